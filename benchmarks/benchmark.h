@@ -0,0 +1,545 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_BENCHMARKS_BENCHMARK_H
+#define SAMPLEFLOW_BENCHMARKS_BENCHMARK_H
+
+#include <sampleflow/auxiliary_data.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#  define SAMPLEFLOW_BENCHMARKS_WITH_PERF_EVENT
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#ifdef SAMPLEFLOW_BENCHMARKS_COUNT_ALLOCATIONS
+#  include "../tests/allocation_counter.h"
+#endif
+
+
+/**
+ * A namespace for the small harness shared by the programs in the
+ * benchmarks/ directory. Each program runs a number of benchmarks, each
+ * identified by a name and a set of parameters (say, the number of
+ * consumers and the dimension of samples), measures how long it takes to
+ * process a given number of samples, and reports the result in two ways:
+ * As a human-readable table on the screen, and -- if the program was
+ * called with `--json <file>` -- as one line per benchmark in the given
+ * file, each of which is a JSON object of the form
+ * @code
+ *   {"suite":"pipeline_throughput", "benchmark":"mh", "parameters":{"n_consumers":"5", ...},
+ *    "n_samples":204800, "seconds":0.52, "samples_per_second":393846,
+ *    "ns_per_sample":2539, "ns_per_sample_per_consumer":507.8, "compiler":"..."}
+ * @endcode
+ * Such files can be collected over time (for example, by a nightly job)
+ * to spot performance regressions.
+ *
+ * All programs also accept `--quick`, which makes each benchmark run for
+ * only a very short time (for checking that the benchmarks work, not for
+ * obtaining meaningful numbers), and `--filter <text>`, which only runs
+ * the benchmarks whose description (the name of the benchmark followed by
+ * its parameters, as shown on the screen) contains the given text.
+ */
+namespace Benchmarks
+{
+  /**
+   * A type for the parameters of a benchmark: pairs of names and values.
+   */
+  using Parameters = std::vector<std::pair<std::string,std::string>>;
+
+
+  /**
+   * The result of measuring a benchmark: how many samples were processed,
+   * and how long that took, in seconds.
+   */
+  struct Measurement
+  {
+    std::uint64_t n_samples = 0;
+    double        seconds   = 0;
+  };
+
+
+  /**
+   * Prevent the compiler from optimizing away the computation of the given
+   * value.
+   */
+  template <typename T>
+  inline
+  void
+  do_not_optimize (const T &value)
+  {
+    asm volatile ("" : : "r,m"(value) : "memory");
+  }
+
+
+  /**
+   * Create `n_samples` samples whose components are drawn from a standard
+   * normal distribution, along with auxiliary data objects that carry a
+   * random "relative log likelihood" the way a Metropolis-Hastings sampler
+   * would attach it. Benchmarks that call the consume() or filter()
+   * functions of a class directly cycle through these samples. The
+   * samples are the same every time the function is called.
+   *
+   * @param[in] dimension The number of components of each sample. Ignored
+   *   if `SampleType` is a scalar type.
+   * @param[in] n_samples The number of samples to create.
+   */
+  template <typename SampleType>
+  std::vector<std::pair<SampleType,SampleFlow::AuxiliaryData>>
+  random_samples (const unsigned int dimension,
+                  const std::size_t  n_samples = 1024);
+
+
+  /**
+   * Return the number of heap allocations the program has made so far,
+   * in all threads. Allocations are only counted in programs that define
+   * `SAMPLEFLOW_BENCHMARKS_COUNT_ALLOCATIONS` before including this file,
+   * in which case this file includes the allocation counter the tests use
+   * (tests/allocation_counter.h), which replaces the global allocation
+   * functions by ones that increment a counter; otherwise, the function
+   * always returns zero.
+   *
+   * Since the replacements are definitions of functions with external
+   * linkage, only one translation unit of a program may define the
+   * macro.
+   */
+  std::uint64_t
+  n_allocations ();
+
+
+  /**
+   * A class that counts the cache misses incurred by the current thread and
+   * by all threads it creates while the counter is running. This uses the
+   * `perf_event_open` system call on Linux; on other systems, or if the
+   * kernel does not allow access to the hardware counters (see
+   * `/proc/sys/kernel/perf_event_paranoid`), available() returns `false`
+   * and nothing is counted.
+   *
+   * Since the counts of other threads are only added to the total when
+   * these threads end, all threads started after start() need to have been
+   * joined before calling stop().
+   */
+  class CacheMissCounter
+  {
+    public:
+      /**
+       * Constructor. Sets up, but does not start, the counter.
+       */
+      CacheMissCounter ();
+
+      /**
+       * Destructor.
+       */
+      ~CacheMissCounter ();
+
+      CacheMissCounter (const CacheMissCounter &) = delete;
+
+      /**
+       * Return whether the counter could be set up.
+       */
+      bool
+      available () const;
+
+      /**
+       * Reset the count to zero and start counting.
+       */
+      void
+      start ();
+
+      /**
+       * Stop counting and return the number of cache misses since the last
+       * call to start(), or zero if the counter is not available.
+       */
+      std::uint64_t
+      stop ();
+
+    private:
+      /**
+       * The file descriptor of the counter, or -1 if it is not available.
+       */
+      int file_descriptor;
+  };
+
+
+  /**
+   * A class that interprets the command line arguments of a benchmark
+   * program and reports results as described in the documentation of
+   * the namespace.
+   */
+  class Reporter
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] suite The name of the benchmark program, as reported in
+       *   the machine-readable output.
+       * @param[in] argc, argv The command line arguments of the program.
+       */
+      Reporter (const std::string &suite,
+                const int          argc,
+                char             **argv);
+
+      /**
+       * Return whether the benchmark with the given name and parameters
+       * should be run, according to the `--filter` argument.
+       */
+      bool
+      selected (const std::string &benchmark,
+                const Parameters  &parameters) const;
+
+      /**
+       * Return the minimal time (in seconds) each measurement should take
+       * to give reliable numbers, or a very short time with `--quick`.
+       */
+      double
+      min_time () const;
+
+      /**
+       * Determine how long `run` takes: Call it with a number of samples,
+       * starting at `initial_n_samples` and doubling it, until one call
+       * takes at least min_time() seconds, and return the number of
+       * samples and the time of that last call. `run` is expected to
+       * process the given number of samples.
+       */
+      Measurement
+      measure (const std::function<void (const std::uint64_t)> &run,
+               const std::uint64_t initial_n_samples = 100) const;
+
+      /**
+       * Report the result of a benchmark. `n_consumers` is the number of
+       * objects each sample was sent to, used to compute the time spent per
+       * sample and consumer; `extra` contains additional quantities (such as
+       * the time spent waiting for locks) that are only reported in the
+       * machine-readable output.
+       */
+      void
+      report (const std::string      &benchmark,
+              const Parameters       &parameters,
+              const Measurement      &measurement,
+              const unsigned int      n_consumers = 1,
+              const std::vector<std::pair<std::string,double>> &extra = {});
+
+    private:
+      /**
+       * Return the description of a benchmark that is shown on the screen
+       * and that `--filter` is matched against.
+       */
+      static
+      std::string
+      description (const std::string &benchmark,
+                   const Parameters  &parameters);
+
+      /**
+       * The name of the benchmark program.
+       */
+      const std::string suite;
+
+      /**
+       * The values of the command line arguments.
+       */
+      bool        quick = false;
+      std::string filter;
+
+      /**
+       * The file the machine-readable output is written to, if any.
+       */
+      std::unique_ptr<std::ofstream> json_output;
+  };
+
+
+
+  inline
+  Reporter::
+  Reporter (const std::string &suite,
+            const int          argc,
+            char             **argv)
+    :
+    suite (suite)
+  {
+    for (int i=1; i<argc; ++i)
+      {
+        const std::string argument = argv[i];
+        if (argument == "--quick")
+          quick = true;
+        else if ((argument == "--filter") && (i+1 < argc))
+          filter = argv[++i];
+        else if ((argument == "--json") && (i+1 < argc))
+          {
+            json_output = std::make_unique<std::ofstream> (argv[++i]);
+            if (!*json_output)
+              {
+                std::cerr << "Could not open <" << argv[i] << "> for writing." << std::endl;
+                std::exit (1);
+              }
+          }
+        else
+          {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--quick] [--filter <text>] [--json <file>]" << std::endl;
+            std::exit (1);
+          }
+      }
+  }
+
+
+
+  inline
+  bool
+  Reporter::
+  selected (const std::string &benchmark,
+            const Parameters  &parameters) const
+  {
+    return (description (benchmark, parameters).find (filter) != std::string::npos);
+  }
+
+
+
+  inline
+  std::string
+  Reporter::
+  description (const std::string &benchmark,
+               const Parameters  &parameters)
+  {
+    std::string result = benchmark;
+    for (const auto &[name, value] : parameters)
+      result += ' ' + name + '=' + value;
+    return result;
+  }
+
+
+
+  inline
+  double
+  Reporter::
+  min_time () const
+  {
+    return (quick ? 0.001 : 0.5);
+  }
+
+
+
+  inline
+  Measurement
+  Reporter::
+  measure (const std::function<void (const std::uint64_t)> &run,
+           const std::uint64_t initial_n_samples) const
+  {
+    // With --quick, a single call with the initial number of samples is
+    // enough to see that the benchmark works.
+    Measurement measurement;
+    for (measurement.n_samples = initial_n_samples; ; measurement.n_samples *= 2)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        run (measurement.n_samples);
+        measurement.seconds
+          = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if ((measurement.seconds >= min_time()) || quick)
+          return measurement;
+      }
+  }
+
+
+
+  inline
+  void
+  Reporter::
+  report (const std::string      &benchmark,
+          const Parameters       &parameters,
+          const Measurement      &measurement,
+          const unsigned int      n_consumers,
+          const std::vector<std::pair<std::string,double>> &extra)
+  {
+    const double samples_per_second = measurement.n_samples / measurement.seconds;
+    const double ns_per_sample      = 1e9 * measurement.seconds / measurement.n_samples;
+
+    std::cout << std::left << std::setw(60) << description (benchmark, parameters) << std::right
+              << std::setw(14) << std::setprecision(4) << samples_per_second << " samples/s"
+              << std::setw(12) << std::setprecision(4) << ns_per_sample / n_consumers << " ns/sample/consumer"
+              << std::endl;
+
+    if (json_output != nullptr)
+      {
+        // Parameter values and the compiler version may contain quotes:
+        const auto quoted = [](const std::string &s)
+        {
+          std::string result = "\"";
+          for (const char c : s)
+            {
+              if ((c == '"') || (c == '\\'))
+                result += '\\';
+              result += c;
+            }
+          return result + "\"";
+        };
+
+        std::ostream &out = *json_output;
+        out << std::setprecision(8)
+            << "{\"suite\":" << quoted(suite)
+            << ",\"benchmark\":" << quoted(benchmark)
+            << ",\"parameters\":{";
+        for (std::size_t i=0; i<parameters.size(); ++i)
+          out << (i > 0 ? "," : "") << quoted(parameters[i].first) << ':' << quoted(parameters[i].second);
+        out << "},\"n_samples\":" << measurement.n_samples
+            << ",\"seconds\":" << measurement.seconds
+            << ",\"samples_per_second\":" << samples_per_second
+            << ",\"ns_per_sample\":" << ns_per_sample
+            << ",\"ns_per_sample_per_consumer\":" << ns_per_sample / n_consumers;
+        for (const auto &[name, value] : extra)
+          out << ',' << quoted(name) << ':' << value;
+        out << ",\"compiler\":" << quoted(__VERSION__)
+            << "}" << std::endl;
+      }
+  }
+
+
+
+  inline
+  CacheMissCounter::CacheMissCounter ()
+    :
+    file_descriptor (-1)
+  {
+#ifdef SAMPLEFLOW_BENCHMARKS_WITH_PERF_EVENT
+    perf_event_attr attributes {};
+    attributes.type           = PERF_TYPE_HARDWARE;
+    attributes.size           = sizeof (attributes);
+    attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled       = 1;
+    attributes.inherit        = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv     = 1;
+    file_descriptor = syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+  }
+
+
+
+  inline
+  CacheMissCounter::~CacheMissCounter ()
+  {
+#ifdef SAMPLEFLOW_BENCHMARKS_WITH_PERF_EVENT
+    if (file_descriptor >= 0)
+      close (file_descriptor);
+#endif
+  }
+
+
+
+  inline
+  bool
+  CacheMissCounter::available () const
+  {
+    return (file_descriptor >= 0);
+  }
+
+
+
+  inline
+  void
+  CacheMissCounter::start ()
+  {
+#ifdef SAMPLEFLOW_BENCHMARKS_WITH_PERF_EVENT
+    if (file_descriptor >= 0)
+      {
+        ioctl (file_descriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl (file_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+
+
+  inline
+  std::uint64_t
+  CacheMissCounter::stop ()
+  {
+    std::uint64_t count = 0;
+#ifdef SAMPLEFLOW_BENCHMARKS_WITH_PERF_EVENT
+    if (file_descriptor >= 0)
+      {
+        ioctl (file_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+        if (read (file_descriptor, &count, sizeof (count)) != sizeof (count))
+          count = 0;
+      }
+#endif
+    return count;
+  }
+
+
+
+  inline
+  std::uint64_t
+  n_allocations ()
+  {
+#ifdef SAMPLEFLOW_BENCHMARKS_COUNT_ALLOCATIONS
+    return SampleFlow::Testing::n_allocations();
+#else
+    return 0;
+#endif
+  }
+
+
+
+  template <typename SampleType>
+  std::vector<std::pair<SampleType,SampleFlow::AuxiliaryData>>
+  random_samples (const unsigned int dimension,
+                  const std::size_t  n_samples)
+  {
+    std::mt19937 rng;
+    std::normal_distribution<double> distribution;
+
+    std::vector<std::pair<SampleType,SampleFlow::AuxiliaryData>> samples (n_samples);
+    for (auto &[sample, aux_data] : samples)
+      {
+        if constexpr (std::is_arithmetic_v<SampleType>)
+          sample = distribution (rng);
+        else
+          {
+            sample.resize (dimension);
+            for (unsigned int i=0; i<dimension; ++i)
+              if constexpr (requires { sample[i].imag(); })
+                {
+                  const double real_part = distribution (rng);
+                  sample[i] = {real_part, distribution (rng)};
+                }
+              else
+                sample[i] = distribution (rng);
+          }
+        aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = distribution (rng);
+      }
+    return samples;
+  }
+}
+
+#endif
@@ -0,0 +1,257 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure the cost of processing one sample in each of the commonly used
+// consumer classes. Rather than connecting the consumers to a producer,
+// the benchmarks call their consume() functions directly, so that the
+// numbers reported do not include the cost of sending samples through
+// the pipeline -- only that of copying the sample into the argument of
+// consume() (which takes it by value) and of whatever the consumer does
+// with it.
+//
+// The samples are drawn from a normal distribution ahead of time and are
+// scalars or vectors of sizes 10 to 1,000. The consumers that compute
+// second moments are in addition measured for complex-valued vectors, for
+// which the times should be no more than about four times those for
+// real-valued vectors of the same size (a complex product takes four real
+// products).
+
+
+#include <benchmark.h>
+
+#include <sampleflow/consumers/auto_covariance_trace.h>
+#include <sampleflow/consumers/banded_covariance_matrix.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/fft_auto_covariance_trace.h>
+#include <sampleflow/consumers/histogram.h>
+#include <sampleflow/consumers/low_rank_covariance_matrix.h>
+#include <sampleflow/consumers/maximum_probability_sample.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/consumers/monte_carlo_standard_error.h>
+#include <sampleflow/consumers/pair_histogram.h>
+#include <sampleflow/consumers/quantiles.h>
+#include <sampleflow/consumers/stream_output.h>
+
+#include <Eigen/Dense>
+
+#include <complex>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <valarray>
+#include <vector>
+
+
+// A stream buffer that throws away everything written to it, so that
+// StreamOutput can be measured without the cost of actual I/O.
+class NullBuffer : public std::streambuf
+{
+  protected:
+    virtual
+    int_type
+    overflow (int_type c) override
+    {
+      return traits_type::not_eof (c);
+    }
+
+    virtual
+    std::streamsize
+    xsputn (const char_type *, std::streamsize n) override
+    {
+      return n;
+    }
+};
+
+
+
+// Measure how long the consumer returned by 'create_consumer' takes to
+// process samples. A new consumer object is created for every
+// measurement, so that the state the consumer accumulates is the same for
+// the same number of samples.
+template <typename SampleType, typename CreateConsumer>
+void
+benchmark_consumer (Benchmarks::Reporter        &reporter,
+                    const std::string           &consumer,
+                    const std::string           &sample_type,
+                    const std::vector<std::pair<SampleType,SampleFlow::AuxiliaryData>> &samples,
+                    const CreateConsumer        &create_consumer)
+{
+  const Benchmarks::Parameters parameters = {{"sample_type", sample_type}};
+  if (reporter.selected (consumer, parameters) == false)
+    return;
+
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    const auto c = create_consumer ();
+    for (std::uint64_t i=0; i<n_samples; ++i)
+      {
+        const auto &[sample, aux_data] = samples[i % samples.size()];
+        c->consume (sample, aux_data);
+      }
+    Benchmarks::do_not_optimize (*c);
+  };
+
+  reporter.report (consumer, parameters, reporter.measure (run));
+}
+
+
+
+template <typename SampleType>
+void
+benchmark_consumers (Benchmarks::Reporter &reporter,
+                     const std::string    &sample_type,
+                     const unsigned int    dimension)
+{
+  using namespace SampleFlow::Consumers;
+
+  const auto samples = Benchmarks::random_samples<SampleType> (dimension);
+
+  benchmark_consumer (reporter, "CountSamples", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<CountSamples<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "MeanValue", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<MeanValue<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "MaximumProbabilitySample", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<MaximumProbabilitySample<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "CovarianceMatrix", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<CovarianceMatrix<SampleType>> ();
+  });
+  if constexpr (std::is_arithmetic_v<SampleType> == false)
+    benchmark_consumer (reporter, "LowRankCovarianceMatrix(10)", sample_type, samples,
+                        []()
+    {
+      return std::make_unique<LowRankCovarianceMatrix<SampleType>> (10);
+    });
+  if constexpr (std::is_arithmetic_v<SampleType> == false)
+    benchmark_consumer (reporter, "BandedCovarianceMatrix(10)", sample_type, samples,
+                        []()
+    {
+      return std::make_unique<BandedCovarianceMatrix<SampleType>> (10);
+    });
+  benchmark_consumer (reporter, "AutoCovarianceTrace(10)", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<AutoCovarianceTrace<SampleType>> (10);
+  });
+  benchmark_consumer (reporter, "FFTAutoCovarianceTrace(10)", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<FFTAutoCovarianceTrace<SampleType>> (10);
+  });
+  benchmark_consumer (reporter, "MonteCarloStandardError", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<MonteCarloStandardError<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "Quantiles", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<Quantiles<SampleType>> ();
+  });
+
+  if constexpr (std::is_arithmetic_v<SampleType>)
+    benchmark_consumer (reporter, "Histogram(100)", sample_type, samples,
+                        []()
+    {
+      return std::make_unique<Histogram<SampleType>> (-3, 3, 100);
+    });
+  else
+    benchmark_consumer (reporter, "PairHistogram(100x100)", sample_type, samples,
+                        []()
+    {
+      return std::make_unique<PairHistogram<SampleType>> (-3, 3, 100, -3, 3, 100);
+    });
+
+  // All StreamOutput objects write into the same (discarding) stream:
+  static NullBuffer null_buffer;
+  static std::ostream null_stream (&null_buffer);
+  using Format = typename StreamOutput<SampleType>::Format;
+  for (const auto &[format, format_name] : {std::pair<Format,std::string> (Format::text, "text"),
+                                            std::pair<Format,std::string> (Format::fast_text, "fast_text"),
+                                            std::pair<Format,std::string> (Format::binary, "binary")
+                                           })
+    benchmark_consumer (reporter, "StreamOutput(" + format_name + ")", sample_type, samples,
+                        [format = format]()
+    {
+      return std::make_unique<StreamOutput<SampleType>> (null_stream, format);
+    });
+}
+
+
+// Measure the consumers that support complex-valued samples.
+template <typename SampleType>
+void
+benchmark_complex_consumers (Benchmarks::Reporter &reporter,
+                             const std::string    &sample_type,
+                             const unsigned int    dimension)
+{
+  using namespace SampleFlow::Consumers;
+
+  const auto samples = Benchmarks::random_samples<SampleType> (dimension);
+
+  benchmark_consumer (reporter, "MeanValue", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<MeanValue<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "CovarianceMatrix", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<CovarianceMatrix<SampleType>> ();
+  });
+  benchmark_consumer (reporter, "BandedCovarianceMatrix(10)", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<BandedCovarianceMatrix<SampleType>> (10);
+  });
+  benchmark_consumer (reporter, "AutoCovarianceTrace(10)", sample_type, samples,
+                      []()
+  {
+    return std::make_unique<AutoCovarianceTrace<SampleType>> (10);
+  });
+}
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("consumers", argc, argv);
+
+  benchmark_consumers<double> (reporter, "double", 1);
+  for (const unsigned int dimension : {10, 100, 1000})
+    benchmark_consumers<Eigen::VectorXd> (reporter, "VectorXd(" + std::to_string (dimension) + ")",
+                                          dimension);
+
+  for (const unsigned int dimension : {100, 1000})
+    {
+      benchmark_complex_consumers<Eigen::VectorXcd> (reporter, "VectorXcd(" + std::to_string (dimension) + ")",
+                                                     dimension);
+      benchmark_complex_consumers<std::valarray<std::complex<double>>>
+      (reporter, "valarray<complex<double>>(" + std::to_string (dimension) + ")", dimension);
+    }
+}
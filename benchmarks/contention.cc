@@ -0,0 +1,194 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure how well pipelines scale when many chains feed the same
+// consumers: K = 1, 2, 4, ..., 128 threads each run their own
+// Metropolis-Hastings sampler (with a trivial likelihood, so that the
+// time is dominated by sending samples downstream), and all samplers are
+// connected to one shared consumer that computes statistics of all
+// samples. Since the consumer processes samples synchronously on the
+// threads of the samplers, it has to coordinate access to its state, and
+// the question is how much that costs as K grows. The consumers compared
+// use different strategies for this: CountSamples only increments an
+// atomic counter, MeanValue and CovarianceMatrix accumulate into
+// per-thread shards, and MaximumProbabilitySample protects its state
+// with a single mutex.
+//
+// Besides the total number of samples processed per second, the
+// machine-readable output contains for each measurement
+// - "speedup": the throughput relative to that with one thread;
+// - "lock_wait_seconds" and "contended_locks_per_sample": how long
+//   threads waited for the consumer's lock, summed over all threads, and
+//   how often they had to wait at all (this is why the program is built
+//   with SAMPLEFLOW_WITH_INSTRUMENTATION, which also makes all numbers
+//   somewhat larger than in an uninstrumented build);
+// - "cache_misses_per_sample", if the hardware counters are accessible
+//   (see Benchmarks::CacheMissCounter).
+
+#define SAMPLEFLOW_WITH_INSTRUMENTATION
+
+#include <benchmark.h>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/maximum_probability_sample.h>
+#include <sampleflow/consumers/mean_value.h>
+
+#include <Eigen/Dense>
+
+#include <latch>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+template <typename SampleType, typename ConsumerType>
+void
+run_contention (Benchmarks::Reporter              &reporter,
+                const std::string                 &consumer_name,
+                const std::string                 &sample_type,
+                const SampleType                  &starting_point,
+                const unsigned int                 n_threads,
+                std::map<std::string,double>       &single_thread_throughput)
+{
+  const Benchmarks::Parameters parameters =
+  {
+    {"consumer", consumer_name},
+    {"sample_type", sample_type},
+    {"n_threads", std::to_string (n_threads)}
+  };
+  if (reporter.selected ("shared_consumer", parameters) == false)
+    return;
+
+  // What we learn about the last (and longest) call of 'run':
+  SampleFlow::Instrumentation::ConsumerStatistics statistics;
+  std::uint64_t                                   n_cache_misses = 0;
+
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    ConsumerType consumer;
+
+    // Samplers can not be moved once connected, so store them in a
+    // container that does not move its elements:
+    std::list<SampleFlow::Producers::MetropolisHastings<SampleType>> samplers (n_threads);
+    for (auto &sampler : samplers)
+      consumer.connect_to_producer (sampler);
+
+    // Let all threads start sampling at the same time, after all of them
+    // have been created:
+    std::latch start (n_threads + 1);
+
+    // The cache miss counter only counts threads created after it has
+    // been set up:
+    Benchmarks::CacheMissCounter counter;
+    counter.start ();
+
+    std::vector<std::thread> threads;
+    for (auto &sampler : samplers)
+      threads.emplace_back ([&]()
+      {
+        start.arrive_and_wait ();
+        sampler.sample (starting_point,
+                        [](const SampleType &) -> double
+        {
+          return 0;
+        },
+        [](const SampleType &x)
+        {
+          SampleType y = x;
+          if constexpr (std::is_arithmetic_v<SampleType>)
+            y += 1e-3;
+          else
+            y[0] += 1e-3;
+          return std::pair<SampleType,double> (std::move(y), 1.);
+        },
+        n_samples / n_threads);
+      });
+    start.arrive_and_wait ();
+    for (auto &thread : threads)
+      thread.join ();
+
+    n_cache_misses = counter.stop ();
+
+    statistics = consumer.get_consumer_statistics ();
+    Benchmarks::do_not_optimize (consumer.get());
+  };
+
+  // Start with a number of samples that is divisible by the number of
+  // threads, so that all threads get the same share:
+  const Benchmarks::Measurement measurement = reporter.measure (run, 100*n_threads);
+  const double throughput = measurement.n_samples / measurement.seconds;
+
+  // The throughput with one thread is measured first, and serves as the
+  // reference for all larger numbers of threads:
+  const std::string key = consumer_name + "/" + sample_type;
+  if (n_threads == 1)
+    single_thread_throughput[key] = throughput;
+
+  std::vector<std::pair<std::string,double>> extra =
+  {
+    {"lock_wait_seconds", std::chrono::duration<double> (statistics.lock_wait_time).count()},
+    {"contended_locks_per_sample", 1. * statistics.n_contended_locks / measurement.n_samples}
+  };
+  if (single_thread_throughput.contains (key))
+    extra.emplace_back ("speedup", throughput / single_thread_throughput[key]);
+  if (n_cache_misses > 0)
+    extra.emplace_back ("cache_misses_per_sample", 1. * n_cache_misses / measurement.n_samples);
+
+  reporter.report ("shared_consumer", parameters, measurement, 1, extra);
+}
+
+
+
+template <typename SampleType>
+void
+run_contention (Benchmarks::Reporter &reporter,
+                const std::string    &sample_type,
+                const SampleType     &starting_point)
+{
+  std::map<std::string,double> single_thread_throughput;
+  for (unsigned int n_threads=1; n_threads<=128; n_threads*=2)
+    {
+      run_contention<SampleType,SampleFlow::Consumers::CountSamples<SampleType>>
+      (reporter, "CountSamples", sample_type, starting_point, n_threads, single_thread_throughput);
+      run_contention<SampleType,SampleFlow::Consumers::MeanValue<SampleType>>
+      (reporter, "MeanValue", sample_type, starting_point, n_threads, single_thread_throughput);
+      run_contention<SampleType,SampleFlow::Consumers::CovarianceMatrix<SampleType>>
+      (reporter, "CovarianceMatrix", sample_type, starting_point, n_threads, single_thread_throughput);
+      run_contention<SampleType,SampleFlow::Consumers::MaximumProbabilitySample<SampleType>>
+      (reporter, "MaximumProbabilitySample", sample_type, starting_point, n_threads, single_thread_throughput);
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("contention", argc, argv);
+
+  std::cout << "Running on " << std::thread::hardware_concurrency() << " hardware threads";
+  if (Benchmarks::CacheMissCounter().available() == false)
+    std::cout << "; cache miss counters are not available";
+  std::cout << std::endl;
+
+  run_contention (reporter, "double", 0.);
+  for (const unsigned int dimension : {10, 100})
+    run_contention<Eigen::VectorXd> (reporter, "VectorXd(" + std::to_string (dimension) + ")",
+                                     Eigen::VectorXd::Zero (dimension));
+}
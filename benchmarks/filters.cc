@@ -0,0 +1,150 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure the cost of processing one sample in each of the commonly used
+// filter classes by calling their filter() functions directly, i.e.,
+// without the cost of receiving samples from a producer and of sending
+// the results on to consumers. As in the consumers benchmark, the
+// samples are scalars or vectors of sizes 10 to 1,000 drawn from a
+// normal distribution ahead of time.
+
+
+#include <benchmark.h>
+
+#include <sampleflow/filters/component_splitter.h>
+#include <sampleflow/filters/condition.h>
+#include <sampleflow/filters/conversion.h>
+#include <sampleflow/filters/discard_first_n.h>
+#include <sampleflow/filters/quantization.h>
+#include <sampleflow/filters/take_every_nth.h>
+
+#include <Eigen/Dense>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Measure how long the filter returned by 'create_filter' takes to
+// process samples. We count how many samples the filter lets through
+// so that the call can not be optimized away.
+template <typename SampleType, typename CreateFilter>
+void
+benchmark_filter (Benchmarks::Reporter        &reporter,
+                  const std::string           &filter,
+                  const std::string           &sample_type,
+                  const std::vector<std::pair<SampleType,SampleFlow::AuxiliaryData>> &samples,
+                  const CreateFilter          &create_filter)
+{
+  const Benchmarks::Parameters parameters = {{"sample_type", sample_type}};
+  if (reporter.selected (filter, parameters) == false)
+    return;
+
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    const auto f = create_filter ();
+    std::uint64_t n_passed = 0;
+    for (std::uint64_t i=0; i<n_samples; ++i)
+      {
+        const auto &[sample, aux_data] = samples[i % samples.size()];
+        const auto result = f->filter (sample, aux_data);
+        if (result)
+          {
+            Benchmarks::do_not_optimize (result->first);
+            ++n_passed;
+          }
+      }
+    Benchmarks::do_not_optimize (n_passed);
+  };
+
+  reporter.report (filter, parameters, reporter.measure (run));
+}
+
+
+
+template <typename SampleType>
+void
+benchmark_filters (Benchmarks::Reporter &reporter,
+                   const std::string    &sample_type,
+                   const unsigned int    dimension)
+{
+  using namespace SampleFlow::Filters;
+
+  const auto samples = Benchmarks::random_samples<SampleType> (dimension);
+
+  benchmark_filter (reporter, "TakeEveryNth(10)", sample_type, samples,
+                    []()
+  {
+    return std::make_unique<TakeEveryNth<SampleType>> (10);
+  });
+  benchmark_filter (reporter, "DiscardFirstN(100)", sample_type, samples,
+                    []()
+  {
+    return std::make_unique<DiscardFirstN<SampleType>> (100);
+  });
+  benchmark_filter (reporter, "Condition", sample_type, samples,
+                    []()
+  {
+    return std::make_unique<Condition<SampleType>> ([](const SampleType &x)
+    {
+      if constexpr (std::is_arithmetic_v<SampleType>)
+        return (x > 0);
+      else
+        return (x[0] > 0);
+    });
+  });
+
+  if constexpr (std::is_arithmetic_v<SampleType>)
+    benchmark_filter (reporter, "Conversion(float)", sample_type, samples,
+                      []()
+    {
+      return std::make_unique<Conversion<SampleType,float>> ();
+    });
+  else
+    {
+      benchmark_filter (reporter, "Conversion(float)", sample_type, samples,
+                        []()
+      {
+        return std::make_unique<Conversion<SampleType,Eigen::VectorXf>> ([](const SampleType &x)
+        {
+          return Eigen::VectorXf (x.template cast<float>());
+        });
+      });
+      benchmark_filter (reporter, "ComponentSplitter", sample_type, samples,
+                        []()
+      {
+        return std::make_unique<ComponentSplitter<SampleType>> (0);
+      });
+      benchmark_filter (reporter, "Quantization(int16)", sample_type, samples,
+                        []()
+      {
+        return std::make_unique<Quantization<SampleType,std::vector<std::int16_t>>> (1e-3);
+      });
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("filters", argc, argv);
+
+  benchmark_filters<double> (reporter, "double", 1);
+  for (const unsigned int dimension : {10, 100, 1000})
+    benchmark_filters<Eigen::VectorXd> (reporter, "VectorXd(" + std::to_string (dimension) + ")",
+                                        dimension);
+}
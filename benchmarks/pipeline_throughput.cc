@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure the throughput of complete pipelines: A Metropolis-Hastings
+// sampler with a trivial likelihood (so that the time is dominated by
+// the sampler and the machinery that sends samples downstream) feeds
+// 1, 5, or 20 consumers that do nearly nothing with the samples. This
+// is repeated for consumers that work synchronously and asynchronously,
+// and for scalar samples as well as for vectors of sizes 10 to 10,000,
+// for which the cost of copying samples becomes important.
+//
+// The numbers reported are the samples produced per second, and the
+// time per sample and consumer.
+
+
+#include <benchmark.h>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/count_samples.h>
+
+#include <Eigen/Dense>
+
+#include <list>
+#include <string>
+
+
+template <typename SampleType>
+void
+run_pipeline (Benchmarks::Reporter        &reporter,
+              const std::string           &sample_type,
+              const SampleType            &starting_point,
+              const unsigned int           n_consumers,
+              const SampleFlow::ParallelMode parallel_mode)
+{
+  const Benchmarks::Parameters parameters =
+  {
+    {"sample_type", sample_type},
+    {"n_consumers", std::to_string (n_consumers)},
+    {"mode", (parallel_mode == SampleFlow::ParallelMode::synchronous ? "sync" : "async")}
+  };
+  if (reporter.selected ("mh", parameters) == false)
+    return;
+
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    // Consumer objects can not be moved once connected, so store them in
+    // a container that does not move its elements:
+    std::list<SampleFlow::Consumers::CountSamples<SampleType>> consumers (n_consumers);
+    for (auto &consumer : consumers)
+      {
+        if (parallel_mode == SampleFlow::ParallelMode::asynchronous)
+          consumer.set_parallel_mode (parallel_mode, 64);
+        consumer.connect_to_producer (mh_sampler);
+      }
+
+    // A likelihood that is the same everywhere means that all trial
+    // samples are accepted, and so each sample is a new object that needs
+    // to be sent downstream. Perturbing the sample in place is about as
+    // cheap as creating a trial sample can be.
+    mh_sampler.sample (starting_point,
+                       [](const SampleType &) -> double
+    {
+      return 0;
+    },
+    [](const SampleType &x)
+    {
+      SampleType y = x;
+      if constexpr (std::is_arithmetic_v<SampleType>)
+        y += 1e-3;
+      else
+        y[0] += 1e-3;
+      return std::pair<SampleType,double> (std::move(y), 1.);
+    },
+    n_samples);
+
+    for (const auto &consumer : consumers)
+      Benchmarks::do_not_optimize (consumer.get());
+  };
+
+  reporter.report ("mh", parameters, reporter.measure (run), n_consumers);
+}
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("pipeline_throughput", argc, argv);
+
+  for (const SampleFlow::ParallelMode parallel_mode : {SampleFlow::ParallelMode::synchronous,
+                                                        SampleFlow::ParallelMode::asynchronous
+                                                       })
+    for (const unsigned int n_consumers : {1, 5, 20})
+      {
+        run_pipeline (reporter, "double", 0., n_consumers, parallel_mode);
+
+        for (const unsigned int dimension : {10, 100, 1000, 10000})
+          run_pipeline<Eigen::VectorXd> (reporter, "VectorXd(" + std::to_string (dimension) + ")",
+                                         Eigen::VectorXd::Zero (dimension),
+                                         n_consumers, parallel_mode);
+      }
+}
@@ -0,0 +1,391 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure how much time the producers themselves add to each step of a
+// chain, independent of the cost of the likelihood and of the proposal:
+// All benchmarks use a likelihood that costs nothing and a proposal that
+// only perturbs one component of the current sample, so that what is
+// measured is the bookkeeping of the sampler, the creation of auxiliary
+// data, and the cost of sending samples downstream.
+//
+// The benchmarks are:
+// - "aux_data": Creating the AuxiliaryData object that MetropolisHastings
+//   attaches to each sample.
+// - "issue_sample": Calling Producer::issue_sample() with a sample and its
+//   auxiliary data, with no consumer or with one consumer that only counts
+//   samples.
+// - "mh": MetropolisHastings, with the proposal returning a new sample or
+//   writing into the trial sample in place, and with no or one consumer.
+//   Times are per step.
+// - "dr": DelayedRejectionMetropolisHastings in which every stage but the
+//   last is rejected. Times are per stage.
+// - "demh": DifferentialEvaluationMetropolisHastings, with the likelihood
+//   evaluated synchronously or asynchronously. Times are per chain and
+//   generation, i.e., per sample.
+//
+// Each of the latter four is run for scalar samples, fixed-size vectors
+// of Eigen and of SampleFlow, and dynamically sized Eigen vectors. In
+// addition to the times, the machine-readable output reports the number of heap
+// allocations per step (or stage) under the key "allocations_per_sample".
+
+
+#define SAMPLEFLOW_BENCHMARKS_COUNT_ALLOCATIONS
+#include <benchmark.h>
+
+#include <sampleflow/fixed_vector.h>
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/producers/delayed_rejection_mh.h>
+#include <sampleflow/producers/differential_evaluation_mh.h>
+#include <sampleflow/consumers/count_samples.h>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <list>
+#include <string>
+
+
+namespace
+{
+  /**
+   * Return a reference to the first component of a sample.
+   */
+  template <typename SampleType>
+  double &
+  first_component (SampleType &x)
+  {
+    if constexpr (std::is_arithmetic_v<SampleType>)
+      return x;
+    else
+      return x[0];
+  }
+
+  template <typename SampleType>
+  double
+  first_component (const SampleType &x)
+  {
+    if constexpr (std::is_arithmetic_v<SampleType>)
+      return x;
+    else
+      return x[0];
+  }
+
+
+  /**
+   * A producer that does nothing but send the samples it is given
+   * downstream.
+   */
+  template <typename SampleType>
+  class Issuer : public SampleFlow::Producer<SampleType>
+  {
+    public:
+      using SampleFlow::Producer<SampleType>::issue_sample;
+  };
+
+
+  /**
+   * Measure `run`, and report the result along with the number of heap
+   * allocations per sample made by the last (and longest) call to `run`.
+   * `units_per_sample` is the number of units (steps, stages, ...) each
+   * sample passed to `run` corresponds to.
+   */
+  void
+  measure_and_report (Benchmarks::Reporter                              &reporter,
+                      const std::string                                 &benchmark,
+                      const Benchmarks::Parameters                      &parameters,
+                      const std::function<void (const std::uint64_t)>   &run,
+                      const unsigned int                                 n_consumers,
+                      const unsigned int                                 units_per_sample = 1)
+  {
+    double allocations_per_unit = 0;
+    Benchmarks::Measurement measurement
+      = reporter.measure ([&](const std::uint64_t n_samples)
+    {
+      const std::uint64_t n_allocations_before = Benchmarks::n_allocations();
+      run (n_samples);
+      allocations_per_unit = 1. * (Benchmarks::n_allocations() - n_allocations_before)
+                             / (n_samples * units_per_sample);
+    });
+    measurement.n_samples *= units_per_sample;
+
+    reporter.report (benchmark, parameters, measurement, std::max (n_consumers, 1u),
+    {{"allocations_per_sample", allocations_per_unit}});
+  }
+
+
+
+  void
+  run_aux_data (Benchmarks::Reporter &reporter)
+  {
+    const Benchmarks::Parameters parameters = {};
+    if (reporter.selected ("aux_data", parameters) == false)
+      return;
+
+    measure_and_report (reporter, "aux_data", parameters,
+                        [](const std::uint64_t n_samples)
+    {
+      for (std::uint64_t i=0; i<n_samples; ++i)
+        {
+          SampleFlow::AuxiliaryData aux_data;
+          aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = 1.*i;
+          aux_data[SampleFlow::AuxiliaryData::sample_is_repeated] = ((i%2) == 0);
+          Benchmarks::do_not_optimize (aux_data);
+        }
+    },
+    1);
+  }
+
+
+
+  template <typename SampleType>
+  void
+  run_issue_sample (Benchmarks::Reporter &reporter,
+                    const std::string    &sample_type,
+                    const SampleType     &sample,
+                    const unsigned int    n_consumers)
+  {
+    const Benchmarks::Parameters parameters =
+    {
+      {"sample_type", sample_type},
+      {"n_consumers", std::to_string (n_consumers)}
+    };
+    if (reporter.selected ("issue_sample", parameters) == false)
+      return;
+
+    measure_and_report (reporter, "issue_sample", parameters,
+                        [&](const std::uint64_t n_samples)
+    {
+      Issuer<SampleType> issuer;
+      std::list<SampleFlow::Consumers::CountSamples<SampleType>> consumers (n_consumers);
+      for (auto &consumer : consumers)
+        consumer.connect_to_producer (issuer);
+
+      for (std::uint64_t i=0; i<n_samples; ++i)
+        issuer.issue_sample (sample, {});
+
+      for (const auto &consumer : consumers)
+        Benchmarks::do_not_optimize (consumer.get());
+    },
+    n_consumers);
+  }
+
+
+
+  template <typename SampleType>
+  void
+  run_mh (Benchmarks::Reporter &reporter,
+          const std::string    &sample_type,
+          const SampleType     &starting_point,
+          const unsigned int    n_consumers,
+          const bool            in_place)
+  {
+    const Benchmarks::Parameters parameters =
+    {
+      {"sample_type", sample_type},
+      {"n_consumers", std::to_string (n_consumers)},
+      {"proposal", (in_place ? "in_place" : "return")}
+    };
+    if (reporter.selected ("mh", parameters) == false)
+      return;
+
+    measure_and_report (reporter, "mh", parameters,
+                        [&](const std::uint64_t n_samples)
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+      std::list<SampleFlow::Consumers::CountSamples<SampleType>> consumers (n_consumers);
+      for (auto &consumer : consumers)
+        consumer.connect_to_producer (mh_sampler);
+
+      // A likelihood that is the same everywhere means that all trial
+      // samples are accepted:
+      const auto log_likelihood = [](const SampleType &) -> double
+      {
+        return 0;
+      };
+
+      if (in_place)
+        mh_sampler.sample (starting_point,
+                           log_likelihood,
+                           [](const SampleType &x, SampleType &trial) -> double
+        {
+          trial = x;
+          first_component (trial) += 1e-3;
+          return 1.;
+        },
+        n_samples);
+      else
+        mh_sampler.sample (starting_point,
+                           log_likelihood,
+                           [](const SampleType &x)
+        {
+          SampleType y = x;
+          first_component (y) += 1e-3;
+          return std::pair<SampleType,double> (std::move(y), 1.);
+        },
+        n_samples);
+
+      for (const auto &consumer : consumers)
+        Benchmarks::do_not_optimize (consumer.get());
+    },
+    n_consumers);
+  }
+
+
+
+  template <typename SampleType>
+  void
+  run_dr (Benchmarks::Reporter &reporter,
+          const std::string    &sample_type,
+          const SampleType     &starting_point,
+          const unsigned int    max_delays)
+  {
+    const Benchmarks::Parameters parameters =
+    {
+      {"sample_type", sample_type},
+      {"max_delays", std::to_string (max_delays)}
+    };
+    if (reporter.selected ("dr", parameters) == false)
+      return;
+
+    measure_and_report (reporter, "dr", parameters,
+                        [&](const std::uint64_t n_samples)
+    {
+      SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType> dr_sampler;
+      SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+      count_samples.connect_to_producer (dr_sampler);
+
+      // All stages but the last propose a sample far away from the
+      // current one, which the likelihood rejects with probability
+      // practically one. The last stage proposes a sample close by that
+      // is always accepted. Every step therefore goes through all
+      // max_delays+1 stages.
+      dr_sampler.sample (starting_point,
+                         [](const SampleType &x) -> double
+      {
+        return (std::fabs (first_component (x)) > 1e5 ? -1e3 : 0);
+      },
+      [max_delays](const SampleType &x, const std::vector<SampleType> &rejected_samples)
+      {
+        SampleType y = x;
+        if (rejected_samples.size() < max_delays)
+          first_component (y) = 1e6;
+        else
+          first_component (y) += 1e-3;
+        return std::pair<SampleType,double> (std::move(y), 1.);
+      },
+      max_delays,
+      n_samples);
+
+      Benchmarks::do_not_optimize (count_samples.get());
+    },
+    1, max_delays+1);
+  }
+
+
+
+  template <typename SampleType>
+  void
+  run_demh (Benchmarks::Reporter &reporter,
+            const std::string    &sample_type,
+            const SampleType     &starting_point,
+            const unsigned int    n_chains,
+            const bool            asynchronous_likelihood)
+  {
+    const Benchmarks::Parameters parameters =
+    {
+      {"sample_type", sample_type},
+      {"n_chains", std::to_string (n_chains)},
+      {"likelihood", (asynchronous_likelihood ? "async" : "sync")}
+    };
+    if (reporter.selected ("demh", parameters) == false)
+      return;
+
+    measure_and_report (reporter, "demh", parameters,
+                        [&](const std::uint64_t n_samples)
+    {
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> demh_sampler;
+      SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+      count_samples.connect_to_producer (demh_sampler);
+
+      std::vector<SampleType> starting_points (n_chains, starting_point);
+      for (unsigned int c=0; c<n_chains; ++c)
+        first_component (starting_points[c]) += c;
+
+      demh_sampler.sample (starting_points,
+                           [](const SampleType &) -> double
+      {
+        return 0;
+      },
+      [](const SampleType &x)
+      {
+        SampleType y = x;
+        first_component (y) += 1e-3;
+        return std::pair<SampleType,double> (std::move(y), 1.);
+      },
+      [](const SampleType &x, const SampleType &a, const SampleType &b) -> SampleType
+      {
+        SampleType y = x;
+        first_component (y) += 1e-3 * (first_component (a) - first_component (b));
+        return y;
+      },
+      10,
+      n_samples,
+      asynchronous_likelihood);
+
+      Benchmarks::do_not_optimize (count_samples.get());
+    },
+    1);
+  }
+
+
+
+  template <typename SampleType>
+  void
+  run_all (Benchmarks::Reporter &reporter,
+           const std::string    &sample_type,
+           const SampleType     &starting_point)
+  {
+    for (const unsigned int n_consumers : {0, 1})
+      run_issue_sample (reporter, sample_type, starting_point, n_consumers);
+
+    for (const unsigned int n_consumers : {0, 1})
+      for (const bool in_place : {false, true})
+        run_mh (reporter, sample_type, starting_point, n_consumers, in_place);
+
+    for (const unsigned int max_delays : {1, 3})
+      run_dr (reporter, sample_type, starting_point, max_delays);
+
+    for (const unsigned int n_chains : {4, 16})
+      for (const bool asynchronous_likelihood : {false, true})
+        run_demh (reporter, sample_type, starting_point, n_chains, asynchronous_likelihood);
+  }
+}
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("producer_overhead", argc, argv);
+
+  run_aux_data (reporter);
+
+  run_all (reporter, "double", 0.);
+  run_all<Eigen::Vector2d> (reporter, "Vector2d", Eigen::Vector2d::Zero());
+  run_all (reporter, "FixedVector(2)", SampleFlow::FixedVector<double,2> {0., 0.});
+  for (const unsigned int dimension : {10, 100})
+    run_all<Eigen::VectorXd> (reporter, "VectorXd(" + std::to_string (dimension) + ")",
+                              Eigen::VectorXd::Zero (dimension));
+}
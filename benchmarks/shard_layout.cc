@@ -0,0 +1,301 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Measure whether consumers whose state is split into per-thread shards
+// (see ShardedAccumulator) actually scale with the number of threads, or
+// whether the shards "false-share" cache lines: K = 1, 2, 4, ..., 128
+// threads call the consume() function of one shared consumer as fast as
+// they can. Unlike the "contention" benchmark, no sampler is involved, so
+// all time is spent in the consumer and any coherence traffic between
+// the shards shows up directly in the throughput.
+//
+// As a reference, the "packed_counters" benchmark does the same with one
+// counter per thread, once with the counters stored next to each other
+// (as a naive implementation of per-thread state would do) and once with
+// each counter allocated by Memory::CacheLineAllocator (as the shards of a
+// ShardedAccumulator are). The former is the textbook case of false
+// sharing and typically gets slower, not faster, with more threads.
+//
+// Finally, "large_histogram" measures a Histogram with many bins, with
+// and without huge pages (see Memory::set_huge_pages()), since for
+// accumulators that do not fit into the caches, TLB misses can dominate.
+//
+// Besides the number of samples processed per second, the
+// machine-readable output contains for each measurement the "speedup"
+// relative to one thread and, if the hardware counters are accessible,
+// "cache_misses_per_sample" (see Benchmarks::CacheMissCounter).
+
+
+#include <benchmark.h>
+
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/histogram.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/memory.h>
+
+#include <latch>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Let 'n_threads' threads each call 'work(thread, n)' with their share of
+// the given number of samples, starting all at the same time, and return
+// the number of cache misses incurred.
+template <typename Work>
+std::uint64_t
+run_threads (const unsigned int  n_threads,
+             const std::uint64_t n_samples,
+             const Work         &work)
+{
+  std::latch start (n_threads + 1);
+
+  Benchmarks::CacheMissCounter counter;
+  counter.start ();
+
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<n_threads; ++t)
+    threads.emplace_back ([&, t]()
+    {
+      start.arrive_and_wait ();
+      work (t, n_samples / n_threads);
+    });
+  start.arrive_and_wait ();
+  for (auto &thread : threads)
+    thread.join ();
+
+  return counter.stop ();
+}
+
+
+
+// Report a measurement along with its speedup over the one-thread case
+// and the number of cache misses per sample.
+void
+report (Benchmarks::Reporter               &reporter,
+        const std::string                  &benchmark,
+        const Benchmarks::Parameters       &parameters,
+        const std::string                  &key,
+        const unsigned int                  n_threads,
+        const Benchmarks::Measurement      &measurement,
+        const std::uint64_t                 n_cache_misses,
+        std::map<std::string,double>       &single_thread_throughput)
+{
+  const double throughput = measurement.n_samples / measurement.seconds;
+  if (n_threads == 1)
+    single_thread_throughput[key] = throughput;
+
+  std::vector<std::pair<std::string,double>> extra;
+  if (single_thread_throughput.contains (key))
+    extra.emplace_back ("speedup", throughput / single_thread_throughput[key]);
+  if (n_cache_misses > 0)
+    extra.emplace_back ("cache_misses_per_sample", 1. * n_cache_misses / measurement.n_samples);
+
+  reporter.report (benchmark, parameters, measurement, 1, extra);
+}
+
+
+
+template <typename ConsumerType, typename CreateConsumer>
+void
+run_shared_consumer (Benchmarks::Reporter         &reporter,
+                     const std::string            &consumer_name,
+                     const CreateConsumer         &create_consumer,
+                     const unsigned int            n_threads,
+                     std::map<std::string,double> &single_thread_throughput)
+{
+  const Benchmarks::Parameters parameters =
+  {
+    {"consumer", consumer_name},
+    {"n_threads", std::to_string (n_threads)}
+  };
+  if (reporter.selected ("shared_consumer", parameters) == false)
+    return;
+
+  const auto samples = Benchmarks::random_samples<double> (1);
+
+  std::uint64_t n_cache_misses = 0;
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    const std::unique_ptr<ConsumerType> consumer = create_consumer();
+    n_cache_misses = run_threads (n_threads, n_samples,
+                                  [&](const unsigned int thread, const std::uint64_t n)
+    {
+      for (std::uint64_t i=0; i<n; ++i)
+        {
+          const auto &[sample, aux_data] = samples[(i + thread) % samples.size()];
+          consumer->consume (sample, aux_data);
+        }
+    });
+    Benchmarks::do_not_optimize (consumer->get());
+  };
+
+  const Benchmarks::Measurement measurement = reporter.measure (run, 1000*n_threads);
+  report (reporter, "shared_consumer", parameters, consumer_name, n_threads,
+          measurement, n_cache_misses, single_thread_throughput);
+}
+
+
+
+void
+run_packed_counters (Benchmarks::Reporter         &reporter,
+                     const bool                    padded,
+                     const unsigned int            n_threads,
+                     std::map<std::string,double> &single_thread_throughput)
+{
+  const Benchmarks::Parameters parameters =
+  {
+    {"layout", (padded ? "cache_line_allocator" : "packed")},
+    {"n_threads", std::to_string (n_threads)}
+  };
+  if (reporter.selected ("packed_counters", parameters) == false)
+    return;
+
+  using Allocator = SampleFlow::Memory::CacheLineAllocator<std::uint64_t>;
+
+  std::uint64_t n_cache_misses = 0;
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    // Either one array with a counter per thread, or one allocation per
+    // counter:
+    std::vector<std::uint64_t> packed (n_threads, 0);
+    std::vector<std::uint64_t *> counters (n_threads);
+    for (unsigned int t=0; t<n_threads; ++t)
+      if (padded)
+        counters[t] = new (Allocator().allocate (1)) std::uint64_t (0);
+      else
+        counters[t] = &packed[t];
+
+    n_cache_misses = run_threads (n_threads, n_samples,
+                                  [&](const unsigned int thread, const std::uint64_t n)
+    {
+      std::uint64_t *const counter = counters[thread];
+      for (std::uint64_t i=0; i<n; ++i)
+        {
+          ++*counter;
+          Benchmarks::do_not_optimize (*counter);
+        }
+    });
+
+    if (padded)
+      for (std::uint64_t *counter : counters)
+        Allocator().deallocate (counter, 1);
+  };
+
+  const Benchmarks::Measurement measurement = reporter.measure (run, 1000*n_threads);
+  report (reporter, "packed_counters", parameters, parameters[0].second, n_threads,
+          measurement, n_cache_misses, single_thread_throughput);
+}
+
+
+
+void
+run_large_histogram (Benchmarks::Reporter         &reporter,
+                     const bool                    huge_pages,
+                     const unsigned int            n_threads,
+                     std::map<std::string,double> &single_thread_throughput)
+{
+  const unsigned int n_bins = 1 << 22;
+  const Benchmarks::Parameters parameters =
+  {
+    {"n_bins", std::to_string (n_bins)},
+    {"huge_pages", (huge_pages ? "yes" : "no")},
+    {"n_threads", std::to_string (n_threads)}
+  };
+  if (reporter.selected ("large_histogram", parameters) == false)
+    return;
+
+  SampleFlow::Memory::set_huge_pages (huge_pages);
+
+  // Spread the samples over all bins so that every sample touches a
+  // different page:
+  std::vector<std::pair<double,SampleFlow::AuxiliaryData>> samples (1 << 16);
+  for (std::size_t i=0; i<samples.size(); ++i)
+    samples[i].first = ((i * 2654435761U) % n_bins + 0.5) / n_bins;
+
+  std::uint64_t n_cache_misses = 0;
+  const auto run = [&](const std::uint64_t n_samples)
+  {
+    SampleFlow::Consumers::Histogram<double> histogram (0, 1, n_bins);
+    n_cache_misses = run_threads (n_threads, n_samples,
+                                  [&](const unsigned int thread, const std::uint64_t n)
+    {
+      for (std::uint64_t i=0; i<n; ++i)
+        {
+          const auto &[sample, aux_data] = samples[(i + 997*thread) % samples.size()];
+          histogram.consume (sample, aux_data);
+        }
+    });
+    Benchmarks::do_not_optimize (histogram.get());
+  };
+
+  const Benchmarks::Measurement measurement = reporter.measure (run, 1000*n_threads);
+  report (reporter, "large_histogram", parameters, parameters[1].second, n_threads,
+          measurement, n_cache_misses, single_thread_throughput);
+
+  SampleFlow::Memory::set_huge_pages (false);
+}
+
+
+
+int main (int argc, char **argv)
+{
+  Benchmarks::Reporter reporter ("shard_layout", argc, argv);
+
+  std::cout << "Running on " << std::thread::hardware_concurrency() << " hardware threads";
+  if (Benchmarks::CacheMissCounter().available() == false)
+    std::cout << "; cache miss counters are not available";
+  std::cout << std::endl;
+
+  std::map<std::string,double> single_thread_throughput;
+  for (unsigned int n_threads=1; n_threads<=128; n_threads*=2)
+    {
+      run_packed_counters (reporter, false, n_threads, single_thread_throughput);
+      run_packed_counters (reporter, true, n_threads, single_thread_throughput);
+
+      run_shared_consumer<SampleFlow::Consumers::CountSamples<double>>
+      (reporter, "CountSamples",
+       []()
+      {
+        return std::make_unique<SampleFlow::Consumers::CountSamples<double>>();
+      },
+      n_threads, single_thread_throughput);
+      run_shared_consumer<SampleFlow::Consumers::MeanValue<double>>
+      (reporter, "MeanValue",
+       []()
+      {
+        return std::make_unique<SampleFlow::Consumers::MeanValue<double>>();
+      },
+      n_threads, single_thread_throughput);
+      run_shared_consumer<SampleFlow::Consumers::Histogram<double>>
+      (reporter, "Histogram",
+       []()
+      {
+        return std::make_unique<SampleFlow::Consumers::Histogram<double>>(-3, 3, 100);
+      },
+      n_threads, single_thread_throughput);
+    }
+
+  single_thread_throughput.clear();
+  for (unsigned int n_threads=1; n_threads<=128; n_threads*=2)
+    {
+      run_large_histogram (reporter, false, n_threads, single_thread_throughput);
+      run_large_histogram (reporter, true, n_threads, single_thread_throughput);
+    }
+}
@@ -19,8 +19,18 @@
 #include <sampleflow/config.h>
 
 #include <any>
-#include <map>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/auxiliary_data.impl.h>
@@ -36,7 +36,7 @@ namespace SampleFlow
    *
    * Since different producer (or filter) classes may want to pass along
    * different kinds of information, the data type used is rather general:
-   * It is a map with string keys that identify what the additional
+   * It acts like a map with keys that identify what the additional
    * information is, and an object of type std::any that stores the
    * information itself. std::any is a data type that wraps around an
    * object of any kind, in essence by storing something like a `void`
@@ -49,6 +49,782 @@ namespace SampleFlow
    * Producers passing along such additional data need to document the string
    * under which the data is stored in the map and the type of the data
    * so stored.
+   *
+   *
+   * ### Implementation ###
+   *
+   * Objects of this type are created for every sample, and are copied
+   * as they are passed from producers through filters to consumers.
+   * Consequently, it is important that creating and copying them is
+   * cheap. This class therefore does not store the keys as strings,
+   * but as objects of type AuxiliaryData::Key that are just numbers: Each
+   * string that is ever used as a key is assigned a number the first time
+   * it is used ("interned"), and comparing keys then only requires
+   * comparing these numbers. The keys used by the producers of this library
+   * are predefined as static members of this class (for example,
+   * AuxiliaryData::relative_log_likelihood) and can be used without ever
+   * looking at a string.
+   *
+   * Furthermore, the key-value pairs are not stored in a tree as in
+   * `std::map`, but in a small array that is part of the object itself
+   * (with room for `n_inline_entries` entries) so that, in the
+   * common case, no memory needs to be allocated. Only if more entries are
+   * stored are they moved to an array on the heap. Because all
+   * producers in this library attach only a handful of
+   * entries, finding an entry by linearly searching through this array
+   * is cheaper than any more sophisticated data structure would be.
+   * Finally, `std::any` stores small objects such as `double`, `bool`, and
+   * `std::size_t` values inside itself, without allocating memory.
+   *
+   * The interface of this class mimics that of
+   * `std::map<std::string,std::any>` (which is what this type used to be)
+   * to the extent it is used in practice, with one difference: Iterating
+   * over the entries of an object visits them in the order in which
+   * they were added, not in alphabetical order of their keys.
    */
-  using AuxiliaryData = std::map<std::string, std::any>;
+  class AuxiliaryData
+  {
+    public:
+      /**
+       * A class that represents the keys under which data is stored.
+       * Objects of this type can be created from strings (and, consequently,
+       * one can write `aux_data.find("relative log likelihood")`), but
+       * internally they only store the number associated with the string.
+       * Creating a key from a string requires looking up the string in a
+       * global table, which is a comparatively expensive operation; code that
+       * is executed for every sample should therefore create the Key object
+       * only once, or use one of the predefined keys.
+       */
+      class Key
+      {
+        public:
+          /**
+           * Default constructor. Creates an invalid key that does not
+           * correspond to any string.
+           */
+          constexpr Key ();
+
+          /**
+           * Constructor. Look up the number associated with the given
+           * string, or create a new number if the string has not been
+           * seen before.
+           */
+          Key (const std::string_view &name);
+
+          /**
+           * Same as above, for strings of type `std::string`.
+           */
+          Key (const std::string &name);
+
+          /**
+           * Same as above, for string literals.
+           */
+          Key (const char *name);
+
+          /**
+           * Return the string this key corresponds to.
+           */
+          const std::string &
+          name () const;
+
+          /**
+           * Compare two keys for equality.
+           */
+          constexpr bool
+          operator== (const Key &other) const = default;
+
+        private:
+          /**
+           * The numbers associated with the predefined keys.
+           */
+          enum class Predefined : unsigned int
+          {
+            relative_log_likelihood    = 0,
+            sample_is_repeated         = 1,
+            chain_number               = 2,
+            rejection_stage            = 3,
+            repetition_count           = 4,
+            sample_weight              = 5,
+            likelihood_evaluation_time = 6,
+            proposal_time              = 7,
+            n_likelihood_blocks        = 8,
+            meeting_time               = 9
+          };
+
+          /**
+           * Constructor for the predefined keys.
+           */
+          constexpr explicit Key (const Predefined predefined_key);
+
+          /**
+           * The number associated with the string this key represents.
+           */
+          unsigned int index;
+
+          /**
+           * Return a reference to the global table of strings that have
+           * been used as keys. The position of a string in this table is its
+           * associated number. The table is initialized with the
+           * predefined keys.
+           */
+          static
+          std::deque<std::string> &
+          key_names ();
+
+          /**
+           * A map from strings to their position in key_names(), and a mutex
+           * that protects accessing both of these tables.
+           */
+          static
+          std::unordered_map<std::string,unsigned int> &
+          key_indices ();
+
+          static
+          std::mutex &
+          key_mutex ();
+
+          friend class AuxiliaryData;
+      };
+
+      /**
+       * The type of the key-value pairs stored in an object of this type.
+       * As for `std::map`, the key is called `first` and the value
+       * `second`.
+       */
+      struct value_type
+      {
+        Key      first;
+        std::any second;
+      };
+
+      using iterator       = value_type *;
+      using const_iterator = const value_type *;
+
+      /**
+       * The key under which producers in this library store the logarithm
+       * of the (relative) likelihood of a sample, as an object of type
+       * `double`. The corresponding string is "relative log likelihood".
+       */
+      static const Key relative_log_likelihood;
+
+      /**
+       * The key under which producers in this library store whether the
+       * sample is the same as the previous one (for example because a
+       * Metropolis-Hastings trial sample was rejected), as an object of type
+       * `bool`. The corresponding string is "sample is repeated".
+       */
+      static const Key sample_is_repeated;
+
+      /**
+       * The key under which producers that run several chains (such as
+       * Producers::DifferentialEvaluationMetropolisHastings) store the
+       * number of the chain a sample belongs to, as an object of type
+       * `std::size_t`. The corresponding string is "chain number".
+       */
+      static const Key chain_number;
+
+      /**
+       * The key under which producers that decide whether to accept a trial
+       * sample in several stages (such as
+       * Producers::DelayedAcceptanceMetropolisHastings) store at which stage
+       * the trial sample was rejected, as an object of type `unsigned int`:
+       * Zero if the trial sample was accepted, and otherwise the (one-based)
+       * number of the stage that rejected it. The corresponding string is
+       * "rejection stage".
+       */
+      static const Key rejection_stage;
+
+      /**
+       * The key under which producers that send each sample only once,
+       * rather than once for every step in which the sampling algorithm
+       * stays at the same sample (such as Producers::MetropolisHastings
+       * with Parameters::compress_repeated_samples set), store how many
+       * samples the sample stands for, as an object of type `std::size_t`.
+       * Consumers that compute statistics over samples treat a sample
+       * with this entry as if they had received that many copies of it;
+       * see also n_repetitions(). The corresponding string is "repetition
+       * count".
+       */
+      static const Key repetition_count;
+
+      /**
+       * The key under which producers (or filters) store the weight of a
+       * sample, as an object of type `double`, for example the importance
+       * weight in importance sampling or in sequential Monte Carlo methods.
+       * Consumers that compute statistics over samples treat a sample with
+       * weight $w$ as contributing $w$ times as much as a sample without
+       * this entry; see also weight(). If a sample also has an entry under
+       * the key repetition_count, then each of the copies it stands for has
+       * this weight. Weights must be non-negative. The corresponding string
+       * is "sample weight".
+       */
+      static const Key sample_weight;
+
+      /**
+       * The keys under which samplers that are asked to time the calls of
+       * the likelihood function and of the function that proposes trial
+       * samples (such as Producers::MetropolisHastings with
+       * Parameters::record_timings set) store how long these calls took
+       * in the step that produced a sample, in seconds, as objects of
+       * type `double`. If a step involves several calls (for example in
+       * Producers::DelayedRejectionMetropolisHastings), the value is the
+       * sum of the times of all of them. The corresponding strings are
+       * "likelihood evaluation time" and "proposal time".
+       */
+      static const Key likelihood_evaluation_time;
+      static const Key proposal_time;
+
+      /**
+       * The key under which producers that evaluate the likelihood only on
+       * a subset of the data in each step (such as
+       * Producers::SubsampledMetropolisHastings) store how many blocks of
+       * the data they evaluated in the step that produced a sample, as an
+       * object of type `std::size_t`. The corresponding string is "number
+       * of likelihood blocks".
+       */
+      static const Key n_likelihood_blocks;
+
+      /**
+       * The key under which producers that run pairs of coupled chains
+       * (such as Producers::CoupledMetropolisHastings) store the number of
+       * steps after which the two chains of a pair met, as an object of
+       * type `types::sample_index`. The corresponding string is "meeting
+       * time".
+       */
+      static const Key meeting_time;
+
+      /**
+       * The number of entries that can be stored without allocating
+       * memory.
+       */
+      static constexpr std::size_t n_inline_entries = 4;
+
+      /**
+       * Constructor. Create an empty object.
+       */
+      AuxiliaryData () = default;
+
+      /**
+       * Constructor. Create an object that stores the given key-value
+       * pairs. As for `std::map`, if a key appears more than once, only the
+       * first of the values is stored.
+       */
+      AuxiliaryData (std::initializer_list<value_type> entries);
+
+      /**
+       * Copy and move constructors and assignment operators.
+       */
+      AuxiliaryData (const AuxiliaryData &aux_data) = default;
+      AuxiliaryData (AuxiliaryData &&aux_data) = default;
+      AuxiliaryData &operator= (const AuxiliaryData &aux_data) = default;
+      AuxiliaryData &operator= (AuxiliaryData &&aux_data) = default;
+
+      /**
+       * Return the number of entries stored.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Return whether no entries are stored.
+       */
+      bool
+      empty () const;
+
+      /**
+       * Iterators to the first and one past the last entry.
+       */
+      iterator begin ();
+      iterator end ();
+      const_iterator begin () const;
+      const_iterator end () const;
+
+      /**
+       * Return an iterator to the entry with the given key, or end() if
+       * there is no such entry.
+       */
+      iterator
+      find (const Key &key);
+
+      const_iterator
+      find (const Key &key) const;
+
+      /**
+       * Return whether there is an entry with the given key.
+       */
+      bool
+      contains (const Key &key) const;
+
+      /**
+       * Return a reference to the value stored under the given key. If there
+       * is no such entry yet, add one with an empty value.
+       */
+      std::any &
+      operator[] (const Key &key);
+
+      /**
+       * Return a pointer to the value stored under the given key, if there is
+       * such an entry and if its value is of type `T`. Otherwise return
+       * `nullptr`. This combines find() and `std::any_cast` into one
+       * convenient function.
+       */
+      template <typename T>
+      const T *
+      get_if (const Key &key) const;
+
+      /**
+       * Return the number of samples the sample this object belongs to
+       * stands for, i.e., the value stored under the key repetition_count
+       * if there is such an entry, and one otherwise.
+       */
+      std::size_t
+      n_repetitions () const;
+
+      /**
+       * Return the weight of the sample this object belongs to, i.e., the
+       * value stored under the key sample_weight if there is such an entry,
+       * and one otherwise. The total weight the sample contributes to
+       * statistics is then `n_repetitions() * weight()`.
+       */
+      double
+      weight () const;
+
+      /**
+       * Remove the entry with the given key, if there is one.
+       *
+       * @return The number of entries removed (i.e., zero or one).
+       */
+      std::size_t
+      erase (const Key &key);
+
+      /**
+       * Remove all entries.
+       */
+      void
+      clear ();
+
+    private:
+      /**
+       * The number of entries stored.
+       */
+      std::size_t n_entries = 0;
+
+      /**
+       * The entries if there are no more than `n_inline_entries` of them.
+       */
+      std::array<value_type,n_inline_entries> inline_entries;
+
+      /**
+       * The entries if there are more than `n_inline_entries` of
+       * them. Empty otherwise.
+       */
+      std::vector<value_type> heap_entries;
+
+      /**
+       * Add an entry at the end of the list of entries without checking
+       * whether an entry with the same key already exists, and return a
+       * reference to it.
+       */
+      value_type &
+      append (const Key &key, std::any &&value);
+  };
+
+
+  /**
+   * Output the string a key corresponds to into the given stream.
+   */
+  std::ostream &
+  operator<< (std::ostream &out, const AuxiliaryData::Key &key);
+
+
+
+  inline
+  constexpr
+  AuxiliaryData::Key::Key ()
+    :
+    index (static_cast<unsigned int>(-1))
+  {}
+
+
+
+  inline
+  constexpr
+  AuxiliaryData::Key::Key (const Predefined predefined_key)
+    :
+    index (static_cast<unsigned int>(predefined_key))
+  {}
+
+
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::relative_log_likelihood (AuxiliaryData::Key::Predefined::relative_log_likelihood);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::sample_is_repeated (AuxiliaryData::Key::Predefined::sample_is_repeated);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::chain_number (AuxiliaryData::Key::Predefined::chain_number);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::rejection_stage (AuxiliaryData::Key::Predefined::rejection_stage);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::repetition_count (AuxiliaryData::Key::Predefined::repetition_count);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::sample_weight (AuxiliaryData::Key::Predefined::sample_weight);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::likelihood_evaluation_time (AuxiliaryData::Key::Predefined::likelihood_evaluation_time);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::proposal_time (AuxiliaryData::Key::Predefined::proposal_time);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::n_likelihood_blocks (AuxiliaryData::Key::Predefined::n_likelihood_blocks);
+
+  inline
+  constexpr
+  AuxiliaryData::Key
+  AuxiliaryData::meeting_time (AuxiliaryData::Key::Predefined::meeting_time);
+
+
+
+  inline
+  AuxiliaryData::Key::Key (const std::string_view &name)
+  {
+    std::lock_guard<std::mutex> lock (key_mutex());
+
+    std::unordered_map<std::string,unsigned int> &indices = key_indices();
+    const auto p = indices.find (std::string(name));
+    if (p != indices.end())
+      index = p->second;
+    else
+      {
+        index = key_names().size();
+        key_names().emplace_back (name);
+        indices.emplace (name, index);
+      }
+  }
+
+
+
+  inline
+  AuxiliaryData::Key::Key (const std::string &name)
+    :
+    Key (std::string_view(name))
+  {}
+
+
+
+  inline
+  AuxiliaryData::Key::Key (const char *name)
+    :
+    Key (std::string_view(name))
+  {}
+
+
+
+  inline
+  const std::string &
+  AuxiliaryData::Key::name () const
+  {
+    std::lock_guard<std::mutex> lock (key_mutex());
+
+    assert (index < key_names().size());
+    return key_names()[index];
+  }
+
+
+
+  inline
+  std::deque<std::string> &
+  AuxiliaryData::Key::key_names ()
+  {
+    // The order of these strings must match the numbers used for the
+    // predefined keys in the Key::Predefined enum.
+    static std::deque<std::string> names
+    {
+      "relative log likelihood",
+      "sample is repeated",
+      "chain number",
+      "rejection stage",
+      "repetition count",
+      "sample weight",
+      "likelihood evaluation time",
+      "proposal time",
+      "number of likelihood blocks",
+      "meeting time"
+    };
+    return names;
+  }
+
+
+
+  inline
+  std::unordered_map<std::string,unsigned int> &
+  AuxiliaryData::Key::key_indices ()
+  {
+    static std::unordered_map<std::string,unsigned int> indices
+    {
+      {"relative log likelihood",    relative_log_likelihood.index},
+      {"sample is repeated",         sample_is_repeated.index},
+      {"chain number",               chain_number.index},
+      {"rejection stage",            rejection_stage.index},
+      {"repetition count",           repetition_count.index},
+      {"sample weight",              sample_weight.index},
+      {"likelihood evaluation time", likelihood_evaluation_time.index},
+      {"proposal time",              proposal_time.index},
+      {"number of likelihood blocks", n_likelihood_blocks.index},
+      {"meeting time",               meeting_time.index}
+    };
+    return indices;
+  }
+
+
+
+  inline
+  std::mutex &
+  AuxiliaryData::Key::key_mutex ()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+
+
+  inline
+  std::ostream &
+  operator<< (std::ostream &out, const AuxiliaryData::Key &key)
+  {
+    return (out << key.name());
+  }
+
+
+
+  inline
+  AuxiliaryData::AuxiliaryData (std::initializer_list<value_type> entries)
+  {
+    for (const value_type &entry : entries)
+      if (contains (entry.first) == false)
+        append (entry.first, std::any(entry.second));
+  }
+
+
+
+  inline
+  std::size_t
+  AuxiliaryData::size () const
+  {
+    return n_entries;
+  }
+
+
+
+  inline
+  bool
+  AuxiliaryData::empty () const
+  {
+    return (n_entries == 0);
+  }
+
+
+
+  inline
+  AuxiliaryData::iterator
+  AuxiliaryData::begin ()
+  {
+    return (heap_entries.empty() ? inline_entries.data() : heap_entries.data());
+  }
+
+
+
+  inline
+  AuxiliaryData::iterator
+  AuxiliaryData::end ()
+  {
+    return begin() + n_entries;
+  }
+
+
+
+  inline
+  AuxiliaryData::const_iterator
+  AuxiliaryData::begin () const
+  {
+    return (heap_entries.empty() ? inline_entries.data() : heap_entries.data());
+  }
+
+
+
+  inline
+  AuxiliaryData::const_iterator
+  AuxiliaryData::end () const
+  {
+    return begin() + n_entries;
+  }
+
+
+
+  inline
+  AuxiliaryData::iterator
+  AuxiliaryData::find (const Key &key)
+  {
+    for (iterator p = begin(); p != end(); ++p)
+      if (p->first == key)
+        return p;
+    return end();
+  }
+
+
+
+  inline
+  AuxiliaryData::const_iterator
+  AuxiliaryData::find (const Key &key) const
+  {
+    for (const_iterator p = begin(); p != end(); ++p)
+      if (p->first == key)
+        return p;
+    return end();
+  }
+
+
+
+  inline
+  bool
+  AuxiliaryData::contains (const Key &key) const
+  {
+    return (find(key) != end());
+  }
+
+
+
+  inline
+  std::any &
+  AuxiliaryData::operator[] (const Key &key)
+  {
+    const iterator p = find(key);
+    if (p != end())
+      return p->second;
+    else
+      return append (key, std::any()).second;
+  }
+
+
+
+  template <typename T>
+  const T *
+  AuxiliaryData::get_if (const Key &key) const
+  {
+    const const_iterator p = find(key);
+    if (p != end())
+      return std::any_cast<T>(&p->second);
+    else
+      return nullptr;
+  }
+
+
+
+  inline
+  std::size_t
+  AuxiliaryData::n_repetitions () const
+  {
+    const std::size_t *n = get_if<std::size_t> (repetition_count);
+    return (n != nullptr ? *n : 1);
+  }
+
+
+
+  inline
+  double
+  AuxiliaryData::weight () const
+  {
+    const double *w = get_if<double> (sample_weight);
+    assert ((w == nullptr) || (*w >= 0));
+    return (w != nullptr ? *w : 1.);
+  }
+
+
+
+  inline
+  std::size_t
+  AuxiliaryData::erase (const Key &key)
+  {
+    const iterator p = find(key);
+    if (p == end())
+      return 0;
+
+    // Shift all following entries forward by one, then reset the now
+    // unused last entry so that it does not hold on to its value.
+    for (iterator q = p; q+1 != end(); ++q)
+      *q = std::move(*(q+1));
+    (end()-1)->second.reset();
+
+    --n_entries;
+    if (heap_entries.empty() == false)
+      heap_entries.pop_back();
+
+    return 1;
+  }
+
+
+
+  inline
+  void
+  AuxiliaryData::clear ()
+  {
+    for (value_type &entry : inline_entries)
+      entry.second.reset();
+    heap_entries.clear();
+    n_entries = 0;
+  }
+
+
+
+  inline
+  AuxiliaryData::value_type &
+  AuxiliaryData::append (const Key &key, std::any &&value)
+  {
+    if (heap_entries.empty() && (n_entries < n_inline_entries))
+      {
+        inline_entries[n_entries].first  = key;
+        inline_entries[n_entries].second = std::move(value);
+        return inline_entries[n_entries++];
+      }
+    else
+      {
+        // We are out of space in the inline array. Move everything to
+        // the heap the first time this happens.
+        if (heap_entries.empty())
+          {
+            heap_entries.reserve (2*n_inline_entries);
+            for (value_type &entry : inline_entries)
+              {
+                heap_entries.emplace_back (std::move(entry));
+                entry.second.reset();
+              }
+          }
+        heap_entries.emplace_back (value_type {key, std::move(value)});
+        ++n_entries;
+        return heap_entries.back();
+      }
+  }
 }
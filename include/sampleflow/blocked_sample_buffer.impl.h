@@ -0,0 +1,306 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores a sequence of samples, along with their repetition
+   * counts and weights, in contiguous blocks of memory. This is the storage
+   * consumers use in Evaluation::lazy mode: They only append samples to an
+   * object of this class while samples are generated, and later loop over
+   * the blocks returned by blocks() to compute their statistic one block
+   * (and one processor core) at a time.
+   *
+   * The elements of the samples in a block are stored one sample after the
+   * other, i.e., a block is a $d\times n$ matrix in column-major order,
+   * which is the layout Eigen uses by default. All samples in a buffer need
+   * to have the same number of elements $d$.
+   *
+   * Blocks that are full are never changed again, and are stored via
+   * `std::shared_ptr<const Block>`. Copying an object of this class
+   * therefore only copies these pointers and the one block that is still
+   * being filled, and its cost does not grow with the number of samples
+   * stored. This is important because consumers keep their state in
+   * ShardedAccumulator or CopyOnWrite objects, which copy the state
+   * whenever a thread modifies it after get() has taken a snapshot.
+   *
+   * The class is not thread-safe: If several threads access the same
+   * object, the caller needs to provide the necessary synchronization.
+   *
+   * @tparam ScalarType The type of the elements of the samples.
+   */
+  template <typename ScalarType>
+  class BlockedSampleBuffer
+  {
+    public:
+      /**
+       * A structure that holds a block of samples.
+       */
+      struct Block
+      {
+        /**
+         * The number of elements of each sample.
+         */
+        unsigned int dimension = 0;
+
+        /**
+         * The elements of the samples, stored one sample after the other.
+         */
+        std::vector<ScalarType> values;
+
+        /**
+         * The repetition counts and weights of the samples.
+         */
+        std::vector<types::sample_index> n_repetitions;
+        std::vector<double>              weights;
+
+        /**
+         * Return the number of samples stored in this block.
+         */
+        std::size_t
+        size () const;
+
+        /**
+         * Return a pointer to the first element of the `i`th sample.
+         */
+        const ScalarType *
+        sample (const std::size_t i) const;
+      };
+
+      /**
+       * Default constructor. Store samples in blocks of 1024 samples.
+       */
+      BlockedSampleBuffer ();
+
+      /**
+       * Constructor.
+       *
+       * @param[in] block_size The number of samples stored in each block.
+       */
+      explicit
+      BlockedSampleBuffer (const std::size_t block_size);
+
+      /**
+       * Append a sample with `dimension` elements, stored contiguously
+       * starting at `values`, along with its repetition count and weight.
+       */
+      void
+      push_back (const ScalarType          *values,
+                 const unsigned int         dimension,
+                 const types::sample_index  n_repetitions,
+                 const double               weight);
+
+      /**
+       * Append all samples stored in another object. The full blocks of
+       * the other object are shared, not copied.
+       */
+      void
+      append (const BlockedSampleBuffer &other);
+
+      /**
+       * Return the number of samples stored.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Return whether no samples are stored.
+       */
+      bool
+      empty () const;
+
+      /**
+       * Return the blocks of samples stored, in the order in which the
+       * samples were appended. The last block may contain fewer samples
+       * than the block size passed to the constructor.
+       */
+      std::vector<std::shared_ptr<const Block>>
+      blocks () const;
+
+      /**
+       * Remove all samples.
+       */
+      void
+      clear ();
+
+      /**
+       * Return an estimate of the memory used by the samples stored.
+       */
+      std::size_t
+      memory_consumption () const;
+
+    private:
+      /**
+       * The number of samples per block.
+       */
+      std::size_t block_size;
+
+      /**
+       * The blocks that are full, and the one that is currently being
+       * filled.
+       */
+      std::vector<std::shared_ptr<const Block>> full_blocks;
+      Block                                     current_block;
+  };
+
+
+
+  template <typename ScalarType>
+  std::size_t
+  BlockedSampleBuffer<ScalarType>::Block::size () const
+  {
+    return weights.size();
+  }
+
+
+
+  template <typename ScalarType>
+  const ScalarType *
+  BlockedSampleBuffer<ScalarType>::Block::sample (const std::size_t i) const
+  {
+    assert (i < size());
+    return values.data() + i*dimension;
+  }
+
+
+
+  template <typename ScalarType>
+  BlockedSampleBuffer<ScalarType>::BlockedSampleBuffer ()
+    :
+    BlockedSampleBuffer (1024)
+  {}
+
+
+
+  template <typename ScalarType>
+  BlockedSampleBuffer<ScalarType>::BlockedSampleBuffer (const std::size_t block_size)
+    :
+    block_size (block_size)
+  {
+    assert (block_size > 0);
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  BlockedSampleBuffer<ScalarType>::push_back (const ScalarType          *values,
+                                              const unsigned int         dimension,
+                                              const types::sample_index  n_repetitions,
+                                              const double               weight)
+  {
+    if (current_block.weights.empty())
+      {
+        current_block.dimension = dimension;
+        current_block.values.reserve (std::size_t(dimension) * block_size);
+        current_block.n_repetitions.reserve (block_size);
+        current_block.weights.reserve (block_size);
+      }
+    assert (dimension == current_block.dimension);
+
+    current_block.values.insert (current_block.values.end(), values, values+dimension);
+    current_block.n_repetitions.push_back (n_repetitions);
+    current_block.weights.push_back (weight);
+
+    // Once the block is full, move it to the list of blocks that are no
+    // longer changed:
+    if (current_block.size() == block_size)
+      {
+        full_blocks.emplace_back (std::make_shared<const Block>(std::move(current_block)));
+        current_block = Block();
+      }
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  BlockedSampleBuffer<ScalarType>::append (const BlockedSampleBuffer &other)
+  {
+    // Appending the full blocks of the other object after our partially
+    // filled one would break the order of samples. So first close the
+    // current block, even though it is not full:
+    if (current_block.size() > 0)
+      {
+        full_blocks.emplace_back (std::make_shared<const Block>(std::move(current_block)));
+        current_block = Block();
+      }
+
+    full_blocks.insert (full_blocks.end(), other.full_blocks.begin(), other.full_blocks.end());
+    current_block = other.current_block;
+  }
+
+
+
+  template <typename ScalarType>
+  std::size_t
+  BlockedSampleBuffer<ScalarType>::size () const
+  {
+    std::size_t n = current_block.size();
+    for (const auto &block : full_blocks)
+      n += block->size();
+    return n;
+  }
+
+
+
+  template <typename ScalarType>
+  bool
+  BlockedSampleBuffer<ScalarType>::empty () const
+  {
+    return (full_blocks.empty() && (current_block.size() == 0));
+  }
+
+
+
+  template <typename ScalarType>
+  std::vector<std::shared_ptr<const typename BlockedSampleBuffer<ScalarType>::Block>>
+  BlockedSampleBuffer<ScalarType>::blocks () const
+  {
+    std::vector<std::shared_ptr<const Block>> all_blocks = full_blocks;
+    if (current_block.size() > 0)
+      all_blocks.emplace_back (std::make_shared<const Block>(current_block));
+    return all_blocks;
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  BlockedSampleBuffer<ScalarType>::clear ()
+  {
+    full_blocks.clear();
+    current_block = Block();
+  }
+
+
+
+  template <typename ScalarType>
+  std::size_t
+  BlockedSampleBuffer<ScalarType>::memory_consumption () const
+  {
+    const auto block_memory = [](const Block &block)
+    {
+      return (block.values.capacity() * sizeof(ScalarType)
+              + block.n_repetitions.capacity() * sizeof(types::sample_index)
+              + block.weights.capacity() * sizeof(double));
+    };
+
+    std::size_t memory = sizeof(*this) + block_memory (current_block);
+    for (const auto &block : full_blocks)
+      memory += sizeof(Block) + block_memory (*block);
+    return memory;
+  }
+}
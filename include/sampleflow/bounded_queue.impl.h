@@ -0,0 +1,262 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that implements a first-in first-out queue of objects of type
+   * `T` with a fixed maximal number of elements. The queue is "lock-free",
+   * i.e., adding and removing elements does not require acquiring a mutex.
+   * Rather, each slot of the queue carries a sequence number that tells
+   * whether the slot is currently empty or full, and threads that want to
+   * add or remove an element reserve a slot by atomically advancing a
+   * position counter. (This is a variation of the well-known bounded
+   * queue design due to Dmitry Vyukov.) Any number of threads can add and
+   * remove elements concurrently, though the typical use in this library is
+   * that several threads add elements and only one thread at a time removes
+   * them.
+   *
+   * Because the queue has a fixed capacity, try_push() may fail. What
+   * should happen in that case is up to the caller; the Consumer class,
+   * for example, uses this class to hold the samples waiting for
+   * processing in ParallelMode::asynchronous and, depending on the
+   * QueueFullPolicy selected, blocks or drops the oldest sample if the
+   * queue is full.
+   *
+   * @tparam T The type of the objects stored in the queue. This type needs
+   *   to be move-constructible.
+   */
+  template <typename T>
+  class BoundedQueue
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] capacity The maximal number of elements that can be
+       *   stored in the queue at any given time. Must be at least one.
+       */
+      BoundedQueue (const std::size_t capacity);
+
+      /**
+       * Copy constructor. Queues cannot be copied, and so this
+       * constructor is deleted.
+       */
+      BoundedQueue (const BoundedQueue &) = delete;
+
+      /**
+       * Return the maximal number of elements the queue can hold.
+       */
+      std::size_t
+      capacity () const;
+
+      /**
+       * Return whether the queue is currently empty. In a concurrent
+       * context, the result of this function may of course already be
+       * outdated by the time it returns.
+       */
+      bool
+      empty () const;
+
+      /**
+       * Return the number of elements currently in the queue. As for
+       * empty(), the result may already be outdated by the time the
+       * function returns if other threads add or remove elements at the
+       * same time; it may then also include elements whose addition or
+       * removal has not been completed yet.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Add an element to the back of the queue if there is space.
+       *
+       * @param[in,out] element The element to be added. If the function
+       *   succeeds, then the element is moved from; otherwise, it is left
+       *   unchanged.
+       * @return Whether the element was added.
+       */
+      bool
+      try_push (T &element);
+
+      /**
+       * Remove the element at the front of the queue, if there is one.
+       *
+       * @return The element removed from the queue, or an empty
+       *   `std::optional` if the queue was empty.
+       */
+      std::optional<T>
+      try_pop ();
+
+    private:
+      /**
+       * A structure that represents one slot of the queue. The `sequence`
+       * member encodes the state of the slot: If it equals twice the
+       * position at which the next element may be added, then the slot is
+       * empty and can be filled; if it equals twice the position plus one,
+       * then the slot holds an element that can be removed. (Vyukov's
+       * original design uses the position itself rather than twice the
+       * position, but then cannot distinguish a full from an empty slot
+       * if the queue has only one slot.)
+       */
+      struct Cell
+      {
+        std::atomic<std::size_t> sequence;
+        std::optional<T>         element;
+      };
+
+      /**
+       * The number of slots.
+       */
+      const std::size_t n_cells;
+
+      /**
+       * The slots of the queue.
+       */
+      std::unique_ptr<Cell[]> cells;
+
+      /**
+       * The position at which the next element will be added, and the
+       * position from which the next element will be removed. These
+       * counters only ever increase; the slot associated with a position
+       * is the position modulo the number of slots. Both are placed on
+       * their own cache lines since they are typically accessed from
+       * different threads.
+       */
+      alignas(64) std::atomic<std::size_t> enqueue_position;
+      alignas(64) std::atomic<std::size_t> dequeue_position;
+  };
+
+
+
+  template <typename T>
+  BoundedQueue<T>::BoundedQueue (const std::size_t capacity)
+    :
+    n_cells (capacity),
+    cells (std::make_unique<Cell[]>(capacity)),
+    enqueue_position (0),
+    dequeue_position (0)
+  {
+    assert (capacity >= 1);
+
+    for (std::size_t i=0; i<n_cells; ++i)
+      cells[i].sequence.store (2*i, std::memory_order_relaxed);
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  BoundedQueue<T>::capacity () const
+  {
+    return n_cells;
+  }
+
+
+
+  template <typename T>
+  bool
+  BoundedQueue<T>::empty () const
+  {
+    const std::size_t position = dequeue_position.load (std::memory_order_acquire);
+    const std::size_t sequence
+      = cells[position % n_cells].sequence.load (std::memory_order_acquire);
+    return (sequence != 2*position+1);
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  BoundedQueue<T>::size () const
+  {
+    // Read the dequeue position first: Since both positions only ever
+    // increase, this ensures that the difference cannot be negative.
+    const std::size_t dequeued = dequeue_position.load (std::memory_order_acquire);
+    const std::size_t enqueued = enqueue_position.load (std::memory_order_acquire);
+    return std::min (enqueued - dequeued, n_cells);
+  }
+
+
+
+  template <typename T>
+  bool
+  BoundedQueue<T>::try_push (T &element)
+  {
+    std::size_t position = enqueue_position.load (std::memory_order_relaxed);
+    while (true)
+      {
+        Cell &cell = cells[position % n_cells];
+        const std::size_t sequence = cell.sequence.load (std::memory_order_acquire);
+
+        if (sequence == 2*position)
+          {
+            // The slot is empty. Try to reserve it by advancing the
+            // position counter. If this fails, 'position' is updated
+            // to the current value and we try again.
+            if (enqueue_position.compare_exchange_weak (position, position+1,
+                                                        std::memory_order_relaxed))
+              {
+                cell.element.emplace (std::move(element));
+                cell.sequence.store (2*position+1, std::memory_order_release);
+                return true;
+              }
+          }
+        else if (sequence < 2*position)
+          // The slot still holds the element that was added one
+          // round ago: the queue is full.
+          return false;
+        else
+          // Another thread has added an element since we read the
+          // position; try again with the new position.
+          position = enqueue_position.load (std::memory_order_relaxed);
+      }
+  }
+
+
+
+  template <typename T>
+  std::optional<T>
+  BoundedQueue<T>::try_pop ()
+  {
+    std::size_t position = dequeue_position.load (std::memory_order_relaxed);
+    while (true)
+      {
+        Cell &cell = cells[position % n_cells];
+        const std::size_t sequence = cell.sequence.load (std::memory_order_acquire);
+
+        if (sequence == 2*position+1)
+          {
+            // The slot holds an element. Try to claim it.
+            if (dequeue_position.compare_exchange_weak (position, position+1,
+                                                        std::memory_order_relaxed))
+              {
+                std::optional<T> element (std::move(cell.element));
+                cell.element.reset();
+
+                // Mark the slot as empty for the round that starts
+                // 'n_cells' positions from now:
+                cell.sequence.store (2*(position+n_cells), std::memory_order_release);
+                return element;
+              }
+          }
+        else if (sequence < 2*position+1)
+          // The slot has not been filled yet: the queue is empty.
+          return {};
+        else
+          position = dequeue_position.load (std::memory_order_relaxed);
+      }
+  }
+}
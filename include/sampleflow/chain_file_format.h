@@ -0,0 +1,41 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_CHAIN_FILE_FORMAT_H
+#define SAMPLEFLOW_CHAIN_FILE_FORMAT_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/auxiliary_data.h>
+#include <sampleflow/element_access.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/types.h>
+
+#include <any>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/chain_file_format.impl.h>
+
+#endif
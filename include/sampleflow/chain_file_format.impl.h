@@ -0,0 +1,549 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the description of the binary file format in which
+   * Consumers::StreamOutput can write samples, and from which
+   * Producers::ChainFile can read them again. Compared to writing samples
+   * as text, the binary format avoids the cost of converting numbers to
+   * text and back, and results in considerably smaller files; more
+   * importantly, the samples stored in such a file can be accessed
+   * directly (through memory mapping) without parsing the file.
+   *
+   * A file consists of a header and a payload. The header is laid out as
+   * follows, where all integers are stored in the byte order of the
+   * machine that wrote the file (in practice, little endian):
+   * - The eight characters `SFCHAIN` followed by a zero byte.
+   * - A 32-bit unsigned integer that denotes the version of the format
+   *   (currently one).
+   * - A 32-bit unsigned integer that denotes the kind of scalars that make
+   *   up each sample (see ScalarKind), and a 32-bit unsigned integer with the
+   *   size of each scalar in bytes.
+   * - A 32-bit unsigned integer that denotes the number of auxiliary data
+   *   columns (see below).
+   * - A 64-bit unsigned integer that denotes the number of scalars per
+   *   sample, i.e., the dimension of the samples.
+   * - A 64-bit unsigned integer that denotes the size of the header in
+   *   bytes, i.e., the offset of the payload from the beginning of the
+   *   file.
+   * - For each auxiliary data column, a 32-bit unsigned integer that
+   *   describes the type of the column (see ColumnType), and the name of
+   *   the AuxiliaryData::Key whose values are stored in the column. The
+   *   name is stored as a 64-bit unsigned integer with the number of
+   *   characters, followed by the characters.
+   * - Zero bytes that pad the header to a multiple of 64 bytes.
+   *
+   * The payload then consists of one record per sample. Each record
+   * contains the scalars of the sample, followed by one eight-byte value
+   * for each auxiliary data column. The number of samples stored in a file
+   * is therefore determined by the size of the file, and a file that is
+   * still being written can be read up to its last complete record.
+   *
+   * The padding of the header ensures that the scalars of the first sample
+   * are suitably aligned in memory when a file is memory-mapped, and since
+   * the size of each record is a multiple of the size of a scalar, this
+   * then also holds for all other samples.
+   */
+  namespace ChainFileFormat
+  {
+    /**
+     * The kinds of scalars samples can be composed of.
+     */
+    enum class ScalarKind : std::uint32_t
+    {
+      floating_point   = 0,
+      signed_integer   = 1,
+      unsigned_integer = 2
+    };
+
+
+    /**
+     * The types of the values that can be stored in auxiliary data columns.
+     * Each value is stored in eight bytes, as a `double`, a
+     * `std::int64_t`, or a `std::uint64_t`, respectively; Boolean values
+     * are stored as an unsigned integer that is either zero or one.
+     *
+     * When reading a file, the values are placed into the AuxiliaryData
+     * object of a sample as objects of type `double`, `std::int64_t`,
+     * `std::size_t` (the type used for AuxiliaryData::repetition_count and
+     * AuxiliaryData::chain_number), and `bool`, respectively.
+     */
+    enum class ColumnType : std::uint32_t
+    {
+      floating_point   = 0,
+      signed_integer   = 1,
+      unsigned_integer = 2,
+      boolean          = 3
+    };
+
+
+    /**
+     * A description of one of the auxiliary data columns of a file.
+     */
+    struct Column
+    {
+      /**
+       * The key of the entries of the AuxiliaryData objects stored in
+       * this column.
+       */
+      AuxiliaryData::Key key;
+
+      /**
+       * The type of the values stored in this column.
+       */
+      ColumnType type;
+    };
+
+
+    /**
+     * A structure that represents the information stored in the header of
+     * a file.
+     */
+    struct Header
+    {
+      /**
+       * The kind and size (in bytes) of the scalars that make up a sample.
+       */
+      ScalarKind    scalar_kind = ScalarKind::floating_point;
+      std::uint32_t scalar_size = sizeof(double);
+
+      /**
+       * The number of scalars per sample.
+       */
+      std::uint64_t dimension = 0;
+
+      /**
+       * The auxiliary data columns stored along with each sample.
+       */
+      std::vector<Column> columns;
+
+      /**
+       * Return the number of bytes each record of the payload occupies.
+       */
+      std::size_t
+      record_size () const;
+    };
+
+
+    /**
+     * The eight bytes every file starts with.
+     */
+    constexpr char magic[8] = {'S', 'F', 'C', 'H', 'A', 'I', 'N', '\0'};
+
+    /**
+     * The version of the format described in the documentation of this
+     * namespace.
+     */
+    constexpr std::uint32_t version = 1;
+
+    /**
+     * The number of bytes to a multiple of which the header is padded.
+     */
+    constexpr std::size_t header_alignment = 64;
+
+
+    /**
+     * Return the ScalarKind that corresponds to the C++ type given as
+     * template argument.
+     */
+    template <typename Scalar>
+    requires (std::is_arithmetic_v<Scalar>)
+    constexpr ScalarKind
+    scalar_kind ();
+
+    /**
+     * Return the header, including the padding, in the form in which it is
+     * stored at the beginning of a file.
+     */
+    std::vector<char>
+    write_header (const Header &header);
+
+    /**
+     * Read the header from the beginning of the given buffer, for example
+     * the memory a file has been mapped to, and advance the buffer to the
+     * beginning of the payload.
+     */
+    Header
+    read_header (std::span<const char> &buffer);
+
+    /**
+     * Write the value with the given column's key in the given auxiliary
+     * data object into the eight bytes starting at `destination`,
+     * converting it to the type of the column. Values of all of the
+     * arithmetic types can be stored in columns of any type; if the
+     * auxiliary data object has no entry for the column's key, or if it
+     * stores an object of a type that is not arithmetic, then a
+     * floating point column receives a NaN, and integer and Boolean columns
+     * receive a zero.
+     */
+    void
+    write_column (const AuxiliaryData &aux_data,
+                  const Column        &column,
+                  char                *destination);
+
+    /**
+     * Read the value of a column of the given type from the eight bytes
+     * starting at `source`, and return it as an object of the type
+     * discussed in the documentation of ColumnType.
+     */
+    std::any
+    read_column (const char       *source,
+                 const ColumnType  type);
+
+    /**
+     * Write the record for the given sample and its auxiliary data into the
+     * `header.record_size()` bytes starting at `destination`: the
+     * components of the sample, followed by the columns described by the
+     * header. The sample needs to have `header.dimension` components of a
+     * scalar type that matches the header.
+     */
+    template <typename SampleType>
+    void
+    write_record (const SampleType    &sample,
+                  const AuxiliaryData &aux_data,
+                  const Header        &header,
+                  char                *destination);
+
+    /**
+     * Read the record that starts at `source`, and that is laid out as
+     * described by the given header, into a sample and its auxiliary
+     * data. If `SampleType` has a `resize()` member function, the sample
+     * is resized to `header.dimension` components; otherwise, it needs to
+     * already have the right size.
+     */
+    template <typename SampleType>
+    void
+    read_record (const char    *source,
+                 const Header  &header,
+                 SampleType    &sample,
+                 AuxiliaryData &aux_data);
+
+
+
+    inline
+    std::size_t
+    Header::record_size () const
+    {
+      return dimension * scalar_size + 8 * columns.size();
+    }
+
+
+
+    template <typename Scalar>
+    requires (std::is_arithmetic_v<Scalar>)
+    constexpr ScalarKind
+    scalar_kind ()
+    {
+      if constexpr (std::is_floating_point_v<Scalar>)
+        return ScalarKind::floating_point;
+      else if constexpr (std::is_signed_v<Scalar>)
+        return ScalarKind::signed_integer;
+      else
+        return ScalarKind::unsigned_integer;
+    }
+
+
+
+    inline
+    std::vector<char>
+    write_header (const Header &header)
+    {
+      // The format stores numbers in the byte order of the machine, and
+      // we promise that that is little endian:
+      assert (std::endian::native == std::endian::little);
+
+      std::vector<char> bytes (std::begin(magic), std::end(magic));
+      Serialization::write (bytes, version);
+      Serialization::write (bytes, static_cast<std::uint32_t>(header.scalar_kind));
+      Serialization::write (bytes, header.scalar_size);
+      Serialization::write (bytes, static_cast<std::uint32_t>(header.columns.size()));
+      Serialization::write (bytes, header.dimension);
+
+      // Leave room for the size of the header, which we only know once
+      // we have written the columns:
+      const std::size_t header_size_position = bytes.size();
+      Serialization::write (bytes, std::uint64_t(0));
+
+      for (const Column &column : header.columns)
+        {
+          Serialization::write (bytes, static_cast<std::uint32_t>(column.type));
+          Serialization::write (bytes, column.key.name());
+        }
+
+      bytes.resize ((bytes.size() + header_alignment - 1) / header_alignment * header_alignment,
+                    '\0');
+
+      const std::uint64_t header_size = bytes.size();
+      std::memcpy (bytes.data() + header_size_position, &header_size, sizeof(header_size));
+
+      return bytes;
+    }
+
+
+
+    inline
+    Header
+    read_header (std::span<const char> &buffer)
+    {
+      assert (std::endian::native == std::endian::little);
+
+      const std::span<const char> file_start = buffer;
+
+      assert (buffer.size() >= sizeof(magic));
+      assert (std::memcmp (buffer.data(), magic, sizeof(magic)) == 0);
+      buffer = buffer.subspan (sizeof(magic));
+
+      std::uint32_t file_version;
+      Serialization::read (buffer, file_version);
+      assert (file_version == version);
+
+      Header header;
+      std::uint32_t scalar_kind;
+      std::uint32_t n_columns;
+      std::uint64_t header_size;
+      Serialization::read (buffer, scalar_kind);
+      Serialization::read (buffer, header.scalar_size);
+      Serialization::read (buffer, n_columns);
+      Serialization::read (buffer, header.dimension);
+      Serialization::read (buffer, header_size);
+      header.scalar_kind = static_cast<ScalarKind>(scalar_kind);
+
+      header.columns.resize (n_columns);
+      for (Column &column : header.columns)
+        {
+          std::uint32_t type;
+          std::string   name;
+          Serialization::read (buffer, type);
+          Serialization::read (buffer, name);
+          column.type = static_cast<ColumnType>(type);
+          column.key  = AuxiliaryData::Key(name);
+        }
+
+      assert (header_size <= file_start.size());
+      assert (header_size % header_alignment == 0);
+      buffer = file_start.subspan (header_size);
+
+      return header;
+    }
+
+
+
+    namespace internal
+    {
+      /**
+       * If the given `std::any` object stores an object of one of the
+       * arithmetic types `Types`, convert it to type `T` and return
+       * `true`; otherwise return `false`.
+       */
+      template <typename T, typename ...Types>
+      bool
+      convert_any_of (const std::any &value,
+                      T              &result)
+      {
+        return ((std::any_cast<Types>(&value) != nullptr
+                 ?
+                 (result = static_cast<T>(*std::any_cast<Types>(&value)), true)
+                 :
+                 false)
+                || ...);
+      }
+
+
+      /**
+       * Like the previous function, but trying all of the arithmetic types
+       * of the C++ language.
+       */
+      template <typename T>
+      bool
+      convert_any (const std::any &value,
+                   T              &result)
+      {
+        return convert_any_of<T,
+                  double, float, long double,
+                  bool, char, signed char, unsigned char,
+                  short, unsigned short, int, unsigned int,
+                  long, unsigned long, long long, unsigned long long> (value, result);
+      }
+    }
+
+
+
+    inline
+    void
+    write_column (const AuxiliaryData &aux_data,
+                  const Column        &column,
+                  char                *destination)
+    {
+      const auto entry = aux_data.find (column.key);
+
+      switch (column.type)
+        {
+          case ColumnType::floating_point:
+          {
+            double value = std::numeric_limits<double>::quiet_NaN();
+            if (entry != aux_data.end())
+              internal::convert_any (entry->second, value);
+            std::memcpy (destination, &value, sizeof(value));
+            break;
+          }
+
+          case ColumnType::signed_integer:
+          {
+            std::int64_t value = 0;
+            if (entry != aux_data.end())
+              internal::convert_any (entry->second, value);
+            std::memcpy (destination, &value, sizeof(value));
+            break;
+          }
+
+          case ColumnType::unsigned_integer:
+          case ColumnType::boolean:
+          {
+            std::uint64_t value = 0;
+            if (entry != aux_data.end())
+              internal::convert_any (entry->second, value);
+            if (column.type == ColumnType::boolean)
+              value = (value != 0 ? 1 : 0);
+            std::memcpy (destination, &value, sizeof(value));
+            break;
+          }
+
+          default:
+            assert (false);
+        }
+    }
+
+
+
+    inline
+    std::any
+    read_column (const char       *source,
+                 const ColumnType  type)
+    {
+      switch (type)
+        {
+          case ColumnType::floating_point:
+          {
+            double value;
+            std::memcpy (&value, source, sizeof(value));
+            return value;
+          }
+
+          case ColumnType::signed_integer:
+          {
+            std::int64_t value;
+            std::memcpy (&value, source, sizeof(value));
+            return value;
+          }
+
+          case ColumnType::unsigned_integer:
+          {
+            std::uint64_t value;
+            std::memcpy (&value, source, sizeof(value));
+            return static_cast<std::size_t>(value);
+          }
+
+          case ColumnType::boolean:
+          {
+            std::uint64_t value;
+            std::memcpy (&value, source, sizeof(value));
+            return (value != 0);
+          }
+
+          default:
+            assert (false);
+            return {};
+        }
+    }
+
+
+
+    template <typename SampleType>
+    void
+    write_record (const SampleType    &sample,
+                  const AuxiliaryData &aux_data,
+                  const Header        &header,
+                  char                *destination)
+    {
+      using scalar_type = types::ScalarType<SampleType>;
+      static_assert (std::is_arithmetic_v<scalar_type>,
+                     "Only samples with arithmetic scalar types can be stored.");
+      assert (header.scalar_kind == scalar_kind<scalar_type>());
+      assert (header.scalar_size == sizeof(scalar_type));
+
+      const std::size_t dimension = Utilities::size(sample);
+      assert (dimension == header.dimension);
+
+      // If the sample type stores its elements contiguously, this is a
+      // single memcpy:
+      if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+        std::memcpy (destination, Utilities::as_span(sample).data(),
+                     dimension * sizeof(scalar_type));
+      else
+        for (std::size_t i=0; i<dimension; ++i)
+          {
+            const scalar_type x = Utilities::get_nth_element (sample, i);
+            std::memcpy (destination + i*sizeof(scalar_type), &x, sizeof(scalar_type));
+          }
+
+      char *column_data = destination + dimension * sizeof(scalar_type);
+      for (const Column &column : header.columns)
+        {
+          write_column (aux_data, column, column_data);
+          column_data += 8;
+        }
+    }
+
+
+
+    template <typename SampleType>
+    void
+    read_record (const char    *source,
+                 const Header  &header,
+                 SampleType    &sample,
+                 AuxiliaryData &aux_data)
+    {
+      using scalar_type = types::ScalarType<SampleType>;
+      static_assert (std::is_arithmetic_v<scalar_type>,
+                     "Only samples with arithmetic scalar types can be stored.");
+      assert (header.scalar_kind == scalar_kind<scalar_type>());
+      assert (header.scalar_size == sizeof(scalar_type));
+
+      if constexpr (requires (SampleType &s) { s.resize (std::size_t()); })
+        sample.resize (header.dimension);
+      assert (static_cast<std::uint64_t>(Utilities::size(sample)) == header.dimension);
+
+      if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+        std::memcpy (Utilities::as_span(sample).data(), source,
+                     header.dimension * sizeof(scalar_type));
+      else
+        for (std::size_t i=0; i<header.dimension; ++i)
+          {
+            scalar_type x;
+            std::memcpy (&x, source + i*sizeof(scalar_type), sizeof(scalar_type));
+            Utilities::get_nth_element (sample, i) = x;
+          }
+
+      const char *column_data = source + header.dimension * sizeof(scalar_type);
+      for (const Column &column : header.columns)
+        {
+          aux_data[column.key] = read_column (column_data, column.type);
+          column_data += 8;
+        }
+    }
+  }
+}
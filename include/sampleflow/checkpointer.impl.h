@@ -0,0 +1,286 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that writes checkpoints, i.e., binary representations of the
+   * state of a computation, to a file. This is used by samplers such as
+   * Producers::MetropolisHastings that can write their state to a
+   * checkpoint every so many steps, so that sampling can be resumed from
+   * the last checkpoint if the program is interrupted -- for example
+   * because it runs as a job on a cluster whose allotted time has run
+   * out. The state is converted into a sequence of bytes using the
+   * functions in namespace Serialization; this class only deals with
+   * storing these bytes.
+   *
+   * Writing a file can take a long time compared to a step of a sampler,
+   * and so this class does not write the data passed to write() right
+   * away, but hands it to a separate thread that does so in the
+   * background while the sampler continues. If a new checkpoint arrives
+   * before the previous one has been written, then the previous one is
+   * simply dropped: Only the most recent state is of interest.
+   *
+   * The file is written in such a way that it always contains a
+   * complete checkpoint, even if the program is terminated while a
+   * checkpoint is being written: The data is first written to a file
+   * whose name is the given file name with `.tmp` appended, and this
+   * file is then renamed to the given name.
+   */
+  class Checkpointer
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] filename The name of the file into which checkpoints
+       *   are written. An existing file of this name is replaced once the
+       *   first checkpoint is written.
+       */
+      Checkpointer (const std::string &filename);
+
+      /**
+       * Destructor. Wait for the last checkpoint to be written to the
+       * file, then stop the thread that writes checkpoints.
+       */
+      ~Checkpointer ();
+
+      /**
+       * Copy constructor. Objects of this class cannot be copied, and so
+       * this constructor is deleted.
+       */
+      Checkpointer (const Checkpointer &) = delete;
+
+      /**
+       * Write the given checkpoint to the file. The actual writing happens
+       * on a separate thread, and this function returns immediately. If the
+       * previous checkpoint has not been written yet by the time this
+       * function is called, then it is discarded in favor of the current
+       * one.
+       */
+      void
+      write (std::vector<char> &&checkpoint);
+
+      /**
+       * Wait until the most recent checkpoint passed to write() has been
+       * written to the file.
+       */
+      void
+      wait ();
+
+      /**
+       * Return the number of checkpoints that have been written to the
+       * file so far. Because checkpoints may be dropped if a newer one
+       * arrives before the previous one has been written, this number
+       * may be smaller than the number of calls to write().
+       */
+      std::size_t
+      n_checkpoints_written () const;
+
+      /**
+       * Return the name of the file into which checkpoints are written.
+       */
+      const std::string &
+      get_filename () const;
+
+      /**
+       * Read the checkpoint stored in the file with the given name, and
+       * return its content.
+       */
+      static
+      std::vector<char>
+      read (const std::string &filename);
+
+    private:
+      /**
+       * The name of the file into which checkpoints are written.
+       */
+      const std::string filename;
+
+      /**
+       * A mutex and condition variable that guard the member variables
+       * below and that the writer thread uses to wait for work.
+       */
+      mutable std::mutex              mutex;
+      std::condition_variable         state_changed;
+
+      /**
+       * The checkpoint that is waiting to be written, if any.
+       */
+      std::optional<std::vector<char>> pending_checkpoint;
+
+      /**
+       * Whether the writer thread is currently writing a checkpoint.
+       */
+      bool is_writing;
+
+      /**
+       * Whether the destructor has asked the writer thread to stop.
+       */
+      bool shutting_down;
+
+      /**
+       * The number of checkpoints written so far.
+       */
+      std::size_t n_written;
+
+      /**
+       * The thread that writes checkpoints to the file.
+       */
+      std::thread writer;
+
+      /**
+       * The function run by the writer thread.
+       */
+      void
+      writer_loop ();
+  };
+
+
+
+  inline
+  Checkpointer::Checkpointer (const std::string &filename)
+    :
+    filename (filename),
+    is_writing (false),
+    shutting_down (false),
+    n_written (0),
+    writer ([this]()
+  {
+    writer_loop ();
+  })
+  {}
+
+
+
+  inline
+  Checkpointer::~Checkpointer ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      shutting_down = true;
+    }
+    state_changed.notify_all();
+
+    writer.join();
+  }
+
+
+
+  inline
+  void
+  Checkpointer::write (std::vector<char> &&checkpoint)
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      pending_checkpoint = std::move(checkpoint);
+    }
+    state_changed.notify_all();
+  }
+
+
+
+  inline
+  void
+  Checkpointer::wait ()
+  {
+    std::unique_lock<std::mutex> lock (mutex);
+    state_changed.wait (lock, [this]()
+    {
+      return ((pending_checkpoint.has_value() == false) && (is_writing == false));
+    });
+  }
+
+
+
+  inline
+  std::size_t
+  Checkpointer::n_checkpoints_written () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    return n_written;
+  }
+
+
+
+  inline
+  const std::string &
+  Checkpointer::get_filename () const
+  {
+    return filename;
+  }
+
+
+
+  inline
+  std::vector<char>
+  Checkpointer::read (const std::string &filename)
+  {
+    std::ifstream in (filename, std::ios::binary);
+    assert (in);
+
+    return std::vector<char> (std::istreambuf_iterator<char>(in),
+                              std::istreambuf_iterator<char>());
+  }
+
+
+
+  inline
+  void
+  Checkpointer::writer_loop ()
+  {
+    while (true)
+      {
+        std::vector<char> checkpoint;
+        {
+          // Wait until there is something to write, or until we are asked
+          // to shut down and there is nothing left to write:
+          std::unique_lock<std::mutex> lock (mutex);
+          state_changed.wait (lock, [this]()
+          {
+            return (shutting_down || pending_checkpoint.has_value());
+          });
+          if (pending_checkpoint.has_value() == false)
+            return;
+
+          checkpoint = std::move(*pending_checkpoint);
+          pending_checkpoint.reset ();
+          is_writing = true;
+        }
+
+        // Write the checkpoint without holding the lock, so that new
+        // checkpoints can be handed to us in the meantime. Write to a
+        // temporary file first, and only then replace the previous
+        // checkpoint by it:
+        const std::string temporary_filename = filename + ".tmp";
+        {
+          std::ofstream out (temporary_filename, std::ios::binary | std::ios::trunc);
+          out.write (checkpoint.data(), checkpoint.size());
+          out.close ();
+          assert (out);
+        }
+        [[maybe_unused]] const int ierr = std::rename (temporary_filename.c_str(),
+                                                       filename.c_str());
+        assert (ierr == 0);
+
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          is_writing = false;
+          ++n_written;
+        }
+        state_changed.notify_all();
+      }
+  }
+}
@@ -0,0 +1,276 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores an array of counters, such as the numbers of
+   * samples in the bins of Consumers::Histogram or
+   * Consumers::PairHistogram, using less memory than an array of
+   * types::sample_index objects would.
+   *
+   * Histograms with many bins are dominated by the memory of their
+   * counters, and as soon as these no longer fit into the processor's
+   * caches, every sample costs a cache miss. Yet almost all counters stay
+   * small: Even in a histogram that has seen many billions of samples,
+   * only a few bins near the mode of the distribution have counts that do
+   * not fit into 32 bits. This class therefore stores each counter as an
+   * object of the (smaller) type `CountType`. If adding to a counter would
+   * exceed the largest value this type can represent, the counter's value
+   * is instead moved to a sparse table of full-width counters and the
+   * small counter starts from zero again; the value of a counter is the
+   * sum of the two. With the default `CountType = std::uint32_t`, this
+   * halves the memory of the counters compared to 64-bit counters, and
+   * with `std::uint16_t` reduces it by a factor of four, at the cost of
+   * more frequent (but still rare) moves to the sparse table.
+   *
+   * In contrast to the counters themselves, the values returned by
+   * operator[] are always of type types::sample_index, and can not
+   * overflow in practice.
+   *
+   * The class is not thread-safe: If several threads access the same
+   * object, the caller needs to provide the necessary synchronization.
+   * The array of small counters is allocated with
+   * Memory::CacheLineAllocator, so that the counters of different objects
+   * never share a cache line, and so that large arrays can be backed by
+   * huge pages (see Memory::set_huge_pages()).
+   *
+   * Objects of this class can be copied and assigned, and can be written
+   * to and read from a buffer using the functions in namespace
+   * Serialization. The data written is the same as for an array of
+   * types::sample_index objects, regardless of `CountType`.
+   *
+   * @tparam CountType The unsigned integer type used to store the
+   *   counters.
+   */
+  template <typename CountType = std::uint32_t>
+  requires (std::is_unsigned_v<CountType>)
+  class CompactCounts
+  {
+    public:
+      /**
+       * The type of the values of the counters.
+       */
+      using value_type = types::sample_index;
+
+      /**
+       * Default constructor. Create an object without counters.
+       */
+      CompactCounts () = default;
+
+      /**
+       * Constructor. Create the given number of counters, all of which
+       * are zero.
+       */
+      explicit CompactCounts (const std::size_t n_counters);
+
+      /**
+       * Return the number of counters.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Add `n` to the `index`th counter.
+       */
+      void
+      add (const std::size_t index,
+           const value_type  n);
+
+      /**
+       * Return the value of the `index`th counter.
+       */
+      value_type
+      operator[] (const std::size_t index) const;
+
+      /**
+       * Add the counters of another object, which needs to have the same
+       * size, to the ones of the current object.
+       */
+      void
+      merge (const CompactCounts &other);
+
+      /**
+       * Return the number of counters that have, at some point, exceeded
+       * the range of `CountType` and that are therefore (partly) stored in
+       * the sparse table of full-width counters.
+       */
+      std::size_t
+      n_overflowed_counters () const;
+
+      /**
+       * Return an estimate of the memory used by this object, in bytes.
+       */
+      std::size_t
+      memory_consumption () const;
+
+      /**
+       * Append the number of counters and their values, in the same format
+       * as Serialization::write() uses for a `std::vector` of
+       * types::sample_index objects, to the given buffer.
+       */
+      void
+      save (std::vector<char> &buffer) const;
+
+      /**
+       * Replace the current object by the one previously written by save()
+       * (or by Serialization::write() for a `std::vector` of
+       * types::sample_index objects), read from the front of the given
+       * buffer. The buffer is advanced past the data read.
+       */
+      void
+      load (std::span<const char> &buffer);
+
+    private:
+      /**
+       * The small counters.
+       */
+      std::vector<CountType,Memory::CacheLineAllocator<CountType>> counts;
+
+      /**
+       * For those counters that have exceeded the range of `CountType`,
+       * the part of their value that is not stored in `counts`.
+       */
+      std::unordered_map<std::size_t,value_type> overflow;
+  };
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  CompactCounts<CountType>::CompactCounts (const std::size_t n_counters)
+    :
+    counts (n_counters, 0)
+  {}
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  std::size_t
+  CompactCounts<CountType>::size () const
+  {
+    return counts.size();
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  void
+  CompactCounts<CountType>::add (const std::size_t index,
+                                 const value_type  n)
+  {
+    assert (index < counts.size());
+
+    // In the common case, the sum fits into the small counter. Otherwise,
+    // move the whole value to the sparse table and start from zero:
+    if (n <= static_cast<value_type>(std::numeric_limits<CountType>::max() - counts[index]))
+      counts[index] += static_cast<CountType>(n);
+    else
+      {
+        overflow[index] += counts[index] + n;
+        counts[index] = 0;
+      }
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  typename CompactCounts<CountType>::value_type
+  CompactCounts<CountType>::operator[] (const std::size_t index) const
+  {
+    assert (index < counts.size());
+
+    if (overflow.empty())
+      return counts[index];
+    else if (const auto p = overflow.find (index);
+             p != overflow.end())
+      return counts[index] + p->second;
+    else
+      return counts[index];
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  void
+  CompactCounts<CountType>::merge (const CompactCounts &other)
+  {
+    assert (other.counts.size() == counts.size());
+
+    for (std::size_t i=0; i<counts.size(); ++i)
+      add (i, other.counts[i]);
+    for (const auto &[index, n] : other.overflow)
+      overflow[index] += n;
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  std::size_t
+  CompactCounts<CountType>::n_overflowed_counters () const
+  {
+    return overflow.size();
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  std::size_t
+  CompactCounts<CountType>::memory_consumption () const
+  {
+    // For the sparse table, count the array of buckets and, for each
+    // element, a node that holds the element and a pointer to the next
+    // node:
+    return (Memory::memory_consumption (counts)
+            + overflow.bucket_count() * sizeof(void *)
+            + overflow.size() * (sizeof(typename decltype(overflow)::value_type)
+                                 + sizeof(void *)));
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  void
+  CompactCounts<CountType>::save (std::vector<char> &buffer) const
+  {
+    std::vector<value_type> values (counts.begin(), counts.end());
+    for (const auto &[index, n] : overflow)
+      values[index] += n;
+    Serialization::write (buffer, values);
+  }
+
+
+
+  template <typename CountType>
+  requires (std::is_unsigned_v<CountType>)
+  void
+  CompactCounts<CountType>::load (std::span<const char> &buffer)
+  {
+    std::vector<value_type> values;
+    Serialization::read (buffer, values);
+
+    counts.assign (values.size(), 0);
+    overflow.clear();
+    for (std::size_t i=0; i<values.size(); ++i)
+      add (i, values[i]);
+  }
+}
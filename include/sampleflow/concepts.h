@@ -19,6 +19,10 @@
 #include <sampleflow/config.h>
 
 #include <concepts>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <type_traits>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/concepts.impl.h>
@@ -23,15 +23,36 @@ namespace SampleFlow
   {
     /**
      * A concept that describes the minimal requirements we have of samples,
-     * namely that they can be copied and that they can be moved/move-created.
+     * namely that they can be moved/move-created.
      * Individual classes may of course have additional requirements -- for example,
      * to compute the mean value of a number of samples, one needs that they
      * can be added and divided by an integer. Individual classes then have to
      * require these additional concepts.
+     *
+     * In particular, samples do not need to be copyable. This allows
+     * using types that hold large objects (say, a mesh or a buffer in the
+     * memory of an accelerator) through a handle that can only be moved,
+     * and that can consequently be sent from a producer through filters to
+     * a consumer without ever being copied. But copies are necessary
+     * whenever several objects need to receive the same sample, and so
+     * there are restrictions on how objects that work on samples of such
+     * types can be connected:
+     * - A producer (or filter) of samples that can not be copied can only
+     *   have a single consumer (or filter) connected to it. To send such
+     *   samples to several consumers, connect a single object of type
+     *   Filters::MakeShared that converts them into `std::shared_ptr`
+     *   handles, which can then be distributed to any number of consumers.
+     * - Batches of samples (see Producer::issue_batch) are passed by
+     *   reference, and processing them requires copies of the samples
+     *   unless the receiving consumer or filter overrides
+     *   Consumer::consume_batch() or Filter::filter_batch() in a way that
+     *   does not copy samples. The same is true for
+     *   Consumer::consume_by_reference().
+     * Where a copy would be required at run time, the program aborts (see
+     * Utilities::copy_sample()).
      */
     template <typename SampleType>
-    concept is_valid_sampletype = (std::copyable<SampleType> &&
-                                   std::movable<SampleType> &&
+    concept is_valid_sampletype = (std::movable<SampleType> &&
                                    std::move_constructible<SampleType>);
 
 
@@ -62,6 +83,61 @@ namespace SampleFlow
       } -> std::convertible_to<SampleType>;
       a /= i;
     };
+
+
+    /**
+     * A concept that describes whether objects of type `StateType` represent
+     * the (partial) state of a computation that can be combined with the
+     * state of the same computation performed on a different set of data.
+     * An example is the mean value over a set of samples along with the
+     * number of samples: Two such objects computed over disjoint sets of
+     * samples can be merged into the mean value and number of samples of the
+     * union of the two sets. This is used in the ShardedAccumulator class.
+     */
+    template <typename StateType>
+    concept is_mergeable = (std::copyable<StateType> &&
+                            std::default_initializable<StateType> &&
+                            requires (StateType &a, const StateType &b)
+    {
+      a.merge (b);
+    });
+
+
+    namespace internal
+    {
+      /**
+       * The machinery behind is_sample_handle.
+       */
+      template <typename SampleType>
+      struct IsSampleHandle : std::false_type
+      {};
+
+      template <typename T>
+      struct IsSampleHandle<std::shared_ptr<const T>> : std::true_type
+      {};
+    }
+
+
+    /**
+     * A concept that describes whether objects of type `SampleType` are
+     * reference-counted handles to immutable samples, i.e., whether
+     * `SampleType` is `std::shared_ptr<const T>` for some type `T`. This is
+     * the type Filters::MakeShared converts samples into so that they can
+     * be sent to any number of consumers without copying them.
+     *
+     * Consumers that keep samples beyond the call of their consume()
+     * function -- such as Consumers::AutoCovarianceTrace or
+     * Consumers::ReservoirSample -- and that are connected to such a filter
+     * keep the handle rather than a copy of the sample it refers to. A
+     * sample then costs each consumer that keeps it only one pointer, and
+     * memory that a producer may want to reuse for a later sample is not
+     * released before all of these consumers have let go of it. The
+     * function Utilities::dereference_sample() and the type
+     * types::HandledType allow writing code that works on the sample
+     * itself, no matter whether it is given directly or through a handle.
+     */
+    template <typename SampleType>
+    concept is_sample_handle = internal::IsSampleHandle<SampleType>::value;
   }
 
 
@@ -103,6 +179,43 @@ namespace SampleFlow
     template <typename C>
     concept is_filter = std::derived_from<C, Filter<typename C::input_type, typename C::output_type>>;
 
+    /**
+     * A concept that describes whether a class `C` is a filter that may be
+     * fused with adjacent filters, i.e., whose effect on the stream of
+     * samples is entirely described by what its `filter()` function does.
+     * This means in particular that the class must not make use of the
+     * asynchronous parallel modes, and must not issue samples from any other
+     * place (such as its `flush()` function). Filter classes declare that
+     * this is the case by having a member variable
+     * `static constexpr bool is_fusable = true;`. See the FusedFilter class
+     * for how this is used.
+     */
+    template <typename C>
+    concept is_fusable_filter = (is_filter<C> &&
+                                 requires ()
+    {
+      requires C::is_fusable;
+    });
+
+    /**
+     * A concept that describes whether a class `C` is a filter whose
+     * `filter()` function does not depend on, or modify, any state other
+     * than what was passed to the class's constructor. The result of
+     * the function then only depends on the sample it is given, and the
+     * function can be called concurrently for different samples without
+     * synchronization. Such filters are also always fusable in the sense of
+     * the is_fusable_filter concept. Filter classes declare that they are
+     * stateless by having a member variable
+     * `static constexpr bool is_stateless = true;`. See the
+     * Filters::ParallelStage class for how this is used.
+     */
+    template <typename C>
+    concept is_stateless_filter = (is_fusable_filter<C> &&
+                                   requires ()
+    {
+      requires C::is_stateless;
+    });
+
     /**
      * A concept that tests whether a class has a member type `value_type`.
      */
@@ -126,6 +239,21 @@ namespace SampleFlow
     };
 
 
+    /**
+     * A concept that describes whether `sample[index]` returns a reference
+     * through which the elements of a non-`const` object of type
+     * `SampleType` can be modified, rather than (for example) a copy of
+     * the element.
+     */
+    template <typename SampleType>
+    concept has_modifiable_elements = requires (SampleType &sample, const std::size_t index)
+    {
+      {
+        sample[index]
+      } -> std::same_as<std::remove_cvref_t<decltype(sample[index])> &>;
+    };
+
+
     /**
      * A concept that describes whether one can call `sample.size()` where
      * `sample` is of type `SampleType`.
@@ -137,6 +265,130 @@ namespace SampleFlow
         sample.size()
       };
     };
+
+
+    /**
+     * A concept that describes whether the elements of an object of type
+     * `SampleType` are stored contiguously in memory as objects of type
+     * `ScalarType`, i.e., whether `std::ranges::data(sample)` returns a
+     * pointer to the first of them. This is the case for `std::vector`,
+     * `std::array`, `std::valarray`, and Eigen vectors, but, for example,
+     * not for `std::vector<bool>`. Classes that know about this property
+     * can pass the elements of a sample to optimized linear algebra
+     * routines without copying them.
+     */
+    template <typename SampleType, typename ScalarType>
+    concept has_contiguous_storage = requires (const SampleType &sample)
+    {
+      {
+        std::ranges::data(sample)
+      } -> std::same_as<const ScalarType *>;
+    };
+
+    /**
+     * A concept that describes whether the elements of an object of type
+     * `SampleType` are stored contiguously in memory, where the type of the
+     * elements is the one returned by `sample[i]`. (This type is the same
+     * as types::ScalarType, which is however not yet available at this
+     * point.) This is the case for Eigen dense vectors, `std::vector`
+     * (except for `std::vector<bool>`), `std::array`, `std::valarray`,
+     * and C-style arrays. For these types, Utilities::as_span() provides
+     * access to all elements at once, and consumers that loop over the
+     * elements of samples use this to work on the underlying array
+     * directly, rather than going through Utilities::get_nth_element()
+     * for each element. This allows compilers to vectorize these loops.
+     */
+    template <typename SampleType>
+    concept has_contiguous_scalar_storage = requires (const SampleType &sample)
+    {
+      {
+        std::ranges::data(sample)
+      } -> std::same_as<const std::remove_cvref_t<decltype(sample[0])> *>;
+    };
+
+    /**
+     * A concept that describes whether objects of type `SampleType` only
+     * store their nonzero elements, and allow iterating over these. This
+     * is the interface of `Eigen::SparseVector`: The type has a member
+     * type `InnerIterator` that is constructed from the sample (and the
+     * index zero of the only "outer" dimension of a vector), and that
+     * provides the `index()` and `value()` of the current element as well
+     * as `operator++` and a conversion to `bool` that indicates whether
+     * the iterator still points to an element. Furthermore,
+     * `sample.nonZeros()` returns the number of elements stored, and
+     * `sample.coeff(i)` returns the `i`th element, whether it is stored or
+     * not. Types whose elements are stored contiguously (see
+     * has_contiguous_scalar_storage), such as Eigen's dense vectors which
+     * also provide the functions above, do not satisfy the concept.
+     *
+     * For samples of such types, the cost of operations such as updating
+     * a running mean value (see Consumers::MeanValue) or a sum of outer
+     * products (see Consumers::SparseCovarianceMatrix) can be made to scale
+     * with the number of nonzero elements rather than the number of all
+     * elements; see Utilities::for_each_nonzero().
+     */
+    template <typename SampleType>
+    concept has_sparse_storage = (!has_contiguous_scalar_storage<SampleType>
+                                  &&
+                                  requires (const SampleType &sample,
+                                            const std::size_t index)
+    {
+      typename SampleType::InnerIterator;
+      {
+        sample.nonZeros()
+      };
+      {
+        sample.coeff(index)
+      };
+      requires std::constructible_from<typename SampleType::InnerIterator, const SampleType &, int>;
+      requires requires (typename SampleType::InnerIterator iterator)
+      {
+        iterator.index();
+        iterator.value();
+        ++iterator;
+        static_cast<bool>(iterator);
+      };
+    });
+
+    /**
+     * A concept that describes whether a class `Device` provides access to
+     * an accelerator (such as a GPU) in the way DeviceLogLikelihood
+     * needs it: It has a type `Device::stream_type` that identifies a
+     * queue of operations that are executed on the device in order
+     * ("stream" in CUDA and HIP terminology), and member functions that
+     * - create and destroy streams;
+     * - allocate and free memory on the host that the device can transfer
+     *   data from and to without going through an intermediate buffer
+     *   ("pinned" or "page-locked" memory);
+     * - allocate and free memory on the device;
+     * - enqueue copies of data from the host to the device and back in a
+     *   stream, without waiting for them to finish;
+     * - wait for all operations enqueued in a stream to finish.
+     *
+     * See CUDA::Device for an implementation of this concept.
+     */
+    template <typename Device>
+    concept is_device = requires (Device                               &device,
+                                  typename Device::stream_type          stream,
+                                  void                                 *pointer,
+                                  const void                           *const_pointer,
+                                  const std::size_t                     n_bytes)
+    {
+      {
+        device.create_stream()
+      } -> std::same_as<typename Device::stream_type>;
+      device.destroy_stream (stream);
+      {
+        device.allocate_host_memory (n_bytes)
+      } -> std::same_as<void *>;
+      device.free_host_memory (pointer);
+      {
+        device.allocate_device_memory (n_bytes)
+      } -> std::same_as<void *>;
+      device.free_device_memory (pointer);
+      device.copy_to_device (pointer, const_pointer, n_bytes, stream);
+      device.copy_to_host (pointer, const_pointer, n_bytes, stream);
+      device.synchronize (stream);
+    };
   }
 }
-
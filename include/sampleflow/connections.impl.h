@@ -95,12 +95,15 @@ namespace SampleFlow
        */
       virtual
       std::pair<const Producer<OutputType> *,
-          std::tuple<boost::signals2::connection,boost::signals2::connection,boost::signals2::connection>>
+          std::tuple<Connection,Connection,Connection,Connection>>
           connect_to_signals (const std::function<void (OutputType, AuxiliaryData)> &signal_slot,
+                              const std::function<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> &batch_slot,
                               const std::function<void ()> &flush_slot,
-                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot) override
+                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot,
+                              const std::function<void (const OutputType &, const AuxiliaryData &)> &reference_signal_slot) override
       {
-        return get_right_object().connect_to_signals(signal_slot, flush_slot, disconnect_slot);
+        return get_right_object().connect_to_signals(signal_slot, batch_slot, flush_slot, disconnect_slot,
+                                                     reference_signal_slot);
       }
 
       /**
@@ -379,12 +382,15 @@ namespace SampleFlow
        */
       virtual
       std::pair<const Producer<OutputType> *,
-          std::tuple<boost::signals2::connection,boost::signals2::connection,boost::signals2::connection>>
+          std::tuple<Connection,Connection,Connection,Connection>>
           connect_to_signals (const std::function<void (OutputType, AuxiliaryData)> &signal_slot,
+                              const std::function<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> &batch_slot,
                               const std::function<void ()> &flush_slot,
-                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot) override
+                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot,
+                              const std::function<void (const OutputType &, const AuxiliaryData &)> &reference_signal_slot) override
       {
-        return get_right_object().connect_to_signals(signal_slot, flush_slot, disconnect_slot);
+        return get_right_object().connect_to_signals(signal_slot, batch_slot, flush_slot, disconnect_slot,
+                                                     reference_signal_slot);
       }
 
     private:
@@ -529,6 +535,269 @@ namespace SampleFlow
   };
 
 
+  /**
+   * A filter that consists of two other filters, the first of which takes
+   * in samples of type `InputType` and outputs `IntermediateType` samples,
+   * and the second of which takes in `IntermediateType` and outputs
+   * `OutputType`. Rather than connecting the two filters so that samples
+   * flow from the first to the second through the signals of the first
+   * filter (as the Chain class does), the filter() function of this class
+   * simply calls the `filter()` functions of the two filters in turn, and
+   * stops as soon as the first of them discards a sample. This avoids
+   * the cost of sending a sample from one filter to the next: wrapping it
+   * in a SharedSample object, calling a `std::function` object through a
+   * signal, and acquiring the lock that protects the second filter's
+   * connections.
+   *
+   * Objects of this class are created by `operator>>` when it is called
+   * with two filters that are both temporary objects, and that both
+   * satisfy the Concepts::is_fusable_filter concept. Since the filters have
+   * been moved into the chain, nothing else can be connected to them, and
+   * so nobody can tell the difference from a chain in which samples flow
+   * through the filters' signals. (This is also true for a filter that
+   * is moved into a chain directly behind a producer; see the FusedChain
+   * class.) The result is again a fusable filter, and so long sequences
+   * of fusable filters collapse into a single filter.
+   *
+   * Unlike the FusedPipeline class, the current class calls the two
+   * filters through their virtual `filter()` functions, and so can be
+   * created at run time without knowing the concrete types of the
+   * filters involved.
+   */
+  template <typename InputType, typename IntermediateType, typename OutputType>
+  class FusedFilter : public Filter<InputType,OutputType>
+  {
+    public:
+      /**
+       * Objects of this class can themselves be fused with other filters.
+       */
+      static constexpr bool is_fusable = true;
+
+      /**
+       * Constructor. Take over the two filters given as arguments. Neither
+       * of them may be connected to anything.
+       */
+      FusedFilter (std::unique_ptr<Filter<InputType,IntermediateType>> &&first,
+                   std::unique_ptr<Filter<IntermediateType,OutputType>> &&second)
+        :
+        first (std::move(first)),
+        second (std::move(second))
+      {}
+
+      /**
+       * Move constructor.
+       */
+      FusedFilter (FusedFilter &&) = default;
+
+      /**
+       * Destructor. This function also makes sure that all samples this
+       * object may have received have been fully processed. To this end,
+       * it calls the Consumers::disconnect_and_flush() function of the
+       * base class.
+       */
+      virtual
+      ~FusedFilter () override
+      {
+        this->disconnect_and_flush();
+      }
+
+      /**
+       * Process one sample by passing it to the first filter and, if that
+       * filter lets it pass, the result to the second filter.
+       */
+      virtual
+      std::optional<std::pair<OutputType, AuxiliaryData> >
+      filter (InputType sample,
+              AuxiliaryData aux_data) override
+      {
+        std::optional<std::pair<IntermediateType, AuxiliaryData> >
+        intermediate = first->filter (std::move(sample), std::move(aux_data));
+
+        if (intermediate)
+          return second->filter (std::move(intermediate->first),
+                                 std::move(intermediate->second));
+        else
+          return {};
+      }
+
+      /**
+       * Return a description of the samples this object passes on if it
+       * receives samples described by the argument, namely what the second
+       * filter passes on if it receives what the first one passes on.
+       * See Filter::output_shape().
+       */
+      virtual
+      SampleShape
+      output_shape (const SampleShape &input_shape) const override
+      {
+        return second->output_shape (first->output_shape (input_shape));
+      }
+
+    private:
+      /**
+       * The two filters that make up this object.
+       */
+      std::unique_ptr<Filter<InputType,IntermediateType>>  first;
+      std::unique_ptr<Filter<IntermediateType,OutputType>> second;
+  };
+
+
+
+  /**
+   * A class that, like the Chain<void,IntermediateType,OutputType> class,
+   * describes a producer followed by a filter. The difference is that the
+   * filter is owned by the current object and satisfies the
+   * Concepts::is_fusable_filter concept. This is what `operator>>` returns
+   * if its right argument is a temporary object of such a filter type.
+   *
+   * The point of the class is that `operator>>` can recognize it: If
+   * an object of this type is itself a temporary object on the left side of
+   * `operator>>`, and if the right side is again a temporary fusable filter,
+   * then `operator>>` takes the current object apart and fuses the filter
+   * stored here with the new one into a FusedFilter object. As a
+   * consequence, in code such as
+   * @code
+   *   producer >> SampleFlow::Filters::Conversion<InputType,OutputType>(convert)
+   *            >> SampleFlow::Filters::Condition<OutputType>(predicate)
+   *            >> SampleFlow::Filters::TakeEveryNth<OutputType>(10)
+   *            >> consumer;
+   * @endcode
+   * the three filters end up as one FusedFilter object that is connected
+   * to the producer, and each sample issued by the producer goes through
+   * a single signal before it reaches the consumer (if it reaches it at
+   * all).
+   */
+  template <typename IntermediateType, typename OutputType>
+  class FusedChain : public Producer<OutputType>
+  {
+    public:
+      /**
+       * Constructor. Build an object out of the producer and filter
+       * provided as argument. As for the Chain class, the producer is
+       * moved into the current object if it is a temporary, and stored by
+       * reference otherwise.
+       */
+      template <typename LeftType>
+      requires (Concepts::is_producer<std::remove_reference_t<LeftType>>)
+      FusedChain (LeftType &&left,
+                  std::unique_ptr<Filter<IntermediateType,OutputType>> &&right)
+        :
+        left_object (nullptr),
+        right_object (std::move(right))
+      {
+        if constexpr (std::is_reference_v<LeftType>)
+          left_object = left;
+        else
+          left_object = std::make_unique<LeftType>(std::move(left));
+
+        right_object->connect_to_producer (get_left_object());
+      }
+
+      /**
+       * Move constructor.
+       */
+      FusedChain (FusedChain &&c) = default;
+
+      /**
+       * Destructor.
+       */
+      virtual
+      ~FusedChain () override = default;
+
+      /**
+       * A function that overrides the one in the base class, forwarding
+       * the request to connect to the filter stored by the current object.
+       */
+      virtual
+      std::pair<const Producer<OutputType> *,
+          std::tuple<Connection,Connection,Connection,Connection>>
+          connect_to_signals (const std::function<void (OutputType, AuxiliaryData)> &signal_slot,
+                              const std::function<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> &batch_slot,
+                              const std::function<void ()> &flush_slot,
+                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot,
+                              const std::function<void (const OutputType &, const AuxiliaryData &)> &reference_signal_slot) override
+      {
+        return right_object->connect_to_signals(signal_slot, batch_slot, flush_slot, disconnect_slot,
+                                                reference_signal_slot);
+      }
+
+      /**
+       * Take the current object apart, and return a new object in which
+       * the filter stored by the current object and the one given as
+       * argument are fused into a FusedFilter object. The current object
+       * is left empty.
+       */
+      template <typename FilterType>
+      requires (Concepts::is_fusable_filter<FilterType>  &&
+                std::same_as<typename FilterType::input_type, OutputType>)
+      FusedChain<IntermediateType, typename FilterType::output_type>
+      append (FilterType &&filter) &&
+      {
+        // Disconnect the stored filter from its producer (the only
+        // thing it can be connected to) before fusing it:
+        right_object->disconnect_and_flush();
+
+        return FusedChain<IntermediateType, typename FilterType::output_type>
+               (std::move(left_object),
+                std::make_unique<FusedFilter<IntermediateType, OutputType, typename FilterType::output_type>>
+                (std::move(right_object),
+                 std::make_unique<FilterType>(std::move(filter))));
+      }
+
+    private:
+      /**
+       * The producer, and the filter connected to it.
+       */
+      std::variant<std::reference_wrapper<Producer<IntermediateType>>,
+          std::unique_ptr<Producer<IntermediateType>>> left_object;
+      std::unique_ptr<Filter<IntermediateType,OutputType>> right_object;
+
+      /**
+       * Constructor used by append(), taking over the storage of the
+       * producer from another object.
+       */
+      FusedChain (std::variant<std::reference_wrapper<Producer<IntermediateType>>,
+                  std::unique_ptr<Producer<IntermediateType>>> &&left,
+                  std::unique_ptr<Filter<IntermediateType,OutputType>> &&right)
+        :
+        left_object (std::move(left)),
+        right_object (std::move(right))
+      {
+        right_object->connect_to_producer (get_left_object());
+      }
+
+      /**
+       * Return a reference to the producer stored by the constructor.
+       */
+      Producer<IntermediateType> &
+      get_left_object ()
+      {
+        if (std::holds_alternative<std::reference_wrapper<Producer<IntermediateType>>>(left_object))
+          return std::get<std::reference_wrapper<Producer<IntermediateType>>>(left_object).get();
+        else
+          return *std::get<std::unique_ptr<Producer<IntermediateType>>>(left_object);
+      }
+
+      template <typename, typename> friend class FusedChain;
+  };
+
+
+  namespace internal
+  {
+    /**
+     * A type trait that determines whether `T` is a specialization of the
+     * FusedChain class.
+     */
+    template <typename T>
+    struct is_fused_chain : std::false_type
+    {};
+
+    template <typename IntermediateType, typename OutputType>
+    struct is_fused_chain<FusedChain<IntermediateType,OutputType>> : std::true_type
+    {};
+  }
+
+
   /**
    * Connect a consumer to a producer of samples, by writing chains such as
    * @code
@@ -594,6 +863,26 @@ namespace SampleFlow
    *
    *    In this case, the return value is an object of type
    *    `Chain<ProducerType::input_type, ProducerType::output_type, ConsumerType::output_type>`.
+   *
+   * Cases 2 and 4 are treated differently if the filter on the right is a
+   * temporary object of a type that satisfies the Concepts::is_fusable_filter
+   * concept:
+   * - In case 4, if the filter on the left is also a temporary fusable
+   *   filter, then the two filters are fused into a single
+   *   `FusedFilter<ProducerType::input_type, ProducerType::output_type, ConsumerType::output_type>`
+   *   object.
+   * - In case 2, the return value is a
+   *   `FusedChain<ProducerType::output_type, ConsumerType::output_type>`
+   *   object. If the producer on the left is itself a temporary FusedChain
+   *   object, then the filter it stores and the one on the right are fused
+   *   as in case 4, and the result is a FusedChain object whose producer
+   *   is the one stored in the chain on the left.
+   *
+   * In these cases, samples do not pass from one filter to the next via
+   * signals, but are passed on by direct function calls; see the
+   * FusedFilter class. Named (i.e., non-temporary) filters are never fused
+   * since other consumers may be connected to them, or their state may be
+   * queried later on.
    */
   template <typename LeftType, typename RightType>
   requires (Concepts::is_producer<std::remove_reference_t<LeftType>>  &&
@@ -610,6 +899,19 @@ namespace SampleFlow
                   !Concepts::is_filter<ConsumerType>)
       return Chain<void, typename ProducerType::output_type, void>
              (std::forward<LeftType>(producer), std::forward<RightType>(consumer));
+    else if constexpr (!Concepts::is_filter<ProducerType>  &&
+                       Concepts::is_fusable_filter<ConsumerType> &&
+                       !std::is_reference_v<RightType>)
+      {
+        if constexpr (!std::is_reference_v<LeftType> &&
+                      internal::is_fused_chain<ProducerType>::value)
+          return std::move(producer).append (std::move(consumer));
+        else
+          return FusedChain<typename ProducerType::output_type,
+                 typename ConsumerType::output_type>
+                 (std::forward<LeftType>(producer),
+                  std::make_unique<ConsumerType>(std::move(consumer)));
+      }
     else if constexpr (!Concepts::is_filter<ProducerType>  &&
                        Concepts::is_filter<ConsumerType>)
       return Chain<void,
@@ -623,6 +925,16 @@ namespace SampleFlow
         typename ProducerType::output_type,
         void>
         (std::forward<LeftType>(producer), std::forward<RightType>(consumer));
+    else if constexpr (Concepts::is_fusable_filter<ProducerType>  &&
+                       Concepts::is_fusable_filter<ConsumerType> &&
+                       !std::is_reference_v<LeftType> &&
+                       !std::is_reference_v<RightType>)
+      return
+        FusedFilter<typename ProducerType::input_type,
+        typename ProducerType::output_type,
+        typename ConsumerType::output_type>
+        (std::make_unique<ProducerType>(std::move(producer)),
+         std::make_unique<ConsumerType>(std::move(consumer)));
     else if constexpr (Concepts::is_filter<ProducerType>  &&
                        Concepts::is_filter<ConsumerType>)
       return
@@ -20,17 +20,34 @@
 
 #include <sampleflow/auxiliary_data.h>
 #include <sampleflow/concepts.h>
+#include <sampleflow/instrumentation.h>
+#include <sampleflow/memory.h>
 #include <sampleflow/producer.h>
 #include <sampleflow/parallel_mode.h>
-#include <boost/signals2.hpp>
+#include <sampleflow/pipeline_graph.h>
+#include <sampleflow/reproducibility.h>
+#include <sampleflow/sample_view.h>
+#include <sampleflow/shared_sample.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/bounded_queue.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/signal.h>
+#include <sampleflow/tracing.h>
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <utility>
-#include <future>
 #include <atomic>
-#include <deque>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <optional>
+#include <thread>
 #include <shared_mutex>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumer.impl.h>
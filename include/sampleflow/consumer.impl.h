@@ -54,6 +54,40 @@ namespace SampleFlow
    * their object need to use `std::mutex` and `std::lock_guard` objects
    * appropriately.
    *
+   * An exception is if the user has selected ParallelMode::single_threaded
+   * for a consumer, and thereby promised that all samples come from a single
+   * thread. To avoid locking a mutex for every sample in that case, the
+   * consume() functions of derived classes should obtain their locks via
+   * the lock_state() function rather than through a `std::lock_guard`
+   * object.
+   *
+   *
+   * ### Saving and combining the state of consumers ###
+   *
+   * Consumers that compute statistics from the samples they receive,
+   * such as Consumers::MeanValue, Consumers::CovarianceMatrix,
+   * Consumers::Histogram, or Consumers::AutoCovarianceTrace, have
+   * member functions `save()` and `load()` that convert the statistics
+   * computed so far into a compact binary representation and back (see
+   * namespace Serialization), as well as a member function `merge()` that
+   * adds the statistics computed by another object of the same type to
+   * the current one. The first two allow saving the state of a
+   * computation along with a checkpoint of the sampler that feeds it (see
+   * Checkpointer), so that a long-running job can be restarted without
+   * having to process all samples again. The last one allows combining
+   * the results of many independent runs -- for example of many jobs on a
+   * cluster, each of which saves the state of its consumers at the end --
+   * at a cost that does not depend on the number of samples these runs
+   * have processed.
+   *
+   * Consumers::MeanValue, Consumers::CovarianceMatrix,
+   * Consumers::Histogram, and Consumers::CountSamples can in addition keep
+   * their state in a memory-mapped file via their `keep_state_in_file()`
+   * member functions (see PersistentState). The state is then updated
+   * every few samples by the threads that process them, survives if the
+   * program is killed, and is restored when the program is restarted and
+   * calls the same function again.
+   *
    *
    * @tparam InputType The C++ type used to describe samples. For example,
    *   if one samples from a continuous, one-dimensional distribution, then
@@ -62,7 +96,7 @@ namespace SampleFlow
    */
   template <typename InputType>
   requires (Concepts::is_valid_sampletype<InputType>)
-  class Consumer
+  class Consumer : public PipelineGraph::DownstreamNode
   {
     public:
       /**
@@ -133,6 +167,15 @@ namespace SampleFlow
        * to all samplers by calling this function several times with
        * different arguments.
        *
+       * This function can be called while the producer is sending samples
+       * on another thread, for example from within a long-running call to
+       * the `sample()` function of a sampler, and while the current object
+       * is already receiving samples from other producers. The current
+       * object then receives the samples the producer sends after the
+       * connection has been made. (See the documentation of the Producer
+       * class.) Likewise, disconnect_and_flush() can be called to detach
+       * the current object while samples are being sent.
+       *
        * @param[in] producer A reference to the producer object whose
        *   samples we want to consumer in the current object.
        */
@@ -155,6 +198,61 @@ namespace SampleFlow
       consume (InputType sample,
                AuxiliaryData aux_data) = 0;
 
+      /**
+       * Process a whole batch of samples at once. This function is called
+       * if an upstream producer sends its samples in batches (via the
+       * Producer::issue_batch signal) rather than one at a time. The
+       * implementation in this class simply calls consume() for each sample
+       * in turn, but derived classes for which processing a single sample
+       * is cheap compared to the overhead of a function call and of
+       * acquiring a lock may want to override this function and process the
+       * whole batch at once.
+       *
+       * In ParallelMode::asynchronous and ParallelMode::dedicated_thread,
+       * the samples of a batch are placed into the queue of samples
+       * individually, and this function is not called.
+       *
+       * @param[in] samples A vector of samples $x_k$.
+       * @param[in] aux_data A vector of the same length as `samples` with the
+       *   additional information for each sample.
+       */
+      virtual
+      void
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data);
+
+      /**
+       * Process a sample that the caller continues to own, and that is for
+       * this reason only passed by reference. This function is called by
+       * Consumers::Group, which sends the same sample to several consumers.
+       * The implementation in this class simply calls consume() with
+       * copies of the sample and the auxiliary data. Derived classes
+       * that do not need to store the sample (or only occasionally) can
+       * override this function to avoid the copy.
+       *
+       * @param[in] sample A sample $x_k$.
+       * @param[in] aux_data Additional information about the sample.
+       */
+      virtual
+      void
+      consume_by_reference (const InputType     &sample,
+                            const AuxiliaryData &aux_data);
+
+      /**
+       * Return whether this object only ever looks at the samples it
+       * receives, without needing a copy of its own. If this is the case,
+       * and if the object processes samples synchronously or in
+       * single-threaded mode, then producers send it samples via
+       * consume_by_reference() rather than consume(), and a producer that
+       * sends each sample to several consumers does not need to copy the
+       * sample for the current object (see SharedSample::release()).
+       * Derived classes whose implementation of consume_by_reference()
+       * does not copy the sample can override this function to return
+       * true; the implementation in this class returns false.
+       */
+      virtual
+      bool
+      reads_samples_by_reference () const;
 
       /**
        * Set how this consumer or filter should process newly incoming samples.
@@ -171,19 +269,127 @@ namespace SampleFlow
        *   processed.
        * @param[in] queue_size The maximum number of samples whose processing
        *   has been deferred at any given time and whose processing has not
-       *   finished yet. If, for example, `queue_size` is one and a previous
-       *   sample has not completed processing, then a newly incoming sample
-       *   will be held up (and the current process will block) until the
-       *   previous sample has completed processing.
+       *   started yet. If, for example, `queue_size` is one and a previous
+       *   sample is still waiting to be processed, then a newly incoming
+       *   sample is dealt with as determined by the `queue_full_policy`
+       *   argument. This argument is only used if `parallel_mode` is
+       *   ParallelMode::asynchronous or ParallelMode::dedicated_thread, and
+       *   must be at least one.
+       * @param[in] queue_full_policy What to do with a newly incoming
+       *   sample if the queue of samples is full. By default, the
+       *   current thread blocks until there is space in the queue.
+       *   See the QueueFullPolicy `enum` for more information.
        *
-       * @note This function needs to be be called *before* this consumer or
-       *   filter is connected to any upstream producer (or other filter), and
-       *   in particular before any samples are actually sent to the current
-       *   object.
+       * @note This function is best called *before* this consumer or
+       *   filter is connected to any upstream producer (or other filter). If
+       *   it is called for an object that is already connected, then the
+       *   object is first disconnected via disconnect_and_flush() -- i.e.,
+       *   it processes all samples it has already received -- and then
+       *   connected to the same producers again, using the new parallel
+       *   mode. Samples that the producers send while this happens are not
+       *   seen by the current object. This function must not be called
+       *   concurrently with connect_to_producer() or disconnect_and_flush()
+       *   for the same object.
        */
       void
       set_parallel_mode (const ParallelMode parallel_mode,
-                         const unsigned int queue_size = 1);
+                         const unsigned int queue_size = 1,
+                         const QueueFullPolicy queue_full_policy = QueueFullPolicy::block);
+
+      /**
+       * Set the thread pool on which samples are processed if this object
+       * works in ParallelMode::asynchronous. If this function is not called,
+       * the pool returned by ThreadPool::default_pool() is used. Passing the
+       * same pool to several consumers and filters (possibly in different
+       * pipelines) lets them share the worker threads of that pool.
+       *
+       * @param[in] thread_pool The pool to be used. This object keeps a
+       *   reference to the pool, so the pool remains alive at least as long
+       *   as the current object.
+       *
+       * @note This function needs to be called *before* this consumer or
+       *   filter is connected to any upstream producer (or other filter).
+       */
+      void
+      set_thread_pool (const std::shared_ptr<ThreadPool> &thread_pool);
+
+      /**
+       * Set how important it is that this object keeps up with the samples
+       * it is sent: Tasks that process its samples in
+       * ParallelMode::asynchronous are executed by the thread pool before
+       * or after those of other objects, depending on their priorities,
+       * and objects with Priority::low skip samples rather than block the
+       * sender if their queue of samples is full. See the Priority `enum`
+       * for more information. The default is Priority::normal.
+       *
+       * This function can be called at any time, including while samples
+       * are being sent to the current object. The new priority then applies
+       * to the samples that arrive after the call.
+       */
+      void
+      set_priority (const Priority priority);
+
+      /**
+       * Return the priority set via set_priority().
+       */
+      Priority
+      get_priority () const;
+
+      /**
+       * Set how the worker thread of this object waits for new samples in
+       * ParallelMode::dedicated_thread (or if it has chosen this mode in
+       * ParallelMode::adaptive) once it has processed all samples in its
+       * queue, i.e., how long it looks for new samples before it goes to
+       * sleep. See the WaitPolicy structure for more information. Producers
+       * only wake up the worker thread if it is actually sleeping, and so
+       * a worker thread that looks for new samples a bit longer saves them
+       * this work if samples arrive at a high rate. The default is a
+       * default-constructed WaitPolicy object.
+       *
+       * This function can be called at any time, including while samples
+       * are being sent to the current object. The new policy then applies
+       * the next time the worker thread runs out of samples.
+       */
+      void
+      set_wait_policy (const WaitPolicy &wait_policy);
+
+      /**
+       * Return the parallel mode in which this object currently processes
+       * samples. This is the mode set via set_parallel_mode(), except if
+       * that was ParallelMode::adaptive: Then the function returns
+       * ParallelMode::adaptive while the object is still measuring how
+       * expensive it is to process samples, and afterwards the mode it
+       * has chosen, i.e., ParallelMode::synchronous,
+       * ParallelMode::asynchronous, or ParallelMode::dedicated_thread.
+       */
+      ParallelMode
+      get_parallel_mode () const;
+
+      /**
+       * The number of samples an object in ParallelMode::adaptive processes
+       * synchronously, measuring how long this takes and how much time
+       * passes between the arrival of samples, before it chooses the mode
+       * in which to process all following samples.
+       */
+      static constexpr types::sample_index adaptive_calibration_samples = 1000;
+
+      /**
+       * The time processing a sample has to take, on average, for an object
+       * in ParallelMode::adaptive to process samples via a queue. This is
+       * an estimate of the time it takes to hand a sample to another thread
+       * instead, below which using a queue can not make anything faster.
+       */
+      static constexpr std::chrono::nanoseconds adaptive_minimal_consume_time
+        = std::chrono::microseconds(2);
+
+      /**
+       * The fraction of the average time between the arrival of two samples
+       * that processing a sample has to take, on average, for an object in
+       * ParallelMode::adaptive to process samples via a queue. If processing
+       * samples takes less time, then doing so synchronously only slows
+       * down the producer by less than this fraction.
+       */
+      static constexpr double adaptive_consume_time_fraction = 0.1;
 
       /**
        * Ensure that all samples currently being worked on by this object
@@ -200,6 +406,22 @@ namespace SampleFlow
       void
       flush ();
 
+      /**
+       * Prepare for receiving the samples described by the given object,
+       * for example by allocating the memory needed to store or process
+       * them. This function is called when a producer connected to the
+       * current object announces the samples it is about to send, see
+       * Producer::announce_samples(). The information is only a hint (see
+       * SampleShape), and a derived class must work correctly if the
+       * function is never called, is called more than once, or if the
+       * samples it then receives do not match the description.
+       *
+       * The default implementation does nothing.
+       */
+      virtual
+      void
+      prepare_for_samples (const SampleShape &shape);
+
       /**
        * Shut down the connections to upstream producers and filters,
        * ensuring that no further samples will be sent to the current object.
@@ -215,6 +437,141 @@ namespace SampleFlow
       void
       disconnect_and_flush ();
 
+      /**
+       * Return the performance counters of this object: how many samples
+       * it has processed and how long that took, how long it waited for
+       * locks, how many samples are waiting in its queue, and how long
+       * calls to flush() took. This function can be called at any time,
+       * also while samples are being processed on other threads; the
+       * result then reflects some, but not necessarily all, of the
+       * samples being processed at the time.
+       *
+       * The counters are only kept if SampleFlow was compiled with
+       * `SAMPLEFLOW_WITH_INSTRUMENTATION` defined; otherwise, the returned
+       * object has all counters set to zero. See namespace Instrumentation
+       * for more information.
+       */
+      Instrumentation::ConsumerStatistics
+      get_consumer_statistics () const;
+
+      /**
+       * Return an estimate of the number of bytes the state of this object
+       * takes up, i.e., the data it has accumulated from the samples it has
+       * processed, not counting the samples waiting in its queue (see
+       * queued_memory_consumption()). Derived classes whose state can take
+       * up a substantial amount of memory, such as
+       * Consumers::AutoCovarianceMatrix or Consumers::SampleStore, override
+       * this function; the default implementation returns zero. See
+       * namespace Memory for more information.
+       *
+       * Like get_consumer_statistics(), this function can be called while
+       * samples are being processed.
+       */
+      virtual
+      std::size_t
+      memory_consumption () const;
+
+      /**
+       * Return the number of bytes taken up by the samples waiting in the
+       * queue of this object in ParallelMode::asynchronous and
+       * ParallelMode::dedicated_thread.
+       */
+      std::size_t
+      queued_memory_consumption () const;
+
+      /**
+       * Add a node that describes the current object to the given graph,
+       * unless the graph already contains one. The node records the
+       * parallel mode of the object and, if it has a queue, the number of
+       * samples currently waiting in it. Filters override this function
+       * to also describe everything downstream of them. This function is
+       * called by Producer::describe_pipeline().
+       */
+      virtual
+      void
+      add_to_graph (PipelineGraph::Graph &graph) const override;
+
+      /**
+       * Return the address of the complete object the current Consumer
+       * object is part of, which identifies it in a PipelineGraph::Graph.
+       */
+      virtual
+      const void *
+      graph_node_id () const override;
+
+      /**
+       * Return the keys of the entries of the auxiliary data of samples that
+       * this object looks at, or `std::nullopt` if it may look at any of
+       * them. Producers use this information (via
+       * Producer::aux_data_requested()) to avoid computing entries that no
+       * consumer needs, and derived classes should therefore override this
+       * function if they only use some entries. The default implementation
+       * returns `std::nullopt`, which is always correct.
+       *
+       * For example, a class that only needs to know how often each sample
+       * is repeated and how it is weighted would return
+       * AuxiliaryData::repetition_count and AuxiliaryData::sample_weight,
+       * the keys queried by AuxiliaryData::n_repetitions() and
+       * AuxiliaryData::weight().
+       */
+      virtual
+      std::optional<std::vector<AuxiliaryData::Key>>
+      used_aux_data_keys () const;
+
+      /**
+       * Return whether used_aux_data_keys() contains the given key, or
+       * whether the current class needs the entry itself: This is the case
+       * for AuxiliaryData::chain_number in the deterministic mode discussed
+       * in the Reproducibility namespace. Filters
+       * override this function to also take into account the objects
+       * connected to them.
+       */
+      virtual
+      bool
+      requests_aux_data (const AuxiliaryData::Key &key) const override;
+
+      /**
+       * Receive the announcement of a producer about the samples it is
+       * about to send, and call prepare_for_samples() with it. Filters
+       * override this function to also pass the announcement on to the
+       * objects connected to them.
+       */
+      virtual
+      void
+      receive_announcement (const SampleShape &shape) override;
+
+    protected:
+      /**
+       * Return whether this object processes samples in
+       * ParallelMode::single_threaded, i.e., whether the user has promised
+       * that all samples will be sent to it from the same thread and that
+       * no other member function is called concurrently with consume().
+       * Derived classes can then skip all synchronization of their state.
+       */
+      bool
+      is_single_threaded () const;
+
+      /**
+       * Return a lock on the given mutex, or -- if this object processes
+       * samples in ParallelMode::single_threaded -- an object that does not
+       * own a lock. Derived classes use this function in their consume()
+       * functions in place of creating a `std::lock_guard`, so that
+       * they do not have to lock a mutex in single-threaded mode.
+       */
+      std::unique_lock<std::mutex>
+      lock_state (std::mutex &mutex) const;
+
+      /**
+       * If this object is connected to exactly one producer (possibly more
+       * than once), return a pointer to that producer. Otherwise, return a
+       * `nullptr`. Derived classes can call this function from their
+       * consume() functions in ParallelMode::synchronous and
+       * ParallelMode::single_threaded, where the producer exists and
+       * remains connected for at least as long as the call lasts.
+       */
+      const Producer<InputType> *
+      sole_producer () const;
+
     private:
 
       /**
@@ -230,7 +587,7 @@ namespace SampleFlow
        * to the same producer more than once.
        */
       std::multimap<const Producer<InputType> *,
-          std::tuple<boost::signals2::connection,boost::signals2::connection,boost::signals2::connection>>
+          std::tuple<Connection,Connection,Connection,Connection>>
           connections_to_producers;
 
       /**
@@ -258,13 +615,37 @@ namespace SampleFlow
       std::atomic<unsigned int> queue_size;
 
       /**
-       * A mutex that controls access to all of the data structures involved
-       * in parallel processing of samples in asynchronous mode. In particular,
-       * this includes the task queue, but also shutting down the process
-       * of accepting samples.
+       * What to do if the queue of samples is full in asynchronous mode.
+       *
+       * This variable can be read from/written to in an atomic
+       * fashion to ensure that different threads don't tread on
+       * each other.
+       */
+      std::atomic<int> queue_full_policy;
+
+      /**
+       * The priority set via set_priority(), stored as an `int` like
+       * `parallel_mode`.
+       */
+      std::atomic<int> priority;
+
+      /**
+       * A mutex that controls shutting down the process of accepting samples.
+       * In asynchronous mode, it is also used together with the
+       * `queue_not_full` condition variable to let threads sleep that wait for
+       * space in the queue of samples. It is not acquired for samples that
+       * can be added to the queue right away.
        */
       std::mutex asynchronous_mode_mutex;
 
+      /**
+       * A condition variable that is signalled whenever a sample has been
+       * removed from the queue of samples while there are threads waiting
+       * for space in the queue, and when the current object is disconnected
+       * from its producers.
+       */
+      std::condition_variable queue_not_full;
+
       /**
        * A mutex that controls access to all of the data structures involved
        * in parallel processing of samples in synchronous mode. In synchronous
@@ -277,19 +658,270 @@ namespace SampleFlow
       std::shared_mutex synchronous_mode_mutex;
 
       /**
-       * A queue of std::future objects that correspond to tasks that
-       * process samples.
+       * The thread pool on which samples are processed if this object
+       * works in asynchronous mode. This is either the pool set via
+       * set_thread_pool(), or -- if that function has not been called --
+       * the pool returned by ThreadPool::default_pool() at the time
+       * this object is connected to a producer.
+       */
+      std::shared_ptr<ThreadPool> thread_pool;
+
+      /**
+       * An object that keeps track of the tasks that have been enqueued
+       * with the thread pool to process samples in asynchronous mode, and
+       * that have not finished yet.
+       */
+      ThreadPool::TaskGroup background_tasks;
+
+      /**
+       * A structure that describes one sample (along with its auxiliary
+       * data) in `sample_queue`, and the number of bytes it was found to
+       * take up when it was added to the queue (see Memory::try_reserve()).
+       * If `InputType` is a view type that refers to memory owned by the
+       * producer (see Concepts::is_sample_view), the queue stores a copy
+       * of the elements of the sample instead, since the producer may
+       * reuse its memory once it has sent the sample.
+       */
+      struct QueuedSample
+      {
+        types::MaterializedType<InputType> sample;
+        AuxiliaryData aux_data;
+        std::size_t   n_bytes;
+      };
+
+      /**
+       * The queue of samples that have been received in asynchronous or
+       * dedicated-thread mode but whose processing has not started yet.
+       * The queue has room for `queue_size` samples and is created when
+       * this object is first connected to a producer.
        */
-      std::deque<std::future<void>> background_tasks;
+      std::unique_ptr<BoundedQueue<QueuedSample>> sample_queue;
 
+      /**
+       * Whether a task that works through `sample_queue` (i.e., a call to
+       * process_queued_samples()) has been handed to the thread pool and has
+       * not finished yet. There is at most one such task at any given time,
+       * so that samples are removed from the queue by only one thread.
+       */
+      std::atomic<bool> processing_scheduled;
+
+      /**
+       * A copy of `connections_to_producers.size()` that can be read without
+       * holding a lock. A value of zero indicates that samples that
+       * arrive in asynchronous mode should be ignored because the current
+       * object is being disconnected.
+       */
+      std::atomic<std::size_t> n_connections;
+
+      /**
+       * The number of threads currently adding a sample to `sample_queue`,
+       * and the number of those that are waiting for space in the queue.
+       * disconnect_and_flush() waits for the former to become zero before
+       * calling flush().
+       */
+      std::atomic<unsigned int> n_active_senders;
+      std::atomic<unsigned int> n_waiting_senders;
+
+      /**
+       * The number of bytes taken up by the samples in `sample_queue`, see
+       * queued_memory_consumption().
+       */
+      std::atomic<std::size_t> n_queued_bytes;
+
+      /**
+       * The thread that works through `sample_queue` in dedicated-thread
+       * mode. It is started when the current object is first connected to a
+       * producer, and stopped in disconnect_and_flush().
+       */
+      std::thread worker_thread;
+
+      /**
+       * A mutex and two condition variables with which the worker thread
+       * goes to sleep if there are no samples in the queue, is woken up
+       * again when a sample is added, and tells flush() that it has
+       * processed all samples.
+       */
+      std::mutex              worker_mutex;
+      std::condition_variable worker_wakeup;
+      std::condition_variable worker_idle;
+
+      /**
+       * Whether the worker thread is waiting for new samples (or is
+       * about to do so), and whether it has been asked to terminate.
+       */
+      std::atomic<bool> worker_waiting;
+      bool              stop_worker;
+
+      /**
+       * The two members of the WaitPolicy set via set_wait_policy(),
+       * stored as atomic variables so that the worker thread can read them
+       * while the policy is changed.
+       */
+      std::atomic<unsigned int> n_wait_spins;
+      std::atomic<unsigned int> n_wait_yields;
+
+      /**
+       * In ParallelMode::adaptive, the mode in which samples are processed:
+       * ParallelMode::adaptive while we are measuring how expensive it is to
+       * process samples, and the mode chosen based on these measurements
+       * afterwards. The value is stored as an `int`, like `parallel_mode`.
+       */
+      std::atomic<int> adaptive_choice;
+
+      /**
+       * The measurements taken in ParallelMode::adaptive before choosing a
+       * mode: The number of samples processed, the time spent processing
+       * them, and the times at which the first and the last of them
+       * arrived (in nanoseconds since the epoch of Instrumentation::Clock,
+       * with zero indicating that no sample has arrived yet).
+       */
+      std::atomic<types::sample_index> n_calibration_samples;
+      std::atomic<std::int64_t>        calibration_consume_time;
+      std::atomic<std::int64_t>        first_calibration_arrival;
+      std::atomic<std::int64_t>        last_calibration_arrival;
+
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+      /**
+       * The performance counters of this object. They are kept per
+       * thread so that threads processing samples concurrently do not
+       * compete for the same counters.
+       */
+      mutable ShardedAccumulator<Instrumentation::ConsumerStatistics> statistics;
+#endif
+
+      /**
+       * Call consume(), consume_by_reference(), or consume_batch() with
+       * the given arguments, and flush(), respectively. These are the
+       * functions through which the machinery of this class calls these
+       * functions, so that the time they take can be recorded if
+       * performance counters are kept. If they are not, these functions do
+       * nothing but forward their arguments.
+       */
+      void
+      instrumented_consume (InputType &&sample,
+                            AuxiliaryData &&aux_data);
+
+      void
+      instrumented_consume_by_reference (const InputType     &sample,
+                                         const AuxiliaryData &aux_data);
+
+      void
+      instrumented_consume_batch (const std::vector<InputType> &samples,
+                                  const std::vector<AuxiliaryData> &aux_data);
+
+      void
+      instrumented_flush ();
+
+      /**
+       * Record the current number of samples in `sample_queue` if
+       * performance counters are kept. This is called after a sample has
+       * been added to the queue.
+       */
+      void
+      record_queue_depth ();
+
+      /**
+       * Add the given sample to `sample_queue`, following the policy set
+       * for the situation that the queue is full, and account for the
+       * memory it takes up (see namespace Memory).
+       *
+       * @return Whether the sample was added. This is not the case if we
+       *   had to wait for space in the queue and the current object was
+       *   disconnected in the meantime.
+       */
+      bool
+      enqueue_sample (QueuedSample &sample);
+
+      /**
+       * The parts of enqueue_sample(): Record that a sample of the given
+       * size is going to be added to the queue, following the memory budget
+       * set via Memory::set_budget(); the opposite of that; and adding the
+       * sample to the queue following the policy selected for the case that
+       * the queue is full. The first and last of these return `false` if we
+       * had to wait and the current object was disconnected in the
+       * meantime.
+       */
+      bool
+      reserve_queue_memory (const std::size_t n_bytes);
+
+      void
+      release_queue_memory (const std::size_t n_bytes);
+
+      bool
+      push_to_queue (QueuedSample &sample);
+
+      /**
+       * Add the given sample to `sample_queue` and make sure that it is
+       * processed, by a task on the thread pool in asynchronous mode or by
+       * the worker thread in dedicated-thread mode, respectively. These
+       * are the functions called for each sample that arrives in these
+       * modes.
+       */
+      void
+      send_to_thread_pool (InputType &&sample,
+                           AuxiliaryData &&aux_data);
+
+      void
+      send_to_worker_thread (InputType &&sample,
+                             AuxiliaryData &&aux_data);
+
+      /**
+       * In ParallelMode::adaptive, record that `n_samples` samples arrived
+       * at the given time and that processing them synchronously took
+       * `consume_time`. Once this has been done for
+       * adaptive_calibration_samples samples, choose the mode in which to
+       * process all following samples and store it in `adaptive_choice`.
+       */
+      void
+      record_calibration (const Instrumentation::Clock::time_point arrival,
+                          const std::chrono::nanoseconds consume_time,
+                          const types::sample_index n_samples);
+
+      /**
+       * Remove samples from `sample_queue` and call consume() for each of
+       * them, until the queue is empty.
+       */
+      void
+      consume_queued_samples ();
+
+      /**
+       * Call consume_queued_samples() until the queue is empty and no other
+       * task has been scheduled to deal with samples that have been added
+       * since. This is the function that is executed on the thread pool in
+       * asynchronous mode.
+       */
+      void
+      process_queued_samples ();
+
+      /**
+       * The function executed by `worker_thread` in dedicated-thread mode:
+       * Process samples as they are added to the queue, and go to sleep
+       * whenever the queue is empty, until stop_worker_thread() is called.
+       */
+      void
+      run_worker_thread ();
+
+      /**
+       * Wake up the worker thread if it is waiting for samples. This
+       * is called after a sample has been added to the queue in
+       * dedicated-thread mode.
+       */
+      void
+      wake_worker_thread ();
+
+      /**
+       * Start the worker thread for dedicated-thread mode, unless it is
+       * already running.
+       */
+      void
+      start_worker_thread ();
 
       /**
-       * Ensure that the queue of background tasks does not grow beyond
-       * bounds by going through the queue and deleting all std::future
-       * objects located at the beginning of the queue that have already
-       * completed.
+       * Tell the worker thread to exit once the queue is empty, and wait
+       * for it to do so. Nothing happens if there is no worker thread.
        */
-      void trim_background_queue();
+      void
+      stop_worker_thread ();
   };
 
 
@@ -300,7 +932,23 @@ namespace SampleFlow
     :
     parallel_mode (static_cast<int>(ParallelMode::synchronous)),
     supported_parallel_modes (supported_parallel_modes),
-    queue_size (1)
+    queue_size (1),
+    queue_full_policy (static_cast<int>(QueueFullPolicy::block)),
+    priority (static_cast<int>(Priority::normal)),
+    processing_scheduled (false),
+    n_connections (0),
+    n_active_senders (0),
+    n_waiting_senders (0),
+    n_queued_bytes (0),
+    worker_waiting (false),
+    stop_worker (false),
+    n_wait_spins (WaitPolicy().n_spins),
+    n_wait_yields (WaitPolicy().n_yields),
+    adaptive_choice (static_cast<int>(ParallelMode::adaptive)),
+    n_calibration_samples (0),
+    calibration_consume_time (0),
+    first_calibration_arrival (0),
+    last_calibration_arrival (0)
   {}
 
 
@@ -309,7 +957,24 @@ namespace SampleFlow
   Consumer<InputType>::Consumer (Consumer &&consumer)
     :
     parallel_mode (consumer.parallel_mode.load()),
-    supported_parallel_modes (consumer.supported_parallel_modes)
+    supported_parallel_modes (consumer.supported_parallel_modes),
+    queue_full_policy (consumer.queue_full_policy.load()),
+    priority (consumer.priority.load()),
+    thread_pool (consumer.thread_pool),
+    processing_scheduled (false),
+    n_connections (0),
+    n_active_senders (0),
+    n_waiting_senders (0),
+    n_queued_bytes (0),
+    worker_waiting (false),
+    stop_worker (false),
+    n_wait_spins (consumer.n_wait_spins.load()),
+    n_wait_yields (consumer.n_wait_yields.load()),
+    adaptive_choice (static_cast<int>(ParallelMode::adaptive)),
+    n_calibration_samples (0),
+    calibration_consume_time (0),
+    first_calibration_arrival (0),
+    last_calibration_arrival (0)
   {
     // Assert that there are no connections yet, as stated in the documentation.
     // If there are no connections, then there can also be no samples
@@ -318,7 +983,7 @@ namespace SampleFlow
 
     assert (consumer.connections_to_producers.size() == 0);
     assert (queue_size == 0);
-    assert (background_tasks.size()==0);
+    assert (consumer.background_tasks.n_pending_tasks() == 0);
   }
 
 
@@ -347,6 +1012,10 @@ namespace SampleFlow
     // sample looks like depends on the parallel mode of the current
     // object.
     std::function<void(InputType sample, AuxiliaryData aux_data)> sample_consumer;
+    std::function<void(const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data)> batch_consumer;
+    std::function<void(const InputType &sample,
+                       const AuxiliaryData &aux_data)> reference_sample_consumer;
     switch (static_cast<ParallelMode>(parallel_mode.load()))
       {
         // If we want to process samples synchronously,
@@ -393,80 +1062,230 @@ namespace SampleFlow
               return;
 
             // Execute the consumer
-            consume (std::move(sample), std::move(aux_data));
+            instrumented_consume (std::move(sample), std::move(aux_data));
+          };
+
+          // Batches of samples are treated the same way, except that we
+          // only need to acquire the lock once for the whole batch.
+          batch_consumer =
+            [&](const std::vector<InputType> &samples,
+                const std::vector<AuxiliaryData> &aux_data)
+          {
+            std::shared_lock<std::shared_mutex> one_of_many_lock(synchronous_mode_mutex);
+
+            if (connections_to_producers.size() == 0)
+              return;
+
+            instrumented_consume_batch (samples, aux_data);
           };
 
+          // Objects that only look at samples can get them by reference:
+          if (reads_samples_by_reference())
+            reference_sample_consumer =
+              [&](const InputType &sample, const AuxiliaryData &aux_data)
+            {
+              std::shared_lock<std::shared_mutex> one_of_many_lock(synchronous_mode_mutex);
+
+              if (connections_to_producers.size() == 0)
+                return;
+
+              instrumented_consume_by_reference (sample, aux_data);
+            };
+
           break;
         }
 
 
-        // On the other hand, if we use asynchronous processing,
-        // then the logic is substantially more complicated.
-        case ParallelMode::asynchronous:
+        // In single-threaded mode, the user has promised us that all
+        // samples come from the same thread, and that disconnect_and_flush()
+        // is called from that thread as well. There is then no need to
+        // guard against anything, and we can just call consume().
+        case ParallelMode::single_threaded:
         {
           sample_consumer =
             [&](InputType sample, AuxiliaryData aux_data)
           {
-            // Create a task that calls `consume()`. First, because we're going
-            // to run this task at some later time, we need to copy the sample
-            // and aux data at this point. (If we were using C++14, we could
-            // actually *move* these objects into the lambda function, but that
-            // is not possible with C++11.)
-            auto worker =
-              [this,sample,aux_data]()
+            instrumented_consume (std::move(sample), std::move(aux_data));
+          };
+
+          batch_consumer =
+            [&](const std::vector<InputType> &samples,
+                const std::vector<AuxiliaryData> &aux_data)
+          {
+            instrumented_consume_batch (samples, aux_data);
+          };
+
+          if (reads_samples_by_reference())
+            reference_sample_consumer =
+              [&](const InputType &sample, const AuxiliaryData &aux_data)
             {
-              this->consume (std::move(sample), std::move(aux_data));
+              instrumented_consume_by_reference (sample, aux_data);
             };
 
-            // We then also need to put a future object into the queue that we
-            // can query for unfinished objects. Since the queue is a shared
-            // state, we need to access it under a lock. Once we are under the
-            // lock, we can also commit to actually launching the task
-            {
-              std::lock_guard<std::mutex> parallel_lock (asynchronous_mode_mutex);
+          break;
+        }
 
-              // If all connections have been severed since we actually
-              // got here (via a connection, of course), we pretend that we
-              // never received the sample. This is the same as what happened
-              // in the synchronous case above.
-              if (connections_to_producers.size() == 0)
-                return;
 
-              // Then start the task in the background and let the OS decide when
-              // it wants to execute it. The result is a std::future object that
-              // we can query for completion of the task, and we will hold on
-              // to this future object because we need to wait for tasks to finish
-              // in flush().
-              std::future<void> future = std::async(worker);
-
-              // Next emplace the future object into the queue, in order
-              // to allow other threads to wait for the termination of
-              // the current job
-              background_tasks.emplace_back (std::move(future));
-            }
+        // On the other hand, if we use asynchronous processing,
+        // then the logic is substantially more complicated.
+        case ParallelMode::asynchronous:
+        {
+          if (thread_pool == nullptr)
+            thread_pool = ThreadPool::default_pool();
+          if (sample_queue == nullptr)
+            sample_queue = std::make_unique<BoundedQueue<QueuedSample>>(queue_size.load());
 
+          sample_consumer =
+            [&](InputType sample, AuxiliaryData aux_data)
+          {
+            send_to_thread_pool (std::move(sample), std::move(aux_data));
+          };
 
-            // Finally, ensure that the queue does not grow beyond bound by
-            // removing futures at the front that have already been satisfied.
-            trim_background_queue();
+          // Batches of samples are simply split into their individual
+          // samples, each of which is placed into the queue.
+          batch_consumer =
+            [sample_consumer](const std::vector<InputType> &samples,
+                              const std::vector<AuxiliaryData> &aux_data)
+          {
+            assert (samples.size() == aux_data.size());
+            for (std::size_t i=0; i<samples.size(); ++i)
+              sample_consumer (Utilities::copy_sample (samples[i]), aux_data[i]);
           };
 
           break;
         }
 
 
-        default:
-          assert(false);
-      }
+        // In dedicated-thread mode, samples are added to the queue in the
+        // same way as in asynchronous mode, but rather than scheduling a
+        // task that processes them, we just have to wake up the worker
+        // thread, which we create the first time we get here.
+        case ParallelMode::dedicated_thread:
+        {
+          if (sample_queue == nullptr)
+            sample_queue = std::make_unique<BoundedQueue<QueuedSample>>(queue_size.load());
+          start_worker_thread ();
+
+          sample_consumer =
+            [&](InputType sample, AuxiliaryData aux_data)
+          {
+            send_to_worker_thread (std::move(sample), std::move(aux_data));
+          };
+
+          batch_consumer =
+            [sample_consumer](const std::vector<InputType> &samples,
+                              const std::vector<AuxiliaryData> &aux_data)
+          {
+            assert (samples.size() == aux_data.size());
+            for (std::size_t i=0; i<samples.size(); ++i)
+              sample_consumer (Utilities::copy_sample (samples[i]), aux_data[i]);
+          };
+
+          break;
+        }
+
+
+        // In adaptive mode, we process samples synchronously (as in the
+        // synchronous case above) until we have taken enough measurements
+        // to choose a mode, and then in the chosen mode. Set up what we
+        // need for asynchronous mode here, but only start a worker thread
+        // once we have chosen dedicated-thread mode.
+        case ParallelMode::adaptive:
+        {
+          if (thread_pool == nullptr)
+            thread_pool = ThreadPool::default_pool();
+          if (sample_queue == nullptr)
+            sample_queue = std::make_unique<BoundedQueue<QueuedSample>>(queue_size.load());
+
+          sample_consumer =
+            [&](InputType sample, AuxiliaryData aux_data)
+          {
+            switch (static_cast<ParallelMode>(adaptive_choice.load (std::memory_order_acquire)))
+              {
+                case ParallelMode::asynchronous:
+                  send_to_thread_pool (std::move(sample), std::move(aux_data));
+                  return;
+
+                case ParallelMode::dedicated_thread:
+                  send_to_worker_thread (std::move(sample), std::move(aux_data));
+                  return;
+
+                default:
+                  break;
+              }
+
+            std::shared_lock<std::shared_mutex> one_of_many_lock(synchronous_mode_mutex);
+            if (connections_to_producers.size() == 0)
+              return;
+
+            if (adaptive_choice.load (std::memory_order_acquire)
+                == static_cast<int>(ParallelMode::adaptive))
+              {
+                const Instrumentation::Clock::time_point arrival = Instrumentation::Clock::now();
+                instrumented_consume (std::move(sample), std::move(aux_data));
+                record_calibration (arrival, Instrumentation::Clock::now() - arrival, 1);
+              }
+            else
+              instrumented_consume (std::move(sample), std::move(aux_data));
+          };
+
+          // If we process samples via a queue, split batches into their
+          // individual samples, as in asynchronous mode:
+          batch_consumer =
+            [&, sample_consumer](const std::vector<InputType> &samples,
+                                 const std::vector<AuxiliaryData> &aux_data)
+          {
+            assert (samples.size() == aux_data.size());
+            const int choice = adaptive_choice.load (std::memory_order_acquire);
+            if ((choice == static_cast<int>(ParallelMode::asynchronous))
+                ||
+                (choice == static_cast<int>(ParallelMode::dedicated_thread)))
+              {
+                for (std::size_t i=0; i<samples.size(); ++i)
+                  sample_consumer (Utilities::copy_sample (samples[i]), aux_data[i]);
+                return;
+              }
+
+            std::shared_lock<std::shared_mutex> one_of_many_lock(synchronous_mode_mutex);
+            if (connections_to_producers.size() == 0)
+              return;
+
+            if ((choice == static_cast<int>(ParallelMode::adaptive))
+                &&
+                (samples.size() > 0))
+              {
+                const Instrumentation::Clock::time_point arrival = Instrumentation::Clock::now();
+                instrumented_consume_batch (samples, aux_data);
+                record_calibration (arrival, Instrumentation::Clock::now() - arrival,
+                                    samples.size());
+              }
+            else
+              instrumented_consume_batch (samples, aux_data);
+          };
+
+          break;
+        }
+
+
+        default:
+          assert(false);
+      }
 
 
     // Also build something that we can connect to the `flush_consumers`
     // signal. For this, we call flush(), which in the case of Filters is
     // overloaded to also call the flush_consumers() signal of the Producer
-    // side of the Filter
+    // side of the Filter. Producers may call this signal from a thread of
+    // their own (see Producer::flush_consumers_async()), possibly while
+    // we are being disconnected; so register the call in the same way as
+    // the asynchronous sample slots do, so that disconnect_and_flush()
+    // waits for it to finish.
     auto flush_slot = [this]()
     {
-      this->flush();
+      ++n_active_senders;
+      if (n_connections.load() > 0)
+        this->instrumented_flush();
+      --n_active_senders;
     };
 
     auto disconnect_from_producer = [this](const Producer<InputType> &p)
@@ -488,16 +1307,104 @@ namespace SampleFlow
         std::get<0>(x->second).disconnect ();
         std::get<1>(x->second).disconnect ();
         std::get<2>(x->second).disconnect ();
+        std::get<3>(x->second).disconnect ();
 
         // Having terminated these connections, remove the entry from the map too.
+        x->first->unregister_downstream_node (this);
         connections_to_producers.erase (x);
+        n_connections = connections_to_producers.size();
       }
+      queue_not_full.notify_all();
     };
 
-    // Finally hook it all up:
-    connections_to_producers.insert (producer.connect_to_signals (sample_consumer,
-                                                                  flush_slot,
-                                                                  disconnect_from_producer));
+    // Count the samples sent through this connection, so that
+    // Producer::describe_pipeline() can report the throughput of each
+    // edge. This is only done with instrumentation enabled, since it
+    // costs an atomic increment per sample.
+    const auto edge_counter = std::make_shared<PipelineGraph::EdgeCounter>();
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    sample_consumer =
+      [edge_counter, sample_consumer](InputType sample, AuxiliaryData aux_data)
+    {
+      edge_counter->n_samples.fetch_add (1, std::memory_order_relaxed);
+      sample_consumer (std::move(sample), std::move(aux_data));
+    };
+    batch_consumer =
+      [edge_counter, batch_consumer](const std::vector<InputType> &samples,
+                                     const std::vector<AuxiliaryData> &aux_data)
+    {
+      edge_counter->n_samples.fetch_add (samples.size(), std::memory_order_relaxed);
+      batch_consumer (samples, aux_data);
+    };
+    if (reference_sample_consumer)
+      reference_sample_consumer =
+        [edge_counter, reference_sample_consumer](const InputType &sample,
+                                                  const AuxiliaryData &aux_data)
+      {
+        edge_counter->n_samples.fetch_add (1, std::memory_order_relaxed);
+        reference_sample_consumer (sample, aux_data);
+      };
+#endif
+
+    // Finally hook it all up, and let the producer we end up connected to
+    // know about us. The current object may already be connected to
+    // other producers that are sending it samples right now, and the
+    // sample processing machinery queries the state of the connections,
+    // so we have to do this under the same mutices as disconnecting:
+    {
+      std::lock_guard<std::mutex> parallel_lock_1 (asynchronous_mode_mutex);
+      std::unique_lock<std::shared_mutex> parallel_lock_2 (synchronous_mode_mutex);
+
+      const auto connection = producer.connect_to_signals (sample_consumer,
+                                                           batch_consumer,
+                                                           flush_slot,
+                                                           disconnect_from_producer,
+                                                           reference_sample_consumer);
+      connection.first->register_downstream_node (this, edge_counter);
+      connections_to_producers.insert (connection);
+      n_connections = connections_to_producers.size();
+    }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  consume_batch (const std::vector<InputType> &samples,
+                 const std::vector<AuxiliaryData> &aux_data)
+  {
+    assert (samples.size() == aux_data.size());
+
+    for (std::size_t i=0; i<samples.size(); ++i)
+      if constexpr (std::copyable<InputType>)
+        consume (samples[i], aux_data[i]);
+      else
+        consume_by_reference (samples[i], aux_data[i]);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  consume_by_reference (const InputType     &sample,
+                        const AuxiliaryData &aux_data)
+  {
+    consume (Utilities::copy_sample (sample), aux_data);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  reads_samples_by_reference () const
+  {
+    return false;
   }
 
 
@@ -507,15 +1414,441 @@ namespace SampleFlow
   void
   Consumer<InputType>::
   set_parallel_mode (const ParallelMode parallel_mode,
-                     const unsigned int queue_size)
+                     const unsigned int queue_size,
+                     const QueueFullPolicy queue_full_policy)
   {
-    assert (connections_to_producers.size() == 0);
-    assert ((static_cast<int>(parallel_mode)
-             & static_cast<int>(supported_parallel_modes))
-            != 0);
+    // Every class that can process samples asynchronously can also
+    // process them on a dedicated thread, which is the more
+    // restrictive case. Every class can process samples in
+    // single-threaded mode, which is the most restrictive case of
+    // all. The adaptive mode only chooses among the supported modes:
+    assert (((static_cast<int>(parallel_mode)
+              & static_cast<int>(supported_parallel_modes))
+             != 0)
+            ||
+            (parallel_mode == ParallelMode::single_threaded)
+            ||
+            (parallel_mode == ParallelMode::adaptive)
+            ||
+            ((parallel_mode == ParallelMode::dedicated_thread)
+             &&
+             ((static_cast<int>(supported_parallel_modes)
+               & static_cast<int>(ParallelMode::asynchronous))
+              != 0)));
+    assert (queue_size >= 1);
+
+    // The functions through which producers send us samples depend on the
+    // parallel mode. If we are already connected to producers, we
+    // therefore have to disconnect from them (processing everything we
+    // have already received), and then connect again with the new mode.
+    // The producers were passed to connect_to_producer() as non-const
+    // references; we only store them as pointers to const objects because
+    // that is how they identify themselves when they go out of scope.
+    std::vector<Producer<InputType> *> producers;
+    {
+      std::lock_guard<std::mutex> parallel_lock_1 (asynchronous_mode_mutex);
+      std::unique_lock<std::shared_mutex> parallel_lock_2 (synchronous_mode_mutex);
+      for (const auto &connection : connections_to_producers)
+        producers.push_back (const_cast<Producer<InputType> *>(connection.first));
+    }
+    if (producers.size() > 0)
+      {
+        disconnect_and_flush ();
+        sample_queue.reset ();
+      }
 
     this->parallel_mode = static_cast<int>(parallel_mode);
     this->queue_size = queue_size;
+    this->queue_full_policy = static_cast<int>(queue_full_policy);
+    adaptive_choice = static_cast<int>(ParallelMode::adaptive);
+
+    for (Producer<InputType> *producer : producers)
+      connect_to_producer (*producer);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  set_priority (const Priority priority)
+  {
+    this->priority = static_cast<int>(priority);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  Priority
+  Consumer<InputType>::
+  get_priority () const
+  {
+    return static_cast<Priority>(priority.load());
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  set_wait_policy (const WaitPolicy &wait_policy)
+  {
+    n_wait_spins  = wait_policy.n_spins;
+    n_wait_yields = wait_policy.n_yields;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  ParallelMode
+  Consumer<InputType>::
+  get_parallel_mode () const
+  {
+    const int mode = parallel_mode.load();
+    if (mode == static_cast<int>(ParallelMode::adaptive))
+      return static_cast<ParallelMode>(adaptive_choice.load());
+    else
+      return static_cast<ParallelMode>(mode);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  is_single_threaded () const
+  {
+    return (parallel_mode.load(std::memory_order_relaxed)
+            == static_cast<int>(ParallelMode::single_threaded));
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  std::unique_lock<std::mutex>
+  Consumer<InputType>::
+  lock_state (std::mutex &mutex) const
+  {
+    if (is_single_threaded())
+      return std::unique_lock<std::mutex> (mutex, std::defer_lock);
+
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    // Only measure the time if we actually have to wait:
+    std::unique_lock<std::mutex> lock (mutex, std::try_to_lock);
+    if (lock.owns_lock() == false)
+      {
+        const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+        lock.lock();
+        const std::chrono::nanoseconds wait_time = Instrumentation::Clock::now() - start;
+        statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+        {
+          ++s.n_contended_locks;
+          s.lock_wait_time += wait_time;
+        });
+      }
+    return lock;
+#else
+    return std::unique_lock<std::mutex> (mutex);
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  const Producer<InputType> *
+  Consumer<InputType>::
+  sole_producer () const
+  {
+    if (connections_to_producers.empty()
+        ||
+        (connections_to_producers.begin()->first
+         != std::prev(connections_to_producers.end())->first))
+      return nullptr;
+    else
+      return connections_to_producers.begin()->first;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  Instrumentation::ConsumerStatistics
+  Consumer<InputType>::
+  get_consumer_statistics () const
+  {
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    Instrumentation::ConsumerStatistics result = statistics.merged();
+    if (sample_queue != nullptr)
+      result.queue_depth = sample_queue->size();
+    return result;
+#else
+    return {};
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  std::size_t
+  Consumer<InputType>::
+  memory_consumption () const
+  {
+    return 0;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  std::size_t
+  Consumer<InputType>::
+  queued_memory_consumption () const
+  {
+    return n_queued_bytes.load (std::memory_order_relaxed);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  add_to_graph (PipelineGraph::Graph &graph) const
+  {
+    if (graph.contains (graph_node_id()))
+      return;
+
+    PipelineGraph::Node node;
+    node.object        = graph_node_id();
+    node.type_name     = PipelineGraph::demangled_type_name (typeid(*this));
+    node.kind          = PipelineGraph::NodeKind::consumer;
+    node.parallel_mode = get_parallel_mode();
+
+    // Only the modes that use a queue have a meaningful queue size:
+    if ((*node.parallel_mode == ParallelMode::asynchronous)
+        ||
+        (*node.parallel_mode == ParallelMode::dedicated_thread))
+      {
+        node.queue_size = queue_size.load();
+        if (sample_queue != nullptr)
+          node.queue_depth = sample_queue->size();
+      }
+
+    node.state_bytes  = memory_consumption();
+    node.queued_bytes = queued_memory_consumption();
+
+    graph.nodes.push_back (node);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  const void *
+  Consumer<InputType>::
+  graph_node_id () const
+  {
+    return dynamic_cast<const void *>(this);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  std::optional<std::vector<AuxiliaryData::Key>>
+  Consumer<InputType>::
+  used_aux_data_keys () const
+  {
+    return std::nullopt;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  requests_aux_data (const AuxiliaryData::Key &key) const
+  {
+    // In deterministic mode, the base class itself uses the chain number
+    // to sort samples into streams (see Reproducibility::StreamScope):
+    if ((key == AuxiliaryData::chain_number) && Reproducibility::is_deterministic())
+      return true;
+
+    const std::optional<std::vector<AuxiliaryData::Key>> keys = used_aux_data_keys();
+    return ((keys.has_value() == false)
+            ||
+            (std::find (keys->begin(), keys->end(), key) != keys->end()));
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  prepare_for_samples (const SampleShape &)
+  {}
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  receive_announcement (const SampleShape &shape)
+  {
+    prepare_for_samples (shape);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  instrumented_consume (InputType &&sample,
+                        AuxiliaryData &&aux_data)
+  {
+    Tracing::Span span ("consume", "consumer", this);
+    const Reproducibility::StreamScope stream_scope (aux_data);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+    consume (std::move(sample), std::move(aux_data));
+    const std::chrono::nanoseconds consume_time = Instrumentation::Clock::now() - start;
+
+    statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+    {
+      ++s.n_samples;
+      s.consume_time += consume_time;
+      s.consume_time_histogram.add (consume_time);
+    },
+    is_single_threaded() == false);
+#else
+    consume (std::move(sample), std::move(aux_data));
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  instrumented_consume_by_reference (const InputType     &sample,
+                                     const AuxiliaryData &aux_data)
+  {
+    Tracing::Span span ("consume", "consumer", this);
+    const Reproducibility::StreamScope stream_scope (aux_data);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+    consume_by_reference (sample, aux_data);
+    const std::chrono::nanoseconds consume_time = Instrumentation::Clock::now() - start;
+
+    statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+    {
+      ++s.n_samples;
+      s.consume_time += consume_time;
+      s.consume_time_histogram.add (consume_time);
+    },
+    is_single_threaded() == false);
+#else
+    consume_by_reference (sample, aux_data);
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  instrumented_consume_batch (const std::vector<InputType> &samples,
+                              const std::vector<AuxiliaryData> &aux_data)
+  {
+    Tracing::Span span ("consume_batch", "consumer", this);
+    const Reproducibility::StreamScope stream_scope (aux_data);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+    consume_batch (samples, aux_data);
+    const std::chrono::nanoseconds consume_time = Instrumentation::Clock::now() - start;
+
+    if (samples.size() > 0)
+      statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+      {
+        s.n_samples += samples.size();
+        ++s.n_batches;
+        s.consume_time += consume_time;
+        s.consume_time_histogram.add (consume_time / samples.size(), samples.size());
+      },
+      is_single_threaded() == false);
+#else
+    consume_batch (samples, aux_data);
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  instrumented_flush ()
+  {
+    Tracing::Span span ("flush", "consumer", this);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+    flush ();
+    const std::chrono::nanoseconds flush_time = Instrumentation::Clock::now() - start;
+
+    statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+    {
+      ++s.n_flushes;
+      s.flush_time += flush_time;
+      s.max_flush_time = std::max (s.max_flush_time, flush_time);
+    });
+#else
+    flush ();
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  record_queue_depth ()
+  {
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const std::size_t queue_depth = sample_queue->size();
+    statistics.update ([&](Instrumentation::ConsumerStatistics &s)
+    {
+      s.max_queue_depth = std::max (s.max_queue_depth, queue_depth);
+    });
+#endif
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  set_thread_pool (const std::shared_ptr<ThreadPool> &thread_pool)
+  {
+    assert (connections_to_producers.size() == 0);
+    assert (thread_pool != nullptr);
+
+    this->thread_pool = thread_pool;
   }
 
 
@@ -547,12 +1880,25 @@ namespace SampleFlow
           std::get<0>(connection).disconnect ();
           std::get<1>(connection).disconnect ();
           std::get<2>(connection).disconnect ();
+          std::get<3>(connection).disconnect ();
+          producer->unregister_downstream_node (this);
         }
       connections_to_producers.clear();
+      n_connections = 0;
     }
 
-    // Then flush() the current state.
-    flush ();
+    // Wake up anyone who is waiting for space in the queue of samples
+    // so that they can notice that we are no longer accepting samples,
+    // and then wait for everyone who is still in the process of adding
+    // a sample to the queue.
+    queue_not_full.notify_all();
+    while (n_active_senders.load() > 0)
+      std::this_thread::yield();
+
+    // Then flush() the current state. In dedicated-thread mode, there is
+    // nothing left for the worker thread to do after that, so let it exit.
+    instrumented_flush ();
+    stop_worker_thread ();
   }
 
 
@@ -563,19 +1909,243 @@ namespace SampleFlow
   Consumer<InputType>::
   flush()
   {
-    std::lock_guard<std::mutex> parallel_lock (asynchronous_mode_mutex);
+    // Wait for all tasks that have been handed to the thread pool
+    // to finish. If we are on a worker thread of the pool ourselves,
+    // this helps with executing pending tasks while waiting.
+    background_tasks.wait();
+
+    // In dedicated-thread mode, wait for the worker thread to have
+    // emptied the queue and to be waiting for more samples.
+    if (worker_thread.joinable())
+      {
+        assert (std::this_thread::get_id() != worker_thread.get_id());
+
+        std::unique_lock<std::mutex> lock (worker_mutex);
+        worker_idle.wait (lock, [this]()
+        {
+          return (worker_waiting.load() && sample_queue->empty());
+        });
+      }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  enqueue_sample (QueuedSample &sample)
+  {
+    // Account for the memory the sample takes up before adding it to the
+    // queue, so that whoever removes it from the queue finds it accounted
+    // for. This may require waiting if the memory budget is used up.
+    sample.n_bytes = (Memory::memory_consumption (sample.sample)
+                      +
+                      Memory::memory_consumption (sample.aux_data));
+    if (reserve_queue_memory (sample.n_bytes) == false)
+      return false;
+    n_queued_bytes += sample.n_bytes;
+
+    if (push_to_queue (sample) == true)
+      return true;
+    else
+      {
+        release_queue_memory (sample.n_bytes);
+        return false;
+      }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  reserve_queue_memory (const std::size_t n_bytes)
+  {
+    if (Memory::try_reserve (n_bytes) == true)
+      return true;
+
+    // The budget is used up. Wait for other samples to be processed in the
+    // same way as we wait for space in the queue in push_to_queue(), but
+    // stop waiting once our own queue is empty (see the documentation of
+    // namespace Memory for why) -- or we are disconnected.
+    const auto stop_waiting = [this]()
+    {
+      return ((n_queued_bytes.load() == 0) || (n_connections.load() == 0));
+    };
+    if (ThreadPool *const pool = ThreadPool::current_pool())
+      {
+        while (stop_waiting () == false)
+          {
+            if (Memory::try_reserve (n_bytes) == true)
+              return true;
+            if (pool->run_pending_task() == false)
+              std::this_thread::yield();
+          }
+      }
+    else if (Memory::wait_and_reserve (n_bytes, stop_waiting) == true)
+      return true;
+
+    if (n_connections.load() == 0)
+      return false;
+
+    Memory::reserve (n_bytes);
+    return true;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  release_queue_memory (const std::size_t n_bytes)
+  {
+    n_queued_bytes -= n_bytes;
+    Memory::release (n_bytes);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  bool
+  Consumer<InputType>::
+  push_to_queue (QueuedSample &sample)
+  {
+    if (sample_queue->try_push (sample) == true)
+      return true;
+
+    // The queue is full. What we do now depends on the policy, except
+    // that objects with low priority never block:
+    const QueueFullPolicy policy
+      = (static_cast<Priority>(priority.load()) == Priority::low ?
+         QueueFullPolicy::drop_oldest :
+         static_cast<QueueFullPolicy>(queue_full_policy.load()));
+    switch (policy)
+      {
+        case QueueFullPolicy::drop_oldest:
+        {
+          // Throw away samples from the front until there is space. This
+          // typically takes only one iteration, but others may be adding
+          // samples at the same time.
+          while (sample_queue->try_push (sample) == false)
+            if (const std::optional<QueuedSample> dropped = sample_queue->try_pop())
+              {
+                release_queue_memory (dropped->n_bytes);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+                statistics.update ([](Instrumentation::ConsumerStatistics &s)
+                {
+                  ++s.n_dropped_samples;
+                });
+#endif
+              }
+          return true;
+        }
+
+        case QueueFullPolicy::spin_then_block:
+        {
+          for (unsigned int i=0; i<1024; ++i)
+            if (sample_queue->try_push (sample) == true)
+              return true;
+
+          // If we did not succeed, block just as below.
+        }
+        [[fallthrough]];
+
+        case QueueFullPolicy::block:
+        {
+          // If we are on a worker thread of a thread pool, we must
+          // not go to sleep: it may well be that the task that would
+          // make space in the queue is waiting to be executed by
+          // exactly this thread. So help with other tasks instead.
+          if (ThreadPool *const pool = ThreadPool::current_pool())
+            {
+              while (sample_queue->try_push (sample) == false)
+                {
+                  if (n_connections.load() == 0)
+                    return false;
+                  if (pool->run_pending_task() == false)
+                    std::this_thread::yield();
+                }
+              return true;
+            }
+
+          // Otherwise, sleep until process_queued_samples() has removed
+          // a sample from the queue. We register as waiting before
+          // trying again under the lock, so that either that function
+          // sees us as waiting and wakes us up, or we see the space it
+          // has made.
+          ++n_waiting_senders;
+          std::atomic_thread_fence (std::memory_order_seq_cst);
+
+          bool sample_was_added = false;
+          {
+            std::unique_lock<std::mutex> lock (asynchronous_mode_mutex);
+            queue_not_full.wait (lock, [&]()
+            {
+              sample_was_added = sample_queue->try_push (sample);
+              return (sample_was_added || (n_connections.load() == 0));
+            });
+          }
+
+          --n_waiting_senders;
+          return sample_was_added;
+        }
+
+        default:
+          assert (false);
+      }
+
+    return false;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  send_to_thread_pool (InputType &&sample,
+                       AuxiliaryData &&aux_data)
+  {
+    // Record that we are in the process of adding a sample so
+    // that disconnect_and_flush() can wait for us to finish. Only
+    // then check whether all connections have been severed since
+    // we actually got here (via a connection, of course). If so,
+    // we pretend that we never received the sample. This is the
+    // same as what happens in synchronous mode.
+    ++n_active_senders;
+    if (n_connections.load() == 0)
+      {
+        --n_active_senders;
+        return;
+      }
 
-    // For each std::future object, first check whether it
-    // has already been waited on. If that is the case, then just
-    // ignore it. If it hasn't, wait for its completion.
-    for (std::future<void> &future : background_tasks)
-      if (future.valid())
-        future.wait();
+    // Move the sample and aux data into the queue of samples to
+    // be processed. This does not require a lock unless the
+    // queue is full and we have to wait.
+    QueuedSample queue_element {Utilities::materialize (std::move(sample)), std::move(aux_data), 0};
+    if (enqueue_sample (queue_element) == true)
+      {
+        record_queue_depth ();
+
+        // Then make sure that there is a task on the thread pool
+        // that works on the queue. If there is not, create one. The
+        // `background_tasks` object keeps track of whether that task
+        // is still running, so that we can wait for it in flush().
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (processing_scheduled.exchange (true) == false)
+          background_tasks.run (*thread_pool,
+                                [this]()
+          {
+            process_queued_samples ();
+          },
+          static_cast<Priority>(priority.load()));
+      }
 
-    // At this point, we have waited for all futures, and because
-    // we are under the lock, no new futures can have been added. So
-    // just clear the whole array
-    background_tasks.clear();
+    --n_active_senders;
   }
 
 
@@ -584,17 +2154,244 @@ namespace SampleFlow
   requires (Concepts::is_valid_sampletype<InputType>)
   void
   Consumer<InputType>::
-  trim_background_queue()
+  send_to_worker_thread (InputType &&sample,
+                         AuxiliaryData &&aux_data)
   {
-    std::lock_guard<std::mutex> parallel_lock (asynchronous_mode_mutex);
+    ++n_active_senders;
+    if (n_connections.load() == 0)
+      {
+        --n_active_senders;
+        return;
+      }
+
+    QueuedSample queue_element {Utilities::materialize (std::move(sample)), std::move(aux_data), 0};
+    if (enqueue_sample (queue_element) == true)
+      {
+        record_queue_depth ();
+        wake_worker_thread ();
+      }
+
+    --n_active_senders;
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  record_calibration (const Instrumentation::Clock::time_point arrival,
+                      const std::chrono::nanoseconds consume_time,
+                      const types::sample_index n_samples)
+  {
+    const std::int64_t arrival_time
+      = std::chrono::duration_cast<std::chrono::nanoseconds>(arrival.time_since_epoch()).count();
+    std::int64_t no_arrival = 0;
+    first_calibration_arrival.compare_exchange_strong (no_arrival, arrival_time);
+    last_calibration_arrival = arrival_time;
+    calibration_consume_time += consume_time.count();
+
+    // Only the thread that completes the calibration chooses the mode:
+    const types::sample_index n_previous_samples = n_calibration_samples.fetch_add (n_samples);
+    if ((n_previous_samples >= adaptive_calibration_samples)
+        ||
+        (n_previous_samples + n_samples < adaptive_calibration_samples))
+      return;
+
+    // Compute the average time it took to process a sample, and the
+    // average time between the arrival of samples. The latter includes
+    // the former since we have processed samples synchronously, and
+    // we can only estimate it if samples arrived at different times:
+    const types::sample_index n_measured_samples = n_previous_samples + n_samples;
+    const double average_consume_time = 1. * calibration_consume_time.load() / n_measured_samples;
+    const double average_interval
+      = (n_measured_samples > 1
+         ?
+         1. * (last_calibration_arrival.load() - first_calibration_arrival.load()) / (n_measured_samples-1)
+         :
+         0.);
+
+    ParallelMode choice = ParallelMode::synchronous;
+    if ((average_consume_time > adaptive_minimal_consume_time.count())
+        &&
+        (average_consume_time > adaptive_consume_time_fraction * average_interval))
+      {
+        if ((static_cast<int>(supported_parallel_modes)
+             & static_cast<int>(ParallelMode::asynchronous)) != 0)
+          choice = ParallelMode::asynchronous;
+        else if ((static_cast<int>(supported_parallel_modes)
+                  & static_cast<int>(ParallelMode::dedicated_thread)) != 0)
+          {
+            start_worker_thread ();
+            choice = ParallelMode::dedicated_thread;
+          }
+      }
+
+    // Publish the choice only after the worker thread (if any) has been
+    // started, so that nobody adds samples to the queue before:
+    adaptive_choice.store (static_cast<int>(choice), std::memory_order_release);
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  consume_queued_samples ()
+  {
+    while (std::optional<QueuedSample> sample = sample_queue->try_pop())
+      {
+        // The sample no longer counts as queued once we start working on
+        // it. This also makes room for a filter to send its results on to
+        // an asynchronous consumer downstream of it.
+        release_queue_memory (sample->n_bytes);
+
+        // Wake up anyone waiting for space in the queue:
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (n_waiting_senders.load() > 0)
+          {
+            {
+              std::lock_guard<std::mutex> lock (asynchronous_mode_mutex);
+            }
+            queue_not_full.notify_all();
+          }
+
+        instrumented_consume (Utilities::view_of<InputType> (sample->sample),
+                              std::move(sample->aux_data));
+      }
+  }
+
 
-    // Drop elements on the front of the list that have completed (either because
-    // someone has waited for it, or because it has finished since someone last looked).
-    // If that is the case, then remove it from the list.
-    while ((background_tasks.size() > 0) &&
-           (background_tasks.front().wait_for(std::chrono::seconds(0))
-            == std::future_status::ready))
-      background_tasks.pop_front();
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  process_queued_samples ()
+  {
+    while (true)
+      {
+        consume_queued_samples ();
+
+        // The queue is empty. Say so, and then check whether someone has
+        // added a sample since we last looked: Whoever adds a sample after
+        // we have reset the flag will create a new task; but a sample
+        // that was added before would be left behind unless we continue.
+        processing_scheduled = false;
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (sample_queue->empty())
+          return;
+        if (processing_scheduled.exchange (true) == true)
+          return;
+      }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  run_worker_thread ()
+  {
+    while (true)
+      {
+        consume_queued_samples ();
+
+        // The queue is empty. Look for new samples for a little while
+        // before going to sleep, see WaitPolicy. We are not yet
+        // announcing that we are waiting, and so whoever adds a sample in
+        // the meantime does not try to wake us up.
+        const WaitPolicy wait_policy {n_wait_spins.load(), n_wait_yields.load()};
+        const auto sample_arrived = [this]()
+        {
+          return (sample_queue->empty() == false);
+        };
+        if (internal::spin_then_yield (wait_policy, sample_arrived))
+          continue;
+
+        // Nothing arrived. Announce that we are going to sleep, and
+        // let flush() know that we are done with everything we had. Then
+        // only go to sleep if there is indeed nothing in the queue:
+        // Whoever adds a sample after we have set 'worker_waiting' will
+        // wake us up; but a sample that was added before would
+        // otherwise be left behind.
+        std::unique_lock<std::mutex> lock (worker_mutex);
+        worker_waiting = true;
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        worker_idle.notify_all();
+
+        worker_wakeup.wait (lock, [this]()
+        {
+          return (stop_worker || !sample_queue->empty());
+        });
+        worker_waiting = false;
+
+        if (stop_worker && sample_queue->empty())
+          return;
+      }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  wake_worker_thread ()
+  {
+    // Only acquire the lock if the worker thread may be sleeping. Acquiring
+    // (and immediately releasing) the lock ensures that the worker is either
+    // already waiting for the notification, or has not yet checked whether
+    // the queue is empty. While the worker spins before it goes to sleep
+    // (see set_wait_policy()), it has not yet set the flag, and so threads
+    // that add samples in the meantime do not need to touch the mutex.
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (worker_waiting.load() == true)
+      {
+        {
+          std::lock_guard<std::mutex> lock (worker_mutex);
+        }
+        worker_wakeup.notify_one();
+      }
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  start_worker_thread ()
+  {
+    if (worker_thread.joinable() == true)
+      return;
+
+    stop_worker = false;
+    worker_thread = std::thread ([this]()
+    {
+      run_worker_thread ();
+    });
+  }
+
+
+
+  template <typename InputType>
+  requires (Concepts::is_valid_sampletype<InputType>)
+  void
+  Consumer<InputType>::
+  stop_worker_thread ()
+  {
+    if (worker_thread.joinable() == false)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock (worker_mutex);
+      stop_worker = true;
+    }
+    worker_wakeup.notify_one();
+    worker_thread.join();
   }
 
 
@@ -18,8 +18,13 @@
 
 #include <sampleflow/auxiliary_data.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/serialization.h>
 #include <sampleflow/types.h>
+#include <atomic>
+#include <cassert>
+#include <cmath>
 #include <mutex>
+#include <span>
 #include <valarray>
 
 // Import the implementation of the things for this header file:
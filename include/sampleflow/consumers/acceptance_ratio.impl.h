@@ -23,18 +23,39 @@ namespace SampleFlow
      * obtained by calling the get() function.
      *
      * The concept of acceptance/rejection of a sample is explained in the documentation of
-     * the Producers::MetropolisHastings class. This calculation uses the
-     * assumption that every *accepted* sample in the sampling algorithm is *different* from last one.
+     * the Producers::MetropolisHastings class. Most samplers in this library
+     * record in the auxiliary data of each sample whether it is a repetition
+     * of the previous sample (see AuxiliaryData::sample_is_repeated), and
+     * this class then counts every sample that is not a repetition as
+     * accepted. For samples that do not carry this information, the class
+     * falls back to comparing each sample with the previous one, using the
+     * assumption that every *accepted* sample in the sampling algorithm is
+     * *different* from last one. In either case, the first sample this
+     * class sees always counts as accepted. The get() function then
+     * returns the number of accepted samples divided by the overall number
+     * of samples. A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count counts as one sample followed by as
+     * many rejected ones as necessary to make up this number.
      *
-     * With every new sample, this algorithm checks if it differs from the last one. If it differs, it adds
-     * one to the counter that keeps track of the number of accepted samples. The get() function
-     * then returns the number of accepted samples divided by the overall number of samples.
+     * Adaptive samplers often need to know the acceptance rate of the
+     * recent past, rather than of all samples. For this purpose, the
+     * class also computes an exponentially weighted moving average
+     * $\bar a_n = \bar a_{n-1} + \alpha_n (a_n - \bar a_{n-1})$ of the
+     * indicators $a_n\in\{0,1\}$ of whether sample $n$ was accepted, with
+     * $\alpha_n = 1/\min(n,L)$ where $L$ is a window length given to the
+     * constructor. For the first $L$ samples, this is the plain acceptance
+     * ratio; afterwards, the weight of past samples decays exponentially
+     * over roughly $L$ samples. This average can be obtained using
+     * get_recent().
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. The counters are atomic variables, and so get() and
+     * get_recent() can be called at any time without waiting for samples
+     * to be processed. A mutex is only used when samples need to be
+     * compared with the previous sample.
      *
      * @tparam InputType The C++ type used for the samples $x_k$. All this class requires of
      *    the data type is that the comparison operator between two objects returns a `bool`. This
@@ -59,8 +80,11 @@ namespace SampleFlow
          * This class does not support asynchronous processing of samples,
          * and consequently calls the base class constructor with
          * ParallelMode::synchronous as argument.
+         *
+         * @param[in] window_length The window length $L$ of the moving
+         *   average computed by get_recent(). Must be at least one.
          */
-        AcceptanceRatio();
+        AcceptanceRatio (const types::sample_index window_length = 100);
 
         /**
          * Destructor. This function also makes sure that all samples this
@@ -76,14 +100,25 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class uses the entries with keys AuxiliaryData::sample_is_repeated
+         *   and AuxiliaryData::repetition_count, if present, and ignores all
+         *   other data.
          */
         virtual
         void
         consume (InputType     sample,
                  AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::sample_is_repeated and
+         * AuxiliaryData::repetition_count.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
         /**
          * A function that returns the ratio computed from the samples
          * seen so far. If no samples have been processed so far, then a
@@ -93,10 +128,54 @@ namespace SampleFlow
          */
         double get () const;
 
+        /**
+         * Return the moving average of the acceptance rate discussed in the
+         * documentation of this class. If no samples have been processed
+         * so far, then a zero will be returned.
+         */
+        double get_recent () const;
+
+        /**
+         * Append the numbers of samples and accepted samples seen so far,
+         * along with the last sample, to the given buffer. See the section
+         * on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers of samples and of accepted samples counted by
+         * another object to the ones of the current object. This is meant for
+         * objects that have seen samples of independent chains: The first
+         * sample of a chain always counts as accepted, and the next sample
+         * the current object receives is compared against the last sample
+         * the current object has seen (or that of `other` if the current
+         * object has not seen any samples yet). The moving average returned
+         * by get_recent() describes the recent past of the current object's
+         * chain and is left unchanged, unless the current object has not
+         * seen any samples yet.
+         */
+        void
+        merge (const AcceptanceRatio &other);
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * The window length of the moving average.
+         */
+        const types::sample_index window_length;
+
+        /**
+         * A mutex used to lock access to `previous_sample` and
+         * `have_previous_sample` when running on multiple threads.
          */
         mutable std::mutex mutex;
 
@@ -104,17 +183,35 @@ namespace SampleFlow
          * The current value of accepted values as described in the introduction
          * of this class.
          */
-        types::sample_index n_accepted_samples;
+        std::atomic<types::sample_index> n_accepted_samples;
 
         /**
          * The number of samples processed so far.
          */
-        types::sample_index n_samples;
+        std::atomic<types::sample_index> n_samples;
+
+        /**
+         * The moving average of the acceptance rate.
+         */
+        std::atomic<double> recent_acceptance_rate;
 
         /**
-         * Previous sample
+         * The previous sample, for samples that need to be compared with
+         * it, and whether this variable has been set.
          */
         InputType previous_sample;
+        bool      have_previous_sample;
+
+        /**
+         * Update the moving average of the acceptance rate for a sample that
+         * was accepted or not, and that is followed by `n_repetitions-1`
+         * rejected samples. `n_previous_samples` is the number of samples
+         * processed before.
+         */
+        void
+        update_recent_acceptance_rate (const bool                accepted,
+                                       const types::sample_index n_previous_samples,
+                                       const types::sample_index n_repetitions);
     };
 
 
@@ -123,12 +220,17 @@ namespace SampleFlow
      */
     template <typename InputType>
     AcceptanceRatio<InputType>::
-    AcceptanceRatio ()
+    AcceptanceRatio (const types::sample_index window_length)
       :
       Consumer<InputType>(ParallelMode::synchronous),
+      window_length (window_length),
+      n_accepted_samples (0),
       n_samples (0),
-      n_accepted_samples (0)
-    {}
+      recent_acceptance_rate (0),
+      have_previous_sample (false)
+    {
+      assert (window_length >= 1);
+    }
 
 
 
@@ -190,37 +292,95 @@ namespace SampleFlow
     template <typename InputType>
     void
     AcceptanceRatio<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    consume (InputType sample, AuxiliaryData aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
 
-      // If this is the first sample we see, naturally, this sample is accepted.
-      if (n_samples == 0)
-        {
-          n_samples          = 1;
-          n_accepted_samples = 1;
-          previous_sample    = sample;
-        }
+      bool accepted;
+      if (const bool *is_repeated = aux_data.get_if<bool> (AuxiliaryData::sample_is_repeated))
+        accepted = !*is_repeated;
       else
-        // Check if new sample is not equal to previous sample and
-        // if that is true add one to accept.
         {
-          if (internal::AcceptanceRatio::is_equal(sample, previous_sample))
-            {
-              // The two samples are equal. That is, we have not received
-              // a new "accepted" sample and don't need to update either
-              // the stored sample or the number of accepted samples.
-              ++n_samples;
-            }
-          else
+          // The producer does not tell us, so check whether the new sample
+          // differs from the previous one. If so, store it for the next
+          // comparison.
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+          accepted = ((have_previous_sample == false)
+                      ||
+                      !internal::AcceptanceRatio::is_equal(sample, previous_sample));
+          if (accepted)
             {
-              // The new sample is different. Update the counter and store
-              // the new sample.
-              ++n_accepted_samples;
-              previous_sample = sample;
-              ++n_samples;
+              previous_sample      = std::move(sample);
+              have_previous_sample = true;
             }
         }
+
+      // If this is the first sample we see, naturally, this sample is
+      // accepted.
+      const types::sample_index n_previous_samples
+        = n_samples.fetch_add (n_repetitions, std::memory_order_relaxed);
+      if (n_previous_samples == 0)
+        accepted = true;
+
+      if (accepted)
+        n_accepted_samples.fetch_add (1, std::memory_order_relaxed);
+
+      update_recent_acceptance_rate (accepted, n_previous_samples, n_repetitions);
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    AcceptanceRatio<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::sample_is_repeated,
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    void
+    AcceptanceRatio<InputType>::
+    update_recent_acceptance_rate (const bool                accepted,
+                                   const types::sample_index n_previous_samples,
+                                   const types::sample_index n_repetitions)
+    {
+      const double a = (accepted ? 1. : 0.);
+
+      // Compute the new average from the old one. If all of the samples
+      // fall into the first 'window_length' ones, the average is the plain
+      // mean of the indicators, and we can add them all at once. Otherwise,
+      // we use the constant weight 1/L for all of them; for the one sample
+      // that straddles the end of the first window, this is only an
+      // approximation.
+      const auto new_rate = [&](const double old_rate)
+      {
+        const types::sample_index n = n_previous_samples + n_repetitions;
+        if (n <= window_length)
+          return (old_rate * n_previous_samples + a) / n;
+        else
+          {
+            const double alpha = 1. / window_length;
+            return (old_rate + alpha * (a - old_rate))
+                   * std::pow (1-alpha, static_cast<double>(n_repetitions-1));
+          }
+      };
+
+      // Other threads might update the average concurrently, so loop until
+      // nobody else has changed it between reading and writing it:
+      double old_rate = recent_acceptance_rate.load (std::memory_order_relaxed);
+      while (!recent_acceptance_rate.compare_exchange_weak (old_rate, new_rate(old_rate),
+                                                            std::memory_order_relaxed))
+        ;
     }
 
 
@@ -230,14 +390,95 @@ namespace SampleFlow
     AcceptanceRatio<InputType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
-
-      if (n_samples > 0)
-        return (static_cast<double>(n_accepted_samples)
+      const types::sample_index n = n_samples.load (std::memory_order_relaxed);
+      if (n > 0)
+        return (static_cast<double>(n_accepted_samples.load (std::memory_order_relaxed))
                 /
-                static_cast<double>(n_samples));
+                static_cast<double>(n));
       else
         return 0.0;
     }
+
+
+
+    template <typename InputType>
+    double
+    AcceptanceRatio<InputType>::
+    get_recent () const
+    {
+      return recent_acceptance_rate.load (std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    void
+    AcceptanceRatio<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      Serialization::write (buffer, n_accepted_samples.load());
+      Serialization::write (buffer, n_samples.load());
+      Serialization::write (buffer, recent_acceptance_rate.load());
+      Serialization::write (buffer, have_previous_sample);
+      Serialization::write (buffer, previous_sample);
+    }
+
+
+
+    template <typename InputType>
+    void
+    AcceptanceRatio<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      types::sample_index saved_n_accepted_samples;
+      types::sample_index saved_n_samples;
+      double              saved_recent_acceptance_rate;
+      Serialization::read (buffer, saved_n_accepted_samples);
+      Serialization::read (buffer, saved_n_samples);
+      Serialization::read (buffer, saved_recent_acceptance_rate);
+      Serialization::read (buffer, have_previous_sample);
+      Serialization::read (buffer, previous_sample);
+
+      n_accepted_samples     = saved_n_accepted_samples;
+      n_samples              = saved_n_samples;
+      recent_acceptance_rate = saved_recent_acceptance_rate;
+    }
+
+
+
+    template <typename InputType>
+    void
+    AcceptanceRatio<InputType>::
+    merge (const AcceptanceRatio &other)
+    {
+      InputType other_previous_sample;
+      bool      other_have_previous_sample;
+      {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        other_previous_sample      = other.previous_sample;
+        other_have_previous_sample = other.have_previous_sample;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (have_previous_sample == false)
+        {
+          previous_sample      = std::move(other_previous_sample);
+          have_previous_sample = other_have_previous_sample;
+        }
+
+      // The moving average only reflects the recent past of one chain, and
+      // there is no meaningful way to combine those of independent chains.
+      // Only adopt the other object's average if we have none of our own:
+      if (n_samples.load() == 0)
+        recent_acceptance_rate = other.recent_acceptance_rate.load();
+
+      n_accepted_samples += other.n_accepted_samples.load();
+      n_samples          += other.n_samples.load();
+    }
+
   }
 }
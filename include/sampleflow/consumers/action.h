@@ -17,7 +17,14 @@
 #define SAMPLEFLOW_CONSUMERS_ACTION_H
 
 #include <sampleflow/consumer.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumers/action.impl.h>
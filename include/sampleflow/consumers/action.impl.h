@@ -57,6 +57,19 @@ namespace SampleFlow
      * named `samples.txt`. The lambda function "captures" the `output_file`
      * variable declared in the previous line.
      *
+     * By default, the action is stored as a `std::function` object, which
+     * means that every sample goes through an indirect call that the
+     * compiler cannot inline. If the action is cheap compared to this
+     * call, it is better to let the class store the function object itself
+     * by giving its type as the second template argument or, more
+     * conveniently, by letting the compiler deduce both template arguments:
+     * @code
+     *   Consumers::Action action ([&sum](const double sample, AuxiliaryData)
+     *                             { sum += sample; });
+     * @endcode
+     * This requires that the action is not a generic lambda, so that the
+     * type of samples can be deduced from the type of its first argument.
+     *
      *
      * ### Differences to other consumers ###
      *
@@ -83,6 +96,41 @@ namespace SampleFlow
      * to execute some action every $n$th sample.
      *
      *
+     * ### Batching samples ###
+     *
+     * If the action is expensive to call compared to the work it does per
+     * sample -- say, it writes samples into a database or copies them to a
+     * GPU -- then it is better to hand it many samples at once. For this
+     * case, the class has a second constructor that takes a function that
+     * receives a whole batch of samples along with their auxiliary data:
+     * @code
+     *   const auto batch_function =
+     *     [&database](const std::vector<SampleType>    &samples,
+     *                 const std::vector<AuxiliaryData> &aux_data)
+     *     { database.insert (samples); };
+     *   Consumers::Action<SampleType> action (batch_function, 10000,
+     *                                         std::chrono::seconds(1));
+     *   action.connect_to_producer (producer);
+     * @endcode
+     * Here, consume() only appends incoming samples to a buffer with room
+     * for 10,000 samples. Once the buffer is full, it is handed to a
+     * separate thread that calls `batch_function` on it, while consume()
+     * starts filling the next buffer. The buffers are reused once the
+     * function has returned, so that their memory is only allocated
+     * once. The optional third argument sets a time limit: If the first
+     * sample in the current buffer has been waiting for longer than this
+     * much time, then the buffer is handed over even though it is not
+     * full. This is useful if samples arrive slowly but should not sit in
+     * the buffer for too long.
+     *
+     * The batch function is always called on the same thread, one batch at
+     * a time, and batches are processed in the order in which they were
+     * filled. If the batch function falls behind by more than two full
+     * buffers, consume() waits for it to catch up.
+     * flush() (and consequently the destructor) hands the partially filled
+     * buffer to the batch function and waits until all batches have been
+     * processed.
+     *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
@@ -92,11 +140,21 @@ namespace SampleFlow
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$.
+     * @tparam ActionFunction The type of the action function. It needs to
+     *   be callable with a sample and its auxiliary data.
      */
-    template <typename InputType>
+    template <typename InputType,
+              typename ActionFunction = std::function<void (InputType, AuxiliaryData)>>
     class Action : public Consumer<InputType>
     {
       public:
+        /**
+         * Whether the action is stored as a `std::function` object, i.e.,
+         * whether the second template argument has its default value.
+         */
+        static constexpr bool is_type_erased
+          = std::is_same_v<ActionFunction, std::function<void (InputType, AuxiliaryData)>>;
+
         /**
          * Constructor. Take the action (a function object) as argument.
          *
@@ -111,10 +169,36 @@ namespace SampleFlow
          * a separate thread. See ParallelMode for more information. Whether this
          * is possible or not depends on what the `action` function does.
          */
-        Action (const std::function<void (InputType, AuxiliaryData)> &action,
+        Action (const ActionFunction &action,
                 const bool allow_concurrent_action = false,
                 const ParallelMode supported_parallel_modes = ParallelMode::synchronous);
 
+        /**
+         * Constructor for the batching mode described in the documentation
+         * of this class.
+         *
+         * @param[in] batch_action The function that is called with a batch
+         *   of samples and their auxiliary data. The two vectors passed to it
+         *   have the same length. Calls to this function never overlap.
+         * @param[in] batch_size The number of samples collected before the
+         *   batch is handed to `batch_action`. Must be at least one.
+         * @param[in] max_delay The maximal time the first sample of a batch
+         *   waits before the batch is handed to `batch_action`, whether it
+         *   is full or not. The default means that there is no time limit.
+         * @param[in] supported_parallel_modes As for the previous
+         *   constructor.
+         *
+         * This constructor is only available if the class stores its action
+         * as a `std::function` object.
+         */
+        Action (const std::function<void (const std::vector<InputType> &,
+                                          const std::vector<AuxiliaryData> &)> &batch_action,
+                const std::size_t                                  batch_size,
+                const std::chrono::steady_clock::duration          max_delay
+                = std::chrono::steady_clock::duration::max(),
+                const ParallelMode supported_parallel_modes = ParallelMode::synchronous)
+        requires (is_type_erased);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -124,65 +208,343 @@ namespace SampleFlow
         virtual ~Action ();
 
         /**
-         * Process one sample by forgetting about the previously last sample
-         * and instead storing this one for later access using the get()
-         * function.
+         * Process one sample by calling the action function on it or, in
+         * batching mode, by adding it to the current batch.
          *
          * @param[in] sample The sample to process.
-         * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         * @param[in] aux_data Auxiliary data about this sample. It is passed
+         *   on to the action function.
          */
         virtual
         void
         consume (InputType sample, AuxiliaryData aux_data) override;
 
+        /**
+         * Finish processing all samples this object has received, as
+         * documented in Consumer::flush(). In batching mode, this also hands
+         * the current, partially filled batch to the batch function and
+         * waits until all batches have been processed.
+         */
+        virtual
+        void
+        flush () override;
+
       private:
         /**
          * A mutex used to synchronize the call to the action function, if so
-         * desired by the caller.
+         * desired by the caller. In batching mode, it guards the member
+         * variables that describe the batches.
          */
         mutable std::mutex mutex;
 
         const bool allow_concurrent_action;
 
-        const std::function<void (InputType, AuxiliaryData)> action_function;
+        const ActionFunction action_function;
+
+        /**
+         * For batching mode, the batch function, the size of batches, and the
+         * time limit for the first sample of a batch, as passed to the
+         * constructor.
+         */
+        const std::function<void (const std::vector<InputType> &,
+                                  const std::vector<AuxiliaryData> &)> batch_function;
+        const std::size_t                                             batch_size;
+        const std::chrono::steady_clock::duration                     max_delay;
+
+        /**
+         * A structure that holds the samples of a batch and their auxiliary
+         * data.
+         */
+        struct Batch
+        {
+          std::vector<InputType>     samples;
+          std::vector<AuxiliaryData> aux_data;
+        };
+
+        /**
+         * The batch consume() currently adds samples to, and the time by
+         * which it has to be handed over if there is a time limit.
+         */
+        Batch                                 current_batch;
+        std::chrono::steady_clock::time_point current_batch_deadline;
+
+        /**
+         * Batches that are waiting to be processed, and batches that have
+         * been processed and whose memory can be reused.
+         */
+        std::deque<Batch>  full_batches;
+        std::vector<Batch> spare_batches;
+
+        /**
+         * Whether the batch thread is currently processing a batch, and
+         * whether the destructor has asked the batch thread to stop.
+         */
+        bool is_processing;
+        bool shutting_down;
+
+        /**
+         * A condition variable used together with `mutex` to signal changes
+         * of the member variables above.
+         */
+        std::condition_variable batch_state_changed;
+
+        /**
+         * The thread that calls the batch function. In non-batching mode, no
+         * thread is started.
+         */
+        std::thread batch_thread;
+
+        /**
+         * The number of full batches that may wait to be processed before
+         * consume() waits for the batch thread.
+         */
+        static constexpr std::size_t max_pending_batches = 2;
+
+        /**
+         * Move the current batch to the list of full batches, and start a new
+         * one. The caller needs to hold `mutex`.
+         */
+        void
+        hand_off_batch ();
+
+        /**
+         * The function run by the batch thread.
+         */
+        void
+        batch_loop ();
     };
 
 
-    template <typename InputType>
-    Action<InputType>::
-    Action (const std::function<void (InputType, AuxiliaryData)> &action,
+    /**
+     * A deduction guide that allows creating an Action object from just a
+     * (non-generic) action function, whose type is then stored rather than
+     * converted to `std::function`. Batch functions are not covered by this
+     * guide; for these, the type of samples needs to be given explicitly.
+     */
+    template <typename ActionFunction, typename... Args>
+    requires (std::is_invocable_v<ActionFunction,
+              types::FirstArgumentType<ActionFunction>,
+              AuxiliaryData>)
+    Action (ActionFunction, Args...)
+    -> Action<types::FirstArgumentType<ActionFunction>, ActionFunction>;
+
+
+    template <typename InputType, typename ActionFunction>
+    Action<InputType,ActionFunction>::
+    Action (const ActionFunction &action,
             const bool allow_concurrent_action,
             const ParallelMode supported_parallel_modes)
       :
       Consumer<InputType>(supported_parallel_modes),
       allow_concurrent_action (allow_concurrent_action),
-      action_function (action)
+      action_function (action),
+      batch_size (0),
+      max_delay (std::chrono::steady_clock::duration::max()),
+      is_processing (false),
+      shutting_down (false)
     {}
 
 
 
-    template <typename InputType>
-    Action<InputType>::
+    template <typename InputType, typename ActionFunction>
+    Action<InputType,ActionFunction>::
+    Action (const std::function<void (const std::vector<InputType> &,
+                                      const std::vector<AuxiliaryData> &)> &batch_action,
+            const std::size_t                                  batch_size,
+            const std::chrono::steady_clock::duration          max_delay,
+            const ParallelMode supported_parallel_modes)
+    requires (is_type_erased)
+      :
+      Consumer<InputType>(supported_parallel_modes),
+      allow_concurrent_action (false),
+      batch_function (batch_action),
+      batch_size (batch_size),
+      max_delay (max_delay),
+      is_processing (false),
+      shutting_down (false)
+    {
+      assert (batch_size >= 1);
+      assert (max_delay > std::chrono::steady_clock::duration::zero());
+
+      current_batch.samples.reserve (batch_size);
+      current_batch.aux_data.reserve (batch_size);
+
+      batch_thread = std::thread ([this]()
+      {
+        batch_loop ();
+      });
+    }
+
+
+
+    template <typename InputType, typename ActionFunction>
+    Action<InputType,ActionFunction>::
     ~Action ()
     {
       this->disconnect_and_flush();
+
+      if (batch_thread.joinable())
+        {
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            shutting_down = true;
+          }
+          batch_state_changed.notify_all();
+
+          batch_thread.join();
+        }
     }
 
 
-    template <typename InputType>
+    template <typename InputType, typename ActionFunction>
     void
-    Action<InputType>::
+    Action<InputType,ActionFunction>::
     consume (InputType sample, AuxiliaryData aux_data)
     {
-      if (allow_concurrent_action)
+      if (batch_function)
+        {
+          // The batch thread accesses the current batch as well, so we have
+          // to lock even if samples only come from one thread:
+          std::unique_lock<std::mutex> lock (mutex);
+
+          // If this is the first sample of a batch and there is a time
+          // limit, tell the batch thread when it is up:
+          if (current_batch.samples.empty()
+              &&
+              (max_delay != std::chrono::steady_clock::duration::max()))
+            {
+              current_batch_deadline = std::chrono::steady_clock::now() + max_delay;
+              batch_state_changed.notify_all();
+            }
+
+          current_batch.samples.emplace_back (std::move(sample));
+          current_batch.aux_data.emplace_back (std::move(aux_data));
+
+          // If the batch is full, hand it off and, if the batch thread
+          // has fallen behind, wait for it to catch up:
+          if (current_batch.samples.size() >= batch_size)
+            {
+              hand_off_batch ();
+              batch_state_changed.notify_all();
+              batch_state_changed.wait (lock, [this]()
+              {
+                return (full_batches.size() <= max_pending_batches);
+              });
+            }
+        }
+      else if (allow_concurrent_action)
         action_function (std::move(sample), std::move(aux_data));
       else
         {
-          std::lock_guard<std::mutex> lock(mutex);
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
           action_function (std::move(sample), std::move(aux_data));
         }
     }
+
+
+
+    template <typename InputType, typename ActionFunction>
+    void
+    Action<InputType,ActionFunction>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+
+      if (batch_function)
+        {
+          std::unique_lock<std::mutex> lock (mutex);
+          if (current_batch.samples.size() > 0)
+            {
+              hand_off_batch ();
+              batch_state_changed.notify_all();
+            }
+
+          batch_state_changed.wait (lock, [this]()
+          {
+            return (full_batches.empty() && (is_processing == false));
+          });
+        }
+    }
+
+
+
+    template <typename InputType, typename ActionFunction>
+    void
+    Action<InputType,ActionFunction>::
+    hand_off_batch ()
+    {
+      full_batches.emplace_back (std::move(current_batch));
+
+      // Reuse the memory of a batch that has already been processed, if
+      // there is one:
+      if (spare_batches.size() > 0)
+        {
+          current_batch = std::move(spare_batches.back());
+          spare_batches.pop_back();
+        }
+      else
+        current_batch = Batch();
+
+      current_batch.samples.reserve (batch_size);
+      current_batch.aux_data.reserve (batch_size);
+    }
+
+
+
+    template <typename InputType, typename ActionFunction>
+    void
+    Action<InputType,ActionFunction>::
+    batch_loop ()
+    {
+      while (true)
+        {
+          Batch batch;
+          {
+            // Wait until there is a full batch, or until the time limit for
+            // the current batch has passed, or until we are asked to shut
+            // down and there is nothing left to do. Any change to these
+            // conditions (including a new deadline) is signaled via the
+            // condition variable, so we re-check them every time we
+            // wake up.
+            std::unique_lock<std::mutex> lock (mutex);
+            while (full_batches.empty())
+              {
+                if (shutting_down)
+                  return;
+
+                if ((current_batch.samples.size() > 0)
+                    &&
+                    (max_delay != std::chrono::steady_clock::duration::max()))
+                  {
+                    if (std::chrono::steady_clock::now() >= current_batch_deadline)
+                      {
+                        hand_off_batch ();
+                        break;
+                      }
+                    batch_state_changed.wait_until (lock, current_batch_deadline);
+                  }
+                else
+                  batch_state_changed.wait (lock);
+              }
+
+            batch = std::move(full_batches.front());
+            full_batches.pop_front();
+            is_processing = true;
+          }
+          // Let consume() know that there is space again:
+          batch_state_changed.notify_all();
+
+          batch_function (batch.samples, batch.aux_data);
+          batch.samples.clear();
+          batch.aux_data.clear();
+
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            is_processing = false;
+            spare_batches.emplace_back (std::move(batch));
+          }
+          batch_state_changed.notify_all();
+        }
+    }
   }
 }
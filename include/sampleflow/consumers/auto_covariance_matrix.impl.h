@@ -211,6 +211,22 @@ namespace SampleFlow
      *     \right]
      * @f}
      *
+     * In practice, the class does not store $\alpha_n(l)$, $\beta_n(l)$,
+     * and $\eta_n(l)$ as defined above, but the running averages
+     * $\frac{n-l-1}{n-l}\alpha_n(l)$, etc., over the $n-l$ pairs of samples
+     * with lag $l$, and get() multiplies by the factor $\frac{n-l}{n-l-1}$.
+     *
+     *
+     * ### Repeated and weighted samples ###
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive samples
+     * of the chain as this entry says, and samples may carry weights (see
+     * AuxiliaryData::sample_weight). The class treats both in the same way
+     * as the AutoCovarianceTrace class, whose documentation discusses the
+     * details.
+     *
+     *
      * ### Making computing this operation less expensive ###
      *
      * The computations made by this class are quite expensive,
@@ -219,11 +235,96 @@ namespace SampleFlow
      * cheaper also apply to the current class.
      *
      *
+     * ### Restricting the computations to selected components and lags ###
+     *
+     * For samples with $d$ components and lags up to $k$, this class
+     * stores $k+1$ matrices of size $d\times d$, and every sample updates
+     * all of them. For large $d$ and $k$, both quickly become prohibitive:
+     * For $d=1000$ and $k=10^4$, the matrices alone would take 80 GB. The
+     * constructor that takes a Selection object allows restricting the
+     * computations in three ways:
+     * - To the components of the samples listed in
+     *   Selection::components. The class then computes the autocovariance
+     *   matrices of the vectors that consist only of these components.
+     * - To the lags listed in Selection::lags. Autocovariances typically
+     *   decay smoothly with the lag, and for long lags, it is often
+     *   sufficient to compute them for lags that grow geometrically, as
+     *   returned by geometric_lags(). The memory for the matrices and the
+     *   work per sample is then proportional to the number of lags listed,
+     *   rather than to the largest lag. (The class nevertheless has to
+     *   store the most recent $k+1$ samples, or rather their selected
+     *   components, which for the example above takes 80 MB.)
+     * - To the symmetric parts $\frac 12 (\gamma(l)+\gamma(l)^T)$ of the
+     *   matrices (Output::symmetric), which are what is needed, for
+     *   example, to estimate the asymptotic covariance matrix of a chain
+     *   $\gamma(0)+\sum_{l\ge 1} (\gamma(l)+\gamma(l)^T)$. Only the
+     *   lower triangles are updated, which halves the work per sample.
+     *   Or to only the diagonals of the matrices (Output::diagonal), i.e.,
+     *   the autocovariances of each component with itself, which takes
+     *   $O(d)$ rather than $O(d^2)$ memory and work per lag.
+     *
+     * Internally, the class always stores the selected components of
+     * samples and of the running averages in Eigen vectors, which makes
+     * the updates vectorizable regardless of the sample type.
+     *
+     *
+     * ### Lazy evaluation ###
+     *
+     * If the object is created with Evaluation::lazy as argument to the
+     * constructor, then processing a sample only appends its selected
+     * components, repetition count, and weight to a BlockedSampleBuffer,
+     * and the updates described above are deferred to the time get() is
+     * called. Since the running averages for different lags do not depend
+     * on each other, get() then computes them on separate tasks, one per
+     * lag, on ThreadPool::default_pool(): Each task goes through all
+     * buffered samples in order and updates the running averages of its
+     * lag (along with its own copy of the running mean and of the window
+     * of the most recent samples). The results are the same as in
+     * Evaluation::eager mode up to round-off.
+     *
+     * This takes the substantial per-sample cost of this class off the
+     * threads that generate samples entirely, and uses as many processor
+     * cores as there are lags once the results are needed. On the other
+     * hand, the memory needed grows linearly with the number of samples,
+     * and each call to get() processes all samples received so far. save()
+     * and merge() also need to process the buffered samples, and save the
+     * same state as in eager mode.
+     *
+     *
+     * ### Sharing previous samples with other consumers ###
+     *
+     * The most recent $k+1$ samples are stored in a LagWindow object. As
+     * discussed in the documentation of AutoCovarianceTrace, this object can
+     * be shared with other consumers connected to the same producer, so that
+     * each sample is copied and stored only once. This requires that the
+     * object uses all components of the samples (since otherwise, what it
+     * needs to store differs from what other consumers need) and evaluates
+     * eagerly.
+     *
+     *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Because the result depends on the order in which samples
+     * are processed, the class supports ParallelMode::dedicated_thread but
+     * not ParallelMode::asynchronous. The former moves the work of this
+     * class off the thread on which samples are generated.
+     *
+     * The state of the computation is kept in a CopyOnWrite object. As a
+     * consequence, calling get() while samples are being processed on
+     * other threads does not block these threads for the (substantial)
+     * time it takes to compute the autocovariances: get() only takes a
+     * snapshot of the current state and then does its work without
+     * holding a lock. If the matrices are large, or there are many lags,
+     * get() computes the matrices for different lags in parallel on
+     * ThreadPool::default_pool().
+     *
+     * For large matrices and many lags, processing a single sample in
+     * eager mode also takes a lot of work, which is independent between
+     * different lags. If there is enough of it, the lags are split into
+     * blocks of successive lags that are updated in parallel on
+     * ThreadPool::default_pool(), as in the AutoCovarianceTrace class.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$. In
@@ -246,18 +347,95 @@ namespace SampleFlow
          */
         using value_type = std::vector<Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>>;
 
+        /**
+         * An enum that describes which part of the matrices $\gamma(l)$
+         * is computed. See the section on restricting the computations in
+         * the documentation of this class.
+         */
+        enum class Output
+        {
+          /**
+           * Compute the full matrices $\gamma(l)$.
+           */
+          full,
+
+          /**
+           * Compute the symmetric parts $\frac 12 (\gamma(l)+\gamma(l)^T)$.
+           */
+          symmetric,
+
+          /**
+           * Compute only the diagonals of the matrices $\gamma(l)$.
+           */
+          diagonal
+        };
+
+        /**
+         * A structure that describes which parts of the autocovariance
+         * matrices are to be computed. See the section on restricting the
+         * computations in the documentation of this class.
+         */
+        struct Selection
+        {
+          /**
+           * The indices of the components of the samples to consider. If
+           * this list is empty (the default), all components are used.
+           */
+          std::vector<unsigned int> components;
+
+          /**
+           * The lags $l$ for which to compute $\gamma(l)$. This list must
+           * not be empty; it is sorted and duplicates are removed by the
+           * constructor. The geometric_lags() function provides a list
+           * that is commonly useful.
+           */
+          std::vector<unsigned int> lags;
+
+          /**
+           * Which part of the matrices to compute.
+           */
+          Output output = Output::full;
+        };
+
         /**
          * Constructor.
          *
-         * This class does not support asynchronous processing of samples,
-         * and consequently calls the base class constructor with
-         * ParallelMode::synchronous as argument.
+         * This class needs to process samples in the order in which they
+         * were generated, and consequently does not support asynchronous
+         * processing of samples on a thread pool. It can, however, work on
+         * its own thread, and so calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::dedicated_thread` as
+         * argument.
          *
          * @param[in] lag_length A number that indicates how many autocovariance
          *   values we want to calculate, i.e., how far back in the past we
          *   want to check how correlated each sample is.
+         * @param[in] evaluation Whether the autocovariances are updated with
+         *   every sample, or computed from all samples only when get() is
+         *   called. See the section on lazy evaluation in the documentation
+         *   of this class.
+         */
+        AutoCovarianceMatrix(const unsigned int lag_length,
+                             const Evaluation   evaluation = Evaluation::eager);
+
+        /**
+         * Constructor for an object that only computes the parts of the
+         * autocovariance matrices described by the first argument. The
+         * second argument has the same meaning as for the other constructor.
          */
-        AutoCovarianceMatrix(const unsigned int lag_length);
+        AutoCovarianceMatrix(const Selection  &selection,
+                             const Evaluation  evaluation = Evaluation::eager);
+
+        /**
+         * Constructor. In contrast to the previous constructors, the samples
+         * this object needs to keep are stored in the given LagWindow
+         * object, which may be shared with other consumers connected to the
+         * same producer (see the documentation of the LagWindow class). The
+         * selection must not restrict the components, and samples are
+         * processed eagerly.
+         */
+        AutoCovarianceMatrix(const Selection                         &selection,
+                             std::shared_ptr<LagWindow<scalar_type>>  window);
 
         /**
          * Destructor. This function also makes sure that all samples this
@@ -273,8 +451,9 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
@@ -284,23 +463,92 @@ namespace SampleFlow
         /**
          * A function that returns the autocovariance vector computed from the
          * samples seen so far. If no samples have been processed so far, then
-         * a default-constructed object of type InputType will be returned.
+         * the returned matrices are all zero.
          *
-         * @return The computed autocovariance vector of length `lag_length+1`
-         *   as provided to the constructor. The $l$th element of this vector,
-         *   starting from $l=0$ and going to $l=$`lag_length` (both inclusive)
-         *   corresponds to the auto-covariance of lag $l$. As a consequence,
-         *   the first entry ($l=0$) is the trace of the covariance matrix
-         *   that would have been returned by the CovarianceMatrix class.
+         * @return The computed autocovariance matrices, one for each of the
+         *   lags returned by get_lags(). If the object was created with the
+         *   constructor that takes a `lag_length`, these are the lags
+         *   $l=0,\ldots,$`lag_length` (both inclusive), and the first entry
+         *   ($l=0$) is the covariance matrix that would have been returned
+         *   by the CovarianceMatrix class. The matrices have as many rows
+         *   and columns as components were selected, except that for
+         *   Output::diagonal, they only have one column that contains the
+         *   diagonal entries.
          */
         value_type get() const;
 
+        /**
+         * Return the lags for which get() computes autocovariances, in
+         * ascending order.
+         */
+        const std::vector<unsigned int> &
+        get_lags () const;
+
+        /**
+         * Return a list of lags that starts with $0,1,2$ and in which each
+         * lag is at least `ratio` times the previous one, up to and
+         * including `max_lag`. Since autocovariances typically decay
+         * smoothly with the lag, this resolves short lags well and yet
+         * reaches long lags with a number of lags that only grows
+         * logarithmically with `max_lag`.
+         */
+        static
+        std::vector<unsigned int>
+        geometric_lags (const unsigned int max_lag,
+                        const double       ratio = 1.5);
+
+        /**
+         * Append the state of the computation, i.e., the running averages
+         * for each lag along with the last `lag_length+1` samples, to the
+         * given buffer. See the section on saving and combining the state of
+         * consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same lags, components, and output as the current
+         * one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the running averages of another object with the ones of
+         * the current object, in the same way as
+         * AutoCovarianceTrace::merge() does. Both objects need to use the
+         * same lags, components, and output.
+         */
+        void
+        merge (const AutoCovarianceMatrix &other);
+
+        /**
+         * Return an estimate of the memory used by the running averages
+         * and by the window of the most recent samples.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * The types used to store the selected components of samples and
+         * running averages.
+         */
+        using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * The lags for which autocovariances are computed, the selected
+         * components (empty if all are used), and which part of the
+         * matrices is computed.
          */
-        mutable std::mutex mutex;
+        const std::vector<unsigned int> lags;
+        const std::vector<unsigned int> components;
+        const Output                    output;
 
         /**
          * Describes the maximal lag up to which we calculate auto-covariances.
@@ -308,38 +556,235 @@ namespace SampleFlow
         const unsigned int max_lag;
 
         /**
-         * The current value of $\bar{x}_k$ as described in the introduction
-         * of this class. For more detailed description of calculation, check mean_value.h
+         * Whether samples are processed right away or only when get() is
+         * called.
+         */
+        const Evaluation evaluation;
+
+        /**
+         * The window that stores the samples, and the number this object
+         * has as a reader of it. The window is only used in eager mode; in
+         * lazy mode, evaluate_buffered_samples() stores the samples it
+         * replays in windows of its own.
          */
-        InputType current_mean;
+        const std::shared_ptr<LagWindow<scalar_type>> window;
+        const unsigned int                            reader;
 
         /**
-         * A data type used to store the past few samples.
+         * The number of entries of all matrices together above which get()
+         * computes the matrices for different lags in parallel.
          */
-        using PreviousSamples = std::deque<InputType>;
+        static constexpr std::size_t parallel_get_threshold = 1 << 16;
 
         /**
-         * Update variables necessary to compute the autocovariation. See their
-         * definition in the documentation of this class.
+         * The number of lags times the number of matrix entries per lag
+         * above which processing a sample updates the running averages for
+         * different lags in parallel. See for_each_lag_block().
          */
-        value_type alpha;
-        std::vector<InputType> beta;
-        std::vector<InputType> eta;
+        static constexpr std::size_t parallel_consume_threshold = 1 << 18;
 
         /**
-         * Save previous samples needed to do calculations when a new sample
-         * comes in.
+         * Call `f(begin,end)` for contiguous ranges of indices into the
+         * `lags` array that together make up the range $[0,n)$. If the
+         * work for all of these lags, i.e., `n` times the number of
+         * entries of the matrices stored for each lag, exceeds
+         * parallel_consume_threshold, then the ranges are processed in
+         * parallel on ThreadPool::default_pool(), unless it has only one
+         * worker thread. Otherwise, `f(0,n)` is called on the current
+         * thread.
          *
-         * These samples are stored in a double-ended queue (`std::deque`) so
-         * that it is efficient to push a new sample to the front of the list
-         * as well as to remove one from the end of the list.
+         * Processing one sample updates the running averages of each lag
+         * independently of those of all other lags, and the matrices for
+         * different lags are stored separately. For large samples and many
+         * lags, a single sample then creates enough work to keep several
+         * threads busy, and processing it in parallel keeps the current
+         * object from limiting the rate at which samples can be generated.
+         * Since each thread works on a block of successive lags, the
+         * per-lag scalars of neighboring lags are mostly updated by the
+         * same thread.
+         */
+        static
+        void
+        for_each_lag_block (const std::size_t  n,
+                            const Eigen::Index size,
+                            const Output       output,
+                            const std::function<void (const std::size_t, const std::size_t)> &f);
+
+        /**
+         * A data type used to store the past few samples, as handles to
+         * the samples stored in a window.
+         */
+        using PreviousSamples = RingBuffer<typename LagWindow<scalar_type>::Sample>;
+
+        /**
+         * A structure that holds all of the information that changes as
+         * samples are processed. All vectors only store the selected
+         * components of the samples, and all variables that are indexed by
+         * a lag are indexed by its position in the `lags` array.
+         */
+        struct State
+        {
+          /**
+           * The current value of $\bar{x}_k$ as described in the introduction
+           * of this class. For more detailed description of calculation, check mean_value.h
+           */
+          vector_type current_mean;
+
+          /**
+           * The total weight of the samples processed so far. If all samples
+           * have weight one, this is the number of samples.
+           */
+          double total_weight = 0;
+
+          /**
+           * Update variables necessary to compute the autocovariation. See their
+           * definition in the documentation of this class. As discussed there,
+           * these variables store the averages over all pairs of samples with
+           * a given lag, without the factor $\frac{n-l}{n-l-1}$. For
+           * Output::symmetric, only the lower triangles of the `alpha`
+           * matrices are used, and they store the symmetric parts of the
+           * averages; for Output::diagonal, the `alpha` matrices have
+           * only one column, which stores the diagonal.
+           */
+          value_type alpha;
+          std::vector<vector_type> beta;
+          std::vector<vector_type> eta;
+
+          /**
+           * The sums $P$ and $P_2$ of the weights of the pairs of samples, and
+           * of their squares, that contribute to the variables above, for each
+           * lag.
+           */
+          std::vector<double> pair_weight;
+          std::vector<double> squared_pair_weight;
+
+          /**
+           * Save previous samples needed to do calculations when a new sample
+           * comes in, along with the square roots of their weights.
+           *
+           * These samples are stored in ring buffers with room for
+           * `max_lag+1` samples that are set up when the first sample
+           * arrives. The samples themselves are stored in a LagWindow
+           * object, and the ring buffer only holds handles to them. Copying
+           * the state therefore does not copy the samples.
+           */
+          PreviousSamples    previous_samples;
+          RingBuffer<double> previous_sqrt_weights;
+
+          /**
+           * In lazy mode, the (selected components of the) samples that
+           * have been received but not yet been included in the variables
+           * above, in the order in which they were received.
+           */
+          BlockedSampleBuffer<scalar_type> buffered_samples;
+
+          /**
+           * Update the variables above with the given sample, stored in a
+           * window, which stands for `n_repetitions` consecutive samples
+           * with the given weight.
+           */
+          void
+          add_sample (const typename LagWindow<scalar_type>::Sample &sample,
+                      const types::sample_index       n_repetitions,
+                      const double                    weight,
+                      const std::vector<unsigned int> &lags,
+                      const Output                    output);
+
+          /**
+           * Update the variables above with one sample with the given weight.
+           */
+          void
+          add_one_sample (const typename LagWindow<scalar_type>::Sample &sample,
+                          const double                    weight,
+                          const std::vector<unsigned int> &lags,
+                          const Output                    output);
+
+          /**
+           * Add `n_pairs` copies of the pair of samples `later_sample`,
+           * `earlier_sample` with pair weight `weight` each to the running
+           * averages for the lag with index `k` in the `lags` array.
+           */
+          void
+          add_pairs (const unsigned int                 k,
+                     Eigen::Ref<const vector_type>      later_sample,
+                     Eigen::Ref<const vector_type>      earlier_sample,
+                     const double                       weight,
+                     const types::sample_index          n_pairs,
+                     const Output                       output);
+
+          /**
+           * Update the running mean with the given sample and (total) weight.
+           */
+          void
+          add_to_mean (Eigen::Ref<const vector_type> sample,
+                       const double                  weight);
+
+          /**
+           * Combine the running averages of the argument with the ones
+           * stored in the current object.
+           */
+          void
+          merge (const State &other);
+
+          /**
+           * Include all samples in `buffered_samples` into the variables
+           * above, and empty the buffer. The running averages for the
+           * different lags are computed in parallel.
+           */
+          void
+          evaluate_buffered_samples (const std::vector<unsigned int> &lags,
+                                     const Output                     output);
+        };
+
+        /**
+         * The current state of the computation. It is stored in a
+         * CopyOnWrite object so that get() can compute the autocovariances
+         * from a snapshot of the state, without holding up threads that
+         * send samples to this object.
+         */
+        CopyOnWrite<State> state;
+
+        /**
+         * Return a snapshot of the current state with the buffered samples
+         * included, i.e., the state that get() and save() work on.
+         */
+        std::shared_ptr<const State>
+        evaluated_state () const;
+
+        /**
+         * Return the number of selected components of samples that have
+         * the same size as the given one.
+         */
+        unsigned int
+        n_selected_components (const InputType &sample) const;
+
+        /**
+         * Return a view of the elements of a sample stored in a window as
+         * an Eigen vector.
+         */
+        static
+        Eigen::Map<const vector_type>
+        as_vector (const typename LagWindow<scalar_type>::Sample &sample);
+
+        /**
+         * Copy the selected components of the given sample into a vector.
+         */
+        vector_type
+        select_components (const InputType &sample) const;
+
+        /**
+         * Return the lags 0,...,lag_length.
          */
-        PreviousSamples previous_samples;
+        static
+        std::vector<unsigned int>
+        all_lags (const unsigned int lag_length);
 
         /**
-         * The number of samples processed so far.
+         * Return the given lags sorted and without duplicates.
          */
-        types::sample_index n_samples;
+        static
+        std::vector<unsigned int>
+        sorted_lags (std::vector<unsigned int> lags);
     };
 
 
@@ -347,21 +792,63 @@ namespace SampleFlow
     template <typename InputType>
     requires (Concepts::is_vector_space_type<InputType>)
     AutoCovarianceMatrix<InputType>::
-    AutoCovarianceMatrix (unsigned int lag_length)
+    AutoCovarianceMatrix (const unsigned int lag_length,
+                          const Evaluation   evaluation)
       :
-      Consumer<InputType>(ParallelMode::synchronous),
-      max_lag(lag_length),
-      n_samples (0)
+      AutoCovarianceMatrix (Selection {{}, all_lags (lag_length), Output::full}, evaluation)
     {}
 
 
 
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    AutoCovarianceMatrix<InputType>::
+    AutoCovarianceMatrix (const Selection  &selection,
+                          const Evaluation  evaluation)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      lags (sorted_lags (selection.lags)),
+      components (selection.components),
+      output (selection.output),
+      max_lag (lags.back()),
+      evaluation (evaluation),
+      window (std::make_shared<LagWindow<scalar_type>>()),
+      reader (window->attach())
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    AutoCovarianceMatrix<InputType>::
+    AutoCovarianceMatrix (const Selection                         &selection,
+                          std::shared_ptr<LagWindow<scalar_type>>  window)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      lags (sorted_lags (selection.lags)),
+      components (selection.components),
+      output (selection.output),
+      max_lag (lags.back()),
+      evaluation (Evaluation::eager),
+      window (std::move(window)),
+      reader (this->window->attach())
+    {
+      assert (components.empty());
+    }
+
+
+
     template <typename InputType>
     requires (Concepts::is_vector_space_type<InputType>)
     AutoCovarianceMatrix<InputType>::
     ~AutoCovarianceMatrix ()
     {
       this->disconnect_and_flush();
+      window->detach (reader);
     }
 
 
@@ -369,108 +856,382 @@ namespace SampleFlow
     requires (Concepts::is_vector_space_type<InputType>)
     void
     AutoCovarianceMatrix<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    consume (InputType sample, AuxiliaryData aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      if (evaluation == Evaluation::lazy)
+        {
+          const vector_type selected_sample = select_components (sample);
+          state.modify ([&](State &current_state)
+          {
+            // Samples that carry no weight at all do not change anything,
+            // and need not be stored:
+            if ((aux_data.n_repetitions() != 0) && (aux_data.weight() != 0))
+              current_state.buffered_samples.push_back (selected_sample.data(), selected_sample.size(),
+                                                        aux_data.n_repetitions(), aux_data.weight());
+          }, this->is_single_threaded() == false);
+        }
+      else
+        state.modify ([&](State &current_state)
+      {
+        // Every sample needs to be inserted into the window, even if it
+        // carries no weight, so that the samples of all readers of the
+        // window remain in step. If all components are used, the window
+        // copies the sample directly:
+        const typename LagWindow<scalar_type>::Sample stored_sample
+          = (components.empty() ?
+             window->insert (reader, sample) :
+             window->insert (reader, select_components (sample)));
+        current_state.add_sample (stored_sample, aux_data.n_repetitions(), aux_data.weight(),
+                                  lags, output);
+      }, this->is_single_threaded() == false);
+    }
+
 
-      // If this is the first sample we see, initialize all components
-      // After the first sample, the autocovariance vector
-      // is the zero vector since a single sample does not have any friends yet.
-      if (n_samples == 0)
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    add_sample (const typename LagWindow<scalar_type>::Sample &sample,
+                const types::sample_index       n_repetitions,
+                const double                    weight,
+                const std::vector<unsigned int> &lags,
+                const Output                    output)
+    {
+      // Samples that carry no weight at all do not change anything:
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
+
+      // If this is the first sample we see, initialize the variables that
+      // store information for each lag:
+      if (total_weight == 0)
         {
-          // Initialize the alpha and beta vectors to a length of lag_length+1
-          // (so that we can compute the variance plus lag_length auto-variances)
-          alpha.resize(max_lag+1);
+          const unsigned int size = sample.values().size();
+          alpha.resize(lags.size());
           for (auto &a : alpha)
-            a.resize (Utilities::size(sample), Utilities::size(sample));
-          beta.resize(max_lag+1);
-          eta.resize(max_lag+1);
+            a.setZero (size, (output == Output::diagonal ? 1 : size));
+          beta.assign(lags.size(), vector_type::Zero(size));
+          eta.assign(lags.size(), vector_type::Zero(size));
+          pair_weight = std::vector<double>(lags.size(), 0.);
+          squared_pair_weight = std::vector<double>(lags.size(), 0.);
+          previous_samples = PreviousSamples(lags.back()+1);
+          previous_sqrt_weights = RingBuffer<double>(lags.back()+1);
+        }
+
+      // Process the copies of the sample one at a time until the list
+      // of previous samples contains nothing but this sample:
+      const types::sample_index n_individual_copies
+        = std::min<types::sample_index> (n_repetitions, lags.back()+1);
+      for (types::sample_index i=0; i<n_individual_copies; ++i)
+        add_one_sample (sample, weight, lags, output);
 
-          for (unsigned int l=0; l<=max_lag; ++l)
+      // At this point, every further copy would add the pair (sample,sample)
+      // to the running averages for every lag, and would not change the list
+      // of previous samples. Add all of them at once:
+      if (n_repetitions > n_individual_copies)
+        {
+          const types::sample_index n_remaining_copies = n_repetitions - n_individual_copies;
+          for_each_lag_block (lags.size(), as_vector (sample).size(), output,
+                              [&](const std::size_t begin, const std::size_t end)
+          {
+            for (std::size_t k=begin; k<end; ++k)
+              add_pairs (k, as_vector (sample), as_vector (sample), weight, n_remaining_copies, output);
+          });
+          add_to_mean (as_vector (sample), n_remaining_copies * weight);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    add_one_sample (const typename LagWindow<scalar_type>::Sample &sample,
+                    const double                    weight,
+                    const std::vector<unsigned int> &lags,
+                    const Output                    output)
+    {
+      // Save the sample. The buffers hold max_lag+1 samples, so if they
+      // are already full, this drops the sample whose lag to the current
+      // one would be larger than max_lag.
+      previous_samples.push_back (sample);
+      previous_sqrt_weights.push_back (std::sqrt(weight));
+
+      // Then add the pairs this sample forms with the previous ones
+      // (including itself, for l=0). The sample with lag l relative to
+      // the current one is the l-th newest one in the buffer. Until the
+      // buffer is full, only the lags smaller than the number of samples
+      // in it have a partner for the current sample:
+      const std::size_t newest = previous_samples.size()-1;
+      const std::size_t n_active_lags
+        = std::upper_bound (lags.begin(), lags.end(), newest) - lags.begin();
+      for_each_lag_block (n_active_lags, as_vector (sample).size(), output,
+                          [&](const std::size_t begin, const std::size_t end)
+      {
+        for (std::size_t k=begin; k<end; ++k)
+          add_pairs (k, as_vector (previous_samples[newest]), as_vector (previous_samples[newest-lags[k]]),
+                     previous_sqrt_weights[newest] * previous_sqrt_weights[newest-lags[k]], 1,
+                     output);
+      });
+
+      add_to_mean (as_vector (sample), weight);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::
+    for_each_lag_block (const std::size_t  n,
+                        const Eigen::Index size,
+                        const Output       output,
+                        const std::function<void (const std::size_t, const std::size_t)> &f)
+    {
+      // Splitting up the work only adds overhead if the pool cannot
+      // process more than one block at a time:
+      const std::size_t work_per_lag = std::size_t(size) * (output == Output::diagonal ? 1 : size);
+      if ((n > 1) && (work_per_lag * n > parallel_consume_threshold))
+        {
+          const std::shared_ptr<ThreadPool> thread_pool = ThreadPool::default_pool();
+          if (thread_pool->n_threads() > 1)
             {
-              // Initialize beta[i] to zero; first initialize it to 'sample'
-              // so that it has the right size already. Do the same for eta.
-              beta[l] = sample;
-              eta[l] = sample;
-              for (unsigned int j=0; j<Utilities::size(sample); ++j)
+              thread_pool->for_each_chunk (n, f);
+              return;
+            }
+        }
+      f (0, n);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    add_pairs (const unsigned int                 k,
+               Eigen::Ref<const vector_type>      later_sample,
+               Eigen::Ref<const vector_type>      earlier_sample,
+               const double                       weight,
+               const types::sample_index          n_pairs,
+               const Output                       output)
+    {
+      pair_weight[k] += n_pairs * weight;
+      squared_pair_weight[k] += n_pairs * weight * weight;
+      const scalar_type factor = n_pairs * weight / pair_weight[k];
+
+      // Update alpha. For the first pair, the factor is one and the
+      // previous (zero) contents of all variables are replaced:
+      //
+      // Eigen's outer products and rank updates are not vectorized for
+      // complex elements, and are then more than an order of magnitude
+      // slower than for real ones. For these, update the columns of
+      // alpha one at a time instead (see Utilities::axpy()).
+      const Eigen::Index size = later_sample.size();
+      const auto later   = std::span<const scalar_type>(later_sample.data(), size);
+      const auto earlier = std::span<const scalar_type>(earlier_sample.data(), size);
+      switch (output)
+        {
+          case Output::full:
+            alpha[k] *= (scalar_type(1) - factor);
+            if constexpr (types::is_complex<scalar_type>)
+              for (Eigen::Index j=0; j<size; ++j)
+                Utilities::axpy (std::span<scalar_type>(&alpha[k](0,j), size),
+                                 Utilities::multiply (factor, earlier[j]),
+                                 later);
+            else
+              alpha[k].noalias() += factor * later_sample * earlier_sample.transpose();
+            break;
+
+          case Output::symmetric:
+            alpha[k].template triangularView<Eigen::Lower>() *= (scalar_type(1) - factor);
+            if constexpr (types::is_complex<scalar_type>)
+              for (Eigen::Index j=0; j<size; ++j)
                 {
-                  Utilities::get_nth_element(beta[l], j) = 0;
-                  Utilities::get_nth_element(eta[l], j) = 0;
+                  const std::span<scalar_type> column (&alpha[k](j,j), size-j);
+                  Utilities::axpy (column,
+                                   scalar_type(factor / scalar_type(2) * Utilities::conj(earlier[j])),
+                                   later.subspan(j));
+                  Utilities::axpy (column,
+                                   scalar_type(factor / scalar_type(2) * Utilities::conj(later[j])),
+                                   earlier.subspan(j));
                 }
-            }
-          current_mean = sample;
+            else
+              alpha[k].template selfadjointView<Eigen::Lower>()
+              .rankUpdate (later_sample, earlier_sample, factor / scalar_type(2));
+            break;
+
+          case Output::diagonal:
+            if constexpr (types::is_complex<scalar_type>)
+              for (Eigen::Index j=0; j<size; ++j)
+                alpha[k](j,0) = Utilities::multiply (scalar_type(1) - factor, alpha[k](j,0))
+                                + Utilities::multiply (factor, Utilities::multiply (later[j], earlier[j]));
+            else
+              alpha[k].col(0) = (scalar_type(1) - factor) * alpha[k].col(0)
+                                + factor * later_sample.cwiseProduct (earlier_sample);
+            break;
+        }
 
-          // Push the first sample to the front of the list of samples:
-          previous_samples.push_front (sample);
-          n_samples = 1;
+      beta[k] += factor * (later_sample - beta[k]);
+      eta[k]  += factor * (earlier_sample - eta[k]);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    add_to_mean (Eigen::Ref<const vector_type> sample,
+                 const double                  weight)
+    {
+      if (total_weight == 0)
+        {
+          total_weight = weight;
+          current_mean = sample;
         }
       else
         {
-          // Now save the sample. If the list is becoming longer than the lag
-          // length (plus one, for l=0), drop the oldest sample at the end of this
-          // block. This makes sure that we always have all samples up to a lag of l+1
-          // available, which we need for the initialization step
-          previous_samples.push_front (sample);
+          total_weight += weight;
+
+          current_mean += (weight / total_weight) * (sample - current_mean);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    merge (const State &other)
+    {
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
 
-          for (unsigned int l=0; l<=max_lag; ++l)
+      // Average the running averages for each lag, weighted by the
+      // weights of the pairs that contributed to them, and then the means:
+      assert (alpha.size() == other.alpha.size());
+      for (unsigned int k=0; k<alpha.size(); ++k)
+        {
+          if (other.pair_weight[k] == 0)
+            continue;
+
+          if (pair_weight[k] == 0)
             {
-              if (n_samples == l+1)
-                {
-                  // We need to initialize alpha via the formula
-                  // alpha_{l+2}(l) = sum_{t=1}^2 x_{t+l} x_t
-                  for (unsigned int i=0; i<Utilities::size(sample); ++i)
-                    for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                      alpha[l](i,j) += Utilities::get_nth_element (previous_samples[0], i) *
-                                       Utilities::get_nth_element (previous_samples[l], j);
-                  for (unsigned int i=0; i<Utilities::size(sample); ++i)
-                    for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                      alpha[l](i,j) += Utilities::get_nth_element (previous_samples[1], i) *
-                                       Utilities::get_nth_element (previous_samples[l+1], j);
-
-                  beta[l] = previous_samples[0];
-                  beta[l] += previous_samples[1];
-
-                  eta[l] += previous_samples[l];
-                  eta[l] += previous_samples[l+1];
-                }
-              else if (n_samples >= l+2)
-                {
-                  // Update alpha
-                  Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic> alphaupd = -alpha[l];
-                  for (unsigned int i=0; i<Utilities::size(sample); ++i)
-                    for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                      {
-                        alphaupd(i,j) += Utilities::get_nth_element (sample, i) *
-                                         Utilities::get_nth_element (previous_samples[l], j);
-                      }
-                  alphaupd *= 1./(n_samples-l);
-                  alpha[l] += alphaupd;
-
-                  // Update beta. Start with the current sample and add up
-                  // the updates.
-                  InputType betaupd = sample;
-                  betaupd -= beta[l];
-                  betaupd *= 1./(n_samples-l);
-                  beta[l] += betaupd;
-
-                  // Finally also update eta
-                  InputType etaupd = previous_samples[l];
-                  etaupd -= eta[l];
-                  etaupd *= 1./(n_samples-l);
-                  eta[l] += etaupd;
-                }
+              alpha[k] = other.alpha[k];
+              beta[k]  = other.beta[k];
+              eta[k]   = other.eta[k];
             }
+          else
+            {
+              const scalar_type factor = other.pair_weight[k] / (pair_weight[k] + other.pair_weight[k]);
+              alpha[k] += factor * (other.alpha[k] - alpha[k]);
+              beta[k]  += factor * (other.beta[k] - beta[k]);
+              eta[k]   += factor * (other.eta[k] - eta[k]);
+            }
+
+          pair_weight[k]         += other.pair_weight[k];
+          squared_pair_weight[k] += other.squared_pair_weight[k];
+        }
+
+      total_weight += other.total_weight;
+
+      current_mean += (other.total_weight / total_weight) * (other.current_mean - current_mean);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::State::
+    evaluate_buffered_samples (const std::vector<unsigned int> &lags,
+                               const Output                     output)
+    {
+      if (buffered_samples.empty())
+        return;
+
+      const auto blocks = buffered_samples.blocks();
+      buffered_samples.clear();
 
-          if (previous_samples.size() > max_lag+1)
-            previous_samples.pop_back ();
-          ++n_samples;
+      // Each task works on a state that only tracks a single lag, starting
+      // from the parts of the current state that concern this lag, and
+      // replays all buffered samples on it:
+      std::vector<State> lag_states (lags.size());
+      const auto evaluate_lag = [this, &lags, output, &blocks, &lag_states](const unsigned int k)
+      {
+        State &lag_state = lag_states[k];
+        if (total_weight > 0)
+          {
+            lag_state.current_mean          = current_mean;
+            lag_state.total_weight          = total_weight;
+            lag_state.alpha                 = {alpha[k]};
+            lag_state.beta                  = {beta[k]};
+            lag_state.eta                   = {eta[k]};
+            lag_state.pair_weight           = {pair_weight[k]};
+            lag_state.squared_pair_weight   = {squared_pair_weight[k]};
+            lag_state.previous_samples      = previous_samples;
+            lag_state.previous_sqrt_weights = previous_sqrt_weights;
+          }
 
-          // Then also update the running mean:
-          InputType update = sample;
-          update -= current_mean;
-          update /= n_samples;
-          current_mean += update;
+        // The samples this task replays are stored in a window of its own,
+        // whose memory is reused once the samples are no longer needed:
+        const std::vector<unsigned int> lag = {lags[k]};
+        LagWindow<scalar_type> replay_window;
+        const unsigned int     replay_reader = replay_window.attach();
+        for (const auto &block : blocks)
+          for (std::size_t i=0; i<block->size(); ++i)
+            lag_state.add_sample (replay_window.insert (replay_reader,
+                                                        Eigen::Map<const vector_type> (block->sample(i),
+                                                            block->dimension)),
+                                  block->n_repetitions[i], block->weights[i],
+                                  lag, output);
+      };
+
+      if (lags.size() == 1)
+        evaluate_lag (0);
+      else
+        {
+          const std::shared_ptr<ThreadPool> thread_pool = ThreadPool::default_pool();
+          ThreadPool::TaskGroup tasks;
+          for (unsigned int k=0; k<lags.size(); ++k)
+            tasks.run (*thread_pool,
+                       [&evaluate_lag, k]()
+          {
+            evaluate_lag (k);
+          });
+          tasks.wait();
+        }
+
+      // Then put the results back together. All tasks have computed the
+      // same running mean, and the one for the largest lag has kept as
+      // many previous samples as the current state needs to:
+      alpha.resize (lags.size());
+      beta.resize (lags.size());
+      eta.resize (lags.size());
+      pair_weight.resize (lags.size());
+      squared_pair_weight.resize (lags.size());
+      for (unsigned int k=0; k<lags.size(); ++k)
+        {
+          alpha[k]               = std::move(lag_states[k].alpha[0]);
+          beta[k]                = std::move(lag_states[k].beta[0]);
+          eta[k]                 = std::move(lag_states[k].eta[0]);
+          pair_weight[k]         = lag_states[k].pair_weight[0];
+          squared_pair_weight[k] = lag_states[k].squared_pair_weight[0];
         }
+
+      State &last_lag_state = lag_states.back();
+      current_mean          = std::move(last_lag_state.current_mean);
+      total_weight          = last_lag_state.total_weight;
+      previous_samples      = std::move(last_lag_state.previous_samples);
+      previous_sqrt_weights = std::move(last_lag_state.previous_sqrt_weights);
     }
 
 
@@ -481,36 +1242,307 @@ namespace SampleFlow
     AutoCovarianceMatrix<InputType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      // Get a snapshot of the current state, and compute the
+      // autocovariances from it without holding up anyone who
+      // wants to process samples in the meantime:
+      const std::shared_ptr<const State> state = evaluated_state();
 
-      value_type current_autocovariation(max_lag+1);
+      const unsigned int size = (state->total_weight > 0
+                                 ?
+                                 state->current_mean.size()
+                                 :
+                                 n_selected_components (InputType()));
+      value_type current_autocovariation(lags.size());
       for (auto &a : current_autocovariation)
-        a.resize (Utilities::size(current_mean), Utilities::size(current_mean));
+        a.setZero (size, (output == Output::diagonal ? 1 : size));
 
-      for (int l=0; l<=max_lag; ++l)
-        {
-          current_autocovariation[l] = alpha[l];
-
-          for (unsigned int i=0; i<Utilities::size(current_mean); ++i)
-            for (unsigned int j=0; j<Utilities::size(current_mean); ++j)
-              current_autocovariation[l](i,j) -= Utilities::get_nth_element(current_mean,i) *
-                                                 Utilities::get_nth_element(eta[l], j);
-
-          for (unsigned int i=0; i<Utilities::size(current_mean); ++i)
-            for (unsigned int j=0; j<Utilities::size(current_mean); ++j)
-              current_autocovariation[l](i,j) -= Utilities::get_nth_element(beta[l],i) *
-                                                 Utilities::get_nth_element(current_mean, j);
-
-          if (n_samples > l+1 )
-            for (unsigned int i=0; i<Utilities::size(current_mean); ++i)
-              for (unsigned int j=0; j<Utilities::size(current_mean); ++j)
-                current_autocovariation[l](i,j) += (1. + 1./(n_samples-l-1))
-                                                   *
-                                                   Utilities::get_nth_element(current_mean,i) *
-                                                   Utilities::get_nth_element(current_mean,j);
-        }
+      // We can only compute the autocovariance for a lag l if we have seen
+      // at least two pairs of samples with this lag (or, with weights, if
+      // P-P_2/P is positive):
+      if (state->total_weight == 0)
+        return current_autocovariation;
+
+      // The matrices for the different lags can be computed independently.
+      // If there is enough work, do so in parallel:
+      const vector_type &mean = state->current_mean;
+      const auto compute_lags = [&](const std::size_t begin, const std::size_t end)
+      {
+        for (std::size_t k=begin; k<end; ++k)
+          {
+            const double normalization
+              = (state->pair_weight[k] > 0
+                 ?
+                 state->pair_weight[k] - state->squared_pair_weight[k] / state->pair_weight[k]
+                 :
+                 0.);
+            if (normalization <= 0)
+              continue;
+
+            const vector_type &beta = state->beta[k];
+            const vector_type &eta  = state->eta[k];
+            matrix_type       &gamma = current_autocovariation[k];
+            switch (output)
+              {
+                case Output::full:
+                  gamma = state->alpha[k]
+                          - mean * eta.transpose()
+                          - beta * mean.transpose()
+                          + mean * mean.transpose();
+                  break;
+
+                case Output::symmetric:
+                {
+                  const vector_type beta_plus_eta = beta + eta;
+                  gamma = state->alpha[k].template selfadjointView<Eigen::Lower>();
+                  gamma -= scalar_type(0.5) * (mean * beta_plus_eta.transpose()
+                                               + beta_plus_eta * mean.transpose());
+                  gamma += mean * mean.transpose();
+                  break;
+                }
+
+                case Output::diagonal:
+                  gamma.col(0) = state->alpha[k].col(0)
+                                 - mean.cwiseProduct (eta)
+                                 - beta.cwiseProduct (mean)
+                                 + mean.cwiseProduct (mean);
+                  break;
+              }
+
+            gamma *= scalar_type(state->pair_weight[k] / normalization);
+          }
+      };
+
+      const std::size_t work_per_lag = std::size_t(size) * (output == Output::diagonal ? 1 : size);
+      if ((lags.size() > 1) && (work_per_lag * lags.size() > parallel_get_threshold))
+        ThreadPool::default_pool()->for_each_chunk (lags.size(), compute_lags);
+      else
+        compute_lags (0, lags.size());
 
       return current_autocovariation;
     }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    const std::vector<unsigned int> &
+    AutoCovarianceMatrix<InputType>::
+    get_lags () const
+    {
+      return lags;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::vector<unsigned int>
+    AutoCovarianceMatrix<InputType>::
+    geometric_lags (const unsigned int max_lag,
+                    const double       ratio)
+    {
+      assert (ratio > 1);
+
+      std::vector<unsigned int> lags = {0};
+      for (unsigned int l=1; l<max_lag;
+           l = std::max<unsigned int> (l+1, std::ceil(l*ratio)))
+        lags.push_back (l);
+      if (max_lag > 0)
+        lags.push_back (max_lag);
+      return lags;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::shared_ptr<const State> state = evaluated_state();
+
+      Serialization::write (buffer, lags);
+      Serialization::write (buffer, components);
+      Serialization::write (buffer, static_cast<int>(output));
+      Serialization::write (buffer, state->current_mean);
+      Serialization::write (buffer, state->total_weight);
+      Serialization::write (buffer, state->alpha);
+      Serialization::write (buffer, state->beta);
+      Serialization::write (buffer, state->eta);
+      Serialization::write (buffer, state->pair_weight);
+      Serialization::write (buffer, state->squared_pair_weight);
+      Serialization::write (buffer, state->previous_samples);
+      Serialization::write (buffer, state->previous_sqrt_weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<unsigned int> saved_lags;
+      std::vector<unsigned int> saved_components;
+      int                       saved_output;
+      Serialization::read (buffer, saved_lags);
+      Serialization::read (buffer, saved_components);
+      Serialization::read (buffer, saved_output);
+      assert (saved_lags == lags);
+      assert (saved_components == components);
+      assert (saved_output == static_cast<int>(output));
+
+      State new_state;
+      Serialization::read (buffer, new_state.current_mean);
+      Serialization::read (buffer, new_state.total_weight);
+      Serialization::read (buffer, new_state.alpha);
+      Serialization::read (buffer, new_state.beta);
+      Serialization::read (buffer, new_state.eta);
+      Serialization::read (buffer, new_state.pair_weight);
+      Serialization::read (buffer, new_state.squared_pair_weight);
+      Serialization::read (buffer, new_state.previous_samples);
+      Serialization::read (buffer, new_state.previous_sqrt_weights);
+
+      state.modify ([&new_state](State &current_state)
+      {
+        current_state = std::move(new_state);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    AutoCovarianceMatrix<InputType>::
+    merge (const AutoCovarianceMatrix &other)
+    {
+      assert (other.lags == lags);
+      assert (other.components == components);
+      assert (other.output == output);
+
+      const std::shared_ptr<const State> other_state = other.evaluated_state();
+      state.modify ([this, &other_state](State &current_state)
+      {
+        current_state.evaluate_buffered_samples (lags, output);
+        current_state.merge (*other_state);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::size_t
+    AutoCovarianceMatrix<InputType>::
+    memory_consumption () const
+    {
+      const std::shared_ptr<const State> current_state = state.snapshot();
+
+      // The window of previous samples has room for max_lag+1 samples, all
+      // of which have the same size as the mean value once it is full:
+      const std::size_t bytes_per_sample = Memory::memory_consumption (current_state->current_mean);
+
+      return (sizeof(State)
+              + Memory::memory_consumption (current_state->alpha)
+              + Memory::memory_consumption (current_state->beta)
+              + Memory::memory_consumption (current_state->eta)
+              + Memory::memory_consumption (current_state->pair_weight)
+              + Memory::memory_consumption (current_state->squared_pair_weight)
+              + current_state->previous_samples.capacity() * bytes_per_sample
+              + current_state->previous_sqrt_weights.capacity() * sizeof(double)
+              + current_state->buffered_samples.memory_consumption());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::shared_ptr<const typename AutoCovarianceMatrix<InputType>::State>
+    AutoCovarianceMatrix<InputType>::
+    evaluated_state () const
+    {
+      std::shared_ptr<const State> current_state = state.snapshot();
+      if (current_state->buffered_samples.empty())
+        return current_state;
+
+      // Copying the state only copies the pointers to the blocks of
+      // buffered samples, not the samples themselves:
+      auto evaluated = std::make_shared<State> (*current_state);
+      evaluated->evaluate_buffered_samples (lags, output);
+      return evaluated;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    unsigned int
+    AutoCovarianceMatrix<InputType>::
+    n_selected_components (const InputType &sample) const
+    {
+      return (components.empty() ? Utilities::size(sample) : components.size());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    Eigen::Map<const typename AutoCovarianceMatrix<InputType>::vector_type>
+    AutoCovarianceMatrix<InputType>::
+    as_vector (const typename LagWindow<scalar_type>::Sample &sample)
+    {
+      return Eigen::Map<const vector_type> (sample.values().data(), sample.values().size());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename AutoCovarianceMatrix<InputType>::vector_type
+    AutoCovarianceMatrix<InputType>::
+    select_components (const InputType &sample) const
+    {
+      const unsigned int size = n_selected_components (sample);
+      if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+        if (components.empty())
+          return Eigen::Map<const vector_type> (std::ranges::data(sample), size);
+
+      vector_type x (size);
+      for (unsigned int i=0; i<size; ++i)
+        x[i] = Utilities::get_nth_element (sample, (components.empty() ? i : components[i]));
+      return x;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::vector<unsigned int>
+    AutoCovarianceMatrix<InputType>::
+    all_lags (const unsigned int lag_length)
+    {
+      std::vector<unsigned int> lags (lag_length+1);
+      for (unsigned int l=0; l<=lag_length; ++l)
+        lags[l] = l;
+      return lags;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::vector<unsigned int>
+    AutoCovarianceMatrix<InputType>::
+    sorted_lags (std::vector<unsigned int> lags)
+    {
+      assert (lags.size() > 0);
+      std::sort (lags.begin(), lags.end());
+      lags.erase (std::unique (lags.begin(), lags.end()), lags.end());
+      return lags;
+    }
+
   }
 }
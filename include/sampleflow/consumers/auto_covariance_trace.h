@@ -19,8 +19,18 @@
 #include <sampleflow/consumer.h>
 #include <sampleflow/types.h>
 #include <sampleflow/element_access.h>
+#include <sampleflow/copy_on_write.h>
+#include <sampleflow/ring_buffer.h>
+#include <sampleflow/lag_window.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/serialization.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <deque>
+#include <span>
+#include <vector>
 
 #include <eigen3/Eigen/Dense>
 
@@ -158,6 +158,39 @@ namespace SampleFlow
      * @f}
      *
      *
+     * In practice, the class does not store $\hat\alpha_n(l)$ and
+     * $\hat\beta_n(l)$ as defined above, but the running averages
+     * $\frac{n-l-1}{n-l}\hat\alpha_n(l)$ and $\frac{n-l-1}{n-l}\hat\beta_n(l)$
+     * over the $n-l$ pairs of samples with lag $l$. These are updated in the
+     * same way as the running mean in the MeanValue class (and without the
+     * need for a special initialization once the first two pairs have been
+     * seen), and get() multiplies by the factor $\frac{n-l}{n-l-1}$.
+     *
+     *
+     * ### Repeated and weighted samples ###
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive samples
+     * of the chain as this entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples),
+     * and the class treats it exactly as if it had received these samples
+     * one at a time. This does not require processing every one of the
+     * copies individually, though: Once the last $k+1$ samples are all the
+     * same, every further copy adds the same contribution to each of the
+     * running averages, and these contributions are then added all at once.
+     *
+     * If samples carry weights $w_t$ (see AuxiliaryData::sample_weight), then
+     * $\bar x$ is the weighted mean (see the MeanValue class), and the pair
+     * of samples $x_{t+l},x_t$ contributes to the averages above with weight
+     * $p_t=\sqrt{w_{t+l}w_t}$. The normalization factor $\frac{n-l}{n-l-1}$
+     * is replaced by $\frac{P}{P-P_2/P}$ where
+     * $P=\sum_t p_t$ and $P_2=\sum_t p_t^2$ are the sum of the pair
+     * weights and of their squares. For lag $l=0$, this yields the same
+     * normalization of the weighted covariance matrix as used in the
+     * CovarianceMatrix class, and if all weights are one, it reduces to the
+     * formulas above.
+     *
+     *
      * ### Making computing this operation less expensive ###
      *
      * In many situations, samples are quite highly correlated. An example is
@@ -259,28 +292,93 @@ namespace SampleFlow
      * is prohibitively expensive works.
      *
      *
+     * ### Sharing previous samples with other consumers ###
+     *
+     * The class needs to keep the last $k+1$ samples it has received. These
+     * are stored in a LagWindow object, which the class creates itself
+     * unless one is passed to the constructor. If several consumers that
+     * compare samples with earlier ones -- this class, AutoCovarianceMatrix,
+     * and AverageCosineBetweenSuccessiveSamples -- are connected to the same
+     * producer, they can share one LagWindow object. Each sample is then
+     * copied only once, and the samples are stored only once, no matter how
+     * many of these consumers there are:
+     * @code
+     *   auto window = std::make_shared<SampleFlow::LagWindow<double>>();
+     *
+     *   SampleFlow::Consumers::AutoCovarianceTrace<SampleType> trace (100, window);
+     *   trace.connect_to_producer (sampler);
+     *
+     *   SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<SampleType> cosine (100, window);
+     *   cosine.connect_to_producer (sampler);
+     * @endcode
+     *
+     * If the samples are large, it may be preferable to not copy them at
+     * all. If the consumers are connected to a Filters::MakeShared object,
+     * they receive reference-counted handles to the samples rather than
+     * copies (see Concepts::is_sample_handle), and the LagWindow object
+     * then keeps these handles instead of copying the samples they refer
+     * to:
+     * @code
+     *   SampleFlow::Filters::MakeShared<SampleType> make_shared;
+     *   make_shared.connect_to_producer (sampler);
+     *
+     *   SampleFlow::Consumers::AutoCovarianceTrace<std::shared_ptr<const SampleType>> trace (100);
+     *   trace.connect_to_producer (make_shared);
+     * @endcode
+     * This requires that `SampleType` stores its elements contiguously
+     * (see Concepts::has_contiguous_scalar_storage); otherwise, the window
+     * copies the samples the handles refer to as before.
+     *
+     *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Because the result depends on the order in which samples
+     * are processed, the class supports ParallelMode::dedicated_thread but
+     * not ParallelMode::asynchronous. The former moves the work of this
+     * class off the thread on which samples are generated.
+     *
+     * The state of the computation is kept in a CopyOnWrite object. As a
+     * consequence, calling get() while samples are being processed on
+     * other threads does not block these threads for the (substantial)
+     * time it takes to compute the autocovariances: get() only takes a
+     * snapshot of the current state and then does its work without
+     * holding a lock. If there are many lags and samples have many
+     * elements, get() computes the values for different lags in parallel
+     * on ThreadPool::default_pool().
+     *
+     * For the same reason, processing a single sample can also be
+     * expensive: For samples with $10^4$ elements and 500 lags, it takes
+     * millions of operations. The updates for different lags are
+     * independent of each other, and if there are enough of them, they are
+     * split into blocks of successive lags that are processed in parallel
+     * on ThreadPool::default_pool(). The current object then no longer
+     * limits the rate at which samples can be generated to what a single
+     * thread can process, whether samples arrive on the thread that
+     * generates them or on a dedicated thread. The results do not depend
+     * on whether or not this happens.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$. In
      *   order to compute auto covariances, the same kind of requirements
      *   have to hold as listed for the MeanValue class (we need to be able to
-     *   calculate mean, divide by positive integers, etc.).
+     *   calculate mean, divide by positive integers, etc.). `InputType` may
+     *   also be a handle `std::shared_ptr<const T>` to samples of such a
+     *   type `T` (see Concepts::is_sample_handle), as created by a
+     *   Filters::MakeShared object. The LagWindow object then stores the
+     *   handles instead of copies of the samples.
      */
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     class AutoCovarianceTrace: public Consumer<InputType>
     {
       public:
         /**
          * The data type of the elements of the input type.
          */
-        using scalar_type = types::ScalarType<InputType>;
+        using scalar_type = types::ScalarType<types::HandledType<InputType>>;
 
         /**
          * The data type returned by the get() function.
@@ -290,9 +388,12 @@ namespace SampleFlow
         /**
          * Constructor.
          *
-         * This class does not support asynchronous processing of samples,
-         * and consequently calls the base class constructor with
-         * ParallelMode::synchronous as argument.
+         * This class needs to process samples in the order in which they
+         * were generated, and consequently does not support asynchronous
+         * processing of samples on a thread pool. It can, however, work on
+         * its own thread, and so calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::dedicated_thread` as
+         * argument.
          *
          * @param[in] lag_length A number that indicates how many autocovariance
          *   values we want to calculate, i.e., how far back in the past we
@@ -300,6 +401,15 @@ namespace SampleFlow
          */
         AutoCovarianceTrace(const unsigned int lag_length);
 
+        /**
+         * Constructor. In contrast to the previous constructor, the samples
+         * this object needs to keep are stored in the given LagWindow
+         * object, which may be shared with other consumers connected to
+         * the same producer (see the documentation of the LagWindow class).
+         */
+        AutoCovarianceTrace(const unsigned int                      lag_length,
+                            std::shared_ptr<LagWindow<scalar_type>> window);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -314,8 +424,9 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
@@ -336,209 +447,632 @@ namespace SampleFlow
          */
         value_type get() const;
 
-      private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * Append the state of the computation, i.e., the running averages
+         * for each lag along with the last `lag_length+1` samples, to the
+         * given buffer. See the section on saving and combining the state of
+         * consumers in the documentation of the Consumer base class.
          */
-        mutable std::mutex mutex;
+        void
+        save (std::vector<char> &buffer) const;
 
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same `lag_length` as the current one. Since the
+         * state includes the most recent samples, the object can then simply
+         * continue processing the samples that follow.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the running averages of another object with the ones of
+         * the current object. This is meant for objects that have processed
+         * independent chains: The result is the weighted average of the
+         * autocovariances the two objects have computed, with the pairs of
+         * samples of both chains contributing to each lag but not the pairs
+         * that would straddle the end of one chain and the beginning of the
+         * other. The current object continues to compute pairs from the
+         * last samples *it* has seen. Both objects need to use the same
+         * `lag_length`.
+         */
+        void
+        merge (const AutoCovarianceTrace &other);
+
+      private:
         /**
          * Describes the maximal lag up to which we calculate auto-covariances.
          */
         const unsigned int max_lag;
 
         /**
-         * The current value of $\bar{x}_k$ as described in the introduction
-         * of this class. For more detailed description of calculation, check mean_value.h
+         * The window that stores the samples, and the number this object
+         * has as a reader of it.
          */
-        InputType current_mean;
+        const std::shared_ptr<LagWindow<scalar_type>> window;
+        const unsigned int                            reader;
 
         /**
-         * A data type used to store the past few samples.
+         * The number of lags times the number of elements of samples above
+         * which get() computes the values for different lags in parallel.
          */
-        using PreviousSamples = std::deque<InputType>;
+        static constexpr std::size_t parallel_get_threshold = 1 << 16;
 
         /**
-         * Update variables necessary to compute the autocovariation. See their
-         * definition in the documentation of this class.
+         * The number of lags times the number of elements of samples above
+         * which processing a sample updates the running averages for
+         * different lags in parallel. See for_each_lag_block().
          */
-        std::vector<scalar_type> alpha;
-        std::vector<InputType> beta;
+        static constexpr std::size_t parallel_consume_threshold = 1 << 18;
 
         /**
-         * Save previous samples needed to do calculations when a new sample
-         * comes in.
+         * Call `f(begin,end)` for contiguous ranges of lags that together
+         * make up the range $[0,n)$. If `n` times the number of elements
+         * `size` of samples exceeds parallel_consume_threshold, then the
+         * ranges are processed in parallel on ThreadPool::default_pool(),
+         * unless it has only one worker thread. Otherwise, `f(0,n)` is
+         * called on the current thread.
          *
-         * These samples are stored in a double-ended queue (`std::deque`) so
-         * that it is efficient to push a new sample to the front of the list
-         * as well as to remove one from the end of the list.
+         * Processing one sample updates the running averages of each lag
+         * independently of those of all other lags, and for large samples
+         * and many lags, there is then enough work in a single sample to
+         * keep several threads busy. Since each thread works on a block of
+         * successive lags, the entries of `alpha` and of the weights of
+         * neighboring lags are mostly updated by the same thread.
+         */
+        static
+        void
+        for_each_lag_block (const std::size_t n,
+                            const std::size_t size,
+                            const std::function<void (const std::size_t, const std::size_t)> &f);
+
+        /**
+         * The type of the samples this class computes with. If `InputType`
+         * is a handle to a sample (see Concepts::is_sample_handle), this is
+         * the type of the sample it refers to, and `InputType` otherwise.
+         */
+        using sample_type = types::HandledType<InputType>;
+
+        /**
+         * A data type used to store the past few samples, as handles to
+         * the samples stored in the window.
+         */
+        using PreviousSamples = RingBuffer<typename LagWindow<scalar_type>::Sample>;
+
+        /**
+         * A structure that holds all of the information that changes as
+         * samples are processed.
          */
-        PreviousSamples previous_samples;
+        struct State
+        {
+          /**
+           * The current value of $\bar{x}_k$ as described in the introduction
+           * of this class. For more detailed description of calculation, check mean_value.h
+           */
+          sample_type current_mean;
+
+          /**
+           * The total weight of the samples processed so far. If all samples
+           * have weight one, this is the number of samples.
+           */
+          double total_weight = 0;
+
+          /**
+           * Update variables necessary to compute the autocovariation. See their
+           * definition in the documentation of this class. As discussed there,
+           * these variables store the averages over all pairs of samples with
+           * a given lag, without the factor $\frac{n-l}{n-l-1}$.
+           */
+          std::vector<scalar_type> alpha;
+          std::vector<sample_type> beta;
+
+          /**
+           * The sums $P$ and $P_2$ of the weights of the pairs of samples, and
+           * of their squares, that contribute to the variables above, for each
+           * lag.
+           */
+          std::vector<double> pair_weight;
+          std::vector<double> squared_pair_weight;
+
+          /**
+           * Save previous samples needed to do calculations when a new sample
+           * comes in, along with the square roots of their weights.
+           *
+           * These samples are stored in ring buffers with room for
+           * `max_lag+1` samples that are set up when the first sample
+           * arrives. The samples themselves are stored in the LagWindow
+           * object, and the ring buffer only holds handles to them. Copying
+           * the state, as CopyOnWrite does whenever get() has taken a
+           * snapshot, therefore does not copy the samples.
+           */
+          PreviousSamples    previous_samples;
+          RingBuffer<double> previous_sqrt_weights;
+
+          /**
+           * Update the variables above with the given sample, which stands
+           * for `n_repetitions` consecutive samples with the given weight.
+           * `stored_sample` is the copy of the sample in the window.
+           */
+          void
+          add_sample (const sample_type                            &sample,
+                      const typename LagWindow<scalar_type>::Sample &stored_sample,
+                      const types::sample_index                     n_repetitions,
+                      const double                                  weight,
+                      const unsigned int                            max_lag);
+
+          /**
+           * Update the variables above with one sample with the given weight.
+           */
+          void
+          add_one_sample (const sample_type                            &sample,
+                          const typename LagWindow<scalar_type>::Sample &stored_sample,
+                          const double                                  weight);
+
+          /**
+           * Add `n_pairs` copies of the pair of samples `later_sample`,
+           * `earlier_sample` with lag `l` and pair weight `weight` each to
+           * the running averages for this lag.
+           */
+          void
+          add_pairs (const unsigned int                 l,
+                     const std::span<const scalar_type> later_sample,
+                     const std::span<const scalar_type> earlier_sample,
+                     const double                       weight,
+                     const types::sample_index          n_pairs);
+
+          /**
+           * Update the running mean with the given sample and (total) weight.
+           */
+          void
+          add_to_mean (const sample_type &sample,
+                       const double     weight);
+
+          /**
+           * Combine the running averages of the argument with the ones
+           * stored in the current object, as described in the documentation
+           * of AutoCovarianceTrace::merge().
+           */
+          void
+          merge (const State &other);
+        };
 
         /**
-         * The number of samples processed so far.
+         * The current state of the computation. It is stored in a
+         * CopyOnWrite object so that get() can compute the autocovariances
+         * from a snapshot of the state, without holding up threads that
+         * send samples to this object.
          */
-        types::sample_index n_samples;
+        CopyOnWrite<State> state;
     };
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     AutoCovarianceTrace<InputType>::
     AutoCovarianceTrace (unsigned int lag_length)
       :
-      Consumer<InputType>(ParallelMode::synchronous),
+      AutoCovarianceTrace (lag_length, std::make_shared<LagWindow<scalar_type>>())
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    AutoCovarianceTrace<InputType>::
+    AutoCovarianceTrace (const unsigned int                      lag_length,
+                         std::shared_ptr<LagWindow<scalar_type>> window)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
       max_lag(lag_length),
-      n_samples (0)
+      window (std::move(window)),
+      reader (this->window->attach())
     {}
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     AutoCovarianceTrace<InputType>::
     ~AutoCovarianceTrace ()
     {
       this->disconnect_and_flush();
+      window->detach (reader);
     }
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     void
     AutoCovarianceTrace<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      state.modify ([&](State &current_state)
+      {
+        // Every sample needs to be inserted into the window, even if it
+        // carries no weight, so that the samples of all readers of the
+        // window remain in step:
+        const typename LagWindow<scalar_type>::Sample stored_sample
+          = window->insert (reader, sample);
+        current_state.add_sample (Utilities::dereference_sample (sample), stored_sample,
+                                  aux_data.n_repetitions(), aux_data.weight(),
+                                  max_lag);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::State::
+    add_sample (const sample_type                            &sample,
+                const typename LagWindow<scalar_type>::Sample &stored_sample,
+                const types::sample_index                     n_repetitions,
+                const double                                  weight,
+                const unsigned int                            max_lag)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      // Samples that carry no weight at all do not change anything:
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
 
-      // If this is the first sample we see, initialize all components
-      // After the first sample, the autocovariance vector
-      // is the zero vector since a single sample does not have any friends yet.
-      if (n_samples == 0)
+      // If this is the first sample we see, initialize the variables that
+      // store information for each lag:
+      if (total_weight == 0)
         {
-          // Initialize the alpha and beta vectors to a length of lag_length+1
-          // (so that we can compute the variance plus lag_length auto-variances)
-          alpha = std::vector<double>(max_lag+1, 0.);
-          beta.resize(max_lag+1);
+          alpha = std::vector<scalar_type>(max_lag+1, scalar_type(0));
+          beta.assign(max_lag+1, sample);
+          pair_weight = std::vector<double>(max_lag+1, 0.);
+          squared_pair_weight = std::vector<double>(max_lag+1, 0.);
+          previous_samples = PreviousSamples(max_lag+1);
+          previous_sqrt_weights = RingBuffer<double>(max_lag+1);
+        }
+
+      // Process the copies of the sample one at a time until the list
+      // of previous samples contains nothing but this sample:
+      const types::sample_index n_individual_copies
+        = std::min<types::sample_index> (n_repetitions, max_lag+1);
+      for (types::sample_index i=0; i<n_individual_copies; ++i)
+        add_one_sample (sample, stored_sample, weight);
+
+      // At this point, every further copy would add the pair (sample,sample)
+      // to the running averages for every lag, and would not change the list
+      // of previous samples. Add all of them at once:
+      if (n_repetitions > n_individual_copies)
+        {
+          const types::sample_index n_remaining_copies = n_repetitions - n_individual_copies;
+          for_each_lag_block (max_lag+1, stored_sample.values().size(),
+                              [&](const std::size_t begin, const std::size_t end)
+          {
+            for (std::size_t l=begin; l<end; ++l)
+              add_pairs (l, stored_sample.values(), stored_sample.values(), weight, n_remaining_copies);
+          });
+          add_to_mean (sample, n_remaining_copies * weight);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::State::
+    add_one_sample (const sample_type                            &sample,
+                    const typename LagWindow<scalar_type>::Sample &stored_sample,
+                    const double                                  weight)
+    {
+      // Save the sample. The buffers hold one more sample than the maximal
+      // lag, so if they are already full, this drops the sample whose lag
+      // to the current one would be larger than the maximal lag.
+      previous_samples.push_back (stored_sample);
+      previous_sqrt_weights.push_back (std::sqrt(weight));
+
+      // Then add the pairs this sample forms with the previous ones
+      // (including itself, for l=0). The sample with lag l relative to
+      // the current one is the l-th newest one in the buffer:
+      const std::size_t newest = previous_samples.size()-1;
+      for_each_lag_block (previous_samples.size(), stored_sample.values().size(),
+                          [&](const std::size_t begin, const std::size_t end)
+      {
+        for (std::size_t l=begin; l<end; ++l)
+          add_pairs (l, previous_samples[newest].values(), previous_samples[newest-l].values(),
+                     previous_sqrt_weights[newest] * previous_sqrt_weights[newest-l], 1);
+      });
+
+      add_to_mean (sample, weight);
+    }
+
+
 
-          for (unsigned int l=0; l<=max_lag; ++l)
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::
+    for_each_lag_block (const std::size_t n,
+                        const std::size_t size,
+                        const std::function<void (const std::size_t, const std::size_t)> &f)
+    {
+      // Splitting up the work only adds overhead if the pool cannot
+      // process more than one block at a time:
+      if ((n > 1) && (n * size > parallel_consume_threshold))
+        {
+          const std::shared_ptr<ThreadPool> thread_pool = ThreadPool::default_pool();
+          if (thread_pool->n_threads() > 1)
             {
-              // Initialize beta[i] to zero; first initialize it to 'sample'
-              // so that it has the right size already
-              beta[l] = sample;
-              for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                {
-                  Utilities::get_nth_element(beta[l], j) = 0;
-                }
+              thread_pool->for_each_chunk (n, f);
+              return;
             }
-          current_mean = sample;
+        }
+      f (0, n);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::State::
+    add_pairs (const unsigned int                 l,
+               const std::span<const scalar_type> later_sample,
+               const std::span<const scalar_type> earlier_sample,
+               const double                       weight,
+               const types::sample_index          n_pairs)
+    {
+      const bool is_first_pair = (pair_weight[l] == 0);
+
+      pair_weight[l] += n_pairs * weight;
+      squared_pair_weight[l] += n_pairs * weight * weight;
+      const double factor = n_pairs * weight / pair_weight[l];
+
+      // Update alpha and beta. For the first pair, beta is simply the sum
+      // of the two samples. Otherwise, compute the scalar product for
+      // alpha and update beta in the same loop over the elements of the
+      // samples, without creating temporary objects of type sample_type.
+      // The samples are stored contiguously in the window, and if the
+      // elements of beta are as well, these loops work on the underlying
+      // arrays. Products use Utilities::multiply() so that the loops are
+      // vectorized also for complex-valued samples.
+      scalar_type product = 0;
+      const std::size_t size = later_sample.size();
+      assert (earlier_sample.size() == size);
+      if constexpr (Concepts::has_contiguous_scalar_storage<sample_type>)
+        {
+          const auto beta_l = Utilities::as_span (beta[l]);
+          if (is_first_pair)
+            for (std::size_t j=0; j<size; ++j)
+              {
+                product += Utilities::multiply (later_sample[j], earlier_sample[j]);
+                beta_l[j] = later_sample[j] + earlier_sample[j];
+              }
+          else
+            for (std::size_t j=0; j<size; ++j)
+              {
+                product += Utilities::multiply (later_sample[j], earlier_sample[j]);
+                beta_l[j] += (later_sample[j] + earlier_sample[j] - beta_l[j]) * factor;
+              }
+        }
+      else
+        for (std::size_t j=0; j<size; ++j)
+          {
+            product += Utilities::multiply (later_sample[j], earlier_sample[j]);
+
+            auto &beta_j = Utilities::get_nth_element (beta[l], j);
+            if (is_first_pair)
+              beta_j = later_sample[j] + earlier_sample[j];
+            else
+              beta_j += (later_sample[j] + earlier_sample[j] - beta_j) * factor;
+          }
+      alpha[l] += factor * (product - alpha[l]);
+    }
 
-          // Push the first sample to the front of the list of samples:
-          previous_samples.push_front (sample);
-          n_samples = 1;
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::State::
+    add_to_mean (const sample_type &sample,
+                 const double     weight)
+    {
+      if (total_weight == 0)
+        {
+          total_weight = weight;
+          current_mean = sample;
         }
       else
         {
-          // Now save the sample. If the list is becoming longer than the lag
-          // length (plus one, for l=0), drop the oldest sample at the end of this
-          // block. This makes sure that we always have all samples up to a lag of l+1
-          // available, which we need for the initialization step
-          previous_samples.push_front (sample);
+          total_weight += weight;
+
+          Utilities::update_running_mean (current_mean, sample, weight / total_weight);
+        }
+    }
+
 
-          for (unsigned int l=0; l<=max_lag; ++l)
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::State::
+    merge (const State &other)
+    {
+      // Merging with an empty set of samples does not change anything,
+      // and merging an empty set with another set simply yields the
+      // other set:
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      // For each lag, form the weighted average of the running averages
+      // of the pairs of samples with this lag, in the same way as add_pairs()
+      // adds a single pair:
+      assert (alpha.size() == other.alpha.size());
+      for (unsigned int l=0; l<alpha.size(); ++l)
+        {
+          if (other.pair_weight[l] == 0)
+            continue;
+
+          if (pair_weight[l] == 0)
             {
-              if (n_samples == l+1)
-                {
-                  // We need to initialize alpha via the formula
-                  // alpha_{l+2}(l) = sum_{t=1}^2 x_{t+l} x_t
-                  alpha[l] = 0;
-                  for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                    alpha[l] += Utilities::get_nth_element (previous_samples[0], j) *
-                                Utilities::get_nth_element (previous_samples[l], j);
-                  for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                    alpha[l] += Utilities::get_nth_element (previous_samples[1], j) *
-                                Utilities::get_nth_element (previous_samples[l+1], j);
-
-                  beta[l] = previous_samples[0];
-                  beta[l] += previous_samples[1];
-                  beta[l] += previous_samples[l];
-                  beta[l] += previous_samples[l+1];
-                }
-              else if (n_samples >= l+2)
-                {
-                  // Update alpha
-                  double alphaupd = -alpha[l];
-                  for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                    {
-                      alphaupd += Utilities::get_nth_element (sample, j) *
-                                  Utilities::get_nth_element (previous_samples[l], j);
-                    }
-                  alphaupd *= 1./(n_samples-l);
-                  alpha[l] += alphaupd;
-
-                  // Update beta. Start with the current sample and add up
-                  // the updates.
-                  InputType betaupd = sample;
-                  for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                    {
-                      Utilities::get_nth_element(betaupd, j)
-                      += Utilities::get_nth_element (previous_samples[l], j);
-
-                      Utilities::get_nth_element(betaupd, j)
-                      -= Utilities::get_nth_element (beta[l], j);
-
-                      Utilities::get_nth_element(betaupd, j)
-                      *= 1./(n_samples-l);
-                    }
-                  beta[l] += betaupd;
-                }
+              alpha[l] = other.alpha[l];
+              beta[l]  = other.beta[l];
             }
+          else
+            {
+              const double factor = other.pair_weight[l] / (pair_weight[l] + other.pair_weight[l]);
+              alpha[l] += factor * (other.alpha[l] - alpha[l]);
 
-          if (previous_samples.size() > max_lag+1)
-            previous_samples.pop_back ();
-          ++n_samples;
+              Utilities::update_running_mean (beta[l], other.beta[l], factor);
+            }
 
-          // Then also update the running mean:
-          InputType update = sample;
-          update -= current_mean;
-          update /= n_samples;
-          current_mean += update;
+          pair_weight[l]         += other.pair_weight[l];
+          squared_pair_weight[l] += other.squared_pair_weight[l];
         }
+
+      // Then also combine the means:
+      total_weight += other.total_weight;
+
+      Utilities::update_running_mean (current_mean, other.current_mean,
+                                      other.total_weight / total_weight);
     }
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     typename AutoCovarianceTrace<InputType>::value_type
     AutoCovarianceTrace<InputType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      // Get a snapshot of the current state, and compute the
+      // autocovariances from it without holding up anyone who
+      // wants to process samples in the meantime:
+      const std::shared_ptr<const State> state = this->state.snapshot();
 
       std::vector<scalar_type> current_autocovariation(max_lag+1,
                                                        scalar_type(0));
 
-      for (int l=0; l<=max_lag; ++l)
-        {
-          current_autocovariation[l] = alpha[l];
-
-          for (unsigned int j=0; j<Utilities::size(current_mean); ++j)
-            current_autocovariation[l] -= Utilities::get_nth_element(current_mean,j) *
-                                          Utilities::get_nth_element(beta[l], j);
-
-          if (n_samples > l+1 )
-            for (unsigned int j=0; j<Utilities::size(current_mean); ++j)
-              current_autocovariation[l] += (1. + 1./(n_samples-l-1))
-                                            *
-                                            Utilities::get_nth_element(current_mean,j) *
-                                            Utilities::get_nth_element(current_mean,j);
-        }
+      // We can only compute the autocovariance for a lag l if we have seen
+      // at least two pairs of samples with this lag (or, with weights, if
+      // P-P_2/P is positive):
+      if (state->total_weight == 0)
+        return current_autocovariation;
+
+      // The term mean^T mean is the same for all lags:
+      const unsigned int size = Utilities::size(state->current_mean);
+      scalar_type mean_norm_square = 0;
+      for (unsigned int j=0; j<size; ++j)
+        mean_norm_square += Utilities::multiply (Utilities::get_nth_element(state->current_mean,j),
+                                                 Utilities::get_nth_element(state->current_mean,j));
+
+      // The values for the different lags can be computed independently.
+      // If there is enough work, do so in parallel:
+      const auto compute_lags = [&](const std::size_t begin, const std::size_t end)
+      {
+        for (std::size_t l=begin; l<end; ++l)
+          {
+            const double normalization
+              = (state->pair_weight[l] > 0
+                 ?
+                 state->pair_weight[l] - state->squared_pair_weight[l] / state->pair_weight[l]
+                 :
+                 0.);
+            if (normalization <= 0)
+              continue;
+
+            current_autocovariation[l] = state->alpha[l];
+
+            for (unsigned int j=0; j<size; ++j)
+              current_autocovariation[l] -= Utilities::multiply (Utilities::get_nth_element(state->current_mean,j),
+                                                                 Utilities::get_nth_element(state->beta[l], j));
+
+            current_autocovariation[l] += mean_norm_square;
+
+            current_autocovariation[l] *= state->pair_weight[l] / normalization;
+          }
+      };
+
+      if ((max_lag > 0) && (std::size_t(max_lag+1) * size > parallel_get_threshold))
+        ThreadPool::default_pool()->for_each_chunk (max_lag+1, compute_lags);
+      else
+        compute_lags (0, max_lag+1);
 
       return current_autocovariation;
     }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::shared_ptr<const State> state = this->state.snapshot();
+
+      Serialization::write (buffer, max_lag);
+      Serialization::write (buffer, state->current_mean);
+      Serialization::write (buffer, state->total_weight);
+      Serialization::write (buffer, state->alpha);
+      Serialization::write (buffer, state->beta);
+      Serialization::write (buffer, state->pair_weight);
+      Serialization::write (buffer, state->squared_pair_weight);
+      Serialization::write (buffer, state->previous_samples);
+      Serialization::write (buffer, state->previous_sqrt_weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      unsigned int saved_max_lag;
+      Serialization::read (buffer, saved_max_lag);
+      assert (saved_max_lag == max_lag);
+
+      State new_state;
+      Serialization::read (buffer, new_state.current_mean);
+      Serialization::read (buffer, new_state.total_weight);
+      Serialization::read (buffer, new_state.alpha);
+      Serialization::read (buffer, new_state.beta);
+      Serialization::read (buffer, new_state.pair_weight);
+      Serialization::read (buffer, new_state.squared_pair_weight);
+      Serialization::read (buffer, new_state.previous_samples);
+      Serialization::read (buffer, new_state.previous_sqrt_weights);
+
+      state.modify ([&new_state](State &current_state)
+      {
+        current_state = std::move(new_state);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    void
+    AutoCovarianceTrace<InputType>::
+    merge (const AutoCovarianceTrace &other)
+    {
+      assert (other.max_lag == max_lag);
+
+      const std::shared_ptr<const State> other_state = other.state.snapshot();
+      state.modify ([&other_state](State &current_state)
+      {
+        current_state.merge (*other_state);
+      }, this->is_single_threaded() == false);
+    }
+
   }
 }
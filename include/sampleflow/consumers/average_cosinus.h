@@ -18,8 +18,14 @@
 
 #include <sampleflow/consumer.h>
 #include <sampleflow/types.h>
-#include <list>
+#include <sampleflow/concepts.h>
+#include <sampleflow/lag_window.h>
+#include <sampleflow/ring_buffer.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <mutex>
+#include <ranges>
 
 #include <eigen3/Eigen/Dense>
 
@@ -34,19 +34,45 @@ namespace SampleFlow
      * Every time, for updating we calculate corresponding fractions. There numerator is the dot product, while denominator -
      * multiplied those two vector norms.
      *
+     * ### Implementation ###
+     *
+     * The last $L+1$ samples, including the current one, are kept in a
+     * RingBuffer of handles to samples stored in a LagWindow object, which
+     * stores the elements of each sample contiguously. The norm of each
+     * sample is computed once when the sample is stored, rather than again
+     * for every lag it is compared with. Processing a sample therefore costs
+     * one dot product with each of the $L$ previous samples, computed by
+     * Eigen on contiguous memory (and so using vector instructions where
+     * available) regardless of how `InputType` stores its elements.
+     *
+     * The LagWindow object can be shared with other consumers that compare
+     * samples with earlier ones, such as AutoCovarianceTrace and
+     * AutoCovarianceMatrix, if they are connected to the same producer: In
+     * that case, each sample is only copied once, and all of these consumers
+     * refer to the same copy. See the constructor that takes a LagWindow
+     * object as argument. If the samples are handles to samples stored
+     * contiguously (see Concepts::is_sample_handle), as created by a
+     * Filters::MakeShared object, then the window does not copy them at
+     * all but keeps the handles.
+     *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Because the result depends on the order in which samples
+     * are processed, the class supports ParallelMode::dedicated_thread but
+     * not ParallelMode::asynchronous. The former moves the work of this
+     * class off the thread on which samples are generated.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$. In
      *   order to compute covariances, the same kind of requirements
-     *   have to hold as listed for the MeanValue class.
+     *   have to hold as listed for the MeanValue class. `InputType` may
+     *   also be a handle `std::shared_ptr<const T>` to samples of such a
+     *   type `T`.
      */
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     class AverageCosineBetweenSuccessiveSamples: public Consumer<InputType>
     {
       public:
@@ -54,17 +80,29 @@ namespace SampleFlow
          * The data type of the elements of the input type. This type is used to define type of members, used in
          * calculations.
          */
-        using scalar_type = typename InputType::value_type;
+        using scalar_type = typename types::HandledType<InputType>::value_type;
 
         /**
          * Constructor.
          *
-         * This class does not support asynchronous processing of samples,
-         * and consequently calls the base class constructor with
-         * ParallelMode::synchronous as argument.
+         * This class needs to process samples in the order in which they
+         * were generated, and consequently does not support asynchronous
+         * processing of samples on a thread pool. It can, however, work on
+         * its own thread, and so calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::dedicated_thread` as
+         * argument.
          */
         AverageCosineBetweenSuccessiveSamples(const unsigned int length);
 
+        /**
+         * Constructor. In contrast to the previous constructor, the samples
+         * this object needs to keep are stored in the given LagWindow
+         * object, which may be shared with other consumers connected to
+         * the same producer (see the documentation of the LagWindow class).
+         */
+        AverageCosineBetweenSuccessiveSamples(const unsigned int                      length,
+                                              std::shared_ptr<LagWindow<scalar_type>> window);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -104,9 +142,9 @@ namespace SampleFlow
         mutable std::mutex mutex;
 
         /**
-         * The data type, where we save multiple set of previous samples.
+         * Describes how many values of average cosine function we calculate.
          */
-        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+        unsigned int history_length;
 
         /**
          * Current average cosine. Description of this is given above
@@ -114,118 +152,118 @@ namespace SampleFlow
         std::vector<scalar_type> current_avg_cosine;
 
         /**
-         * Save previous sample value
+         * The window that stores the samples, and the number this object
+         * has as a reader of it.
          */
-        matrix_type previous_sample;
-        matrix_type previous_sample_replace;
+        const std::shared_ptr<LagWindow<scalar_type>> window;
+        const unsigned int                            reader;
 
         /**
-         * The number of samples processed so far.
+         * The last `history_length+1` samples, and their norms.
          */
-        types::sample_index n_samples;
+        RingBuffer<typename LagWindow<scalar_type>::Sample> previous_samples;
+        RingBuffer<double>                                  previous_norms;
 
         /**
-         * Describes how many values of average cosine function we calculate.
+         * The number of samples processed so far.
          */
-        unsigned int history_length;
+        types::sample_index n_samples;
     };
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     AverageCosineBetweenSuccessiveSamples<InputType>::
     AverageCosineBetweenSuccessiveSamples (const unsigned int length)
       :
-      Consumer<InputType>(ParallelMode::synchronous),
+      AverageCosineBetweenSuccessiveSamples (length,
+                                             std::make_shared<LagWindow<scalar_type>>())
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    AverageCosineBetweenSuccessiveSamples<InputType>::
+    AverageCosineBetweenSuccessiveSamples (const unsigned int                      length,
+                                           std::shared_ptr<LagWindow<scalar_type>> window)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
       history_length(length),
+      window (std::move(window)),
+      reader (this->window->attach()),
       n_samples (0)
-
     {}
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     AverageCosineBetweenSuccessiveSamples<InputType>::
     ~AverageCosineBetweenSuccessiveSamples ()
     {
       this->disconnect_and_flush();
+      window->detach (reader);
     }
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
     void
     AverageCosineBetweenSuccessiveSamples<InputType>::
     consume (InputType sample, AuxiliaryData /*aux_data*/)
     {
-      std::lock_guard<std::mutex> lock(mutex);
-
-      // If this is the first sample we see, initialize all components
-      // After the first sample, the average cosine vector.
-      // is the zero vector since a single sample does not have any friends yet.
-
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
 
+      // If this is the first sample we see, set up the ring buffers of
+      // previous samples. The average cosine vector is the zero vector
+      // since a single sample does not have any friends yet.
       if (n_samples == 0)
         {
-          current_avg_cosine.resize(history_length);
-          n_samples = 1;
-
-          for (unsigned int i=0; i<history_length; ++i)
-            {
-              current_avg_cosine[i] = 0;
-            }
-
-          previous_sample.resize(history_length,sample.size());
-          previous_sample_replace.resize(history_length,sample.size());
-
-          for (unsigned int i=0; i<sample.size(); ++i) previous_sample(0,i) = sample[i];
-
+          current_avg_cosine.assign (history_length, 0);
+          previous_samples = RingBuffer<typename LagWindow<scalar_type>::Sample>(history_length+1);
+          previous_norms   = RingBuffer<double>(history_length+1);
         }
 
-      else
+      // Store the new sample in the window, which overwrites the oldest
+      // one in our ring buffer, and compute its norm:
+      using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+      const auto as_vector = [](const typename LagWindow<scalar_type>::Sample &x)
+      {
+        return Eigen::Map<const vector_type> (x.values().data(), x.values().size());
+      };
+
+      previous_samples.push_back (window->insert (reader, sample));
+      const auto new_sample = as_vector (previous_samples.back());
+      const double new_norm = std::sqrt (static_cast<double>(new_sample.squaredNorm()));
+      previous_norms.push_back (new_norm);
+
+      ++n_samples;
+
+      // Then update the average cosine for every lag for which we have
+      // seen enough samples. The entry with index i corresponds to a lag
+      // of i+1, and the number of pairs of samples with this lag is
+      // n_samples-i-1. The sample with this lag is the (i+1)th newest one
+      // in the ring buffer:
+      const unsigned int n_lags = std::min<types::sample_index>(n_samples-1, history_length);
+      const std::size_t  newest = previous_samples.size()-1;
+      for (unsigned int i=0; i<n_lags; ++i)
         {
-          unsigned int length1=std::min(static_cast<unsigned int>(n_samples),history_length);
-          unsigned int length2=std::min(static_cast<unsigned int>(n_samples),history_length-1);
-
-          ++n_samples;
-          for (unsigned int i=0; i<length1; ++i)
-            {
-
-              //Update first dot product (alpha)
-              double update=0,norm1=0, norm2=0;
-              for (unsigned int j=0; j<sample.size(); ++j)
-                {
-                  update += sample[j]*previous_sample(i,j);
-                  norm1 += sample[j]*sample[j];
-                  norm2 += previous_sample(i,j)*previous_sample(i,j);
-                }
-              update = update/(std::sqrt(norm1*norm2));
-              update -= current_avg_cosine[i];
-              update /= static_cast<double>(n_samples-i-1);
-              current_avg_cosine[i] += update;
-            }
-
-          //Save needed previous values
-          for (unsigned int i=0; i<length2; ++i)
-            {
-              for (unsigned int j=0; j<sample.size(); ++j)
-                {
-                  previous_sample_replace(i+1,j)=previous_sample(i,j);
-                }
-            }
-
-          for (unsigned int j=0; j<sample.size(); ++j) previous_sample_replace(0,j) = sample[j];
-          previous_sample = previous_sample_replace;
-
+          double update = new_sample.dot (as_vector (previous_samples[newest-i-1]));
+          update /= new_norm * previous_norms[newest-i-1];
+          update -= current_avg_cosine[i];
+          update /= static_cast<double>(n_samples-i-1);
+          current_avg_cosine[i] += update;
         }
     }
 
 
 
     template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    std::vector<typename InputType::value_type>
+    requires (Concepts::is_vector_space_type<types::HandledType<InputType>>)
+    std::vector<typename AverageCosineBetweenSuccessiveSamples<InputType>::scalar_type>
     AverageCosineBetweenSuccessiveSamples<InputType>::
     get () const
     {
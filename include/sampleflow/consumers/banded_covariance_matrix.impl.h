@@ -0,0 +1,447 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the entries of the covariance matrix
+     * $C$ of all samples seen so far that lie within a band of a given
+     * width around the diagonal, i.e., the entries $C_{ij}$ with
+     * $|i-j|\le b$. In particular, if the bandwidth $b$ is zero, then the
+     * class computes only the variances of the individual components of
+     * the samples.
+     *
+     * The CovarianceMatrix class computes the full $d\times d$ matrix
+     * $C$ for samples with $d$ components. This requires $O(d^2)$ memory
+     * and $O(d^2)$ operations per sample, which is not feasible if the
+     * samples have many components, as is the case, for example, if they
+     * are discretized fields. In contrast, the current class requires only
+     * $O(d(b+1))$ memory and operations per sample. This is appropriate if
+     * one knows that components far apart from each other are only
+     * weakly correlated, or if one only needs information about the
+     * variability of each component individually. (See the
+     * LowRankCovarianceMatrix class for a different approximation of the
+     * covariance matrix of high-dimensional samples that is appropriate if
+     * most of the variability of the samples lies in a low-dimensional
+     * subspace.)
+     *
+     * The entries within the band are computed with exactly the same
+     * formulas as used by the CovarianceMatrix class -- including the
+     * treatment of sample weights and repetition counts, and the way the
+     * results of different threads are combined -- and consequently
+     * agree with the corresponding entries of the matrix the
+     * CovarianceMatrix class computes.
+     *
+     * The band is returned in the format LAPACK uses for symmetric band
+     * matrices whose lower triangle is stored: get() returns a
+     * $(b+1)\times d$ matrix $B$ whose column $j$ contains the entries on
+     * and below the diagonal of column $j$ of $C$, i.e.,
+     * $B_{kj}=C_{j+k,j}$ for $0\le k\le b$ and $j+k<d$. The remaining
+     * entries of $B$ in the lower right corner are zero. The entries
+     * above the diagonal of $C$ follow from its symmetry (or, for complex
+     * samples, from the fact that $C$ is Hermitian).
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. As in the CovarianceMatrix class, each thread updates its own
+     * partial result, and get() combines them.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The
+     *   same requirements hold as listed for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class BandedCovarianceMatrix : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type of the information generated by this class, i.e., in which
+         * the band of the covariance matrix is returned.
+         */
+        using value_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] bandwidth The number $b$ of diagonals below (and
+         *   above) the main diagonal for which entries of the covariance
+         *   matrix are to be computed. If zero, only the variances of the
+         *   components of the samples are computed.
+         */
+        BandedCovarianceMatrix (const unsigned int bandwidth);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~BandedCovarianceMatrix ();
+
+        /**
+         * Process one sample by updating the previously computed entries
+         * of the covariance matrix using this one sample.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the band of the covariance matrix computed from the samples
+         * seen so far, in the format described in the documentation of this
+         * class. If no samples have been processed so far, then an empty
+         * matrix will be returned.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the diagonal of the covariance matrix, i.e., the variances
+         * of the components of the samples seen so far. This is the first
+         * row of the matrix returned by get().
+         */
+        Eigen::Matrix<scalar_type,Eigen::Dynamic,1>
+        get_diagonal () const;
+
+        /**
+         * Append the running mean, the band of the sum of outer products,
+         * and the sums of weights computed so far to the given buffer, from
+         * which load() can later restore them. See the section on saving
+         * and combining the state of consumers in the documentation of the
+         * Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the state of another object with the one of the current
+         * object, so that get() afterwards returns the band of the
+         * covariance matrix of the union of the samples both objects have
+         * received. The other object must have been created with the same
+         * bandwidth.
+         */
+        void
+        merge (const BandedCovarianceMatrix &other);
+
+      private:
+        /**
+         * The bandwidth $b$ passed to the constructor.
+         */
+        const unsigned int bandwidth;
+
+        /**
+         * A structure that describes the mean value and band of the
+         * covariance matrix over a subset of the samples processed so far,
+         * namely those processed on one shard of the `partial_covariances`
+         * variable below. It corresponds to the structure of the same name
+         * in the CovarianceMatrix class, but stores only the band of the
+         * sum of outer products $M$, in the same format in which get()
+         * returns the band of the covariance matrix.
+         */
+        struct PartialCovariance
+        {
+          InputType           current_mean;
+          value_type          current_sum_of_products;
+          double              total_weight = 0;
+          double              total_squared_weight = 0;
+
+          /**
+           * Update the mean value, band of the sum of outer products, and
+           * sums of weights with the given sample, counted `n_repetitions`
+           * times with the given weight each.
+           */
+          void
+          add_sample (InputType &&sample,
+                      const types::sample_index n_repetitions,
+                      const double weight,
+                      const unsigned int bandwidth);
+
+          /**
+           * Update the current object so that it represents the mean value
+           * and band of the covariance matrix over the samples represented
+           * by both the current object and the argument.
+           */
+          void
+          merge (const PartialCovariance &other);
+
+          /**
+           * Add `factor` times the band of the outer product of `delta`
+           * with itself to `current_sum_of_products`.
+           */
+          void
+          add_outer_product (const InputType &delta,
+                             const double factor);
+        };
+
+        /**
+         * The partial results computed by the threads that have sent
+         * samples to this object.
+         */
+        ShardedAccumulator<PartialCovariance> partial_covariances;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    BandedCovarianceMatrix<InputType>::
+    BandedCovarianceMatrix (const unsigned int bandwidth)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      bandwidth (bandwidth)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    BandedCovarianceMatrix<InputType>::
+    ~BandedCovarianceMatrix ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      partial_covariances.update ([this, &sample, &aux_data](PartialCovariance &partial_covariance)
+      {
+        partial_covariance.add_sample (std::move(sample), aux_data.n_repetitions(),
+                                       aux_data.weight(), bandwidth);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::PartialCovariance::
+    add_sample (InputType &&sample,
+                const types::sample_index n_repetitions,
+                const double weight,
+                const unsigned int bandwidth)
+    {
+      const double sample_weight = n_repetitions * weight;
+      if (sample_weight == 0)
+        return;
+
+      if (total_weight == 0)
+        {
+          total_weight = sample_weight;
+          total_squared_weight = n_repetitions * weight * weight;
+          current_sum_of_products.setZero (bandwidth+1, Utilities::size(sample));
+          current_mean = std::move(sample);
+        }
+      else
+        {
+          // Same as in CovarianceMatrix::PartialCovariance::add_sample():
+          const double combined_weight = total_weight + sample_weight;
+
+          InputType delta = std::move(sample);
+          delta -= current_mean;
+
+          add_outer_product (delta, total_weight * sample_weight / combined_weight);
+
+          Utilities::add_scaled (current_mean, delta, sample_weight / combined_weight);
+
+          total_weight = combined_weight;
+          total_squared_weight += n_repetitions * weight * weight;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::PartialCovariance::
+    merge (const PartialCovariance &other)
+    {
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      assert (other.current_sum_of_products.rows() == current_sum_of_products.rows());
+
+      const double combined_weight = total_weight + other.total_weight;
+
+      InputType delta = other.current_mean;
+      delta -= current_mean;
+
+      current_sum_of_products += other.current_sum_of_products;
+      add_outer_product (delta, total_weight * other.total_weight / combined_weight);
+
+      Utilities::add_scaled (current_mean, delta, other.total_weight / combined_weight);
+
+      total_weight = combined_weight;
+      total_squared_weight += other.total_squared_weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::PartialCovariance::
+    add_outer_product (const InputType &delta,
+                       const double factor)
+    {
+      const unsigned int size = Utilities::size(delta);
+      const unsigned int n_diagonals = current_sum_of_products.rows();
+
+      for (unsigned int j=0; j<size; ++j)
+        {
+          const auto delta_j = Utilities::conj(Utilities::get_nth_element(delta, j));
+          for (unsigned int k=0; k<std::min(n_diagonals, size-j); ++k)
+            current_sum_of_products(k,j)
+            += Utilities::multiply (Utilities::get_nth_element(delta, j+k), delta_j) * factor;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename BandedCovarianceMatrix<InputType>::value_type
+    BandedCovarianceMatrix<InputType>::
+    get () const
+    {
+      const PartialCovariance covariance = partial_covariances.merged();
+
+      // Use the same normalization as the CovarianceMatrix class:
+      const double normalization
+        = (covariance.total_weight > 0
+           ?
+           covariance.total_weight
+           - covariance.total_squared_weight / covariance.total_weight
+           :
+           0.);
+      if (normalization > 0)
+        return covariance.current_sum_of_products / normalization;
+      else
+        return covariance.current_sum_of_products;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    Eigen::Matrix<typename BandedCovarianceMatrix<InputType>::scalar_type,Eigen::Dynamic,1>
+    BandedCovarianceMatrix<InputType>::
+    get_diagonal () const
+    {
+      const value_type band = get();
+      if (band.size() == 0)
+        return {};
+      else
+        return band.row(0).transpose();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialCovariance covariance = partial_covariances.merged();
+      Serialization::write (buffer, covariance.current_mean);
+      Serialization::write (buffer, covariance.current_sum_of_products);
+      Serialization::write (buffer, covariance.total_weight);
+      Serialization::write (buffer, covariance.total_squared_weight);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialCovariance covariance;
+      Serialization::read (buffer, covariance.current_mean);
+      Serialization::read (buffer, covariance.current_sum_of_products);
+      Serialization::read (buffer, covariance.total_weight);
+      Serialization::read (buffer, covariance.total_squared_weight);
+      assert ((covariance.total_weight == 0)
+              ||
+              (covariance.current_sum_of_products.rows() == Eigen::Index(bandwidth)+1));
+      partial_covariances.reset (covariance);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    BandedCovarianceMatrix<InputType>::
+    merge (const BandedCovarianceMatrix &other)
+    {
+      assert (other.bandwidth == bandwidth);
+
+      const PartialCovariance other_covariance = other.partial_covariances.merged();
+      partial_covariances.update ([&other_covariance](PartialCovariance &partial_covariance)
+      {
+        partial_covariance.merge (other_covariance);
+      }, this->is_single_threaded() == false);
+    }
+
+  }
+}
@@ -0,0 +1,40 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_CONSUMERS_CATEGORICAL_HISTOGRAM_H
+#define SAMPLEFLOW_CONSUMERS_CATEGORICAL_HISTOGRAM_H
+
+#include <sampleflow/consumer.h>
+#include <sampleflow/sample_hash.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/types.h>
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/consumers/categorical_histogram.impl.h>
+
+#endif
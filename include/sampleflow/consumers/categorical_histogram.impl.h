@@ -0,0 +1,754 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace CategoricalHistogram
+    {
+      /**
+       * A structure that describes one category of a CategoricalHistogram:
+       * The value of the samples in it, along with their number and the sum
+       * of their weights.
+       */
+      template <typename ValueType>
+      struct Category
+      {
+        ValueType           value;
+        types::sample_index n_samples;
+        double              weight;
+      };
+
+
+      /**
+       * For a value of an integer or enumeration type, return the value as
+       * an integer, promoted to at least `int` so that `bool` and character
+       * types can be used in arithmetic.
+       */
+      template <typename ValueType>
+      requires (std::is_integral_v<ValueType> || std::is_enum_v<ValueType>)
+      auto
+      integer_value (const ValueType value)
+      {
+        if constexpr (std::is_enum_v<ValueType>)
+          return +static_cast<std::underlying_type_t<ValueType>>(value);
+        else
+          return +value;
+      }
+
+
+      /**
+       * A hash table that maps sample values to the number and weight of
+       * the samples with this value. The categories are stored in a vector
+       * in the order in which they were first seen, and the table itself
+       * uses open addressing with linear probing on an array of positions
+       * in this vector: A category is found by starting at the slot its
+       * hash value points to and walking forward until either a slot that
+       * refers to a category with the same value, or an empty slot is
+       * found. The array's size is a power of two, and it is doubled
+       * whenever it would otherwise become more than half full.
+       *
+       * Storing the categories separately from the array of slots means that
+       * sample values are only copied when a new category is created, that
+       * the sample type does not need to be default-constructible, and that
+       * iterating over all categories does not have to skip empty slots.
+       * Because categories are never removed (other than by clearing the
+       * table as a whole), there is no need for "tombstones".
+       */
+      template <typename ValueType>
+      class CategoryTable
+      {
+        public:
+          /**
+           * Constructor. Create an empty table.
+           */
+          CategoryTable ();
+
+          /**
+           * Add the given number of samples with the given sum of weights
+           * to the category with the given value, creating the category if
+           * it does not exist yet. `hash` must be the value
+           * SampleHash<ValueType> computes for `value`.
+           */
+          void
+          add (const ValueType           &value,
+               const std::size_t          hash,
+               const types::sample_index  n_samples,
+               const double               weight);
+
+          /**
+           * Return all categories, in the order in which they were first
+           * added.
+           */
+          const std::vector<Category<ValueType>> &
+          get_categories () const;
+
+        private:
+          /**
+           * A value that marks an empty slot.
+           */
+          static constexpr std::size_t empty_slot = std::numeric_limits<std::size_t>::max();
+
+          /**
+           * The categories, and the slots of the table. Each slot is either
+           * empty or stores the position of a category in `categories`.
+           */
+          std::vector<Category<ValueType>> categories;
+          std::vector<std::size_t>         slots;
+
+          /**
+           * Return the position of the slot that refers to the category with
+           * the given value or, if the table does not contain this category,
+           * of the empty slot in which it would have to be stored.
+           */
+          std::size_t
+          find_slot (const ValueType   &value,
+                     const std::size_t  hash) const;
+      };
+
+
+
+      template <typename ValueType>
+      CategoryTable<ValueType>::CategoryTable ()
+        :
+        slots (16, empty_slot)
+      {}
+
+
+
+      template <typename ValueType>
+      void
+      CategoryTable<ValueType>::add (const ValueType           &value,
+                                     const std::size_t          hash,
+                                     const types::sample_index  n_samples,
+                                     const double               weight)
+      {
+        std::size_t slot = find_slot (value, hash);
+        if (slots[slot] == empty_slot)
+          {
+            // This is a new category. If adding it would make the table
+            // more than half full, then first double its size and
+            // re-insert the existing categories:
+            if (2*(categories.size()+1) > slots.size())
+              {
+                slots.assign (2*slots.size(), empty_slot);
+                for (std::size_t c=0; c<categories.size(); ++c)
+                  slots[find_slot (categories[c].value,
+                                   SampleHash<ValueType>()(categories[c].value))] = c;
+
+                slot = find_slot (value, hash);
+              }
+
+            slots[slot] = categories.size();
+            categories.push_back (Category<ValueType> {value, 0, 0.});
+          }
+
+        categories[slots[slot]].n_samples += n_samples;
+        categories[slots[slot]].weight    += weight;
+      }
+
+
+
+      template <typename ValueType>
+      const std::vector<Category<ValueType>> &
+      CategoryTable<ValueType>::get_categories () const
+      {
+        return categories;
+      }
+
+
+
+      template <typename ValueType>
+      std::size_t
+      CategoryTable<ValueType>::find_slot (const ValueType   &value,
+                                           const std::size_t  hash) const
+      {
+        // Scramble the bits of the hash value using the finalization step
+        // of the MurmurHash3 function: For integer types, std::hash is
+        // typically the identity, and linear probing degrades badly if
+        // neighboring values end up in neighboring slots.
+        std::uint64_t h = hash;
+        h ^= (h >> 33);
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= (h >> 33);
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= (h >> 33);
+
+        const std::size_t mask = slots.size() - 1;
+        for (std::size_t slot = h & mask; ; slot = (slot+1) & mask)
+          if ((slots[slot] == empty_slot)
+              ||
+              (categories[slots[slot]].value == value))
+            return slot;
+      }
+    }
+  }
+
+
+
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that counts how often each distinct value of the
+     * samples occurs. This is the natural kind of histogram for samples
+     * that can only take discrete values -- integers, `bool`s, enumerations,
+     * or composite discrete states such as `std::vector<int>` or
+     * `std::array<bool,N>` -- for which the Histogram class is either
+     * wasteful (because it requires the sample type to be arithmetic and
+     * bins values into intervals of real numbers) or unusable.
+     *
+     * The class stores one "category" for every distinct value it has
+     * seen, in a hash table that uses the SampleHash class to compute hash
+     * values and `operator==` to compare samples. For integer and
+     * enumeration types, one can additionally give the constructor a
+     * range of values that are expected to occur; the counts for values in
+     * this range are then stored in an array indexed by the value, which
+     * avoids hashing altogether. Values outside the range are still
+     * counted, in the hash table.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. If samples carry weights (see AuxiliaryData::sample_weight),
+     * then the class also adds up the weights of the samples in each
+     * category; these can be obtained via get_weighted().
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread counts samples in its own table, stored in a
+     * ShardedAccumulator object, so that threads do not have to wait for
+     * each other; get() and get_weighted() add up the counts of all of
+     * these tables. consume_batch() computes the hash values of all samples
+     * of a batch before it acquires the lock of its thread's table, and
+     * then adds all samples in one go.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. It needs to be comparable using `operator==`, and
+     *   SampleHash needs to be able to compute hash values for it. If the
+     *   type is also totally ordered (as, for example, integers and
+     *   `std::vector<int>` are), then get() and get_weighted() return the
+     *   categories sorted by value.
+     */
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    class CategoricalHistogram : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(): A vector with one entry for
+         * each distinct value seen, consisting of the value and the number
+         * of samples with this value.
+         */
+        using value_type = std::vector<std::pair<InputType,types::sample_index>>;
+
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as `value_type`, except that the second element of each entry is
+         * the sum of the weights of the samples with this value.
+         */
+        using weighted_value_type = std::vector<std::pair<InputType,double>>;
+
+        /**
+         * Constructor. Count all values in a hash table.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         */
+        CategoricalHistogram ();
+
+        /**
+         * Constructor for integer and enumeration types. Count the values
+         * $v$ with `min_value` $\le v \le$ `max_value` in an array, and all
+         * other values in a hash table. The range should be small enough
+         * that an array with one entry per value in it fits comfortably
+         * into memory.
+         */
+        CategoricalHistogram (const InputType min_value,
+                              const InputType max_value)
+        requires (std::is_integral_v<InputType> || std::is_enum_v<InputType>);
+
+        /**
+         * Copy constructor.
+         */
+        CategoricalHistogram (const CategoricalHistogram<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~CategoricalHistogram ();
+
+        /**
+         * Process one sample by incrementing the count of its category.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a sample that the caller continues to own. Since this
+         * class only copies a sample when it is the first of its category,
+         * this avoids the copy that the base class implementation makes.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
+        /**
+         * Process a batch of samples as discussed in the documentation of
+         * this class.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `value_type` type. Only values that have been seen are
+         * returned.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `weighted_value_type` type, i.e., with the sum of the
+         * weights of the samples in each category rather than their number.
+         */
+        weighted_value_type
+        get_weighted () const;
+
+        /**
+         * Append the values seen, along with the numbers and weights of
+         * samples with these values, to the given buffer. See the section
+         * on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the counts stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another object has
+         * counted to the ones counted by the current object. Both objects
+         * must have been created with the same arguments to the
+         * constructor.
+         */
+        void
+        merge (const CategoricalHistogram &other);
+
+      private:
+        /**
+         * A structure storing the counts for the samples processed by one
+         * shard of the `partial_histograms` variable below.
+         */
+        struct PartialHistogram
+        {
+          /**
+           * The range of values counted in the arrays below, if any.
+           */
+          InputType min_value = {};
+          InputType max_value = {};
+
+          /**
+           * The numbers and weights of samples with values in the range
+           * above, indexed by the difference between the value and
+           * `min_value`. These arrays are empty if no range was given to
+           * the constructor.
+           */
+          std::vector<types::sample_index> dense_counts;
+          std::vector<double>              dense_weights;
+
+          /**
+           * The categories of values outside this range.
+           */
+          internal::CategoricalHistogram::CategoryTable<InputType> categories;
+
+          /**
+           * Add a sample with the given hash value, repetition count, and
+           * weight.
+           */
+          void
+          add_sample (const InputType           &sample,
+                      const std::size_t          hash,
+                      const types::sample_index  n_repetitions,
+                      const double               weight);
+
+          /**
+           * Return the position of `sample` in the arrays `dense_counts` and
+           * `dense_weights`, or the size of these arrays if the sample lies
+           * outside their range.
+           */
+          std::size_t
+          dense_index (const InputType &sample) const;
+
+          /**
+           * Add the counts stored in the argument to the ones stored in the
+           * current object.
+           */
+          void
+          merge (const PartialHistogram &other);
+        };
+
+        /**
+         * The counts of the threads that have sent samples to this object.
+         */
+        ShardedAccumulator<PartialHistogram> partial_histograms;
+
+        /**
+         * Return all categories with at least one sample, together from the
+         * array and the hash table of the given object, sorted by value if
+         * the sample type allows that.
+         */
+        static
+        std::vector<internal::CategoricalHistogram::Category<InputType>>
+        all_categories (const PartialHistogram &histogram);
+    };
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    CategoricalHistogram<InputType>::
+    CategoricalHistogram ()
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous)))
+    {}
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    CategoricalHistogram<InputType>::
+    CategoricalHistogram (const InputType min_value,
+                          const InputType max_value)
+    requires (std::is_integral_v<InputType> || std::is_enum_v<InputType>)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      partial_histograms ([&]()
+    {
+      assert (min_value <= max_value);
+
+      PartialHistogram histogram;
+      histogram.min_value = min_value;
+      histogram.max_value = max_value;
+
+      using internal::CategoricalHistogram::integer_value;
+      using IndexType = std::make_unsigned_t<decltype(integer_value(min_value))>;
+      const std::size_t n_values
+        = static_cast<std::size_t>(static_cast<IndexType>(integer_value(max_value))
+                                   - static_cast<IndexType>(integer_value(min_value))) + 1;
+      histogram.dense_counts.resize (n_values, 0);
+      histogram.dense_weights.resize (n_values, 0.);
+      return histogram;
+    }())
+    {}
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    CategoricalHistogram<InputType>::
+    CategoricalHistogram (const CategoricalHistogram<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      partial_histograms (o.partial_histograms)
+    {}
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    CategoricalHistogram<InputType>::
+    ~CategoricalHistogram ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      consume_by_reference (sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      const std::size_t hash   = SampleHash<InputType>()(sample);
+      const double      weight = aux_data.weight();
+      partial_histograms.update ([&](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.add_sample (sample, hash, n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      // First compute the hash values of all samples (without holding a
+      // lock), then add them to the counts:
+      std::vector<std::size_t> hashes (samples.size());
+      for (std::size_t i=0; i<samples.size(); ++i)
+        hashes[i] = SampleHash<InputType>()(samples[i]);
+
+      partial_histograms.update ([&](PartialHistogram &partial_histogram)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          {
+            const types::sample_index n_repetitions = aux_data[i].n_repetitions();
+            if (n_repetitions > 0)
+              partial_histogram.add_sample (samples[i], hashes[i], n_repetitions,
+                                            aux_data[i].weight());
+          }
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    typename CategoricalHistogram<InputType>::value_type
+    CategoricalHistogram<InputType>::
+    get () const
+    {
+      value_type return_value;
+      for (auto &category : all_categories (partial_histograms.merged()))
+        return_value.emplace_back (std::move(category.value), category.n_samples);
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    typename CategoricalHistogram<InputType>::weighted_value_type
+    CategoricalHistogram<InputType>::
+    get_weighted () const
+    {
+      weighted_value_type return_value;
+      for (auto &category : all_categories (partial_histograms.merged()))
+        return_value.emplace_back (std::move(category.value), category.weight);
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::vector<std::tuple<InputType,types::sample_index,double>> categories;
+      for (auto &category : all_categories (partial_histograms.merged()))
+        categories.emplace_back (std::move(category.value), category.n_samples, category.weight);
+
+      Serialization::write (buffer, categories);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<std::tuple<InputType,types::sample_index,double>> categories;
+      Serialization::read (buffer, categories);
+
+      // Start from an empty object with the same range of values as the
+      // current one, and add the saved categories:
+      PartialHistogram histogram = partial_histograms.merged();
+      std::fill (histogram.dense_counts.begin(), histogram.dense_counts.end(), 0);
+      std::fill (histogram.dense_weights.begin(), histogram.dense_weights.end(), 0.);
+      histogram.categories = internal::CategoricalHistogram::CategoryTable<InputType>();
+      for (const auto &[value, n_samples, weight] : categories)
+        histogram.add_sample (value, SampleHash<InputType>()(value), n_samples, weight);
+
+      partial_histograms.reset (histogram);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::
+    merge (const CategoricalHistogram &other)
+    {
+      const PartialHistogram other_histogram = other.partial_histograms.merged();
+      partial_histograms.update ([&other_histogram](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.merge (other_histogram);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    std::vector<internal::CategoricalHistogram::Category<InputType>>
+    CategoricalHistogram<InputType>::
+    all_categories (const PartialHistogram &histogram)
+    {
+      std::vector<internal::CategoricalHistogram::Category<InputType>> categories;
+
+      if constexpr (std::is_integral_v<InputType> || std::is_enum_v<InputType>)
+        for (std::size_t i=0; i<histogram.dense_counts.size(); ++i)
+          if (histogram.dense_counts[i] > 0)
+            {
+              using internal::CategoricalHistogram::integer_value;
+              using IndexType = std::make_unsigned_t<decltype(integer_value(histogram.min_value))>;
+              const InputType value
+                = static_cast<InputType>(static_cast<IndexType>(integer_value(histogram.min_value))
+                                         + static_cast<IndexType>(i));
+              categories.push_back ({value, histogram.dense_counts[i], histogram.dense_weights[i]});
+            }
+
+      for (const auto &category : histogram.categories.get_categories())
+        categories.push_back (category);
+
+      if constexpr (std::totally_ordered<InputType>)
+        std::sort (categories.begin(), categories.end(),
+                   [](const auto &a, const auto &b)
+      {
+        return a.value < b.value;
+      });
+
+      return categories;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::PartialHistogram::
+    add_sample (const InputType           &sample,
+                const std::size_t          hash,
+                const types::sample_index  n_repetitions,
+                const double               weight)
+    {
+      const std::size_t index = dense_index (sample);
+      if (index < dense_counts.size())
+        {
+          dense_counts[index]  += n_repetitions;
+          dense_weights[index] += n_repetitions * weight;
+        }
+      else
+        categories.add (sample, hash, n_repetitions, n_repetitions * weight);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    std::size_t
+    CategoricalHistogram<InputType>::PartialHistogram::
+    dense_index (const InputType &sample) const
+    {
+      if constexpr (std::is_integral_v<InputType> || std::is_enum_v<InputType>)
+        {
+          using internal::CategoricalHistogram::integer_value;
+          if (dense_counts.empty()
+              ||
+              (integer_value(sample) < integer_value(min_value))
+              ||
+              (integer_value(sample) > integer_value(max_value)))
+            return dense_counts.size();
+
+          using IndexType = std::make_unsigned_t<decltype(integer_value(sample))>;
+          return static_cast<IndexType>(integer_value(sample))
+                 - static_cast<IndexType>(integer_value(min_value));
+        }
+      else
+        return dense_counts.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::equality_comparable<InputType>)
+    void
+    CategoricalHistogram<InputType>::PartialHistogram::
+    merge (const PartialHistogram &other)
+    {
+      assert (other.dense_counts.size() == dense_counts.size());
+      for (std::size_t i=0; i<dense_counts.size(); ++i)
+        {
+          dense_counts[i]  += other.dense_counts[i];
+          dense_weights[i] += other.dense_weights[i];
+        }
+
+      for (const auto &category : other.categories.get_categories())
+        categories.add (category.value, SampleHash<InputType>()(category.value),
+                        category.n_samples, category.weight);
+    }
+  }
+}
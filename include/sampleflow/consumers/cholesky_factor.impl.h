@@ -0,0 +1,542 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that keeps track of the Cholesky factor $L$ of the
+     * covariance matrix of the samples it receives, i.e., the
+     * lower-triangular matrix for which $LL^T=C$. Samplers whose proposal
+     * distribution is shaped by the covariance of the samples seen so far
+     * need this factor: If $z$ is a vector of independent standard normal
+     * random numbers, then $Lz$ is normally distributed with covariance
+     * $C$.
+     *
+     * Computing the factor from the covariance matrix computed by the
+     * CovarianceMatrix class costs ${\cal O}(d^3)$ operations for samples
+     * with $d$ components, which is prohibitive if the factor is needed
+     * after every sample. The current class instead updates the factor
+     * with every sample, at a cost of ${\cal O}(d^2)$ operations, by
+     * exploiting that adding a sample changes the sum of outer products
+     * $S=\sum_k w_k (x_k-\bar x)(x_k-\bar x)^T$ from which the covariance
+     * matrix is computed only by a rank-one term: If the running mean is
+     * $\bar x$ and the sum of weights is $W$ before a sample $x$ with
+     * weight $w$ arrives, then
+     * @f{align*}{
+     *   S \leftarrow S + \frac{wW}{W+w} (x-\bar x)(x-\bar x)^T,
+     * @f}
+     * and the Cholesky factor of a matrix can be updated for a rank-one
+     * change of the matrix in ${\cal O}(d^2)$ operations (see the
+     * `rankUpdate()` function of Eigen's `LLT` class). Since such updates
+     * accumulate round-off, the class recomputes the factor from $S$
+     * itself every so many samples, as set in the constructor.
+     *
+     * The covariance matrix whose factor the class computes is
+     * @f{align*}{
+     *   C = \frac{1}{W_1-W_2/W_1} (S + \lambda I),
+     * @f}
+     * where $W_1$ and $W_2$ are the sums of the weights and of their
+     * squares (which for unweighted samples reduces to the usual factor
+     * $\frac{1}{n-1}$, see the CovarianceMatrix class). The regularization
+     * $\lambda\ge 0$ is set in the constructor. A positive value ensures
+     * that $C$ is positive definite, and so has a Cholesky factor, even
+     * before the class has seen $d+1$ distinct samples, or if the samples
+     * only span a subspace. Since $\lambda$ is added to $S$ rather than to
+     * $C$, its influence decays as more samples are received. With
+     * $\lambda=0$, $C$ is the same matrix CovarianceMatrix computes, and the
+     * class only provides a factor once $C$ is positive definite.
+     *
+     * A sample with $r$ repetitions (see AuxiliaryData::n_repetitions())
+     * and weight $w$ (see AuxiliaryData::weight()) is treated in the same
+     * way as in the CovarianceMatrix class.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from
+     * multiple threads. Because round-off depends on the order in which
+     * samples are processed, the class supports
+     * ParallelMode::dedicated_thread but not ParallelMode::asynchronous.
+     *
+     * consume() protects the running statistics with a mutex. The factor,
+     * on the other hand, is published after every so many samples (as set
+     * in the constructor) via a `std::atomic<std::shared_ptr>` in the same
+     * way as in the LastSample class: snapshot() and get() never wait for
+     * consume() or hold it up, and a sampler can use the object snapshot()
+     * returns for as long as it wants. Publishing the factor copies it,
+     * which costs about as much as updating it; the memory of snapshots
+     * that no one uses any more is reused for later ones.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The same
+     *   requirements hold as for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class CholeskyFactor : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type of the Cholesky factor returned by get().
+         */
+        using value_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * The type of the mean value.
+         */
+        using mean_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+
+        /**
+         * A structure that describes the information published by this
+         * class after every so many samples.
+         */
+        struct Snapshot
+        {
+          /**
+           * The lower-triangular Cholesky factor of the covariance matrix
+           * described in the class documentation. This matrix is empty if
+           * no factor is available yet, i.e., if the class has not seen
+           * enough samples for the covariance matrix to be positive
+           * definite.
+           */
+          value_type factor;
+
+          /**
+           * The mean value of the samples.
+           */
+          mean_type mean;
+
+          /**
+           * The sum of the weights of the samples the factor and mean have
+           * been computed from. For samples without weights, this is the
+           * number of samples.
+           */
+          double total_weight = 0;
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] regularization The value $\lambda\ge 0$ discussed in
+         *   the class documentation.
+         * @param[in] refactorization_interval The number of samples after
+         *   which the factor is recomputed from scratch rather than
+         *   updated, to get rid of the round-off the updates accumulate.
+         *   Recomputing the factor costs ${\cal O}(d^3)$ operations, and
+         *   so the average cost per sample remains ${\cal O}(d^2)$ as
+         *   long as this interval is at least $d$.
+         * @param[in] publication_interval The number of samples after which
+         *   the factor is published, i.e., made available to snapshot()
+         *   and get().
+         */
+        CholeskyFactor (const double              regularization = 0,
+                        const types::sample_index refactorization_interval = 1000,
+                        const types::sample_index publication_interval = 1);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~CholeskyFactor ();
+
+        /**
+         * Process one sample by updating the mean, the sum of outer
+         * products, and the Cholesky factor.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the most recently published Cholesky factor, mean, and
+         * total weight. This function does not acquire any lock, and the
+         * object pointed to is never modified.
+         */
+        std::shared_ptr<const Snapshot>
+        snapshot () const;
+
+        /**
+         * Return a copy of the most recently published Cholesky factor. If
+         * no factor is available yet, an empty matrix is returned.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Append the current mean, weights, and sum of outer products to
+         * the given buffer. See the section on saving and combining the
+         * state of consumers in the documentation of the Consumer base
+         * class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The factor is then recomputed and
+         * published.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Return an estimate of the memory used by the running statistics,
+         * the factor, and the published snapshots.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * The parameters passed to the constructor.
+         */
+        const double              regularization;
+        const types::sample_index refactorization_interval;
+        const types::sample_index publication_interval;
+
+        /**
+         * A mutex that guards all member variables below.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The running mean, the sums of the weights and of their squares,
+         * and the sum of outer products $S$, of which only the lower
+         * triangle is kept up to date.
+         */
+        mean_type  mean;
+        double     total_weight;
+        double     total_squared_weight;
+        value_type sum_of_products;
+
+        /**
+         * The Cholesky factorization of $S+\lambda I$, and whether it is
+         * valid, i.e., whether this matrix was positive definite when it
+         * was last factorized and has remained so in the updates since.
+         */
+        Eigen::LLT<value_type> factorization;
+        bool                   factorization_is_valid;
+
+        /**
+         * The number of samples since the factorization was last computed
+         * from scratch (or, if it is not valid, last attempted to be).
+         */
+        types::sample_index n_updates_since_factorization;
+
+        /**
+         * The number of samples since the factor was last published.
+         */
+        types::sample_index n_samples_since_publication;
+
+        /**
+         * The published snapshot. The variable `current_snapshot` points
+         * to the same object, and `spare_snapshot` to the one published
+         * before; its memory is reused for the next snapshot if no one
+         * uses it any more.
+         */
+        std::atomic<std::shared_ptr<const Snapshot>> published_snapshot;
+        std::shared_ptr<Snapshot>                    current_snapshot;
+        std::shared_ptr<Snapshot>                    spare_snapshot;
+
+        /**
+         * Compute the factorization of $S+\lambda I$ from scratch. The
+         * caller needs to hold the mutex.
+         */
+        void
+        refactorize ();
+
+        /**
+         * Publish the current factor, scaled to be the factor of the
+         * covariance matrix, along with the mean. The caller needs to hold
+         * the mutex.
+         */
+        void
+        publish ();
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    CholeskyFactor<InputType>::
+    CholeskyFactor (const double              regularization,
+                    const types::sample_index refactorization_interval,
+                    const types::sample_index publication_interval)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      regularization (regularization),
+      refactorization_interval (refactorization_interval),
+      publication_interval (publication_interval),
+      total_weight (0),
+      total_squared_weight (0),
+      factorization_is_valid (false),
+      n_updates_since_factorization (0),
+      n_samples_since_publication (0),
+      published_snapshot (std::make_shared<const Snapshot>())
+    {
+      assert (regularization >= 0);
+      assert (refactorization_interval >= 1);
+      assert (publication_interval >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    CholeskyFactor<InputType>::
+    ~CholeskyFactor ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    CholeskyFactor<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double              weight        = n_repetitions * aux_data.weight();
+      if (weight == 0)
+        return;
+
+      const unsigned int size = Utilities::size(sample);
+      mean_type x (size);
+      if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+        x = Eigen::Map<const mean_type> (std::ranges::data(sample), size);
+      else
+        for (unsigned int i=0; i<size; ++i)
+          x[i] = Utilities::get_nth_element (sample, i);
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      if (total_weight == 0)
+        {
+          // This is the first sample. The sum of outer products is zero,
+          // and so S+lambda*I only has a factorization if lambda>0:
+          mean                 = x;
+          total_weight         = weight;
+          total_squared_weight = weight * aux_data.weight();
+          sum_of_products      = value_type::Zero (size, size);
+          refactorize ();
+        }
+      else
+        {
+          assert (mean.size() == size);
+
+          const mean_type delta        = x - mean;
+          const double    new_weight   = total_weight + weight;
+          const double    update_scale = weight * total_weight / new_weight;
+
+          mean                 += (weight / new_weight) * delta;
+          total_weight          = new_weight;
+          total_squared_weight += weight * aux_data.weight();
+
+          if constexpr (types::is_complex<scalar_type>)
+            Utilities::add_hermitian_rank_one (sum_of_products.data(),
+                                               sum_of_products.outerStride(),
+                                               std::span<const scalar_type>(delta.data(), size),
+                                               update_scale);
+          else
+            sum_of_products.template selfadjointView<Eigen::Lower>()
+            .rankUpdate (delta, update_scale);
+
+          // Update the factorization, if we have one. If we don't have one,
+          // the matrix can only have become positive definite after at
+          // least another `size` samples, so only try again then:
+          ++n_updates_since_factorization;
+          if (factorization_is_valid)
+            {
+              factorization.rankUpdate (delta, update_scale);
+              factorization_is_valid = (factorization.info() == Eigen::Success);
+              if (n_updates_since_factorization >= refactorization_interval)
+                refactorize ();
+            }
+          else if (n_updates_since_factorization >= size)
+            refactorize ();
+        }
+
+      ++n_samples_since_publication;
+      if (n_samples_since_publication >= publication_interval)
+        publish ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    CholeskyFactor<InputType>::
+    refactorize ()
+    {
+      value_type matrix = sum_of_products.template selfadjointView<Eigen::Lower>();
+      matrix.diagonal().array() += scalar_type(regularization);
+
+      factorization.compute (matrix);
+      factorization_is_valid        = (factorization.info() == Eigen::Success);
+      n_updates_since_factorization = 0;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    CholeskyFactor<InputType>::
+    publish ()
+    {
+      // Reuse the snapshot published before the current one if no one
+      // other than this object refers to it any more. As in the
+      // CopyOnWrite class, the fence makes sure that everything its last
+      // reader did happens before we overwrite it:
+      std::shared_ptr<Snapshot> snapshot;
+      if ((spare_snapshot != nullptr) && (spare_snapshot.use_count() == 1))
+        {
+          std::atomic_thread_fence (std::memory_order_acquire);
+          snapshot = std::move(spare_snapshot);
+        }
+      else
+        snapshot = std::make_shared<Snapshot>();
+
+      // The factor of C=(S+lambda I)/normalization is the factor of
+      // S+lambda I divided by the square root of the normalization:
+      const double normalization = total_weight - total_squared_weight / total_weight;
+      if (factorization_is_valid && (normalization > 0))
+        {
+          snapshot->factor = factorization.matrixL();
+          snapshot->factor *= scalar_type(1. / std::sqrt (normalization));
+        }
+      else
+        snapshot->factor.resize (0, 0);
+      snapshot->mean         = mean;
+      snapshot->total_weight = total_weight;
+
+      published_snapshot.store (snapshot, std::memory_order_release);
+      spare_snapshot   = std::move(current_snapshot);
+      current_snapshot = std::move(snapshot);
+
+      n_samples_since_publication = 0;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::shared_ptr<const typename CholeskyFactor<InputType>::Snapshot>
+    CholeskyFactor<InputType>::
+    snapshot () const
+    {
+      return published_snapshot.load (std::memory_order_acquire);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename CholeskyFactor<InputType>::value_type
+    CholeskyFactor<InputType>::
+    get () const
+    {
+      return snapshot()->factor;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    CholeskyFactor<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+
+      Serialization::write (buffer, regularization);
+      Serialization::write (buffer, mean);
+      Serialization::write (buffer, total_weight);
+      Serialization::write (buffer, total_squared_weight);
+      Serialization::write (buffer, sum_of_products);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    CholeskyFactor<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      double saved_regularization;
+      Serialization::read (buffer, saved_regularization);
+      assert (saved_regularization == regularization);
+
+      std::lock_guard<std::mutex> lock (mutex);
+
+      Serialization::read (buffer, mean);
+      Serialization::read (buffer, total_weight);
+      Serialization::read (buffer, total_squared_weight);
+      Serialization::read (buffer, sum_of_products);
+
+      if (total_weight > 0)
+        refactorize ();
+      else
+        factorization_is_valid = false;
+      publish ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::size_t
+    CholeskyFactor<InputType>::
+    memory_consumption () const
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+
+      std::size_t memory = sizeof(*this)
+                           + Memory::memory_consumption (mean)
+                           + Memory::memory_consumption (sum_of_products)
+                           + Memory::memory_consumption (factorization.matrixLLT());
+      for (const auto &snapshot : {current_snapshot, spare_snapshot})
+        if (snapshot != nullptr)
+          memory += (sizeof(Snapshot)
+                     + Memory::memory_consumption (snapshot->factor)
+                     + Memory::memory_consumption (snapshot->mean));
+      return memory;
+    }
+  }
+}
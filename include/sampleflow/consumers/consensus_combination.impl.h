@@ -0,0 +1,640 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A class that implements the "consensus Monte Carlo" method of
+     * S. L. Scott, A. W. Blocker, F. V. Bonassi, H. A. Chipman,
+     * E. I. George, R. E. McCulloch: "Bayes and big data: The consensus
+     * Monte Carlo algorithm", International Journal of Management Science
+     * and Engineering Management, vol. 11, pp. 78-88, 2016.
+     *
+     * If the likelihood of a sample $\theta$ is a product
+     * $L(\theta)=\prod_{s=1}^S L_s(\theta)$ over $S$ "shards" of a large
+     * data set, and if the prior is $\mu_0(\theta)$, then the posterior
+     * distribution is the product of the $S$ "sub-posteriors"
+     * $\pi_s(\theta) \propto L_s(\theta)\mu_0(\theta)^{1/S}$. Each of
+     * these can be sampled independently -- for example by one
+     * Producers::MetropolisHastings object per shard, each of which only
+     * needs to evaluate the likelihood of its own part of the data -- and
+     * consensus Monte Carlo combines the $g$th samples
+     * $\theta_{1,g},\ldots,\theta_{S,g}$ of the $S$ chains into one sample
+     * @f{align*}{
+     *   \theta_g = \left(\sum_{s=1}^S W_s\right)^{-1}
+     *              \sum_{s=1}^S W_s \theta_{s,g}
+     * @f}
+     * of the posterior. If all sub-posteriors are Gaussian and the weights
+     * $W_s=\Sigma_s^{-1}$ are the inverses of their covariance matrices,
+     * then the $\theta_g$ are exactly distributed according to the
+     * posterior; otherwise, they are an approximation that becomes better
+     * the more data each shard contains.
+     *
+     * An object of this class has one input per shard, returned by
+     * shard(), which is a Consumer object that can be connected to the
+     * producer that samples the corresponding sub-posterior. The object
+     * itself is a Producer: It sends the combined samples $\theta_g$ to
+     * the consumers connected to it. For each shard, the class
+     * accumulates the covariance matrix of all samples the shard has
+     * received in an object of type CovarianceMatrix, and stores the
+     * samples until the samples with the same number have arrived from
+     * all other shards. Whenever `batch_size` such aligned samples are
+     * available from every shard, they are combined with weights computed
+     * from the current covariance matrices of all shards, and the
+     * resulting `batch_size` samples are sent downstream as one batch
+     * (see Producer::issue_batch). The weights are therefore computed
+     * from all samples received so far rather than, as in the paper, from
+     * all samples of the sub-posteriors; they converge to the latter as
+     * the chains progress. The remaining aligned samples are combined by
+     * flush().
+     *
+     * The shards may send their samples from different threads at the
+     * same time; combining a batch is done on the thread that provides
+     * the last sample needed for it. The function run_shards() runs the
+     * samplers of all shards concurrently on a thread pool and then calls
+     * flush():
+     * @code
+     *   SampleFlow::Consumers::ConsensusCombination<SampleType> consensus (n_shards);
+     *   std::vector<SampleFlow::Producers::MetropolisHastings<SampleType>> samplers (n_shards);
+     *   for (unsigned int s=0; s<n_shards; ++s)
+     *     consensus.shard(s).connect_to_producer (samplers[s]);
+     *
+     *   SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+     *   mean_value.connect_to_producer (consensus);
+     *
+     *   std::vector<std::function<void ()>> shard_samplers;
+     *   for (unsigned int s=0; s<n_shards; ++s)
+     *     shard_samplers.emplace_back ([&, s]()
+     *       {
+     *         samplers[s].sample (starting_point,
+     *                             [&, s](const SampleType &x)
+     *                             {
+     *                               return log_likelihood_of_shard (s, x)
+     *                                      + log_prior (x) / n_shards;
+     *                             },
+     *                             perturb,
+     *                             n_samples);
+     *       });
+     *   consensus.run_shards (shard_samplers);
+     * @endcode
+     * Samples that arrive from one shard before the corresponding samples
+     * of the other shards are stored, and so shards that produce samples
+     * much faster than others (or that are run after others, because the
+     * pool has fewer threads than there are shards) lead to a
+     * correspondingly large memory consumption.
+     *
+     * @tparam InputType The type of the samples. It needs to be a vector
+     *   type with real-valued elements whose elements can be accessed via
+     *   Utilities::get_nth_element().
+     */
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    class ConsensusCombination : public Producer<InputType>
+    {
+      public:
+        /**
+         * The type of the elements of samples.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The different ways in which the weights $W_s$ can be computed
+         * from the covariance matrix $\Sigma_s$ of the samples of each
+         * shard.
+         */
+        enum class Weighting
+        {
+          /**
+           * Use $W_s=\Sigma_s^{-1}$, as in the paper. Combining each sample
+           * then takes ${\cal O}(Sd^2)$ operations for samples with $d$
+           * components, and computing the weights ${\cal O}(Sd^3)$
+           * operations per batch. As long as the covariance matrix of one
+           * of the shards is singular, for example because the shard has
+           * received fewer than $d+1$ distinct samples, all shards are
+           * weighted equally.
+           */
+          inverse_covariance,
+
+          /**
+           * Use the diagonal matrix $W_s=\text{diag}(\Sigma_s)^{-1}$, i.e.,
+           * weight each component of the samples of a shard by the inverse
+           * of its variance. This ignores correlations between components,
+           * but costs only ${\cal O}(Sd)$ operations per sample.
+           */
+          inverse_variance,
+
+          /**
+           * Use $W_s=I$, i.e., average the samples of all shards.
+           */
+          equal
+        };
+
+        /**
+         * A class that receives the samples of one shard.
+         */
+        class Shard : public Consumer<InputType>
+        {
+          public:
+            /**
+             * Constructor.
+             */
+            Shard (ConsensusCombination &combination,
+                   const unsigned int    shard_number);
+
+            /**
+             * Destructor.
+             */
+            virtual ~Shard ();
+
+            /**
+             * Add the sample to the covariance matrix of the shard and to
+             * the samples waiting to be combined.
+             */
+            virtual
+            void
+            consume (InputType     sample,
+                     AuxiliaryData aux_data) override;
+
+            /**
+             * Return an empty list, since this class does not look at the
+             * auxiliary data of samples. See Consumer::used_aux_data_keys().
+             */
+            virtual
+            std::optional<std::vector<AuxiliaryData::Key>>
+            used_aux_data_keys () const override;
+
+            /**
+             * Return the covariance matrix of the samples the shard has
+             * received so far.
+             */
+            typename CovarianceMatrix<InputType>::value_type
+            covariance () const;
+
+          private:
+            ConsensusCombination           &combination;
+            const unsigned int              shard_number;
+            CovarianceMatrix<InputType>     covariance_matrix;
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] n_shards The number $S$ of shards.
+         * @param[in] weighting How the weights of the shards are computed.
+         * @param[in] batch_size The number of aligned samples that are
+         *   combined at once.
+         */
+        ConsensusCombination (const unsigned int n_shards,
+                              const Weighting    weighting = Weighting::inverse_covariance,
+                              const std::size_t  batch_size = 64);
+
+        /**
+         * Destructor. Disconnects all shards from their producers. Samples
+         * that have not been combined yet are discarded.
+         */
+        virtual ~ConsensusCombination ();
+
+        /**
+         * Return the number of shards.
+         */
+        unsigned int
+        n_shards () const;
+
+        /**
+         * Return the input of the shard with the given number, to be
+         * connected to the producer of samples of this shard's
+         * sub-posterior.
+         */
+        Shard &
+        shard (const unsigned int shard_number);
+
+        /**
+         * Combine all aligned samples still waiting, i.e., as many as the
+         * shard with the fewest waiting samples has, send them downstream,
+         * and flush the consumers connected to the current object. Samples
+         * beyond these remain stored until the corresponding samples of
+         * the other shards arrive.
+         */
+        void
+        flush ();
+
+        /**
+         * Run the given functions, which are expected to run the samplers
+         * of the shards, as tasks on the given thread pool, wait for all of
+         * them to finish, and then call flush().
+         */
+        void
+        run_shards (const std::vector<std::function<void ()>> &shard_samplers,
+                    const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * Return the number of combined samples sent downstream so far.
+         */
+        types::sample_index
+        n_combined_samples () const;
+
+      private:
+        /**
+         * The way weights are computed.
+         */
+        const Weighting weighting;
+
+        /**
+         * The number of aligned samples combined at once.
+         */
+        const std::size_t batch_size;
+
+        /**
+         * The inputs of the shards.
+         */
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        /**
+         * For each shard, the samples that have not been combined yet, and
+         * a mutex that guards these queues and the counter of combined
+         * samples.
+         */
+        mutable std::mutex                  mutex;
+        std::vector<std::deque<InputType>>  waiting_samples;
+        types::sample_index                 n_combined;
+
+        /**
+         * Add a sample that has arrived from the given shard to its queue,
+         * and combine a batch if one is complete.
+         */
+        void
+        receive (const unsigned int shard_number,
+                 InputType        &&sample);
+
+        /**
+         * Take the first `n` samples out of the queue of every shard, and
+         * return them. The caller needs to hold the mutex.
+         */
+        std::vector<std::vector<InputType>>
+        take_aligned_samples (const std::size_t n);
+
+        /**
+         * Combine the given aligned samples of all shards and send the
+         * results downstream.
+         */
+        void
+        combine (std::vector<std::vector<InputType>> &&aligned_samples);
+    };
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    ConsensusCombination<InputType>::Shard::
+    Shard (ConsensusCombination &combination,
+           const unsigned int    shard_number)
+      :
+      Consumer<InputType> (ParallelMode::synchronous),
+      combination (combination),
+      shard_number (shard_number)
+    {}
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    ConsensusCombination<InputType>::Shard::
+    ~Shard ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    ConsensusCombination<InputType>::Shard::
+    consume (InputType     sample,
+             AuxiliaryData /*aux_data*/)
+    {
+      covariance_matrix.consume (sample, AuxiliaryData());
+      combination.receive (shard_number, std::move(sample));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    ConsensusCombination<InputType>::Shard::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    typename CovarianceMatrix<InputType>::value_type
+    ConsensusCombination<InputType>::Shard::
+    covariance () const
+    {
+      return covariance_matrix.get();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    ConsensusCombination<InputType>::
+    ConsensusCombination (const unsigned int n_shards,
+                          const Weighting    weighting,
+                          const std::size_t  batch_size)
+      :
+      weighting (weighting),
+      batch_size (batch_size),
+      waiting_samples (n_shards),
+      n_combined (0)
+    {
+      assert (n_shards >= 1);
+      assert (batch_size >= 1);
+
+      for (unsigned int s=0; s<n_shards; ++s)
+        shards.emplace_back (std::make_unique<Shard> (*this, s));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    ConsensusCombination<InputType>::
+    ~ConsensusCombination ()
+    {
+      for (auto &shard : shards)
+        shard->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    unsigned int
+    ConsensusCombination<InputType>::
+    n_shards () const
+    {
+      return shards.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    typename ConsensusCombination<InputType>::Shard &
+    ConsensusCombination<InputType>::
+    shard (const unsigned int shard_number)
+    {
+      assert (shard_number < shards.size());
+      return *shards[shard_number];
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    ConsensusCombination<InputType>::
+    flush ()
+    {
+      for (auto &shard : shards)
+        shard->flush();
+
+      std::vector<std::vector<InputType>> aligned_samples;
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        std::size_t n_aligned = waiting_samples[0].size();
+        for (const auto &queue : waiting_samples)
+          n_aligned = std::min (n_aligned, queue.size());
+        if (n_aligned > 0)
+          aligned_samples = take_aligned_samples (n_aligned);
+      }
+
+      if (aligned_samples.size() > 0)
+        combine (std::move(aligned_samples));
+      this->flush_consumers();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    ConsensusCombination<InputType>::
+    run_shards (const std::vector<std::function<void ()>> &shard_samplers,
+                const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      assert (thread_pool != nullptr);
+
+      ThreadPool::TaskGroup samplers;
+      for (const auto &sampler : shard_samplers)
+        samplers.run (*thread_pool,
+                      [&sampler]()
+      {
+        sampler();
+      });
+      samplers.wait();
+
+      flush ();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    ConsensusCombination<InputType>::
+    n_combined_samples () const
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      return n_combined;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    ConsensusCombination<InputType>::
+    receive (const unsigned int shard_number,
+             InputType        &&sample)
+    {
+      std::vector<std::vector<InputType>> aligned_samples;
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        waiting_samples[shard_number].emplace_back (std::move(sample));
+
+        // Only the shard whose queue just grew can have completed a
+        // batch, and only if it is now the one with the fewest samples:
+        if (waiting_samples[shard_number].size() < batch_size)
+          return;
+        for (const auto &queue : waiting_samples)
+          if (queue.size() < batch_size)
+            return;
+
+        aligned_samples = take_aligned_samples (batch_size);
+      }
+
+      combine (std::move(aligned_samples));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::vector<std::vector<InputType>>
+    ConsensusCombination<InputType>::
+    take_aligned_samples (const std::size_t n)
+    {
+      std::vector<std::vector<InputType>> aligned_samples (waiting_samples.size());
+      for (unsigned int s=0; s<waiting_samples.size(); ++s)
+        {
+          assert (waiting_samples[s].size() >= n);
+          aligned_samples[s].reserve (n);
+          for (std::size_t g=0; g<n; ++g)
+            {
+              aligned_samples[s].emplace_back (std::move(waiting_samples[s].front()));
+              waiting_samples[s].pop_front();
+            }
+        }
+      n_combined += n;
+
+      return aligned_samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::floating_point<types::ScalarType<InputType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    ConsensusCombination<InputType>::
+    combine (std::vector<std::vector<InputType>> &&aligned_samples)
+    {
+      using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+      using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+      const unsigned int n_shards  = aligned_samples.size();
+      const std::size_t  n_samples = aligned_samples[0].size();
+      const std::size_t  size      = Utilities::size (aligned_samples[0][0]);
+
+      // Compute the weights W_s of all shards, and from them the matrices
+      // A_s = (sum_s W_s)^{-1} W_s with which the samples of shard s are
+      // multiplied. For the diagonal weightings, only store the diagonals
+      // of these matrices:
+      const bool diagonal = (weighting != Weighting::inverse_covariance);
+      std::vector<matrix_type> weights (n_shards);
+      bool weights_valid = (weighting != Weighting::equal);
+      for (unsigned int s=0; (s<n_shards) && weights_valid; ++s)
+        {
+          const matrix_type covariance = shards[s]->covariance();
+          if (covariance.rows() != static_cast<Eigen::Index>(size))
+            weights_valid = false;
+          else if (diagonal)
+            {
+              if ((covariance.diagonal().array() > 0).all())
+                weights[s] = covariance.diagonal().cwiseInverse();
+              else
+                weights_valid = false;
+            }
+          else
+            {
+              const Eigen::LLT<matrix_type> factorization (covariance);
+              if (factorization.info() == Eigen::Success)
+                weights[s] = factorization.solve (matrix_type::Identity (size, size));
+              else
+                weights_valid = false;
+            }
+        }
+      if (weights_valid == false)
+        for (unsigned int s=0; s<n_shards; ++s)
+          {
+            weights[s] = (diagonal ?
+                          matrix_type (matrix_type::Ones (size, 1)) :
+                          matrix_type (matrix_type::Identity (size, size)));
+          }
+
+      {
+        matrix_type sum_of_weights = weights[0];
+        for (unsigned int s=1; s<n_shards; ++s)
+          sum_of_weights += weights[s];
+
+        if (diagonal)
+          for (unsigned int s=0; s<n_shards; ++s)
+            weights[s].array() /= sum_of_weights.array();
+        else
+          {
+            const Eigen::LLT<matrix_type> factorization (sum_of_weights);
+            for (unsigned int s=0; s<n_shards; ++s)
+              weights[s] = factorization.solve (weights[s]);
+          }
+      }
+
+      // Then combine the samples. We write the result into the sample of
+      // the first shard, whose memory we can reuse:
+      std::vector<InputType> combined_samples;
+      combined_samples.reserve (n_samples);
+      vector_type theta (size);
+      vector_type combined (size);
+      for (std::size_t g=0; g<n_samples; ++g)
+        {
+          combined.setZero();
+          for (unsigned int s=0; s<n_shards; ++s)
+            {
+              assert (static_cast<std::size_t>(Utilities::size (aligned_samples[s][g])) == size);
+              for (std::size_t i=0; i<size; ++i)
+                theta(i) = Utilities::get_nth_element (aligned_samples[s][g], i);
+
+              if (diagonal)
+                combined.array() += weights[s].col(0).array() * theta.array();
+              else
+                combined.noalias() += weights[s] * theta;
+            }
+
+          InputType &sample = aligned_samples[0][g];
+          for (std::size_t i=0; i<size; ++i)
+            Utilities::get_nth_element (sample, i) = combined(i);
+          combined_samples.emplace_back (std::move(sample));
+        }
+
+      this->issue_batch (combined_samples,
+                         std::vector<AuxiliaryData> (n_samples));
+    }
+  }
+}
@@ -17,8 +17,15 @@
 #define SAMPLEFLOW_CONSUMERS_COUNT_SAMPLES_H
 
 #include <sampleflow/consumer.h>
+#include <sampleflow/persistent_state.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
 #include <sampleflow/types.h>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <string>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumers/count_samples.impl.h>
@@ -19,13 +19,28 @@ namespace SampleFlow
   {
     /**
      * A Consumer class that simply counts how many samples it has received.
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples).
+     *
+     * If samples carry weights (see AuxiliaryData::sample_weight), then
+     * get() still returns the number of samples, but the class also keeps
+     * track of the sum $W=\sum_j w_j$ of the weights and the sum
+     * $W_2=\sum_j w_j^2$ of their squares, which are available through
+     * total_weight() and effective_sample_size(). The latter returns
+     * Kish's effective sample size $W^2/W_2$, which equals the number of
+     * samples if all weights are the same, and is the number commonly
+     * used to judge the quality of a set of importance-weighted samples.
      *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Each thread increments its own counter in a ShardedAccumulator
+     * object so that threads do not have to wait for each other, and get()
+     * adds up these counters.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$.
@@ -65,13 +80,48 @@ namespace SampleFlow
          *   not care about the actual value of the sample, it simply
          *   ignores its value.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
         consume (InputType sample, AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses, namely the repetition count and the weight of samples.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process a batch of samples by incrementing the sample counter by
+         * the number of samples in the batch.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples. As for
+         *   consume(), only the repetition counts and weights are used.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Process one sample owned by the caller. This does the same as
+         * consume(), but without requiring a copy of the sample.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
         /**
          * A function that returns the number of samples received so far.
          *
@@ -80,17 +130,125 @@ namespace SampleFlow
         value_type
         get () const;
 
+        /**
+         * Return the sum of the weights of all samples received so far. If
+         * no sample carried a weight, then this is the same as get().
+         */
+        double
+        total_weight () const;
+
+        /**
+         * Return the sum of the squares of the weights of all samples
+         * received so far. If no sample carried a weight, then this is the
+         * same as get().
+         */
+        double
+        total_squared_weight () const;
+
+        /**
+         * Return the effective sample size $W^2/W_2$ of the samples received
+         * so far, as discussed in the documentation of this class. If no
+         * samples have been received so far, then zero is returned.
+         */
+        double
+        effective_sample_size () const;
+
+        /**
+         * Append the number of samples and the sums of weights received so
+         * far to the given buffer. See the section on saving and combining
+         * the state of consumers in the documentation of the Consumer base
+         * class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the counts stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the counts of another object to the ones of the current
+         * object, as if the current object had also received all of the
+         * samples that the other object has received.
+         */
+        void
+        merge (const CountSamples &other);
+
+        /**
+         * Keep the state of this object in the memory-mapped file with the
+         * given name, updated every `interval` samples and when this object
+         * is destroyed, so that it survives if the program is terminated.
+         * If the file already contains a state written this way, for
+         * example by a run of the program that was interrupted, then this
+         * state replaces the current one of this object. See the
+         * PersistentState class for details. This function needs to be
+         * called before the object receives its first sample.
+         *
+         * @return Whether a state was restored from the file.
+         */
+        bool
+        keep_state_in_file (const std::string        &filename,
+                            const types::sample_index interval = 1);
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * A structure that holds the number of samples received so far by
+         * one shard of the `partial_counts` variable below.
+         */
+        struct PartialCount
+        {
+          /**
+           * The number of samples received so far.
+           */
+          types::sample_index n_samples = 0;
+
+          /**
+           * The sum of the weights and of the squares of the weights of the
+           * samples received so far.
+           */
+          double sum_of_weights = 0;
+          double sum_of_squared_weights = 0;
+
+          /**
+           * Add a sample with the given repetition count and weight.
+           */
+          void
+          add_sample (const types::sample_index n_repetitions,
+                      const double weight)
+          {
+            n_samples += n_repetitions;
+            sum_of_weights += n_repetitions * weight;
+            sum_of_squared_weights += n_repetitions * weight * weight;
+          }
+
+          /**
+           * Add the number of samples and weights stored in the argument to
+           * the current object.
+           */
+          void
+          merge (const PartialCount &other)
+          {
+            n_samples += other.n_samples;
+            sum_of_weights += other.sum_of_weights;
+            sum_of_squared_weights += other.sum_of_squared_weights;
+          }
+        };
+
+        /**
+         * The numbers of samples received by the threads that have sent
+         * samples to this object.
          */
-        mutable std::mutex mutex;
+        ShardedAccumulator<PartialCount> partial_counts;
 
         /**
-         * The number of samples received so far.
+         * The object that keeps the state of this object in a file, if
+         * keep_state_in_file() has been called.
          */
-        types::sample_index n_samples;
+        std::unique_ptr<PersistentState> persistent_state;
     };
 
 
@@ -101,8 +259,7 @@ namespace SampleFlow
       :
       Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
                                        |
-                                       static_cast<int>(ParallelMode::asynchronous))),
-      n_samples (0)
+                                       static_cast<int>(ParallelMode::asynchronous)))
     {}
 
 
@@ -112,6 +269,40 @@ namespace SampleFlow
     ~CountSamples ()
     {
       this->disconnect_and_flush();
+      if (persistent_state)
+        persistent_state->write();
+    }
+
+
+
+    template <typename InputType>
+    void
+    CountSamples<InputType>::
+    consume (InputType /*sample*/, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double              weight        = aux_data.weight();
+      partial_counts.update ([n_repetitions, weight](PartialCount &partial_count)
+      {
+        partial_count.add_sample (n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (1);
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    CountSamples<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
     }
 
 
@@ -119,11 +310,41 @@ namespace SampleFlow
     template <typename InputType>
     void
     CountSamples<InputType>::
-    consume (InputType /*sample*/, AuxiliaryData /*aux_data*/)
+    consume_by_reference (const InputType     &/*sample*/,
+                          const AuxiliaryData &aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double              weight        = aux_data.weight();
+      partial_counts.update ([n_repetitions, weight](PartialCount &partial_count)
+      {
+        partial_count.add_sample (n_repetitions, weight);
+      }, this->is_single_threaded() == false);
 
-      ++n_samples;
+      if (persistent_state)
+        persistent_state->samples_processed (1);
+    }
+
+
+
+    template <typename InputType>
+    void
+    CountSamples<InputType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      PartialCount batch_count;
+      for (const AuxiliaryData &a : aux_data)
+        batch_count.add_sample (a.n_repetitions(), a.weight());
+
+      partial_counts.update ([&batch_count](PartialCount &partial_count)
+      {
+        partial_count.merge (batch_count);
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (samples.size());
     }
 
 
@@ -133,9 +354,98 @@ namespace SampleFlow
     CountSamples<InputType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      return partial_counts.merged().n_samples;
+    }
+
+
+
+    template <typename InputType>
+    double
+    CountSamples<InputType>::
+    total_weight () const
+    {
+      return partial_counts.merged().sum_of_weights;
+    }
+
+
+
+    template <typename InputType>
+    double
+    CountSamples<InputType>::
+    total_squared_weight () const
+    {
+      return partial_counts.merged().sum_of_squared_weights;
+    }
+
+
 
-      return n_samples;
+    template <typename InputType>
+    double
+    CountSamples<InputType>::
+    effective_sample_size () const
+    {
+      const PartialCount count = partial_counts.merged();
+      if (count.sum_of_squared_weights > 0)
+        return count.sum_of_weights * count.sum_of_weights / count.sum_of_squared_weights;
+      else
+        return 0;
+    }
+
+
+
+    template <typename InputType>
+    void
+    CountSamples<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, partial_counts.merged());
+    }
+
+
+
+    template <typename InputType>
+    void
+    CountSamples<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialCount count;
+      Serialization::read (buffer, count);
+      partial_counts.reset (count);
+    }
+
+
+
+    template <typename InputType>
+    bool
+    CountSamples<InputType>::
+    keep_state_in_file (const std::string        &filename,
+                        const types::sample_index interval)
+    {
+      persistent_state = std::make_unique<PersistentState> (filename,
+                                                             [this](std::vector<char> &buffer)
+      {
+        save (buffer);
+      },
+      interval);
+
+      return persistent_state->restore ([this](std::span<const char> &buffer)
+      {
+        load (buffer);
+      });
+    }
+
+
+
+    template <typename InputType>
+    void
+    CountSamples<InputType>::
+    merge (const CountSamples &other)
+    {
+      const PartialCount other_count = other.partial_counts.merged();
+      partial_counts.update ([&other_count](PartialCount &partial_count)
+      {
+        partial_count.merge (other_count);
+      }, this->is_single_threaded() == false);
     }
 
   }
@@ -16,9 +16,21 @@
 #ifndef SAMPLEFLOW_CONSUMERS_COVARIANCE_MATRIX_H
 #define SAMPLEFLOW_CONSUMERS_COVARIANCE_MATRIX_H
 
+#include <sampleflow/blocked_sample_buffer.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/parallel_mode.h>
+#include <sampleflow/persistent_state.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/thread_pool.h>
 #include <sampleflow/types.h>
+#include <cassert>
+#include <cmath>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <string>
+#include <vector>
 
 #include <eigen3/Eigen/Dense>
 
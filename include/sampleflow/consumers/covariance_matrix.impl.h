@@ -33,27 +33,140 @@ namespace SampleFlow
      * and
      * https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Online .
      *
+     * If a sample carries an entry with key AuxiliaryData::repetition_count
+     * in its auxiliary data (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples),
+     * then the sample is counted as many times as this entry says. More
+     * generally, samples can carry a weight $w_j$ (see
+     * AuxiliaryData::sample_weight), and the class then computes the
+     * weighted covariance matrix
+     * @f{align*}{
+     *   C = \frac{1}{W - W_2/W} \sum_j w_j (x_j-\bar x)(x_j-\bar x)^T,
+     * @f}
+     * where $\bar x$ is the weighted mean (see the MeanValue class),
+     * $W=\sum_j w_j$, and $W_2=\sum_j w_j^2$, with each of the copies
+     * a sample with a repetition count stands for counted separately
+     * in these sums. The normalization is the usual one for "reliability
+     * weights"; it does not change if all weights are multiplied by the
+     * same factor, and if all weights are one, it reduces to the factor
+     * $\frac{1}{k-1}$ above. To obtain this matrix, the class keeps
+     * track of the sum $M=\sum_j w_j (x_j-\bar x)(x_j-\bar x)^T$ along
+     * with $\bar x$, $W$, and $W_2$, and updates it for a sample $x$ with
+     * total weight $w$ (its weight times its repetition count) as
+     * @f{align*}{
+     *   M \leftarrow M + \frac{W w}{W+w} (x-\bar x)(x-\bar x)^T,
+     * @f}
+     * which costs no more than adding a single sample with weight one.
+     *
+     * Since $M$ is symmetric (or, for complex-valued samples, Hermitian),
+     * the class only updates the entries on and below its diagonal, and
+     * only fills the upper triangle when get() or save() is called. If
+     * the elements of the sample type are stored contiguously in memory
+     * (see Concepts::has_contiguous_storage; this is true for
+     * `std::valarray<double>` or Eigen vectors,
+     * for example), then the update is done by Eigen's optimized
+     * symmetric rank-one update rather than element by element.
+     *
+     * For such sample types, a batch of $k$ samples sent via
+     * Producer::issue_batch is not processed one sample at a time either.
+     * Rather, consume_batch() computes the weighted mean $\bar x_B$ of the
+     * batch and its sum of outer products
+     * $M_B = \sum_{j\in B} w_j (x_j-\bar x_B)(x_j-\bar x_B)^T = Y Y^T$,
+     * where the $j$th column of the $d\times k$ matrix $Y$ is
+     * $\sqrt{w_j}(x_j-\bar x_B)$, as a single symmetric rank-$k$ update,
+     * and then merges these into the current state using the formula
+     * shown in the section on the threading model below. Computing
+     * $Y Y^T$ is a matrix-matrix product that makes much better use of
+     * the processor's caches than $k$ separate rank-one updates.
+     *
+     * If the number of elements of samples is small and known at compile
+     * time (see Utilities::static_size; this is the case for
+     * `Eigen::Vector2d` or `std::array<double,3>`, for example), then the
+     * class stores $M$ in a fixed-size Eigen matrix. Processing a sample
+     * then does not allocate memory, and the compiler can unroll the
+     * update completely. get() still returns a matrix of dynamic size.
+     *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Since the covariance matrix does not depend on the order in
+     * which samples are processed, each thread updates its own running mean,
+     * covariance matrix, and number of samples, stored in a
+     * ShardedAccumulator object, so that threads do not have to wait for
+     * each other. The get() function then combines these partial results
+     * using the formula by Chan, Golub, and LeVeque (1979) (see
+     * https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm):
+     * If $M_A$ and $M_B$ are the (weighted) sums of outer products
+     * of deviations from the mean for two disjoint sets $A,B$ of samples with
+     * total weights $W_A$ and $W_B$ and mean values $\bar x_A$, $\bar x_B$,
+     * then
+     * @f{align*}{
+     *   M_{A\cup B} = M_A + M_B + \frac{W_A W_B}{W_A+W_B}
+     *                  (\bar x_B-\bar x_A)(\bar x_B-\bar x_A)^T.
+     * @f}
+     *
+     *
+     * ### Accumulating in higher precision ###
+     *
+     * As for the MeanValue class, the second template argument allows
+     * computing the mean value and the matrix $M$ in a more precise type
+     * than the one of the samples, for example
+     * `CovarianceMatrix<Eigen::VectorXf, Eigen::VectorXd>`. Each sample is
+     * then converted to the accumulator type once when it is processed
+     * (see Utilities::convert_elements()), and all arithmetic uses the
+     * scalar type of the accumulator type. For batches, the conversion is
+     * done by Eigen as part of copying the samples into the matrix $Y$.
+     *
+     *
+     * ### Lazy evaluation ###
+     *
+     * If the object is created with Evaluation::lazy as argument to the
+     * constructor, and if the elements of the accumulator type are stored
+     * contiguously, then processing a sample only appends it (converted to
+     * the scalar type of the accumulator type) and its weight to a
+     * BlockedSampleBuffer, and all of the work described above is deferred
+     * to the time get() is called. get() then splits the buffered samples
+     * into blocks of 1024 samples, computes the mean and the sum of outer
+     * products $Y Y^T$ of each block as described for batches above, on
+     * as many threads of ThreadPool::default_pool() as there are blocks,
+     * and combines the results of the blocks in the order in which the
+     * samples were received using the formula by Chan, Golub, and LeVeque
+     * below. The result is the same as the one computed in
+     * Evaluation::eager mode up to round-off.
+     *
+     * This is useful if the covariance matrix is only needed at the end,
+     * and if the samples of all chains fit into memory: The threads that
+     * generate samples then do almost no work for the current object,
+     * and the expensive part is done with matrix-matrix products that run
+     * at close to the peak speed of all processor cores, rather than with
+     * one rank-one update per sample. On the other hand, each call to
+     * get() processes all samples received so far, and so calling get()
+     * frequently is expensive. save() and merge() also need to process the
+     * buffered samples, and the state they save or merge is the same as in
+     * eager mode; load() replaces the buffered samples by the state read.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$. In
      *   order to compute covariances, the same kind of requirements
      *   have to hold as listed for the MeanValue class.
+     * @tparam AccumulatorType The C++ type in which the running mean value
+     *   is stored, and whose scalar type is the one in which the covariance
+     *   matrix is computed.
      */
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    template <typename InputType, typename AccumulatorType = InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
     class CovarianceMatrix : public Consumer<InputType>
     {
       public:
         /**
-         * The data type of the elements of the input type.
+         * The data type of the elements of the accumulator type, in which
+         * the covariance matrix is computed. By default, this is the type
+         * of the elements of the input type.
          */
-        using scalar_type = types::ScalarType<InputType>;
+        using scalar_type = types::ScalarType<AccumulatorType>;
 
         /**
          * The type of the information generated by this class, i.e., in which
@@ -67,8 +180,15 @@ namespace SampleFlow
          * This class does not care in which order samples are processed, and
          * consequently calls the base class constructor with
          * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] evaluation Whether the covariance matrix is updated
+         *   with every sample, or computed from all samples only when get()
+         *   is called. See the section on lazy evaluation in the
+         *   documentation of this class. If the elements of
+         *   `AccumulatorType` are not stored contiguously, this argument is
+         *   ignored and the class always uses Evaluation::eager.
          */
-        CovarianceMatrix ();
+        CovarianceMatrix (const Evaluation evaluation = Evaluation::eager);
 
         /**
          * Destructor. This function also makes sure that all samples this
@@ -84,14 +204,40 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
         consume (InputType     sample,
                  AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses, namely the repetition count and the weight of samples.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process a batch of samples. For sample types whose elements are
+         * stored contiguously, this function updates the covariance matrix
+         * with the whole batch at once as described in the documentation
+         * of this class; for all other types, it is the same as calling
+         * consume() for each sample.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples. As for
+         *   consume(), only the repetition counts and weights are used.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
         /**
          * A function that returns the covariance matrix computed from the
          * samples seen so far. If no samples have been processed so far, then
@@ -102,111 +248,810 @@ namespace SampleFlow
         value_type
         get () const;
 
+        /**
+         * Append the running mean, the sum of outer products $M$, and the
+         * sums of weights computed so far to the given buffer, from which
+         * load() can later restore them. See the section on saving and
+         * combining the state of consumers in the documentation of the
+         * Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the state of another object with the one of the current
+         * object, using the formula by Chan, Golub, and LeVeque shown in the
+         * documentation of this class, so that get() afterwards returns
+         * the covariance matrix of the union of the samples both objects
+         * have received.
+         */
+        void
+        merge (const CovarianceMatrix &other);
+
+        /**
+         * Keep the state of this object in the memory-mapped file with the
+         * given name, updated every `interval` samples and when this object
+         * is destroyed, so that it survives if the program is terminated.
+         * If the file already contains a state written this way, for
+         * example by a run of the program that was interrupted, then this
+         * state replaces the current one of this object. See the
+         * PersistentState class for details. This function needs to be
+         * called before the object receives its first sample.
+         *
+         * @return Whether a state was restored from the file.
+         */
+        bool
+        keep_state_in_file (const std::string        &filename,
+                            const types::sample_index interval = 1);
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * The number of rows and columns of $M$ if it is known at compile
+         * time and small enough to be stored in a fixed-size matrix, or
+         * `Eigen::Dynamic` otherwise.
+         */
+        static constexpr int static_dimension
+          = ((Utilities::static_size<AccumulatorType> != std::dynamic_extent)
+             &&
+             (Utilities::static_size<AccumulatorType> <= 16)
+             ?
+             static_cast<int>(Utilities::static_size<AccumulatorType>)
+             :
+             Eigen::Dynamic);
+
+        /**
+         * The types used to store $M$ and vectors with as many elements as
+         * samples have.
+         */
+        using sum_of_products_type = Eigen::Matrix<scalar_type,static_dimension,static_dimension>;
+        using vector_type          = Eigen::Matrix<scalar_type,static_dimension,1>;
+
+        /**
+         * Whether the class can defer its work to get() as described in the
+         * section on lazy evaluation in the documentation of this class.
+         */
+        static constexpr bool lazy_evaluation_is_supported
+          = Concepts::has_contiguous_storage<AccumulatorType,scalar_type>;
+
+        /**
+         * The type of the buffer of samples used in lazy mode.
+         */
+        using sample_buffer_type = BlockedSampleBuffer<scalar_type>;
+
+        /**
+         * A structure that describes the mean value and covariance matrix
+         * over a subset of the samples processed so far, namely those
+         * processed on one shard of the `partial_covariances` variable below.
+         */
+        struct PartialCovariance
+        {
+          /**
+           * The current value of $\bar x_k$ as described in the introduction
+           * of this class.
+           */
+          AccumulatorType     current_mean;
+
+          /**
+           * The current value of $M$, the weighted sum of outer products of
+           * deviations from the mean, as described in the introduction of
+           * this class. Only the lower triangle of this matrix is kept up
+           * to date; the entries above the diagonal are meaningless.
+           */
+          sum_of_products_type current_sum_of_products;
+
+          /**
+           * The sum of the weights $W$ and of the squares of the weights
+           * $W_2$ of the samples processed so far. If all samples have weight
+           * one, both are the number of samples.
+           */
+          double              total_weight = 0;
+          double              total_squared_weight = 0;
+
+          /**
+           * In lazy mode, the samples that have been received but not yet
+           * been included in the variables above, and a copy of the first
+           * of them converted to `AccumulatorType` that serves to create
+           * mean values of the right size.
+           */
+          sample_buffer_type  buffered_samples;
+          AccumulatorType     sample_prototype;
+
+          /**
+           * Update the mean value, sum of outer products, and sums of weights
+           * with the given sample, counted `n_repetitions` times with the
+           * given weight each.
+           */
+          void
+          add_sample (InputType &&sample,
+                      const types::sample_index n_repetitions,
+                      const double weight);
+
+          /**
+           * Update the mean value, sum of outer products, and sums of weights
+           * with all of the given samples.
+           */
+          void
+          add_batch (const std::vector<InputType>     &samples,
+                     const std::vector<AuxiliaryData> &aux_data);
+
+          /**
+           * Update the mean value, sum of outer products, and sums of weights
+           * with the samples stored in the columns of `columns`, with the
+           * given (total) weights, as one symmetric rank-$k$ update.
+           * `prototype` is an object of type `AccumulatorType` of the
+           * right size. The matrix `columns` is overwritten.
+           */
+          void
+          add_columns (Eigen::Matrix<scalar_type,static_dimension,Eigen::Dynamic> &columns,
+                       const std::vector<double> &sample_weights,
+                       const double               squared_weight,
+                       const AccumulatorType     &prototype);
+
+          /**
+           * Append a sample to `buffered_samples`, for lazy mode.
+           */
+          void
+          buffer_sample (const InputType          &sample,
+                         const types::sample_index n_repetitions,
+                         const double              weight);
+
+          /**
+           * Include all samples in `buffered_samples` into the mean value,
+           * sum of outer products, and sums of weights, and empty the
+           * buffer. The blocks of the buffer are processed in parallel.
+           */
+          void
+          evaluate_buffered_samples ();
+
+          /**
+           * Update the current object so that it represents the mean value
+           * and covariance matrix over the samples represented by both the
+           * current object and the argument.
+           */
+          void
+          merge (const PartialCovariance &other);
+
+          /**
+           * Like merge(), but only for the mean value, sum of outer
+           * products, and sums of weights, ignoring buffered samples.
+           */
+          void
+          merge_evaluated (const PartialCovariance &other);
+
+          /**
+           * Add `factor` times the outer product of `delta` with itself to
+           * the lower triangle of `current_sum_of_products`.
+           */
+          void
+          add_outer_product (const AccumulatorType &delta,
+                             const double              factor);
+
+          /**
+           * Return the full matrix $M$, i.e., `current_sum_of_products`
+           * with its upper triangle filled from the lower one, or an
+           * empty matrix if no samples have been processed.
+           */
+          value_type
+          full_sum_of_products () const;
+        };
+
+        /**
+         * The partial results computed by the threads that have sent
+         * samples to this object.
          */
-        mutable std::mutex mutex;
+        ShardedAccumulator<PartialCovariance> partial_covariances;
 
         /**
-         * The current value of $\bar x_k$ as described in the introduction
-         * of this class.
+         * Whether samples are processed right away or only when get() is
+         * called.
          */
-        InputType           current_mean;
+        const Evaluation evaluation;
 
         /**
-         * The current value of $\bar x_k$ as described in the introduction
-         * of this class.
+         * Return the merged state of all shards with the buffered samples
+         * included, i.e., the state that get() and save() work on.
          */
-        value_type current_covariance_matrix;
+        PartialCovariance
+        evaluated_state () const;
 
         /**
-         * The number of samples processed so far.
+         * The object that keeps the state of this object in a file, if
+         * keep_state_in_file() has been called.
          */
-        types::sample_index n_samples;
+        std::unique_ptr<PersistentState> persistent_state;
     };
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    CovarianceMatrix<InputType>::
-    CovarianceMatrix ()
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    CovarianceMatrix<InputType,AccumulatorType>::
+    CovarianceMatrix (const Evaluation evaluation)
       :
       Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
                                        |
                                        static_cast<int>(ParallelMode::asynchronous))),
-      n_samples (0)
+      evaluation (lazy_evaluation_is_supported ? evaluation : Evaluation::eager)
     {}
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    CovarianceMatrix<InputType>::
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    CovarianceMatrix<InputType,AccumulatorType>::
     ~CovarianceMatrix ()
     {
       this->disconnect_and_flush();
+      if (persistent_state)
+        persistent_state->write();
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      partial_covariances.update ([this, &sample, &aux_data](PartialCovariance &partial_covariance)
+      {
+        if (evaluation == Evaluation::lazy)
+          partial_covariance.buffer_sample (sample, aux_data.n_repetitions(),
+                                            aux_data.weight());
+        else
+          partial_covariance.add_sample (std::move(sample), aux_data.n_repetitions(),
+                                         aux_data.weight());
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (1);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    CovarianceMatrix<InputType,AccumulatorType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      partial_covariances.update ([this, &samples, &aux_data](PartialCovariance &partial_covariance)
+      {
+        if (evaluation == Evaluation::lazy)
+          for (std::size_t i=0; i<samples.size(); ++i)
+            partial_covariance.buffer_sample (samples[i], aux_data[i].n_repetitions(),
+                                              aux_data[i].weight());
+        else
+          partial_covariance.add_batch (samples, aux_data);
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (samples.size());
     }
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
     void
-    CovarianceMatrix<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
-    {
-      std::lock_guard<std::mutex> lock(mutex);
-
-      // If this is the first sample we see, initialize the matrix with
-      // this sample. After the first sample, the covariance matrix
-      // is the zero matrix since a single sample has a zero variance.
-      //
-      // For the overall algorithm, we also have to keep track of the mean.
-      // For this, we use the same algorithm as in the MeanValues class.
-      if (n_samples == 0)
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    add_sample (InputType &&sample,
+                const types::sample_index n_repetitions,
+                const double weight)
+    {
+      // Samples that carry no weight at all do not change anything:
+      const double sample_weight = n_repetitions * weight;
+      if (sample_weight == 0)
+        return;
+
+      // If this is the first sample we see, initialize the mean with
+      // this sample and the sum of products with zero, since a single
+      // sample (or several copies of it) has zero variance.
+      if (total_weight == 0)
         {
-          n_samples = 1;
-          current_covariance_matrix.resize (Utilities::size(sample), Utilities::size(sample));
-          current_mean = std::move(sample);
+          total_weight = sample_weight;
+          total_squared_weight = n_repetitions * weight * weight;
+          current_sum_of_products.setZero (Utilities::size(sample), Utilities::size(sample));
+          current_mean = Utilities::convert_elements<AccumulatorType> (std::move(sample));
         }
       else
         {
-          // Otherwise update the previously computed covariance by the current
-          // sample; this also requires updating the current running mean.
-          ++n_samples;
+          // Otherwise update the previously computed sum of products by the
+          // current sample; this also requires updating the current running
+          // mean. This is the same as merging with a set of samples with
+          // mean 'sample' and zero sum of products, see the merge() function.
+          const double combined_weight = total_weight + sample_weight;
 
-          InputType delta = sample;
+          AccumulatorType delta = Utilities::convert_elements<AccumulatorType> (std::move(sample));
           delta -= current_mean;
-          for (unsigned int i=0; i<Utilities::size(sample); ++i)
+
+          add_outer_product (delta, total_weight * sample_weight / combined_weight);
+
+          Utilities::add_scaled (current_mean, delta, sample_weight / combined_weight);
+
+          total_weight = combined_weight;
+          total_squared_weight += n_repetitions * weight * weight;
+        }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    add_batch (const std::vector<InputType>     &samples,
+               const std::vector<AuxiliaryData> &aux_data)
+    {
+      using input_scalar_type = types::ScalarType<InputType>;
+      if constexpr (Concepts::has_contiguous_storage<InputType,input_scalar_type>
+                    &&
+                    Concepts::has_contiguous_storage<AccumulatorType,scalar_type>)
+        {
+          using input_vector_type = Eigen::Matrix<input_scalar_type,static_dimension,1>;
+
+          // First compute the weights of the samples of the batch.
+          // Samples without weight do not contribute anything and are
+          // skipped.
+          std::vector<std::size_t> contributing_samples;
+          std::vector<double>      sample_weights;
+          double                   squared_weight = 0;
+          for (std::size_t i=0; i<samples.size(); ++i)
+            if (const double sample_weight = aux_data[i].n_repetitions() * aux_data[i].weight();
+                sample_weight != 0)
+              {
+                contributing_samples.push_back (i);
+                sample_weights.push_back (sample_weight);
+                squared_weight
+                  += aux_data[i].n_repetitions() * aux_data[i].weight() * aux_data[i].weight();
+              }
+          if (contributing_samples.empty())
+            return;
+
+          // Then copy the samples into the columns of a matrix, and let
+          // add_columns() do the rest. It needs an object of type
+          // AccumulatorType of the right size, for which we use a copy
+          // of one of the samples:
+          const unsigned int size = Utilities::size(samples[contributing_samples[0]]);
+          const std::size_t  n_samples = contributing_samples.size();
+
+          Eigen::Matrix<scalar_type,static_dimension,Eigen::Dynamic> columns (size, n_samples);
+          for (std::size_t k=0; k<n_samples; ++k)
+            {
+              const InputType &sample = samples[contributing_samples[k]];
+              assert (Utilities::size(sample) == size);
+
+              columns.col(k) = Eigen::Map<const input_vector_type> (std::ranges::data(sample), size)
+                               .template cast<scalar_type>();
+            }
+
+          add_columns (columns, sample_weights, squared_weight,
+                       Utilities::convert_elements<AccumulatorType> (samples[contributing_samples[0]]));
+        }
+      else
+        for (std::size_t i=0; i<samples.size(); ++i)
+          add_sample (InputType(samples[i]), aux_data[i].n_repetitions(),
+                      aux_data[i].weight());
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    add_columns (Eigen::Matrix<scalar_type,static_dimension,Eigen::Dynamic> &columns,
+                 const std::vector<double> &sample_weights,
+                 const double               squared_weight,
+                 const AccumulatorType     &prototype)
+    {
+      if constexpr (Concepts::has_contiguous_storage<AccumulatorType,scalar_type>)
+        {
+          assert (static_cast<std::size_t>(columns.cols()) == sample_weights.size());
+          const unsigned int size = columns.rows();
+
+          PartialCovariance batch;
+          for (const double w : sample_weights)
+            batch.total_weight += w;
+          batch.total_squared_weight = squared_weight;
+          if (batch.total_weight == 0)
+            return;
+
+          // Compute the weighted mean of the columns:
+          const Eigen::Map<const Eigen::VectorXd> weights (sample_weights.data(), sample_weights.size());
+          const vector_type batch_mean
+            = columns * (weights / batch.total_weight).template cast<scalar_type>();
+
+          // Turn the columns into the scaled deviations from the mean that
+          // form the matrix Y in the documentation of this class, and
+          // compute Y Y^T in one go. As everywhere else, only the lower
+          // triangle is computed.
+          for (Eigen::Index k=0; k<columns.cols(); ++k)
+            columns.col(k) = (columns.col(k) - batch_mean) * std::sqrt(sample_weights[k]);
+
+          batch.current_sum_of_products.setZero (size, size);
+          batch.current_sum_of_products.template selfadjointView<Eigen::Lower>()
+            .rankUpdate (columns);
+
+          // Finally store the mean in an object of type AccumulatorType,
+          // and merge the batch into the current object:
+          batch.current_mean = prototype;
+          Eigen::Map<vector_type> (std::ranges::data(batch.current_mean), size) = batch_mean;
+
+          merge_evaluated (batch);
+        }
+      else
+        assert (false);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    buffer_sample (const InputType          &sample,
+                   const types::sample_index n_repetitions,
+                   const double              weight)
+    {
+      if constexpr (Concepts::has_contiguous_storage<AccumulatorType,scalar_type>)
+        {
+          // Samples that carry no weight at all do not change anything:
+          if (n_repetitions * weight == 0)
+            return;
+
+          const unsigned int size = Utilities::size(sample);
+          if (buffered_samples.empty())
+            sample_prototype = Utilities::convert_elements<AccumulatorType> (sample);
+
+          // If the sample already stores elements of the right type
+          // contiguously, copy them straight into the buffer. Otherwise,
+          // convert the sample first:
+          if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+            buffered_samples.push_back (std::ranges::data(sample), size, n_repetitions, weight);
+          else
+            {
+              const AccumulatorType converted
+                = Utilities::convert_elements<AccumulatorType> (sample);
+              buffered_samples.push_back (std::ranges::data(converted), size, n_repetitions, weight);
+            }
+        }
+      else
+        add_sample (InputType(sample), n_repetitions, weight);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    evaluate_buffered_samples ()
+    {
+      if constexpr (Concepts::has_contiguous_storage<AccumulatorType,scalar_type>)
+        {
+          if (buffered_samples.empty())
+            return;
+
+          // Compute the contribution of each block of samples on a
+          // separate task:
+          const auto blocks = buffered_samples.blocks();
+          std::vector<PartialCovariance> block_covariances (blocks.size());
+
+          const auto evaluate_block = [this, &blocks, &block_covariances](const std::size_t b)
+          {
+            const typename sample_buffer_type::Block &block = *blocks[b];
+            const std::size_t n_samples = block.size();
+
+            std::vector<double> sample_weights (n_samples);
+            double              squared_weight = 0;
+            for (std::size_t k=0; k<n_samples; ++k)
+              {
+                sample_weights[k] = block.n_repetitions[k] * block.weights[k];
+                squared_weight += block.n_repetitions[k] * block.weights[k] * block.weights[k];
+              }
+
+            Eigen::Matrix<scalar_type,static_dimension,Eigen::Dynamic> columns
+              = Eigen::Map<const Eigen::Matrix<scalar_type,static_dimension,Eigen::Dynamic>>
+                (block.values.data(), block.dimension, n_samples);
+            block_covariances[b].add_columns (columns, sample_weights, squared_weight,
+                                              sample_prototype);
+          };
+
+          if (blocks.size() == 1)
+            evaluate_block (0);
+          else
             {
-              const auto delta_i = Utilities::get_nth_element(delta, i);
-              for (unsigned int j=0; j<Utilities::size(sample); ++j)
-                {
-                  const auto delta_j = Utilities::conj(Utilities::get_nth_element(delta, j));
-                  current_covariance_matrix(i,j) += ((delta_i*delta_j)/(1.0*n_samples)) - current_covariance_matrix(i,j)/((1.0*n_samples)-1);
-                }
+              const std::shared_ptr<ThreadPool> thread_pool = ThreadPool::default_pool();
+              ThreadPool::TaskGroup tasks;
+              for (std::size_t b=0; b<blocks.size(); ++b)
+                tasks.run (*thread_pool,
+                           [&evaluate_block, b]()
+              {
+                evaluate_block (b);
+              });
+              tasks.wait();
             }
-          InputType mean_update = sample;
-          mean_update -= current_mean;
-          mean_update /= n_samples;
-          current_mean += mean_update;
+
+          // Then combine the results in the order of the blocks, so that the
+          // result does not depend on which task finished first:
+          buffered_samples.clear();
+          for (const auto &block_covariance : block_covariances)
+            merge_evaluated (block_covariance);
+        }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    merge (const PartialCovariance &other)
+    {
+      if (buffered_samples.empty())
+        sample_prototype = other.sample_prototype;
+      buffered_samples.append (other.buffered_samples);
+
+      merge_evaluated (other);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    merge_evaluated (const PartialCovariance &other)
+    {
+      // Merging with an empty set of samples does not change anything,
+      // and merging an empty set with another set simply yields the
+      // other set:
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          current_mean            = other.current_mean;
+          current_sum_of_products = other.current_sum_of_products;
+          total_weight            = other.total_weight;
+          total_squared_weight    = other.total_squared_weight;
+          return;
         }
+
+      const double combined_weight = total_weight + other.total_weight;
+
+      // Add up the two sums of outer products of deviations from the
+      // respective mean, along with the correction term for the
+      // difference of the means:
+      AccumulatorType delta = other.current_mean;
+      delta -= current_mean;
+
+      current_sum_of_products.template triangularView<Eigen::Lower>()
+        += other.current_sum_of_products;
+      add_outer_product (delta, total_weight * other.total_weight / combined_weight);
+
+      Utilities::add_scaled (current_mean, delta, other.total_weight / combined_weight);
+
+      total_weight = combined_weight;
+      total_squared_weight += other.total_squared_weight;
     }
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    typename CovarianceMatrix<InputType>::value_type
-    CovarianceMatrix<InputType>::
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    add_outer_product (const AccumulatorType &delta,
+                       const double              factor)
+    {
+      const unsigned int size = Utilities::size(delta);
+
+      // If the elements of 'delta' are stored contiguously, we can let
+      // Eigen do the update on the memory of 'delta' directly. Otherwise,
+      // go through the elements one by one.
+      if constexpr (Concepts::has_contiguous_storage<AccumulatorType,scalar_type>)
+        {
+          const Eigen::Map<const vector_type> delta_vector (std::ranges::data(delta), size);
+
+          // For small fixed-size matrices, updating all entries is cheaper
+          // than working out which ones are in the lower triangle, and
+          // Eigen unrolls the product completely:
+          if constexpr (static_dimension != Eigen::Dynamic)
+            current_sum_of_products.noalias() += (factor * delta_vector) * delta_vector.adjoint();
+          else if constexpr (types::is_complex<scalar_type>)
+            Utilities::add_hermitian_rank_one (current_sum_of_products.data(),
+                                               current_sum_of_products.outerStride(),
+                                               Utilities::as_span (delta), factor);
+          else
+            current_sum_of_products.template selfadjointView<Eigen::Lower>()
+            .rankUpdate (delta_vector, factor);
+        }
+      else
+        // Go through the lower triangle column by column, in the order in
+        // which its entries are stored:
+        for (unsigned int j=0; j<size; ++j)
+          {
+            const auto delta_j = Utilities::conj(Utilities::get_nth_element(delta, j));
+            for (unsigned int i=j; i<size; ++i)
+              current_sum_of_products(i,j)
+              += Utilities::multiply (Utilities::get_nth_element(delta, i), delta_j) * factor;
+          }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    typename CovarianceMatrix<InputType,AccumulatorType>::value_type
+    CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance::
+    full_sum_of_products () const
+    {
+      // A fixed-size matrix has its size even before it is first used:
+      if (total_weight == 0)
+        return value_type();
+
+      return current_sum_of_products.template selfadjointView<Eigen::Lower>();
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    typename CovarianceMatrix<InputType,AccumulatorType>::value_type
+    CovarianceMatrix<InputType,AccumulatorType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      const PartialCovariance covariance = evaluated_state();
+
+      // Convert the sum of products into the covariance matrix. If we have
+      // seen fewer than two distinct samples, the normalization factor is
+      // zero, but so is the sum of products, and the covariance matrix is
+      // the zero matrix.
+      const double normalization
+        = (covariance.total_weight > 0
+           ?
+           covariance.total_weight
+           - covariance.total_squared_weight / covariance.total_weight
+           :
+           0.);
+      if (normalization > 0)
+        return covariance.full_sum_of_products() / normalization;
+      else
+        return covariance.full_sum_of_products();
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialCovariance covariance = evaluated_state();
+      Serialization::write (buffer, covariance.current_mean);
+      Serialization::write (buffer, covariance.full_sum_of_products());
+      Serialization::write (buffer, covariance.total_weight);
+      Serialization::write (buffer, covariance.total_squared_weight);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialCovariance covariance;
+      Serialization::read (buffer, covariance.current_mean);
+      value_type sum_of_products;
+      Serialization::read (buffer, sum_of_products);
+      if (sum_of_products.size() > 0)
+        covariance.current_sum_of_products = sum_of_products;
+      Serialization::read (buffer, covariance.total_weight);
+      Serialization::read (buffer, covariance.total_squared_weight);
+      partial_covariances.reset (covariance);
+    }
+
+
 
-      return current_covariance_matrix;
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    bool
+    CovarianceMatrix<InputType,AccumulatorType>::
+    keep_state_in_file (const std::string        &filename,
+                        const types::sample_index interval)
+    {
+      persistent_state = std::make_unique<PersistentState> (filename,
+                                                             [this](std::vector<char> &buffer)
+      {
+        save (buffer);
+      },
+      interval);
+
+      return persistent_state->restore ([this](std::span<const char> &buffer)
+      {
+        load (buffer);
+      });
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    CovarianceMatrix<InputType,AccumulatorType>::
+    merge (const CovarianceMatrix &other)
+    {
+      const PartialCovariance other_covariance = other.evaluated_state();
+      partial_covariances.update ([&other_covariance](PartialCovariance &partial_covariance)
+      {
+        partial_covariance.merge (other_covariance);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    typename CovarianceMatrix<InputType,AccumulatorType>::PartialCovariance
+    CovarianceMatrix<InputType,AccumulatorType>::
+    evaluated_state () const
+    {
+      // Merging the shards only concatenates their lists of buffered
+      // samples, which are then all processed together:
+      PartialCovariance covariance = partial_covariances.merged();
+      covariance.evaluate_buffered_samples();
+      return covariance;
     }
 
   }
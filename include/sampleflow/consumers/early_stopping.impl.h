@@ -0,0 +1,259 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that stops a running sampler as soon as a
+     * user-provided criterion says that enough samples have been
+     * collected. Sampling algorithms are typically asked to produce a
+     * fixed number of samples, but one often does not know ahead of time
+     * how many samples are necessary to compute the quantities of interest
+     * to the desired accuracy. A common strategy is then to ask for far
+     * more samples than one expects to need, and to stop the sampler once
+     * some convergence criterion is satisfied. This class implements this
+     * strategy: It counts the samples it receives and, every
+     * `check_interval` samples, evaluates the criterion. If the criterion
+     * returns `true`, it calls Producer::request_stop() on the producer it
+     * was given in the constructor, which then returns from its `sample()`
+     * function once it has finished its current step.
+     *
+     * The criterion is a function object without arguments. It typically
+     * queries other consumers connected to the same producer. For example,
+     * the following code stops sampling once one million samples have been
+     * generated or the estimate of the mean value has an estimated standard
+     * error (computed from the covariance matrix and the effective sample
+     * size, see the EffectiveSampleSize class) less than some tolerance:
+     * @code
+     *   Producers::MetropolisHastings<SampleType> mh_sampler;
+     *
+     *   Consumers::CountSamples<SampleType> count_samples;
+     *   count_samples.connect_to_producer (mh_sampler);
+     *
+     *   Consumers::MeanValue<SampleType> mean_value;
+     *   mean_value.connect_to_producer (mh_sampler);
+     *
+     *   Consumers::EffectiveSampleSize<SampleType> effective_sample_size;
+     *   effective_sample_size.connect_to_producer (mh_sampler);
+     *
+     *   ...
+     *
+     *   Consumers::EarlyStopping<SampleType>
+     *   early_stopping (mh_sampler,
+     *                   [&]()
+     *   {
+     *     return ((count_samples.get() >= 1000000)
+     *             ||
+     *             (estimated_standard_error (...) < tolerance));
+     *   },
+     *   1000);
+     *   early_stopping.connect_to_producer (mh_sampler);
+     *
+     *   mh_sampler.sample (starting_point, log_likelihood, perturb,
+     *                      std::numeric_limits<types::sample_index>::max());
+     * @endcode
+     *
+     * Because the producer calls connected consumers in the order in which
+     * they were connected, the EarlyStopping object should be connected
+     * after the consumers whose results the criterion queries; the
+     * criterion then sees results that already include the current sample.
+     *
+     * The producer that is asked to stop need not be the one this object
+     * is connected to. For example, if this object is connected to a
+     * Filters::TakeEveryNth filter that is in turn connected to a sampler,
+     * then the object needs to be told about the sampler rather than the
+     * filter. (Filters do not produce samples on their own, and asking
+     * them to stop has no effect.) This is why the constructor accepts a
+     * producer of arbitrary output type.
+     *
+     * Evaluating the criterion is often expensive, for example if it
+     * requires computing an autocovariance. Choosing a `check_interval`
+     * larger than one reduces this cost, at the price of producing up to
+     * `check_interval-1` samples more than necessary.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. The counter and the evaluation of the criterion are
+     * protected by a mutex, so that the criterion is never evaluated
+     * concurrently. The class only supports ParallelMode::synchronous
+     * because the criterion typically reads the state of other consumers
+     * that are expected to be up to date with the current sample by the
+     * time it is evaluated.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$.
+     */
+    template <typename InputType>
+    class EarlyStopping : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the type
+         * of the object returned by get(). This is a flag that indicates
+         * whether this object has requested the producer to stop.
+         */
+        using value_type = bool;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] producer The producer that is to be stopped once the
+         *   criterion is satisfied. This is typically, but not necessarily,
+         *   the producer this object will be connected to; see the
+         *   documentation of this class. The producer needs to live at
+         *   least as long as the current object receives samples.
+         * @param[in] stopping_criterion A function object that returns
+         *   whether enough samples have been collected.
+         * @param[in] check_interval The number of samples between
+         *   evaluations of the criterion. Must be at least one.
+         */
+        template <typename ProducerOutputType>
+        EarlyStopping (Producer<ProducerOutputType> &producer,
+                       const std::function<bool ()> &stopping_criterion,
+                       const types::sample_index check_interval = 1);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~EarlyStopping ();
+
+        /**
+         * Process one sample by incrementing the sample counter and, if
+         * it is time to do so, evaluating the criterion.
+         *
+         * @param[in] sample The sample to process. Since this class does
+         *   not care about the actual value of the sample, it simply
+         *   ignores its value.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count of the sample (see
+         *   AuxiliaryData::n_repetitions()) and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Return whether this object has asked the producer to stop.
+         */
+        value_type
+        get () const;
+
+      private:
+        /**
+         * A mutex used to lock access to all member variables below.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * A function object that calls Producer::request_stop() on the
+         * producer given to the constructor. Storing the function object,
+         * rather than a pointer to the producer, allows us to accept
+         * producers of any output type.
+         */
+        const std::function<void ()> request_stop;
+
+        /**
+         * The criterion and the interval at which it is evaluated, as
+         * given to the constructor.
+         */
+        const std::function<bool ()> stopping_criterion;
+        const types::sample_index    check_interval;
+
+        /**
+         * The number of samples received since the criterion was last
+         * evaluated.
+         */
+        types::sample_index n_samples_since_last_check;
+
+        /**
+         * Whether we have asked the producer to stop.
+         */
+        bool stop_has_been_requested;
+    };
+
+
+
+    template <typename InputType>
+    template <typename ProducerOutputType>
+    EarlyStopping<InputType>::
+    EarlyStopping (Producer<ProducerOutputType> &producer,
+                   const std::function<bool ()> &stopping_criterion,
+                   const types::sample_index check_interval)
+      :
+      Consumer<InputType>(ParallelMode::synchronous),
+      request_stop ([&producer]()
+    {
+      producer.request_stop();
+    }),
+      stopping_criterion (stopping_criterion),
+      check_interval (check_interval),
+      n_samples_since_last_check (0),
+      stop_has_been_requested (false)
+    {
+      assert (check_interval >= 1);
+    }
+
+
+
+    template <typename InputType>
+    EarlyStopping<InputType>::
+    ~EarlyStopping ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    void
+    EarlyStopping<InputType>::
+    consume (InputType /*sample*/, AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      n_samples_since_last_check += aux_data.n_repetitions();
+      if (n_samples_since_last_check < check_interval)
+        return;
+
+      n_samples_since_last_check = 0;
+      if (stopping_criterion())
+        {
+          request_stop();
+          stop_has_been_requested = true;
+        }
+    }
+
+
+
+    template <typename InputType>
+    typename EarlyStopping<InputType>::value_type
+    EarlyStopping<InputType>::
+    get () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      return stop_has_been_requested;
+    }
+  }
+}
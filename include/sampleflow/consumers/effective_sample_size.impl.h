@@ -0,0 +1,856 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that estimates, for each component of the samples,
+     * the integrated autocorrelation time
+     * @f{align*}{
+     *   \tau = 1 + 2\sum_{l=1}^\infty \rho(l)
+     * @f}
+     * where $\rho(l)$ is the autocorrelation of the component at lag $l$,
+     * along with the effective sample size $n/\tau$, i.e., the number of
+     * statistically independent samples whose mean would have the same
+     * variance as the mean of the $n$ correlated samples seen so far.
+     * Unlike computing $\tau$ from the autocovariances returned by the
+     * AutoCovarianceTrace class, the approach used here requires neither
+     * choosing a maximal lag nor storing past samples, and costs
+     * ${\cal O}(d)$ operations per sample (amortized) and
+     * ${\cal O}(d\log n)$ memory if $d$ is the number of components of
+     * each sample. This makes the class a good choice for the criterion
+     * of an EarlyStopping object: Sampling can be stopped once the
+     * effective sample size is large enough.
+     *
+     *
+     * <h3> Algorithm </h3>
+     *
+     * The class uses the method of batch means: If one splits the chain
+     * into consecutive batches of $b$ samples each, then the means of
+     * these batches have variance approximately $\tau\sigma^2/b$ once $b$
+     * is substantially larger than $\tau$, where $\sigma^2$ is the variance
+     * of the samples. An estimate of $\tau$ is then $b$ times the sample
+     * variance of the batch means divided by the sample variance of the
+     * samples.
+     *
+     * To avoid having to choose $b$ ahead of time, the class keeps batches
+     * of sizes $b=2^k$ for all $k=0,1,2,\ldots$ at the same time: For each
+     * of these "levels", it stores the sum of the samples in the current,
+     * incomplete batch and the running mean and sum of squared deviations
+     * of the means of the completed batches. When a batch of size $2^k$ is
+     * completed, its sum is added to the incomplete batch of the next
+     * level, and so each sample only touches as many levels as there are
+     * batches completed by it -- on average two. When asked for $\tau$,
+     * the class uses the level whose batch size is closest to (but not
+     * larger than) $\sqrt{n}$, the usual choice that balances the bias of
+     * too small batches against the variance of the estimate that results
+     * from too few batches.
+     *
+     *
+     * <h3> Spectral estimate </h3>
+     *
+     * The batch means estimate uses only one of the levels, and its error
+     * is dominated by the bias of batches that are too short and the
+     * noise of having too few batches. If the constructor is given
+     * Estimator::spectral, the class instead uses all levels to compute an
+     * estimate in the spirit of Geyer's initial sequence estimators. This
+     * only changes what get() and get_integrated_autocorrelation_times()
+     * compute from the levels; it does not change the (amortized)
+     * ${\cal O}(d)$ cost of processing a sample.
+     *
+     * Let $v_k$ be the variance of the means of the batches of size
+     * $b=2^k$, and let $\Gamma_k=bv_k$. Then
+     * @f{align*}{
+     *   \Gamma_k = \sum_{|l|<b} \left(1-\frac{|l|}{b}\right) \gamma(l),
+     * @f}
+     * i.e., $\Gamma_k$ is the spectral density at frequency zero computed
+     * with a Bartlett lag window of width $b$, and $\Gamma_k\to\tau\gamma(0)$
+     * as $k\to\infty$. Furthermore, the covariance of the means of two
+     * adjacent batches of size $b$ is $c_k=2v_{k+1}-v_k$, which equals
+     * the average of the autocovariances $\gamma(l)$ for $0<l<2b$ with
+     * triangular weights centered at lag $l=b$. The $c_k$ are therefore
+     * (smoothed) autocovariances at the geometrically spaced lags
+     * $1,2,4,\ldots$, and are returned by get_autocovariances().
+     *
+     * The class walks through the levels $k=0,1,\ldots$ until the
+     * increment $\Gamma_{k+1}-\Gamma_k=bc_k$ is no longer positive by more
+     * than twice the statistical uncertainty of $\Gamma_{k+1}$, i.e.,
+     * until the autocovariances at lags around $b$ are indistinguishable
+     * from zero. It then returns the Richardson extrapolation
+     * @f{align*}{
+     *   \tau \approx \frac{2\Gamma_{k+1}-\Gamma_k}{\Gamma_0},
+     * @f}
+     * which removes the ${\cal O}(1/b)$ bias of the Bartlett window and
+     * corresponds to a flat-top lag window that includes all
+     * autocovariances up to lag $b$ with weight one. Only levels with at
+     * least eight completed batches are considered; if the increments are
+     * still significant at the last of these levels, the chain is too short
+     * to estimate $\tau$ reliably, and the returned value is likely too
+     * small.
+     *
+     *
+     * <h3> Repeated and weighted samples </h3>
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive samples
+     * of the chain as this entry says. Such samples are not processed one
+     * at a time, but their contributions to the batches of each level are
+     * computed at once, at a cost of ${\cal O}(d\log n)$ operations. The
+     * class does not support weighted samples (see
+     * AuxiliaryData::sample_weight) other than samples with weight zero,
+     * which are ignored.
+     *
+     *
+     * <h3> Threading model </h3>
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because the result depends on the order in which samples
+     * are processed, the class supports ParallelMode::dedicated_thread but
+     * not ParallelMode::asynchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. It needs
+     *   to satisfy the same requirements as for the MeanValue class, and
+     *   its elements need to be real-valued floating point numbers.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    class EffectiveSampleSize: public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type returned by the get() function: One effective
+         * sample size per component of the samples.
+         */
+        using value_type = std::vector<double>;
+
+        /**
+         * The ways in which the integrated autocorrelation time can be
+         * estimated from the batches of all sizes.
+         */
+        enum class Estimator
+        {
+          /**
+           * Use the batch means of the one batch size closest to
+           * $\sqrt{n}$. See the section on the algorithm in the
+           * documentation of this class.
+           */
+          batch_means,
+
+          /**
+           * Use the variances of the batch means of all batch sizes to
+           * compute autocovariances at geometrically spaced lags, and
+           * from these a spectral estimate. See the section on the spectral
+           * estimate in the documentation of this class.
+           */
+          spectral
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] estimator The way in which the get() and
+         *   get_integrated_autocorrelation_times() functions compute their
+         *   results. All estimators use the same data, and so cost the same
+         *   per sample.
+         */
+        EffectiveSampleSize (const Estimator estimator = Estimator::batch_means);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~EffectiveSampleSize ();
+
+        /**
+         * Process one sample by adding it to the batches of all levels.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and the weight of the
+         *   sample. The latter must be either zero or one.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the estimated effective sample size $n/\tau$ for each
+         * component of the samples. If fewer than four samples have been
+         * seen, the returned values are zero.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the estimated integrated autocorrelation time $\tau$ for
+         * each component of the samples. For components whose samples all
+         * have the same value, $\tau$ is reported as one. If fewer than four
+         * samples have been seen, the returned values are zero.
+         */
+        std::vector<double>
+        get_integrated_autocorrelation_times () const;
+
+        /**
+         * Return the smoothed autocovariances $c_k$ at lags $2^k$ discussed
+         * in the section on the spectral estimate in the documentation of
+         * this class, for all $k$ for which there are at least two
+         * completed batches of size $2^{k+1}$. Each element of the returned
+         * vector is a pair of the lag and the autocovariances of all
+         * components of the samples at this lag. The element for lag one
+         * is the ordinary lag-one autocovariance $\gamma(1)$ (up to the
+         * difference between the means of the batches and of the chain).
+         * This function can be called regardless of the estimator given to
+         * the constructor.
+         */
+        std::vector<std::pair<types::sample_index,std::vector<double>>>
+        get_autocovariances () const;
+
+        /**
+         * Append the state of the computation to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the batch means computed by another object that has processed
+         * an independent chain to the ones of the current object. The
+         * estimates returned afterwards are based on the batches of both
+         * chains (but not on batches that would straddle the end of one
+         * chain and the beginning of the other), and are therefore only
+         * meaningful if both chains sample the same distribution. The
+         * current object continues to fill its own incomplete batches.
+         */
+        void
+        merge (const EffectiveSampleSize &other);
+
+      private:
+        /**
+         * A mutex used to lock access to all member variables when running
+         * on multiple threads.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The estimator to be used by get() and
+         * get_integrated_autocorrelation_times().
+         */
+        Estimator estimator;
+
+        /**
+         * The data stored for the batches of size $2^k$.
+         */
+        struct Level
+        {
+          /**
+           * The sum of those samples of the current, incomplete batch that
+           * are no longer part of the incomplete batch of the level below.
+           * (The sum of all samples of the incomplete batch is then the
+           * sum of this vector over the current and all lower levels.)
+           */
+          std::vector<double> partial_sum;
+
+          /**
+           * The number of completed batches, and the running mean and sum
+           * of squared deviations from the mean of their means.
+           */
+          types::sample_index n_batches = 0;
+          std::vector<double> mean;
+          std::vector<double> sum_of_squares;
+
+          /**
+           * Constructor.
+           */
+          Level (const unsigned int dimension = 0);
+
+          /**
+           * Add `n` batches whose means equal `batch_sum/batch_size` to
+           * the running mean and sum of squares.
+           */
+          void
+          add_batches (const std::vector<double> &batch_sum,
+                       const double               batch_size,
+                       const types::sample_index  n);
+
+          /**
+           * Combine the statistics of the completed batches of `other`
+           * with the ones of the current object.
+           */
+          void
+          merge (const Level &other);
+
+          /**
+           * Return the variance of the means of the completed batches of
+           * this level for component `j`. This requires at least two
+           * completed batches.
+           */
+          double
+          variance (const unsigned int j) const;
+        };
+
+        /**
+         * The number of components of each sample, and the number of
+         * samples this object has processed itself (i.e., not counting the
+         * ones of objects merged into the current one). The latter
+         * determines where the batches of each level end.
+         */
+        unsigned int        dimension;
+        types::sample_index n_samples;
+
+        /**
+         * The data for the levels $k=0,1,\ldots$. The level with the
+         * largest $k$ has no completed batches of the samples of the current
+         * object yet.
+         */
+        std::vector<Level> levels;
+
+        /**
+         * Add one sample to all levels whose batches it completes.
+         */
+        void
+        add_one_sample (const std::vector<double> &sample);
+
+        /**
+         * Add `n_repetitions` copies of the given sample.
+         */
+        void
+        add_repeated_sample (const std::vector<double> &sample,
+                             const types::sample_index  n_repetitions);
+
+        /**
+         * Compute the integrated autocorrelation times as described in the
+         * documentation of get_integrated_autocorrelation_times(). The
+         * caller needs to hold the lock on the mutex.
+         */
+        std::vector<double>
+        compute_integrated_autocorrelation_times () const;
+
+        /**
+         * Compute the integrated autocorrelation time of component `j` using
+         * the spectral estimate, or return zero if there are too few batches
+         * for it. The caller needs to hold the lock on the mutex.
+         */
+        double
+        compute_spectral_integrated_autocorrelation_time (const unsigned int j) const;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    EffectiveSampleSize<InputType>::Level::
+    Level (const unsigned int dimension)
+      :
+      partial_sum (dimension, 0.),
+      mean (dimension, 0.),
+      sum_of_squares (dimension, 0.)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::Level::
+    add_batches (const std::vector<double> &batch_sum,
+                 const double               batch_size,
+                 const types::sample_index  n)
+    {
+      // Add n batches with the same mean, using the update formula for
+      // the mean and sum of squares of two sets (the second one with
+      // zero sum of squares):
+      const types::sample_index previous_n_batches = n_batches;
+      n_batches += n;
+      const double factor = 1. * n / n_batches;
+      const double square_factor = 1. * previous_n_batches * n / n_batches;
+      for (unsigned int j=0; j<mean.size(); ++j)
+        {
+          const double delta = batch_sum[j] / batch_size - mean[j];
+          mean[j] += delta * factor;
+          sum_of_squares[j] += delta * delta * square_factor;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::Level::
+    merge (const Level &other)
+    {
+      if (other.n_batches == 0)
+        return;
+
+      const types::sample_index previous_n_batches = n_batches;
+      n_batches += other.n_batches;
+      const double factor = 1. * other.n_batches / n_batches;
+      const double square_factor = 1. * previous_n_batches * other.n_batches / n_batches;
+      for (unsigned int j=0; j<mean.size(); ++j)
+        {
+          const double delta = other.mean[j] - mean[j];
+          mean[j] += delta * factor;
+          sum_of_squares[j] += other.sum_of_squares[j] + delta * delta * square_factor;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    double
+    EffectiveSampleSize<InputType>::Level::
+    variance (const unsigned int j) const
+    {
+      assert (n_batches >= 2);
+      return sum_of_squares[j] / (n_batches-1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    EffectiveSampleSize<InputType>::
+    EffectiveSampleSize (const Estimator estimator)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      estimator (estimator),
+      dimension (0),
+      n_samples (0)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    EffectiveSampleSize<InputType>::
+    ~EffectiveSampleSize ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double weight = aux_data.weight();
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
+      assert ((weight == 1) && "This class does not support weighted samples.");
+
+      std::vector<double> x (Utilities::size(sample));
+      for (unsigned int j=0; j<x.size(); ++j)
+        x[j] = Utilities::get_nth_element (sample, j);
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // Set up levels 0 and 1 upon the first sample. The latter is the
+      // one without completed batches:
+      if (levels.empty())
+        {
+          dimension = x.size();
+          levels = std::vector<Level>(2, Level(dimension));
+        }
+      assert (x.size() == dimension);
+
+      if (n_repetitions == 1)
+        add_one_sample (x);
+      else
+        add_repeated_sample (x, n_repetitions);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    add_one_sample (const std::vector<double> &sample)
+    {
+      ++n_samples;
+
+      // Every sample completes a batch on level zero. From there, move
+      // the sum of each completed batch up to the next level until we
+      // reach a level whose batch is not yet complete:
+      levels[0].add_batches (sample, 1, 1);
+      for (unsigned int k=1; ; ++k)
+        {
+          if (k == levels.size())
+            levels.emplace_back (dimension);
+
+          const std::vector<double> &source = (k == 1 ? sample : levels[k-1].partial_sum);
+          Level &level = levels[k];
+          for (unsigned int j=0; j<dimension; ++j)
+            level.partial_sum[j] += source[j];
+          if (k > 1)
+            std::fill (levels[k-1].partial_sum.begin(), levels[k-1].partial_sum.end(), 0.);
+
+          const types::sample_index batch_size = types::sample_index(1) << k;
+          if (n_samples % batch_size != 0)
+            break;
+
+          level.add_batches (level.partial_sum, batch_size, 1);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    add_repeated_sample (const std::vector<double> &sample,
+                         const types::sample_index  n_repetitions)
+    {
+      // Make sure that there are levels for all batches that the new
+      // samples can complete, plus one more level without completed
+      // batches. The incomplete batches of new levels consist of all
+      // samples seen so far, and so their partial sums are zero.
+      const types::sample_index new_n_samples = n_samples + n_repetitions;
+      while ((types::sample_index(1) << (levels.size()-1)) <= new_n_samples)
+        levels.emplace_back (dimension);
+
+      levels[0].add_batches (sample, 1, n_repetitions);
+
+      // Then deal with each level separately: Compute the sum of all
+      // samples of the incomplete batch, add as many copies of the sample
+      // as that batch still needs, then all of the batches that consist of
+      // copies of the sample only, and finally put the remaining copies into
+      // a new incomplete batch. Finally convert the sums of incomplete
+      // batches back into the form in which they are stored. The
+      // sums of the incomplete batches before and after adding the
+      // samples are accumulated in 'old_lower_total' and 'lower_total'.
+      std::vector<double> old_lower_total (dimension, 0.);
+      std::vector<double> lower_total (dimension, 0.);
+      std::vector<double> total (dimension);
+      for (unsigned int k=1; k<levels.size(); ++k)
+        {
+          Level &level = levels[k];
+          for (unsigned int j=0; j<dimension; ++j)
+            {
+              old_lower_total[j] += level.partial_sum[j];
+              total[j] = old_lower_total[j];
+            }
+
+          const types::sample_index batch_size = types::sample_index(1) << k;
+          const types::sample_index n_in_batch = n_samples % batch_size;
+          if (n_in_batch + n_repetitions < batch_size)
+            for (unsigned int j=0; j<dimension; ++j)
+              total[j] += n_repetitions * sample[j];
+          else
+            {
+              const types::sample_index n_to_complete = batch_size - n_in_batch;
+              for (unsigned int j=0; j<dimension; ++j)
+                total[j] += n_to_complete * sample[j];
+              level.add_batches (total, batch_size, 1);
+
+              const types::sample_index n_left = n_repetitions - n_to_complete;
+              if (n_left >= batch_size)
+                level.add_batches (sample, 1, n_left / batch_size);
+              for (unsigned int j=0; j<dimension; ++j)
+                total[j] = (n_left % batch_size) * sample[j];
+            }
+
+          for (unsigned int j=0; j<dimension; ++j)
+            {
+              level.partial_sum[j] = total[j] - lower_total[j];
+              lower_total[j] = total[j];
+            }
+        }
+
+      n_samples = new_n_samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::vector<double>
+    EffectiveSampleSize<InputType>::
+    get_integrated_autocorrelation_times () const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      return compute_integrated_autocorrelation_times ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::vector<double>
+    EffectiveSampleSize<InputType>::
+    compute_integrated_autocorrelation_times () const
+    {
+      std::vector<double> tau (dimension, 0.);
+      if (levels.empty() || (levels[0].n_batches < 4))
+        return tau;
+
+      // The spectral estimate falls back to the batch means estimate for
+      // components for which it does not yet have enough batches:
+      if (estimator == Estimator::spectral)
+        {
+          bool all_computed = true;
+          for (unsigned int j=0; j<dimension; ++j)
+            {
+              tau[j] = compute_spectral_integrated_autocorrelation_time (j);
+              all_computed = all_computed && (tau[j] > 0);
+            }
+          if (all_computed)
+            return tau;
+        }
+
+      // Choose the level with batch size 2^k <= sqrt(n), but make sure
+      // that it has at least two batches (which may not be the case if
+      // we have merged the batches of chains of different lengths):
+      const types::sample_index n = levels[0].n_batches;
+      unsigned int k = std::min<std::size_t> ((std::bit_width(n)-1)/2, levels.size()-1);
+      while ((k > 0) && (levels[k].n_batches < 2))
+        --k;
+
+      const double batch_size = types::sample_index(1) << k;
+      for (unsigned int j=0; j<dimension; ++j)
+        {
+          const double variance = levels[0].sum_of_squares[j] / (n-1);
+          const double batch_mean_variance
+            = levels[k].sum_of_squares[j] / (levels[k].n_batches-1);
+          if (tau[j] == 0)
+            tau[j] = (variance > 0 ? batch_size * batch_mean_variance / variance : 1.);
+        }
+
+      return tau;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    double
+    EffectiveSampleSize<InputType>::
+    compute_spectral_integrated_autocorrelation_time (const unsigned int j) const
+    {
+      // Only use levels k for which level k+1 has enough batches to
+      // compute the increment Gamma_{k+1}-Gamma_k:
+      const types::sample_index min_n_batches = 8;
+      if ((levels.size() < 2) || (levels[1].n_batches < min_n_batches))
+        return 0;
+
+      const double gamma_0 = levels[0].variance(j);
+      if (gamma_0 <= 0)
+        return 1;
+
+      double gamma_k = gamma_0;
+      for (unsigned int k=0; ; ++k)
+        {
+          const double batch_size = types::sample_index(1) << (k+1);
+          const double gamma_k_plus_1 = batch_size * levels[k+1].variance(j);
+          const double increment = gamma_k_plus_1 - gamma_k;
+
+          // Stop if the autocovariances around lag 2^k are no longer
+          // significant, or if there are no more levels with enough
+          // batches to look further:
+          const double uncertainty
+            = gamma_k_plus_1 * std::sqrt (2. / levels[k+1].n_batches);
+          if ((increment <= 2 * uncertainty)
+              ||
+              (k+2 == levels.size())
+              ||
+              (levels[k+2].n_batches < min_n_batches))
+            {
+              const double tau = (gamma_k_plus_1 + increment) / gamma_0;
+              return (tau > 0 ? tau : gamma_k_plus_1 / gamma_0);
+            }
+
+          gamma_k = gamma_k_plus_1;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::vector<std::pair<types::sample_index,std::vector<double>>>
+    EffectiveSampleSize<InputType>::
+    get_autocovariances () const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      std::vector<std::pair<types::sample_index,std::vector<double>>> autocovariances;
+      for (unsigned int k=0; (k+1<levels.size()) && (levels[k+1].n_batches >= 2); ++k)
+        {
+          std::vector<double> c (dimension);
+          for (unsigned int j=0; j<dimension; ++j)
+            c[j] = 2*levels[k+1].variance(j) - levels[k].variance(j);
+          autocovariances.emplace_back (types::sample_index(1) << k, std::move(c));
+        }
+
+      return autocovariances;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename EffectiveSampleSize<InputType>::value_type
+    EffectiveSampleSize<InputType>::
+    get () const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      std::vector<double> ess = compute_integrated_autocorrelation_times();
+      for (double &x : ess)
+        if (x > 0)
+          x = levels[0].n_batches / x;
+
+      return ess;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      Serialization::write (buffer, dimension);
+      Serialization::write (buffer, n_samples);
+      Serialization::write (buffer, static_cast<std::uint64_t>(levels.size()));
+      for (const Level &level : levels)
+        {
+          Serialization::write (buffer, level.partial_sum);
+          Serialization::write (buffer, level.n_batches);
+          Serialization::write (buffer, level.mean);
+          Serialization::write (buffer, level.sum_of_squares);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      Serialization::read (buffer, dimension);
+      Serialization::read (buffer, n_samples);
+
+      std::uint64_t n_levels;
+      Serialization::read (buffer, n_levels);
+      levels.resize (n_levels);
+      for (Level &level : levels)
+        {
+          Serialization::read (buffer, level.partial_sum);
+          Serialization::read (buffer, level.n_batches);
+          Serialization::read (buffer, level.mean);
+          Serialization::read (buffer, level.sum_of_squares);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    EffectiveSampleSize<InputType>::
+    merge (const EffectiveSampleSize &other)
+    {
+      std::vector<Level> other_levels;
+      {
+        const std::unique_lock<std::mutex> lock = other.lock_state (other.mutex);
+        other_levels = other.levels;
+      }
+      if (other_levels.empty())
+        return;
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // Levels beyond the ones we have contain all of our own samples in
+      // their incomplete batches, and so have zero partial sums:
+      if (levels.empty())
+        dimension = other_levels[0].mean.size();
+      assert (other_levels[0].mean.size() == dimension);
+      while (levels.size() < other_levels.size())
+        levels.emplace_back (dimension);
+
+      for (unsigned int k=0; k<other_levels.size(); ++k)
+        levels[k].merge (other_levels[k]);
+    }
+  }
+}
@@ -0,0 +1,318 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes an exponentially weighted moving
+     * average $\bar x$ and covariance matrix $C$ of the samples it
+     * receives. Like the WindowedCovarianceMatrix class, this class
+     * follows a chain as it moves rather than averaging over its whole
+     * history, but instead of forgetting samples abruptly when they leave
+     * a window of fixed length, it forgets them gradually. As a
+     * consequence, it does not need to store any samples: Processing a
+     * sample costs ${\cal O}(d^2)$ operations and the memory used is that
+     * of $\bar x$ and $C$, regardless of how slowly old samples are to be
+     * forgotten.
+     *
+     * For a smoothing factor $0<\alpha\le 1$, the class updates the mean
+     * and covariance matrix with each sample $x$ as follows:
+     * @f{align*}{
+     *   \delta &= x - \bar x,
+     *   \\
+     *   \bar x &\leftarrow \bar x + \alpha \delta,
+     *   \\
+     *   C &\leftarrow (1-\alpha) \left(C + \alpha \delta\delta^T\right).
+     * @f}
+     * The first sample initializes $\bar x=x$ and $C=0$. The influence of a
+     * sample on $\bar x$ and $C$ decays by a factor of $1-\alpha$ with every
+     * later sample, i.e., it halves after
+     * $\frac{\ln 2}{-\ln(1-\alpha)}\approx \frac{0.69}{\alpha}$ samples.
+     * Choosing $\alpha=2/(N+1)$ yields a "center of mass" of the weights
+     * comparable to that of a window of length $N$.
+     *
+     * A sample with $r$ repetitions (see AuxiliaryData::n_repetitions())
+     * and weight $w$ (see AuxiliaryData::weight()) is treated as if the
+     * sample had been received $rw$ times: The update above is applied
+     * once with $\alpha$ replaced by $1-(1-\alpha)^{rw}$, which for integer
+     * $rw$ yields the same result as applying it $rw$ times with $\alpha$.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because the result depends on the order in which samples are
+     * processed, the class supports ParallelMode::dedicated_thread but not
+     * ParallelMode::asynchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The same
+     *   requirements hold as for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class ExponentiallyWeightedCovarianceMatrix : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type of the covariance matrix returned by get().
+         */
+        using value_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * The type of the mean value returned by get_mean().
+         */
+        using mean_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] smoothing_factor The factor $\alpha$ discussed in the
+         *   class documentation. Must be in the interval $(0,1]$.
+         */
+        ExponentiallyWeightedCovarianceMatrix (const double smoothing_factor);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~ExponentiallyWeightedCovarianceMatrix ();
+
+        /**
+         * Process one sample by updating the mean and covariance matrix.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the current exponentially weighted covariance matrix. If
+         * no samples have been processed so far, an empty matrix is
+         * returned.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the current exponentially weighted mean value. If no
+         * samples have been processed so far, an empty vector is returned.
+         */
+        mean_type
+        get_mean () const;
+
+        /**
+         * Return the number of samples after which the influence of a
+         * sample has decayed to one half, as discussed in the class
+         * documentation.
+         */
+        double
+        half_life () const;
+
+        /**
+         * Append the current mean and covariance matrix to the given
+         * buffer. See the section on saving and combining the state of
+         * consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+      private:
+        /**
+         * The smoothing factor $\alpha$.
+         */
+        const double smoothing_factor;
+
+        /**
+         * A structure that describes the current mean and covariance
+         * matrix (of which only the lower triangle is kept up to date).
+         */
+        struct State
+        {
+          mean_type  mean;
+          value_type covariance;
+        };
+
+        /**
+         * The current state, along with a mutex that protects it if
+         * several threads send samples to this object.
+         */
+        CopyOnWrite<State> state;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    ExponentiallyWeightedCovarianceMatrix (const double smoothing_factor)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      smoothing_factor (smoothing_factor)
+    {
+      assert ((smoothing_factor > 0) && (smoothing_factor <= 1));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    ~ExponentiallyWeightedCovarianceMatrix ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const double multiplicity = aux_data.n_repetitions() * aux_data.weight();
+      if (multiplicity == 0)
+        return;
+
+      // Fold the repetitions of the sample into one update:
+      const double alpha = 1 - std::pow (1 - smoothing_factor, multiplicity);
+
+      const unsigned int size = Utilities::size(sample);
+      mean_type x (size);
+      if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+        x = Eigen::Map<const mean_type> (std::ranges::data(sample), size);
+      else
+        for (unsigned int i=0; i<size; ++i)
+          x[i] = Utilities::get_nth_element (sample, i);
+
+      state.modify ([&](State &current_state)
+      {
+        if (current_state.mean.size() == 0)
+          {
+            current_state.mean = x;
+            current_state.covariance = value_type::Zero (size, size);
+            return;
+          }
+        assert (current_state.mean.size() == size);
+
+        const mean_type delta = x - current_state.mean;
+        current_state.mean += alpha * delta;
+        if constexpr (types::is_complex<scalar_type>)
+          Utilities::add_hermitian_rank_one (current_state.covariance.data(),
+                                             current_state.covariance.outerStride(),
+                                             std::span<const scalar_type>(delta.data(), size),
+                                             alpha);
+        else
+          current_state.covariance.template selfadjointView<Eigen::Lower>()
+          .rankUpdate (delta, alpha);
+        current_state.covariance.template triangularView<Eigen::Lower>()
+          *= (1 - alpha);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename ExponentiallyWeightedCovarianceMatrix<InputType>::value_type
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    get () const
+    {
+      return state.snapshot()->covariance.template selfadjointView<Eigen::Lower>();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename ExponentiallyWeightedCovarianceMatrix<InputType>::mean_type
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    get_mean () const
+    {
+      return state.snapshot()->mean;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    double
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    half_life () const
+    {
+      if (smoothing_factor == 1)
+        return 0;
+      else
+        return std::log(2.) / -std::log1p(-smoothing_factor);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::shared_ptr<const State> current_state = state.snapshot();
+      Serialization::write (buffer, current_state->mean);
+      Serialization::write (buffer, current_state->covariance);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    ExponentiallyWeightedCovarianceMatrix<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      State new_state;
+      Serialization::read (buffer, new_state.mean);
+      Serialization::read (buffer, new_state.covariance);
+
+      state.modify ([&new_state](State &current_state)
+      {
+        current_state = std::move (new_state);
+      });
+    }
+  }
+}
@@ -0,0 +1,795 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace FFTAutoCovarianceTrace
+    {
+      /**
+       * Compute the discrete Fourier transform of the given vector in place,
+       * using the iterative radix-2 variant of the Cooley-Tukey algorithm.
+       * The length of the vector must be a power of two, and `twiddles`
+       * must contain the values $e^{-2\pi i k/L}$ for $k=0,\ldots,L/2-1$
+       * where $L$ is the length of the vector. If `inverse` is true, the
+       * function computes the inverse transform, but without the factor
+       * $1/L$.
+       */
+      inline
+      void
+      fft (std::vector<std::complex<double>>       &data,
+           const std::vector<std::complex<double>> &twiddles,
+           const bool                               inverse)
+      {
+        const std::size_t length = data.size();
+        assert (std::has_single_bit (length));
+        assert (twiddles.size() == length/2);
+
+        // Bring the elements into bit-reversed order:
+        for (std::size_t i=1, j=0; i<length; ++i)
+          {
+            std::size_t bit = length >> 1;
+            for (; j & bit; bit >>= 1)
+              j ^= bit;
+            j ^= bit;
+
+            if (i < j)
+              std::swap (data[i], data[j]);
+          }
+
+        // Then combine transforms of length 'half' into transforms of
+        // twice that length. The twiddle factors for the current length
+        // are every (length/(2*half))th element of the table:
+        for (std::size_t half=1; half<length; half *= 2)
+          {
+            const std::size_t stride = length / (2*half);
+            for (std::size_t start=0; start<length; start += 2*half)
+              for (std::size_t k=0; k<half; ++k)
+                {
+                  const std::complex<double> w
+                    = (inverse ? std::conj(twiddles[k*stride]) : twiddles[k*stride]);
+                  const std::complex<double> u = data[start+k];
+                  const std::complex<double> v = Utilities::multiply (data[start+k+half], w);
+                  data[start+k]      = u + v;
+                  data[start+k+half] = u - v;
+                }
+          }
+      }
+    }
+  }
+
+
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the same quantity as the
+     * AutoCovarianceTrace class, namely the trace of the auto-covariance
+     * of the samples for lags $l=0,1,\ldots,k$,
+     * @f{align*}{
+     *   \hat\gamma(l)
+     *   &=
+     *   \frac{1}{n-l-1} \sum_{t=1}^{n-l}{(x_{t+l}-\bar{x})^T(x_{t}-\bar{x})},
+     * @f}
+     * but does so in a way that is substantially cheaper if the maximal lag
+     * $k$ is large. See the documentation of the AutoCovarianceTrace class
+     * for a discussion of the quantity computed.
+     *
+     * The AutoCovarianceTrace class updates its running averages for
+     * every lag whenever a new sample comes in, at a cost of
+     * ${\cal O}(kd)$ operations per sample if $d$ is the number of
+     * components of each sample. For slowly mixing chains where one needs
+     * lags in the thousands, this can easily be more expensive than
+     * generating the samples. The current class instead collects samples
+     * into blocks of $m$ samples and computes the contribution of each
+     * block to the sums
+     * @f{align*}{
+     *   S_l = \sum_{t=1}^{n-l} x_{t+l}^T x_t
+     * @f}
+     * at once, using that these sums are correlations that can be computed
+     * via the Fast Fourier Transform. This requires ${\cal O}(d(m+k)\log(m+k))$
+     * operations per block, i.e., ${\cal O}(d\log k)$ operations per sample
+     * if the block size $m$ is chosen proportional to $k$ (as is the
+     * default).
+     *
+     *
+     * <h3> Algorithm </h3>
+     *
+     * The pairs of samples $x_{t+l},x_t$ that contribute to $S_l$ can be
+     * sorted by the block in which their later member $x_{t+l}$ lies. For a
+     * block that contains the samples $x_{s+1},\ldots,x_{s+m}$, these pairs
+     * only involve the block itself and the $k$ samples $x_{s-k+1},\ldots,x_s$
+     * that precede it (the "tail" of the previous blocks). If we denote by
+     * $z$ the concatenation of the tail and the block, and by $a$ the same
+     * vector but with the elements that correspond to the tail set to zero,
+     * then the contribution of the block is
+     * @f{align*}{
+     *   \sum_{j=1}^d \sum_{i} a_{i+l,j}\, z_{i,j},
+     * @f}
+     * which is the sum over the components $j$ of the cross-correlations of
+     * $a_{\cdot,j}$ and $z_{\cdot,j}$. If both are padded with zeros to a
+     * length $L\ge |z|+k$, then these cross-correlations can be computed
+     * exactly (up to round-off) via the circular correlation theorem, i.e.,
+     * as the inverse Fourier transform of
+     * $\sum_j \hat a_j \overline{\hat z_j}$. Since $a$ and $z$ are real, both
+     * of their transforms are obtained from one complex transform of
+     * $a+iz$, and the class therefore computes $d$ forward and one inverse
+     * transform of length $L$ per block. Because pairs of samples are
+     * attributed to exactly one block, the result does not depend on the
+     * block size other than through round-off.
+     *
+     * Computing $\hat\gamma(l)$ from the $S_l$ then also requires the mean
+     * $\bar x_n$ and the sums $\sum_{t=1}^{n-l}(x_{t+l}+x_t)$, which are
+     * the sum of all samples counted twice, minus the first and the last
+     * $l$ samples. The class therefore also stores the first $k$ samples;
+     * the last $k$ samples are part of the tail and current block.
+     *
+     * To avoid the loss of accuracy that results from computing a
+     * covariance as the difference of two large sums if the mean of the
+     * samples is far from zero, all of the sums above are computed for the
+     * shifted samples $x_t-x_1$ rather than the samples themselves. This
+     * shift does not change the auto-covariances.
+     *
+     *
+     * <h3> Repeated and weighted samples </h3>
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive samples
+     * of the chain as this entry says, and is treated exactly as if it had
+     * been received this many times. On the other hand, the class does not
+     * support weighted samples (see AuxiliaryData::sample_weight) other than
+     * samples with weight zero, which are ignored: The pair weights
+     * $\sqrt{w_{t+l}w_t}$ used by the AutoCovarianceTrace class would
+     * require additional transforms per block. Use that class if you need
+     * weighted samples.
+     *
+     *
+     * <h3> Threading model </h3>
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because the result depends on the order in which samples
+     * are processed, the class supports ParallelMode::dedicated_thread but
+     * not ParallelMode::asynchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. In addition
+     *   to the requirements listed for the AutoCovarianceTrace class, the
+     *   elements of samples need to be real-valued floating point numbers.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    class FFTAutoCovarianceTrace: public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The data type returned by the get() function. This is the same
+         * type as the one returned by AutoCovarianceTrace::get().
+         */
+        using value_type = std::vector<scalar_type>;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] lag_length The maximal lag $k$ for which the
+         *   autocovariance is to be computed.
+         * @param[in] block_size The number of samples that are collected
+         *   before their contributions are computed. The cost per sample is
+         *   smallest if this number is a small multiple of `lag_length`.
+         *   If zero (the default), the class uses $\max\{4(k+1),256\}$.
+         */
+        FFTAutoCovarianceTrace (const unsigned int lag_length,
+                                const unsigned int block_size = 0);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~FFTAutoCovarianceTrace ();
+
+        /**
+         * Process one sample by adding it to the current block, and
+         * processing the block if it is full.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and the weight of the
+         *   sample. The latter must be either zero or one.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the autocovariances computed from the samples seen so far,
+         * including the ones in a block that has not been processed yet.
+         *
+         * @return A vector of length `lag_length+1` whose $l$th element is
+         *   $\hat\gamma(l)$. Entries for lags for which fewer than two pairs
+         *   of samples have been seen are zero.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Append the state of the computation to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same `lag_length`, but may have used a different
+         * block size.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the sums computed by another object with the ones of the
+         * current object, in the same way as AutoCovarianceTrace::merge()
+         * does: Pairs of samples of both chains contribute to each lag, but
+         * not pairs that would straddle the end of one chain and the
+         * beginning of the other. The current object continues to form
+         * pairs from the last samples *it* has seen. Both objects need to
+         * use the same `lag_length`.
+         */
+        void
+        merge (const FFTAutoCovarianceTrace &other);
+
+      private:
+        /**
+         * The maximal lag up to which we calculate auto-covariances, and
+         * the number of samples per block.
+         */
+        const unsigned int max_lag;
+        const unsigned int block_size;
+
+        /**
+         * A mutex used to lock access to all member variables when running
+         * on multiple threads.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * A structure that holds the sums from which the autocovariances
+         * are computed: The number of samples and their sum, and for each
+         * lag $l$ the number of pairs of samples, the sum $S_l$ of their
+         * scalar products, and the sum of the two members of each pair (as
+         * a vector of length $d$, stored consecutively for all lags). All
+         * of these refer to the shifted samples discussed in the
+         * documentation of this class.
+         */
+        struct Sums
+        {
+          types::sample_index              n_samples = 0;
+          std::vector<double>              sum;
+          std::vector<types::sample_index> n_pairs;
+          std::vector<double>              products;
+          std::vector<double>              pair_sums;
+
+          /**
+           * Add the sums stored in `other`, which refer to samples shifted
+           * by a vector that differs from the one used for the current
+           * object by `shift_difference` (i.e., the other object's shift
+           * minus the current one's).
+           */
+          void
+          add (const Sums                &other,
+               const std::vector<double> &shift_difference);
+        };
+
+        /**
+         * The number of components of each sample, and the vector by which
+         * samples are shifted. The latter is the first sample this object
+         * has seen (or, if it has received sums from another object via
+         * merge() before seeing any samples, the shift of the other
+         * object), and is empty as long as neither has happened.
+         */
+        unsigned int        dimension;
+        std::vector<double> shift;
+
+        /**
+         * The number of samples this object has seen, and their sum.
+         */
+        types::sample_index n_samples;
+        std::vector<double> sum;
+
+        /**
+         * The first `max_lag` samples, the up to `max_lag` samples that
+         * precede the current block, and the samples of the current
+         * block. All of these are stored as the shifted samples, one
+         * after the other.
+         */
+        std::vector<double> first_samples;
+        std::vector<double> tail;
+        std::vector<double> block;
+
+        /**
+         * The sums $S_l$ of scalar products for the blocks that have
+         * already been processed.
+         */
+        std::vector<double> products;
+
+        /**
+         * The sums received from other objects via merge(), converted to
+         * the shift used by the current object.
+         */
+        Sums merged_sums;
+
+        /**
+         * Add the contributions of the pairs of samples whose later member
+         * is in `new_block` to `sums_of_products`, as described in the
+         * documentation of this class. `new_block` is assumed to follow
+         * the samples stored in the tail.
+         */
+        void
+        add_block_products (const std::vector<double> &new_block,
+                            std::vector<double>       &sums_of_products) const;
+
+        /**
+         * Add the contributions of the current block to `products`, update
+         * the tail, and start a new block.
+         */
+        void
+        process_block ();
+
+        /**
+         * Return the sums that correspond to the samples this object has
+         * seen, including the ones in the current block, but not including
+         * the sums received via merge().
+         */
+        Sums
+        own_sums () const;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    FFTAutoCovarianceTrace<InputType>::
+    FFTAutoCovarianceTrace (const unsigned int lag_length,
+                            const unsigned int block_size)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      max_lag (lag_length),
+      block_size (block_size != 0 ? block_size : std::max (4*(lag_length+1), 256U)),
+      dimension (0),
+      n_samples (0)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    FFTAutoCovarianceTrace<InputType>::
+    ~FFTAutoCovarianceTrace ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double weight = aux_data.weight();
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
+      assert ((weight == 1) && "This class does not support weighted samples.");
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // If this is the first sample we see, use it as the shift and set up
+      // the sums:
+      if (shift.empty())
+        {
+          dimension = Utilities::size(sample);
+          shift.resize (dimension);
+          for (unsigned int j=0; j<dimension; ++j)
+            shift[j] = Utilities::get_nth_element (sample, j);
+          sum = std::vector<double>(dimension, 0.);
+          products = std::vector<double>(max_lag+1, 0.);
+        }
+      assert (Utilities::size(sample) == dimension);
+
+      // Then add the shifted sample as many times as it is repeated,
+      // processing blocks as they fill up:
+      std::vector<double> shifted_sample (dimension);
+      for (unsigned int j=0; j<dimension; ++j)
+        shifted_sample[j] = Utilities::get_nth_element (sample, j) - shift[j];
+
+      for (types::sample_index r=0; r<n_repetitions; ++r)
+        {
+          if (first_samples.size() < static_cast<std::size_t>(max_lag)*dimension)
+            first_samples.insert (first_samples.end(),
+                                  shifted_sample.begin(), shifted_sample.end());
+          block.insert (block.end(), shifted_sample.begin(), shifted_sample.end());
+          if (block.size() >= static_cast<std::size_t>(block_size)*dimension)
+            process_block ();
+        }
+
+      n_samples += n_repetitions;
+      for (unsigned int j=0; j<dimension; ++j)
+        sum[j] += n_repetitions * shifted_sample[j];
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    add_block_products (const std::vector<double> &new_block,
+                        std::vector<double>       &sums_of_products) const
+    {
+      const std::size_t n_tail_samples  = tail.size() / dimension;
+      const std::size_t n_block_samples = new_block.size() / dimension;
+      const std::size_t n_total_samples = n_tail_samples + n_block_samples;
+      if (n_block_samples == 0)
+        return;
+
+      // Choose the length of the transforms so that circular correlations
+      // do not wrap around for any of the lags we are interested in:
+      const std::size_t length = std::bit_ceil (n_total_samples + max_lag);
+
+      std::vector<std::complex<double>> twiddles (length/2);
+      for (std::size_t k=0; k<length/2; ++k)
+        twiddles[k] = std::polar (1., -2*std::numbers::pi*k/length);
+
+      // For each component, transform a+iz, extract the transforms of a
+      // and z from it, and accumulate the product of the former with the
+      // conjugate of the latter:
+      std::vector<std::complex<double>> correlation (length, 0.);
+      std::vector<std::complex<double>> transform (length);
+      for (unsigned int j=0; j<dimension; ++j)
+        {
+          for (std::size_t i=0; i<n_tail_samples; ++i)
+            transform[i] = std::complex<double>(0., tail[i*dimension+j]);
+          for (std::size_t i=0; i<n_block_samples; ++i)
+            transform[n_tail_samples+i] = std::complex<double>(new_block[i*dimension+j],
+                                                               new_block[i*dimension+j]);
+          std::fill (transform.begin()+n_total_samples, transform.end(), 0.);
+
+          internal::FFTAutoCovarianceTrace::fft (transform, twiddles, false);
+
+          for (std::size_t k=0; k<length; ++k)
+            {
+              const std::complex<double> mirrored = std::conj (transform[(length-k) % length]);
+              const std::complex<double> a_hat = 0.5 * (transform[k] + mirrored);
+              const std::complex<double> z_hat = Utilities::multiply (std::complex<double>(0., -0.5),
+                                                                    transform[k] - mirrored);
+              correlation[k] += Utilities::multiply_conjugate (a_hat, z_hat);
+            }
+        }
+
+      internal::FFTAutoCovarianceTrace::fft (correlation, twiddles, true);
+
+      // There are no pairs with lags of n_total_samples or more, and so
+      // we need not add the round-off in these entries:
+      for (std::size_t l=0; l<std::min<std::size_t>(max_lag+1, n_total_samples); ++l)
+        sums_of_products[l] += correlation[l].real() / length;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    process_block ()
+    {
+      add_block_products (block, products);
+
+      // The new tail consists of the last max_lag samples of the old tail
+      // followed by the block:
+      const std::size_t tail_length = static_cast<std::size_t>(max_lag)*dimension;
+      if (block.size() >= tail_length)
+        tail.assign (block.end()-tail_length, block.end());
+      else
+        {
+          tail.insert (tail.end(), block.begin(), block.end());
+          if (tail.size() > tail_length)
+            tail.erase (tail.begin(), tail.end()-tail_length);
+        }
+
+      block.clear();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename FFTAutoCovarianceTrace<InputType>::Sums
+    FFTAutoCovarianceTrace<InputType>::
+    own_sums () const
+    {
+      Sums sums;
+      sums.n_samples = n_samples;
+      sums.sum       = sum;
+      sums.products  = products;
+      add_block_products (block, sums.products);
+
+      sums.n_pairs   = std::vector<types::sample_index>(max_lag+1, 0);
+      sums.pair_sums = std::vector<double>((max_lag+1)*dimension, 0.);
+
+      // The sum of x_{t+l}+x_t over all pairs with lag l is twice the sum
+      // of all samples minus the first and the last l samples. Accumulate
+      // the latter lag by lag; the last samples are at the end of the
+      // concatenation of tail and block:
+      const std::size_t n_tail_samples = tail.size() / dimension;
+      const auto last_sample = [&](const std::size_t i, const unsigned int j)
+      {
+        // Return component j of the i-th sample counted from the end:
+        const std::size_t n_block_samples = block.size() / dimension;
+        if (i < n_block_samples)
+          return block[(n_block_samples-1-i)*dimension+j];
+        else
+          return tail[(n_tail_samples-1-(i-n_block_samples))*dimension+j];
+      };
+
+      std::vector<double> first_and_last (dimension, 0.);
+      for (unsigned int l=0; (l<=max_lag) && (l<n_samples); ++l)
+        {
+          if (l > 0)
+            for (unsigned int j=0; j<dimension; ++j)
+              first_and_last[j] += first_samples[(l-1)*dimension+j] + last_sample(l-1, j);
+
+          sums.n_pairs[l] = n_samples - l;
+          for (unsigned int j=0; j<dimension; ++j)
+            sums.pair_sums[l*dimension+j] = 2*sum[j] - first_and_last[j];
+        }
+
+      return sums;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::Sums::
+    add (const Sums                &other,
+         const std::vector<double> &shift_difference)
+    {
+      const std::size_t dimension = shift_difference.size();
+      const std::size_t n_lags    = other.n_pairs.size();
+      if (sum.empty())
+        {
+          sum       = std::vector<double>(dimension, 0.);
+          n_pairs   = std::vector<types::sample_index>(n_lags, 0);
+          products  = std::vector<double>(n_lags, 0.);
+          pair_sums = std::vector<double>(n_lags*dimension, 0.);
+        }
+
+      // If y=x-c is a sample shifted by the other object's shift c, then
+      // x-c' = y+delta with delta=c-c'. Expanding the products and sums
+      // of the shifted samples in terms of delta yields:
+      double delta_squared = 0;
+      for (std::size_t j=0; j<dimension; ++j)
+        delta_squared += shift_difference[j] * shift_difference[j];
+
+      n_samples += other.n_samples;
+      for (std::size_t j=0; j<dimension; ++j)
+        sum[j] += other.sum[j] + other.n_samples * shift_difference[j];
+
+      for (std::size_t l=0; l<n_lags; ++l)
+        {
+          n_pairs[l]  += other.n_pairs[l];
+          products[l] += other.products[l] + other.n_pairs[l] * delta_squared;
+          for (std::size_t j=0; j<dimension; ++j)
+            {
+              products[l] += shift_difference[j] * other.pair_sums[l*dimension+j];
+              pair_sums[l*dimension+j] += other.pair_sums[l*dimension+j]
+                                          + 2. * other.n_pairs[l] * shift_difference[j];
+            }
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename FFTAutoCovarianceTrace<InputType>::value_type
+    FFTAutoCovarianceTrace<InputType>::
+    get () const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      value_type autocovariance (max_lag+1, scalar_type(0));
+      if (shift.empty())
+        return autocovariance;
+
+      Sums sums = own_sums();
+      if (merged_sums.n_samples > 0)
+        sums.add (merged_sums, std::vector<double>(dimension, 0.));
+      if (sums.n_samples == 0)
+        return autocovariance;
+
+      // Compute
+      //   gamma(l) = [S_l - mean^T B_l + P_l mean^T mean] / (P_l-1)
+      // where P_l is the number of pairs and B_l the sum of their members:
+      std::vector<double> mean (dimension);
+      double mean_squared = 0;
+      for (unsigned int j=0; j<dimension; ++j)
+        {
+          mean[j] = sums.sum[j] / sums.n_samples;
+          mean_squared += mean[j] * mean[j];
+        }
+
+      for (unsigned int l=0; l<=max_lag; ++l)
+        if (sums.n_pairs[l] > 1)
+          {
+            double value = sums.products[l] + sums.n_pairs[l] * mean_squared;
+            for (unsigned int j=0; j<dimension; ++j)
+              value -= mean[j] * sums.pair_sums[l*dimension+j];
+            autocovariance[l] = value / (sums.n_pairs[l] - 1);
+          }
+
+      return autocovariance;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      Serialization::write (buffer, max_lag);
+      Serialization::write (buffer, dimension);
+      Serialization::write (buffer, shift);
+      Serialization::write (buffer, n_samples);
+      Serialization::write (buffer, sum);
+      Serialization::write (buffer, first_samples);
+      Serialization::write (buffer, tail);
+      Serialization::write (buffer, block);
+      Serialization::write (buffer, products);
+
+      Serialization::write (buffer, merged_sums.n_samples);
+      Serialization::write (buffer, merged_sums.sum);
+      Serialization::write (buffer, merged_sums.n_pairs);
+      Serialization::write (buffer, merged_sums.products);
+      Serialization::write (buffer, merged_sums.pair_sums);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      unsigned int saved_max_lag;
+      Serialization::read (buffer, saved_max_lag);
+      assert (saved_max_lag == max_lag);
+
+      Serialization::read (buffer, dimension);
+      Serialization::read (buffer, shift);
+      Serialization::read (buffer, n_samples);
+      Serialization::read (buffer, sum);
+      Serialization::read (buffer, first_samples);
+      Serialization::read (buffer, tail);
+      Serialization::read (buffer, block);
+      Serialization::read (buffer, products);
+
+      Serialization::read (buffer, merged_sums.n_samples);
+      Serialization::read (buffer, merged_sums.sum);
+      Serialization::read (buffer, merged_sums.n_pairs);
+      Serialization::read (buffer, merged_sums.products);
+      Serialization::read (buffer, merged_sums.pair_sums);
+
+      // The object that saved the data may have used a larger block
+      // size than we do:
+      if (block.size() >= static_cast<std::size_t>(block_size)*dimension)
+        process_block ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    FFTAutoCovarianceTrace<InputType>::
+    merge (const FFTAutoCovarianceTrace &other)
+    {
+      assert (other.max_lag == max_lag);
+
+      // Get the sums of the other object, including the ones it has
+      // itself received from others:
+      Sums other_sums;
+      std::vector<double> other_shift;
+      {
+        const std::unique_lock<std::mutex> lock = other.lock_state (other.mutex);
+        if (other.shift.empty())
+          return;
+
+        other_sums = other.own_sums();
+        if (other.merged_sums.n_samples > 0)
+          other_sums.add (other.merged_sums, std::vector<double>(other.dimension, 0.));
+        other_shift = other.shift;
+      }
+      if (other_sums.n_samples == 0)
+        return;
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // If we have not seen any samples yet, adopt the shift of the other
+      // object:
+      if (shift.empty())
+        {
+          dimension = other_shift.size();
+          shift     = other_shift;
+          sum       = std::vector<double>(dimension, 0.);
+          products  = std::vector<double>(max_lag+1, 0.);
+        }
+      assert (other_shift.size() == dimension);
+
+      std::vector<double> shift_difference (dimension);
+      for (unsigned int j=0; j<dimension; ++j)
+        shift_difference[j] = other_shift[j] - shift[j];
+      merged_sums.add (other_sums, shift_difference);
+    }
+  }
+}
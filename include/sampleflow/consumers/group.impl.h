@@ -0,0 +1,298 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that forwards every sample it receives to a number of
+     * other consumers, the "members" of the group. The point of this class
+     * is to reduce the cost of attaching many consumers to the same
+     * producer: If each of $N$ consumers is connected to the producer
+     * separately, then each sample is sent through $N$ slots of the
+     * producer's signal, is copied $N$ times, and requires acquiring $N$
+     * locks. If instead the $N$ consumers are members of a group, and only
+     * the group is connected to the producer, then each sample goes through
+     * one slot, is copied once for the group, and the members are called
+     * one after the other under one lock via
+     * Consumer::consume_by_reference(). Consumers that do not need to keep
+     * a copy of every sample (for example CountSamples, MeanValue, or
+     * MaximumProbabilitySample) implement that function without copying
+     * the sample. For all others, the base class implementation copies the
+     * sample, except for the last member of the group, which is given the
+     * group's own copy.
+     *
+     * In code, a group is used as follows:
+     * @code
+     *   SampleFlow::Consumers::MeanValue<SampleType>        mean_value;
+     *   SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+     *   SampleFlow::Consumers::CountSamples<SampleType>     count_samples;
+     *
+     *   SampleFlow::Consumers::Group<SampleType> group;
+     *   group.add (mean_value);
+     *   group.add (covariance_matrix);
+     *   group.add (count_samples);
+     *   group.connect_to_producer (mh_sampler);
+     * @endcode
+     * The members can be of any class derived from Consumer, including
+     * Filter classes and classes defined in user code. Members must not
+     * themselves be connected to a producer. Because the group holds
+     * pointers to its members, it must be destroyed (or disconnected from
+     * its producers via disconnect_and_flush()) before any of its members
+     * are; declaring the group after its members, as in the example above,
+     * ensures this.
+     *
+     * Batches of samples a producer sends via the Producer::issue_batch
+     * signal are passed on unchanged to the Consumer::consume_batch()
+     * functions of all members.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The group calls the functions of its members while holding a lock,
+     * so that the members see the samples one at a time and in the same
+     * order. Because some members may depend on the order in which samples
+     * arrive, the group only supports ParallelMode::synchronous and
+     * ParallelMode::dedicated_thread. In the latter case, all members
+     * process samples on the group's worker thread. The parallel modes the
+     * members themselves have been set to do not matter, since they are
+     * not connected to a producer; however, members set to
+     * ParallelMode::single_threaded skip acquiring their own locks, which
+     * is safe as long as their results are only queried once sampling has
+     * finished.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$.
+     */
+    template <typename InputType>
+    class Group : public Consumer<InputType>
+    {
+      public:
+        /**
+         * Constructor. The group initially has no members.
+         */
+        Group ();
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Group ();
+
+        /**
+         * Add a consumer to the group. This function needs to be called
+         * before the group is connected to a producer.
+         *
+         * @param[in] member The consumer to be added. The group stores a
+         *   pointer to this object, which therefore needs to live at least
+         *   as long as the group is connected to a producer.
+         */
+        void
+        add (Consumer<InputType> &member);
+
+        /**
+         * Return the number of consumers that are members of the group.
+         */
+        std::size_t
+        n_members () const;
+
+        /**
+         * Process one sample by passing it on to all members of the group.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples by passing it on to the
+         * Consumer::consume_batch() functions of all members of the group.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Process one sample owned by the caller by passing it on to all
+         * members of the group. This function is called if the current
+         * group is itself a member of another group.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
+        /**
+         * Make sure that all samples the group has received have been
+         * processed, and then call the flush() function of each member.
+         * (This matters for members that are themselves filters, which
+         * pass the flush on to their downstream consumers.)
+         */
+        virtual
+        void
+        flush () override;
+
+        /**
+         * Pass the announcement of the samples the group is about to receive
+         * on to all members of the group. See Consumer::prepare_for_samples().
+         */
+        virtual
+        void
+        prepare_for_samples (const SampleShape &shape) override;
+
+      private:
+        /**
+         * A mutex used to serialize the calls to the member consumers.
+         */
+        std::mutex mutex;
+
+        /**
+         * Pointers to the members of the group.
+         */
+        std::vector<Consumer<InputType> *> members;
+    };
+
+
+
+    template <typename InputType>
+    Group<InputType>::
+    Group ()
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread)))
+    {}
+
+
+
+    template <typename InputType>
+    Group<InputType>::
+    ~Group ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    add (Consumer<InputType> &member)
+    {
+      assert (&member != this);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      members.push_back (&member);
+    }
+
+
+
+    template <typename InputType>
+    std::size_t
+    Group<InputType>::
+    n_members () const
+    {
+      return members.size();
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      if (members.empty())
+        return;
+
+      // All but the last member only get to see a reference to the
+      // sample. The last one can take over the sample:
+      for (std::size_t i=0; i<members.size()-1; ++i)
+        members[i]->consume_by_reference (sample, aux_data);
+      members.back()->consume (std::move(sample), std::move(aux_data));
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      for (Consumer<InputType> *member : members)
+        member->consume_batch (samples, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      for (Consumer<InputType> *member : members)
+        member->consume_by_reference (sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    flush ()
+    {
+      Consumer<InputType>::flush ();
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (Consumer<InputType> *member : members)
+        member->flush ();
+    }
+
+
+
+    template <typename InputType>
+    void
+    Group<InputType>::
+    prepare_for_samples (const SampleShape &shape)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (Consumer<InputType> *member : members)
+        member->receive_announcement (shape);
+    }
+
+  }
+}
@@ -0,0 +1,939 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that identifies the states that occur most often
+     * among the samples it receives, and estimates how often they occur,
+     * using a fixed amount of memory. This is useful for discrete models
+     * whose state space is combinatorially large -- say, the structure of
+     * a graph, or an assignment of objects to clusters -- and for which
+     * chains visit so many distinct states that the exact counts
+     * Consumers::StateCounts or Consumers::CategoricalHistogram keep no
+     * longer fit into memory. Typically, only a small number of these
+     * states carries a substantial part of the posterior probability, and
+     * these are the states that this class reports.
+     *
+     * The class combines two well-known data structures for summarizing
+     * streams of data:
+     * - A table of $k$ counters maintained by the "Space-Saving" algorithm
+     *   of Metwally, Agrawal, and El Abbadi (2005). A state that is already
+     *   in the table has its counter incremented. A state that is not
+     *   replaces the state with the smallest count $c_\text{min}$, and
+     *   starts with count $c_\text{min}+1$ and an error bound of
+     *   $c_\text{min}$. As a consequence, the count of each state in the
+     *   table overestimates its true number of occurrences by at most
+     *   its error bound, which is at most $N/k$ after $N$ samples, and
+     *   every state that makes up more than a fraction $1/k$ of the samples
+     *   is guaranteed to be in the table.
+     * - A "count-min sketch" (Cormode and Muthukrishnan, 2005): An array of
+     *   $d$ rows of $w$ counters, in each of which a sample increments the
+     *   counter selected by a hash function of the sample that is different
+     *   for each row. The smallest of the $d$ counters a sample maps to is
+     *   an estimate of the number of occurrences of any state -- not only
+     *   those in the table -- that is never too small, and with probability
+     *   at least $1-e^{-d}$ too large by at most $eN/w$.
+     *
+     * get() reports the states in the Space-Saving table, ordered by their
+     * estimated number of occurrences. For each of them, both data
+     * structures provide an upper bound for the number of occurrences, and
+     * the estimate reported is the smaller of the two. The Space-Saving
+     * table also provides a lower bound, namely its count minus its error
+     * bound. Dividing these numbers by n_samples() yields approximate
+     * frequencies, i.e., posterior probabilities of the states.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says.
+     *
+     * The memory used by objects of this class does not depend on the
+     * number of samples or the number of distinct states: It consists of
+     * the $dw$ counters of the sketch, plus one Space-Saving table with $k$
+     * counters and two copies of the $k$ states for each of the shards
+     * discussed below.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads -- for example, if several chains send their samples to the
+     * same object of this class. The counters of the sketch are atomic
+     * variables that are incremented without acquiring any lock. The
+     * Space-Saving table is kept separately for each thread in a
+     * ShardedAccumulator object, and so threads only compete for the lock
+     * that protects a table if there are more threads than shards. get()
+     * combines the tables of all shards using the merge operation for
+     * Space-Saving tables described by Agarwal et al. ("Mergeable
+     * summaries", 2013), which preserves the error bounds discussed above.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. States are compared with SampleEqual and hashed with
+     *   SampleHash.
+     */
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    class HeavyHitters : public Consumer<InputType>
+    {
+      public:
+        /**
+         * A structure describing one of the most frequent states.
+         */
+        struct HeavyHitter
+        {
+          /**
+           * The state itself.
+           */
+          InputType sample;
+
+          /**
+           * An estimate of the number of samples that were equal to this
+           * state. This number is never smaller than the true number.
+           */
+          types::sample_index estimated_count;
+
+          /**
+           * A number of samples that were guaranteed to be equal to this
+           * state. This number is never larger than the true number.
+           */
+          types::sample_index guaranteed_count;
+        };
+
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(): A vector of at most $k$
+         * states, sorted by decreasing estimated number of occurrences.
+         */
+        using value_type = std::vector<HeavyHitter>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] n_heavy_hitters The number $k$ of counters of the
+         *   Space-Saving table, i.e., the largest number of states get()
+         *   reports.
+         * @param[in] sketch_width The number $w$ of counters in each row of
+         *   the count-min sketch.
+         * @param[in] sketch_depth The number $d$ of rows of the count-min
+         *   sketch.
+         */
+        HeavyHitters (const unsigned int n_heavy_hitters,
+                      const unsigned int sketch_width = 2048,
+                      const unsigned int sketch_depth = 4);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~HeavyHitters ();
+
+        /**
+         * Process one sample by updating the sketch and the Space-Saving
+         * table of the current thread.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count of the sample (see
+         *   AuxiliaryData::n_repetitions()) and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a sample that the caller continues to own. Since this
+         * class only copies a sample when it enters the Space-Saving table,
+         * this avoids the copy that the base class implementation makes.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
+        /**
+         * Process a batch of samples. This updates the Space-Saving table of
+         * the current thread only once for the whole batch, and does not
+         * copy samples other than those that enter the table.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return the key of the entry of the auxiliary data that this class
+         * uses: AuxiliaryData::repetition_count. See
+         * Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return the most frequent states seen so far, in the format
+         * discussed in the documentation of the `value_type` type.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the estimate the count-min sketch provides for the number
+         * of samples seen so far that were equal to the given state. The
+         * state does not need to be one of those reported by get().
+         */
+        types::sample_index
+        estimated_count (const InputType &sample) const;
+
+        /**
+         * Return the number of samples seen so far, counting repeated
+         * samples as often as they are repeated.
+         */
+        types::sample_index
+        n_samples () const;
+
+        /**
+         * Append the counters of the sketch and the Space-Saving table to the
+         * given buffer. See the section on saving and combining the state of
+         * consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same parameters as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the information collected by another object with the one
+         * collected by the current object, so that the current object then
+         * describes the union of the samples seen by both objects. Both
+         * objects need to have been created with the same parameters.
+         */
+        void
+        merge (const HeavyHitters &other);
+
+        /**
+         * Return an estimate of the memory used by the sketch and the
+         * Space-Saving tables.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * A Space-Saving table with a fixed number of counters. The counters
+         * are stored in a vector in which each counter keeps its place
+         * while it is used, and are organized as a binary min-heap (ordered
+         * by count) via the indices stored in `heap`, so that the counter
+         * with the smallest count can be found in constant time and a
+         * counter can be updated in logarithmic time.
+         */
+        struct SpaceSavingTable
+        {
+          /**
+           * A counter for one state.
+           */
+          struct Counter
+          {
+            InputType           sample;
+            types::sample_index count;
+            types::sample_index error;
+            std::size_t         heap_position;
+          };
+
+          /**
+           * The number $k$ of counters.
+           */
+          unsigned int max_n_counters = 0;
+
+          /**
+           * The counters, the heap of indices into `counters`, and a hash
+           * table that maps each state to the index of its counter.
+           */
+          std::vector<Counter>     counters;
+          std::vector<std::size_t> heap;
+          std::unordered_map<InputType,std::size_t,SampleHash<InputType>,SampleEqual<InputType>> counter_of;
+
+          /**
+           * Add `n_repetitions` occurrences of the given state. `SampleRef`
+           * is either `const InputType &` or `InputType`, in which case the
+           * sample is moved into the table if it replaces another state.
+           */
+          template <typename SampleRef>
+          void
+          add (SampleRef                &&sample,
+               const types::sample_index n_repetitions);
+
+          /**
+           * Update the current object so that it describes the union of the
+           * samples described by the current object and the argument.
+           */
+          void
+          merge (const SpaceSavingTable &other);
+
+          /**
+           * Return the smallest count of all counters if all of them are in
+           * use, and zero otherwise. This is an upper bound for the number
+           * of occurrences of any state that is not in the table.
+           */
+          types::sample_index
+          min_count () const;
+
+          /**
+           * Replace the contents of the table by the given counters, of
+           * which only the $k$ ones with the largest counts are kept.
+           */
+          void
+          assign (std::vector<std::tuple<InputType,types::sample_index,types::sample_index>> &&new_counters);
+
+          /**
+           * Move the counter at the given position of the heap up or down
+           * until the heap property is restored.
+           */
+          void
+          sift_up (std::size_t position);
+
+          void
+          sift_down (std::size_t position);
+
+          /**
+           * Write the counters to a buffer, or read them from a buffer.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          void
+          load (std::span<const char> &buffer);
+        };
+
+        /**
+         * The dimensions $w$ and $d$ of the sketch.
+         */
+        const unsigned int sketch_width;
+        const unsigned int sketch_depth;
+
+        /**
+         * The $dw$ counters of the sketch, stored row by row.
+         */
+        std::unique_ptr<std::atomic<types::sample_index>[]> sketch;
+
+        /**
+         * The number of samples seen so far.
+         */
+        std::atomic<types::sample_index> sample_counter;
+
+        /**
+         * The Space-Saving tables of the threads that have sent samples to
+         * this object.
+         */
+        ShardedAccumulator<SpaceSavingTable> tables;
+
+        /**
+         * Return an empty Space-Saving table with the given number of
+         * counters.
+         */
+        static
+        SpaceSavingTable
+        empty_table (const unsigned int n_counters);
+
+        /**
+         * Return the counter in the given row of the sketch that a sample
+         * maps to. The hash function for each row is derived from the
+         * sample's hash value by feeding the latter into a SplitMix64
+         * generator, whose successive outputs are essentially independent.
+         * The `hash_state` argument is the state of this generator: It
+         * needs to be initialized with the sample's hash value, and the
+         * function needs to be called for the rows in order.
+         */
+        std::atomic<types::sample_index> &
+        sketch_counter (const unsigned int row,
+                        std::uint64_t     &hash_state) const;
+
+        /**
+         * Return the sketch's estimate for the number of occurrences of the
+         * state with the given hash value.
+         */
+        types::sample_index
+        sketch_estimate (const std::size_t hash) const;
+
+        /**
+         * Process `n_repetitions` occurrences of a sample. See
+         * SpaceSavingTable::add() for the meaning of `SampleRef`.
+         */
+        template <typename SampleRef>
+        void
+        add (SampleRef          &&sample,
+             const AuxiliaryData &aux_data);
+
+        /**
+         * Add `n_repetitions` occurrences of a sample to the sketch, and
+         * to the number of samples seen.
+         */
+        void
+        add_to_sketch (const InputType          &sample,
+                       const types::sample_index n_repetitions);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    template <typename SampleRef>
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    add (SampleRef                &&sample,
+         const types::sample_index n_repetitions)
+    {
+      const auto p = counter_of.find (sample);
+      if (p != counter_of.end())
+        {
+          // The state is already in the table. Increase its count, which
+          // may move it down the heap:
+          Counter &counter = counters[p->second];
+          counter.count += n_repetitions;
+          sift_down (counter.heap_position);
+        }
+      else if (counters.size() < max_n_counters)
+        {
+          // There is still an unused counter:
+          const std::size_t index = counters.size();
+          counter_of.emplace (sample, index);
+          counters.push_back (Counter {std::forward<SampleRef>(sample),
+                                       n_repetitions, 0, heap.size()});
+          heap.push_back (index);
+          sift_up (heap.size()-1);
+        }
+      else if (max_n_counters > 0)
+        {
+          // Replace the state with the smallest count, which is at the top
+          // of the heap. The new state inherits its count as error bound:
+          const std::size_t index = heap[0];
+          Counter &counter = counters[index];
+          counter_of.erase (counter.sample);
+          counter_of.emplace (sample, index);
+
+          counter.sample = std::forward<SampleRef>(sample);
+          counter.error  = counter.count;
+          counter.count += n_repetitions;
+          sift_down (0);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    merge (const SpaceSavingTable &other)
+    {
+      if (other.counters.size() == 0)
+        return;
+
+      // Every state that is only in one of the two tables may have
+      // occurred up to min_count() times among the samples described by
+      // the other table. Add this number to both its count and its error
+      // bound:
+      const types::sample_index own_min_count   = min_count();
+      const types::sample_index other_min_count = other.min_count();
+
+      std::vector<std::tuple<InputType,types::sample_index,types::sample_index>> combined;
+      combined.reserve (counters.size() + other.counters.size());
+      for (const Counter &counter : counters)
+        {
+          const auto p = other.counter_of.find (counter.sample);
+          if (p != other.counter_of.end())
+            combined.emplace_back (counter.sample,
+                                   counter.count + other.counters[p->second].count,
+                                   counter.error + other.counters[p->second].error);
+          else
+            combined.emplace_back (counter.sample,
+                                   counter.count + other_min_count,
+                                   counter.error + other_min_count);
+        }
+      for (const Counter &counter : other.counters)
+        if (counter_of.find (counter.sample) == counter_of.end())
+          combined.emplace_back (counter.sample,
+                                 counter.count + own_min_count,
+                                 counter.error + own_min_count);
+
+      max_n_counters = std::max (max_n_counters, other.max_n_counters);
+      assign (std::move(combined));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    HeavyHitters<InputType>::SpaceSavingTable::
+    min_count () const
+    {
+      if ((counters.size() < max_n_counters) || (counters.size() == 0))
+        return 0;
+      else
+        return counters[heap[0]].count;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    assign (std::vector<std::tuple<InputType,types::sample_index,types::sample_index>> &&new_counters)
+    {
+      // Keep only the counters with the largest counts:
+      if (new_counters.size() > max_n_counters)
+        {
+          std::nth_element (new_counters.begin(),
+                            new_counters.begin() + max_n_counters,
+                            new_counters.end(),
+                            [](const auto &a, const auto &b)
+          {
+            return std::get<1>(a) > std::get<1>(b);
+          });
+          new_counters.erase (new_counters.begin() + max_n_counters,
+                              new_counters.end());
+        }
+
+      counters.clear();
+      heap.clear();
+      counter_of.clear();
+      for (auto &[sample, count, error] : new_counters)
+        {
+          counter_of.emplace (sample, counters.size());
+          counters.push_back (Counter {std::move(sample), count, error, heap.size()});
+          heap.push_back (counters.size()-1);
+          sift_up (heap.size()-1);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    sift_up (std::size_t position)
+    {
+      while (position > 0)
+        {
+          const std::size_t parent = (position-1) / 2;
+          if (counters[heap[parent]].count <= counters[heap[position]].count)
+            break;
+
+          std::swap (heap[parent], heap[position]);
+          counters[heap[parent]].heap_position = parent;
+          counters[heap[position]].heap_position = position;
+          position = parent;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    sift_down (std::size_t position)
+    {
+      while (true)
+        {
+          std::size_t smallest = position;
+          for (const std::size_t child : {2*position+1, 2*position+2})
+            if ((child < heap.size())
+                &&
+                (counters[heap[child]].count < counters[heap[smallest]].count))
+              smallest = child;
+
+          if (smallest == position)
+            break;
+
+          std::swap (heap[smallest], heap[position]);
+          counters[heap[smallest]].heap_position = smallest;
+          counters[heap[position]].heap_position = position;
+          position = smallest;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    save (std::vector<char> &buffer) const
+    {
+      std::vector<std::tuple<InputType,types::sample_index,types::sample_index>> saved_counters;
+      for (const Counter &counter : counters)
+        saved_counters.emplace_back (counter.sample, counter.count, counter.error);
+
+      Serialization::write (buffer, max_n_counters);
+      Serialization::write (buffer, saved_counters);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::SpaceSavingTable::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<std::tuple<InputType,types::sample_index,types::sample_index>> saved_counters;
+      Serialization::read (buffer, max_n_counters);
+      Serialization::read (buffer, saved_counters);
+      assign (std::move(saved_counters));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    HeavyHitters<InputType>::
+    HeavyHitters (const unsigned int n_heavy_hitters,
+                  const unsigned int sketch_width,
+                  const unsigned int sketch_depth)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      sketch_width (sketch_width),
+      sketch_depth (sketch_depth),
+      sketch (std::make_unique<std::atomic<types::sample_index>[]>(std::size_t(sketch_width) * sketch_depth)),
+      sample_counter (0),
+      tables (empty_table (n_heavy_hitters))
+    {
+      assert (n_heavy_hitters >= 1);
+      assert (sketch_width >= 1);
+      assert (sketch_depth >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    HeavyHitters<InputType>::
+    ~HeavyHitters ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      add (std::move(sample), aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
+    {
+      add (sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      for (std::size_t i=0; i<samples.size(); ++i)
+        add_to_sketch (samples[i], aux_data[i].n_repetitions());
+
+      tables.update ([&](SpaceSavingTable &table)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          if (const types::sample_index n_repetitions = aux_data[i].n_repetitions();
+              n_repetitions > 0)
+            table.add (samples[i], n_repetitions);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    HeavyHitters<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key> {AuxiliaryData::repetition_count};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    template <typename SampleRef>
+    void
+    HeavyHitters<InputType>::
+    add (SampleRef          &&sample,
+         const AuxiliaryData &aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      add_to_sketch (sample, n_repetitions);
+
+      tables.update ([&](SpaceSavingTable &table)
+      {
+        table.add (std::forward<SampleRef>(sample), n_repetitions);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    add_to_sketch (const InputType          &sample,
+                   const types::sample_index n_repetitions)
+    {
+      if (n_repetitions == 0)
+        return;
+
+      sample_counter.fetch_add (n_repetitions, std::memory_order_relaxed);
+
+      // This does not require a lock:
+      std::uint64_t hash_state = SampleHash<InputType>()(sample);
+      for (unsigned int row=0; row<sketch_depth; ++row)
+        sketch_counter (row, hash_state).fetch_add (n_repetitions,
+                                                    std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename HeavyHitters<InputType>::value_type
+    HeavyHitters<InputType>::
+    get () const
+    {
+      const SpaceSavingTable table = tables.merged();
+
+      value_type heavy_hitters;
+      heavy_hitters.reserve (table.counters.size());
+      for (const auto &counter : table.counters)
+        heavy_hitters.push_back (HeavyHitter
+        {
+          counter.sample,
+          std::min (counter.count,
+                    sketch_estimate (SampleHash<InputType>()(counter.sample))),
+          counter.count - counter.error
+        });
+
+      std::sort (heavy_hitters.begin(), heavy_hitters.end(),
+                 [](const HeavyHitter &a, const HeavyHitter &b)
+      {
+        return ((a.estimated_count > b.estimated_count)
+                ||
+                ((a.estimated_count == b.estimated_count)
+                 &&
+                 (a.guaranteed_count > b.guaranteed_count)));
+      });
+      return heavy_hitters;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    HeavyHitters<InputType>::
+    estimated_count (const InputType &sample) const
+    {
+      return sketch_estimate (SampleHash<InputType>()(sample));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    HeavyHitters<InputType>::
+    n_samples () const
+    {
+      return sample_counter.load (std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::vector<types::sample_index> sketch_counters (std::size_t(sketch_width) * sketch_depth);
+      for (std::size_t i=0; i<sketch_counters.size(); ++i)
+        sketch_counters[i] = sketch[i].load (std::memory_order_relaxed);
+
+      Serialization::write (buffer, n_samples());
+      Serialization::write (buffer, sketch_counters);
+      Serialization::write (buffer, tables.merged());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      types::sample_index              n_saved_samples;
+      std::vector<types::sample_index> sketch_counters;
+      SpaceSavingTable                 table;
+      Serialization::read (buffer, n_saved_samples);
+      Serialization::read (buffer, sketch_counters);
+      Serialization::read (buffer, table);
+      assert (sketch_counters.size() == std::size_t(sketch_width) * sketch_depth);
+
+      for (std::size_t i=0; i<sketch_counters.size(); ++i)
+        sketch[i].store (sketch_counters[i], std::memory_order_relaxed);
+      sample_counter.store (n_saved_samples, std::memory_order_relaxed);
+      tables.reset (table);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    HeavyHitters<InputType>::
+    merge (const HeavyHitters &other)
+    {
+      assert (other.sketch_width == sketch_width);
+      assert (other.sketch_depth == sketch_depth);
+
+      // Count-min sketches over two sets of samples are simply added:
+      for (std::size_t i=0; i<std::size_t(sketch_width)*sketch_depth; ++i)
+        sketch[i].fetch_add (other.sketch[i].load (std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+      sample_counter.fetch_add (other.n_samples(), std::memory_order_relaxed);
+
+      const SpaceSavingTable other_table = other.tables.merged();
+      tables.update ([&other_table](SpaceSavingTable &table)
+      {
+        table.merge (other_table);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::size_t
+    HeavyHitters<InputType>::
+    memory_consumption () const
+    {
+      // Estimate the memory used by each shard's table by the one used by
+      // the merged table, which has as many counters as the fullest one:
+      const SpaceSavingTable table = tables.merged();
+      std::size_t table_memory = sizeof(SpaceSavingTable)
+                                 + table.counters.capacity() * sizeof(typename SpaceSavingTable::Counter)
+                                 + table.heap.capacity() * sizeof(std::size_t)
+                                 + table.counter_of.bucket_count() * sizeof(void *);
+      for (const auto &counter : table.counters)
+        // Each state is stored in its counter and as the key of a node of
+        // the hash table, which also stores an index and a pointer:
+        table_memory += 2 * Memory::memory_consumption (counter.sample)
+                        + sizeof(std::size_t) + sizeof(void *);
+
+      return sizeof(*this)
+             + std::size_t(sketch_width) * sketch_depth * sizeof(std::atomic<types::sample_index>)
+             + tables.n_shards() * table_memory;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename HeavyHitters<InputType>::SpaceSavingTable
+    HeavyHitters<InputType>::
+    empty_table (const unsigned int n_counters)
+    {
+      SpaceSavingTable table;
+      table.max_n_counters = n_counters;
+      return table;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::atomic<types::sample_index> &
+    HeavyHitters<InputType>::
+    sketch_counter (const unsigned int row,
+                    std::uint64_t     &hash_state) const
+    {
+      assert (row < sketch_depth);
+      const std::size_t column = Random::internal::splitmix64 (hash_state) % sketch_width;
+      return sketch[std::size_t(row)*sketch_width + column];
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    HeavyHitters<InputType>::
+    sketch_estimate (const std::size_t hash) const
+    {
+      std::uint64_t hash_state = hash;
+      types::sample_index estimate = std::numeric_limits<types::sample_index>::max();
+      for (unsigned int row=0; row<sketch_depth; ++row)
+        estimate = std::min (estimate,
+                             sketch_counter (row, hash_state).load (std::memory_order_relaxed));
+      return estimate;
+    }
+  }
+}
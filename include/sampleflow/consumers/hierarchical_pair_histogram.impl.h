@@ -0,0 +1,746 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace HierarchicalPairHistogram
+    {
+      /**
+       * A structure that describes one node of the quadtree a
+       * HierarchicalPairHistogram stores: The number of samples that have
+       * been counted in the rectangle the node represents, and the index
+       * of the first of its four children in the array that stores all
+       * nodes. Since the root of the tree is stored at index zero and is
+       * nobody's child, a value of zero for the latter indicates that the
+       * node has no children.
+       *
+       * The children of a node are stored consecutively and represent, in
+       * this order, the bottom left, bottom right, top left, and top right
+       * quarter of the rectangle of their parent.
+       */
+      struct Node
+      {
+        types::sample_index n_samples;
+        std::size_t         first_child;
+      };
+    }
+  }
+
+
+
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that, like the PairHistogram class, computes a
+     * joint histogram of two components of vector-valued samples, but
+     * with bins whose size adapts to the number of samples in them: Where
+     * many samples fall, bins are small, and where few samples fall, bins
+     * are large. This allows looking at the histogram at any level of
+     * detail, for example when zooming into a part of the range, from
+     * one pass over the samples, whereas a PairHistogram would have to be
+     * re-computed with a new range and number of bins for each zoom
+     * level. The sample type needs to have exactly two components for
+     * this class to work.
+     *
+     * The bins are organized in a quadtree: The root of the tree is the
+     * rectangle $[x_\text{min},x_\text{max}) \times [y_\text{min},y_\text{max})$
+     * given to the constructor, and each node of the tree is either a
+     * leaf or has four children that split its rectangle into four
+     * equally sized quarters. Initially, the tree consists of only the
+     * root. Every node counts the samples that fall into its rectangle,
+     * and once a leaf has counted `split_threshold` samples, it is given
+     * four children that then count the samples that arrive from then on.
+     * This continues until the leaves reach the maximal depth given to the
+     * constructor, or until the tree has the maximal number of nodes
+     * given to the constructor; after that, leaves simply keep counting.
+     * As a consequence, the memory used by this class is proportional to
+     * the number of nodes, which grows with the level of detail the
+     * sample distribution requires but is bounded by the given budget,
+     * rather than with the number of bins a PairHistogram with the
+     * finest bin size would need across the whole range.
+     *
+     * Because the children of a node only exist once the node has counted
+     * `split_threshold` samples, they do not know where in their parent the
+     * earlier samples fell. The get() function therefore reports, for each
+     * bin, the number of samples the bin's node has counted itself plus an
+     * estimate of the number of the earlier samples of its ancestors that
+     * fell into it: The samples of a node that its children have not
+     * counted are distributed among the children in proportion to the
+     * numbers of samples the children have counted. These estimates add up
+     * exactly: The numbers reported for the four children of a node always
+     * add up to the number reported for the node itself, and the numbers
+     * for all bins of the histogram to the number of samples counted. To
+     * keep the estimates accurate, get() only uses the children of a node
+     * as bins once they have counted at least as many samples as they do
+     * not know about, and otherwise reports the node itself as a bin. For
+     * large numbers of samples, the samples a node counts before it is
+     * split are a small fraction of all of its samples, and the estimates
+     * are close to the numbers of samples one would count in a
+     * PairHistogram with the same bins.
+     *
+     * Samples that lie outside the range given to the constructor, or
+     * that have components that are not finite numbers, are not counted.
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. Unlike the PairHistogram class, this class does not
+     * accumulate the weights of samples.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread counts samples in its own tree, stored in a
+     * ShardedAccumulator object, so that threads do not have to wait for
+     * each other; the budget for the number of nodes applies to each of
+     * these trees separately. get() and the other functions that need the
+     * complete histogram then merge the trees, refining each one where the
+     * others are finer.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. The requirements on this type are the same as for
+     *   the PairHistogram class.
+     */
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class HierarchicalPairHistogram : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(). This is the same type as
+         * PairHistogram::weighted_value_type: Each bin is represented by its
+         * bottom left and top right corners, and the (estimated, see the
+         * documentation of this class) number of samples in it.
+         */
+        using value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,double>>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] min_x_value The left end point of the range of the
+         *   first coordinate. Samples with a smaller first coordinate are
+         *   not counted.
+         * @param[in] max_x_value The right end point of the range of the
+         *   first coordinate. Samples with a first coordinate equal to or
+         *   larger than this value are not counted.
+         * @param[in] min_y_value Like `min_x_value`, but for the second
+         *   coordinate.
+         * @param[in] max_y_value Like `max_x_value`, but for the second
+         *   coordinate.
+         * @param[in] max_n_nodes The maximal number of nodes of the tree,
+         *   i.e., the memory budget of this object. Each node takes 16
+         *   bytes. Since every node other than the root has three siblings,
+         *   the tree has at most $3/4$ of this number of leaves. Must be at
+         *   least one.
+         * @param[in] split_threshold The number of samples a leaf of the
+         *   tree needs to have counted before it is split into four
+         *   children. Small values lead to fine bins early on but also to
+         *   less accurate estimates of the numbers of samples in them. Must
+         *   be positive.
+         * @param[in] max_depth The maximal depth of the tree. The smallest
+         *   bins this object can have are $2^{\text{max\_depth}}$ times
+         *   smaller than the range in each coordinate direction. Must be at
+         *   most 52, since finer bins can not be represented in double
+         *   precision arithmetic anyway.
+         */
+        HierarchicalPairHistogram (const double              min_x_value,
+                                   const double              max_x_value,
+                                   const double              min_y_value,
+                                   const double              max_y_value,
+                                   const std::size_t         max_n_nodes,
+                                   const types::sample_index split_threshold = 100,
+                                   const unsigned int        max_depth = 20);
+
+        /**
+         * Copy constructor.
+         */
+        HierarchicalPairHistogram (const HierarchicalPairHistogram<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~HierarchicalPairHistogram ();
+
+        /**
+         * Process one sample by finding the leaf of the tree it lies in,
+         * splitting the leaf if it has counted enough samples, and
+         * incrementing the number of samples of all nodes on the way.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count of the sample (see
+         *   AuxiliaryData::n_repetitions()) and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `value_type` type, with the bins being the leaves of the
+         * tree, except where the leaves have not counted enough samples yet
+         * (see the documentation of this class). Only bins with a nonzero
+         * number of samples are returned.
+         *
+         * @param[in] max_depth If given, leaves deeper than this level of
+         *   the tree are not returned, but their ancestor at this level is
+         *   returned as a bin instead. This allows obtaining a coarse view
+         *   of the histogram.
+         */
+        value_type
+        get (const unsigned int max_depth = std::numeric_limits<unsigned int>::max()) const;
+
+        /**
+         * Like the previous function, but only return bins that intersect
+         * the rectangle with the given bottom left and top right corners.
+         * This is what one needs when zooming into a part of the range:
+         * The bins returned are the finest ones that are available in that
+         * part, and the work this function does is proportional to their
+         * number rather than to the size of the whole tree.
+         */
+        value_type
+        get (const std::array<double,2> &window_min,
+             const std::array<double,2> &window_max,
+             const unsigned int          max_depth = std::numeric_limits<unsigned int>::max()) const;
+
+        /**
+         * Return the number of nodes of the tree, i.e., of the trees of all
+         * threads merged into one.
+         */
+        std::size_t
+        n_nodes () const;
+
+        /**
+         * Append the range, along with the nodes of the tree and the
+         * numbers of samples they have counted, to the given buffer. See
+         * the section on saving and combining the state of consumers in
+         * the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the tree stored by this object by the one previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The object that wrote the
+         * data must have been created with the same range as the current
+         * one. The tree is used as is, even if it has more nodes than the
+         * current object's budget allows; it is then simply not refined
+         * any further.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers of samples that another object has counted to
+         * the ones counted by the current object, refining the tree of the
+         * current object where the one of the other object is finer. Both
+         * objects must have been created with the same range.
+         */
+        void
+        merge (const HierarchicalPairHistogram &other);
+
+      private:
+        /**
+         * The range given to the constructor.
+         */
+        const double min_x_value;
+        const double max_x_value;
+        const double min_y_value;
+        const double max_y_value;
+
+        /**
+         * A structure storing the tree of samples processed by one shard
+         * of the `partial_histograms` variable below.
+         */
+        struct PartialHistogram
+        {
+          /**
+           * The limits on the tree given to the constructor.
+           */
+          std::size_t         max_n_nodes = 1;
+          types::sample_index split_threshold = 1;
+          unsigned int        max_depth = 0;
+
+          /**
+           * The nodes of the tree, with the root at index zero.
+           */
+          std::vector<internal::HierarchicalPairHistogram::Node> nodes
+            = std::vector<internal::HierarchicalPairHistogram::Node> (1, {0, 0});
+
+          /**
+           * Add a sample with the given repetition count at the given
+           * position, with coordinates relative to the range given to the
+           * constructor, i.e., scaled to lie in $[0,1)$.
+           */
+          void
+          add_sample (double                    x,
+                      double                    y,
+                      const types::sample_index n_repetitions);
+
+          /**
+           * Give the leaf with the given index four children that have not
+           * counted any samples yet.
+           */
+          void
+          split (const std::size_t node);
+
+          /**
+           * Add the numbers of samples counted by the node with index
+           * `other_node` of `other`, and its descendants, to the ones of the
+           * node with index `node` of the current object and its
+           * descendants, creating the latter where necessary.
+           */
+          void
+          merge_node (const std::size_t       node,
+                      const PartialHistogram &other,
+                      const std::size_t       other_node);
+
+          /**
+           * Add the numbers of samples counted by the tree stored in the
+           * argument to the ones counted by the current object.
+           */
+          void
+          merge (const PartialHistogram &other);
+        };
+
+        /**
+         * The trees built by the threads that have sent samples to this
+         * object.
+         */
+        ShardedAccumulator<PartialHistogram> partial_histograms;
+
+        /**
+         * Append to `bins` the bins that correspond to the node with index
+         * `node` of the given tree, if it is a leaf, at depth `max_depth`,
+         * or has children that have not counted enough samples yet, and to
+         * its descendants otherwise, as long as they intersect the given
+         * window. The node is at depth `depth` and has coordinates
+         * `(i,j)` among the $2^\text{depth} \times 2^\text{depth}$ rectangles
+         * of that depth; `n_samples` is the (estimated) number of samples
+         * in its rectangle.
+         */
+        void
+        collect_bins (const PartialHistogram     &histogram,
+                      const std::size_t           node,
+                      const unsigned int          depth,
+                      const std::uint64_t         i,
+                      const std::uint64_t         j,
+                      const double                n_samples,
+                      const std::array<double,2> &window_min,
+                      const std::array<double,2> &window_max,
+                      const unsigned int          max_depth,
+                      value_type                 &bins) const;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    HierarchicalPairHistogram<InputType>::
+    HierarchicalPairHistogram (const double              min_x_value,
+                               const double              max_x_value,
+                               const double              min_y_value,
+                               const double              max_y_value,
+                               const std::size_t         max_n_nodes,
+                               const types::sample_index split_threshold,
+                               const unsigned int        max_depth)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      min_x_value (min_x_value),
+      max_x_value (max_x_value),
+      min_y_value (min_y_value),
+      max_y_value (max_y_value),
+      partial_histograms (PartialHistogram {max_n_nodes, split_threshold, max_depth})
+    {
+      assert (min_x_value < max_x_value);
+      assert (min_y_value < max_y_value);
+      assert (max_n_nodes >= 1);
+      assert (split_threshold > 0);
+      assert (max_depth <= 52);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    HierarchicalPairHistogram<InputType>::
+    HierarchicalPairHistogram (const HierarchicalPairHistogram<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      min_x_value (o.min_x_value),
+      max_x_value (o.max_x_value),
+      min_y_value (o.min_y_value),
+      max_y_value (o.max_y_value),
+      partial_histograms (o.partial_histograms)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    HierarchicalPairHistogram<InputType>::
+    ~HierarchicalPairHistogram ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      assert (sample.size() == 2);
+
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      // If a sample lies outside the range, just discard it. Written this
+      // way, the comparisons also discard samples that are not finite:
+      const double x = sample[0];
+      const double y = sample[1];
+      if (!((x >= min_x_value) && (x < max_x_value) && (y >= min_y_value) && (y < max_y_value)))
+        return;
+
+      // Scale the coordinates to [0,1). Round-off may make a value just
+      // below the right end point come out as one, which we need to avoid:
+      const double below_one = std::nextafter (1., 0.);
+      const double scaled_x  = std::min ((x - min_x_value) / (max_x_value - min_x_value), below_one);
+      const double scaled_y  = std::min ((y - min_y_value) / (max_y_value - min_y_value), below_one);
+
+      partial_histograms.update ([=](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.add_sample (scaled_x, scaled_y, n_repetitions);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename HierarchicalPairHistogram<InputType>::value_type
+    HierarchicalPairHistogram<InputType>::
+    get (const unsigned int max_depth) const
+    {
+      return get ({{min_x_value, min_y_value}}, {{max_x_value, max_y_value}}, max_depth);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename HierarchicalPairHistogram<InputType>::value_type
+    HierarchicalPairHistogram<InputType>::
+    get (const std::array<double,2> &window_min,
+         const std::array<double,2> &window_max,
+         const unsigned int          max_depth) const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+
+      value_type bins;
+      collect_bins (histogram, 0, 0, 0, 0, histogram.nodes[0].n_samples,
+                    window_min, window_max, max_depth, bins);
+      return bins;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    HierarchicalPairHistogram<InputType>::
+    n_nodes () const
+    {
+      return partial_histograms.merged().nodes.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+
+      Serialization::write (buffer, std::array<double,4> {{min_x_value, max_x_value,
+                                                           min_y_value, max_y_value
+                                                          }
+                                                         });
+      Serialization::write (buffer, histogram.nodes);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::array<double,4> saved_range;
+      Serialization::read (buffer, saved_range);
+      assert ((saved_range == std::array<double,4> {{min_x_value, max_x_value,
+                                                     min_y_value, max_y_value
+                                                    }
+                                                   }));
+
+      // Keep the current limits on the tree, but replace its nodes:
+      PartialHistogram histogram = partial_histograms.merged();
+      Serialization::read (buffer, histogram.nodes);
+      assert (histogram.nodes.size() >= 1);
+
+      partial_histograms.reset (histogram);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::
+    merge (const HierarchicalPairHistogram &other)
+    {
+      assert (other.min_x_value == min_x_value);
+      assert (other.max_x_value == max_x_value);
+      assert (other.min_y_value == min_y_value);
+      assert (other.max_y_value == max_y_value);
+
+      const PartialHistogram other_histogram = other.partial_histograms.merged();
+      partial_histograms.update ([&other_histogram](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.merge (other_histogram);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::
+    collect_bins (const PartialHistogram     &histogram,
+                  const std::size_t           node,
+                  const unsigned int          depth,
+                  const std::uint64_t         i,
+                  const std::uint64_t         j,
+                  const double                n_samples,
+                  const std::array<double,2> &window_min,
+                  const std::array<double,2> &window_max,
+                  const unsigned int          max_depth,
+                  value_type                 &bins) const
+    {
+      // Compute the corners of the rectangle of the current node, and
+      // skip it if it does not intersect the window:
+      const double x_width = std::ldexp (max_x_value - min_x_value, -static_cast<int>(depth));
+      const double y_width = std::ldexp (max_y_value - min_y_value, -static_cast<int>(depth));
+      const std::array<double,2> lower_left  = {{min_x_value + i*x_width,
+                                                 min_y_value + j*y_width
+                                                }
+                                               };
+      const std::array<double,2> upper_right = {{min_x_value + (i+1)*x_width,
+                                                 min_y_value + (j+1)*y_width
+                                                }
+                                               };
+      if ((upper_right[0] <= window_min[0]) || (lower_left[0] >= window_max[0])
+          ||
+          (upper_right[1] <= window_min[1]) || (lower_left[1] >= window_max[1])
+          ||
+          (n_samples == 0))
+        return;
+
+      // Report the current node as a bin if it is a leaf, if it is as
+      // deep as we are asked to go, or if its children have counted fewer
+      // samples than they do not know about:
+      const std::size_t first_child = histogram.nodes[node].first_child;
+      types::sample_index n_resolved_samples = 0;
+      if (first_child != 0)
+        for (unsigned int q=0; q<4; ++q)
+          n_resolved_samples += histogram.nodes[first_child+q].n_samples;
+      const double n_unresolved_samples = n_samples - n_resolved_samples;
+
+      if ((first_child == 0) || (depth >= max_depth) || (n_resolved_samples < n_unresolved_samples))
+        {
+          bins.emplace_back (lower_left, upper_right, n_samples);
+          return;
+        }
+
+      // Otherwise distribute the samples the children have not counted
+      // among them, in proportion to the ones they have counted:
+
+      for (unsigned int q=0; q<4; ++q)
+        {
+          const types::sample_index n_child_samples = histogram.nodes[first_child+q].n_samples;
+          const double share = 1. * n_child_samples / n_resolved_samples;
+          collect_bins (histogram, first_child+q, depth+1,
+                        2*i + (q % 2), 2*j + (q / 2),
+                        n_child_samples + share * n_unresolved_samples,
+                        window_min, window_max, max_depth, bins);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::PartialHistogram::
+    add_sample (double                    x,
+                double                    y,
+                const types::sample_index n_repetitions)
+    {
+      std::size_t node = 0;
+      for (unsigned int depth=0; ; ++depth)
+        {
+          // If we have arrived at a leaf, either split it or count the
+          // sample there:
+          if (nodes[node].first_child == 0)
+            {
+              if ((nodes[node].n_samples < split_threshold)
+                  ||
+                  (depth >= max_depth)
+                  ||
+                  (nodes.size() + 4 > max_n_nodes))
+                {
+                  nodes[node].n_samples += n_repetitions;
+                  return;
+                }
+              split (node);
+            }
+
+          // Otherwise count the sample in the current node, and move on
+          // to the child that contains it. Doubling the scaled
+          // coordinates and subtracting one is exact in floating point
+          // arithmetic.
+          nodes[node].n_samples += n_repetitions;
+
+          x *= 2;
+          y *= 2;
+          const unsigned int right_half = (x >= 1 ? 1 : 0);
+          const unsigned int top_half   = (y >= 1 ? 1 : 0);
+          x -= right_half;
+          y -= top_half;
+
+          node = nodes[node].first_child + right_half + 2*top_half;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::PartialHistogram::
+    split (const std::size_t node)
+    {
+      assert (nodes[node].first_child == 0);
+
+      nodes[node].first_child = nodes.size();
+      nodes.insert (nodes.end(), 4, internal::HierarchicalPairHistogram::Node {0, 0});
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::PartialHistogram::
+    merge_node (const std::size_t       node,
+                const PartialHistogram &other,
+                const std::size_t       other_node)
+    {
+      nodes[node].n_samples += other.nodes[other_node].n_samples;
+
+      // If the other tree is refined here, refine the current one as well
+      // (if it is not already), and merge the children. Samples the node
+      // of the current tree has counted before it had children are then
+      // simply ones its new children do not know about, just as if they
+      // had arrived before a split. Note that split() may reallocate the
+      // array of nodes, so we must not hold references into it.
+      const std::size_t other_first_child = other.nodes[other_node].first_child;
+      if (other_first_child != 0)
+        {
+          if (nodes[node].first_child == 0)
+            split (node);
+          for (unsigned int q=0; q<4; ++q)
+            merge_node (nodes[node].first_child+q, other, other_first_child+q);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    HierarchicalPairHistogram<InputType>::PartialHistogram::
+    merge (const PartialHistogram &other)
+    {
+      merge_node (0, other, 0);
+    }
+  }
+}
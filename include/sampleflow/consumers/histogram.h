@@ -16,10 +16,18 @@
 #ifndef SAMPLEFLOW_CONSUMERS_HISTOGRAM_H
 #define SAMPLEFLOW_CONSUMERS_HISTOGRAM_H
 
+#include <sampleflow/compact_counts.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/memory.h>
+#include <sampleflow/persistent_state.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
 #include <sampleflow/types.h>
 
+#include <memory>
 #include <mutex>
+#include <span>
+#include <string>
 #include <type_traits>
 #include <vector>
 #include <tuple>
@@ -30,12 +30,30 @@ namespace SampleFlow
      * are integer-valued, then the intervals should be chosen to be from
      * $n-0.5$ to $n+0.5$ for integers $n$.
      *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples).
+     * If samples carry weights (see AuxiliaryData::sample_weight), then the
+     * class also adds up the weights of the samples in each bin; these
+     * can be obtained via get_weighted(), whereas get() and write_gnuplot()
+     * continue to report the number of samples in each bin.
+     *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Each thread counts samples in its own copy of the bins, stored
+     * in a ShardedAccumulator object, so that threads do not have to wait for
+     * each other; the get() function adds up these counts.
+     *
+     * For histograms whose bins are equally spaced (i.e., that were created
+     * with the first constructor), the bin a sample falls into is computed
+     * arithmetically, rather than by a binary search over the break points
+     * between bins. consume_batch() computes the bins of all samples of a
+     * batch in a separate, simple loop that the compiler can vectorize,
+     * before adding them to the counts.
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$ processed
@@ -76,6 +94,13 @@ namespace SampleFlow
          */
         using value_type = std::vector<std::tuple<double,double,types::sample_index>>;
 
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as `value_type`, except that the third element of each bin is
+         * the sum of the weights of the samples in the bin.
+         */
+        using weighted_value_type = std::vector<std::tuple<double,double,double>>;
+
         /**
          * Constructor for a histogram that is equally spaced in real space.
          *
@@ -130,12 +155,16 @@ namespace SampleFlow
          * @param[in] f The function used in the transformation. For this
          *   set up of bins to make sense, `f` needs to be a strictly
          *   monotonically increasing function on the range
-         *   `[min_pre_values,max_pre_values]`.
+         *   `[min_pre_values,max_pre_values]`. It can be any function object
+         *   that takes and returns a `double`; it is only called in this
+         *   constructor.
          */
+        template <typename Transformation>
+        requires (std::is_invocable_r_v<double,const Transformation &,double>)
         Histogram (const double min_pre_value,
                    const double max_pre_value,
                    const unsigned int n_bins,
-                   const std::function<double (const double)> &f);
+                   const Transformation &f);
 
         /**
          * Copy constructor.
@@ -162,13 +191,37 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
         consume (InputType sample, AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses, namely the repetition count and the weight of samples.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process a batch of samples. This does the same as calling consume()
+         * for each sample, but only acquires the lock that protects the
+         * bins once.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples. As for
+         *   consume(), only the repetition counts and weights are used.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
         /**
          * Return the histogram in the format discussed in the documentation
          * of the `value_type` type.
@@ -178,6 +231,16 @@ namespace SampleFlow
         value_type
         get () const;
 
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `weighted_value_type` type, i.e., with the sum of the
+         * weights of the samples in each bin rather than their number.
+         *
+         * @return The weighted histogram.
+         */
+        weighted_value_type
+        get_weighted () const;
+
         /**
          * Write the histogram into a file in such a way that it can
          * be visualized using the Gnuplot program. Internally, this function
@@ -203,13 +266,49 @@ namespace SampleFlow
         void
         write_gnuplot (std::ostream &&output_stream) const;
 
-      private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * Append the break points of the bins and the numbers and weights of
+         * samples counted in each bin so far to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the counts stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The histogram that wrote
+         * the data must have used the same bins as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another histogram has
+         * counted in each bin to the ones counted by the current object. Both
+         * histograms need to use the same bins.
          */
-        mutable std::mutex mutex;
+        void
+        merge (const Histogram &other);
 
+        /**
+         * Keep the state of this object in the memory-mapped file with the
+         * given name, updated every `interval` samples and when this object
+         * is destroyed, so that it survives if the program is terminated.
+         * If the file already contains a state written this way, for
+         * example by a run of the program that was interrupted, then this
+         * state replaces the current one of this object. See the
+         * PersistentState class for details. This function needs to be
+         * called before the object receives its first sample.
+         *
+         * @return Whether a state was restored from the file.
+         */
+        bool
+        keep_state_in_file (const std::string        &filename,
+                            const types::sample_index interval = 1);
+
+      private:
         /**
          * A variable that describes the left end points of each of the
          * intervals that make up each bin. The vector contains one additional
@@ -218,10 +317,69 @@ namespace SampleFlow
         std::vector<double> interval_points;
 
         /**
-         * A vector storing the number of samples so far encountered in each
-         * of the bins of the histogram.
+         * Whether the bins are equally spaced, and if so the left end point
+         * of the first bin and the inverse of the width of the bins. These
+         * are used to compute the bin of a sample without searching through
+         * `interval_points`.
+         */
+        bool   equally_spaced;
+        double min_value;
+        double inverse_bin_width;
+
+        /**
+         * A structure storing the number of samples so far encountered in
+         * each of the bins of the histogram by one shard of the `bins`
+         * variable below. The arrays are allocated with
+         * Memory::CacheLineAllocator so that the bins of different shards
+         * never share a cache line, and so that histograms with many bins
+         * can be backed by huge pages (see Memory::set_huge_pages()). The
+         * numbers of samples are stored as 32-bit counters in a
+         * CompactCounts object, which moves the few counters that exceed
+         * this range to a separate table of 64-bit counters.
          */
-        std::vector<types::sample_index> bins;
+        struct PartialHistogram
+        {
+          /**
+           * The number of samples in each bin.
+           */
+          CompactCounts<> bin_counts;
+
+          /**
+           * The sum of the weights of the samples in each bin.
+           */
+          std::vector<double,Memory::CacheLineAllocator<double>> bin_weights;
+
+          /**
+           * Add a sample with the given repetition count and weight to the
+           * given bin.
+           */
+          void
+          add_sample (const unsigned int        bin,
+                      const types::sample_index n_repetitions,
+                      const double              weight)
+          {
+            bin_counts.add (bin, n_repetitions);
+            bin_weights[bin] += n_repetitions * weight;
+          }
+
+          /**
+           * Add the numbers and weights of samples stored in the argument to
+           * the ones stored in the current object.
+           */
+          void
+          merge (const PartialHistogram &other)
+          {
+            bin_counts.merge (other.bin_counts);
+            for (unsigned int bin=0; bin<bin_weights.size(); ++bin)
+              bin_weights[bin] += other.bin_weights[bin];
+          }
+        };
+
+        /**
+         * The numbers of samples in each bin counted by the threads that
+         * have sent samples to this object.
+         */
+        ShardedAccumulator<PartialHistogram> bins;
 
         /**
          * For a given `value`, compute the number of the bin it lies
@@ -233,6 +391,21 @@ namespace SampleFlow
          * abort.
          */
         unsigned int bin_number (const double value) const;
+
+        /**
+         * Compute the bins of all of the given samples, in the same way as
+         * bin_number() does, but for samples outside the range of the
+         * histogram return the number of bins. This function is only used
+         * for histograms with equally spaced bins.
+         */
+        std::vector<unsigned int>
+        equally_spaced_bin_numbers (const std::vector<InputType> &samples) const;
+
+        /**
+         * The object that keeps the state of this object in a file, if
+         * keep_state_in_file() has been called.
+         */
+        std::unique_ptr<PersistentState> persistent_state;
     };
 
 
@@ -248,7 +421,11 @@ namespace SampleFlow
                                        |
                                        static_cast<int>(ParallelMode::asynchronous))),
       interval_points(n_bins+1),
-      bins (n_bins)
+      equally_spaced (true),
+      min_value (min_value),
+      inverse_bin_width (n_bins / (max_value - min_value)),
+      bins (PartialHistogram {decltype(PartialHistogram::bin_counts)(n_bins),
+                              decltype(PartialHistogram::bin_weights)(n_bins, 0.)})
     {
       assert (min_value < max_value);
 
@@ -264,17 +441,23 @@ namespace SampleFlow
 
     template <typename InputType>
     requires (std::is_arithmetic_v<InputType>)
+    template <typename Transformation>
+    requires (std::is_invocable_r_v<double,const Transformation &,double>)
     Histogram<InputType>::
     Histogram (const double min_pre_value,
                const double max_pre_value,
                const unsigned int n_bins,
-               const std::function<double (const double)> &f)
+               const Transformation &f)
       :
       Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
                                        |
                                        static_cast<int>(ParallelMode::asynchronous))),
       interval_points(n_bins+1),
-      bins (n_bins)
+      equally_spaced (false),
+      min_value (0),
+      inverse_bin_width (0),
+      bins (PartialHistogram {decltype(PartialHistogram::bin_counts)(n_bins),
+                              decltype(PartialHistogram::bin_weights)(n_bins, 0.)})
     {
       assert (min_pre_value < max_pre_value);
 
@@ -306,6 +489,9 @@ namespace SampleFlow
                                        |
                                        static_cast<int>(ParallelMode::asynchronous))),
       interval_points(o.interval_points),
+      equally_spaced (o.equally_spaced),
+      min_value (o.min_value),
+      inverse_bin_width (o.inverse_bin_width),
       bins (o.bins)
     {}
 
@@ -317,6 +503,8 @@ namespace SampleFlow
     ~Histogram ()
     {
       this->disconnect_and_flush();
+      if (persistent_state)
+        persistent_state->write();
     }
 
 
@@ -325,7 +513,7 @@ namespace SampleFlow
     requires (std::is_arithmetic_v<InputType>)
     void
     Histogram<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    consume (InputType sample, AuxiliaryData aux_data)
     {
       // If a sample lies outside the bounds, just discard it:
       if (sample<interval_points.front() || sample>=interval_points.back())
@@ -334,11 +522,82 @@ namespace SampleFlow
       // Otherwise we need to update the appropriate histogram bin:
       const unsigned int bin = bin_number(sample);
 
-      if (bin >= 0  &&  bin < bins.size())
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double              weight        = aux_data.weight();
+      if (bin >= 0  &&  bin < interval_points.size()-1)
+        bins.update ([bin, n_repetitions, weight](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.add_sample (bin, n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (1);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    Histogram<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    void
+    Histogram<InputType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      // For equally spaced bins, first compute the bins of all samples
+      // (without holding a lock), then add them to the counts:
+      if (equally_spaced)
         {
-          std::lock_guard<std::mutex> lock(mutex);
-          ++bins[bin];
+          const std::vector<unsigned int> sample_bins = equally_spaced_bin_numbers (samples);
+          bins.update ([&](PartialHistogram &partial_histogram)
+          {
+            const unsigned int n_bins = partial_histogram.bin_counts.size();
+            for (std::size_t i=0; i<samples.size(); ++i)
+              if (sample_bins[i] < n_bins)
+                partial_histogram.add_sample (sample_bins[i], aux_data[i].n_repetitions(),
+                                              aux_data[i].weight());
+          }, this->is_single_threaded() == false);
+
+          if (persistent_state)
+            persistent_state->samples_processed (samples.size());
+          return;
         }
+
+      bins.update ([&](PartialHistogram &partial_histogram)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          {
+            const InputType sample = samples[i];
+
+            // Discard samples outside the bounds, as in consume():
+            if (sample<interval_points.front() || sample>=interval_points.back())
+              continue;
+
+            const unsigned int bin = bin_number(sample);
+            if (bin < partial_histogram.bin_counts.size())
+              partial_histogram.add_sample (bin, aux_data[i].n_repetitions(),
+                                            aux_data[i].weight());
+          }
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (samples.size());
     }
 
 
@@ -350,22 +609,45 @@ namespace SampleFlow
     get () const
     {
       // First create the output table and breakpoints. We can do
-      // this without holding the lock since we're not accessing
+      // this without holding a lock since we're not accessing
       // information that is subject to change when a new sample
       // comes in.
-      value_type return_value (bins.size());
-      for (unsigned int bin=0; bin<bins.size(); ++bin)
+      const unsigned int n_bins = interval_points.size()-1;
+      value_type return_value (n_bins);
+      for (unsigned int bin=0; bin<n_bins; ++bin)
         {
           std::get<0>(return_value[bin]) = interval_points[bin];
           std::get<1>(return_value[bin]) = interval_points[bin+1];
         }
 
-      // Now fill the bin sizes under a lock as they are subject to
-      // change from other threads:
-      std::lock_guard<std::mutex> lock(mutex);
-      for (unsigned int bin=0; bin<bins.size(); ++bin)
+      // Now fill the bin sizes by adding up the counts of all
+      // shards:
+      const PartialHistogram histogram = bins.merged();
+      for (unsigned int bin=0; bin<n_bins; ++bin)
+        {
+          std::get<2>(return_value[bin]) = histogram.bin_counts[bin];
+        }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    typename Histogram<InputType>::weighted_value_type
+    Histogram<InputType>::
+    get_weighted () const
+    {
+      const unsigned int n_bins = interval_points.size()-1;
+      weighted_value_type return_value (n_bins);
+
+      const PartialHistogram histogram = bins.merged();
+      for (unsigned int bin=0; bin<n_bins; ++bin)
         {
-          std::get<2>(return_value[bin]) = bins[bin];
+          std::get<0>(return_value[bin]) = interval_points[bin];
+          std::get<1>(return_value[bin]) = interval_points[bin+1];
+          std::get<2>(return_value[bin]) = histogram.bin_weights[bin];
         }
 
       return return_value;
@@ -404,6 +686,23 @@ namespace SampleFlow
     {
       assert (value >= interval_points.front() && value <= interval_points.back());
 
+      // For equally spaced bins, compute the bin directly. Round-off may
+      // put the result one bin off of what the break points stored in
+      // 'interval_points' say, and samples that lie exactly on a break
+      // point are counted for the bin to the left below; correct for both
+      // so that we get the same result as with the binary search:
+      if (equally_spaced)
+        {
+          const unsigned int n_bins = interval_points.size()-1;
+          unsigned int bin = std::min (static_cast<unsigned int>((value - min_value) * inverse_bin_width),
+                                       n_bins-1);
+          if ((bin > 0) && (value <= interval_points[bin]))
+            --bin;
+          else if ((bin < n_bins-1) && (value > interval_points[bin+1]))
+            ++bin;
+          return bin;
+        }
+
       // Find the first element in interval_points that is not < value
       const auto p = std::lower_bound(interval_points.begin(), interval_points.end(),
                                       value);
@@ -417,5 +716,124 @@ namespace SampleFlow
       else
         return (p-interval_points.begin()-1);
     }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    std::vector<unsigned int>
+    Histogram<InputType>::
+    equally_spaced_bin_numbers (const std::vector<InputType> &samples) const
+    {
+      assert (equally_spaced);
+
+      const unsigned int n_bins = interval_points.size()-1;
+      const double       left   = interval_points.front();
+      const double       right  = interval_points.back();
+
+      // Compute the bins without branches, marking samples outside the
+      // range with n_bins:
+      std::vector<unsigned int> sample_bins (samples.size());
+      for (std::size_t i=0; i<samples.size(); ++i)
+        {
+          const double value  = samples[i];
+          const bool   inside = (value >= left) && (value < right);
+          const double scaled = std::clamp ((value - min_value) * inverse_bin_width,
+                                            0., n_bins - 1.);
+          sample_bins[i] = (inside ? static_cast<unsigned int>(scaled) : n_bins);
+        }
+
+      // Then apply the same correction as in bin_number() for samples
+      // close to break points:
+      for (std::size_t i=0; i<samples.size(); ++i)
+        {
+          const unsigned int bin = sample_bins[i];
+          if (bin < n_bins)
+            {
+              const double value = samples[i];
+              if ((bin > 0) && (value <= interval_points[bin]))
+                --sample_bins[i];
+              else if ((bin < n_bins-1) && (value > interval_points[bin+1]))
+                ++sample_bins[i];
+            }
+        }
+
+      return sample_bins;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    void
+    Histogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialHistogram histogram = bins.merged();
+      Serialization::write (buffer, interval_points);
+      Serialization::write (buffer, histogram.bin_counts);
+      Serialization::write (buffer, histogram.bin_weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    void
+    Histogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<double> saved_interval_points;
+      Serialization::read (buffer, saved_interval_points);
+      assert (saved_interval_points == interval_points);
+
+      PartialHistogram histogram;
+      Serialization::read (buffer, histogram.bin_counts);
+      Serialization::read (buffer, histogram.bin_weights);
+      assert (histogram.bin_counts.size() == interval_points.size()-1);
+      assert (histogram.bin_weights.size() == interval_points.size()-1);
+
+      bins.reset (histogram);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    bool
+    Histogram<InputType>::
+    keep_state_in_file (const std::string        &filename,
+                        const types::sample_index interval)
+    {
+      persistent_state = std::make_unique<PersistentState> (filename,
+                                                             [this](std::vector<char> &buffer)
+      {
+        save (buffer);
+      },
+      interval);
+
+      return persistent_state->restore ([this](std::span<const char> &buffer)
+      {
+        load (buffer);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<InputType>)
+    void
+    Histogram<InputType>::
+    merge (const Histogram &other)
+    {
+      assert (other.interval_points == interval_points);
+
+      const PartialHistogram other_histogram = other.bins.merged();
+      bins.update ([&other_histogram](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.merge (other_histogram);
+      }, this->is_single_threaded() == false);
+    }
+
   }
 }
@@ -17,7 +17,8 @@
 #define SAMPLEFLOW_CONSUMERS_LAST_SAMPLE_H
 
 #include <sampleflow/consumer.h>
-#include <mutex>
+#include <atomic>
+#include <memory>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumers/last_sample.impl.h>
@@ -27,10 +27,27 @@ namespace SampleFlow
      * consume() member function can be called concurrently and from multiple
      * threads.
      *
+     * The class does not use a mutex. Rather, consume() moves the sample
+     * into a newly allocated, immutable object and then publishes a
+     * `std::shared_ptr` to it through an atomic variable, and get() and
+     * get_shared() atomically obtain a copy of this pointer. If the sample
+     * type is cheap to move (say, an `Eigen::VectorXd` or a
+     * `std::valarray`), consume() therefore only allocates a
+     * small object and swaps pointers, and reading the last sample never
+     * blocks the threads that generate samples, however long the reader
+     * holds on to the sample. A sample that is no longer the last one is
+     * freed by whoever releases the last pointer to it.
+     * The same is true if the class is connected to a Filters::MakeShared
+     * object, i.e., if `InputType` is a handle `std::shared_ptr<const T>`
+     * (see Concepts::is_sample_handle): The sample the handle refers to is
+     * then not copied, and it is kept alive for as long as it is the last
+     * sample or someone holds a pointer obtained from get_shared().
+     *
      *
      * @tparam InputType The C++ type used for the samples $x_k$.
      */
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     class LastSample : public Consumer<InputType>
     {
       public:
@@ -62,32 +79,47 @@ namespace SampleFlow
         void
         consume (InputType sample, AuxiliaryData aux_data) override;
 
+        /**
+         * Return an empty list, since this class does not look at the
+         * auxiliary data of samples. See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
         /**
          * A function that returns the last sample processed by the consume()
          * function. If no samples have been processed so far, then a
          * default-constructed object of type InputType will be returned.
          *
-         * @return The computed mean value.
+         * @return The last sample.
          */
         value_type
         get () const;
 
-      private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * Like get(), but return a pointer to the last sample rather than a
+         * copy of it. The object pointed to is never modified, and remains
+         * valid for as long as the caller holds on to the pointer, even if
+         * the current object receives other samples in the meantime.
+         *
+         * @return A pointer to the last sample processed by consume(), or an
+         *   empty pointer if no samples have been processed so far.
          */
-        mutable std::mutex mutex;
+        std::shared_ptr<const value_type>
+        get_shared () const;
 
+      private:
         /**
-         * The value of the last sample seen by consume().
+         * A pointer to the last sample seen by consume().
          */
-        InputType last_sample;
+        std::atomic<std::shared_ptr<const InputType>> last_sample;
     };
 
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     LastSample<InputType>::
     ~LastSample ()
     {
@@ -97,25 +129,51 @@ namespace SampleFlow
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     void
     LastSample<InputType>::
     consume (InputType sample, AuxiliaryData /*aux_data*/)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      last_sample.store (std::make_shared<const InputType>(std::move (sample)),
+                         std::memory_order_release);
+    }
+
+
 
-      last_sample = std::move (sample);
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    LastSample<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
     }
 
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     typename LastSample<InputType>::value_type
     LastSample<InputType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      const std::shared_ptr<const InputType> sample = get_shared();
+
+      if (sample)
+        return *sample;
+      else
+        return {};
+    }
 
-      return last_sample;
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::shared_ptr<const typename LastSample<InputType>::value_type>
+    LastSample<InputType>::
+    get_shared () const
+    {
+      return last_sample.load (std::memory_order_acquire);
     }
 
   }
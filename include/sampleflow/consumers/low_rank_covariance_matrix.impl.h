@@ -0,0 +1,623 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes a low-rank approximation of the
+     * covariance matrix of all samples seen so far. More precisely, if
+     * $C$ is the covariance matrix computed by the CovarianceMatrix
+     * class, then the current class computes approximations of the $r$
+     * largest eigenvalues $\lambda_1\ge\lambda_2\ge\ldots\ge\lambda_r$ of
+     * $C$ and of the corresponding eigenvectors $v_1,\ldots,v_r$, so that
+     * $C\approx \sum_{i=1}^r \lambda_i v_i v_i^T$. In other words, the
+     * class computes the principal components of the samples.
+     *
+     * For samples with $d$ components, this requires $O(dr)$ memory and,
+     * on average, $O(dr)$ operations per sample, rather than the $O(d^2)$
+     * memory and operations of the CovarianceMatrix class. This makes the
+     * class appropriate for samples with many components, such as
+     * discretized fields, if most of the variability of the samples lies
+     * in a low-dimensional subspace. (See the BandedCovarianceMatrix class
+     * for an approximation of the covariance matrix for high-dimensional
+     * samples that is appropriate if only nearby components are
+     * correlated.)
+     *
+     * The class is based on the same update of the (weighted) sum of
+     * outer products $M$ as the CovarianceMatrix class, see there:
+     * Whenever a sample is added, $M$ is updated by adding $f\,\delta
+     * \delta^T$, where $\delta$ is the deviation of the sample from the
+     * previous running mean and $f$ a factor that depends on the weights.
+     * In other words, $M=A^TA$, where the rows of the matrix $A$ are the
+     * vectors $\sqrt{f}\delta^T$ of all of these updates. Instead of
+     * storing $A$ or $M$, the class keeps a "sketch" $B$ with only $2r$
+     * rows from which $M$ can be approximated as $B^TB$, using the
+     * "Frequent Directions" algorithm by Liberty (2013), see also
+     * M. Ghashami, E. Liberty, J. M. Phillips, D. P. Woodruff:
+     * "Frequent Directions: Simple and deterministic matrix sketching",
+     * SIAM J. Comput., vol. 45, pp. 1762-1792, 2016.
+     * New rows are appended to $B$ until all $2r$ rows are used. At this
+     * point, the class computes the singular value decomposition
+     * $B=U\Sigma V^T$, subtracts the square of the $(r+1)$st singular value
+     * from the squares of all singular values (setting negative values to
+     * zero), and replaces $B$ by $\tilde\Sigma V^T$ with the singular values
+     * so reduced. This leaves at most $r$ nonzero rows, whose directions
+     * are those in which the samples vary the most. $B^TB$ never
+     * overestimates $M$, and the error $\|M-B^TB\|_2$ is bounded in terms
+     * of the part of $M$ that is not captured by its best approximations
+     * of rank less than $r$ -- in particular, the error is zero if all
+     * samples lie in a subspace of dimension less than or equal to $r$.
+     *
+     * Computing the singular value decomposition of $B$, which has $2r$
+     * rows and $d$ columns, is done via the eigenvalue decomposition of
+     * the $2r\times 2r$ matrix $BB^T$ and costs $O(dr^2)$ operations, but
+     * is only necessary once every $r$ samples.
+     *
+     * The eigenvalues and eigenvectors computed by this class are
+     * normalized in the same way as the ones of the matrix returned by
+     * CovarianceMatrix::get(), including the treatment of weighted and
+     * repeated samples.
+     *
+     * In addition, the class keeps track of the trace of $M$, which is
+     * the sum of all $d$ eigenvalues and which requires only $O(d)$
+     * operations per sample to compute exactly. Comparing the sum of the
+     * $r$ eigenvalues computed with this total (see
+     * value_type::total_variance) shows which fraction of the variability
+     * of the samples the $r$ principal components capture, i.e., whether
+     * $r$ is large enough -- without ever forming the $d\times d$
+     * covariance matrix or computing its eigenvalue decomposition.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread updates its own running mean and sketch, and
+     * get() combines them. Two sketches are combined by stacking their rows,
+     * along with a row that accounts for the difference of the two mean
+     * values as described in the documentation of the CovarianceMatrix
+     * class, and reducing the result to $r$ rows as above.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The
+     *   same requirements hold as listed for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class LowRankCovarianceMatrix : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type of the information generated by this class, namely the
+         * approximations of the largest eigenvalues of the covariance matrix
+         * and of the corresponding eigenvectors.
+         */
+        struct value_type
+        {
+          /**
+           * The eigenvalues $\lambda_i$, sorted in descending order. There
+           * are at most as many eigenvalues as the rank passed to the
+           * constructor, but there may be fewer if the samples seen so far
+           * lie in a lower-dimensional subspace.
+           */
+          Eigen::VectorXd eigenvalues;
+
+          /**
+           * The eigenvectors $v_i$ associated with the eigenvalues, stored as
+           * the columns of this matrix. The eigenvectors have unit length
+           * and are orthogonal to each other.
+           */
+          Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic> eigenvectors;
+
+          /**
+           * The trace of the covariance matrix, i.e., the sum of all of its
+           * eigenvalues, not only of the ones stored above. Unlike the
+           * eigenvalues, this number is computed exactly. The ratio of the
+           * sum of `eigenvalues` to this number is the fraction of the
+           * variance of the samples explained by the eigenvectors above.
+           */
+          double total_variance = 0;
+        };
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] rank The number $r$ of eigenvalues and eigenvectors of
+         *   the covariance matrix to be computed. Must be at least one.
+         */
+        LowRankCovarianceMatrix (const unsigned int rank);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~LowRankCovarianceMatrix ();
+
+        /**
+         * Process one sample by updating the sketch of the covariance
+         * matrix with this one sample.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the approximations of the largest eigenvalues and the
+         * corresponding eigenvectors of the covariance matrix computed from
+         * the samples seen so far. If fewer than two distinct samples have
+         * been processed so far, then the returned object is empty.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Append the running mean, the sketch, the sums of weights, and the
+         * trace computed so far to the given buffer, from which load() can later
+         * restore them. See the section on saving and combining the state
+         * of consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the state of another object with the one of the current
+         * object, so that get() afterwards returns the approximation of
+         * the covariance matrix of the union of the samples both objects
+         * have received. The other object must have been created with the
+         * same rank.
+         */
+        void
+        merge (const LowRankCovarianceMatrix &other);
+
+      private:
+        /**
+         * The rank $r$ passed to the constructor.
+         */
+        const unsigned int rank;
+
+        /**
+         * The type used to store the sketch $B$.
+         */
+        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * A structure that describes the mean value and sketch of the sum
+         * of outer products over a subset of the samples processed so far,
+         * namely those processed on one shard of the `partial_sketches`
+         * variable below.
+         */
+        struct PartialSketch
+        {
+          /**
+           * The current value of the running mean.
+           */
+          InputType           current_mean;
+
+          /**
+           * The sketch $B$ described in the documentation of this class. The
+           * matrix always has $2r$ rows, of which only the first
+           * `n_used_rows` are nonzero.
+           */
+          matrix_type         sketch;
+          unsigned int        n_used_rows = 0;
+
+          /**
+           * The sum of the weights $W$ and of the squares of the weights
+           * $W_2$ of the samples processed so far, as in the CovarianceMatrix
+           * class.
+           */
+          double              total_weight = 0;
+          double              total_squared_weight = 0;
+
+          /**
+           * The trace of the sum of outer products $M$, which unlike
+           * $B^TB$ is not approximated.
+           */
+          double              trace = 0;
+
+          /**
+           * Update the mean value, sketch, and sums of weights with the given
+           * sample, counted `n_repetitions` times with the given weight each.
+           */
+          void
+          add_sample (InputType &&sample,
+                      const types::sample_index n_repetitions,
+                      const double weight,
+                      const unsigned int rank);
+
+          /**
+           * Update the current object so that it represents the mean value
+           * and sketch over the samples represented by both the current
+           * object and the argument.
+           */
+          void
+          merge (const PartialSketch &other);
+
+          /**
+           * Add the row $\sqrt{f}\delta^T$ with $f$ equal to `factor` to the
+           * sketch, first compressing it if all rows are already in use.
+           */
+          void
+          add_row (const InputType &delta,
+                   const double factor);
+
+          /**
+           * Replace the sketch by one with at most $r$ nonzero rows computed
+           * from the given rows as described in the documentation of this
+           * class.
+           */
+          void
+          compress (const matrix_type &rows);
+        };
+
+        /**
+         * Compute the eigenvalues and eigenvectors of $BB^T$, where $B$ is
+         * the given matrix, and return them in ascending order of the
+         * eigenvalues. The eigenvectors of $B^TB$ for the nonzero eigenvalues
+         * are then $B^Tu_i/\sqrt{\lambda_i}$, where $u_i$ are the
+         * eigenvectors of $BB^T$.
+         */
+        static
+        Eigen::SelfAdjointEigenSolver<matrix_type>
+        gram_eigenvalues (const matrix_type &rows);
+
+        /**
+         * The partial results computed by the threads that have sent
+         * samples to this object.
+         */
+        ShardedAccumulator<PartialSketch> partial_sketches;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    LowRankCovarianceMatrix<InputType>::
+    LowRankCovarianceMatrix (const unsigned int rank)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      rank (rank)
+    {
+      assert (rank >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    LowRankCovarianceMatrix<InputType>::
+    ~LowRankCovarianceMatrix ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      partial_sketches.update ([this, &sample, &aux_data](PartialSketch &partial_sketch)
+      {
+        partial_sketch.add_sample (std::move(sample), aux_data.n_repetitions(),
+                                   aux_data.weight(), rank);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::PartialSketch::
+    add_sample (InputType &&sample,
+                const types::sample_index n_repetitions,
+                const double weight,
+                const unsigned int rank)
+    {
+      const double sample_weight = n_repetitions * weight;
+      if (sample_weight == 0)
+        return;
+
+      if (total_weight == 0)
+        {
+          total_weight = sample_weight;
+          total_squared_weight = n_repetitions * weight * weight;
+          sketch.setZero (2*rank, Utilities::size(sample));
+          n_used_rows = 0;
+          trace = 0;
+          current_mean = std::move(sample);
+        }
+      else
+        {
+          // Same as in CovarianceMatrix::PartialCovariance::add_sample(),
+          // except that the outer product is added to the sketch:
+          const double combined_weight = total_weight + sample_weight;
+
+          InputType delta = std::move(sample);
+          delta -= current_mean;
+
+          add_row (delta, total_weight * sample_weight / combined_weight);
+
+          Utilities::add_scaled (current_mean, delta, sample_weight / combined_weight);
+
+          total_weight = combined_weight;
+          total_squared_weight += n_repetitions * weight * weight;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::PartialSketch::
+    merge (const PartialSketch &other)
+    {
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      assert (other.sketch.rows() == sketch.rows());
+      assert (other.sketch.cols() == sketch.cols());
+
+      const double combined_weight = total_weight + other.total_weight;
+
+      InputType delta = other.current_mean;
+      delta -= current_mean;
+
+      // Stack the rows of both sketches. If they fit into the current
+      // sketch, there is nothing else to do; otherwise compress them.
+      if (Eigen::Index(n_used_rows + other.n_used_rows) <= sketch.rows())
+        {
+          sketch.middleRows (n_used_rows, other.n_used_rows)
+            = other.sketch.topRows (other.n_used_rows);
+          n_used_rows += other.n_used_rows;
+        }
+      else
+        {
+          matrix_type rows (n_used_rows + other.n_used_rows, sketch.cols());
+          rows.topRows (n_used_rows) = sketch.topRows (n_used_rows);
+          rows.bottomRows (other.n_used_rows) = other.sketch.topRows (other.n_used_rows);
+          compress (rows);
+        }
+      trace += other.trace;
+
+      // Then add the row that accounts for the difference of the means:
+      add_row (delta, total_weight * other.total_weight / combined_weight);
+
+      Utilities::add_scaled (current_mean, delta, other.total_weight / combined_weight);
+
+      total_weight = combined_weight;
+      total_squared_weight += other.total_squared_weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::PartialSketch::
+    add_row (const InputType &delta,
+             const double factor)
+    {
+      if (Eigen::Index(n_used_rows) == sketch.rows())
+        compress (sketch);
+
+      // For complex-valued samples, we need B^H B = sum f delta delta^H,
+      // and so the row to add is the complex conjugate of delta:
+      const double sqrt_factor = std::sqrt(factor);
+      for (unsigned int j=0; j<Utilities::size(delta); ++j)
+        sketch(n_used_rows, j) = Utilities::conj(Utilities::get_nth_element(delta, j)) * sqrt_factor;
+      trace += sketch.row(n_used_rows).squaredNorm();
+      ++n_used_rows;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::PartialSketch::
+    compress (const matrix_type &rows)
+    {
+      // The sketch has 2r rows, and we want to retain at most r of them:
+      const unsigned int rank = sketch.rows() / 2;
+      const unsigned int n_rows = rows.rows();
+      assert (n_rows > rank);
+
+      // Compute the squares of the singular values (in ascending order)
+      // and the left singular vectors of the given rows. The right singular
+      // vectors, times the singular values, are then U^H B:
+      const Eigen::SelfAdjointEigenSolver<matrix_type> eigen_solver
+        = LowRankCovarianceMatrix::gram_eigenvalues (rows);
+      const auto  &sigma_squared = eigen_solver.eigenvalues();
+      const double shift = sigma_squared(n_rows-rank-1);
+
+      // Replace the singular values sigma_i by sqrt(sigma_i^2-shift) for
+      // the r largest singular values; all others become zero:
+      matrix_type scaled_vectors (rank, n_rows);
+      for (unsigned int k=0; k<rank; ++k)
+        {
+          const unsigned int i = n_rows-1-k;
+          const double scaling = (sigma_squared(i) > shift
+                                  ?
+                                  std::sqrt((sigma_squared(i) - shift) / sigma_squared(i))
+                                  :
+                                  0.);
+          scaled_vectors.row(k) = eigen_solver.eigenvectors().col(i).adjoint() * scaling;
+        }
+
+      matrix_type new_sketch = matrix_type::Zero (sketch.rows(), sketch.cols());
+      new_sketch.topRows(rank) = scaled_vectors * rows;
+      sketch = std::move(new_sketch);
+      n_used_rows = rank;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    Eigen::SelfAdjointEigenSolver<typename LowRankCovarianceMatrix<InputType>::matrix_type>
+    LowRankCovarianceMatrix<InputType>::
+    gram_eigenvalues (const matrix_type &rows)
+    {
+      const matrix_type gram_matrix = rows * rows.adjoint();
+      return Eigen::SelfAdjointEigenSolver<matrix_type> (gram_matrix);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename LowRankCovarianceMatrix<InputType>::value_type
+    LowRankCovarianceMatrix<InputType>::
+    get () const
+    {
+      const PartialSketch sketch = partial_sketches.merged();
+
+      // Use the same normalization as the CovarianceMatrix class:
+      const double normalization
+        = (sketch.total_weight > 0
+           ?
+           sketch.total_weight
+           - sketch.total_squared_weight / sketch.total_weight
+           :
+           0.);
+      if ((normalization <= 0) || (sketch.n_used_rows == 0))
+        return {};
+
+      // Compute the eigenvalues and eigenvectors of B^H B from those of
+      // B B^H, starting from the largest, and skipping zero eigenvalues:
+      const matrix_type rows = sketch.sketch.topRows (sketch.n_used_rows);
+      const Eigen::SelfAdjointEigenSolver<matrix_type> eigen_solver = gram_eigenvalues (rows);
+      const auto &sigma_squared = eigen_solver.eigenvalues();
+
+      const unsigned int n_rows = rows.rows();
+      unsigned int n_eigenvalues = 0;
+      while ((n_eigenvalues < std::min(rank, n_rows))
+             &&
+             (sigma_squared(n_rows-1-n_eigenvalues) > 0))
+        ++n_eigenvalues;
+
+      value_type result;
+      result.eigenvalues.resize (n_eigenvalues);
+      result.eigenvectors.resize (rows.cols(), n_eigenvalues);
+      for (unsigned int k=0; k<n_eigenvalues; ++k)
+        {
+          const unsigned int i = n_rows-1-k;
+          result.eigenvalues(k) = sigma_squared(i) / normalization;
+          result.eigenvectors.col(k) = rows.adjoint() * eigen_solver.eigenvectors().col(i)
+                                       / std::sqrt(sigma_squared(i));
+        }
+      result.total_variance = sketch.trace / normalization;
+
+      return result;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialSketch sketch = partial_sketches.merged();
+      Serialization::write (buffer, sketch.current_mean);
+      Serialization::write (buffer, sketch.sketch);
+      Serialization::write (buffer, sketch.n_used_rows);
+      Serialization::write (buffer, sketch.total_weight);
+      Serialization::write (buffer, sketch.total_squared_weight);
+      Serialization::write (buffer, sketch.trace);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialSketch sketch;
+      Serialization::read (buffer, sketch.current_mean);
+      Serialization::read (buffer, sketch.sketch);
+      Serialization::read (buffer, sketch.n_used_rows);
+      Serialization::read (buffer, sketch.total_weight);
+      Serialization::read (buffer, sketch.total_squared_weight);
+      Serialization::read (buffer, sketch.trace);
+      assert ((sketch.total_weight == 0)
+              ||
+              (sketch.sketch.rows() == 2*Eigen::Index(rank)));
+      partial_sketches.reset (sketch);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    LowRankCovarianceMatrix<InputType>::
+    merge (const LowRankCovarianceMatrix &other)
+    {
+      assert (other.rank == rank);
+
+      const PartialSketch other_sketch = other.partial_sketches.merged();
+      partial_sketches.update ([&other_sketch](PartialSketch &partial_sketch)
+      {
+        partial_sketch.merge (other_sketch);
+      }, this->is_single_threaded() == false);
+    }
+
+  }
+}
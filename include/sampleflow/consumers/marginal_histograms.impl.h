@@ -0,0 +1,891 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the histograms of all components of
+     * vector-valued samples, along with the joint histograms of all pairs
+     * of components. This is the information one needs to draw a "corner
+     * plot" of a sample distribution, i.e., a triangular array of plots
+     * where the diagonal shows the marginal distribution of each component
+     * and the plots below the diagonal show the marginal distributions of
+     * each pair of components.
+     *
+     * The same information could be obtained by connecting one Histogram
+     * object (via a Filters::ComponentSplitter) for each component and one
+     * PairHistogram object for each pair of components to the producer of
+     * samples. For $d$-dimensional samples, this requires $d(d+1)/2$
+     * consumers that all receive their own copy of every sample and that
+     * all have to acquire their own lock. In contrast, the current class
+     * computes the bin each component of a sample falls into only once,
+     * and then updates all histograms in a single pass. The joint histogram
+     * of each pair of components is stored as a contiguous block of memory,
+     * and these blocks are stored one after the other in the order in which
+     * they are visited when processing a sample, so that this pass walks
+     * through memory in a predictable way.
+     *
+     * Optionally, one can restrict the histograms to a subset of the
+     * components of the samples. All components use the same number of
+     * bins, equally spaced between a minimal and maximal value given
+     * separately for each component. A component whose value lies outside
+     * its range is not counted in the histogram of that component, nor in
+     * the joint histograms of the pairs it is part of, but the other
+     * components of the same sample are counted as usual.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. If samples carry weights (see AuxiliaryData::sample_weight),
+     * then the class also adds up the weights of the samples in each bin;
+     * these can be obtained via get_weighted() and get_pair_weighted().
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread counts samples in its own copy of the bins, stored
+     * in a ShardedAccumulator object, so that threads do not have to wait for
+     * each other; the functions that return histograms add up these counts.
+     * Since each copy stores all joint histograms, the memory required
+     * by this class is proportional to the number of threads that send
+     * samples to it times $d(d-1)/2$ times the square of the number of bins.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. The requirements on this type are the same as for
+     *   the PairHistogram class, except that there is no restriction on the
+     *   number of components of samples.
+     */
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class MarginalHistograms : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the object returned by get(). This is the same as
+         * Histogram::value_type.
+         */
+        using value_type = std::vector<std::tuple<double,double,types::sample_index>>;
+
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as Histogram::weighted_value_type.
+         */
+        using weighted_value_type = std::vector<std::tuple<double,double,double>>;
+
+        /**
+         * The type of the object returned by get_pair(). This is the same as
+         * PairHistogram::value_type.
+         */
+        using pair_value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,types::sample_index>>;
+
+        /**
+         * The type of the object returned by get_pair_weighted(). This is the
+         * same as PairHistogram::weighted_value_type.
+         */
+        using weighted_pair_value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,double>>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] min_values The left end points of the ranges over which
+         *   the histograms of the selected components should be generated.
+         *   This vector has one entry for each selected component, i.e., its
+         *   $i$th entry corresponds to component `components[i]` if
+         *   `components` is not empty, and to component $i$ otherwise.
+         * @param[in] max_values The right end points of these ranges.
+         * @param[in] n_bins The number of bins into which the range of each
+         *   component is split.
+         * @param[in] components The components of the samples for which
+         *   histograms should be generated. If this vector is empty, the
+         *   default, then histograms are generated for components
+         *   $0,\ldots,n-1$ where $n$ is the number of entries of
+         *   `min_values`; samples then need to have exactly $n$ components.
+         *   Otherwise, the entries of this vector have to be distinct.
+         */
+        MarginalHistograms (const std::vector<double>       &min_values,
+                            const std::vector<double>       &max_values,
+                            const unsigned int               n_bins,
+                            const std::vector<unsigned int> &components = {});
+
+        /**
+         * Copy constructor.
+         */
+        MarginalHistograms (const MarginalHistograms<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MarginalHistograms ();
+
+        /**
+         * Process one sample by computing which bin each selected component
+         * lies in, and then incrementing the number of samples in these bins
+         * and in the corresponding bins of the joint histograms.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples. This function does the same as calling
+         * consume() for each sample in turn, but only accesses the bins
+         * stored for the current thread once per batch.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return the histogram of the given component of the samples, in the
+         * format discussed in the documentation of Histogram::value_type.
+         *
+         * @param[in] component The component of the samples. This must be one
+         *   of the components for which this object generates histograms.
+         */
+        value_type
+        get (const unsigned int component) const;
+
+        /**
+         * Like get(), but return the sum of the weights of the samples in
+         * each bin rather than their number.
+         */
+        weighted_value_type
+        get_weighted (const unsigned int component) const;
+
+        /**
+         * Return the joint histogram of the two given components of the
+         * samples, in the format discussed in the documentation of
+         * PairHistogram::value_type, i.e., with `x_component` providing the
+         * first and `y_component` the second coordinate of each bin.
+         *
+         * @param[in] x_component The first of the two components. This must
+         *   be one of the components for which this object generates
+         *   histograms.
+         * @param[in] y_component The second of the two components, with the
+         *   same requirement. It must be different from `x_component`.
+         */
+        pair_value_type
+        get_pair (const unsigned int x_component,
+                  const unsigned int y_component) const;
+
+        /**
+         * Like get_pair(), but return the sum of the weights of the samples
+         * in each bin rather than their number.
+         */
+        weighted_pair_value_type
+        get_pair_weighted (const unsigned int x_component,
+                           const unsigned int y_component) const;
+
+        /**
+         * Append the selected components and their ranges, along with the
+         * numbers and weights of samples counted in each bin so far, to the
+         * given buffer. See the section on saving and combining the state
+         * of consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the counts stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The object that wrote the
+         * data must have been created with the same arguments to the
+         * constructor as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another object has
+         * counted in each bin to the ones counted by the current object. Both
+         * objects must have been created with the same arguments to the
+         * constructor.
+         */
+        void
+        merge (const MarginalHistograms &other);
+
+      private:
+        /**
+         * The components for which histograms are generated. If the
+         * constructor was called with an empty list of components, then
+         * this vector contains all components of the samples.
+         */
+        const std::vector<unsigned int> components;
+
+        /**
+         * The ranges of the histograms of the selected components, and the
+         * number of bins into which each range is split.
+         */
+        const std::vector<double> min_values;
+        const std::vector<double> max_values;
+        const unsigned int        n_bins;
+
+        /**
+         * The inverse of the width of the bins of each selected component.
+         */
+        std::vector<double> inverse_bin_widths;
+
+        /**
+         * Whether the constructor was called with an empty list of
+         * components, in which case samples need to have exactly as many
+         * components as there are ranges.
+         */
+        bool all_components;
+
+        /**
+         * A structure storing the number of samples so far encountered in
+         * each of the bins of all histograms by one shard of the `bins`
+         * variable below.
+         *
+         * The histograms of the $m$ selected components are stored one after
+         * the other in `bin_counts` and `bin_weights`, each with `n_bins`
+         * entries. The joint histograms of the $m(m-1)/2$ pairs $(a,b)$
+         * with $a<b$ (where $a,b$ are positions within the list of selected
+         * components) are stored in `pair_bin_counts` and
+         * `pair_bin_weights`, each as a block of `n_bins*n_bins` entries in
+         * which the bin of component $a$ is the row and the bin of
+         * component $b$ the column index. The blocks are ordered
+         * lexicographically by $(a,b)$.
+         */
+        struct PartialHistograms
+        {
+          std::vector<types::sample_index> bin_counts;
+          std::vector<double>              bin_weights;
+          std::vector<types::sample_index> pair_bin_counts;
+          std::vector<double>              pair_bin_weights;
+
+          /**
+           * Return an object in which all bins of the histograms of `m`
+           * components, each split into `n_bins` bins, are empty.
+           */
+          static
+          PartialHistograms
+          empty (const std::size_t  m,
+                 const unsigned int n_bins);
+
+          /**
+           * Add a sample with the given repetition count and weight. The
+           * first argument contains the bins into which the selected
+           * components of the sample fall, with a value of `n_bins` denoting
+           * a component that lies outside its range.
+           */
+          void
+          add_sample (const unsigned int        *sample_bins,
+                      const unsigned int         n_components,
+                      const unsigned int         n_bins,
+                      const types::sample_index  n_repetitions,
+                      const double               weight);
+
+          /**
+           * Add the numbers and weights of samples stored in the argument to
+           * the ones stored in the current object.
+           */
+          void
+          merge (const PartialHistograms &other);
+        };
+
+        /**
+         * The numbers of samples in each bin counted by the threads that
+         * have sent samples to this object.
+         */
+        ShardedAccumulator<PartialHistograms> bins;
+
+        /**
+         * Compute the bins into which the selected components of the given
+         * sample fall, and write them into `sample_bins`.
+         */
+        void
+        compute_sample_bins (const InputType &sample,
+                             unsigned int    *sample_bins) const;
+
+        /**
+         * Return the position of the given component within the list of
+         * selected components.
+         */
+        unsigned int
+        component_position (const unsigned int component) const;
+
+        /**
+         * Return the position of the joint histogram of the components at
+         * positions `a<b` within the list of selected components among all
+         * joint histograms.
+         */
+        std::size_t
+        pair_position (const unsigned int a,
+                       const unsigned int b) const;
+
+        /**
+         * Return the end points of the given bin of the component at the
+         * given position within the list of selected components.
+         */
+        std::array<double,2>
+        bin_end_points (const unsigned int position,
+                        const unsigned int bin) const;
+
+        /**
+         * Return the list of components $0,\ldots,n-1$.
+         */
+        static
+        std::vector<unsigned int>
+        all_components_list (const unsigned int n);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MarginalHistograms<InputType>::
+    MarginalHistograms (const std::vector<double>       &min_values,
+                        const std::vector<double>       &max_values,
+                        const unsigned int               n_bins,
+                        const std::vector<unsigned int> &components)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      components (components.size() > 0
+                  ?
+                  components
+                  :
+                  all_components_list (min_values.size())),
+      min_values (min_values),
+      max_values (max_values),
+      n_bins (n_bins),
+      inverse_bin_widths (min_values.size()),
+      all_components (components.size() == 0),
+      bins (PartialHistograms::empty (this->components.size(), n_bins))
+    {
+      assert (min_values.size() > 0);
+      assert (max_values.size() == min_values.size());
+      assert (this->components.size() == min_values.size());
+      assert (n_bins > 0);
+
+      for (unsigned int i=0; i<min_values.size(); ++i)
+        {
+          assert (min_values[i] < max_values[i]);
+          inverse_bin_widths[i] = n_bins / (max_values[i] - min_values[i]);
+
+          for (unsigned int j=0; j<i; ++j)
+            assert (this->components[i] != this->components[j]);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MarginalHistograms<InputType>::
+    MarginalHistograms (const MarginalHistograms<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      components (o.components),
+      min_values (o.min_values),
+      max_values (o.max_values),
+      n_bins (o.n_bins),
+      inverse_bin_widths (o.inverse_bin_widths),
+      all_components (o.all_components),
+      bins (o.bins)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MarginalHistograms<InputType>::
+    ~MarginalHistograms ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      // Compute the bins of all components without holding a lock, then
+      // add the sample to the counts:
+      std::vector<unsigned int> sample_bins (components.size());
+      compute_sample_bins (sample, sample_bins.data());
+
+      const double weight = aux_data.weight();
+      bins.update ([&](PartialHistograms &partial_histograms)
+      {
+        partial_histograms.add_sample (sample_bins.data(), components.size(), n_bins,
+                                       n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      const unsigned int m = components.size();
+      std::vector<unsigned int> sample_bins (samples.size() * m);
+      for (std::size_t i=0; i<samples.size(); ++i)
+        compute_sample_bins (samples[i], &sample_bins[i*m]);
+
+      bins.update ([&](PartialHistograms &partial_histograms)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          if (aux_data[i].n_repetitions() > 0)
+            partial_histograms.add_sample (&sample_bins[i*m], m, n_bins,
+                                           aux_data[i].n_repetitions(),
+                                           aux_data[i].weight());
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MarginalHistograms<InputType>::value_type
+    MarginalHistograms<InputType>::
+    get (const unsigned int component) const
+    {
+      const unsigned int position = component_position (component);
+      const PartialHistograms histograms = bins.merged();
+
+      value_type return_value (n_bins);
+      for (unsigned int bin=0; bin<n_bins; ++bin)
+        {
+          const std::array<double,2> end_points = bin_end_points (position, bin);
+          return_value[bin] = {end_points[0], end_points[1],
+                               histograms.bin_counts[position*n_bins + bin]
+                              };
+        }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MarginalHistograms<InputType>::weighted_value_type
+    MarginalHistograms<InputType>::
+    get_weighted (const unsigned int component) const
+    {
+      const unsigned int position = component_position (component);
+      const PartialHistograms histograms = bins.merged();
+
+      weighted_value_type return_value (n_bins);
+      for (unsigned int bin=0; bin<n_bins; ++bin)
+        {
+          const std::array<double,2> end_points = bin_end_points (position, bin);
+          return_value[bin] = {end_points[0], end_points[1],
+                               histograms.bin_weights[position*n_bins + bin]
+                              };
+        }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MarginalHistograms<InputType>::pair_value_type
+    MarginalHistograms<InputType>::
+    get_pair (const unsigned int x_component,
+              const unsigned int y_component) const
+    {
+      const unsigned int x = component_position (x_component);
+      const unsigned int y = component_position (y_component);
+      assert (x != y);
+
+      // The joint histogram is stored with the component that comes first
+      // in the list of selected components as the row index:
+      const std::size_t offset = pair_position (std::min(x,y), std::max(x,y)) * n_bins * n_bins;
+      const PartialHistograms histograms = bins.merged();
+
+      pair_value_type return_value (n_bins * n_bins);
+      for (unsigned int x_bin=0; x_bin<n_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_bins; ++y_bin)
+          {
+            const std::array<double,2> x_end_points = bin_end_points (x, x_bin);
+            const std::array<double,2> y_end_points = bin_end_points (y, y_bin);
+            const std::size_t index = (x < y
+                                       ?
+                                       x_bin*n_bins + y_bin
+                                       :
+                                       y_bin*n_bins + x_bin);
+            return_value[x_bin*n_bins + y_bin]
+              = {{{x_end_points[0], y_end_points[0]}},
+              {{x_end_points[1], y_end_points[1]}},
+              histograms.pair_bin_counts[offset + index]
+            };
+          }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MarginalHistograms<InputType>::weighted_pair_value_type
+    MarginalHistograms<InputType>::
+    get_pair_weighted (const unsigned int x_component,
+                       const unsigned int y_component) const
+    {
+      const unsigned int x = component_position (x_component);
+      const unsigned int y = component_position (y_component);
+      assert (x != y);
+
+      const std::size_t offset = pair_position (std::min(x,y), std::max(x,y)) * n_bins * n_bins;
+      const PartialHistograms histograms = bins.merged();
+
+      weighted_pair_value_type return_value (n_bins * n_bins);
+      for (unsigned int x_bin=0; x_bin<n_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_bins; ++y_bin)
+          {
+            const std::array<double,2> x_end_points = bin_end_points (x, x_bin);
+            const std::array<double,2> y_end_points = bin_end_points (y, y_bin);
+            const std::size_t index = (x < y
+                                       ?
+                                       x_bin*n_bins + y_bin
+                                       :
+                                       y_bin*n_bins + x_bin);
+            return_value[x_bin*n_bins + y_bin]
+              = {{{x_end_points[0], y_end_points[0]}},
+              {{x_end_points[1], y_end_points[1]}},
+              histograms.pair_bin_weights[offset + index]
+            };
+          }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialHistograms histograms = bins.merged();
+
+      Serialization::write (buffer, components);
+      Serialization::write (buffer, min_values);
+      Serialization::write (buffer, max_values);
+      Serialization::write (buffer, n_bins);
+      Serialization::write (buffer, histograms.bin_counts);
+      Serialization::write (buffer, histograms.bin_weights);
+      Serialization::write (buffer, histograms.pair_bin_counts);
+      Serialization::write (buffer, histograms.pair_bin_weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<unsigned int> saved_components;
+      std::vector<double>       saved_min_values;
+      std::vector<double>       saved_max_values;
+      unsigned int              saved_n_bins;
+      Serialization::read (buffer, saved_components);
+      Serialization::read (buffer, saved_min_values);
+      Serialization::read (buffer, saved_max_values);
+      Serialization::read (buffer, saved_n_bins);
+      assert (saved_components == components);
+      assert (saved_min_values == min_values);
+      assert (saved_max_values == max_values);
+      assert (saved_n_bins == n_bins);
+
+      PartialHistograms histograms;
+      Serialization::read (buffer, histograms.bin_counts);
+      Serialization::read (buffer, histograms.bin_weights);
+      Serialization::read (buffer, histograms.pair_bin_counts);
+      Serialization::read (buffer, histograms.pair_bin_weights);
+
+      const std::size_t m = components.size();
+      assert (histograms.bin_counts.size() == m*n_bins);
+      assert (histograms.bin_weights.size() == m*n_bins);
+      assert (histograms.pair_bin_counts.size() == m*(m-1)/2*n_bins*n_bins);
+      assert (histograms.pair_bin_weights.size() == m*(m-1)/2*n_bins*n_bins);
+      (void)m;
+
+      bins.reset (histograms);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    merge (const MarginalHistograms &other)
+    {
+      assert (other.components == components);
+      assert (other.min_values == min_values);
+      assert (other.max_values == max_values);
+      assert (other.n_bins == n_bins);
+
+      const PartialHistograms other_histograms = other.bins.merged();
+      bins.update ([&other_histograms](PartialHistograms &partial_histograms)
+      {
+        partial_histograms.merge (other_histograms);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::
+    compute_sample_bins (const InputType &sample,
+                         unsigned int    *sample_bins) const
+    {
+      assert ((all_components == false) || (sample.size() == components.size()));
+
+      for (unsigned int i=0; i<components.size(); ++i)
+        {
+          assert (components[i] < sample.size());
+          const double value = sample[components[i]];
+
+          // Mark values outside the range (including NaNs, for which both
+          // comparisons are false) by an invalid bin number. For values
+          // inside, guard against round-off pushing the computed bin past
+          // the last one:
+          if ((value >= min_values[i]) && (value < max_values[i]))
+            sample_bins[i] = std::min (static_cast<unsigned int>((value - min_values[i])
+                                                                 * inverse_bin_widths[i]),
+                                       n_bins-1);
+          else
+            sample_bins[i] = n_bins;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    unsigned int
+    MarginalHistograms<InputType>::
+    component_position (const unsigned int component) const
+    {
+      const auto p = std::find (components.begin(), components.end(), component);
+      assert ((p != components.end())
+              &&
+              "This object does not generate histograms for the given component.");
+      return (p - components.begin());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    MarginalHistograms<InputType>::
+    pair_position (const unsigned int a,
+                   const unsigned int b) const
+    {
+      assert (a < b);
+      assert (b < components.size());
+
+      // The pairs (a',b') that come before (a,b) are those with a'<a, of
+      // which there are (m-1)+(m-2)+...+(m-a), plus those with a'=a and
+      // a<b'<b:
+      const std::size_t m = components.size();
+      return a*m - a*(a+1)/2 + (b-a-1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::array<double,2>
+    MarginalHistograms<InputType>::
+    bin_end_points (const unsigned int position,
+                    const unsigned int bin) const
+    {
+      const double delta = (max_values[position] - min_values[position]) / n_bins;
+      return {{min_values[position] + bin*delta,
+               (bin+1 == n_bins ? max_values[position] : min_values[position] + (bin+1)*delta)
+              }};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::vector<unsigned int>
+    MarginalHistograms<InputType>::
+    all_components_list (const unsigned int n)
+    {
+      std::vector<unsigned int> list (n);
+      std::iota (list.begin(), list.end(), 0U);
+      return list;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MarginalHistograms<InputType>::PartialHistograms
+    MarginalHistograms<InputType>::PartialHistograms::
+    empty (const std::size_t  m,
+           const unsigned int n_bins)
+    {
+      return {std::vector<types::sample_index>(m*n_bins, 0),
+              std::vector<double>(m*n_bins, 0.),
+              std::vector<types::sample_index>(m*(m-1)/2*n_bins*n_bins, 0),
+              std::vector<double>(m*(m-1)/2*n_bins*n_bins, 0.)};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::PartialHistograms::
+    add_sample (const unsigned int        *sample_bins,
+                const unsigned int         n_components,
+                const unsigned int         n_bins,
+                const types::sample_index  n_repetitions,
+                const double               weight)
+    {
+      const double total_weight = n_repetitions * weight;
+
+      // Walk through the histograms in the order in which they are stored.
+      // 'block' runs over the joint histograms, in the order of the pairs
+      // (a,b):
+      std::size_t block = 0;
+      for (unsigned int a=0; a<n_components; ++a)
+        {
+          const unsigned int a_bin = sample_bins[a];
+          if (a_bin == n_bins)
+            {
+              block += n_components-a-1;
+              continue;
+            }
+
+          bin_counts[a*n_bins + a_bin]  += n_repetitions;
+          bin_weights[a*n_bins + a_bin] += total_weight;
+
+          for (unsigned int b=a+1; b<n_components; ++b, ++block)
+            if (sample_bins[b] < n_bins)
+              {
+                const std::size_t index = (block*n_bins + a_bin)*n_bins + sample_bins[b];
+                pair_bin_counts[index]  += n_repetitions;
+                pair_bin_weights[index] += total_weight;
+              }
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MarginalHistograms<InputType>::PartialHistograms::
+    merge (const PartialHistograms &other)
+    {
+      for (std::size_t i=0; i<bin_counts.size(); ++i)
+        {
+          bin_counts[i]  += other.bin_counts[i];
+          bin_weights[i] += other.bin_weights[i];
+        }
+      for (std::size_t i=0; i<pair_bin_counts.size(); ++i)
+        {
+          pair_bin_counts[i]  += other.pair_bin_counts[i];
+          pair_bin_weights[i] += other.pair_bin_weights[i];
+        }
+    }
+  }
+}
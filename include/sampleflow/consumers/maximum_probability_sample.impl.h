@@ -40,6 +40,7 @@ namespace SampleFlow
      * @tparam InputType The C++ type used for the samples $x_k$.
      */
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     class MaximumProbabilitySample : public Consumer<InputType>
     {
       public:
@@ -84,6 +85,28 @@ namespace SampleFlow
         consume (InputType     sample,
                  AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::relative_log_likelihood.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process one sample owned by the caller. This does the same as
+         * consume(), but only copies the sample if it is more likely than
+         * all previous ones.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
         /**
          * A function that returns the most likely among the samples
          * seen so far, along with the auxiliary data that was associated
@@ -126,6 +149,7 @@ namespace SampleFlow
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     MaximumProbabilitySample<InputType>::
     MaximumProbabilitySample ()
       :
@@ -140,6 +164,7 @@ namespace SampleFlow
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     MaximumProbabilitySample<InputType>::
     ~MaximumProbabilitySample ()
     {
@@ -149,17 +174,18 @@ namespace SampleFlow
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     void
     MaximumProbabilitySample<InputType>::
     consume (InputType sample, AuxiliaryData aux_data)
     {
       // Let's see first if the sample provided has the log likelihood
       // attribute we would like to evaluate
-      if (aux_data.find ("relative log likelihood") != aux_data.end())
+      if (const double *p = aux_data.get_if<double> (AuxiliaryData::relative_log_likelihood))
         {
-          const double log_likelihood = std::any_cast<double>(aux_data["relative log likelihood"]);
+          const double log_likelihood = *p;
 
-          std::lock_guard<std::mutex> lock(mutex);
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
 
           // Check if we have seen any sample at all so far
           if (current_highest_log_likelihood == std::numeric_limits<double>::lowest())
@@ -184,6 +210,49 @@ namespace SampleFlow
 
 
     template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    MaximumProbabilitySample<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::relative_log_likelihood
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    MaximumProbabilitySample<InputType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
+    {
+      if (const double *p = aux_data.get_if<double> (AuxiliaryData::relative_log_likelihood))
+        {
+          const double log_likelihood = *p;
+
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+          // As in consume(), take the sample if it is the first one we
+          // see or if it is better than the best one so far:
+          if ((current_highest_log_likelihood == std::numeric_limits<double>::lowest())
+              ||
+              (log_likelihood > current_highest_log_likelihood))
+            {
+              current_most_likely_sample = sample;
+              current_most_likely_sample_data = aux_data;
+              current_highest_log_likelihood = log_likelihood;
+            }
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
     typename MaximumProbabilitySample<InputType>::value_type
     MaximumProbabilitySample<InputType>::
     get () const
@@ -16,9 +16,21 @@
 #ifndef SAMPLEFLOW_CONSUMERS_MEAN_VALUE_H
 #define SAMPLEFLOW_CONSUMERS_MEAN_VALUE_H
 
+#include <sampleflow/concepts.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/element_access.h>
+#include <sampleflow/persistent_state.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
 #include <sampleflow/types.h>
+#include <cassert>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumers/mean_value.impl.h>
@@ -40,12 +40,77 @@ namespace SampleFlow
      *      \\       &= \bar x_{k-1} + \frac{1}{k} (x_k - \bar x_{k-1}).
      * @f}
      *
+     * If a sample carries an entry with key AuxiliaryData::repetition_count
+     * in its auxiliary data (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples),
+     * then the sample is counted as many times as this entry says. More
+     * generally, samples can carry a weight (see
+     * AuxiliaryData::sample_weight), and the class then computes the
+     * weighted mean $\bar x = \frac{\sum_j w_j x_j}{\sum_j w_j}$. For
+     * a sample $x$ with total weight $w$ (its weight times its repetition
+     * count), the update then reads
+     * $\bar x_{W+w} = \bar x_W + \frac{w}{W+w} (x - \bar x_W)$, where $W$
+     * is the total weight of all previous samples. This costs no more than
+     * the update for a single sample with weight one.
+     *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * consume() member function can be called concurrently and from multiple
-     * threads.
+     * threads. Since the mean value does not depend on the order in which
+     * samples are processed, threads do not all update the same running mean
+     * value. Rather, the class uses a ShardedAccumulator object in which each
+     * thread updates its own running mean value and number of samples, and
+     * the get() function combines these partial results using the formula
+     * @f{align*}{
+     *   \bar x_{A\cup B} = \bar x_A + \frac{W_B}{W_A+W_B} (\bar x_B - \bar x_A)
+     * @f}
+     * for the mean value of the union of two disjoint sets $A,B$ of
+     * samples with total weights $W_A$ and $W_B$, respectively (i.e., the
+     * number of samples in each set if all samples have weight one). As a
+     * consequence, threads that send samples do not have to wait for each
+     * other; the price to pay is that get() becomes more expensive.
+     *
+     *
+     * ### Accumulating in higher precision ###
+     *
+     * By default, the running mean is stored in an object of type
+     * `InputType`. For samples with single precision elements (say, of type
+     * `float` or `Eigen::VectorXf`, which halve the memory traffic of a
+     * sampler compared to double precision), this means that the mean is
+     * also computed in single precision, and rounding errors accumulate
+     * to a noticeable degree over millions of samples. The second template
+     * argument allows choosing a different type for the running mean, such
+     * as `double` or `Eigen::VectorXd`:
+     * @code
+     *   SampleFlow::Consumers::MeanValue<Eigen::VectorXf, Eigen::VectorXd> mean_value;
+     * @endcode
+     * Each sample's elements are then converted to the scalar type of the
+     * accumulator as part of the update (see
+     * Utilities::update_running_mean() and Utilities::convert_elements()).
+     * Only the first sample is copied into an object of the accumulator
+     * type; later ones are added element by element without creating a
+     * converted copy. get() returns an object of the accumulator type.
+     *
+     *
+     * ### Sparse samples ###
+     *
+     * If the samples only store their nonzero elements (see
+     * Concepts::has_sparse_storage; an example is `Eigen::SparseVector`),
+     * the mean value is nonetheless generally a dense vector, and the
+     * default accumulator type is then the corresponding dense type (see
+     * types::DenseType). The update formula above would touch every one of
+     * the $d$ elements of the running mean for each sample, even if the
+     * sample has only very few nonzero elements. Instead, the class then
+     * stores the mean as $\bar x = s y$ with a scalar $s$ and a vector $y$.
+     * The update $\bar x \leftarrow (1-f)\bar x + f x$ with
+     * $f=\frac{w}{W+w}$ becomes $s \leftarrow (1-f)s$,
+     * $y \leftarrow y + \frac{f}{s} x$, which only touches those elements
+     * of $y$ for which $x$ is nonzero. The cost of processing a sample is
+     * therefore proportional to its number of nonzero elements, not to $d$.
+     * The product $s y$ is only formed when the mean is actually needed,
+     * for example in get().
      *
      *
      * @tparam InputType The C++ type used for the samples $x_k$. In
@@ -73,17 +138,25 @@ namespace SampleFlow
      *   Filters::Conversion filter class, for example. In practice,
      *   the requirement on `InputType` is that it models a "vector space",
      *   and this requirement is enforced by the compiler.
+     * @tparam AccumulatorType The C++ type in which the mean value is
+     *   computed and returned. It needs to satisfy the same requirements as
+     *   `InputType`, and have as many elements as the samples; see the
+     *   section on accumulating in higher precision above. The default is
+     *   `InputType` itself, except for sparse sample types; see the
+     *   section on sparse samples above.
      */
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    template <typename InputType, typename AccumulatorType = types::DenseType<InputType>>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
     class MeanValue : public Consumer<InputType>
     {
       public:
         /**
          * The type of the information generated by this class, i.e., in which
-         * the mean value is computed. This is of course the InputType.
+         * the mean value is computed. This is the AccumulatorType, which by
+         * default is the InputType.
          */
-        using value_type = InputType;
+        using value_type = AccumulatorType;
 
         /**
          * Constructor.
@@ -108,108 +181,588 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
         consume (InputType     sample,
                  AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses, namely the repetition count and the weight of samples.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process a batch of samples. The result is the same as calling
+         * consume() for each sample, but the shard of the accumulator that
+         * holds the running mean is only looked up once. Furthermore, if the
+         * elements of `InputType` are stored contiguously (see
+         * Concepts::has_contiguous_storage), the function does not update
+         * the running mean sample by sample but computes the weighted mean
+         * of the batch in a single pass over the samples' memory, and then
+         * merges it with the running mean using the formula shown in the
+         * documentation of this class.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples. As for
+         *   consume(), only the repetition counts and weights are used.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Process one sample owned by the caller. This does the same as
+         * consume(), but only requires a copy of the sample if it is the
+         * first one, or if the sample type does not allow updating the
+         * mean element by element (see Utilities::update_running_mean()).
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
         /**
          * A function that returns the mean value computed from the samples
          * seen so far. If no samples have been processed so far, then a
-         * default-constructed object of type InputType will be returned.
+         * default-constructed object of type value_type will be returned.
          *
          * @return The computed mean value.
          */
         value_type
         get () const;
 
+        /**
+         * Append the mean value computed so far, along with the total
+         * weight of the samples it was computed from, to the given buffer.
+         * See the section on saving and combining the state of consumers in
+         * the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the mean value and total weight stored by this object by
+         * the ones previously written by save(), read from the front of the
+         * given buffer. The buffer is advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the mean value computed by another object with the one
+         * computed by the current object, using the formula for the union
+         * of two sets of samples shown in the documentation of this class.
+         */
+        void
+        merge (const MeanValue &other);
+
+        /**
+         * Keep the state of this object in the memory-mapped file with the
+         * given name, updated every `interval` samples and when this object
+         * is destroyed, so that it survives if the program is terminated.
+         * If the file already contains a state written this way, for
+         * example by a run of the program that was interrupted, then this
+         * state replaces the current one of this object. See the
+         * PersistentState class for details. This function needs to be
+         * called before the object receives its first sample.
+         *
+         * @return Whether a state was restored from the file.
+         */
+        bool
+        keep_state_in_file (const std::string        &filename,
+                            const types::sample_index interval = 1);
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * A structure that describes the mean value over a subset of the
+         * samples processed so far, namely those processed on one shard of
+         * the `partial_means` variable below.
          */
-        mutable std::mutex mutex;
+        struct PartialMean
+        {
+          /**
+           * The current value of $\bar x_k$ as described in the introduction
+           * of this class.
+           */
+          AccumulatorType     current_mean;
+
+          /**
+           * The total weight of the samples processed so far. If all
+           * samples have weight one, this is the number of samples.
+           */
+          double              total_weight = 0;
+
+          /**
+           * The factor $s$ by which `current_mean` needs to be multiplied
+           * to obtain the mean value, see the section on sparse samples in
+           * the documentation of this class. This is always one unless the
+           * samples are sparse.
+           */
+          double              scale = 1;
+
+          /**
+           * Whether samples are processed as described in the section on
+           * sparse samples in the documentation of this class.
+           */
+          static constexpr bool use_sparse_update
+            = (Concepts::has_sparse_storage<InputType>
+               &&
+               !Concepts::has_sparse_storage<AccumulatorType>);
+
+          /**
+           * Update `current_mean` and `total_weight` with the given sample,
+           * which contributes with the given (total) weight.
+           */
+          void
+          add_sample (InputType &&sample,
+                      const double weight);
+
+          /**
+           * Like the previous function, but for a sample that the caller
+           * still needs.
+           */
+          void
+          add_sample (const InputType &sample,
+                      const double     weight);
+
+          /**
+           * Update `current_mean` and `total_weight` with all of the given
+           * samples.
+           */
+          void
+          add_batch (const std::vector<InputType>     &samples,
+                     const std::vector<AuxiliaryData> &aux_data);
+
+          /**
+           * Update the current object so that it represents the mean value
+           * over the samples represented by both the current object and the
+           * argument.
+           */
+          void
+          merge (const PartialMean &other);
+
+          /**
+           * Multiply `current_mean` by `scale`, and set `scale` to one.
+           */
+          void
+          normalize ();
+        };
 
         /**
-         * The current value of $\bar x_k$ as described in the introduction
-         * of this class.
+         * The partial mean values computed by the threads that have sent
+         * samples to this object.
          */
-        InputType           current_mean;
+        ShardedAccumulator<PartialMean> partial_means;
 
         /**
-         * The number of samples processed so far.
+         * The object that keeps the state of this object in a file, if
+         * keep_state_in_file() has been called.
          */
-        types::sample_index n_samples;
+        std::unique_ptr<PersistentState> persistent_state;
     };
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    MeanValue<InputType>::
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    MeanValue<InputType,AccumulatorType>::
     MeanValue ()
       :
       Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
                                        |
-                                       static_cast<int>(ParallelMode::asynchronous))),
-      n_samples (0)
+                                       static_cast<int>(ParallelMode::asynchronous)))
     {}
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    MeanValue<InputType>::
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    MeanValue<InputType,AccumulatorType>::
     ~MeanValue ()
     {
       this->disconnect_and_flush();
+      if (persistent_state)
+        persistent_state->write();
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      partial_means.update ([&sample, &aux_data](PartialMean &partial_mean)
+      {
+        partial_mean.add_sample (std::move(sample),
+                                 aux_data.n_repetitions() * aux_data.weight());
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (1);
     }
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    MeanValue<InputType,AccumulatorType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
     void
-    MeanValue<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    MeanValue<InputType,AccumulatorType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      partial_means.update ([&sample, &aux_data](PartialMean &partial_mean)
+      {
+        partial_mean.add_sample (sample,
+                                 aux_data.n_repetitions() * aux_data.weight());
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (1);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      partial_means.update ([&samples, &aux_data](PartialMean &partial_mean)
+      {
+        partial_mean.add_batch (samples, aux_data);
+      }, this->is_single_threaded() == false);
+
+      if (persistent_state)
+        persistent_state->samples_processed (samples.size());
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::PartialMean::
+    add_sample (InputType &&sample,
+                const double weight)
+    {
+      // Samples that carry no weight at all do not change anything:
+      if (weight == 0)
+        return;
+
+      // Sparse samples are added element by element, for which we do not
+      // need to own the sample:
+      if constexpr (use_sparse_update)
+        {
+          add_sample (std::as_const(sample), weight);
+          return;
+        }
 
       // If this is the first sample we see, initialize the current-mean with
       // this sample.
-      if (n_samples == 0)
+      if (total_weight == 0)
         {
-          n_samples = 1;
-          current_mean = std::move(sample);
+          total_weight = weight;
+          current_mean = Utilities::convert_elements<AccumulatorType> (std::move(sample));
         }
       else
         {
           // Otherwise update the previously computed mean by the current
-          // sample.
-          ++n_samples;
+          // sample, using the formulas in the documentation of this class.
+          total_weight += weight;
+
+          Utilities::update_running_mean (current_mean, std::move(sample),
+                                          weight / total_weight);
+        }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::PartialMean::
+    add_sample (const InputType &sample,
+                const double     weight)
+    {
+      if (weight == 0)
+        return;
+
+      if (total_weight == 0)
+        {
+          total_weight = weight;
+          current_mean = Utilities::convert_elements<AccumulatorType> (sample);
+          scale = 1;
+        }
+      else if constexpr (use_sparse_update)
+        {
+          // Update the scaled representation of the mean as described in
+          // the documentation of this class. If the scaling factor becomes
+          // so small that the elements of current_mean could overflow,
+          // apply it to them first; this costs O(d) operations, but is only
+          // necessary once in a very long while:
+          total_weight += weight;
+          const double f = weight / total_weight;
+          if (scale * (1-f) < 1e-100)
+            normalize ();
+          scale *= (1-f);
+
+          using scalar_type = types::ScalarType<AccumulatorType>;
+          const double factor = f / scale;
+          Utilities::for_each_nonzero (sample,
+                                       [this, factor](const std::size_t j, const auto x_j)
+          {
+            Utilities::get_nth_element (current_mean, j) += static_cast<scalar_type>(x_j * factor);
+          });
+        }
+      else
+        {
+          total_weight += weight;
+
+          Utilities::update_running_mean (current_mean, sample,
+                                          weight / total_weight);
+        }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::PartialMean::
+    add_batch (const std::vector<InputType>     &samples,
+               const std::vector<AuxiliaryData> &aux_data)
+    {
+      using input_scalar_type = types::ScalarType<InputType>;
+      using scalar_type       = types::ScalarType<AccumulatorType>;
+
+      // For integer-valued samples, the weighted sum below would be rounded
+      // differently than the updates in add_sample(), so process them one
+      // by one as in consume() instead:
+      if constexpr (Concepts::has_contiguous_storage<InputType,input_scalar_type>
+                    &&
+                    Concepts::has_contiguous_storage<AccumulatorType,scalar_type>
+                    &&
+                    (std::is_integral_v<scalar_type> == false))
+        {
+          // Accumulate the weighted sum of the samples directly in the
+          // memory of an object of type AccumulatorType, which we create as
+          // a (converted) copy of the first sample so that it has the right
+          // size:
+          PartialMean batch;
+          scalar_type *batch_sum = nullptr;
+          std::size_t  size = 0;
+          for (std::size_t i=0; i<samples.size(); ++i)
+            {
+              const double weight = aux_data[i].n_repetitions() * aux_data[i].weight();
+              if (weight == 0)
+                continue;
+
+              const input_scalar_type *sample = std::ranges::data(samples[i]);
+              if (batch.total_weight == 0)
+                {
+                  batch.current_mean = Utilities::convert_elements<AccumulatorType> (samples[i]);
+                  batch_sum = std::ranges::data(batch.current_mean);
+                  size = Utilities::size(samples[i]);
+                  for (std::size_t j=0; j<size; ++j)
+                    batch_sum[j] = sample[j] * weight;
+                }
+              else
+                {
+                  assert (static_cast<std::size_t>(Utilities::size(samples[i])) == size);
+                  for (std::size_t j=0; j<size; ++j)
+                    batch_sum[j] += sample[j] * weight;
+                }
+              batch.total_weight += weight;
+            }
+          if (batch.total_weight == 0)
+            return;
+
+          for (std::size_t j=0; j<size; ++j)
+            batch_sum[j] /= batch.total_weight;
+
+          merge (batch);
+        }
+      else
+        for (std::size_t i=0; i<samples.size(); ++i)
+          add_sample (InputType(samples[i]),
+                      aux_data[i].n_repetitions() * aux_data[i].weight());
+    }
+
+
 
-          InputType update = std::move(sample);
-          update -= current_mean;
-          update /= n_samples;
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::PartialMean::
+    merge (const PartialMean &other)
+    {
+      // Merging with an empty set of samples does not change anything,
+      // and merging an empty set with another set simply yields the
+      // other set:
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      const double combined_weight = total_weight + other.total_weight;
 
-          current_mean += update;
+      normalize ();
+      if (other.scale != 1)
+        {
+          PartialMean normalized_other = other;
+          normalized_other.normalize ();
+          Utilities::update_running_mean (current_mean, normalized_other.current_mean,
+                                          other.total_weight / combined_weight);
         }
+      else
+        Utilities::update_running_mean (current_mean, other.current_mean,
+                                        other.total_weight / combined_weight);
+      total_weight = combined_weight;
     }
 
 
 
-    template <typename InputType>
-    requires (Concepts::is_vector_space_type<InputType>)
-    typename MeanValue<InputType>::value_type
-    MeanValue<InputType>::
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::PartialMean::
+    normalize ()
+    {
+      if (scale != 1)
+        {
+          current_mean = current_mean * scale;
+          scale = 1;
+        }
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    typename MeanValue<InputType,AccumulatorType>::value_type
+    MeanValue<InputType,AccumulatorType>::
     get () const
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      PartialMean mean = partial_means.merged();
+      mean.normalize ();
+      return mean.current_mean;
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::
+    save (std::vector<char> &buffer) const
+    {
+      PartialMean mean = partial_means.merged();
+      mean.normalize ();
+      Serialization::write (buffer, mean.current_mean);
+      Serialization::write (buffer, mean.total_weight);
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialMean mean;
+      Serialization::read (buffer, mean.current_mean);
+      Serialization::read (buffer, mean.total_weight);
+      partial_means.reset (mean);
+    }
+
 
-      return current_mean;
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    bool
+    MeanValue<InputType,AccumulatorType>::
+    keep_state_in_file (const std::string        &filename,
+                        const types::sample_index interval)
+    {
+      persistent_state = std::make_unique<PersistentState> (filename,
+                                                             [this](std::vector<char> &buffer)
+      {
+        save (buffer);
+      },
+      interval);
+
+      return persistent_state->restore ([this](std::span<const char> &buffer)
+      {
+        load (buffer);
+      });
+    }
+
+
+
+    template <typename InputType, typename AccumulatorType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::is_vector_space_type<AccumulatorType>)
+    void
+    MeanValue<InputType,AccumulatorType>::
+    merge (const MeanValue &other)
+    {
+      const PartialMean other_mean = other.partial_means.merged();
+      partial_means.update ([&other_mean](PartialMean &partial_mean)
+      {
+        partial_mean.merge (other_mean);
+      }, this->is_single_threaded() == false);
     }
 
   }
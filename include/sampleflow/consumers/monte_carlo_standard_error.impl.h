@@ -0,0 +1,599 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that estimates the Monte Carlo standard error of
+     * the mean of the samples, i.e., the standard deviation of the error
+     * one makes when using the mean of the (correlated) samples of a Markov
+     * chain as an approximation of the expected value of the distribution
+     * sampled. This is the quantity that determines how many digits of
+     * the result of, for example, the MeanValue class can be trusted,
+     * and it is computed for each component of the samples separately.
+     *
+     *
+     * <h3> Algorithm </h3>
+     *
+     * The class uses the method of non-overlapping batch means: If one
+     * splits the $n$ samples of a chain into $m$ consecutive batches of $b$
+     * samples each, and if $b$ is large compared to the correlation length
+     * of the chain, then the means of these batches are approximately
+     * independent, and the variance of the mean of all samples is
+     * approximately $s_b^2/m$, where $s_b^2$ is the sample variance of the
+     * batch means. The standard error is then $s_b/\sqrt{m}$.
+     *
+     * The batch size needs to grow with the length of the chain. To this
+     * end, the class starts with batches of size one and stores the sums
+     * of up to $2B$ completed batches. Once there are $2B$ batches, pairs of
+     * consecutive batches are combined into one, leaving $B$ batches of
+     * twice the previous size. The number of batches is therefore always
+     * between $B$ and $2B$ (once at least $B$ samples have been seen), the
+     * batch size grows proportionally to $n$, and the memory required is
+     * ${\cal O}(Bd)$ for samples with $d$ components, independent of $n$.
+     * Each sample costs ${\cal O}(d)$ operations, plus ${\cal O}(d)$ amortized
+     * for combining batches. The value of $B$ is given to the constructor;
+     * larger values make the estimate less noisy, but increase its bias if
+     * the batches become too short compared to the correlation length
+     * of the chain. A sample whose auxiliary data carries an entry with
+     * key AuxiliaryData::repetition_count counts as many times as this
+     * entry says. Like the EffectiveSampleSize class (which uses batches of
+     * all sizes $2^k$, at a memory cost that grows with $n$), this class does
+     * not support weighted samples other than samples with weight zero,
+     * which are ignored.
+     *
+     *
+     * <h3> Several chains </h3>
+     *
+     * The samples that arrive on each thread are considered to form one
+     * chain, and the batches of each chain are kept separately (see the
+     * ShardedAccumulator class). This is the situation if several samplers
+     * run on separate threads and all send their samples to the same
+     * object. Since the chains are independent, the variance of the sum of
+     * all samples is the sum of the variances of the sums of each chain,
+     * and the standard error reported is that of the mean over all samples
+     * of all chains, estimated in this way. The same approach is used by
+     * merge() to combine the estimates of two objects. If more threads send
+     * samples than the ShardedAccumulator uses shards, then the samples
+     * of several threads end up in the same chain, which leads to estimates
+     * that are too small.
+     *
+     *
+     * <h3> Threading model </h3>
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because samples need to be processed on the thread on which
+     * they were sent and in the order in which they were generated, the
+     * class only supports ParallelMode::synchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. It needs
+     *   to satisfy the same requirements as for the MeanValue class, and
+     *   its elements need to be real-valued floating point numbers.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    class MonteCarloStandardError: public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type returned by the get() function: One standard error
+         * per component of the samples.
+         */
+        using value_type = std::vector<double>;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] min_n_batches The number $B$ discussed in the
+         *   documentation of this class. Must be at least two.
+         */
+        MonteCarloStandardError (const unsigned int min_n_batches = 32);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MonteCarloStandardError ();
+
+        /**
+         * Process one sample by adding it to the current batch of the
+         * chain that corresponds to the current thread.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and the weight of the
+         *   sample. The latter must be either zero or one.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the estimated Monte Carlo standard error of the mean of
+         * each component of the samples seen so far. If no chain has
+         * completed two batches yet (i.e., if no thread has sent at least
+         * two samples), then the returned values are infinite.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Append the state of the computation to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class. If samples were sent
+         * from several threads, then the chains are combined as in merge()
+         * first, and a Consumer object into which the data is loaded then
+         * starts a new chain.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same number $B$ as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the estimate of another object that has processed independent
+         * chains to the one of the current object, as discussed in the
+         * documentation of this class.
+         */
+        void
+        merge (const MonteCarloStandardError &other);
+
+      private:
+        /**
+         * A structure that describes the batches of one chain, along with
+         * the combined contributions of chains that have been merged into
+         * it.
+         */
+        struct PartialEstimate
+        {
+          /**
+           * The number $B$, and the number of components of samples (which
+           * is zero until the first sample arrives).
+           */
+          unsigned int min_n_batches = 0;
+          unsigned int dimension     = 0;
+
+          /**
+           * The number of samples of the chain, the current batch size,
+           * and the number of samples in the current, incomplete batch.
+           */
+          types::sample_index n_samples           = 0;
+          types::sample_index batch_size          = 1;
+          types::sample_index n_in_current_batch  = 0;
+
+          /**
+           * The sums of the samples of the completed batches, stored one
+           * batch after the other, and the sum of the samples of the
+           * incomplete batch.
+           */
+          std::vector<double> batch_sums;
+          std::vector<double> current_batch_sum;
+
+          /**
+           * The total number of samples of the chains merged into the
+           * current object, and the sum of the estimated variances of the
+           * sums of their samples.
+           */
+          types::sample_index merged_n_samples = 0;
+          std::vector<double> merged_variance_of_sum;
+
+          /**
+           * Whether at least one of the merged chains had enough batches
+           * to contribute to `merged_variance_of_sum`.
+           */
+          bool has_variance = false;
+
+          /**
+           * Add `n_repetitions` copies of the given sample to the chain.
+           */
+          void
+          add_sample (const std::vector<double> &sample,
+                      types::sample_index        n_repetitions);
+
+          /**
+           * Return the number of completed batches.
+           */
+          unsigned int
+          n_batches () const;
+
+          /**
+           * Return the estimated variance of the sum of the samples of the
+           * chain itself, or an empty vector if there are fewer than two
+           * completed batches.
+           */
+          std::vector<double>
+          chain_variance_of_sum () const;
+
+          /**
+           * Add the estimate of the chains described by `other` to the
+           * merged contributions of the current object.
+           */
+          void
+          merge (const PartialEstimate &other);
+
+          /**
+           * Write the members of this structure to a buffer, or read them
+           * from a buffer.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          void
+          load (std::span<const char> &buffer);
+        };
+
+        /**
+         * The number $B$.
+         */
+        const unsigned int min_n_batches;
+
+        /**
+         * The chains processed on the threads that have sent samples to
+         * this object.
+         */
+        ShardedAccumulator<PartialEstimate> estimates;
+
+        /**
+         * Return an estimate without any samples for the given $B$.
+         */
+        static
+        PartialEstimate
+        empty_estimate (const unsigned int min_n_batches);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    add_sample (const std::vector<double> &sample,
+                types::sample_index        n_repetitions)
+    {
+      if (dimension == 0)
+        {
+          dimension = sample.size();
+          batch_sums.reserve (2 * min_n_batches * dimension);
+          current_batch_sum.assign (dimension, 0.);
+          if (merged_variance_of_sum.empty())
+            merged_variance_of_sum.assign (dimension, 0.);
+        }
+      assert (sample.size() == dimension);
+
+      n_samples += n_repetitions;
+
+      // Add as many copies of the sample to the current batch as it
+      // still needs (or as we have), and whenever this completes the
+      // batch, store it. Each iteration completes a batch, so the number
+      // of iterations is at most proportional to B times the logarithm of
+      // the number of copies.
+      while (n_repetitions > 0)
+        {
+          const types::sample_index n_added
+            = std::min (n_repetitions, batch_size - n_in_current_batch);
+          for (unsigned int j=0; j<dimension; ++j)
+            current_batch_sum[j] += n_added * sample[j];
+          n_in_current_batch += n_added;
+          n_repetitions -= n_added;
+
+          if (n_in_current_batch == batch_size)
+            {
+              batch_sums.insert (batch_sums.end(),
+                                 current_batch_sum.begin(), current_batch_sum.end());
+              std::fill (current_batch_sum.begin(), current_batch_sum.end(), 0.);
+              n_in_current_batch = 0;
+
+              // If we now have 2B batches, combine pairs of them:
+              if (n_batches() == 2*min_n_batches)
+                {
+                  for (unsigned int b=0; b<min_n_batches; ++b)
+                    for (unsigned int j=0; j<dimension; ++j)
+                      batch_sums[b*dimension + j] = batch_sums[2*b*dimension + j]
+                                                    + batch_sums[(2*b+1)*dimension + j];
+                  batch_sums.resize (min_n_batches * dimension);
+                  batch_size *= 2;
+                }
+            }
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    unsigned int
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    n_batches () const
+    {
+      return (dimension > 0 ? batch_sums.size() / dimension : 0);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::vector<double>
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    chain_variance_of_sum () const
+    {
+      const unsigned int m = n_batches();
+      if (m < 2)
+        return {};
+
+      // Compute the sample variance s_b^2 of the batch means with
+      // Welford's algorithm. The variance of the mean of the chain is then
+      // approximately s_b^2/m, and the variance of the sum of its n
+      // samples n^2 s_b^2/m:
+      std::vector<double> mean (dimension, 0.);
+      std::vector<double> sum_of_squares (dimension, 0.);
+      for (unsigned int b=0; b<m; ++b)
+        for (unsigned int j=0; j<dimension; ++j)
+          {
+            const double batch_mean = batch_sums[b*dimension + j] / batch_size;
+            const double delta = batch_mean - mean[j];
+            mean[j] += delta / (b+1);
+            sum_of_squares[j] += delta * (batch_mean - mean[j]);
+          }
+
+      const double n = static_cast<double>(n_samples);
+      std::vector<double> variance (dimension);
+      for (unsigned int j=0; j<dimension; ++j)
+        variance[j] = n * n * sum_of_squares[j] / (m-1) / m;
+      return variance;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    merge (const PartialEstimate &other)
+    {
+      if ((other.n_samples == 0) && (other.merged_n_samples == 0))
+        return;
+
+      assert (min_n_batches == other.min_n_batches);
+      if (merged_variance_of_sum.empty())
+        merged_variance_of_sum.assign (other.merged_variance_of_sum.size(), 0.);
+      assert ((dimension == 0) || (other.dimension == 0) || (dimension == other.dimension));
+
+      // Chains with fewer than two completed batches only consist of a
+      // single sample, and their contribution to the variance is simply
+      // not known. Ignore it.
+      const std::vector<double> other_chain_variance = other.chain_variance_of_sum();
+      for (unsigned int j=0; j<merged_variance_of_sum.size(); ++j)
+        merged_variance_of_sum[j] += other.merged_variance_of_sum[j]
+                                     + (other_chain_variance.size() > 0 ?
+                                        other_chain_variance[j] : 0.);
+      merged_n_samples += other.n_samples + other.merged_n_samples;
+      has_variance = has_variance || other.has_variance || (other_chain_variance.size() > 0);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, min_n_batches);
+      Serialization::write (buffer, dimension);
+      Serialization::write (buffer, n_samples);
+      Serialization::write (buffer, batch_size);
+      Serialization::write (buffer, n_in_current_batch);
+      Serialization::write (buffer, batch_sums);
+      Serialization::write (buffer, current_batch_sum);
+      Serialization::write (buffer, merged_n_samples);
+      Serialization::write (buffer, merged_variance_of_sum);
+      Serialization::write (buffer, has_variance);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::PartialEstimate::
+    load (std::span<const char> &buffer)
+    {
+      Serialization::read (buffer, min_n_batches);
+      Serialization::read (buffer, dimension);
+      Serialization::read (buffer, n_samples);
+      Serialization::read (buffer, batch_size);
+      Serialization::read (buffer, n_in_current_batch);
+      Serialization::read (buffer, batch_sums);
+      Serialization::read (buffer, current_batch_sum);
+      Serialization::read (buffer, merged_n_samples);
+      Serialization::read (buffer, merged_variance_of_sum);
+      Serialization::read (buffer, has_variance);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename MonteCarloStandardError<InputType>::PartialEstimate
+    MonteCarloStandardError<InputType>::
+    empty_estimate (const unsigned int min_n_batches)
+    {
+      PartialEstimate estimate;
+      estimate.min_n_batches = min_n_batches;
+      return estimate;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    MonteCarloStandardError<InputType>::
+    MonteCarloStandardError (const unsigned int min_n_batches)
+      :
+      Consumer<InputType>(ParallelMode::synchronous),
+      min_n_batches (min_n_batches),
+      estimates (empty_estimate (min_n_batches))
+    {
+      assert (min_n_batches >= 2);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    MonteCarloStandardError<InputType>::
+    ~MonteCarloStandardError ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double weight = aux_data.weight();
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
+      assert ((weight == 1) && "This class does not support weighted samples.");
+
+      std::vector<double> x (Utilities::size(sample));
+      for (unsigned int j=0; j<x.size(); ++j)
+        x[j] = Utilities::get_nth_element (sample, j);
+
+      estimates.update ([&x, n_repetitions](PartialEstimate &estimate)
+      {
+        estimate.add_sample (x, n_repetitions);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename MonteCarloStandardError<InputType>::value_type
+    MonteCarloStandardError<InputType>::
+    get () const
+    {
+      // Merge all chains into an empty estimate, so that the contributions
+      // of all of them end up in the merged part. Note that the number of
+      // samples counted there includes those of chains that are too
+      // short to contribute a variance, since the mean the error refers
+      // to includes these samples as well.
+      const PartialEstimate all_chains = estimates.merged();
+      PartialEstimate estimate = empty_estimate (min_n_batches);
+      estimate.merge (all_chains);
+
+      const double n = static_cast<double>(estimate.merged_n_samples);
+      const std::vector<double> &variance = estimate.merged_variance_of_sum;
+
+      // If no chain contributes a variance, the error is not known:
+      value_type standard_error (variance.size(),
+                                 std::numeric_limits<double>::infinity());
+      if (estimate.has_variance)
+        for (unsigned int j=0; j<variance.size(); ++j)
+          standard_error[j] = std::sqrt (variance[j]) / n;
+      return standard_error;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, estimates.merged());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialEstimate estimate;
+      Serialization::read (buffer, estimate);
+      assert (estimate.min_n_batches == min_n_batches);
+      estimates.reset (estimate);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    MonteCarloStandardError<InputType>::
+    merge (const MonteCarloStandardError &other)
+    {
+      const PartialEstimate other_estimate = other.estimates.merged();
+      estimates.update ([&other_estimate](PartialEstimate &estimate)
+      {
+        estimate.merge (other_estimate);
+      }, this->is_single_threaded() == false);
+    }
+  }
+}
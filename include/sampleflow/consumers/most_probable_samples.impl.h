@@ -0,0 +1,258 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that keeps the $k$ most likely among the samples seen
+     * so far. This generalizes the MaximumProbabilitySample class, which
+     * only keeps the single most likely sample: Like that class, the
+     * current one looks at the entry with key
+     * AuxiliaryData::relative_log_likelihood in the auxiliary data of each
+     * sample, and ignores samples that do not have such an entry.
+     *
+     * Markov chain samplers such as Producers::MetropolisHastings send the
+     * previous sample again whenever a trial sample is rejected. To make
+     * sure that the list of most likely samples does not consist of $k$
+     * copies of the same sample, this class ignores all samples whose
+     * auxiliary data says that they are repetitions of the previous sample
+     * (i.e., that have an entry with key AuxiliaryData::sample_is_repeated
+     * that is `true`). This does not require comparing samples with each
+     * other, but also means that the class does not recognize samples that
+     * are equal to ones seen before for other reasons, for example because
+     * a chain returned to a point it had visited before.
+     *
+     * The samples are stored in a heap whose top element is the least likely
+     * of the $k$ samples kept, so that replacing it by a more likely sample
+     * costs $O(\log k)$ operations. Once $k$ samples have been seen, the log
+     * likelihood of this element is a threshold that a sample has to exceed
+     * to be considered at all; this threshold is also stored in an atomic
+     * variable that can be read without holding a lock. Since the vast
+     * majority of samples is generally not among the $k$ most likely
+     * ones, consume() then typically returns after reading this variable,
+     * and only needs to acquire a mutex for the few samples that make it
+     * onto the list.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$.
+     */
+    template <typename InputType>
+    class MostProbableSamples : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class. Here, this
+         * is a vector of pairs of a sample and the AuxiliaryData that was
+         * attached to it.
+         */
+        using value_type = std::vector<std::pair<InputType,AuxiliaryData>>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] n_samples The number $k$ of samples to keep. Must be at
+         *   least one.
+         */
+        MostProbableSamples (const unsigned int n_samples);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MostProbableSamples ();
+
+        /**
+         * Process one sample by checking whether it is more likely than the
+         * least likely of the samples kept so far (or whether fewer than $k$
+         * samples have been kept so far). If so, store it.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the entries with keys
+         *   AuxiliaryData::relative_log_likelihood and
+         *   AuxiliaryData::sample_is_repeated as discussed in the
+         *   documentation of this class, and ignores all other entries.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the most likely samples seen so far, along with the
+         * auxiliary data that was associated with each of them, sorted by
+         * decreasing log likelihood. The vector returned has $k$ elements,
+         * or fewer if fewer suitable samples have been processed so far.
+         */
+        value_type
+        get () const;
+
+      private:
+        /**
+         * A structure that represents one of the samples kept.
+         */
+        struct Entry
+        {
+          double        log_likelihood;
+          InputType     sample;
+          AuxiliaryData aux_data;
+
+          /**
+           * Comparison operator. We use it to order the heap so that its top
+           * element is the least likely sample.
+           */
+          bool
+          operator> (const Entry &other) const
+          {
+            return log_likelihood > other.log_likelihood;
+          }
+        };
+
+        /**
+         * The number of samples to keep.
+         */
+        const unsigned int n_samples;
+
+        /**
+         * A mutex used to lock access to the `heap` member variable when
+         * running on multiple threads.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The samples kept so far, arranged as a heap with the least likely
+         * sample at the front.
+         */
+        std::vector<Entry> heap;
+
+        /**
+         * The log likelihood a sample has to exceed to be added to the heap.
+         * This is minus infinity until $k$ samples are stored, and the log
+         * likelihood of the front element of the heap afterwards. The
+         * variable is only written while holding the mutex, but may be read
+         * at any time. Because the threshold only ever increases, a thread
+         * that reads an outdated value will at worst acquire the mutex
+         * unnecessarily, and then find out that the sample is not good
+         * enough after all.
+         */
+        std::atomic<double> threshold;
+    };
+
+
+
+    template <typename InputType>
+    MostProbableSamples<InputType>::
+    MostProbableSamples (const unsigned int n_samples)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      n_samples (n_samples),
+      threshold (-std::numeric_limits<double>::infinity())
+    {
+      assert (n_samples >= 1);
+      heap.reserve (n_samples+1);
+    }
+
+
+
+    template <typename InputType>
+    MostProbableSamples<InputType>::
+    ~MostProbableSamples ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    void
+    MostProbableSamples<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      // Repeated samples have already been considered when they were
+      // first sent:
+      if (const bool *is_repeated = aux_data.get_if<bool> (AuxiliaryData::sample_is_repeated))
+        if (*is_repeated)
+          return;
+
+      const double *p = aux_data.get_if<double> (AuxiliaryData::relative_log_likelihood);
+      if (p == nullptr)
+        return;
+      const double log_likelihood = *p;
+
+      // Check whether the sample is good enough without holding the lock.
+      // Writing the condition this way also excludes NaNs:
+      if (!(log_likelihood > threshold.load (std::memory_order_relaxed)))
+        return;
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // Check again now that we hold the lock, since another thread may
+      // have raised the threshold in the meantime:
+      if ((heap.size() == n_samples) && !(log_likelihood > heap.front().log_likelihood))
+        return;
+
+      heap.push_back ({log_likelihood, std::move(sample), std::move(aux_data)});
+      std::push_heap (heap.begin(), heap.end(), std::greater<Entry>());
+      if (heap.size() > n_samples)
+        {
+          std::pop_heap (heap.begin(), heap.end(), std::greater<Entry>());
+          heap.pop_back ();
+        }
+
+      if (heap.size() == n_samples)
+        threshold.store (heap.front().log_likelihood, std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    typename MostProbableSamples<InputType>::value_type
+    MostProbableSamples<InputType>::
+    get () const
+    {
+      std::vector<Entry> entries;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries = heap;
+      }
+
+      std::sort (entries.begin(), entries.end(), std::greater<Entry>());
+
+      value_type return_value;
+      for (auto &entry : entries)
+        return_value.emplace_back (std::move(entry.sample), std::move(entry.aux_data));
+      return return_value;
+    }
+
+  }
+}
@@ -0,0 +1,653 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes a joint histogram of several selected
+     * components of vector-valued samples, for example to visualize the
+     * joint distribution of three to six parameters, or to compare models
+     * via the densities they imply. This generalizes the PairHistogram
+     * class to more than two components; because the number of bins of a
+     * dense grid grows exponentially with the number of components, the
+     * class uses the same approach as the SparsePairHistogram class and
+     * only stores the cells of the grid that actually contain samples.
+     *
+     * The cells this class uses tile the entire space of the selected
+     * components and are all of the same size. Specifically, if the
+     * constructor is called with cell widths $h_1,\ldots,h_D$ and an origin
+     * $(o_1,\ldots,o_D)$, then the cell with integer coordinates
+     * $(i_1,\ldots,i_D)$ is the box $\prod_d [o_d+i_dh_d, o_d+(i_d+1)h_d)$.
+     * The memory used by this class is proportional to the number of cells
+     * that contain samples, times the number of selected components.
+     * Samples with a selected component that is not a finite number
+     * are ignored.
+     *
+     * Besides the histogram itself, the class can evaluate a "binned"
+     * kernel density estimate of the joint distribution of the selected
+     * components at given points (see get_density()). Rather than summing
+     * the kernel over all samples, which would require storing them, this
+     * estimate places the weight of all samples in a cell at the center of
+     * the cell. This approximation is accurate as long as the bandwidths of
+     * the kernel are large compared to the widths of the cells. The
+     * estimate is only computed when get_density() is called, and so
+     * consuming samples costs nothing beyond updating the histogram.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. If samples carry weights (see AuxiliaryData::sample_weight),
+     * then the class also adds up the weights of the samples in each cell;
+     * these can be obtained via get_weighted(), and are the ones used by
+     * get_density().
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread counts samples in its own hash table, stored in a
+     * ShardedAccumulator object, so that threads do not have to wait for
+     * each other; get() and the other functions that need the complete
+     * histogram add up these tables.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. The requirements on this type are the same as for
+     *   the PairHistogram class, except that there is no restriction on the
+     *   number of components.
+     */
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class MultivariateHistogram : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(). This is a vector with one
+         * entry for each cell that contains samples, and each cell is
+         * represented by three elements:
+         * - The corner of the cell with the smallest coordinates.
+         * - The corner of the cell with the largest coordinates.
+         * - The number of samples in the cell.
+         * The $d$th coordinate of each corner corresponds to the $d$th of the
+         * components selected in the constructor. The cells are sorted
+         * lexicographically by their first corner.
+         */
+        using value_type = std::vector<std::tuple<std::vector<double>,std::vector<double>,types::sample_index>>;
+
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as `value_type`, except that the third element of each cell is
+         * the sum of the weights of the samples in the cell.
+         */
+        using weighted_value_type = std::vector<std::tuple<std::vector<double>,std::vector<double>,double>>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] components The components of the samples whose joint
+         *   histogram should be computed. The entries of this vector have to
+         *   be distinct.
+         * @param[in] cell_widths The widths of the cells in the directions
+         *   of the selected components. This vector needs to have as many
+         *   entries as `components`, and all of them must be positive.
+         * @param[in] origin A corner of one of the cells. If this vector is
+         *   empty, the default, then the origin is used; otherwise, it needs
+         *   to have as many entries as `components`.
+         */
+        MultivariateHistogram (const std::vector<unsigned int> &components,
+                               const std::vector<double>       &cell_widths,
+                               const std::vector<double>       &origin = {});
+
+        /**
+         * Copy constructor.
+         */
+        MultivariateHistogram (const MultivariateHistogram<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MultivariateHistogram ();
+
+        /**
+         * Process one sample by computing which cell it lies in, and then
+         * incrementing the number of samples in the cell.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples. This has the same effect as calling
+         * consume() for each sample of the batch, but only accesses the table
+         * of the current thread once.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `value_type` type.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `weighted_value_type` type, i.e., with the sum of the
+         * weights of the samples in each cell rather than their number.
+         */
+        weighted_value_type
+        get_weighted () const;
+
+        /**
+         * Evaluate the binned kernel density estimate discussed in the
+         * documentation of this class at the given points, using a Gaussian
+         * kernel. That is, for each point $x$, compute
+         * @f{align*}{
+         *   \hat p(x) = \frac{1}{W} \sum_c W_c \prod_{d=1}^D
+         *      \frac{1}{\sqrt{2\pi}\, b_d}
+         *      \exp\left(-\frac{(x_d-m_{c,d})^2}{2b_d^2}\right),
+         * @f}
+         * where the sum is over all cells that contain samples, $W_c$ is the
+         * sum of the weights of the samples in cell $c$ and $m_c$ its
+         * center, $W$ is the sum of the weights of all samples, and $b_d$ are
+         * the bandwidths. The cost of this function is proportional to the
+         * number of points times the number of cells that contain samples.
+         *
+         * @param[in] points The points at which to evaluate the estimate.
+         *   Each point needs to have as many entries as there are selected
+         *   components.
+         * @param[in] bandwidths The bandwidths $b_d$ of the kernel in the
+         *   directions of the selected components. All of them must be
+         *   positive.
+         * @return A vector with the estimated density at each point. If no
+         *   samples with nonzero total weight have been processed, the
+         *   estimates are NaN.
+         */
+        std::vector<double>
+        get_density (const std::vector<std::vector<double>> &points,
+                     const std::vector<double>              &bandwidths) const;
+
+        /**
+         * Append the selected components and the geometry of the cells,
+         * along with the cells that contain samples and the numbers and
+         * weights of samples in them, to the given buffer. See the section
+         * on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the cells stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The object that wrote the
+         * data must have been created with the same arguments to the
+         * constructor as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another object has
+         * counted in each cell to the ones counted by the current object.
+         * Both objects must have been created with the same arguments to
+         * the constructor.
+         */
+        void
+        merge (const MultivariateHistogram &other);
+
+      private:
+        /**
+         * The arguments given to the constructor, with an empty `origin`
+         * replaced by zeros.
+         */
+        const std::vector<unsigned int> components;
+        const std::vector<double>       cell_widths;
+        const std::vector<double>       origin;
+
+        /**
+         * A structure storing the cells that contain samples processed by
+         * one shard of the `partial_histograms` variable below.
+         */
+        struct PartialHistogram
+        {
+          internal::SparseGridTable cells;
+
+          /**
+           * Add the cells stored in the argument to the ones stored in the
+           * current object.
+           */
+          void
+          merge (const PartialHistogram &other);
+        };
+
+        /**
+         * The cells counted by the threads that have sent samples to this
+         * object.
+         */
+        ShardedAccumulator<PartialHistogram> partial_histograms;
+
+        /**
+         * Compute the integer coordinates of the cell the given sample lies
+         * in, and write them into `index`. Return whether all selected
+         * components of the sample are finite.
+         */
+        bool
+        compute_cell_index (const InputType &sample,
+                            std::int64_t    *index) const;
+
+        /**
+         * Return the two corners of the given cell.
+         */
+        std::pair<std::vector<double>,std::vector<double>>
+        cell_corners (const internal::SparseGridTable::Cell &cell) const;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MultivariateHistogram<InputType>::
+    MultivariateHistogram (const std::vector<unsigned int> &components,
+                           const std::vector<double>       &cell_widths,
+                           const std::vector<double>       &origin)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      components (components),
+      cell_widths (cell_widths),
+      origin (origin.size() > 0 ? origin : std::vector<double>(components.size(), 0.)),
+      partial_histograms (PartialHistogram {internal::SparseGridTable (components.size())})
+    {
+      assert (components.size() > 0);
+      assert (cell_widths.size() == components.size());
+      assert (this->origin.size() == components.size());
+
+      for (unsigned int d=0; d<components.size(); ++d)
+        {
+          assert (cell_widths[d] > 0);
+          for (unsigned int e=0; e<d; ++e)
+            assert (components[d] != components[e]);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MultivariateHistogram<InputType>::
+    MultivariateHistogram (const MultivariateHistogram<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      components (o.components),
+      cell_widths (o.cell_widths),
+      origin (o.origin),
+      partial_histograms (o.partial_histograms)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    MultivariateHistogram<InputType>::
+    ~MultivariateHistogram ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      std::vector<std::int64_t> index (components.size());
+      if (compute_cell_index (sample, index.data()) == false)
+        return;
+
+      const double weight = n_repetitions * aux_data.weight();
+      partial_histograms.update ([&](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.cells.add (index.data(), n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      // Compute the cells of all samples before accessing the table:
+      const unsigned int D = components.size();
+      std::vector<std::int64_t> indices (samples.size() * D);
+      std::vector<bool>         valid (samples.size());
+      for (std::size_t i=0; i<samples.size(); ++i)
+        valid[i] = ((aux_data[i].n_repetitions() > 0)
+                    &&
+                    compute_cell_index (samples[i], &indices[i*D]));
+
+      partial_histograms.update ([&](PartialHistogram &partial_histogram)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          if (valid[i])
+            partial_histogram.cells.add (&indices[i*D], aux_data[i].n_repetitions(),
+                                         aux_data[i].n_repetitions() * aux_data[i].weight());
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MultivariateHistogram<InputType>::value_type
+    MultivariateHistogram<InputType>::
+    get () const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+
+      value_type return_value;
+      for (const auto &cell : histogram.cells.sorted_cells())
+        {
+          auto corners = cell_corners (cell);
+          return_value.emplace_back (std::move(corners.first), std::move(corners.second),
+                                     cell.n_samples);
+        }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename MultivariateHistogram<InputType>::weighted_value_type
+    MultivariateHistogram<InputType>::
+    get_weighted () const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+
+      weighted_value_type return_value;
+      for (const auto &cell : histogram.cells.sorted_cells())
+        {
+          auto corners = cell_corners (cell);
+          return_value.emplace_back (std::move(corners.first), std::move(corners.second),
+                                     cell.weight);
+        }
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::vector<double>
+    MultivariateHistogram<InputType>::
+    get_density (const std::vector<std::vector<double>> &points,
+                 const std::vector<double>              &bandwidths) const
+    {
+      const unsigned int D = components.size();
+      assert (bandwidths.size() == D);
+      for (unsigned int d=0; d<D; ++d)
+        assert (bandwidths[d] > 0);
+
+      // Convert the cells into a list of centers and weights, and compute
+      // the normalization of the estimate:
+      const auto cells = partial_histograms.merged().cells.sorted_cells();
+      std::vector<double> centers (cells.size() * D);
+      std::vector<double> weights (cells.size());
+      double total_weight = 0;
+      for (std::size_t c=0; c<cells.size(); ++c)
+        {
+          for (unsigned int d=0; d<D; ++d)
+            centers[c*D+d] = origin[d] + (cells[c].index[d] + 0.5) * cell_widths[d];
+          weights[c]    = cells[c].weight;
+          total_weight += cells[c].weight;
+        }
+
+      double normalization = 1. / total_weight;
+      for (unsigned int d=0; d<D; ++d)
+        normalization /= (std::sqrt(2*std::numbers::pi) * bandwidths[d]);
+
+      std::vector<double> densities (points.size());
+      for (std::size_t p=0; p<points.size(); ++p)
+        {
+          assert (points[p].size() == D);
+
+          double sum = 0;
+          for (std::size_t c=0; c<cells.size(); ++c)
+            {
+              double exponent = 0;
+              for (unsigned int d=0; d<D; ++d)
+                {
+                  const double z = (points[p][d] - centers[c*D+d]) / bandwidths[d];
+                  exponent += z*z;
+                }
+              sum += weights[c] * std::exp (-exponent/2);
+            }
+
+          densities[p] = (total_weight != 0
+                          ?
+                          sum * normalization
+                          :
+                          std::numeric_limits<double>::quiet_NaN());
+        }
+
+      return densities;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const auto cells = partial_histograms.merged().cells.sorted_cells();
+
+      // Store the cells as three flat arrays:
+      std::vector<std::int64_t>        indices;
+      std::vector<types::sample_index> counts;
+      std::vector<double>              weights;
+      for (const auto &cell : cells)
+        {
+          indices.insert (indices.end(), cell.index.begin(), cell.index.end());
+          counts.push_back (cell.n_samples);
+          weights.push_back (cell.weight);
+        }
+
+      Serialization::write (buffer, components);
+      Serialization::write (buffer, cell_widths);
+      Serialization::write (buffer, origin);
+      Serialization::write (buffer, indices);
+      Serialization::write (buffer, counts);
+      Serialization::write (buffer, weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<unsigned int> saved_components;
+      std::vector<double>       saved_cell_widths;
+      std::vector<double>       saved_origin;
+      Serialization::read (buffer, saved_components);
+      Serialization::read (buffer, saved_cell_widths);
+      Serialization::read (buffer, saved_origin);
+      assert (saved_components == components);
+      assert (saved_cell_widths == cell_widths);
+      assert (saved_origin == origin);
+
+      std::vector<std::int64_t>        indices;
+      std::vector<types::sample_index> counts;
+      std::vector<double>              weights;
+      Serialization::read (buffer, indices);
+      Serialization::read (buffer, counts);
+      Serialization::read (buffer, weights);
+      assert (indices.size() == counts.size() * components.size());
+      assert (weights.size() == counts.size());
+
+      PartialHistogram histogram {internal::SparseGridTable (components.size())};
+      for (std::size_t c=0; c<counts.size(); ++c)
+        histogram.cells.add (&indices[c*components.size()], counts[c], weights[c]);
+
+      partial_histograms.reset (histogram);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::
+    merge (const MultivariateHistogram &other)
+    {
+      assert (other.components == components);
+      assert (other.cell_widths == cell_widths);
+      assert (other.origin == origin);
+
+      const PartialHistogram other_histogram = other.partial_histograms.merged();
+      partial_histograms.update ([&other_histogram](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.merge (other_histogram);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    bool
+    MultivariateHistogram<InputType>::
+    compute_cell_index (const InputType &sample,
+                        std::int64_t    *index) const
+    {
+      // As in SparsePairHistogram, restrict the coordinates to a range that
+      // can be represented by 64-bit integers, with room to spare:
+      const double max_index = std::ldexp (1., 62);
+
+      for (unsigned int d=0; d<components.size(); ++d)
+        {
+          assert (components[d] < sample.size());
+          const double value = sample[components[d]];
+          if (!std::isfinite(value))
+            return false;
+
+          index[d] = static_cast<std::int64_t>(std::clamp (std::floor((value - origin[d]) / cell_widths[d]),
+                                                           -max_index, max_index));
+        }
+      return true;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::pair<std::vector<double>,std::vector<double>>
+    MultivariateHistogram<InputType>::
+    cell_corners (const internal::SparseGridTable::Cell &cell) const
+    {
+      std::pair<std::vector<double>,std::vector<double>> corners;
+      for (unsigned int d=0; d<components.size(); ++d)
+        {
+          corners.first.push_back (origin[d] + cell.index[d] * cell_widths[d]);
+          corners.second.push_back (origin[d] + (cell.index[d]+1) * cell_widths[d]);
+        }
+      return corners;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    MultivariateHistogram<InputType>::PartialHistogram::
+    merge (const PartialHistogram &other)
+    {
+      for (const auto &cell : other.cells.sorted_cells())
+        cells.add (cell.index.data(), cell.n_samples, cell.weight);
+    }
+  }
+}
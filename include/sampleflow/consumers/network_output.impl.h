@@ -0,0 +1,512 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that sends the samples it receives, along with
+     * selected entries of their auxiliary data, over a TCP connection to a
+     * Producers::NetworkInput object, typically in a program that runs on
+     * another machine. There, the samples are sent on to the consumers
+     * connected to the Producers::NetworkInput object. This makes it
+     * possible to stream samples from the compute nodes of a cluster that
+     * run samplers to a node that analyzes them as they arrive:
+     * @code
+     *   // On the analysis node:
+     *   SampleFlow::Producers::NetworkInput<Eigen::VectorXd>
+     *     network_input (5555, 16);   // port, number of senders
+     *   SampleFlow::Consumers::MeanValue<Eigen::VectorXd> mean_value;
+     *   mean_value.connect_to_producer (network_input);
+     *   network_input.sample ();      // returns once all senders are done
+     *
+     *   // On each compute node:
+     *   SampleFlow::Producers::MetropolisHastings<Eigen::VectorXd> mh_sampler;
+     *   SampleFlow::Consumers::NetworkOutput<Eigen::VectorXd>
+     *     network_output ("analysis-node", 5555, 3);
+     *   network_output.connect_to_producer (mh_sampler);
+     *   mh_sampler.sample (...);
+     * @endcode
+     * The constructor of this class connects to the receiving side, which
+     * therefore needs to exist already; the connection is closed by the
+     * destructor.
+     *
+     * The class sends samples in batches: Samples are converted into
+     * records as described in the documentation of namespace
+     * ChainFileFormat, and once `batch_size` records have been collected
+     * (or when flush() is called, i.e., when the producer that sends
+     * samples to this object has finished), the batch is handed to a
+     * separate thread. That thread compresses the batch into a "frame" as
+     * described in the documentation of namespace NetworkStream and sends
+     * it. The threads that send samples to this object therefore neither
+     * compress nor wait for the network.
+     *
+     * Batches waiting for the sending thread are kept in a BoundedQueue.
+     * If the network or the receiving side do not keep up, this queue
+     * fills up, and what happens then is determined by the QueueFullPolicy
+     * given to the constructor, in the same way as for consumers that
+     * process samples in ParallelMode::asynchronous: The threads that send
+     * samples either wait -- i.e., the backpressure of the TCP connection
+     * propagates back to the sampler -- or the oldest batch that is still
+     * waiting is discarded. The latter is appropriate if the receiving side
+     * only monitors the sampler. If the receiving side closes the
+     * connection, all further batches are discarded.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from
+     * multiple threads.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. Its
+     *   scalar type (see types::ScalarType) needs to be an arithmetic
+     *   type, and all samples need to have the same number of components.
+     */
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class NetworkOutput : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the scalars that make up a sample.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * Constructor. Connect to the receiving side.
+         *
+         * @param[in] host The name or address of the machine on which the
+         *   receiving Producers::NetworkInput object runs.
+         * @param[in] port The port on which the receiving side listens.
+         * @param[in] dimension The number of components of each sample.
+         * @param[in] aux_data_columns The entries of the auxiliary data of
+         *   each sample that should be sent along with the sample, and the
+         *   types as which they should be sent.
+         * @param[in] batch_size The number of samples sent together as one
+         *   frame.
+         * @param[in] compression How frames are compressed.
+         * @param[in] max_pending_batches The number of batches that can be
+         *   waiting to be sent.
+         * @param[in] queue_full_policy What to do if a batch is complete
+         *   but `max_pending_batches` batches are already waiting.
+         */
+        NetworkOutput (const std::string                          &host,
+                       const std::uint16_t                         port,
+                       const std::size_t                           dimension,
+                       const std::vector<ChainFileFormat::Column> &aux_data_columns = {},
+                       const std::size_t                           batch_size = 1024,
+                       const NetworkStream::Compression            compression = NetworkStream::Compression::delta_zero_run,
+                       const std::size_t                           max_pending_batches = 16,
+                       const QueueFullPolicy                       queue_full_policy = QueueFullPolicy::block);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed and sent, and
+         * then closes the connection, which tells the receiving side that
+         * no more samples will follow.
+         */
+        virtual ~NetworkOutput ();
+
+        /**
+         * Process one sample by adding it, and the selected entries of its
+         * auxiliary data, to the current batch, and hand the batch to the
+         * sending thread if it is complete.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Finish processing all samples this object has received, as
+         * documented in Consumer::flush(). This also hands the current,
+         * partially filled batch to the sending thread, and waits for all
+         * batches to be sent.
+         */
+        virtual
+        void
+        flush () override;
+
+        /**
+         * Return the number of samples that were discarded rather than
+         * sent, either because of QueueFullPolicy::drop_oldest or because
+         * the receiving side closed the connection.
+         */
+        std::uint64_t
+        n_dropped_samples () const;
+
+        /**
+         * Return the number of bytes sent over the connection so far. Compared
+         * to the number of samples sent, this shows how well frames are
+         * compressed.
+         */
+        std::uint64_t
+        n_bytes_sent () const;
+
+      private:
+        /**
+         * A batch of records waiting to be sent.
+         */
+        struct Batch
+        {
+          std::vector<char> records;
+          std::size_t       n_records = 0;
+        };
+
+        /**
+         * A mutex used to make sure that only one thread at a time adds
+         * records to the current batch.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The header that describes the records.
+         */
+        const ChainFileFormat::Header header;
+
+        /**
+         * The number of samples per batch, how batches are compressed, and
+         * what to do if too many batches are waiting to be sent.
+         */
+        const std::size_t                batch_size;
+        const NetworkStream::Compression compression;
+        const QueueFullPolicy            queue_full_policy;
+
+        /**
+         * The socket of the connection.
+         */
+        const int socket;
+
+        /**
+         * The batch that is currently being filled.
+         */
+        Batch current_batch;
+
+        /**
+         * The batches that are complete and waiting to be sent.
+         */
+        BoundedQueue<Batch> pending_batches;
+
+        /**
+         * A mutex and condition variables with which the sending thread
+         * waits for batches, and threads that have completed a batch wait
+         * for room in the queue or for all batches to have been sent. The
+         * counters track how many batches have been handed to the sending
+         * thread and how many it has dealt with.
+         */
+        std::mutex              sender_mutex;
+        std::condition_variable batch_available;
+        std::condition_variable batch_done;
+        std::uint64_t           n_batches_handed_off;
+        std::uint64_t           n_batches_done;
+        bool                    shutting_down;
+
+        /**
+         * Whether the connection is still usable.
+         */
+        std::atomic<bool> connection_is_open;
+
+        /**
+         * The statistics reported by n_dropped_samples() and n_bytes_sent().
+         */
+        std::atomic<std::uint64_t> dropped_samples;
+        std::atomic<std::uint64_t> bytes_sent;
+
+        /**
+         * The thread that compresses and sends batches.
+         */
+        std::thread sender;
+
+        /**
+         * Hand the current batch to the sending thread, and start a new one.
+         * The caller needs to hold `mutex`.
+         */
+        void
+        hand_off_batch ();
+
+        /**
+         * The function run by the sending thread.
+         */
+        void
+        sender_loop ();
+
+        /**
+         * Return the header that describes the records sent.
+         */
+        static
+        ChainFileFormat::Header
+        create_header (const std::size_t                           dimension,
+                       const std::vector<ChainFileFormat::Column> &aux_data_columns);
+    };
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    NetworkOutput<InputType>::
+    NetworkOutput (const std::string                          &host,
+                   const std::uint16_t                         port,
+                   const std::size_t                           dimension,
+                   const std::vector<ChainFileFormat::Column> &aux_data_columns,
+                   const std::size_t                           batch_size,
+                   const NetworkStream::Compression            compression,
+                   const std::size_t                           max_pending_batches,
+                   const QueueFullPolicy                       queue_full_policy)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      header (create_header (dimension, aux_data_columns)),
+      batch_size (batch_size),
+      compression (compression),
+      queue_full_policy (queue_full_policy),
+      socket (NetworkStream::connect_to (host, port)),
+      pending_batches (max_pending_batches),
+      n_batches_handed_off (0),
+      n_batches_done (0),
+      shutting_down (false),
+      connection_is_open (true),
+      dropped_samples (0),
+      bytes_sent (0)
+    {
+      assert (batch_size > 0);
+
+      // Tell the other side what we are going to send, then start the thread
+      // that sends batches:
+      const std::vector<char> preamble = NetworkStream::encode_preamble (header);
+      connection_is_open = NetworkStream::send_all (socket, preamble);
+      bytes_sent += preamble.size();
+
+      current_batch.records.reserve (batch_size * header.record_size());
+      sender = std::thread ([this]()
+      {
+        sender_loop ();
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    NetworkOutput<InputType>::
+    ~NetworkOutput ()
+    {
+      this->disconnect_and_flush();
+
+      {
+        std::lock_guard<std::mutex> lock (sender_mutex);
+        shutting_down = true;
+      }
+      batch_available.notify_all();
+      sender.join();
+
+      close (socket);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    NetworkOutput<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      const std::size_t position = current_batch.records.size();
+      current_batch.records.resize (position + header.record_size());
+      ChainFileFormat::write_record (sample, aux_data, header,
+                                     current_batch.records.data() + position);
+      ++current_batch.n_records;
+
+      if (current_batch.n_records == batch_size)
+        hand_off_batch ();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    NetworkOutput<InputType>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (current_batch.n_records > 0)
+          hand_off_batch ();
+      }
+
+      std::unique_lock<std::mutex> lock (sender_mutex);
+      batch_done.wait (lock, [this]()
+      {
+        return (n_batches_done == n_batches_handed_off);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::uint64_t
+    NetworkOutput<InputType>::
+    n_dropped_samples () const
+    {
+      return dropped_samples.load();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::uint64_t
+    NetworkOutput<InputType>::
+    n_bytes_sent () const
+    {
+      return bytes_sent.load();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    NetworkOutput<InputType>::
+    hand_off_batch ()
+    {
+      // If there is no one to send the batch to, don't bother:
+      if (connection_is_open.load() == false)
+        {
+          dropped_samples += current_batch.n_records;
+          current_batch.records.clear();
+          current_batch.n_records = 0;
+          return;
+        }
+
+      Batch batch = std::move (current_batch);
+      current_batch = Batch();
+      current_batch.records.reserve (batch_size * header.record_size());
+
+      // Put the batch into the queue. We do this while holding the lock the
+      // sending thread holds while checking whether the queue is empty, so
+      // that it cannot miss the batch:
+      bool dropped_a_batch = false;
+      {
+        std::unique_lock<std::mutex> lock (sender_mutex);
+        ++n_batches_handed_off;
+
+        if (pending_batches.try_push (batch) == false)
+          {
+            if (queue_full_policy == QueueFullPolicy::drop_oldest)
+              {
+                // Throw away the oldest batch still waiting:
+                while (pending_batches.try_push (batch) == false)
+                  if (const std::optional<Batch> dropped = pending_batches.try_pop())
+                    {
+                      dropped_samples += dropped->n_records;
+                      ++n_batches_done;
+                      dropped_a_batch = true;
+                    }
+              }
+            else
+              // Wait until the sending thread has taken a batch out of the
+              // queue:
+              batch_done.wait (lock, [&]()
+            {
+              return pending_batches.try_push (batch);
+            });
+          }
+      }
+
+      batch_available.notify_one();
+      if (dropped_a_batch)
+        batch_done.notify_all();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    NetworkOutput<InputType>::
+    sender_loop ()
+    {
+      while (true)
+        {
+          std::optional<Batch> batch;
+          {
+            std::unique_lock<std::mutex> lock (sender_mutex);
+            batch_available.wait (lock, [&]()
+            {
+              batch = pending_batches.try_pop();
+              return (batch.has_value() || shutting_down);
+            });
+          }
+          if (batch.has_value() == false)
+            return;
+
+          // There is now room in the queue again; let waiting threads know:
+          batch_done.notify_all();
+
+          // Compress and send the batch without holding a lock:
+          if (connection_is_open.load() == true)
+            {
+              const std::vector<char> frame
+                = NetworkStream::encode_frame (batch->records, header.record_size(),
+                                               compression);
+              if (NetworkStream::send_all (socket, frame) == true)
+                bytes_sent += frame.size();
+              else
+                {
+                  connection_is_open = false;
+                  dropped_samples += batch->n_records;
+                }
+            }
+          else
+            dropped_samples += batch->n_records;
+
+          {
+            std::lock_guard<std::mutex> lock (sender_mutex);
+            ++n_batches_done;
+          }
+          batch_done.notify_all();
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    ChainFileFormat::Header
+    NetworkOutput<InputType>::
+    create_header (const std::size_t                           dimension,
+                   const std::vector<ChainFileFormat::Column> &aux_data_columns)
+    {
+      ChainFileFormat::Header header;
+      header.scalar_kind = ChainFileFormat::scalar_kind<scalar_type>();
+      header.scalar_size = sizeof(scalar_type);
+      header.dimension   = dimension;
+      header.columns     = aux_data_columns;
+      return header;
+    }
+  }
+}
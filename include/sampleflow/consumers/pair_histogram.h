@@ -16,12 +16,15 @@
 #ifndef SAMPLEFLOW_CONSUMERS_PAIR_PairHistogram_H
 #define SAMPLEFLOW_CONSUMERS_PAIR_PairHistogram_H
 
+#include <sampleflow/compact_counts.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/serialization.h>
 #include <sampleflow/types.h>
 
 #include <eigen3/Eigen/Dense>
 
 #include <mutex>
+#include <span>
 #include <type_traits>
 #include <vector>
 #include <array>
@@ -30,6 +30,15 @@ namespace SampleFlow
      * components are integer-valued, then the intervals should be chosen
      * to be from $n-0.5$ to $n+0.5$ for integers $n$.
      *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples).
+     * If samples carry weights (see AuxiliaryData::sample_weight), then the
+     * class also adds up the weights of the samples in each bin; these
+     * can be obtained via get_weighted(), whereas get() and write_gnuplot()
+     * continue to report the number of samples in each bin.
+     *
      *
      * ### Threading model ###
      *
@@ -82,6 +91,13 @@ namespace SampleFlow
          */
         using value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,types::sample_index>>;
 
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as `value_type`, except that the third element of each bin is
+         * the sum of the weights of the samples in the bin.
+         */
+        using weighted_value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,double>>;
+
         /**
          * Constructor for a PairHistogram that is equally spaced in real space.
          *
@@ -144,7 +160,9 @@ namespace SampleFlow
          * @param[in] f_x The function used in the transformation of the first
          *   coordinate. For this set up of bins to make sense, `f_x` needs to be
          *   a strictly monotonically increasing function on the range
-         *   `[min_x_pre_values,max_x_pre_values]`.
+         *   `[min_x_pre_values,max_x_pre_values]`. It can be any function
+         *   object that takes and returns a `double`; it is only called in
+         *   this constructor.
          * @param[in] min_y_pre_value Like `min_x_pre_value`,
          *   but for the second coordinate axis.
          * @param[in] max_y_pre_value Like `max_x_pre_value`,
@@ -152,14 +170,17 @@ namespace SampleFlow
          * @param[in] n_y_bins Like `n_x_bins`, but for the second coordinate axis.
          * @param[in] f_y Like `f_x`, but for the second coordinate axis.
          */
+        template <typename TransformationX, typename TransformationY>
+        requires (std::is_invocable_r_v<double,const TransformationX &,double> &&
+                  std::is_invocable_r_v<double,const TransformationY &,double>)
         PairHistogram (const double min_x_pre_value,
                        const double max_x_pre_value,
                        const unsigned int n_x_bins,
-                       const std::function<double (const double)> &f_x,
+                       const TransformationX &f_x,
                        const double min_y_pre_value,
                        const double max_y_pre_value,
                        const unsigned int n_y_bins,
-                       const std::function<double (const double)> &f_y);
+                       const TransformationY &f_y);
 
         /**
          * Copy constructor.
@@ -180,8 +201,9 @@ namespace SampleFlow
          *
          * @param[in] sample The sample to process.
          * @param[in] aux_data Auxiliary data about this sample. The current
-         *   class does not know what to do with any such data and consequently
-         *   simply ignores it.
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
          */
         virtual
         void
@@ -196,6 +218,17 @@ namespace SampleFlow
         value_type
         get () const;
 
+        /**
+         * Return the PairHistogram in the format discussed in the
+         * documentation of the `weighted_value_type` type, i.e., with the
+         * sum of the weights of the samples in each bin rather than their
+         * number.
+         *
+         * @return The weighted PairHistogram.
+         */
+        weighted_value_type
+        get_weighted () const;
+
         /**
          * Write the PairHistogram into a file in such a way that it can
          * be visualized using the Gnuplot program. Internally, this function
@@ -222,6 +255,42 @@ namespace SampleFlow
         void
         write_gnuplot (std::ostream &&output_stream) const;
 
+        /**
+         * Append the break points of the bins in both coordinate directions,
+         * along with the numbers and weights of samples counted in each bin
+         * so far, to the given buffer. See the section on saving and
+         * combining the state of consumers in the documentation of the
+         * Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the counts stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The object that wrote the
+         * data must have used the same bins as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another object has
+         * counted in each bin to the ones counted by the current object. Both
+         * objects need to use the same bins.
+         */
+        void
+        merge (const PairHistogram &other);
+
+        /**
+         * Return the memory used by the bins of this object, which is
+         * proportional to the product of the numbers of bins in the two
+         * directions.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
       private:
         /**
          * A mutex used to lock access to all member variables when running
@@ -238,10 +307,20 @@ namespace SampleFlow
         std::vector<double> y_interval_points;
 
         /**
-         * A vector storing the number of samples so far encountered in each
-         * of the bins of the PairHistogram.
+         * An array storing the number of samples so far encountered in each
+         * of the bins of the PairHistogram. The number of samples in bin
+         * `(x_bin,y_bin)` is stored at index `x_bin*n_y_bins+y_bin`, using
+         * 32-bit counters that are moved to a separate table of 64-bit
+         * counters in the rare case where they exceed this range (see the
+         * CompactCounts class).
          */
-        Eigen::Matrix<types::sample_index,Eigen::Dynamic,Eigen::Dynamic> bins;
+        CompactCounts<> bins;
+
+        /**
+         * A matrix storing the sum of the weights of the samples so far
+         * encountered in each of the bins of the PairHistogram.
+         */
+        Eigen::MatrixXd bin_weights;
 
         /**
          * For a given `value`, compute the number of the bin it lies
@@ -275,7 +354,8 @@ namespace SampleFlow
                                        static_cast<int>(ParallelMode::asynchronous))),
       x_interval_points(n_x_bins+1),
       y_interval_points(n_y_bins+1),
-      bins (n_x_bins, n_y_bins)
+      bins (n_x_bins * n_y_bins),
+      bin_weights (Eigen::MatrixXd::Zero(n_x_bins, n_y_bins))
     {
       // First treat the subdivision of the x-axis:
       {
@@ -308,22 +388,26 @@ namespace SampleFlow
     requires (Concepts::has_subscript_operator<InputType> &&
               Concepts::has_size_function<InputType> &&
               std::is_arithmetic_v<types::ScalarType<InputType>>)
+    template <typename TransformationX, typename TransformationY>
+    requires (std::is_invocable_r_v<double,const TransformationX &,double> &&
+              std::is_invocable_r_v<double,const TransformationY &,double>)
     PairHistogram<InputType>::
     PairHistogram (const double min_x_pre_value,
                    const double max_x_pre_value,
                    const unsigned int n_x_bins,
-                   const std::function<double (const double)> &f_x,
+                   const TransformationX &f_x,
                    const double min_y_pre_value,
                    const double max_y_pre_value,
                    const unsigned int n_y_bins,
-                   const std::function<double (const double)> &f_y)
+                   const TransformationY &f_y)
       :
       Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
                                        |
                                        static_cast<int>(ParallelMode::asynchronous))),
       x_interval_points(n_x_bins+1),
       y_interval_points(n_y_bins+1),
-      bins (n_x_bins, n_y_bins)
+      bins (n_x_bins * n_y_bins),
+      bin_weights (Eigen::MatrixXd::Zero(n_x_bins, n_y_bins))
     {
       // Treat the x-axis subdivision:
       {
@@ -378,7 +462,8 @@ namespace SampleFlow
                                        static_cast<int>(ParallelMode::asynchronous))),
       x_interval_points(o.x_interval_points),
       y_interval_points(o.y_interval_points),
-      bins (o.bins)
+      bins (o.bins),
+      bin_weights (o.bin_weights)
     {}
 
 
@@ -401,7 +486,7 @@ namespace SampleFlow
               std::is_arithmetic_v<types::ScalarType<InputType>>)
     void
     PairHistogram<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    consume (InputType sample, AuxiliaryData aux_data)
     {
       assert (sample.size() == 2);
 
@@ -415,13 +500,16 @@ namespace SampleFlow
       const unsigned int x_bin = x_bin_number(sample[0]);
       const unsigned int y_bin = y_bin_number(sample[1]);
 
-      if (x_bin >= 0  &&  x_bin < bins.rows()
+      const unsigned int n_x_bins = x_interval_points.size()-1;
+      const unsigned int n_y_bins = y_interval_points.size()-1;
+      if (x_bin >= 0  &&  x_bin < n_x_bins
           &&
-          y_bin >= 0  &&  y_bin < bins.cols())
+          y_bin >= 0  &&  y_bin < n_y_bins)
         {
-          std::lock_guard<std::mutex> lock(mutex);
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
 
-          ++bins(x_bin,y_bin);
+          bins.add (x_bin*n_y_bins + y_bin, aux_data.n_repetitions());
+          bin_weights(x_bin,y_bin) += aux_data.n_repetitions() * aux_data.weight();
         }
     }
 
@@ -439,12 +527,14 @@ namespace SampleFlow
       // this without holding the lock since we're not accessing
       // information that is subject to change when a new sample
       // comes in.
-      value_type return_value (bins.rows() * bins.cols());
+      const unsigned int n_x_bins = x_interval_points.size()-1;
+      const unsigned int n_y_bins = y_interval_points.size()-1;
+      value_type return_value (n_x_bins * n_y_bins);
 
-      for (unsigned int x_bin=0; x_bin<bins.rows(); ++x_bin)
-        for (unsigned int y_bin=0; y_bin<bins.cols(); ++y_bin)
+      for (unsigned int x_bin=0; x_bin<n_x_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_y_bins; ++y_bin)
           {
-            const unsigned int bin = x_bin * bins.cols() + y_bin;
+            const unsigned int bin = x_bin * n_y_bins + y_bin;
             std::get<0>(return_value[bin]) = {x_interval_points[x_bin], y_interval_points[y_bin]};
             std::get<1>(return_value[bin]) = {x_interval_points[x_bin+1], y_interval_points[y_bin+1]};
           }
@@ -452,11 +542,40 @@ namespace SampleFlow
       // Now fill the bin sizes under a lock as they are subject to
       // change from other threads:
       std::lock_guard<std::mutex> lock(mutex);
-      for (unsigned int x_bin=0; x_bin<bins.rows(); ++x_bin)
-        for (unsigned int y_bin=0; y_bin<bins.cols(); ++y_bin)
+      for (unsigned int bin=0; bin<n_x_bins*n_y_bins; ++bin)
+        std::get<2>(return_value[bin]) = bins[bin];
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename PairHistogram<InputType>::weighted_value_type
+    PairHistogram<InputType>::
+    get_weighted () const
+    {
+      const unsigned int n_x_bins = x_interval_points.size()-1;
+      const unsigned int n_y_bins = y_interval_points.size()-1;
+      weighted_value_type return_value (n_x_bins * n_y_bins);
+
+      for (unsigned int x_bin=0; x_bin<n_x_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_y_bins; ++y_bin)
+          {
+            const unsigned int bin = x_bin * n_y_bins + y_bin;
+            std::get<0>(return_value[bin]) = {x_interval_points[x_bin], y_interval_points[y_bin]};
+            std::get<1>(return_value[bin]) = {x_interval_points[x_bin+1], y_interval_points[y_bin+1]};
+          }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (unsigned int x_bin=0; x_bin<n_x_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_y_bins; ++y_bin)
           {
-            const unsigned int bin = x_bin * bins.cols() + y_bin;
-            std::get<2>(return_value[bin]) = bins(x_bin,y_bin);
+            const unsigned int bin = x_bin * n_y_bins + y_bin;
+            std::get<2>(return_value[bin]) = bin_weights(x_bin,y_bin);
           }
 
       return return_value;
@@ -598,5 +717,117 @@ namespace SampleFlow
       else
         return (p-y_interval_points.begin()-1);
     }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    PairHistogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      Serialization::write (buffer, x_interval_points);
+      Serialization::write (buffer, y_interval_points);
+
+      // Write the numbers of samples as a matrix, as we did before they
+      // were stored in a CompactCounts object:
+      const unsigned int n_x_bins = x_interval_points.size()-1;
+      const unsigned int n_y_bins = y_interval_points.size()-1;
+      Eigen::Matrix<types::sample_index,Eigen::Dynamic,Eigen::Dynamic> bin_counts (n_x_bins, n_y_bins);
+      for (unsigned int x_bin=0; x_bin<n_x_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_y_bins; ++y_bin)
+          bin_counts(x_bin,y_bin) = bins[x_bin*n_y_bins + y_bin];
+      Serialization::write (buffer, bin_counts);
+      Serialization::write (buffer, bin_weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    PairHistogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::vector<double> saved_x_interval_points;
+      std::vector<double> saved_y_interval_points;
+      Serialization::read (buffer, saved_x_interval_points);
+      Serialization::read (buffer, saved_y_interval_points);
+      assert (saved_x_interval_points == x_interval_points);
+      assert (saved_y_interval_points == y_interval_points);
+
+      Eigen::Matrix<types::sample_index,Eigen::Dynamic,Eigen::Dynamic> bin_counts;
+      Serialization::read (buffer, bin_counts);
+      const unsigned int n_x_bins = x_interval_points.size()-1;
+      const unsigned int n_y_bins = y_interval_points.size()-1;
+      assert (bin_counts.rows() == static_cast<long>(n_x_bins));
+      assert (bin_counts.cols() == static_cast<long>(n_y_bins));
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      bins = CompactCounts<> (n_x_bins * n_y_bins);
+      for (unsigned int x_bin=0; x_bin<n_x_bins; ++x_bin)
+        for (unsigned int y_bin=0; y_bin<n_y_bins; ++y_bin)
+          bins.add (x_bin*n_y_bins + y_bin, bin_counts(x_bin,y_bin));
+
+      Serialization::read (buffer, bin_weights);
+      assert (bin_weights.rows() == static_cast<long>(n_x_bins));
+      assert (bin_weights.cols() == static_cast<long>(n_y_bins));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    PairHistogram<InputType>::
+    merge (const PairHistogram &other)
+    {
+      assert (other.x_interval_points == x_interval_points);
+      assert (other.y_interval_points == y_interval_points);
+
+      // Copy the other object's counts first so that we never hold
+      // both locks at the same time:
+      CompactCounts<> other_bins;
+      Eigen::MatrixXd other_bin_weights;
+      {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        other_bins        = other.bins;
+        other_bin_weights = other.bin_weights;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      bins.merge (other_bins);
+      bin_weights += other_bin_weights;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    PairHistogram<InputType>::
+    memory_consumption () const
+    {
+      // The sizes of the interval points and the weights are set in the
+      // constructor and never change, but the table of overflowed
+      // counters in `bins` may grow:
+      std::lock_guard<std::mutex> lock(mutex);
+      return (Memory::memory_consumption (x_interval_points)
+              + Memory::memory_consumption (y_interval_points)
+              + Memory::memory_consumption (bins)
+              + Memory::memory_consumption (bin_weights));
+    }
+
   }
 }
@@ -0,0 +1,44 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_CONSUMERS_POSTERIOR_PREDICTIVE_H
+#define SAMPLEFLOW_CONSUMERS_POSTERIOR_PREDICTIVE_H
+
+#include <sampleflow/concepts.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/consumers/quantiles.h>
+#include <sampleflow/filter.h>
+#include <sampleflow/sample_shape.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/types.h>
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/consumers/posterior_predictive.impl.h>
+
+#endif
@@ -0,0 +1,627 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A class that computes the posterior predictive distribution of a
+     * quantity of interest. For every $n$th sample $x_k$ it receives, it
+     * evaluates a user-provided "forward model" $y_k=f(x_k)$ -- say, the
+     * solution of a partial differential equation at a few measurement
+     * points for the parameters $x_k$ -- and accumulates the mean value,
+     * the (co)variance, and quantiles of the predictions $y_k$ using
+     * MeanValue, CovarianceMatrix, and Quantiles objects.
+     *
+     * Forward models are typically far more expensive than the
+     * likelihood evaluations of the sampler (or, at least, are not
+     * needed for every sample), and if they were evaluated in consume()
+     * on the thread that runs the chain, they would hold up the chain.
+     * This class therefore only stores the samples it keeps in consume()
+     * and evaluates the forward model on a ThreadPool: Samples are
+     * collected into batches of a given size, and every full batch is
+     * handed to the pool as one task. The forward model can be provided
+     * in one of two forms:
+     * - As a function that computes the prediction for one sample. Each
+     *   task then calls this function for all samples of its batch in
+     *   turn. A batch size of one makes each sample a task of its own,
+     *   which balances the load best if the forward model is expensive.
+     * - As a function that computes the predictions for a whole batch of
+     *   samples at once. This is useful if the forward model can be
+     *   evaluated more efficiently for many samples together, for example
+     *   because it uses vectorized code or an accelerator.
+     *
+     * The thread of the chain that sends a sample therefore only pays for
+     * copying the sample into the current batch and, once per batch, for
+     * enqueuing a task. The number of samples that have been kept but
+     * whose predictions have not been computed yet is bounded by a given
+     * queue size: If the forward model is so slow that the pool can not
+     * keep up, consume() waits for the pool to catch up rather than
+     * accumulating ever more samples.
+     *
+     * Every prediction is sent on, together with the auxiliary data of
+     * the sample it was computed from, to the consumers connected to the
+     * current object, which is therefore a Filter from `InputType` to
+     * `PredictionType`. The statistics this class provides are computed
+     * by consumers of this kind that the current object owns, but other
+     * consumers can be attached as well, for example a Histogram of the
+     * predictions. The predictions are sent on in the order in which
+     * their tasks finish, not in the order of the samples, and possibly
+     * from several threads at once.
+     *
+     * Like Filters::TakeEveryNth, this class counts a sample whose
+     * auxiliary data has an AuxiliaryData::repetition_count entry as that
+     * many consecutive copies of the sample, and keeps the sample if one
+     * of these copies is an $n$th sample; the forward model is then only
+     * evaluated once for the sample, and the prediction is sent on with
+     * the number of copies kept as its repetition count.
+     *
+     * The flush() function dispatches the samples of an incomplete batch
+     * and waits for all predictions to be computed. Producers call it
+     * when they are done sampling, and so the statistics this class
+     * provides are complete when, for example, the
+     * Producers::MetropolisHastings::sample() function returns. While
+     * samples are still arriving, they reflect the predictions computed
+     * so far.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The consume() function of this class can be called concurrently
+     * from several threads. The forward model is called concurrently on
+     * the threads of the thread pool, and must therefore be thread-safe.
+     * Consumers connected to the current object receive the predictions
+     * on the threads of the pool, possibly concurrently.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$.
+     * @tparam PredictionType The C++ type used for the predictions
+     *   $y_k$. It needs to be a vector space type whose elements are
+     *   arithmetic types, so that its mean value, covariance matrix, and
+     *   quantiles can be computed.
+     */
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    class PosteriorPredictive : public Filter<InputType, PredictionType>
+    {
+      public:
+        /**
+         * The type of a function that computes the prediction for one
+         * sample.
+         */
+        using ForwardModel = std::function<PredictionType (const InputType &)>;
+
+        /**
+         * The type of a function that computes the predictions for a batch
+         * of samples. The function is given the samples as its first
+         * argument, and needs to write the predictions into the elements of
+         * the second argument, which is of the same size.
+         */
+        using BatchForwardModel
+          = std::function<void (std::span<const InputType>, std::span<PredictionType>)>;
+
+        /**
+         * Constructor for a forward model that computes the prediction for
+         * one sample at a time.
+         *
+         * @param[in] forward_model The function that computes the
+         *   prediction for a sample.
+         * @param[in] every_nth The distance between samples for which the
+         *   forward model is to be evaluated.
+         * @param[in] batch_size The number of samples that are evaluated by
+         *   one task of the thread pool.
+         * @param[in] queue_size The maximal number of samples that have
+         *   been kept but not been evaluated yet. It must be at least as
+         *   large as `batch_size`.
+         * @param[in] thread_pool The pool on which the forward model is to
+         *   be evaluated. If this is a `nullptr`, then
+         *   ThreadPool::default_pool() is used.
+         */
+        PosteriorPredictive (const ForwardModel                &forward_model,
+                             const types::sample_index          every_nth = 1,
+                             const std::size_t                  batch_size = 1,
+                             const std::size_t                  queue_size = 1024,
+                             const std::shared_ptr<ThreadPool> &thread_pool = nullptr);
+
+        /**
+         * Constructor for a forward model that computes the predictions for
+         * a whole batch of samples at once. The arguments are as for the
+         * other constructor. The last batch passed to `forward_model` may
+         * contain fewer than `batch_size` samples.
+         */
+        PosteriorPredictive (const BatchForwardModel           &forward_model,
+                             const types::sample_index          every_nth = 1,
+                             const std::size_t                  batch_size = 64,
+                             const std::size_t                  queue_size = 1024,
+                             const std::shared_ptr<ThreadPool> &thread_pool = nullptr);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed, including
+         * the evaluation of their predictions. To this end, it calls the
+         * Consumers::disconnect_and_flush() function of the base class.
+         */
+        virtual ~PosteriorPredictive ();
+
+        /**
+         * Process one sample: If it is an $n$th sample, store it in the
+         * current batch and, if the batch is full, hand the batch to the
+         * thread pool. The predictions are sent downstream by the task
+         * that computes them, and this function therefore always returns
+         * an empty object.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. It is
+         *   passed on with the prediction computed from the sample.
+         *
+         * @return An empty object.
+         */
+        virtual
+        std::optional<std::pair<PredictionType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Hand the samples of the current, incomplete batch to the thread
+         * pool, wait for all predictions to have been computed and sent
+         * downstream, and then flush the consumers connected to the
+         * current object.
+         */
+        virtual
+        void
+        flush () override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::repetition_count.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return a description of the predictions this object sends on if
+         * it receives samples described by the argument: One for about
+         * every $n$th of them. The number of components of the predictions
+         * is not known.
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return the number of predictions computed so far, counting
+         * repeated samples as often as they were kept.
+         */
+        types::sample_index
+        n_predictions () const;
+
+        /**
+         * Return the mean value of the predictions computed so far. See
+         * MeanValue::get().
+         */
+        typename MeanValue<PredictionType>::value_type
+        get_mean () const;
+
+        /**
+         * Return the covariance matrix of the predictions computed so far.
+         * See CovarianceMatrix::get().
+         */
+        typename CovarianceMatrix<PredictionType>::value_type
+        get_covariance () const;
+
+        /**
+         * Return the variances of the components of the predictions
+         * computed so far, i.e., the diagonal of the matrix returned by
+         * get_covariance().
+         */
+        std::vector<double>
+        get_variance () const;
+
+        /**
+         * Return the $q$-quantiles of the components of the predictions
+         * computed so far. See Quantiles::get().
+         */
+        std::vector<typename Quantiles<PredictionType>::value_type>
+        get_quantiles (const std::vector<double> &qs) const;
+
+      private:
+        /**
+         * The function that computes predictions for a batch of samples.
+         * If the object was created with a function for one sample, then
+         * this is a function that calls that function for every sample of
+         * the batch.
+         */
+        const BatchForwardModel forward_model;
+
+        /**
+         * The distance between samples for which predictions are computed.
+         */
+        const types::sample_index every_nth;
+
+        /**
+         * The number of samples that make up a batch.
+         */
+        const std::size_t batch_size;
+
+        /**
+         * The maximal number of samples kept but not yet evaluated.
+         */
+        const std::size_t queue_size;
+
+        /**
+         * The pool on which the forward model is evaluated.
+         */
+        const std::shared_ptr<ThreadPool> thread_pool;
+
+        /**
+         * A mutex that guards the following variables.
+         */
+        std::mutex mutex;
+
+        /**
+         * The number of (expanded) samples seen so far.
+         */
+        types::sample_index counter;
+
+        /**
+         * The samples of the current batch, and their auxiliary data.
+         */
+        std::vector<InputType>     batch_samples;
+        std::vector<AuxiliaryData> batch_aux_data;
+
+        /**
+         * The number of samples kept but whose predictions have not been
+         * sent on yet, including the ones in the current batch.
+         */
+        std::size_t n_pending;
+
+        /**
+         * The number of predictions sent on so far, counting repeated
+         * samples as often as they were kept.
+         */
+        std::atomic<types::sample_index> n_predictions_computed;
+
+        /**
+         * A condition variable used to wake up threads waiting in
+         * filter() for `n_pending` to drop below `queue_size`.
+         */
+        std::condition_variable slot_available;
+
+        /**
+         * The tasks evaluating batches of samples.
+         */
+        ThreadPool::TaskGroup background_tasks;
+
+        /**
+         * The consumers that compute the statistics of the predictions.
+         * They are connected to the current object.
+         */
+        MeanValue<PredictionType>        mean_value;
+        CovarianceMatrix<PredictionType> covariance_matrix;
+        Quantiles<PredictionType>        quantiles;
+
+        /**
+         * Hand the current batch to the thread pool. The caller must hold
+         * the lock on `mutex`.
+         */
+        void
+        dispatch_batch ();
+    };
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    PosteriorPredictive<InputType,PredictionType>::
+    PosteriorPredictive (const ForwardModel                &forward_model,
+                         const types::sample_index          every_nth,
+                         const std::size_t                  batch_size,
+                         const std::size_t                  queue_size,
+                         const std::shared_ptr<ThreadPool> &thread_pool)
+      :
+      PosteriorPredictive ([forward_model](std::span<const InputType> samples,
+                                           std::span<PredictionType>  predictions)
+    {
+      for (std::size_t i=0; i<samples.size(); ++i)
+        predictions[i] = forward_model (samples[i]);
+    },
+    every_nth, batch_size, queue_size, thread_pool)
+    {}
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    PosteriorPredictive<InputType,PredictionType>::
+    PosteriorPredictive (const BatchForwardModel           &forward_model,
+                         const types::sample_index          every_nth,
+                         const std::size_t                  batch_size,
+                         const std::size_t                  queue_size,
+                         const std::shared_ptr<ThreadPool> &thread_pool)
+      :
+      forward_model (forward_model),
+      every_nth (every_nth),
+      batch_size (batch_size),
+      queue_size (queue_size),
+      thread_pool (thread_pool != nullptr ? thread_pool : ThreadPool::default_pool()),
+      counter (0),
+      n_pending (0),
+      n_predictions_computed (0)
+    {
+      assert (every_nth >= 1);
+      assert (batch_size >= 1);
+      assert (queue_size >= batch_size);
+
+      batch_samples.reserve (batch_size);
+      batch_aux_data.reserve (batch_size);
+
+      mean_value.connect_to_producer (*this);
+      covariance_matrix.connect_to_producer (*this);
+      quantiles.connect_to_producer (*this);
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    PosteriorPredictive<InputType,PredictionType>::
+    ~PosteriorPredictive ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::pair<PredictionType, AuxiliaryData> >
+    PosteriorPredictive<InputType,PredictionType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      std::unique_lock<std::mutex> lock (mutex);
+
+      // The sample stands for copies number k...k+m-1 of the (expanded)
+      // sequence of samples. Determine how many of them are multiples of
+      // n, as in Filters::TakeEveryNth:
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const types::sample_index first = counter;
+      counter += n_repetitions;
+      const auto n_multiples_below = [this](const types::sample_index k)
+      {
+        return (k + every_nth - 1) / every_nth;
+      };
+      const types::sample_index n_kept
+        = n_multiples_below (first + n_repetitions) - n_multiples_below (first);
+
+      if (n_kept == 0)
+        return {};
+
+      // Wait until there is space for another sample. On a worker thread
+      // of a thread pool, we must not go to sleep since the tasks that
+      // would make space may be waiting for exactly this thread, so help
+      // with other tasks instead.
+      if (ThreadPool *const pool = ThreadPool::current_pool())
+        while (n_pending >= queue_size)
+          {
+            lock.unlock();
+            if (pool->run_pending_task() == false)
+              std::this_thread::yield();
+            lock.lock();
+          }
+      else
+        slot_available.wait (lock, [this]()
+      {
+        return (n_pending < queue_size);
+      });
+
+      if (n_repetitions != 1)
+        aux_data[AuxiliaryData::repetition_count] = std::size_t(n_kept);
+
+      batch_samples.emplace_back (std::move(sample));
+      batch_aux_data.emplace_back (std::move(aux_data));
+      ++n_pending;
+
+      if (batch_samples.size() == batch_size)
+        dispatch_batch ();
+
+      return {};
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    PosteriorPredictive<InputType,PredictionType>::
+    dispatch_batch ()
+    {
+      std::vector<InputType>     samples;
+      std::vector<AuxiliaryData> aux_data;
+      samples.reserve (batch_size);
+      aux_data.reserve (batch_size);
+      std::swap (samples, batch_samples);
+      std::swap (aux_data, batch_aux_data);
+
+      background_tasks.run (*thread_pool,
+                            [this,
+                             samples = std::move(samples),
+                             aux_data = std::move(aux_data)]()
+      {
+        std::vector<PredictionType> predictions (samples.size());
+        forward_model (std::span<const InputType> (samples),
+                       std::span<PredictionType> (predictions));
+
+        this->issue_batch (predictions, aux_data);
+
+        types::sample_index n_computed = 0;
+        for (const AuxiliaryData &a : aux_data)
+          n_computed += a.n_repetitions();
+        n_predictions_computed.fetch_add (n_computed);
+
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          n_pending -= samples.size();
+        }
+        slot_available.notify_all();
+      });
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    void
+    PosteriorPredictive<InputType,PredictionType>::
+    flush ()
+    {
+      // Make sure that all samples that are currently arriving have been
+      // added to a batch, then send off the last, incomplete batch and
+      // wait for the thread pool to have evaluated all batches. Each task
+      // sends its predictions downstream, and so when all tasks are done,
+      // all predictions have been sent on.
+      Consumer<InputType>::flush();
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (batch_samples.size() > 0)
+          dispatch_batch ();
+      }
+      background_tasks.wait();
+
+      this->flush_consumers();
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    PosteriorPredictive<InputType,PredictionType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    SampleShape
+    PosteriorPredictive<InputType,PredictionType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape;
+      if (input_shape.n_samples.has_value())
+        shape.n_samples = (*input_shape.n_samples + every_nth - 1) / every_nth;
+      return shape;
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    PosteriorPredictive<InputType,PredictionType>::
+    n_predictions () const
+    {
+      return n_predictions_computed.load();
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    typename MeanValue<PredictionType>::value_type
+    PosteriorPredictive<InputType,PredictionType>::
+    get_mean () const
+    {
+      return mean_value.get();
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    typename CovarianceMatrix<PredictionType>::value_type
+    PosteriorPredictive<InputType,PredictionType>::
+    get_covariance () const
+    {
+      return covariance_matrix.get();
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::vector<double>
+    PosteriorPredictive<InputType,PredictionType>::
+    get_variance () const
+    {
+      const typename CovarianceMatrix<PredictionType>::value_type
+      covariance = covariance_matrix.get();
+
+      std::vector<double> variance (covariance.rows());
+      for (std::size_t i=0; i<variance.size(); ++i)
+        variance[i] = covariance(i,i);
+      return variance;
+    }
+
+
+
+    template <typename InputType, typename PredictionType>
+    requires (Concepts::is_vector_space_type<PredictionType> &&
+              std::is_arithmetic_v<types::ScalarType<PredictionType>> &&
+              Concepts::is_owning_sampletype<InputType>)
+    std::vector<typename Quantiles<PredictionType>::value_type>
+    PosteriorPredictive<InputType,PredictionType>::
+    get_quantiles (const std::vector<double> &qs) const
+    {
+      return quantiles.get (qs);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_CONSUMERS_POTENTIAL_SCALE_REDUCTION_H
+#define SAMPLEFLOW_CONSUMERS_POTENTIAL_SCALE_REDUCTION_H
+
+#include <sampleflow/consumer.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/element_access.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/types.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/consumers/potential_scale_reduction.impl.h>
+
+#endif
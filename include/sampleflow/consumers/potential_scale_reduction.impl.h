@@ -0,0 +1,778 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the split-$\hat R$ convergence
+     * diagnostic of Gelman and Rubin (also called the "potential scale
+     * reduction factor") for each component of the samples of several
+     * chains. If the chains have all converged to the distribution they
+     * sample, then the variance of the samples within each chain equals the
+     * variance of the samples of all chains taken together, and $\hat R$ is
+     * close to one; values substantially larger than one (a common threshold
+     * is 1.01) indicate that the chains have not yet explored the same
+     * region of parameter space. Splitting each chain in half and treating
+     * the two halves as separate chains also detects chains that are still
+     * drifting.
+     *
+     * Other consumers treat the samples they receive from all of the
+     * producers they are connected to as one stream. In contrast, the
+     * current class keeps separate statistics for each chain: Samples are
+     * attributed to a chain based on the producer that sent them (each call
+     * to connect_to_producer() starts a new "source") and, within each
+     * source, based on the AuxiliaryData::chain_number entry of their
+     * auxiliary data if there is one. Samples that are passed to consume()
+     * directly are attributed to source zero. As a consequence, the class
+     * can be connected to several producers that each run one chain, to one
+     * producer that runs many chains (for example via
+     * Producers::MetropolisHastings::sample_chains()), or a combination of
+     * the two.
+     *
+     *
+     * <h3> Algorithm </h3>
+     *
+     * For each chain, the class stores the running mean and sum of squared
+     * deviations from the mean of each of a bounded number of consecutive
+     * blocks of samples: Once there are `max_n_blocks` completed blocks,
+     * adjacent blocks are combined and the block size is doubled. When
+     * $\hat R$ is requested, each chain is split at the block boundary
+     * closest to its middle, and the statistics of the blocks in each half
+     * are combined. With $m$ half-chains of average length $n$, means
+     * $\bar x_i$, and sample variances $s_i^2$, the class then computes
+     * @f{align*}{
+     *   W &= \frac 1m \sum_i s_i^2,
+     *   \qquad
+     *   \frac Bn = \frac{1}{m-1} \sum_i (\bar x_i - \bar x)^2,
+     *   \qquad
+     *   \hat R = \sqrt{\frac{\frac{n-1}{n} W + \frac Bn}{W}}
+     * @f}
+     * for each component, where $\bar x$ is the average of the $\bar x_i$.
+     * Processing a sample costs ${\cal O}(d)$ operations, where $d$ is the
+     * number of components of samples, and computing $\hat R$ costs
+     * ${\cal O}(d)$ operations per chain.
+     *
+     *
+     * <h3> Repeated and weighted samples </h3>
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is treated as if it had been received
+     * this many times in a row. The class does not support weighted samples
+     * (see AuxiliaryData::sample_weight) other than samples with weight
+     * zero, which are ignored.
+     *
+     *
+     * <h3> Threading model </h3>
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each chain has its own statistics protected by its own mutex,
+     * and so samples of different chains -- typically generated on
+     * different threads -- do not compete for a lock; only the first sample
+     * of each chain needs to briefly lock the list of chains. Because the
+     * split of each chain into halves requires samples to arrive in the
+     * order in which they were generated, and because the work per sample is
+     * small, samples are processed synchronously on the thread of the
+     * producer that sends them. For the same reason, calling
+     * set_parallel_mode() on objects of this class has no effect.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. It needs
+     *   to satisfy the same requirements as for the MeanValue class, and its
+     *   elements need to be real-valued floating point numbers.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    class PotentialScaleReduction: public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type returned by the get() function: One value of
+         * $\hat R$ per component of the samples.
+         */
+        using value_type = std::vector<double>;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] max_n_blocks The maximal number of blocks into which the
+         *   samples of each chain are grouped. Each chain is split in half at
+         *   a block boundary, and so the split is exact only up to the
+         *   $1/$`max_n_blocks`th part of the chain. Must be an even number.
+         */
+        PotentialScaleReduction (const unsigned int max_n_blocks = 32);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~PotentialScaleReduction ();
+
+        /**
+         * Connect the current object to a producer. In contrast to the
+         * function in the base class, samples of each producer are kept
+         * apart as described in the documentation of this class.
+         */
+        virtual
+        void
+        connect_to_producer (Producer<InputType> &producer) override;
+
+        /**
+         * Process one sample by adding it to the statistics of the chain it
+         * belongs to, with the chain identified by the
+         * AuxiliaryData::chain_number entry of `aux_data` (if there is one)
+         * within source zero.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the chain number, the repetition count, and the
+         *   weight of the sample. The latter must be either zero or one.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::chain_number,
+         * AuxiliaryData::repetition_count, and AuxiliaryData::sample_weight.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return the split-$\hat R$ for each component of the samples. Only
+         * chains with at least four samples are considered. If there are no
+         * such chains, all returned values are NaN. Components for which all
+         * samples of each half-chain are the same have a value of one if
+         * the half-chains all agree, and infinity otherwise.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the number of chains for which the current object has
+         * received samples (including the ones received via merge()).
+         */
+        std::size_t
+        n_chains () const;
+
+        /**
+         * Append the state of the computation to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same `max_n_blocks`.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the chains of another object to the ones of the current
+         * object. These chains are considered complete, i.e., samples the
+         * current object receives later are never attributed to them.
+         */
+        void
+        merge (const PotentialScaleReduction &other);
+
+      private:
+        /**
+         * The number of blocks at which adjacent blocks are combined.
+         */
+        const unsigned int max_n_blocks;
+
+        /**
+         * The running mean and sum of squared deviations from the mean of a
+         * set of samples.
+         */
+        struct Statistics
+        {
+          types::sample_index n_samples = 0;
+          std::vector<double> mean;
+          std::vector<double> sum_of_squares;
+
+          /**
+           * Add `n` copies of the given sample.
+           */
+          void
+          add (const std::vector<double> &sample,
+               const types::sample_index  n);
+
+          /**
+           * Combine the statistics of `other` with the ones of the current
+           * object.
+           */
+          void
+          merge (const Statistics &other);
+        };
+
+        /**
+         * The data kept for each chain: the statistics of the completed
+         * blocks of samples and of the current, incomplete one.
+         */
+        struct Chain
+        {
+          mutable std::mutex      mutex;
+          types::sample_index     block_size = 1;
+          std::vector<Statistics> blocks;
+          Statistics              current_block;
+
+          /**
+           * Add `n` copies of the given sample, combining blocks if
+           * there are `max_n_blocks` of them.
+           */
+          void
+          add (const std::vector<double> &sample,
+               const types::sample_index  n,
+               const unsigned int         max_n_blocks);
+
+          /**
+           * Compute the statistics of the two halves of the chain.
+           */
+          std::pair<Statistics,Statistics>
+          split () const;
+        };
+
+        /**
+         * A chain is identified by the number of the source (i.e., the
+         * producer) it came from and the chain number within that source.
+         */
+        using ChainKey = std::pair<std::size_t,std::size_t>;
+
+        /**
+         * A mutex that protects the list of chains and the map from chain
+         * keys to chains. It is only locked exclusively when a chain
+         * is added.
+         */
+        mutable std::shared_mutex chains_mutex;
+
+        /**
+         * The chains seen so far, and for those whose samples were sent to
+         * the current object (rather than merged from another one) the map
+         * from key to position in the list.
+         */
+        std::vector<std::unique_ptr<Chain>> chains;
+        std::map<ChainKey,std::size_t>      chain_numbers;
+
+        /**
+         * The number of sources with which to identify the next producer
+         * this object is connected to.
+         */
+        std::size_t next_source;
+
+        /**
+         * For each producer this object is connected to, a consumer that
+         * forwards samples to add_sample() with the number of the source.
+         * Since these objects hold references to the current object, they
+         * are destroyed before anything else in the destructor.
+         */
+        std::vector<std::unique_ptr<Action<InputType>>> sources;
+
+        /**
+         * Add a sample to the statistics of the chain it belongs to.
+         */
+        void
+        add_sample (const std::size_t   source,
+                    const InputType    &sample,
+                    const AuxiliaryData &aux_data);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::Statistics::
+    add (const std::vector<double> &sample,
+         const types::sample_index  n)
+    {
+      if (n_samples == 0)
+        {
+          mean.assign (sample.size(), 0.);
+          sum_of_squares.assign (sample.size(), 0.);
+        }
+
+      const types::sample_index previous_n_samples = n_samples;
+      n_samples += n;
+      const double factor = 1. * n / n_samples;
+      const double square_factor = 1. * previous_n_samples * n / n_samples;
+      for (unsigned int j=0; j<sample.size(); ++j)
+        {
+          const double delta = sample[j] - mean[j];
+          mean[j] += delta * factor;
+          sum_of_squares[j] += delta * delta * square_factor;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::Statistics::
+    merge (const Statistics &other)
+    {
+      if (other.n_samples == 0)
+        return;
+      if (n_samples == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      const types::sample_index previous_n_samples = n_samples;
+      n_samples += other.n_samples;
+      const double factor = 1. * other.n_samples / n_samples;
+      const double square_factor = 1. * previous_n_samples * other.n_samples / n_samples;
+      for (unsigned int j=0; j<mean.size(); ++j)
+        {
+          const double delta = other.mean[j] - mean[j];
+          mean[j] += delta * factor;
+          sum_of_squares[j] += other.sum_of_squares[j] + delta * delta * square_factor;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::Chain::
+    add (const std::vector<double> &sample,
+         const types::sample_index  n,
+         const unsigned int         max_n_blocks)
+    {
+      // Fill the current block, then start new ones as long as there are
+      // copies of the sample left:
+      types::sample_index n_left = n;
+      while (n_left > 0)
+        {
+          const types::sample_index n_added
+            = std::min (n_left, block_size - current_block.n_samples);
+          current_block.add (sample, n_added);
+          n_left -= n_added;
+
+          if (current_block.n_samples == block_size)
+            {
+              blocks.emplace_back (std::move(current_block));
+              current_block = Statistics();
+
+              if (blocks.size() == max_n_blocks)
+                {
+                  for (unsigned int i=0; i<max_n_blocks/2; ++i)
+                    {
+                      if (i > 0)
+                        blocks[i] = std::move(blocks[2*i]);
+                      blocks[i].merge (blocks[2*i+1]);
+                    }
+                  blocks.resize (max_n_blocks/2);
+                  block_size *= 2;
+                }
+            }
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::pair<typename PotentialScaleReduction<InputType>::Statistics,
+        typename PotentialScaleReduction<InputType>::Statistics>
+        PotentialScaleReduction<InputType>::Chain::
+        split () const
+    {
+      // Find the block boundary closest to the middle of the chain. All
+      // completed blocks have the same size, and so this is simply a
+      // matter of rounding:
+      const types::sample_index n_samples
+        = blocks.size() * block_size + current_block.n_samples;
+      const std::size_t n_first_blocks
+        = std::min<std::size_t> ((n_samples + block_size) / (2*block_size), blocks.size());
+
+      std::pair<Statistics,Statistics> halves;
+      for (std::size_t i=0; i<n_first_blocks; ++i)
+        halves.first.merge (blocks[i]);
+      for (std::size_t i=n_first_blocks; i<blocks.size(); ++i)
+        halves.second.merge (blocks[i]);
+      halves.second.merge (current_block);
+
+      return halves;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    PotentialScaleReduction<InputType>::
+    PotentialScaleReduction (const unsigned int max_n_blocks)
+      :
+      Consumer<InputType>(ParallelMode::synchronous),
+      max_n_blocks (max_n_blocks),
+      next_source (1)
+    {
+      assert ((max_n_blocks >= 2) && (max_n_blocks % 2 == 0));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    PotentialScaleReduction<InputType>::
+    ~PotentialScaleReduction ()
+    {
+      sources.clear();
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    connect_to_producer (Producer<InputType> &producer)
+    {
+      const std::size_t source = next_source++;
+      sources.emplace_back (std::make_unique<Action<InputType>>(
+                              [this, source](InputType sample, AuxiliaryData aux_data)
+      {
+        add_sample (source, sample, aux_data);
+      },
+      /* allow_concurrent_action = */ true));
+      sources.back()->connect_to_producer (producer);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      add_sample (0, sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    PotentialScaleReduction<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::chain_number,
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    add_sample (const std::size_t    source,
+                const InputType     &sample,
+                const AuxiliaryData &aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double weight = aux_data.weight();
+      if ((n_repetitions == 0) || (weight == 0))
+        return;
+      assert ((weight == 1) && "This class does not support weighted samples.");
+
+      const std::size_t *chain_number = aux_data.get_if<std::size_t> (AuxiliaryData::chain_number);
+      const ChainKey key (source, (chain_number != nullptr ? *chain_number : 0));
+
+      // Find the chain. Most of the time, it already exists and we only
+      // need to hold a shared lock for the lookup. Chains are never
+      // removed, so the pointer remains valid after we release the lock.
+      Chain *chain = nullptr;
+      {
+        const std::shared_lock<std::shared_mutex> lock (chains_mutex);
+        const auto p = chain_numbers.find (key);
+        if (p != chain_numbers.end())
+          chain = chains[p->second].get();
+      }
+      if (chain == nullptr)
+        {
+          const std::unique_lock<std::shared_mutex> lock (chains_mutex);
+          const auto p = chain_numbers.find (key);
+          if (p != chain_numbers.end())
+            chain = chains[p->second].get();
+          else
+            {
+              chain_numbers[key] = chains.size();
+              chains.emplace_back (std::make_unique<Chain>());
+              chain = chains.back().get();
+            }
+        }
+
+      std::vector<double> x (Utilities::size(sample));
+      for (unsigned int j=0; j<x.size(); ++j)
+        x[j] = Utilities::get_nth_element (sample, j);
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (chain->mutex);
+      chain->add (x, n_repetitions, max_n_blocks);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    typename PotentialScaleReduction<InputType>::value_type
+    PotentialScaleReduction<InputType>::
+    get () const
+    {
+      // Split all chains with enough samples into halves:
+      std::vector<Statistics> halves;
+      std::size_t dimension = 0;
+      {
+        const std::shared_lock<std::shared_mutex> lock (chains_mutex);
+        for (const auto &chain : chains)
+          {
+            const std::unique_lock<std::mutex> chain_lock = this->lock_state (chain->mutex);
+            std::pair<Statistics,Statistics> h = chain->split();
+            dimension = std::max (dimension, h.second.mean.size());
+            if ((h.first.n_samples >= 2) && (h.second.n_samples >= 2))
+              {
+                halves.emplace_back (std::move(h.first));
+                halves.emplace_back (std::move(h.second));
+              }
+          }
+      }
+
+      if (halves.empty())
+        return value_type (dimension, std::numeric_limits<double>::quiet_NaN());
+
+      // Then compute the within-chain and between-chain variances for
+      // each component:
+      const double m = halves.size();
+      double n = 0;
+      for (const Statistics &h : halves)
+        n += h.n_samples;
+      n /= m;
+
+      value_type r_hat (dimension);
+      for (unsigned int j=0; j<dimension; ++j)
+        {
+          double overall_mean = 0;
+          double W = 0;
+          for (const Statistics &h : halves)
+            {
+              overall_mean += h.mean[j];
+              W += h.sum_of_squares[j] / (h.n_samples-1);
+            }
+          overall_mean /= m;
+          W /= m;
+
+          double B_over_n = 0;
+          for (const Statistics &h : halves)
+            B_over_n += (h.mean[j] - overall_mean) * (h.mean[j] - overall_mean);
+          B_over_n /= (m-1);
+
+          if (W > 0)
+            r_hat[j] = std::sqrt (((n-1)/n * W + B_over_n) / W);
+          else
+            r_hat[j] = (B_over_n == 0 ? 1. : std::numeric_limits<double>::infinity());
+        }
+
+      return r_hat;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::size_t
+    PotentialScaleReduction<InputType>::
+    n_chains () const
+    {
+      const std::shared_lock<std::shared_mutex> lock (chains_mutex);
+      return chains.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::shared_lock<std::shared_mutex> lock (chains_mutex);
+
+      const auto write_statistics = [&buffer](const Statistics &statistics)
+      {
+        Serialization::write (buffer, statistics.n_samples);
+        Serialization::write (buffer, statistics.mean);
+        Serialization::write (buffer, statistics.sum_of_squares);
+      };
+
+      Serialization::write (buffer, max_n_blocks);
+      Serialization::write (buffer, static_cast<std::uint64_t>(chains.size()));
+      for (const auto &chain : chains)
+        {
+          const std::unique_lock<std::mutex> chain_lock = this->lock_state (chain->mutex);
+          Serialization::write (buffer, chain->block_size);
+          Serialization::write (buffer, static_cast<std::uint64_t>(chain->blocks.size()));
+          for (const Statistics &block : chain->blocks)
+            write_statistics (block);
+          write_statistics (chain->current_block);
+        }
+
+      Serialization::write (buffer, static_cast<std::uint64_t>(chain_numbers.size()));
+      for (const auto &[key, number] : chain_numbers)
+        {
+          Serialization::write (buffer, static_cast<std::uint64_t>(key.first));
+          Serialization::write (buffer, static_cast<std::uint64_t>(key.second));
+          Serialization::write (buffer, static_cast<std::uint64_t>(number));
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      const auto read_statistics = [&buffer](Statistics &statistics)
+      {
+        Serialization::read (buffer, statistics.n_samples);
+        Serialization::read (buffer, statistics.mean);
+        Serialization::read (buffer, statistics.sum_of_squares);
+      };
+
+      unsigned int saved_max_n_blocks;
+      Serialization::read (buffer, saved_max_n_blocks);
+      assert (saved_max_n_blocks == max_n_blocks);
+
+      std::vector<std::unique_ptr<Chain>> new_chains;
+      std::uint64_t n_chains;
+      Serialization::read (buffer, n_chains);
+      for (std::uint64_t c=0; c<n_chains; ++c)
+        {
+          new_chains.emplace_back (std::make_unique<Chain>());
+          Chain &chain = *new_chains.back();
+
+          std::uint64_t n_blocks;
+          Serialization::read (buffer, chain.block_size);
+          Serialization::read (buffer, n_blocks);
+          chain.blocks.resize (n_blocks);
+          for (Statistics &block : chain.blocks)
+            read_statistics (block);
+          read_statistics (chain.current_block);
+        }
+
+      std::map<ChainKey,std::size_t> new_chain_numbers;
+      std::uint64_t n_keys;
+      Serialization::read (buffer, n_keys);
+      for (std::uint64_t k=0; k<n_keys; ++k)
+        {
+          std::uint64_t source, chain_number, number;
+          Serialization::read (buffer, source);
+          Serialization::read (buffer, chain_number);
+          Serialization::read (buffer, number);
+          new_chain_numbers[ChainKey(source, chain_number)] = number;
+        }
+
+      const std::unique_lock<std::shared_mutex> lock (chains_mutex);
+      chains        = std::move(new_chains);
+      chain_numbers = std::move(new_chain_numbers);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    PotentialScaleReduction<InputType>::
+    merge (const PotentialScaleReduction &other)
+    {
+      assert (other.max_n_blocks == max_n_blocks);
+
+      // Copy the chains of the other object:
+      std::vector<std::unique_ptr<Chain>> other_chains;
+      {
+        const std::shared_lock<std::shared_mutex> lock (other.chains_mutex);
+        for (const auto &chain : other.chains)
+          {
+            const std::unique_lock<std::mutex> chain_lock = other.lock_state (chain->mutex);
+            other_chains.emplace_back (std::make_unique<Chain>());
+            other_chains.back()->block_size    = chain->block_size;
+            other_chains.back()->blocks        = chain->blocks;
+            other_chains.back()->current_block = chain->current_block;
+          }
+      }
+
+      const std::unique_lock<std::shared_mutex> lock (chains_mutex);
+      for (auto &chain : other_chains)
+        chains.emplace_back (std::move(chain));
+    }
+  }
+}
@@ -0,0 +1,749 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace Quantiles
+    {
+      /**
+       * A class that implements the "merging t-digest" of Ted Dunning and
+       * Otmar Ertl (see T. Dunning, "The t-digest: Efficient estimates of
+       * distributions", Software Impacts, vol. 7, 2021), a data structure
+       * that summarizes a stream of weighted scalar values in a bounded
+       * amount of memory and allows estimating quantiles of their
+       * distribution.
+       *
+       * The digest represents the values it has seen by a sorted list of
+       * "centroids", i.e., pairs of a mean value and a weight. New values
+       * are first collected in a buffer; when the buffer is full, it is
+       * sorted together with the existing centroids, and neighboring
+       * entries are merged as long as the merged centroid does not span
+       * more than one unit of the "scale function"
+       * $k(q) = \frac{\delta}{2\pi} \arcsin(2q-1)$, where $q$ is the fraction
+       * of the total weight that lies to the left of a point and $\delta$ is
+       * the "compression" parameter. Because $k$ is steep near $q=0$ and
+       * $q=1$, centroids near the tails of the distribution represent few
+       * values, which makes estimates of extreme quantiles accurate, and the
+       * number of centroids is bounded by a small multiple of $\delta$
+       * independently of the number of values.
+       */
+      class TDigest
+      {
+        public:
+          /**
+           * Constructor.
+           *
+           * @param[in] compression The parameter $\delta$ discussed in the
+           *   documentation of this class.
+           */
+          TDigest (const double compression = 100);
+
+          /**
+           * Add a value with the given weight. The weight must be positive.
+           */
+          void
+          add (const double value,
+               const double weight);
+
+          /**
+           * Add all values represented by the other digest to the current
+           * one.
+           */
+          void
+          merge (const TDigest &other);
+
+          /**
+           * Return an estimate of the value below which the given fraction
+           * `q` of the total weight of the values lies. If the digest has
+           * not seen any values yet, return NaN.
+           */
+          double
+          quantile (const double q) const;
+
+          /**
+           * Write the centroids and buffered values of the digest into the
+           * given buffer.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          /**
+           * Read the state previously written by save() from the front of
+           * the given buffer, and advance the buffer past the data read.
+           */
+          void
+          load (std::span<const char> &buffer);
+
+        private:
+          /**
+           * A structure that represents a centroid, or a value in the buffer.
+           */
+          struct Centroid
+          {
+            double mean;
+            double weight;
+          };
+
+          /**
+           * The compression parameter.
+           */
+          double compression;
+
+          /**
+           * The centroids, sorted by their mean, as computed by the last
+           * call to compress().
+           */
+          std::vector<Centroid> centroids;
+
+          /**
+           * The values added since the last call to compress().
+           */
+          std::vector<Centroid> buffer;
+
+          /**
+           * The sum of the weights of all values, including those in the
+           * buffer.
+           */
+          double total_weight;
+
+          /**
+           * The smallest and largest value seen so far. Quantiles are never
+           * estimated to lie outside this range.
+           */
+          double min_value;
+          double max_value;
+
+          /**
+           * Whether the next call to compress() should walk through the
+           * sorted values from the largest to the smallest. Merging always
+           * in the same direction leads to centroids that are
+           * systematically larger on one side of the distribution than on
+           * the other; alternating the direction avoids this bias.
+           */
+          bool merge_from_the_right = false;
+
+          /**
+           * Sort the buffered values into the list of centroids and merge
+           * neighboring centroids where the scale function allows.
+           */
+          void
+          compress ();
+
+          /**
+           * Return the number of values that are collected in the buffer
+           * before they are merged into the centroids.
+           */
+          std::size_t
+          buffer_capacity () const;
+      };
+
+
+
+      inline
+      TDigest::TDigest (const double compression)
+        :
+        compression (compression),
+        total_weight (0),
+        min_value (std::numeric_limits<double>::infinity()),
+        max_value (-std::numeric_limits<double>::infinity())
+      {
+        assert (compression >= 10);
+      }
+
+
+
+      inline
+      void
+      TDigest::add (const double value,
+                    const double weight)
+      {
+        assert (weight > 0);
+
+        buffer.push_back ({value, weight});
+        total_weight += weight;
+        min_value = std::min (min_value, value);
+        max_value = std::max (max_value, value);
+
+        if (buffer.size() >= buffer_capacity())
+          compress ();
+      }
+
+
+
+      inline
+      void
+      TDigest::merge (const TDigest &other)
+      {
+        // Treat the other digest's centroids and buffered values as
+        // weighted values in our own buffer. compress() needs to know the
+        // total weight, so update it first:
+        total_weight += other.total_weight;
+        min_value = std::min (min_value, other.min_value);
+        max_value = std::max (max_value, other.max_value);
+
+        for (const std::vector<Centroid> *list : {&other.centroids, &other.buffer})
+          for (const Centroid &c : *list)
+            {
+              buffer.push_back (c);
+              if (buffer.size() >= buffer_capacity())
+                compress ();
+            }
+      }
+
+
+
+      inline
+      double
+      TDigest::quantile (const double q) const
+      {
+        assert ((q >= 0) && (q <= 1));
+
+        if (total_weight == 0)
+          return std::numeric_limits<double>::quiet_NaN();
+
+        // If there are values left in the buffer, work on a compressed
+        // copy of the digest:
+        if (buffer.size() > 0)
+          {
+            TDigest copy (*this);
+            copy.compress ();
+            return copy.quantile (q);
+          }
+
+        if (centroids.size() == 1)
+          return centroids[0].mean;
+
+        // Think of the weight of each centroid as being spread out
+        // around its mean, with half of it on either side. The
+        // quantile is then found by linear interpolation between the
+        // means of the two centroids whose halves surround the target
+        // weight, or between the first or last mean and the smallest or
+        // largest value:
+        const double target = q * total_weight;
+        if (target < centroids.front().weight/2)
+          return min_value + (centroids.front().mean - min_value) * target / (centroids.front().weight/2);
+
+        double weight_so_far = centroids.front().weight/2;
+        for (std::size_t i=0; i+1<centroids.size(); ++i)
+          {
+            const double gap = (centroids[i].weight + centroids[i+1].weight) / 2;
+            if (target < weight_so_far + gap)
+              return centroids[i].mean
+                     + (centroids[i+1].mean - centroids[i].mean) * (target - weight_so_far) / gap;
+            weight_so_far += gap;
+          }
+
+        const double last_half = centroids.back().weight/2;
+        return centroids.back().mean
+               + (max_value - centroids.back().mean) * std::min ((target - weight_so_far) / last_half, 1.);
+      }
+
+
+
+      inline
+      void
+      TDigest::save (std::vector<char> &output) const
+      {
+        TDigest copy (*this);
+        copy.compress ();
+
+        Serialization::write (output, copy.compression);
+        Serialization::write (output, copy.total_weight);
+        Serialization::write (output, copy.min_value);
+        Serialization::write (output, copy.max_value);
+        Serialization::write (output, copy.centroids);
+      }
+
+
+
+      inline
+      void
+      TDigest::load (std::span<const char> &input)
+      {
+        Serialization::read (input, compression);
+        Serialization::read (input, total_weight);
+        Serialization::read (input, min_value);
+        Serialization::read (input, max_value);
+        Serialization::read (input, centroids);
+        buffer.clear ();
+      }
+
+
+
+      inline
+      void
+      TDigest::compress ()
+      {
+        if (buffer.size() == 0)
+          return;
+
+        buffer.insert (buffer.end(), centroids.begin(), centroids.end());
+        std::sort (buffer.begin(), buffer.end(),
+                   [](const Centroid &a, const Centroid &b)
+        {
+          return a.mean < b.mean;
+        });
+        if (merge_from_the_right)
+          std::reverse (buffer.begin(), buffer.end());
+
+        // The scale function and its inverse:
+        const auto k = [this](const double q)
+        {
+          return compression / (2*std::numbers::pi) * std::asin (2*q-1);
+        };
+        const auto k_inverse = [this](const double k_value)
+        {
+          const double x = std::clamp (k_value * 2*std::numbers::pi / compression,
+                                       -std::numbers::pi/2, std::numbers::pi/2);
+          return (std::sin(x) + 1) / 2;
+        };
+
+        // Walk through the sorted list and add each entry to the current
+        // centroid as long as the fraction of the total weight to its
+        // right stays below the limit of one unit of k beyond the fraction
+        // to its left:
+        std::vector<Centroid> merged;
+        merged.reserve (buffer.size());
+        merged.push_back (buffer[0]);
+        double weight_to_the_left = 0;
+        double q_limit = k_inverse (k(0) + 1);
+        for (std::size_t i=1; i<buffer.size(); ++i)
+          {
+            Centroid &current = merged.back();
+            const double q = (weight_to_the_left + current.weight + buffer[i].weight) / total_weight;
+            if (q <= q_limit)
+              {
+                current.weight += buffer[i].weight;
+                current.mean   += (buffer[i].mean - current.mean) * buffer[i].weight / current.weight;
+              }
+            else
+              {
+                weight_to_the_left += current.weight;
+                q_limit = k_inverse (k(weight_to_the_left / total_weight) + 1);
+                merged.push_back (buffer[i]);
+              }
+          }
+
+        if (merge_from_the_right)
+          std::reverse (merged.begin(), merged.end());
+        merge_from_the_right = !merge_from_the_right;
+
+        centroids.swap (merged);
+        buffer.clear ();
+      }
+
+
+
+      inline
+      std::size_t
+      TDigest::buffer_capacity () const
+      {
+        return static_cast<std::size_t>(5 * compression);
+      }
+    }
+  }
+
+
+
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that estimates quantiles of each component of the
+     * samples it receives, for example the median or the end points of
+     * a 95% credible interval, using a bounded amount of memory. Computing
+     * quantiles exactly would require storing all samples and sorting
+     * them, and using a Histogram object requires knowing the range of
+     * samples beforehand; instead, this class keeps one "t-digest" (see
+     * T. Dunning, "The t-digest: Efficient estimates of distributions",
+     * Software Impacts, vol. 7, 2021) per component, a summary of the
+     * distribution of values that requires $O(\delta)$ memory where $\delta$
+     * is a "compression" parameter given to the constructor, regardless of
+     * how many samples have been processed. Larger values of $\delta$ lead
+     * to more accurate estimates; with the default value of 100, the
+     * fraction of samples that lies below the estimate of the $q$-quantile
+     * typically differs from $q$ by less than $10^{-3}$, and by much less
+     * for quantiles close to zero or one.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. If samples carry weights (see AuxiliaryData::sample_weight),
+     * then the class estimates quantiles of the weighted distribution;
+     * samples with weight zero are ignored.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread adds samples to its own set of digests, stored in
+     * a ShardedAccumulator object, so that threads do not have to wait for
+     * each other; get() merges these digests. consume_batch() adds all
+     * samples of a batch while accessing the digests of the current thread
+     * only once.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The
+     *   requirements on this type are the same as for the MeanValue class,
+     *   and the components of samples need to be convertible to `double`.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class Quantiles : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class for one
+         * quantile, i.e., the type of the object returned by get(). This
+         * is a vector that contains the estimated quantile for each
+         * component of the samples.
+         */
+        using value_type = std::vector<double>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] compression The compression parameter $\delta$ of the
+         *   digests discussed in the documentation of this class. The memory
+         *   used by each digest, and the cost of estimating quantiles, is
+         *   proportional to this number. It needs to be at least 10.
+         */
+        Quantiles (const double compression = 100);
+
+        /**
+         * Copy constructor.
+         */
+        Quantiles (const Quantiles<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Quantiles ();
+
+        /**
+         * Process one sample by adding each of its components to the
+         * respective digest.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples. This has the same effect as calling
+         * consume() for each sample of the batch.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return estimates of the $q$-quantile of each component of the
+         * samples, i.e., of the value below which the fraction $q$ of
+         * samples lies. For example, `get(0.5)` returns the median of each
+         * component. If no samples have been processed so far, this function
+         * returns an empty vector.
+         */
+        value_type
+        get (const double q) const;
+
+        /**
+         * Return estimates of several quantiles at once. The function returns
+         * a vector with one element for each element of `qs`, each of which
+         * is what get() would return for this quantile. This is cheaper than
+         * calling get() several times since the per-thread digests only need
+         * to be merged once. For example, `get({0.025, 0.975})` returns the
+         * end points of the central 95% credible interval of each component.
+         */
+        std::vector<value_type>
+        get (const std::vector<double> &qs) const;
+
+        /**
+         * Append the digests of all components to the given buffer. See the
+         * section on saving and combining the state of consumers in the
+         * documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the digests stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the samples summarized by another object to the ones summarized
+         * by the current one. The other object must have processed samples
+         * with the same number of components.
+         */
+        void
+        merge (const Quantiles &other);
+
+      private:
+        /**
+         * The compression parameter given to the constructor.
+         */
+        const double compression;
+
+        /**
+         * A structure storing the digests of all components of the samples
+         * processed by one shard of the `partial_digests` variable below.
+         * The vector is empty until the first sample has been processed.
+         */
+        struct PartialDigests
+        {
+          double                                  compression = 100;
+          std::vector<internal::Quantiles::TDigest> digests;
+
+          /**
+           * Add a sample with the given weight, which must be positive.
+           */
+          void
+          add_sample (const InputType &sample,
+                      const double     weight);
+
+          /**
+           * Merge the digests stored in the argument into the ones stored in
+           * the current object.
+           */
+          void
+          merge (const PartialDigests &other);
+        };
+
+        /**
+         * The digests of the threads that have sent samples to this object.
+         */
+        ShardedAccumulator<PartialDigests> partial_digests;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    Quantiles<InputType>::
+    Quantiles (const double compression)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      compression (compression),
+      partial_digests (PartialDigests {compression, {}})
+    {
+      assert (compression >= 10);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    Quantiles<InputType>::
+    Quantiles (const Quantiles<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      compression (o.compression),
+      partial_digests (o.partial_digests)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    Quantiles<InputType>::
+    ~Quantiles ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const double weight = aux_data.n_repetitions() * aux_data.weight();
+      if (weight == 0)
+        return;
+
+      partial_digests.update ([&sample, weight](PartialDigests &digests)
+      {
+        digests.add_sample (sample, weight);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      partial_digests.update ([&samples, &aux_data](PartialDigests &digests)
+      {
+        for (std::size_t i=0; i<samples.size(); ++i)
+          {
+            const double weight = aux_data[i].n_repetitions() * aux_data[i].weight();
+            if (weight != 0)
+              digests.add_sample (samples[i], weight);
+          }
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename Quantiles<InputType>::value_type
+    Quantiles<InputType>::
+    get (const double q) const
+    {
+      return get (std::vector<double> {q})[0];
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::vector<typename Quantiles<InputType>::value_type>
+    Quantiles<InputType>::
+    get (const std::vector<double> &qs) const
+    {
+      const PartialDigests digests = partial_digests.merged();
+
+      std::vector<value_type> return_value (qs.size(), value_type(digests.digests.size()));
+      for (unsigned int i=0; i<qs.size(); ++i)
+        for (unsigned int c=0; c<digests.digests.size(); ++c)
+          return_value[i][c] = digests.digests[c].quantile (qs[i]);
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, partial_digests.merged().digests);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialDigests digests {compression, {}};
+      Serialization::read (buffer, digests.digests);
+      partial_digests.reset (digests);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::
+    merge (const Quantiles &other)
+    {
+      const PartialDigests other_digests = other.partial_digests.merged();
+      partial_digests.update ([&other_digests](PartialDigests &digests)
+      {
+        digests.merge (other_digests);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::PartialDigests::
+    add_sample (const InputType &sample,
+                const double     weight)
+    {
+      const std::size_t n_components = Utilities::size(sample);
+      if (digests.size() == 0)
+        digests.resize (n_components, internal::Quantiles::TDigest (compression));
+      assert (digests.size() == n_components);
+
+      for (std::size_t c=0; c<n_components; ++c)
+        digests[c].add (Utilities::get_nth_element (sample, c), weight);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    Quantiles<InputType>::PartialDigests::
+    merge (const PartialDigests &other)
+    {
+      if (other.digests.size() == 0)
+        return;
+      if (digests.size() == 0)
+        {
+          digests = other.digests;
+          return;
+        }
+
+      assert (digests.size() == other.digests.size());
+      for (std::size_t c=0; c<digests.size(); ++c)
+        digests[c].merge (other.digests[c]);
+    }
+  }
+}
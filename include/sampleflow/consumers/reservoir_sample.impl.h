@@ -0,0 +1,619 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that keeps a uniformly random subset of fixed size
+     * $k$ of the samples it has seen -- a "reservoir sample". This is useful
+     * if one wants to have, say, $10^5$ samples for plotting or for training
+     * an emulator at the end of a run whose length is not known in advance
+     * and that may produce far more samples than can be stored. In contrast
+     * to using a Filters::TakeEveryNth object, one does not need to know
+     * the length of the run to choose the interval, and the subset the
+     * class keeps is always a uniformly random one of all samples seen so
+     * far, no matter when one calls get().
+     *
+     * The class uses "Algorithm L" of Kim-Hung Li ("Reservoir-sampling
+     * algorithms of time complexity $O(n(1+\log(N/n)))$", ACM Transactions
+     * on Mathematical Software, vol. 20, pp. 481-493, 1994). The first $k$
+     * samples are simply stored. After that, rather than drawing a random
+     * number for every sample to decide whether it replaces one of the
+     * stored samples, the algorithm draws the (geometrically distributed)
+     * number of samples to skip until the next one that does. Since the
+     * $k/n$ chance that the $n$th sample is kept decreases as $n$ grows,
+     * almost all samples are skipped in a long run, and for these consume()
+     * only needs to increment a counter. The samples kept are stored in a
+     * vector that has room for $k$ samples. A new sample is assigned to the
+     * slot of the one it replaces, so that for sample types such as
+     * `Eigen::VectorXd` or `std::valarray<double>` no memory is allocated
+     * once the reservoir is full.
+     *
+     * If the samples are large, the class can also be connected to a
+     * Filters::MakeShared object, i.e., be used with `InputType` equal to
+     * `std::shared_ptr<const T>` (see Concepts::is_sample_handle). The
+     * reservoir then holds the handles, i.e., one pointer per sample kept,
+     * and samples are never copied; a sample is released once it has been
+     * replaced in all reservoirs and no other consumer holds on to it.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count counts as many times as this entry
+     * says, i.e., the result is the same as if the copies had been sent one
+     * at a time. Sample weights are ignored: Every sample of the chain has
+     * the same chance to be kept.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread (or, if there are many threads, each group of
+     * threads) fills its own reservoir, see the ShardedAccumulator class,
+     * with its own stream of random numbers. get() combines these into a
+     * uniformly random subset of the union of all samples: It draws the
+     * $k$ samples one after the other, each time from one of the reservoirs
+     * with probability proportional to the number of samples that reservoir
+     * represents and has not contributed yet.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$.
+     */
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    class ReservoirSample : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get().
+         */
+        using value_type = std::vector<InputType>;
+
+        /**
+         * The type of the random number generators used to decide which
+         * samples to keep.
+         */
+        using RandomNumberGenerator = Random::Xoshiro256PlusPlus;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] n_samples The number $k$ of samples to keep. Must be at
+         *   least one.
+         * @param[in] random_seed The seed of the random number generators.
+         *   Each thread that sends samples uses a separate stream of random
+         *   numbers for this seed, see Random::create_stream().
+         */
+        ReservoirSample (const unsigned int  n_samples,
+                         const std::uint64_t random_seed = 0);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~ReservoirSample ();
+
+        /**
+         * Process one sample by deciding whether to keep it, and if so,
+         * storing it in place of one of the samples kept so far.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count of the sample (see
+         *   AuxiliaryData::n_repetitions()) and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return a uniformly random subset of the samples seen so far. The
+         * vector returned has $k$ elements, or as many as there were samples
+         * if fewer than $k$ samples have been processed so far. The order of
+         * the elements is arbitrary.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the number of samples the subset returned by get() has been
+         * drawn from, i.e., the number of samples processed so far
+         * (counting repeated samples as often as they were repeated).
+         */
+        types::sample_index
+        n_samples_seen () const;
+
+        /**
+         * Append the samples kept so far, along with the state of the
+         * sampling algorithm, to the given buffer. See the section on
+         * saving and combining the state of consumers in the documentation
+         * of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have kept the same number of samples as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Combine the samples kept by another object with the ones kept by
+         * the current object, so that the current object then keeps a
+         * uniformly random subset of the union of the samples seen by both
+         * objects. Both objects need to keep the same number of samples.
+         */
+        void
+        merge (const ReservoirSample &other);
+
+      private:
+        /**
+         * A structure that describes the reservoir for a subset of the
+         * samples processed so far, namely those processed on one shard of
+         * the `reservoirs` variable below.
+         */
+        struct PartialReservoir
+        {
+          /**
+           * The number $k$ of samples to keep.
+           */
+          unsigned int max_n_samples = 0;
+
+          /**
+           * The number of samples this reservoir represents.
+           */
+          types::sample_index n_samples_seen = 0;
+
+          /**
+           * The samples kept.
+           */
+          std::vector<InputType> samples;
+
+          /**
+           * Once the reservoir is full, the logarithm of the variable $W$ of
+           * Algorithm L -- the $k$th smallest of the uniformly distributed
+           * random "keys" the algorithm implicitly assigns to all samples
+           * seen so far -- and the index (starting at zero) of the next
+           * sample that will replace one of those kept. We store $\log W$
+           * rather than $W$ since $W$ approaches one in long runs, and
+           * $1-W$ could then no longer be computed accurately.
+           */
+          double              log_w = 0;
+          types::sample_index next_sample_to_keep = 0;
+
+          /**
+           * The random number generator used for this reservoir. It is
+           * created when the first sample is added to the reservoir, so
+           * that each shard can use a different stream of random numbers.
+           */
+          std::optional<RandomNumberGenerator> rng;
+
+          /**
+           * Add the given sample, which stands for `n_repetitions`
+           * consecutive samples, to the reservoir.
+           */
+          void
+          add_sample (const InputType          &sample,
+                      const types::sample_index n_repetitions);
+
+          /**
+           * Update the current object so that it represents a uniformly
+           * random subset of the samples represented by both the current
+           * object and the argument.
+           */
+          void
+          merge (const PartialReservoir &other);
+
+          /**
+           * Return the logarithm of a random number that is uniformly
+           * distributed in $(0,1]$.
+           */
+          double
+          log_uniform ();
+
+          /**
+           * Draw the number of samples to skip after the one with index
+           * `index`, for the current value of $W$, and set
+           * `next_sample_to_keep` accordingly.
+           */
+          void
+          draw_next_sample_to_keep (const types::sample_index index);
+
+          /**
+           * Write the members of this structure to a buffer, or read them
+           * from a buffer.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          void
+          load (std::span<const char> &buffer);
+        };
+
+        /**
+         * The number $k$ of samples to keep.
+         */
+        const unsigned int max_n_samples;
+
+        /**
+         * The seed of the random number generators, and the number of the
+         * stream of random numbers the next shard to receive a sample will
+         * use.
+         */
+        const std::uint64_t                random_seed;
+        mutable std::atomic<std::uint64_t> next_stream;
+
+        /**
+         * The reservoirs filled by the threads that have sent samples to
+         * this object.
+         */
+        ShardedAccumulator<PartialReservoir> reservoirs;
+
+        /**
+         * Return an empty reservoir for the given number of samples.
+         */
+        static
+        PartialReservoir
+        empty_reservoir (const unsigned int n_samples);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::PartialReservoir::
+    add_sample (const InputType          &sample,
+                const types::sample_index n_repetitions)
+    {
+      types::sample_index n_remaining = n_repetitions;
+
+      // As long as the reservoir is not full, simply store the sample. Once
+      // it is full, initialize W as the largest of k uniformly distributed
+      // keys, and find the first sample that will replace one of those
+      // kept:
+      while ((n_remaining > 0) && (samples.size() < max_n_samples))
+        {
+          if (samples.capacity() < max_n_samples)
+            samples.reserve (max_n_samples);
+          samples.push_back (sample);
+          ++n_samples_seen;
+          --n_remaining;
+
+          if (samples.size() == max_n_samples)
+            {
+              log_w = log_uniform() / max_n_samples;
+              draw_next_sample_to_keep (n_samples_seen-1);
+            }
+        }
+
+      // Then replace randomly chosen samples by the copies of the current
+      // one that the algorithm wants to keep, and skip the rest:
+      while (n_remaining > 0)
+        {
+          if (next_sample_to_keep >= n_samples_seen + n_remaining)
+            {
+              n_samples_seen += n_remaining;
+              break;
+            }
+
+          const types::sample_index index = next_sample_to_keep;
+          const unsigned int slot
+            = std::uniform_int_distribution<unsigned int>(0, max_n_samples-1)(*rng);
+          samples[slot] = sample;
+
+          n_remaining -= (index - n_samples_seen + 1);
+          n_samples_seen = index + 1;
+
+          log_w += log_uniform() / max_n_samples;
+          draw_next_sample_to_keep (index);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::PartialReservoir::
+    merge (const PartialReservoir &other)
+    {
+      // Merging with an empty reservoir does not change anything, and
+      // merging an empty reservoir with another one yields the other one,
+      // though we keep our own random number generator if we already have
+      // one:
+      if (other.n_samples_seen == 0)
+        return;
+      if (n_samples_seen == 0)
+        {
+          std::optional<RandomNumberGenerator> own_rng = rng;
+          *this = other;
+          if (own_rng)
+            rng = own_rng;
+          return;
+        }
+
+      assert (max_n_samples == other.max_n_samples);
+      if (!rng)
+        rng = other.rng;
+
+      const types::sample_index n_combined = n_samples_seen + other.n_samples_seen;
+
+      // If both reservoirs together hold no more than k samples, then
+      // they both hold all of the samples they have seen, and we can put
+      // them all into the current reservoir:
+      if (n_combined <= max_n_samples)
+        {
+          samples.insert (samples.end(), other.samples.begin(), other.samples.end());
+          n_samples_seen = n_combined;
+          if (samples.size() == max_n_samples)
+            {
+              log_w = log_uniform() / max_n_samples;
+              draw_next_sample_to_keep (n_samples_seen-1);
+            }
+          return;
+        }
+
+      // Otherwise, draw k samples without replacement from the union of
+      // the two sets of samples. Each draw comes from the first set with
+      // probability proportional to the number of its samples not yet
+      // drawn, and then is a uniformly random one of the stored samples of
+      // that set not yet drawn. Since the stored samples of each
+      // reservoir are a uniformly random subset of the samples it
+      // represents, this yields a uniformly random subset of the union.
+      std::vector<InputType> samples_1 = std::move(samples);
+      std::vector<InputType> samples_2 = other.samples;
+      types::sample_index n_remaining_1 = n_samples_seen;
+      types::sample_index n_remaining_2 = other.n_samples_seen;
+
+      samples.clear ();
+      samples.reserve (max_n_samples);
+      for (unsigned int i=0; i<max_n_samples; ++i)
+        {
+          const types::sample_index r
+            = std::uniform_int_distribution<types::sample_index>(0, n_remaining_1+n_remaining_2-1)(*rng);
+          std::vector<InputType> &source = (r < n_remaining_1 ? samples_1 : samples_2);
+          if (r < n_remaining_1)
+            --n_remaining_1;
+          else
+            --n_remaining_2;
+
+          assert (source.size() > 0);
+          const std::size_t j
+            = std::uniform_int_distribution<std::size_t>(0, source.size()-1)(*rng);
+          std::swap (source[j], source.back());
+          samples.emplace_back (std::move(source.back()));
+          source.pop_back ();
+        }
+      n_samples_seen = n_combined;
+
+      // The k kept samples are those with the k smallest keys, and given
+      // the number n of samples seen, the kth smallest of n uniformly
+      // distributed keys follows a Beta(k,n-k+1) distribution. This is
+      // all that Algorithm L needs to know to continue, so draw W from
+      // this distribution, computed as the ratio X/(X+Y) of gamma
+      // distributed variables:
+      const double x
+        = std::gamma_distribution<double>(max_n_samples)(*rng);
+      const double y
+        = std::gamma_distribution<double>(static_cast<double>(n_combined - max_n_samples + 1))(*rng);
+      log_w = std::log(x) - std::log(x+y);
+      draw_next_sample_to_keep (n_samples_seen-1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    double
+    ReservoirSample<InputType>::PartialReservoir::
+    log_uniform ()
+    {
+      return std::log (1. - std::uniform_real_distribution<double>(0., 1.)(*rng));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::PartialReservoir::
+    draw_next_sample_to_keep (const types::sample_index index)
+    {
+      // Each of the following samples is kept with probability W, so the
+      // number of samples to skip is geometrically distributed. log(1-W)
+      // is computed as log(-expm1(log W)) to retain accuracy for W close
+      // to one:
+      const double skip = std::floor (log_uniform() / std::log(-std::expm1(log_w)));
+
+      const types::sample_index max_index = std::numeric_limits<types::sample_index>::max();
+      if (!(skip < static_cast<double>(max_index - index - 1)))
+        next_sample_to_keep = max_index;
+      else
+        next_sample_to_keep = index + static_cast<types::sample_index>(skip) + 1;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::PartialReservoir::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, max_n_samples);
+      Serialization::write (buffer, n_samples_seen);
+      Serialization::write (buffer, samples);
+      Serialization::write (buffer, log_w);
+      Serialization::write (buffer, next_sample_to_keep);
+      Serialization::write (buffer, rng);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::PartialReservoir::
+    load (std::span<const char> &buffer)
+    {
+      Serialization::read (buffer, max_n_samples);
+      Serialization::read (buffer, n_samples_seen);
+      Serialization::read (buffer, samples);
+      Serialization::read (buffer, log_w);
+      Serialization::read (buffer, next_sample_to_keep);
+      Serialization::read (buffer, rng);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename ReservoirSample<InputType>::PartialReservoir
+    ReservoirSample<InputType>::
+    empty_reservoir (const unsigned int n_samples)
+    {
+      PartialReservoir reservoir;
+      reservoir.max_n_samples = n_samples;
+      return reservoir;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    ReservoirSample<InputType>::
+    ReservoirSample (const unsigned int  n_samples,
+                     const std::uint64_t random_seed)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      max_n_samples (n_samples),
+      random_seed (random_seed),
+      next_stream (0),
+      reservoirs (empty_reservoir (n_samples))
+    {
+      assert (n_samples >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    ReservoirSample<InputType>::
+    ~ReservoirSample ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      reservoirs.update ([&](PartialReservoir &reservoir)
+      {
+        if (!reservoir.rng)
+          reservoir.rng = Random::create_stream<RandomNumberGenerator>(random_seed,
+                                                                      next_stream++);
+        reservoir.add_sample (sample, n_repetitions);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename ReservoirSample<InputType>::value_type
+    ReservoirSample<InputType>::
+    get () const
+    {
+      return reservoirs.merged().samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    ReservoirSample<InputType>::
+    n_samples_seen () const
+    {
+      return reservoirs.merged().n_samples_seen;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, reservoirs.merged());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      PartialReservoir reservoir;
+      Serialization::read (buffer, reservoir);
+      assert (reservoir.max_n_samples == max_n_samples);
+      reservoirs.reset (reservoir);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    ReservoirSample<InputType>::
+    merge (const ReservoirSample &other)
+    {
+      const PartialReservoir other_reservoir = other.reservoirs.merged();
+      reservoirs.update ([&other_reservoir](PartialReservoir &reservoir)
+      {
+        reservoir.merge (other_reservoir);
+      }, this->is_single_threaded() == false);
+    }
+  }
+}
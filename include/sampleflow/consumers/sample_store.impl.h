@@ -0,0 +1,1090 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class SampleStore;
+
+
+    namespace internal
+    {
+      namespace SampleStore
+      {
+        /**
+         * An iterator over the samples stored in a Consumers::SampleStore
+         * object. Dereferencing the iterator creates an object of type
+         * `InputType` from the stored components of the sample it points
+         * to. The iterator satisfies the requirements of the
+         * `std::random_access_iterator` concept, so that a SampleStore
+         * object can be passed to Producers::Range::sample_in_parallel().
+         */
+        template <typename InputType>
+        class Iterator
+        {
+          public:
+            using value_type        = InputType;
+            using difference_type   = std::ptrdiff_t;
+            using iterator_concept  = std::random_access_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+
+            Iterator () = default;
+
+            Iterator (const Consumers::SampleStore<InputType> *store,
+                      const std::size_t                        index)
+              :
+              store (store),
+              index (index)
+            {}
+
+            value_type operator* () const
+            {
+              return (*store)[index];
+            }
+
+            value_type operator[] (const difference_type n) const
+            {
+              return (*store)[index + n];
+            }
+
+            Iterator &operator++ ()
+            {
+              ++index;
+              return *this;
+            }
+
+            Iterator operator++ (int)
+            {
+              Iterator tmp = *this;
+              ++index;
+              return tmp;
+            }
+
+            Iterator &operator-- ()
+            {
+              --index;
+              return *this;
+            }
+
+            Iterator operator-- (int)
+            {
+              Iterator tmp = *this;
+              --index;
+              return tmp;
+            }
+
+            Iterator &operator+= (const difference_type n)
+            {
+              index += n;
+              return *this;
+            }
+
+            Iterator &operator-= (const difference_type n)
+            {
+              index -= n;
+              return *this;
+            }
+
+            friend Iterator operator+ (Iterator it, const difference_type n)
+            {
+              return it += n;
+            }
+
+            friend Iterator operator+ (const difference_type n, Iterator it)
+            {
+              return it += n;
+            }
+
+            friend Iterator operator- (Iterator it, const difference_type n)
+            {
+              return it -= n;
+            }
+
+            friend difference_type operator- (const Iterator &a, const Iterator &b)
+            {
+              return static_cast<difference_type>(a.index) - static_cast<difference_type>(b.index);
+            }
+
+            friend bool operator== (const Iterator &a, const Iterator &b)
+            {
+              return a.index == b.index;
+            }
+
+            friend auto operator<=> (const Iterator &a, const Iterator &b)
+            {
+              return a.index <=> b.index;
+            }
+
+          private:
+            const Consumers::SampleStore<InputType> *store = nullptr;
+            std::size_t                              index = 0;
+        };
+      }
+    }
+
+
+
+    /**
+     * A Consumer class that stores all samples it receives in memory for
+     * later analysis, along with selected entries of their auxiliary data.
+     *
+     * Storing samples of type, say, `Eigen::VectorXd` in a
+     * `std::vector<Eigen::VectorXd>` (for example, via an Action object)
+     * requires a separate memory allocation for each sample, and the
+     * components of the samples end up scattered all over memory. This class
+     * instead stores samples "by column": It allocates memory in chunks that
+     * each have room for a fixed number of samples, and within each chunk
+     * stores the first component of all samples contiguously, followed by
+     * the second component of all samples, etc., and then the values of the
+     * selected auxiliary data entries. Adding a sample therefore copies its
+     * components into memory that has already been allocated, and only every
+     * `chunk_size`th sample requires allocating a new chunk. (If the producer
+     * announces how many samples to expect, see Producer::announce_samples(),
+     * then all chunks are allocated up front.) Since chunks
+     * are never moved once allocated, the stored data can be accessed
+     * without copying it through `Eigen::Map` objects that refer to the
+     * memory of a chunk (see chunk(), component(), and aux_data_column()).
+     * For example, the mean value of the stored samples can be computed as
+     * follows:
+     * @code
+     *   Eigen::VectorXd sum = Eigen::VectorXd::Zero (store.n_components());
+     *   for (std::size_t c=0; c<store.n_chunks(); ++c)
+     *     sum += store.chunk(c).colwise().sum().transpose();
+     *   const Eigen::VectorXd mean = sum / store.size();
+     * @endcode
+     *
+     * The object also acts as a random-access range of samples: Its begin()
+     * and end() functions return iterators that, when dereferenced, create
+     * an object of type `InputType` from the stored components. As a
+     * consequence, a SampleStore object can be used as the input of a
+     * Producers::Range object to send the stored samples through another
+     * pipeline of filters and consumers. (The auxiliary data is not sent
+     * along.)
+     *
+     * The values of the auxiliary data entries are stored as `double`
+     * values, regardless of the type of the entry, as long as it has an
+     * arithmetic type (as is the case for all predefined keys such as
+     * AuxiliaryData::relative_log_likelihood or
+     * AuxiliaryData::sample_is_repeated). If a sample does not have an
+     * entry for one of the selected keys, or the entry does not have an
+     * arithmetic type, then NaN is stored.
+     *
+     *
+     * ### Storing samples on disk ###
+     *
+     * Long runs can produce more samples than fit into memory. After
+     * calling spill_to_file(), the object therefore only keeps a bounded
+     * number of chunks in memory: Whenever a chunk is full, it is handed to
+     * a writer thread that writes it to the given file, after which the
+     * memory of the chunk is released and the chunk's data is instead
+     * accessed through a read-only memory mapping of the file. If the
+     * writer falls behind and the given number of chunks in memory is
+     * reached, then consume() waits for the writer before it starts a new
+     * chunk. Chunks that have been written to the file are then read back
+     * through the mapping by the operating system as they are accessed,
+     * and are evicted from memory again when memory is needed elsewhere.
+     * Since the mappings are marked as being read sequentially, and
+     * accessing a chunk via chunk(), component(), or aux_data_column()
+     * asks the operating system to read the next chunk ahead of time,
+     * passing over the stored samples from the first to the last chunk --
+     * as an analysis of the stored samples, or a Producers::Range object
+     * given begin() and end(), typically does -- reads the file
+     * sequentially.
+     *
+     * The views returned by chunk(), component(), and aux_data_column()
+     * refer to the mapping for chunks that are full (waiting for the
+     * chunk to be written, if necessary), and so remain valid for as long
+     * as the current object exists. However, the last chunk is kept in
+     * memory until it is full, and views of it that are created while
+     * samples are still being added become invalid once the chunk is full
+     * and has been written to the file.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Samples are stored in the order in which they arrive. The
+     * functions that provide access to the stored samples can be called
+     * while other threads are still adding samples, but the objects they
+     * return only cover the samples stored at the time of the call, and the
+     * range formed by begin() and end() should only be iterated over once
+     * all samples have been added.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. Its
+     *   elements need to have an arithmetic type.
+     */
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class SampleStore : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the components of samples.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The iterator type returned by begin() and end().
+         */
+        using const_iterator = internal::SampleStore::Iterator<InputType>;
+
+        /**
+         * The types of the objects returned by chunk(), component(), and
+         * aux_data_column(), respectively.
+         */
+        using ChunkView = Eigen::Map<const Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>,
+              Eigen::Unaligned, Eigen::OuterStride<>>;
+        using ComponentView     = Eigen::Map<const Eigen::Matrix<scalar_type,Eigen::Dynamic,1>>;
+        using AuxDataColumnView = Eigen::Map<const Eigen::VectorXd>;
+
+        /**
+         * Constructor.
+         *
+         * Because samples are stored in the order in which they arrive and
+         * there is no reason to process them in any particular order, the
+         * class calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as
+         * argument.
+         *
+         * @param[in] aux_data_columns The keys of the auxiliary data entries
+         *   whose values should be stored along with each sample.
+         * @param[in] chunk_size The number of samples each chunk of memory
+         *   has room for. Must be at least one.
+         */
+        SampleStore (const std::vector<AuxiliaryData::Key> &aux_data_columns = {},
+                     const std::size_t                      chunk_size = 16384);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class. If spill_to_file() has been called, it then stops the
+         * writer thread, without writing the chunks still waiting to be
+         * written, and closes the file.
+         */
+        virtual ~SampleStore ();
+
+        /**
+         * Store full chunks in the file with the given name rather than in
+         * memory, and keep at most `max_n_hot_chunks` chunks in memory:
+         * the chunk that is currently being filled, and full chunks that
+         * are still waiting to be written. See the section on storing
+         * samples on disk in the documentation of this class.
+         *
+         * This function has to be called before the first sample arrives.
+         * The file is created (replacing an existing file of that name) and
+         * immediately removed from its directory, so that the space it uses
+         * is returned once the current object is destroyed (or the program
+         * ends), without leaving a file behind.
+         *
+         * @param[in] filename The name of the file. It needs to be on a
+         *   file system with enough space for all samples.
+         * @param[in] max_n_hot_chunks The maximal number of chunks kept in
+         *   memory. Must be at least one.
+         */
+        void
+        spill_to_file (const std::string &filename,
+                       const std::size_t  max_n_hot_chunks = 4);
+
+        /**
+         * Process one sample by appending it, and the selected entries
+         * of its auxiliary data, to the stored samples.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only stores the entries selected in the constructor and
+         *   ignores all others.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the number of samples stored so far.
+         */
+        std::size_t
+        size () const;
+
+        /**
+         * Return the number of components of each sample, or zero if no
+         * samples have been stored so far.
+         */
+        std::size_t
+        n_components () const;
+
+        /**
+         * Return the number of chunks of memory used so far. All but the
+         * last of these are full.
+         */
+        std::size_t
+        n_chunks () const;
+
+        /**
+         * Allocate the chunks needed to store the announced number of
+         * samples, so that storing them does not require allocating memory.
+         * See Consumer::prepare_for_samples(). This function does nothing if
+         * spill_to_file() has been called.
+         */
+        virtual
+        void
+        prepare_for_samples (const SampleShape &shape) override;
+
+        /**
+         * Return the memory used by the chunks allocated so far, including
+         * the ones allocated up front by prepare_for_samples() that are not
+         * used yet. Chunks that have been written to a file (see
+         * spill_to_file()) are not counted.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+        /**
+         * Return the sample with the given index, starting at zero for the
+         * first sample stored.
+         */
+        InputType
+        operator[] (const std::size_t index) const;
+
+        /**
+         * Return the value of the selected auxiliary data entry with the
+         * given index (in the list of keys passed to the constructor) for
+         * the sample with the given index.
+         */
+        double
+        aux_data (const std::size_t index,
+                  const unsigned int column) const;
+
+        /**
+         * Return a view of the samples stored in the chunk with the given
+         * index, as a matrix in which each row corresponds to a sample and
+         * each column to a component. The matrix has `chunk_size` rows for
+         * all but the last chunk.
+         */
+        ChunkView
+        chunk (const std::size_t chunk_index) const;
+
+        /**
+         * Return a view of the given component of all samples stored in the
+         * chunk with the given index. This is the same as column
+         * `component_index` of `chunk(chunk_index)`, but returns a vector
+         * stored contiguously in memory.
+         */
+        ComponentView
+        component (const std::size_t chunk_index,
+                   const std::size_t component_index) const;
+
+        /**
+         * Return a view of the values of one of the selected auxiliary data
+         * entries for all samples stored in the chunk with the given index.
+         */
+        AuxDataColumnView
+        aux_data_column (const std::size_t  chunk_index,
+                         const unsigned int column) const;
+
+        /**
+         * Return iterators to the first sample and past the last sample
+         * stored so far.
+         */
+        const_iterator
+        begin () const;
+
+        const_iterator
+        end () const;
+
+      private:
+        /**
+         * A mutex used to lock access to all member variables when running
+         * on multiple threads.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The keys of the auxiliary data entries to be stored.
+         */
+        const std::vector<AuxiliaryData::Key> aux_data_columns;
+
+        /**
+         * The number of samples per chunk.
+         */
+        const std::size_t chunk_size;
+
+        /**
+         * The number of components of each sample. It is determined by the
+         * first sample.
+         */
+        std::size_t dimension;
+
+        /**
+         * The number of samples stored so far.
+         */
+        std::size_t n_samples;
+
+        /**
+         * A structure that represents one chunk of memory. `components`
+         * points to `chunk_size*dimension` scalars: first the first
+         * component of all samples in this chunk, then the second one, etc.
+         * `aux_data_values` similarly points to `chunk_size` values for each
+         * auxiliary data column. While the chunk is in memory, the two
+         * pointers point to the memory owned by `component_memory` and
+         * `aux_data_memory`; once the chunk has been written to a file
+         * (see spill_to_file()), this memory is released and the pointers
+         * point into the mapping of the file.
+         */
+        struct Chunk
+        {
+          std::unique_ptr<scalar_type[]> component_memory;
+          std::unique_ptr<double[]>      aux_data_memory;
+
+          scalar_type *components;
+          double      *aux_data_values;
+        };
+
+        /**
+         * The chunks allocated so far. This may include chunks allocated
+         * by prepare_for_samples() that are not in use yet.
+         */
+        std::vector<Chunk> chunks;
+
+        /**
+         * Return a newly allocated chunk for samples with `dimension`
+         * components.
+         */
+        Chunk
+        allocate_chunk () const;
+
+        /**
+         * A structure that describes the file to which full chunks are
+         * written after spill_to_file() has been called. Each chunk
+         * occupies `chunk_bytes()` bytes of the file, starting with its
+         * components, followed by the values of the auxiliary data
+         * columns. The file is mapped into memory in segments of
+         * `chunks_per_segment` chunks, each of which is mapped once the
+         * first of its chunks is written, so that the number of mappings
+         * stays small even for very many chunks. All variables other
+         * than `segments` (which only the writer thread accesses while it
+         * runs) are guarded by `mutex`.
+         */
+        struct Spill
+        {
+          int                      fd;
+          std::size_t              max_n_hot_chunks;
+          std::size_t              chunks_per_segment;
+          std::vector<char *>      segments;
+
+          /**
+           * The number of chunks that are currently held in memory, the
+           * number of chunks that have been written to the file (these
+           * are always the first chunks), and the chunks that are full and
+           * waiting to be written.
+           */
+          std::size_t              n_hot_chunks;
+          std::size_t              n_spilled_chunks;
+          std::deque<std::size_t>  chunks_to_write;
+
+          /**
+           * Whether the destructor has asked the writer thread to stop.
+           */
+          bool                     shutting_down;
+
+          /**
+           * A condition variable used by the writer thread to wait for
+           * work, and by all other threads to wait for chunks to be
+           * written.
+           */
+          std::condition_variable  state_changed;
+
+          /**
+           * The thread that writes full chunks to the file.
+           */
+          std::thread              writer;
+        };
+
+        /**
+         * The state of the file to which chunks are written, or a
+         * `nullptr` if spill_to_file() has not been called.
+         */
+        std::unique_ptr<Spill> spill;
+
+        /**
+         * Return the number of bytes a chunk occupies in the file. This is
+         * a multiple of the page size, so that each chunk starts at a page
+         * boundary.
+         */
+        std::size_t
+        chunk_bytes () const;
+
+        /**
+         * Return the number of bytes of a chunk that store the components
+         * of its samples, rounded up so that the values of the auxiliary
+         * data columns that follow them are properly aligned.
+         */
+        std::size_t
+        component_bytes () const;
+
+        /**
+         * If the chunk with the given index has been written to the file,
+         * ask the operating system to read the one following it ahead of
+         * time. The caller needs to hold `mutex`.
+         */
+        void
+        prefetch_after (const std::size_t chunk_index) const;
+
+        /**
+         * Wait until the chunk with the given index has been written to
+         * the file if it is full and spill_to_file() has been called. The
+         * lock passed as argument needs to hold `mutex`.
+         */
+        void
+        wait_until_spilled (const std::size_t             chunk_index,
+                            std::unique_lock<std::mutex> &lock) const;
+
+        /**
+         * The function run by the writer thread.
+         */
+        void
+        writer_loop ();
+    };
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SampleStore<InputType>::
+    SampleStore (const std::vector<AuxiliaryData::Key> &aux_data_columns,
+                 const std::size_t                      chunk_size)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      aux_data_columns (aux_data_columns),
+      chunk_size (chunk_size),
+      dimension (0),
+      n_samples (0)
+    {
+      assert (chunk_size >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SampleStore<InputType>::
+    ~SampleStore ()
+    {
+      this->disconnect_and_flush();
+
+      if (spill != nullptr)
+        {
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            spill->shutting_down = true;
+            spill->chunks_to_write.clear();
+          }
+          spill->state_changed.notify_all();
+          spill->writer.join();
+
+          const std::size_t segment_bytes = spill->chunks_per_segment * chunk_bytes();
+          for (char *segment : spill->segments)
+            munmap (segment, segment_bytes);
+          ::close (spill->fd);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    spill_to_file (const std::string &filename,
+                   const std::size_t  max_n_hot_chunks)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      assert (n_samples == 0);
+      assert (spill == nullptr);
+      assert (max_n_hot_chunks >= 1);
+
+      // Release chunks that may have been allocated up front:
+      chunks.clear();
+
+      const int fd = ::open (filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      assert (fd >= 0);
+      ::unlink (filename.c_str());
+
+      spill = std::make_unique<Spill>();
+      spill->fd                 = fd;
+      spill->max_n_hot_chunks   = max_n_hot_chunks;
+      spill->chunks_per_segment = 0;
+      spill->n_hot_chunks       = 0;
+      spill->n_spilled_chunks   = 0;
+      spill->shutting_down      = false;
+      spill->writer = std::thread ([this]()
+      {
+        writer_loop ();
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      // If chunks are written to a file, we share our state with the
+      // writer thread, and so need the lock even in single-threaded mode:
+      std::unique_lock<std::mutex> lock = (spill != nullptr
+                                           ?
+                                           std::unique_lock<std::mutex> (mutex)
+                                           :
+                                           this->lock_state (mutex));
+
+      // The first sample determines the number of components. If chunks
+      // have been allocated up front for samples of a different size,
+      // then the announcement was wrong, and we have to start over:
+      if (n_samples == 0)
+        {
+          const std::size_t sample_size = Utilities::size(sample);
+          if (sample_size != dimension)
+            chunks.clear();
+          dimension = sample_size;
+        }
+      assert (static_cast<std::size_t>(Utilities::size(sample)) == dimension);
+
+      // Use the next chunk if the current one is full, and allocate it
+      // unless this has been done up front:
+      const std::size_t chunk_index = n_samples / chunk_size;
+      const std::size_t position    = n_samples % chunk_size;
+      if (chunk_index == chunks.size())
+        {
+          // If chunks are written to a file, wait until the writer has
+          // made room for another chunk in memory:
+          if (spill != nullptr)
+            {
+              spill->state_changed.wait (lock, [this]()
+              {
+                return (spill->n_hot_chunks < spill->max_n_hot_chunks);
+              });
+              ++spill->n_hot_chunks;
+            }
+          chunks.emplace_back (allocate_chunk());
+        }
+      Chunk &chunk = chunks[chunk_index];
+
+      for (std::size_t i=0; i<dimension; ++i)
+        chunk.components[i*chunk_size + position] = Utilities::get_nth_element (sample, i);
+
+      for (unsigned int c=0; c<aux_data_columns.size(); ++c)
+        {
+          double value = std::numeric_limits<double>::quiet_NaN();
+          const auto entry = aux_data.find (aux_data_columns[c]);
+          if (entry != aux_data.end())
+            ChainFileFormat::internal::convert_any (entry->second, value);
+          chunk.aux_data_values[c*chunk_size + position] = value;
+        }
+
+      ++n_samples;
+
+      // Hand the chunk to the writer thread if it is full:
+      if ((spill != nullptr) && (position == chunk_size-1))
+        {
+          spill->chunks_to_write.push_back (chunk_index);
+          lock.unlock();
+          spill->state_changed.notify_all();
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    size () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return n_samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    n_components () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return dimension;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    n_chunks () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return (n_samples + chunk_size - 1) / chunk_size;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    prepare_for_samples (const SampleShape &shape)
+    {
+      if ((shape.n_components.has_value() == false)
+          ||
+          (shape.n_samples.has_value() == false)
+          ||
+          (spill != nullptr))
+        return;
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      if (n_samples == 0)
+        {
+          if (*shape.n_components != dimension)
+            chunks.clear();
+          dimension = *shape.n_components;
+        }
+      else if (*shape.n_components != dimension)
+        return;
+
+      const std::size_t n_chunks_needed
+        = (n_samples + *shape.n_samples + chunk_size - 1) / chunk_size;
+      chunks.reserve (n_chunks_needed);
+      while (chunks.size() < n_chunks_needed)
+        chunks.emplace_back (allocate_chunk());
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::Chunk
+    SampleStore<InputType>::
+    allocate_chunk () const
+    {
+      Chunk chunk;
+      chunk.component_memory = std::make_unique<scalar_type[]>(chunk_size * dimension);
+      chunk.aux_data_memory  = std::make_unique<double[]>(chunk_size * aux_data_columns.size());
+      chunk.components       = chunk.component_memory.get();
+      chunk.aux_data_values  = chunk.aux_data_memory.get();
+      return chunk;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    component_bytes () const
+    {
+      return ((chunk_size * dimension * sizeof(scalar_type) + alignof(double) - 1)
+              / alignof(double) * alignof(double));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    chunk_bytes () const
+    {
+      const std::size_t page_size = sysconf (_SC_PAGESIZE);
+      const std::size_t bytes = component_bytes() + chunk_size * aux_data_columns.size() * sizeof(double);
+      return std::max<std::size_t> ((bytes + page_size - 1) / page_size, 1) * page_size;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    writer_loop ()
+    {
+      while (true)
+        {
+          std::size_t        chunk_index;
+          const scalar_type *components;
+          const double      *aux_data_values;
+          {
+            // Wait until there is something to write, or until we are asked
+            // to shut down:
+            std::unique_lock<std::mutex> lock (mutex);
+            spill->state_changed.wait (lock, [this]()
+            {
+              return (spill->shutting_down || (spill->chunks_to_write.size() > 0));
+            });
+            if (spill->shutting_down)
+              return;
+
+            // The chunk is full and nobody writes to it any more, so we can
+            // read from it without holding the lock, even if other threads
+            // add chunks in the meantime:
+            chunk_index     = spill->chunks_to_write.front();
+            components      = chunks[chunk_index].components;
+            aux_data_values = chunks[chunk_index].aux_data_values;
+          }
+
+          // Map the segment of the file the chunk belongs to if this is the
+          // first chunk of it. Segments are a bit larger than 64 MB unless
+          // chunks are larger than that.
+          const std::size_t bytes_per_chunk = chunk_bytes();
+          if (spill->chunks_per_segment == 0)
+            spill->chunks_per_segment = std::max<std::size_t> ((std::size_t(64) << 20) / bytes_per_chunk, 1);
+          const std::size_t segment_bytes = spill->chunks_per_segment * bytes_per_chunk;
+          const std::size_t segment       = chunk_index / spill->chunks_per_segment;
+          if (segment == spill->segments.size())
+            {
+              [[maybe_unused]] int ierr = ftruncate (spill->fd, (segment+1) * segment_bytes);
+              assert (ierr == 0);
+
+              void *const address = mmap (nullptr, segment_bytes, PROT_READ, MAP_SHARED,
+                                          spill->fd, segment * segment_bytes);
+              assert (address != MAP_FAILED);
+              ierr = madvise (address, segment_bytes, MADV_SEQUENTIAL);
+              assert (ierr == 0);
+              spill->segments.push_back (static_cast<char *>(address));
+            }
+
+          // Write the chunk:
+          const std::size_t offset = chunk_index * bytes_per_chunk;
+          const auto write = [this](const void *data, std::size_t n_bytes, std::size_t offset)
+          {
+            const char *p = static_cast<const char *>(data);
+            while (n_bytes > 0)
+              {
+                const ssize_t n_written = pwrite (spill->fd, p, n_bytes, offset);
+                assert (n_written > 0);
+                p       += n_written;
+                n_bytes -= n_written;
+                offset  += n_written;
+              }
+          };
+          write (components, chunk_size * dimension * sizeof(scalar_type), offset);
+          write (aux_data_values, chunk_size * aux_data_columns.size() * sizeof(double),
+                 offset + component_bytes());
+
+          // Then point the chunk to the mapping of the file and release its
+          // memory:
+          char *const mapped_chunk = spill->segments[segment]
+                                     + (chunk_index % spill->chunks_per_segment) * bytes_per_chunk;
+          Chunk released_chunk;
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            Chunk &chunk = chunks[chunk_index];
+            chunk.components      = reinterpret_cast<scalar_type *>(mapped_chunk);
+            chunk.aux_data_values = reinterpret_cast<double *>(mapped_chunk + component_bytes());
+            released_chunk.component_memory = std::move(chunk.component_memory);
+            released_chunk.aux_data_memory  = std::move(chunk.aux_data_memory);
+
+            spill->chunks_to_write.pop_front();
+            --spill->n_hot_chunks;
+            ++spill->n_spilled_chunks;
+          }
+          spill->state_changed.notify_all();
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    wait_until_spilled (const std::size_t             chunk_index,
+                        std::unique_lock<std::mutex> &lock) const
+    {
+      if ((spill != nullptr) && ((chunk_index+1)*chunk_size <= n_samples))
+        spill->state_changed.wait (lock, [this, chunk_index]()
+      {
+        return (chunk_index < spill->n_spilled_chunks);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SampleStore<InputType>::
+    prefetch_after (const std::size_t chunk_index) const
+    {
+      if ((spill != nullptr) && (chunk_index+1 < spill->n_spilled_chunks))
+        madvise (chunks[chunk_index+1].components, chunk_bytes(), MADV_WILLNEED);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::size_t
+    SampleStore<InputType>::
+    memory_consumption () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      const std::size_t n_chunks_in_memory = (spill != nullptr
+                                              ?
+                                              spill->n_hot_chunks
+                                              :
+                                              chunks.size());
+      return (chunks.capacity() * sizeof(Chunk)
+              +
+              n_chunks_in_memory * chunk_size * (dimension * sizeof(scalar_type)
+                                                 + aux_data_columns.size() * sizeof(double)));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    InputType
+    SampleStore<InputType>::
+    operator[] (const std::size_t index) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      assert (index < n_samples);
+
+      const scalar_type *components = chunks[index / chunk_size].components
+                                      + (index % chunk_size);
+
+      InputType sample;
+      if constexpr (requires (InputType &s) { s.resize (std::size_t()); })
+        sample.resize (dimension);
+      assert (static_cast<std::size_t>(Utilities::size(sample)) == dimension);
+
+      for (std::size_t i=0; i<dimension; ++i)
+        Utilities::get_nth_element (sample, i) = components[i*chunk_size];
+
+      return sample;
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    double
+    SampleStore<InputType>::
+    aux_data (const std::size_t index,
+              const unsigned int column) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      assert (index < n_samples);
+      assert (column < aux_data_columns.size());
+
+      return chunks[index / chunk_size].aux_data_values[column*chunk_size + index % chunk_size];
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::ChunkView
+    SampleStore<InputType>::
+    chunk (const std::size_t chunk_index) const
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      assert (chunk_index*chunk_size < n_samples);
+      wait_until_spilled (chunk_index, lock);
+      prefetch_after (chunk_index);
+
+      const std::size_t n_rows = std::min (chunk_size, n_samples - chunk_index*chunk_size);
+      return ChunkView (chunks[chunk_index].components,
+                        n_rows, dimension,
+                        Eigen::OuterStride<>(chunk_size));
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::ComponentView
+    SampleStore<InputType>::
+    component (const std::size_t chunk_index,
+               const std::size_t component_index) const
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      assert (chunk_index*chunk_size < n_samples);
+      assert (component_index < dimension);
+      wait_until_spilled (chunk_index, lock);
+      prefetch_after (chunk_index);
+
+      const std::size_t n_rows = std::min (chunk_size, n_samples - chunk_index*chunk_size);
+      return ComponentView (chunks[chunk_index].components + component_index*chunk_size,
+                            n_rows);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::AuxDataColumnView
+    SampleStore<InputType>::
+    aux_data_column (const std::size_t  chunk_index,
+                     const unsigned int column) const
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      assert (chunk_index*chunk_size < n_samples);
+      assert (column < aux_data_columns.size());
+      wait_until_spilled (chunk_index, lock);
+      prefetch_after (chunk_index);
+
+      const std::size_t n_rows = std::min (chunk_size, n_samples - chunk_index*chunk_size);
+      return AuxDataColumnView (chunks[chunk_index].aux_data_values + column*chunk_size,
+                                n_rows);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::const_iterator
+    SampleStore<InputType>::
+    begin () const
+    {
+      return const_iterator (this, 0);
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SampleStore<InputType>::const_iterator
+    SampleStore<InputType>::
+    end () const
+    {
+      return const_iterator (this, size());
+    }
+  }
+}
@@ -0,0 +1,674 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    namespace internal
+    {
+      namespace ShardedChainOutput
+      {
+        /**
+         * A counter that gives every ShardedChainOutput object a number
+         * that is never reused, so that threads can cache which shard of
+         * which object they last wrote to without being confused by an
+         * object that is later created at the same address.
+         */
+        inline std::atomic<std::uint64_t> next_object_id {0};
+      }
+    }
+
+
+    /**
+     * A Consumer class that writes the samples it receives into a set of
+     * files, each in the binary format described in the documentation of
+     * namespace ChainFileFormat, along with an index file that describes
+     * which file contains what.
+     *
+     * If many chains run in parallel and all of them send their samples to
+     * a single StreamOutput object, then all of these threads serialize on
+     * the mutex of that object and on the single stream it writes to. In
+     * contrast, this class writes one file ("shard") per chain (as
+     * determined by the AuxiliaryData::chain_number entry of the
+     * auxiliary data of samples) or one file per thread that sends samples,
+     * depending on the ShardBy argument of the constructor. Each shard has
+     * its own buffer and its own lock, and the latter is only ever contended
+     * if several threads send samples of the same chain (or if flush() is
+     * called while samples are sent), so that writing samples scales with
+     * the number of threads that produce them.
+     *
+     * The shards are named `<base>.shard<k>`, where `<base>` is the name
+     * given to the constructor and `<k>` is the chain number, or for
+     * ShardBy::thread, the number of the thread in the order in which
+     * threads first sent a sample to the current object. Each of them can
+     * be read by Producers::ChainFile, which provides random access to
+     * the samples of a shard; different shards can therefore also be read
+     * in parallel. Samples are written in the order in which they arrive at
+     * a shard, and for ShardBy::chain, a shard therefore contains the
+     * samples of one chain in the order in which that chain produced them.
+     *
+     * Whenever flush() is called (in particular, whenever the producers
+     * connected to the current object finish a call to their `sample()`
+     * functions, and when the current object is destroyed), the class also
+     * writes an index file named `<base>.index`. It is a text file whose
+     * first line is `SFSHARDS 1` (a magic string and the version of the
+     * format), whose second line contains the number of shards, and each of
+     * whose following lines describes one shard via the values of the
+     * members of ShardDescription, separated by spaces: the shard key, the
+     * number of samples, the offset of the first sample from the beginning
+     * of the file, the size of each sample's record in bytes, and the name
+     * of the file. Since all records of a shard have the same size, the
+     * byte offset of sample $i$ of a shard is then
+     * ShardDescription::byte_offset(i), and a reader can seek directly to
+     * any range of samples of any chain. The index can be read via
+     * read_index().
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Since the point of the class is to let the threads that
+     * produce samples write them in parallel, it only supports
+     * ParallelMode::synchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The scalar
+     *   type of this type (see types::ScalarType) must be an arithmetic
+     *   type.
+     */
+    template <typename InputType>
+    class ShardedChainOutput : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The ways in which samples can be distributed to shards.
+         */
+        enum class ShardBy
+        {
+          /**
+           * Write one shard per chain, as identified by the
+           * AuxiliaryData::chain_number entry of the auxiliary data of each
+           * sample. Samples without such an entry are considered part of
+           * chain zero.
+           */
+          chain,
+
+          /**
+           * Write one shard per thread that sends samples to the current
+           * object.
+           */
+          thread
+        };
+
+        /**
+         * A structure that describes one shard, as listed in the index file.
+         */
+        struct ShardDescription
+        {
+          /**
+           * The chain number, or the number of the thread, whose samples are
+           * stored in the shard.
+           */
+          std::uint64_t shard_key = 0;
+
+          /**
+           * The number of samples stored in the shard.
+           */
+          std::uint64_t n_samples = 0;
+
+          /**
+           * The offset of the first sample from the beginning of the file,
+           * i.e., the size of the header of the file.
+           */
+          std::uint64_t payload_offset = 0;
+
+          /**
+           * The number of bytes each sample occupies in the file.
+           */
+          std::uint64_t record_size = 0;
+
+          /**
+           * The name of the file.
+           */
+          std::string filename;
+
+          /**
+           * Return the offset of the sample with the given index from the
+           * beginning of the file.
+           */
+          std::uint64_t
+          byte_offset (const std::uint64_t sample_index) const;
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] base_filename The names of the shards and of the index
+         *   file are formed by appending `.shard<k>` and `.index` to this
+         *   name. Existing files of these names are overwritten.
+         * @param[in] shard_by How to distribute samples to shards.
+         * @param[in] aux_data_columns The entries of the auxiliary data to
+         *   be stored along with each sample, see ChainFileFormat.
+         * @param[in] buffer_size The number of bytes each shard collects
+         *   before it writes them to its file.
+         * @param[in] backend How the shards are written. With
+         *   FileWriterBackend::direct, each shard is written through a
+         *   DirectFileWriter object, i.e., with asynchronous writes that
+         *   bypass the page cache. This object has three buffers of size
+         *   `buffer_size` of its own for each shard.
+         */
+        ShardedChainOutput (const std::string                           &base_filename,
+                            const ShardBy                                shard_by = ShardBy::chain,
+                            const std::vector<ChainFileFormat::Column>  &aux_data_columns = {},
+                            const std::size_t                            buffer_size = 1024*1024,
+                            const FileWriterBackend                      backend = FileWriterBackend::standard);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed and written
+         * to their files, and that the index file is up to date. To this
+         * end, it calls the Consumers::disconnect_and_flush() function of
+         * the base class.
+         */
+        virtual ~ShardedChainOutput ();
+
+        /**
+         * Process one sample by appending it to the buffer of the shard it
+         * belongs to, and writing the buffer to the shard's file if it is
+         * full.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the AuxiliaryData::chain_number entry to choose the
+         *   shard (for ShardBy::chain), and stores the entries given to
+         *   the constructor.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Write the buffers of all shards to their files, and write the
+         * index file.
+         */
+        virtual
+        void
+        flush () override;
+
+        /**
+         * Return the description of all shards that have been created so
+         * far, in the order of their keys. This is what flush() writes to
+         * the index file.
+         */
+        std::vector<ShardDescription>
+        get () const;
+
+        /**
+         * Return the name of the index file.
+         */
+        std::string
+        index_filename () const;
+
+        /**
+         * Read the index file with the given name, and return the
+         * descriptions of the shards stored in it.
+         */
+        static
+        std::vector<ShardDescription>
+        read_index (const std::string &index_filename);
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::chain_number (for ShardBy::chain) and
+         * the ones passed to the constructor.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+      private:
+        /**
+         * The state of one shard.
+         */
+        struct Shard
+        {
+          /**
+           * A mutex that guards the other members.
+           */
+          std::mutex mutex;
+
+          /**
+           * The file and its name.
+           */
+          std::unique_ptr<std::streambuf> file;
+          std::string   filename;
+
+          /**
+           * The header of the file. Its `dimension` is zero until the
+           * first sample has arrived.
+           */
+          ChainFileFormat::Header header;
+
+          /**
+           * The bytes that have not been written to the file yet.
+           */
+          std::vector<char> buffer;
+
+          /**
+           * The number of samples stored in the shard, and the size of the
+           * header of its file.
+           */
+          std::uint64_t n_samples      = 0;
+          std::uint64_t payload_offset = 0;
+        };
+
+        /**
+         * The name from which the names of all files are formed.
+         */
+        const std::string base_filename;
+
+        /**
+         * How samples are distributed to shards.
+         */
+        const ShardBy shard_by;
+
+        /**
+         * The auxiliary data columns stored with each sample.
+         */
+        const std::vector<ChainFileFormat::Column> aux_data_columns;
+
+        /**
+         * The number of bytes each shard collects before writing them.
+         */
+        const std::size_t buffer_size;
+
+        /**
+         * How the shards are written.
+         */
+        const FileWriterBackend backend;
+
+        /**
+         * A number that identifies the current object, see
+         * internal::ShardedChainOutput::next_object_id.
+         */
+        const std::uint64_t object_id;
+
+        /**
+         * The shards, indexed by their keys, along with a mutex that guards
+         * this map (but not the shards themselves). The map is only
+         * modified when a sample for a new shard arrives. For
+         * ShardBy::thread, also keep track of which thread writes to which
+         * shard.
+         */
+        mutable std::shared_mutex                         shards_mutex;
+        std::map<std::uint64_t, std::unique_ptr<Shard>>   shards;
+        std::map<std::thread::id, std::uint64_t>          thread_keys;
+
+        /**
+         * A mutex that serializes writing the index file, since several
+         * producers may call flush() at the same time.
+         */
+        mutable std::mutex index_mutex;
+
+        /**
+         * Return the shard the sample with the given auxiliary data belongs
+         * to, creating it if necessary.
+         */
+        Shard &
+        get_shard (const AuxiliaryData &aux_data);
+
+        /**
+         * Write the buffer of the given shard to its file. The caller needs
+         * to hold the mutex of the shard.
+         */
+        void
+        write_buffer (Shard &shard);
+
+        /**
+         * Write the index file.
+         */
+        void
+        write_index () const;
+    };
+
+
+
+    template <typename InputType>
+    std::uint64_t
+    ShardedChainOutput<InputType>::ShardDescription::
+    byte_offset (const std::uint64_t sample_index) const
+    {
+      return payload_offset + sample_index * record_size;
+    }
+
+
+
+    template <typename InputType>
+    ShardedChainOutput<InputType>::
+    ShardedChainOutput (const std::string                           &base_filename,
+                        const ShardBy                                shard_by,
+                        const std::vector<ChainFileFormat::Column>  &aux_data_columns,
+                        const std::size_t                            buffer_size,
+                        const FileWriterBackend                      backend)
+      :
+      Consumer<InputType>(ParallelMode::synchronous),
+      base_filename (base_filename),
+      shard_by (shard_by),
+      aux_data_columns (aux_data_columns),
+      buffer_size (buffer_size),
+      backend (backend),
+      object_id (internal::ShardedChainOutput::next_object_id.fetch_add (1))
+    {
+      static_assert (std::is_arithmetic_v<types::ScalarType<InputType>>,
+                     "This class can only write samples whose scalar type is "
+                     "an arithmetic type.");
+      assert (buffer_size > 0);
+    }
+
+
+
+    template <typename InputType>
+    ShardedChainOutput<InputType>::
+    ~ShardedChainOutput ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    void
+    ShardedChainOutput<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      using scalar_type = types::ScalarType<InputType>;
+
+      Shard &shard = get_shard (aux_data);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+
+      // If this is the first sample of the shard, put the header in front
+      // of it:
+      const std::size_t dimension = Utilities::size(sample);
+      if (shard.header.dimension == 0)
+        {
+          shard.header.scalar_kind = ChainFileFormat::scalar_kind<scalar_type>();
+          shard.header.scalar_size = sizeof(scalar_type);
+          shard.header.dimension   = dimension;
+          shard.header.columns     = aux_data_columns;
+
+          shard.buffer = ChainFileFormat::write_header (shard.header);
+          shard.buffer.reserve (buffer_size);
+          shard.payload_offset = shard.buffer.size();
+        }
+      assert (dimension == shard.header.dimension);
+
+      // Then append the record for the current sample:
+      const std::size_t position = shard.buffer.size();
+      shard.buffer.resize (position + shard.header.record_size());
+      ChainFileFormat::write_record (sample, aux_data, shard.header,
+                                     shard.buffer.data() + position);
+      ++shard.n_samples;
+
+      if (shard.buffer.size() >= buffer_size)
+        write_buffer (shard);
+    }
+
+
+
+    template <typename InputType>
+    void
+    ShardedChainOutput<InputType>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+
+      {
+        std::shared_lock<std::shared_mutex> lock (shards_mutex);
+        for (auto &[key, shard] : shards)
+          {
+            std::lock_guard<std::mutex> shard_lock (shard->mutex);
+            write_buffer (*shard);
+            shard->file->pubsync();
+          }
+      }
+
+      write_index ();
+    }
+
+
+
+    template <typename InputType>
+    auto
+    ShardedChainOutput<InputType>::
+    get () const
+    -> std::vector<ShardDescription>
+    {
+      std::vector<ShardDescription> descriptions;
+
+      std::shared_lock<std::shared_mutex> lock (shards_mutex);
+      for (const auto &[key, shard] : shards)
+        {
+          std::lock_guard<std::mutex> shard_lock (shard->mutex);
+
+          ShardDescription description;
+          description.shard_key      = key;
+          description.n_samples      = shard->n_samples;
+          description.payload_offset = shard->payload_offset;
+          description.record_size    = shard->header.record_size();
+          description.filename       = shard->filename;
+          descriptions.push_back (description);
+        }
+
+      return descriptions;
+    }
+
+
+
+    template <typename InputType>
+    std::string
+    ShardedChainOutput<InputType>::
+    index_filename () const
+    {
+      return base_filename + ".index";
+    }
+
+
+
+    template <typename InputType>
+    auto
+    ShardedChainOutput<InputType>::
+    read_index (const std::string &index_filename)
+    -> std::vector<ShardDescription>
+    {
+      std::ifstream in (index_filename);
+      assert (in);
+
+      std::string   magic;
+      unsigned int  version = 0;
+      std::size_t   n_shards = 0;
+      in >> magic >> version >> n_shards;
+      assert (magic == "SFSHARDS");
+      assert (version == 1);
+      (void)version;
+
+      std::vector<ShardDescription> descriptions (n_shards);
+      for (ShardDescription &description : descriptions)
+        {
+          in >> description.shard_key
+             >> description.n_samples
+             >> description.payload_offset
+             >> description.record_size;
+
+          // The file name is the rest of the line, after the separating
+          // space:
+          in.get();
+          std::getline (in, description.filename);
+        }
+      assert (in);
+
+      return descriptions;
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    ShardedChainOutput<InputType>::
+    used_aux_data_keys () const
+    {
+      std::vector<AuxiliaryData::Key> keys;
+      if (shard_by == ShardBy::chain)
+        keys.push_back (AuxiliaryData::chain_number);
+      for (const ChainFileFormat::Column &column : aux_data_columns)
+        keys.push_back (column.key);
+      return keys;
+    }
+
+
+
+    template <typename InputType>
+    auto
+    ShardedChainOutput<InputType>::
+    get_shard (const AuxiliaryData &aux_data)
+    -> Shard &
+    {
+      // Most of the time, a thread sends several samples in a row to the
+      // same shard. Remember which one that was, so that we can skip
+      // looking it up in the map (which, even with a shared lock, requires
+      // every thread to modify the same mutex):
+      struct CachedShard
+      {
+        std::uint64_t object_id = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t key       = 0;
+        Shard        *shard     = nullptr;
+      };
+      thread_local CachedShard cached_shard;
+
+      std::uint64_t key = 0;
+      if (shard_by == ShardBy::chain)
+        {
+          if (const std::size_t *chain_number = aux_data.get_if<std::size_t> (AuxiliaryData::chain_number))
+            key = *chain_number;
+          if ((cached_shard.object_id == object_id) && (cached_shard.key == key))
+            return *cached_shard.shard;
+        }
+      else if (cached_shard.object_id == object_id)
+        return *cached_shard.shard;
+
+      Shard *shard = nullptr;
+      {
+        std::shared_lock<std::shared_mutex> lock (shards_mutex);
+        if (shard_by == ShardBy::thread)
+          {
+            const auto p = thread_keys.find (std::this_thread::get_id());
+            if (p != thread_keys.end())
+              key = p->second;
+            else
+              key = std::numeric_limits<std::uint64_t>::max();
+          }
+
+        const auto p = shards.find (key);
+        if (p != shards.end())
+          shard = p->second.get();
+      }
+
+      // If the shard does not exist yet, create it:
+      if (shard == nullptr)
+        {
+          std::unique_lock<std::shared_mutex> lock (shards_mutex);
+          if (shard_by == ShardBy::thread)
+            key = thread_keys.emplace (std::this_thread::get_id(),
+                                       thread_keys.size()).first->second;
+
+          std::unique_ptr<Shard> &new_shard = shards[key];
+          if (new_shard == nullptr)
+            {
+              new_shard = std::make_unique<Shard>();
+              new_shard->filename = base_filename + ".shard" + std::to_string(key);
+              if (backend == FileWriterBackend::direct)
+                new_shard->file = std::make_unique<DirectFileWriter>(new_shard->filename,
+                                                                     buffer_size, 3);
+              else
+                {
+                  auto file = std::make_unique<std::filebuf>();
+                  [[maybe_unused]] const bool success
+                    = (file->open (new_shard->filename,
+                                   std::ios::out | std::ios::binary | std::ios::trunc) != nullptr);
+                  assert (success);
+                  new_shard->file = std::move (file);
+                }
+            }
+          shard = new_shard.get();
+        }
+
+      cached_shard = {object_id, key, shard};
+      return *shard;
+    }
+
+
+
+    template <typename InputType>
+    void
+    ShardedChainOutput<InputType>::
+    write_buffer (Shard &shard)
+    {
+      if (shard.buffer.size() > 0)
+        {
+          [[maybe_unused]] const std::streamsize written
+            = shard.file->sputn (shard.buffer.data(), shard.buffer.size());
+          assert (written == static_cast<std::streamsize>(shard.buffer.size()));
+          shard.buffer.clear();
+        }
+    }
+
+
+
+    template <typename InputType>
+    void
+    ShardedChainOutput<InputType>::
+    write_index () const
+    {
+      std::lock_guard<std::mutex> lock (index_mutex);
+
+      const std::vector<ShardDescription> descriptions = get();
+
+      std::ostringstream index;
+      index << "SFSHARDS 1\n"
+            << descriptions.size() << '\n';
+      for (const ShardDescription &description : descriptions)
+        index << description.shard_key << ' '
+              << description.n_samples << ' '
+              << description.payload_offset << ' '
+              << description.record_size << ' '
+              << description.filename << '\n';
+
+      // Write to a temporary file first, so that readers never see a
+      // partially written index:
+      const std::string temporary_filename = index_filename() + ".tmp";
+      {
+        std::ofstream out (temporary_filename, std::ios::trunc);
+        out << index.str();
+        out.close();
+        assert (out);
+      }
+      [[maybe_unused]] const int ierr = std::rename (temporary_filename.c_str(),
+                                                     index_filename().c_str());
+      assert (ierr == 0);
+    }
+  }
+}
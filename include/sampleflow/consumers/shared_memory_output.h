@@ -0,0 +1,36 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+#ifndef SAMPLEFLOW_CONSUMERS_SHARED_MEMORY_OUTPUT_H
+#define SAMPLEFLOW_CONSUMERS_SHARED_MEMORY_OUTPUT_H
+
+#include <sampleflow/consumer.h>
+#include <sampleflow/chain_file_format.h>
+#include <sampleflow/parallel_mode.h>
+#include <sampleflow/shared_memory_queue.h>
+#include <sampleflow/types.h>
+
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/consumers/shared_memory_output.impl.h>
+
+#endif
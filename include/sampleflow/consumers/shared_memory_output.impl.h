@@ -0,0 +1,225 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that sends the samples it receives, along with
+     * selected entries of their auxiliary data, to another process on the
+     * same machine through a SharedMemoryQueue. In the other process, a
+     * Producers::SharedMemoryInput object with the same name receives
+     * these samples and sends them on to its own consumers. This makes it
+     * possible to run expensive analyses of the samples (or ones that
+     * happen in other programs altogether) in a separate process without
+     * slowing down the sampler, and the pipeline in the other process
+     * looks exactly as if it were connected to the sampler directly:
+     * @code
+     *   // In the process that runs the sampler:
+     *   SampleFlow::Producers::MetropolisHastings<Eigen::VectorXd> mh_sampler;
+     *   SampleFlow::Consumers::SharedMemoryOutput<Eigen::VectorXd>
+     *     shared_memory_output ("/my-chain", 3);
+     *   shared_memory_output.connect_to_producer (mh_sampler);
+     *   mh_sampler.sample (...);
+     *
+     *   // In the analysis process:
+     *   SampleFlow::Producers::SharedMemoryInput<Eigen::VectorXd>
+     *     shared_memory_input ("/my-chain");
+     *   SampleFlow::Consumers::MeanValue<Eigen::VectorXd> mean_value;
+     *   mean_value.connect_to_producer (shared_memory_input);
+     *   shared_memory_input.sample ();   // returns once the sender is gone
+     * @endcode
+     * The shared memory object is created by the constructor of this class
+     * and removed by its destructor, so the receiving process needs to
+     * connect while the current object exists. (It may, however, continue
+     * to read samples that are still in the queue after the current object
+     * has been destroyed.)
+     *
+     * What happens if the queue is full, because the receiving process
+     * does not keep up, is determined by the QueueFullPolicy given to the
+     * constructor: The sampler either waits, or the oldest samples not
+     * yet read are overwritten. The latter is appropriate if the other
+     * process only monitors the sampler.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from
+     * multiple threads.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. Its
+     *   scalar type (see types::ScalarType) needs to be an arithmetic
+     *   type, and all samples need to have the same number of components.
+     */
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class SharedMemoryOutput : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the scalars that make up a sample.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * Constructor. Create the shared memory object.
+         *
+         * @param[in] name The name of the shared memory object, which should
+         *   start with a slash, see SharedMemoryQueue.
+         * @param[in] dimension The number of components of each sample.
+         * @param[in] aux_data_columns The entries of the auxiliary data of
+         *   each sample that should be sent along with the sample, and the
+         *   types as which they should be sent.
+         * @param[in] n_slots The number of samples the queue can hold.
+         * @param[in] queue_full_policy What to do if the queue is full when
+         *   a sample is to be sent.
+         */
+        SharedMemoryOutput (const std::string                          &name,
+                            const std::size_t                           dimension,
+                            const std::vector<ChainFileFormat::Column> &aux_data_columns = {},
+                            const std::size_t                           n_slots = 4096,
+                            const QueueFullPolicy                       queue_full_policy = QueueFullPolicy::block);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed, then tells
+         * the receiving side that no more samples will follow, and removes
+         * the shared memory object.
+         */
+        virtual ~SharedMemoryOutput ();
+
+        /**
+         * Process one sample by writing it, and the selected entries of its
+         * auxiliary data, into the next slot of the queue.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Return the number of samples that were overwritten before the
+         * receiving process could read them. This can only be nonzero for
+         * QueueFullPolicy::drop_oldest.
+         */
+        std::uint64_t
+        n_dropped_samples () const;
+
+      private:
+        /**
+         * A mutex used to make sure that only one thread at a time writes
+         * into the queue.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The queue through which samples are sent.
+         */
+        SharedMemoryQueue queue;
+
+        /**
+         * What to do if the queue is full.
+         */
+        const QueueFullPolicy queue_full_policy;
+
+        /**
+         * Return the header that describes the records sent through the
+         * queue.
+         */
+        static
+        ChainFileFormat::Header
+        create_header (const std::size_t                           dimension,
+                       const std::vector<ChainFileFormat::Column> &aux_data_columns);
+    };
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SharedMemoryOutput<InputType>::
+    SharedMemoryOutput (const std::string                          &name,
+                        const std::size_t                           dimension,
+                        const std::vector<ChainFileFormat::Column> &aux_data_columns,
+                        const std::size_t                           n_slots,
+                        const QueueFullPolicy                       queue_full_policy)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      queue (name, create_header (dimension, aux_data_columns), n_slots),
+      queue_full_policy (queue_full_policy)
+    {}
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SharedMemoryOutput<InputType>::
+    ~SharedMemoryOutput ()
+    {
+      this->disconnect_and_flush();
+      queue.close();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SharedMemoryOutput<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      char *const slot = queue.begin_write (queue_full_policy);
+      ChainFileFormat::write_record (sample, aux_data, queue.header(), slot);
+      queue.end_write ();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::uint64_t
+    SharedMemoryOutput<InputType>::
+    n_dropped_samples () const
+    {
+      return queue.n_dropped_records();
+    }
+
+
+
+    template <typename InputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+    ChainFileFormat::Header
+    SharedMemoryOutput<InputType>::
+    create_header (const std::size_t                           dimension,
+                   const std::vector<ChainFileFormat::Column> &aux_data_columns)
+    {
+      ChainFileFormat::Header header;
+      header.scalar_kind = ChainFileFormat::scalar_kind<scalar_type>();
+      header.scalar_size = sizeof(scalar_type);
+      header.dimension   = dimension;
+      header.columns     = aux_data_columns;
+      return header;
+    }
+  }
+}
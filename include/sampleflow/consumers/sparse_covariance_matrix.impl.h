@@ -0,0 +1,559 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the covariance matrix of samples that
+     * only store their nonzero elements, such as `Eigen::SparseVector` (see
+     * Concepts::has_sparse_storage), at a cost per sample that is
+     * proportional to the square of the number of nonzero elements of the
+     * sample rather than to the square of the number $d$ of its elements.
+     *
+     * The CovarianceMatrix class updates the $d\times d$ matrix $M$ of
+     * outer products of deviations from the running mean with every
+     * sample. Even if a sample $x$ has only few nonzero elements, the
+     * deviation $x-\bar x$ from the mean generally has none, and every
+     * update costs $O(d^2)$ operations. The current class instead
+     * accumulates the weighted sum of samples $s=\sum_k w_k x_k$ (a dense
+     * vector) and the weighted sum of outer products
+     * $S=\sum_k w_k x_k x_k^T$ (a sparse matrix whose nonzero entries are
+     * those $S_{ij}$ for which some sample has both $x_i\neq 0$ and
+     * $x_j\neq 0$). With $W=\sum_k w_k$ and the mean $\bar x = s/W$, the
+     * covariance matrix is then
+     * @f{align*}{
+     *   C = \frac{1}{N} \left(S - W \bar x \bar x^T\right)
+     *     = \frac{1}{N} S - u u^T,
+     *   \qquad
+     *   u = \sqrt{\frac{W}{N}}\, \bar x,
+     * @f}
+     * where $N=W-\frac{\sum_k w_k^2}{W}$ is the same normalization the
+     * CovarianceMatrix class uses (i.e., $N=n-1$ for $n$ samples of weight
+     * one). $C$ is generally dense, but it is the difference of a sparse
+     * matrix and a matrix of rank one, and this is how get() returns it:
+     * as an object of type `value_type` that stores $\frac 1N S$ and $u$,
+     * and from which one can compute individual entries of $C$, products
+     * of $C$ with vectors in $O(\text{nnz}(S)+d)$ operations, or (if $d$
+     * is small enough) the dense matrix $C$.
+     *
+     * Only the lower triangle of $S$ is accumulated. For each sample, the
+     * class only records the products $w x_i x_j$ of its nonzero elements
+     * in a list; these are added to $S$ once the list has become as long
+     * as $S$ has nonzero entries (or at least $2^{16}$ elements). This
+     * way, the cost of assembling $S$ is, on average, proportional to the
+     * number of products recorded.
+     *
+     *
+     * ### Numerical accuracy ###
+     *
+     * In contrast to the CovarianceMatrix class, the current class
+     * accumulates outer products of the samples themselves, not of their
+     * deviations from the mean -- this is what makes it possible to avoid
+     * dense updates. If the mean of an element is large compared to its
+     * standard deviation, the subtraction of $W \bar x \bar x^T$ then loses
+     * accuracy to cancellation. For sparse samples, most elements of most
+     * samples are zero, so that the means are typically of the same size
+     * as the standard deviations, and this is rarely a problem in practice.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. As in the CovarianceMatrix class, each thread updates its own
+     * partial result, and get() combines them. Since all sums above are
+     * simply added up, combining partial results is straightforward.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. It needs
+     *   to store only the nonzero elements of samples, i.e., satisfy the
+     *   Concepts::has_sparse_storage concept.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    class SparseCovarianceMatrix : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The types of the dense vectors and matrices, and of the sparse
+         * matrices, used by this class.
+         */
+        using vector_type        = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+        using dense_matrix_type  = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+        using sparse_matrix_type = Eigen::SparseMatrix<scalar_type>;
+
+        /**
+         * A structure that represents the covariance matrix as the
+         * difference $C = A - u u^T$ of a sparse, symmetric matrix $A$ and
+         * a matrix of rank one, as described in the documentation of this
+         * class.
+         */
+        struct SparseMinusRankOne
+        {
+          /**
+           * The matrix $A=\frac 1N S$. Both its lower and upper triangle
+           * are stored.
+           */
+          sparse_matrix_type sparse_part;
+
+          /**
+           * The vector $u$.
+           */
+          vector_type        rank_one_factor;
+
+          /**
+           * Return the number of rows (and columns) of $C$.
+           */
+          Eigen::Index
+          size () const;
+
+          /**
+           * Return the entry $C_{ij}$.
+           */
+          scalar_type
+          entry (const Eigen::Index i,
+                 const Eigen::Index j) const;
+
+          /**
+           * Return the product $Cv$.
+           */
+          vector_type
+          multiply (const vector_type &v) const;
+
+          /**
+           * Return $C$ as a dense matrix. This requires $O(d^2)$ memory.
+           */
+          dense_matrix_type
+          to_dense () const;
+        };
+
+        /**
+         * The type of the information generated by this class.
+         */
+        using value_type = SparseMinusRankOne;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         */
+        SparseCovarianceMatrix ();
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~SparseCovarianceMatrix ();
+
+        /**
+         * Process one sample by adding its contributions to the sums
+         * described in the documentation of this class.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses, namely the repetition count and the weight of samples.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return the covariance matrix computed from the samples seen so
+         * far, in the form described in the documentation of this class. If
+         * no samples have been processed so far, then both members of the
+         * returned object are empty.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the mean value of the samples seen so far, as a dense
+         * vector.
+         */
+        vector_type
+        get_mean () const;
+
+        /**
+         * Combine the state of another object with the one of the current
+         * object, so that get() afterwards returns the covariance matrix of
+         * the union of the samples both objects have received.
+         */
+        void
+        merge (const SparseCovarianceMatrix &other);
+
+        /**
+         * Return an estimate of the number of bytes the sums described in
+         * the documentation of this class take up.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * A structure that describes the sums described in the
+         * documentation of this class over a subset of the samples
+         * processed so far, namely those processed on one shard of the
+         * `partial_covariances` variable below.
+         */
+        struct PartialCovariance
+        {
+          /**
+           * The weighted sum $s$ of samples.
+           */
+          vector_type        weighted_sum;
+
+          /**
+           * The lower triangle of the weighted sum $S$ of outer products,
+           * not including the products still in `pending_products`.
+           */
+          sparse_matrix_type sum_of_products;
+
+          /**
+           * Products $w x_i x_j$ not yet added to `sum_of_products`.
+           */
+          std::vector<Eigen::Triplet<scalar_type>> pending_products;
+
+          /**
+           * The sums $W$ and $\sum_k w_k^2$ of weights and squared weights.
+           */
+          double             total_weight = 0;
+          double             total_squared_weight = 0;
+
+          /**
+           * Add the contributions of the given sample, counted
+           * `n_repetitions` times with the given weight each.
+           */
+          void
+          add_sample (const InputType          &sample,
+                      const types::sample_index n_repetitions,
+                      const double              weight);
+
+          /**
+           * Update the current object so that it represents the sums over
+           * the samples represented by both the current object and the
+           * argument.
+           */
+          void
+          merge (const PartialCovariance &other);
+
+          /**
+           * Add `pending_products` to `sum_of_products`, and clear the
+           * former.
+           */
+          void
+          compress ();
+        };
+
+        /**
+         * The partial results computed by the threads that have sent
+         * samples to this object.
+         */
+        ShardedAccumulator<PartialCovariance> partial_covariances;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    Eigen::Index
+    SparseCovarianceMatrix<InputType>::SparseMinusRankOne::
+    size () const
+    {
+      return rank_one_factor.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    typename SparseCovarianceMatrix<InputType>::scalar_type
+    SparseCovarianceMatrix<InputType>::SparseMinusRankOne::
+    entry (const Eigen::Index i,
+           const Eigen::Index j) const
+    {
+      assert ((i < size()) && (j < size()));
+      return sparse_part.coeff(i,j) - rank_one_factor[i] * Utilities::conj(rank_one_factor[j]);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    typename SparseCovarianceMatrix<InputType>::vector_type
+    SparseCovarianceMatrix<InputType>::SparseMinusRankOne::
+    multiply (const vector_type &v) const
+    {
+      assert (v.size() == size());
+      return sparse_part * v - rank_one_factor * rank_one_factor.dot(v);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    typename SparseCovarianceMatrix<InputType>::dense_matrix_type
+    SparseCovarianceMatrix<InputType>::SparseMinusRankOne::
+    to_dense () const
+    {
+      return dense_matrix_type(sparse_part) - rank_one_factor * rank_one_factor.adjoint();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    SparseCovarianceMatrix<InputType>::
+    SparseCovarianceMatrix ()
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous)))
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    SparseCovarianceMatrix<InputType>::
+    ~SparseCovarianceMatrix ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    void
+    SparseCovarianceMatrix<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      partial_covariances.update ([&sample, &aux_data](PartialCovariance &partial_covariance)
+      {
+        partial_covariance.add_sample (sample, aux_data.n_repetitions(),
+                                       aux_data.weight());
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    SparseCovarianceMatrix<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    void
+    SparseCovarianceMatrix<InputType>::PartialCovariance::
+    add_sample (const InputType          &sample,
+                const types::sample_index n_repetitions,
+                const double              weight)
+    {
+      const double sample_weight = n_repetitions * weight;
+      if (sample_weight == 0)
+        return;
+
+      const Eigen::Index size = Utilities::size(sample);
+      if (total_weight == 0)
+        {
+          weighted_sum.setZero (size);
+          sum_of_products.resize (size, size);
+        }
+      assert (weighted_sum.size() == size);
+
+      // Record the products of all pairs of nonzero elements with i>=j:
+      for (typename InputType::InnerIterator it_i (sample, 0); it_i; ++it_i)
+        {
+          weighted_sum[it_i.index()] += sample_weight * it_i.value();
+          for (typename InputType::InnerIterator it_j (sample, 0);
+               it_j && (it_j.index() <= it_i.index()); ++it_j)
+            pending_products.emplace_back (it_i.index(), it_j.index(),
+                                           sample_weight * it_i.value() * Utilities::conj(it_j.value()));
+        }
+
+      total_weight += sample_weight;
+      total_squared_weight += n_repetitions * weight * weight;
+
+      if (pending_products.size() >= std::max<std::size_t>(1<<16, sum_of_products.nonZeros()))
+        compress ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    void
+    SparseCovarianceMatrix<InputType>::PartialCovariance::
+    merge (const PartialCovariance &other)
+    {
+      if (other.total_weight == 0)
+        return;
+      if (total_weight == 0)
+        {
+          *this = other;
+          return;
+        }
+
+      assert (other.weighted_sum.size() == weighted_sum.size());
+
+      weighted_sum += other.weighted_sum;
+      sum_of_products += other.sum_of_products;
+      pending_products.insert (pending_products.end(),
+                               other.pending_products.begin(), other.pending_products.end());
+      total_weight += other.total_weight;
+      total_squared_weight += other.total_squared_weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    void
+    SparseCovarianceMatrix<InputType>::PartialCovariance::
+    compress ()
+    {
+      if (pending_products.empty())
+        return;
+
+      // setFromTriplets() adds up products for the same entry:
+      sparse_matrix_type pending (sum_of_products.rows(), sum_of_products.cols());
+      pending.setFromTriplets (pending_products.begin(), pending_products.end());
+      sum_of_products += pending;
+      pending_products.clear();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    typename SparseCovarianceMatrix<InputType>::value_type
+    SparseCovarianceMatrix<InputType>::
+    get () const
+    {
+      PartialCovariance covariance = partial_covariances.merged();
+      if (covariance.total_weight == 0)
+        return {};
+      covariance.compress ();
+
+      // Use the same normalization as the CovarianceMatrix class:
+      double normalization = covariance.total_weight
+                             - covariance.total_squared_weight / covariance.total_weight;
+      if (normalization <= 0)
+        normalization = 1;
+
+      value_type result;
+      result.sparse_part = covariance.sum_of_products.template selfadjointView<Eigen::Lower>();
+      result.sparse_part /= normalization;
+      result.rank_one_factor = covariance.weighted_sum
+                               / std::sqrt(covariance.total_weight * normalization);
+      return result;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    typename SparseCovarianceMatrix<InputType>::vector_type
+    SparseCovarianceMatrix<InputType>::
+    get_mean () const
+    {
+      const PartialCovariance covariance = partial_covariances.merged();
+      if (covariance.total_weight == 0)
+        return {};
+      return covariance.weighted_sum / covariance.total_weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    void
+    SparseCovarianceMatrix<InputType>::
+    merge (const SparseCovarianceMatrix &other)
+    {
+      const PartialCovariance other_covariance = other.partial_covariances.merged();
+      partial_covariances.update ([&other_covariance](PartialCovariance &partial_covariance)
+      {
+        partial_covariance.merge (other_covariance);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType> &&
+              Concepts::has_sparse_storage<InputType>)
+    std::size_t
+    SparseCovarianceMatrix<InputType>::
+    memory_consumption () const
+    {
+      const PartialCovariance covariance = partial_covariances.merged();
+      return (sizeof(PartialCovariance)
+              + Memory::memory_consumption (covariance.weighted_sum)
+              + Memory::memory_consumption (covariance.sum_of_products)
+              + Memory::memory_consumption (covariance.pending_products));
+    }
+  }
+}
@@ -0,0 +1,687 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace SparsePairHistogram
+    {
+      /**
+       * A structure that describes one bin of a SparsePairHistogram: The
+       * integer coordinates of the bin, along with the number of samples
+       * that fell into it and the sum of their weights.
+       */
+      struct Bin
+      {
+        std::int64_t        x_index;
+        std::int64_t        y_index;
+        types::sample_index n_samples;
+        double              weight;
+      };
+
+
+      /**
+       * Return all bins stored in the given table of a two-dimensional
+       * grid, sorted by their first coordinate and, for bins with the same
+       * first coordinate, by their second one.
+       */
+      inline
+      std::vector<Bin>
+      sorted_bins (const SparseGridTable &table)
+      {
+        std::vector<Bin> bins;
+        bins.reserve (table.size());
+        table.for_each_cell ([&bins](const std::int64_t        *index,
+                                     const types::sample_index  n_samples,
+                                     const double               weight)
+        {
+          bins.push_back (Bin {index[0], index[1], n_samples, weight});
+        });
+
+        std::sort (bins.begin(), bins.end(),
+                   [](const Bin &a, const Bin &b)
+        {
+          return std::tie(a.x_index, a.y_index) < std::tie(b.x_index, b.y_index);
+        });
+
+        return bins;
+      }
+    }
+  }
+
+
+
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that, like the PairHistogram class, computes a
+     * joint histogram of two components of vector-valued samples, but does
+     * not require knowing the range of samples beforehand and only uses
+     * memory for those bins that actually contain samples. The sample type
+     * needs to have exactly two components for this class to work.
+     *
+     * The bins this class uses are rectangles of fixed width and height
+     * that tile the entire plane. Specifically, if the constructor is
+     * called with bin widths $h_x,h_y$ and an origin $(x_0,y_0)$, then the
+     * bin with integer coordinates $(i,j)$ is the rectangle
+     * $[x_0+ih_x,x_0+(i+1)h_x) \times [y_0+jh_y,y_0+(j+1)h_y)$. No sample is
+     * ever discarded because it lies outside a pre-determined range; only
+     * samples with components that are not finite numbers are ignored. The
+     * bins that contain samples are stored in a hash table, and so the
+     * memory used by this class is proportional to the number of these
+     * bins, rather than to the number of bins in the bounding box of all
+     * samples: A sample distribution with heavy tails typically leads to a
+     * handful of bins far away from all others, which a PairHistogram with
+     * the same bin size would need to store as a large, mostly empty
+     * matrix.
+     *
+     * Because the number of occupied bins may still grow without bound if
+     * samples keep exploring new parts of the plane, the constructor also
+     * allows specifying a maximal number of occupied bins. Whenever this
+     * number would be exceeded, the class doubles the width and height of
+     * all bins, merging each group of $2\times 2$ bins into one, until the
+     * number of occupied bins is small enough again. Because bins are
+     * always merged this way, the bins of the coarser histogram are still
+     * of the form above, with $h_x,h_y$ replaced by $2^\ell h_x, 2^\ell h_y$
+     * where $\ell$ is the number of times bins have been merged; the bin
+     * widths currently in use can be obtained using get_bin_widths(). The
+     * counts in the coarser bins are exact: They are the sums of the
+     * counts of the finer bins that were merged.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says. If samples carry weights (see AuxiliaryData::sample_weight),
+     * then the class also adds up the weights of the samples in each bin;
+     * these can be obtained via get_weighted().
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Each thread counts samples in its own hash table, stored in a
+     * ShardedAccumulator object, so that threads do not have to wait for
+     * each other. If a maximal number of bins is given, then each of these
+     * tables merges its own bins independently of the others; get() and the
+     * other functions that need the complete histogram then coarsen all
+     * tables to the bin size of the coarsest one before adding them up.
+     * As a consequence, the bin size one ends up with can depend on which
+     * samples were processed by which thread.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class. The requirements on this type are the same as for
+     *   the PairHistogram class.
+     */
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    class SparsePairHistogram : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(). This is the same type as
+         * PairHistogram::value_type, except that the vector returned only
+         * contains those bins that contain samples.
+         */
+        using value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,types::sample_index>>;
+
+        /**
+         * The type of the object returned by get_weighted(). This is the same
+         * as `value_type`, except that the third element of each bin is
+         * the sum of the weights of the samples in the bin.
+         */
+        using weighted_value_type = std::vector<std::tuple<std::array<double,2>,std::array<double,2>,double>>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] x_bin_width The width of the bins in the direction of
+         *   the first component of the samples. Must be positive.
+         * @param[in] y_bin_width The width of the bins in the direction of
+         *   the second component of the samples. Must be positive.
+         * @param[in] max_n_bins The maximal number of bins that contain
+         *   samples. If this number is exceeded, the width and height of all
+         *   bins are doubled as discussed in the documentation of this class.
+         *   A value of zero, the default, means that bins are never merged.
+         *   If not zero, this number needs to be at least four, since even
+         *   the coarsest bins may split the samples into four quadrants.
+         * @param[in] x_origin The first coordinate of a corner shared by
+         *   four bins.
+         * @param[in] y_origin The second coordinate of a corner shared by
+         *   four bins.
+         */
+        SparsePairHistogram (const double      x_bin_width,
+                             const double      y_bin_width,
+                             const std::size_t max_n_bins = 0,
+                             const double      x_origin = 0,
+                             const double      y_origin = 0);
+
+        /**
+         * Copy constructor.
+         */
+        SparsePairHistogram (const SparsePairHistogram<InputType> &o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~SparsePairHistogram ();
+
+        /**
+         * Process one sample by computing which bin it lies in, and then
+         * incrementing the number of samples in the bin.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `value_type` type. The bins are sorted by their left end
+         * point in the first coordinate direction and, for bins with the same
+         * left end point, by their bottom end point in the second coordinate
+         * direction.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the histogram in the format discussed in the documentation
+         * of the `weighted_value_type` type, i.e., with the sum of the
+         * weights of the samples in each bin rather than their number.
+         */
+        weighted_value_type
+        get_weighted () const;
+
+        /**
+         * Return the width of the bins in the two coordinate directions.
+         * These are the widths given to the constructor, multiplied by
+         * $2^\ell$ where $\ell$ is the number of times bins had to be merged
+         * to satisfy the limit on the number of bins.
+         */
+        std::array<double,2>
+        get_bin_widths () const;
+
+        /**
+         * Append the size and position of the bins, along with the bins
+         * that contain samples and the numbers and weights of samples in
+         * them, to the given buffer. See the section on saving and combining
+         * the state of consumers in the documentation of the Consumer base
+         * class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the bins stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read. The object that wrote the
+         * data must have been created with the same arguments to the
+         * constructor as the current one, though it may have merged its bins
+         * a different number of times.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Add the numbers and weights of samples that another object has
+         * counted in each bin to the ones counted by the current object.
+         * Both objects must have been created with the same arguments to
+         * the constructor. If one of the two objects has already merged its
+         * bins more often than the other, then the bins of the other are
+         * merged accordingly first.
+         */
+        void
+        merge (const SparsePairHistogram &other);
+
+      private:
+        /**
+         * The arguments given to the constructor.
+         */
+        const double x_bin_width;
+        const double y_bin_width;
+        const double x_origin;
+        const double y_origin;
+
+        /**
+         * A structure storing the bins that contain samples processed by
+         * one shard of the `partial_histograms` variable below.
+         */
+        struct PartialHistogram
+        {
+          /**
+           * The maximal number of bins, as given to the constructor.
+           */
+          std::size_t max_n_bins = 0;
+
+          /**
+           * The number of times the bins stored in `bins` have been
+           * merged. The bin with coordinates $(i,j)$ in `bins` contains
+           * the samples with coordinates $(i',j')$ with respect to the
+           * bins given to the constructor where $i=\lfloor i'/2^\ell \rfloor$
+           * and $j=\lfloor j'/2^\ell \rfloor$, and $\ell$ is the value of
+           * this variable.
+           */
+          unsigned int level = 0;
+
+          /**
+           * The bins that contain samples.
+           */
+          internal::SparseGridTable bins = internal::SparseGridTable (2);
+
+          /**
+           * Add a sample with the given repetition count and weight to the
+           * bin with the given coordinates. The coordinates are relative to
+           * the bins given to the constructor, not the current, possibly
+           * merged, ones.
+           */
+          void
+          add_sample (const std::int64_t        x_index,
+                      const std::int64_t        y_index,
+                      const types::sample_index n_repetitions,
+                      const double              weight);
+
+          /**
+           * Merge bins until the current object has been coarsened
+           * `new_level` times, and then as many more times as necessary
+           * to bring the number of bins below `max_n_bins`.
+           */
+          void
+          coarsen (const unsigned int new_level);
+
+          /**
+           * Add the bins stored in the argument to the ones stored in the
+           * current object.
+           */
+          void
+          merge (const PartialHistogram &other);
+        };
+
+        /**
+         * The bins counted by the threads that have sent samples to this
+         * object.
+         */
+        ShardedAccumulator<PartialHistogram> partial_histograms;
+
+        /**
+         * For a given `value`, compute the integer coordinate of the bin it
+         * lies in with respect to the bins given to the constructor.
+         */
+        static
+        std::int64_t
+        bin_index (const double value,
+                   const double origin,
+                   const double bin_width);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SparsePairHistogram<InputType>::
+    SparsePairHistogram (const double      x_bin_width,
+                         const double      y_bin_width,
+                         const std::size_t max_n_bins,
+                         const double      x_origin,
+                         const double      y_origin)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      x_bin_width (x_bin_width),
+      y_bin_width (y_bin_width),
+      x_origin (x_origin),
+      y_origin (y_origin),
+      partial_histograms (PartialHistogram {max_n_bins, 0, internal::SparseGridTable (2)})
+    {
+      assert (x_bin_width > 0);
+      assert (y_bin_width > 0);
+      assert ((max_n_bins == 0) || (max_n_bins >= 4));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SparsePairHistogram<InputType>::
+    SparsePairHistogram (const SparsePairHistogram<InputType> &o)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      x_bin_width (o.x_bin_width),
+      y_bin_width (o.y_bin_width),
+      x_origin (o.x_origin),
+      y_origin (o.y_origin),
+      partial_histograms (o.partial_histograms)
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    SparsePairHistogram<InputType>::
+    ~SparsePairHistogram ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      assert (sample.size() == 2);
+
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      // Samples that are not finite do not lie in any bin:
+      const double x = sample[0];
+      const double y = sample[1];
+      if (!std::isfinite(x) || !std::isfinite(y))
+        return;
+
+      const std::int64_t x_index = bin_index (x, x_origin, x_bin_width);
+      const std::int64_t y_index = bin_index (y, y_origin, y_bin_width);
+      const double       weight  = aux_data.weight();
+
+      partial_histograms.update ([=](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.add_sample (x_index, y_index, n_repetitions, weight);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SparsePairHistogram<InputType>::value_type
+    SparsePairHistogram<InputType>::
+    get () const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+      const double x_width = std::ldexp (x_bin_width, histogram.level);
+      const double y_width = std::ldexp (y_bin_width, histogram.level);
+
+      value_type return_value;
+      for (const auto &bin : internal::SparsePairHistogram::sorted_bins (histogram.bins))
+        return_value.emplace_back (std::array<double,2> {x_origin + bin.x_index*x_width,
+                                                         y_origin + bin.y_index*y_width},
+                                   std::array<double,2> {x_origin + (bin.x_index+1)*x_width,
+                                                         y_origin + (bin.y_index+1)*y_width},
+                                   bin.n_samples);
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    typename SparsePairHistogram<InputType>::weighted_value_type
+    SparsePairHistogram<InputType>::
+    get_weighted () const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+      const double x_width = std::ldexp (x_bin_width, histogram.level);
+      const double y_width = std::ldexp (y_bin_width, histogram.level);
+
+      weighted_value_type return_value;
+      for (const auto &bin : internal::SparsePairHistogram::sorted_bins (histogram.bins))
+        return_value.emplace_back (std::array<double,2> {x_origin + bin.x_index*x_width,
+                                                         y_origin + bin.y_index*y_width},
+                                   std::array<double,2> {x_origin + (bin.x_index+1)*x_width,
+                                                         y_origin + (bin.y_index+1)*y_width},
+                                   bin.weight);
+
+      return return_value;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::array<double,2>
+    SparsePairHistogram<InputType>::
+    get_bin_widths () const
+    {
+      const unsigned int level = partial_histograms.merged().level;
+      return {{std::ldexp (x_bin_width, level), std::ldexp (y_bin_width, level)}};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const PartialHistogram histogram = partial_histograms.merged();
+
+      Serialization::write (buffer, std::array<double,4> {{x_bin_width, y_bin_width,
+                                                           x_origin, y_origin
+                                                          }
+                                                         });
+      Serialization::write (buffer, histogram.level);
+      Serialization::write (buffer, internal::SparsePairHistogram::sorted_bins (histogram.bins));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      std::array<double,4> saved_bin_geometry;
+      Serialization::read (buffer, saved_bin_geometry);
+      assert ((saved_bin_geometry == std::array<double,4> {{x_bin_width, y_bin_width,
+                                                            x_origin, y_origin
+                                                           }
+                                                          }));
+
+      unsigned int                                   saved_level;
+      std::vector<internal::SparsePairHistogram::Bin> saved_bins;
+      Serialization::read (buffer, saved_level);
+      Serialization::read (buffer, saved_bins);
+
+      // Put the saved bins into an empty table, keeping the current limit
+      // on the number of bins (which may be smaller than the one of the
+      // object that wrote the data, in which case we have to merge bins):
+      PartialHistogram histogram;
+      histogram.max_n_bins = partial_histograms.merged().max_n_bins;
+      histogram.level      = saved_level;
+      histogram.bins  = internal::SparseGridTable (2);
+      for (const auto &bin : saved_bins)
+        {
+          const std::int64_t index[2] = {bin.x_index, bin.y_index};
+          histogram.bins.add (index, bin.n_samples, bin.weight);
+        }
+      histogram.coarsen (saved_level);
+
+      partial_histograms.reset (histogram);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::
+    merge (const SparsePairHistogram &other)
+    {
+      assert (other.x_bin_width == x_bin_width);
+      assert (other.y_bin_width == y_bin_width);
+      assert (other.x_origin == x_origin);
+      assert (other.y_origin == y_origin);
+
+      const PartialHistogram other_histogram = other.partial_histograms.merged();
+      partial_histograms.update ([&other_histogram](PartialHistogram &partial_histogram)
+      {
+        partial_histogram.merge (other_histogram);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    std::int64_t
+    SparsePairHistogram<InputType>::
+    bin_index (const double value,
+               const double origin,
+               const double bin_width)
+    {
+      // Restrict the coordinate to a range in which it can be represented
+      // as a 64-bit integer, with room to spare for the computation of
+      // the end points of bins. Samples this far away from the origin
+      // are then all counted in the outermost bins.
+      const double max_index = std::ldexp (1., 62);
+      return static_cast<std::int64_t>(std::clamp (std::floor((value - origin) / bin_width),
+                                                   -max_index, max_index));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::PartialHistogram::
+    add_sample (const std::int64_t        x_index,
+                const std::int64_t        y_index,
+                const types::sample_index n_repetitions,
+                const double              weight)
+    {
+      // Shifting a signed integer to the right rounds towards negative
+      // infinity, which is what we need for bins to the left of or below
+      // the origin:
+      const std::int64_t index[2] = {x_index >> level, y_index >> level};
+      bins.add (index, n_repetitions, n_repetitions * weight);
+
+      if ((max_n_bins != 0) && (bins.size() > max_n_bins) && (level < 63))
+        coarsen (level+1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::PartialHistogram::
+    coarsen (const unsigned int new_level)
+    {
+      assert (new_level >= level);
+      assert (new_level <= 63);
+
+      unsigned int target_level = new_level;
+      while (true)
+        {
+          if (target_level > level)
+            {
+              const unsigned int shift = target_level - level;
+
+              internal::SparseGridTable coarse_bins (2);
+              for (const auto &bin : internal::SparsePairHistogram::sorted_bins (bins))
+                {
+                  const std::int64_t index[2] = {bin.x_index >> shift, bin.y_index >> shift};
+                  coarse_bins.add (index, bin.n_samples, bin.weight);
+                }
+
+              bins  = std::move (coarse_bins);
+              level = target_level;
+            }
+
+          // With bin coordinates limited to 63 bits, all samples lie in
+          // one of four bins after 63 rounds of merging at the latest,
+          // and we can stop there:
+          if ((max_n_bins == 0) || (bins.size() <= max_n_bins) || (level >= 63))
+            break;
+          ++target_level;
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_size_function<InputType> &&
+              std::is_arithmetic_v<types::ScalarType<InputType>>)
+    void
+    SparsePairHistogram<InputType>::PartialHistogram::
+    merge (const PartialHistogram &other)
+    {
+      coarsen (std::max (level, other.level));
+
+      const unsigned int shift = level - other.level;
+      for (const auto &bin : internal::SparsePairHistogram::sorted_bins (other.bins))
+        {
+          const std::int64_t index[2] = {bin.x_index >> shift, bin.y_index >> shift};
+          bins.add (index, bin.n_samples, bin.weight);
+        }
+
+      coarsen (level);
+    }
+  }
+}
@@ -0,0 +1,42 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_CONSUMERS_STATE_COUNTS_H
+#define SAMPLEFLOW_CONSUMERS_STATE_COUNTS_H
+
+#include <sampleflow/consumer.h>
+#include <sampleflow/memory.h>
+#include <sampleflow/sample_hash.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/types.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/consumers/state_counts.impl.h>
+
+#endif
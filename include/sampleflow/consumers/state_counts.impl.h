@@ -0,0 +1,513 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that stores every distinct sample it receives only
+     * once, along with the number of times it has been seen, the index of
+     * its first occurrence in the sequence of samples, and its log
+     * likelihood. For discrete models -- or, more generally, for chains that
+     * frequently revisit states, as Metropolis-Hastings chains do whenever
+     * they reject a trial sample -- the number of distinct states is often
+     * much smaller than the number of samples, and the result of get() is a
+     * compact summary of the chain: Each state together with its count is a
+     * weighted sample, and all statistics that do not depend on the order
+     * of samples (mean values, covariances, histograms, expectations of
+     * arbitrary functions) can be computed from this summary just as well
+     * as from the full chain that, for example, the StreamOutput class
+     * would write, with one occurrence of each state per line.
+     *
+     * The log likelihood stored for each state is the one that comes with
+     * its first occurrence as the AuxiliaryData::relative_log_likelihood
+     * entry of the auxiliary data, or a quiet NaN if the sample does not
+     * carry such an entry. Storing it means that the summary can be
+     * re-weighted (for example for importance sampling, or to combine runs
+     * with different likelihoods) without evaluating the likelihood again.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count is counted as many times as this
+     * entry says, and takes up as many indices in the sequence of samples.
+     *
+     * Compared to Consumers::CategoricalHistogram, which also counts how
+     * often each distinct value occurs, this class keeps the log likelihood
+     * and first occurrence of each state, does not require the sample type
+     * to provide `operator==`, and is intended for sample types such as
+     * `std::vector<int>` or `std::valarray<double>` whose objects are
+     * comparatively large. States are compared with SampleEqual and hashed
+     * with SampleHash, both of which read the elements of samples directly
+     * from memory if they are stored contiguously (see
+     * Concepts::has_contiguous_scalar_storage).
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. The states are stored in a hash table that is split into a
+     * number of "shards", each with its own lock, and the shard a state is
+     * stored in is determined by its hash value; the hash value is computed
+     * before any lock is acquired. Threads that process different states
+     * therefore rarely wait for each other, as in the LikelihoodCache
+     * class. The index of a sample is taken from an atomic counter at the
+     * time consume() is called for it, and so the indices reflect the order
+     * in which samples arrive here; this is the order in which the producer
+     * created them unless samples are processed asynchronously (see
+     * ParallelMode) or come from several threads at once.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$ processed
+     *   by this class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    class StateCounts : public Consumer<InputType>
+    {
+      public:
+        /**
+         * A structure describing one distinct state.
+         */
+        struct State
+        {
+          /**
+           * The state itself.
+           */
+          InputType sample;
+
+          /**
+           * The number of samples that were equal to this state.
+           */
+          types::sample_index n_occurrences;
+
+          /**
+           * The index, within the sequence of all samples, of the first
+           * sample that was equal to this state.
+           */
+          types::sample_index first_index;
+
+          /**
+           * The log likelihood attached to the first sample that was equal
+           * to this state, or a quiet NaN if it did not carry one.
+           */
+          double log_likelihood;
+        };
+
+        /**
+         * The type of the information generated by this class, i.e., the
+         * type of the object returned by get(): A vector with one entry for
+         * each distinct state, sorted by the index of its first occurrence.
+         */
+        using value_type = std::vector<State>;
+
+        /**
+         * Constructor.
+         *
+         * This class does not care in which order samples are processed, and
+         * consequently calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as argument.
+         *
+         * @param[in] n_shards The number of independently locked pieces the
+         *   hash table is split into.
+         */
+        StateCounts (const unsigned int n_shards = 16);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~StateCounts ();
+
+        /**
+         * Process one sample by incrementing the count of its state, or
+         * adding a new state if it has not been seen before.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the repetition count and the relative log
+         *   likelihood, and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType sample, AuxiliaryData aux_data) override;
+
+        /**
+         * Process a sample that the caller continues to own. Since this
+         * class only copies a sample when it is a new state, this avoids
+         * the copy that the base class implementation makes.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::relative_log_likelihood and
+         * AuxiliaryData::repetition_count. See
+         * Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return all distinct states seen so far, in the format discussed
+         * in the documentation of the `value_type` type.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the number of distinct states seen so far.
+         */
+        std::size_t
+        n_distinct_states () const;
+
+        /**
+         * Return the number of samples seen so far, counting repeated
+         * samples as often as they are repeated.
+         */
+        types::sample_index
+        n_samples () const;
+
+        /**
+         * Append the states seen, along with their counts, first indices,
+         * and log likelihoods, to the given buffer. See the section on
+         * saving and combining the state of consumers in the documentation
+         * of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the states stored by this object by the ones previously
+         * written by save(), read from the front of the given buffer. The
+         * buffer is advanced past the data read.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Return an estimate of the memory used by the states stored.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * What is stored for each state in the hash table.
+         */
+        struct Entry
+        {
+          types::sample_index n_occurrences;
+          types::sample_index first_index;
+          double              log_likelihood;
+        };
+
+        /**
+         * One of the independently locked pieces of the hash table.
+         */
+        struct Shard
+        {
+          mutable std::mutex mutex;
+          std::unordered_map<InputType,Entry,SampleHash<InputType>,SampleEqual<InputType>> entries;
+        };
+
+        /**
+         * The shards of the hash table.
+         */
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        /**
+         * The number of samples seen so far, which is also the index the
+         * next sample gets.
+         */
+        std::atomic<types::sample_index> sample_counter;
+
+        /**
+         * Add the given number of occurrences of a sample. `SampleRef` is
+         * either `const InputType &` or `InputType`, in which case the
+         * sample is moved into the table if it is a new state.
+         */
+        template <typename SampleRef>
+        void
+        add (SampleRef          &&sample,
+             const AuxiliaryData &aux_data);
+
+        /**
+         * Return the shard in which the sample with the given hash value
+         * is stored.
+         */
+        Shard &
+        shard_for (const std::size_t hash) const;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    StateCounts<InputType>::
+    StateCounts (const unsigned int n_shards)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      sample_counter (0)
+    {
+      assert (n_shards > 0);
+      for (unsigned int s=0; s<n_shards; ++s)
+        shards.emplace_back (std::make_unique<Shard>());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    StateCounts<InputType>::
+    ~StateCounts ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    StateCounts<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      add (std::move(sample), aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    StateCounts<InputType>::
+    consume_by_reference (const InputType     &sample,
+                          const AuxiliaryData &aux_data)
+    {
+      add (sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    StateCounts<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::relative_log_likelihood,
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    template <typename SampleRef>
+    void
+    StateCounts<InputType>::
+    add (SampleRef          &&sample,
+         const AuxiliaryData &aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+
+      const types::sample_index index = sample_counter.fetch_add (n_repetitions,
+                                                                  std::memory_order_relaxed);
+      const double *const log_likelihood
+        = aux_data.get_if<double> (AuxiliaryData::relative_log_likelihood);
+
+      const std::size_t hash = SampleHash<InputType>()(sample);
+      Shard &shard = shard_for (hash);
+
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      const auto p = shard.entries.find (sample);
+      if (p != shard.entries.end())
+        {
+          p->second.n_occurrences += n_repetitions;
+
+          // If several threads add the same state at once, the one with
+          // the smaller index may get here second:
+          if (index < p->second.first_index)
+            {
+              p->second.first_index = index;
+              if (log_likelihood != nullptr)
+                p->second.log_likelihood = *log_likelihood;
+            }
+        }
+      else
+        {
+          const Entry entry = {n_repetitions,
+                               index,
+                               (log_likelihood != nullptr ?
+                                *log_likelihood :
+                                std::numeric_limits<double>::quiet_NaN())
+                              };
+          shard.entries.emplace (std::forward<SampleRef>(sample), entry);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename StateCounts<InputType>::value_type
+    StateCounts<InputType>::
+    get () const
+    {
+      value_type states;
+      for (const auto &shard : shards)
+        {
+          std::lock_guard<std::mutex> lock (shard->mutex);
+          for (const auto &[sample, entry] : shard->entries)
+            states.push_back (State {sample, entry.n_occurrences,
+                                     entry.first_index, entry.log_likelihood});
+        }
+
+      std::sort (states.begin(), states.end(),
+                 [](const State &a, const State &b)
+      {
+        return a.first_index < b.first_index;
+      });
+      return states;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::size_t
+    StateCounts<InputType>::
+    n_distinct_states () const
+    {
+      std::size_t n = 0;
+      for (const auto &shard : shards)
+        {
+          std::lock_guard<std::mutex> lock (shard->mutex);
+          n += shard->entries.size();
+        }
+      return n;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    types::sample_index
+    StateCounts<InputType>::
+    n_samples () const
+    {
+      return sample_counter.load (std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    StateCounts<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      std::vector<std::tuple<InputType,types::sample_index,types::sample_index,double>> states;
+      for (auto &state : get())
+        states.emplace_back (std::move(state.sample), state.n_occurrences,
+                             state.first_index, state.log_likelihood);
+
+      Serialization::write (buffer, n_samples());
+      Serialization::write (buffer, states);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    void
+    StateCounts<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      types::sample_index n_saved_samples;
+      std::vector<std::tuple<InputType,types::sample_index,types::sample_index,double>> states;
+      Serialization::read (buffer, n_saved_samples);
+      Serialization::read (buffer, states);
+
+      for (const auto &shard : shards)
+        {
+          std::lock_guard<std::mutex> lock (shard->mutex);
+          shard->entries.clear();
+        }
+      for (auto &[sample, n_occurrences, first_index, log_likelihood] : states)
+        {
+          Shard &shard = shard_for (SampleHash<InputType>()(sample));
+          std::lock_guard<std::mutex> lock (shard.mutex);
+          shard.entries.emplace (std::move(sample),
+                                 Entry {n_occurrences, first_index, log_likelihood});
+        }
+      sample_counter.store (n_saved_samples, std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    std::size_t
+    StateCounts<InputType>::
+    memory_consumption () const
+    {
+      std::size_t memory = sizeof(*this);
+      for (const auto &shard : shards)
+        {
+          std::lock_guard<std::mutex> lock (shard->mutex);
+          memory += sizeof(Shard)
+                    + shard->entries.bucket_count() * sizeof(void *);
+          for (const auto &[sample, entry] : shard->entries)
+            // Each element of an unordered_map is a node that stores the
+            // key, the value, and a pointer to the next node:
+            memory += (Memory::memory_consumption (sample)
+                       + sizeof(Entry) + sizeof(void *));
+        }
+      return memory;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_owning_sampletype<InputType>)
+    typename StateCounts<InputType>::Shard &
+    StateCounts<InputType>::
+    shard_for (const std::size_t hash) const
+    {
+      // The hash tables within the shards use the low bits of the hash
+      // value to find a bucket, so use the high bits of a scrambled version
+      // of it to choose the shard:
+      const std::uint64_t scrambled = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+      return *shards[(scrambled >> 32) % shards.size()];
+    }
+  }
+}
@@ -17,9 +17,21 @@
 #define SAMPLEFLOW_CONSUMERS_STREAM_OUTPUT_H
 
 #include <sampleflow/consumer.h>
+#include <sampleflow/chain_file_format.h>
 #include <sampleflow/element_access.h>
+#include <sampleflow/types.h>
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <mutex>
 #include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/consumers/stream_output.impl.h>
@@ -22,6 +22,35 @@ namespace SampleFlow
      * `std::ostream` object. This can be used to write all samples into
      * a file, for example.
      *
+     * By default, samples are written as text, one sample per line (see
+     * below for how samples are converted to text). Alternatively, the
+     * class can write samples in the binary format described in the
+     * documentation of namespace ChainFileFormat, from which
+     * Producers::ChainFile can read them again; in this format, the class
+     * can also store selected entries of the auxiliary data of each
+     * sample. Writing binary output is considerably cheaper than formatting
+     * every number as text, and the resulting files are smaller. In binary
+     * mode, samples are copied into a large buffer that, once full, is
+     * handed to a separate thread that writes it to the stream, so that the
+     * thread that sends samples to this object does not have to wait for
+     * the stream. Because the data is written at some later time, the
+     * stream must not be used by anyone else while the current object
+     * exists; the data is guaranteed to have been written to the stream
+     * once flush() has been called, i.e., once the producer that sends
+     * samples to this object has finished. If writing to a file through
+     * the page cache stalls the writer thread, the stream can be created
+     * on top of a DirectFileWriter object instead of a `std::ofstream`.
+     *
+     * If the output needs to be text, but writing it through the
+     * formatting machinery of `std::ostream` is too slow, the class can
+     * also format numbers itself using `std::to_chars`, see
+     * Format::fast_text. This does not depend on the locale of the stream,
+     * and yields the shortest representation from which the number can be
+     * read back exactly, unless a precision is requested. Each sample is
+     * formatted into a separate buffer of the thread that calls consume(),
+     * and then written to the stream as a whole line; only the latter
+     * requires a lock.
+     *
      *
      * ### Threading model ###
      *
@@ -50,12 +79,67 @@ namespace SampleFlow
     class StreamOutput : public Consumer<InputType>
     {
       public:
+        /**
+         * The formats in which this class can write samples.
+         */
+        enum class Format
+        {
+          /**
+           * Write each sample as text, on a separate line.
+           */
+          text,
+
+          /**
+           * Write samples in the binary format described in the
+           * documentation of namespace ChainFileFormat. This requires that
+           * the scalar type of `InputType` (see types::ScalarType) is an
+           * arithmetic type.
+           */
+          binary,
+
+          /**
+           * Write each sample as text, on a separate line, but convert
+           * numbers to text using `std::to_chars` rather than the
+           * `operator<<` of the stream. The separator between elements and
+           * the precision are given by a TextFormat object. This requires
+           * that the scalar type of `InputType` (see types::ScalarType) is
+           * an arithmetic type.
+           */
+          fast_text
+        };
+
+        /**
+         * A structure that describes how samples are written in
+         * Format::fast_text.
+         */
+        struct TextFormat
+        {
+          /**
+           * The string written between two elements of a sample.
+           */
+          std::string separator = " ";
+
+          /**
+           * The number of significant digits with which floating point
+           * numbers are written. If negative, numbers are written with
+           * as many digits as are necessary to read them back exactly,
+           * but no more.
+           */
+          int precision = -1;
+        };
+
         /**
          * Constructor.
          *
-         * This class does not support asynchronous processing of samples,
-         * and consequently calls the base class constructor with
-         * ParallelMode::synchronous as argument.
+         * Because a Consumer object processes the samples waiting in its
+         * queue in the order in which they arrived, this class can also be
+         * used with asynchronous processing of samples, and consequently
+         * calls the base class constructor with
+         * `ParallelMode::synchronous | ParallelMode::asynchronous` as
+         * argument. This is useful if writing samples to a stream is slow
+         * and should not hold up the producer; a program that only wants to
+         * monitor a sampler may then want to also choose
+         * QueueFullPolicy::drop_oldest in Consumer::set_parallel_mode().
          *
          * @param[in] output_stream A reference to the stream to which output
          *   will be written for each sample. This class stores a reference
@@ -64,6 +148,42 @@ namespace SampleFlow
          */
         StreamOutput (std::ostream &output_stream);
 
+        /**
+         * Constructor that allows selecting the format in which samples are
+         * written. Other than that, the same applies as for the previous
+         * constructor.
+         *
+         * @param[in] output_stream A reference to the stream to which output
+         *   will be written. For binary output, this stream should have been
+         *   opened with `std::ios::binary`.
+         * @param[in] format The format in which samples are written.
+         * @param[in] aux_data_columns For binary output, the entries of the
+         *   auxiliary data of each sample that should be stored along with
+         *   the sample, and the types as which they should be stored. This
+         *   argument is ignored for text output.
+         * @param[in] buffer_size For binary output, the size (in bytes) of
+         *   the buffers that are handed to the writer thread once full. At
+         *   most two full buffers are waiting to be written at any given
+         *   time; if the writer thread falls behind, then consume() waits
+         *   for it.
+         */
+        StreamOutput (std::ostream                                &output_stream,
+                      const Format                                 format,
+                      const std::vector<ChainFileFormat::Column>  &aux_data_columns = {},
+                      const std::size_t                            buffer_size = 4*1024*1024);
+
+        /**
+         * Constructor for writing samples in Format::fast_text. Other than
+         * that, the same applies as for the first constructor.
+         *
+         * @param[in] output_stream A reference to the stream to which output
+         *   will be written.
+         * @param[in] text_format The separator and precision used for
+         *   writing samples.
+         */
+        StreamOutput (std::ostream     &output_stream,
+                      const TextFormat &text_format);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -85,6 +205,17 @@ namespace SampleFlow
         void
         consume (InputType sample, AuxiliaryData aux_data) override;
 
+        /**
+         * Finish processing all samples this object has received, as
+         * documented in Consumer::flush(). For binary output, this also
+         * hands the partially filled buffer to the writer thread and waits
+         * for all buffers to be written. In either case, the function then
+         * calls `flush()` on the output stream.
+         */
+        virtual
+        void
+        flush () override;
+
       private:
         /**
          * A mutex used to lock access to all member variables when running
@@ -97,6 +228,87 @@ namespace SampleFlow
          * sample.
          */
         std::ostream &output_stream;
+
+        /**
+         * The format in which samples are written, and for binary output, the
+         * auxiliary data columns to be written and the size of the buffers.
+         */
+        const Format                               format;
+        const std::vector<ChainFileFormat::Column> aux_data_columns;
+        const std::size_t                          buffer_size;
+
+        /**
+         * For Format::fast_text, how samples are written.
+         */
+        const TextFormat text_format;
+
+        /**
+         * For binary output, the header of the file. It is written along
+         * with the first sample, at which time we know the dimension of
+         * samples. (Before that, `header.dimension` is zero.)
+         */
+        ChainFileFormat::Header header;
+
+        /**
+         * The buffer into which consume() copies samples in binary mode.
+         * Access to it is guarded by `mutex`.
+         */
+        std::vector<char> current_buffer;
+
+        /**
+         * A mutex and condition variable that guard the member variables
+         * below and that the writer thread uses to wait for work.
+         */
+        std::mutex              writer_mutex;
+        std::condition_variable writer_state_changed;
+
+        /**
+         * Buffers that are full and waiting to be written, and buffers that
+         * have been written and whose memory can be reused.
+         */
+        std::deque<std::vector<char>>  full_buffers;
+        std::vector<std::vector<char>> spare_buffers;
+
+        /**
+         * Whether the writer thread is currently writing a buffer, and
+         * whether the destructor has asked the writer thread to stop.
+         */
+        bool is_writing;
+        bool shutting_down;
+
+        /**
+         * The thread that writes buffers to the stream in binary mode. In
+         * text mode, no thread is started.
+         */
+        std::thread writer;
+
+        /**
+         * The maximal number of buffers waiting to be written.
+         */
+        static constexpr std::size_t max_pending_buffers = 2;
+
+        /**
+         * Copy the given sample and its auxiliary data into the current
+         * buffer, and hand the buffer to the writer thread if it is full.
+         * The caller needs to hold `mutex`.
+         */
+        void
+        write_binary (const InputType     &sample,
+                      const AuxiliaryData &aux_data);
+
+        /**
+         * Hand the current buffer to the writer thread, waiting if too many
+         * buffers are already waiting to be written, and start a new one.
+         * The caller needs to hold `mutex`.
+         */
+        void
+        hand_off_buffer ();
+
+        /**
+         * The function run by the writer thread.
+         */
+        void
+        writer_loop ();
     };
 
 
@@ -105,17 +317,81 @@ namespace SampleFlow
     StreamOutput<InputType>::
     StreamOutput (std::ostream &output_stream)
       :
-      Consumer<InputType>(ParallelMode::synchronous),
-      output_stream (output_stream)
+      StreamOutput (output_stream, Format::text)
     {}
 
 
 
+    template <typename InputType>
+    StreamOutput<InputType>::
+    StreamOutput (std::ostream                                &output_stream,
+                  const Format                                 format,
+                  const std::vector<ChainFileFormat::Column>  &aux_data_columns,
+                  const std::size_t                            buffer_size)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      output_stream (output_stream),
+      format (format),
+      aux_data_columns (aux_data_columns),
+      buffer_size (buffer_size),
+      is_writing (false),
+      shutting_down (false)
+    {
+      if (format == Format::fast_text)
+        assert (std::is_arithmetic_v<types::ScalarType<InputType>>);
+      else if (format == Format::binary)
+        {
+          assert (std::is_arithmetic_v<types::ScalarType<InputType>>);
+          assert (buffer_size > 0);
+
+          current_buffer.reserve (buffer_size);
+          writer = std::thread ([this]()
+          {
+            writer_loop ();
+          });
+        }
+    }
+
+
+
+    template <typename InputType>
+    StreamOutput<InputType>::
+    StreamOutput (std::ostream     &output_stream,
+                  const TextFormat &text_format)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::asynchronous))),
+      output_stream (output_stream),
+      format (Format::fast_text),
+      buffer_size (0),
+      text_format (text_format),
+      is_writing (false),
+      shutting_down (false)
+    {
+      assert (std::is_arithmetic_v<types::ScalarType<InputType>>);
+    }
+
+
+
     template <typename InputType>
     StreamOutput<InputType>::
     ~StreamOutput ()
     {
       this->disconnect_and_flush();
+
+      if (writer.joinable())
+        {
+          {
+            std::lock_guard<std::mutex> lock (writer_mutex);
+            shutting_down = true;
+          }
+          writer_state_changed.notify_all();
+
+          writer.join();
+        }
     }
 
 
@@ -173,19 +449,277 @@ namespace SampleFlow
               output_stream << ' ';
             }
         }
+
+
+
+        /**
+         * Append the text representation of a number to the given string,
+         * using `std::to_chars`. If `precision` is negative, floating point
+         * numbers are written in the shortest form that can be read back
+         * exactly; otherwise with the given number of significant digits.
+         */
+        template <typename T>
+        requires (std::is_arithmetic_v<T>)
+        void append_number (const T      x,
+                            const int    precision,
+                            std::string &line)
+        {
+          // 64 characters are enough for any integer, and for any
+          // floating point number in its shortest representation. If a
+          // precision is requested, it determines the space we need.
+          if constexpr (std::is_same_v<T,bool>)
+            line += (x ? '1' : '0');
+          else if constexpr (std::is_floating_point_v<T>)
+            {
+              if (precision < 0)
+                {
+                  char digits[64];
+                  const std::to_chars_result result
+                    = std::to_chars (std::begin(digits), std::end(digits), x);
+                  line.append (digits, result.ptr);
+                }
+              else
+                {
+                  std::vector<char> large_digits (precision + 32);
+                  const std::to_chars_result result
+                    = std::to_chars (large_digits.data(), large_digits.data() + large_digits.size(),
+                                     x, std::chars_format::general, precision);
+                  assert (result.ec == std::errc());
+                  line.append (large_digits.data(), result.ptr);
+                }
+            }
+          else
+            {
+              char digits[64];
+              const std::to_chars_result result
+                = std::to_chars (std::begin(digits), std::end(digits), x);
+              line.append (digits, result.ptr);
+            }
+        }
+
+
+
+        /**
+         * Append the text representation of a sample, followed by a
+         * newline, to the given string. The elements of the sample are
+         * separated by the given separator.
+         */
+        template <typename SampleType>
+        void format_line (const SampleType  &sample,
+                          const std::string &separator,
+                          const int          precision,
+                          std::string       &line)
+        {
+          using scalar_type = types::ScalarType<SampleType>;
+
+          if constexpr (std::is_arithmetic_v<scalar_type>)
+            {
+              if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+                {
+                  const auto elements = Utilities::as_span (sample);
+                  for (std::size_t i=0; i<elements.size(); ++i)
+                    {
+                      if (i > 0)
+                        line += separator;
+                      append_number<scalar_type> (elements[i], precision, line);
+                    }
+                }
+              else
+                {
+                  const std::size_t n_elements = Utilities::size(sample);
+                  for (std::size_t i=0; i<n_elements; ++i)
+                    {
+                      if (i > 0)
+                        line += separator;
+                      append_number<scalar_type> (Utilities::get_nth_element(sample, i),
+                                                  precision, line);
+                    }
+                }
+            }
+          else
+            {
+              (void)sample;
+              (void)separator;
+              (void)precision;
+              assert (false);
+            }
+          line += '\n';
+        }
+      }
+    }
+
+
+    template <typename InputType>
+    void
+    StreamOutput<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      if (format == Format::fast_text)
+        {
+          // Format the sample outside the lock, into a buffer that every
+          // thread keeps around for the next sample, and only lock for
+          // writing the line:
+          thread_local std::string line;
+          line.clear();
+          internal::StreamOutput::format_line (sample, text_format.separator,
+                                               text_format.precision, line);
+
+          const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+          output_stream.write (line.data(), line.size());
+          return;
+        }
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      if (format == Format::text)
+        {
+          internal::StreamOutput::write (sample, output_stream);
+          output_stream << '\n';
+        }
+      else
+        write_binary (sample, aux_data);
+    }
+
+
+
+    template <typename InputType>
+    void
+    StreamOutput<InputType>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+
+      if (format == Format::binary)
+        {
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            if (current_buffer.size() > 0)
+              hand_off_buffer ();
+          }
+
+          std::unique_lock<std::mutex> lock (writer_mutex);
+          writer_state_changed.wait (lock, [this]()
+          {
+            return (full_buffers.empty() && (is_writing == false));
+          });
+        }
+
+      output_stream.flush();
+    }
+
+
+
+    template <typename InputType>
+    void
+    StreamOutput<InputType>::
+    write_binary (const InputType     &sample,
+                  const AuxiliaryData &aux_data)
+    {
+      using scalar_type = types::ScalarType<InputType>;
+
+      if constexpr (std::is_arithmetic_v<scalar_type>)
+        {
+          const std::size_t dimension = Utilities::size(sample);
+
+          // If this is the first sample, put the header in front of it:
+          if (header.dimension == 0)
+            {
+              header.scalar_kind = ChainFileFormat::scalar_kind<scalar_type>();
+              header.scalar_size = sizeof(scalar_type);
+              header.dimension   = dimension;
+              header.columns     = aux_data_columns;
+
+              const std::vector<char> header_bytes = ChainFileFormat::write_header (header);
+              current_buffer.insert (current_buffer.end(),
+                                     header_bytes.begin(), header_bytes.end());
+            }
+          assert (dimension == header.dimension);
+
+          // Then append the record for the current sample:
+          const std::size_t position = current_buffer.size();
+          current_buffer.resize (position + header.record_size());
+          ChainFileFormat::write_record (sample, aux_data, header,
+                                         current_buffer.data() + position);
+
+          if (current_buffer.size() >= buffer_size)
+            hand_off_buffer ();
+        }
+      else
+        {
+          (void)sample;
+          (void)aux_data;
+          assert (false);
+        }
+    }
+
+
+
+    template <typename InputType>
+    void
+    StreamOutput<InputType>::
+    hand_off_buffer ()
+    {
+      {
+        std::unique_lock<std::mutex> lock (writer_mutex);
+        writer_state_changed.wait (lock, [this]()
+        {
+          return (full_buffers.size() < max_pending_buffers);
+        });
+
+        full_buffers.emplace_back (std::move(current_buffer));
+
+        // Reuse the memory of a buffer that has already been written, if
+        // there is one:
+        if (spare_buffers.size() > 0)
+          {
+            current_buffer = std::move(spare_buffers.back());
+            spare_buffers.pop_back();
+          }
+        else
+          current_buffer = std::vector<char>();
       }
+      writer_state_changed.notify_all();
+
+      current_buffer.clear();
+      current_buffer.reserve (buffer_size);
     }
 
 
+
     template <typename InputType>
     void
     StreamOutput<InputType>::
-    consume (InputType sample, AuxiliaryData /*aux_data*/)
+    writer_loop ()
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      while (true)
+        {
+          std::vector<char> buffer;
+          {
+            // Wait until there is something to write, or until we are asked
+            // to shut down and there is nothing left to write:
+            std::unique_lock<std::mutex> lock (writer_mutex);
+            writer_state_changed.wait (lock, [this]()
+            {
+              return (shutting_down || (full_buffers.size() > 0));
+            });
+            if (full_buffers.size() == 0)
+              return;
+
+            buffer = std::move(full_buffers.front());
+            full_buffers.pop_front();
+            is_writing = true;
+          }
 
-      internal::StreamOutput::write (sample, output_stream);
-      output_stream << '\n';
+          output_stream.write (buffer.data(), buffer.size());
+          buffer.clear();
+
+          {
+            std::lock_guard<std::mutex> lock (writer_mutex);
+            is_writing = false;
+            spare_buffers.emplace_back (std::move(buffer));
+          }
+          writer_state_changed.notify_all();
+        }
     }
   }
 }
@@ -0,0 +1,554 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes several of the statistics that are
+     * otherwise computed by separate consumers, namely
+     * - the number of samples, as computed by CountSamples;
+     * - the mean value, as computed by MeanValue;
+     * - the covariance matrix, as computed by CovarianceMatrix;
+     * - the sample with the highest probability, as computed by
+     *   MaximumProbabilitySample;
+     * - the acceptance ratio, as computed by AcceptanceRatio.
+     *
+     * Which of these are computed is selected by the argument to the
+     * constructor, and the results can be obtained via the functions
+     * get_count(), get_mean(), get_covariance(),
+     * get_maximum_probability_sample(), and get_acceptance_ratio(). These
+     * return objects of the same type and with the same values as the
+     * get() functions of the individual consumer classes. (The one
+     * exception is that this class does not compute the moving average of
+     * AcceptanceRatio::get_recent().)
+     *
+     * The point of this class is efficiency. Attaching the five consumers
+     * listed above to a producer means that every sample is copied for
+     * four of them, that each of them acquires its own lock, and that the
+     * mean value and the covariance matrix traverse the memory of the
+     * sample and of the running mean separately. This class processes each
+     * sample in one call that acquires one lock, and it updates the mean
+     * value and the vector of deviations from the mean needed for the
+     * covariance matrix in the same loop over the elements of the sample.
+     * The formulas are otherwise the same as those of the individual
+     * classes; in particular, the class takes into account the repetition
+     * counts and weights of samples (see AuxiliaryData::n_repetitions() and
+     * AuxiliaryData::weight()) in the same way.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from
+     * multiple threads. A single mutex protects the state of the object.
+     * Since the acceptance ratio may depend on the order in which samples
+     * arrive, the class supports ParallelMode::synchronous and
+     * ParallelMode::dedicated_thread, both of which process samples in
+     * the order in which they were issued, but not
+     * ParallelMode::asynchronous.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The same
+     *   requirements apply as for the MeanValue class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class SummaryStatistics : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type used for the covariance matrix, the same as
+         * CovarianceMatrix::value_type.
+         */
+        using covariance_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * The statistics this class can compute. The argument to the
+         * constructor is a combination of these, formed via `operator|`.
+         */
+        enum Statistic : unsigned int
+        {
+          count                      = 1,
+          mean                       = 2,
+          covariance                 = 4,
+          maximum_probability_sample = 8,
+          acceptance_ratio           = 16,
+          all                        = 31
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] statistics The statistics to compute, given as a
+         *   combination of elements of the Statistic enum, for example
+         *   `SummaryStatistics::mean | SummaryStatistics::covariance`.
+         */
+        SummaryStatistics (const unsigned int statistics = all);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~SummaryStatistics ();
+
+        /**
+         * Process one sample by updating all of the statistics selected
+         * in the constructor.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The class
+         *   uses the repetition count and weight of the sample, and the
+         *   entries with keys AuxiliaryData::relative_log_likelihood and
+         *   AuxiliaryData::sample_is_repeated, in the same way as the
+         *   individual consumer classes do.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples. This is the same as calling consume()
+         * for each sample, except that the lock is only acquired once.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data Auxiliary data about these samples.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType>     &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Return the number of samples received so far. See
+         * CountSamples::get().
+         */
+        types::sample_index
+        get_count () const;
+
+        /**
+         * Return the mean value of the samples received so far. See
+         * MeanValue::get(). This function can only be called if the mean
+         * value was selected in the constructor.
+         */
+        InputType
+        get_mean () const;
+
+        /**
+         * Return the covariance matrix of the samples received so far. See
+         * CovarianceMatrix::get(). This function can only be called if the
+         * covariance matrix was selected in the constructor.
+         */
+        covariance_type
+        get_covariance () const;
+
+        /**
+         * Return the most likely of the samples received so far along with
+         * its auxiliary data. See MaximumProbabilitySample::get(). This
+         * function can only be called if the maximum probability sample
+         * was selected in the constructor.
+         */
+        std::pair<InputType,AuxiliaryData>
+        get_maximum_probability_sample () const;
+
+        /**
+         * Return the acceptance ratio of the samples received so far. See
+         * AcceptanceRatio::get(). This function can only be called if the
+         * acceptance ratio was selected in the constructor.
+         */
+        double
+        get_acceptance_ratio () const;
+
+      private:
+        /**
+         * The statistics selected in the constructor.
+         */
+        const unsigned int statistics;
+
+        /**
+         * A mutex used to lock access to all member variables below.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The number of samples received so far, and the sums of their
+         * weights and of the squares of their weights.
+         */
+        types::sample_index n_samples;
+        double              total_weight;
+        double              total_squared_weight;
+
+        /**
+         * The running mean value and the sum of outer products of deviations
+         * from the mean, whose lower triangle is kept up to date as in
+         * CovarianceMatrix. These are used if either the mean or the
+         * covariance matrix is requested.
+         */
+        InputType       current_mean;
+        covariance_type current_sum_of_products;
+
+        /**
+         * The deviation of the current sample from the previous mean
+         * value, for sample types whose elements are stored contiguously.
+         * Kept as a member variable so that its memory is only allocated
+         * once.
+         */
+        Eigen::Matrix<scalar_type,Eigen::Dynamic,1> delta;
+
+        /**
+         * The most likely sample, its auxiliary data, and its log
+         * likelihood, along with whether any sample with a log likelihood
+         * has been seen so far.
+         */
+        InputType     most_likely_sample;
+        AuxiliaryData most_likely_sample_data;
+        double        highest_log_likelihood;
+        bool          have_most_likely_sample;
+
+        /**
+         * The number of accepted samples, along with the previous sample
+         * for samples that need to be compared with it in the same way as
+         * AcceptanceRatio does.
+         */
+        types::sample_index n_accepted_samples;
+        InputType           previous_sample;
+        bool                have_previous_sample;
+
+        /**
+         * Update the statistics with one sample. The caller needs to hold
+         * the lock. The function takes the arguments by forwarding
+         * reference so that samples passed to consume() can be moved into
+         * the member variables that store samples, whereas samples that
+         * are part of a batch are copied.
+         */
+        template <typename SampleType, typename AuxDataType>
+        void
+        add_sample (SampleType  &&sample,
+                    AuxDataType &&aux_data);
+
+        /**
+         * Update the mean value and, if requested, the sum of outer
+         * products with a sample that has the given total weight (its
+         * weight times its repetition count). The caller needs to
+         * hold the lock and to have updated `total_weight` already.
+         */
+        void
+        update_moments (const InputType &sample,
+                        const double     sample_weight);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    SummaryStatistics<InputType>::
+    SummaryStatistics (const unsigned int statistics)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      statistics (statistics),
+      n_samples (0),
+      total_weight (0),
+      total_squared_weight (0),
+      highest_log_likelihood (std::numeric_limits<double>::lowest()),
+      have_most_likely_sample (false),
+      n_accepted_samples (0),
+      have_previous_sample (false)
+    {
+      assert ((statistics & ~static_cast<unsigned int>(all)) == 0);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    SummaryStatistics<InputType>::
+    ~SummaryStatistics ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    SummaryStatistics<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      add_sample (std::move(sample), std::move(aux_data));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    SummaryStatistics<InputType>::
+    consume_batch (const std::vector<InputType>     &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      for (std::size_t i=0; i<samples.size(); ++i)
+        add_sample (samples[i], aux_data[i]);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    template <typename SampleType, typename AuxDataType>
+    void
+    SummaryStatistics<InputType>::
+    add_sample (SampleType  &&sample,
+                AuxDataType &&aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const double              weight        = aux_data.weight();
+      if (n_repetitions == 0)
+        return;
+
+      // First the acceptance ratio, since it needs to know whether this is
+      // the first sample. As in AcceptanceRatio::consume(), use the
+      // information the producer provides if possible, and otherwise
+      // compare with the previous sample:
+      if (statistics & acceptance_ratio)
+        {
+          bool accepted;
+          if (const bool *is_repeated = aux_data.template get_if<bool> (AuxiliaryData::sample_is_repeated))
+            accepted = !*is_repeated;
+          else
+            {
+              accepted = ((have_previous_sample == false)
+                          ||
+                          !internal::AcceptanceRatio::is_equal(sample, previous_sample));
+              if (accepted)
+                {
+                  previous_sample      = sample;
+                  have_previous_sample = true;
+                }
+            }
+
+          if (accepted || (n_samples == 0))
+            ++n_accepted_samples;
+        }
+
+      // Then the counts and the moments, for which samples without a
+      // weight do not count:
+      const double sample_weight = n_repetitions * weight;
+      n_samples += n_repetitions;
+      if (sample_weight != 0)
+        {
+          total_weight         += sample_weight;
+          total_squared_weight += n_repetitions * weight * weight;
+
+          if (statistics & (mean | covariance))
+            update_moments (sample, sample_weight);
+        }
+
+      // Finally see whether this is the most likely sample so far. This
+      // comes last since we may move the sample into the member variable.
+      if (statistics & maximum_probability_sample)
+        if (const double *log_likelihood
+            = aux_data.template get_if<double> (AuxiliaryData::relative_log_likelihood))
+          if ((have_most_likely_sample == false)
+              ||
+              (*log_likelihood > highest_log_likelihood))
+            {
+              highest_log_likelihood  = *log_likelihood;
+              most_likely_sample      = std::forward<SampleType>(sample);
+              most_likely_sample_data = std::forward<AuxDataType>(aux_data);
+              have_most_likely_sample = true;
+            }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    SummaryStatistics<InputType>::
+    update_moments (const InputType &sample,
+                    const double     sample_weight)
+    {
+      const bool compute_covariance = ((statistics & covariance) != 0);
+
+      // If this is the first sample with a weight, initialize the mean
+      // with this sample and the sum of products with zero:
+      if (total_weight == sample_weight)
+        {
+          current_mean = sample;
+          if (compute_covariance)
+            current_sum_of_products.setZero (Utilities::size(sample), Utilities::size(sample));
+          return;
+        }
+
+      // Otherwise, update both in the same way as
+      // CovarianceMatrix::PartialCovariance::add_sample() does. (At this
+      // point, 'total_weight' already includes the current sample.)
+      const double previous_weight = total_weight - sample_weight;
+      const double mean_factor     = sample_weight / total_weight;
+
+      if constexpr (Concepts::has_contiguous_scalar_storage<InputType>)
+        {
+          // Compute the deviation from the previous mean and update the
+          // mean in the same loop, then let Eigen do the rank-one update
+          // with the deviation:
+          const auto x             = Utilities::as_span (sample);
+          const auto mean_elements = Utilities::as_span (current_mean);
+          assert (x.size() == mean_elements.size());
+
+          delta.resize (x.size());
+          for (std::size_t j=0; j<x.size(); ++j)
+            {
+              delta[j] = x[j] - mean_elements[j];
+              mean_elements[j] += static_cast<scalar_type>(delta[j] * mean_factor);
+            }
+
+          if (compute_covariance)
+            {
+              if constexpr (types::is_complex<scalar_type>)
+                Utilities::add_hermitian_rank_one (current_sum_of_products.data(),
+                                                   current_sum_of_products.outerStride(),
+                                                   std::span<const scalar_type>(delta.data(), delta.size()),
+                                                   previous_weight * mean_factor);
+              else
+                current_sum_of_products.template selfadjointView<Eigen::Lower>()
+                .rankUpdate (delta, previous_weight * mean_factor);
+            }
+        }
+      else
+        {
+          InputType deviation = sample;
+          deviation -= current_mean;
+
+          if (compute_covariance)
+            {
+              const double factor = previous_weight * mean_factor;
+              for (unsigned int j=0; j<Utilities::size(deviation); ++j)
+                {
+                  const auto delta_j = Utilities::conj(Utilities::get_nth_element(deviation, j));
+                  for (unsigned int i=j; i<Utilities::size(deviation); ++i)
+                    current_sum_of_products(i,j)
+                    += Utilities::multiply (Utilities::get_nth_element(deviation, i), delta_j) * factor;
+                }
+            }
+
+          Utilities::add_scaled (current_mean, deviation, mean_factor);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    types::sample_index
+    SummaryStatistics<InputType>::
+    get_count () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return n_samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    InputType
+    SummaryStatistics<InputType>::
+    get_mean () const
+    {
+      assert (statistics & mean);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      return current_mean;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename SummaryStatistics<InputType>::covariance_type
+    SummaryStatistics<InputType>::
+    get_covariance () const
+    {
+      assert (statistics & covariance);
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // Fill the upper triangle and normalize as in CovarianceMatrix::get():
+      covariance_type sum_of_products = current_sum_of_products;
+      sum_of_products.template triangularView<Eigen::StrictlyUpper>()
+        = current_sum_of_products.adjoint();
+
+      const double normalization
+        = (total_weight > 0
+           ?
+           total_weight - total_squared_weight / total_weight
+           :
+           0.);
+      if (normalization > 0)
+        return sum_of_products / normalization;
+      else
+        return sum_of_products;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::pair<InputType,AuxiliaryData>
+    SummaryStatistics<InputType>::
+    get_maximum_probability_sample () const
+    {
+      assert (statistics & maximum_probability_sample);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      return {most_likely_sample, most_likely_sample_data};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    double
+    SummaryStatistics<InputType>::
+    get_acceptance_ratio () const
+    {
+      assert (statistics & acceptance_ratio);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (n_samples > 0)
+        return static_cast<double>(n_accepted_samples) / static_cast<double>(n_samples);
+      else
+        return 0.0;
+    }
+
+  }
+}
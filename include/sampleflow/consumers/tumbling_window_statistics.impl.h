@@ -0,0 +1,597 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that splits the chain into consecutive,
+     * non-overlapping windows of $W$ steps each ("tumbling windows") and
+     * computes the mean value, the variance of each component, and the
+     * acceptance ratio of the samples in each window. The summaries of the
+     * $K$ most recently completed windows are kept and can be obtained via
+     * get().
+     *
+     * Comparing these summaries is the usual way to check whether a chain
+     * is still drifting, i.e., whether it has reached its stationary
+     * distribution: If it has, then the means of early and late windows
+     * should agree to within their statistical uncertainty. The
+     * drift_z_scores() function implements this comparison in the style of
+     * Geweke's diagnostic. Because the class only stores summaries, such
+     * checks neither require storing samples nor cost anything beyond
+     * ${\cal O}(d)$ operations per sample, where $d$ is the number of
+     * components of the samples: The statistics of the current window are
+     * updated with each sample using Welford's algorithm, and when a
+     * window is complete, its summary is appended to a ring buffer of $K$
+     * summaries. (Publishing the summaries then costs ${\cal O}(Kd)$
+     * operations once every $W$ samples.)
+     *
+     * A sample with a repetition count (see AuxiliaryData::n_repetitions())
+     * stands for as many steps of the chain as it has repetitions, and
+     * may therefore be split between two or more windows; a sample with
+     * a weight (see AuxiliaryData::weight()) enters the mean and variance
+     * with this weight. Whether a sample was accepted is determined in the
+     * same way as in the AcceptanceRatio class: from the
+     * AuxiliaryData::sample_is_repeated entry if the producer provides it,
+     * and otherwise by comparing the sample with the previous one. Of the
+     * steps a repeated sample stands for, only the first can count as
+     * accepted.
+     *
+     * The variance of a component is computed with the same normalization
+     * for "reliability weights" as in the CovarianceMatrix class, i.e., as
+     * $\frac{1}{W_1-W_2/W_1}\sum_j w_j (x_j-\bar x)^2$ where $W_1$ and
+     * $W_2$ are the sums of the weights and of their squares.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because which samples end up in which window depends on the
+     * order in which samples are processed, the class supports
+     * ParallelMode::dedicated_thread but not ParallelMode::asynchronous.
+     *
+     * The statistics of the window that is currently being filled are
+     * protected by a mutex that only consume() uses. Completed summaries
+     * are published via a `std::atomic<std::shared_ptr>` in the same way
+     * as in the LastSample class, so get() and drift_z_scores() never wait
+     * for consume() or hold it up.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The same
+     *   requirements hold as for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class TumblingWindowStatistics : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type used for the mean values and variances of windows.
+         */
+        using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+
+        /**
+         * A structure that summarizes the samples in one window.
+         */
+        struct WindowSummary
+        {
+          /**
+           * The (zero-based) index of the first step of the chain that
+           * belongs to this window, counting the repetitions of samples.
+           * The window covers the steps `first_step` to
+           * `first_step+window_size-1`.
+           */
+          types::sample_index first_step = 0;
+
+          /**
+           * The sum of the weights of the samples in the window.
+           */
+          double total_weight = 0;
+
+          /**
+           * The weighted mean value of the samples in the window.
+           */
+          vector_type mean;
+
+          /**
+           * The weighted variance of each component of the samples in the
+           * window.
+           */
+          vector_type variance;
+
+          /**
+           * The fraction of the steps in the window that were accepted.
+           */
+          double acceptance_ratio = 0;
+        };
+
+        /**
+         * The type of the information generated by this class: the
+         * summaries of the most recently completed windows, from the oldest
+         * to the most recent one.
+         */
+        using value_type = std::vector<WindowSummary>;
+
+        /**
+         * Constructor.
+         *
+         * This class needs to process samples in the order in which they
+         * were generated, and consequently calls the base class constructor
+         * with `ParallelMode::synchronous | ParallelMode::dedicated_thread`
+         * as argument.
+         *
+         * @param[in] window_size The number $W$ of steps of the chain in
+         *   each window. Must be at least one.
+         * @param[in] n_windows The number $K$ of completed windows whose
+         *   summaries are kept. Must be at least one.
+         */
+        TumblingWindowStatistics (const types::sample_index window_size,
+                                  const std::size_t         n_windows);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~TumblingWindowStatistics ();
+
+        /**
+         * Process one sample by adding it to the statistics of the current
+         * window, and completing the window (and perhaps further ones, if
+         * the sample is repeated many times) if it is full.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the entries listed in used_aux_data_keys() and
+         *   ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the keys of the auxiliary data this class uses: the
+         * repetition count and weight of samples, and whether a sample is
+         * a repetition of the previous one. See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return the summaries of the (up to $K$) most recently completed
+         * windows, from the oldest to the most recent one. The window that
+         * is currently being filled is not included.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Like get(), but return a pointer to the summaries rather than a
+         * copy of them. The object pointed to is never modified, and
+         * remains valid for as long as the caller holds on to the pointer.
+         * If no window has been completed so far, the function returns a
+         * pointer to an empty vector.
+         */
+        std::shared_ptr<const value_type>
+        get_shared () const;
+
+        /**
+         * Return the number of windows completed so far, including the
+         * ones whose summaries are no longer kept.
+         */
+        types::sample_index
+        n_completed_windows () const;
+
+        /**
+         * Compare the means of the oldest `n_early_windows` and of the most
+         * recent `n_late_windows` of the windows whose summaries are kept,
+         * and return for each component the difference between the late and
+         * the early mean in units of its standard error,
+         * @f{align*}{
+         *   z = \frac{\bar x_\text{late} - \bar x_\text{early}}
+         *            {\sqrt{s_\text{early}^2/n_\text{early}
+         *                   + s_\text{late}^2/n_\text{late}}},
+         * @f}
+         * where $\bar x$ and $s^2$ are the average and the sample variance
+         * of the means of the respective windows. This is Geweke's
+         * diagnostic with the variance of the mean estimated by batch
+         * means; it accounts for the correlation between samples as long as
+         * the window size $W$ is large compared to the autocorrelation
+         * length of the chain. Values of $|z|$ much larger than two
+         * indicate that the chain is still drifting.
+         *
+         * Both numbers of windows need to be at least two, and their sum
+         * must not exceed the number of summaries kept. If fewer summaries
+         * are available, an empty vector is returned.
+         */
+        vector_type
+        drift_z_scores (const std::size_t n_early_windows,
+                        const std::size_t n_late_windows) const;
+
+        /**
+         * Return an estimate of the memory used by the statistics of the
+         * current window and the summaries of the completed ones.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * The number of steps per window.
+         */
+        const types::sample_index window_size;
+
+        /**
+         * A mutex that protects the members below that consume() updates.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The statistics of the window currently being filled: the number
+         * of steps in it so far and how many of them were accepted, the
+         * sums $W_1$ and $W_2$ of weights and squared weights, the running
+         * mean, and the running sums of squared deviations from it.
+         */
+        types::sample_index current_n_steps = 0;
+        types::sample_index current_n_accepted = 0;
+        double              current_total_weight = 0;
+        double              current_total_squared_weight = 0;
+        vector_type         current_mean;
+        vector_type         current_sum_of_squares;
+
+        /**
+         * The number of steps processed so far, in all windows.
+         */
+        types::sample_index n_steps = 0;
+
+        /**
+         * The current sample, converted to a vector, and (if the producer
+         * does not tell us which samples are repeated) the previous one
+         * to compare it with. Both are members so that their memory can be
+         * reused from one sample to the next.
+         */
+        vector_type x;
+        vector_type previous_sample;
+        bool        have_previous_sample = false;
+
+        /**
+         * The summaries of the most recently completed windows.
+         */
+        RingBuffer<WindowSummary> summaries;
+
+        /**
+         * The number of windows completed so far.
+         */
+        std::atomic<types::sample_index> n_windows_completed;
+
+        /**
+         * The summaries as last published, for readers.
+         */
+        std::atomic<std::shared_ptr<const value_type>> published_summaries;
+
+        /**
+         * Add `n_copies` steps of the sample stored in `x` with weight
+         * `weight` to the statistics of the current window. The first of
+         * these steps counts as accepted if `accepted` is true.
+         */
+        void
+        add_to_current_window (const types::sample_index n_copies,
+                               const double              weight,
+                               const bool                accepted);
+
+        /**
+         * Compute the summary of the current window, append it to the ring
+         * buffer of summaries and publish it, and start a new window.
+         */
+        void
+        complete_current_window ();
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    TumblingWindowStatistics<InputType>::
+    TumblingWindowStatistics (const types::sample_index window_size,
+                              const std::size_t         n_windows)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      window_size (window_size),
+      summaries (n_windows),
+      n_windows_completed (0),
+      published_summaries (std::make_shared<const value_type>())
+    {
+      assert (window_size >= 1);
+      assert (n_windows >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    TumblingWindowStatistics<InputType>::
+    ~TumblingWindowStatistics ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    TumblingWindowStatistics<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return;
+      const double weight = aux_data.weight();
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      // Copy the sample into a vector whose memory is reused from one
+      // sample to the next:
+      const unsigned int size = Utilities::size(sample);
+      if (current_mean.size() == 0)
+        {
+          x.resize (size);
+          current_mean = vector_type::Zero (size);
+          current_sum_of_squares = vector_type::Zero (size);
+        }
+      assert (static_cast<Eigen::Index>(size) == current_mean.size());
+      for (unsigned int i=0; i<size; ++i)
+        x[i] = Utilities::get_nth_element (sample, i);
+
+      // Determine whether the sample was accepted, in the same way as the
+      // AcceptanceRatio class does:
+      bool accepted;
+      if (const bool *is_repeated = aux_data.get_if<bool> (AuxiliaryData::sample_is_repeated))
+        accepted = !*is_repeated;
+      else
+        {
+          accepted = ((have_previous_sample == false) || (x != previous_sample));
+          if (accepted)
+            {
+              previous_sample = x;
+              have_previous_sample = true;
+            }
+        }
+      if (n_steps == 0)
+        accepted = true;
+
+      // Distribute the repetitions of the sample over as many windows as
+      // necessary:
+      while (n_repetitions > 0)
+        {
+          const types::sample_index n_copies
+            = std::min (n_repetitions, window_size - current_n_steps);
+          add_to_current_window (n_copies, weight, accepted);
+          n_repetitions -= n_copies;
+          accepted = false;
+
+          if (current_n_steps == window_size)
+            complete_current_window ();
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    TumblingWindowStatistics<InputType>::
+    add_to_current_window (const types::sample_index n_copies,
+                           const double              weight,
+                           const bool                accepted)
+    {
+      current_n_steps += n_copies;
+      n_steps         += n_copies;
+      if (accepted)
+        ++current_n_accepted;
+
+      // Adding n_copies copies of a sample with weight w is the same as
+      // adding one copy with weight n_copies*w, except for the sum of
+      // squared weights:
+      const double added_weight = n_copies * weight;
+      if (added_weight == 0)
+        return;
+
+      const double combined_weight = current_total_weight + added_weight;
+      for (Eigen::Index i=0; i<x.size(); ++i)
+        {
+          const scalar_type delta = x[i] - current_mean[i];
+          current_mean[i] += (added_weight / combined_weight) * delta;
+          current_sum_of_squares[i]
+          += (current_total_weight * added_weight / combined_weight) * delta * delta;
+        }
+      current_total_weight          = combined_weight;
+      current_total_squared_weight += n_copies * weight * weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    TumblingWindowStatistics<InputType>::
+    complete_current_window ()
+    {
+      WindowSummary summary;
+      summary.first_step       = n_steps - current_n_steps;
+      summary.total_weight     = current_total_weight;
+      summary.mean             = current_mean;
+      summary.acceptance_ratio = 1. * current_n_accepted / current_n_steps;
+
+      // As in CovarianceMatrix::get(), if the window contains fewer than
+      // two distinct samples, the normalization factor is zero, but so is
+      // the sum of squares:
+      const double normalization
+        = (current_total_weight > 0
+           ?
+           current_total_weight - current_total_squared_weight / current_total_weight
+           :
+           0.);
+      summary.variance = (normalization > 0
+                          ?
+                          vector_type(current_sum_of_squares / normalization)
+                          :
+                          current_sum_of_squares);
+
+      summaries.push_back (summary);
+
+      // Publish the summaries for readers:
+      std::vector<WindowSummary> all_summaries;
+      all_summaries.reserve (summaries.size());
+      for (std::size_t i=0; i<summaries.size(); ++i)
+        all_summaries.push_back (summaries[i]);
+      published_summaries.store (std::make_shared<const value_type>(std::move(all_summaries)),
+                                 std::memory_order_release);
+      n_windows_completed.fetch_add (1, std::memory_order_release);
+
+      // Start a new window, reusing the memory of the statistics:
+      current_n_steps = 0;
+      current_n_accepted = 0;
+      current_total_weight = 0;
+      current_total_squared_weight = 0;
+      current_mean.setZero();
+      current_sum_of_squares.setZero();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    TumblingWindowStatistics<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::sample_is_repeated,
+        AuxiliaryData::repetition_count,
+        AuxiliaryData::sample_weight
+      };
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename TumblingWindowStatistics<InputType>::value_type
+    TumblingWindowStatistics<InputType>::
+    get () const
+    {
+      return *get_shared();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::shared_ptr<const typename TumblingWindowStatistics<InputType>::value_type>
+    TumblingWindowStatistics<InputType>::
+    get_shared () const
+    {
+      return published_summaries.load (std::memory_order_acquire);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    types::sample_index
+    TumblingWindowStatistics<InputType>::
+    n_completed_windows () const
+    {
+      return n_windows_completed.load (std::memory_order_acquire);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename TumblingWindowStatistics<InputType>::vector_type
+    TumblingWindowStatistics<InputType>::
+    drift_z_scores (const std::size_t n_early_windows,
+                    const std::size_t n_late_windows) const
+    {
+      assert (n_early_windows >= 2);
+      assert (n_late_windows >= 2);
+
+      const std::shared_ptr<const value_type> windows = get_shared();
+      if (n_early_windows + n_late_windows > windows->size())
+        return {};
+
+      // Compute the average and the sample variance of the means of the
+      // windows in the given range:
+      const auto mean_and_variance = [&windows](const std::size_t begin,
+                                                const std::size_t n)
+      {
+        vector_type average = vector_type::Zero ((*windows)[begin].mean.size());
+        for (std::size_t w=begin; w<begin+n; ++w)
+          average += (*windows)[w].mean;
+        average /= n;
+
+        vector_type variance = vector_type::Zero (average.size());
+        for (std::size_t w=begin; w<begin+n; ++w)
+          variance += ((*windows)[w].mean - average).cwiseAbs2();
+        variance /= (n - 1);
+
+        return std::make_pair (average, variance);
+      };
+
+      const auto [early_mean, early_variance] = mean_and_variance (0, n_early_windows);
+      const auto [late_mean, late_variance]
+        = mean_and_variance (windows->size() - n_late_windows, n_late_windows);
+
+      const vector_type standard_error
+        = (early_variance / n_early_windows + late_variance / n_late_windows).cwiseSqrt();
+      return (late_mean - early_mean).cwiseQuotient (standard_error);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::size_t
+    TumblingWindowStatistics<InputType>::
+    memory_consumption () const
+    {
+      const std::shared_ptr<const value_type> windows = get_shared();
+
+      std::lock_guard<std::mutex> lock (mutex);
+      const std::size_t memory_per_vector = x.size() * sizeof(scalar_type);
+      const std::size_t memory_per_summary = sizeof(WindowSummary) + 2 * memory_per_vector;
+
+      return (sizeof(*this)
+              + 4 * memory_per_vector
+              + (summaries.capacity() + windows->size()) * memory_per_summary);
+    }
+  }
+}
@@ -0,0 +1,619 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Consumers
+  {
+    /**
+     * A Consumer class that computes the mean value and covariance matrix
+     * of the most recent $N$ samples, rather than of all samples seen so
+     * far as the MeanValue and CovarianceMatrix classes do. Such statistics
+     * of a sliding window are what adaptive proposal distributions and
+     * monitors that detect whether a chain is still drifting need: They
+     * follow the chain as it moves, rather than being dominated by the
+     * (possibly very long) history of the chain.
+     *
+     * Recomputing the covariance matrix from the stored window whenever a
+     * sample arrives would cost ${\cal O}(Nd^2)$ operations, where $d$ is
+     * the number of components of the samples. Instead, this class
+     * updates the mean $\bar x$ and the sum of outer products
+     * $M=\sum_j w_j (x_j-\bar x)(x_j-\bar x)^T$ of the window with the
+     * sample that enters the window and "downdates" them with the one that
+     * leaves it. If $W$ is the sum of the weights of the samples in the
+     * window, then adding a sample $x$ with weight $w$ uses the same
+     * formula as the CovarianceMatrix class,
+     * @f{align*}{
+     *   M \leftarrow M + \frac{W w}{W+w} (x-\bar x)(x-\bar x)^T,
+     * @f}
+     * and removing a sample $x$ with weight $w$ undoes it:
+     * @f{align*}{
+     *   M \leftarrow M - \frac{W w}{W-w} (x-\bar x)(x-\bar x)^T,
+     * @f}
+     * where $\bar x$ is the mean before the respective update. Both are
+     * symmetric rank-one updates that cost ${\cal O}(d^2)$ operations.
+     * Because subtracting is prone to the accumulation of round-off
+     * errors, the class in addition recomputes $\bar x$ and $M$ from the
+     * samples in the window every $N$ samples, at a cost of
+     * ${\cal O}(Nd^2)$ operations every $N$ samples -- that is,
+     * ${\cal O}(d^2)$ operations per sample on average.
+     *
+     * The samples in the window are stored as the columns of one $d\times N$
+     * matrix that is allocated when the first sample arrives, and that is
+     * used as a ring buffer: Every new sample overwrites the column of the
+     * oldest one. Processing a sample therefore does not allocate memory,
+     * and all samples in the window are contiguous in memory, which is what
+     * makes recomputing $M$ from them fast.
+     *
+     * get() returns the covariance matrix $\frac{1}{W - W_2/W} M$ where
+     * $W_2$ is the sum of the squares of the weights, with the same
+     * normalization for "reliability weights" as in the CovarianceMatrix
+     * class; if all samples have weight one, this is the usual factor
+     * $\frac{1}{N-1}$. A sample with a repetition count (see
+     * AuxiliaryData::n_repetitions()) occupies as many places in the window
+     * as it has repetitions, so that the window always covers the same
+     * number of steps of a chain regardless of whether repeated samples
+     * are compressed.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. Because which samples are in the window depends on the
+     * order in which samples are processed, the class supports
+     * ParallelMode::dedicated_thread but not ParallelMode::asynchronous.
+     * As in the AutoCovarianceTrace class, the state of the computation is
+     * kept in a CopyOnWrite object so that get() does not hold up the
+     * threads that send samples.
+     *
+     *
+     * @tparam InputType The C++ type used for the samples $x_k$. The same
+     *   requirements hold as for the CovarianceMatrix class.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    class WindowedCovarianceMatrix : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the input type.
+         */
+        using scalar_type = types::ScalarType<InputType>;
+
+        /**
+         * The type of the covariance matrix returned by get().
+         */
+        using value_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * The type of the mean value returned by get_mean().
+         */
+        using mean_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+
+        /**
+         * Constructor.
+         *
+         * This class needs to process samples in the order in which they
+         * were generated, and consequently calls the base class constructor
+         * with `ParallelMode::synchronous | ParallelMode::dedicated_thread`
+         * as argument.
+         *
+         * @param[in] window_size The number $N$ of most recent samples over
+         *   which the mean and covariance are computed. Must be at least
+         *   one.
+         */
+        WindowedCovarianceMatrix (const std::size_t window_size);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~WindowedCovarianceMatrix ();
+
+        /**
+         * Process one sample by adding it to the window, and removing the
+         * oldest sample from the window if it is full.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count and weight of the sample
+         *   (see AuxiliaryData::n_repetitions() and AuxiliaryData::weight())
+         *   and ignores all other data.
+         */
+        virtual
+        void
+        consume (InputType     sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Return the covariance matrix of the samples currently in the
+         * window. If no samples have been processed so far, an empty matrix
+         * is returned.
+         */
+        value_type
+        get () const;
+
+        /**
+         * Return the (weighted) mean value of the samples currently in the
+         * window. If no samples have been processed so far, an empty vector
+         * is returned.
+         */
+        mean_type
+        get_mean () const;
+
+        /**
+         * Return the number of samples currently in the window. This is
+         * the number of samples processed so far (counting repetitions)
+         * until the window is full, and the window size after that.
+         */
+        std::size_t
+        n_samples_in_window () const;
+
+        /**
+         * Append the samples in the window and their weights to the given
+         * buffer. See the section on saving and combining the state of
+         * consumers in the documentation of the Consumer base class.
+         */
+        void
+        save (std::vector<char> &buffer) const;
+
+        /**
+         * Replace the state of this object by the one previously written by
+         * save(), read from the front of the given buffer. The buffer is
+         * advanced past the data read. The object that wrote the data must
+         * have used the same window size as the current one.
+         */
+        void
+        load (std::span<const char> &buffer);
+
+        /**
+         * Return an estimate of the memory used by the window and the
+         * running statistics.
+         */
+        virtual
+        std::size_t
+        memory_consumption () const override;
+
+      private:
+        /**
+         * The size of the window.
+         */
+        const std::size_t window_size;
+
+        /**
+         * A structure that describes the samples in the window and their
+         * statistics.
+         */
+        struct State
+        {
+          /**
+           * The samples in the window, one per column, and their weights.
+           * Once the window is full, `first` is the column of the oldest
+           * sample, and a new sample replaces it.
+           */
+          value_type          samples;
+          std::vector<double> weights;
+          std::size_t         n_samples = 0;
+          std::size_t         first = 0;
+
+          /**
+           * The mean value $\bar x$ and the sum of outer products $M$ (of
+           * which only the lower triangle is kept up to date), along with
+           * the sums of weights $W$ and $W_2$ of the samples in the window.
+           */
+          mean_type  mean;
+          value_type sum_of_products;
+          double     total_weight = 0;
+          double     total_squared_weight = 0;
+
+          /**
+           * The number of samples removed from the window since $\bar x$
+           * and $M$ were last computed from scratch.
+           */
+          std::size_t n_removals = 0;
+
+          /**
+           * Add one copy of the given sample with the given weight to the
+           * window, removing the oldest sample if the window is full.
+           */
+          void
+          add_sample (const mean_type  &sample,
+                      const double      weight,
+                      const std::size_t window_size);
+
+          /**
+           * Update $\bar x$, $M$, $W$, and $W_2$ for a sample entering or
+           * leaving the window.
+           */
+          void
+          add_to_statistics (const mean_type &sample,
+                             const double     weight);
+
+          void
+          remove_from_statistics (const mean_type &sample,
+                                  const double     weight);
+
+          /**
+           * Add $f \delta\delta^T$ to the lower triangle of $M$.
+           */
+          void
+          add_rank_one (const mean_type &delta,
+                        const double     factor);
+
+          /**
+           * Compute $\bar x$, $M$, $W$, and $W_2$ from the samples in the
+           * window.
+           */
+          void
+          recompute_statistics ();
+        };
+
+        /**
+         * The current state, along with a mutex that protects it if
+         * several threads send samples to this object.
+         */
+        CopyOnWrite<State> state;
+
+        /**
+         * Copy the elements of a sample into an Eigen vector.
+         */
+        static
+        mean_type
+        to_vector (const InputType &sample);
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    WindowedCovarianceMatrix<InputType>::
+    WindowedCovarianceMatrix (const std::size_t window_size)
+      :
+      Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                       |
+                                       static_cast<int>(ParallelMode::dedicated_thread))),
+      window_size (window_size)
+    {
+      assert (window_size >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    WindowedCovarianceMatrix<InputType>::
+    ~WindowedCovarianceMatrix ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::
+    consume (InputType sample, AuxiliaryData aux_data)
+    {
+      const double weight = aux_data.weight();
+      if ((aux_data.n_repetitions() == 0) || (weight == 0))
+        return;
+
+      // A sample that is repeated more often than the window is long
+      // fills the whole window:
+      const std::size_t n_copies
+        = std::min<std::size_t> (aux_data.n_repetitions(), window_size);
+      const mean_type x = to_vector (sample);
+
+      state.modify ([&](State &current_state)
+      {
+        for (std::size_t i=0; i<n_copies; ++i)
+          current_state.add_sample (x, weight, window_size);
+      }, this->is_single_threaded() == false);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::State::
+    add_sample (const mean_type  &sample,
+                const double      weight,
+                const std::size_t window_size)
+    {
+      // Set up the window with the first sample:
+      if (samples.cols() == 0)
+        {
+          samples.resize (sample.size(), window_size);
+          weights.resize (window_size);
+          mean = mean_type::Zero (sample.size());
+          sum_of_products = value_type::Zero (sample.size(), sample.size());
+        }
+      assert (sample.size() == samples.rows());
+
+      // If the window is full, take out the oldest sample and put the new
+      // one in its place:
+      std::size_t column;
+      if (n_samples == window_size)
+        {
+          column = first;
+          first = (first + 1) % window_size;
+
+          remove_from_statistics (samples.col(column), weights[column]);
+          ++n_removals;
+        }
+      else
+        {
+          column = n_samples;
+          ++n_samples;
+        }
+
+      samples.col(column) = sample;
+      weights[column] = weight;
+      add_to_statistics (sample, weight);
+
+      // Get rid of the round-off errors the removals have accumulated,
+      // once every window_size removals:
+      if (n_removals >= window_size)
+        recompute_statistics ();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::State::
+    add_to_statistics (const mean_type &sample,
+                       const double     weight)
+    {
+      const double combined_weight = total_weight + weight;
+      const mean_type delta = sample - mean;
+
+      add_rank_one (delta, total_weight * weight / combined_weight);
+      mean += (weight / combined_weight) * delta;
+
+      total_weight = combined_weight;
+      total_squared_weight += weight * weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::State::
+    remove_from_statistics (const mean_type &sample,
+                            const double     weight)
+    {
+      const double remaining_weight = total_weight - weight;
+
+      // If nothing remains (which, since samples are removed only to make
+      // room for a new one, only happens for windows of length one), start
+      // from scratch:
+      if (remaining_weight <= 0)
+        {
+          mean.setZero();
+          sum_of_products.setZero();
+          total_weight = 0;
+          total_squared_weight = 0;
+          return;
+        }
+
+      const mean_type delta = sample - mean;
+
+      add_rank_one (delta, -total_weight * weight / remaining_weight);
+      mean -= (weight / remaining_weight) * delta;
+
+      total_weight = remaining_weight;
+      total_squared_weight -= weight * weight;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::State::
+    add_rank_one (const mean_type &delta,
+                  const double     factor)
+    {
+      if constexpr (types::is_complex<scalar_type>)
+        Utilities::add_hermitian_rank_one (sum_of_products.data(),
+                                           sum_of_products.outerStride(),
+                                           std::span<const scalar_type>(delta.data(), delta.size()),
+                                           factor);
+      else
+        sum_of_products.template selfadjointView<Eigen::Lower>()
+        .rankUpdate (delta, factor);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::State::
+    recompute_statistics ()
+    {
+      total_weight = 0;
+      total_squared_weight = 0;
+      mean.setZero();
+      for (std::size_t j=0; j<n_samples; ++j)
+        {
+          mean += weights[j] * samples.col(j);
+          total_weight += weights[j];
+          total_squared_weight += weights[j] * weights[j];
+        }
+      mean /= total_weight;
+
+      // Compute M = Y Y^T, where the columns of Y are the deviations of
+      // the samples from the mean, scaled by the square roots of their
+      // weights:
+      value_type deviations (samples.rows(), n_samples);
+      for (std::size_t j=0; j<n_samples; ++j)
+        deviations.col(j) = std::sqrt(weights[j]) * (samples.col(j) - mean);
+      sum_of_products.setZero();
+      sum_of_products.template selfadjointView<Eigen::Lower>().rankUpdate (deviations);
+
+      n_removals = 0;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename WindowedCovarianceMatrix<InputType>::value_type
+    WindowedCovarianceMatrix<InputType>::
+    get () const
+    {
+      const std::shared_ptr<const State> current_state = state.snapshot();
+
+      // As in CovarianceMatrix::get(), if the window contains fewer than
+      // two distinct samples, the normalization factor is zero, but so is
+      // the sum of products:
+      const value_type sum_of_products
+        = current_state->sum_of_products.template selfadjointView<Eigen::Lower>();
+      const double normalization
+        = (current_state->total_weight > 0
+           ?
+           current_state->total_weight
+           - current_state->total_squared_weight / current_state->total_weight
+           :
+           0.);
+      if (normalization > 0)
+        return sum_of_products / normalization;
+      else
+        return sum_of_products;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename WindowedCovarianceMatrix<InputType>::mean_type
+    WindowedCovarianceMatrix<InputType>::
+    get_mean () const
+    {
+      return state.snapshot()->mean;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::size_t
+    WindowedCovarianceMatrix<InputType>::
+    n_samples_in_window () const
+    {
+      return state.snapshot()->n_samples;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::
+    save (std::vector<char> &buffer) const
+    {
+      const std::shared_ptr<const State> current_state = state.snapshot();
+
+      // Write the samples from the oldest to the newest, which is all that
+      // is needed to restore the state:
+      const std::size_t n_samples = current_state->n_samples;
+      const std::size_t first     = current_state->first;
+
+      value_type          samples (current_state->samples.rows(), n_samples);
+      std::vector<double> weights (n_samples);
+      for (std::size_t j=0; j<n_samples; ++j)
+        {
+          const std::size_t column = (first + j) % std::max<std::size_t> (current_state->samples.cols(), 1);
+          samples.col(j) = current_state->samples.col(column);
+          weights[j]     = current_state->weights[column];
+        }
+
+      Serialization::write (buffer, samples);
+      Serialization::write (buffer, weights);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    void
+    WindowedCovarianceMatrix<InputType>::
+    load (std::span<const char> &buffer)
+    {
+      value_type          samples;
+      std::vector<double> weights;
+      Serialization::read (buffer, samples);
+      Serialization::read (buffer, weights);
+      assert (static_cast<std::size_t>(samples.cols()) == weights.size());
+      assert (weights.size() <= window_size);
+
+      State new_state;
+      for (std::size_t j=0; j<weights.size(); ++j)
+        new_state.add_sample (samples.col(j), weights[j], window_size);
+      if (new_state.n_samples > 0)
+        new_state.recompute_statistics ();
+
+      state.modify ([&new_state](State &current_state)
+      {
+        current_state = std::move (new_state);
+      });
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    std::size_t
+    WindowedCovarianceMatrix<InputType>::
+    memory_consumption () const
+    {
+      const std::shared_ptr<const State> current_state = state.snapshot();
+      return (sizeof(State)
+              + Memory::memory_consumption (current_state->samples)
+              + Memory::memory_consumption (current_state->weights)
+              + Memory::memory_consumption (current_state->mean)
+              + Memory::memory_consumption (current_state->sum_of_products));
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>)
+    typename WindowedCovarianceMatrix<InputType>::mean_type
+    WindowedCovarianceMatrix<InputType>::
+    to_vector (const InputType &sample)
+    {
+      const unsigned int size = Utilities::size(sample);
+      if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+        return Eigen::Map<const mean_type> (std::ranges::data(sample), size);
+      else
+        {
+          mean_type x (size);
+          for (unsigned int i=0; i<size; ++i)
+            x[i] = Utilities::get_nth_element (sample, i);
+          return x;
+        }
+    }
+  }
+}
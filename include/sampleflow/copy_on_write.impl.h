@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores an object of type `T` that is modified by some
+   * threads and read by others, in such a way that readers can obtain a
+   * consistent copy ("snapshot") of the object without holding up the
+   * threads that modify it.
+   *
+   * A typical use case is a consumer such as Consumers::CovarianceMatrix
+   * whose state is updated for every sample while sampling is running, and
+   * whose get() function is called periodically from a different thread to
+   * monitor progress. If the consumer protected its state with a mutex and
+   * the get() function copied the state while holding this mutex, then
+   * the sampler would have to wait every time get() is called, for as long
+   * as it takes to copy a potentially large object and to compute derived
+   * quantities from it.
+   *
+   * Instead, this class stores the object via a `std::shared_ptr`. The
+   * snapshot() function only holds a lock for as long as it takes to copy
+   * this pointer, and returns a shared pointer to the object that readers
+   * can then use for as long as they want, without a lock. The modify()
+   * function, on the other hand, checks whether any reader still holds a
+   * snapshot of the object. If so, it makes a copy of the object first,
+   * and modifies the copy; otherwise, it modifies the object in place. In
+   * other words, the object is copied at most once for every call to
+   * snapshot(), and the copy is made by the next thread that modifies
+   * the object and only if the reader is still using the snapshot at
+   * that time.
+   *
+   * The object, along with the reference count of the `std::shared_ptr`
+   * that points to it, is allocated by Memory::CacheLineAllocator and so
+   * occupies cache lines of its own. This matters because objects of
+   * this class are typically small, numerous, and each updated by a
+   * different thread (for example, the shards of a ShardedAccumulator):
+   * If two of them ended up next to each other in memory, the threads
+   * updating them would constantly steal the cache line from each other.
+   *
+   * @tparam T The type of the object stored. It needs to be copy-constructible.
+   */
+  template <typename T>
+  class CopyOnWrite
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] initial_value The value the stored object starts out with.
+       */
+      CopyOnWrite (const T &initial_value = T());
+
+      /**
+       * Copy constructor. This creates a copy of the object stored by the
+       * argument, rather than sharing the object with the argument.
+       */
+      CopyOnWrite (const CopyOnWrite &o);
+
+      /**
+       * Modify the stored object by calling the function object given as
+       * argument with a reference to it. The function object is called while
+       * holding a lock, so calls to this function from different threads
+       * are serialized.
+       *
+       * @param[in] modify_function The function object that modifies the
+       *   stored object.
+       * @param[in] synchronize Whether to acquire the lock. Callers can pass
+       *   `false` if they can guarantee that no other thread calls any
+       *   member function of this object at the same time, for example
+       *   because they process samples in ParallelMode::single_threaded.
+       */
+      template <typename ModifyFunction>
+      void
+      modify (const ModifyFunction &modify_function,
+              const bool synchronize = true);
+
+      /**
+       * Return a pointer to an object that has the current value of the
+       * stored object. The object pointed to will not be modified by any
+       * other thread in the future.
+       */
+      std::shared_ptr<const T>
+      snapshot () const;
+
+    private:
+      /**
+       * A mutex that protects the `value` pointer and, in modify(), the
+       * object it points to.
+       */
+      mutable std::mutex mutex;
+
+      /**
+       * A pointer to the stored object.
+       */
+      std::shared_ptr<T> value;
+  };
+
+
+
+  template <typename T>
+  CopyOnWrite<T>::
+  CopyOnWrite (const T &initial_value)
+    :
+    value (std::allocate_shared<T>(Memory::CacheLineAllocator<T>(), initial_value))
+  {}
+
+
+
+  template <typename T>
+  CopyOnWrite<T>::
+  CopyOnWrite (const CopyOnWrite &o)
+    :
+    value (std::allocate_shared<T>(Memory::CacheLineAllocator<T>(), *o.snapshot()))
+  {}
+
+
+
+  template <typename T>
+  template <typename ModifyFunction>
+  void
+  CopyOnWrite<T>::
+  modify (const ModifyFunction &modify_function,
+          const bool synchronize)
+  {
+    std::unique_lock<std::mutex> lock (mutex, std::defer_lock);
+    if (synchronize)
+      lock.lock();
+
+    // If anyone else holds a pointer to the object, make a copy we
+    // can work on. (New pointers can only be created while holding
+    // the lock, so the use count can only decrease while we are here.)
+    // Otherwise, make sure that we see everything the last reader
+    // did before it released its pointer, before we modify the object.
+    if (value.use_count() > 1)
+      value = std::allocate_shared<T>(Memory::CacheLineAllocator<T>(), *value);
+    else
+      std::atomic_thread_fence (std::memory_order_acquire);
+
+    modify_function (*value);
+  }
+
+
+
+  template <typename T>
+  std::shared_ptr<const T>
+  CopyOnWrite<T>::
+  snapshot () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    return value;
+  }
+}
@@ -0,0 +1,741 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that allow writing parts of a sampling
+   * pipeline as C++20 coroutines. The typical use case is a producer that
+   * runs many chains whose log likelihoods are evaluated elsewhere -- on a
+   * remote machine, or on a GPU -- and that spend most of their time
+   * waiting for these evaluations. Running each of these chains on its own
+   * thread would require as many threads as there are chains; running them
+   * in lockstep on one thread (as some of the `sample_chains()` functions
+   * of the producers do) makes all chains wait for the slowest evaluation
+   * in every step. If each chain is instead a coroutine, then a chain that
+   * waits for the result of an evaluation simply suspends, and the thread
+   * it ran on can advance other chains in the meantime. This way, hundreds
+   * of chains can be multiplexed onto the few worker threads of a
+   * ThreadPool.
+   *
+   * Coroutines are functions that return an object of type Task and that
+   * use `co_await` to wait for results; they are run by handing them to an
+   * object of type Scheduler. For example, the following coroutine waits
+   * for the result of a function that returns a `std::future`, without
+   * blocking the thread it runs on:
+   * @code
+   *   SampleFlow::Coroutines::Task
+   *   evaluate (SampleFlow::Coroutines::Scheduler &scheduler,
+   *             const std::vector<double> &x)
+   *   {
+   *     const double value = co_await scheduler.wait_for (remote_evaluation(x));
+   *     ...
+   *   }
+   *
+   *   SampleFlow::Coroutines::Scheduler scheduler;
+   *   for (const auto &x : points)
+   *     scheduler.spawn (evaluate (scheduler, x));
+   *   scheduler.wait ();
+   * @endcode
+   */
+  namespace Coroutines
+  {
+    class Scheduler;
+
+
+    /**
+     * The type that coroutines run by a Scheduler need to return. An
+     * object of this type represents a coroutine that has been called, but
+     * that does not start executing until it is given to
+     * Scheduler::spawn(). Objects of this type can only be moved, not
+     * copied. If an object is destroyed without having been given to a
+     * scheduler, then the coroutine is destroyed without ever having run.
+     *
+     * @note Like tasks executed by a ThreadPool, coroutines must not throw
+     *   exceptions. An exception that escapes from a coroutine terminates
+     *   the program.
+     */
+    class Task
+    {
+      public:
+        /**
+         * The promise type C++ associates with coroutines returning a
+         * Task. It is not intended for direct use.
+         */
+        class promise_type
+        {
+          public:
+            /**
+             * Return the Task object that represents the coroutine.
+             */
+            Task
+            get_return_object () noexcept;
+
+            /**
+             * Suspend the coroutine right after it has been created: It only
+             * starts once it is given to Scheduler::spawn().
+             */
+            std::suspend_always
+            initial_suspend () const noexcept;
+
+            /**
+             * An awaitable object that, when the coroutine has finished,
+             * destroys it and tells the scheduler that ran it.
+             */
+            struct FinalAwaiter
+            {
+              bool
+              await_ready () const noexcept;
+
+              void
+              await_suspend (std::coroutine_handle<promise_type> coroutine) const noexcept;
+
+              void
+              await_resume () const noexcept;
+            };
+
+            /**
+             * Return the object used when the coroutine has finished.
+             */
+            FinalAwaiter
+            final_suspend () const noexcept;
+
+            /**
+             * Called when the coroutine executes `co_return`, or reaches its
+             * end.
+             */
+            void
+            return_void () const noexcept;
+
+            /**
+             * Called if an exception escapes from the coroutine. This
+             * terminates the program.
+             */
+            [[noreturn]]
+            void
+            unhandled_exception () const noexcept;
+
+          private:
+            /**
+             * The scheduler the coroutine has been given to, or `nullptr`
+             * if it has not been started yet.
+             */
+            Scheduler *scheduler = nullptr;
+
+            friend class Scheduler;
+        };
+
+        /**
+         * Move constructor.
+         */
+        Task (Task &&other) noexcept;
+
+        /**
+         * Copy constructor. Coroutines cannot be copied, and so this
+         * constructor is deleted.
+         */
+        Task (const Task &) = delete;
+
+        /**
+         * Destructor. If the coroutine has not been given to a Scheduler,
+         * then it is destroyed.
+         */
+        ~Task ();
+
+      private:
+        /**
+         * Constructor. Used by promise_type::get_return_object().
+         */
+        explicit
+        Task (const std::coroutine_handle<promise_type> coroutine);
+
+        /**
+         * The handle of the coroutine, or an empty handle if the coroutine
+         * has been given to a Scheduler.
+         */
+        std::coroutine_handle<promise_type> coroutine;
+
+        friend class Scheduler;
+    };
+
+
+
+    /**
+     * A class that runs coroutines (i.e., objects of type Task) on the
+     * worker threads of a ThreadPool. Coroutines are started with spawn(),
+     * and wait() waits until all coroutines started this way have
+     * finished.
+     *
+     * While a coroutine runs, it occupies a worker thread of the pool just
+     * like any other task. But when it waits for a result via
+     * `co_await scheduler.wait_for(future)` and the result is not available
+     * yet, the coroutine is suspended and the worker thread becomes
+     * available for other work. The scheduler keeps a list of the futures
+     * suspended coroutines are waiting for, and a separate thread checks
+     * these futures every `polling_interval`; once a future has become
+     * ready, the coroutine that waits for it is enqueued with the pool
+     * again and continues where it left off -- possibly on a different
+     * worker thread than the one it ran on before. (Polling is necessary
+     * because `std::future` does not provide a way to be notified when it
+     * becomes ready. The polling thread only wakes up while there are
+     * coroutines waiting.)
+     *
+     * Because coroutines run as tasks of a ThreadPool, they share the
+     * worker threads with the consumers and filters that use the same pool
+     * for ParallelMode::asynchronous; in particular, if a coroutine issues
+     * samples to asynchronous consumers, both the coroutine and the
+     * processing of its samples use the same, fixed set of threads.
+     *
+     * Objects of this type can be shared by several producers, but wait()
+     * waits for all coroutines spawned on the object, not only the ones a
+     * specific producer has started.
+     */
+    class Scheduler
+    {
+      public:
+        /**
+         * An awaitable object that suspends the coroutine that awaits it
+         * until the given future has a value, and then returns that value.
+         * Objects of this type are created by Scheduler::wait_for().
+         */
+        template <typename T>
+        class FutureAwaiter
+        {
+          public:
+            /**
+             * Constructor.
+             */
+            FutureAwaiter (Scheduler &scheduler,
+                           std::future<T> &&future);
+
+            /**
+             * Return whether the value is already available, in which case
+             * the coroutine does not need to be suspended.
+             */
+            bool
+            await_ready () const;
+
+            /**
+             * Suspend the coroutine and ask the scheduler to resume it once
+             * the future has a value.
+             */
+            void
+            await_suspend (const std::coroutine_handle<> coroutine);
+
+            /**
+             * Return the value of the future.
+             */
+            T
+            await_resume ();
+
+          private:
+            /**
+             * The scheduler that resumes the coroutine.
+             */
+            Scheduler &scheduler;
+
+            /**
+             * The future the coroutine waits for.
+             */
+            std::future<T> future;
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param[in] thread_pool The pool on whose worker threads the
+         *   coroutines are run. By default, this is the pool returned by
+         *   ThreadPool::default_pool().
+         * @param[in] polling_interval The time between two checks of whether
+         *   the futures suspended coroutines are waiting for have become
+         *   ready. Shorter intervals resume coroutines sooner, at the cost of
+         *   more frequent checks.
+         */
+        Scheduler (const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool(),
+                   const std::chrono::microseconds polling_interval = std::chrono::microseconds (100));
+
+        /**
+         * Copy constructor. Schedulers cannot be copied, and so this
+         * constructor is deleted.
+         */
+        Scheduler (const Scheduler &) = delete;
+
+        /**
+         * Destructor. Waits for all coroutines that are still running to
+         * finish.
+         */
+        ~Scheduler ();
+
+        /**
+         * Start running the given coroutine on one of the worker threads of
+         * the pool.
+         */
+        void
+        spawn (Task &&task);
+
+        /**
+         * Wait until all coroutines that have been started via spawn() have
+         * finished. If this function is called on one of the worker threads
+         * of a thread pool, then it executes other pending tasks of that pool
+         * in the meantime, as ThreadPool::TaskGroup::wait() does.
+         */
+        void
+        wait ();
+
+        /**
+         * Return the number of coroutines that have been started via spawn()
+         * and that have not finished yet.
+         */
+        std::size_t
+        n_active_tasks () const;
+
+        /**
+         * Return an object that, when awaited by a coroutine via `co_await`,
+         * suspends the coroutine until the given future has a value, and
+         * then returns this value. If the value is already available, then
+         * the coroutine continues right away.
+         */
+        template <typename T>
+        FutureAwaiter<T>
+        wait_for (std::future<T> &&future);
+
+      private:
+        /**
+         * The pool on which coroutines are run.
+         */
+        const std::shared_ptr<ThreadPool> thread_pool;
+
+        /**
+         * The time between two checks of the futures coroutines wait for.
+         */
+        const std::chrono::microseconds polling_interval;
+
+        /**
+         * The number of coroutines that have been started but have not
+         * finished yet, along with a mutex and condition variable to wait
+         * for it to become zero.
+         */
+        std::size_t             n_active;
+        mutable std::mutex      active_mutex;
+        std::condition_variable all_done;
+
+        /**
+         * A structure that describes a suspended coroutine: A function that
+         * returns whether the future the coroutine waits for has become
+         * ready, and the coroutine to resume once it has.
+         */
+        struct SuspendedCoroutine
+        {
+          std::function<bool ()>  is_ready;
+          std::coroutine_handle<> coroutine;
+        };
+
+        /**
+         * The list of suspended coroutines, along with a mutex that protects
+         * it and a condition variable used to wake up the polling thread
+         * when a coroutine is added to the list or the scheduler is
+         * destroyed.
+         */
+        std::vector<SuspendedCoroutine> suspended_coroutines;
+        std::mutex                      suspended_mutex;
+        std::condition_variable         coroutine_suspended;
+        bool                            shutting_down;
+
+        /**
+         * The thread that checks the futures suspended coroutines wait for.
+         */
+        std::thread polling_thread;
+
+        /**
+         * Enqueue the given coroutine with the thread pool so that it
+         * continues to run.
+         */
+        void
+        resume (const std::coroutine_handle<> coroutine);
+
+        /**
+         * Add the given coroutine to the list of suspended coroutines.
+         */
+        void
+        suspend (SuspendedCoroutine &&suspended_coroutine);
+
+        /**
+         * The function run by the polling thread.
+         */
+        void
+        poll ();
+
+        /**
+         * Record that one of the coroutines started via spawn() has
+         * finished.
+         */
+        void
+        task_finished ();
+
+        friend class Task::promise_type;
+    };
+
+
+
+    inline
+    Task
+    Task::promise_type::
+    get_return_object () noexcept
+    {
+      return Task (std::coroutine_handle<promise_type>::from_promise (*this));
+    }
+
+
+
+    inline
+    std::suspend_always
+    Task::promise_type::
+    initial_suspend () const noexcept
+    {
+      return {};
+    }
+
+
+
+    inline
+    bool
+    Task::promise_type::FinalAwaiter::
+    await_ready () const noexcept
+    {
+      return false;
+    }
+
+
+
+    inline
+    void
+    Task::promise_type::FinalAwaiter::
+    await_suspend (std::coroutine_handle<promise_type> coroutine) const noexcept
+    {
+      // The coroutine is suspended for the last time. We can destroy it,
+      // but need to get the scheduler from its promise first. Telling the
+      // scheduler has to be the very last thing we do since a thread
+      // waiting in Scheduler::wait() may destroy the scheduler right away.
+      Scheduler *const scheduler = coroutine.promise().scheduler;
+      assert (scheduler != nullptr);
+
+      coroutine.destroy ();
+      scheduler->task_finished ();
+    }
+
+
+
+    inline
+    void
+    Task::promise_type::FinalAwaiter::
+    await_resume () const noexcept
+    {}
+
+
+
+    inline
+    Task::promise_type::FinalAwaiter
+    Task::promise_type::
+    final_suspend () const noexcept
+    {
+      return {};
+    }
+
+
+
+    inline
+    void
+    Task::promise_type::
+    return_void () const noexcept
+    {}
+
+
+
+    inline
+    void
+    Task::promise_type::
+    unhandled_exception () const noexcept
+    {
+      std::terminate ();
+    }
+
+
+
+    inline
+    Task::Task (const std::coroutine_handle<promise_type> coroutine)
+      :
+      coroutine (coroutine)
+    {}
+
+
+
+    inline
+    Task::Task (Task &&other) noexcept
+      :
+      coroutine (std::exchange (other.coroutine, {}))
+    {}
+
+
+
+    inline
+    Task::~Task ()
+    {
+      if (coroutine)
+        coroutine.destroy ();
+    }
+
+
+
+    template <typename T>
+    Scheduler::FutureAwaiter<T>::
+    FutureAwaiter (Scheduler &scheduler,
+                   std::future<T> &&future)
+      :
+      scheduler (scheduler),
+      future (std::move(future))
+    {
+      assert (this->future.valid());
+    }
+
+
+
+    template <typename T>
+    bool
+    Scheduler::FutureAwaiter<T>::
+    await_ready () const
+    {
+      return (future.wait_for (std::chrono::seconds(0)) == std::future_status::ready);
+    }
+
+
+
+    template <typename T>
+    void
+    Scheduler::FutureAwaiter<T>::
+    await_suspend (const std::coroutine_handle<> coroutine)
+    {
+      // The current object lives in the frame of the suspended coroutine,
+      // and so remains valid until the coroutine is resumed. Note that the
+      // coroutine may be resumed on another thread before this function
+      // has even returned; we must therefore not touch the current object
+      // after handing the coroutine to the scheduler.
+      scheduler.suspend ({[this]()
+      {
+        return await_ready();
+      },
+      coroutine
+                         });
+    }
+
+
+
+    template <typename T>
+    T
+    Scheduler::FutureAwaiter<T>::
+    await_resume ()
+    {
+      return future.get();
+    }
+
+
+
+    inline
+    Scheduler::Scheduler (const std::shared_ptr<ThreadPool> &thread_pool,
+                          const std::chrono::microseconds polling_interval)
+      :
+      thread_pool (thread_pool),
+      polling_interval (polling_interval),
+      n_active (0),
+      shutting_down (false),
+      polling_thread ([this]()
+    {
+      poll();
+    })
+    {
+      assert (thread_pool != nullptr);
+    }
+
+
+
+    inline
+    Scheduler::~Scheduler ()
+    {
+      wait ();
+
+      {
+        std::lock_guard<std::mutex> lock (suspended_mutex);
+        shutting_down = true;
+      }
+      coroutine_suspended.notify_one ();
+      polling_thread.join ();
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    spawn (Task &&task)
+    {
+      assert (task.coroutine);
+
+      {
+        std::lock_guard<std::mutex> lock (active_mutex);
+        ++n_active;
+      }
+
+      task.coroutine.promise().scheduler = this;
+      resume (std::exchange (task.coroutine, {}));
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    wait ()
+    {
+      if (ThreadPool *const pool = ThreadPool::current_pool())
+        {
+          // We are on a worker thread. Help with pending work (which
+          // may include our own coroutines) until all coroutines are
+          // done.
+          while (n_active_tasks() > 0)
+            if (pool->run_pending_task() == false)
+              std::this_thread::yield();
+        }
+      else
+        {
+          std::unique_lock<std::mutex> lock (active_mutex);
+          all_done.wait (lock, [this]()
+          {
+            return (n_active == 0);
+          });
+        }
+    }
+
+
+
+    inline
+    std::size_t
+    Scheduler::
+    n_active_tasks () const
+    {
+      std::lock_guard<std::mutex> lock (active_mutex);
+      return n_active;
+    }
+
+
+
+    template <typename T>
+    Scheduler::FutureAwaiter<T>
+    Scheduler::
+    wait_for (std::future<T> &&future)
+    {
+      return FutureAwaiter<T> (*this, std::move(future));
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    resume (const std::coroutine_handle<> coroutine)
+    {
+      thread_pool->enqueue ([coroutine]()
+      {
+        coroutine.resume();
+      });
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    suspend (SuspendedCoroutine &&suspended_coroutine)
+    {
+      {
+        std::lock_guard<std::mutex> lock (suspended_mutex);
+        suspended_coroutines.emplace_back (std::move(suspended_coroutine));
+      }
+      coroutine_suspended.notify_one ();
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    poll ()
+    {
+      std::unique_lock<std::mutex> lock (suspended_mutex);
+      while (true)
+        {
+          // Sleep until there is something to do:
+          coroutine_suspended.wait (lock, [this]()
+          {
+            return (shutting_down || (suspended_coroutines.empty() == false));
+          });
+          if (suspended_coroutines.empty())
+            return;
+
+          // Move the coroutines whose futures have become ready to the
+          // end of the list, take them out, and resume them after
+          // releasing the lock (so that they can suspend again right
+          // away if they want to):
+          const auto first_ready
+            = std::partition (suspended_coroutines.begin(), suspended_coroutines.end(),
+                              [](const SuspendedCoroutine &suspended_coroutine)
+          {
+            return (suspended_coroutine.is_ready() == false);
+          });
+
+          if (first_ready == suspended_coroutines.end())
+            {
+              coroutine_suspended.wait_for (lock, polling_interval);
+              continue;
+            }
+
+          std::vector<std::coroutine_handle<>> ready_coroutines;
+          for (auto p=first_ready; p!=suspended_coroutines.end(); ++p)
+            ready_coroutines.push_back (p->coroutine);
+          suspended_coroutines.erase (first_ready, suspended_coroutines.end());
+
+          lock.unlock ();
+          for (const std::coroutine_handle<> coroutine : ready_coroutines)
+            resume (coroutine);
+          lock.lock ();
+        }
+    }
+
+
+
+    inline
+    void
+    Scheduler::
+    task_finished ()
+    {
+      // Decrement the counter and notify while holding the lock, so that
+      // a thread in wait() cannot see the counter at zero, return, and
+      // destroy the current object before we are done with it.
+      std::lock_guard<std::mutex> lock (active_mutex);
+      assert (n_active > 0);
+      if (--n_active == 0)
+        all_done.notify_all ();
+    }
+  }
+}
@@ -0,0 +1,35 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_CUDA_DEVICE_H
+#define SAMPLEFLOW_CUDA_DEVICE_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/concepts.h>
+
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+#  include <hip/hip_runtime_api.h>
+#else
+#  include <cuda_runtime_api.h>
+#endif
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/cuda/device.impl.h>
+
+#endif
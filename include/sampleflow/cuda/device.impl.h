@@ -0,0 +1,314 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that connect SampleFlow to the CUDA
+   * runtime. Like the classes in namespaces MPI, HDF5, and TBB, these
+   * classes are not included in the SampleFlow module and require linking
+   * with the external library (`libcudart`).
+   *
+   * If the preprocessor symbol `SAMPLEFLOW_CUDA_USE_HIP` is defined before
+   * the header files of this namespace are included, the classes use the
+   * HIP runtime instead, whose interface mirrors that of CUDA, and so
+   * work with AMD GPUs.
+   */
+  namespace CUDA
+  {
+    namespace internal
+    {
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      using stream_type = hipStream_t;
+      using error_type  = hipError_t;
+      constexpr error_type success = hipSuccess;
+
+      inline const char *error_string (const error_type e)
+      {
+        return hipGetErrorString (e);
+      }
+#else
+      using stream_type = cudaStream_t;
+      using error_type  = cudaError_t;
+      constexpr error_type success = cudaSuccess;
+
+      inline const char *error_string (const error_type e)
+      {
+        return cudaGetErrorString (e);
+      }
+#endif
+
+      /**
+       * Throw an exception if the given return value of a function of
+       * the runtime indicates an error.
+       */
+      inline
+      void
+      check (const error_type error,
+             const char      *function)
+      {
+        if (error != success)
+          throw std::runtime_error (std::string("SampleFlow::CUDA: ") + function
+                                    + " failed: " + error_string(error));
+      }
+    }
+
+
+    /**
+     * A class that provides access to a GPU through the CUDA (or HIP)
+     * runtime, in the way described by Concepts::is_device. Its main use
+     * is as template argument of DeviceLogLikelihood.
+     *
+     * All functions of this class first make the device given to the
+     * constructor the current device of the calling thread. Errors
+     * reported by the runtime are turned into exceptions of type
+     * `std::runtime_error`.
+     */
+    class Device
+    {
+      public:
+        /**
+         * The type that identifies a stream.
+         */
+        using stream_type = internal::stream_type;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] device_number The number of the GPU to use, as counted
+         *   by the runtime.
+         */
+        explicit
+        Device (const int device_number = 0);
+
+        /**
+         * Create a stream whose operations do not synchronize with the
+         * default stream.
+         */
+        stream_type
+        create_stream () const;
+
+        void
+        destroy_stream (stream_type stream) const;
+
+        /**
+         * Allocate and free pinned (page-locked) host memory.
+         */
+        void *
+        allocate_host_memory (const std::size_t n_bytes) const;
+
+        void
+        free_host_memory (void *pointer) const;
+
+        /**
+         * Allocate and free memory on the device.
+         */
+        void *
+        allocate_device_memory (const std::size_t n_bytes) const;
+
+        void
+        free_device_memory (void *pointer) const;
+
+        /**
+         * Enqueue a copy from host to device, or from device to host, in
+         * the given stream.
+         */
+        void
+        copy_to_device (void              *device_pointer,
+                        const void        *host_pointer,
+                        const std::size_t  n_bytes,
+                        stream_type        stream) const;
+
+        void
+        copy_to_host (void              *host_pointer,
+                      const void        *device_pointer,
+                      const std::size_t  n_bytes,
+                      stream_type        stream) const;
+
+        /**
+         * Wait for all operations enqueued in the given stream to finish.
+         */
+        void
+        synchronize (stream_type stream) const;
+
+      private:
+        /**
+         * The number of the GPU.
+         */
+        int device_number;
+
+        /**
+         * Make the GPU the current device of the calling thread.
+         */
+        void
+        activate () const;
+    };
+
+    static_assert (Concepts::is_device<Device>);
+
+
+
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+#  define SAMPLEFLOW_CUDA_CALL(f, ...) internal::check (hip ## f (__VA_ARGS__), "hip" #f)
+#else
+#  define SAMPLEFLOW_CUDA_CALL(f, ...) internal::check (cuda ## f (__VA_ARGS__), "cuda" #f)
+#endif
+
+
+    inline
+    Device::Device (const int device_number)
+      :
+      device_number (device_number)
+    {}
+
+
+
+    inline
+    void
+    Device::activate () const
+    {
+      SAMPLEFLOW_CUDA_CALL (SetDevice, device_number);
+    }
+
+
+
+    inline
+    Device::stream_type
+    Device::create_stream () const
+    {
+      activate ();
+      stream_type stream;
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      SAMPLEFLOW_CUDA_CALL (StreamCreateWithFlags, &stream, hipStreamNonBlocking);
+#else
+      SAMPLEFLOW_CUDA_CALL (StreamCreateWithFlags, &stream, cudaStreamNonBlocking);
+#endif
+      return stream;
+    }
+
+
+
+    inline
+    void
+    Device::destroy_stream (stream_type stream) const
+    {
+      activate ();
+      SAMPLEFLOW_CUDA_CALL (StreamDestroy, stream);
+    }
+
+
+
+    inline
+    void *
+    Device::allocate_host_memory (const std::size_t n_bytes) const
+    {
+      activate ();
+      void *pointer;
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      SAMPLEFLOW_CUDA_CALL (HostMalloc, &pointer, n_bytes, 0);
+#else
+      SAMPLEFLOW_CUDA_CALL (MallocHost, &pointer, n_bytes);
+#endif
+      return pointer;
+    }
+
+
+
+    inline
+    void
+    Device::free_host_memory (void *pointer) const
+    {
+      activate ();
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      SAMPLEFLOW_CUDA_CALL (HostFree, pointer);
+#else
+      SAMPLEFLOW_CUDA_CALL (FreeHost, pointer);
+#endif
+    }
+
+
+
+    inline
+    void *
+    Device::allocate_device_memory (const std::size_t n_bytes) const
+    {
+      activate ();
+      void *pointer;
+      SAMPLEFLOW_CUDA_CALL (Malloc, &pointer, n_bytes);
+      return pointer;
+    }
+
+
+
+    inline
+    void
+    Device::free_device_memory (void *pointer) const
+    {
+      activate ();
+      SAMPLEFLOW_CUDA_CALL (Free, pointer);
+    }
+
+
+
+    inline
+    void
+    Device::copy_to_device (void              *device_pointer,
+                            const void        *host_pointer,
+                            const std::size_t  n_bytes,
+                            stream_type        stream) const
+    {
+      activate ();
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      SAMPLEFLOW_CUDA_CALL (MemcpyAsync, device_pointer, host_pointer, n_bytes,
+                            hipMemcpyHostToDevice, stream);
+#else
+      SAMPLEFLOW_CUDA_CALL (MemcpyAsync, device_pointer, host_pointer, n_bytes,
+                            cudaMemcpyHostToDevice, stream);
+#endif
+    }
+
+
+
+    inline
+    void
+    Device::copy_to_host (void              *host_pointer,
+                          const void        *device_pointer,
+                          const std::size_t  n_bytes,
+                          stream_type        stream) const
+    {
+      activate ();
+#ifdef SAMPLEFLOW_CUDA_USE_HIP
+      SAMPLEFLOW_CUDA_CALL (MemcpyAsync, host_pointer, device_pointer, n_bytes,
+                            hipMemcpyDeviceToHost, stream);
+#else
+      SAMPLEFLOW_CUDA_CALL (MemcpyAsync, host_pointer, device_pointer, n_bytes,
+                            cudaMemcpyDeviceToHost, stream);
+#endif
+    }
+
+
+
+    inline
+    void
+    Device::synchronize (stream_type stream) const
+    {
+      activate ();
+      SAMPLEFLOW_CUDA_CALL (StreamSynchronize, stream);
+    }
+
+
+#undef SAMPLEFLOW_CUDA_CALL
+  }
+}
@@ -0,0 +1,381 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that evaluates the logarithm of the likelihood for batches of
+   * samples on an accelerator such as a GPU, and that can be used wherever
+   * a types::BatchLogLikelihood is expected -- for example, in
+   * Producers::MetropolisHastings::sample_chains() and
+   * Producers::DifferentialEvaluationMetropolisHastings::sample(). The
+   * sampling algorithms and everything connected to them downstream are
+   * not aware that the likelihood is evaluated on a device.
+   *
+   * For each batch of samples, the class
+   * - copies the elements of all samples into one contiguous array in
+   *   pinned host memory (see Concepts::is_device);
+   * - transfers this array to the device with one asynchronous copy;
+   * - calls the user-provided "kernel" function, which is expected to
+   *   enqueue the computation of the log likelihoods of all samples of
+   *   the array in the given stream, and to write them into the given
+   *   array of `double`s on the device;
+   * - transfers these values back with one asynchronous copy, and waits
+   *   for the stream to finish only once all of this has been enqueued.
+   *
+   * There is consequently one synchronization with the device per batch,
+   * rather than one per sample. Moreover, the batch is split into as many
+   * pieces as there are buffers (two by default), each with its own
+   * stream and its own host and device memory: While the device works on
+   * one piece, the host already packs the next piece into the next buffer
+   * and enqueues its work, and then unpacks the results of the first piece
+   * while the device works on the second ("double buffering"). The buffers
+   * are allocated upon first use and grow as necessary; they are reused for
+   * subsequent batches.
+   *
+   * The kernel function has the signature
+   * @code
+   *   void kernel (const Scalar *samples,
+   *                std::size_t n_samples,
+   *                std::size_t sample_size,
+   *                double *log_likelihoods,
+   *                typename Device::stream_type stream);
+   * @endcode
+   * where `samples` points to device memory that stores `n_samples`
+   * samples of `sample_size` elements each, one after the other, and
+   * `log_likelihoods` points to device memory with room for `n_samples`
+   * values. With CUDA, it would typically just launch a kernel:
+   * @code
+   *   SampleFlow::DeviceLogLikelihood<Eigen::VectorXd,SampleFlow::CUDA::Device>
+   *   log_likelihood (SampleFlow::CUDA::Device(),
+   *                   [](const double *samples, std::size_t n_samples,
+   *                      std::size_t sample_size, double *log_likelihoods,
+   *                      cudaStream_t stream)
+   *                   {
+   *                     evaluate<<<(n_samples+255)/256, 256, 0, stream>>>
+   *                       (samples, n_samples, sample_size, log_likelihoods);
+   *                   });
+   *   mh_sampler.sample_chains (starting_points, log_likelihood, propose, n_samples);
+   * @endcode
+   *
+   * All samples of a batch need to have the same number of elements. Calls
+   * from different threads are serialized, since they share the buffers.
+   * Copies of an object of this class (for example, the one that
+   * `std::function` makes when the object is passed as a
+   * types::BatchLogLikelihood) share the device, buffers, and streams.
+   *
+   * @tparam SampleType The type of the samples.
+   * @tparam Device A class that describes how memory is allocated on,
+   *   and transferred to and from, the device. It needs to satisfy the
+   *   Concepts::is_device concept.
+   * @tparam Scalar The type in which the elements of the samples are
+   *   stored on the device. By default, this is types::ScalarType.
+   */
+  template <typename SampleType,
+            typename Device,
+            typename Scalar = std::remove_cvref_t<types::ScalarType<SampleType>>>
+  requires (Concepts::is_device<Device>)
+  class DeviceLogLikelihood
+  {
+    public:
+      /**
+       * The type of the function that enqueues the evaluation of the log
+       * likelihoods of the samples stored on the device. See the
+       * documentation of the class.
+       */
+      using Kernel = std::function<void (const Scalar *samples,
+                                         const std::size_t n_samples,
+                                         const std::size_t sample_size,
+                                         double *log_likelihoods,
+                                         typename Device::stream_type stream)>;
+
+      /**
+       * Constructor.
+       *
+       * @param[in] device The object that provides access to the device.
+       * @param[in] kernel The function that enqueues the evaluation of the
+       *   log likelihoods of samples on the device.
+       * @param[in] n_buffers The number of pieces each batch is split
+       *   into, each of which has its own stream and its own memory. With
+       *   one buffer, there is no overlap between work on the host and on
+       *   the device.
+       */
+      DeviceLogLikelihood (const Device &device,
+                           const Kernel &kernel,
+                           const unsigned int n_buffers = 2);
+
+      /**
+       * Evaluate the log likelihoods of the given samples. This is the
+       * function through which objects of this class act as a
+       * types::BatchLogLikelihood.
+       */
+      void
+      operator() (std::span<const SampleType> samples,
+                  std::span<double>           log_likelihoods) const;
+
+      /**
+       * Return the number of batches evaluated so far, and the number of
+       * times the host has waited for a stream to finish. The latter is at
+       * most the number of buffers times the number of batches.
+       */
+      std::size_t
+      n_batches () const;
+
+      std::size_t
+      n_synchronizations () const;
+
+    private:
+      /**
+       * A buffer: A stream, along with host and device memory for the
+       * samples and log likelihoods of one piece of a batch. The memory has
+       * room for `capacity` samples of `sample_size` elements each.
+       */
+      struct Buffer
+      {
+        typename Device::stream_type stream;
+        Scalar      *host_samples           = nullptr;
+        Scalar      *device_samples         = nullptr;
+        double      *host_log_likelihoods   = nullptr;
+        double      *device_log_likelihoods = nullptr;
+        std::size_t  capacity               = 0;
+        std::size_t  sample_size            = 0;
+      };
+
+      /**
+       * Everything that copies of an object share. The destructor waits
+       * for all streams and releases all memory.
+       */
+      struct State
+      {
+        Device              device;
+        Kernel              kernel;
+        std::vector<Buffer> buffers;
+        std::mutex          mutex;
+        std::size_t         n_batches          = 0;
+        std::size_t         n_synchronizations = 0;
+
+        State (const Device &device,
+               const Kernel &kernel);
+
+        ~State ();
+
+        /**
+         * Make sure the given buffer has room for the given number of
+         * samples of the given size. The buffer must not be in use.
+         */
+        void
+        reserve (Buffer &buffer,
+                 const std::size_t n_samples,
+                 const std::size_t sample_size);
+
+        /**
+         * Release the memory of the given buffer.
+         */
+        void
+        release (Buffer &buffer);
+      };
+
+      std::shared_ptr<State> state;
+  };
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  DeviceLogLikelihood<SampleType,Device,Scalar>::State::
+  State (const Device &device,
+         const Kernel &kernel)
+    :
+    device (device),
+    kernel (kernel)
+  {}
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  DeviceLogLikelihood<SampleType,Device,Scalar>::State::
+  ~State ()
+  {
+    for (Buffer &buffer : buffers)
+      {
+        device.synchronize (buffer.stream);
+        release (buffer);
+        device.destroy_stream (buffer.stream);
+      }
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  void
+  DeviceLogLikelihood<SampleType,Device,Scalar>::State::
+  reserve (Buffer &buffer,
+           const std::size_t n_samples,
+           const std::size_t sample_size)
+  {
+    if ((n_samples <= buffer.capacity) && (sample_size == buffer.sample_size))
+      return;
+
+    // Grow geometrically so that slowly growing batches do not lead to
+    // a reallocation every time:
+    const std::size_t capacity = std::max (n_samples,
+                                           (sample_size == buffer.sample_size ?
+                                            2*buffer.capacity :
+                                            std::size_t(0)));
+    release (buffer);
+
+    buffer.host_samples
+      = static_cast<Scalar *>(device.allocate_host_memory (capacity * sample_size * sizeof(Scalar)));
+    buffer.device_samples
+      = static_cast<Scalar *>(device.allocate_device_memory (capacity * sample_size * sizeof(Scalar)));
+    buffer.host_log_likelihoods
+      = static_cast<double *>(device.allocate_host_memory (capacity * sizeof(double)));
+    buffer.device_log_likelihoods
+      = static_cast<double *>(device.allocate_device_memory (capacity * sizeof(double)));
+    buffer.capacity    = capacity;
+    buffer.sample_size = sample_size;
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  void
+  DeviceLogLikelihood<SampleType,Device,Scalar>::State::
+  release (Buffer &buffer)
+  {
+    if (buffer.capacity == 0)
+      return;
+
+    device.free_host_memory (buffer.host_samples);
+    device.free_device_memory (buffer.device_samples);
+    device.free_host_memory (buffer.host_log_likelihoods);
+    device.free_device_memory (buffer.device_log_likelihoods);
+    buffer = Buffer {buffer.stream};
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  DeviceLogLikelihood<SampleType,Device,Scalar>::
+  DeviceLogLikelihood (const Device &device,
+                       const Kernel &kernel,
+                       const unsigned int n_buffers)
+    :
+    state (std::make_shared<State>(device, kernel))
+  {
+    assert (n_buffers >= 1);
+
+    for (unsigned int b=0; b<n_buffers; ++b)
+      state->buffers.emplace_back (Buffer {state->device.create_stream()});
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  void
+  DeviceLogLikelihood<SampleType,Device,Scalar>::
+  operator() (std::span<const SampleType> samples,
+              std::span<double>           log_likelihoods) const
+  {
+    assert (samples.size() == log_likelihoods.size());
+
+    const std::size_t n_samples = samples.size();
+    if (n_samples == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock (state->mutex);
+    ++state->n_batches;
+
+    const std::size_t sample_size = Utilities::size (samples[0]);
+    const std::size_t n_pieces    = std::min<std::size_t> (state->buffers.size(), n_samples);
+
+    // Enqueue the work for all pieces, one per buffer. Each piece only
+    // needs to be packed, and its work enqueued; none of this waits for
+    // the device.
+    for (std::size_t piece=0; piece<n_pieces; ++piece)
+      {
+        Buffer &buffer = state->buffers[piece];
+        const std::size_t begin = piece * n_samples / n_pieces;
+        const std::size_t end   = (piece+1) * n_samples / n_pieces;
+
+        state->reserve (buffer, end-begin, sample_size);
+
+        Scalar *p = buffer.host_samples;
+        for (std::size_t i=begin; i<end; ++i, p+=sample_size)
+          {
+            assert (static_cast<std::size_t>(Utilities::size (samples[i])) == sample_size);
+            if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>
+                          &&
+                          std::is_same_v<std::remove_cvref_t<types::ScalarType<SampleType>>, Scalar>)
+              std::memcpy (p, Utilities::as_span (samples[i]).data(), sample_size * sizeof(Scalar));
+            else
+              for (std::size_t d=0; d<sample_size; ++d)
+                p[d] = static_cast<Scalar>(Utilities::get_nth_element (samples[i], d));
+          }
+
+        state->device.copy_to_device (buffer.device_samples, buffer.host_samples,
+                                      (end-begin) * sample_size * sizeof(Scalar),
+                                      buffer.stream);
+        state->kernel (buffer.device_samples, end-begin, sample_size,
+                       buffer.device_log_likelihoods, buffer.stream);
+        state->device.copy_to_host (buffer.host_log_likelihoods, buffer.device_log_likelihoods,
+                                    (end-begin) * sizeof(double),
+                                    buffer.stream);
+      }
+
+    // Then wait for the pieces in turn, and unpack the results of each
+    // while the device may still be working on the later ones:
+    for (std::size_t piece=0; piece<n_pieces; ++piece)
+      {
+        Buffer &buffer = state->buffers[piece];
+        const std::size_t begin = piece * n_samples / n_pieces;
+        const std::size_t end   = (piece+1) * n_samples / n_pieces;
+
+        state->device.synchronize (buffer.stream);
+        ++state->n_synchronizations;
+
+        std::copy (buffer.host_log_likelihoods,
+                   buffer.host_log_likelihoods + (end-begin),
+                   log_likelihoods.begin() + begin);
+      }
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  std::size_t
+  DeviceLogLikelihood<SampleType,Device,Scalar>::n_batches () const
+  {
+    std::lock_guard<std::mutex> lock (state->mutex);
+    return state->n_batches;
+  }
+
+
+
+  template <typename SampleType, typename Device, typename Scalar>
+  requires (Concepts::is_device<Device>)
+  std::size_t
+  DeviceLogLikelihood<SampleType,Device,Scalar>::n_synchronizations () const
+  {
+    std::lock_guard<std::mutex> lock (state->mutex);
+    return state->n_synchronizations;
+  }
+}
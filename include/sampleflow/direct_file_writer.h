@@ -0,0 +1,50 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_DIRECT_FILE_WRITER_H
+#define SAMPLEFLOW_DIRECT_FILE_WRITER_H
+
+#include <sampleflow/config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// io_uring is a Linux interface. We talk to the kernel directly via the
+// system calls, rather than through liburing, so that we do not add a
+// dependency on another library:
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/syscall.h>
+#  define SAMPLEFLOW_WITH_IO_URING
+#endif
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/direct_file_writer.impl.h>
+
+#endif
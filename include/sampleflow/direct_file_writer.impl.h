@@ -0,0 +1,769 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * An enumeration that describes how classes that write files, such as
+   * Consumers::ShardedChainOutput, write the data to the file.
+   */
+  enum class FileWriterBackend
+  {
+    /**
+     * Write through a `std::filebuf`, i.e., in the same way as
+     * `std::ofstream` does. The data is copied into the page cache of the
+     * operating system, and written to the device whenever the operating
+     * system decides to do so.
+     */
+    standard,
+
+    /**
+     * Write through a DirectFileWriter object.
+     */
+    direct
+  };
+
+
+
+  /**
+   * A stream buffer that writes to a file using large, asynchronous writes
+   * that bypass the page cache of the operating system. It can be used
+   * wherever a `std::streambuf` is used, and in particular underneath a
+   * `std::ostream` that is given to a Consumers::StreamOutput object in
+   * binary mode:
+   * @code
+   *   SampleFlow::DirectFileWriter file ("samples.chain");
+   *   std::ostream                 output (&file);
+   *   SampleFlow::Consumers::StreamOutput<SampleType>
+   *     stream_output (output, SampleFlow::Consumers::StreamOutput<SampleType>::Format::binary);
+   * @endcode
+   *
+   * When a program writes large amounts of data to a file through a
+   * `std::ofstream`, the data is first copied into the page cache of the
+   * operating system, and written to the device later. On fast storage
+   * devices, the rate at which the page cache can be written back then
+   * often limits how fast a program can write, and once too much data is
+   * waiting to be written back, calls to `write()` simply stall --
+   * sometimes for many milliseconds, in which the thread that wanted to
+   * write cannot do anything else.
+   *
+   * This class avoids both issues. It opens the file with `O_DIRECT`, so
+   * that data goes from the program's memory straight to the device, and
+   * it submits writes through Linux's io_uring interface, so that the
+   * thread that writes does not wait for the device: The class owns a
+   * small ring of buffers that are allocated once and aligned as
+   * `O_DIRECT` requires. Data passed to the stream buffer is copied into
+   * the current buffer, and once this buffer is full, a write of the whole
+   * buffer is submitted to the kernel and the next buffer becomes the
+   * current one. Only if all buffers are still being written does the
+   * writing thread need to wait. With a few buffers of a few megabytes
+   * each, the device is kept busy with large sequential writes, and the
+   * sustained throughput approaches the bandwidth of the device.
+   *
+   * If io_uring is not available (because the program does not run on
+   * Linux, or because the kernel is too old or does not allow the use of
+   * io_uring), buffers are written with `pwrite()` on the thread that
+   * filled them. If the file system does not support `O_DIRECT`, the file
+   * is written through the page cache instead. The file that is written
+   * is the same in all of these cases; uses_io_uring() and
+   * uses_direct_io() report what is actually used.
+   *
+   * Because `O_DIRECT` only allows writing whole blocks, flushing the
+   * stream buffer (for example via `std::ostream::flush()`) writes the
+   * last, partially filled block padded with zeros and then truncates the
+   * file to the number of bytes actually written; the partial block is
+   * written again, with more data, at the next flush. Flushing often
+   * therefore defeats the purpose of this class. Flushing waits for all
+   * writes to finish, so that the file is complete after the flush.
+   *
+   *
+   * ### Threading model ###
+   *
+   * Like all stream buffers, objects of this class must only be used by
+   * one thread at a time.
+   */
+  class DirectFileWriter : public std::streambuf
+  {
+    public:
+      /**
+       * The alignment of the buffers, and the size of the blocks that
+       * `O_DIRECT` writes. 4096 bytes is a multiple of the logical block
+       * size of all common storage devices.
+       */
+      static constexpr std::size_t alignment = 4096;
+
+      /**
+       * Constructor. Create the file with the given name, replacing an
+       * existing file of that name.
+       *
+       * @param[in] filename The name of the file.
+       * @param[in] buffer_size The size of each of the buffers, which is
+       *   also the size of the writes submitted to the kernel. It is
+       *   rounded up to a multiple of `alignment`.
+       * @param[in] n_buffers The number of buffers. At most `n_buffers-1`
+       *   writes are in flight while the thread that writes fills the
+       *   remaining buffer.
+       */
+      DirectFileWriter (const std::string  &filename,
+                        const std::size_t   buffer_size = 4*1024*1024,
+                        const unsigned int  n_buffers = 4);
+
+      /**
+       * Destructor. Write all remaining data and close the file.
+       */
+      virtual ~DirectFileWriter ();
+
+      /**
+       * Copy constructor. Objects of this class cannot be copied, and so
+       * this constructor is deleted.
+       */
+      DirectFileWriter (const DirectFileWriter &) = delete;
+
+      /**
+       * Write all remaining data and close the file. Nothing can be written
+       * after this function has been called.
+       */
+      void
+      close ();
+
+      /**
+       * Return whether writes are submitted through io_uring, rather than
+       * written with `pwrite()` on the calling thread.
+       */
+      bool
+      uses_io_uring () const;
+
+      /**
+       * Return whether the file was opened with `O_DIRECT`, and the file
+       * system accepted writes with this flag.
+       */
+      bool
+      uses_direct_io () const;
+
+    protected:
+      /**
+       * Called by the base class if the current buffer is full: Submit the
+       * buffer for writing, move on to the next buffer, and put the given
+       * character into it.
+       */
+      virtual
+      int_type
+      overflow (int_type c) override;
+
+      /**
+       * Copy the given characters into the buffers, submitting full
+       * buffers for writing as they fill up.
+       */
+      virtual
+      std::streamsize
+      xsputn (const char *s, std::streamsize n) override;
+
+      /**
+       * Write all data that has been passed to the object so far, and wait
+       * for it to reach the file.
+       */
+      virtual
+      int
+      sync () override;
+
+    private:
+      /**
+       * A structure that describes one of the buffers.
+       */
+      struct Buffer
+      {
+        /**
+         * The memory of the buffer, aligned to `alignment` bytes.
+         */
+        char *data = nullptr;
+
+        /**
+         * If the buffer is being written: the number of bytes written, and
+         * the position in the file they are written to.
+         */
+        std::size_t   length      = 0;
+        std::uint64_t file_offset = 0;
+
+        /**
+         * Whether the buffer is currently being written.
+         */
+        bool in_flight = false;
+      };
+
+      /**
+       * The file descriptor of the file, or -1 once the file is closed.
+       */
+      int fd;
+
+      /**
+       * Whether the file descriptor has the `O_DIRECT` flag set.
+       */
+      bool direct_io;
+
+      /**
+       * The size of each of the buffers.
+       */
+      const std::size_t buffer_size;
+
+      /**
+       * The buffers, the index of the one that is currently being filled,
+       * and the position in the file at which the data of the current
+       * buffer will be written. Since each buffer except for the last one
+       * is written in its entirety, the latter is always a multiple of
+       * `alignment`.
+       */
+      std::vector<Buffer> buffers;
+      unsigned int        current_buffer;
+      std::uint64_t       current_offset;
+
+      /**
+       * The number of buffers that are currently being written.
+       */
+      unsigned int n_in_flight;
+
+#ifdef SAMPLEFLOW_WITH_IO_URING
+      /**
+       * The state of the io_uring instance: its file descriptor (or -1 if
+       * io_uring is not used), the memory regions shared with the kernel,
+       * and pointers to the fields of the submission and completion
+       * queues within them.
+       */
+      struct Ring
+      {
+        int fd = -1;
+
+        void        *sq_ring      = nullptr;
+        void        *cq_ring      = nullptr;
+        std::size_t  sq_ring_size = 0;
+        std::size_t  cq_ring_size = 0;
+
+        io_uring_sqe *sqes      = nullptr;
+        std::size_t   sqes_size = 0;
+
+        unsigned int *sq_tail  = nullptr;
+        unsigned int *sq_mask  = nullptr;
+        unsigned int *sq_array = nullptr;
+
+        unsigned int *cq_head  = nullptr;
+        unsigned int *cq_tail  = nullptr;
+        unsigned int *cq_mask  = nullptr;
+        io_uring_cqe *cqes     = nullptr;
+      } ring;
+
+      /**
+       * Create the io_uring instance with room for the given number of
+       * writes in flight. Return whether this was successful.
+       */
+      bool
+      setup_ring (const unsigned int n_entries);
+
+      /**
+       * Destroy the io_uring instance.
+       */
+      void
+      teardown_ring ();
+#endif
+
+      /**
+       * Start writing the given buffer, whose `length` and `file_offset`
+       * have already been set.
+       */
+      void
+      submit (Buffer &buffer);
+
+      /**
+       * Wait for at least one of the buffers that are being written to be
+       * done.
+       */
+      void
+      wait_for_one ();
+
+      /**
+       * Wait for all buffers that are being written to be done.
+       */
+      void
+      wait_for_all ();
+
+      /**
+       * Process the result of a write of the given buffer: If it did not
+       * write all of the buffer, write the rest synchronously.
+       */
+      void
+      complete (Buffer &buffer, const long result);
+
+      /**
+       * Write the given data at the given position of the file on the
+       * current thread.
+       */
+      void
+      write_synchronously (const char          *data,
+                           std::size_t          length,
+                           std::uint64_t        file_offset);
+
+      /**
+       * Submit the current buffer for writing, if it contains data, and make
+       * the next buffer the current one, waiting for it to be written if
+       * necessary.
+       */
+      void
+      submit_current_buffer ();
+  };
+
+
+
+  inline
+  DirectFileWriter::DirectFileWriter (const std::string  &filename,
+                                      const std::size_t   buffer_size,
+                                      const unsigned int  n_buffers)
+    :
+    fd (-1),
+    direct_io (false),
+    buffer_size ((std::max<std::size_t>(buffer_size, 1) + alignment - 1) / alignment * alignment),
+    buffers (std::max (n_buffers, 2U)),
+    current_buffer (0),
+    current_offset (0),
+    n_in_flight (0)
+  {
+    // io_uring writes at most 2^32-1 bytes at a time:
+    assert (this->buffer_size <= std::size_t(1) << 31);
+
+    for (Buffer &buffer : buffers)
+      {
+        buffer.data = static_cast<char *>(std::aligned_alloc (alignment, this->buffer_size));
+        assert (buffer.data != nullptr);
+      }
+
+    // Open the file with O_DIRECT if the platform knows about it. Some file
+    // systems (e.g., tmpfs) reject the flag, in which case we fall back to
+    // writing through the page cache:
+#ifdef O_DIRECT
+    fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    direct_io = (fd >= 0);
+#endif
+    if (fd < 0)
+      fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert (fd >= 0);
+
+#ifdef SAMPLEFLOW_WITH_IO_URING
+    setup_ring (buffers.size());
+#endif
+
+    setp (buffers[current_buffer].data,
+          buffers[current_buffer].data + this->buffer_size);
+  }
+
+
+
+  inline
+  DirectFileWriter::~DirectFileWriter ()
+  {
+    close ();
+
+    for (Buffer &buffer : buffers)
+      std::free (buffer.data);
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::close ()
+  {
+    if (fd < 0)
+      return;
+
+    sync ();
+
+#ifdef SAMPLEFLOW_WITH_IO_URING
+    teardown_ring ();
+#endif
+
+    ::close (fd);
+    fd = -1;
+    setp (nullptr, nullptr);
+  }
+
+
+
+  inline
+  bool
+  DirectFileWriter::uses_io_uring () const
+  {
+#ifdef SAMPLEFLOW_WITH_IO_URING
+    return (ring.fd >= 0);
+#else
+    return false;
+#endif
+  }
+
+
+
+  inline
+  bool
+  DirectFileWriter::uses_direct_io () const
+  {
+    return direct_io;
+  }
+
+
+
+  inline
+  DirectFileWriter::int_type
+  DirectFileWriter::overflow (int_type c)
+  {
+    assert (fd >= 0);
+
+    if (traits_type::eq_int_type (c, traits_type::eof()))
+      return traits_type::not_eof (c);
+
+    submit_current_buffer ();
+
+    *pptr() = traits_type::to_char_type (c);
+    pbump (1);
+    return c;
+  }
+
+
+
+  inline
+  std::streamsize
+  DirectFileWriter::xsputn (const char *s, std::streamsize n)
+  {
+    assert (fd >= 0);
+
+    const std::streamsize total = n;
+    while (n > 0)
+      {
+        if (pptr() == epptr())
+          submit_current_buffer ();
+
+        const std::streamsize chunk = std::min<std::streamsize> (n, epptr() - pptr());
+        std::memcpy (pptr(), s, chunk);
+        pbump (static_cast<int>(chunk));
+        s += chunk;
+        n -= chunk;
+      }
+    return total;
+  }
+
+
+
+  inline
+  int
+  DirectFileWriter::sync ()
+  {
+    if (fd < 0)
+      return 0;
+
+    Buffer &buffer = buffers[current_buffer];
+    const std::size_t length = pptr() - pbase();
+
+    // Write the complete blocks of the current buffer as well as the last,
+    // partial block padded with zeros, and wait for everything to be
+    // written:
+    const std::size_t complete_blocks = (direct_io
+                                         ?
+                                         length / alignment * alignment
+                                         :
+                                         length);
+    const std::size_t tail = length - complete_blocks;
+    if (length > 0)
+      {
+        buffer.length = (tail > 0
+                         ?
+                         complete_blocks + alignment
+                         :
+                         length);
+        std::memset (buffer.data + length, 0, buffer.length - length);
+        buffer.file_offset = current_offset;
+        submit (buffer);
+      }
+    wait_for_all ();
+
+    // Then cut off the padding:
+    if (tail > 0)
+      {
+        [[maybe_unused]] const int ierr = ftruncate (fd, current_offset + length);
+        assert (ierr == 0);
+      }
+
+    // Finally, continue with the next buffer, starting with the data of the
+    // partial block so that it is written again at the same position once
+    // more data has arrived:
+    const unsigned int next_buffer = (current_buffer + 1) % buffers.size();
+    std::memmove (buffers[next_buffer].data, buffer.data + complete_blocks, tail);
+    current_offset += complete_blocks;
+    current_buffer  = next_buffer;
+    setp (buffers[current_buffer].data,
+          buffers[current_buffer].data + buffer_size);
+    pbump (static_cast<int>(tail));
+
+    return 0;
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::submit_current_buffer ()
+  {
+    Buffer &buffer = buffers[current_buffer];
+    const std::size_t length = pptr() - pbase();
+
+    if (length > 0)
+      {
+        // All buffers but the last one are full, and so have a length that
+        // is a multiple of the block size:
+        assert (length == buffer_size);
+
+        buffer.length      = length;
+        buffer.file_offset = current_offset;
+        submit (buffer);
+        current_offset += length;
+      }
+
+    current_buffer = (current_buffer + 1) % buffers.size();
+    while (buffers[current_buffer].in_flight)
+      wait_for_one ();
+
+    setp (buffers[current_buffer].data,
+          buffers[current_buffer].data + buffer_size);
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::submit (Buffer &buffer)
+  {
+#ifdef SAMPLEFLOW_WITH_IO_URING
+    if (ring.fd >= 0)
+      {
+        // Fill the next submission queue entry. We are the only ones who
+        // add entries, and there are never more writes in flight than
+        // there are entries, so there is always room:
+        const unsigned int tail  = std::atomic_ref<unsigned int>(*ring.sq_tail).load (std::memory_order_relaxed);
+        const unsigned int index = tail & *ring.sq_mask;
+
+        io_uring_sqe &sqe = ring.sqes[index];
+        std::memset (&sqe, 0, sizeof(sqe));
+        sqe.opcode    = IORING_OP_WRITE;
+        sqe.fd        = fd;
+        sqe.addr      = reinterpret_cast<std::uint64_t>(buffer.data);
+        sqe.len       = static_cast<std::uint32_t>(buffer.length);
+        sqe.off       = buffer.file_offset;
+        sqe.user_data = &buffer - buffers.data();
+
+        ring.sq_array[index] = index;
+        std::atomic_ref<unsigned int>(*ring.sq_tail).store (tail + 1, std::memory_order_release);
+
+        long n_submitted;
+        do
+          n_submitted = syscall (__NR_io_uring_enter, ring.fd, 1, 0, 0, nullptr, 0);
+        while ((n_submitted < 0) && (errno == EINTR));
+        assert (n_submitted == 1);
+
+        buffer.in_flight = true;
+        ++n_in_flight;
+        return;
+      }
+#endif
+
+    write_synchronously (buffer.data, buffer.length, buffer.file_offset);
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::wait_for_one ()
+  {
+    assert (n_in_flight > 0);
+
+#ifdef SAMPLEFLOW_WITH_IO_URING
+    while (true)
+      {
+        unsigned int       head = std::atomic_ref<unsigned int>(*ring.cq_head).load (std::memory_order_relaxed);
+        const unsigned int tail = std::atomic_ref<unsigned int>(*ring.cq_tail).load (std::memory_order_acquire);
+
+        if (head == tail)
+          {
+            // Nothing has completed yet. Go to sleep until something does:
+            const long ierr = syscall (__NR_io_uring_enter, ring.fd, 0, 1,
+                                       IORING_ENTER_GETEVENTS, nullptr, 0);
+            assert ((ierr >= 0) || (errno == EINTR));
+            (void)ierr;
+            continue;
+          }
+
+        for (; head != tail; ++head)
+          {
+            const io_uring_cqe &cqe = ring.cqes[head & *ring.cq_mask];
+            complete (buffers[cqe.user_data], cqe.res);
+          }
+        std::atomic_ref<unsigned int>(*ring.cq_head).store (head, std::memory_order_release);
+        return;
+      }
+#endif
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::wait_for_all ()
+  {
+    while (n_in_flight > 0)
+      wait_for_one ();
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::complete (Buffer &buffer, const long result)
+  {
+    buffer.in_flight = false;
+    --n_in_flight;
+
+    // The kernel may have written less than we asked for, or the file
+    // system may have rejected O_DIRECT writes only once it saw one. In
+    // either case, write the rest ourselves:
+    if (result != static_cast<long>(buffer.length))
+      {
+        const std::size_t written = (result > 0 ? result : 0);
+        write_synchronously (buffer.data + written,
+                             buffer.length - written,
+                             buffer.file_offset + written);
+      }
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::write_synchronously (const char    *data,
+                                         std::size_t    length,
+                                         std::uint64_t  file_offset)
+  {
+    while (length > 0)
+      {
+        const ssize_t written = pwrite (fd, data, length, file_offset);
+        if (written < 0)
+          {
+            if (errno == EINTR)
+              continue;
+
+#ifdef O_DIRECT
+            // If the file system does not support O_DIRECT writes, switch
+            // to writing through the page cache:
+            if ((errno == EINVAL) && direct_io)
+              {
+                fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_DIRECT);
+                direct_io = false;
+                continue;
+              }
+#endif
+            assert (false);
+            return;
+          }
+
+        data        += written;
+        length      -= written;
+        file_offset += written;
+      }
+  }
+
+
+
+#ifdef SAMPLEFLOW_WITH_IO_URING
+  inline
+  bool
+  DirectFileWriter::setup_ring (const unsigned int n_entries)
+  {
+    io_uring_params params;
+    std::memset (&params, 0, sizeof(params));
+
+    const int ring_fd = syscall (__NR_io_uring_setup, n_entries, &params);
+    if (ring_fd < 0)
+      return false;
+
+    // Map the submission and completion queues and the array of
+    // submission queue entries into our address space. Newer kernels
+    // allow mapping both queues at once:
+    ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+    if (single_mmap)
+      ring.sq_ring_size = ring.cq_ring_size = std::max (ring.sq_ring_size, ring.cq_ring_size);
+
+    ring.sq_ring = mmap (nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    ring.cq_ring = (single_mmap
+                    ?
+                    ring.sq_ring
+                    :
+                    mmap (nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING));
+    ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *const sqes = mmap (nullptr, ring.sqes_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if ((ring.sq_ring == MAP_FAILED) || (ring.cq_ring == MAP_FAILED) || (sqes == MAP_FAILED))
+      {
+        if (sqes != MAP_FAILED)
+          munmap (sqes, ring.sqes_size);
+        if ((ring.cq_ring != MAP_FAILED) && (ring.cq_ring != ring.sq_ring))
+          munmap (ring.cq_ring, ring.cq_ring_size);
+        if (ring.sq_ring != MAP_FAILED)
+          munmap (ring.sq_ring, ring.sq_ring_size);
+        ::close (ring_fd);
+        ring = Ring();
+        return false;
+      }
+    ring.sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *const sq = static_cast<char *>(ring.sq_ring);
+    ring.sq_tail  = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    ring.sq_mask  = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    ring.sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+
+    char *const cq = static_cast<char *>(ring.cq_ring);
+    ring.cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    ring.cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    ring.cq_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    ring.cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    ring.fd = ring_fd;
+    return true;
+  }
+
+
+
+  inline
+  void
+  DirectFileWriter::teardown_ring ()
+  {
+    if (ring.fd < 0)
+      return;
+
+    munmap (ring.sqes, ring.sqes_size);
+    if (ring.cq_ring != ring.sq_ring)
+      munmap (ring.cq_ring, ring.cq_ring_size);
+    munmap (ring.sq_ring, ring.sq_ring_size);
+    ::close (ring.fd);
+    ring = Ring();
+  }
+#endif
+}
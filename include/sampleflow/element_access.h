@@ -22,7 +22,10 @@
 
 #include <cstddef>
 #include <cassert>
+#include <ranges>
+#include <span>
 #include <type_traits>
+#include <utility>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/element_access.impl.h>
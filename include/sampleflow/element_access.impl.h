@@ -17,6 +17,60 @@ namespace SampleFlow
 {
   namespace Utilities
   {
+    namespace internal
+    {
+      /**
+       * Compute the value of Utilities::static_size for the given type.
+       */
+      template <typename SampleType>
+      constexpr
+      std::size_t
+      compute_static_size ()
+      {
+        if constexpr (std::is_array_v<SampleType>)
+          return std::extent_v<SampleType>;
+        else if constexpr (Concepts::has_size_function<SampleType> == false)
+          return 1;
+        // Eigen's matrices and vectors, whose size is negative if it is
+        // only known at run time:
+        else if constexpr (requires { SampleType::SizeAtCompileTime; })
+          return (SampleType::SizeAtCompileTime >= 0
+                  ?
+                  static_cast<std::size_t>(SampleType::SizeAtCompileTime)
+                  :
+                  std::dynamic_extent);
+        // std::array:
+        else if constexpr (requires { std::tuple_size<SampleType>::value; })
+          return std::tuple_size_v<SampleType>;
+        // Classes such as FixedVector with a `static constexpr` size()
+        // function:
+        else if constexpr (requires { typename std::integral_constant<std::size_t, SampleType::size()>; })
+          return SampleType::size();
+        else
+          return std::dynamic_extent;
+      }
+    }
+
+
+    /**
+     * The number of elements of objects of type `SampleType`, if it is the
+     * same for all objects of this type and known at compile time, or
+     * `std::dynamic_extent` otherwise. This is the case for scalar types
+     * (with one element), C-style arrays, `std::array`, FixedVector, and
+     * Eigen's fixed-size matrices and vectors such as `Eigen::Vector2d`.
+     *
+     * Consumers can use this to replace data structures whose size depends
+     * on the number of elements of samples by ones whose size is fixed,
+     * and that therefore do not need to allocate memory, as
+     * Consumers::CovarianceMatrix does for its matrix of sums of products.
+     * Loops over the elements of samples of such types (for example via
+     * size()) have a bound known to the compiler, which can then unroll
+     * them completely.
+     */
+    template <typename SampleType>
+    constexpr std::size_t static_size = internal::compute_static_size<SampleType>();
+
+
     /**
      * A function that, for types `SampleType` for which one can build
      * expressions of the form `sample.size()`, returns the size of the
@@ -27,13 +81,18 @@ namespace SampleFlow
      * into smaller pieces, there is a separate function that allows
      * the expression `size(sample)` simply returning 1. There is also
      * a specialization of the function for the case that `SampleType`
-     * is an array type.
+     * is an array type. If the size is the same for all objects of type
+     * `SampleType` (see static_size), then that constant is returned so
+     * that the compiler sees it even if it does not inline `sample.size()`.
      */
     template <typename SampleType>
     requires (Concepts::has_size_function<SampleType>)
     auto size (const SampleType &sample)
     {
-      return sample.size();
+      if constexpr (static_size<SampleType> != std::dynamic_extent)
+        return static_cast<decltype(sample.size())>(static_size<SampleType>);
+      else
+        return sample.size();
     }
 
 
@@ -86,7 +145,7 @@ namespace SampleFlow
                           const std::size_t index)
     -> std::remove_cv_t<std::remove_reference_t<decltype(std::declval<SampleType>()[index])>>
     {
-      assert (index < Utilities::size(sample));
+      assert (index < static_cast<std::size_t>(Utilities::size(sample)));
       return sample[index];
     }
 
@@ -101,7 +160,7 @@ namespace SampleFlow
                           const std::size_t index)
     -> std::remove_cv_t<std::remove_reference_t<decltype(std::declval<SampleType>()[index])>> &
     {
-      assert (index < Utilities::size(sample));
+      assert (index < static_cast<std::size_t>(Utilities::size(sample)));
       return sample[index];
     }
 
@@ -117,7 +176,9 @@ namespace SampleFlow
      * the only valid value for the `index` argument to this function is zero.
      */
     template <typename SampleType>
-    requires (!Concepts::has_subscript_operator<SampleType>)
+    requires (!Concepts::has_subscript_operator<SampleType>
+              &&
+              !Concepts::has_sparse_storage<SampleType>)
     auto get_nth_element (const SampleType &sample,
                           const std::size_t index)
     -> SampleType
@@ -138,7 +199,9 @@ namespace SampleFlow
      * the only valid value for the `index` argument to this function is zero.
      */
     template <typename SampleType>
-    requires (!Concepts::has_subscript_operator<SampleType>)
+    requires (!Concepts::has_subscript_operator<SampleType>
+              &&
+              !Concepts::has_sparse_storage<SampleType>)
     auto get_nth_element (SampleType &sample,
                           const std::size_t index)
     -> SampleType &
@@ -146,5 +209,362 @@ namespace SampleFlow
       assert (index == 0);
       return sample;
     }
+
+
+    /**
+     * A function that, for types `SampleType` that only store their nonzero
+     * elements (see Concepts::has_sparse_storage), returns the `index`th
+     * element of the sample, which is zero if the element is not stored.
+     * Accessing elements this way is typically not cheap for such types;
+     * code that can should loop over the nonzero elements instead, using
+     * for_each_nonzero().
+     */
+    template <typename SampleType>
+    requires (!Concepts::has_subscript_operator<SampleType>
+              &&
+              Concepts::has_sparse_storage<SampleType>)
+    auto get_nth_element (const SampleType &sample,
+                          const std::size_t index)
+    -> std::remove_cvref_t<decltype(sample.coeff(index))>
+    {
+      assert (index < static_cast<std::size_t>(Utilities::size(sample)));
+      return sample.coeff(index);
+    }
+
+
+    /**
+     * Like the previous function, but for non-`const` objects, for which
+     * the function returns a reference to the element. If the element is
+     * not yet stored, it is inserted (with value zero) before a reference
+     * to it is returned.
+     */
+    template <typename SampleType>
+    requires (!Concepts::has_subscript_operator<SampleType>
+              &&
+              Concepts::has_sparse_storage<SampleType>)
+    auto get_nth_element (SampleType &sample,
+                          const std::size_t index)
+    -> std::remove_cvref_t<decltype(sample.coeff(index))> &
+    {
+      assert (index < static_cast<std::size_t>(Utilities::size(sample)));
+      return sample.coeffRef(index);
+    }
+
+
+    /**
+     * Call `f(index, value)` for the elements of the given sample that may
+     * be nonzero. For types that only store their nonzero elements (see
+     * Concepts::has_sparse_storage), these are the elements stored, in the
+     * order in which they are stored; the cost of the function is then
+     * proportional to the number of nonzero elements rather than to the
+     * size of the sample. For all other types, `f` is called for all
+     * elements, in order.
+     */
+    template <typename SampleType, typename Function>
+    void for_each_nonzero (const SampleType &sample,
+                           const Function   &f)
+    {
+      if constexpr (Concepts::has_sparse_storage<SampleType>)
+        {
+          for (typename SampleType::InnerIterator it (sample, 0); it; ++it)
+            f (static_cast<std::size_t>(it.index()), it.value());
+        }
+      else
+        for (std::size_t j=0; j<static_cast<std::size_t>(Utilities::size(sample)); ++j)
+          f (j, Utilities::get_nth_element (sample, j));
+    }
+
+
+    /**
+     * A function that, for types `SampleType` whose elements are stored
+     * contiguously in memory (see Concepts::has_contiguous_scalar_storage),
+     * returns a `std::span` object that refers to all elements of the
+     * given sample. Loops over the elements of such a span operate
+     * directly on the memory of the sample, and can be vectorized by
+     * compilers in cases where the equivalent loop using get_nth_element()
+     * cannot.
+     */
+    template <typename SampleType>
+    requires (Concepts::has_contiguous_scalar_storage<SampleType>)
+    auto as_span (const SampleType &sample)
+    -> std::span<const std::remove_cvref_t<decltype(sample[0])>>
+    {
+      return {std::ranges::data(sample), static_cast<std::size_t>(Utilities::size(sample))};
+    }
+
+
+    /**
+     * Like the previous function, but for non-`const` objects, for which
+     * the returned span allows modifying the elements of the sample.
+     */
+    template <typename SampleType>
+    requires (Concepts::has_contiguous_scalar_storage<SampleType>)
+    auto as_span (SampleType &sample)
+    -> std::span<std::remove_cvref_t<decltype(std::as_const(sample)[0])>>
+    {
+      return {std::ranges::data(sample), static_cast<std::size_t>(Utilities::size(sample))};
+    }
+
+
+    /**
+     * Return a reference to the sample the argument refers to if it is a
+     * handle to a sample (see Concepts::is_sample_handle), and the argument
+     * itself otherwise. This allows consumers to work on samples of type
+     * `std::shared_ptr<const T>` in the same way as on samples of type `T`,
+     * without copying the sample the handle refers to. The type of the
+     * object referenced by the return value is types::HandledType.
+     */
+    template <typename SampleType>
+    const auto &dereference_sample (const SampleType &sample)
+    {
+      if constexpr (Concepts::is_sample_handle<SampleType>)
+        {
+          assert (sample != nullptr);
+          return *sample;
+        }
+      else
+        return sample;
+    }
+
+
+    /**
+     * Update a running (weighted) mean value by a sample, i.e., compute
+     * @f[
+     *   \bar x \leftarrow \bar x + (x - \bar x) f
+     * @f]
+     * where the factor $f$ is typically the weight of the new sample
+     * divided by the total weight of all samples seen so far, including
+     * the new one -- e.g., $f=1/n$ for the $n$th of a sequence of
+     * unweighted samples. This is the update that consumers such as
+     * Consumers::MeanValue perform for every sample they receive.
+     *
+     * Written in terms of the operations of a vector space type, this
+     * update requires a temporary object that holds $(x-\bar x)f$, and
+     * for types such as `std::valarray<double>` or `Eigen::VectorXd`
+     * creating this temporary means allocating memory on the heap.
+     * This function instead updates the elements of `mean` one at a time
+     * in a single loop if the elements of `SampleType` can be accessed
+     * individually. This is the case for all types whose elements are
+     * stored contiguously (see Concepts::has_contiguous_scalar_storage),
+     * which includes Eigen's dense vectors and matrices as well as
+     * `std::valarray`, FixedVector, and SmallVector, and for which the
+     * loop works directly on the memory of the objects; and for types
+     * with an index operator. All other types, including scalar types
+     * such as `double`, use the formula above.
+     *
+     * If the elements of the sample are integers, then each element of
+     * the update is rounded as it would be by the formula above when
+     * assigning the product with the floating point factor to an object
+     * of type `SampleType`.
+     */
+    template <typename SampleType>
+    requires (Concepts::is_vector_space_type<SampleType>)
+    void update_running_mean (SampleType       &mean,
+                              const SampleType &sample,
+                              const double      factor)
+    {
+      if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+        {
+          const auto sample_elements = Utilities::as_span (sample);
+          const auto mean_elements   = Utilities::as_span (mean);
+          using scalar_type = typename decltype(mean_elements)::value_type;
+
+          assert (sample_elements.size() == mean_elements.size());
+          for (std::size_t j=0; j<sample_elements.size(); ++j)
+            mean_elements[j] += static_cast<scalar_type>((sample_elements[j] - mean_elements[j]) * factor);
+        }
+      else if constexpr (Concepts::has_modifiable_elements<SampleType>
+                         &&
+                         Concepts::has_size_function<SampleType>)
+        {
+          assert (Utilities::size(sample) == Utilities::size(mean));
+          for (std::size_t j=0; j<Utilities::size(sample); ++j)
+            {
+              auto &mean_j = Utilities::get_nth_element (mean, j);
+              mean_j += static_cast<std::remove_cvref_t<decltype(mean_j)>>
+                        ((Utilities::get_nth_element (sample, j) - mean_j) * factor);
+            }
+        }
+      else
+        {
+          SampleType update = sample;
+          update -= mean;
+          mean += update * factor;
+        }
+    }
+
+
+    /**
+     * Like the previous function, but for a sample that the caller no
+     * longer needs. For types for which the previous function would have
+     * to create a temporary object, this function uses the memory of
+     * `sample` instead.
+     */
+    template <typename SampleType>
+    requires (Concepts::is_vector_space_type<SampleType>
+              &&
+              !std::is_lvalue_reference_v<SampleType>)
+    void update_running_mean (SampleType   &mean,
+                              SampleType  &&sample,
+                              const double  factor)
+    {
+      if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>
+                    ||
+                    (Concepts::has_modifiable_elements<SampleType>
+                     &&
+                     Concepts::has_size_function<SampleType>))
+        update_running_mean (mean, std::as_const(sample), factor);
+      else
+        {
+          sample -= mean;
+          mean += sample * factor;
+        }
+    }
+
+
+    /**
+     * Like the previous functions, but for the case where the mean value
+     * is stored in a different type than the samples -- typically one with
+     * a more precise scalar type, such as `Eigen::VectorXd` for samples of
+     * type `Eigen::VectorXf`. The elements of the sample are converted to
+     * the scalar type of `MeanType` one at a time, so that no temporary
+     * object is created.
+     */
+    template <typename MeanType, typename SampleType>
+    requires (Concepts::is_vector_space_type<MeanType>
+              &&
+              !std::is_same_v<MeanType, std::remove_cvref_t<SampleType>>)
+    void update_running_mean (MeanType         &mean,
+                              const SampleType &sample,
+                              const double      factor)
+    {
+      if constexpr (Concepts::has_contiguous_scalar_storage<MeanType>
+                    &&
+                    Concepts::has_contiguous_scalar_storage<SampleType>)
+        {
+          const auto sample_elements = Utilities::as_span (sample);
+          const auto mean_elements   = Utilities::as_span (mean);
+          using scalar_type = typename decltype(mean_elements)::value_type;
+
+          assert (sample_elements.size() == mean_elements.size());
+          for (std::size_t j=0; j<mean_elements.size(); ++j)
+            mean_elements[j] += static_cast<scalar_type>((static_cast<scalar_type>(sample_elements[j])
+                                                          - mean_elements[j]) * factor);
+        }
+      else if constexpr (Concepts::has_modifiable_elements<MeanType>
+                         &&
+                         Concepts::has_size_function<MeanType>)
+        {
+          assert (static_cast<std::size_t>(Utilities::size(sample))
+                  == static_cast<std::size_t>(Utilities::size(mean)));
+          for (std::size_t j=0; j<static_cast<std::size_t>(Utilities::size(mean)); ++j)
+            {
+              auto &mean_j = Utilities::get_nth_element (mean, j);
+              using scalar_type = std::remove_cvref_t<decltype(mean_j)>;
+              mean_j += static_cast<scalar_type>
+                        ((static_cast<scalar_type>(Utilities::get_nth_element (sample, j)) - mean_j)
+                         * factor);
+            }
+        }
+      else
+        mean += (static_cast<MeanType>(sample) - mean) * factor;
+    }
+
+
+    /**
+     * Convert a sample into an object of type `TargetType` with the same
+     * number of elements, converting each element by `static_cast` to the
+     * scalar type of `TargetType`. This is used by consumers that keep
+     * their state in a more precise type than that of the samples they
+     * receive, such as Consumers::MeanValue with a second template
+     * argument. If both types store their elements contiguously, the
+     * conversion is a single loop over the memory of both objects that
+     * compilers translate into vectorized conversion instructions.
+     *
+     * If `TargetType` is the type of the sample, the sample is simply
+     * returned (and moved from, if it is an rvalue).
+     */
+    template <typename TargetType, typename SampleType>
+    TargetType convert_elements (SampleType &&sample)
+    {
+      using SourceType = std::remove_cvref_t<SampleType>;
+      if constexpr (std::is_same_v<TargetType, SourceType>)
+        return std::forward<SampleType>(sample);
+      else if constexpr (Concepts::has_size_function<TargetType> == false)
+        return static_cast<TargetType>(sample);
+      else
+        {
+          TargetType result;
+          const auto size = Utilities::size(sample);
+          if constexpr (requires { result.resize (size); })
+            result.resize (size);
+          assert (static_cast<std::size_t>(Utilities::size(result))
+                  == static_cast<std::size_t>(size));
+
+          if constexpr (Concepts::has_contiguous_scalar_storage<TargetType>
+                        &&
+                        Concepts::has_contiguous_scalar_storage<SourceType>)
+            {
+              const auto source_elements = Utilities::as_span (std::as_const(sample));
+              const auto target_elements = Utilities::as_span (result);
+              using scalar_type = typename decltype(target_elements)::value_type;
+              for (std::size_t j=0; j<target_elements.size(); ++j)
+                target_elements[j] = static_cast<scalar_type>(source_elements[j]);
+            }
+          else
+            for (std::size_t j=0; j<static_cast<std::size_t>(size); ++j)
+              {
+                auto &target_j = Utilities::get_nth_element (result, j);
+                target_j = static_cast<std::remove_cvref_t<decltype(target_j)>>
+                           (Utilities::get_nth_element (sample, j));
+              }
+          return result;
+        }
+    }
+
+
+    /**
+     * Add a multiple of one vector to another, i.e., compute
+     * @f[
+     *   y \leftarrow y + a x.
+     * @f]
+     * Consumers such as Consumers::CovarianceMatrix need this operation
+     * to update their running mean value by the difference between a new
+     * sample and the previous mean, which they have already computed for
+     * other purposes. As for update_running_mean(), the function avoids
+     * creating a temporary object holding $ax$ for types whose
+     * elements can be accessed individually.
+     */
+    template <typename SampleType>
+    requires (Concepts::is_vector_space_type<SampleType>)
+    void add_scaled (SampleType       &y,
+                     const SampleType &x,
+                     const double      a)
+    {
+      if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+        {
+          const auto x_elements = Utilities::as_span (x);
+          const auto y_elements = Utilities::as_span (y);
+          using scalar_type = typename decltype(y_elements)::value_type;
+
+          assert (x_elements.size() == y_elements.size());
+          for (std::size_t j=0; j<x_elements.size(); ++j)
+            y_elements[j] += static_cast<scalar_type>(x_elements[j] * a);
+        }
+      else if constexpr (Concepts::has_modifiable_elements<SampleType>
+                         &&
+                         Concepts::has_size_function<SampleType>)
+        {
+          assert (Utilities::size(x) == Utilities::size(y));
+          for (std::size_t j=0; j<Utilities::size(x); ++j)
+            {
+              auto &y_j = Utilities::get_nth_element (y, j);
+              y_j += static_cast<std::remove_cvref_t<decltype(y_j)>>
+                     (Utilities::get_nth_element (x, j) * a);
+            }
+        }
+      else
+        y += x * a;
+    }
   }
 }
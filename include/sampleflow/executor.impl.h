@@ -0,0 +1,79 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * An interface for objects that can run tasks (function objects) on
+   * some set of threads at a later time. All of the places in SampleFlow
+   * that do work in parallel -- consumers and filters that use
+   * ParallelMode::asynchronous, and producers that run several chains or
+   * likelihood evaluations at the same time -- do so by handing tasks to
+   * a ThreadPool object. By default, these pools have their own worker
+   * threads; but a ThreadPool can also be constructed from an object of
+   * a class derived from the current one, in which case it hands all
+   * tasks to that object instead. This way, applications that already
+   * manage their threads in other ways -- via a TBB task arena, via
+   * OpenMP, or via a pool of their own -- can have SampleFlow use these
+   * threads, rather than have SampleFlow's threads compete with their own
+   * for the processor cores of the machine.
+   *
+   * The ThreadPool class itself is derived from the current class, and
+   * the classes TBB::Executor and OpenMP::Executor provide implementations
+   * for the TBB library and for OpenMP tasks. As for the ThreadPool class,
+   * an executor can be made the one used by default by all parts of
+   * SampleFlow by calling
+   * @code
+   *   SampleFlow::ThreadPool::set_default_pool
+   *     (std::make_shared<SampleFlow::ThreadPool>(my_executor));
+   * @endcode
+   * and it can be used only for specific consumers, filters, or producers
+   * by passing such a pool to Consumer::set_thread_pool() or to the
+   * respective functions of producers.
+   *
+   * Implementations of this interface do not need to worry about tasks
+   * that wait for other tasks to finish: The ThreadPool class keeps the
+   * tasks in a queue of its own, and threads that wait execute pending
+   * tasks from that queue in the meantime.
+   */
+  class Executor
+  {
+    public:
+      /**
+       * Destructor.
+       */
+      virtual
+      ~Executor () = default;
+
+      /**
+       * Arrange for the given task to be executed, typically on a thread
+       * other than the current one. Implementations may also decide to
+       * execute the task right away on the current thread.
+       */
+      virtual
+      void
+      execute (std::function<void ()> &&task) = 0;
+
+      /**
+       * Return the number of tasks this object can execute concurrently,
+       * i.e., typically the number of threads it uses. Producers use this
+       * number to decide how many pieces of work to create.
+       */
+      virtual
+      unsigned int
+      concurrency () const = 0;
+  };
+}
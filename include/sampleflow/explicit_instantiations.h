@@ -0,0 +1,45 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_EXPLICIT_INSTANTIATIONS_H
+#define SAMPLEFLOW_EXPLICIT_INSTANTIATIONS_H
+
+#include <sampleflow/config.h>
+
+#include <sampleflow/producer.h>
+#include <sampleflow/consumer.h>
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/filters/component_splitter.h>
+#include <sampleflow/filters/discard_first_n.h>
+#include <sampleflow/filters/take_every_nth.h>
+#include <sampleflow/consumers/acceptance_ratio.h>
+#include <sampleflow/consumers/auto_covariance_trace.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/histogram.h>
+#include <sampleflow/consumers/last_sample.h>
+#include <sampleflow/consumers/maximum_probability_sample.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/consumers/sample_store.h>
+#include <sampleflow/consumers/stream_output.h>
+
+#include <eigen3/Eigen/Dense>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/explicit_instantiations.impl.h>
+
+#endif
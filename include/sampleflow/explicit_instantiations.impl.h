@@ -0,0 +1,88 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+/**
+ * @file
+ *
+ * SampleFlow is a header-only library, and so every translation unit that
+ * uses, say, Producers::MetropolisHastings<double> instantiates all of
+ * the member functions of that class (and of its base classes, and of
+ * the consumers connected to it) anew, only for the linker to throw
+ * away all but one copy. In programs that consist of many translation
+ * units, this takes a substantial part of the overall compile time.
+ *
+ * To avoid this, SampleFlow also builds a library, `SampleFlow.instantiations`,
+ * that contains explicit instantiations of the most widely used classes
+ * for the two most widely used sample types, `double` and
+ * `Eigen::VectorXd`. Translation units that `#include` the current file
+ * see the corresponding `extern template` declarations, and consequently
+ * do not instantiate these classes themselves; the program then needs to
+ * be linked with the library. (For cmake projects, linking with the
+ * `SampleFlow.instantiations` target takes care of both.) Translation
+ * units that do not include this file are unaffected and instantiate
+ * what they need as before.
+ *
+ * The C++20 module `SampleFlow` contains the same instantiations.
+ *
+ * The list of classes and sample types is given by the macros below, so
+ * that the declarations in this file and the definitions in the library
+ * can not get out of sync.
+ */
+
+
+/**
+ * Apply `prefix` (either `template` for explicit instantiation
+ * definitions, or `extern template` for explicit instantiation
+ * declarations) to all classes instantiated in the
+ * `SampleFlow.instantiations` library for the sample type `SampleType`
+ * that are meaningful for both scalar and vector-valued samples. This
+ * macro must be used inside namespace SampleFlow.
+ */
+#define SAMPLEFLOW_INSTANTIATE_FOR_SAMPLE_TYPE(prefix, SampleType)      \
+  prefix class Producer<SampleType>;                                    \
+  prefix class Consumer<SampleType>;                                    \
+  prefix class Producers::MetropolisHastings<SampleType>;               \
+  prefix class Filters::DiscardFirstN<SampleType>;                      \
+  prefix class Filters::TakeEveryNth<SampleType>;                       \
+  prefix class Consumers::AcceptanceRatio<SampleType>;                  \
+  prefix class Consumers::AutoCovarianceTrace<SampleType>;              \
+  prefix class Consumers::CountSamples<SampleType>;                     \
+  prefix class Consumers::CovarianceMatrix<SampleType>;                 \
+  prefix class Consumers::LastSample<SampleType>;                       \
+  prefix class Consumers::MaximumProbabilitySample<SampleType>;         \
+  prefix class Consumers::MeanValue<SampleType>;                        \
+  prefix class Consumers::SampleStore<SampleType>;                      \
+  prefix class Consumers::StreamOutput<SampleType>;
+
+
+/**
+ * Apply `prefix` to all classes instantiated in the
+ * `SampleFlow.instantiations` library. This includes the classes that
+ * only make sense for scalar samples (for `double`) or for vector-valued
+ * samples (for `Eigen::VectorXd`). Like the previous macro, this one
+ * must be used inside namespace SampleFlow.
+ */
+#define SAMPLEFLOW_INSTANTIATE(prefix)                                  \
+  SAMPLEFLOW_INSTANTIATE_FOR_SAMPLE_TYPE(prefix, double)                \
+  SAMPLEFLOW_INSTANTIATE_FOR_SAMPLE_TYPE(prefix, Eigen::VectorXd)       \
+  prefix class Consumers::Histogram<double>;                            \
+  prefix class Filters::ComponentSplitter<Eigen::VectorXd>;
+
+
+namespace SampleFlow
+{
+  SAMPLEFLOW_INSTANTIATE(extern template)
+}
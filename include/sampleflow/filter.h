@@ -24,6 +24,8 @@
 
 #include <mutex>
 #include <optional>
+#include <type_traits>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/filter.impl.h>
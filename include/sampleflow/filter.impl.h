@@ -103,6 +103,22 @@ namespace SampleFlow
       consume (InputType sample,
                AuxiliaryData aux_data) override final;
 
+      /**
+       * An implementation of the Consumer::consume_batch() function. This
+       * function calls the filter_batch() function, which by default calls
+       * the filter() function for each sample of the batch and collects the
+       * samples that function returns, and sends the resulting samples as
+       * one batch to all consumers connected to this filter.
+       *
+       * @param[in] samples A vector of samples $x_k$.
+       * @param[in] aux_data A vector of the same length as `samples` with the
+       *   additional information for each sample.
+       */
+      virtual
+      void
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data) override final;
+
       /**
        * Ensure that all samples currently being worked on by this object
        * are finished up. In a parallel context, there may still be new samples
@@ -125,6 +141,58 @@ namespace SampleFlow
       void
       flush () override;
 
+      /**
+       * An implementation of the Consumer::add_to_graph() function. In
+       * addition to a node for the current object, which is marked as a
+       * filter, this function also adds all nodes and edges downstream of
+       * the filter to the graph.
+       */
+      virtual
+      void
+      add_to_graph (PipelineGraph::Graph &graph) const override;
+
+      /**
+       * An implementation of the Consumer::requests_aux_data() function. A
+       * filter passes the auxiliary data of samples on to the objects
+       * connected to it, and so it requests an entry if it uses the entry
+       * itself (as declared by the used_aux_data_keys() function of the
+       * derived class) or if any of these objects requests it. Derived
+       * classes that do not look at the auxiliary data themselves should
+       * therefore override used_aux_data_keys() to return an empty list.
+       */
+      virtual
+      bool
+      requests_aux_data (const AuxiliaryData::Key &key) const override;
+
+      /**
+       * An implementation of the Consumer::receive_announcement()
+       * function. In addition to preparing the current object for the
+       * samples it is about to receive, this function announces the
+       * samples it will then send to the objects connected to it, as
+       * described by output_shape().
+       */
+      virtual
+      void
+      receive_announcement (const SampleShape &shape) override;
+
+      /**
+       * Return a description of the samples this filter will send
+       * downstream if it receives samples described by the argument (see
+       * SampleShape and Producer::announce_samples()). The default
+       * implementation keeps the number of samples, and the number of
+       * components if the input and output types are the same. This is
+       * right for filters that pass on every sample they receive. Since
+       * consumers may allocate memory for as many samples as are announced
+       * (see, for example, SampleStore), derived classes that may drop
+       * samples need to override this function and report the number of
+       * samples they will pass on, or report it as unknown if they cannot
+       * know it. The same applies to classes that send samples downstream
+       * via other means than the return value of filter().
+       */
+      virtual
+      SampleShape
+      output_shape (const SampleShape &input_shape) const;
+
       /**
        * The main function of this class, which needs to be implemented by
        * derived classes. This function takes a sample of type `InputType`
@@ -153,6 +221,37 @@ namespace SampleFlow
       std::optional<std::pair<OutputType, AuxiliaryData> >
       filter (InputType sample,
               AuxiliaryData aux_data) = 0;
+
+      /**
+       * Process a batch of samples, and append the samples to be sent
+       * downstream, along with their auxiliary data, to the last two
+       * arguments. The default implementation calls filter() for every
+       * sample of the batch. Derived classes can override this function if
+       * they can process a batch more efficiently as a whole than one
+       * sample at a time -- for example, because they do not then need to
+       * copy every sample into the argument of filter() and out of its
+       * return value (see Filters::Condition).
+       *
+       * Implementations may also send samples downstream themselves, via
+       * Producer::issue_batch(), and leave the output arrays empty; this
+       * avoids copying the batch if all of its samples are passed on
+       * unchanged.
+       *
+       * @param[in] samples The samples of the batch.
+       * @param[in] aux_data The auxiliary data of the samples of the batch.
+       * @param[out] output_samples The array to which the samples to be
+       *   passed on are to be appended. It is empty when this function is
+       *   called.
+       * @param[out] output_aux_data The array to which the auxiliary data
+       *   of the samples to be passed on is to be appended. It is empty
+       *   when this function is called.
+       */
+      virtual
+      void
+      filter_batch (const std::vector<InputType>     &samples,
+                    const std::vector<AuxiliaryData> &aux_data,
+                    std::vector<OutputType>          &output_samples,
+                    std::vector<AuxiliaryData>       &output_aux_data);
   };
 
 
@@ -189,6 +288,57 @@ namespace SampleFlow
 
 
 
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  void
+  Filter<InputType,OutputType>::
+  consume_batch (const std::vector<InputType> &samples,
+                 const std::vector<AuxiliaryData> &aux_data)
+  {
+    assert (samples.size() == aux_data.size());
+
+    // Filter all samples and collect the ones the derived class wants
+    // to pass on:
+    std::vector<OutputType>    output_samples;
+    std::vector<AuxiliaryData> output_aux_data;
+    filter_batch (samples, aux_data, output_samples, output_aux_data);
+    assert (output_samples.size() == output_aux_data.size());
+
+    // Then send them downstream, if there are any:
+    if (output_samples.size() > 0)
+      this->issue_batch (output_samples, output_aux_data);
+  }
+
+
+
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  void
+  Filter<InputType,OutputType>::
+  filter_batch (const std::vector<InputType>     &samples,
+                const std::vector<AuxiliaryData> &aux_data,
+                std::vector<OutputType>          &output_samples,
+                std::vector<AuxiliaryData>       &output_aux_data)
+  {
+    output_samples.reserve (samples.size());
+    output_aux_data.reserve (samples.size());
+
+    for (std::size_t i=0; i<samples.size(); ++i)
+      {
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        maybe_sample =
+          filter (Utilities::copy_sample (samples[i]), aux_data[i]);
+
+        if (maybe_sample)
+          {
+            output_samples.emplace_back (std::move (maybe_sample->first));
+            output_aux_data.emplace_back (std::move (maybe_sample->second));
+          }
+      }
+  }
+
+
+
   template <typename InputType, typename OutputType>
   requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
   void
@@ -204,4 +354,61 @@ namespace SampleFlow
     this->flush_consumers();
   }
 
+
+
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  void
+  Filter<InputType,OutputType>::
+  add_to_graph (PipelineGraph::Graph &graph) const
+  {
+    if (graph.contains (this->graph_node_id()))
+      return;
+
+    Consumer<InputType>::add_to_graph (graph);
+    graph.nodes.back().kind = PipelineGraph::NodeKind::filter;
+
+    this->add_downstream_nodes_to_graph (graph);
+  }
+
+
+
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  bool
+  Filter<InputType,OutputType>::
+  requests_aux_data (const AuxiliaryData::Key &key) const
+  {
+    return (Consumer<InputType>::requests_aux_data (key)
+            ||
+            this->aux_data_requested (key));
+  }
+
+
+
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  void
+  Filter<InputType,OutputType>::
+  receive_announcement (const SampleShape &shape)
+  {
+    Consumer<InputType>::receive_announcement (shape);
+    this->announce_samples (output_shape (shape));
+  }
+
+
+
+  template <typename InputType, typename OutputType>
+  requires (Concepts::is_valid_sampletype<InputType>  &&Concepts::is_valid_sampletype<OutputType>)
+  SampleShape
+  Filter<InputType,OutputType>::
+  output_shape (const SampleShape &input_shape) const
+  {
+    SampleShape shape;
+    if constexpr (std::is_same_v<InputType,OutputType>)
+      shape.n_components = input_shape.n_components;
+    shape.n_samples = input_shape.n_samples;
+    return shape;
+  }
+
 }
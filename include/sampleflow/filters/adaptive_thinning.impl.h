@@ -0,0 +1,324 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * An implementation of the Filter interface that, like the TakeEveryNth
+     * class, passes on only every $n$th sample, but that chooses $n$ by
+     * itself: It keeps an estimate of the integrated autocorrelation time
+     * $\tau$ of the samples it receives, and uses $n\approx\tau$ so
+     * that the samples it passes on are approximately independent. This
+     * avoids having to guess the thinning interval: If it is chosen too
+     * small, then downstream consumers (and files written to disk) have to
+     * deal with many more samples than carry independent information; if
+     * it is chosen too large, then information is thrown away.
+     *
+     * The estimate of $\tau$ is computed by a Consumers::EffectiveSampleSize
+     * object that the current object feeds all samples it receives, using
+     * the method of batch means described there. This costs ${\cal O}(d)$
+     * operations per sample (amortized) for samples with $d$ components. The
+     * current object queries the estimate every `update_interval` samples
+     * and takes the largest of the autocorrelation times of all components
+     * as the new target for $n$. Because the estimate fluctuates from one
+     * update to the next, the stride $n$ is only changed if the target
+     * differs from the current stride by more than a relative amount
+     * given by the `hysteresis` argument of the constructor -- for
+     * example, with the default of 0.5, a stride of 10 is only changed if
+     * the target becomes larger than 15 or smaller than 10/1.5. This
+     * keeps the stride from jumping back and forth, which would otherwise
+     * make the spacing of the samples passed on irregular.
+     *
+     * Since the estimate is based on all samples received so far, including
+     * those from the early, transient phase of a Markov chain, it is
+     * useful to put a DiscardFirstN filter in front of objects of this
+     * class.
+     *
+     * Samples whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count are treated as that many consecutive
+     * copies, in the same way as in the TakeEveryNth class. Samples with
+     * weights other than zero and one are not supported, see the
+     * Consumers::EffectiveSampleSize class.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. However, since the estimate of the autocorrelation time
+     * makes only sense if samples arrive in the order in which they were
+     * generated, this class is typically used with a single producer.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   It needs to satisfy the requirements of the
+     *   Consumers::EffectiveSampleSize class. The outgoing samples are of
+     *   the same type.
+     */
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    class AdaptiveThinning : public Filter<InputType, InputType>
+    {
+      public:
+        /**
+         * Constructor.
+         *
+         * @param[in] update_interval The number of samples after which the
+         *   estimate of the autocorrelation time is queried and the stride
+         *   possibly updated.
+         * @param[in] hysteresis The relative amount by which the estimated
+         *   autocorrelation time has to differ from the current stride
+         *   for the stride to be changed. Must be non-negative.
+         * @param[in] max_stride The largest stride this object will use,
+         *   regardless of the estimated autocorrelation time.
+         *
+         * The stride is initially one, i.e., all samples are passed on
+         * until the first update.
+         */
+        AdaptiveThinning (const types::sample_index update_interval = 1000,
+                          const double              hysteresis = 0.5,
+                          const types::sample_index max_stride
+                          = std::numeric_limits<types::sample_index>::max());
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~AdaptiveThinning ();
+
+        /**
+         * Process one sample by adding it to the estimate of the
+         * autocorrelation time and checking whether it is to be passed on.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only uses the repetition count (which it adjusts if the
+         *   sample is passed on) and the weight.
+         *
+         * @return The sample and its auxiliary data if this sample is
+         *   (or, for repeated samples, if one of its copies is) one stride
+         *   after the previous sample passed on. Otherwise, an empty object.
+         */
+        virtual
+        std::optional<std::pair<InputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since the stride
+         * adapts to the samples, the number of samples passed on is reported
+         * as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return the stride currently used.
+         */
+        types::sample_index
+        get_stride () const;
+
+      private:
+        /**
+         * A mutex used to lock access to all member variables when running
+         * on multiple threads.
+         */
+        mutable std::mutex mutex;
+
+        /**
+         * The object that estimates the autocorrelation time. It is not
+         * connected to any producer; rather, the current object calls its
+         * consume() function directly.
+         */
+        Consumers::EffectiveSampleSize<InputType> autocorrelation_estimator;
+
+        /**
+         * The parameters passed to the constructor.
+         */
+        const types::sample_index update_interval;
+        const double              hysteresis;
+        const types::sample_index max_stride;
+
+        /**
+         * The current stride, the number of (copies of) samples that are
+         * to be discarded before the next one is passed on, and the number
+         * of samples received since the stride was last updated.
+         */
+        types::sample_index stride;
+        types::sample_index n_until_next;
+        types::sample_index n_since_update;
+
+        /**
+         * Query the estimate of the autocorrelation time and update the
+         * stride if necessary. The caller needs to hold the lock on the
+         * mutex.
+         */
+        void
+        update_stride ();
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    AdaptiveThinning<InputType>::
+    AdaptiveThinning (const types::sample_index update_interval,
+                      const double              hysteresis,
+                      const types::sample_index max_stride)
+      : update_interval (update_interval),
+        hysteresis (hysteresis),
+        max_stride (max_stride),
+        stride (1),
+        n_until_next (0),
+        n_since_update (0)
+    {
+      assert (update_interval >= 1);
+      assert (hysteresis >= 0);
+      assert (max_stride >= 1);
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    AdaptiveThinning<InputType>::
+    ~AdaptiveThinning ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    std::optional<std::pair<InputType, AuxiliaryData> >
+    AdaptiveThinning<InputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      if (n_repetitions == 0)
+        return {};
+
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      autocorrelation_estimator.consume (sample, aux_data);
+
+      // Decide how many of the copies this sample stands for are passed on,
+      // and how many copies are to be discarded after the last of them:
+      types::sample_index n_forwarded = 0;
+      if (n_repetitions <= n_until_next)
+        n_until_next -= n_repetitions;
+      else
+        {
+          const types::sample_index n_after_first = n_repetitions - n_until_next - 1;
+          n_forwarded  = 1 + n_after_first / stride;
+          n_until_next = stride - 1 - n_after_first % stride;
+        }
+
+      n_since_update += n_repetitions;
+      if (n_since_update >= update_interval)
+        {
+          n_since_update = 0;
+          update_stride ();
+        }
+
+      if (n_forwarded == 0)
+        return {};
+
+      if (n_repetitions != 1)
+        aux_data[AuxiliaryData::repetition_count] = std::size_t(n_forwarded);
+      return {{ std::move(sample), std::move(aux_data)}};
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    void
+    AdaptiveThinning<InputType>::
+    update_stride ()
+    {
+      const std::vector<double> tau
+        = autocorrelation_estimator.get_integrated_autocorrelation_times();
+      if (tau.size() == 0)
+        return;
+
+      const double max_tau = *std::max_element (tau.begin(), tau.end());
+      if (!(max_tau > 0))
+        return;
+
+      const types::sample_index target
+        = (max_tau >= max_stride ?
+           max_stride :
+           std::max<types::sample_index> (1, std::ceil(max_tau)));
+
+      if ((target > stride * (1+hysteresis))
+          ||
+          (target * (1+hysteresis) < stride))
+        {
+          stride       = target;
+          n_until_next = std::min (n_until_next, stride-1);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    types::sample_index
+    AdaptiveThinning<InputType>::
+    get_stride () const
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+      return stride;
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::is_vector_space_type<InputType>
+              &&
+              std::is_floating_point_v<types::ScalarType<InputType>>)
+    SampleShape
+    AdaptiveThinning<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<InputType,InputType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+  }
+}
@@ -0,0 +1,286 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A filter that, for each sample it receives, sends on one of the
+     * entries of the sample's auxiliary data in place of the sample
+     * itself. This is useful to analyze the information producers attach
+     * to samples with the same tools as the samples: For example, the
+     * following code computes a histogram of the (relative) log likelihoods
+     * of the samples a Metropolis-Hastings sampler produces:
+     * @code
+     *   SampleFlow::Filters::AuxiliaryDataProjection<SampleType, double>
+     *     log_likelihoods (SampleFlow::AuxiliaryData::relative_log_likelihood);
+     *   log_likelihoods.connect_to_producer (mh_sampler);
+     *
+     *   SampleFlow::Consumers::Histogram<double> histogram (-10, 0, 100);
+     *   histogram.connect_to_producer (log_likelihoods);
+     * @endcode
+     * In the same way, one can compute the acceptance rate of a sampler by
+     * connecting a Consumers::MeanValue object to a projection onto the
+     * AuxiliaryData::sample_is_repeated entry (converted to a number by a
+     * Filters::Conversion object), or output timing information stored in
+     * the auxiliary data via a Consumers::StreamOutput object.
+     *
+     * One could do the same with a Filters::Conversion object whose
+     * conversion function looks at the auxiliary data, but such a filter
+     * receives every sample by value, and consequently requires a copy of
+     * it if the producer has other consumers as well. For large samples,
+     * this copy can easily cost more than everything that is then done with
+     * the extracted entry. In contrast, the current class never needs a
+     * copy of the sample: It declares that it only reads samples (see
+     * Consumer::reads_samples_by_reference()), and so receives them by
+     * reference from producers, and it also overrides the function that
+     * processes batches so that it does not have to copy the samples of a
+     * batch to call filter().
+     *
+     * The auxiliary data is passed on along with the extracted entry, so
+     * that downstream consumers can still see, for example, repetition
+     * counts and weights. Samples whose auxiliary data does not contain
+     * the entry, or contains it with a type other than `OutputType`, are
+     * dropped.
+     *
+     * This class only avoids copies if it processes samples synchronously
+     * (the default for filters) or in single-threaded mode; in the other
+     * parallel modes, samples have to be stored in a queue anyway. If a
+     * producer sends each sample to several consumers, it is best to
+     * connect the current object first: Consumers connected after it can
+     * then still receive the sample without a copy (see
+     * SharedSample::release()).
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     * @tparam OutputType The type of the entry of the auxiliary data that
+     *   is to be sent on, i.e., the type of the object stored in the
+     *   `std::any` object for the entry.
+     */
+    template <typename InputType, typename OutputType>
+    class AuxiliaryDataProjection : public Filter<InputType, OutputType>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] key The key of the entry of the auxiliary data that is
+         *   to be sent on in place of each sample.
+         */
+        AuxiliaryDataProjection (const AuxiliaryData::Key &key);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~AuxiliaryDataProjection ();
+
+        /**
+         * Process one sample by extracting the selected entry of its
+         * auxiliary data.
+         *
+         * @param[in] sample The sample to process. It is ignored.
+         * @param[in] aux_data Auxiliary data about this sample.
+         *
+         * @return The selected entry of the auxiliary data, along with the
+         *   auxiliary data, or nothing if the auxiliary data does not
+         *   contain the entry.
+         */
+        virtual
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since only samples
+         * whose auxiliary data contains the selected entry are passed on, the
+         * number of samples is reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Process a sample owned by the caller in the same way as
+         * filter(), and send the extracted entry downstream. This is the
+         * function through which producers send samples to this object in
+         * synchronous and single-threaded mode.
+         */
+        virtual
+        void
+        consume_by_reference (const InputType     &sample,
+                              const AuxiliaryData &aux_data) override;
+
+        /**
+         * Return true, since this class never needs its own copy of
+         * samples. See Consumer::reads_samples_by_reference().
+         */
+        virtual
+        bool
+        reads_samples_by_reference () const override;
+
+        /**
+         * Return the key of the selected entry, which is the only one this
+         * class looks at. See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Process a batch of samples by extracting the selected entry from
+         * the auxiliary data of each of them, without looking at (or
+         * copying) the samples themselves.
+         */
+        virtual
+        void
+        filter_batch (const std::vector<InputType>     &samples,
+                      const std::vector<AuxiliaryData> &aux_data,
+                      std::vector<OutputType>          &output_samples,
+                      std::vector<AuxiliaryData>       &output_aux_data) override;
+
+      private:
+        /**
+         * The key of the selected entry.
+         */
+        const AuxiliaryData::Key key;
+    };
+
+
+
+    template <typename InputType, typename OutputType>
+    AuxiliaryDataProjection<InputType,OutputType>::
+    AuxiliaryDataProjection (const AuxiliaryData::Key &key)
+      : key (key)
+    {}
+
+
+
+    template <typename InputType, typename OutputType>
+    AuxiliaryDataProjection<InputType,OutputType>::
+    ~AuxiliaryDataProjection ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    std::optional<std::pair<OutputType, AuxiliaryData> >
+    AuxiliaryDataProjection<InputType,OutputType>::
+    filter (InputType /*sample*/,
+            AuxiliaryData aux_data)
+    {
+      if (const OutputType *const value = aux_data.get_if<OutputType>(key))
+        {
+          OutputType output = *value;
+          return std::make_pair (std::move(output), std::move(aux_data));
+        }
+      else
+        return {};
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    void
+    AuxiliaryDataProjection<InputType,OutputType>::
+    consume_by_reference (const InputType     &/*sample*/,
+                          const AuxiliaryData &aux_data)
+    {
+      if (const OutputType *const value = aux_data.get_if<OutputType>(key))
+        this->issue_sample (*value, aux_data);
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    bool
+    AuxiliaryDataProjection<InputType,OutputType>::
+    reads_samples_by_reference () const
+    {
+      return true;
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    AuxiliaryDataProjection<InputType,OutputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key> {key};
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    void
+    AuxiliaryDataProjection<InputType,OutputType>::
+    filter_batch (const std::vector<InputType>     &samples,
+                  const std::vector<AuxiliaryData> &aux_data,
+                  std::vector<OutputType>          &output_samples,
+                  std::vector<AuxiliaryData>       &output_aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      output_samples.reserve (samples.size());
+      output_aux_data.reserve (samples.size());
+      for (const AuxiliaryData &a : aux_data)
+        if (const OutputType *const value = a.get_if<OutputType>(key))
+          {
+            output_samples.push_back (*value);
+            output_aux_data.push_back (a);
+          }
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    SampleShape
+    AuxiliaryDataProjection<InputType,OutputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<InputType,OutputType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+  }
+}
@@ -0,0 +1,280 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A type that describes a batch of samples along with their auxiliary
+     * data. Objects of this type are what the Batcher class produces and the
+     * Unbatcher class consumes. The samples are stored contiguously in a
+     * `std::vector`, and so a consumer that receives a batch can process
+     * all of its samples at once -- say, by handing them to a BLAS-3
+     * function or copying them to a GPU in one go.
+     *
+     * @tparam InputType The type of the individual samples of the batch.
+     */
+    template <typename InputType>
+    struct SampleBatch
+    {
+      /**
+       * The samples of the batch.
+       */
+      std::vector<InputType>     samples;
+
+      /**
+       * The auxiliary data of each of the samples, in the same order.
+       */
+      std::vector<AuxiliaryData> aux_data;
+    };
+
+
+
+    /**
+     * An implementation of the Filter interface that collects samples into
+     * batches and sends a SampleBatch object downstream once a batch is
+     * complete. A batch is complete once it contains a given number of
+     * samples or, if a maximal delay is given to the constructor, if the
+     * first sample of the batch arrived longer ago than this delay. (The
+     * latter condition is checked whenever a sample arrives; the class
+     * does not use a timer to send off batches while no samples arrive.)
+     *
+     * Calling flush() -- which happens, for example, whenever the producer
+     * upstream finishes a call to its `sample()` function, and in the
+     * destructor of this class -- sends off the samples collected so far as
+     * a (shorter) batch, so that no samples are lost and all samples the
+     * filter has received have been passed on when flush() returns. The
+     * Unbatcher class undoes what this class does.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. Samples that arrive concurrently end up in a batch in the
+     * order in which the threads acquire the lock that protects the current
+     * batch.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   The outgoing samples are of type `SampleBatch<InputType>`.
+     */
+    template <typename InputType>
+    class Batcher : public Filter<InputType, SampleBatch<InputType>>
+    {
+      public:
+        /**
+         * Constructor.
+         *
+         * @param[in] batch_size The number of samples that make up a
+         *   complete batch. Must be at least one.
+         * @param[in] max_delay The time after which a batch is considered
+         *   complete even if it does not yet have `batch_size` samples,
+         *   measured from the time its first sample arrived. The default
+         *   means that batches are only complete once they have
+         *   `batch_size` samples.
+         */
+        Batcher (const std::size_t                         batch_size,
+                 const std::chrono::steady_clock::duration max_delay
+                 = std::chrono::steady_clock::duration::max());
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed, and that the
+         * last, incomplete batch has been sent off. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Batcher ();
+
+        /**
+         * Process one sample by adding it to the current batch and, if the
+         * batch is then complete, return the batch so that it can be sent
+         * downstream.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. It is
+         *   stored in the batch along with the sample.
+         *
+         * @return The completed batch, or an empty object if the batch
+         *   is not yet complete. The auxiliary data of the batch itself is
+         *   empty.
+         */
+        virtual
+        std::optional<std::pair<SampleBatch<InputType>, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. The number of batches
+         * is known if no maximal delay has been given to the constructor;
+         * otherwise, batches may be sent off before they are complete, and
+         * the number is reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Wait for all samples currently being processed, then send off the
+         * current batch if it contains any samples, and finally flush the
+         * consumers connected to this filter. See Filter::flush().
+         */
+        virtual
+        void
+        flush () override;
+
+      private:
+        /**
+         * The number of samples per batch, and the maximal age of a batch.
+         */
+        const std::size_t                         batch_size;
+        const std::chrono::steady_clock::duration max_delay;
+
+        /**
+         * A mutex used to lock access to the current batch when running on
+         * multiple threads.
+         */
+        std::mutex mutex;
+
+        /**
+         * The batch currently being filled, and the time by which it has to
+         * be sent off if there is a maximal delay.
+         */
+        SampleBatch<InputType>                current_batch;
+        std::chrono::steady_clock::time_point current_batch_deadline;
+
+        /**
+         * Return the current batch and start a new one. This function must
+         * be called with `mutex` locked.
+         */
+        SampleBatch<InputType>
+        take_current_batch ();
+    };
+
+
+
+    template <typename InputType>
+    Batcher<InputType>::
+    Batcher (const std::size_t                         batch_size,
+             const std::chrono::steady_clock::duration max_delay)
+      : batch_size (batch_size),
+        max_delay (max_delay)
+    {
+      assert (batch_size >= 1);
+      assert (max_delay > std::chrono::steady_clock::duration::zero());
+
+      current_batch.samples.reserve (batch_size);
+      current_batch.aux_data.reserve (batch_size);
+    }
+
+
+
+    template <typename InputType>
+    Batcher<InputType>::
+    ~Batcher ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<SampleBatch<InputType>, AuxiliaryData> >
+    Batcher<InputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+      const bool has_deadline = (max_delay != std::chrono::steady_clock::duration::max());
+      std::chrono::steady_clock::time_point now;
+      if (has_deadline)
+        {
+          now = std::chrono::steady_clock::now();
+          if (current_batch.samples.empty())
+            current_batch_deadline = now + max_delay;
+        }
+
+      current_batch.samples.emplace_back (std::move(sample));
+      current_batch.aux_data.emplace_back (std::move(aux_data));
+
+      if ((current_batch.samples.size() >= batch_size)
+          ||
+          (has_deadline && (now >= current_batch_deadline)))
+        return {{ take_current_batch(), AuxiliaryData()}};
+      else
+        return {};
+    }
+
+
+
+    template <typename InputType>
+    void
+    Batcher<InputType>::
+    flush ()
+    {
+      // First make sure that all samples currently being processed have
+      // arrived in the current batch, then send off what we have:
+      Consumer<InputType>::flush();
+
+      std::optional<SampleBatch<InputType>> last_batch;
+      {
+        const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+        if (current_batch.samples.size() > 0)
+          last_batch = take_current_batch();
+      }
+      if (last_batch)
+        this->issue_sample (std::move(*last_batch), AuxiliaryData());
+
+      this->flush_consumers();
+    }
+
+
+
+    template <typename InputType>
+    SampleBatch<InputType>
+    Batcher<InputType>::
+    take_current_batch ()
+    {
+      SampleBatch<InputType> batch = std::move(current_batch);
+
+      current_batch = SampleBatch<InputType>();
+      current_batch.samples.reserve (batch_size);
+      current_batch.aux_data.reserve (batch_size);
+
+      return batch;
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    Batcher<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape;
+      if (input_shape.n_samples.has_value()
+          &&
+          (max_delay == std::chrono::steady_clock::duration::max()))
+        shape.n_samples = (*input_shape.n_samples + batch_size - 1) / batch_size;
+      return shape;
+    }
+  }
+}
@@ -49,6 +49,18 @@ namespace SampleFlow
          */
         using OutputType = typename InputType::value_type;
 
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
         /**
          * Constructor.
          *
@@ -87,6 +99,15 @@ namespace SampleFlow
         filter (InputType sample,
                 AuxiliaryData aux_data) override;
 
+        /**
+         * Return an empty list, since this class passes the auxiliary data
+         * of samples on without looking at it. See
+         * Consumer::used_aux_data_keys() and Filter::requests_aux_data().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
       private:
         /**
          * The selected component of samples to be extracted.
@@ -140,5 +161,17 @@ namespace SampleFlow
                             std::move(aux_data));
     }
 
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    std::optional<std::vector<AuxiliaryData::Key>>
+    ComponentSplitter<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
+    }
+
   }
 }
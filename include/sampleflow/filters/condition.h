@@ -18,6 +18,11 @@
 
 #include <sampleflow/filter.h>
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <span>
 #include <type_traits>
 
 // Import the implementation of the things for this header file:
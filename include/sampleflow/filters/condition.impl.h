@@ -27,6 +27,50 @@ namespace SampleFlow
      * is what is called a "predicate" and is referred by that name in the
      * code of this class.
      *
+     * By default, the predicate is stored as a `std::function` object,
+     * which allows choosing it at run time but costs an indirect function
+     * call for every sample and prevents the compiler from inlining the
+     * predicate into the filter() function. If the type of the predicate
+     * is known when the filter is created -- as is the case for lambda
+     * functions -- it can be given as the second template argument instead.
+     * The simplest way to do so is to let the compiler deduce both template
+     * arguments from the predicate:
+     * @code
+     *   SampleFlow::Filters::Condition positive ([](const double x)
+     *   {
+     *     return x > 0;
+     *   });
+     * @endcode
+     * This requires that the predicate is not a generic lambda function, so
+     * that the type of samples can be deduced from the type of its (first)
+     * argument.
+     *
+     * When samples arrive in batches (see Consumer::consume_batch()), the
+     * filter_batch() function of this class first evaluates the predicate
+     * for all samples of the batch into an array of flags, and then sends
+     * the selected samples downstream as one batch -- or the incoming
+     * batch itself, without copying it, if all of its samples are
+     * selected. Alternatively, the constructor can be given a "batch
+     * predicate" that fills this array of flags for a whole batch in one
+     * call:
+     * @code
+     *   SampleFlow::Filters::Condition<double> positive (
+     *     [](const std::span<const double> samples,
+     *        const std::span<const SampleFlow::AuxiliaryData> ,
+     *        const std::span<bool> selected)
+     *   {
+     *     for (std::size_t i=0; i<samples.size(); ++i)
+     *       selected[i] = (samples[i] > 0);
+     *   });
+     * @endcode
+     * This replaces one indirect function call per sample by one per batch,
+     * and allows writing the predicate as a loop that the compiler can
+     * vectorize (or as a call into a library that evaluates constraints on
+     * many samples at once). Samples that arrive individually are passed
+     * to the batch predicate as batches of one sample. The type of samples
+     * cannot be deduced from a batch predicate, and so needs to be given
+     * explicitly as above.
+     *
      *
      * ### Threading model ###
      *
@@ -37,11 +81,47 @@ namespace SampleFlow
      *
      * @tparam SampleType The C++ type used to describe the incoming and outgoing
      *   samples.
+     * @tparam Predicate The type of the predicate. It needs to be callable
+     *   as a `const` object with a sample, or with a sample and its
+     *   auxiliary data, and return something convertible to `bool`.
      */
-    template <typename SampleType>
+    template <typename SampleType,
+              typename Predicate = std::function<bool (const SampleType &, const AuxiliaryData &)>>
     class Condition : public Filter<SampleType,SampleType>
     {
       public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Whether the predicate is stored as a `std::function` object, i.e.,
+         * whether the second template argument has its default value.
+         */
+        static constexpr bool is_type_erased
+          = std::is_same_v<Predicate,
+            std::function<bool (const SampleType &, const AuxiliaryData &)>>;
+
+        /**
+         * The type of a predicate that decides for a whole batch of
+         * samples, given as the first argument along with their auxiliary
+         * data as the second, whether they should be passed through, and
+         * stores the answers in the corresponding elements of the third
+         * argument.
+         */
+        using BatchPredicate
+          = std::function<void (std::span<const SampleType>,
+                                std::span<const AuxiliaryData>,
+                                std::span<bool>)>;
+
         /**
          * Constructor. This constructor is used when you pass in a predicate
          * that only takes the sample as argument. In other words, the
@@ -50,10 +130,21 @@ namespace SampleFlow
          *
          * @param[in] predicate A function object that is used to
          *   select whether a sample should be passed through.
+         *
+         * This constructor, and the following one, are used if the
+         * predicate is stored as a `std::function` object (the default of
+         * the second template argument of this class).
          */
         template <typename PredicateType>
-        requires (std::is_invocable_r_v<bool,PredicateType,SampleType>)
-        Condition (const PredicateType &predicate);
+        requires (is_type_erased
+                  &&
+                  std::is_invocable_r_v<bool,PredicateType,SampleType>)
+        Condition (const PredicateType &predicate)
+        // Wrap the predicate and pass it on to the other constructor. Capture
+        // the predicate by value copy.
+          : Condition([p = predicate](const SampleType &sample, const AuxiliaryData &) -> bool
+        { return p(sample); })
+        {}
 
         /**
          * Constructor. This constructor is used when you pass in a predicate
@@ -65,8 +156,52 @@ namespace SampleFlow
          *   select whether a sample should be passed through.
          */
         template <typename PredicateType>
-        requires (std::is_invocable_r_v<bool,PredicateType,SampleType,AuxiliaryData>)
-        Condition (const PredicateType &predicate);
+        requires (is_type_erased
+                  &&
+                  std::is_invocable_r_v<bool,PredicateType,SampleType,AuxiliaryData>)
+        Condition (const PredicateType &predicate)
+          : predicate(predicate)
+        {}
+
+        /**
+         * Constructor for the case where the type of the predicate is given
+         * as the second template argument of this class. The predicate may
+         * either take only the sample, or the sample and its auxiliary
+         * data as arguments.
+         *
+         * @param[in] predicate A function object that is used to
+         *   select whether a sample should be passed through.
+         */
+        Condition (const Predicate &predicate)
+        requires (is_type_erased == false);
+
+        /**
+         * Constructor for a batch predicate, see the documentation of this
+         * class. The predicate is used both for samples that arrive in
+         * batches and for individual samples.
+         *
+         * @param[in] batch_predicate A function object that is used to
+         *   select which samples of a batch should be passed through.
+         */
+        template <typename PredicateType>
+        requires (is_type_erased
+                  &&
+                  std::is_invocable_v<PredicateType,
+                  std::span<const SampleType>,
+                  std::span<const AuxiliaryData>,
+                  std::span<bool>>)
+        Condition (const PredicateType &batch_predicate)
+          : Condition([batch_predicate](const SampleType &sample, const AuxiliaryData &aux_data) -> bool
+        {
+          bool selected;
+          batch_predicate (std::span<const SampleType> (&sample, 1),
+                           std::span<const AuxiliaryData> (&aux_data, 1),
+                           std::span<bool> (&selected, 1));
+          return selected;
+        })
+        {
+          this->batch_predicate = batch_predicate;
+        }
 
         /**
          * Move constructor.
@@ -99,57 +234,161 @@ namespace SampleFlow
         filter (SampleType sample,
                 AuxiliaryData aux_data) override;
 
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since whether a sample
+         * is passed on depends on the predicate, the number of samples is
+         * reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Process a batch of samples by evaluating the predicate (or the
+         * batch predicate, if one was given to the constructor) for all of
+         * them, and pass on the ones it selects. See the documentation of
+         * this class.
+         */
+        virtual
+        void
+        filter_batch (const std::vector<SampleType>    &samples,
+                      const std::vector<AuxiliaryData> &aux_data,
+                      std::vector<SampleType>          &output_samples,
+                      std::vector<AuxiliaryData>       &output_aux_data) override;
+
       private:
         /**
          * The predicate function used.
          */
-        const std::function<bool (const SampleType &, const AuxiliaryData &aux_data)> predicate;
-    };
+        const Predicate predicate;
+
+        /**
+         * The batch predicate, if one was given to the constructor.
+         */
+        BatchPredicate batch_predicate;
 
+        /**
+         * Evaluate the predicate for one sample.
+         */
+        bool
+        is_selected (const SampleType    &sample,
+                     const AuxiliaryData &aux_data) const;
+    };
 
 
-    template <typename SampleType>
-    template <typename PredicateType>
-    requires (std::is_invocable_r_v<bool,PredicateType,SampleType>)
-    Condition<SampleType>::
-    Condition (const PredicateType &predicate)
-    // Wrap the predicate and pass it on to the other constructor. Capture the
-    // predicate by value copy.
-      : Condition([p = predicate](const SampleType &sample, const AuxiliaryData &) -> bool
-    { return p(sample); })
-    {}
+    /**
+     * A deduction guide that allows creating a Condition object from just
+     * a (non-generic) predicate, whose type is then stored rather than
+     * converted to `std::function`.
+     */
+    template <typename Predicate>
+    Condition (Predicate) -> Condition<types::FirstArgumentType<Predicate>, Predicate>;
 
 
 
-    template <typename SampleType>
-    template <typename PredicateType>
-    requires (std::is_invocable_r_v<bool,PredicateType,SampleType,AuxiliaryData>)
-    Condition<SampleType>::
-    Condition (const PredicateType &predicate)
+    template <typename SampleType, typename Predicate>
+    Condition<SampleType,Predicate>::
+    Condition (const Predicate &predicate)
+    requires (is_type_erased == false)
       : predicate(predicate)
     {}
 
 
 
-    template <typename SampleType>
-    Condition<SampleType>::
+    template <typename SampleType, typename Predicate>
+    Condition<SampleType,Predicate>::
     ~Condition ()
     {
       this->disconnect_and_flush();
     }
 
 
-    template <typename SampleType>
+    template <typename SampleType, typename Predicate>
     std::optional<std::pair<SampleType, AuxiliaryData> >
-    Condition<SampleType>::
+    Condition<SampleType,Predicate>::
     filter (SampleType sample,
             AuxiliaryData aux_data)
     {
-      if (predicate (sample, aux_data))
+      if (is_selected (sample, aux_data))
         return std::make_pair(std::move(sample), std::move(aux_data));
       else
         return {};
     }
 
+
+
+    template <typename SampleType, typename Predicate>
+    void
+    Condition<SampleType,Predicate>::
+    filter_batch (const std::vector<SampleType>    &samples,
+                  const std::vector<AuxiliaryData> &aux_data,
+                  std::vector<SampleType>          &output_samples,
+                  std::vector<AuxiliaryData>       &output_aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+      const std::size_t n = samples.size();
+
+      // First decide for all samples whether they pass. This loop does
+      // nothing but call the predicate, which the compiler can inline if
+      // its type is known:
+      const std::unique_ptr<bool[]> selected = std::make_unique_for_overwrite<bool[]>(n);
+      if (batch_predicate)
+        batch_predicate (std::span<const SampleType> (samples),
+                         std::span<const AuxiliaryData> (aux_data),
+                         std::span<bool> (selected.get(), n));
+      else
+        for (std::size_t i=0; i<n; ++i)
+          selected[i] = is_selected (samples[i], aux_data[i]);
+
+      const std::size_t n_selected = std::count (selected.get(), selected.get() + n, true);
+
+      // If all samples pass, send the batch on as is. Otherwise, copy the
+      // selected ones:
+      if (n_selected == n)
+        {
+          if (n > 0)
+            this->issue_batch (samples, aux_data);
+        }
+      else if (n_selected > 0)
+        {
+          output_samples.reserve (n_selected);
+          output_aux_data.reserve (n_selected);
+          for (std::size_t i=0; i<n; ++i)
+            if (selected[i])
+              {
+                output_samples.push_back (Utilities::copy_sample (samples[i]));
+                output_aux_data.push_back (aux_data[i]);
+              }
+        }
+    }
+
+
+
+    template <typename SampleType, typename Predicate>
+    bool
+    Condition<SampleType,Predicate>::
+    is_selected (const SampleType    &sample,
+                 const AuxiliaryData &aux_data) const
+    {
+      if constexpr (std::is_invocable_r_v<bool, const Predicate &, const SampleType &, const AuxiliaryData &>)
+        return predicate (sample, aux_data);
+      else
+        return predicate (sample);
+    }
+
+
+
+    template <typename SampleType, typename Predicate>
+    SampleShape
+    Condition<SampleType,Predicate>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<SampleType,SampleType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+
   }
 }
@@ -18,6 +18,10 @@
 
 #include <sampleflow/filter.h>
 
+#include <functional>
+#include <type_traits>
+#include <utility>
+
 // Import the implementation of the things for this header file:
 #include <sampleflow/filters/conversion.impl.h>
 
@@ -48,6 +48,42 @@ namespace SampleFlow
      * such a conversion function could then connect the triangle producer
      * to a Consumers::Histogram or Consumers::MeanValue consumer.
      *
+     * By default, the function object is stored as a `std::function` object
+     * that receives the sample by `const` reference, and so has to create
+     * the converted sample from scratch. However, the filter owns each
+     * sample it receives and has no further use for it once converted.
+     * The type of the function object is therefore a template argument,
+     * and if it can be called with an rvalue reference, it receives the
+     * sample as an rvalue. A conversion function can then reuse the memory
+     * of the sample for the converted object:
+     * @code
+     *   const auto to_valarray = [](std::vector<double> &&x)
+     *   {
+     *     std::valarray<double> y (x.size());
+     *     ...
+     *     return y;
+     *   };
+     *   SampleFlow::Filters::Conversion<std::vector<double>, std::valarray<double>,
+     *                                   decltype(to_valarray)>
+     *     conversion (to_valarray);
+     * @endcode
+     * Finally, if input and output type are the same, the function object
+     * can also take the sample by (non-`const`) reference and return
+     * nothing. It then modifies the sample in place, and the filter sends
+     * the modified object on without creating a new one. This is useful for
+     * transformations such as scaling samples or changing the
+     * parameterization of the space the samples live in:
+     * @code
+     *   const auto scale = [](Eigen::VectorXd &x) { x *= 2; };
+     *   SampleFlow::Filters::Conversion<Eigen::VectorXd, Eigen::VectorXd,
+     *                                   decltype(scale)>
+     *     scaling (scale);
+     * @endcode
+     * In all of these cases, the template arguments can also be deduced
+     * from the function object, as in
+     * `SampleFlow::Filters::Conversion scaling (scale);`, as long as the
+     * function object is not a generic lambda.
+     *
      *
      * ### Threading model ###
      *
@@ -59,11 +95,29 @@ namespace SampleFlow
      * @tparam InputType The C++ type used to describe the incoming samples.
      * @tparam OutputType The C++ type used to describe the outgoing samples,
      *   i.e., the data type that the input is to be converted to.
+     * @tparam ConversionFunction The type of the function object that does
+     *   the conversion. It needs to be callable as a `const` object, either
+     *   with an rvalue of type `InputType` (returning something convertible
+     *   to `OutputType`), or with an lvalue reference to `InputType`
+     *   (returning `void`) as discussed above.
      */
-    template <typename InputType, typename OutputType>
+    template <typename InputType, typename OutputType,
+              typename ConversionFunction = std::function<OutputType (const InputType &)>>
     class Conversion : public Filter<InputType, OutputType>
     {
       public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
         /**
          * Constructor.
          *
@@ -71,14 +125,21 @@ namespace SampleFlow
          *   do the actual conversion from `InputType` to `OutputType`.
          *   The default for this function object is a lambda function
          *   that simply calls `static_cast`. This is appropriate for
-         *   simple conversions such as from `int` to double.
+         *   simple conversions such as from `int` to double. This default
+         *   can only be used if `ConversionFunction` is the default
+         *   `std::function` type.
          */
-        Conversion (const std::function<OutputType (const InputType &)> &conversion_function
+        Conversion (const ConversionFunction &conversion_function
                     = [] (const InputType &in)
         {
           return static_cast<OutputType>(in);
         });
 
+        /**
+         * Move constructor.
+         */
+        Conversion (Conversion &&) = default;
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -97,45 +158,143 @@ namespace SampleFlow
          *   simply passes it on.
          *
          * @return The converted sample and the auxiliary data
-         *   originally associated with the sample.
+         *   originally associated with the sample. If the conversion
+         *   function modifies samples in place, then the converted sample
+         *   is the object `sample` itself.
          */
         virtual
         std::optional<std::pair<OutputType, AuxiliaryData> >
         filter (InputType sample,
                 AuxiliaryData aux_data) override;
 
+        /**
+         * Return an empty list, since this class passes the auxiliary data
+         * of samples on without looking at it. See
+         * Consumer::used_aux_data_keys() and Filter::requests_aux_data().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
       private:
         /**
          * The conversion function used.
          */
-        const std::function<OutputType (const InputType &)> conversion_function;
+        const ConversionFunction conversion_function;
+
+        /**
+         * Return whether the conversion function is one that modifies
+         * samples in place.
+         */
+        static
+        constexpr
+        bool
+        converts_in_place ();
     };
 
 
+    namespace internal
+    {
+      /**
+       * Return (wrapped in `std::type_identity`) the type the given
+       * conversion function produces when called with its argument type,
+       * or the argument type itself if the function modifies its argument
+       * in place.
+       */
+      template <typename ConversionFunction>
+      constexpr
+      auto
+      deduce_conversion_output_type ()
+      {
+        using InputType = types::FirstArgumentType<ConversionFunction>;
+        if constexpr (std::is_invocable_v<const ConversionFunction &, InputType>)
+          {
+            using ResultType = std::invoke_result_t<const ConversionFunction &, InputType>;
+            if constexpr (std::is_void_v<ResultType> == false)
+              return std::type_identity<std::remove_cvref_t<ResultType>> ();
+            else
+              return std::type_identity<InputType> ();
+          }
+        else
+          return std::type_identity<InputType> ();
+      }
+    }
+
+
+    /**
+     * A deduction guide that allows creating a Conversion object from just
+     * a (non-generic) conversion function: The input type is the type of
+     * the function's argument, and the output type is the type it returns
+     * or, for functions that modify their argument in place and return
+     * nothing, the input type.
+     */
+    template <typename ConversionFunction>
+    Conversion (ConversionFunction)
+    -> Conversion<types::FirstArgumentType<ConversionFunction>,
+    typename decltype(internal::deduce_conversion_output_type<ConversionFunction>())::type,
+    ConversionFunction>;
 
-    template <typename InputType, typename OutputType>
-    Conversion<InputType,OutputType>::
-    Conversion (const std::function<OutputType (const InputType &)> &conversion_function)
+
+    template <typename InputType, typename OutputType, typename ConversionFunction>
+    Conversion<InputType,OutputType,ConversionFunction>::
+    Conversion (const ConversionFunction &conversion_function)
       : conversion_function (conversion_function)
     {}
 
 
 
-    template <typename InputType, typename OutputType>
-    Conversion<InputType,OutputType>::
+    template <typename InputType, typename OutputType, typename ConversionFunction>
+    Conversion<InputType,OutputType,ConversionFunction>::
     ~Conversion ()
     {
       this->disconnect_and_flush();
     }
 
 
-    template <typename InputType, typename OutputType>
+    template <typename InputType, typename OutputType, typename ConversionFunction>
+    constexpr
+    bool
+    Conversion<InputType,OutputType,ConversionFunction>::
+    converts_in_place ()
+    {
+      if constexpr (std::is_invocable_v<const ConversionFunction &, InputType &>)
+        return std::is_void_v<std::invoke_result_t<const ConversionFunction &, InputType &>>;
+      else
+        return false;
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename ConversionFunction>
     std::optional<std::pair<OutputType, AuxiliaryData> >
-    Conversion<InputType, OutputType>::
+    Conversion<InputType,OutputType,ConversionFunction>::
     filter (InputType sample,
             AuxiliaryData aux_data)
     {
-      return std::make_pair(conversion_function(sample), std::move(aux_data));
+      // See whether the conversion function modifies samples in place, and
+      // otherwise let it have the sample as an rvalue (which also works
+      // for functions that take their argument by const reference):
+      if constexpr (converts_in_place())
+        {
+          static_assert (std::is_same_v<InputType, OutputType>,
+                         "Conversion functions that modify samples in place "
+                         "can only be used if input and output type are the same.");
+          conversion_function (sample);
+          return std::make_pair(std::move(sample), std::move(aux_data));
+        }
+      else
+        return std::make_pair(OutputType (conversion_function(std::move(sample))),
+                              std::move(aux_data));
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename ConversionFunction>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    Conversion<InputType,OutputType,ConversionFunction>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
     }
 
   }
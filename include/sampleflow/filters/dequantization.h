@@ -0,0 +1,37 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_FILTERS_DEQUANTIZATION_H
+#define SAMPLEFLOW_FILTERS_DEQUANTIZATION_H
+
+#include <sampleflow/filter.h>
+#include <sampleflow/concepts.h>
+#include <sampleflow/element_access.h>
+#include <sampleflow/types.h>
+
+#include <cassert>
+#include <cmath>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/filters/dequantization.impl.h>
+
+#endif
@@ -0,0 +1,264 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * An implementation of the Filter interface that undoes what the
+     * Quantization class does: Component $j$ of an outgoing sample $x$ is
+     * computed from the corresponding component of the incoming, quantized
+     * sample $y$ as
+     * @f{align*}{
+     *   x_j = o_j + s_j y_j,
+     * @f}
+     * where the scales $s_j$ and offsets $o_j$ are the same as the ones
+     * given to the Quantization object that created the samples. This
+     * class is typically used to convert samples that were written to a
+     * file in reduced precision and are read back via Producers::ChainFile
+     * into samples of the type used by downstream consumers, see the
+     * example in the documentation of the Quantization class.
+     *
+     * If the components of both the incoming and outgoing samples are
+     * stored contiguously (see Concepts::has_contiguous_storage), then the
+     * conversion is done in a simple loop over the underlying arrays that
+     * compilers can vectorize.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The object is not modified after it is created, and so filter() can
+     * be called concurrently and from multiple threads.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   Its elements need to be of an arithmetic type.
+     * @tparam OutputType The C++ type used to describe the outgoing samples.
+     *   The same requirements apply as for the output type of the
+     *   Quantization class, and its elements need to be floating point
+     *   numbers.
+     */
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_floating_point_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    class Dequantization : public Filter<InputType, OutputType>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Constructor for the case where all components use the same
+         * scale and offset.
+         *
+         * @param[in] scale The scale $s$.
+         * @param[in] offset The offset $o$.
+         */
+        Dequantization (const double scale = 1.,
+                        const double offset = 0.);
+
+        /**
+         * Constructor for the case where each component has its own scale
+         * and offset.
+         *
+         * @param[in] scales The scales $s_j$.
+         * @param[in] offsets The offsets $o_j$. This vector needs to have
+         *   the same size as `scales`, and both need to have as many
+         *   elements as the incoming samples have components.
+         */
+        Dequantization (const std::vector<double> &scales,
+                        const std::vector<double> &offsets);
+
+        /**
+         * Move constructor.
+         */
+        Dequantization (Dequantization &&) = default;
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Dequantization ();
+
+        /**
+         * Process one sample by converting each of its components as
+         * described in the documentation of this class.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   simply passes it on.
+         *
+         * @return The converted sample and the auxiliary data
+         *   originally associated with the sample.
+         */
+        virtual
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+      private:
+        /**
+         * The scale and the offset if they are the same for all
+         * components. Only used if the following vectors are empty.
+         */
+        double uniform_scale;
+        double uniform_offset;
+
+        /**
+         * The scales and the offsets for each component.
+         */
+        std::vector<double> scales;
+        std::vector<double> offsets;
+    };
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_floating_point_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Dequantization<InputType,OutputType>::
+    Dequantization (const double scale,
+                    const double offset)
+      :
+      uniform_scale (scale),
+      uniform_offset (offset)
+    {}
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_floating_point_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Dequantization<InputType,OutputType>::
+    Dequantization (const std::vector<double> &scales,
+                    const std::vector<double> &offsets)
+      :
+      uniform_scale (1.),
+      uniform_offset (0.),
+      scales (scales),
+      offsets (offsets)
+    {
+      assert (scales.size() > 0);
+      assert (scales.size() == offsets.size());
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_floating_point_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Dequantization<InputType,OutputType>::
+    ~Dequantization ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_floating_point_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    std::optional<std::pair<OutputType, AuxiliaryData> >
+    Dequantization<InputType,OutputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      using input_scalar  = types::ScalarType<InputType>;
+      using output_scalar = types::ScalarType<OutputType>;
+
+      const std::size_t size = Utilities::size(sample);
+      assert ((scales.size() == 0) || (scales.size() == size));
+
+      OutputType converted_sample;
+      if constexpr (requires (OutputType &x, const std::size_t n)
+      {
+        x.resize(n);
+      })
+      converted_sample.resize (size);
+      assert (Utilities::size(converted_sample) == size);
+
+      // As in the Quantization class, do the conversion with the given
+      // functions for the scales and offsets, on the underlying arrays if
+      // possible:
+      const auto convert = [&](const auto &scale, const auto &offset)
+      {
+        if constexpr (Concepts::has_contiguous_storage<InputType,input_scalar>
+                      &&
+                      Concepts::has_contiguous_storage<OutputType,output_scalar>)
+          {
+            const input_scalar *const y = std::ranges::data(std::as_const(sample));
+            output_scalar *const      x = std::ranges::data(converted_sample);
+            for (std::size_t j=0; j<size; ++j)
+              x[j] = static_cast<output_scalar>(offset(j) + scale(j) * y[j]);
+          }
+        else
+          for (std::size_t j=0; j<size; ++j)
+            converted_sample[j]
+              = static_cast<output_scalar>(offset(j)
+                                           + scale(j) * Utilities::get_nth_element (sample, j));
+      };
+
+      if (scales.size() == 0)
+        convert ([this](const std::size_t)
+      {
+        return uniform_scale;
+      },
+      [this](const std::size_t)
+      {
+        return uniform_offset;
+      });
+      else
+        convert ([this](const std::size_t j)
+      {
+        return scales[j];
+      },
+      [this](const std::size_t j)
+      {
+        return offsets[j];
+      });
+
+      return {{ std::move(converted_sample), std::move(aux_data)}};
+    }
+  }
+}
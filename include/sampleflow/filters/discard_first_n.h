@@ -19,7 +19,8 @@
 #include <sampleflow/filter.h>
 #include <sampleflow/types.h>
 
-#include <mutex>
+#include <algorithm>
+#include <atomic>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/filters/discard_first_n.impl.h>
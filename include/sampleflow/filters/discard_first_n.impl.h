@@ -24,12 +24,23 @@ namespace SampleFlow
      * that the samples are not a reliable reflection of the underlying
      * probability distribution
      *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive copies
+     * of the sample as this entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples),
+     * and this class counts all of these copies. If only some of them are
+     * to be discarded, then the sample is passed on with the repetition
+     * count reduced by the number of discarded copies.
+     *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * filter() member function can be called concurrently and from multiple
-     * threads.
+     * threads. The number of samples seen is kept in an atomic counter,
+     * and so concurrent calls do not have to wait for each other. Once the
+     * first $n$ samples have been discarded, the counter is no longer
+     * updated, and the filter simply passes on all samples.
      *
      *
      * @tparam InputType The C++ type used to describe the incoming samples.
@@ -42,6 +53,12 @@ namespace SampleFlow
     class DiscardFirstN : public Filter<InputType, InputType>
     {
       public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
         /**
          * Constructor.
          *
@@ -50,6 +67,12 @@ namespace SampleFlow
          */
         DiscardFirstN (const types::sample_index initial_n_samples);
 
+        /**
+         * Move constructor. The moved-from object must not be connected to
+         * any producer.
+         */
+        DiscardFirstN (DiscardFirstN &&o);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -78,17 +101,36 @@ namespace SampleFlow
         filter (InputType sample,
                 AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::repetition_count.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument: All but those that
+         * are still part of the initial $n$. See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * A counter counting how many samples we have seen so far, up to
+         * the point where all of the initial samples have been discarded.
          */
-        std::mutex mutex;
+        std::atomic<types::sample_index> counter;
 
         /**
-         * A counter counting how many samples we have seen so far.
+         * Whether all of the first $n$ samples have been seen, so that
+         * every sample from now on is passed on.
          */
-        types::sample_index counter;
+        std::atomic<bool> burn_in_is_over;
 
         /**
          * The variable storing how many samples to discard initially.
@@ -102,11 +144,23 @@ namespace SampleFlow
     DiscardFirstN<InputType>::
     DiscardFirstN (const types::sample_index initial_n_samples)
       : counter (0),
+        burn_in_is_over (initial_n_samples == 0),
         initial_n_samples (initial_n_samples)
     {}
 
 
 
+    template <typename InputType>
+    DiscardFirstN<InputType>::
+    DiscardFirstN (DiscardFirstN &&o)
+      : Filter<InputType, InputType> (std::move(o)),
+        counter (o.counter.load()),
+        burn_in_is_over (o.burn_in_is_over.load()),
+        initial_n_samples (o.initial_n_samples)
+    {}
+
+
+
     template <typename InputType>
     DiscardFirstN<InputType>::
     ~DiscardFirstN ()
@@ -121,16 +175,64 @@ namespace SampleFlow
     filter (InputType sample,
             AuxiliaryData aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
-
-      ++counter;
-      if (counter > initial_n_samples)
+      if (burn_in_is_over.load (std::memory_order_relaxed))
+        return {{ std::move(sample), std::move(aux_data)}};
+
+      // Reserve the positions of the copies of the current sample in the
+      // stream of samples. Whoever reserves the position that ends the
+      // burn-in period also switches to pass-through mode:
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const types::sample_index first
+        = counter.fetch_add (n_repetitions, std::memory_order_relaxed);
+      const types::sample_index n_discarded
+        = (first < initial_n_samples ?
+           std::min (n_repetitions, initial_n_samples - first) :
+           0);
+      if (first + n_repetitions >= initial_n_samples)
+        burn_in_is_over.store (true, std::memory_order_relaxed);
+
+      if (n_discarded < n_repetitions)
         {
+          if (n_discarded > 0)
+            aux_data[AuxiliaryData::repetition_count] = std::size_t(n_repetitions - n_discarded);
           return {{ std::move(sample), std::move(aux_data)}};
         }
       else
         return {};
     }
 
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    DiscardFirstN<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    DiscardFirstN<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = input_shape;
+      if (shape.n_samples.has_value())
+        {
+          const types::sample_index n_seen
+            = std::min (counter.load (std::memory_order_relaxed), initial_n_samples);
+          const types::sample_index n_to_discard = initial_n_samples - n_seen;
+          shape.n_samples = (*shape.n_samples > n_to_discard ?
+                             *shape.n_samples - n_to_discard :
+                             0);
+        }
+      return shape;
+    }
+
   }
 }
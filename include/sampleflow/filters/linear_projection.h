@@ -0,0 +1,38 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_FILTERS_LINEAR_PROJECTION_H
+#define SAMPLEFLOW_FILTERS_LINEAR_PROJECTION_H
+
+#include <sampleflow/consumer.h>
+#include <sampleflow/producer.h>
+#include <sampleflow/concepts.h>
+#include <sampleflow/element_access.h>
+
+#include <cassert>
+#include <concepts>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/filters/linear_projection.impl.h>
+
+#endif
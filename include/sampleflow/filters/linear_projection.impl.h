@@ -0,0 +1,335 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A class that applies a linear operator $P$ to each sample $x_k$ it
+     * receives and passes on the result $y_k=Px_k$. The typical use case is
+     * reducing high-dimensional samples -- say, the $10^5$ coefficients of
+     * a discretized parameter field -- to their components in a few hundred
+     * principal directions, or to a few hundred observations, before
+     * computing statistics such as covariance matrices whose cost grows
+     * with the square of the dimension. The operator is an Eigen matrix
+     * with as many columns as the samples have components, and may be a
+     * dense matrix (the default, `Eigen::MatrixXd`) or a sparse one
+     * (say, `Eigen::SparseMatrix<double>`).
+     *
+     * One could of course do the same with a Conversion filter whose
+     * conversion function multiplies each sample by the matrix. The
+     * difference is what happens if the producer upstream sends samples in
+     * batches (see Producer::issue_batch()): The current class then copies
+     * the samples of the batch into the columns of a matrix $X$ and
+     * computes all of the $y_k$ at once as the columns of $PX$. This
+     * matrix-matrix product is substantially faster than the same number of
+     * matrix-vector products since it can make better use of the
+     * processor's caches, and the results are sent downstream as one batch
+     * as well. Individually sent samples are multiplied by $P$ one at a
+     * time; if their elements are stored contiguously (see
+     * Concepts::has_contiguous_storage), this happens without copying them.
+     *
+     * The class is not derived from Filter since that class processes
+     * batches one sample at a time. Rather, it is both a Consumer and a
+     * Producer, and behaves like a filter otherwise: In particular,
+     * calling flush() on an object of this class also flushes the
+     * consumers connected to it.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The operator is not modified after the object has been created,
+     * and so the consume() and consume_batch() functions can be called
+     * concurrently and from multiple threads without any locking. The
+     * results are sent downstream on the thread that sent the sample.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   The number of elements of each sample must equal the number of
+     *   columns of the operator.
+     * @tparam OutputType The C++ type used to describe the outgoing samples.
+     *   This needs to be an Eigen column vector type. Using a vector type
+     *   whose size is fixed at compile time (say,
+     *   `Eigen::Matrix<double,3,1>` for projections to three directions)
+     *   avoids allocating memory for each outgoing sample; in that case, the
+     *   number of rows of the operator must equal this size.
+     * @tparam OperatorType The type of the operator $P$.
+     */
+    template <typename InputType,
+              typename OutputType = Eigen::VectorXd,
+              typename OperatorType = Eigen::MatrixXd>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    class LinearProjection : public Consumer<InputType>, public Producer<OutputType>
+    {
+      public:
+        /**
+         * The type of the elements of the operator, and of the vectors
+         * and matrices the operator is applied to.
+         */
+        using scalar_type = typename OperatorType::Scalar;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] projection The operator $P$ to be applied to each
+         *   sample. The object keeps a copy of it.
+         */
+        LinearProjection (const OperatorType &projection);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~LinearProjection ();
+
+        /**
+         * Process one sample by applying the operator to it and sending
+         * the result downstream.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   simply passes it on.
+         */
+        virtual
+        void
+        consume (InputType sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples by applying the operator to all of
+         * them with one matrix-matrix product, and send the results
+         * downstream as one batch.
+         *
+         * @param[in] samples The samples to process.
+         * @param[in] aux_data A vector of the same length as `samples` with the
+         *   auxiliary data for each sample. It is passed on unchanged.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Wait for all samples currently being processed, and then flush
+         * the consumers connected to this object. See Filter::flush().
+         */
+        virtual
+        void
+        flush () override;
+
+        /**
+         * Add this object and everything downstream of it to the given
+         * graph. See Filter::add_to_graph().
+         */
+        virtual
+        void
+        add_to_graph (PipelineGraph::Graph &graph) const override;
+
+        /**
+         * Pass the announcement of the samples this object is about to
+         * receive on to the objects connected to it, with the number of
+         * components replaced by the number of rows of the operator. See
+         * Filter::receive_announcement().
+         */
+        virtual
+        void
+        receive_announcement (const SampleShape &shape) override;
+
+        /**
+         * Return the operator used by this object.
+         */
+        const OperatorType &
+        get_projection () const;
+
+      private:
+        /**
+         * The operator.
+         */
+        const OperatorType projection;
+    };
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    LinearProjection<InputType,OutputType,OperatorType>::
+    LinearProjection (const OperatorType &projection)
+      :
+      projection (projection)
+    {
+      assert ((OutputType::RowsAtCompileTime == Eigen::Dynamic)
+              ||
+              (OutputType::RowsAtCompileTime == projection.rows()));
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    LinearProjection<InputType,OutputType,OperatorType>::
+    ~LinearProjection ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    void
+    LinearProjection<InputType,OutputType,OperatorType>::
+    consume (InputType sample,
+             AuxiliaryData aux_data)
+    {
+      using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+
+      const std::size_t size = Utilities::size(sample);
+      assert (size == static_cast<std::size_t>(projection.cols()));
+
+      OutputType projected_sample;
+      if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+        projected_sample
+          = projection * Eigen::Map<const vector_type> (std::ranges::data(std::as_const(sample)),
+                                                        size);
+      else
+        {
+          vector_type x (size);
+          for (std::size_t j=0; j<size; ++j)
+            x(j) = Utilities::get_nth_element (sample, j);
+          projected_sample = projection * x;
+        }
+
+      this->issue_sample (std::move(projected_sample), std::move(aux_data));
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    void
+    LinearProjection<InputType,OutputType,OperatorType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+      using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+      assert (samples.size() == aux_data.size());
+      if (samples.size() == 0)
+        return;
+
+      // Copy the samples into the columns of a matrix, apply the operator
+      // to all of them at once, and then split up the result again:
+      const std::size_t size = projection.cols();
+      matrix_type X (size, samples.size());
+      for (std::size_t b=0; b<samples.size(); ++b)
+        {
+          assert (Utilities::size(samples[b]) == size);
+          if constexpr (Concepts::has_contiguous_storage<InputType,scalar_type>)
+            X.col(b) = Eigen::Map<const vector_type> (std::ranges::data(samples[b]), size);
+          else
+            for (std::size_t j=0; j<size; ++j)
+              X(j,b) = Utilities::get_nth_element (samples[b], j);
+        }
+
+      const matrix_type Y = projection * X;
+
+      std::vector<OutputType> projected_samples (samples.size());
+      for (std::size_t b=0; b<samples.size(); ++b)
+        projected_samples[b] = Y.col(b);
+
+      this->issue_batch (projected_samples, aux_data);
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    void
+    LinearProjection<InputType,OutputType,OperatorType>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+      this->flush_consumers();
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    void
+    LinearProjection<InputType,OutputType,OperatorType>::
+    add_to_graph (PipelineGraph::Graph &graph) const
+    {
+      if (graph.contains (this->graph_node_id()))
+        return;
+
+      Consumer<InputType>::add_to_graph (graph);
+      graph.nodes.back().kind = PipelineGraph::NodeKind::filter;
+
+      this->add_downstream_nodes_to_graph (graph);
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    void
+    LinearProjection<InputType,OutputType,OperatorType>::
+    receive_announcement (const SampleShape &shape)
+    {
+      Consumer<InputType>::receive_announcement (shape);
+      this->announce_samples (SampleShape
+      {
+        static_cast<std::size_t>(projection.rows()),
+        shape.n_samples
+      });
+    }
+
+
+
+    template <typename InputType, typename OutputType, typename OperatorType>
+    requires (std::derived_from<OutputType, Eigen::MatrixBase<OutputType>>
+              &&
+              (OutputType::ColsAtCompileTime == 1))
+    const OperatorType &
+    LinearProjection<InputType,OutputType,OperatorType>::
+    get_projection () const
+    {
+      return projection;
+    }
+  }
+}
@@ -0,0 +1,142 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A filter that moves each sample it receives into an object managed
+     * by a `std::shared_ptr`, and passes this handle downstream.
+     *
+     * The main use of this class is as a "broadcast" node for samples of a
+     * type that can be moved but not copied (see
+     * Concepts::is_valid_sampletype): A producer of such samples can only
+     * send them to a single consumer, since sending a sample to several
+     * consumers requires copies. If the current filter is that one
+     * consumer, then any number of consumers can be connected to it, and
+     * each of them receives a handle to the same, shared object -- at the
+     * cost of incrementing and decrementing a reference count rather than
+     * copying the sample. The same is true for sample types that can be
+     * copied, but for which copying is expensive.
+     *
+     * Consumers connected to this filter receive samples of type
+     * `std::shared_ptr<const InputType>`. Since they can not modify the
+     * sample pointed to, it does not matter whether they process samples
+     * right away or at a later time (see ParallelMode).
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     */
+    template <typename InputType>
+    class MakeShared : public Filter<InputType, std::shared_ptr<const InputType>>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MakeShared ();
+
+        /**
+         * Default constructor.
+         */
+        MakeShared () = default;
+
+        /**
+         * Move constructor.
+         */
+        MakeShared (MakeShared &&) = default;
+
+        /**
+         * Process one sample by moving it into a newly created object
+         * managed by a `std::shared_ptr`.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   simply passes it on.
+         *
+         * @return A pointer to the sample and the auxiliary data originally
+         *   associated with the sample.
+         */
+        virtual
+        std::optional<std::pair<std::shared_ptr<const InputType>, SampleFlow::AuxiliaryData> >
+        filter (InputType sample,
+                SampleFlow::AuxiliaryData aux_data) override;
+
+        /**
+         * Return an empty list, since this class passes the auxiliary data
+         * of samples on without looking at it. See
+         * Consumer::used_aux_data_keys() and Filter::requests_aux_data().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+    };
+
+
+
+    template <typename InputType>
+    MakeShared<InputType>::
+    ~MakeShared ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<std::shared_ptr<const InputType>, SampleFlow::AuxiliaryData>>
+    MakeShared<InputType>::
+    filter (InputType sample,
+            SampleFlow::AuxiliaryData aux_data)
+    {
+      return {{ std::make_shared<const InputType> (std::move(sample)), std::move(aux_data) }};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    MakeShared<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
+    }
+  }
+}
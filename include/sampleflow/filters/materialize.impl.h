@@ -0,0 +1,166 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A filter that converts samples whose type does not own its elements
+     * -- such as `std::span<const double>` or
+     * `Eigen::Map<const Eigen::VectorXd>`, see Concepts::is_sample_view --
+     * into samples of a type that stores a copy of the elements, namely
+     * `std::vector<double>` or `Eigen::VectorXd` in these examples (see
+     * Utilities::materialize() and types::MaterializedType).
+     *
+     * Producers that create their samples in a buffer they reuse can send
+     * views of this buffer downstream, which avoids copying samples for all
+     * those consumers that only look at a sample while their consume()
+     * function runs (for example Consumers::MeanValue or
+     * Consumers::Action). Consumers that need to keep samples around --
+     * such as Consumers::LastSample, Consumers::ReservoirSample, or
+     * Consumers::MaximumProbabilitySample -- can not accept view types,
+     * and need to be connected to an object of the current type instead,
+     * which makes a copy exactly at the point where one is needed.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   The type of the outgoing samples is types::MaterializedType of this
+     *   type, which is `InputType` itself if it is not a view type.
+     */
+    template <typename InputType>
+    class Materialize : public Filter<InputType, types::MaterializedType<InputType>>
+    {
+      public:
+        /**
+         * The type of the samples this filter sends downstream.
+         */
+        using OutputType = types::MaterializedType<InputType>;
+
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Materialize ();
+
+        /**
+         * Default constructor.
+         */
+        Materialize () = default;
+
+        /**
+         * Move constructor.
+         */
+        Materialize (Materialize &&) = default;
+
+        /**
+         * Process one sample by copying its elements into an object of type
+         * `OutputType`.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   simply passes it on.
+         *
+         * @return The copy of the input sample and the auxiliary data
+         *   originally associated with the sample.
+         */
+        virtual
+        std::optional<std::pair<OutputType, SampleFlow::AuxiliaryData> >
+        filter (InputType sample,
+                SampleFlow::AuxiliaryData aux_data) override;
+
+        /**
+         * Return the description of the incoming samples, since copying a
+         * sample does not change the number of its components. See
+         * Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return an empty list, since this class passes the auxiliary data
+         * of samples on without looking at it. See
+         * Consumer::used_aux_data_keys() and Filter::requests_aux_data().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+    };
+
+
+
+    template <typename InputType>
+    Materialize<InputType>::
+    ~Materialize ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<typename Materialize<InputType>::OutputType, SampleFlow::AuxiliaryData>>
+    Materialize<InputType>::
+    filter (InputType sample,
+            SampleFlow::AuxiliaryData aux_data)
+    {
+      return {{ Utilities::materialize (std::move(sample)), std::move(aux_data) }};
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    Materialize<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      return input_shape;
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    Materialize<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
+    }
+  }
+}
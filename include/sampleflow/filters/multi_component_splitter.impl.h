@@ -0,0 +1,298 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A class that splits each vector-valued sample it receives into
+     * several of its components and passes each of these components on,
+     * as a sample in its own right, through a separate output. This is
+     * the same as connecting several ComponentSplitter objects to the same
+     * producer, one for each component of interest, but considerably
+     * cheaper if many components are needed: Each ComponentSplitter object
+     * receives a copy of the whole sample (see Producer::issue_sample()),
+     * and so extracting all $d$ components of a sample with $d$ objects of
+     * that class costs $d-1$ copies of the sample plus $d$ calls through
+     * signals, whereas the current class receives the sample only once
+     * and extracts all selected components from it in one pass.
+     *
+     * The class is not a Filter since it does not have a single output.
+     * Rather, it is a Consumer, and the output for each selected component
+     * is a Producer object that can be obtained via the output() function:
+     * @code
+     *   SampleFlow::Filters::MultiComponentSplitter<SampleType> splitter (d);
+     *   splitter.connect_to_producer (sampler);
+     *
+     *   std::vector<std::unique_ptr<SampleFlow::Consumers::Histogram<double>>> histograms;
+     *   for (unsigned int i=0; i<d; ++i)
+     *     {
+     *       histograms.emplace_back (std::make_unique<SampleFlow::Consumers::Histogram<double>>(-3, 3, 100));
+     *       histograms.back()->connect_to_producer (splitter.output(i));
+     *     }
+     * @endcode
+     * Calling flush() on an object of this class flushes the consumers
+     * connected to all of its outputs, as for a Filter.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * consume() member function can be called concurrently and from multiple
+     * threads. As for other filters, the components of each sample are
+     * sent downstream on the thread that calls consume(), one output
+     * after the other.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   The same requirements apply as for the ComponentSplitter class, and
+     *   the output type of each output is `typename InputType::value_type`.
+     */
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    class MultiComponentSplitter : public Consumer<InputType>
+    {
+      public:
+        /**
+         * The type that describes the output type for this filter.
+         */
+        using OutputType = typename InputType::value_type;
+
+        /**
+         * Constructor. Create an object that passes on all of the first
+         * `n_components` components of each sample, with component $i$
+         * being sent to `output(i)`.
+         */
+        MultiComponentSplitter (const unsigned int n_components);
+
+        /**
+         * Constructor. Create an object that passes on the given
+         * components of each sample, with component
+         * `selected_components[i]` being sent to `output(i)`.
+         */
+        MultiComponentSplitter (const std::vector<unsigned int> &selected_components);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~MultiComponentSplitter ();
+
+        /**
+         * Return the number of outputs of this object, i.e., the number of
+         * components selected.
+         */
+        unsigned int
+        n_outputs () const;
+
+        /**
+         * Return the producer through which the `i`th selected component
+         * of each sample is sent downstream.
+         */
+        Producer<OutputType> &
+        output (const unsigned int i);
+
+        /**
+         * Process one sample by extracting the selected components and
+         * sending each of them downstream through its output.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   passes it on along with each of the components.
+         */
+        virtual
+        void
+        consume (InputType sample,
+                 AuxiliaryData aux_data) override;
+
+        /**
+         * Process a batch of samples by extracting the selected components
+         * of all of them, and sending the resulting batch of each component
+         * downstream through its output.
+         */
+        virtual
+        void
+        consume_batch (const std::vector<InputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data) override;
+
+        /**
+         * Finish processing all samples received so far, and then flush
+         * the consumers connected to all outputs. See Filter::flush().
+         */
+        virtual
+        void
+        flush () override;
+
+      private:
+        /**
+         * A class whose only purpose is to give access to the
+         * Producer::issue_sample() function and the other protected members
+         * of a Producer for the outputs of this object.
+         */
+        class Output : public Producer<OutputType>
+        {
+            friend class MultiComponentSplitter;
+        };
+
+        /**
+         * The selected components of samples to be extracted.
+         */
+        const std::vector<unsigned int> selected_components;
+
+        /**
+         * The outputs for each of the selected components. Since Producer
+         * objects cannot be copied and are referenced by the consumers
+         * connected to them, they are stored by pointer.
+         */
+        std::vector<std::unique_ptr<Output>> outputs;
+    };
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    MultiComponentSplitter<InputType>::
+    MultiComponentSplitter (const unsigned int n_components)
+      : MultiComponentSplitter ([n_components]()
+    {
+      std::vector<unsigned int> all_components (n_components);
+      for (unsigned int i=0; i<n_components; ++i)
+        all_components[i] = i;
+      return all_components;
+    }())
+    {}
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    MultiComponentSplitter<InputType>::
+    MultiComponentSplitter (const std::vector<unsigned int> &selected_components)
+      : selected_components (selected_components)
+    {
+      outputs.reserve (selected_components.size());
+      for (unsigned int i=0; i<selected_components.size(); ++i)
+        outputs.emplace_back (std::make_unique<Output>());
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    MultiComponentSplitter<InputType>::
+    ~MultiComponentSplitter ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    unsigned int
+    MultiComponentSplitter<InputType>::
+    n_outputs () const
+    {
+      return outputs.size();
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    Producer<typename MultiComponentSplitter<InputType>::OutputType> &
+    MultiComponentSplitter<InputType>::
+    output (const unsigned int i)
+    {
+      assert (i < outputs.size());
+      return *outputs[i];
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    void
+    MultiComponentSplitter<InputType>::
+    consume (InputType sample,
+             AuxiliaryData aux_data)
+    {
+      // Each output needs its own copy of the auxiliary data, except for
+      // the last one, which can have the original:
+      for (unsigned int i=0; i<outputs.size(); ++i)
+        {
+          assert (selected_components[i] < sample.size());
+          if (i+1 < outputs.size())
+            outputs[i]->issue_sample (sample[selected_components[i]], aux_data);
+          else
+            outputs[i]->issue_sample (std::move(sample[selected_components[i]]),
+                                      std::move(aux_data));
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    void
+    MultiComponentSplitter<InputType>::
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      // All outputs can share the auxiliary data of the incoming batch,
+      // since the issue_batch signal passes it by reference:
+      std::vector<OutputType> components (samples.size());
+      for (unsigned int i=0; i<outputs.size(); ++i)
+        {
+          for (std::size_t s=0; s<samples.size(); ++s)
+            {
+              assert (selected_components[i] < samples[s].size());
+              components[s] = samples[s][selected_components[i]];
+            }
+          outputs[i]->issue_batch (components, aux_data);
+        }
+    }
+
+
+
+    template <typename InputType>
+    requires (Concepts::has_subscript_operator<InputType> &&
+              Concepts::has_value_type<InputType>)
+    void
+    MultiComponentSplitter<InputType>::
+    flush ()
+    {
+      Consumer<InputType>::flush();
+
+      for (const auto &output : outputs)
+        output->flush_consumers();
+    }
+  }
+}
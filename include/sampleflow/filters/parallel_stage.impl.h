@@ -0,0 +1,355 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A filter that wraps around another, stateless filter and runs that
+     * filter's work for several samples concurrently on the worker threads
+     * of a ThreadPool, while still sending the results downstream in the
+     * order in which the samples arrived. This is useful if the wrapped
+     * filter is expensive -- say, a Conversion object that runs a forward
+     * model to compute a quantity of interest for each sample -- and the
+     * consumers downstream depend on the order of samples: Unlike the
+     * PipelineStage class, which moves the work of a filter to one other
+     * thread, this class can keep as many processor cores busy as the
+     * thread pool has worker threads.
+     *
+     * Running the filter() function of the wrapped filter concurrently for
+     * different samples is only correct if that function does not depend
+     * on anything but the sample it is given. Filters declare this through
+     * the Concepts::is_stateless_filter concept, and the constructor of this
+     * class only accepts such filters. Conversion and Condition objects
+     * are stateless in this sense, provided the function objects given to
+     * them are; TakeEveryNth, on the other hand, is not since whether it
+     * passes on a sample depends on how many samples came before.
+     *
+     * In practice, one would use this class as follows:
+     * @code
+     *   SampleFlow::Filters::ParallelStage<SampleType,double>
+     *     qoi (SampleFlow::Filters::Conversion<SampleType,double>
+     *            ([](const SampleType &x) { return expensive_qoi(x); }),
+     *          32);
+     *   qoi.connect_to_producer (sampler);
+     *
+     *   SampleFlow::Consumers::AutoCovarianceTrace<double> autocovariance (100);
+     *   autocovariance.connect_to_producer (qoi);
+     * @endcode
+     *
+     *
+     * ### Implementation ###
+     *
+     * Each incoming sample is given a sequence number, and a task that
+     * calls the wrapped filter's filter() function for the sample is
+     * enqueued with the thread pool. When a task finishes, it stores its
+     * result in a "reorder buffer" at the position that corresponds to
+     * its sequence number. Whichever task finds the result at the front of
+     * the buffer available then sends it and all available results that
+     * immediately follow downstream; only one thread does so at any given
+     * time, so that downstream consumers receive the samples in order --
+     * and not concurrently, as long as this object is the only producer
+     * they are connected to.
+     *
+     * The number of samples that have arrived but whose result has not yet
+     * been sent downstream is limited to the `queue_size` argument of the
+     * constructor; this bounds both the memory used by the reorder buffer
+     * and the number of samples processed concurrently. If the limit is
+     * reached, the thread sending a new sample waits until the result of
+     * the oldest sample has been sent on. It is useful for the limit to be
+     * a small multiple of the number of worker threads of the pool, so
+     * that the workers remain busy even if processing some samples takes
+     * longer than others.
+     *
+     * The object itself runs in ParallelMode::synchronous: The work of
+     * calling filter() on the thread that sends a sample consists of
+     * nothing more than enqueueing a task.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     * @tparam OutputType The C++ type used to describe the outgoing samples.
+     */
+    template <typename InputType, typename OutputType>
+    class ParallelStage : public Filter<InputType, OutputType>
+    {
+      public:
+        /**
+         * Constructor.
+         *
+         * @param[in] filter The filter whose work this object is to do. The
+         *   object is moved into an object owned by this class, and must be
+         *   of a type that satisfies the Concepts::is_stateless_filter
+         *   concept.
+         * @param[in] queue_size The maximal number of samples that can have
+         *   arrived at this object without their results having been sent
+         *   downstream yet. Must be at least one.
+         * @param[in] thread_pool The thread pool on whose worker threads
+         *   the wrapped filter is to be run. If this is a `nullptr` (the
+         *   default), then the pool returned by ThreadPool::default_pool()
+         *   is used.
+         */
+        template <typename FilterType>
+        requires (Concepts::is_stateless_filter<FilterType>
+                  &&
+                  std::derived_from<FilterType, Filter<InputType,OutputType>>)
+        ParallelStage (FilterType &&filter,
+                       const unsigned int queue_size,
+                       const std::shared_ptr<ThreadPool> &thread_pool = nullptr);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed and their
+         * results sent downstream. To this end, it calls the
+         * Consumers::disconnect_and_flush() function of the base class.
+         */
+        virtual ~ParallelStage ();
+
+        /**
+         * Process one sample by giving it a sequence number and enqueueing
+         * a task that calls the wrapped filter for it. The result is sent
+         * downstream once the results for all previous samples have been.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         *
+         * @return An empty object, since the results of the wrapped filter
+         *   are sent downstream by the tasks that compute them.
+         */
+        virtual
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. This is what the wrapped
+         * filter reports.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Wait for all samples currently being processed, send their
+         * results downstream, and then flush the consumers connected to
+         * this filter. See Filter::flush().
+         */
+        virtual
+        void
+        flush () override;
+
+      private:
+        /**
+         * An entry of the reorder buffer: Whether the result for the
+         * corresponding sample is available, and what it is. The result
+         * may be empty if the wrapped filter did not produce a sample.
+         */
+        struct Slot
+        {
+          bool                                                 finished = false;
+          std::optional<std::pair<OutputType, AuxiliaryData> > result;
+        };
+
+        /**
+         * The wrapped filter, the maximal number of samples in flight, and
+         * the thread pool used to process them.
+         */
+        const std::unique_ptr<Filter<InputType,OutputType>> stage_filter;
+        const unsigned int                                  queue_size;
+        const std::shared_ptr<ThreadPool>                   thread_pool;
+
+        /**
+         * A mutex that protects the reorder buffer and sequence numbers,
+         * and a condition variable that threads wait on if the reorder
+         * buffer is full.
+         */
+        std::mutex              mutex;
+        std::condition_variable slot_available;
+
+        /**
+         * The reorder buffer. Its first element corresponds to the sample
+         * with sequence number `next_to_issue`, and it has one element
+         * for each sample that has arrived but whose result has not been
+         * sent downstream yet.
+         */
+        std::deque<Slot>    reorder_buffer;
+        types::sample_index next_to_issue;
+
+        /**
+         * Whether one thread is currently sending results from the front of
+         * the reorder buffer downstream.
+         */
+        bool issuing;
+
+        /**
+         * The tasks processing samples that have been enqueued with the
+         * thread pool.
+         */
+        ThreadPool::TaskGroup background_tasks;
+
+        /**
+         * Store the result for the sample with the given sequence number in
+         * the reorder buffer, and if it is at the front of the buffer, send
+         * it and all following available results downstream.
+         */
+        void
+        finish_sample (const types::sample_index sequence_number,
+                       std::optional<std::pair<OutputType, AuxiliaryData> > &&result);
+    };
+
+
+
+    template <typename InputType, typename OutputType>
+    template <typename FilterType>
+    requires (Concepts::is_stateless_filter<FilterType>
+              &&
+              std::derived_from<FilterType, Filter<InputType,OutputType>>)
+    ParallelStage<InputType,OutputType>::
+    ParallelStage (FilterType &&filter,
+                   const unsigned int queue_size,
+                   const std::shared_ptr<ThreadPool> &thread_pool)
+      :
+      stage_filter (std::make_unique<FilterType>(std::move(filter))),
+      queue_size (queue_size),
+      thread_pool (thread_pool != nullptr ? thread_pool : ThreadPool::default_pool()),
+      next_to_issue (0),
+      issuing (false)
+    {
+      assert (queue_size >= 1);
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    ParallelStage<InputType,OutputType>::
+    ~ParallelStage ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    std::optional<std::pair<OutputType, AuxiliaryData> >
+    ParallelStage<InputType,OutputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      // Reserve a slot in the reorder buffer. If there is none, we have to
+      // wait. On a worker thread of a thread pool, we must not go to sleep
+      // since the tasks that would make space may be waiting for
+      // exactly this thread, so help with other tasks instead.
+      types::sample_index sequence_number;
+      {
+        std::unique_lock<std::mutex> lock (mutex);
+        if (ThreadPool *const pool = ThreadPool::current_pool())
+          while (reorder_buffer.size() >= queue_size)
+            {
+              lock.unlock();
+              if (pool->run_pending_task() == false)
+                std::this_thread::yield();
+              lock.lock();
+            }
+        else
+          slot_available.wait (lock, [this]()
+          {
+            return (reorder_buffer.size() < queue_size);
+          });
+
+        sequence_number = next_to_issue + reorder_buffer.size();
+        reorder_buffer.emplace_back ();
+      }
+
+      background_tasks.run (*thread_pool,
+                            [this, sequence_number,
+                             sample = std::move(sample),
+                             aux_data = std::move(aux_data)]() mutable
+      {
+        finish_sample (sequence_number,
+                       stage_filter->filter (std::move(sample), std::move(aux_data)));
+      });
+
+      return {};
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    void
+    ParallelStage<InputType,OutputType>::
+    finish_sample (const types::sample_index sequence_number,
+                   std::optional<std::pair<OutputType, AuxiliaryData> > &&result)
+    {
+      std::unique_lock<std::mutex> lock (mutex);
+
+      Slot &slot = reorder_buffer[sequence_number - next_to_issue];
+      slot.finished = true;
+      slot.result   = std::move(result);
+
+      // If another thread is already sending results downstream, then
+      // it will also pick up ours when it gets to it.
+      if (issuing == true)
+        return;
+
+      issuing = true;
+      while ((reorder_buffer.size() > 0) && reorder_buffer.front().finished)
+        {
+          std::optional<std::pair<OutputType, AuxiliaryData> > front_result
+            = std::move(reorder_buffer.front().result);
+          reorder_buffer.pop_front();
+          ++next_to_issue;
+
+          lock.unlock();
+          slot_available.notify_one();
+          if (front_result)
+            this->issue_sample (std::move(front_result->first),
+                                std::move(front_result->second));
+          lock.lock();
+        }
+      issuing = false;
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    void
+    ParallelStage<InputType,OutputType>::
+    flush ()
+    {
+      // Make sure that all samples that are currently arriving have been
+      // handed to the thread pool, then wait for the thread pool to have
+      // processed them. Each task sends its result downstream (or hands
+      // that task to a thread that is already doing so), and so when all
+      // tasks are done, all results have been sent on.
+      Consumer<InputType>::flush();
+      background_tasks.wait();
+
+      this->flush_consumers();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    SampleShape
+    ParallelStage<InputType,OutputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      return stage_filter->output_shape (input_shape);
+    }
+  }
+}
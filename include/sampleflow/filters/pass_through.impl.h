@@ -52,6 +52,18 @@ namespace SampleFlow
     class PassThrough : public Filter<InputType, InputType>
     {
       public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -85,6 +97,15 @@ namespace SampleFlow
         std::optional<std::pair<InputType, SampleFlow::AuxiliaryData> >
         filter (InputType sample,
                 SampleFlow::AuxiliaryData aux_data) override;
+
+        /**
+         * Return an empty list, since this class passes the auxiliary data
+         * of samples on without looking at it. See
+         * Consumer::used_aux_data_keys() and Filter::requests_aux_data().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
     };
 
 
@@ -104,7 +125,17 @@ namespace SampleFlow
                                                                 filter (InputType sample,
                                                                         SampleFlow::AuxiliaryData aux_data)
     {
-      return {{ sample, aux_data }};
+      return {{ std::move(sample), std::move(aux_data) }};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    PassThrough<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>();
     }
   }
 }
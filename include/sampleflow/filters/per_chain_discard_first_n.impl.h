@@ -0,0 +1,278 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A variant of the DiscardFirstN filter for producers that run several
+     * chains at once (such as
+     * Producers::DifferentialEvaluationMetropolisHastings), or for a filter
+     * that receives samples from several producers that each run one
+     * chain: It discards the first $n$ samples *of each chain*, as
+     * identified by the AuxiliaryData::chain_number entry of the auxiliary
+     * data of samples. Samples without such an entry are counted as part
+     * of chain zero.
+     *
+     * Burn-in needs to be discarded separately for each chain, since each
+     * chain starts from its own starting point. With DiscardFirstN, this
+     * requires one filter per chain, each connected to a filter (such as a
+     * Filters::Condition) that selects the samples of its chain, and all
+     * of these connected to each of the downstream consumers. The current
+     * class does the same in a single object.
+     *
+     * As with DiscardFirstN, a sample whose auxiliary data carries an entry
+     * with key AuxiliaryData::repetition_count stands for as many
+     * consecutive copies of the sample as this entry says, and if only some
+     * of these are to be discarded, then the sample is passed on with the
+     * repetition count reduced accordingly.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. The numbers of samples seen are kept in an array of atomic
+     * counters, one per chain, that is allocated by the constructor. No
+     * locks are involved, and since each counter occupies a cache line of
+     * its own, threads that work on different chains do not slow each
+     * other down. Once the first $n$ samples of a chain have been
+     * discarded, its counter is no longer updated.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   For the current class, this is of course also the type used for
+     *   the outgoing samples.
+     */
+    template <typename InputType>
+    class PerChainDiscardFirstN : public Filter<InputType, InputType>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] initial_n_samples The number of samples to discard at
+         *   the beginning of each chain.
+         * @param[in] n_chains The number of chains. The chain numbers of all
+         *   samples need to be less than this number.
+         */
+        PerChainDiscardFirstN (const types::sample_index initial_n_samples,
+                               const std::size_t         n_chains);
+
+        /**
+         * Move constructor. The moved-from object must not be connected to
+         * any producer.
+         */
+        PerChainDiscardFirstN (PerChainDiscardFirstN &&o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~PerChainDiscardFirstN ();
+
+        /**
+         * Process one sample by checking whether it is after the initial $n$
+         * samples of its chain and if so, pass it on to downstream
+         * consumers. If it isn't, return an empty object which the caller
+         * of this function in the base class will interpret as the
+         * instruction to discard the sample from further processing.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the chain number and repetition count, and passes
+         *   all of it on.
+         */
+        virtual
+        std::optional<std::pair<InputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since the number of
+         * samples discarded depends on the number of chains, the number of
+         * samples passed on is reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::chain_number and
+         * AuxiliaryData::repetition_count. See
+         * Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return how many samples of the given chain this object has seen,
+         * up to the point where the first $n$ have been discarded.
+         */
+        types::sample_index
+        n_samples_seen (const std::size_t chain) const;
+
+      private:
+        /**
+         * A counter for the samples of one chain, on a cache line of its
+         * own.
+         */
+        struct alignas(Memory::cache_line_size) ChainCounter
+        {
+          std::atomic<types::sample_index> value {0};
+        };
+
+        /**
+         * The variable storing how many samples to discard initially.
+         */
+        const types::sample_index initial_n_samples;
+
+        /**
+         * The number of chains.
+         */
+        const std::size_t n_chains;
+
+        /**
+         * One counter per chain, counting how many samples of the chain we
+         * have seen so far, up to the point where all of the initial
+         * samples of the chain have been discarded.
+         */
+        std::unique_ptr<ChainCounter[]> counters;
+    };
+
+
+
+    template <typename InputType>
+    PerChainDiscardFirstN<InputType>::
+    PerChainDiscardFirstN (const types::sample_index initial_n_samples,
+                           const std::size_t         n_chains)
+      : initial_n_samples (initial_n_samples),
+        n_chains (n_chains),
+        counters (std::make_unique<ChainCounter[]> (n_chains))
+    {
+      assert (n_chains > 0);
+    }
+
+
+
+    template <typename InputType>
+    PerChainDiscardFirstN<InputType>::
+    PerChainDiscardFirstN (PerChainDiscardFirstN &&o)
+      : Filter<InputType, InputType> (std::move(o)),
+        initial_n_samples (o.initial_n_samples),
+        n_chains (o.n_chains),
+        counters (std::move(o.counters))
+    {}
+
+
+
+    template <typename InputType>
+    PerChainDiscardFirstN<InputType>::
+    ~PerChainDiscardFirstN ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<InputType, AuxiliaryData> >
+    PerChainDiscardFirstN<InputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      const std::size_t *const chain_number
+        = aux_data.get_if<std::size_t> (AuxiliaryData::chain_number);
+      const std::size_t chain = (chain_number != nullptr ? *chain_number : 0);
+      assert (chain < n_chains);
+      std::atomic<types::sample_index> &counter = counters[chain].value;
+
+      // Once the burn-in period of the chain is over, there is no need to
+      // update the counter any more:
+      if (counter.load (std::memory_order_relaxed) >= initial_n_samples)
+        return {{ std::move(sample), std::move(aux_data)}};
+
+      // Otherwise, proceed as in DiscardFirstN:
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const types::sample_index first
+        = counter.fetch_add (n_repetitions, std::memory_order_relaxed);
+      const types::sample_index n_discarded
+        = (first < initial_n_samples ?
+           std::min (n_repetitions, initial_n_samples - first) :
+           0);
+
+      if (n_discarded < n_repetitions)
+        {
+          if (n_discarded > 0)
+            aux_data[AuxiliaryData::repetition_count] = std::size_t(n_repetitions - n_discarded);
+          return {{ std::move(sample), std::move(aux_data)}};
+        }
+      else
+        return {};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    PerChainDiscardFirstN<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::chain_number,
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    types::sample_index
+    PerChainDiscardFirstN<InputType>::
+    n_samples_seen (const std::size_t chain) const
+    {
+      assert (chain < n_chains);
+      return std::min (counters[chain].value.load (std::memory_order_relaxed),
+                       initial_n_samples);
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    PerChainDiscardFirstN<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<InputType,InputType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+
+  }
+}
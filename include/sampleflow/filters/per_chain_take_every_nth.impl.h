@@ -0,0 +1,277 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A variant of the TakeEveryNth filter for producers that run several
+     * chains at once (such as
+     * Producers::DifferentialEvaluationMetropolisHastings), or for a filter
+     * that receives samples from several producers that each run one
+     * chain: It passes on every $n$th sample *of each chain*, as
+     * identified by the AuxiliaryData::chain_number entry of the auxiliary
+     * data of samples. Samples without such an entry are counted as part
+     * of chain zero.
+     *
+     * Thinning a sequence in which the samples of several chains are
+     * interleaved with TakeEveryNth keeps every $n$th sample of the
+     * combined sequence, which -- depending on the order in which chains
+     * produce samples -- may select all samples from some chains and none
+     * from others. The current class instead thins each chain separately,
+     * exactly as one TakeEveryNth object per chain would.
+     *
+     * As with TakeEveryNth, a sample whose auxiliary data carries an entry
+     * with key AuxiliaryData::repetition_count stands for as many
+     * consecutive copies of the sample as this entry says, and the sample
+     * is passed on with a repetition count equal to the number of these
+     * copies that would have been selected.
+     *
+     * Unlike TakeEveryNth, this class does not ask its producer to skip
+     * samples via Producer::skip_next_samples(): That request applies to
+     * whatever samples the producer creates next, which for a producer that
+     * interleaves chains are not the samples of the chain in question.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. The numbers of samples seen are kept in an array of atomic
+     * counters, one per chain, that is allocated by the constructor. No
+     * locks are involved, and since each counter occupies a cache line of
+     * its own, threads that work on different chains do not slow each
+     * other down.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   For the current class, this is of course also the type used for
+     *   the outgoing samples.
+     */
+    template <typename InputType>
+    class PerChainTakeEveryNth : public Filter<InputType, InputType>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] every_nth The number $n$ of samples of each chain
+         *   between two samples of the chain that are passed on.
+         * @param[in] n_chains The number of chains. The chain numbers of all
+         *   samples need to be less than this number.
+         */
+        PerChainTakeEveryNth (const types::sample_index every_nth,
+                              const std::size_t         n_chains);
+
+        /**
+         * Move constructor. The moved-from object must not be connected to
+         * any producer.
+         */
+        PerChainTakeEveryNth (PerChainTakeEveryNth &&o);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~PerChainTakeEveryNth ();
+
+        /**
+         * Process one sample by checking whether it is an $n$th sample of
+         * its chain and if so, pass it on to downstream consumers. If it
+         * isn't, return an empty object which the caller of this function
+         * in the base class will interpret as the instruction to discard
+         * the sample from further processing.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class uses the chain number and repetition count, and passes
+         *   all of it on.
+         */
+        virtual
+        std::optional<std::pair<InputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since the number of
+         * samples passed on depends on the number of chains and the length
+         * of each, it is reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::chain_number and
+         * AuxiliaryData::repetition_count. See
+         * Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return how many samples of the given chain this object has seen.
+         */
+        types::sample_index
+        n_samples_seen (const std::size_t chain) const;
+
+      private:
+        /**
+         * A counter for the samples of one chain, on a cache line of its
+         * own.
+         */
+        struct alignas(Memory::cache_line_size) ChainCounter
+        {
+          std::atomic<types::sample_index> value {0};
+        };
+
+        /**
+         * The variable storing the spacing between samples of a chain that
+         * are passed on.
+         */
+        const types::sample_index every_nth;
+
+        /**
+         * The number of chains.
+         */
+        const std::size_t n_chains;
+
+        /**
+         * One counter per chain, counting how many samples of the chain we
+         * have seen so far.
+         */
+        std::unique_ptr<ChainCounter[]> counters;
+    };
+
+
+
+    template <typename InputType>
+    PerChainTakeEveryNth<InputType>::
+    PerChainTakeEveryNth (const types::sample_index every_nth,
+                          const std::size_t         n_chains)
+      : every_nth (every_nth),
+        n_chains (n_chains),
+        counters (std::make_unique<ChainCounter[]> (n_chains))
+    {
+      assert (every_nth >= 1);
+      assert (n_chains > 0);
+    }
+
+
+
+    template <typename InputType>
+    PerChainTakeEveryNth<InputType>::
+    PerChainTakeEveryNth (PerChainTakeEveryNth &&o)
+      : Filter<InputType, InputType> (std::move(o)),
+        every_nth (o.every_nth),
+        n_chains (o.n_chains),
+        counters (std::move(o.counters))
+    {}
+
+
+
+    template <typename InputType>
+    PerChainTakeEveryNth<InputType>::
+    ~PerChainTakeEveryNth ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<InputType, AuxiliaryData> >
+    PerChainTakeEveryNth<InputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      const std::size_t *const chain_number
+        = aux_data.get_if<std::size_t> (AuxiliaryData::chain_number);
+      const std::size_t chain = (chain_number != nullptr ? *chain_number : 0);
+      assert (chain < n_chains);
+
+      // The sample stands for copies number k...k+m-1 of the (expanded)
+      // sequence of samples of its chain. Determine how many of them are
+      // multiples of n as in TakeEveryNth:
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const types::sample_index first
+        = counters[chain].value.fetch_add (n_repetitions, std::memory_order_relaxed);
+      const auto n_multiples_below = [this](const types::sample_index k)
+      {
+        return (k + every_nth - 1) / every_nth;
+      };
+      const types::sample_index n_forwarded
+        = n_multiples_below (first + n_repetitions) - n_multiples_below (first);
+
+      if (n_forwarded == 0)
+        return {};
+
+      if (n_repetitions != 1)
+        aux_data[AuxiliaryData::repetition_count] = std::size_t(n_forwarded);
+      return {{ std::move(sample), std::move(aux_data)}};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    PerChainTakeEveryNth<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::chain_number,
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    types::sample_index
+    PerChainTakeEveryNth<InputType>::
+    n_samples_seen (const std::size_t chain) const
+    {
+      assert (chain < n_chains);
+      return counters[chain].value.load (std::memory_order_relaxed);
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    PerChainTakeEveryNth<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<InputType,InputType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+
+  }
+}
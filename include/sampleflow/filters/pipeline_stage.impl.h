@@ -0,0 +1,241 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * A filter that wraps around another filter and runs that filter's
+     * work on a thread of its own, so that a sequence of expensive filters
+     * -- say, a Conversion object that runs a forward model to compute a
+     * quantity of interest for each sample, followed by consumers that
+     * evaluate statistics of this quantity -- can be split into stages that
+     * run concurrently on different processor cores, rather than all on
+     * the thread that runs the sampler.
+     *
+     * In practice, one would use this class as follows:
+     * @code
+     *   SampleFlow::Filters::PipelineStage<SampleType,double>
+     *     qoi (SampleFlow::Filters::Conversion<SampleType,double>
+     *            ([](const SampleType &x) { return expensive_qoi(x); }),
+     *          16);
+     *   qoi.connect_to_producer (sampler);
+     *
+     *   SampleFlow::Consumers::MeanValue<double> mean_qoi;
+     *   mean_qoi.connect_to_producer (qoi);
+     * @endcode
+     * The sampler then only places each sample in the queue of the `qoi`
+     * object and continues with the next sample while the conversion
+     * happens in the background.
+     *
+     * All of the machinery necessary for this already exists in the
+     * Consumer base class: This class simply selects
+     * ParallelMode::dedicated_thread in its constructor, so that samples
+     * are put into a (lock-free, bounded) queue from which a thread that
+     * belongs to this object takes them in the order in which they arrived,
+     * calls the filter() function of the wrapped filter, and sends the
+     * result downstream. The wrapped filter is never connected to a
+     * producer by itself. Because samples are processed one at a time and
+     * in the order in which they were added to the queue, the order of
+     * samples is preserved, and downstream consumers that depend on it
+     * (Consumers::AutoCovarianceTrace, for example) see the same sequence
+     * of samples they would see without the intermediate stage --
+     * though of course on a different thread. If more than one
+     * pipeline stage should share processor cores, then one can instead
+     * call `set_parallel_mode(ParallelMode::asynchronous, queue_size)` on
+     * an object of this class before connecting it to a producer, in which
+     * case the queue is worked on by a task of the ThreadPool set via
+     * Consumer::set_thread_pool(); the order of samples is preserved in
+     * that case as well.
+     *
+     * The `queue_size` argument of the constructor determines how many
+     * samples may be waiting for processing; if the queue is full, the
+     * sampler blocks until the stage has caught up (or does what the
+     * QueueFullPolicy selected through Consumer::set_parallel_mode()
+     * specifies).
+     *
+     *
+     * ### Requirements on the wrapped filter ###
+     *
+     * Only the filter() function of the wrapped filter is called, and the
+     * samples it returns are the ones sent downstream. Filters that send
+     * samples on in other ways -- for example Filters::Batcher, which sends
+     * off its last batch in its flush() function -- can therefore not be
+     * wrapped by this class. Since filter() is only ever called from one
+     * thread at a time, the wrapped filter does not need to be thread-safe.
+     *
+     * Objects of this class are deliberately not "fusable" in the sense
+     * of Concepts::is_fusable_filter: the whole point of the class is to
+     * put a thread boundary between the producer upstream and the
+     * consumers downstream.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     * @tparam OutputType The C++ type used to describe the outgoing samples.
+     */
+    template <typename InputType, typename OutputType>
+    class PipelineStage : public Filter<InputType, OutputType>
+    {
+      public:
+        /**
+         * Constructor.
+         *
+         * @param[in] filter The filter whose work this stage is to do. This
+         *   object takes over ownership of the filter.
+         * @param[in] queue_size The maximal number of samples that can be
+         *   waiting for processing by this stage.
+         */
+        PipelineStage (std::unique_ptr<Filter<InputType,OutputType>> filter,
+                       const unsigned int queue_size = 1);
+
+        /**
+         * Constructor. This is a shortcut for the previous constructor
+         * that moves the given filter object into a newly created object
+         * owned by this stage.
+         *
+         * @param[in] filter The filter whose work this stage is to do.
+         * @param[in] queue_size The maximal number of samples that can be
+         *   waiting for processing by this stage.
+         */
+        template <typename FilterType>
+        requires (std::derived_from<FilterType, Filter<InputType,OutputType>>
+                  &&
+                  !std::same_as<FilterType, PipelineStage>)
+        PipelineStage (FilterType &&filter,
+                       const unsigned int queue_size = 1);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class, which also stops the thread of this object.
+         */
+        virtual ~PipelineStage ();
+
+        /**
+         * Process one sample by calling the filter() function of the
+         * wrapped filter. This function is called on the thread that
+         * works through the queue of samples of this object.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample.
+         *
+         * @return Whatever the wrapped filter returns.
+         */
+        virtual
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. This is what the wrapped
+         * filter reports.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return a reference to the wrapped filter.
+         */
+        Filter<InputType,OutputType> &
+        wrapped_filter ();
+
+      private:
+        /**
+         * The wrapped filter.
+         */
+        const std::unique_ptr<Filter<InputType,OutputType>> stage_filter;
+    };
+
+
+
+    template <typename InputType, typename OutputType>
+    PipelineStage<InputType,OutputType>::
+    PipelineStage (std::unique_ptr<Filter<InputType,OutputType>> filter,
+                   const unsigned int queue_size)
+      :
+      Filter<InputType,OutputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                                |
+                                                static_cast<int>(ParallelMode::asynchronous)
+                                                |
+                                                static_cast<int>(ParallelMode::dedicated_thread))),
+      stage_filter (std::move(filter))
+    {
+      assert (stage_filter != nullptr);
+
+      this->set_parallel_mode (ParallelMode::dedicated_thread, queue_size);
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    template <typename FilterType>
+    requires (std::derived_from<FilterType, Filter<InputType,OutputType>>
+              &&
+              !std::same_as<FilterType, PipelineStage<InputType,OutputType>>)
+    PipelineStage<InputType,OutputType>::
+    PipelineStage (FilterType &&filter,
+                   const unsigned int queue_size)
+      :
+      PipelineStage (std::make_unique<FilterType>(std::move(filter)),
+                     queue_size)
+    {}
+
+
+
+    template <typename InputType, typename OutputType>
+    PipelineStage<InputType,OutputType>::
+    ~PipelineStage ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    std::optional<std::pair<OutputType, AuxiliaryData> >
+    PipelineStage<InputType,OutputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      return stage_filter->filter (std::move(sample), std::move(aux_data));
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    Filter<InputType,OutputType> &
+    PipelineStage<InputType,OutputType>::
+    wrapped_filter ()
+    {
+      return *stage_filter;
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    SampleShape
+    PipelineStage<InputType,OutputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      return stage_filter->output_shape (input_shape);
+    }
+  }
+}
@@ -0,0 +1,322 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * An implementation of the Filter interface that stores the components
+     * of each sample with less precision, for example as `float` rather
+     * than `double`, or as 16-bit integers in a fixed-point
+     * representation. Analysis of samples rarely needs the full precision
+     * of `double` variables, but consumers that write samples to disk (such
+     * as Consumers::StreamOutput in its binary format) or send them to
+     * other processes (such as Consumers::SharedMemoryOutput) move eight
+     * bytes per component. Putting an object of this class in front of
+     * them reduces this to four or two bytes.
+     *
+     * Component $j$ of an outgoing sample $y$ is computed from the
+     * corresponding component of the incoming sample $x$ as
+     * @f{align*}{
+     *   y_j = Q\left(\frac{x_j - o_j}{s_j}\right),
+     * @f}
+     * where $s_j$ and $o_j$ are a scale and an offset given to the
+     * constructor (either the same for all components, or one per
+     * component), and $Q$ is the conversion to the scalar type of
+     * `OutputType`. If that is a floating point type, then $Q$ simply
+     * rounds to the nearest representable number. If it is an integer type,
+     * then $Q$ rounds to the nearest integer and values outside the range
+     * of the type are clamped to the smallest or largest representable
+     * value. For example, to store components that are known to lie
+     * between -1 and 1 as 16-bit integers with a resolution of about
+     * $3\cdot 10^{-5}$, one would use a scale of $1/32767$ and an offset
+     * of zero. The Dequantization class implements the reverse operation,
+     * and so a file written this way can be read using
+     * Producers::ChainFile and then be converted back to samples of the
+     * original type:
+     * @code
+     *   // Writing:
+     *   SampleFlow::Filters::Quantization<std::vector<double>,std::vector<std::int16_t>>
+     *     quantization (1./32767);
+     *   quantization.connect_to_producer (sampler);
+     *   SampleFlow::Consumers::StreamOutput<std::vector<std::int16_t>>
+     *     writer (file, SampleFlow::Consumers::StreamOutput<std::vector<std::int16_t>>::Format::binary);
+     *   writer.connect_to_producer (quantization);
+     *
+     *   // Reading:
+     *   SampleFlow::Producers::ChainFile<std::vector<std::int16_t>> chain_file (filename);
+     *   SampleFlow::Filters::Dequantization<std::vector<std::int16_t>,std::vector<double>>
+     *     dequantization (1./32767);
+     *   dequantization.connect_to_producer (chain_file);
+     * @endcode
+     *
+     * If the components of both the incoming and outgoing samples are
+     * stored contiguously (see Concepts::has_contiguous_storage; this is
+     * the case for `std::vector`, `std::array`, `std::valarray`, and Eigen
+     * vectors), then the conversion is done in a simple loop over the
+     * underlying arrays that compilers can vectorize. Otherwise, the
+     * components are accessed one at a time via Utilities::get_nth_element().
+     *
+     * The C++ standard before C++23 does not provide a 16-bit floating
+     * point type such as `bfloat16`, and the binary file format described
+     * in ChainFileFormat does not have a way to describe one. Fixed-point
+     * representations via 16-bit integers serve the same purpose.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The object is not modified after it is created, and so filter() can
+     * be called concurrently and from multiple threads.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   Its elements need to be real numbers.
+     * @tparam OutputType The C++ type used to describe the outgoing samples.
+     *   It needs to either have a `resize()` member function or have the
+     *   number of elements of the incoming samples already when it is
+     *   default-constructed (as is the case for `std::array`), and its
+     *   elements need to be of an arithmetic type that can be accessed via
+     *   `operator[]`.
+     */
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_arithmetic_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    class Quantization : public Filter<InputType, OutputType>
+    {
+      public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
+        /**
+         * The filter() function of this class does not modify the
+         * object's state, see Concepts::is_stateless_filter.
+         */
+        static constexpr bool is_stateless = true;
+
+        /**
+         * Constructor for the case where all components use the same
+         * scale and offset.
+         *
+         * @param[in] scale The scale $s$. Must be positive.
+         * @param[in] offset The offset $o$.
+         */
+        Quantization (const double scale = 1.,
+                      const double offset = 0.);
+
+        /**
+         * Constructor for the case where each component has its own scale
+         * and offset.
+         *
+         * @param[in] scales The scales $s_j$. All must be positive.
+         * @param[in] offsets The offsets $o_j$. This vector needs to have
+         *   the same size as `scales`, and both need to have as many
+         *   elements as the incoming samples have components.
+         */
+        Quantization (const std::vector<double> &scales,
+                      const std::vector<double> &offsets);
+
+        /**
+         * Move constructor.
+         */
+        Quantization (Quantization &&) = default;
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Quantization ();
+
+        /**
+         * Process one sample by converting each of its components as
+         * described in the documentation of this class.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class does not know what to do with any such data and consequently
+         *   simply passes it on.
+         *
+         * @return The converted sample and the auxiliary data
+         *   originally associated with the sample.
+         */
+        virtual
+        std::optional<std::pair<OutputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+      private:
+        /**
+         * The inverse of the scale and the offset if they are the same for
+         * all components. Only used if the following vectors are empty.
+         */
+        double uniform_inverse_scale;
+        double uniform_offset;
+
+        /**
+         * The inverses of the scales and the offsets for each component.
+         */
+        std::vector<double> inverse_scales;
+        std::vector<double> offsets;
+    };
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_arithmetic_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Quantization<InputType,OutputType>::
+    Quantization (const double scale,
+                  const double offset)
+      :
+      uniform_inverse_scale (1./scale),
+      uniform_offset (offset)
+    {
+      assert (scale > 0);
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_arithmetic_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Quantization<InputType,OutputType>::
+    Quantization (const std::vector<double> &scales,
+                  const std::vector<double> &offsets)
+      :
+      uniform_inverse_scale (1.),
+      uniform_offset (0.),
+      inverse_scales (scales.size()),
+      offsets (offsets)
+    {
+      assert (scales.size() > 0);
+      assert (scales.size() == offsets.size());
+      for (std::size_t j=0; j<scales.size(); ++j)
+        {
+          assert (scales[j] > 0);
+          inverse_scales[j] = 1./scales[j];
+        }
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_arithmetic_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    Quantization<InputType,OutputType>::
+    ~Quantization ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType, typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<InputType>>
+              &&
+              std::is_arithmetic_v<types::ScalarType<OutputType>>
+              &&
+              Concepts::has_subscript_operator<OutputType>)
+    std::optional<std::pair<OutputType, AuxiliaryData> >
+    Quantization<InputType,OutputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      using input_scalar  = types::ScalarType<InputType>;
+      using output_scalar = types::ScalarType<OutputType>;
+
+      const std::size_t size = Utilities::size(sample);
+      assert ((inverse_scales.size() == 0) || (inverse_scales.size() == size));
+
+      OutputType quantized_sample;
+      if constexpr (requires (OutputType &y, const std::size_t n)
+      {
+        y.resize(n);
+      })
+      quantized_sample.resize (size);
+      assert (static_cast<std::size_t>(Utilities::size(quantized_sample)) == size);
+
+      const auto quantize = [](const double y) -> output_scalar
+      {
+        if constexpr (std::is_floating_point_v<output_scalar>)
+          return static_cast<output_scalar>(y);
+        else
+          return static_cast<output_scalar>
+                 (std::clamp (std::round(y),
+                              static_cast<double>(std::numeric_limits<output_scalar>::lowest()),
+                              static_cast<double>(std::numeric_limits<output_scalar>::max())));
+      };
+
+      // Do the conversion with the given functions for the scales and
+      // offsets of each component. If the data is stored contiguously,
+      // work on the underlying arrays directly:
+      const auto convert = [&](const auto &inverse_scale, const auto &offset)
+      {
+        if constexpr (Concepts::has_contiguous_storage<InputType,input_scalar>
+                      &&
+                      Concepts::has_contiguous_storage<OutputType,output_scalar>)
+          {
+            const input_scalar *const x = std::ranges::data(std::as_const(sample));
+            output_scalar *const      y = std::ranges::data(quantized_sample);
+            for (std::size_t j=0; j<size; ++j)
+              y[j] = quantize ((x[j] - offset(j)) * inverse_scale(j));
+          }
+        else
+          for (std::size_t j=0; j<size; ++j)
+            quantized_sample[j]
+              = quantize ((Utilities::get_nth_element (sample, j) - offset(j))
+                          * inverse_scale(j));
+      };
+
+      if (inverse_scales.size() == 0)
+        convert ([this](const std::size_t)
+      {
+        return uniform_inverse_scale;
+      },
+      [this](const std::size_t)
+      {
+        return uniform_offset;
+      });
+      else
+        convert ([this](const std::size_t j)
+      {
+        return inverse_scales[j];
+      },
+      [this](const std::size_t j)
+      {
+        return offsets[j];
+      });
+
+      return {{ std::move(quantized_sample), std::move(aux_data)}};
+    }
+  }
+}
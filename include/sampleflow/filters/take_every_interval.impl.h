@@ -0,0 +1,213 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * An implementation of the Filter interface that passes on at most one
+     * sample per given time interval, and discards all other samples. In
+     * contrast to TakeEveryNth, which thins a stream of samples by a fixed
+     * factor, this class limits the *rate* at which samples arrive
+     * downstream, independently of how fast the upstream producer generates
+     * them. This is what one wants for consumers that monitor a sampler
+     * -- for example, a Consumers::StreamOutput object that prints samples
+     * to a terminal, or a Consumers::Action object that updates a plot --
+     * since these should show a sample every so often, regardless of
+     * whether the sampler generates ten or ten million samples per second.
+     *
+     * The first sample is always passed on. After that, a sample is passed
+     * on if at least the given interval has passed since the last sample
+     * that was passed on. The time is measured with `std::chrono::steady_clock`,
+     * which on common platforms reads a counter of the processor without
+     * making a system call, and so checking the time for every sample is
+     * cheap compared to what producers do to generate a sample.
+     *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for several consecutive copies
+     * of the sample (see TakeEveryNth). Since all of these copies arrive at
+     * the same time, at most one of them can be passed on, and the
+     * repetition count of a sample that is passed on is therefore set to
+     * one.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. The time at which the last sample was passed on is kept in an
+     * atomic variable, and if several threads find that the interval has
+     * passed at the same time, only one of them passes on its sample.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the incoming samples.
+     *   For the current class, this is of course also the type used for
+     *   the outgoing samples.
+     */
+    template <typename InputType>
+    class TakeEveryInterval : public Filter<InputType, InputType>
+    {
+      public:
+        /**
+         * The clock used to measure time.
+         */
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] interval The minimal time between two samples that are
+         *   passed on to downstream consumers of this filter.
+         */
+        TakeEveryInterval (const Clock::duration interval);
+
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~TakeEveryInterval ();
+
+        /**
+         * Process one sample by checking whether enough time has passed
+         * since the last sample that was passed on, and if so, pass it on
+         * to downstream consumers. If not, return an empty object which the
+         * caller of this function in the base class will interpret as the
+         * instruction to discard the sample from further processing.
+         *
+         * @param[in] sample The sample to process.
+         * @param[in] aux_data Auxiliary data about this sample. The current
+         *   class only changes the repetition count of the sample, if there
+         *   is one.
+         *
+         * @return The sample and its auxiliary data if the sample is passed
+         *   on, or an empty object.
+         */
+        virtual
+        std::optional<std::pair<InputType, AuxiliaryData> >
+        filter (InputType sample,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument. Since whether a sample
+         * is passed on depends on when it arrives, the number of samples is
+         * reported as unknown.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::repetition_count.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+      private:
+        /**
+         * The minimal time between two samples that are passed on.
+         */
+        const Clock::duration interval;
+
+        /**
+         * The time at which the last sample was passed on, as the number of
+         * ticks of `Clock` since its epoch. The initial value, the smallest
+         * representable value, denotes that no sample has been passed on
+         * yet.
+         */
+        std::atomic<Clock::rep> last_passed_on;
+    };
+
+
+
+    template <typename InputType>
+    TakeEveryInterval<InputType>::
+    TakeEveryInterval (const Clock::duration interval)
+      : interval (interval),
+        last_passed_on (std::numeric_limits<Clock::rep>::min())
+    {
+      assert (interval >= Clock::duration::zero());
+    }
+
+
+
+    template <typename InputType>
+    TakeEveryInterval<InputType>::
+    ~TakeEveryInterval ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<InputType, AuxiliaryData> >
+    TakeEveryInterval<InputType>::
+    filter (InputType sample,
+            AuxiliaryData aux_data)
+    {
+      const Clock::rep now = Clock::now().time_since_epoch().count();
+
+      // Check whether enough time has passed, and if so try to claim the
+      // right to pass on a sample. If another thread claims it at the same
+      // time, it wins and we discard our sample:
+      Clock::rep last = last_passed_on.load (std::memory_order_relaxed);
+      if ((last != std::numeric_limits<Clock::rep>::min())
+          &&
+          (now - last < interval.count()))
+        return {};
+      if (last_passed_on.compare_exchange_strong (last, now,
+                                                  std::memory_order_relaxed) == false)
+        return {};
+
+      if (aux_data.n_repetitions() != 1)
+        aux_data[AuxiliaryData::repetition_count] = std::size_t(1);
+      return {{ std::move(sample), std::move(aux_data)}};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    TakeEveryInterval<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    TakeEveryInterval<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = Filter<InputType,InputType>::output_shape (input_shape);
+      shape.n_samples.reset();
+      return shape;
+    }
+
+  }
+}
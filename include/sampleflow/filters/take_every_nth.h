@@ -19,7 +19,7 @@
 #include <sampleflow/filter.h>
 #include <sampleflow/types.h>
 
-#include <mutex>
+#include <atomic>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/filters/take_every_nth.impl.h>
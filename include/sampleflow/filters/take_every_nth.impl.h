@@ -29,12 +29,32 @@ namespace SampleFlow
      * consequently skipping most samples does not reduce the amount of
      * information available in a chain.
      *
+     * A sample whose auxiliary data carries an entry with key
+     * AuxiliaryData::repetition_count stands for as many consecutive copies
+     * of the sample as this entry says (see, for example,
+     * Producers::MetropolisHastings::Parameters::compress_repeated_samples),
+     * and this class counts all of these copies. If some of them are among
+     * the ones to be passed on, then the sample is passed on once, with the
+     * repetition count replaced by the number of copies passed on.
+     *
+     * If the filter is connected to only one producer, and is the only
+     * consumer of that producer, then it uses Producer::skip_next_samples()
+     * after each sample it passes on to ask the producer not to even send
+     * the $n-1$ copies that follow. This avoids the cost of the producer
+     * issuing samples that would only be discarded. Producers ignore such
+     * requests for samples they send in batches (see Producer::issue_batch);
+     * if a sample arrives while the filter believes it
+     * should have been skipped, the filter takes back the request by
+     * calling Producer::cancel_skip_request() and processes the sample as
+     * usual.
+     *
      *
      * ### Threading model ###
      *
      * The implementation of this class is thread-safe, i.e., its
      * filter() member function can be called concurrently and from multiple
-     * threads.
+     * threads. The number of samples seen is kept in an atomic counter,
+     * and so concurrent calls do not have to wait for each other.
      *
      *
      * @tparam InputType The C++ type used to describe the incoming samples.
@@ -47,6 +67,12 @@ namespace SampleFlow
     class TakeEveryNth : public Filter<InputType, InputType>
     {
       public:
+        /**
+         * Objects of this class can be fused with adjacent filters, see
+         * Concepts::is_fusable_filter.
+         */
+        static constexpr bool is_fusable = true;
+
         /**
          * Constructor.
          *
@@ -55,6 +81,12 @@ namespace SampleFlow
          */
         TakeEveryNth (const types::sample_index every_nth);
 
+        /**
+         * Move constructor. The moved-from object must not be connected to
+         * any producer.
+         */
+        TakeEveryNth (TakeEveryNth &&o);
+
         /**
          * Destructor. This function also makes sure that all samples this
          * object may have received have been fully processed. To this end,
@@ -76,24 +108,45 @@ namespace SampleFlow
          *   simply passed it on.
          *
          * @return The sample and its auxiliary data if this is the $k$th
-         *   sample and $k \mod n = 0$. Otherwise, an empty object.
+         *   sample and $k \mod n = 0$ (or, for repeated samples, if one of
+         *   the copies is). Otherwise, an empty object.
          */
         virtual
         std::optional<std::pair<InputType, AuxiliaryData> >
         filter (InputType sample,
                 AuxiliaryData aux_data) override;
 
+        /**
+         * Return the keys of the entries of the auxiliary data that this
+         * class uses: AuxiliaryData::repetition_count.
+         * See Consumer::used_aux_data_keys().
+         */
+        virtual
+        std::optional<std::vector<AuxiliaryData::Key>>
+        used_aux_data_keys () const override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives samples described by the argument: About every $n$th
+         * of them. See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+
       private:
         /**
-         * A mutex used to lock access to all member variables when running
-         * on multiple threads.
+         * A counter counting how many samples we have seen so far,
+         * including the ones we have asked the producer to skip.
          */
-        std::mutex mutex;
+        std::atomic<types::sample_index> counter;
 
         /**
-         * A counter counting how many samples we have seen so far.
+         * Whether we have asked the producer to skip samples, and the
+         * number of copies we have asked it to skip is included in
+         * `counter`.
          */
-        types::sample_index counter;
+        std::atomic<bool> skip_requested;
 
         /**
          * The variable storing how often we are to forward a received
@@ -108,7 +161,21 @@ namespace SampleFlow
     TakeEveryNth<InputType>::
     TakeEveryNth (const types::sample_index every_nth)
       : counter (0),
+        skip_requested (false),
         every_nth (every_nth)
+    {
+      assert (every_nth >= 1);
+    }
+
+
+
+    template <typename InputType>
+    TakeEveryNth<InputType>::
+    TakeEveryNth (TakeEveryNth &&o)
+      : Filter<InputType, InputType> (std::move(o)),
+        counter (o.counter.load()),
+        skip_requested (false),
+        every_nth (o.every_nth)
     {}
 
 
@@ -128,18 +195,83 @@ namespace SampleFlow
     filter (InputType sample,
             AuxiliaryData aux_data)
     {
-      std::lock_guard<std::mutex> lock(mutex);
+      const Producer<InputType> *const producer = this->sole_producer();
 
-      if (counter % every_nth == 0)
+      // If we receive a sample although we have asked the producer to
+      // skip it, the producer has not honored the request (for example
+      // because it sent this sample as part of a batch, or because another
+      // consumer has connected to it in the meantime). Take back what is
+      // left of the request, and forget about the copies we had assumed
+      // to be skipped:
+      if (skip_requested.load (std::memory_order_relaxed)
+          &&
+          skip_requested.exchange (false))
         {
-          counter = 1;
-          return {{ std::move(sample), std::move(aux_data)}};
+          if (producer != nullptr)
+            counter.fetch_sub (producer->cancel_skip_request(),
+                               std::memory_order_relaxed);
         }
-      else
+
+      // The sample stands for copies number k...k+m-1 of the (expanded)
+      // sequence of samples. Determine how many of them are multiples of
+      // n by counting the multiples of n below k+m and below k:
+      const types::sample_index n_repetitions = aux_data.n_repetitions();
+      const types::sample_index first
+        = counter.fetch_add (n_repetitions, std::memory_order_relaxed);
+      const auto n_multiples_below = [this](const types::sample_index k)
+      {
+        return (k + every_nth - 1) / every_nth;
+      };
+      const types::sample_index n_forwarded
+        = n_multiples_below (first + n_repetitions) - n_multiples_below (first);
+
+      if (n_forwarded == 0)
+        return {};
+
+      // We are passing this sample on. All copies up to the next multiple
+      // of n are going to be discarded, so ask the producer not to send
+      // them in the first place:
+      const types::sample_index n_to_skip
+        = (every_nth - (first + n_repetitions) % every_nth) % every_nth;
+      if ((n_to_skip > 0)
+          &&
+          (producer != nullptr)
+          &&
+          producer->skip_next_samples (n_to_skip))
         {
-          ++counter;
-          return {};
+          counter.fetch_add (n_to_skip, std::memory_order_relaxed);
+          skip_requested.store (true);
         }
+
+      if (n_repetitions != 1)
+        aux_data[AuxiliaryData::repetition_count] = std::size_t(n_forwarded);
+      return {{ std::move(sample), std::move(aux_data)}};
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::vector<AuxiliaryData::Key>>
+    TakeEveryNth<InputType>::
+    used_aux_data_keys () const
+    {
+      return std::vector<AuxiliaryData::Key>
+      {
+        AuxiliaryData::repetition_count
+      };
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    TakeEveryNth<InputType>::
+    output_shape (const SampleShape &input_shape) const
+    {
+      SampleShape shape = input_shape;
+      if (shape.n_samples.has_value())
+        shape.n_samples = (*shape.n_samples + every_nth - 1) / every_nth;
+      return shape;
     }
 
   }
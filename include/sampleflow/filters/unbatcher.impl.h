@@ -0,0 +1,119 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Filters
+  {
+    /**
+     * An implementation of the Filter interface that undoes what the Batcher
+     * class does: It receives SampleBatch objects and sends the samples they
+     * contain downstream, along with their auxiliary data. The samples of
+     * each batch are sent on together via the Producer::issue_batch signal,
+     * and so downstream consumers receive them through their
+     * Consumer::consume_batch() functions. The auxiliary data associated
+     * with each SampleBatch object itself is ignored.
+     *
+     * The pair of Batcher and Unbatcher objects can be used to have a
+     * part of a graph of producers, filters, and consumers work on batches
+     * of samples rather than individual samples.
+     *
+     *
+     * ### Threading model ###
+     *
+     * The implementation of this class is thread-safe, i.e., its
+     * filter() member function can be called concurrently and from multiple
+     * threads. The samples of a batch are sent downstream on the thread on
+     * which the batch arrives.
+     *
+     *
+     * @tparam InputType The C++ type used to describe the samples stored in
+     *   the incoming batches, and consequently the type of the outgoing
+     *   samples.
+     */
+    template <typename InputType>
+    class Unbatcher : public Filter<SampleBatch<InputType>, InputType>
+    {
+      public:
+        /**
+         * Destructor. This function also makes sure that all samples this
+         * object may have received have been fully processed. To this end,
+         * it calls the Consumers::disconnect_and_flush() function of the
+         * base class.
+         */
+        virtual ~Unbatcher ();
+
+        /**
+         * Process one batch by sending all of its samples downstream.
+         *
+         * @param[in] batch The batch to process.
+         * @param[in] aux_data Auxiliary data about the batch. It is
+         *   ignored.
+         *
+         * @return An empty object, since the samples of the batch have
+         *   already been sent on by this function.
+         */
+        virtual
+        std::optional<std::pair<InputType, AuxiliaryData> >
+        filter (SampleBatch<InputType> batch,
+                AuxiliaryData aux_data) override;
+
+        /**
+         * Return a description of the samples this object passes on if it
+         * receives batches described by the argument. Since the number of
+         * samples per batch is not known, the returned object is empty.
+         * See Filter::output_shape().
+         */
+        virtual
+        SampleShape
+        output_shape (const SampleShape &input_shape) const override;
+    };
+
+
+
+    template <typename InputType>
+    Unbatcher<InputType>::
+    ~Unbatcher ()
+    {
+      this->disconnect_and_flush();
+    }
+
+
+
+    template <typename InputType>
+    std::optional<std::pair<InputType, AuxiliaryData> >
+    Unbatcher<InputType>::
+    filter (SampleBatch<InputType> batch,
+            AuxiliaryData /*aux_data*/)
+    {
+      assert (batch.samples.size() == batch.aux_data.size());
+
+      if (batch.samples.size() > 0)
+        this->issue_batch (batch.samples, batch.aux_data);
+      return {};
+    }
+
+
+
+    template <typename InputType>
+    SampleShape
+    Unbatcher<InputType>::
+    output_shape (const SampleShape &/*input_shape*/) const
+    {
+      return {};
+    }
+  }
+}
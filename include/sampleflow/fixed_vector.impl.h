@@ -0,0 +1,447 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace VectorStorage
+    {
+      /**
+       * Return the alignment with which to store `n` objects of type `T`
+       * inline in an object of type FixedVector or SmallVector. This is
+       * the size of the array rounded up to the next power of two, so
+       * that the whole array can be loaded into one vector register (or
+       * a small number of them) with aligned loads, but never less than
+       * the alignment `T` requires anyway, and never more than the size
+       * of a cache line.
+       */
+      template <typename T>
+      constexpr std::size_t
+      alignment (const std::size_t n)
+      {
+        return std::max (alignof(T),
+                         std::min (std::size_t(64),
+                                   std::bit_ceil (std::max (std::size_t(1), n) * sizeof(T))));
+      }
+    }
+  }
+
+
+  /**
+   * A class that represents a vector with a fixed number of elements `N`
+   * of type `T` that are stored inline in the object itself, in the spirit
+   * of `std::array<T,N>`. In contrast to `std::array`, this class provides
+   * the operations necessary to satisfy Concepts::is_vector_space_type,
+   * i.e., one can add and subtract objects of this type and multiply them
+   * by scalars. It can therefore be used as the sample type of
+   * producers such as Producers::MetropolisHastings and of consumers such
+   * as Consumers::MeanValue or Consumers::CovarianceMatrix.
+   *
+   * The advantage over `std::valarray<double>` or `Eigen::VectorXd` is
+   * that copying an object of this type does not require allocating
+   * memory on the heap. Since SampleFlow copies samples a lot (for
+   * example, every time a sample is passed from a producer to a filter
+   * that modifies it, or when a consumer stores the sample with the
+   * highest probability), pipelines that work on low-dimensional
+   * problems with sample types of this kind often do not allocate any
+   * memory at all once they are set up. The type is also trivially
+   * copyable if `T` is, and can then be written by the functions in
+   * namespace Serialization and by Consumers::StreamOutput in binary
+   * format as a single block of memory.
+   *
+   * The elements are stored with an alignment that allows the compiler
+   * to use aligned vector loads and stores (see
+   * internal::VectorStorage::alignment()), and the arithmetic operators
+   * are implemented as loops of known length over these elements that
+   * compilers turn into vector instructions without the need for
+   * platform-specific code.
+   *
+   * @tparam T The type of the individual elements, typically `double` or
+   *   `float`.
+   * @tparam N The number of elements.
+   */
+  template <typename T, std::size_t N>
+  class alignas(internal::VectorStorage::alignment<T>(N)) FixedVector
+  {
+    public:
+      /**
+       * The type of the elements of this vector.
+       */
+      using value_type = T;
+
+      /**
+       * Default constructor. Sets all elements to `T()`, i.e., to zero
+       * for arithmetic types.
+       */
+      FixedVector ();
+
+      /**
+       * Constructor that sets all elements to the given value.
+       *
+       * @param[in] value The value to which all elements are set.
+       */
+      explicit FixedVector (const T &value);
+
+      /**
+       * Constructor that sets the elements to the given list of values.
+       *
+       * @param[in] values The values of the elements. The list needs to
+       *   have exactly `N` elements.
+       */
+      FixedVector (const std::initializer_list<T> values);
+
+      /**
+       * Return the number of elements of this vector, i.e., `N`.
+       */
+      static constexpr std::size_t
+      size ();
+
+      /**
+       * Return a reference to the `i`th element of the vector.
+       */
+      T &
+      operator[] (const std::size_t i);
+
+      /**
+       * Return a reference to the `i`th element of the vector.
+       */
+      const T &
+      operator[] (const std::size_t i) const;
+
+      /**
+       * Return a pointer to the first element of the vector. The elements
+       * are stored contiguously.
+       */
+      T *
+      data ();
+
+      /**
+       * Return a pointer to the first element of the vector. The elements
+       * are stored contiguously.
+       */
+      const T *
+      data () const;
+
+      /**
+       * Return an iterator to the first element of the vector.
+       */
+      T *
+      begin ();
+
+      /**
+       * Return an iterator to the first element of the vector.
+       */
+      const T *
+      begin () const;
+
+      /**
+       * Return an iterator to one past the last element of the vector.
+       */
+      T *
+      end ();
+
+      /**
+       * Return an iterator to one past the last element of the vector.
+       */
+      const T *
+      end () const;
+
+      /**
+       * Add the elements of the given vector to the current one.
+       */
+      FixedVector &
+      operator+= (const FixedVector &v);
+
+      /**
+       * Subtract the elements of the given vector from the current one.
+       */
+      FixedVector &
+      operator-= (const FixedVector &v);
+
+      /**
+       * Multiply all elements of the current vector by the given factor.
+       */
+      FixedVector &
+      operator*= (const double factor);
+
+      /**
+       * Divide all elements of the current vector by the given factor.
+       */
+      FixedVector &
+      operator/= (const double factor);
+
+      /**
+       * Compare two vectors element by element.
+       */
+      bool
+      operator== (const FixedVector &v) const = default;
+
+    private:
+      /**
+       * The elements of the vector.
+       */
+      T elements[N];
+  };
+
+
+  /**
+   * Return the sum of two vectors.
+   */
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator+ (FixedVector<T,N> v1,
+             const FixedVector<T,N> &v2);
+
+  /**
+   * Return the difference of two vectors.
+   */
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator- (FixedVector<T,N> v1,
+             const FixedVector<T,N> &v2);
+
+  /**
+   * Return the vector multiplied by a scalar.
+   */
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator* (FixedVector<T,N> v,
+             const double factor);
+
+  /**
+   * Return the vector multiplied by a scalar.
+   */
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator* (const double factor,
+             FixedVector<T,N> v);
+
+  /**
+   * Return the vector divided by a scalar.
+   */
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator/ (FixedVector<T,N> v,
+             const double factor);
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>::FixedVector ()
+    :
+    elements {}
+  {}
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>::FixedVector (const T &value)
+  {
+    std::fill_n (elements, N, value);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>::FixedVector (const std::initializer_list<T> values)
+  {
+    assert (values.size() == N);
+    std::copy_n (values.begin(), N, elements);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  constexpr std::size_t
+  FixedVector<T,N>::size ()
+  {
+    return N;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T &
+  FixedVector<T,N>::operator[] (const std::size_t i)
+  {
+    assert (i < N);
+    return elements[i];
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T &
+  FixedVector<T,N>::operator[] (const std::size_t i) const
+  {
+    assert (i < N);
+    return elements[i];
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  FixedVector<T,N>::data ()
+  {
+    return elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  FixedVector<T,N>::data () const
+  {
+    return elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  FixedVector<T,N>::begin ()
+  {
+    return elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  FixedVector<T,N>::begin () const
+  {
+    return elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  FixedVector<T,N>::end ()
+  {
+    return elements + N;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  FixedVector<T,N>::end () const
+  {
+    return elements + N;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N> &
+  FixedVector<T,N>::operator+= (const FixedVector &v)
+  {
+    for (std::size_t i=0; i<N; ++i)
+      elements[i] += v.elements[i];
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N> &
+  FixedVector<T,N>::operator-= (const FixedVector &v)
+  {
+    for (std::size_t i=0; i<N; ++i)
+      elements[i] -= v.elements[i];
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N> &
+  FixedVector<T,N>::operator*= (const double factor)
+  {
+    for (std::size_t i=0; i<N; ++i)
+      elements[i] *= factor;
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N> &
+  FixedVector<T,N>::operator/= (const double factor)
+  {
+    for (std::size_t i=0; i<N; ++i)
+      elements[i] /= factor;
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator+ (FixedVector<T,N> v1,
+             const FixedVector<T,N> &v2)
+  {
+    v1 += v2;
+    return v1;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator- (FixedVector<T,N> v1,
+             const FixedVector<T,N> &v2)
+  {
+    v1 -= v2;
+    return v1;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator* (FixedVector<T,N> v,
+             const double factor)
+  {
+    v *= factor;
+    return v;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator* (const double factor,
+             FixedVector<T,N> v)
+  {
+    v *= factor;
+    return v;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  FixedVector<T,N>
+  operator/ (FixedVector<T,N> v,
+             const double factor)
+  {
+    v /= factor;
+    return v;
+  }
+}
@@ -0,0 +1,427 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that represents a pipeline of filters followed by a consumer in
+   * which samples are passed from one stage to the next by direct function
+   * calls, rather than through the signals and slots that are used when
+   * connecting objects via Consumer::connect_to_producer() or the
+   * `operator>>` functions declared in connections.h. Objects of this type
+   * are created by writing code such as
+   * @code
+   *   SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+   *   SampleFlow::Filters::DiscardFirstN<SampleType> burn_in (1000);
+   *   SampleFlow::Filters::TakeEveryNth<SampleType> every_10th (10);
+   *   SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+   *
+   *   auto pipeline = SampleFlow::fuse(mh_sampler) >> burn_in >> every_10th >> mean_value;
+   *
+   *   mh_sampler.sample (...);
+   *   std::cout << mean_value.get() << std::endl;
+   * @endcode
+   * The result is a single object whose type encodes the types of all
+   * stages of the pipeline, and that is connected to the producer as one
+   * consumer. Every time the producer issues a sample, the consume()
+   * function of this class calls the `filter()` functions of all filters
+   * in turn and, if all of them let the sample pass, the `consume()`
+   * function of the consumer at the end of the pipeline.
+   *
+   * Because the concrete types of all stages are known, these calls are
+   * made without going through the virtual function mechanism, and the
+   * compiler can inline them into a single function. This avoids the
+   * costs of the dynamic connections made by `producer >> filter >>
+   * consumer` (i.e., by the Chain class): calling a `std::function` object
+   * through a signal for every sample at every stage, acquiring the locks
+   * associated with signals and with the parallel mode of each stage, and
+   * passing samples between stages through `std::optional` objects that
+   * cannot be optimized away across a virtual function call. Only the
+   * connection between the producer and the first stage of the pipeline
+   * is still a dynamic one.
+   *
+   * The price to pay is flexibility: The stages of a pipeline are no
+   * longer independent objects. In particular:
+   * - The ParallelMode settings of the filters and the consumer that make
+   *   up the pipeline are ignored. Rather, the pipeline as a whole is a
+   *   consumer that processes samples in ParallelMode::synchronous mode,
+   *   i.e., on the thread on which the producer issues them. (Because the
+   *   pipeline is connected to its producer upon construction, its
+   *   parallel mode cannot be changed later on.)
+   * - Samples produced by filters that are part of the pipeline are passed
+   *   on only to the next stage of the pipeline, not to any other consumers
+   *   connected to these filters. Consumers should therefore not connect
+   *   to the stages of a pipeline.
+   * - The type of each stage must be the dynamic type of the object, since
+   *   the overrides of `filter()` and `consume()` in the static types of the
+   *   stages are the ones that will be called.
+   *
+   * For graphs of producers, filters, and consumers that are assembled
+   * at run time, or in which one filter feeds more than one consumer,
+   * one needs to continue using Consumer::connect_to_producer().
+   *
+   * Like with the Chain class, stages that are passed as named objects
+   * (lvalues) are stored by reference, and the pipeline must not outlive
+   * them; stages that are passed as temporary objects (rvalues) are moved
+   * into the pipeline and can be accessed through the get_stage() function.
+   *
+   * @tparam InputType The type of the samples this pipeline consumes,
+   *   i.e., the type of the samples produced by the producer the pipeline
+   *   is connected to.
+   * @tparam StageTypes The types of the filters and the final consumer.
+   *   These are either class types (if the corresponding stage is stored
+   *   inside the pipeline) or reference types (if the pipeline only
+   *   references the stage).
+   */
+  template <typename InputType, typename ... StageTypes>
+  class FusedPipeline : public Consumer<InputType>
+  {
+    public:
+      /**
+       * Constructor. Store the given stages and connect the resulting
+       * pipeline to the given producer.
+       *
+       * This constructor is typically not called directly, but through a
+       * sequence of calls to `operator>>` starting with a call to fuse().
+       */
+      FusedPipeline (Producer<InputType>        &producer,
+                     std::tuple<StageTypes...> &&stages);
+
+      /**
+       * Copy constructor. Pipelines can not be copied, and so this
+       * constructor is deleted.
+       */
+      FusedPipeline (const FusedPipeline &) = delete;
+
+      /**
+       * Destructor. This function also makes sure that all samples this
+       * object has received have been fully processed.
+       */
+      virtual
+      ~FusedPipeline () override;
+
+      /**
+       * Process a sample by running it through all stages of the pipeline.
+       *
+       * @param[in] sample The sample to process.
+       * @param[in] aux_data Auxiliary data about this sample. The current
+       *   class does not know what to do with any such data and consequently
+       *   simply passes it on to the first stage.
+       */
+      virtual
+      void
+      consume (InputType sample,
+               AuxiliaryData aux_data) override;
+
+      /**
+       * Process a batch of samples by running each of them through all
+       * stages of the pipeline.
+       */
+      virtual
+      void
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data) override;
+
+      /**
+       * Wait for all samples to be processed. This calls the flush()
+       * functions of the base class and of all stages.
+       */
+      virtual
+      void
+      flush () override;
+
+      /**
+       * Return a reference to the stage with index `stage_index`, where the
+       * filters are numbered starting at zero in the order in which they
+       * appear in the pipeline, and the final consumer has index
+       * `sizeof...(StageTypes)-1`. This is how one accesses, for
+       * example, the result of a consumer that has been moved into the
+       * pipeline.
+       */
+      template <std::size_t stage_index>
+      std::remove_reference_t<std::tuple_element_t<stage_index, std::tuple<StageTypes...>>> &
+      get_stage ();
+
+    private:
+      /**
+       * The stages of the pipeline, either as objects or as references.
+       */
+      std::tuple<StageTypes...> stages;
+
+      /**
+       * Pass a sample to the stage with index `stage_index` and, if that
+       * stage is a filter that lets the sample pass, recursively on to
+       * the next stage.
+       */
+      template <std::size_t stage_index, typename SampleType>
+      void
+      process_sample (SampleType &&sample,
+                      AuxiliaryData &&aux_data);
+  };
+
+
+
+  /**
+   * A class that represents a pipeline under construction, i.e., a producer
+   * followed by zero or more filters but not yet by a consumer. Objects of
+   * this type are created by calling the fuse() function, extended by
+   * additional filters via `operator>>`, and finally turned into a
+   * FusedPipeline object by applying `operator>>` with a consumer that is
+   * not a filter. See the FusedPipeline class for an example.
+   *
+   * The class does not allow anything else with its objects, and is not
+   * itself a Producer or Consumer.
+   *
+   * @tparam ProducerType The type of the producer at the start of the pipeline.
+   * @tparam FilterTypes The types of the filters that have been appended so
+   *   far; see the corresponding template argument of the FusedPipeline class.
+   */
+  template <typename ProducerType, typename ... FilterTypes>
+  class FusedPipelineHead
+  {
+    public:
+      /**
+       * The type of samples that come out at the end of the pipeline
+       * built so far.
+       */
+      using output_type
+        = typename std::remove_reference_t<std::tuple_element_t<sizeof...(FilterTypes),
+          std::tuple<ProducerType,FilterTypes...>>>::output_type;
+
+      /**
+       * Constructor.
+       */
+      FusedPipelineHead (ProducerType              &producer,
+                         std::tuple<FilterTypes...> &&filters);
+
+      /**
+       * A reference to the producer at the start of the pipeline.
+       */
+      ProducerType &producer;
+
+      /**
+       * The filters appended to the pipeline so far, either as objects
+       * or as references.
+       */
+      std::tuple<FilterTypes...> filters;
+  };
+
+
+
+  /**
+   * Start building a FusedPipeline connected to the given producer by
+   * writing code such as
+   * @code
+   *   auto pipeline = SampleFlow::fuse(producer) >> filter >> consumer;
+   * @endcode
+   * See the documentation of the FusedPipeline class for more information.
+   */
+  template <typename ProducerType>
+  requires (Concepts::is_producer<ProducerType>)
+  FusedPipelineHead<ProducerType>
+  fuse (ProducerType &producer);
+
+
+
+  /**
+   * Append a filter to a pipeline under construction.
+   */
+  template <typename ProducerType, typename ... FilterTypes, typename RightType>
+  requires (Concepts::is_filter<std::remove_reference_t<RightType>> &&
+            std::same_as<typename FusedPipelineHead<ProducerType,FilterTypes...>::output_type,
+            typename std::remove_reference_t<RightType>::input_type>)
+  FusedPipelineHead<ProducerType,FilterTypes...,RightType>
+  operator>> (FusedPipelineHead<ProducerType,FilterTypes...> &&head,
+              RightType &&filter);
+
+
+
+  /**
+   * Complete a pipeline under construction by appending a consumer that
+   * is not a filter. The returned object is connected to the producer at
+   * the start of the pipeline and needs to be kept alive for as long as
+   * samples are supposed to flow through the pipeline.
+   */
+  template <typename ProducerType, typename ... FilterTypes, typename RightType>
+  requires (Concepts::is_consumer<std::remove_reference_t<RightType>> &&
+            !Concepts::is_filter<std::remove_reference_t<RightType>> &&
+            std::same_as<typename FusedPipelineHead<ProducerType,FilterTypes...>::output_type,
+            typename std::remove_reference_t<RightType>::input_type>)
+  FusedPipeline<typename ProducerType::output_type,FilterTypes...,RightType>
+  operator>> (FusedPipelineHead<ProducerType,FilterTypes...> &&head,
+              RightType &&consumer);
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  FusedPipeline<InputType,StageTypes...>::
+  FusedPipeline (Producer<InputType>        &producer,
+                 std::tuple<StageTypes...> &&stages)
+    :
+    stages (std::move(stages))
+  {
+    static_assert (sizeof...(StageTypes) >= 1,
+                   "A pipeline needs to end in a consumer.");
+
+    this->connect_to_producer (producer);
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  FusedPipeline<InputType,StageTypes...>::
+  ~FusedPipeline ()
+  {
+    this->disconnect_and_flush();
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  void
+  FusedPipeline<InputType,StageTypes...>::
+  consume (InputType sample,
+           AuxiliaryData aux_data)
+  {
+    process_sample<0> (std::move(sample), std::move(aux_data));
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  void
+  FusedPipeline<InputType,StageTypes...>::
+  consume_batch (const std::vector<InputType> &samples,
+                 const std::vector<AuxiliaryData> &aux_data)
+  {
+    assert (samples.size() == aux_data.size());
+
+    for (std::size_t i=0; i<samples.size(); ++i)
+      process_sample<0> (Utilities::copy_sample (samples[i]), AuxiliaryData(aux_data[i]));
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  void
+  FusedPipeline<InputType,StageTypes...>::
+  flush ()
+  {
+    // First wait for all samples this object has received to be
+    // processed, then give the stages the opportunity to
+    // do the same:
+    Consumer<InputType>::flush();
+
+    std::apply ([](auto &... stage)
+    {
+      (stage.flush(), ...);
+    },
+    stages);
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  template <std::size_t stage_index>
+  std::remove_reference_t<std::tuple_element_t<stage_index, std::tuple<StageTypes...>>> &
+  FusedPipeline<InputType,StageTypes...>::
+  get_stage ()
+  {
+    return std::get<stage_index>(stages);
+  }
+
+
+
+  template <typename InputType, typename ... StageTypes>
+  template <std::size_t stage_index, typename SampleType>
+  void
+  FusedPipeline<InputType,StageTypes...>::
+  process_sample (SampleType &&sample,
+                  AuxiliaryData &&aux_data)
+  {
+    using StageType = std::remove_reference_t<std::tuple_element_t<stage_index, std::tuple<StageTypes...>>>;
+    StageType &stage = std::get<stage_index>(stages);
+
+    // Call the functions of the stage by their qualified names. This
+    // suppresses the virtual function call mechanism and allows the
+    // compiler to inline the call.
+    if constexpr (stage_index < sizeof...(StageTypes)-1)
+      {
+        static_assert (Concepts::is_filter<StageType>,
+                       "All but the last stage of a pipeline need to be filters.");
+
+        auto maybe_sample = stage.StageType::filter (std::move(sample), std::move(aux_data));
+        if (maybe_sample)
+          process_sample<stage_index+1> (std::move(maybe_sample->first),
+                                         std::move(maybe_sample->second));
+      }
+    else
+      stage.StageType::consume (std::move(sample), std::move(aux_data));
+  }
+
+
+
+  template <typename ProducerType, typename ... FilterTypes>
+  FusedPipelineHead<ProducerType,FilterTypes...>::
+  FusedPipelineHead (ProducerType              &producer,
+                     std::tuple<FilterTypes...> &&filters)
+    :
+    producer (producer),
+    filters (std::move(filters))
+  {}
+
+
+
+  template <typename ProducerType>
+  requires (Concepts::is_producer<ProducerType>)
+  FusedPipelineHead<ProducerType>
+  fuse (ProducerType &producer)
+  {
+    return FusedPipelineHead<ProducerType> (producer, std::tuple<>());
+  }
+
+
+
+  template <typename ProducerType, typename ... FilterTypes, typename RightType>
+  requires (Concepts::is_filter<std::remove_reference_t<RightType>> &&
+            std::same_as<typename FusedPipelineHead<ProducerType,FilterTypes...>::output_type,
+            typename std::remove_reference_t<RightType>::input_type>)
+  FusedPipelineHead<ProducerType,FilterTypes...,RightType>
+  operator>> (FusedPipelineHead<ProducerType,FilterTypes...> &&head,
+              RightType &&filter)
+  {
+    return FusedPipelineHead<ProducerType,FilterTypes...,RightType>
+           (head.producer,
+            std::tuple_cat (std::move(head.filters),
+                            std::tuple<RightType>(std::forward<RightType>(filter))));
+  }
+
+
+
+  template <typename ProducerType, typename ... FilterTypes, typename RightType>
+  requires (Concepts::is_consumer<std::remove_reference_t<RightType>> &&
+            !Concepts::is_filter<std::remove_reference_t<RightType>> &&
+            std::same_as<typename FusedPipelineHead<ProducerType,FilterTypes...>::output_type,
+            typename std::remove_reference_t<RightType>::input_type>)
+  FusedPipeline<typename ProducerType::output_type,FilterTypes...,RightType>
+  operator>> (FusedPipelineHead<ProducerType,FilterTypes...> &&head,
+              RightType &&consumer)
+  {
+    return FusedPipeline<typename ProducerType::output_type,FilterTypes...,RightType>
+           (head.producer,
+            std::tuple_cat (std::move(head.filters),
+                            std::tuple<RightType>(std::forward<RightType>(consumer))));
+  }
+}
@@ -0,0 +1,574 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace HDF5
+  {
+    namespace Consumers
+    {
+      /**
+       * A Consumer class that writes the samples it receives, along with
+       * selected entries of their auxiliary data, into an HDF5 file laid out
+       * as described in the documentation of namespace HDF5. The file can
+       * be read again using HDF5::Producers::ChainFile.
+       *
+       * The datasets in the file are stored in chunks of `chunk_size`
+       * samples, and each chunk is compressed. In the `samples` dataset,
+       * each chunk contains only one component of the samples, i.e., the
+       * file is stored by columns: Because consecutive values of a
+       * component of a Markov chain are similar (and are often exactly
+       * the same), this compresses considerably better than storing
+       * complete samples together, and it allows reading the values of
+       * only a few components without decompressing the others.
+       *
+       * Optionally, the values of all datasets can be encoded before they
+       * are compressed, as described for HDF5::Encoding.
+       *
+       * The class collects samples in memory until it has a complete chunk.
+       * The chunk is then handed to a separate thread that encodes and
+       * compresses it and writes it to the file, so that the thread that
+       * sends samples to this object only has to copy the sample into
+       * memory. At most two
+       * chunks are waiting to be written at any given time; if the writer
+       * thread falls behind, consume() waits for it. Once flush() has been
+       * called, all samples received so far have been written to the file.
+       *
+       *
+       * ### Threading model ###
+       *
+       * The implementation of this class is thread-safe, i.e., its
+       * consume() member function can be called concurrently and from
+       * multiple threads. The functions of the HDF5 library are only called
+       * from one thread at a time, so that this class does not require an
+       * HDF5 library built with thread-safety enabled.
+       *
+       *
+       * @tparam InputType The C++ type used for the samples $x_k$. Its
+       *   scalar type (see types::ScalarType) needs to be an arithmetic
+       *   type.
+       */
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      class ChainOutput : public Consumer<InputType>
+      {
+        public:
+          /**
+           * The type of the scalars that make up a sample.
+           */
+          using scalar_type = types::ScalarType<InputType>;
+
+          /**
+           * Constructor. Create the given file, overwriting it if it
+           * already exists.
+           *
+           * @param[in] filename The name of the file to write to.
+           * @param[in] aux_data_columns The entries of the auxiliary data of
+           *   each sample that should be stored along with the sample, and
+           *   the types as which they should be stored. Samples for which an
+           *   entry does not exist are treated as described for
+           *   ChainFileFormat::write_column().
+           * @param[in] chunk_size The number of samples in each chunk of
+           *   the datasets in the file.
+           * @param[in] compression_level The level (between zero and nine)
+           *   with which chunks are compressed using the "deflate" algorithm
+           *   of the zlib library. Zero means that chunks are not
+           *   compressed.
+           * @param[in] encoding How values are encoded before they are
+           *   compressed.
+           */
+          ChainOutput (const std::string                          &filename,
+                       const std::vector<ChainFileFormat::Column> &aux_data_columns = {},
+                       const std::size_t                           chunk_size = 4096,
+                       const unsigned int                          compression_level = 4,
+                       const Encoding                              encoding = Encoding::none);
+
+          /**
+           * Destructor. This function also makes sure that all samples this
+           * object may have received have been fully processed and written
+           * to the file, and then closes the file.
+           */
+          virtual ~ChainOutput ();
+
+          /**
+           * Process one sample by copying it, and the selected entries of
+           * its auxiliary data, into the current chunk.
+           *
+           * @param[in] sample The sample to process.
+           * @param[in] aux_data Auxiliary data about this sample.
+           */
+          virtual
+          void
+          consume (InputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * Finish processing all samples this object has received, as
+           * documented in Consumer::flush(), then hand the partially
+           * filled chunk to the writer thread, wait for all chunks to be
+           * written, and flush the file.
+           */
+          virtual
+          void
+          flush () override;
+
+        private:
+          /**
+           * A structure that holds the data of a chunk of samples: the
+           * components of the samples, stored sample by sample, and for
+           * each auxiliary data column the eight bytes
+           * ChainFileFormat::write_column() produces for each sample.
+           */
+          struct Chunk
+          {
+            std::size_t                    n_samples = 0;
+            std::vector<scalar_type>       samples;
+            std::vector<std::vector<char>> columns;
+          };
+
+          /**
+           * A mutex used to lock access to the current chunk and the
+           * dimension of samples when running on multiple threads.
+           */
+          mutable std::mutex mutex;
+
+          /**
+           * The auxiliary data columns to be written, and how to write
+           * them.
+           */
+          const std::vector<ChainFileFormat::Column> aux_data_columns;
+          const std::size_t                          chunk_size;
+          const unsigned int                         compression_level;
+          const Encoding                             encoding;
+
+          /**
+           * The number of components of samples. This is determined by the
+           * first sample; before that, it is zero.
+           */
+          std::size_t dimension;
+
+          /**
+           * The chunk into which consume() copies samples.
+           */
+          Chunk current_chunk;
+
+          /**
+           * A mutex and condition variable that guard the member variables
+           * below and that the writer thread uses to wait for work.
+           */
+          std::mutex              writer_mutex;
+          std::condition_variable writer_state_changed;
+
+          /**
+           * Chunks that are waiting to be written, and chunks that have been
+           * written and whose memory can be reused.
+           */
+          std::deque<Chunk>  full_chunks;
+          std::vector<Chunk> spare_chunks;
+
+          /**
+           * Whether the writer thread is currently writing a chunk, and
+           * whether the destructor has asked the writer thread to stop.
+           */
+          bool is_writing;
+          bool shutting_down;
+
+          /**
+           * The file and its datasets. The datasets are created when the
+           * first chunk is written. Once the writer thread has been
+           * started, these objects are only accessed on that thread.
+           */
+          Handle              file;
+          Handle              samples_dataset;
+          std::vector<Handle> column_datasets;
+
+          /**
+           * The number of samples that have been written to the file.
+           */
+          std::size_t n_written_samples;
+
+          /**
+           * For Encoding::xor_with_previous, the last sample and the last
+           * entries of the auxiliary data columns that have been written,
+           * against which the next ones are encoded. Only accessed on the
+           * writer thread.
+           */
+          std::vector<char>              previous_sample;
+          std::vector<std::vector<char>> previous_columns;
+
+          /**
+           * The thread that writes chunks to the file.
+           */
+          std::thread writer;
+
+          /**
+           * The maximal number of chunks waiting to be written.
+           */
+          static constexpr std::size_t max_pending_chunks = 2;
+
+          /**
+           * Hand the current chunk to the writer thread, waiting if too many
+           * chunks are already waiting to be written, and start a new one.
+           * The caller needs to hold `mutex`.
+           */
+          void
+          hand_off_chunk ();
+
+          /**
+           * The function run by the writer thread.
+           */
+          void
+          writer_loop ();
+
+          /**
+           * Create the datasets of the file. Called by the writer thread
+           * before it writes the first chunk.
+           */
+          void
+          create_datasets ();
+
+          /**
+           * Append the samples of the given chunk to the datasets of the
+           * file. The chunk is encoded in place, if so requested.
+           */
+          void
+          write_chunk (Chunk &chunk);
+      };
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      ChainOutput<InputType>::
+      ChainOutput (const std::string                          &filename,
+                   const std::vector<ChainFileFormat::Column> &aux_data_columns,
+                   const std::size_t                           chunk_size,
+                   const unsigned int                          compression_level,
+                   const Encoding                              encoding)
+        :
+        Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                         |
+                                         static_cast<int>(ParallelMode::asynchronous))),
+        aux_data_columns (aux_data_columns),
+        chunk_size (chunk_size),
+        compression_level (compression_level),
+        encoding (encoding),
+        dimension (0),
+        is_writing (false),
+        shutting_down (false),
+        file (H5Fcreate (filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT),
+              &H5Fclose),
+        n_written_samples (0)
+      {
+        assert (chunk_size > 0);
+        assert (compression_level <= 9);
+
+        // Dataset names cannot contain slashes, since these separate
+        // groups in HDF5 paths:
+        for (const ChainFileFormat::Column &column : aux_data_columns)
+          assert (column.key.name().find('/') == std::string::npos);
+
+        current_chunk.columns.resize (aux_data_columns.size());
+
+        writer = std::thread ([this]()
+        {
+          writer_loop ();
+        });
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      ChainOutput<InputType>::
+      ~ChainOutput ()
+      {
+        this->disconnect_and_flush();
+
+        {
+          std::lock_guard<std::mutex> lock (writer_mutex);
+          shutting_down = true;
+        }
+        writer_state_changed.notify_all();
+
+        writer.join();
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      consume (InputType sample, AuxiliaryData aux_data)
+      {
+        const std::unique_lock<std::mutex> lock = this->lock_state (mutex);
+
+        const std::size_t sample_dimension = Utilities::size(sample);
+        if (dimension == 0)
+          dimension = sample_dimension;
+        assert (sample_dimension == dimension);
+
+        for (std::size_t i=0; i<dimension; ++i)
+          current_chunk.samples.push_back (Utilities::get_nth_element (sample, i));
+
+        for (std::size_t c=0; c<aux_data_columns.size(); ++c)
+          {
+            std::vector<char> &column = current_chunk.columns[c];
+            column.resize (column.size() + 8);
+            ChainFileFormat::write_column (aux_data, aux_data_columns[c],
+                                           column.data() + column.size() - 8);
+          }
+
+        ++current_chunk.n_samples;
+        if (current_chunk.n_samples == chunk_size)
+          hand_off_chunk ();
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      flush ()
+      {
+        Consumer<InputType>::flush();
+
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          if (current_chunk.n_samples > 0)
+            hand_off_chunk ();
+        }
+
+        std::unique_lock<std::mutex> lock (writer_mutex);
+        writer_state_changed.wait (lock, [this]()
+        {
+          return (full_chunks.empty() && (is_writing == false));
+        });
+
+        // Now that the writer thread is idle, we can call into the HDF5
+        // library ourselves:
+        [[maybe_unused]] const herr_t ierr = H5Fflush (file, H5F_SCOPE_LOCAL);
+        assert (ierr >= 0);
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      hand_off_chunk ()
+      {
+        {
+          std::unique_lock<std::mutex> lock (writer_mutex);
+          writer_state_changed.wait (lock, [this]()
+          {
+            return (full_chunks.size() < max_pending_chunks);
+          });
+
+          full_chunks.emplace_back (std::move(current_chunk));
+
+          // Reuse the memory of a chunk that has already been written, if
+          // there is one:
+          if (spare_chunks.size() > 0)
+            {
+              current_chunk = std::move(spare_chunks.back());
+              spare_chunks.pop_back();
+            }
+          else
+            current_chunk = Chunk();
+        }
+        writer_state_changed.notify_all();
+
+        current_chunk.n_samples = 0;
+        current_chunk.samples.clear();
+        current_chunk.samples.reserve (chunk_size * dimension);
+        current_chunk.columns.resize (aux_data_columns.size());
+        for (std::vector<char> &column : current_chunk.columns)
+          {
+            column.clear();
+            column.reserve (chunk_size * 8);
+          }
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      writer_loop ()
+      {
+        while (true)
+          {
+            Chunk chunk;
+            {
+              // Wait until there is something to write, or until we are
+              // asked to shut down and there is nothing left to write:
+              std::unique_lock<std::mutex> lock (writer_mutex);
+              writer_state_changed.wait (lock, [this]()
+              {
+                return (shutting_down || (full_chunks.size() > 0));
+              });
+              if (full_chunks.size() == 0)
+                return;
+
+              chunk = std::move(full_chunks.front());
+              full_chunks.pop_front();
+              is_writing = true;
+            }
+
+            write_chunk (chunk);
+
+            {
+              std::lock_guard<std::mutex> lock (writer_mutex);
+              is_writing = false;
+              spare_chunks.emplace_back (std::move(chunk));
+            }
+            writer_state_changed.notify_all();
+          }
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      create_datasets ()
+      {
+        // The samples are stored by columns, see the class documentation.
+        // All datasets can grow without bounds in the number of samples.
+        const auto create_dataset = [this](const hid_t location,
+                                           const std::string &name,
+                                           const hid_t type,
+                                           const std::size_t n_columns)
+        {
+          const int rank = (n_columns == 0 ? 1 : 2);
+          const std::array<hsize_t,2> initial_size = {{0, n_columns}};
+          const std::array<hsize_t,2> maximal_size = {{H5S_UNLIMITED, n_columns}};
+          const std::array<hsize_t,2> chunk_dimensions = {{chunk_size, 1}};
+
+          const Handle dataspace (H5Screate_simple (rank, initial_size.data(), maximal_size.data()),
+                                  &H5Sclose);
+          const Handle properties (H5Pcreate (H5P_DATASET_CREATE), &H5Pclose);
+          [[maybe_unused]] herr_t ierr = H5Pset_chunk (properties, rank, chunk_dimensions.data());
+          assert (ierr >= 0);
+          if (compression_level > 0)
+            {
+              // Reordering the bytes of the values so that the first bytes
+              // of all values come first, then the second bytes, etc.,
+              // makes the data easier to compress:
+              ierr = H5Pset_shuffle (properties);
+              assert (ierr >= 0);
+              ierr = H5Pset_deflate (properties, compression_level);
+              assert (ierr >= 0);
+            }
+
+          Handle dataset (H5Dcreate2 (location, name.c_str(), type, dataspace,
+                                      H5P_DEFAULT, properties, H5P_DEFAULT),
+                          &H5Dclose);
+          if (encoding != Encoding::none)
+            write_attribute (dataset, encoding_attribute,
+                             static_cast<std::uint32_t>(encoding));
+          return dataset;
+        };
+
+        samples_dataset = create_dataset (file, "samples", native_type<scalar_type>(), dimension);
+
+        if (aux_data_columns.size() > 0)
+          {
+            // Keep track of the order in which the datasets are created so
+            // that they can be read in the same order:
+            const Handle properties (H5Pcreate (H5P_GROUP_CREATE), &H5Pclose);
+            [[maybe_unused]] herr_t ierr
+              = H5Pset_link_creation_order (properties,
+                                            H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+            assert (ierr >= 0);
+            const Handle group (H5Gcreate2 (file, "aux_data", H5P_DEFAULT, properties, H5P_DEFAULT),
+                                &H5Gclose);
+
+            for (const ChainFileFormat::Column &column : aux_data_columns)
+              {
+                column_datasets.emplace_back (create_dataset (group, column.key.name(),
+                                                              column_type (column.type), 0));
+                write_attribute (column_datasets.back(), column_type_attribute,
+                                 static_cast<std::uint32_t>(column.type));
+              }
+          }
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<types::ScalarType<InputType>>)
+      void
+      ChainOutput<InputType>::
+      write_chunk (Chunk &chunk)
+      {
+        if (n_written_samples == 0)
+          {
+            create_datasets ();
+            previous_columns.resize (aux_data_columns.size());
+          }
+
+        if (encoding == Encoding::xor_with_previous)
+          {
+            internal::xor_encode (reinterpret_cast<char *>(chunk.samples.data()),
+                                  chunk.n_samples, dimension * sizeof(scalar_type),
+                                  n_written_samples, chunk_size, previous_sample);
+            for (std::size_t c=0; c<aux_data_columns.size(); ++c)
+              internal::xor_encode (chunk.columns[c].data(), chunk.n_samples, 8,
+                                    n_written_samples, chunk_size, previous_columns[c]);
+          }
+
+        // Grow each dataset by the number of samples in the chunk, and write
+        // the chunk into the newly added rows:
+        const auto append = [this, &chunk](const hid_t dataset,
+                                           const hid_t type,
+                                           const void *data,
+                                           const std::size_t n_columns)
+        {
+          const int rank = (n_columns == 0 ? 1 : 2);
+          const std::array<hsize_t,2> new_size = {{n_written_samples + chunk.n_samples, n_columns}};
+          const std::array<hsize_t,2> start = {{n_written_samples, 0}};
+          const std::array<hsize_t,2> count = {{chunk.n_samples, n_columns}};
+
+          [[maybe_unused]] herr_t ierr = H5Dset_extent (dataset, new_size.data());
+          assert (ierr >= 0);
+
+          const Handle file_space (H5Dget_space (dataset), &H5Sclose);
+          ierr = H5Sselect_hyperslab (file_space, H5S_SELECT_SET,
+                                      start.data(), nullptr, count.data(), nullptr);
+          assert (ierr >= 0);
+          const Handle memory_space (H5Screate_simple (rank, count.data(), nullptr),
+                                     &H5Sclose);
+
+          ierr = H5Dwrite (dataset, type, memory_space, file_space, H5P_DEFAULT, data);
+          assert (ierr >= 0);
+        };
+
+        append (samples_dataset, native_type<scalar_type>(), chunk.samples.data(), dimension);
+        for (std::size_t c=0; c<aux_data_columns.size(); ++c)
+          append (column_datasets[c], column_type (aux_data_columns[c].type),
+                  chunk.columns[c].data(), 0);
+
+        n_written_samples += chunk.n_samples;
+      }
+    }
+  }
+}
@@ -0,0 +1,397 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace HDF5
+  {
+    namespace Producers
+    {
+      /**
+       * A producer that reads samples, and the auxiliary data stored along
+       * with them, from an HDF5 file laid out as described in the
+       * documentation of namespace HDF5 (for example, one written by
+       * HDF5::Consumers::ChainOutput), and sends them downstream. This is the
+       * counterpart of Producers::ChainFile for HDF5 files.
+       *
+       * Samples are read from the file in blocks of up to `max_batch_size`
+       * samples, which are then sent downstream as one batch. If the
+       * datasets in the file have been encoded (see HDF5::Encoding), they
+       * are decoded while reading; because decoding a row requires all
+       * previous rows of the same chunk, this means that reading only
+       * every `stride`th sample is then not much cheaper than reading all
+       * of them. Encoded files can also only be read if the scalar type of
+       * `OutputType` is the type of the values stored in the file. If the scalar
+       * type stored in the file differs from the scalar type of
+       * `OutputType`, the HDF5 library converts the values while reading.
+       *
+       * @tparam OutputType The type of the samples this producer creates.
+       *   Its scalar type (see types::ScalarType) needs to be an arithmetic
+       *   type. If the type has a `resize()` member function, samples are
+       *   resized to the number of components stored in the file; otherwise,
+       *   samples need to have the right size upon default construction.
+       */
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      class ChainFile : public Producer<OutputType>
+      {
+        public:
+          /**
+           * The type of the scalars that make up a sample.
+           */
+          using scalar_type = types::ScalarType<OutputType>;
+
+          /**
+           * Constructor. Open the given file and find out what it contains.
+           *
+           * @param[in] filename The name of the file to read from.
+           */
+          ChainFile (const std::string &filename);
+
+          /**
+           * Return the number of samples stored in the file.
+           */
+          std::size_t
+          n_samples () const;
+
+          /**
+           * Return the number of components of each sample.
+           */
+          std::size_t
+          dimension () const;
+
+          /**
+           * Return the auxiliary data columns stored in the file, in the
+           * order in which they were written.
+           */
+          const std::vector<ChainFileFormat::Column> &
+          columns () const;
+
+          /**
+           * Send the samples with indices `begin`, `begin+stride`,
+           * `begin+2*stride`, ... up to (but excluding) `end` downstream,
+           * in batches of up to `max_batch_size` samples.
+           *
+           * @param[in] begin The index of the first sample to send downstream.
+           * @param[in] end The index one past the last sample to consider. If
+           *   larger than the number of samples in the file (as is the
+           *   default), then all samples up to the end of the file are
+           *   considered.
+           * @param[in] stride Only send every `stride`th sample downstream.
+           */
+          void
+          sample (const std::size_t begin = 0,
+                  const std::size_t end = std::numeric_limits<std::size_t>::max(),
+                  const std::size_t stride = 1);
+
+          /**
+           * The maximal number of samples read from the file, and sent
+           * downstream, at once.
+           */
+          static constexpr std::size_t max_batch_size = 4096;
+
+        private:
+          /**
+           * The file and its datasets.
+           */
+          Handle              file;
+          Handle              samples_dataset;
+          std::vector<Handle> column_datasets;
+
+          /**
+           * How the datasets are encoded, and the number of rows in their
+           * chunks.
+           */
+          Encoding    encoding;
+          std::size_t chunk_rows;
+
+          /**
+           * The number of samples in the file, the number of components of
+           * each sample, and the auxiliary data columns.
+           */
+          std::size_t                          n_stored_samples;
+          std::size_t                          n_components;
+          std::vector<ChainFileFormat::Column> aux_data_columns;
+
+          /**
+           * Read `count` rows with indices `first`, `first+stride`, ... from
+           * the given dataset, which has `n_columns` columns (or is
+           * one-dimensional, if `n_columns` is zero) of values of the given
+           * type and size, into `data`. If the file is encoded, decode the
+           * rows.
+           */
+          void
+          read_rows (const hid_t       dataset,
+                     const hid_t       type,
+                     const std::size_t value_size,
+                     const std::size_t first,
+                     const std::size_t count,
+                     const std::size_t stride,
+                     const std::size_t n_columns,
+                     char             *data) const;
+      };
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      ChainFile<OutputType>::
+      ChainFile (const std::string &filename)
+        :
+        file (H5Fopen (filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), &H5Fclose),
+        encoding (Encoding::none),
+        chunk_rows (0),
+        n_stored_samples (0),
+        n_components (0)
+      {
+        // A file to which no samples have been written does not have any
+        // datasets:
+        if (H5Lexists (file, "samples", H5P_DEFAULT) <= 0)
+          return;
+
+        samples_dataset = Handle (H5Dopen2 (file, "samples", H5P_DEFAULT), &H5Dclose);
+        {
+          const Handle dataspace (H5Dget_space (samples_dataset), &H5Sclose);
+          assert (H5Sget_simple_extent_ndims (dataspace) == 2);
+
+          std::array<hsize_t,2> size;
+          H5Sget_simple_extent_dims (dataspace, size.data(), nullptr);
+          n_stored_samples = size[0];
+          n_components     = size[1];
+        }
+
+        // The encoding is the same for all datasets:
+        encoding = static_cast<Encoding>(read_attribute (samples_dataset, encoding_attribute,
+                                                         static_cast<std::uint32_t>(Encoding::none)));
+        {
+          const Handle properties (H5Dget_create_plist (samples_dataset), &H5Pclose);
+          std::array<hsize_t,2> chunk_dimensions;
+          if (H5Pget_chunk (properties, 2, chunk_dimensions.data()) == 2)
+            chunk_rows = chunk_dimensions[0];
+        }
+        assert ((encoding == Encoding::none) || (chunk_rows > 0));
+
+        if (H5Lexists (file, "aux_data", H5P_DEFAULT) <= 0)
+          return;
+
+        const Handle group (H5Gopen2 (file, "aux_data", H5P_DEFAULT), &H5Gclose);
+        H5G_info_t group_info;
+        [[maybe_unused]] herr_t ierr = H5Gget_info (group, &group_info);
+        assert (ierr >= 0);
+
+        for (hsize_t i=0; i<group_info.nlinks; ++i)
+          {
+            // Get the name of the dataset, which is the name of the key:
+            const ssize_t length = H5Lget_name_by_idx (group, ".", H5_INDEX_CRT_ORDER, H5_ITER_INC,
+                                                       i, nullptr, 0, H5P_DEFAULT);
+            assert (length >= 0);
+            std::string name (length, '\0');
+            H5Lget_name_by_idx (group, ".", H5_INDEX_CRT_ORDER, H5_ITER_INC,
+                                i, name.data(), length+1, H5P_DEFAULT);
+
+            column_datasets.emplace_back (H5Dopen2 (group, name.c_str(), H5P_DEFAULT), &H5Dclose);
+
+            const std::uint32_t type
+              = read_attribute (column_datasets.back(), column_type_attribute,
+                                static_cast<std::uint32_t>(ChainFileFormat::ColumnType::floating_point));
+            aux_data_columns.push_back ({AuxiliaryData::Key (name),
+                                         static_cast<ChainFileFormat::ColumnType>(type)});
+          }
+      }
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      std::size_t
+      ChainFile<OutputType>::
+      n_samples () const
+      {
+        return n_stored_samples;
+      }
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      std::size_t
+      ChainFile<OutputType>::
+      dimension () const
+      {
+        return n_components;
+      }
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      const std::vector<ChainFileFormat::Column> &
+      ChainFile<OutputType>::
+      columns () const
+      {
+        return aux_data_columns;
+      }
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      void
+      ChainFile<OutputType>::
+      read_rows (const hid_t       dataset,
+                 const hid_t       type,
+                 const std::size_t value_size,
+                 const std::size_t first,
+                 const std::size_t count,
+                 const std::size_t stride,
+                 const std::size_t n_columns,
+                 char             *data) const
+      {
+        const int rank = (n_columns == 0 ? 1 : 2);
+        const auto read = [&](const std::size_t first,
+                              const std::size_t count,
+                              const std::size_t stride,
+                              void             *data)
+        {
+          const std::array<hsize_t,2> start      = {{first, 0}};
+          const std::array<hsize_t,2> row_stride = {{stride, 1}};
+          const std::array<hsize_t,2> n_elements = {{count, n_columns}};
+
+          const Handle file_space (H5Dget_space (dataset), &H5Sclose);
+          [[maybe_unused]] herr_t ierr
+            = H5Sselect_hyperslab (file_space, H5S_SELECT_SET,
+                                   start.data(), row_stride.data(), n_elements.data(), nullptr);
+          assert (ierr >= 0);
+          const Handle memory_space (H5Screate_simple (rank, n_elements.data(), nullptr),
+                                     &H5Sclose);
+
+          ierr = H5Dread (dataset, type, memory_space, file_space, H5P_DEFAULT, data);
+          assert (ierr >= 0);
+        };
+
+        if (encoding == Encoding::none)
+          {
+            read (first, count, stride, data);
+            return;
+          }
+
+        // Encoded values can only be decoded in the type in which they were
+        // stored, so the HDF5 library must not convert them while
+        // reading:
+        {
+          const Handle stored_type (H5Dget_type (dataset), &H5Tclose);
+          assert (H5Tequal (stored_type, type) > 0);
+        }
+
+        // For encoded datasets, read and decode one chunk at a time, from
+        // the beginning of the chunk up to the last requested row in it,
+        // and then pick out the requested rows:
+        const std::size_t row_size = std::max<std::size_t>(n_columns, 1) * value_size;
+        std::vector<char> decoded_rows;
+        for (std::size_t n_read=0; n_read<count; )
+          {
+            const std::size_t row         = first + n_read*stride;
+            const std::size_t chunk_begin = row - row % chunk_rows;
+            const std::size_t chunk_end   = std::min (chunk_begin + chunk_rows, n_stored_samples);
+
+            // The requested rows in this chunk are 'row', 'row+stride', ...:
+            const std::size_t n_rows_in_chunk = std::min ((chunk_end - row + stride - 1) / stride,
+                                                          count - n_read);
+            const std::size_t last_row = row + (n_rows_in_chunk-1)*stride;
+
+            decoded_rows.resize ((last_row - chunk_begin + 1) * row_size);
+            read (chunk_begin, last_row - chunk_begin + 1, 1, decoded_rows.data());
+            internal::xor_decode (decoded_rows.data(), last_row - chunk_begin + 1,
+                                  row_size, chunk_rows);
+
+            for (std::size_t i=0; i<n_rows_in_chunk; ++i)
+              std::memcpy (data + (n_read+i)*row_size,
+                           decoded_rows.data() + (row + i*stride - chunk_begin)*row_size,
+                           row_size);
+            n_read += n_rows_in_chunk;
+          }
+      }
+
+
+
+      template <typename OutputType>
+      requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+      void
+      ChainFile<OutputType>::
+      sample (const std::size_t begin,
+              const std::size_t end,
+              const std::size_t stride)
+      {
+        assert (stride >= 1);
+
+        Utilities::ScopeExit scope_exit ([this]()
+        {
+          this->flush_consumers();
+          this->clear_stop_request();
+        });
+
+        const std::size_t last = std::min (end, n_stored_samples);
+        if (begin >= last)
+          return;
+
+        std::vector<scalar_type>       sample_data;
+        std::vector<std::vector<char>> column_data (aux_data_columns.size());
+
+        const std::size_t n_selected = (last - begin + stride - 1) / stride;
+        for (std::size_t n_sent=0; n_sent<n_selected; )
+          {
+            const std::size_t first = begin + n_sent * stride;
+            const std::size_t count = std::min (max_batch_size, n_selected - n_sent);
+
+            sample_data.resize (count * n_components);
+            read_rows (samples_dataset, native_type<scalar_type>(), sizeof(scalar_type),
+                       first, count, stride, n_components,
+                       reinterpret_cast<char *>(sample_data.data()));
+            for (std::size_t c=0; c<aux_data_columns.size(); ++c)
+              {
+                column_data[c].resize (count * 8);
+                read_rows (column_datasets[c], column_type (aux_data_columns[c].type), 8,
+                           first, count, stride, 0, column_data[c].data());
+              }
+
+            // Convert what we have read into samples and auxiliary data:
+            std::vector<OutputType>    samples (count);
+            std::vector<AuxiliaryData> aux_data (count);
+            for (std::size_t s=0; s<count; ++s)
+              {
+                if constexpr (requires (OutputType &x) { x.resize (std::size_t()); })
+                  samples[s].resize (n_components);
+                assert (Utilities::size(samples[s]) == n_components);
+
+                for (std::size_t i=0; i<n_components; ++i)
+                  Utilities::get_nth_element (samples[s], i) = sample_data[s*n_components + i];
+
+                for (std::size_t c=0; c<aux_data_columns.size(); ++c)
+                  aux_data[s][aux_data_columns[c].key]
+                    = ChainFileFormat::read_column (column_data[c].data() + s*8,
+                                                    aux_data_columns[c].type);
+              }
+
+            this->issue_batch (samples, aux_data);
+            n_sent += count;
+
+            if (this->stop_requested())
+              return;
+          }
+      }
+    }
+  }
+}
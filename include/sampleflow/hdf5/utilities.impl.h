@@ -0,0 +1,399 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for classes that write samples to, and read them from,
+   * files in the HDF5 format. Unlike the simple binary format of namespace
+   * ChainFileFormat, HDF5 files store data in compressed chunks, can be
+   * read on any platform, and can be opened directly by many analysis
+   * tools (for example, the `h5py` package for Python). In the files
+   * written by HDF5::Consumers::ChainOutput, the samples are stored in a
+   * two-dimensional dataset called `samples` with one row per sample and
+   * one column per component of the samples, and each selected entry of the
+   * auxiliary data is stored in a one-dimensional dataset in the group
+   * `aux_data` whose name is the name of the key under which the entry is
+   * stored.
+   *
+   * Optionally, the values in a dataset can be encoded before they are
+   * compressed, see HDF5::Encoding. This makes use of the fact that
+   * successive samples of a Markov chain are often identical or similar,
+   * and can reduce the size of files considerably.
+   *
+   * Like the classes in namespace MPI, this part of the library is
+   * optional: It is only available if the files in the `sampleflow/hdf5/`
+   * directory are included explicitly, which in turn requires that the
+   * HDF5 header file `hdf5.h` is available and that programs are linked
+   * with the HDF5 library. It is also not part of the `SampleFlow` C++20
+   * module.
+   */
+  namespace HDF5
+  {
+    /**
+     * A class that owns an HDF5 identifier (of type `hid_t`) for a file,
+     * dataset, dataspace, property list, or similar and closes it when it
+     * is destroyed, using the function given to the constructor (for
+     * example, `H5Fclose` or `H5Dclose`). Objects of this class can be
+     * moved, but not copied.
+     */
+    class Handle
+    {
+      public:
+        /**
+         * Default constructor. The object does not own an identifier.
+         */
+        Handle ();
+
+        /**
+         * Constructor. Take ownership of the given identifier, which needs
+         * to be valid, and close it with the given function.
+         */
+        Handle (const hid_t id,
+                herr_t (*close_function)(hid_t));
+
+        /**
+         * Move constructor.
+         */
+        Handle (Handle &&other);
+
+        /**
+         * Copy constructor. Handles cannot be copied.
+         */
+        Handle (const Handle &) = delete;
+
+        /**
+         * Destructor. Close the identifier, if the object owns one.
+         */
+        ~Handle ();
+
+        /**
+         * Move assignment. Close the identifier owned by the current object,
+         * if any, and take over the one of the given object.
+         */
+        Handle &
+        operator= (Handle &&other);
+
+        /**
+         * Return the identifier, for use in functions of the HDF5 library.
+         */
+        operator hid_t () const;
+
+      private:
+        /**
+         * The identifier and the function with which it is closed.
+         */
+        hid_t id;
+        herr_t (*close_function)(hid_t);
+    };
+
+
+
+    /**
+     * Return the HDF5 data type that corresponds to the arithmetic C++
+     * type `T`.
+     */
+    template <typename T>
+    requires (std::is_arithmetic_v<T>)
+    hid_t
+    native_type ()
+    {
+      if constexpr (std::is_same_v<T, bool>)
+        return H5T_NATIVE_HBOOL;
+      else if constexpr (std::is_floating_point_v<T>)
+        {
+          if constexpr (sizeof(T) == sizeof(float))
+            return H5T_NATIVE_FLOAT;
+          else if constexpr (sizeof(T) == sizeof(double))
+            return H5T_NATIVE_DOUBLE;
+          else
+            return H5T_NATIVE_LDOUBLE;
+        }
+      else if constexpr (std::is_signed_v<T>)
+        {
+          if constexpr (sizeof(T) == 1)
+            return H5T_NATIVE_INT8;
+          else if constexpr (sizeof(T) == 2)
+            return H5T_NATIVE_INT16;
+          else if constexpr (sizeof(T) == 4)
+            return H5T_NATIVE_INT32;
+          else
+            return H5T_NATIVE_INT64;
+        }
+      else
+        {
+          if constexpr (sizeof(T) == 1)
+            return H5T_NATIVE_UINT8;
+          else if constexpr (sizeof(T) == 2)
+            return H5T_NATIVE_UINT16;
+          else if constexpr (sizeof(T) == 4)
+            return H5T_NATIVE_UINT32;
+          else
+            return H5T_NATIVE_UINT64;
+        }
+    }
+
+
+
+    /**
+     * Return the HDF5 data type of the values produced by
+     * ChainFileFormat::write_column() for a column of the given type. (This
+     * function writes each entry of the auxiliary data into eight bytes,
+     * as a `double`, `std::int64_t`, or `std::uint64_t`.)
+     */
+    inline
+    hid_t
+    column_type (const ChainFileFormat::ColumnType type)
+    {
+      switch (type)
+        {
+          case ChainFileFormat::ColumnType::floating_point:
+            return H5T_NATIVE_DOUBLE;
+          case ChainFileFormat::ColumnType::signed_integer:
+            return H5T_NATIVE_INT64;
+          case ChainFileFormat::ColumnType::unsigned_integer:
+          case ChainFileFormat::ColumnType::boolean:
+            return H5T_NATIVE_UINT64;
+          default:
+            assert (false);
+            return H5I_INVALID_HID;
+        }
+    }
+
+
+
+    /**
+     * An enum that describes how the values of a dataset are encoded before
+     * they are compressed.
+     */
+    enum class Encoding : std::uint32_t
+    {
+      /**
+       * Store values as they are.
+       */
+      none = 0,
+
+      /**
+       * Store each row of the dataset (i.e., each sample, or each entry of
+       * an auxiliary data column) as the bitwise exclusive-or ("XOR") of
+       * its bytes with the bytes of the previous row, except for the first
+       * row of each chunk, which is stored as is so that each chunk can be
+       * decoded by itself. Samples that are repetitions of their
+       * predecessor (as are all rejected samples of a Metropolis-Hastings
+       * sampler) are then stored as all zeros, and components that change
+       * little between samples have leading bytes (sign, exponent, and
+       * leading mantissa bits) that are zero. The compression that follows
+       * turns long sequences of zeros into almost nothing.
+       */
+      xor_with_previous = 1
+    };
+
+
+
+    /**
+     * The name of the attribute in which the Encoding of a dataset is
+     * stored. Datasets without this attribute are not encoded.
+     */
+    inline constexpr const char *encoding_attribute = "encoding";
+
+
+
+    /**
+     * The name of the attribute in which the ChainFileFormat::ColumnType of
+     * an auxiliary data column is stored, so that one can distinguish
+     * boolean from unsigned integer columns when reading a file.
+     */
+    inline constexpr const char *column_type_attribute = "column type";
+
+
+
+    /**
+     * Attach an attribute with the given name and value to the given
+     * dataset.
+     */
+    inline
+    void
+    write_attribute (const hid_t         dataset,
+                     const char         *name,
+                     const std::uint32_t value)
+    {
+      const Handle dataspace (H5Screate (H5S_SCALAR), &H5Sclose);
+      const Handle attribute (H5Acreate2 (dataset, name, H5T_NATIVE_UINT32, dataspace,
+                                          H5P_DEFAULT, H5P_DEFAULT),
+                              &H5Aclose);
+      [[maybe_unused]] const herr_t ierr = H5Awrite (attribute, H5T_NATIVE_UINT32, &value);
+      assert (ierr >= 0);
+    }
+
+
+
+    /**
+     * Return the value of the attribute with the given name of the given
+     * dataset, or the given default value if the dataset has no such
+     * attribute.
+     */
+    inline
+    std::uint32_t
+    read_attribute (const hid_t         dataset,
+                    const char         *name,
+                    const std::uint32_t default_value)
+    {
+      if (H5Aexists (dataset, name) <= 0)
+        return default_value;
+
+      std::uint32_t value;
+      const Handle attribute (H5Aopen (dataset, name, H5P_DEFAULT), &H5Aclose);
+      [[maybe_unused]] const herr_t ierr = H5Aread (attribute, H5T_NATIVE_UINT32, &value);
+      assert (ierr >= 0);
+      return value;
+    }
+
+
+
+    namespace internal
+    {
+      /**
+       * Encode the `n_rows` rows of `row_size` bytes each stored at `data`
+       * using Encoding::xor_with_previous, in place. The first of these rows
+       * has index `first_row` in the dataset, and chunks of the dataset have
+       * `chunk_rows` rows. `previous_row` holds the (unencoded) row that
+       * precedes the first one, if any; upon return, it holds the last of
+       * the rows passed in, so that the next call can continue where this
+       * one left off.
+       */
+      inline
+      void
+      xor_encode (char              *data,
+                  const std::size_t  n_rows,
+                  const std::size_t  row_size,
+                  const std::size_t  first_row,
+                  const std::size_t  chunk_rows,
+                  std::vector<char> &previous_row)
+      {
+        if (n_rows == 0)
+          return;
+
+        std::vector<char> last_row (data + (n_rows-1)*row_size, data + n_rows*row_size);
+
+        // Work backward so that each row is combined with the unencoded
+        // version of its predecessor:
+        for (std::size_t r=n_rows; r-- > 0; )
+          if ((first_row + r) % chunk_rows != 0)
+            {
+              const char *previous = (r > 0
+                                      ?
+                                      data + (r-1)*row_size
+                                      :
+                                      previous_row.data());
+              assert ((r > 0) || (previous_row.size() == row_size));
+
+              char *row = data + r*row_size;
+              for (std::size_t i=0; i<row_size; ++i)
+                row[i] ^= previous[i];
+            }
+
+        previous_row = std::move(last_row);
+      }
+
+
+
+      /**
+       * Decode the `n_rows` rows of `row_size` bytes each stored at `data`,
+       * which were encoded using xor_encode(), in place. The first of these
+       * rows needs to be the first row of a chunk.
+       */
+      inline
+      void
+      xor_decode (char              *data,
+                  const std::size_t  n_rows,
+                  const std::size_t  row_size,
+                  const std::size_t  chunk_rows)
+      {
+        for (std::size_t r=1; r<n_rows; ++r)
+          if (r % chunk_rows != 0)
+            {
+              const char *previous = data + (r-1)*row_size;
+              char       *row      = data + r*row_size;
+              for (std::size_t i=0; i<row_size; ++i)
+                row[i] ^= previous[i];
+            }
+      }
+    }
+
+
+
+    inline
+    Handle::Handle ()
+      :
+      id (H5I_INVALID_HID),
+      close_function (nullptr)
+    {}
+
+
+
+    inline
+    Handle::Handle (const hid_t id,
+                    herr_t (*close_function)(hid_t))
+      :
+      id (id),
+      close_function (close_function)
+    {
+      assert (id >= 0);
+    }
+
+
+
+    inline
+    Handle::Handle (Handle &&other)
+      :
+      id (std::exchange (other.id, H5I_INVALID_HID)),
+      close_function (other.close_function)
+    {}
+
+
+
+    inline
+    Handle::~Handle ()
+    {
+      if (id >= 0)
+        close_function (id);
+    }
+
+
+
+    inline
+    Handle &
+    Handle::operator= (Handle &&other)
+    {
+      if (this != &other)
+        {
+          if (id >= 0)
+            close_function (id);
+          id = std::exchange (other.id, H5I_INVALID_HID);
+          close_function = other.close_function;
+        }
+      return *this;
+    }
+
+
+
+    inline
+    Handle::operator hid_t () const
+    {
+      return id;
+    }
+  }
+}
@@ -0,0 +1,515 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that describe the performance counters
+   * SampleFlow can keep for every consumer, filter, and producer. These
+   * counters make it possible to find out which part of a large pipeline
+   * is responsible for how much of the run time: how many samples each
+   * consumer has processed, how much time it has spent in its consume()
+   * function (and how that time is distributed), how long it has waited
+   * for locks, how many samples are waiting in its queue if it processes
+   * samples asynchronously, and how long its flush() function took.
+   *
+   * Keeping these counters costs two reads of a clock and an update of an
+   * uncontended, per-thread copy of the counters (see ShardedAccumulator)
+   * for every sample. Since that is not negligible for cheap consumers,
+   * the counters are only kept if the macro
+   * `SAMPLEFLOW_WITH_INSTRUMENTATION` is defined before any SampleFlow
+   * header file is included. Otherwise, no counters are kept at all, the
+   * corresponding code is not even compiled, and the functions that
+   * return the counters (Consumer::get_consumer_statistics() and
+   * Producer::get_producer_statistics()) return objects in which all
+   * counters are zero. Whether the counters are kept can be queried via
+   * Instrumentation::enabled.
+   */
+  namespace Instrumentation
+  {
+    /**
+     * Whether SampleFlow keeps performance counters, i.e., whether
+     * `SAMPLEFLOW_WITH_INSTRUMENTATION` was defined.
+     */
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    /**
+     * The clock used to measure durations.
+     */
+    using Clock = std::chrono::steady_clock;
+
+
+    /**
+     * A class that represents the distribution of a set of durations, as
+     * a histogram with logarithmically spaced buckets: Bucket $b>0$ counts
+     * durations $t$ with $2^{b-1} \le t < 2^b$ nanoseconds, and bucket zero
+     * counts durations of less than one nanosecond. The last bucket also
+     * counts all longer durations. Adding a duration is just the
+     * computation of the bucket and an increment.
+     */
+    class DurationHistogram
+    {
+      public:
+        /**
+         * The number of buckets. The last bucket starts at $2^{46}$
+         * nanoseconds, i.e., at about 20 hours.
+         */
+        static constexpr unsigned int n_buckets = 48;
+
+        /**
+         * Record `n` occurrences of the given duration.
+         */
+        void
+        add (const std::chrono::nanoseconds duration,
+             const std::uint64_t n = 1);
+
+        /**
+         * Add the durations recorded in the given object to the ones
+         * recorded in the current object.
+         */
+        void
+        merge (const DurationHistogram &other);
+
+        /**
+         * Return the number of durations recorded.
+         */
+        std::uint64_t
+        count () const;
+
+        /**
+         * Return the number of durations recorded in the given bucket.
+         */
+        std::uint64_t
+        bucket_count (const unsigned int bucket) const;
+
+        /**
+         * Return the (exclusive) upper bound of the durations recorded in
+         * the given bucket.
+         */
+        static
+        std::chrono::nanoseconds
+        bucket_upper_bound (const unsigned int bucket);
+
+        /**
+         * Return an estimate of the given quantile of the durations
+         * recorded, for example of the median if `q` equals 0.5. The
+         * estimate is the upper bound of the bucket that contains the
+         * quantile, and so at most a factor of two larger than the true
+         * value. If no durations have been recorded, return zero.
+         */
+        std::chrono::nanoseconds
+        quantile (const double q) const;
+
+      private:
+        /**
+         * The number of durations recorded in each bucket.
+         */
+        std::array<std::uint64_t,n_buckets> counts {};
+    };
+
+
+    /**
+     * A structure that holds the performance counters of a consumer or
+     * filter. See Consumer::get_consumer_statistics().
+     */
+    struct ConsumerStatistics
+    {
+      /**
+       * The number of samples processed, and the number of batches among
+       * them (see Consumer::consume_batch()).
+       */
+      std::uint64_t n_samples = 0;
+      std::uint64_t n_batches = 0;
+
+      /**
+       * The total time spent in the consume() and consume_batch()
+       * functions, and the distribution of the time per sample. The
+       * time spent on a batch is distributed evenly among its samples.
+       */
+      std::chrono::nanoseconds consume_time {0};
+      DurationHistogram        consume_time_histogram;
+
+      /**
+       * The number of times a call to Consumer::lock_state() found the
+       * mutex locked by another thread, and the total time spent waiting
+       * for it in these cases.
+       */
+      std::uint64_t            n_contended_locks = 0;
+      std::chrono::nanoseconds lock_wait_time {0};
+
+      /**
+       * In ParallelMode::asynchronous and ParallelMode::dedicated_thread,
+       * the number of samples waiting to be processed at the time the
+       * statistics were requested, and the largest number of samples
+       * found in the queue right after a sample was added to it.
+       */
+      std::size_t queue_depth     = 0;
+      std::size_t max_queue_depth = 0;
+
+      /**
+       * The number of samples that were discarded without being processed
+       * because the queue of samples was full, see
+       * QueueFullPolicy::drop_oldest and Priority::low.
+       */
+      std::uint64_t n_dropped_samples = 0;
+
+      /**
+       * The number of times flush() was called by an upstream producer or
+       * by Consumer::disconnect_and_flush(), and the total and maximal
+       * time these calls took.
+       */
+      std::uint64_t            n_flushes = 0;
+      std::chrono::nanoseconds flush_time {0};
+      std::chrono::nanoseconds max_flush_time {0};
+
+      /**
+       * Combine the counters of the given object with the ones of the
+       * current object, as necessary for ShardedAccumulator.
+       */
+      void
+      merge (const ConsumerStatistics &other);
+    };
+
+
+    /**
+     * A structure that holds the performance counters of a producer or
+     * filter. See Producer::get_producer_statistics().
+     */
+    struct ProducerStatistics
+    {
+      /**
+       * The number of samples sent downstream via Producer::issue_sample().
+       */
+      std::uint64_t n_samples = 0;
+
+      /**
+       * The total time spent in Producer::issue_sample(), and its
+       * distribution. This is the time it takes to hand a sample to all
+       * consumers connected to the producer, including the time spent in
+       * the consume() functions of consumers (and of everything downstream
+       * of them) that work in ParallelMode::synchronous.
+       */
+      std::chrono::nanoseconds issue_time {0};
+      DurationHistogram        issue_time_histogram;
+
+      /**
+       * Combine the counters of the given object with the ones of the
+       * current object, as necessary for ShardedAccumulator.
+       */
+      void
+      merge (const ProducerStatistics &other);
+    };
+
+
+    /**
+     * A structure that describes how long the calls of some function
+     * took, for example the calls of the likelihood function by a
+     * sampler: how often the function was called, how long all calls took
+     * together, and how the durations of the calls are distributed.
+     */
+    struct TimingStatistics
+    {
+      /**
+       * The number of calls.
+       */
+      std::uint64_t n_calls = 0;
+
+      /**
+       * The total time taken by all calls, and its distribution.
+       */
+      std::chrono::nanoseconds total_time {0};
+      DurationHistogram        histogram;
+
+      /**
+       * Record `n` calls that each took the given time.
+       */
+      void
+      add (const std::chrono::nanoseconds duration,
+           const std::uint64_t n = 1);
+
+      /**
+       * Return the average time per call, or zero if there have not been
+       * any calls.
+       */
+      std::chrono::nanoseconds
+      mean () const;
+
+      /**
+       * Return an estimate of the given quantile of the time per call,
+       * for example `quantile(0.99)` for the 99th percentile. See
+       * DurationHistogram::quantile() for the accuracy of the estimate.
+       */
+      std::chrono::nanoseconds
+      quantile (const double q) const;
+
+      /**
+       * Combine the counters of the given object with the ones of the
+       * current object, as necessary for ShardedAccumulator.
+       */
+      void
+      merge (const TimingStatistics &other);
+    };
+
+
+    /**
+     * A structure that holds the timings a Markov chain Monte Carlo
+     * sampler such as Producers::MetropolisHastings collects if asked to
+     * (see, for example, Producers::MetropolisHastings::Parameters::record_timings):
+     * how long the evaluations of the likelihood function and the
+     * proposals of trial samples took. Comparing these with the time
+     * spent sending samples downstream (see ProducerStatistics) tells
+     * how much of the run time is due to the model, and how much is
+     * overhead of the sampler and the pipeline.
+     *
+     * Unlike the counters of ConsumerStatistics and ProducerStatistics,
+     * these timings do not depend on `SAMPLEFLOW_WITH_INSTRUMENTATION`
+     * being defined: Likelihood functions are typically expensive enough
+     * that the two additional reads of a clock per call do not matter,
+     * and so whether timings are recorded is a run-time choice.
+     */
+    struct SamplerStatistics
+    {
+      /**
+       * The calls of the likelihood function, including the ones for the
+       * starting points of chains.
+       */
+      TimingStatistics likelihood_evaluations;
+
+      /**
+       * The calls of the function that proposes trial samples.
+       */
+      TimingStatistics proposals;
+
+      /**
+       * Combine the counters of the given object with the ones of the
+       * current object, as necessary for ShardedAccumulator.
+       */
+      void
+      merge (const SamplerStatistics &other);
+    };
+
+
+    /**
+     * Call the given function object without arguments and return its
+     * result. If `measure` is true, the time the call took is stored in
+     * `duration`; otherwise `duration` is left unchanged and the clock is
+     * not read at all.
+     */
+    template <typename Function>
+    auto
+    timed_call (const bool                measure,
+                std::chrono::nanoseconds &duration,
+                const Function           &function);
+
+
+
+    inline
+    void
+    DurationHistogram::
+    add (const std::chrono::nanoseconds duration,
+         const std::uint64_t n)
+    {
+      const std::uint64_t ns = std::max<std::chrono::nanoseconds::rep>(duration.count(), 0);
+      const unsigned int bucket = std::min<unsigned int> (std::bit_width (ns), n_buckets-1);
+      counts[bucket] += n;
+    }
+
+
+
+    inline
+    void
+    DurationHistogram::
+    merge (const DurationHistogram &other)
+    {
+      for (unsigned int b=0; b<n_buckets; ++b)
+        counts[b] += other.counts[b];
+    }
+
+
+
+    inline
+    std::uint64_t
+    DurationHistogram::
+    count () const
+    {
+      std::uint64_t n = 0;
+      for (const std::uint64_t c : counts)
+        n += c;
+      return n;
+    }
+
+
+
+    inline
+    std::uint64_t
+    DurationHistogram::
+    bucket_count (const unsigned int bucket) const
+    {
+      assert (bucket < n_buckets);
+      return counts[bucket];
+    }
+
+
+
+    inline
+    std::chrono::nanoseconds
+    DurationHistogram::
+    bucket_upper_bound (const unsigned int bucket)
+    {
+      assert (bucket < n_buckets);
+      return std::chrono::nanoseconds (std::int64_t(1) << bucket);
+    }
+
+
+
+    inline
+    std::chrono::nanoseconds
+    DurationHistogram::
+    quantile (const double q) const
+    {
+      assert ((q >= 0) && (q <= 1));
+
+      const std::uint64_t n = count();
+      if (n == 0)
+        return std::chrono::nanoseconds (0);
+
+      // Find the first bucket up to which at least the fraction 'q' of
+      // all durations (but at least one duration) has been recorded:
+      const std::uint64_t n_below = std::max<std::uint64_t> (1, static_cast<std::uint64_t>(std::ceil (q * n)));
+      std::uint64_t n_seen = 0;
+      for (unsigned int b=0; b<n_buckets; ++b)
+        {
+          n_seen += counts[b];
+          if (n_seen >= n_below)
+            return bucket_upper_bound (b);
+        }
+      return bucket_upper_bound (n_buckets-1);
+    }
+
+
+
+    inline
+    void
+    ConsumerStatistics::
+    merge (const ConsumerStatistics &other)
+    {
+      n_samples         += other.n_samples;
+      n_batches         += other.n_batches;
+      consume_time      += other.consume_time;
+      consume_time_histogram.merge (other.consume_time_histogram);
+      n_contended_locks += other.n_contended_locks;
+      lock_wait_time    += other.lock_wait_time;
+      queue_depth       += other.queue_depth;
+      max_queue_depth    = std::max (max_queue_depth, other.max_queue_depth);
+      n_dropped_samples += other.n_dropped_samples;
+      n_flushes         += other.n_flushes;
+      flush_time        += other.flush_time;
+      max_flush_time     = std::max (max_flush_time, other.max_flush_time);
+    }
+
+
+
+    inline
+    void
+    ProducerStatistics::
+    merge (const ProducerStatistics &other)
+    {
+      n_samples  += other.n_samples;
+      issue_time += other.issue_time;
+      issue_time_histogram.merge (other.issue_time_histogram);
+    }
+
+
+
+    inline
+    void
+    TimingStatistics::
+    add (const std::chrono::nanoseconds duration,
+         const std::uint64_t n)
+    {
+      n_calls    += n;
+      total_time += duration * static_cast<std::int64_t>(n);
+      histogram.add (duration, n);
+    }
+
+
+
+    inline
+    std::chrono::nanoseconds
+    TimingStatistics::
+    mean () const
+    {
+      if (n_calls == 0)
+        return std::chrono::nanoseconds (0);
+      else
+        return total_time / n_calls;
+    }
+
+
+
+    inline
+    std::chrono::nanoseconds
+    TimingStatistics::
+    quantile (const double q) const
+    {
+      return histogram.quantile (q);
+    }
+
+
+
+    inline
+    void
+    TimingStatistics::
+    merge (const TimingStatistics &other)
+    {
+      n_calls    += other.n_calls;
+      total_time += other.total_time;
+      histogram.merge (other.histogram);
+    }
+
+
+
+    inline
+    void
+    SamplerStatistics::
+    merge (const SamplerStatistics &other)
+    {
+      likelihood_evaluations.merge (other.likelihood_evaluations);
+      proposals.merge (other.proposals);
+    }
+
+
+
+    template <typename Function>
+    auto
+    timed_call (const bool                measure,
+                std::chrono::nanoseconds &duration,
+                const Function           &function)
+    {
+      if (measure == false)
+        return function();
+
+      const Clock::time_point start = Clock::now();
+      auto result = function();
+      duration = Clock::now() - start;
+      return result;
+    }
+  }
+}
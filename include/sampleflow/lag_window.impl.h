@@ -0,0 +1,454 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores the samples consumers such as
+   * Consumers::AutoCovarianceTrace, Consumers::AutoCovarianceMatrix, and
+   * Consumers::AverageCosineBetweenSuccessiveSamples need to keep in order
+   * to compare each new sample with the ones that came before it, and that
+   * several such consumers can share.
+   *
+   * Each of these consumers needs the most recent $L+1$ samples it has
+   * received, where $L$ is the largest lag it considers. If several of them
+   * are connected to the same producer, they would each store a copy of the
+   * same samples, and each copy every sample into their own history. If
+   * they instead share an object of the current class (by passing the same
+   * `std::shared_ptr<LagWindow>` to their constructors), then every sample
+   * is copied only once, into an object of type LagWindow::Sample that
+   * stores the elements of the sample contiguously and that all consumers
+   * then refer to. Objects of type LagWindow::Sample are reference-counted
+   * handles, and so a consumer's history of previous samples is simply a
+   * RingBuffer of handles; a sample is kept alive for as long as one of the
+   * consumers still needs it, and its memory is reused for a later sample
+   * once none of them does. Once all consumers have filled their histories,
+   * processing a sample therefore does not allocate memory.
+   *
+   * If the samples are themselves reference-counted handles (see
+   * Concepts::is_sample_handle) -- for example because the consumers are
+   * connected to a Filters::MakeShared object -- and the samples they
+   * refer to store their elements contiguously, then the window does not
+   * copy the samples at all: A LagWindow::Sample object then simply holds
+   * on to the handle and refers to the elements of the sample it points
+   * to. The history of a consumer then costs one handle per sample, and
+   * the sample is only released (and its memory possibly reused by the
+   * producer) once no consumer needs it any more.
+   *
+   * Consumers call attach() once to obtain a reader number, and then pass
+   * every sample they receive to insert(). The window counts how many
+   * samples each reader has inserted: The first reader to insert the $k$th
+   * sample copies it into the window, and all other readers that insert
+   * their $k$th sample afterwards receive a handle to this copy. This
+   * requires that all readers attached to a window receive the same
+   * sequence of samples -- i.e., that they are connected to the same
+   * producer (or to filters that pass on the same samples), and that they
+   * have been attached before the first sample is produced. Readers do not
+   * need to process samples in lockstep: The window keeps handles to a
+   * number of recent samples that is given to the constructor, and a
+   * reader that falls behind by more than that (for example because it
+   * processes samples on a dedicated thread, see ParallelMode) simply
+   * receives a copy of its sample that is not shared.
+   *
+   * The class is thread-safe: Its member functions can be called
+   * concurrently from multiple threads.
+   *
+   * @tparam ScalarType The type of the elements of the samples.
+   */
+  template <typename ScalarType>
+  class LagWindow
+  {
+    private:
+      /**
+       * The elements of a sample stored in the window.
+       */
+      struct Storage
+      {
+        std::vector<ScalarType> values;
+      };
+
+    public:
+      /**
+       * A handle to a sample stored in a LagWindow object. Copying objects
+       * of this type does not copy the sample, only the reference to it.
+       *
+       * Objects of this type can be written to and read from a buffer using
+       * the functions in namespace Serialization, so that they can be part
+       * of the state of a consumer. A sample read in this way is not shared
+       * with any other object.
+       */
+      class Sample
+      {
+        public:
+          /**
+           * Default constructor. The resulting object does not refer to
+           * any sample.
+           */
+          Sample () = default;
+
+          /**
+           * Return the elements of the sample.
+           */
+          std::span<const ScalarType>
+          values () const;
+
+          /**
+           * Write the elements of the sample to the given buffer.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          /**
+           * Replace the current object by one that refers to a new sample
+           * whose elements are read from the front of the given buffer.
+           * The buffer is advanced past the data read.
+           */
+          void
+          load (std::span<const char> &buffer);
+
+        private:
+          /**
+           * The object that owns the elements of the sample, and the
+           * elements themselves. The owner is either a Storage object of
+           * the window, or a handle to a sample that was passed to
+           * insert(), and `elements` points into it.
+           */
+          std::shared_ptr<const void> owner;
+          std::span<const ScalarType> elements;
+
+          friend class LagWindow;
+      };
+
+      /**
+       * Constructor.
+       *
+       * @param[in] n_shared_samples The number of most recent samples the
+       *   window keeps handles to, so that readers that insert a sample
+       *   after another reader has already done so can share the copy the
+       *   latter has made. If all readers process samples on the thread
+       *   that produces them, they are never more than one sample apart,
+       *   and the default is sufficient.
+       */
+      explicit
+      LagWindow (const unsigned int n_shared_samples = 4);
+
+      /**
+       * Register a new reader and return its number. The first sample the
+       * reader inserts will be considered the same as the next sample any
+       * other reader inserts for the first time.
+       */
+      unsigned int
+      attach ();
+
+      /**
+       * Unregister a reader. Samples the reader has received from the
+       * window remain valid.
+       */
+      void
+      detach (const unsigned int reader);
+
+      /**
+       * Insert the next sample of the given reader into the window, and
+       * return a handle to the stored copy. If another reader has already
+       * inserted the same sample, then no copy is made, and the handle
+       * refers to the copy made by that reader. If the sample is a handle
+       * to a sample whose elements are stored contiguously (see
+       * Concepts::is_sample_handle), then no copy is made either, and the
+       * returned object keeps the handle alive instead.
+       *
+       * @tparam InputType The type of the sample. Its elements are
+       *   accessed via Utilities::get_nth_element(), or directly if they
+       *   are stored contiguously.
+       */
+      template <typename InputType>
+      Sample
+      insert (const unsigned int  reader,
+              const InputType    &sample);
+
+      /**
+       * Return the number of samples inserted by one reader whose copy
+       * had been made by another reader already.
+       */
+      types::sample_index
+      n_shared_insertions () const;
+
+      /**
+       * Return an estimate of the memory used by the samples stored in
+       * the window, including the ones that are no longer used and whose
+       * memory will be reused for later samples.
+       */
+      std::size_t
+      memory_consumption () const;
+
+    private:
+      /**
+       * A mutex that guards all member variables below.
+       */
+      mutable std::mutex mutex;
+
+      /**
+       * For each reader, the number of samples it has inserted so far.
+       * Readers that have been detached are marked by the largest
+       * representable number.
+       */
+      std::vector<types::sample_index> reader_positions;
+
+      /**
+       * The number of distinct samples inserted so far, and the number of
+       * times a reader has received a sample already inserted by another
+       * reader.
+       */
+      types::sample_index n_inserted;
+      types::sample_index n_shared;
+
+      /**
+       * Handles to the most recently inserted samples. The last element of
+       * this buffer is the sample with number `n_inserted-1`.
+       */
+      RingBuffer<Sample> recent_samples;
+
+      /**
+       * All storage objects ever created by this window. A storage object
+       * that is referenced by nothing but this array is unused, and its
+       * memory can be reused for a new sample. The variable `next_storage`
+       * indicates where the search for an unused object starts: Samples
+       * are generally released in the order in which they were inserted,
+       * and so the object after the one used last is typically unused.
+       */
+      std::vector<std::shared_ptr<Storage>> storage_pool;
+      std::size_t                           next_storage;
+
+      /**
+       * Copy the given sample into an unused storage object, or a new one
+       * if there is none, and return a handle to it. If the sample is a
+       * handle to a sample whose elements are stored contiguously, return
+       * an object that refers to these elements instead. The caller needs
+       * to hold the mutex.
+       */
+      template <typename InputType>
+      Sample
+      store (const InputType &sample);
+  };
+
+
+
+  template <typename ScalarType>
+  std::span<const ScalarType>
+  LagWindow<ScalarType>::Sample::values () const
+  {
+    assert (owner != nullptr);
+    return elements;
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  LagWindow<ScalarType>::Sample::save (std::vector<char> &buffer) const
+  {
+    assert (owner != nullptr);
+
+    // Write the elements in the same format as a std::vector, i.e., their
+    // number followed by the elements themselves, so that load() can
+    // read them into a Storage object:
+    Serialization::write (buffer, std::uint64_t(elements.size()));
+    for (const ScalarType &element : elements)
+      Serialization::write (buffer, element);
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  LagWindow<ScalarType>::Sample::load (std::span<const char> &buffer)
+  {
+    auto new_storage = std::make_shared<Storage>();
+    Serialization::read (buffer, new_storage->values);
+    elements = new_storage->values;
+    owner    = std::move(new_storage);
+  }
+
+
+
+  template <typename ScalarType>
+  LagWindow<ScalarType>::LagWindow (const unsigned int n_shared_samples)
+    :
+    n_inserted (0),
+    n_shared (0),
+    recent_samples (n_shared_samples),
+    next_storage (0)
+  {}
+
+
+
+  template <typename ScalarType>
+  unsigned int
+  LagWindow<ScalarType>::attach ()
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    reader_positions.push_back (n_inserted);
+    return reader_positions.size()-1;
+  }
+
+
+
+  template <typename ScalarType>
+  void
+  LagWindow<ScalarType>::detach (const unsigned int reader)
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    assert (reader < reader_positions.size());
+    reader_positions[reader] = std::numeric_limits<types::sample_index>::max();
+  }
+
+
+
+  template <typename ScalarType>
+  template <typename InputType>
+  typename LagWindow<ScalarType>::Sample
+  LagWindow<ScalarType>::insert (const unsigned int  reader,
+                                 const InputType    &sample)
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    assert (reader < reader_positions.size());
+    const types::sample_index position = reader_positions[reader]++;
+    assert (position <= n_inserted);
+
+    // If another reader has already inserted this sample, and it is still
+    // among the recent ones, share it:
+    if (position < n_inserted)
+      {
+        const types::sample_index age = n_inserted - position;
+        if (age <= recent_samples.size())
+          {
+            const Sample &shared = recent_samples[recent_samples.size() - age];
+            assert (shared.values().size()
+                    == static_cast<std::size_t>(Utilities::size(Utilities::dereference_sample(sample))));
+            ++n_shared;
+            return shared;
+          }
+        else
+          // The reader has fallen too far behind. Give it a copy of its
+          // own:
+          return store (sample);
+      }
+
+    // Otherwise, this is a new sample:
+    Sample new_sample = store (sample);
+    recent_samples.push_back (new_sample);
+    ++n_inserted;
+    return new_sample;
+  }
+
+
+
+  template <typename ScalarType>
+  template <typename InputType>
+  typename LagWindow<ScalarType>::Sample
+  LagWindow<ScalarType>::store (const InputType &sample)
+  {
+    // If the sample is a handle to a sample whose elements are stored
+    // contiguously, there is no need to copy anything: Just hold on to
+    // the handle, which keeps the sample alive for as long as someone
+    // needs it.
+    if constexpr (Concepts::is_sample_handle<InputType>)
+      if constexpr (Concepts::has_contiguous_scalar_storage<types::HandledType<InputType>>)
+        if constexpr (std::is_same_v<types::ScalarType<types::HandledType<InputType>>, ScalarType>)
+          {
+            Sample handle;
+            handle.elements = Utilities::as_span (*sample);
+            handle.owner    = sample;
+            return handle;
+          }
+
+    // Find a storage object that nobody refers to any more, starting at the
+    // one after the one we used last. If one of them is referenced only by
+    // the pool, no one else can obtain a reference to it other than through
+    // this function, which is protected by the mutex. The fence makes sure
+    // that all accesses by the threads that released their references
+    // happen before we overwrite the object.
+    std::shared_ptr<Storage> storage;
+    for (std::size_t i=0; i<storage_pool.size(); ++i)
+      {
+        const std::size_t candidate = (next_storage + i) % storage_pool.size();
+        if (storage_pool[candidate].use_count() == 1)
+          {
+            std::atomic_thread_fence (std::memory_order_acquire);
+            storage = storage_pool[candidate];
+            next_storage = (candidate + 1) % storage_pool.size();
+            break;
+          }
+      }
+    if (storage == nullptr)
+      {
+        storage = std::make_shared<Storage>();
+        storage_pool.push_back (storage);
+        next_storage = 0;
+      }
+
+    // Copy the sample (or the one a handle refers to). If the storage
+    // object has been used before, this reuses its memory:
+    const auto &values = Utilities::dereference_sample (sample);
+    using ValueType = types::HandledType<InputType>;
+    const std::size_t size = Utilities::size(values);
+    storage->values.resize (size);
+    if constexpr (Concepts::has_contiguous_scalar_storage<ValueType>)
+      {
+        const auto elements = Utilities::as_span (values);
+        std::copy (elements.begin(), elements.end(), storage->values.begin());
+      }
+    else
+      for (std::size_t j=0; j<size; ++j)
+        storage->values[j] = Utilities::get_nth_element (values, j);
+
+    // The handle shares ownership of the storage object with the pool,
+    // so that the use count of the latter tells us whether the object
+    // is still in use:
+    Sample handle;
+    handle.elements = storage->values;
+    handle.owner    = std::move(storage);
+    return handle;
+  }
+
+
+
+  template <typename ScalarType>
+  types::sample_index
+  LagWindow<ScalarType>::n_shared_insertions () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    return n_shared;
+  }
+
+
+
+  template <typename ScalarType>
+  std::size_t
+  LagWindow<ScalarType>::memory_consumption () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    std::size_t memory = sizeof(*this)
+                         + reader_positions.capacity() * sizeof(types::sample_index)
+                         + recent_samples.capacity() * sizeof(Sample)
+                         + storage_pool.capacity() * sizeof(std::shared_ptr<Storage>);
+    for (const auto &storage : storage_pool)
+      memory += sizeof(Storage) + storage->values.capacity() * sizeof(ScalarType);
+    return memory;
+  }
+}
@@ -0,0 +1,332 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that wraps a function that computes the logarithm of the
+   * likelihood of a sample, and remembers the values it has computed for
+   * recently seen samples. This is useful for sampling algorithms that
+   * frequently propose samples they have already seen -- for example
+   * Producers::MetropolisHastings for discrete sample types with few
+   * states (such as a coin or a dice), or
+   * Producers::DifferentialEvaluationMetropolisHastings with populations
+   * whose chains revisit each other's states -- and for likelihoods that
+   * are expensive enough that looking up a value in a hash table is
+   * cheap in comparison.
+   *
+   * Objects of this class are function objects that can be passed
+   * wherever a `std::function<double (const SampleType &)>` is expected,
+   * for example:
+   * @code
+   *   SampleFlow::LikelihoodCache<int> cached_log_likelihood (&log_likelihood, 1000);
+   *   mh_sampler.sample (3, cached_log_likelihood, &propose_sample, 10000);
+   *   std::cout << "Hit rate: " << cached_log_likelihood.hit_rate() << std::endl;
+   * @endcode
+   * Since `std::function` copies the function object it wraps, copies of
+   * an object of this class share the same cache and the same
+   * statistics; the example above therefore reports the hit rate of the
+   * calls made by the sampler.
+   *
+   * The cache stores at most a given number of values. If it is full, it
+   * evicts entries using the "clock" (or "second chance") approximation
+   * of a least-recently-used policy: Each entry has a bit that is set
+   * whenever the entry is used, and a "hand" sweeps over the entries,
+   * clearing the bits it finds set and evicting the first entry whose bit
+   * is not set.
+   *
+   * All member functions can be called concurrently from different
+   * threads, as happens for example when several chains run in parallel
+   * (see Producers::MetropolisHastings::sample_chains()). To avoid having
+   * all of these threads compete for one lock, the cache is split into a
+   * number of "shards", each with its own lock, and the shard a sample is
+   * stored in is determined by its hash value. The wrapped function is
+   * called without holding any lock, so different threads can evaluate
+   * the likelihood at the same time. (If two threads ask for the same
+   * new sample at the same time, both may end up evaluating the
+   * likelihood for it.)
+   *
+   * The cache assumes that the wrapped function always returns the same
+   * value for the same sample, i.e., that it is deterministic.
+   *
+   * @tparam SampleType The type of the samples.
+   * @tparam Hash A function object type that computes hash values for
+   *   samples.
+   * @tparam KeyEqual A function object type that determines whether two
+   *   samples are equal.
+   */
+  template <typename SampleType,
+            typename Hash = SampleHash<SampleType>,
+            typename KeyEqual = std::equal_to<SampleType>>
+  class LikelihoodCache
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] log_likelihood The function whose values are cached.
+       * @param[in] capacity The maximal number of values stored.
+       * @param[in] n_shards The number of independently locked pieces the
+       *   cache is split into. The capacity is split evenly among them.
+       */
+      LikelihoodCache (const std::function<double (const SampleType &)> &log_likelihood,
+                       const std::size_t capacity,
+                       const unsigned int n_shards = 16);
+
+      /**
+       * Return the value of the wrapped function for the given sample,
+       * either from the cache or by calling the function and storing the
+       * result.
+       */
+      double
+      operator() (const SampleType &sample) const;
+
+      /**
+       * Return the number of calls to operator() that were answered from
+       * the cache, and the number of calls that required evaluating the
+       * wrapped function.
+       */
+      std::size_t
+      n_hits () const;
+
+      std::size_t
+      n_misses () const;
+
+      /**
+       * Return the fraction of calls to operator() that were answered from
+       * the cache, or zero if there have not been any calls.
+       */
+      double
+      hit_rate () const;
+
+      /**
+       * Return the number of values currently stored.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Remove all stored values and reset the statistics.
+       */
+      void
+      clear ();
+
+    private:
+      /**
+       * The value stored for a sample, along with the bit that the clock
+       * algorithm uses.
+       */
+      struct Entry
+      {
+        double log_likelihood;
+        bool   referenced;
+      };
+
+      /**
+       * One of the independently locked pieces of the cache. The map
+       * stores the values; the vector stores pointers to the keys of the
+       * map (which remain valid as long as the elements exist) in the
+       * order in which the clock hand sweeps over them.
+       */
+      struct Shard
+      {
+        std::mutex                                             mutex;
+        std::unordered_map<SampleType,Entry,Hash,KeyEqual>     entries;
+        std::vector<const SampleType *>                        clock;
+        std::size_t                                            clock_hand = 0;
+      };
+
+      /**
+       * Everything that copies of an object share.
+       */
+      struct State
+      {
+        std::function<double (const SampleType &)> log_likelihood;
+        Hash                                       hash;
+        std::size_t                                shard_capacity;
+        std::vector<std::unique_ptr<Shard>>        shards;
+        std::atomic<std::size_t>                   n_hits;
+        std::atomic<std::size_t>                   n_misses;
+      };
+
+      std::shared_ptr<State> state;
+
+      /**
+       * Return the shard in which the sample with the given hash value
+       * is stored.
+       */
+      Shard &
+      shard_for (const std::size_t hash) const;
+  };
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  LikelihoodCache<SampleType,Hash,KeyEqual>::
+  LikelihoodCache (const std::function<double (const SampleType &)> &log_likelihood,
+                   const std::size_t capacity,
+                   const unsigned int n_shards)
+    :
+    state (std::make_shared<State>())
+  {
+    assert (capacity > 0);
+    assert (n_shards > 0);
+
+    const std::size_t n = std::min<std::size_t> (n_shards, capacity);
+
+    state->log_likelihood = log_likelihood;
+    state->shard_capacity = (capacity + n - 1) / n;
+    for (std::size_t s=0; s<n; ++s)
+      {
+        state->shards.emplace_back (std::make_unique<Shard>());
+        state->shards.back()->entries.reserve (state->shard_capacity);
+        state->shards.back()->clock.reserve (state->shard_capacity);
+      }
+    state->n_hits   = 0;
+    state->n_misses = 0;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  double
+  LikelihoodCache<SampleType,Hash,KeyEqual>::
+  operator() (const SampleType &sample) const
+  {
+    Shard &shard = shard_for (state->hash (sample));
+
+    {
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      const auto p = shard.entries.find (sample);
+      if (p != shard.entries.end())
+        {
+          p->second.referenced = true;
+          ++state->n_hits;
+          return p->second.log_likelihood;
+        }
+    }
+
+    // Evaluate the function outside the lock, then store the value
+    // unless another thread has done so in the meantime:
+    ++state->n_misses;
+    const double log_likelihood = state->log_likelihood (sample);
+
+    std::lock_guard<std::mutex> lock (shard.mutex);
+    if (shard.entries.contains (sample))
+      return log_likelihood;
+
+    if (shard.clock.size() == state->shard_capacity)
+      {
+        // Advance the clock hand to the first entry that has not been
+        // used since the hand last passed it, and evict that entry:
+        while (true)
+          {
+            Entry &entry = shard.entries.find (*shard.clock[shard.clock_hand])->second;
+            if (entry.referenced == false)
+              break;
+            entry.referenced = false;
+            shard.clock_hand = (shard.clock_hand + 1) % shard.clock.size();
+          }
+        shard.entries.erase (*shard.clock[shard.clock_hand]);
+
+        const auto p = shard.entries.emplace (sample, Entry {log_likelihood, false});
+        shard.clock[shard.clock_hand] = &p.first->first;
+        shard.clock_hand = (shard.clock_hand + 1) % shard.clock.size();
+      }
+    else
+      {
+        const auto p = shard.entries.emplace (sample, Entry {log_likelihood, false});
+        shard.clock.push_back (&p.first->first);
+      }
+
+    return log_likelihood;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  std::size_t
+  LikelihoodCache<SampleType,Hash,KeyEqual>::n_hits () const
+  {
+    return state->n_hits;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  std::size_t
+  LikelihoodCache<SampleType,Hash,KeyEqual>::n_misses () const
+  {
+    return state->n_misses;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  double
+  LikelihoodCache<SampleType,Hash,KeyEqual>::hit_rate () const
+  {
+    const std::size_t hits   = state->n_hits;
+    const std::size_t misses = state->n_misses;
+    return ((hits + misses) > 0 ?
+            1. * hits / (hits + misses) :
+            0.);
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  std::size_t
+  LikelihoodCache<SampleType,Hash,KeyEqual>::size () const
+  {
+    std::size_t n = 0;
+    for (const auto &shard : state->shards)
+      {
+        std::lock_guard<std::mutex> lock (shard->mutex);
+        n += shard->entries.size();
+      }
+    return n;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  void
+  LikelihoodCache<SampleType,Hash,KeyEqual>::clear ()
+  {
+    for (const auto &shard : state->shards)
+      {
+        std::lock_guard<std::mutex> lock (shard->mutex);
+        shard->entries.clear();
+        shard->clock.clear();
+        shard->clock_hand = 0;
+      }
+    state->n_hits   = 0;
+    state->n_misses = 0;
+  }
+
+
+
+  template <typename SampleType, typename Hash, typename KeyEqual>
+  typename LikelihoodCache<SampleType,Hash,KeyEqual>::Shard &
+  LikelihoodCache<SampleType,Hash,KeyEqual>::shard_for (const std::size_t hash) const
+  {
+    // The hash tables within the shards use the low bits of the hash
+    // value to find a bucket, so use the high bits of a scrambled version
+    // of it to choose the shard:
+    const std::uint64_t scrambled = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+    return *state->shards[(scrambled >> 32) % state->shards.size()];
+  }
+}
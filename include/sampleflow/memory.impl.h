@@ -0,0 +1,580 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the functions that keep track of how much memory the
+   * objects of a pipeline use. There are two parts to this:
+   *
+   * - Consumers report how much memory their state takes up via
+   *   Consumer::memory_consumption(), and how much memory is taken up by
+   *   the samples waiting in their queues (in ParallelMode::asynchronous
+   *   and ParallelMode::dedicated_thread) via
+   *   Consumer::queued_memory_consumption(). Both are also listed in the
+   *   description of a pipeline returned by Producer::describe_pipeline().
+   *   This makes it possible to find out which object is responsible if a
+   *   program uses more memory than expected.
+   *
+   * - The memory taken up by queued samples is also added up over all
+   *   consumers of a program. queued_bytes() returns the current total and
+   *   high_water_mark() the largest total seen so far. Because queues are
+   *   the one place where memory use can grow quickly and without bound
+   *   (namely, if samples are produced faster than they can be processed),
+   *   one can in addition set a budget for this total via set_budget().
+   *   Once the budget is used up, consumers that want to add a sample to
+   *   their queue wait until other samples have been processed, just as if
+   *   their queue were full. This applies regardless of the QueueFullPolicy
+   *   selected for the consumer, since dropping samples would change the
+   *   results of the computation. A consumer whose queue is empty always
+   *   accepts a sample, however: Otherwise, an asynchronous filter whose
+   *   queue holds all of the budget could wait forever to hand its
+   *   results to an asynchronous consumer downstream, and a single sample
+   *   larger than the budget could never be processed.
+   *
+   * The memory used by a sample is estimated by memory_consumption(), which
+   * knows about contiguous containers such as `std::vector` and
+   * `Eigen::VectorXd`, and about classes that provide a
+   * `memory_consumption()` member function of their own.
+   *
+   * Finally, the namespace provides CacheLineAllocator, which places the
+   * objects it allocates on cache lines of their own. It is used for state
+   * that different threads update concurrently, such as the shards of a
+   * ShardedAccumulator: If two such objects shared a cache line, every
+   * update by one thread would evict the line from the caches of all other
+   * threads working on the other object ("false sharing"), and consumers
+   * that scale perfectly on paper would get slower with every thread
+   * added. Large allocations made by CacheLineAllocator can in addition be
+   * backed by huge pages, see set_huge_pages().
+   */
+  namespace Memory
+  {
+    /**
+     * Return an estimate of the number of bytes the given object takes up,
+     * including the memory it has allocated on the heap.
+     *
+     * If the object has a `memory_consumption()` member function, that is
+     * what is returned. Otherwise, containers that provide `data()` and
+     * `size()` functions (such as `std::vector`, `Eigen::Matrix`, or
+     * SmallVector) are assumed to store their elements contiguously, in the
+     * object itself if `data()` points into the object and on the heap
+     * otherwise; the memory used by the elements is counted recursively
+     * unless they are trivially copyable (and therefore cannot own heap
+     * memory). Other ranges are assumed to store their elements on the
+     * heap. Sparse vectors and matrices of Eigen (such as
+     * `Eigen::SparseVector`) are counted by their number of nonzero
+     * elements. For everything else, the function returns `sizeof(object)`.
+     */
+    template <typename T>
+    std::size_t
+    memory_consumption (const T &object);
+
+
+    /**
+     * Return the number of bytes taken up by all samples currently waiting
+     * in the queues of consumers.
+     */
+    std::size_t
+    queued_bytes ();
+
+    /**
+     * Return the largest value queued_bytes() has had since the program
+     * started or since the last call to reset_high_water_mark().
+     */
+    std::size_t
+    high_water_mark ();
+
+    /**
+     * Reset the high-water mark to the current value of queued_bytes().
+     */
+    void
+    reset_high_water_mark ();
+
+    /**
+     * Set the number of bytes the samples waiting in the queues of all
+     * consumers together may take up, or remove the limit if `budget` is
+     * zero (which is the default). The budget only applies to samples added
+     * to queues after the call.
+     */
+    void
+    set_budget (const std::size_t budget);
+
+    /**
+     * Return the budget set by set_budget(), or zero if there is none.
+     */
+    std::size_t
+    get_budget ();
+
+    /**
+     * Record that a sample of the given size is about to be added to a
+     * queue, if this does not exceed the budget.
+     *
+     * @return Whether the memory was reserved. If not, the caller needs to
+     *   wait for other samples to be processed and try again (see
+     *   wait_and_reserve()).
+     */
+    bool
+    try_reserve (const std::size_t n_bytes);
+
+    /**
+     * Record that a sample of the given size is about to be added to a
+     * queue, regardless of the budget.
+     */
+    void
+    reserve (const std::size_t n_bytes);
+
+    /**
+     * Like try_reserve(), but wait until the memory can be reserved or
+     * `give_up()` returns `true`, whichever happens first. The function
+     * checks `give_up()` at least once per millisecond, since the reasons
+     * for giving up (for example, that the caller has been disconnected
+     * from its producers) do not come with a notification.
+     *
+     * @return Whether the memory was reserved.
+     */
+    bool
+    wait_and_reserve (const std::size_t n_bytes,
+                      const std::function<bool ()> &give_up);
+
+    /**
+     * Record that a sample of the given size, previously reserved via
+     * try_reserve() or wait_and_reserve(), has been removed from a queue,
+     * and wake up those waiting in wait_and_reserve().
+     */
+    void
+    release (const std::size_t n_bytes);
+
+
+    /**
+     * The size of a cache line in bytes, or more precisely, the distance two
+     * objects need to be apart to avoid false sharing. 64 bytes is the size
+     * of a cache line on all current x86-64 and most ARM processors. (We do
+     * not use `std::hardware_destructive_interference_size` because its
+     * value can differ between compilers and compiler flags, which would
+     * make the layout of classes depend on them.)
+     */
+    inline constexpr std::size_t cache_line_size = 64;
+
+    /**
+     * The size of the huge pages CacheLineAllocator uses for large
+     * allocations if set_huge_pages() has been called. This is the size of
+     * huge pages on x86-64 and on ARM with 4 kB base pages.
+     */
+    inline constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+    /**
+     * Set whether allocations made by CacheLineAllocator that are at least
+     * `huge_page_size` bytes large should ask the operating system to back
+     * them with huge pages. This reduces the number of TLB misses for
+     * accumulators that are too large to fit into the caches anyway, such
+     * as the bins of a large Consumers::Histogram. The default is not to
+     * do so. The setting only applies to allocations made after the call,
+     * and only has an effect on Linux; whether huge pages are actually used
+     * then depends on the system's configuration of transparent huge
+     * pages.
+     */
+    void
+    set_huge_pages (const bool use_huge_pages);
+
+    /**
+     * Return whether set_huge_pages() has been called to enable huge
+     * pages.
+     */
+    bool
+    get_huge_pages ();
+
+
+    /**
+     * An allocator, in the sense of the C++ standard library, that aligns
+     * the memory it allocates to a cache line and rounds the size of every
+     * allocation up to a multiple of `cache_line_size`, so that no other
+     * object ends up on the same cache lines. This costs some memory for
+     * small objects, but avoids false sharing between objects that are
+     * updated by different threads.
+     *
+     * Allocations of at least `huge_page_size` bytes are instead aligned to
+     * and rounded up to huge pages and, if set_huge_pages() has been
+     * called, the operating system is asked to back them with huge pages.
+     *
+     * The allocator can be used with containers, as in
+     * `std::vector<double,Memory::CacheLineAllocator<double>>`, and with
+     * `std::allocate_shared()`, which is what CopyOnWrite does.
+     */
+    template <typename T>
+    class CacheLineAllocator
+    {
+      public:
+        using value_type = T;
+
+        /**
+         * Constructors. All objects of this class are interchangeable.
+         */
+        CacheLineAllocator () = default;
+
+        template <typename U>
+        CacheLineAllocator (const CacheLineAllocator<U> &);
+
+        /**
+         * Allocate and deallocate memory for `n` objects of type `T`.
+         */
+        T *
+        allocate (const std::size_t n);
+
+        void
+        deallocate (T *p, const std::size_t n);
+
+        /**
+         * Return the alignment and size of the block of memory allocate()
+         * obtains for the given number of bytes.
+         */
+        static
+        std::pair<std::size_t,std::size_t>
+        block_layout (const std::size_t n_bytes);
+    };
+
+
+    template <typename T, typename U>
+    bool
+    operator== (const CacheLineAllocator<T> &, const CacheLineAllocator<U> &);
+
+
+    namespace internal
+    {
+      /**
+       * A structure that holds the library-wide memory counters.
+       */
+      struct State
+      {
+        std::atomic<std::size_t> queued_bytes {0};
+        std::atomic<std::size_t> high_water_mark {0};
+        std::atomic<std::size_t> budget {0};
+
+        /**
+         * The number of threads waiting in wait_and_reserve(), and the
+         * mutex and condition variable they wait with. release() only
+         * acquires the mutex if someone is waiting.
+         */
+        std::atomic<unsigned int> n_waiting {0};
+        std::mutex                mutex;
+        std::condition_variable   memory_released;
+
+        /**
+         * Whether large allocations should be backed by huge pages, see
+         * set_huge_pages().
+         */
+        std::atomic<bool> use_huge_pages {false};
+      };
+
+
+      /**
+       * Return the object that holds the library-wide memory counters.
+       */
+      inline
+      State &
+      state ()
+      {
+        static State state;
+        return state;
+      }
+
+
+      /**
+       * Raise the high-water mark to the given number of queued bytes, if
+       * it is lower.
+       */
+      inline
+      void
+      update_high_water_mark (const std::size_t queued_bytes)
+      {
+        std::atomic<std::size_t> &mark = state().high_water_mark;
+        std::size_t current = mark.load (std::memory_order_relaxed);
+        while ((queued_bytes > current)
+               &&
+               !mark.compare_exchange_weak (current, queued_bytes,
+                                            std::memory_order_relaxed))
+          ;
+      }
+    }
+
+
+
+    template <typename T>
+    std::size_t
+    memory_consumption (const T &object)
+    {
+      if constexpr (requires { {object.memory_consumption()} -> std::convertible_to<std::size_t>; })
+        return object.memory_consumption();
+      else if constexpr (requires
+    {
+      typename T::Scalar;
+      typename T::StorageIndex;
+      object.nonZeros();
+      object.innerIndexPtr();
+    })
+      {
+        // Sparse vectors and matrices in the format Eigen uses, which
+        // store the value and the index of each nonzero element, plus
+        // (for matrices) where each column starts:
+        std::size_t n_bytes = sizeof(T) + object.nonZeros() * (sizeof(typename T::Scalar)
+                                                              + sizeof(typename T::StorageIndex));
+        if constexpr (requires { object.outerIndexPtr(); object.outerSize(); })
+          n_bytes += (object.outerSize()+1) * sizeof(typename T::StorageIndex);
+        return n_bytes;
+      }
+      else if constexpr (requires { object.data(); object.size(); })
+        {
+          using value_type = std::remove_cvref_t<decltype(*object.data())>;
+
+          std::size_t n_bytes = sizeof(T);
+
+          // See whether the elements are stored in the object itself:
+          const char *const begin = reinterpret_cast<const char *>(&object);
+          const char *const data  = reinterpret_cast<const char *>(object.data());
+          if ((data < begin) || (data >= begin + sizeof(T)))
+            {
+              std::size_t n_elements = object.size();
+              if constexpr (requires { object.capacity(); })
+                n_elements = object.capacity();
+              n_bytes += n_elements * sizeof(value_type);
+            }
+
+          if constexpr (!std::is_trivially_copyable_v<value_type>)
+            for (std::size_t i=0; i<static_cast<std::size_t>(object.size()); ++i)
+              n_bytes += memory_consumption (object.data()[i]) - sizeof(value_type);
+
+          return n_bytes;
+        }
+      else if constexpr (std::ranges::sized_range<const T>)
+        {
+          using value_type = std::remove_cvref_t<std::ranges::range_reference_t<const T>>;
+
+          if constexpr (std::is_trivially_copyable_v<value_type>)
+            return sizeof(T) + std::ranges::size(object) * sizeof(value_type);
+          else
+            {
+              std::size_t n_bytes = sizeof(T);
+              for (const auto &element : object)
+                n_bytes += memory_consumption (element);
+              return n_bytes;
+            }
+        }
+      else
+        return sizeof(T);
+    }
+
+
+
+    inline
+    std::size_t
+    queued_bytes ()
+    {
+      return internal::state().queued_bytes.load (std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    std::size_t
+    high_water_mark ()
+    {
+      return internal::state().high_water_mark.load (std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    void
+    reset_high_water_mark ()
+    {
+      internal::State &state = internal::state();
+      state.high_water_mark.store (state.queued_bytes.load (std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    void
+    set_budget (const std::size_t budget)
+    {
+      internal::state().budget.store (budget, std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    std::size_t
+    get_budget ()
+    {
+      return internal::state().budget.load (std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    bool
+    try_reserve (const std::size_t n_bytes)
+    {
+      internal::State &state = internal::state();
+      const std::size_t budget = state.budget.load (std::memory_order_relaxed);
+
+      std::size_t queued = state.queued_bytes.load (std::memory_order_relaxed);
+      while (true)
+        {
+          if ((budget > 0) && (queued + n_bytes > budget))
+            return false;
+          if (state.queued_bytes.compare_exchange_weak (queued, queued + n_bytes,
+                                                        std::memory_order_relaxed))
+            break;
+        }
+
+      internal::update_high_water_mark (queued + n_bytes);
+      return true;
+    }
+
+
+
+    inline
+    void
+    reserve (const std::size_t n_bytes)
+    {
+      const std::size_t queued
+        = internal::state().queued_bytes.fetch_add (n_bytes, std::memory_order_relaxed);
+      internal::update_high_water_mark (queued + n_bytes);
+    }
+
+
+
+    inline
+    bool
+    wait_and_reserve (const std::size_t n_bytes,
+                      const std::function<bool ()> &give_up)
+    {
+      if (try_reserve (n_bytes))
+        return true;
+
+      // Register as waiting before trying again under the lock, so that
+      // either release() sees us waiting and wakes us up, or we see the
+      // memory it has released.
+      internal::State &state = internal::state();
+      ++state.n_waiting;
+      std::atomic_thread_fence (std::memory_order_seq_cst);
+
+      bool reserved = false;
+      {
+        std::unique_lock<std::mutex> lock (state.mutex);
+        while (!(reserved = try_reserve (n_bytes)) && !give_up())
+          state.memory_released.wait_for (lock, std::chrono::milliseconds(1));
+      }
+
+      --state.n_waiting;
+      return reserved;
+    }
+
+
+
+    inline
+    void
+    release (const std::size_t n_bytes)
+    {
+      internal::State &state = internal::state();
+      state.queued_bytes.fetch_sub (n_bytes, std::memory_order_relaxed);
+
+      std::atomic_thread_fence (std::memory_order_seq_cst);
+      if (state.n_waiting.load() > 0)
+        {
+          {
+            std::lock_guard<std::mutex> lock (state.mutex);
+          }
+          state.memory_released.notify_all();
+        }
+    }
+  
+
+
+    inline
+    void
+    set_huge_pages (const bool use_huge_pages)
+    {
+      internal::state().use_huge_pages.store (use_huge_pages);
+    }
+
+
+
+    inline
+    bool
+    get_huge_pages ()
+    {
+      return internal::state().use_huge_pages.load();
+    }
+
+
+
+    template <typename T>
+    template <typename U>
+    CacheLineAllocator<T>::CacheLineAllocator (const CacheLineAllocator<U> &)
+    {}
+
+
+
+    template <typename T>
+    std::pair<std::size_t,std::size_t>
+    CacheLineAllocator<T>::block_layout (const std::size_t n_bytes)
+    {
+      const std::size_t alignment = std::max ((n_bytes >= huge_page_size ?
+                                               huge_page_size :
+                                               cache_line_size),
+                                              alignof(T));
+      return {alignment, (n_bytes + alignment - 1) / alignment * alignment};
+    }
+
+
+
+    template <typename T>
+    T *
+    CacheLineAllocator<T>::allocate (const std::size_t n)
+    {
+      const auto [alignment, size] = block_layout (n * sizeof(T));
+      void *const p = ::operator new (size, std::align_val_t (alignment));
+
+#ifdef __linux__
+      if ((alignment == huge_page_size) && get_huge_pages())
+        madvise (p, size, MADV_HUGEPAGE);
+#endif
+
+      return static_cast<T *>(p);
+    }
+
+
+
+    template <typename T>
+    void
+    CacheLineAllocator<T>::deallocate (T *p, const std::size_t n)
+    {
+      const auto [alignment, size] = block_layout (n * sizeof(T));
+      ::operator delete (p, size, std::align_val_t (alignment));
+    }
+
+
+
+    template <typename T, typename U>
+    bool
+    operator== (const CacheLineAllocator<T> &, const CacheLineAllocator<U> &)
+    {
+      return true;
+    }
+  }
+}
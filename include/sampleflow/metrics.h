@@ -0,0 +1,43 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_METRICS_H
+#define SAMPLEFLOW_METRICS_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/instrumentation.h>
+#include <sampleflow/producer.h>
+#include <sampleflow/consumer.h>
+#include <sampleflow/consumers/acceptance_ratio.h>
+
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/metrics.impl.h>
+
+#endif
@@ -0,0 +1,460 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the tools that make the state of a running pipeline
+   * available to monitoring systems such as Prometheus.
+   */
+  namespace Metrics
+  {
+    /**
+     * A class that collects metrics from producers, consumers, and other
+     * sources registered with it and writes them in the text-based
+     * exposition format of Prometheus (version 0.0.4). This is useful for
+     * samplers that run for a long time, for example on a cluster, and
+     * whose progress should be watched by the same monitoring system as
+     * everything else.
+     *
+     * The class does not provide an HTTP server itself. Rather, it offers
+     * a "pull" interface: Whenever the monitoring system asks for the
+     * current metrics, the program calls scrape() (or write()) and sends
+     * the result back, for example from the request handler of whatever
+     * HTTP server library the program already uses, or it periodically
+     * writes the result to a file that is picked up by the "textfile"
+     * collector of the Prometheus node exporter.
+     *
+     * For each registered producer, the exporter reports the counters of
+     * Producer::get_producer_statistics() and the number of samples per
+     * second since the previous scrape; for samplers that also provide a
+     * `get_sampler_statistics()` function (such as
+     * Producers::MetropolisHastings), it also reports how often and for
+     * how long the likelihood function and the proposal function were
+     * called. For each registered consumer, it reports the counters of
+     * Consumer::get_consumer_statistics(), including the current and
+     * maximal depth of the queue of samples waiting to be processed and
+     * the memory used by the consumer (see namespace Memory). It
+     * also reports the acceptance ratios computed by registered
+     * Consumers::AcceptanceRatio objects, and the values of arbitrary
+     * functions registered via add_gauge(). Each metric carries a label
+     * with the name given when registering the object, so that several
+     * producers or consumers can be told apart.
+     *
+     * The performance counters of producers and consumers are only kept
+     * if `SAMPLEFLOW_WITH_INSTRUMENTATION` is defined (see namespace
+     * Instrumentation), and are zero otherwise.
+     *
+     * Scraping does not hold up sampling: All of the quantities reported
+     * are either atomic variables or kept in ShardedAccumulator objects
+     * whose snapshots are taken without waiting for the threads updating
+     * them.
+     *
+     * Objects registered with an exporter must remain alive for as long
+     * as they are registered. Use remove() before destroying them.
+     */
+    class Exporter
+    {
+      public:
+        /**
+         * Register a producer under the given name. If the producer
+         * provides a `get_sampler_statistics()` function, the timings of
+         * its likelihood and proposal functions are reported as well.
+         */
+        template <typename ProducerType>
+        requires (std::derived_from<ProducerType, Producer<typename ProducerType::output_type>>)
+        void
+        add_producer (const std::string &name,
+                      const ProducerType &producer);
+
+        /**
+         * Register a consumer or filter under the given name.
+         */
+        template <typename InputType>
+        void
+        add_consumer (const std::string &name,
+                      const Consumer<InputType> &consumer);
+
+        /**
+         * Register an object that computes the acceptance ratio of a
+         * sampler under the given name. Both the overall acceptance ratio
+         * and the acceptance ratio over the recent window (see
+         * Consumers::AcceptanceRatio::get_recent()) are reported. The
+         * object is not registered as a consumer; call add_consumer() in
+         * addition if its performance counters are of interest.
+         */
+        template <typename InputType>
+        void
+        add_acceptance_ratio (const std::string &name,
+                              const Consumers::AcceptanceRatio<InputType> &acceptance_ratio);
+
+        /**
+         * Register an arbitrary quantity to be reported as a gauge, i.e.,
+         * as a value that can go up and down. The quantity is reported as
+         * the metric `metric` (which should follow the Prometheus naming
+         * conventions, i.e., consist of letters, digits, and underscores)
+         * with the label `name="name"`, and `help` is the description of the
+         * metric. The function `value` is called from the thread that calls
+         * write() or scrape() and must therefore be safe to call
+         * concurrently with sampling.
+         */
+        void
+        add_gauge (const std::string &metric,
+                   const std::string &help,
+                   const std::string &name,
+                   const std::function<double ()> &value);
+
+        /**
+         * Remove all objects and gauges registered under the given name.
+         */
+        void
+        remove (const std::string &name);
+
+        /**
+         * Write the current values of all metrics to the given stream in
+         * the Prometheus text exposition format.
+         */
+        void
+        write (std::ostream &out);
+
+        /**
+         * Return the current values of all metrics in the Prometheus text
+         * exposition format, for use as the body of the response to a
+         * scrape request (with content type
+         * `text/plain; version=0.0.4`).
+         */
+        std::string
+        scrape ();
+
+      private:
+        /**
+         * A structure that describes one value of one metric.
+         */
+        struct Sample
+        {
+          std::string metric;
+          std::string type;
+          std::string help;
+          std::string name;
+          double      value;
+        };
+
+        /**
+         * A structure that describes one registered object: its name, and a
+         * function that adds the current values of its metrics to a list.
+         */
+        struct Source
+        {
+          std::string                                  name;
+          std::function<void (std::vector<Sample> &)> collect;
+        };
+
+        /**
+         * The registered objects, and a mutex that guards the list. The
+         * mutex is only ever acquired by the functions of this class, never
+         * by the objects being monitored.
+         */
+        std::mutex          mutex;
+        std::vector<Source> sources;
+    };
+
+
+
+    template <typename ProducerType>
+    requires (std::derived_from<ProducerType, Producer<typename ProducerType::output_type>>)
+    void
+    Exporter::
+    add_producer (const std::string &name,
+                  const ProducerType &producer)
+    {
+      // Remember the number of samples at the previous scrape so that we
+      // can compute the current rate at which samples are produced. This
+      // state is only touched by collect(), which is called under the
+      // lock of this object.
+      struct PreviousScrape
+      {
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        std::uint64_t                         n_samples = 0;
+      };
+      const auto previous = std::make_shared<PreviousScrape>();
+
+      auto collect = [&producer, name, previous](std::vector<Sample> &samples)
+      {
+        const Instrumentation::ProducerStatistics statistics
+          = producer.get_producer_statistics();
+        samples.push_back ({"sampleflow_producer_samples_total", "counter",
+                            "Number of samples sent downstream.",
+                            name, static_cast<double>(statistics.n_samples)
+                           });
+        samples.push_back ({"sampleflow_producer_issue_seconds_total", "counter",
+                            "Time spent sending samples downstream.",
+                            name, std::chrono::duration<double>(statistics.issue_time).count()
+                           });
+
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - previous->time).count();
+        const double rate = (elapsed > 0
+                             ?
+                             (statistics.n_samples - previous->n_samples) / elapsed
+                             :
+                             0);
+        previous->time      = now;
+        previous->n_samples = statistics.n_samples;
+        samples.push_back ({"sampleflow_producer_samples_per_second", "gauge",
+                            "Rate at which samples were sent downstream since the previous scrape.",
+                            name, rate
+                           });
+
+        if constexpr (requires { producer.get_sampler_statistics(); })
+          {
+            const Instrumentation::SamplerStatistics sampler_statistics
+              = producer.get_sampler_statistics();
+            samples.push_back ({"sampleflow_sampler_likelihood_evaluations_total", "counter",
+                                "Number of evaluations of the likelihood function.",
+                                name, static_cast<double>(sampler_statistics.likelihood_evaluations.n_calls)
+                               });
+            samples.push_back ({"sampleflow_sampler_likelihood_evaluation_seconds_total", "counter",
+                                "Time spent evaluating the likelihood function.",
+                                name, std::chrono::duration<double>(sampler_statistics.likelihood_evaluations.total_time).count()
+                               });
+            samples.push_back ({"sampleflow_sampler_proposals_total", "counter",
+                                "Number of calls of the proposal function.",
+                                name, static_cast<double>(sampler_statistics.proposals.n_calls)
+                               });
+            samples.push_back ({"sampleflow_sampler_proposal_seconds_total", "counter",
+                                "Time spent in the proposal function.",
+                                name, std::chrono::duration<double>(sampler_statistics.proposals.total_time).count()
+                               });
+          }
+      };
+
+      std::lock_guard<std::mutex> lock (mutex);
+      sources.push_back ({name, collect});
+    }
+
+
+
+    template <typename InputType>
+    void
+    Exporter::
+    add_consumer (const std::string &name,
+                  const Consumer<InputType> &consumer)
+    {
+      auto collect = [&consumer, name](std::vector<Sample> &samples)
+      {
+        const Instrumentation::ConsumerStatistics statistics
+          = consumer.get_consumer_statistics();
+        const auto seconds = [](const std::chrono::nanoseconds t)
+        {
+          return std::chrono::duration<double>(t).count();
+        };
+
+        samples.push_back ({"sampleflow_consumer_samples_total", "counter",
+                            "Number of samples processed.",
+                            name, static_cast<double>(statistics.n_samples)
+                           });
+        samples.push_back ({"sampleflow_consumer_batches_total", "counter",
+                            "Number of batches of samples processed.",
+                            name, static_cast<double>(statistics.n_batches)
+                           });
+        samples.push_back ({"sampleflow_consumer_consume_seconds_total", "counter",
+                            "Time spent processing samples.",
+                            name, seconds (statistics.consume_time)
+                           });
+        samples.push_back ({"sampleflow_consumer_contended_locks_total", "counter",
+                            "Number of times the state of the consumer was found locked.",
+                            name, static_cast<double>(statistics.n_contended_locks)
+                           });
+        samples.push_back ({"sampleflow_consumer_lock_wait_seconds_total", "counter",
+                            "Time spent waiting for the state of the consumer to be unlocked.",
+                            name, seconds (statistics.lock_wait_time)
+                           });
+        samples.push_back ({"sampleflow_consumer_queue_depth", "gauge",
+                            "Number of samples waiting to be processed.",
+                            name, static_cast<double>(statistics.queue_depth)
+                           });
+        samples.push_back ({"sampleflow_consumer_max_queue_depth", "gauge",
+                            "Largest number of samples found waiting to be processed.",
+                            name, static_cast<double>(statistics.max_queue_depth)
+                           });
+        samples.push_back ({"sampleflow_consumer_dropped_samples_total", "counter",
+                            "Number of samples discarded because the queue was full.",
+                            name, static_cast<double>(statistics.n_dropped_samples)
+                           });
+        samples.push_back ({"sampleflow_consumer_flushes_total", "counter",
+                            "Number of calls to flush().",
+                            name, static_cast<double>(statistics.n_flushes)
+                           });
+        samples.push_back ({"sampleflow_consumer_flush_seconds_total", "counter",
+                            "Time spent in flush().",
+                            name, seconds (statistics.flush_time)
+                           });
+        samples.push_back ({"sampleflow_consumer_state_bytes", "gauge",
+                            "Memory used by the state of the consumer.",
+                            name, static_cast<double>(consumer.memory_consumption())
+                           });
+        samples.push_back ({"sampleflow_consumer_queued_bytes", "gauge",
+                            "Memory used by the samples waiting to be processed.",
+                            name, static_cast<double>(consumer.queued_memory_consumption())
+                           });
+      };
+
+      std::lock_guard<std::mutex> lock (mutex);
+      sources.push_back ({name, collect});
+    }
+
+
+
+    template <typename InputType>
+    void
+    Exporter::
+    add_acceptance_ratio (const std::string &name,
+                          const Consumers::AcceptanceRatio<InputType> &acceptance_ratio)
+    {
+      auto collect = [&acceptance_ratio, name](std::vector<Sample> &samples)
+      {
+        samples.push_back ({"sampleflow_acceptance_ratio", "gauge",
+                            "Fraction of trial samples accepted.",
+                            name, acceptance_ratio.get()
+                           });
+        samples.push_back ({"sampleflow_recent_acceptance_ratio", "gauge",
+                            "Fraction of trial samples accepted over the recent window.",
+                            name, acceptance_ratio.get_recent()
+                           });
+      };
+
+      std::lock_guard<std::mutex> lock (mutex);
+      sources.push_back ({name, collect});
+    }
+
+
+
+    inline
+    void
+    Exporter::
+    add_gauge (const std::string &metric,
+               const std::string &help,
+               const std::string &name,
+               const std::function<double ()> &value)
+    {
+      auto collect = [metric, help, name, value](std::vector<Sample> &samples)
+      {
+        samples.push_back ({metric, "gauge", help, name, value()});
+      };
+
+      std::lock_guard<std::mutex> lock (mutex);
+      sources.push_back ({name, collect});
+    }
+
+
+
+    inline
+    void
+    Exporter::
+    remove (const std::string &name)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      std::erase_if (sources, [&name](const Source &source)
+      {
+        return (source.name == name);
+      });
+    }
+
+
+
+    inline
+    void
+    Exporter::
+    write (std::ostream &out)
+    {
+      std::vector<Sample> samples;
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        for (const Source &source : sources)
+          source.collect (samples);
+      }
+
+      // Label values need to have backslashes, double quotes, and line
+      // breaks escaped:
+      const auto escape = [](const std::string &s)
+      {
+        std::string result;
+        for (const char c : s)
+          if (c == '\n')
+            result += "\\n";
+          else
+            {
+              if ((c == '"') || (c == '\\'))
+                result += '\\';
+              result += c;
+            }
+        return result;
+      };
+
+      // Print counts exactly, and everything else with enough digits to
+      // not lose anything. The format has its own spelling of infinities
+      // and NaNs:
+      const auto format = [](const double value)
+      {
+        std::ostringstream s;
+        if (std::isnan (value))
+          s << "NaN";
+        else if (std::isinf (value))
+          s << (value > 0 ? "+Inf" : "-Inf");
+        else if ((value == std::floor(value)) && (std::fabs(value) < 9007199254740992.))
+          s << static_cast<std::int64_t>(value);
+        else
+          {
+            s.precision (std::numeric_limits<double>::max_digits10);
+            s << value;
+          }
+        return s.str();
+      };
+
+      // The format requires all values of a metric to be listed together,
+      // after a description of the metric. We list metrics in the order in
+      // which they first appear, and their values in the order of the
+      // registered objects:
+      std::vector<bool> written (samples.size(), false);
+      for (std::size_t i=0; i<samples.size(); ++i)
+        if (written[i] == false)
+          {
+            out << "# HELP " << samples[i].metric << ' ' << samples[i].help << '\n'
+                << "# TYPE " << samples[i].metric << ' ' << samples[i].type << '\n';
+            for (std::size_t j=i; j<samples.size(); ++j)
+              if (samples[j].metric == samples[i].metric)
+                {
+                  out << samples[j].metric << "{name=\"" << escape (samples[j].name) << "\"} "
+                      << format (samples[j].value) << '\n';
+                  written[j] = true;
+                }
+          }
+      out << std::flush;
+    }
+
+
+
+    inline
+    std::string
+    Exporter::
+    scrape ()
+    {
+      std::ostringstream out;
+      write (out);
+      return out.str();
+    }
+  }
+}
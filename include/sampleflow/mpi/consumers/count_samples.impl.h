@@ -0,0 +1,238 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    /**
+     * A namespace for consumers that compute statistics over the samples
+     * received on all processes of an MPI communicator. See the
+     * documentation of namespace MPI for the general approach.
+     */
+    namespace Consumers
+    {
+      /**
+       * A version of the Consumers::CountSamples class that counts the
+       * samples received on all processes of an MPI communicator. Each
+       * process counts the samples it receives itself, without any
+       * communication, and only the get(), total_weight(), and
+       * effective_sample_size() functions add up these counts. These
+       * functions are therefore collective operations: They need to be
+       * called on all processes of the communicator at the same time, and
+       * return the same value on all of them. The counts on the current
+       * process alone are available via local().
+       *
+       *
+       * ### Threading model ###
+       *
+       * The consume() functions of this class are thread-safe, in the same
+       * way as those of Consumers::CountSamples. The functions that
+       * communicate must be called from only one thread per process at a
+       * time, as is generally the case for MPI collective operations.
+       *
+       *
+       * @tparam InputType The C++ type used for the samples $x_k$.
+       */
+      template <typename InputType>
+      class CountSamples : public Consumer<InputType>
+      {
+        public:
+          /**
+           * The type of the information generated by this class. This is
+           * the same type as for Consumers::CountSamples.
+           */
+          using value_type = types::sample_index;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The communicator over whose processes
+           *   samples are to be counted.
+           */
+          CountSamples (const MPI_Comm communicator);
+
+          /**
+           * Destructor. This function also makes sure that all samples this
+           * object may have received have been fully processed. To this end,
+           * it calls the Consumers::disconnect_and_flush() function of the
+           * base class.
+           */
+          virtual ~CountSamples ();
+
+          /**
+           * Process one sample by passing it on to the object that counts
+           * the samples on the current process.
+           *
+           * @param[in] sample The sample to process.
+           * @param[in] aux_data Auxiliary data about this sample.
+           */
+          virtual
+          void
+          consume (InputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * Process a batch of samples by passing it on to the object that
+           * counts the samples on the current process.
+           *
+           * @param[in] samples The samples to process.
+           * @param[in] aux_data Auxiliary data about these samples.
+           */
+          virtual
+          void
+          consume_batch (const std::vector<InputType> &samples,
+                         const std::vector<AuxiliaryData> &aux_data) override;
+
+          /**
+           * Return the number of samples received so far on all processes.
+           * This is a collective operation.
+           */
+          value_type
+          get () const;
+
+          /**
+           * Return the sum of the weights of all samples received so far on
+           * all processes. This is a collective operation.
+           */
+          double
+          total_weight () const;
+
+          /**
+           * Return the effective sample size of all samples received so far
+           * on all processes; see Consumers::CountSamples. This is a
+           * collective operation.
+           */
+          double
+          effective_sample_size () const;
+
+          /**
+           * Return a reference to the object that counts the samples
+           * received on the current process. Calling the member functions of
+           * this object does not involve any communication.
+           */
+          const SampleFlow::Consumers::CountSamples<InputType> &
+          local () const;
+
+        private:
+          /**
+           * The communicator over whose processes samples are counted.
+           */
+          const MPI_Comm communicator;
+
+          /**
+           * The object that counts the samples on the current process.
+           */
+          SampleFlow::Consumers::CountSamples<InputType> local_count;
+      };
+
+
+
+      template <typename InputType>
+      CountSamples<InputType>::
+      CountSamples (const MPI_Comm communicator)
+        :
+        Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                         |
+                                         static_cast<int>(ParallelMode::asynchronous))),
+        communicator (communicator)
+      {}
+
+
+
+      template <typename InputType>
+      CountSamples<InputType>::
+      ~CountSamples ()
+      {
+        this->disconnect_and_flush();
+      }
+
+
+
+      template <typename InputType>
+      void
+      CountSamples<InputType>::
+      consume (InputType sample, AuxiliaryData aux_data)
+      {
+        local_count.consume (std::move(sample), std::move(aux_data));
+      }
+
+
+
+      template <typename InputType>
+      void
+      CountSamples<InputType>::
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data)
+      {
+        local_count.consume_batch (samples, aux_data);
+      }
+
+
+
+      template <typename InputType>
+      typename CountSamples<InputType>::value_type
+      CountSamples<InputType>::
+      get () const
+      {
+        std::vector<types::sample_index> n_samples = { local_count.get() };
+        sum (n_samples, communicator);
+
+        return n_samples[0];
+      }
+
+
+
+      template <typename InputType>
+      double
+      CountSamples<InputType>::
+      total_weight () const
+      {
+        std::vector<double> weight = { local_count.total_weight() };
+        sum (weight, communicator);
+
+        return weight[0];
+      }
+
+
+
+      template <typename InputType>
+      double
+      CountSamples<InputType>::
+      effective_sample_size () const
+      {
+        std::vector<double> weights = { local_count.total_weight(),
+                                        local_count.total_squared_weight()
+                                      };
+        sum (weights, communicator);
+
+        if (weights[1] > 0)
+          return weights[0] * weights[0] / weights[1];
+        else
+          return 0;
+      }
+
+
+
+      template <typename InputType>
+      const SampleFlow::Consumers::CountSamples<InputType> &
+      CountSamples<InputType>::
+      local () const
+      {
+        return local_count;
+      }
+    }
+  }
+}
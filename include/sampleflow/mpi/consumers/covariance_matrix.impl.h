@@ -0,0 +1,284 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    namespace Consumers
+    {
+      /**
+       * A version of the Consumers::CovarianceMatrix class that computes the
+       * covariance matrix of the samples received on all processes of an
+       * MPI communicator. Each process computes the mean value $\bar x_r$,
+       * the total weight $W_r$ and sum of squared weights $W_{2,r}$, and the
+       * covariance matrix $C_r$ of the samples it receives itself, without
+       * any communication. From these, it can recover the sum of outer
+       * products of deviations from the mean,
+       * $M_r = (W_r - W_{2,r}/W_r) C_r$ (see Consumers::CovarianceMatrix).
+       * The get() function then first computes the overall mean value
+       * $\bar x$ (see MPI::Consumers::MeanValue), and then
+       * @f{align*}{
+       *   M = \sum_r \left[ M_r + W_r (\bar x_r-\bar x)(\bar x_r-\bar x)^T \right],
+       * @f}
+       * along with $W=\sum_r W_r$ and $W_2=\sum_r W_{2,r}$, using a
+       * reduction over all processes; this is the formula for the
+       * combination of partial results used within each process
+       * (see the documentation of Consumers::CovarianceMatrix), applied
+       * to all processes at once. The result is then $M/(W-W_2/W)$.
+       *
+       * get() is therefore a collective operation: It needs to be called
+       * on all processes of the communicator at the same time, and returns
+       * the same value on all of them.
+       *
+       *
+       * ### Threading model ###
+       *
+       * The consume() function of this class is thread-safe, in the same
+       * way as that of Consumers::CovarianceMatrix. The get() function must
+       * be called from only one thread per process at a time, as is
+       * generally the case for MPI collective operations.
+       *
+       *
+       * @tparam InputType The C++ type used for the samples $x_k$. The same
+       *   requirements apply as for MPI::Consumers::MeanValue.
+       */
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      class CovarianceMatrix : public Consumer<InputType>
+      {
+        public:
+          /**
+           * The data type of the elements of the input type.
+           */
+          using scalar_type = types::ScalarType<InputType>;
+
+          /**
+           * The type of the information generated by this class. This is
+           * the same type as for Consumers::CovarianceMatrix.
+           */
+          using value_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The communicator over whose processes
+           *   the covariance matrix is to be computed.
+           */
+          CovarianceMatrix (const MPI_Comm communicator);
+
+          /**
+           * Destructor. This function also makes sure that all samples this
+           * object may have received have been fully processed. To this end,
+           * it calls the Consumers::disconnect_and_flush() function of the
+           * base class.
+           */
+          virtual ~CovarianceMatrix ();
+
+          /**
+           * Process one sample by passing it on to the objects that compute
+           * the statistics of the samples on the current process.
+           *
+           * @param[in] sample The sample to process.
+           * @param[in] aux_data Auxiliary data about this sample.
+           */
+          virtual
+          void
+          consume (InputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * Like consume(), but for a batch of samples.
+           *
+           * @param[in] samples The samples to process.
+           * @param[in] aux_data Auxiliary data about these samples.
+           */
+          virtual
+          void
+          consume_batch (const std::vector<InputType> &samples,
+                         const std::vector<AuxiliaryData> &aux_data) override;
+
+          /**
+           * Return the covariance matrix of the samples received so far on
+           * all processes. If no process has received any samples, then an
+           * empty matrix is returned. This is a collective operation.
+           */
+          value_type
+          get () const;
+
+          /**
+           * Return a reference to the object that computes the covariance
+           * matrix of the samples received on the current process. Calling
+           * the member functions of this object does not involve any
+           * communication.
+           */
+          const SampleFlow::Consumers::CovarianceMatrix<InputType> &
+          local () const;
+
+        private:
+          /**
+           * The communicator over whose processes the covariance matrix is
+           * computed.
+           */
+          const MPI_Comm communicator;
+
+          /**
+           * The object that computes the mean value over all processes, and
+           * which also provides the mean value and the weights of the
+           * samples on the current process.
+           */
+          MeanValue<InputType> mean_value;
+
+          /**
+           * The object that computes the covariance matrix of the samples on
+           * the current process.
+           */
+          SampleFlow::Consumers::CovarianceMatrix<InputType> local_covariance;
+      };
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      CovarianceMatrix<InputType>::
+      CovarianceMatrix (const MPI_Comm communicator)
+        :
+        Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                         |
+                                         static_cast<int>(ParallelMode::asynchronous))),
+        communicator (communicator),
+        mean_value (communicator)
+      {}
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      CovarianceMatrix<InputType>::
+      ~CovarianceMatrix ()
+      {
+        this->disconnect_and_flush();
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      void
+      CovarianceMatrix<InputType>::
+      consume (InputType sample, AuxiliaryData aux_data)
+      {
+        mean_value.consume (sample, aux_data);
+        local_covariance.consume (std::move(sample), std::move(aux_data));
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      void
+      CovarianceMatrix<InputType>::
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data)
+      {
+        mean_value.consume_batch (samples, aux_data);
+        local_covariance.consume_batch (samples, aux_data);
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      typename CovarianceMatrix<InputType>::value_type
+      CovarianceMatrix<InputType>::
+      get () const
+      {
+        const double local_weight
+          = mean_value.local_count().total_weight();
+        const double local_squared_weight
+          = mean_value.local_count().total_squared_weight();
+
+        // Compute the overall mean value first. This also tells us whether
+        // any process has seen any samples at all.
+        const InputType mean = mean_value.get();
+        const std::size_t n_elements
+          = max<std::size_t> ((local_weight > 0 ? Utilities::size(mean_value.local().get()) : 0),
+                              communicator);
+        if (n_elements == 0)
+          return value_type();
+
+        // Then compute the contribution of the current process to M, and
+        // add these up along with the weights, which we put at the end of
+        // the array.
+        std::vector<scalar_type> sums (n_elements*n_elements + 2, scalar_type(0));
+        if (local_weight > 0)
+          {
+            const double local_normalization
+              = local_weight - local_squared_weight / local_weight;
+            const value_type local_sum_of_products
+              = (local_normalization > 0
+                 ?
+                 value_type(local_covariance.get() * scalar_type(local_normalization))
+                 :
+                 value_type(local_covariance.get()));
+
+            InputType delta = mean_value.local().get();
+            delta -= mean;
+
+            for (std::size_t i=0; i<n_elements; ++i)
+              {
+                const auto delta_i = Utilities::get_nth_element(delta, i);
+                for (std::size_t j=0; j<n_elements; ++j)
+                  {
+                    const auto delta_j = Utilities::conj(Utilities::get_nth_element(delta, j));
+                    sums[i*n_elements+j] = local_sum_of_products(i,j)
+                                           + delta_i * delta_j * scalar_type(local_weight);
+                  }
+              }
+
+            sums[n_elements*n_elements]   = local_weight;
+            sums[n_elements*n_elements+1] = local_squared_weight;
+          }
+        sum (sums, communicator);
+
+        const double total_weight         = std::real(sums[n_elements*n_elements]);
+        const double total_squared_weight = std::real(sums[n_elements*n_elements+1]);
+        const double normalization        = total_weight - total_squared_weight / total_weight;
+
+        value_type covariance (n_elements, n_elements);
+        for (std::size_t i=0; i<n_elements; ++i)
+          for (std::size_t j=0; j<n_elements; ++j)
+            covariance(i,j) = (normalization > 0
+                               ?
+                               sums[i*n_elements+j] / scalar_type(normalization)
+                               :
+                               sums[i*n_elements+j]);
+
+        return covariance;
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      const SampleFlow::Consumers::CovarianceMatrix<InputType> &
+      CovarianceMatrix<InputType>::
+      local () const
+      {
+        return local_covariance;
+      }
+    }
+  }
+}
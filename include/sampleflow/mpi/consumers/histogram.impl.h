@@ -0,0 +1,242 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    namespace Consumers
+    {
+      /**
+       * A version of the Consumers::Histogram class that computes the
+       * histogram of the samples received on all processes of an MPI
+       * communicator. Each process sorts the samples it receives into its
+       * own bins, without any communication; the get() and get_weighted()
+       * functions then add up the bins of all processes. These functions
+       * are therefore collective operations: They need to be called on all
+       * processes of the communicator at the same time, and return the same
+       * value on all of them. For this to make sense, the objects on all
+       * processes need to be created with the same bins.
+       *
+       *
+       * ### Threading model ###
+       *
+       * The consume() functions of this class are thread-safe, in the same
+       * way as those of Consumers::Histogram. The functions that
+       * communicate must be called from only one thread per process at a
+       * time, as is generally the case for MPI collective operations.
+       *
+       *
+       * @tparam InputType The C++ type used for the samples $x_k$. The same
+       *   requirements apply as for Consumers::Histogram.
+       */
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      class Histogram : public Consumer<InputType>
+      {
+        public:
+          /**
+           * The types of the information generated by this class. These
+           * are the same types as for Consumers::Histogram.
+           */
+          using value_type          = typename SampleFlow::Consumers::Histogram<InputType>::value_type;
+          using weighted_value_type = typename SampleFlow::Consumers::Histogram<InputType>::weighted_value_type;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The communicator over whose processes
+           *   the histogram is to be computed.
+           * @param[in] args The arguments that describe the bins. These
+           *   are passed on to one of the constructors of
+           *   Consumers::Histogram.
+           */
+          template <typename... Args>
+          Histogram (const MPI_Comm communicator,
+                     Args &&...args);
+
+          /**
+           * Destructor. This function also makes sure that all samples this
+           * object may have received have been fully processed. To this end,
+           * it calls the Consumers::disconnect_and_flush() function of the
+           * base class.
+           */
+          virtual ~Histogram ();
+
+          /**
+           * Process one sample by passing it on to the object that computes
+           * the histogram of the samples on the current process.
+           *
+           * @param[in] sample The sample to process.
+           * @param[in] aux_data Auxiliary data about this sample.
+           */
+          virtual
+          void
+          consume (InputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * Like consume(), but for a batch of samples.
+           *
+           * @param[in] samples The samples to process.
+           * @param[in] aux_data Auxiliary data about these samples.
+           */
+          virtual
+          void
+          consume_batch (const std::vector<InputType> &samples,
+                         const std::vector<AuxiliaryData> &aux_data) override;
+
+          /**
+           * Return the histogram of the samples received so far on all
+           * processes, in the format described for
+           * Consumers::Histogram::get(). This is a collective operation.
+           */
+          value_type
+          get () const;
+
+          /**
+           * Return the weighted histogram of the samples received so far on
+           * all processes, in the format described for
+           * Consumers::Histogram::get_weighted(). This is a collective
+           * operation.
+           */
+          weighted_value_type
+          get_weighted () const;
+
+          /**
+           * Return a reference to the object that computes the histogram of
+           * the samples received on the current process. Calling the member
+           * functions of this object does not involve any communication.
+           */
+          const SampleFlow::Consumers::Histogram<InputType> &
+          local () const;
+
+        private:
+          /**
+           * The communicator over whose processes the histogram is computed.
+           */
+          const MPI_Comm communicator;
+
+          /**
+           * The object that computes the histogram of the samples on the
+           * current process.
+           */
+          SampleFlow::Consumers::Histogram<InputType> local_histogram;
+      };
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      template <typename... Args>
+      Histogram<InputType>::
+      Histogram (const MPI_Comm communicator,
+                 Args &&...args)
+        :
+        Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                         |
+                                         static_cast<int>(ParallelMode::asynchronous))),
+        communicator (communicator),
+        local_histogram (std::forward<Args>(args)...)
+      {}
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      Histogram<InputType>::
+      ~Histogram ()
+      {
+        this->disconnect_and_flush();
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      void
+      Histogram<InputType>::
+      consume (InputType sample, AuxiliaryData aux_data)
+      {
+        local_histogram.consume (std::move(sample), std::move(aux_data));
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      void
+      Histogram<InputType>::
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data)
+      {
+        local_histogram.consume_batch (samples, aux_data);
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      typename Histogram<InputType>::value_type
+      Histogram<InputType>::
+      get () const
+      {
+        value_type histogram = local_histogram.get();
+
+        std::vector<types::sample_index> counts (histogram.size());
+        for (std::size_t bin=0; bin<histogram.size(); ++bin)
+          counts[bin] = std::get<2>(histogram[bin]);
+        sum (counts, communicator);
+
+        for (std::size_t bin=0; bin<histogram.size(); ++bin)
+          std::get<2>(histogram[bin]) = counts[bin];
+
+        return histogram;
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      typename Histogram<InputType>::weighted_value_type
+      Histogram<InputType>::
+      get_weighted () const
+      {
+        weighted_value_type histogram = local_histogram.get_weighted();
+
+        std::vector<double> weights (histogram.size());
+        for (std::size_t bin=0; bin<histogram.size(); ++bin)
+          weights[bin] = std::get<2>(histogram[bin]);
+        sum (weights, communicator);
+
+        for (std::size_t bin=0; bin<histogram.size(); ++bin)
+          std::get<2>(histogram[bin]) = weights[bin];
+
+        return histogram;
+      }
+
+
+
+      template <typename InputType>
+      requires (std::is_arithmetic_v<InputType>)
+      const SampleFlow::Consumers::Histogram<InputType> &
+      Histogram<InputType>::
+      local () const
+      {
+        return local_histogram;
+      }
+    }
+  }
+}
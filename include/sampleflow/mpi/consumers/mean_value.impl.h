@@ -0,0 +1,267 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    namespace Consumers
+    {
+      /**
+       * A version of the Consumers::MeanValue class that computes the mean
+       * value over the samples received on all processes of an MPI
+       * communicator. Each process computes the mean value $\bar x_r$ and
+       * total weight $W_r$ (i.e., the number of samples if all samples
+       * have weight one) of the samples it receives itself, without any
+       * communication. The get() function then computes
+       * @f{align*}{
+       *   \bar x = \frac{\sum_r W_r \bar x_r}{\sum_r W_r}
+       * @f}
+       * using one reduction over all processes. It is therefore a
+       * collective operation: It needs to be called on all processes of the
+       * communicator at the same time, and returns the same value on all of
+       * them.
+       *
+       * Processes that have not received any samples contribute nothing to
+       * the mean value. For them to be able to return the mean value, they
+       * need to be able to create an object of type `InputType` of the
+       * correct size: If `InputType` has a `resize()` function (as, for
+       * example, `std::vector` and `Eigen::VectorXd` do), then it is used
+       * for this purpose; otherwise, a default-constructed object of type
+       * `InputType` needs to have the correct size (as is the case for
+       * scalar types and `std::array`).
+       *
+       *
+       * ### Threading model ###
+       *
+       * The consume() function of this class is thread-safe, in the same
+       * way as that of Consumers::MeanValue. The get() function must be
+       * called from only one thread per process at a time, as is generally
+       * the case for MPI collective operations.
+       *
+       *
+       * @tparam InputType The C++ type used for the samples $x_k$. The same
+       *   requirements apply as for Consumers::MeanValue. In addition,
+       *   the elements of the samples need to be of a type for which
+       *   MPI::mpi_type() is implemented.
+       */
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      class MeanValue : public Consumer<InputType>
+      {
+        public:
+          /**
+           * The type of the information generated by this class. This is
+           * the same type as for Consumers::MeanValue.
+           */
+          using value_type = InputType;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The communicator over whose processes
+           *   the mean value is to be computed.
+           */
+          MeanValue (const MPI_Comm communicator);
+
+          /**
+           * Destructor. This function also makes sure that all samples this
+           * object may have received have been fully processed. To this end,
+           * it calls the Consumers::disconnect_and_flush() function of the
+           * base class.
+           */
+          virtual ~MeanValue ();
+
+          /**
+           * Process one sample by passing it on to the objects that compute
+           * the mean value and total weight of the samples on the current
+           * process.
+           *
+           * @param[in] sample The sample to process.
+           * @param[in] aux_data Auxiliary data about this sample.
+           */
+          virtual
+          void
+          consume (InputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * Like consume(), but for a batch of samples.
+           *
+           * @param[in] samples The samples to process.
+           * @param[in] aux_data Auxiliary data about these samples.
+           */
+          virtual
+          void
+          consume_batch (const std::vector<InputType> &samples,
+                         const std::vector<AuxiliaryData> &aux_data) override;
+
+          /**
+           * Return the mean value over the samples received so far on all
+           * processes. If no process has received any samples, then a
+           * default-constructed object of type InputType is returned. This
+           * is a collective operation.
+           */
+          value_type
+          get () const;
+
+          /**
+           * Return a reference to the object that computes the mean value of
+           * the samples received on the current process. Calling the member
+           * functions of this object does not involve any communication.
+           */
+          const SampleFlow::Consumers::MeanValue<InputType> &
+          local () const;
+
+          /**
+           * Return a reference to the object that counts the samples received
+           * on the current process, and adds up their weights.
+           */
+          const SampleFlow::Consumers::CountSamples<InputType> &
+          local_count () const;
+
+        private:
+          /**
+           * The communicator over whose processes the mean value is computed.
+           */
+          const MPI_Comm communicator;
+
+          /**
+           * The objects that compute the mean value and total weight of the
+           * samples on the current process.
+           */
+          SampleFlow::Consumers::MeanValue<InputType>    local_mean_value;
+          SampleFlow::Consumers::CountSamples<InputType> local_sample_count;
+      };
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      MeanValue<InputType>::
+      MeanValue (const MPI_Comm communicator)
+        :
+        Consumer<InputType>(ParallelMode(static_cast<int>(ParallelMode::synchronous)
+                                         |
+                                         static_cast<int>(ParallelMode::asynchronous))),
+        communicator (communicator)
+      {}
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      MeanValue<InputType>::
+      ~MeanValue ()
+      {
+        this->disconnect_and_flush();
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      void
+      MeanValue<InputType>::
+      consume (InputType sample, AuxiliaryData aux_data)
+      {
+        local_sample_count.consume (sample, aux_data);
+        local_mean_value.consume (std::move(sample), std::move(aux_data));
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      void
+      MeanValue<InputType>::
+      consume_batch (const std::vector<InputType> &samples,
+                     const std::vector<AuxiliaryData> &aux_data)
+      {
+        local_sample_count.consume_batch (samples, aux_data);
+        local_mean_value.consume_batch (samples, aux_data);
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      typename MeanValue<InputType>::value_type
+      MeanValue<InputType>::
+      get () const
+      {
+        using scalar_type = types::ScalarType<InputType>;
+
+        const double local_weight = local_sample_count.total_weight();
+        value_type   mean         = local_mean_value.get();
+
+        // First find out how many elements the samples have. Processes
+        // that have not seen any samples do not know, and contribute zero:
+        const std::size_t n_elements
+          = max<std::size_t> ((local_weight > 0 ? Utilities::size(mean) : 0),
+                              communicator);
+
+        // Then add up the weights and the weighted mean values. Put the
+        // total weight into the last element of the array:
+        std::vector<scalar_type> weighted_sums (n_elements+1, scalar_type(0));
+        if (local_weight > 0)
+          {
+            for (std::size_t i=0; i<n_elements; ++i)
+              weighted_sums[i] = Utilities::get_nth_element(mean, i) * scalar_type(local_weight);
+            weighted_sums[n_elements] = local_weight;
+          }
+        sum (weighted_sums, communicator);
+
+        const double total_weight = std::real(weighted_sums[n_elements]);
+        if (total_weight == 0)
+          return value_type();
+
+        if (local_weight == 0)
+          {
+            if constexpr (requires (value_type &x, const std::size_t n) { x.resize(n); })
+              mean.resize (n_elements);
+            assert (Utilities::size(mean) == n_elements);
+          }
+
+        for (std::size_t i=0; i<n_elements; ++i)
+          Utilities::get_nth_element(mean, i) = weighted_sums[i] / scalar_type(total_weight);
+
+        return mean;
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      const SampleFlow::Consumers::MeanValue<InputType> &
+      MeanValue<InputType>::
+      local () const
+      {
+        return local_mean_value;
+      }
+
+
+
+      template <typename InputType>
+      requires (Concepts::is_vector_space_type<InputType>)
+      const SampleFlow::Consumers::CountSamples<InputType> &
+      MeanValue<InputType>::
+      local_count () const
+      {
+        return local_sample_count;
+      }
+    }
+  }
+}
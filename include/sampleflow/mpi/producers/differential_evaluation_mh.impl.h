@@ -0,0 +1,495 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    namespace Producers
+    {
+      /**
+       * A version of the Producers::DifferentialEvaluationMetropolisHastings
+       * class that runs an "island model" across the processes of an MPI
+       * communicator: Each process runs its own population of chains -- an
+       * "island" -- exactly like the base class does, and sends the samples
+       * of its chains to the consumers connected to it on the same process.
+       * Every so many generations, each island sends copies of the current
+       * states of a few randomly chosen members of its population to its
+       * neighbor in a ring of processes (the process with the next larger
+       * rank, and the one with rank zero for the last process), and the
+       * current states of randomly chosen members of its population are
+       * replaced by the ones it has received from its other neighbor. See
+       * Producers::DifferentialEvaluationMetropolisHastings::Parameters::migrate
+       * for a discussion of why this does not affect the distribution that
+       * is sampled once the chains have converged.
+       *
+       * Migration is the only communication between islands, and it never
+       * makes an island wait for another one: The states sent are
+       * transferred by non-blocking messages, and an island uses whatever
+       * states have arrived from its neighbor since the last migration --
+       * possibly none, if the neighbor is slower, or states from several
+       * migrations, if it is faster. If the message an island sent at the
+       * previous migration has not been delivered yet, the island skips
+       * sending at the current one. Islands can therefore run at different
+       * speeds, for example because the likelihood is more expensive to
+       * evaluate in some regions of the parameter space than in others, or
+       * because processes run on machines of different speed.
+       *
+       * The sample() and resume() functions of this class need to be
+       * called on all processes of the communicator, though not at the
+       * same time: Once an island has produced its samples, it waits until
+       * its neighbors have finished as well, so that all messages are
+       * delivered before the function returns. The islands need not all
+       * produce the same number of samples, or have the same number of
+       * chains.
+       *
+       * A typical use looks like this:
+       * @code
+       *   MPI::Producers::DifferentialEvaluationMetropolisHastings<SampleType>
+       *   de_sampler (MPI_COMM_WORLD, migration_interval, n_migrants);
+       *
+       *   MPI::Consumers::MeanValue<SampleType> mean_value (MPI_COMM_WORLD);
+       *   mean_value.connect_to_producer (de_sampler);
+       *
+       *   // Run one population of chains per process, each with its own
+       *   // random seed:
+       *   de_sampler.sample (starting_points,
+       *                      log_likelihood,
+       *                      perturb,
+       *                      crossover,
+       *                      crossover_gap,
+       *                      n_samples_per_process,
+       *                      asynchronous_likelihood_execution,
+       *                      random_seed + MPI::this_rank (MPI_COMM_WORLD));
+       *
+       *   // Compute (on all processes) the mean over all islands:
+       *   const SampleType mean = mean_value.get();
+       * @endcode
+       * If all islands start from the same points with the same random
+       * seed, they produce the same samples; one should therefore pass a
+       * different seed on each process, as above.
+       *
+       * The islands need not be processes: Since migration is implemented
+       * via Parameters::migrate, a program that wants to run several
+       * islands on the threads of one process can instead create several
+       * objects of the base class and pass each a `migrate` function that
+       * exchanges states with the others through shared memory.
+       *
+       * @tparam OutputType The type of the samples. It needs to be
+       *   serializable by the functions of namespace Serialization.
+       * @tparam RandomNumberGenerator The type of the random number
+       *   generator; see Producers::DifferentialEvaluationMetropolisHastings.
+       */
+      template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      class DifferentialEvaluationMetropolisHastings
+        : public SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>
+      {
+        public:
+          /**
+           * The parameters of the sampler; see
+           * Producers::DifferentialEvaluationMetropolisHastings::Parameters.
+           * The `migrate` and `migration_interval` members are ignored
+           * since this class sets them itself.
+           */
+          using Parameters
+            = typename SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::Parameters;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The MPI communicator whose processes
+           *   each run one island. The object uses a duplicate of this
+           *   communicator, so that its messages cannot be confused with
+           *   other messages sent on it.
+           * @param[in] migration_interval The number of generations between
+           *   two migrations.
+           * @param[in] n_migrants The number of members of its population
+           *   an island sends to its neighbor at each migration. This
+           *   number should be small compared to the number of chains,
+           *   so that islands do not become copies of each other.
+           * @param[in] parameters The parameters of the sampler.
+           */
+          DifferentialEvaluationMetropolisHastings (const MPI_Comm            communicator,
+                                                    const types::sample_index migration_interval,
+                                                    const unsigned int        n_migrants,
+                                                    const Parameters         &parameters = {});
+
+          /**
+           * Destructor. Frees the duplicated communicator.
+           */
+          ~DifferentialEvaluationMetropolisHastings ();
+
+          /**
+           * Run the population of chains of the current process, with
+           * migration between islands. The arguments are the same as for
+           * the sample() functions of the base class, and are simply
+           * passed on to the matching one of them.
+           *
+           * This function needs to be called on all processes of the
+           * communicator, and only returns once all neighbors of the
+           * current process have finished sampling as well.
+           */
+          template <typename... Args>
+          void
+          sample (const std::vector<OutputType> &starting_points,
+                  Args &&...args);
+
+          /**
+           * Continue the chains whose state is stored in the given
+           * checkpoint, with migration between islands. The arguments are
+           * the same as for the resume() functions of the base class. The
+           * same considerations as for sample() apply.
+           */
+          template <typename... Args>
+          void
+          resume (const std::vector<char> &checkpoint,
+                  Args &&...args);
+
+          /**
+           * Return the number of states the current island has sent to
+           * its neighbor, and the number of states it has received from
+           * its other neighbor and taken into its population, since the
+           * object was created.
+           */
+          std::pair<types::sample_index,types::sample_index>
+          n_migrants_exchanged () const;
+
+        private:
+          /**
+           * The duplicate of the communicator passed to the constructor.
+           */
+          MPI_Comm communicator;
+
+          /**
+           * The number of members an island sends at each migration.
+           */
+          const unsigned int n_migrants;
+
+          /**
+           * The tags of the messages that carry migrants, and of the
+           * message an island sends to its neighbor once it has finished
+           * sampling.
+           */
+          static constexpr int migration_tag = 1;
+          static constexpr int finished_tag  = 2;
+
+          /**
+           * The buffer holding the migrants sent last, and the request
+           * for this message. The buffer may only be reused once the
+           * request has completed.
+           */
+          std::vector<char> send_buffer;
+          MPI_Request       send_request;
+
+          /**
+           * The buffer into which migrants are received.
+           */
+          std::vector<char> receive_buffer;
+
+          /**
+           * The numbers of states sent and received so far.
+           */
+          types::sample_index n_sent;
+          types::sample_index n_received;
+
+          /**
+           * Return a copy of the given parameters in which the `migrate`
+           * member calls the migrate() function of the given object.
+           */
+          static
+          Parameters
+          with_migration (const Parameters                         &parameters,
+                          const types::sample_index                 migration_interval,
+                          DifferentialEvaluationMetropolisHastings *island);
+
+          /**
+           * Take the migrants that have arrived from the neighbor with the
+           * next smaller rank into the population, and send migrants to
+           * the one with the next larger rank, without waiting for either.
+           * This is the function called via Parameters::migrate.
+           */
+          void
+          migrate (std::vector<OutputType> &current_samples,
+                   std::vector<double>     &current_log_likelihoods,
+                   RandomNumberGenerator   &rng);
+
+          /**
+           * Tell the neighbor with the next larger rank that the current
+           * island has finished sampling, and discard all messages from
+           * the neighbor with the next smaller rank until it has finished
+           * as well. Then wait for the messages sent by the current island
+           * to be delivered. This is called at the end of sample() and
+           * resume(), so that no message is left over when they return.
+           */
+          void
+          finish_migration ();
+
+          /**
+           * Return the ranks of the neighbors of the current process to
+           * which it sends migrants and from which it receives them.
+           */
+          int
+          destination () const;
+
+          int
+          source () const;
+      };
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      DifferentialEvaluationMetropolisHastings (const MPI_Comm            communicator,
+                                                const types::sample_index migration_interval,
+                                                const unsigned int        n_migrants,
+                                                const Parameters         &parameters)
+        :
+        SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>
+        (with_migration (parameters, migration_interval, this)),
+        n_migrants (n_migrants),
+        send_request (MPI_REQUEST_NULL),
+        n_sent (0),
+        n_received (0)
+      {
+        assert (migration_interval > 0);
+        assert (n_migrants > 0);
+
+        [[maybe_unused]] const int ierr = MPI_Comm_dup (communicator, &this->communicator);
+        assert (ierr == MPI_SUCCESS);
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      ~DifferentialEvaluationMetropolisHastings ()
+      {
+        // All messages have been delivered at the end of sample() or
+        // resume(), unless these functions were left via an exception.
+        // In that case, there is nothing sensible we can do about
+        // outstanding messages.
+        MPI_Comm_free (&communicator);
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      template <typename... Args>
+      void
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      sample (const std::vector<OutputType> &starting_points,
+              Args &&...args)
+      {
+        SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+        sample (starting_points, std::forward<Args>(args)...);
+
+        finish_migration ();
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      template <typename... Args>
+      void
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      resume (const std::vector<char> &checkpoint,
+              Args &&...args)
+      {
+        SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+        resume (checkpoint, std::forward<Args>(args)...);
+
+        finish_migration ();
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      std::pair<types::sample_index,types::sample_index>
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      n_migrants_exchanged () const
+      {
+        return {n_sent, n_received};
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      typename DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::Parameters
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      with_migration (const Parameters                         &parameters,
+                      const types::sample_index                 migration_interval,
+                      DifferentialEvaluationMetropolisHastings *island)
+      {
+        Parameters parameters_with_migration = parameters;
+        parameters_with_migration.migration_interval = migration_interval;
+        parameters_with_migration.migrate
+          = [island](std::vector<OutputType> &current_samples,
+                     std::vector<double>     &current_log_likelihoods,
+                     RandomNumberGenerator   &rng)
+        {
+          island->migrate (current_samples, current_log_likelihoods, rng);
+        };
+        return parameters_with_migration;
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      void
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      migrate (std::vector<OutputType> &current_samples,
+               std::vector<double>     &current_log_likelihoods,
+               RandomNumberGenerator   &rng)
+      {
+        const std::size_t n_chains = current_samples.size();
+        std::uniform_int_distribution<std::size_t> random_chain (0, n_chains-1);
+
+        // First take in whatever migrants have arrived, each replacing
+        // the state of a randomly chosen chain:
+        while (true)
+          {
+            int        message_arrived;
+            MPI_Status status;
+            [[maybe_unused]] int ierr = MPI_Iprobe (source(), migration_tag, communicator,
+                                                    &message_arrived, &status);
+            assert (ierr == MPI_SUCCESS);
+            if (!message_arrived)
+              break;
+
+            int n_bytes;
+            ierr = MPI_Get_count (&status, MPI_BYTE, &n_bytes);
+            assert (ierr == MPI_SUCCESS);
+            receive_buffer.resize (n_bytes);
+            ierr = MPI_Recv (receive_buffer.data(), n_bytes, MPI_BYTE, source(), migration_tag,
+                             communicator, MPI_STATUS_IGNORE);
+            assert (ierr == MPI_SUCCESS);
+
+            std::span<const char> buffer (receive_buffer);
+            std::size_t n_arrived;
+            Serialization::read (buffer, n_arrived);
+            for (std::size_t i=0; i<n_arrived; ++i)
+              {
+                const std::size_t chain = random_chain (rng);
+                Serialization::read (buffer, current_samples[chain]);
+                Serialization::read (buffer, current_log_likelihoods[chain]);
+              }
+            n_received += n_arrived;
+          }
+
+        // Then send copies of randomly chosen members of the population,
+        // unless the previous message is still on its way:
+        if (send_request != MPI_REQUEST_NULL)
+          {
+            int previous_message_delivered;
+            [[maybe_unused]] const int ierr = MPI_Test (&send_request, &previous_message_delivered,
+                                                        MPI_STATUS_IGNORE);
+            assert (ierr == MPI_SUCCESS);
+            if (!previous_message_delivered)
+              return;
+          }
+
+        const std::size_t n_sent_now = std::min<std::size_t> (n_migrants, n_chains);
+        send_buffer.clear ();
+        Serialization::write (send_buffer, n_sent_now);
+        for (std::size_t i=0; i<n_sent_now; ++i)
+          {
+            const std::size_t chain = random_chain (rng);
+            Serialization::write (send_buffer, current_samples[chain]);
+            Serialization::write (send_buffer, current_log_likelihoods[chain]);
+          }
+
+        [[maybe_unused]] const int ierr = MPI_Isend (send_buffer.data(), send_buffer.size(), MPI_BYTE,
+                                                     destination(), migration_tag, communicator,
+                                                     &send_request);
+        assert (ierr == MPI_SUCCESS);
+        n_sent += n_sent_now;
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      void
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      finish_migration ()
+      {
+        // Tell the neighbor that no more migrants will come from here.
+        // Messages between two processes do not overtake each other, so
+        // this message arrives after all migrants we have sent.
+        MPI_Request finished_request;
+        [[maybe_unused]] int ierr = MPI_Isend (nullptr, 0, MPI_BYTE, destination(), finished_tag,
+                                               communicator, &finished_request);
+        assert (ierr == MPI_SUCCESS);
+
+        // Then receive (and discard) the migrants the other neighbor sends
+        // until it tells us that it is done as well:
+        while (true)
+          {
+            MPI_Status status;
+            ierr = MPI_Probe (source(), MPI_ANY_TAG, communicator, &status);
+            assert (ierr == MPI_SUCCESS);
+
+            int n_bytes;
+            ierr = MPI_Get_count (&status, MPI_BYTE, &n_bytes);
+            assert (ierr == MPI_SUCCESS);
+            receive_buffer.resize (n_bytes);
+            ierr = MPI_Recv (receive_buffer.data(), n_bytes, MPI_BYTE, source(), status.MPI_TAG,
+                             communicator, MPI_STATUS_IGNORE);
+            assert (ierr == MPI_SUCCESS);
+
+            if (status.MPI_TAG == finished_tag)
+              break;
+          }
+
+        // Finally, make sure our own messages have been delivered:
+        ierr = MPI_Wait (&send_request, MPI_STATUS_IGNORE);
+        assert (ierr == MPI_SUCCESS);
+        ierr = MPI_Wait (&finished_request, MPI_STATUS_IGNORE);
+        assert (ierr == MPI_SUCCESS);
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      int
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      destination () const
+      {
+        return (this_rank (communicator) + 1) % n_ranks (communicator);
+      }
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      int
+      DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+      source () const
+      {
+        return (this_rank (communicator) + n_ranks (communicator) - 1) % n_ranks (communicator);
+      }
+    }
+  }
+}
@@ -0,0 +1,169 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace MPI
+  {
+    /**
+     * A namespace for the producers that distribute their work across the
+     * processes of an MPI communicator.
+     */
+    namespace Producers
+    {
+      /**
+       * A version of the Producers::MetropolisHastings class whose
+       * sample_chains() functions distribute the chains across the
+       * processes of an MPI communicator. All processes call
+       * sample_chains() with the same (complete) list of starting points;
+       * each process then runs only its own, contiguous subset of these
+       * chains (see MPI::local_range()) and sends the samples of these
+       * chains to the consumers connected to it on the same process. No
+       * communication happens during sampling, and different processes do
+       * not wait for each other except as implied by whatever the
+       * consumers do.
+       *
+       * Chains keep their global numbers: The chain started from the
+       * $c$th starting point uses the same random number stream, and
+       * reports the same AuxiliaryData::chain_number, regardless of which
+       * process runs it and how many processes there are (see
+       * Producers::MetropolisHastings::Parameters::first_chain_number).
+       * As a consequence, the union of the samples produced on all
+       * processes does not depend on the number of processes.
+       *
+       * A typical use looks like this:
+       * @code
+       *   MPI::Producers::MetropolisHastings<SampleType> mh_sampler (MPI_COMM_WORLD);
+       *
+       *   MPI::Consumers::MeanValue<SampleType> mean_value (MPI_COMM_WORLD);
+       *   mean_value.connect_to_producer (mh_sampler);
+       *
+       *   // Run 256 chains distributed over all processes:
+       *   mh_sampler.sample_chains (starting_points,
+       *                             log_likelihood,
+       *                             perturb,
+       *                             n_samples_per_chain);
+       *
+       *   // Compute (on all processes) the mean over all chains:
+       *   const SampleType mean = mean_value.get();
+       * @endcode
+       *
+       * The sample() function inherited from the base class is not
+       * distributed: It runs one chain on each process on which it is
+       * called.
+       *
+       * @tparam OutputType The type of the samples.
+       * @tparam RandomNumberGenerator The type of the random number
+       *   generator; see Producers::MetropolisHastings.
+       */
+      template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      class MetropolisHastings
+        : public SampleFlow::Producers::MetropolisHastings<OutputType,RandomNumberGenerator>
+      {
+        public:
+          /**
+           * The parameters of the sampler; see
+           * Producers::MetropolisHastings::Parameters. The
+           * `first_chain_number` member is ignored since this class
+           * determines it itself.
+           */
+          using Parameters
+            = typename SampleFlow::Producers::MetropolisHastings<OutputType,RandomNumberGenerator>::Parameters;
+
+          /**
+           * Constructor.
+           *
+           * @param[in] communicator The MPI communicator over whose
+           *   processes the chains are to be distributed.
+           * @param[in] parameters The parameters of the sampler.
+           */
+          MetropolisHastings (const MPI_Comm    communicator,
+                              const Parameters &parameters = {});
+
+          /**
+           * Run the chains that belong to the current process. The
+           * arguments are the same as for the `sample_chains()` functions
+           * of the base class, and are simply passed on to the matching
+           * one of them; the only difference is that `starting_points`
+           * contains the starting points of the chains of all processes.
+           *
+           * This function needs to be called with the same
+           * `starting_points` on all processes, but is not a collective
+           * operation in the MPI sense: It does not communicate.
+           */
+          template <typename... Args>
+          void
+          sample_chains (const std::vector<OutputType> &starting_points,
+                         Args &&...args);
+
+        private:
+          /**
+           * The communicator over whose processes the chains are
+           * distributed.
+           */
+          const MPI_Comm communicator;
+      };
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      MetropolisHastings<OutputType,RandomNumberGenerator>::
+      MetropolisHastings (const MPI_Comm    communicator,
+                          const Parameters &parameters)
+        :
+        SampleFlow::Producers::MetropolisHastings<OutputType,RandomNumberGenerator> (parameters),
+        communicator (communicator)
+      {}
+
+
+
+      template <typename OutputType, typename RandomNumberGenerator>
+      requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+      template <typename... Args>
+      void
+      MetropolisHastings<OutputType,RandomNumberGenerator>::
+      sample_chains (const std::vector<OutputType> &starting_points,
+                     Args &&...args)
+      {
+        const std::pair<std::size_t,std::size_t> local_chains
+          = local_range (starting_points.size(), communicator);
+
+        if (local_chains.first == local_chains.second)
+          return;
+
+        const std::vector<OutputType>
+        local_starting_points (starting_points.begin() + local_chains.first,
+                               starting_points.begin() + local_chains.second);
+
+        // Number the local chains by their global indices for the duration
+        // of this call, and restore the parameters afterwards so that later
+        // calls (including of the base class's sample() function) are not
+        // affected:
+        const std::size_t previous_first_chain_number = this->parameters.first_chain_number;
+        Utilities::ScopeExit restore_parameters ([this, previous_first_chain_number]()
+        {
+          this->parameters.first_chain_number = previous_first_chain_number;
+        });
+
+        this->parameters.first_chain_number = local_chains.first;
+        SampleFlow::Producers::MetropolisHastings<OutputType,RandomNumberGenerator>::
+        sample_chains (local_starting_points, std::forward<Args>(args)...);
+      }
+    }
+  }
+}
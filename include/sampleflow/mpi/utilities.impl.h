@@ -0,0 +1,181 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes and functions that allow running sampling
+   * algorithms on several processes that communicate via the Message
+   * Passing Interface (MPI), in particular on clusters. This part of the
+   * library is optional: It is only available if the files in the
+   * `sampleflow/mpi/` directory are included explicitly, which in turn
+   * requires that the MPI header file `mpi.h` is available and that
+   * programs are linked with an MPI library. It is also not part of the
+   * `SampleFlow` C++20 module.
+   *
+   * The general approach to running a sampler on $P$ processes ("ranks")
+   * is that each process runs a part of the overall set of chains -- see
+   * MPI::Producers::MetropolisHastings -- and sends the samples it
+   * produces to consumers on the same process. Nothing in the path along
+   * which samples travel involves any communication. Rather, the
+   * consumers in namespace MPI::Consumers compute their statistics from
+   * the samples on their own process, just like the consumers in namespace
+   * Consumers, and only communicate with the consumers on the other
+   * processes when their `get()` function is called: They then exchange
+   * and combine their partial results (numbers of samples, sums of
+   * weights, mean values, sums of products, histogram bins) to compute the
+   * result over the samples of all processes. Consequently, the `get()`
+   * functions of these classes are "collective" operations in MPI
+   * parlance: They need to be called on all processes of the communicator
+   * at the same time, and they return the same result on all processes.
+   *
+   * The exception to the rule that sampling does not involve communication
+   * is MPI::Producers::DifferentialEvaluationMetropolisHastings, which runs
+   * one population of chains on each process and every so often exchanges
+   * a few members of these populations between processes via non-blocking
+   * messages.
+   */
+  namespace MPI
+  {
+    /**
+     * Return the MPI data type that corresponds to the C++ type `T`. This
+     * function is implemented for the floating point types, their complex
+     * counterparts, and the unsigned integer types.
+     */
+    template <typename T>
+    MPI_Datatype
+    mpi_type ()
+    {
+      if constexpr (std::is_same_v<T, double>)
+        return MPI_DOUBLE;
+      else if constexpr (std::is_same_v<T, float>)
+        return MPI_FLOAT;
+      else if constexpr (std::is_same_v<T, long double>)
+        return MPI_LONG_DOUBLE;
+      else if constexpr (std::is_same_v<T, std::complex<double>>)
+        return MPI_CXX_DOUBLE_COMPLEX;
+      else if constexpr (std::is_same_v<T, std::complex<float>>)
+        return MPI_CXX_FLOAT_COMPLEX;
+      else if constexpr (std::is_same_v<T, std::complex<long double>>)
+        return MPI_CXX_LONG_DOUBLE_COMPLEX;
+      else if constexpr (std::is_same_v<T, unsigned int>)
+        return MPI_UNSIGNED;
+      else if constexpr (std::is_same_v<T, unsigned long>)
+        return MPI_UNSIGNED_LONG;
+      else if constexpr (std::is_same_v<T, unsigned long long>)
+        return MPI_UNSIGNED_LONG_LONG;
+      else
+        static_assert (sizeof(T) == 0,
+                       "There is no MPI data type for this C++ type.");
+    }
+
+
+
+    /**
+     * Return the number of the current process within the given
+     * communicator.
+     */
+    inline
+    int
+    this_rank (const MPI_Comm communicator)
+    {
+      int rank;
+      [[maybe_unused]] const int ierr = MPI_Comm_rank (communicator, &rank);
+      assert (ierr == MPI_SUCCESS);
+
+      return rank;
+    }
+
+
+
+    /**
+     * Return the number of processes within the given communicator.
+     */
+    inline
+    int
+    n_ranks (const MPI_Comm communicator)
+    {
+      int size;
+      [[maybe_unused]] const int ierr = MPI_Comm_size (communicator, &size);
+      assert (ierr == MPI_SUCCESS);
+
+      return size;
+    }
+
+
+
+    /**
+     * Split the index range $[0,n)$ into contiguous pieces, one for each
+     * process in the given communicator, and return the half-open range
+     * $[b,e)$ that the current process owns. The pieces differ in size by
+     * at most one, and the pieces of processes with smaller rank come
+     * first. If there are more processes than elements, then some
+     * processes own an empty range.
+     */
+    inline
+    std::pair<std::size_t,std::size_t>
+    local_range (const std::size_t n,
+                 const MPI_Comm    communicator)
+    {
+      const std::size_t rank   = this_rank (communicator);
+      const std::size_t n_proc = n_ranks (communicator);
+
+      const std::size_t n_per_rank = n / n_proc;
+      const std::size_t remainder  = n % n_proc;
+
+      const std::size_t begin = rank * n_per_rank + std::min (rank, remainder);
+      const std::size_t end   = begin + n_per_rank + (rank < remainder ? 1 : 0);
+
+      return {begin, end};
+    }
+
+
+
+    /**
+     * Replace each element of `values` by the sum of the corresponding
+     * elements on all processes of the communicator. The vector needs to
+     * have the same size on all processes. This is a collective operation.
+     */
+    template <typename T>
+    void
+    sum (std::vector<T>  &values,
+         const MPI_Comm   communicator)
+    {
+      [[maybe_unused]] const int ierr = MPI_Allreduce (MPI_IN_PLACE, values.data(), values.size(),
+                                                       mpi_type<T>(), MPI_SUM, communicator);
+      assert (ierr == MPI_SUCCESS);
+    }
+
+
+
+    /**
+     * Return the maximum of the `value` arguments passed on all processes
+     * of the communicator. This is a collective operation.
+     */
+    template <typename T>
+    T
+    max (const T         value,
+         const MPI_Comm  communicator)
+    {
+      T result;
+      [[maybe_unused]] const int ierr = MPI_Allreduce (&value, &result, 1,
+                                                       mpi_type<T>(), MPI_MAX, communicator);
+      assert (ierr == MPI_SUCCESS);
+
+      return result;
+    }
+  }
+}
@@ -0,0 +1,489 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the functions that define how Consumers::NetworkOutput
+   * sends samples over a TCP connection to a Producers::NetworkInput object
+   * on another machine (or in another process, or even the same process).
+   *
+   * When a connection is established, the sending side first sends the
+   * eight bytes of `magic`, then the size of the ChainFileFormat::Header
+   * that describes the records it will send (as a 64-bit integer) and the
+   * header itself, as written by ChainFileFormat::write_header(). After
+   * that, it sends "frames", each of which consists of a FrameHeader
+   * followed by a payload that contains the records (in the layout
+   * described in the documentation of namespace ChainFileFormat) of a batch
+   * of samples. The payload may be compressed in one of the ways
+   * described by Compression. The sending side ends the stream by closing
+   * the connection. Like the ChainFileFormat, this protocol uses the byte
+   * order of the machine, which we require to be little endian.
+   */
+  namespace NetworkStream
+  {
+    /**
+     * The first eight bytes sent over every connection.
+     */
+    inline constexpr char magic[8] = {'S', 'F', 'N', 'E', 'T', 0, 0, 1};
+
+    /**
+     * The ways in which the payload of a frame can be compressed.
+     */
+    enum class Compression : std::uint32_t
+    {
+      /**
+       * The payload contains the records as they are.
+       */
+      none = 0,
+
+      /**
+       * The payload is compressed by a simple scheme that works well for
+       * the records of a Markov chain and that is cheap enough to keep up
+       * with a network connection on a single core: Each record is first
+       * replaced by the bitwise exclusive-or of itself and the previous
+       * record in the batch. Consecutive samples of a chain are often
+       * identical (whenever a proposal is rejected) or close to each
+       * other, and in the latter case they share their sign, exponent,
+       * and leading mantissa bits; the exclusive-or of the two is then
+       * zero in all of these bits, and the same is typically true for
+       * the auxiliary data. The bytes of the batch are then reordered so
+       * that the first byte of all records comes first, followed by the
+       * second byte of all records, and so on, which turns these zeros
+       * into long runs. Finally, runs of zero bytes are replaced by a
+       * single byte that stores their length: A byte value $c<128$ is
+       * followed by $c+1$ bytes that are stored as they are, and a byte
+       * value $c\ge 128$ stands for $c-127$ zero bytes.
+       *
+       * If compressing a batch in this way does not make it smaller, then
+       * the frame is sent without compression.
+       */
+      delta_zero_run = 1
+    };
+
+    /**
+     * The structure that precedes the payload of every frame.
+     */
+    struct FrameHeader
+    {
+      /**
+       * The number of records in the frame.
+       */
+      std::uint32_t n_records;
+
+      /**
+       * How the payload is compressed, see Compression.
+       */
+      std::uint32_t compression;
+
+      /**
+       * The number of bytes of the payload.
+       */
+      std::uint64_t payload_size;
+    };
+
+    /**
+     * Create a frame (i.e., the FrameHeader followed by the payload) that
+     * contains the given records, each of which has the given size, using
+     * the given compression.
+     */
+    std::vector<char>
+    encode_frame (const std::span<const char> records,
+                  const std::size_t           record_size,
+                  const Compression           compression);
+
+    /**
+     * Restore the records from the payload of a frame described by the
+     * given header, where each record has the given size.
+     */
+    void
+    decode_payload (const FrameHeader          &frame_header,
+                    const std::span<const char> payload,
+                    const std::size_t           record_size,
+                    std::vector<char>          &records);
+
+    /**
+     * Create the bytes that start a connection: `magic`, followed by the
+     * size of the given header and the header itself.
+     */
+    std::vector<char>
+    encode_preamble (const ChainFileFormat::Header &header);
+
+    /**
+     * Receive the bytes sent by encode_preamble() from the given socket,
+     * and return the header. Return an empty object if the connection is
+     * closed before the preamble has been received.
+     */
+    std::optional<ChainFileFormat::Header>
+    receive_preamble (const int socket);
+
+    /**
+     * Send the given bytes over the given socket. Return whether this was
+     * successful; it is not if the other side has closed the connection.
+     */
+    bool
+    send_all (const int                   socket,
+              const std::span<const char> data);
+
+    /**
+     * Receive exactly as many bytes from the given socket as fit into the
+     * given buffer. Return whether this was successful; it is not if the
+     * connection was closed before enough bytes arrived.
+     */
+    bool
+    receive_all (const int             socket,
+                 const std::span<char> data);
+
+    /**
+     * Open a TCP connection to the given host and port, and return the
+     * socket.
+     */
+    int
+    connect_to (const std::string  &host,
+                const std::uint16_t port);
+
+    /**
+     * Create a socket that listens for TCP connections on the given port on
+     * all network interfaces of the machine, with room for the given
+     * number of connections waiting to be accepted. If the port is zero,
+     * the operating system chooses a free port.
+     */
+    int
+    listen_on (const std::uint16_t port,
+               const unsigned int  backlog);
+
+    /**
+     * Return the port on which the given socket listens.
+     */
+    std::uint16_t
+    local_port (const int socket);
+
+
+
+    inline
+    std::vector<char>
+    encode_frame (const std::span<const char> records,
+                  const std::size_t           record_size,
+                  const Compression           compression)
+    {
+      assert (std::endian::native == std::endian::little);
+      assert (record_size > 0);
+      assert (records.size() % record_size == 0);
+
+      const std::size_t n_records = records.size() / record_size;
+
+      FrameHeader frame_header;
+      frame_header.n_records    = static_cast<std::uint32_t>(n_records);
+      frame_header.compression  = static_cast<std::uint32_t>(Compression::none);
+      frame_header.payload_size = records.size();
+
+      std::vector<char> frame (sizeof(FrameHeader));
+
+      if (compression == Compression::delta_zero_run)
+        {
+          // Take differences between subsequent records and reorder the
+          // bytes at the same time:
+          std::vector<unsigned char> planes (records.size());
+          const unsigned char *const bytes = reinterpret_cast<const unsigned char *>(records.data());
+          for (std::size_t j=0; j<record_size; ++j)
+            {
+              unsigned char previous = 0;
+              for (std::size_t i=0; i<n_records; ++i)
+                {
+                  const unsigned char current = bytes[i*record_size + j];
+                  planes[j*n_records + i] = current ^ previous;
+                  previous = current;
+                }
+            }
+
+          // Then replace runs of zeros. Runs of length one are not worth
+          // it, and we simply store them as part of the surrounding
+          // literal bytes:
+          std::vector<char> &payload = frame;
+          std::size_t p = 0;
+          while ((p < planes.size()) && (payload.size() < sizeof(FrameHeader) + records.size()))
+            {
+              std::size_t zeros = 0;
+              while ((p+zeros < planes.size()) && (planes[p+zeros] == 0) && (zeros < 128))
+                ++zeros;
+
+              if (zeros >= 2)
+                {
+                  payload.push_back (static_cast<char>(127 + zeros));
+                  p += zeros;
+                }
+              else
+                {
+                  std::size_t n_literals = 0;
+                  while ((p+n_literals < planes.size()) && (n_literals < 128)
+                         &&
+                         !((p+n_literals+1 < planes.size())
+                           && (planes[p+n_literals] == 0)
+                           && (planes[p+n_literals+1] == 0)))
+                    ++n_literals;
+
+                  payload.push_back (static_cast<char>(n_literals - 1));
+                  payload.insert (payload.end(),
+                                  planes.begin() + p, planes.begin() + p + n_literals);
+                  p += n_literals;
+                }
+            }
+
+          if (payload.size() < sizeof(FrameHeader) + records.size())
+            {
+              frame_header.compression  = static_cast<std::uint32_t>(Compression::delta_zero_run);
+              frame_header.payload_size = payload.size() - sizeof(FrameHeader);
+            }
+          else
+            frame.resize (sizeof(FrameHeader));
+        }
+
+      if (frame_header.compression == static_cast<std::uint32_t>(Compression::none))
+        frame.insert (frame.end(), records.begin(), records.end());
+
+      std::memcpy (frame.data(), &frame_header, sizeof(FrameHeader));
+      return frame;
+    }
+
+
+
+    inline
+    void
+    decode_payload (const FrameHeader          &frame_header,
+                    const std::span<const char> payload,
+                    const std::size_t           record_size,
+                    std::vector<char>          &records)
+    {
+      const std::size_t n_records = frame_header.n_records;
+      records.resize (n_records * record_size);
+
+      switch (static_cast<Compression>(frame_header.compression))
+        {
+          case Compression::none:
+          {
+            assert (payload.size() == records.size());
+            std::copy (payload.begin(), payload.end(), records.begin());
+            return;
+          }
+
+          case Compression::delta_zero_run:
+          {
+            // First undo the replacement of runs of zeros:
+            std::vector<unsigned char> planes;
+            planes.reserve (records.size());
+            for (std::size_t p=0; p<payload.size(); )
+              {
+                const unsigned int c = static_cast<unsigned char>(payload[p]);
+                ++p;
+                if (c >= 128)
+                  planes.insert (planes.end(), c - 127, 0);
+                else
+                  {
+                    assert (p + c + 1 <= payload.size());
+                    planes.insert (planes.end(), payload.begin() + p, payload.begin() + p + c + 1);
+                    p += c + 1;
+                  }
+              }
+            assert (planes.size() == records.size());
+
+            // Then restore the original order of bytes and undo the
+            // differences:
+            unsigned char *const bytes = reinterpret_cast<unsigned char *>(records.data());
+            for (std::size_t j=0; j<record_size; ++j)
+              {
+                unsigned char previous = 0;
+                for (std::size_t i=0; i<n_records; ++i)
+                  {
+                    previous ^= planes[j*n_records + i];
+                    bytes[i*record_size + j] = previous;
+                  }
+              }
+            return;
+          }
+
+          default:
+            assert (false);
+        }
+    }
+
+
+
+    inline
+    std::vector<char>
+    encode_preamble (const ChainFileFormat::Header &header)
+    {
+      const std::vector<char> header_bytes = ChainFileFormat::write_header (header);
+
+      std::vector<char> preamble (std::begin(magic), std::end(magic));
+      Serialization::write (preamble, static_cast<std::uint64_t>(header_bytes.size()));
+      preamble.insert (preamble.end(), header_bytes.begin(), header_bytes.end());
+      return preamble;
+    }
+
+
+
+    inline
+    std::optional<ChainFileFormat::Header>
+    receive_preamble (const int socket)
+    {
+      char          received_magic[sizeof(magic)];
+      std::uint64_t header_size;
+      if ((receive_all (socket, received_magic) == false)
+          ||
+          (receive_all (socket, {reinterpret_cast<char *>(&header_size), sizeof(header_size)}) == false))
+        return {};
+      assert (std::memcmp (received_magic, magic, sizeof(magic)) == 0);
+
+      std::vector<char> header_bytes (header_size);
+      if (receive_all (socket, header_bytes) == false)
+        return {};
+
+      std::span<const char> buffer (header_bytes);
+      return ChainFileFormat::read_header (buffer);
+    }
+
+
+
+    inline
+    bool
+    send_all (const int                   socket,
+              const std::span<const char> data)
+    {
+      std::size_t n_sent = 0;
+      while (n_sent < data.size())
+        {
+          // Do not let the operating system kill the program with SIGPIPE
+          // if the other side has closed the connection:
+          const ssize_t n = send (socket, data.data() + n_sent, data.size() - n_sent,
+                                  MSG_NOSIGNAL);
+          if (n < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              return false;
+            }
+          n_sent += n;
+        }
+      return true;
+    }
+
+
+
+    inline
+    bool
+    receive_all (const int             socket,
+                 const std::span<char> data)
+    {
+      std::size_t n_received = 0;
+      while (n_received < data.size())
+        {
+          const ssize_t n = recv (socket, data.data() + n_received,
+                                  data.size() - n_received, 0);
+          if (n < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              return false;
+            }
+          if (n == 0)
+            return false;
+          n_received += n;
+        }
+      return true;
+    }
+
+
+
+    inline
+    int
+    connect_to (const std::string  &host,
+                const std::uint16_t port)
+    {
+      addrinfo hints;
+      std::memset (&hints, 0, sizeof(hints));
+      hints.ai_family   = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+
+      addrinfo *addresses = nullptr;
+      [[maybe_unused]] const int ierr = getaddrinfo (host.c_str(), std::to_string(port).c_str(),
+                                                     &hints, &addresses);
+      assert (ierr == 0);
+
+      // Try the addresses the host name resolves to, one after the other:
+      int socket_fd = -1;
+      for (const addrinfo *address = addresses; address != nullptr; address = address->ai_next)
+        {
+          socket_fd = socket (address->ai_family, address->ai_socktype, address->ai_protocol);
+          if (socket_fd < 0)
+            continue;
+          if (connect (socket_fd, address->ai_addr, address->ai_addrlen) == 0)
+            break;
+          close (socket_fd);
+          socket_fd = -1;
+        }
+      freeaddrinfo (addresses);
+      assert (socket_fd >= 0);
+
+      // We always send whole frames, so there is no point in waiting for
+      // more data before sending a packet:
+      const int one = 1;
+      setsockopt (socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      return socket_fd;
+    }
+
+
+
+    inline
+    int
+    listen_on (const std::uint16_t port,
+               const unsigned int  backlog)
+    {
+      const int socket_fd = socket (AF_INET, SOCK_STREAM, 0);
+      assert (socket_fd >= 0);
+
+      const int one = 1;
+      setsockopt (socket_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+      sockaddr_in address;
+      std::memset (&address, 0, sizeof(address));
+      address.sin_family      = AF_INET;
+      address.sin_addr.s_addr = htonl (INADDR_ANY);
+      address.sin_port        = htons (port);
+
+      [[maybe_unused]] int ierr = bind (socket_fd, reinterpret_cast<const sockaddr *>(&address),
+                                        sizeof(address));
+      assert (ierr == 0);
+      ierr = listen (socket_fd, static_cast<int>(backlog));
+      assert (ierr == 0);
+
+      return socket_fd;
+    }
+
+
+
+    inline
+    std::uint16_t
+    local_port (const int socket)
+    {
+      sockaddr_in address;
+      socklen_t   address_size = sizeof(address);
+      [[maybe_unused]] const int ierr = getsockname (socket, reinterpret_cast<sockaddr *>(&address),
+                                                     &address_size);
+      assert (ierr == 0);
+      return ntohs (address.sin_port);
+    }
+  }
+}
@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that connect SampleFlow to OpenMP. Code
+   * that uses these classes needs to be compiled with OpenMP support
+   * enabled (for example, with the `-fopenmp` flag for GCC and Clang).
+   * Like the classes in namespaces MPI and HDF5, these classes are not
+   * included in the SampleFlow module.
+   */
+  namespace OpenMP
+  {
+    /**
+     * An implementation of the Executor interface that runs tasks as
+     * OpenMP tasks. This is meant for applications that are parallelized
+     * with OpenMP and call SampleFlow from within a parallel region,
+     * typically from code executed by only one thread of the team:
+     * @code
+     *   auto pool = std::make_shared<SampleFlow::ThreadPool>
+     *               (std::make_shared<SampleFlow::OpenMP::Executor>());
+     *   #pragma omp parallel
+     *   #pragma omp single
+     *   {
+     *     mh_sampler.sample_chains (starting_points, log_likelihood,
+     *                               perturb, n_samples, pool);
+     *   }
+     * @endcode
+     * The tasks SampleFlow creates are then executed by the other threads
+     * of the team, which pick up tasks while they wait at the implicit
+     * barrier at the end of the `single` construct.
+     *
+     * OpenMP tasks can only be run in parallel if they are created inside
+     * a parallel region. If execute() is called outside of one, the task
+     * is therefore executed right away on the calling thread.
+     */
+    class Executor : public SampleFlow::Executor
+    {
+      public:
+        /**
+         * Create an OpenMP task that executes the given task if we are in
+         * a parallel region, or execute the task right away otherwise.
+         */
+        virtual
+        void
+        execute (std::function<void ()> &&task) override;
+
+        /**
+         * Return the number of threads of the current team if we are in a
+         * parallel region, or the number of threads a parallel region would
+         * use otherwise.
+         */
+        virtual
+        unsigned int
+        concurrency () const override;
+    };
+
+
+
+    inline
+    void
+    Executor::execute (std::function<void ()> &&task)
+    {
+      if (omp_in_parallel())
+        {
+          // Tasks need to capture their data by value. Wrap the function
+          // object into a shared pointer so that capturing it does not
+          // copy whatever the function object itself has captured.
+          const std::shared_ptr<std::function<void ()>> shared_task
+            = std::make_shared<std::function<void ()>>(std::move(task));
+#pragma omp task firstprivate(shared_task)
+          (*shared_task)();
+        }
+      else
+        task ();
+    }
+
+
+
+    inline
+    unsigned int
+    Executor::concurrency () const
+    {
+      if (omp_in_parallel())
+        return omp_get_num_threads();
+      else
+        return omp_get_max_threads();
+    }
+  }
+}
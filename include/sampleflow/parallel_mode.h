@@ -19,6 +19,8 @@
 
 #include <sampleflow/config.h>
 
+#include <thread>
+
 // Import the implementation of the things for this header file:
 #include <sampleflow/parallel_mode.impl.h>
 
@@ -45,56 +45,370 @@ namespace SampleFlow
     synchronous = 1,
 
     /**
-     * Process the sample asynchronously by creating a new task that the
-     * operating system can work on whenever it has available resources.
+     * Process the sample asynchronously on one of the worker threads of a
+     * ThreadPool, whenever that pool has available resources.
      * To make this possible, a Consumer or Filter object that uses this
-     * mode copies the sample, and then creates a std::task object that
-     * encapsulates what needs to be done (namely, processing the sample
-     * and, if this consumer is in fact a filter, sending the processed
-     * sample downstream to other consumers).
+     * mode copies the sample into a queue of samples waiting to be
+     * processed, and makes sure that a task is enqueued with the thread
+     * pool set by Consumer::set_thread_pool() (or, by default, the one
+     * returned by ThreadPool::default_pool()) that works its way through
+     * this queue (namely, processing each sample and, if this consumer is
+     * in fact a filter, sending the processed sample downstream to other
+     * consumers). Because the pool's worker threads are long-lived, this
+     * does not involve starting a new operating system thread, and adding
+     * a sample to the queue does not require acquiring a mutex.
      *
      * Control flow then immediately returns to the place where the current
      * sample was sent from, with one caveat: when specifying
-     * `asynchronous`, only a finite number of such tasks can exist at any
-     * given time. If the number of tasks that were created for previous
-     * samples and that have not been executed yet at the time a subsequent
-     * sample is sent exceeds a certain limit, then the
-     * current thread of execution will block until some of these still
-     * pending tasks have been
-     * completed, before creating a new task. This is to make sure that
+     * `asynchronous`, only a finite number of samples can be waiting for
+     * processing at any given time. If the queue is full at the time a
+     * subsequent sample is sent, then what happens is determined by the
+     * QueueFullPolicy selected for the consumer: By default, the
+     * current thread of execution will block until some of the samples
+     * still waiting have been processed. This is to make sure that
      * if processing samples takes substantially longer than creating new
-     * samples, we don't end up with an indefinite backlog of samples.
+     * samples, we don't end up with an indefinite backlog of samples (and
+     * an indefinitely growing amount of memory to store them).
      *
-     * The limit of currently pending tasks (the "queue size") can be
-     * set through an argument to Consumer::set_parallel_mode().
+     * The size of the queue as well as the policy can be set through
+     * arguments to Consumer::set_parallel_mode().
      *
-     * @note When a filter or consumer object uses this parallel mode,
-     *   then it can be thought of copying every incoming sample into
-     *   a separate location and describes to the operating system
-     *   that that sample should be processed whenever computational
-     *   resources are available. This also means that if the queue
-     *   size is larger than one, then these tasks may be executed
-     *   in a different order than the samples came in. This is
-     *   because the operating system sees no need to execute
-     *   the available tasks in any particular order. One could of course
-     *   enforce this somehow, but when processing samples in parallel,
-     *   it is often also the case that an upstream sample producer
-     *   (or multiple producers feeding into a consumer or filter) already
-     *   run in parallel and send their sample in a non-deterministic
-     *   order -- making the effort to process them in a deterministic order
-     *   pointless. In any case, if a user uses this asynchronous mode
-     *   on a consumer of filter, then this is really only useful for
-     *   consumers or filters for which processing in a random order makes
-     *   sense. For example, the Consumers::MeanValue doesn't really care
-     *   about the order in which samples are processed since the mean
-     *   value computed after all samples have been processed is
+     * @note Each consumer or filter object processes the samples in its
+     *   queue one at a time and in the order in which they were added
+     *   to the queue. This does not imply that samples are processed in the
+     *   order in which they were generated: It is often the case that an
+     *   upstream sample producer (or multiple producers feeding into a
+     *   consumer or filter) already run in parallel and send their sample
+     *   in a non-deterministic order. In any case, if a user uses this
+     *   asynchronous mode on a consumer of filter, then this is really only
+     *   useful for consumers or filters for which processing in a random
+     *   order makes sense. For example, the Consumers::MeanValue doesn't
+     *   really care about the order in which samples are processed since the
+     *   mean value computed after all samples have been processed is
      *   independent of their order. On the other hand, the
      *   Consumers::AcceptanceRatio class <i>does</i> care and one should
-     *   probably not set this parallel mode for that class. Similarly,
-     *   a program using Consumers::StreamOutput likely intends that
-     *   samples are written to the stream in the order in which they were
-     *   sent (though this may not in fact be the case).
+     *   probably not set this parallel mode for that class if the samples
+     *   may come from more than one thread.
      */
-    asynchronous = 2
+    asynchronous = 2,
+
+    /**
+     * Process the sample asynchronously, on a thread that is dedicated to
+     * the current Consumer or Filter object. In this mode, an object
+     * starts its own worker thread when it is first connected to a
+     * producer, and this thread lives until the object is disconnected
+     * from all producers (i.e., typically until it is destroyed). Samples
+     * are added to a queue in the same way as for the `asynchronous` mode,
+     * with the same choices for the size of the queue and for what to do if
+     * the queue is full, and the worker thread then takes them out of the
+     * queue one at a time and processes them in exactly the order in which
+     * they were added.
+     *
+     * The difference to the `asynchronous` mode is that processing samples
+     * does not compete with the other work scheduled on a ThreadPool, and
+     * that the order in which samples are processed is the order in which a
+     * producer running on a single thread generated them. This makes the
+     * mode appropriate for consumers that depend on the order of samples
+     * and whose work per sample is expensive -- for example, consumers that
+     * compute autocovariances such as Consumers::AutoCovarianceTrace:
+     * these can then do their work on a separate processor core,
+     * rather than on the thread that runs the sampling algorithm. Of the
+     * QueueFullPolicy options, only QueueFullPolicy::block and
+     * QueueFullPolicy::spin_then_block make sense for such consumers
+     * since every sample is important for them.
+     *
+     * Every Consumer or Filter class that supports the `asynchronous` mode
+     * also supports this mode, since it only differs in where samples are
+     * processed, and processes them one at a time in either case. Classes
+     * that only support the `synchronous` mode because the order of
+     * samples matters to them may advertise support for this mode
+     * specifically.
+     *
+     * On the other hand, each object that uses this mode occupies one
+     * operating system thread, whether there are samples to process or
+     * not. The worker thread does, however, sleep if there are no samples
+     * waiting for processing.
+     */
+    dedicated_thread = 4,
+
+    /**
+     * Process the sample synchronously, like in the `synchronous` mode, but
+     * without any synchronization at all. By selecting this mode for a
+     * Consumer or Filter object, the user promises that all samples are sent
+     * to the object from one and the same thread -- i.e., that the object is
+     * connected to a single producer that runs on one thread and does not
+     * itself process samples asynchronously -- and that no other member
+     * functions of the object (such as the `get()` functions of consumers)
+     * are called from other threads while samples are being sent. This is
+     * the very common case of a single sampler feeding a handful of
+     * consumers.
+     *
+     * In the `synchronous` mode, every sample requires acquiring (and
+     * releasing) a shared lock that guards against the object being
+     * disconnected at the same time, and most consumers then acquire a
+     * lock of their own that protects their state. For consumers that do
+     * little work per sample, such as Consumers::CountSamples, these locks
+     * can cost more than the actual work. In the `single_threaded` mode,
+     * neither of these locks is acquired.
+     *
+     * Every Consumer or Filter class supports this mode. Breaking the
+     * promise above leads to data races and undefined behavior.
+     */
+    single_threaded = 8,
+
+    /**
+     * Let the Consumer or Filter object choose between processing samples
+     * on the thread that sends them (as in the `synchronous` mode) and
+     * handing them to another thread via a queue, based on measurements.
+     * Which of these is faster depends on how expensive it is to process a
+     * sample compared to how quickly samples arrive: Handing a sample to
+     * another thread costs copying it into the queue and waking up
+     * whoever processes it, which is more than what many cheap consumers
+     * such as Consumers::MeanValue do with a sample. On the other hand,
+     * an expensive consumer that processes samples synchronously holds
+     * up the producer for as long as it works on each sample.
+     *
+     * In this mode, an object therefore processes the first
+     * Consumer::adaptive_calibration_samples samples synchronously, and
+     * measures both how long this takes per sample and how much time
+     * passes between the arrival of subsequent samples. If processing a
+     * sample takes longer than Consumer::adaptive_minimal_consume_time
+     * and more than the fraction Consumer::adaptive_consume_time_fraction
+     * of the interval between samples, then all following samples are put
+     * into a queue and processed as in the `asynchronous` mode if the
+     * class supports that mode, or as in the `dedicated_thread` mode if
+     * the class only supports that one (because it depends on the order of
+     * samples). Otherwise, and for classes that support neither, the
+     * object continues to process samples synchronously. The size of the
+     * queue and what happens when it is full are set by the arguments to
+     * Consumer::set_parallel_mode() in the same way as for the other modes
+     * that use a queue. The choice an object has made can be queried
+     * through Consumer::get_parallel_mode().
+     *
+     * Every Consumer or Filter class supports this mode, since it only
+     * ever uses modes the class supports.
+     */
+    adaptive = 16
+  };
+
+
+
+  /**
+   * An enumeration that designates what a Consumer (or Filter) object that
+   * processes samples in ParallelMode::asynchronous or
+   * ParallelMode::dedicated_thread should do when a new
+   * sample comes in but its queue of samples waiting for processing is
+   * already full. This is set through the Consumer::set_parallel_mode()
+   * function.
+   */
+  enum class QueueFullPolicy : int
+  {
+    /**
+     * Block the thread that sent the sample until there is space in the
+     * queue. If the thread that sent the sample is a worker thread of a
+     * ThreadPool, then it does not just wait, but executes other pending
+     * tasks of that pool in the meantime.
+     */
+    block = 1,
+
+    /**
+     * Like `block`, but first re-try a number of times without
+     * going to sleep. This has lower latency than `block` if
+     * processing a sample takes only a short time, at the cost of keeping
+     * the waiting thread busy.
+     */
+    spin_then_block = 2,
+
+    /**
+     * Never block, but instead discard the oldest sample that is still
+     * waiting in the queue to make room for the new one. This is the
+     * appropriate choice for consumers that only monitor the progress of
+     * a sampler (for example, a Consumers::StreamOutput object that prints
+     * samples to the screen) and that should never hold up the sampler,
+     * but it is clearly not appropriate for consumers that compute
+     * statistics for which every sample matters.
+     */
+    drop_oldest = 3
+  };
+
+
+
+  /**
+   * An enumeration that describes how important it is that a Consumer (or
+   * Filter) object keeps up with the samples it is sent. This is set
+   * through the Consumer::set_priority() function, and matters for objects
+   * that process samples in ParallelMode::asynchronous (or that have
+   * chosen this mode in ParallelMode::adaptive) and, to some extent, in
+   * ParallelMode::dedicated_thread.
+   *
+   * Pipelines often contain both consumers whose results are the reason
+   * for running the sampler in the first place -- say, the mean value and
+   * covariance matrix of the samples -- and consumers that are merely
+   * convenient, such as a Consumers::StreamOutput object that prints
+   * samples to a terminal to monitor progress, or a Consumers::Action
+   * object that updates a live plot. If there is more work than processor
+   * cores, the former should be served first, and the latter should
+   * rather skip samples than hold up the sampler.
+   */
+  enum class Priority : int
+  {
+    /**
+     * The tasks that process the samples of the object are executed by a
+     * ThreadPool before tasks of lower priority that are waiting at the
+     * same time.
+     */
+    critical = 0,
+
+    /**
+     * The default: Tasks are executed before those of objects with
+     * priority `low`, and after those of objects with priority
+     * `critical`.
+     */
+    normal = 1,
+
+    /**
+     * The tasks that process the samples of the object are only executed
+     * by a ThreadPool if no tasks of higher priority are waiting. In
+     * addition, the object never applies backpressure: If its queue of
+     * samples is full when a new sample arrives, then the oldest sample
+     * in the queue is discarded as described for
+     * QueueFullPolicy::drop_oldest, regardless of the QueueFullPolicy set
+     * for the object. Under load, such an object therefore processes only
+     * the most recent samples, i.e., it skips samples.
+     */
+    low = 2
   };
+
+
+  /**
+   * An enum that describes when consumers that support it compute the
+   * statistic they are asked for. Such consumers, for example
+   * Consumers::CovarianceMatrix and Consumers::AutoCovarianceMatrix, take
+   * an argument of this type in their constructors.
+   *
+   * Updating a statistic such as a covariance matrix with every sample
+   * as it arrives costs a substantial amount of work per sample, and this
+   * work is done either on the thread that generates samples or competes
+   * with it for processor cores. In many programs, however, the result is
+   * only looked at once, after sampling is finished. For these cases, it
+   * is cheaper to only store the samples while sampling, and to then
+   * compute the statistic from all of them at once with algorithms that
+   * work on many samples at a time and that can use all processor cores.
+   */
+  enum class Evaluation : int
+  {
+    /**
+     * Update the statistic with every sample as it is processed. This is
+     * the default. get() then only needs to combine the (small) partial
+     * results computed so far, and the memory used does not grow with the
+     * number of samples.
+     */
+    eager = 0,
+
+    /**
+     * Only append the samples (and their weights) to a buffer as they are
+     * processed, and compute the statistic from the buffered samples when
+     * get() is called, with blocked algorithms that are run in parallel
+     * on ThreadPool::default_pool(). The memory used grows linearly with
+     * the number of samples, and every call to get() processes all
+     * buffered samples again.
+     */
+    lazy = 1
+  };
+
+
+
+  /**
+   * A structure that describes how a thread that has run out of work waits
+   * for more: the worker thread of a Consumer object in
+   * ParallelMode::dedicated_thread (see Consumer::set_wait_policy()), and
+   * the worker threads of a ThreadPool (see ThreadPool::set_wait_policy()).
+   *
+   * Such a thread eventually goes to sleep, and whoever gives it new work
+   * then has to wake it up. On Linux, going to sleep and being woken up
+   * each cost a system call, and it takes a few microseconds until the
+   * woken thread runs again. If samples arrive every few microseconds, and
+   * processing them is cheap, then this costs more than the actual work,
+   * both for the worker and for the producer that sends the samples. A
+   * thread that runs out of work therefore first checks for new work
+   * `n_spins` times in a tight loop (using the processor's instruction for
+   * such loops, which tells the processor to save power and to give
+   * resources to the other hardware thread of the core), then `n_yields`
+   * times while giving up the rest of its time slice to other threads in
+   * between, and only then goes to sleep. While it does the former, it is
+   * not considered sleeping, and so whoever gives it work does not need to
+   * wake it up. At high rates of samples, the thread therefore rarely
+   * sleeps; at low rates, it sleeps after a short while and does not keep
+   * a processor core busy.
+   *
+   * The default values let a thread look for work for a few tens of
+   * microseconds before it goes to sleep. Setting both values to zero
+   * makes the thread go to sleep right away, which is appropriate if there
+   * are more busy threads than processor cores.
+   */
+  struct WaitPolicy
+  {
+    /**
+     * The number of times a thread that has run out of work checks for new
+     * work in a tight loop before it starts yielding.
+     */
+    unsigned int n_spins = 256;
+
+    /**
+     * The number of times a thread then checks for new work while giving
+     * up its time slice in between, before it goes to sleep.
+     */
+    unsigned int n_yields = 16;
+  };
+
+
+
+  namespace internal
+  {
+    /**
+     * Tell the processor that the current thread is waiting in a loop for
+     * another thread to change something.
+     */
+    inline
+    void
+    pause_in_spin_loop ()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile ("yield");
+#endif
+    }
+
+
+
+    /**
+     * Wait for the given function to return `true`, following the first
+     * two phases of the given WaitPolicy: check `wait_policy.n_spins`
+     * times in a tight loop, and then `wait_policy.n_yields` times
+     * while yielding in between. Return whether the function returned
+     * `true`; if it did not, the caller goes to sleep.
+     */
+    template <typename Condition>
+    bool
+    spin_then_yield (const WaitPolicy &wait_policy,
+                     const Condition  &condition)
+    {
+      for (unsigned int i=0; i<wait_policy.n_spins; ++i)
+        {
+          if (condition())
+            return true;
+          pause_in_spin_loop ();
+        }
+
+      for (unsigned int i=0; i<wait_policy.n_yields; ++i)
+        {
+          if (condition())
+            return true;
+          std::this_thread::yield();
+        }
+
+      return condition();
+    }
+  }
 }
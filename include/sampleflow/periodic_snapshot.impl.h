@@ -0,0 +1,299 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that periodically writes the state of a set of objects --
+   * typically, the consumers that compute the statistics a program is
+   * interested in, such as Consumers::MeanValue or
+   * Consumers::CovarianceMatrix -- to a file. This allows looking at
+   * intermediate results of a long-running sampler from outside the
+   * program, and resuming the computation of these statistics if the
+   * program is interrupted.
+   *
+   * Objects are registered via add(). Every so often, as determined by the
+   * interval passed to the constructor, a thread owned by the current
+   * object then wakes up, converts the state of all registered objects into
+   * a sequence of bytes using Serialization::write() (i.e., using the
+   * `save()` functions of consumers), and hands this sequence to a
+   * Checkpointer that writes it to the file, again on a separate thread.
+   * The threads that produce and process samples are therefore never
+   * blocked by writing snapshots. Calling the `save()` function of a
+   * consumer does, however, need to obtain a consistent view of its state:
+   * Consumers that keep their state in a ShardedAccumulator or CopyOnWrite
+   * object do this without interfering with the threads that process
+   * samples; other consumers may briefly hold the lock that protects
+   * their state.
+   *
+   * The state of the objects can be restored from the file via the static
+   * load() function, which needs to be given objects of the same types and
+   * in the same order as they were registered with add().
+   *
+   * The registered objects need to live at least as long as the current
+   * object, i.e., the PeriodicSnapshot object should be declared after the
+   * objects it writes snapshots of.
+   */
+  class PeriodicSnapshot
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] filename The name of the file into which snapshots are
+       *   written. An existing file of this name is replaced once the first
+       *   snapshot is written.
+       * @param[in] interval The time between two snapshots.
+       */
+      PeriodicSnapshot (const std::string &filename,
+                        const std::chrono::milliseconds interval);
+
+      /**
+       * Destructor. Stop the thread that periodically takes snapshots, and
+       * wait for the last snapshot taken to be written to the file.
+       */
+      ~PeriodicSnapshot ();
+
+      /**
+       * Copy constructor. Objects of this class cannot be copied, and so
+       * this constructor is deleted.
+       */
+      PeriodicSnapshot (const PeriodicSnapshot &) = delete;
+
+      /**
+       * Register an object whose state is to be part of all following
+       * snapshots. `ObjectType` needs to be a type that can be converted
+       * by Serialization::write(), which is the case for all consumers that
+       * have `save()` and `load()` member functions.
+       */
+      template <typename ObjectType>
+      void
+      add (const ObjectType &object);
+
+      /**
+       * Take a snapshot of the registered objects right away, independent
+       * of the periodic snapshots, and hand it to the thread that writes
+       * snapshots to the file. Use wait() to wait until it has been written.
+       */
+      void
+      snapshot_now ();
+
+      /**
+       * Wait until the most recent snapshot has been written to the file.
+       */
+      void
+      wait ();
+
+      /**
+       * Return the number of snapshots that have been written to the file
+       * so far.
+       */
+      std::size_t
+      n_snapshots_written () const;
+
+      /**
+       * Read the snapshot stored in the file with the given name, and
+       * restore the state of the given objects from it. The objects must be
+       * of the same types as, and be given in the same order as, the objects
+       * that were registered with add() for the PeriodicSnapshot object
+       * that wrote the file.
+       */
+      template <typename... ObjectTypes>
+      static
+      void
+      load (const std::string &filename,
+            ObjectTypes &... objects);
+
+    private:
+      /**
+       * The time between two snapshots.
+       */
+      const std::chrono::milliseconds interval;
+
+      /**
+       * A mutex that guards the list of functions below.
+       */
+      mutable std::mutex object_mutex;
+
+      /**
+       * For each registered object, a function that appends its binary
+       * representation to the given buffer.
+       */
+      std::vector<std::function<void (std::vector<char> &)>> savers;
+
+      /**
+       * The object that writes snapshots to the file.
+       */
+      Checkpointer checkpointer;
+
+      /**
+       * A mutex and a condition variable that the timer thread uses to
+       * wait for the next snapshot, or for the destructor to ask it to
+       * stop.
+       */
+      std::mutex              timer_mutex;
+      std::condition_variable timer_condition;
+      bool                    shutting_down;
+
+      /**
+       * The thread that periodically takes snapshots.
+       */
+      std::thread timer;
+
+      /**
+       * Convert the state of all registered objects into a sequence of
+       * bytes.
+       */
+      std::vector<char>
+      take_snapshot () const;
+
+      /**
+       * The function run by the timer thread.
+       */
+      void
+      timer_loop ();
+  };
+
+
+
+  inline
+  PeriodicSnapshot::PeriodicSnapshot (const std::string &filename,
+                                      const std::chrono::milliseconds interval)
+    :
+    interval (interval),
+    checkpointer (filename),
+    shutting_down (false),
+    timer ([this]()
+  {
+    timer_loop ();
+  })
+  {
+    assert (interval > std::chrono::milliseconds::zero());
+  }
+
+
+
+  inline
+  PeriodicSnapshot::~PeriodicSnapshot ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (timer_mutex);
+      shutting_down = true;
+    }
+    timer_condition.notify_all();
+
+    timer.join();
+    checkpointer.wait();
+  }
+
+
+
+  template <typename ObjectType>
+  void
+  PeriodicSnapshot::add (const ObjectType &object)
+  {
+    static_assert (Serialization::is_serializable<ObjectType>(),
+                   "The objects registered with a PeriodicSnapshot object must "
+                   "be of a type that Serialization::write() can convert.");
+
+    std::lock_guard<std::mutex> lock (object_mutex);
+    savers.emplace_back ([&object](std::vector<char> &buffer)
+    {
+      Serialization::write (buffer, object);
+    });
+  }
+
+
+
+  inline
+  void
+  PeriodicSnapshot::snapshot_now ()
+  {
+    checkpointer.write (take_snapshot());
+  }
+
+
+
+  inline
+  void
+  PeriodicSnapshot::wait ()
+  {
+    checkpointer.wait ();
+  }
+
+
+
+  inline
+  std::size_t
+  PeriodicSnapshot::n_snapshots_written () const
+  {
+    return checkpointer.n_checkpoints_written();
+  }
+
+
+
+  template <typename... ObjectTypes>
+  void
+  PeriodicSnapshot::load (const std::string &filename,
+                          ObjectTypes &... objects)
+  {
+    const std::vector<char> snapshot = Checkpointer::read (filename);
+    std::span<const char>   buffer (snapshot);
+
+    (Serialization::read (buffer, objects), ...);
+    assert (buffer.empty());
+  }
+
+
+
+  inline
+  std::vector<char>
+  PeriodicSnapshot::take_snapshot () const
+  {
+    std::vector<char> buffer;
+
+    std::lock_guard<std::mutex> lock (object_mutex);
+    for (const auto &saver : savers)
+      saver (buffer);
+
+    return buffer;
+  }
+
+
+
+  inline
+  void
+  PeriodicSnapshot::timer_loop ()
+  {
+    std::unique_lock<std::mutex> lock (timer_mutex);
+    while (true)
+      {
+        // Sleep until the next snapshot is due, or until we are asked to
+        // shut down:
+        if (timer_condition.wait_for (lock, interval, [this]()
+      {
+        return shutting_down;
+      }))
+        return;
+
+        // Take the snapshot without holding the lock, so that the
+        // destructor does not have to wait for it to be taken before it
+        // can ask us to stop:
+        lock.unlock ();
+        checkpointer.write (take_snapshot());
+        lock.lock ();
+      }
+  }
+}
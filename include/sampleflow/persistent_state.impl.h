@@ -0,0 +1,479 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A class that keeps the state of an object (typically a consumer) in a
+   * memory-mapped file, so that the state survives if the program crashes
+   * or is terminated, and can be restored by just mapping the file again
+   * when the program is restarted. This is an alternative to writing
+   * checkpoints via the PeriodicSnapshot class: The state is updated every
+   * few samples by the thread that processes them, rather than at fixed
+   * time intervals by a separate thread, and writing it only amounts to
+   * copying a few bytes into memory the operating system writes back to
+   * the file on its own -- also if the program dies.
+   *
+   * The state is provided as a sequence of bytes by a function given to
+   * the constructor, typically one that calls the `save()` member function
+   * of a consumer. The file consists of a small control block followed by
+   * two "slots" for such byte sequences. The control block holds an
+   * "epoch" counter that is incremented every time a new state is
+   * written, and which of the two slots holds the current state is
+   * determined by whether the epoch is even or odd. A new state is always
+   * written into the *other* slot, along with its size and a checksum,
+   * and only then is the epoch incremented. As a consequence, the file
+   * contains a complete state at every moment, no matter where the
+   * program is interrupted: either the previous state (if the program
+   * dies while a new one is being written) or the new one. If a slot is
+   * too small for a state, the file is extended by a larger slot, which
+   * is then used instead.
+   *
+   * Since the operating system writes the memory back to the file on its
+   * own schedule, the state survives the termination of the program, but
+   * not necessarily a crash of the whole machine. If the latter matters,
+   * the constructor's `synchronize` argument ensures that every state has
+   * reached the disk before it becomes the current one, at the cost of
+   * waiting for the disk every time a state is written. In this case, the
+   * checksums also allow detecting that a state was not completely
+   * written, in which case the previous one is used.
+   *
+   * The file is meant to be used by one object (and one process) at a
+   * time. Errors, such as a file that cannot be created, are caught by
+   * assertions, as in the SharedMemoryQueue class.
+   */
+  class PersistentState
+  {
+    public:
+      /**
+       * Constructor. Open the file with the given name, creating it if it
+       * does not exist yet, and map it into memory. If the file contains a
+       * state written by a previous object of this class, this state is
+       * available via stored_state(); otherwise, the file is set up to
+       * hold states from scratch.
+       *
+       * @param[in] filename The name of the file.
+       * @param[in] save A function that writes the state to be stored
+       *   into the given buffer. It is called by write() and
+       *   samples_processed(), possibly while other threads update the
+       *   state, and needs to be able to deal with that.
+       * @param[in] interval The number of samples after which
+       *   samples_processed() writes a new state.
+       * @param[in] synchronize Whether every state is to be written to
+       *   disk before it becomes the current one, see the documentation of
+       *   this class.
+       */
+      PersistentState (const std::string                                &filename,
+                       const std::function<void (std::vector<char> &)> &save,
+                       const types::sample_index                        interval = 1,
+                       const bool                                       synchronize = false);
+
+      /**
+       * Copy constructor. Objects of this class cannot be copied, and so
+       * this constructor is deleted.
+       */
+      PersistentState (const PersistentState &) = delete;
+
+      /**
+       * Destructor. Unmap and close the file, which retains the last state
+       * written. This function does not write a state itself because the
+       * object whose state it would have to obtain may not exist any more;
+       * owners of objects of this class should call write() before.
+       */
+      ~PersistentState ();
+
+      /**
+       * Return the current state stored in the file, i.e., the last one
+       * written, or an empty buffer if no state has been written to the
+       * file yet.
+       */
+      std::vector<char>
+      stored_state () const;
+
+      /**
+       * Return the number of states written to the file so far, including
+       * the ones written by previous objects that used the same file. This
+       * is the "epoch" of the current state.
+       */
+      std::uint64_t
+      epoch () const;
+
+      /**
+       * Pass the current state stored in the file to the given function,
+       * typically one that calls the `load()` member function of the
+       * object whose state is kept in the file. This is how an object
+       * restores the state a previous run of the program left behind.
+       *
+       * @return Whether the file contained a state. If it did not, the
+       *   function given as argument is not called.
+       */
+      bool
+      restore (const std::function<void (std::span<const char> &)> &load) const;
+
+      /**
+       * Note that `n` more samples have been processed, and write the
+       * state if this makes the number of samples processed reach another
+       * multiple of the `interval` given to the constructor. If another
+       * thread is writing a state at that moment, this function does not
+       * wait for it but returns right away: The state written will be
+       * superseded by the one written after the next `interval` samples,
+       * or by the next call to write().
+       */
+      void
+      samples_processed (const types::sample_index n);
+
+      /**
+       * Obtain the state from the function given to the constructor and
+       * make it the current state in the file.
+       */
+      void
+      write ();
+
+    private:
+      /**
+       * The description of one of the two slots that hold states: Where in
+       * the file it is, how many bytes it can hold, and the size and
+       * checksum of the state it holds.
+       */
+      struct Slot
+      {
+        std::uint64_t offset;
+        std::uint64_t capacity;
+        std::uint64_t size;
+        std::uint64_t checksum;
+      };
+
+      /**
+       * The layout of the control block at the beginning of the file.
+       */
+      struct ControlBlock
+      {
+        char                       magic[8];
+        std::atomic<std::uint64_t> epoch;
+        Slot                       slots[2];
+      };
+
+      static_assert (std::atomic<std::uint64_t>::is_always_lock_free,
+                     "Persistent states require lock-free 64-bit atomics.");
+
+      /**
+       * The bytes with which the file starts.
+       */
+      static constexpr char magic[8] = {'S', 'F', 'S', 'T', 'A', 'T', '1', '\0'};
+
+      /**
+       * Return the checksum of the given bytes (using the 64-bit FNV-1a
+       * hash function).
+       */
+      static
+      std::uint64_t
+      checksum (const char *data, const std::size_t size);
+
+      /**
+       * Return whether the given slot lies within the file and holds a
+       * state whose checksum matches.
+       */
+      bool
+      is_valid (const Slot &slot) const;
+
+      /**
+       * Map the first `size` bytes of the file into memory, after unmapping
+       * what was mapped before.
+       */
+      void
+      map (const std::size_t size);
+
+      /**
+       * Write the state, assuming that the caller holds the `write_mutex`.
+       */
+      void
+      write_locked ();
+
+      /**
+       * The function that provides the state, and the parameters given to
+       * the constructor.
+       */
+      const std::function<void (std::vector<char> &)> save;
+      const types::sample_index                        interval;
+      const bool                                       synchronize;
+
+      /**
+       * The file descriptor of the open file, the memory it has been
+       * mapped to, and the size of the mapping (which is also the size of
+       * the file).
+       */
+      int          fd;
+      char        *mapped_data;
+      std::size_t  mapped_size;
+
+      /**
+       * A pointer to the control block at the beginning of the mapped
+       * memory.
+       */
+      ControlBlock *control;
+
+      /**
+       * The number of samples processed so far, as reported to
+       * samples_processed().
+       */
+      std::atomic<types::sample_index> n_processed_samples;
+
+      /**
+       * A mutex that ensures that only one thread writes a state at a
+       * time, and that the file is not remapped while another thread looks
+       * at it.
+       */
+      mutable std::mutex write_mutex;
+
+      /**
+       * A buffer into which the state is written before it is copied into
+       * the file, kept around to avoid allocating memory every time.
+       */
+      std::vector<char> buffer;
+  };
+
+
+
+  inline
+  PersistentState::PersistentState (const std::string                                &filename,
+                                    const std::function<void (std::vector<char> &)> &save,
+                                    const types::sample_index                        interval,
+                                    const bool                                       synchronize)
+    :
+    save (save),
+    interval (interval),
+    synchronize (synchronize),
+    mapped_data (nullptr),
+    mapped_size (0),
+    control (nullptr),
+    n_processed_samples (0)
+  {
+    assert (interval >= 1);
+
+    fd = open (filename.c_str(), O_CREAT | O_RDWR, 0600);
+    assert (fd >= 0);
+
+    struct stat file_status;
+    [[maybe_unused]] int ierr = fstat (fd, &file_status);
+    assert (ierr == 0);
+
+    if (static_cast<std::size_t>(file_status.st_size) >= sizeof(ControlBlock))
+      {
+        map (file_status.st_size);
+        if (std::memcmp (control->magic, magic, sizeof(magic)) == 0)
+          {
+            // The file holds states written before. If the current one is
+            // broken (which can only happen if the machine crashed while
+            // the operating system was writing the file back to disk), fall
+            // back to the previous one:
+            const std::uint64_t current_epoch = control->epoch.load (std::memory_order_acquire);
+            if ((current_epoch > 0)
+                &&
+                (is_valid (control->slots[current_epoch % 2]) == false))
+              {
+                if ((current_epoch > 1)
+                    &&
+                    is_valid (control->slots[(current_epoch-1) % 2]))
+                  control->epoch.store (current_epoch-1, std::memory_order_release);
+                else
+                  control->epoch.store (0, std::memory_order_release);
+              }
+            return;
+          }
+      }
+
+    // The file is new (or does not contain what we expect). Set it up
+    // with a control block and two empty slots, and write the magic
+    // number last so that an interrupted setup is repeated next time:
+    ierr = ftruncate (fd, 0);
+    assert (ierr == 0);
+    ierr = ftruncate (fd, sizeof(ControlBlock));
+    assert (ierr == 0);
+    map (sizeof(ControlBlock));
+
+    control = new (mapped_data) ControlBlock;
+    control->epoch.store (0, std::memory_order_relaxed);
+    for (Slot &slot : control->slots)
+      slot = Slot {0, 0, 0, 0};
+    std::memcpy (control->magic, magic, sizeof(magic));
+    if (synchronize)
+      msync (mapped_data, mapped_size, MS_SYNC);
+  }
+
+
+
+  inline
+  PersistentState::~PersistentState ()
+  {
+    munmap (mapped_data, mapped_size);
+    ::close (fd);
+  }
+
+
+
+  inline
+  std::vector<char>
+  PersistentState::stored_state () const
+  {
+    std::lock_guard<std::mutex> lock (write_mutex);
+
+    const std::uint64_t current_epoch = control->epoch.load (std::memory_order_acquire);
+    if (current_epoch == 0)
+      return {};
+
+    const Slot &slot = control->slots[current_epoch % 2];
+    return std::vector<char> (mapped_data + slot.offset,
+                              mapped_data + slot.offset + slot.size);
+  }
+
+
+
+  inline
+  std::uint64_t
+  PersistentState::epoch () const
+  {
+    std::lock_guard<std::mutex> lock (write_mutex);
+    return control->epoch.load (std::memory_order_acquire);
+  }
+
+
+
+  inline
+  bool
+  PersistentState::restore (const std::function<void (std::span<const char> &)> &load) const
+  {
+    const std::vector<char> state = stored_state();
+    if (state.size() == 0)
+      return false;
+
+    std::span<const char> buffer (state);
+    load (buffer);
+    return true;
+  }
+
+
+
+  inline
+  void
+  PersistentState::samples_processed (const types::sample_index n)
+  {
+    const types::sample_index previous
+      = n_processed_samples.fetch_add (n, std::memory_order_relaxed);
+    if ((previous + n) / interval == previous / interval)
+      return;
+
+    std::unique_lock<std::mutex> lock (write_mutex, std::try_to_lock);
+    if (lock.owns_lock())
+      write_locked ();
+  }
+
+
+
+  inline
+  void
+  PersistentState::write ()
+  {
+    std::lock_guard<std::mutex> lock (write_mutex);
+    write_locked ();
+  }
+
+
+
+  inline
+  void
+  PersistentState::write_locked ()
+  {
+    buffer.clear();
+    save (buffer);
+
+    // Only the current object changes the epoch, so we can read it
+    // without synchronization. The new state goes into the slot that
+    // does not hold the current state, and if that is too small, into a
+    // newly added region at the end of the file that leaves some room to
+    // grow:
+    const std::uint64_t current_epoch = control->epoch.load (std::memory_order_relaxed);
+    const unsigned int  slot_index    = (current_epoch + 1) % 2;
+    if (control->slots[slot_index].capacity < buffer.size())
+      {
+        const std::size_t offset   = (mapped_size + 63) / 64 * 64;
+        const std::size_t capacity = (buffer.size() + buffer.size()/2 + 63) / 64 * 64;
+
+        [[maybe_unused]] const int ierr = ftruncate (fd, offset + capacity);
+        assert (ierr == 0);
+        map (offset + capacity);
+
+        control->slots[slot_index].offset   = offset;
+        control->slots[slot_index].capacity = capacity;
+      }
+
+    Slot &slot = control->slots[slot_index];
+    std::memcpy (mapped_data + slot.offset, buffer.data(), buffer.size());
+    slot.size     = buffer.size();
+    slot.checksum = checksum (buffer.data(), buffer.size());
+
+    if (synchronize)
+      msync (mapped_data, mapped_size, MS_SYNC);
+    control->epoch.store (current_epoch + 1, std::memory_order_release);
+    if (synchronize)
+      msync (mapped_data, sizeof(ControlBlock), MS_SYNC);
+  }
+
+
+
+  inline
+  std::uint64_t
+  PersistentState::checksum (const char *data, const std::size_t size)
+  {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i=0; i<size; ++i)
+      {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+      }
+    return hash;
+  }
+
+
+
+  inline
+  bool
+  PersistentState::is_valid (const Slot &slot) const
+  {
+    return ((slot.offset >= sizeof(ControlBlock))
+            &&
+            (slot.size <= slot.capacity)
+            &&
+            (slot.offset + slot.capacity <= mapped_size)
+            &&
+            (checksum (mapped_data + slot.offset, slot.size) == slot.checksum));
+  }
+
+
+
+  inline
+  void
+  PersistentState::map (const std::size_t size)
+  {
+    if (mapped_data != nullptr)
+      munmap (mapped_data, mapped_size);
+
+    void *const address = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert (address != MAP_FAILED);
+    mapped_data = static_cast<char *>(address);
+    mapped_size = size;
+    control     = reinterpret_cast<ControlBlock *>(mapped_data);
+  }
+}
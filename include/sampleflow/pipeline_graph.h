@@ -0,0 +1,44 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_PIPELINE_GRAPH_H
+#define SAMPLEFLOW_PIPELINE_GRAPH_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/auxiliary_data.h>
+#include <sampleflow/parallel_mode.h>
+#include <sampleflow/sample_shape.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#  include <cxxabi.h>
+#endif
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/pipeline_graph.impl.h>
+
+#endif
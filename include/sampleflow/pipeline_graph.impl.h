@@ -0,0 +1,358 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that describe the graph formed by
+   * producers, filters, and consumers that are connected to each other,
+   * as returned by Producer::describe_pipeline(). The graph lists every
+   * object that samples flow through, starting at a producer, along with
+   * how each consumer and filter processes its samples (see
+   * ParallelMode) and how many samples are currently waiting in its
+   * queue, and every connection, along with how many samples have
+   * passed through it. Printing the graph via Graph::write_dot() in the
+   * format of Graphviz then shows at a glance how a large pipeline is
+   * put together, where samples are copied (namely, on every edge), and,
+   * via the queue depths and numbers of samples, where the bottlenecks
+   * are.
+   *
+   * Counting the samples that pass through each connection costs an
+   * atomic increment per sample and connection, and is therefore only
+   * done if `SAMPLEFLOW_WITH_INSTRUMENTATION` is defined (see
+   * namespace Instrumentation). Otherwise, the graph has the same nodes
+   * and edges, but the numbers of samples are all zero.
+   */
+  namespace PipelineGraph
+  {
+    /**
+     * The kinds of objects that can be part of a pipeline.
+     */
+    enum class NodeKind
+    {
+      producer,
+      filter,
+      consumer
+    };
+
+
+    /**
+     * A structure that describes one producer, filter, or consumer.
+     */
+    struct Node
+    {
+      /**
+       * The address of the object, which identifies it in the edges of
+       * the graph. (For filters, which are both producers and consumers,
+       * this is the address of the complete object.)
+       */
+      const void *object = nullptr;
+
+      /**
+       * The name of the class of the object, demangled if the compiler
+       * provides a way to do so.
+       */
+      std::string type_name;
+
+      /**
+       * The kind of the object.
+       */
+      NodeKind kind = NodeKind::producer;
+
+      /**
+       * For consumers and filters, how the object processes samples, and,
+       * in ParallelMode::asynchronous and ParallelMode::dedicated_thread,
+       * the size of its queue and the number of samples currently
+       * waiting in it.
+       */
+      std::optional<ParallelMode> parallel_mode;
+      unsigned int                queue_size  = 0;
+      std::size_t                 queue_depth = 0;
+
+      /**
+       * For consumers and filters, the number of bytes taken up by the
+       * state of the object and by the samples in its queue. See
+       * Consumer::memory_consumption() and
+       * Consumer::queued_memory_consumption().
+       */
+      std::size_t state_bytes  = 0;
+      std::size_t queued_bytes = 0;
+    };
+
+
+    /**
+     * A structure that describes the connection of a consumer or filter
+     * to a producer or filter.
+     */
+    struct Edge
+    {
+      /**
+       * The objects at the two ends of the connection. These are the
+       * values of Node::object of the corresponding nodes.
+       */
+      const void *producer = nullptr;
+      const void *consumer = nullptr;
+
+      /**
+       * The number of samples (or, for batches, the number of samples in
+       * them) that have been sent through the connection since it was
+       * made, and that number divided by the time since then. These are
+       * zero unless `SAMPLEFLOW_WITH_INSTRUMENTATION` is defined.
+       */
+      std::uint64_t n_samples          = 0;
+      double        samples_per_second = 0;
+    };
+
+
+    /**
+     * A class that describes a pipeline, i.e., a set of producers,
+     * filters, and consumers together with the connections between them.
+     */
+    struct Graph
+    {
+      /**
+       * The nodes and edges of the graph. The node the description
+       * started from comes first, and every other node is listed after
+       * (at least) one of the nodes it is connected to.
+       */
+      std::vector<Node> nodes;
+      std::vector<Edge> edges;
+
+      /**
+       * Return whether the graph contains a node for the given object.
+       */
+      bool
+      contains (const void *object) const;
+
+      /**
+       * Write the graph to the given stream in the DOT format of
+       * Graphviz, for example to be converted into an image by `dot
+       * -Tpdf`. Producers are shown as boxes, filters as hexagons, and
+       * consumers as ellipses, each labeled with the name of its class
+       * and its parallel mode (along with the occupancy of its queue, if
+       * it has one, and the memory it uses, if known). Edges are labeled with the number of samples that
+       * have passed through them and the throughput, if these are
+       * available.
+       */
+      void
+      write_dot (std::ostream &out) const;
+    };
+
+
+    /**
+     * An interface for the objects that can receive samples, i.e., of the
+     * Consumer class and thereby of all consumers and filters. Producers
+     * keep a list of the objects of this kind connected to them so that
+     * Producer::describe_pipeline() can walk the graph downstream, so
+     * that Producer::aux_data_requested() can find out which entries of the
+     * auxiliary data of samples are of interest to anyone, and so that
+     * Producer::announce_samples() can tell everyone what samples to
+     * expect.
+     */
+    class DownstreamNode
+    {
+      public:
+        /**
+         * Destructor.
+         */
+        virtual
+        ~DownstreamNode () = default;
+
+        /**
+         * Add a node for the current object to the given graph, along with
+         * all nodes and edges downstream of it if the object is a filter,
+         * unless the graph already contains a node for it.
+         */
+        virtual
+        void
+        add_to_graph (Graph &graph) const = 0;
+
+        /**
+         * Return the address that identifies the current object in a
+         * Graph, i.e., the value of Node::object for it.
+         */
+        virtual
+        const void *
+        graph_node_id () const = 0;
+
+        /**
+         * Return whether the current object, or (if it passes samples on)
+         * any object downstream of it, may look at the entry with the given
+         * key in the auxiliary data of the samples it receives. Producers
+         * use this via Producer::aux_data_requested() to avoid computing
+         * entries nobody is interested in.
+         */
+        virtual
+        bool
+        requests_aux_data (const AuxiliaryData::Key &key) const = 0;
+
+        /**
+         * Receive the announcement of a producer connected to the current
+         * object about the samples it is about to send, and (if the
+         * current object passes samples on) pass it on downstream. See
+         * SampleShape and Producer::announce_samples().
+         */
+        virtual
+        void
+        receive_announcement (const SampleShape &shape) = 0;
+    };
+
+
+    /**
+     * A structure that counts the samples that pass through one
+     * connection. The consumer end of the connection increments the
+     * counter, and the producer end reads it when the graph is described.
+     */
+    struct EdgeCounter
+    {
+      std::atomic<std::uint64_t>                  n_samples {0};
+      const std::chrono::steady_clock::time_point connection_time
+        = std::chrono::steady_clock::now();
+    };
+
+
+    /**
+     * Return the name of the class described by the given type
+     * information, demangled if possible.
+     */
+    std::string
+    demangled_type_name (const std::type_info &type);
+
+    /**
+     * Return the name of the given parallel mode.
+     */
+    std::string
+    to_string (const ParallelMode parallel_mode);
+
+
+
+    inline
+    bool
+    Graph::
+    contains (const void *object) const
+    {
+      for (const Node &node : nodes)
+        if (node.object == object)
+          return true;
+      return false;
+    }
+
+
+
+    inline
+    void
+    Graph::
+    write_dot (std::ostream &out) const
+    {
+      // Nodes are named by their position in the list of nodes, since
+      // addresses are not valid DOT identifiers:
+      const auto node_name = [this](const void *object)
+      {
+        for (std::size_t i=0; i<nodes.size(); ++i)
+          if (nodes[i].object == object)
+            return "node" + std::to_string(i);
+        return std::string("unknown");
+      };
+
+      // Class names may contain quotes, for example in string literal
+      // template arguments, so escape them:
+      const auto escape = [](const std::string &s)
+      {
+        std::string result;
+        for (const char c : s)
+          {
+            if ((c == '"') || (c == '\\'))
+              result += '\\';
+            result += c;
+          }
+        return result;
+      };
+
+      out << "digraph SampleFlow {\n";
+      for (const Node &node : nodes)
+        {
+          std::string label = escape (node.type_name);
+          if (node.parallel_mode)
+            {
+              label += "\\n" + to_string (*node.parallel_mode);
+              if (node.queue_size > 0)
+                label += ", queue " + std::to_string (node.queue_depth)
+                         + "/" + std::to_string (node.queue_size);
+            }
+          if ((node.state_bytes > 0) || (node.queued_bytes > 0))
+            label += "\\n" + std::to_string (node.state_bytes) + " bytes in state, "
+                     + std::to_string (node.queued_bytes) + " bytes queued";
+
+          const char *const shape = (node.kind == NodeKind::producer ? "box" :
+                                     node.kind == NodeKind::filter ? "hexagon" :
+                                     "ellipse");
+          out << "  " << node_name (node.object)
+              << " [label=\"" << label << "\", shape=" << shape << "];\n";
+        }
+      for (const Edge &edge : edges)
+        {
+          out << "  " << node_name (edge.producer) << " -> " << node_name (edge.consumer);
+          if (edge.n_samples > 0)
+            out << " [label=\"" << edge.n_samples << " samples\\n"
+                << edge.samples_per_second << "/s\"]";
+          out << ";\n";
+        }
+      out << "}" << std::endl;
+    }
+
+
+
+    inline
+    std::string
+    demangled_type_name (const std::type_info &type)
+    {
+#if __has_include(<cxxabi.h>)
+      int status = 0;
+      char *const name = abi::__cxa_demangle (type.name(), nullptr, nullptr, &status);
+      if ((status == 0) && (name != nullptr))
+        {
+          const std::string result (name);
+          std::free (name);
+          return result;
+        }
+#endif
+      return type.name();
+    }
+
+
+
+    inline
+    std::string
+    to_string (const ParallelMode parallel_mode)
+    {
+      switch (parallel_mode)
+        {
+          case ParallelMode::synchronous:
+            return "synchronous";
+          case ParallelMode::asynchronous:
+            return "asynchronous";
+          case ParallelMode::dedicated_thread:
+            return "dedicated thread";
+          case ParallelMode::single_threaded:
+            return "single threaded";
+          case ParallelMode::adaptive:
+            return "adaptive";
+          default:
+            return "unknown";
+        }
+    }
+  }
+}
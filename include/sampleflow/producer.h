@@ -20,11 +20,28 @@
 
 #include <sampleflow/auxiliary_data.h>
 #include <sampleflow/concepts.h>
+#include <sampleflow/instrumentation.h>
+#include <sampleflow/pipeline_graph.h>
+#include <sampleflow/sample_shape.h>
+#include <sampleflow/shared_sample.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/signal.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/tracing.h>
+#include <sampleflow/types.h>
 
-#include <boost/signals2.hpp>
-
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/producer.impl.h>
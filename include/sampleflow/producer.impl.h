@@ -30,11 +30,64 @@ namespace SampleFlow
    * "consumes" a sample, i.e., it called from another producer with a
    * new sample, it decides whether it wants to convert this input into
    * an output sample of its own.) In general, implementations of derived
-   * classes signal the availability of a new sample by triggering the
-   * `issue_sample` member variable of this class, which then passes on the
+   * classes signal the availability of a new sample by calling the
+   * `issue_sample()` member function of this class, which then passes on the
    * sample (and any auxiliary data that may be available along with the
    * sample) to all consumers that have connected to the sample.
    *
+   * The signals through which samples are sent are objects of type Signal,
+   * for which sending a sample requires neither acquiring a lock nor
+   * copying the list of connected consumers. If the macro
+   * `SAMPLEFLOW_WITH_BOOST_SIGNALS2` is defined, `boost::signals2::signal`
+   * is used instead (see the file signal.h).
+   *
+   *
+   * ### Connecting and disconnecting consumers while sampling ###
+   *
+   * Consumers can be connected to a producer, and disconnected from it,
+   * while the producer is sending samples on another thread -- for
+   * example, to attach a consumer that computes a diagnostic to a sampler
+   * that has been running for days, or to detach a consumer whose work is
+   * done, without stopping the sampler. Connecting or disconnecting a
+   * consumer replaces the list of slots of the signals by a new one
+   * ("read-copy-update"), and issue_sample() works with the list of
+   * consumers that was current when it started sending the sample; the
+   * thread that sends samples therefore never has to wait for a consumer
+   * to be connected or disconnected. A consumer connected while a sample
+   * is being sent receives the following samples; a consumer disconnected
+   * while a sample is being sent may or may not receive it (see
+   * Consumer::disconnect_and_flush() for what happens then).
+   *
+   *
+   * ### Stopping early ###
+   *
+   * Sampling algorithms are typically asked to produce a fixed number of
+   * samples, chosen large enough to be reasonably sure that the quantities
+   * of interest have converged. Since that is often far more samples than
+   * are actually necessary, this class provides a way to stop a running
+   * sampler: Calling request_stop() (from any thread, for example from a
+   * consumer that has determined that enough information has been
+   * collected -- see Consumers::EarlyStopping) asks the sampler to return
+   * from its `sample()` function once it has finished the current step,
+   * in the same way as if it had produced the requested number of samples.
+   * In particular, all samples issued up to that point are flushed to the
+   * consumers. Derived classes check for such requests in their sampling
+   * loops by calling stop_requested(), and call clear_stop_request() when
+   * their `sample()` function returns so that the producer can be used
+   * again afterwards.
+   *
+   * This is the same model as `std::stop_source` and `std::stop_token` in
+   * the C++ standard library, and one can connect the two by registering a
+   * callback with a `std::stop_token`:
+   * @code
+   *   std::jthread thread ([&](std::stop_token stop_token)
+   *   {
+   *     std::stop_callback stop_sampler (stop_token,
+   *                                      [&]() { sampler.request_stop(); });
+   *     sampler.sample (...);
+   *   });
+   * @endcode
+   *
    * @tparam OutputType The C++ type used to describe samples. For example,
    *   if one samples from a continuous, one-dimensional distribution, then
    *   an appropriate type may be `double`. If one samples from the two
@@ -53,7 +106,7 @@ namespace SampleFlow
       /**
        * Default constructor.
        */
-      Producer() = default;
+      Producer();
 
       /**
        * Copy constructor. Producer objects can not be copied, and so
@@ -85,6 +138,12 @@ namespace SampleFlow
        *   arguments, or something that has been created using the std::bind
        *   functionalities.
        *
+       * @param[in] batch_slot The function to be called whenever a producer
+       *   has generated a whole batch of samples at once and sends them
+       *   downstream using the `issue_batch` signal. The function receives
+       *   a `std::vector` of samples and a `std::vector` of the same size
+       *   with the auxiliary data for each sample.
+       *
        * @param[in] flush_slot The function to be called whenever a this
        *   producer decides that it is, at least for the moment, done with
        *   producing samples. Downstream listeners to this signal are
@@ -97,6 +156,18 @@ namespace SampleFlow
        *   call the Consumer::flush() function. The Filter class overloads
        *   this function in Filter::flush().)
        *
+       * @param[in] disconnect_slot The function to be called when the
+       *   producer is destroyed, or otherwise wants to sever the connection.
+       *
+       * @param[in] reference_signal_slot If not empty, a function that is
+       *   called for each new sample instead of `signal_slot`, and that
+       *   receives the sample and its auxiliary data by reference rather
+       *   than by value. The references are only valid for the duration of
+       *   the call. Consumers that only need to look at samples (see
+       *   Consumer::reads_samples_by_reference()) provide such a function,
+       *   and then do not cause samples to be copied if they are sent to
+       *   several consumers (see SharedSample::release()).
+       *
        * @return The returned object describes the connection made with
        *   the signal to which the caller wants to attach `f`. Callers
        *   may want to store this connection object and, if the calling
@@ -114,19 +185,342 @@ namespace SampleFlow
        */
       virtual
       std::pair<const Producer<OutputType> *,
-          std::tuple<boost::signals2::connection,boost::signals2::connection,boost::signals2::connection>>
+          std::tuple<Connection,Connection,Connection,Connection>>
           connect_to_signals (const std::function<void (OutputType, AuxiliaryData)> &signal_slot,
+                              const std::function<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> &batch_slot,
                               const std::function<void ()> &flush_slot,
-                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot);
+                              const std::function<void (const Producer<OutputType> &)> &disconnect_slot,
+                              const std::function<void (const OutputType &, const AuxiliaryData &)> &reference_signal_slot = {});
+
+      /**
+       * Start flushing all consumers connected to this producer (see
+       * `flush_consumers`) on a thread of the given pool, and return
+       * right away. The returned future becomes ready once the consumers
+       * have finished processing the samples they have received -- and,
+       * if they are filters, once the consumers downstream of them have
+       * done so as well.
+       *
+       * This allows a thread that runs a sampling algorithm to go on with
+       * other work -- for example, to start the next call to `sample()` --
+       * while consumers downstream are still working through their queues.
+       * Samples sent while a flush is under way may or may not be covered
+       * by it; the future only becomes ready at a time when all consumers
+       * have been idle at least once after the flush started.
+       *
+       * The destructor of this class waits for all flushes started by this
+       * function to finish.
+       */
+      std::shared_future<void>
+      flush_consumers_async (const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+      /**
+       * Choose whether the `flush_consumers` calls with which sampling
+       * algorithms end their `sample()` functions wait for all consumers
+       * to finish their work (the default), or only start doing so via
+       * flush_consumers_async() on the given pool and return right away.
+       * In the latter case, wait_for_flush() or the future returned by
+       * last_flush() can be used to wait for the consumers later.
+       *
+       * This only makes sense for objects that generate samples, i.e.,
+       * not for filters: A filter is flushed when its upstream producer
+       * flushes it, and that flush needs to include the consumers
+       * connected to the filter.
+       */
+      void
+      set_deferred_flush (const bool deferred,
+                          const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+      /**
+       * Return a future that becomes ready once the most recent flush
+       * started via flush_consumers_async() (or a deferred flush, see
+       * set_deferred_flush()) has finished. If no flush has been started,
+       * the returned future is ready.
+       */
+      std::shared_future<void>
+      last_flush () const;
+
+      /**
+       * Wait for all flushes started via flush_consumers_async() (or
+       * deferred flushes, see set_deferred_flush()) to finish.
+       */
+      void
+      wait_for_flush ();
+
+      /**
+       * Ask the producer to stop generating samples as soon as possible,
+       * as discussed in the documentation of this class. If the producer is
+       * currently not generating samples, then the request applies to the
+       * next call to its `sample()` function, which then returns right away.
+       * This function can be called from any thread, concurrently with the
+       * producer generating samples.
+       */
+      void
+      request_stop ();
+
+      /**
+       * Return whether request_stop() has been called since the last time
+       * the producer's `sample()` function returned.
+       */
+      bool
+      stop_requested () const;
+
+      /**
+       * Ask the producer not to send the next `n_copies` samples it
+       * generates to its consumer, for use by consumers (such as
+       * Filters::TakeEveryNth) that know that they would discard these
+       * samples anyway. Each sample counts as many copies as its
+       * AuxiliaryData::repetition_count entry says; if a sample consists
+       * of more copies than are left to be skipped, it is sent on with
+       * its repetition count reduced accordingly. Consecutive calls to
+       * this function add up.
+       *
+       * This is only possible if exactly one consumer is connected to
+       * the producer, since all other consumers would otherwise miss the
+       * samples skipped; the function returns whether this is the case
+       * and the request has consequently been registered. The request is
+       * also ignored (but remains registered) for samples that are issued
+       * while more than one consumer is connected, and it only applies to
+       * samples issued one at a time, not to those issued through the
+       * `issue_batch` signal. A consumer that receives a sample while it
+       * believes that the producer should still be skipping samples can
+       * find out how many of the copies it had asked to skip were not
+       * skipped by calling cancel_skip_request().
+       *
+       * The function is `const` because it does not affect which samples
+       * the producer generates, only whether they are delivered; it is
+       * called through the `const` pointers to their producers that
+       * consumers store.
+       */
+      bool
+      skip_next_samples (const types::sample_index n_copies) const;
+
+      /**
+       * Cancel the request made by previous calls to skip_next_samples(),
+       * and return the number of copies that were still to be skipped.
+       */
+      types::sample_index
+      cancel_skip_request () const;
+
+      /**
+       * Return the performance counters of this object: how many samples
+       * it has sent downstream via issue_sample(), and how long that took.
+       * As for Consumer::get_consumer_statistics(), the counters are only
+       * kept if SampleFlow was compiled with
+       * `SAMPLEFLOW_WITH_INSTRUMENTATION` defined, and otherwise all
+       * counters of the returned object are zero. Samples sent downstream
+       * in batches are not counted here, but by the consumers receiving
+       * them.
+       */
+      Instrumentation::ProducerStatistics
+      get_producer_statistics () const;
+
+      /**
+       * Return a description of the pipeline that starts at the current
+       * object, i.e., of the current object and all consumers and filters
+       * connected to it, directly or indirectly via filters, together with
+       * the connections between them. See the PipelineGraph namespace for
+       * what is recorded about each node and edge. If the current object
+       * is a Filter, then the description starts at the filter, i.e., it
+       * does not include the producers upstream of it.
+       *
+       * The function can be called at any time, including while samples
+       * are being produced, but it only provides a snapshot; in
+       * particular, the queue depths of asynchronous consumers may already
+       * have changed by the time the function returns.
+       */
+      PipelineGraph::Graph
+      describe_pipeline () const;
+
+      /**
+       * Return whether any of the objects connected to the current one may
+       * look at the entry with the given key in the auxiliary data of the
+       * samples it sends downstream. Each consumer declares the keys it uses
+       * through Consumer::used_aux_data_keys(), and filters pass on the
+       * requests of the objects connected to them. Sampling algorithms can
+       * call this function at the start of their `sample()` functions to
+       * skip computing and storing entries that would only be ignored; since
+       * the answer reflects the connections that exist at the time of the
+       * call, consumers need to be connected before sampling starts (as is
+       * the case for the efficient use of issue_sample() anyway).
+       *
+       * The function errs on the side of caution: It returns `true` if a
+       * consumer has not declared which keys it uses, or if a function has
+       * been attached via connect_to_signals() by something other than a
+       * Consumer whose interests are unknown. If no one is connected at
+       * all, it returns `false`.
+       *
+       * The entries that affect what a sample means -- namely those stored
+       * under AuxiliaryData::repetition_count and
+       * AuxiliaryData::sample_weight -- should be provided by producers
+       * regardless of what this function returns.
+       */
+      bool
+      aux_data_requested (const AuxiliaryData::Key &key) const;
+
+      /**
+       * Record that the given object has connected to the current object,
+       * and that it counts the samples it receives through this connection
+       * in the given `counter`. Consumer::connect_to_producer() calls this
+       * function with the producer object returned by connect_to_signals(),
+       * so that describe_pipeline() can later find the objects downstream
+       * of the current one. Like skip_next_samples(), the function is
+       * `const` because it is called through the `const` pointers to their
+       * producers that consumers store; it does not affect which samples
+       * are produced.
+       */
+      void
+      register_downstream_node (PipelineGraph::DownstreamNode *node,
+                                const std::shared_ptr<const PipelineGraph::EdgeCounter> &counter) const;
+
+      /**
+       * Undo one previous call to register_downstream_node() with the
+       * given object, when that object disconnects from the current one.
+       */
+      void
+      unregister_downstream_node (const PipelineGraph::DownstreamNode *node) const;
 
     protected:
       /**
-       * The signal that is used to notify downstream objects of the
+       * The type of the `flush_consumers` signal: A Signal object whose
+       * invocation either calls all connected slots (as for any other
+       * signal), or, if set_deferred_flush() has been called, starts doing
+       * so via flush_consumers_async().
+       */
+      class FlushSignal : public Signal<void ()>
+      {
+        public:
+          /**
+           * Constructor.
+           */
+          explicit
+          FlushSignal (Producer &producer);
+
+          /**
+           * Invoke the signal as described above.
+           */
+          void
+          operator() () const;
+
+          /**
+           * Invoke the signal by calling all connected slots, regardless
+           * of whether flushing is deferred.
+           */
+          void
+          call_slots () const;
+
+        private:
+          /**
+           * The producer this signal belongs to.
+           */
+          Producer &producer;
+      };
+
+      /**
+       * Add nodes for all objects registered via register_downstream_node()
+       * to the given graph (unless the graph already contains them), along
+       * with the edges from the current object to them. This is called by
+       * describe_pipeline() and, for filters, by Filter::add_to_graph().
+       */
+      void
+      add_downstream_nodes_to_graph (PipelineGraph::Graph &graph) const;
+
+      /**
+       * Tell all objects connected to the current one what samples to
+       * expect, before sending the first of them, so that they can
+       * allocate the memory they need up front. Derived classes call this
+       * function at the start of their `sample()` functions with as much
+       * information as they have, typically the number of samples
+       * requested and the number of components of the starting sample (see
+       * SampleShape::of()). Filters pass the information on to the objects
+       * connected to them, see Filter::output_shape(), and consumers
+       * receive it through Consumer::prepare_for_samples().
+       *
+       * As for aux_data_requested(), only the objects connected at the
+       * time of the call are informed; this function must not be called
+       * while samples are being sent.
+       */
+      void
+      announce_samples (const SampleShape &shape);
+
+      /**
+       * Forget about a previous call to request_stop(). Derived classes call
+       * this function when their `sample()` function returns.
+       */
+      void
+      clear_stop_request ();
+
+      /**
+       * The function that is used to notify downstream objects of the
        * availability of a new sample. Implementations of derived
-       * classes should call this signal whenever a new sample has
+       * classes should call this function whenever a new sample has
        * been produced.
+       *
+       * The function does not simply pass the sample on by value to
+       * every connected consumer. Rather, it wraps the sample and its
+       * auxiliary data in a SharedSample object that all consumers
+       * receive a reference to: All but the last consumer then make a
+       * copy of the sample for their own use, and the last one receives
+       * the original object. Sending a sample to $N$ consumers therefore
+       * requires $N-1$ copies (and no copy at all for the common case of a
+       * single consumer), rather than the $N+1$ copies that would result
+       * from passing the sample through a signal by value. For this to
+       * work, the list of consumers must not change while samples are
+       * being produced, i.e., consumers must connect to a producer before
+       * the producer starts generating samples.
+       *
+       * If no consumer is connected, the function does nothing.
+       */
+      void
+      issue_sample (OutputType sample,
+                    AuxiliaryData aux_data);
+
+      /**
+       * Send a sequence of `n_batches` batches downstream via the
+       * `issue_batch` signal, where the samples (and auxiliary data) of each
+       * batch are created by calling `create_batch` with the number of the
+       * batch, on the threads of the given thread pool. This is a building
+       * block for derived classes that have random access to the samples
+       * they produce, such as Producers::Range::sample_in_parallel().
+       *
+       * If `preserve_order` is `false`, then each batch is sent downstream
+       * by the thread that created it, as soon as it is created. Batches
+       * then arrive in no particular order and concurrently from different
+       * threads. Otherwise, the calling thread sends the batches downstream
+       * in order while the threads of the pool already create the next few
+       * batches.
+       *
+       * The function stops sending batches once stop_requested() returns
+       * `true`. It does not call `flush_consumers`; this is left to the
+       * caller.
        */
-      boost::signals2::signal<void (OutputType, AuxiliaryData)> issue_sample;
+      void
+      issue_batches_in_parallel (const std::size_t n_batches,
+                                 const std::function<std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>> (const std::size_t)> &create_batch,
+                                 const bool preserve_order,
+                                 ThreadPool &thread_pool);
+
+      /**
+       * The signal that is used to notify downstream objects of the
+       * availability of a whole batch of new samples. The arguments are
+       * a vector of samples and a vector of the same length that contains
+       * the auxiliary data for each of these samples.
+       *
+       * Calling this signal has the same effect as calling `issue_sample`
+       * for each sample of the batch in turn, but it is cheaper: Each
+       * downstream object is only called once for the batch, rather than
+       * once for every sample, and can in turn process the samples all at
+       * once using Consumer::consume_batch(). Derived classes that
+       * naturally produce several samples at once (or that can buffer
+       * samples before sending them off) should therefore prefer this
+       * signal.
+       *
+       * The one difference to calling `issue_sample` for each sample is
+       * that if several consumers are connected to a producer, then
+       * each of them sees all samples of the batch before the next consumer
+       * sees any. All consumers see the samples of a batch in the same order,
+       * however.
+       */
+      Signal<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> issue_batch;
 
       /**
        * The signal that is used to notify downstream objects of the
@@ -174,20 +568,90 @@ namespace SampleFlow
        * (which, because it isn't caught here, automatically leads to the
        * current function exiting as well).
        */
-      boost::signals2::signal<void ()> flush_consumers;
+      FlushSignal flush_consumers;
 
     private:
+      /**
+       * Whether flushing is deferred (see set_deferred_flush()), and the
+       * pool on which deferred flushes are run.
+       */
+      std::atomic<bool>           deferred_flush {false};
+      std::shared_ptr<ThreadPool> deferred_flush_pool;
+
+      /**
+       * The flushes started via flush_consumers_async() that have not
+       * finished yet, the future of the most recent one, and a mutex that
+       * protects the latter.
+       */
+      ThreadPool::TaskGroup    pending_flushes;
+      std::shared_future<void> most_recent_flush;
+      mutable std::mutex       flush_mutex;
+
+      /**
+       * The number of functions connected to `sample_signal`. This is the
+       * number of receivers each SharedSample object created by
+       * issue_sample() has to expect. The variable is declared before the
+       * signal because the objects connected to the signal decrement it
+       * when they are destroyed, and so it has to outlive the signal.
+       */
+      std::atomic<std::size_t> n_sample_slots;
+
+      /**
+       * The signal through which issue_sample() sends samples to all
+       * connected consumers. The functions connected to this signal are
+       * wrappers around the functions passed to connect_to_signals() that
+       * extract their copy of the sample from the SharedSample object.
+       */
+      Signal<void (SharedSample<OutputType> &)> sample_signal;
+
       /**
        * A signal that is used to notify downstream consumer or filter objects
        * that they need to disconnect from the current object (provided as
        * argument to the signal) because the current object is going out of
        * scope.
        */
-      boost::signals2::signal<void (const Producer<OutputType> &)> disconnect_consumers;
+      Signal<void (const Producer<OutputType> &)> disconnect_consumers;
+
+      /**
+       * Whether request_stop() has been called.
+       */
+      std::atomic<bool> stop_is_requested {false};
+
+      /**
+       * The number of copies of samples still to be skipped, see
+       * skip_next_samples().
+       */
+      mutable std::atomic<types::sample_index> n_copies_to_skip {0};
+
+      /**
+       * The objects registered via register_downstream_node(), along with
+       * the counters of the samples sent through their connections, and a
+       * mutex that guards this list.
+       */
+      mutable std::mutex downstream_mutex;
+      mutable std::vector<std::pair<PipelineGraph::DownstreamNode *,
+              std::shared_ptr<const PipelineGraph::EdgeCounter>>> downstream_nodes;
+
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+      /**
+       * The performance counters of this object, kept per thread since
+       * several threads may issue samples at the same time.
+       */
+      mutable ShardedAccumulator<Instrumentation::ProducerStatistics> statistics;
+#endif
   };
 
 
 
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  Producer<OutputType>::Producer ()
+    :
+    flush_consumers (*this)
+  {}
+
+
+
   template <typename OutputType>
   requires (Concepts::is_valid_sampletype<OutputType>)
   Producer<OutputType>::Producer (Producer &&producer)
@@ -196,13 +660,21 @@ namespace SampleFlow
     // here, even if we later need to check that these signals
     // do not have any connections yet. Alas, moving BOOST signals
     // is broken: https://github.com/boostorg/signals2/issues/75
-    issue_sample (),
-    flush_consumers (),
-    disconnect_consumers ()
+    issue_batch (),
+    flush_consumers (*this),
+    n_sample_slots (0),
+    sample_signal (),
+    disconnect_consumers (),
+    stop_is_requested (false),
+    n_copies_to_skip (0),
+    downstream_mutex (),
+    downstream_nodes ()
   {
-    assert(producer.issue_sample.empty());
+    assert(producer.sample_signal.empty());
+    assert(producer.issue_batch.empty());
     assert(producer.flush_consumers.empty());
     assert(producer.disconnect_consumers.empty());
+    assert(producer.downstream_nodes.empty());
   }
 
 
@@ -211,26 +683,240 @@ namespace SampleFlow
   requires (Concepts::is_valid_sampletype<OutputType>)
   Producer<OutputType>::~Producer ()
   {
+    pending_flushes.wait();
     disconnect_consumers(*this);
   }
 
 
 
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  std::shared_future<void>
+  Producer<OutputType>::flush_consumers_async (const std::shared_ptr<ThreadPool> &thread_pool)
+  {
+    assert (thread_pool != nullptr);
+
+    const std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+    const std::shared_future<void> future = promise->get_future().share();
+    {
+      std::lock_guard<std::mutex> lock (flush_mutex);
+      most_recent_flush = future;
+    }
+
+    pending_flushes.run (*thread_pool, [this, promise]()
+    {
+      flush_consumers.call_slots();
+      promise->set_value();
+    });
+
+    return future;
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::set_deferred_flush (const bool deferred,
+                                            const std::shared_ptr<ThreadPool> &thread_pool)
+  {
+    assert (thread_pool != nullptr);
+
+    deferred_flush_pool = thread_pool;
+    deferred_flush.store (deferred);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  std::shared_future<void>
+  Producer<OutputType>::last_flush () const
+  {
+    std::lock_guard<std::mutex> lock (flush_mutex);
+    if (most_recent_flush.valid())
+      return most_recent_flush;
+
+    std::promise<void> promise;
+    promise.set_value();
+    return promise.get_future().share();
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::wait_for_flush ()
+  {
+    pending_flushes.wait();
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  Producer<OutputType>::FlushSignal::FlushSignal (Producer &producer)
+    :
+    producer (producer)
+  {}
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::FlushSignal::operator() () const
+  {
+    if (producer.deferred_flush.load())
+      producer.flush_consumers_async (producer.deferred_flush_pool);
+    else
+      call_slots();
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::FlushSignal::call_slots () const
+  {
+    Signal<void ()>::operator() ();
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::request_stop ()
+  {
+    stop_is_requested.store (true, std::memory_order_relaxed);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  bool
+  Producer<OutputType>::stop_requested () const
+  {
+    return stop_is_requested.load (std::memory_order_relaxed);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::clear_stop_request ()
+  {
+    stop_is_requested.store (false, std::memory_order_relaxed);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  bool
+  Producer<OutputType>::skip_next_samples (const types::sample_index n_copies) const
+  {
+    if (n_sample_slots.load() != 1)
+      return false;
+
+    n_copies_to_skip.fetch_add (n_copies, std::memory_order_relaxed);
+    return true;
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  types::sample_index
+  Producer<OutputType>::cancel_skip_request () const
+  {
+    return n_copies_to_skip.exchange (0, std::memory_order_relaxed);
+  }
+
+
+
   template <typename OutputType>
   requires (Concepts::is_valid_sampletype<OutputType>)
   std::pair<const Producer<OutputType> *,
-      std::tuple<boost::signals2::connection,boost::signals2::connection,boost::signals2::connection>>
+      std::tuple<Connection,Connection,Connection,Connection>>
       Producer<OutputType>::
       connect_to_signals (const std::function<void (OutputType, AuxiliaryData)> &new_sample_slot,
+                          const std::function<void (const std::vector<OutputType> &, const std::vector<AuxiliaryData> &)> &new_batch_slot,
                           const std::function<void ()> &flush_slot,
-                          const std::function<void (const Producer<OutputType> &)> &disconnect_slot)
+                          const std::function<void (const Producer<OutputType> &)> &disconnect_slot,
+                          const std::function<void (const OutputType &, const AuxiliaryData &)> &reference_signal_slot)
   {
+    // The sample signal does not send samples by value, but a reference
+    // to a SharedSample object from which each slot needs to extract its
+    // own copy. Keep track of the number of slots so that issue_sample()
+    // can tell the SharedSample object how many receivers to expect:
+    // Wrap the slot in a lambda function that holds an object that
+    // increments the counter upon creation and decrements it again
+    // when the lambda function (and any copies thereof) is destroyed,
+    // which happens when the slot is disconnected.
+    class SlotCounter
+    {
+      public:
+        SlotCounter (std::atomic<std::size_t> &counter)
+          :
+          counter (&counter)
+        {
+          ++counter;
+        }
+
+        SlotCounter (const SlotCounter &other)
+          :
+          SlotCounter (*other.counter)
+        {}
+
+        ~SlotCounter ()
+        {
+          --*counter;
+        }
+
+      private:
+        std::atomic<std::size_t> *counter;
+    };
+
+    // Samples that can not be copied can only be sent to a single
+    // consumer (see SharedSample):
+    if constexpr (!std::copyable<OutputType>)
+      assert ((n_sample_slots.load() == 0) &&
+              "A producer of samples that can not be copied can only be "
+              "connected to a single consumer. Use a Filters::MakeShared "
+              "object to send such samples to several consumers.");
+
+    // Consumers that only look at samples receive references to the
+    // stored objects, and then release them without taking a copy:
+    auto sample_slot
+      = [new_sample_slot, reference_signal_slot, slot_counter = SlotCounter(n_sample_slots)]
+        (SharedSample<OutputType> &shared_sample)
+    {
+      if (reference_signal_slot)
+        {
+          reference_signal_slot (shared_sample.sample(), shared_sample.aux_data());
+          shared_sample.release();
+        }
+      else
+        {
+          std::pair<OutputType,AuxiliaryData> sample_and_aux_data = shared_sample.take();
+          new_sample_slot (std::move(sample_and_aux_data.first),
+                           std::move(sample_and_aux_data.second));
+        }
+    };
+
     // Connect with the signal and return the connection object.
     return
     {
       this,
       {
-        issue_sample.connect (new_sample_slot),
+        sample_signal.connect (std::move(sample_slot)),
+        issue_batch.connect (new_batch_slot),
         flush_consumers.connect (flush_slot),
         disconnect_consumers.connect (disconnect_slot)
       }
@@ -238,6 +924,338 @@ namespace SampleFlow
   }
 
 
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  issue_sample (OutputType sample,
+                AuxiliaryData aux_data)
+  {
+    // Consumers may be connected or disconnected on other threads while
+    // we are sending the sample. The number of receivers we announce to
+    // the SharedSample object below must not be smaller than the number of
+    // slots we actually call, so take a snapshot of the list of slots
+    // and send the sample to exactly the slots in it. (With BOOST's
+    // signals2 library, we cannot do that, and have to rely on consumers
+    // not being connected while samples are sent.)
+#ifdef SAMPLEFLOW_WITH_BOOST_SIGNALS2
+    const auto &receivers = sample_signal;
+    const std::size_t n_receivers = n_sample_slots.load();
+#else
+    const auto receivers = sample_signal.current_slots();
+    const std::size_t n_receivers = receivers.size();
+#endif
+    if (n_receivers == 0)
+      return;
+
+    // If our only consumer has asked us to skip samples, take as many
+    // copies of the current sample off the number of copies still to be
+    // skipped as we can, and only send on what is left:
+    if ((n_receivers == 1)
+        &&
+        (n_copies_to_skip.load (std::memory_order_relaxed) > 0))
+      {
+        const types::sample_index n_repetitions = aux_data.n_repetitions();
+        types::sample_index n_to_skip = n_copies_to_skip.load (std::memory_order_relaxed);
+        while ((n_to_skip > 0)
+               &&
+               !n_copies_to_skip.compare_exchange_weak (n_to_skip,
+                                                        n_to_skip - std::min (n_to_skip, n_repetitions),
+                                                        std::memory_order_relaxed))
+          ;
+
+        const types::sample_index n_skipped = std::min (n_to_skip, n_repetitions);
+        if (n_skipped == n_repetitions)
+          return;
+        else if (n_skipped > 0)
+          aux_data[AuxiliaryData::repetition_count] = std::size_t(n_repetitions - n_skipped);
+      }
+
+    SharedSample<OutputType> shared_sample (std::move(sample),
+                                            std::move(aux_data),
+                                            n_receivers);
+    Tracing::Span span ("issue_sample", "producer", this);
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    const Instrumentation::Clock::time_point start = Instrumentation::Clock::now();
+    receivers (shared_sample);
+    const std::chrono::nanoseconds issue_time = Instrumentation::Clock::now() - start;
+
+    statistics.update ([&](Instrumentation::ProducerStatistics &s)
+    {
+      ++s.n_samples;
+      s.issue_time += issue_time;
+      s.issue_time_histogram.add (issue_time);
+    });
+#else
+    receivers (shared_sample);
+#endif
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  Instrumentation::ProducerStatistics
+  Producer<OutputType>::
+  get_producer_statistics () const
+  {
+#ifdef SAMPLEFLOW_WITH_INSTRUMENTATION
+    return statistics.merged();
+#else
+    return {};
+#endif
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  PipelineGraph::Graph
+  Producer<OutputType>::
+  describe_pipeline () const
+  {
+    PipelineGraph::Graph graph;
+
+    // Filters describe themselves, including everything downstream of
+    // them. For everything else, add a node for the current object and
+    // then walk downstream from it.
+    if (const auto *const node = dynamic_cast<const PipelineGraph::DownstreamNode *>(this))
+      node->add_to_graph (graph);
+    else
+      {
+        PipelineGraph::Node producer_node;
+        producer_node.object    = dynamic_cast<const void *>(this);
+        producer_node.type_name = PipelineGraph::demangled_type_name (typeid(*this));
+        producer_node.kind      = PipelineGraph::NodeKind::producer;
+        graph.nodes.push_back (producer_node);
+
+        add_downstream_nodes_to_graph (graph);
+      }
+
+    return graph;
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  bool
+  Producer<OutputType>::
+  aux_data_requested (const AuxiliaryData::Key &key) const
+  {
+    std::lock_guard<std::mutex> lock (downstream_mutex);
+
+    // Every Consumer connected to us has registered itself, so if there
+    // are more slots than registered objects, then someone has connected
+    // whose interests we do not know about:
+    if (n_sample_slots.load() > downstream_nodes.size())
+      return true;
+
+    return std::any_of (downstream_nodes.begin(), downstream_nodes.end(),
+                        [&key](const auto &entry)
+    {
+      return entry.first->requests_aux_data (key);
+    });
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  register_downstream_node (PipelineGraph::DownstreamNode *node,
+                            const std::shared_ptr<const PipelineGraph::EdgeCounter> &counter) const
+  {
+    std::lock_guard<std::mutex> lock (downstream_mutex);
+    downstream_nodes.emplace_back (node, counter);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  unregister_downstream_node (const PipelineGraph::DownstreamNode *node) const
+  {
+    std::lock_guard<std::mutex> lock (downstream_mutex);
+
+    // A consumer may be connected to the same producer more than once, so
+    // only remove one of the entries for it:
+    const auto p = std::find_if (downstream_nodes.begin(), downstream_nodes.end(),
+                                 [node](const auto &entry)
+    {
+      return (entry.first == node);
+    });
+    if (p != downstream_nodes.end())
+      downstream_nodes.erase (p);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  announce_samples (const SampleShape &shape)
+  {
+    // Copy the list of downstream objects so that we do not hold the lock
+    // while they (and, for filters, the objects downstream of them)
+    // prepare for the samples:
+    std::vector<PipelineGraph::DownstreamNode *> nodes;
+    {
+      std::lock_guard<std::mutex> lock (downstream_mutex);
+      nodes.reserve (downstream_nodes.size());
+      for (const auto &entry : downstream_nodes)
+        nodes.push_back (entry.first);
+    }
+
+    for (PipelineGraph::DownstreamNode *node : nodes)
+      node->receive_announcement (shape);
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  add_downstream_nodes_to_graph (PipelineGraph::Graph &graph) const
+  {
+    const void *const this_node = dynamic_cast<const void *>(this);
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock (downstream_mutex);
+    for (const auto &[node, counter] : downstream_nodes)
+      {
+        PipelineGraph::Edge edge;
+        edge.producer  = this_node;
+        edge.consumer  = node->graph_node_id();
+        edge.n_samples = counter->n_samples.load (std::memory_order_relaxed);
+
+        const double elapsed
+          = std::chrono::duration<double>(now - counter->connection_time).count();
+        if (elapsed > 0)
+          edge.samples_per_second = edge.n_samples / elapsed;
+        graph.edges.push_back (edge);
+
+        node->add_to_graph (graph);
+      }
+  }
+
+
+
+  template <typename OutputType>
+  requires (Concepts::is_valid_sampletype<OutputType>)
+  void
+  Producer<OutputType>::
+  issue_batches_in_parallel (const std::size_t n_batches,
+                             const std::function<std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>> (const std::size_t)> &create_batch,
+                             const bool preserve_order,
+                             ThreadPool &thread_pool)
+  {
+    if (n_batches == 0)
+      return;
+
+    if (preserve_order == false)
+      {
+        // Start one task per thread of the pool (but not more than there
+        // are batches). Each of these tasks repeatedly grabs the next batch
+        // not yet processed, creates it, and sends it off.
+        std::atomic<std::size_t> next_batch = 0;
+
+        ThreadPool::TaskGroup tasks;
+        const std::size_t n_tasks = std::min<std::size_t> (thread_pool.n_threads(), n_batches);
+        for (std::size_t t=0; t<n_tasks; ++t)
+          tasks.run (thread_pool,
+                     [&]()
+        {
+          while (this->stop_requested() == false)
+            {
+              const std::size_t batch = next_batch++;
+              if (batch >= n_batches)
+                break;
+
+              const auto [samples, aux_data] = create_batch (batch);
+              issue_batch (samples, aux_data);
+            }
+        });
+        tasks.wait();
+      }
+    else
+      {
+        // Work on rounds of a few batches per thread: While the current
+        // thread sends the batches of one round downstream in order, the
+        // threads of the pool already create the batches of the next
+        // round. This keeps the pool busy but bounds the memory used for
+        // batches that have been created but not sent yet.
+        using Batch = std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>>;
+        const std::size_t batches_per_round = 4 * thread_pool.n_threads();
+
+        std::vector<Batch> current_round;
+        std::vector<Batch> next_round;
+        ThreadPool::TaskGroup tasks;
+
+        const auto start_round = [&](std::vector<Batch> &round,
+                                     const std::size_t first_batch)
+        {
+          round.resize (std::min (batches_per_round, n_batches - first_batch));
+          for (std::size_t b=0; b<round.size(); ++b)
+            tasks.run (thread_pool,
+                       [&round, &create_batch, first_batch, b]()
+          {
+            round[b] = create_batch (first_batch + b);
+          });
+        };
+
+        start_round (current_round, 0);
+        tasks.wait();
+
+        for (std::size_t first_batch=0; first_batch<n_batches; first_batch+=batches_per_round)
+          {
+            if (first_batch + batches_per_round < n_batches)
+              start_round (next_round, first_batch + batches_per_round);
+
+            for (const Batch &batch : current_round)
+              {
+                issue_batch (batch.first, batch.second);
+
+                if (this->stop_requested())
+                  {
+                    tasks.wait();
+                    return;
+                  }
+              }
+
+            tasks.wait();
+            std::swap (current_round, next_round);
+          }
+      }
+  }
+
+
+  namespace internal
+  {
+    /**
+     * Return whether the given value of a log prior or log likelihood
+     * indicates that a sample has zero probability. Following the
+     * convention of Producers::MetropolisHastings, functions that compute
+     * log likelihoods indicate this by returning either minus infinity or
+     * `-std::numeric_limits<double>::max()`.
+     */
+    inline
+    bool
+    has_zero_probability (const double log_likelihood)
+    {
+      return ((log_likelihood == -std::numeric_limits<double>::max())
+              ||
+              (log_likelihood == -std::numeric_limits<double>::infinity()));
+    }
+  }
+
+
   /**
    * A namespace for the implementation of producers, i.e., classes
    * derived from the Producer class.
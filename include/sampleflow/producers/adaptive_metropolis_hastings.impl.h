@@ -0,0 +1,466 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the Adaptive Metropolis algorithm of Haario,
+     * Saksman, and Tamminen (see @cite HST01). This is a Metropolis-Hastings
+     * sampler with a Gaussian proposal distribution whose covariance matrix
+     * is learned from the samples the chain has produced so far: After
+     * an initial phase in which trial samples are drawn from
+     * $N(x_k, C_0)$ with a given covariance matrix $C_0$, the trial samples
+     * are drawn from
+     * @f{align*}{
+     *   \tilde x \sim N\left(x_k, s_d \left(C_k + \frac{\lambda}{k} I\right)\right),
+     * @f}
+     * where $C_k$ is the covariance matrix of the samples $x_0,\ldots,x_k$,
+     * $s_d$ a scaling factor that is typically chosen as $\frac{2.4^2}{d}$
+     * for a sample space of dimension $d$ (see @cite GRG95), and
+     * $\lambda$ a small regularization parameter that ensures that the
+     * proposal covariance is positive definite even if $C_k$ is not,
+     * and that becomes less important as the chain grows.
+     *
+     * The documentation of the MetropolisHastings class shows how one can
+     * implement this algorithm using a Consumers::CovarianceMatrix object
+     * and a proposal function that computes the Cholesky factorization
+     * $C_k=LL^T$ needed to draw from the proposal distribution. This costs
+     * ${\cal O}(d^3)$ operations per sample, which becomes prohibitive
+     * for sample spaces of even moderately large dimension. This class
+     * instead stores $M_k=kC_k + \lambda I$ along with its Cholesky
+     * factorization, and whenever a sample is added to the chain updates
+     * the factorization with a rank-1 update: Using Welford's formula,
+     * @f{align*}{
+     *   M_{k+1} = M_k + \frac{k+1}{k+2} (x_{k+1}-\bar x_k)(x_{k+1}-\bar x_k)^T,
+     * @f}
+     * where $\bar x_k$ is the mean of the first $k+1$ samples. Each step
+     * then only costs ${\cal O}(d^2)$ operations. Because rank-1 updates
+     * accumulate round-off errors, the factorization is recomputed from
+     * $M_k$ after every Parameters::refactorization_interval samples.
+     *
+     * The proposal distribution is symmetric, and so trial samples are
+     * accepted or rejected with the same criterion as in the
+     * MetropolisHastings class. The AuxiliaryData object sent along with
+     * each sample also stores the same entries as described there.
+     *
+     * Strictly speaking, a chain whose proposal distribution keeps changing
+     * is no longer a Markov chain. The Adaptive Metropolis algorithm is
+     * nevertheless known to sample the correct distribution (see
+     * @cite HST01). If one wants to be on the safe side, one can stop the
+     * adaptation after a certain number of samples via
+     * Parameters::n_adaptive_samples, and only use the samples produced
+     * after that.
+     *
+     * @tparam OutputType The type of the samples. It needs to represent
+     *   a vector space, and one needs to be able to access its elements
+     *   via the functions in namespace Utilities, as for the
+     *   Consumers::CovarianceMatrix class.
+     * @tparam RandomNumberGenerator The type of the random number generator.
+     *   See the documentation of the MetropolisHastings class for more
+     *   information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class AdaptiveMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * The data type of the elements of the samples.
+         */
+        using scalar_type = types::ScalarType<OutputType>;
+
+        /**
+         * The type used to represent the covariance matrix of the proposal
+         * distribution.
+         */
+        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm, including the adaptation schedule.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generators used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The covariance matrix $C_0$ of the proposal distribution used
+           * before the adaptation starts. If this matrix is empty, then
+           * the identity matrix is used.
+           */
+          matrix_type initial_proposal_covariance;
+
+          /**
+           * The number of samples that are drawn with the initial proposal
+           * covariance matrix before the adaptation starts. The samples
+           * produced during this phase nevertheless contribute to the
+           * covariance matrix $C_k$ used after it.
+           */
+          types::sample_index n_non_adaptive_samples = 1000;
+
+          /**
+           * The number of samples after the initial phase during which the
+           * proposal covariance matrix is adapted. After that, the proposal
+           * distribution is frozen at its last state. The default is to
+           * never stop adapting.
+           */
+          types::sample_index n_adaptive_samples = std::numeric_limits<types::sample_index>::max();
+
+          /**
+           * The scaling factor $s_d$. If zero, then $\frac{2.4^2}{d}$ is
+           * used, where $d$ is the dimension of the samples.
+           */
+          double scaling_factor = 0;
+
+          /**
+           * The regularization parameter $\lambda$.
+           */
+          double regularization = 1e-6;
+
+          /**
+           * The number of rank-1 updates after which the Cholesky
+           * factorization is recomputed from scratch.
+           */
+          types::sample_index refactorization_interval = 1000;
+        };
+
+        /**
+         * Constructor.
+         */
+        AdaptiveMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial sample $x_0$, it produces a sequence of samples $x_k$
+         * that are passed through the signal of the base class to
+         * Consumer objects.
+         *
+         * The state of the adaptation is kept between calls of this
+         * function. Calling it a second time therefore continues the chain
+         * with the proposal distribution learned so far, starting from
+         * the given point. This point is typically the last sample of the
+         * previous call, and so is not added to the data from which the
+         * proposal distribution is learned a second time.
+         *
+         * @param[in] starting_point The initial sample $x_0$.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$. See
+         *   MetropolisHastings::sample() for the treatment of samples with
+         *   zero probability.
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const types::sample_index n_samples);
+
+        /**
+         * Return the covariance matrix of the proposal distribution that
+         * is used for the next trial sample. The matrix is computed from its
+         * Cholesky factorization, which is what is actually used to draw
+         * trial samples.
+         */
+        matrix_type
+        get_proposal_covariance () const;
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+
+        /**
+         * The number of samples that have been added to the covariance
+         * matrix so far, i.e., $k+1$ in the notation of the class
+         * documentation.
+         */
+        types::sample_index n_samples_seen;
+
+        /**
+         * The mean value $\bar x_k$ of the samples seen so far.
+         */
+        Eigen::Matrix<scalar_type,Eigen::Dynamic,1> mean;
+
+        /**
+         * The matrix $M_k$.
+         */
+        matrix_type scaled_covariance;
+
+        /**
+         * The Cholesky factorization of $M_k$, as well as the number of
+         * rank-1 updates applied to it since it was last computed from
+         * scratch. The factorization is only computed once the adaptation
+         * starts.
+         */
+        Eigen::LLT<matrix_type> factorization;
+        types::sample_index     n_rank_one_updates;
+
+        /**
+         * The Cholesky factorization of the initial proposal covariance
+         * matrix $C_0$.
+         */
+        Eigen::LLT<matrix_type> initial_factorization;
+
+        /**
+         * Return whether the proposal distribution is currently the
+         * adaptive one.
+         */
+        bool
+        is_adapting () const;
+
+        /**
+         * Add a sample of the chain to $\bar x_k$ and $M_k$, and update
+         * the factorization if necessary.
+         */
+        void
+        add_to_covariance (const OutputType &sample);
+
+        /**
+         * Return a trial sample drawn from the current proposal
+         * distribution around the given sample.
+         */
+        OutputType
+        propose_sample (const OutputType &current_sample);
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    AdaptiveMetropolisHastings (const Parameters &parameters)
+      :
+      parameters (parameters),
+      n_samples_seen (0),
+      n_rank_one_updates (0)
+    {
+      assert (parameters.refactorization_interval > 0);
+      assert (parameters.regularization > 0);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const auto dimension = Utilities::size(starting_point);
+      if (n_samples_seen == 0)
+        {
+          mean.setZero (dimension);
+          scaled_covariance = parameters.regularization *
+                              matrix_type::Identity (dimension, dimension);
+
+          if (parameters.initial_proposal_covariance.size() == 0)
+            initial_factorization.compute (matrix_type::Identity (dimension, dimension));
+          else
+            initial_factorization.compute (parameters.initial_proposal_covariance);
+          assert (initial_factorization.info() == Eigen::Success);
+        }
+      assert (mean.size() == static_cast<Eigen::Index>(dimension));
+
+      OutputType current_sample         = starting_point;
+      double     current_log_likelihood = log_likelihood (current_sample);
+
+      // The starting point is only new on the first call. A continued run
+      // starts from the last sample of the previous one, which has already
+      // been added to the covariance matrix:
+      if (n_samples_seen == 0)
+        add_to_covariance (current_sample);
+
+      for (types::sample_index i=0; (i<n_samples) && (this->stop_requested() == false); ++i)
+        {
+          OutputType   trial_sample         = propose_sample (current_sample);
+          const double trial_log_likelihood = log_likelihood (trial_sample);
+
+          // The proposal distribution is symmetric, so the ratio of
+          // proposal probabilities is one.
+          const bool repeated_sample
+            = (MetropolisHastings<OutputType,RandomNumberGenerator>::
+               accept_trial_sample (trial_log_likelihood,
+                                    current_log_likelihood,
+                                    1.0,
+                                    rng)
+               == false);
+          if (repeated_sample == false)
+            {
+              std::swap (current_sample, trial_sample);
+              current_log_likelihood = trial_log_likelihood;
+            }
+
+          // Output the new sample (which may be equal to the old sample),
+          // and then let it contribute to the proposal distribution of the
+          // next step.
+          this->issue_sample (current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(repeated_sample)}
+          });
+
+          add_to_covariance (current_sample);
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    typename AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::matrix_type
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    get_proposal_covariance () const
+    {
+      if (is_adapting())
+        {
+          const double scaling_factor
+            = (parameters.scaling_factor != 0 ?
+               parameters.scaling_factor :
+               2.4*2.4/mean.size());
+          return scaling_factor / (n_samples_seen-1) * factorization.reconstructedMatrix();
+        }
+      else
+        return initial_factorization.reconstructedMatrix();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    bool
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    is_adapting () const
+    {
+      // We need at least two samples for a covariance matrix.
+      return ((n_samples_seen > parameters.n_non_adaptive_samples) &&
+              (n_samples_seen >= 2));
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    add_to_covariance (const OutputType &sample)
+    {
+      // Once the adaptation has ended, the proposal distribution does not
+      // change any more:
+      if ((n_samples_seen > parameters.n_non_adaptive_samples)
+          &&
+          (n_samples_seen - parameters.n_non_adaptive_samples > parameters.n_adaptive_samples))
+        return;
+
+      // Update the running mean and M_k using Welford's formula.
+      Eigen::Matrix<scalar_type,Eigen::Dynamic,1> delta (mean.size());
+      for (Eigen::Index i=0; i<mean.size(); ++i)
+        delta(i) = Utilities::get_nth_element (sample, i) - mean(i);
+
+      ++n_samples_seen;
+      const double weight = (n_samples_seen - 1.) / n_samples_seen;
+      mean += delta / n_samples_seen;
+      scaled_covariance.noalias() += weight * delta * delta.transpose();
+
+      // Then update the factorization. While we are still in the initial
+      // phase, there is nothing to do; once we have left it, the
+      // factorization is updated with a rank-1 update unless it is time to
+      // re-compute it from scratch (or the factorization is needed for the
+      // first time).
+      if (is_adapting() == false)
+        return;
+
+      if ((n_samples_seen == parameters.n_non_adaptive_samples+1) ||
+          (n_samples_seen == 2) ||
+          (n_rank_one_updates+1 >= parameters.refactorization_interval))
+        {
+          factorization.compute (scaled_covariance);
+          n_rank_one_updates = 0;
+        }
+      else
+        {
+          factorization.rankUpdate (delta, weight);
+          ++n_rank_one_updates;
+        }
+      assert (factorization.info() == Eigen::Success);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    OutputType
+    AdaptiveMetropolisHastings<OutputType,RandomNumberGenerator>::
+    propose_sample (const OutputType &current_sample)
+    {
+      std::normal_distribution<scalar_type> distribution (0, 1);
+      Eigen::Matrix<scalar_type,Eigen::Dynamic,1> random_vector (mean.size());
+      for (Eigen::Index i=0; i<mean.size(); ++i)
+        random_vector(i) = distribution (rng);
+
+      // Multiply the random vector by the Cholesky factor of the proposal
+      // covariance matrix to obtain a random vector with that covariance.
+      Eigen::Matrix<scalar_type,Eigen::Dynamic,1> perturbation;
+      if (is_adapting())
+        {
+          const double scaling_factor
+            = (parameters.scaling_factor != 0 ?
+               parameters.scaling_factor :
+               2.4*2.4/mean.size());
+          perturbation = factorization.matrixL() * random_vector;
+          perturbation *= std::sqrt (scaling_factor / (n_samples_seen-1));
+        }
+      else
+        perturbation = initial_factorization.matrixL() * random_vector;
+
+      OutputType trial_sample = current_sample;
+      for (Eigen::Index i=0; i<mean.size(); ++i)
+        Utilities::get_nth_element (trial_sample, i) += perturbation(i);
+      return trial_sample;
+    }
+  }
+}
@@ -0,0 +1,40 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_PRODUCERS_AFFINE_INVARIANT_ENSEMBLE_H
+#define SAMPLEFLOW_PRODUCERS_AFFINE_INVARIANT_ENSEMBLE_H
+
+#include <sampleflow/producer.h>
+#include <sampleflow/concepts.h>
+#include <sampleflow/element_access.h>
+#include <sampleflow/scope_exit.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/types.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/producers/affine_invariant_ensemble.impl.h>
+
+#endif
@@ -0,0 +1,421 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the affine-invariant ensemble sampler of Goodman
+     * and Weare (see @cite GoodmanWeare2010) with the "stretch move", the
+     * algorithm that is popularly known through the `emcee` package. The
+     * sampler evolves an ensemble of $N$ "walkers" $x_1,\ldots,x_N$ that
+     * together sample the $N$-fold product of the target distribution.
+     * Rather than requiring a proposal distribution that is adapted to the
+     * shape of the target distribution, as the MetropolisHastings class
+     * does, a walker $x_k$ is updated by choosing another walker $x_j$ and
+     * proposing the trial sample
+     * @f{align*}{
+     *   y = x_j + z (x_k - x_j)
+     * @f}
+     * on the line through the two walkers, where the "stretch factor" $z$
+     * is drawn from the distribution with density
+     * $g(z) \propto \frac{1}{\sqrt{z}}$ on the interval $[1/a,a]$. The
+     * trial sample is accepted with probability
+     * @f{align*}{
+     *   \min\left\{1, z^{d-1}\frac{\pi(y)}{\pi(x_k)}\right\},
+     * @f}
+     * where $d$ is the dimension of the sample space. Because the proposals
+     * are built from the differences between walkers, the algorithm is
+     * invariant under affine transformations of the sample space: It
+     * samples a strongly anisotropic Gaussian as well as it samples a
+     * standard normal distribution.
+     *
+     * Updating the walkers one after the other is inherently sequential.
+     * Like the `emcee` package, this class therefore splits the ensemble
+     * into two halves and updates all walkers of one half at the same
+     * time, using only walkers from the other half as partners $x_j$;
+     * this preserves the correctness of the algorithm since the walkers of
+     * the half that is being updated do not depend on each other. A
+     * "generation" then consists of first updating the first half of the
+     * walkers against the second half, and then the second half against
+     * the (already updated) first half. The likelihoods of the trial
+     * samples of a half-ensemble are evaluated at once, either as tasks on
+     * a ThreadPool or by a function object that evaluates a whole batch of
+     * samples; with $N$ walkers, up to $N/2$ cores are kept busy. All
+     * random numbers are drawn on the thread that calls sample(), in a
+     * fixed order, so the sequence of samples produced depends only on the
+     * random seed and not on the number of threads used.
+     *
+     * The walkers are stored contiguously in one array, and the samples of
+     * each generation are sent downstream via the Producer::issue_batch
+     * signal as one batch, ordered by walker. The AuxiliaryData object that
+     * accompanies each sample carries the entries described for the
+     * MetropolisHastings class, along with an entry with key
+     * AuxiliaryData::chain_number that indicates the walker the sample
+     * belongs to. As for the DifferentialEvaluationMetropolisHastings
+     * class, consecutive samples of the output stream therefore come from
+     * different walkers, and consumers that compute quantities such as
+     * auto-covariances should separate the walkers first.
+     *
+     * The number of walkers should be at least twice the dimension of the
+     * sample space, since the walkers otherwise only explore the affine
+     * subspace spanned by their starting points.
+     *
+     * @tparam OutputType The type of the samples. Since trial samples are
+     *   computed as linear combinations of existing samples, this type
+     *   must represent elements of a vector space; the dimension $d$ of the
+     *   space is computed using Utilities::size().
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used for choosing partner walkers, for the stretch factors, and
+     *   for deciding whether trial samples are accepted. See the
+     *   documentation of the MetropolisHastings class for more
+     *   information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class AffineInvariantEnsemble : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generator used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The parameter $a>1$ that determines the range $[1/a,a]$ of the
+           * stretch factors $z$. The default value $a=2$ is the one
+           * recommended by Goodman and Weare.
+           */
+          double stretch_scale = 2;
+
+          /**
+           * The pool on which the likelihood evaluations are run by the
+           * sample() function that takes a function evaluating the
+           * likelihood of one sample at a time. If this is `nullptr` (the
+           * default), then the pool returned by ThreadPool::default_pool()
+           * is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        AffineInvariantEnsemble (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial positions of the walkers, it produces a sequence of
+         * samples that are passed through the signals of the base class to
+         * Consumer objects.
+         *
+         * @param[in] starting_points The initial positions of the walkers.
+         *   The number of walkers must be even and at least four. The
+         *   starting points must not all lie in a common affine subspace of
+         *   lower dimension than the sample space; they are typically
+         *   drawn from a small ball around a point of high probability.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$. The function is
+         *   called concurrently for the trial samples of a half-ensemble on
+         *   the threads of Parameters::thread_pool, and so needs to be
+         *   reentrant. As for the MetropolisHastings class, a value of
+         *   `-std::numeric_limits<double>::max()` or minus infinity
+         *   indicates that the sample has zero probability.
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function, summed over all walkers. If this number is
+         *   not a multiple of the number of walkers, then only the first
+         *   few walkers are updated in the last generation.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const types::sample_index n_samples);
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once,
+         * namely the starting points and then the trial samples of each
+         * half-ensemble. Whether and how the evaluation of a batch is
+         * parallelized is up to the function object.
+         *
+         * For the same arguments and random seed, this function produces
+         * the same sequence of samples as the previous function.
+         *
+         * @param[in] starting_points See the previous function.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sequence of samples $x_j$, writes $\log(\pi(x_j))$ into the
+         *   corresponding elements of its second argument. See
+         *   types::BatchLogLikelihood.
+         * @param[in] n_samples See the previous function.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+
+        /**
+         * Return a stretch factor $z$ drawn from the distribution with
+         * density proportional to $\frac{1}{\sqrt{z}}$ on $[1/a,a]$. This is
+         * done by inverting the cumulative distribution function: If $u$
+         * is uniformly distributed on $[0,1]$, then
+         * $z=\frac{((a-1)u+1)^2}{a}$ has the desired distribution.
+         */
+        double
+        draw_stretch_factor ();
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    AffineInvariantEnsemble<OutputType,RandomNumberGenerator>::
+    AffineInvariantEnsemble (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert (parameters.stretch_scale > 1);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    AffineInvariantEnsemble<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const types::sample_index n_samples)
+    {
+      // Wrap the function into one that evaluates a whole batch of
+      // samples as tasks on the thread pool:
+      const std::shared_ptr<ThreadPool> thread_pool
+        = (parameters.thread_pool != nullptr ?
+           parameters.thread_pool :
+           ThreadPool::default_pool());
+      const auto batch_log_likelihood
+        = [&log_likelihood, &thread_pool](std::span<const OutputType> samples,
+                                          std::span<double> log_likelihoods)
+      {
+        assert (samples.size() == log_likelihoods.size());
+
+        ThreadPool::TaskGroup evaluations;
+        for (std::size_t i=0; i<samples.size(); ++i)
+          evaluations.run (*thread_pool,
+                           [&log_likelihood, &samples, &log_likelihoods, i]()
+        {
+          log_likelihoods[i] = log_likelihood (samples[i]);
+        });
+        evaluations.wait();
+      };
+
+      sample (starting_points,
+              batch_log_likelihood,
+              n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    AffineInvariantEnsemble<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const types::sample_index n_samples)
+    {
+      const std::size_t n_walkers = starting_points.size();
+      assert (n_walkers >= 4);
+      assert (n_walkers % 2 == 0);
+
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const std::size_t half      = n_walkers / 2;
+      const double      dimension = Utilities::size(starting_points[0]);
+
+      // Store the walkers and their log likelihoods in contiguous arrays.
+      // The same is true for the trial samples of a half-ensemble, along
+      // with the stretch factors and uniform random numbers used to
+      // create and accept or reject them. All of these arrays are
+      // allocated once and re-used in all generations.
+      std::vector<OutputType> walkers = starting_points;
+      std::vector<double>     log_likelihoods (n_walkers);
+      log_likelihood (walkers, log_likelihoods);
+
+      std::vector<OutputType> trial_samples (half, starting_points[0]);
+      std::vector<double>     trial_log_likelihoods (half);
+      std::vector<double>     stretch_factors (half);
+      std::vector<double>     uniform_random_numbers (half);
+      std::vector<bool>       accepted (n_walkers);
+
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+      std::uniform_int_distribution<std::size_t> partner_distribution(0, half-1);
+
+      const auto has_zero_probability = [](const double log_likelihood)
+      {
+        return ((log_likelihood == -std::numeric_limits<double>::max())
+                ||
+                (log_likelihood == -std::numeric_limits<double>::infinity()));
+      };
+
+      std::vector<AuxiliaryData> generation_aux_data;
+      generation_aux_data.reserve (n_walkers);
+
+      for (types::sample_index n_issued = 0; (n_issued < n_samples) && (this->stop_requested() == false); )
+        {
+          // Determine how many walkers we update in this generation. This
+          // is all of them unless this is the last generation. In that
+          // case, we only update the first few walkers -- which are not
+          // necessarily all in the first half.
+          const std::size_t n_active_walkers
+            = std::min<types::sample_index> (n_walkers, n_samples - n_issued);
+
+          // Update first the first half of the walkers against the second
+          // half, then the second half against the first:
+          for (unsigned int h=0; h<2; ++h)
+            {
+              const std::size_t first_walker   = h * half;
+              const std::size_t first_partner  = (1-h) * half;
+              const std::size_t n_active_in_half
+                = std::min (half, n_active_walkers - std::min(n_active_walkers, first_walker));
+              if (n_active_in_half == 0)
+                break;
+
+              // Create the trial samples. We draw all random numbers for
+              // this half here so that they are created in a fixed order.
+              for (std::size_t k=0; k<n_active_in_half; ++k)
+                {
+                  const OutputType &walker  = walkers[first_walker + k];
+                  const OutputType &partner = walkers[first_partner + partner_distribution(rng)];
+
+                  stretch_factors[k] = draw_stretch_factor ();
+                  uniform_random_numbers[k] = uniform_distribution(rng);
+
+                  OutputType difference = walker;
+                  difference -= partner;
+                  trial_samples[k] = partner;
+                  trial_samples[k] += stretch_factors[k] * difference;
+                }
+
+              // Evaluate the likelihoods of all trial samples at once:
+              log_likelihood (std::span<const OutputType> (trial_samples.data(), n_active_in_half),
+                              std::span<double> (trial_log_likelihoods.data(), n_active_in_half));
+
+              // Then decide for each walker whether we accept its trial
+              // sample. If the current position of a walker has zero
+              // probability, we accept whatever we get so that the walker
+              // can find its way into an area of nonzero probability;
+              // trial samples with zero probability are otherwise
+              // rejected.
+              for (std::size_t k=0; k<n_active_in_half; ++k)
+                {
+                  const std::size_t walker = first_walker + k;
+
+                  bool accepted_sample;
+                  if (has_zero_probability (log_likelihoods[walker]))
+                    accepted_sample = true;
+                  else if (has_zero_probability (trial_log_likelihoods[k]))
+                    accepted_sample = false;
+                  else
+                    {
+                      const double log_acceptance_ratio
+                        = ((dimension-1) * std::log(stretch_factors[k])
+                           + trial_log_likelihoods[k] - log_likelihoods[walker]);
+                      accepted_sample = ((log_acceptance_ratio >= 0)
+                                         ||
+                                         (std::exp(log_acceptance_ratio) >= uniform_random_numbers[k]));
+                    }
+
+                  if (accepted_sample)
+                    {
+                      std::swap (walkers[walker], trial_samples[k]);
+                      log_likelihoods[walker] = trial_log_likelihoods[k];
+                    }
+                  accepted[walker] = accepted_sample;
+                }
+            }
+
+          // Output the new positions of the walkers (which may of course
+          // be equal to the old positions) as one batch -- directly from
+          // the array of walkers, unless this is a last, partial
+          // generation.
+          generation_aux_data.clear ();
+          for (std::size_t walker = 0; walker < n_active_walkers; ++walker)
+            {
+              generation_aux_data.emplace_back (AuxiliaryData
+              {
+                {AuxiliaryData::relative_log_likelihood, std::any(log_likelihoods[walker])},
+                {AuxiliaryData::sample_is_repeated, std::any(!accepted[walker])},
+                {AuxiliaryData::chain_number, std::any(walker)}
+              });
+            }
+
+          if (n_active_walkers == n_walkers)
+            this->issue_batch (walkers, generation_aux_data);
+          else
+            this->issue_batch (std::vector<OutputType> (walkers.begin(),
+                                                        walkers.begin() + n_active_walkers),
+                               generation_aux_data);
+
+          n_issued += n_active_walkers;
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    AffineInvariantEnsemble<OutputType,RandomNumberGenerator>::
+    draw_stretch_factor ()
+    {
+      const double a = parameters.stretch_scale;
+      const double u = std::uniform_real_distribution<>(0,1)(rng);
+      return ((a-1)*u + 1) * ((a-1)*u + 1) / a;
+    }
+  }
+}
@@ -0,0 +1,437 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A class that produces samples from a file in the binary format
+     * described in the documentation of namespace ChainFileFormat, as
+     * written by Consumers::StreamOutput. This is useful to re-analyze
+     * chains that have been stored previously, for example to compute
+     * statistics that had not been computed while sampling.
+     *
+     * The class does not read the file into memory. Rather, the file is
+     * mapped into memory (using the POSIX `mmap()` function) and the
+     * operating system reads those parts of the file that are actually
+     * accessed. The samples can then be accessed directly and without
+     * copying via sample_data() and sample_vector(), and can be sent to
+     * consumers and filters via sample() and sample_in_parallel(). All of
+     * these functions provide random access to samples, i.e., one can
+     * start at an arbitrary sample or only use every $k$th sample without
+     * having to read the samples in between.
+     *
+     * Here is an example of how to use this class:
+     * @code
+     *   SampleFlow::Producers::ChainFile<Eigen::VectorXd> chain ("samples.bin");
+     *
+     *   SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXd> covariance;
+     *   covariance.connect_to_producer (chain);
+     *
+     *   // Skip the first 10,000 samples as burn-in, and then use every
+     *   // tenth sample:
+     *   chain.sample (10000, chain.n_samples(), 10);
+     * @endcode
+     *
+     * The samples sent downstream carry auxiliary data with the entries
+     * stored in the auxiliary data columns of the file, if any.
+     *
+     * @tparam OutputType The type of the samples this class produces. The
+     *   scalar type of this type (see types::ScalarType) needs to match the
+     *   type of the scalars stored in the file. If `OutputType` has a
+     *   `resize()` member function (as, for example, `std::vector` and
+     *   `Eigen::VectorXd` do), then samples are resized to the dimension
+     *   stored in the file; otherwise, its size needs to match this
+     *   dimension.
+     */
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    class ChainFile : public Producer<OutputType>
+    {
+      public:
+        /**
+         * The type of the scalars that make up a sample.
+         */
+        using scalar_type = types::ScalarType<OutputType>;
+
+        /**
+         * Constructor. Map the given file into memory and read its header.
+         *
+         * @param[in] filename The name of the file to read from.
+         */
+        ChainFile (const std::string &filename);
+
+        /**
+         * Copy constructor. Objects of this class cannot be copied.
+         */
+        ChainFile (const ChainFile &) = delete;
+
+        /**
+         * Destructor. Unmaps the file.
+         */
+        ~ChainFile ();
+
+        /**
+         * Return the information stored in the header of the file.
+         */
+        const ChainFileFormat::Header &
+        header () const;
+
+        /**
+         * Return the number of (complete) samples stored in the file at the
+         * time the object was created.
+         */
+        std::size_t
+        n_samples () const;
+
+        /**
+         * Return a view to the scalars that make up the sample with the given
+         * index. This view points into the memory the file has been mapped
+         * to and remains valid as long as the current object exists.
+         */
+        std::span<const scalar_type>
+        sample_data (const std::size_t index) const;
+
+        /**
+         * Like sample_data(), but return an `Eigen::Map` object that allows
+         * using the sample with the given index like an Eigen vector, without
+         * copying the data.
+         */
+        Eigen::Map<const Eigen::Matrix<scalar_type,Eigen::Dynamic,1>>
+        sample_vector (const std::size_t index) const;
+
+        /**
+         * Return the sample with the given index as an object of type
+         * `OutputType`.
+         */
+        OutputType
+        get_sample (const std::size_t index) const;
+
+        /**
+         * Return the auxiliary data stored for the sample with the given
+         * index.
+         */
+        AuxiliaryData
+        get_aux_data (const std::size_t index) const;
+
+        /**
+         * Send the samples with indices `begin`, `begin+stride`,
+         * `begin+2*stride`, ... up to (but excluding) `end` downstream,
+         * in batches of up to `max_batch_size` samples.
+         *
+         * @param[in] begin The index of the first sample to send downstream.
+         * @param[in] end The index one past the last sample to consider. If
+         *   larger than the number of samples in the file (as is the
+         *   default), then all samples up to the end of the file are
+         *   considered.
+         * @param[in] stride Only send every `stride`th sample downstream.
+         */
+        void
+        sample (const std::size_t begin = 0,
+                const std::size_t end = std::numeric_limits<std::size_t>::max(),
+                const std::size_t stride = 1);
+
+        /**
+         * Like sample(), but create the batches of samples on the threads
+         * of the given thread pool, in the same way as
+         * Producers::Range::sample_in_parallel() does. See there for the
+         * meaning of the `preserve_order` argument.
+         */
+        void
+        sample_in_parallel (const std::size_t begin = 0,
+                            const std::size_t end = std::numeric_limits<std::size_t>::max(),
+                            const std::size_t stride = 1,
+                            const bool preserve_order = false,
+                            const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * The maximal number of samples sent downstream as one batch.
+         */
+        static constexpr std::size_t max_batch_size = 1024;
+
+      private:
+        /**
+         * The beginning and size of the memory region the file has been
+         * mapped to.
+         */
+        const char  *mapped_data;
+        std::size_t  mapped_size;
+
+        /**
+         * The header of the file.
+         */
+        ChainFileFormat::Header file_header;
+
+        /**
+         * A pointer to the first record of the payload, and the number of
+         * samples stored in the file.
+         */
+        const char  *payload;
+        std::size_t  n_stored_samples;
+
+        /**
+         * Create the batch of samples with the given number, when sending
+         * every `stride`th sample starting at `begin` downstream.
+         */
+        std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>>
+        create_batch (const std::size_t batch,
+                      const std::size_t begin,
+                      const std::size_t end,
+                      const std::size_t stride) const;
+    };
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    ChainFile<OutputType>::
+    ChainFile (const std::string &filename)
+      :
+      mapped_data (nullptr),
+      mapped_size (0),
+      payload (nullptr),
+      n_stored_samples (0)
+    {
+      const int fd = open (filename.c_str(), O_RDONLY);
+      assert (fd >= 0);
+
+      struct stat file_status;
+      const int ierr = fstat (fd, &file_status);
+      assert (ierr == 0);
+      (void)ierr;
+      mapped_size = file_status.st_size;
+
+      void *const address = mmap (nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      assert (address != MAP_FAILED);
+      mapped_data = static_cast<const char *>(address);
+
+      // The mapping remains valid after the file descriptor is closed:
+      close (fd);
+
+      std::span<const char> buffer (mapped_data, mapped_size);
+      file_header = ChainFileFormat::read_header (buffer);
+      assert (file_header.scalar_kind == ChainFileFormat::scalar_kind<scalar_type>());
+      assert (file_header.scalar_size == sizeof(scalar_type));
+
+      payload = buffer.data();
+      n_stored_samples = (file_header.record_size() > 0
+                          ?
+                          buffer.size() / file_header.record_size()
+                          :
+                          0);
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    ChainFile<OutputType>::
+    ~ChainFile ()
+    {
+      munmap (const_cast<char *>(mapped_data), mapped_size);
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    const ChainFileFormat::Header &
+    ChainFile<OutputType>::
+    header () const
+    {
+      return file_header;
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    std::size_t
+    ChainFile<OutputType>::
+    n_samples () const
+    {
+      return n_stored_samples;
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    std::span<const typename ChainFile<OutputType>::scalar_type>
+    ChainFile<OutputType>::
+    sample_data (const std::size_t index) const
+    {
+      assert (index < n_stored_samples);
+      return {reinterpret_cast<const scalar_type *>(payload + index * file_header.record_size()),
+              static_cast<std::size_t>(file_header.dimension)};
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    Eigen::Map<const Eigen::Matrix<typename ChainFile<OutputType>::scalar_type,Eigen::Dynamic,1>>
+    ChainFile<OutputType>::
+    sample_vector (const std::size_t index) const
+    {
+      const std::span<const scalar_type> data = sample_data (index);
+      return {data.data(), static_cast<Eigen::Index>(data.size())};
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    OutputType
+    ChainFile<OutputType>::
+    get_sample (const std::size_t index) const
+    {
+      const std::span<const scalar_type> data = sample_data (index);
+
+      // Resize the sample to the dimension stored in the file if the
+      // sample type allows this; otherwise it needs to already have the
+      // right size:
+      OutputType sample;
+      if constexpr (requires (OutputType &s) { s.resize (std::size_t()); })
+        sample.resize (data.size());
+      assert (static_cast<std::size_t>(Utilities::size(sample)) == data.size());
+
+      for (std::size_t i=0; i<data.size(); ++i)
+        Utilities::get_nth_element (sample, i) = data[i];
+
+      return sample;
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    AuxiliaryData
+    ChainFile<OutputType>::
+    get_aux_data (const std::size_t index) const
+    {
+      assert (index < n_stored_samples);
+
+      AuxiliaryData aux_data;
+      const char *column_data = payload + index * file_header.record_size()
+                                + file_header.dimension * file_header.scalar_size;
+      for (const ChainFileFormat::Column &column : file_header.columns)
+        {
+          aux_data[column.key] = ChainFileFormat::read_column (column_data, column.type);
+          column_data += 8;
+        }
+
+      return aux_data;
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>>
+    ChainFile<OutputType>::
+    create_batch (const std::size_t batch,
+                  const std::size_t begin,
+                  const std::size_t end,
+                  const std::size_t stride) const
+    {
+      const std::size_t first = begin + batch * max_batch_size * stride;
+
+      std::pair<std::vector<OutputType>,std::vector<AuxiliaryData>> result;
+      result.first.reserve (max_batch_size);
+      result.second.reserve (max_batch_size);
+      for (std::size_t i=first;
+           (i < end) && (result.first.size() < max_batch_size);
+           i += stride)
+        {
+          result.first.emplace_back (get_sample (i));
+          result.second.emplace_back (get_aux_data (i));
+        }
+
+      return result;
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    void
+    ChainFile<OutputType>::
+    sample (const std::size_t begin,
+            const std::size_t end,
+            const std::size_t stride)
+    {
+      assert (stride >= 1);
+
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const std::size_t last = std::min (end, n_stored_samples);
+      if (begin >= last)
+        return;
+
+      const std::size_t n_selected = (last - begin + stride - 1) / stride;
+      const std::size_t n_batches  = (n_selected + max_batch_size - 1) / max_batch_size;
+      for (std::size_t batch=0; batch<n_batches; ++batch)
+        {
+          const auto [samples, aux_data] = create_batch (batch, begin, last, stride);
+          this->issue_batch (samples, aux_data);
+
+          if (this->stop_requested())
+            return;
+        }
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    void
+    ChainFile<OutputType>::
+    sample_in_parallel (const std::size_t begin,
+                        const std::size_t end,
+                        const std::size_t stride,
+                        const bool preserve_order,
+                        const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      assert (stride >= 1);
+      assert (thread_pool != nullptr);
+
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const std::size_t last = std::min (end, n_stored_samples);
+      if (begin >= last)
+        return;
+
+      const std::size_t n_selected = (last - begin + stride - 1) / stride;
+      const std::size_t n_batches  = (n_selected + max_batch_size - 1) / max_batch_size;
+      this->issue_batches_in_parallel (n_batches,
+                                       [&](const std::size_t batch)
+      {
+        return create_batch (batch, begin, last, stride);
+      },
+      preserve_order,
+      *thread_pool);
+    }
+  }
+}
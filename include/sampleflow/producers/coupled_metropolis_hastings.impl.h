@@ -0,0 +1,644 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the unbiased Markov chain Monte Carlo method of
+     * P. E. Jacob, J. O'Leary, Y. F. Atchadé: "Unbiased Markov chain Monte
+     * Carlo methods with couplings", Journal of the Royal Statistical
+     * Society B, vol. 82, pp. 543-600, 2020.
+     *
+     * Estimates of expected values $E_\pi[h(x)]$ computed from a
+     * Metropolis-Hastings chain (see the MetropolisHastings class) are
+     * biased because the chain starts somewhere other than in the target
+     * distribution $\pi$, and the usual remedy is to discard a "burn-in"
+     * phase at the start of the chain. Running $P$ chains in parallel does
+     * not help with this: Each of them has to go through its own burn-in,
+     * and so the time to solution cannot drop below the burn-in time
+     * however many processors one has.
+     *
+     * This class instead runs two Metropolis-Hastings chains $X_t$ and
+     * $Y_t$ with the same transition kernel that are "coupled": Their
+     * trial samples are drawn from a maximal coupling of the two proposal
+     * distributions $q(X_t,\cdot)$ and $q(Y_{t-1},\cdot)$ -- i.e., they are
+     * the same sample with the largest probability possible -- and the
+     * two chains use the same uniform random number to decide whether to
+     * accept them. Each chain on its own is an ordinary
+     * Metropolis-Hastings chain, but the chain $Y$ lags one step behind $X$,
+     * and once $X_\tau=Y_{\tau-1}$ at the "meeting time" $\tau$, the two
+     * chains stay together forever. Then, for integers $0\le k\le m$,
+     * @f{align*}{
+     *   H_{k:m}
+     *   = \frac{1}{m-k+1} \sum_{t=k}^m h(X_t)
+     *   + \sum_{t=k+1}^{\tau-1}
+     *     \min\left\{1,\frac{t-k}{m-k+1}\right\}
+     *     \left(h(X_t)-h(Y_{t-1})\right)
+     * @f}
+     * is an unbiased estimator of $E_\pi[h(x)]$: The first term is the
+     * usual average over the samples $k,\ldots,m$ of the chain $X$ (with
+     * the first $k$ samples discarded as burn-in), and the second one
+     * corrects for its bias. Each pair of chains only needs to run for
+     * $\max\{m,\tau\}$ steps, and since the estimators computed by
+     * independent pairs are independent, any number of them can be
+     * computed in parallel; their average is again unbiased, and its
+     * variance decreases as the inverse of the number of pairs. The
+     * parameters $k$ and $m$ trade the cost of each pair for the variance
+     * of its estimator; the paper suggests choosing $k$ as a large quantile
+     * of the meeting times (which can be estimated from a few pairs with
+     * $k=m=0$) and $m$ as a small multiple of $k$.
+     *
+     * The sample() function runs a given number of such pairs of chains
+     * ("runs") as tasks on a ThreadPool and sends the estimator $H_{k:m}$ of
+     * each run downstream as a sample of type `OutputType`. The
+     * individual samples of the chains are not sent anywhere. The samples
+     * that are sent are therefore not samples of $\pi$, but independent,
+     * identically distributed, unbiased estimates of $E_\pi[h(x)]$:
+     * Connecting a Consumers::MeanValue object to this producer computes
+     * their average, and since the estimates are independent, the
+     * variance of this average is estimated by the (co)variance computed by
+     * Consumers::CovarianceMatrix divided by the number of runs. Because
+     * the consumers of this library can be merged, the runs can also be
+     * distributed over many processes (see Parameters::first_run_number),
+     * each of which computes the average of its own runs, and the results
+     * can be combined afterwards.
+     *
+     * The AuxiliaryData object sent along with each estimate stores the
+     * number of the run under the key AuxiliaryData::chain_number, as an
+     * object of type `std::size_t`, and the meeting time $\tau$ under the
+     * key AuxiliaryData::meeting_time, as an object of type
+     * `types::sample_index`.
+     *
+     * Maximal couplings are implemented by rejection sampling, following
+     * Algorithm 2 of the paper above. This requires not only a function
+     * that draws trial samples, but also one that evaluates the
+     * (logarithm of the) density of the proposal distribution, up to a
+     * constant that must be the same for all arguments. For a Gaussian
+     * random walk, the class Proposals::GaussianRandomWalk provides both;
+     * its function call operator and its `log_density()` member function
+     * can be wrapped into the function objects sample() expects. The
+     * expected number of proposals per step is at most two for each of
+     * the two chains.
+     *
+     * @tparam SampleType The type of the samples of the chains.
+     * @tparam OutputType The type of the values of the function $h$, and
+     *   consequently of the estimates this class produces. It needs to be
+     *   a vector space type (see Concepts::is_vector_space_type). By
+     *   default, this is the same as `SampleType`, and the class then
+     *   estimates the mean value of $\pi$ unless a different function $h$
+     *   is provided.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used. Each run uses its own generator, created by
+     *   Random::create_stream() from Parameters::random_seed and the number
+     *   of the run, so that the estimate of each run does not depend on
+     *   the order in which runs are processed or on which thread.
+     */
+    template <typename SampleType,
+              typename OutputType = SampleType,
+              typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class CoupledMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed from which the random number generators of the
+           * individual runs are created.
+           */
+          std::uint64_t random_seed = 0;
+
+          /**
+           * The number $k$ of the first sample of the chain $X$ that
+           * contributes to the average in the estimator $H_{k:m}$.
+           */
+          types::sample_index first_averaged_step = 0;
+
+          /**
+           * The number $m$ of the last sample of the chain $X$ that
+           * contributes to the average in the estimator $H_{k:m}$. This
+           * number must not be smaller than first_averaged_step.
+           */
+          types::sample_index last_averaged_step = 0;
+
+          /**
+           * The largest number of steps a run may take. Runs whose chains
+           * have not met after this many steps (for example because one of
+           * them is stuck in a mode the other one does not find) are
+           * abandoned and do not produce an estimate; their number can be
+           * queried via n_abandoned_runs(). Abandoning runs biases the
+           * average of the remaining ones, and so this limit should be
+           * large enough that it is never reached in practice.
+           */
+          types::sample_index max_steps = std::numeric_limits<types::sample_index>::max();
+
+          /**
+           * The number given to the first run started by sample(). The
+           * runs started by one call of sample() are numbered
+           * consecutively from there. The number of a run determines its
+           * random number generator, and so several processes that
+           * compute estimates for the same problem need to use disjoint
+           * ranges of run numbers; for example, process $p$ that runs $n$
+           * runs would set this number to $pn$.
+           */
+          std::size_t first_run_number = 0;
+        };
+
+        /**
+         * Constructor.
+         */
+        CoupledMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. It computes `n_runs`
+         * independent estimates $H_{k:m}$ of $E_\pi[h(x)]$, each by a pair
+         * of coupled chains, and passes them through the signal of the base
+         * class to Consumer objects.
+         *
+         * @param[in] draw_starting_point A function object that, given a
+         *   random number generator, returns a sample drawn from the
+         *   distribution from which the chains start. The two chains of a
+         *   run start at two independent draws. The function may also
+         *   simply return a fixed sample.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$ up to a constant.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample drawn from the proposal distribution $q(x,\cdot)$. It
+         *   should use the generator it is given, rather than a global or
+         *   `static` one, for all of its random draws.
+         * @param[in] log_proposal_density A function object that, when
+         *   given samples $x$ and $\tilde x$, returns
+         *   $\log(q(x,\tilde x))$, up to a constant that is the same for
+         *   all arguments.
+         * @param[in] test_function The function $h$ whose expected value is
+         *   to be estimated.
+         * @param[in] n_runs The number of runs, i.e., of pairs of chains.
+         *   This is also the number of times the signal is called that
+         *   notifies Consumer objects that a new sample is available,
+         *   unless runs are abandoned (see Parameters::max_steps).
+         * @param[in] thread_pool The pool on which the runs are executed,
+         *   each as a separate task. By default, this is the pool returned
+         *   by ThreadPool::default_pool(). All of the function object
+         *   arguments are called concurrently from the threads of this
+         *   pool, and so need to be reentrant.
+         */
+        void
+        sample (const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+                const std::function<double (const SampleType &)> &log_likelihood,
+                const std::function<SampleType (const SampleType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<double (const SampleType &, const SampleType &)> &log_proposal_density,
+                const std::function<OutputType (const SampleType &)> &test_function,
+                const std::size_t n_runs,
+                const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * Like the previous function, but for the case that
+         * `OutputType` equals `SampleType` and $h(x)=x$, i.e., for
+         * estimating the mean value of the target distribution.
+         */
+        void
+        sample (const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+                const std::function<double (const SampleType &)> &log_likelihood,
+                const std::function<SampleType (const SampleType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<double (const SampleType &, const SampleType &)> &log_proposal_density,
+                const std::size_t n_runs,
+                const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool())
+        requires (std::is_same_v<SampleType,OutputType>);
+
+        /**
+         * Return the number of runs that have been abandoned by previous
+         * calls to sample() because their chains had not met after
+         * Parameters::max_steps steps.
+         */
+        std::size_t
+        n_abandoned_runs () const;
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The number of runs abandoned so far.
+         */
+        std::atomic<std::size_t> n_abandoned;
+
+        /**
+         * The functions the sampler is given, bundled into one object that
+         * the functions below can be passed.
+         */
+        struct Problem
+        {
+          const std::function<double (const SampleType &)>                            &log_likelihood;
+          const std::function<SampleType (const SampleType &, RandomNumberGenerator &)> &propose_sample;
+          const std::function<double (const SampleType &, const SampleType &)>        &log_proposal_density;
+        };
+
+        /**
+         * Compute the estimate of one run with the given number, and send
+         * it downstream unless the run is abandoned.
+         */
+        void
+        run (const std::size_t run_number,
+             const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+             const Problem &problem,
+             const std::function<OutputType (const SampleType &)> &test_function);
+
+        /**
+         * Do one Metropolis-Hastings step of a single chain with current
+         * sample `x` and its log likelihood `log_likelihood_x`.
+         */
+        static
+        void
+        step (SampleType            &x,
+              double                &log_likelihood_x,
+              const Problem         &problem,
+              RandomNumberGenerator &rng);
+
+        /**
+         * Do one step of the two coupled chains with current samples `x`
+         * and `y` and their log likelihoods, and return whether the two
+         * chains have the same sample afterwards because they have
+         * accepted the same trial sample.
+         */
+        static
+        bool
+        coupled_step (SampleType            &x,
+                      double                &log_likelihood_x,
+                      SampleType            &y,
+                      double                &log_likelihood_y,
+                      const Problem         &problem,
+                      RandomNumberGenerator &rng);
+
+        /**
+         * Return whether a trial sample proposed from the current sample
+         * `x` is accepted, given the log likelihoods of the two samples,
+         * the log proposal densities for going from one to the other and
+         * back, and a uniformly distributed random number.
+         */
+        static
+        bool
+        accept (const double log_likelihood_x,
+                const double log_likelihood_trial,
+                const double log_forward_density,
+                const double log_backward_density,
+                const double uniform);
+    };
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    CoupledMetropolisHastings (const Parameters &parameters)
+      : parameters (parameters),
+        n_abandoned (0)
+    {
+      assert (parameters.first_averaged_step <= parameters.last_averaged_step);
+      assert (parameters.max_steps > parameters.last_averaged_step);
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    sample (const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+            const std::function<double (const SampleType &)> &log_likelihood,
+            const std::function<SampleType (const SampleType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<double (const SampleType &, const SampleType &)> &log_proposal_density,
+            const std::function<OutputType (const SampleType &)> &test_function,
+            const std::size_t n_runs,
+            const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      assert (thread_pool != nullptr);
+
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const Problem problem {log_likelihood, propose_sample, log_proposal_density};
+
+      // Start one task per run. The meeting times of runs vary widely,
+      // and so having many small tasks balances the load among the
+      // threads of the pool better than splitting the runs into one
+      // chunk per thread would.
+      ThreadPool::TaskGroup runs;
+      for (std::size_t r=0; r<n_runs; ++r)
+        runs.run (*thread_pool,
+                  [&, r]()
+      {
+        if (this->stop_requested() == false)
+          run (parameters.first_run_number + r,
+               draw_starting_point,
+               problem,
+               test_function);
+      });
+
+      // Wait for all runs to finish before we flush the consumers
+      // and return:
+      runs.wait();
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    sample (const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+            const std::function<double (const SampleType &)> &log_likelihood,
+            const std::function<SampleType (const SampleType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<double (const SampleType &, const SampleType &)> &log_proposal_density,
+            const std::size_t n_runs,
+            const std::shared_ptr<ThreadPool> &thread_pool)
+    requires (std::is_same_v<SampleType,OutputType>)
+    {
+      sample (draw_starting_point,
+              log_likelihood,
+              propose_sample,
+              log_proposal_density,
+              [](const SampleType &x)
+      {
+        return x;
+      },
+      n_runs,
+      thread_pool);
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::size_t
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    n_abandoned_runs () const
+    {
+      return n_abandoned.load();
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    run (const std::size_t run_number,
+         const std::function<SampleType (RandomNumberGenerator &)> &draw_starting_point,
+         const Problem &problem,
+         const std::function<OutputType (const SampleType &)> &test_function)
+    {
+      const types::sample_index k = parameters.first_averaged_step;
+      const types::sample_index m = parameters.last_averaged_step;
+      const double n_averaged = m - k + 1;
+
+      RandomNumberGenerator rng
+        = Random::create_stream<RandomNumberGenerator> (parameters.random_seed, run_number);
+
+      // Start the two chains, and let X take its first step so that it is
+      // one step ahead of Y. In the following, x is X_t and y is Y_{t-1}:
+      SampleType x = draw_starting_point (rng);
+      SampleType y = draw_starting_point (rng);
+      double log_likelihood_x = problem.log_likelihood (x);
+      double log_likelihood_y = problem.log_likelihood (y);
+
+      std::optional<OutputType> average;
+      std::optional<OutputType> bias_correction;
+      if (k == 0)
+        average = test_function (x);
+
+      step (x, log_likelihood_x, problem, rng);
+
+      // Then run the chains until they have met and X has taken m steps.
+      // We do not compare x and y to find out whether the chains have met
+      // (SampleType may not even have an equality operator), but instead
+      // consider them as having met once they accept the same trial
+      // sample. If they happen to arrive at the same sample in a different
+      // way (for example because both start at the same fixed sample and X
+      // rejects its first trial sample), then the maximal coupling
+      // proposes the same trial sample for both in the next step, and so
+      // we only notice one step late that they have met; but in that
+      // step, the term h(X_t)-h(Y_{t-1}) that we then add to the bias
+      // correction is zero.
+      bool met = false;
+      types::sample_index meeting_time = 0;
+      for (types::sample_index t=1; ; ++t)
+        {
+          if ((t >= k) && (t <= m))
+            {
+              if (average)
+                *average += test_function (x);
+              else
+                average = test_function (x);
+            }
+
+          if ((met == false) && (t > k))
+            {
+              OutputType difference = test_function (x);
+              difference -= test_function (y);
+              const double weight = std::min (1., (t - k) / n_averaged);
+              if (bias_correction)
+                *bias_correction += weight * difference;
+              else
+                bias_correction = weight * difference;
+            }
+
+          if (met && (t >= m))
+            break;
+
+          if (t == parameters.max_steps)
+            {
+              ++n_abandoned;
+              return;
+            }
+
+          if (met)
+            step (x, log_likelihood_x, problem, rng);
+          else if (coupled_step (x, log_likelihood_x, y, log_likelihood_y, problem, rng))
+            {
+              met = true;
+              meeting_time = t+1;
+            }
+        }
+
+      // Put the two terms of the estimator together and send it
+      // downstream:
+      assert (average);
+      OutputType estimate = std::move(*average);
+      estimate *= 1. / n_averaged;
+      if (bias_correction)
+        estimate += *bias_correction;
+
+      this->issue_sample (std::move(estimate),
+      {
+        {AuxiliaryData::chain_number, std::any(run_number)},
+        {AuxiliaryData::meeting_time, std::any(meeting_time)}
+      });
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    step (SampleType            &x,
+          double                &log_likelihood_x,
+          const Problem         &problem,
+          RandomNumberGenerator &rng)
+    {
+      SampleType trial_sample = problem.propose_sample (x, rng);
+      const double log_likelihood_trial = problem.log_likelihood (trial_sample);
+
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+      if (accept (log_likelihood_x,
+                  log_likelihood_trial,
+                  problem.log_proposal_density (x, trial_sample),
+                  problem.log_proposal_density (trial_sample, x),
+                  uniform_distribution(rng)))
+        {
+          x = std::move(trial_sample);
+          log_likelihood_x = log_likelihood_trial;
+        }
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    bool
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    coupled_step (SampleType            &x,
+                  double                &log_likelihood_x,
+                  SampleType            &y,
+                  double                &log_likelihood_y,
+                  const Problem         &problem,
+                  RandomNumberGenerator &rng)
+    {
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      // Draw a pair of trial samples from a maximal coupling of the
+      // proposal distributions p=q(x,.) and q=q(y,.): Draw the trial
+      // sample for x from p, and with probability min{1,q/p} at this
+      // sample also use it for y. Otherwise, draw the trial sample for y
+      // from q, but only accept draws at which p is smaller than q (with
+      // the appropriate probability), so that the overall distribution of
+      // the trial sample for y is q:
+      SampleType   trial_x = problem.propose_sample (x, rng);
+      const double log_forward_density_x = problem.log_proposal_density (x, trial_x);
+      const double log_forward_density_y_at_trial_x = problem.log_proposal_density (y, trial_x);
+
+      std::optional<SampleType> trial_y;
+      double log_forward_density_y;
+      if (std::log(uniform_distribution(rng)) + log_forward_density_x
+          <= log_forward_density_y_at_trial_x)
+        log_forward_density_y = log_forward_density_y_at_trial_x;
+      else
+        while (true)
+          {
+            SampleType   candidate = problem.propose_sample (y, rng);
+            const double log_density_y = problem.log_proposal_density (y, candidate);
+            if (std::log(uniform_distribution(rng)) + log_density_y
+                > problem.log_proposal_density (x, candidate))
+              {
+                trial_y = std::move(candidate);
+                log_forward_density_y = log_density_y;
+                break;
+              }
+          }
+
+      // Then accept or reject the trial samples using the same uniform
+      // random number for both chains. If the trial samples are the same,
+      // we only need to evaluate the likelihood once:
+      const double log_likelihood_trial_x = problem.log_likelihood (trial_x);
+      const double log_likelihood_trial_y = (trial_y ?
+                                             problem.log_likelihood (*trial_y) :
+                                             log_likelihood_trial_x);
+
+      const double uniform = uniform_distribution(rng);
+      const bool accept_x = accept (log_likelihood_x,
+                                    log_likelihood_trial_x,
+                                    log_forward_density_x,
+                                    problem.log_proposal_density (trial_x, x),
+                                    uniform);
+      const bool accept_y = accept (log_likelihood_y,
+                                    log_likelihood_trial_y,
+                                    log_forward_density_y,
+                                    problem.log_proposal_density ((trial_y ? *trial_y : trial_x), y),
+                                    uniform);
+
+      if (accept_y)
+        {
+          y = (trial_y ? std::move(*trial_y) : trial_x);
+          log_likelihood_y = log_likelihood_trial_y;
+        }
+      if (accept_x)
+        {
+          x = std::move(trial_x);
+          log_likelihood_x = log_likelihood_trial_x;
+        }
+
+      return (!trial_y && accept_x && accept_y);
+    }
+
+
+
+    template <typename SampleType, typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    bool
+    CoupledMetropolisHastings<SampleType,OutputType,RandomNumberGenerator>::
+    accept (const double log_likelihood_x,
+            const double log_likelihood_trial,
+            const double log_forward_density,
+            const double log_backward_density,
+            const double uniform)
+    {
+      // As in the MetropolisHastings class, samples with a log likelihood
+      // of -std::numeric_limits<double>::max() or minus infinity have zero
+      // probability and are never accepted:
+      if ((log_likelihood_trial == -std::numeric_limits<double>::max())
+          ||
+          (log_likelihood_trial == -std::numeric_limits<double>::infinity()))
+        return false;
+
+      return (std::log(uniform)
+              <= (log_likelihood_trial - log_likelihood_x
+                  + log_backward_density - log_forward_density));
+    }
+  }
+}
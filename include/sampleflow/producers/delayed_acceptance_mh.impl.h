@@ -0,0 +1,245 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the "delayed acceptance" variant of the
+     * Metropolis-Hastings algorithm (see @cite ChristenFox2005). If
+     * evaluating the likelihood $\pi(x)$ is expensive -- say, because it
+     * requires the solution of a partial differential equation -- but
+     * most trial samples are rejected, then most of the time spent in the
+     * sampler is spent on evaluations whose only outcome is that the chain
+     * stays where it is. If a cheap approximation $\pi^*(x)$ of the
+     * likelihood is available (a "surrogate", for example the likelihood
+     * computed with a coarse mesh, or a reduced order model), then one can
+     * avoid many of these evaluations by first testing the trial sample
+     * $\tilde x$ with the surrogate: The trial sample is passed on to the
+     * second stage with probability
+     * @f{align*}{
+     *   \alpha_1(x,\tilde x) = \min\left\{1,
+     *     \frac{\pi^*(\tilde x)}{\pi^*(x)}
+     *     \frac{\pi_\text{proposal}(x|\tilde x)}{\pi_\text{proposal}(\tilde x|x)}
+     *   \right\},
+     * @f}
+     * i.e., the usual Metropolis-Hastings criterion applied to the
+     * surrogate, and is rejected outright otherwise. Only if it passes this
+     * first stage is the expensive likelihood evaluated, and the trial
+     * sample is then accepted with probability
+     * @f{align*}{
+     *   \alpha_2(x,\tilde x) = \min\left\{1,
+     *     \frac{\pi(\tilde x)}{\pi(x)}
+     *     \frac{\pi^*(x)}{\pi^*(\tilde x)}
+     *   \right\}.
+     * @f}
+     * This second stage corrects for the error in the surrogate, and the
+     * resulting chain has $\pi(x)$ as its stationary distribution
+     * regardless of how good the surrogate is -- the quality of the
+     * surrogate only affects how many trial samples that would have been
+     * accepted are rejected in the first stage, and how many that are
+     * ultimately rejected make it to the second stage. The only requirement
+     * is that the surrogate be nonzero wherever $\pi(x)$ is nonzero.
+     *
+     * The AuxiliaryData object sent along with each sample stores the same
+     * entries as are described for the MetropolisHastings class (where
+     * AuxiliaryData::relative_log_likelihood is the logarithm of the
+     * exact likelihood $\pi(x)$, not the surrogate), and in addition an
+     * entry under the key AuxiliaryData::rejection_stage that indicates
+     * whether the trial sample was accepted (zero), rejected based on the
+     * surrogate (one), or rejected after evaluating the exact likelihood
+     * (two). The fraction of samples for which this entry equals one is the
+     * fraction of likelihood evaluations saved compared to the
+     * MetropolisHastings class.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used to decide whether trial samples are accepted. See the
+     *   documentation of the MetropolisHastings class for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class DelayedAcceptanceMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generators used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+        };
+
+        /**
+         * Constructor.
+         */
+        DelayedAcceptanceMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial sample $x_0$, it produces a sequence of samples $x_k$
+         * that are passed through the signal of the base class to
+         * Consumer objects.
+         *
+         * @param[in] starting_point The initial sample $x_0$.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$, i.e., the natural
+         *   logarithm of the (expensive) likelihood function evaluated at
+         *   the sample. See MetropolisHastings::sample() for how samples
+         *   with zero probability are treated.
+         * @param[in] surrogate_log_likelihood A function object that, when
+         *   called with a sample $x$, returns $\log(\pi^*(x))$, the
+         *   logarithm of the cheap approximation of the likelihood with
+         *   which trial samples are screened.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$, returns a trial sample $\tilde x$ and the ratio of
+         *   proposal probabilities, exactly as for
+         *   MetropolisHastings::sample().
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function. This is also the number of times the
+         *   signal is called that notifies Consumer objects that a new
+         *   sample is available.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<double (const OutputType &)> &surrogate_log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    DelayedAcceptanceMetropolisHastings<OutputType,RandomNumberGenerator>::
+    DelayedAcceptanceMetropolisHastings (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DelayedAcceptanceMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<double (const OutputType &)> &surrogate_log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      OutputType current_sample                   = starting_point;
+      double     current_log_likelihood           = log_likelihood (current_sample);
+      double     current_surrogate_log_likelihood = surrogate_log_likelihood (current_sample);
+
+      for (types::sample_index i=0; (i<n_samples) && (this->stop_requested() == false); ++i)
+        {
+          std::pair<OutputType,double> trial_sample_and_ratio = propose_sample (current_sample);
+          OutputType &trial_sample = trial_sample_and_ratio.first;
+          const double proposal_distribution_ratio = trial_sample_and_ratio.second;
+
+          // First stage: Screen the trial sample with the surrogate, using
+          // the same criterion as the MetropolisHastings class.
+          const double trial_surrogate_log_likelihood = surrogate_log_likelihood (trial_sample);
+
+          unsigned int rejection_stage = 0;
+          if (MetropolisHastings<OutputType,RandomNumberGenerator>::
+              accept_trial_sample (trial_surrogate_log_likelihood,
+                                   current_surrogate_log_likelihood,
+                                   proposal_distribution_ratio,
+                                   rng) == false)
+            rejection_stage = 1;
+          else
+            {
+              // Second stage: Evaluate the expensive likelihood, and correct
+              // for the error in the surrogate. If the current sample has
+              // zero probability according to the surrogate, then the first
+              // stage can never go back from the trial sample to the current
+              // one, and the correction factor is infinite; if both have
+              // zero probability, then the first stage was a random walk
+              // step and we do nothing to correct it.
+              const double trial_log_likelihood = log_likelihood (trial_sample);
+
+              bool accepted_sample;
+              if (internal::has_zero_probability (trial_log_likelihood))
+                accepted_sample = internal::has_zero_probability (current_log_likelihood);
+              else if (internal::has_zero_probability (current_log_likelihood)
+                       ||
+                       internal::has_zero_probability (current_surrogate_log_likelihood))
+                accepted_sample = true;
+              else
+                {
+                  const double log_acceptance_ratio
+                    = ((trial_log_likelihood - current_log_likelihood)
+                       -
+                       (trial_surrogate_log_likelihood - current_surrogate_log_likelihood));
+                  accepted_sample = ((log_acceptance_ratio >= 0)
+                                     ||
+                                     (std::exp(log_acceptance_ratio) >= uniform_distribution(rng)));
+                }
+
+              if (accepted_sample)
+                {
+                  current_sample                   = std::move(trial_sample);
+                  current_log_likelihood           = trial_log_likelihood;
+                  current_surrogate_log_likelihood = trial_surrogate_log_likelihood;
+                }
+              else
+                rejection_stage = 2;
+            }
+
+          // Output the new sample (which may be equal to the old sample).
+          this->issue_sample (current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(rejection_stage != 0)},
+            {AuxiliaryData::rejection_stage, std::any(rejection_stage)}
+          });
+        }
+    }
+  }
+}
@@ -17,11 +17,27 @@
 #ifndef SAMPLEFLOW_PRODUCERS_DELAYED_REJECTION_MH_H
 #define SAMPLEFLOW_PRODUCERS_DELAYED_REJECTION_MH_H
 
+#include <sampleflow/checkpointer.h>
+#include <sampleflow/instrumentation.h>
 #include <sampleflow/producer.h>
+#include <sampleflow/random.h>
+#include <sampleflow/sample_pool.h>
 #include <sampleflow/scope_exit.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/tracing.h>
 #include <sampleflow/types.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <memory>
+#include <span>
 #include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <cmath>
 
 // Import the implementation of the things for this header file:
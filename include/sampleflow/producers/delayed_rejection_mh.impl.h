@@ -1,4 +1,3 @@
-
 // ---------------------------------------------------------------------
 //
 // Copyright (C) 2020 by the SampleFlow authors.
@@ -27,8 +26,14 @@ namespace SampleFlow
      * different propose_sample function that accepts both the current sample and a vector
      * of rejected samples as arguments. These rejected samples can be used for a more
      * sophisticated perturbation strategy.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used to decide whether trial samples are accepted. See the
+     *   documentation of the MetropolisHastings class for more information.
      */
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     class DelayedRejectionMetropolisHastings : public Producer<OutputType>
     {
       public:
@@ -42,7 +47,121 @@ namespace SampleFlow
            * A random seed to be used to initialize the random number
            * generators used by the sampling algorithm.
            */
-          std::mt19937::result_type random_seed = {};
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The number of delayed rejection stages whose likelihoods are
+           * evaluated concurrently. If this number is one (the default),
+           * then the algorithm proceeds strictly sequentially: It proposes
+           * the trial sample of the first stage, evaluates its likelihood,
+           * and only if it is rejected proposes the trial sample of the
+           * second stage, and so on.
+           *
+           * If the number is larger than one, then the algorithm instead
+           * proposes the trial samples of that many stages at once --
+           * passing to the `propose_sample` function for each stage the
+           * trial samples of the previous stages as if they had been
+           * rejected -- and evaluates their likelihoods concurrently on the
+           * threads of `thread_pool`. It then decides for the stages in
+           * order whether to accept their trial sample, and discards the
+           * trial samples (and likelihoods) of the stages after the first
+           * one that was accepted. If likelihood evaluations are expensive
+           * and there are enough idle cores, the wall-clock time per step
+           * is then close to that of a single likelihood evaluation, at the
+           * cost of evaluating likelihoods that are not needed if an early
+           * stage accepts.
+           *
+           * Since the `propose_sample` function is called for stages that
+           * would otherwise not have been reached, the trial samples it
+           * proposes generally differ from the ones it proposes in the
+           * sequential algorithm if it draws from a random number
+           * generator, and so does the sequence of samples. The samples
+           * nonetheless follow the same distribution.
+           */
+          unsigned int n_concurrent_stages = 1;
+
+          /**
+           * The pool on which the likelihood evaluations are run if
+           * `n_concurrent_stages` is larger than one. If this is `nullptr`
+           * (the default), then the pool returned by
+           * ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+
+          /**
+           * An object that writes checkpoints of the state of the chain to a
+           * file. If this is set, then sample() and resume() write the
+           * state of the chain, in the form of a ChainState object
+           * converted to bytes using Serialization::write(), to a
+           * checkpoint every `checkpoint_interval` steps (unless
+           * `checkpoint_interval` is zero) and once more when sampling
+           * ends. Sampling can then later be continued from the checkpoint
+           * using the resume() function. See the Checkpointer class, and
+           * the documentation of MetropolisHastings for a discussion.
+           */
+          std::shared_ptr<Checkpointer> checkpointer;
+
+          /**
+           * The number of steps between two checkpoints. See `checkpointer`.
+           */
+          types::sample_index checkpoint_interval = 0;
+
+          /**
+           * Whether to measure how long each call of the likelihood
+           * function and of the `propose_sample` function takes. If this
+           * is set, the timings are accumulated in the statistics returned
+           * by get_sampler_statistics(), and each sample sent downstream
+           * carries entries with keys
+           * AuxiliaryData::likelihood_evaluation_time and
+           * AuxiliaryData::proposal_time that store the total times of
+           * the calls made in all delayed rejection stages of the step
+           * that produced it. If stages are evaluated concurrently (see
+           * `n_concurrent_stages`), this total is the sum of the times of
+           * the individual evaluations, rather than the wall-clock time
+           * that passed.
+           */
+          bool record_timings = false;
+        };
+
+        /**
+         * A structure that describes the state of the chain between two
+         * steps, i.e., everything that is needed to continue the chain in
+         * exactly the same way as if it had not been interrupted. This is
+         * what is stored in the checkpoints described in the documentation
+         * of Parameters::checkpointer.
+         */
+        struct ChainState
+        {
+          /**
+           * The sample the chain is currently at, and its log likelihood.
+           */
+          OutputType current_sample;
+          double     current_log_likelihood;
+
+          /**
+           * The random number generator used to decide whether trial
+           * samples are accepted.
+           */
+          RandomNumberGenerator rng;
+
+          /**
+           * The number of steps the chain has taken so far.
+           */
+          types::sample_index n_steps;
+
+          /**
+           * Append the binary representation of this object to the given
+           * buffer. See namespace Serialization.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          /**
+           * Read the object from the binary representation at the beginning
+           * of the given buffer. See namespace Serialization.
+           */
+          void
+          load (std::span<const char> &buffer);
         };
 
         /**
@@ -101,6 +220,9 @@ namespace SampleFlow
          *   and care has to be taken to compute the ratio with
          *   $\pi_\text{proposal}(x|\tilde x)$. The paper @cite trias2009delayed
          *   provides a nice introduction.
+         *   If Parameters::n_concurrent_stages is larger than one, then the
+         *   function object is also called for stages that turn out not to
+         *   be needed, see there.
          * @param[in] max_delays The maximum number of delayed rejection stages.
          *   if `max_delays==0`, then this class functions the same as a regular
          *   Metropolis-Hastings producer.
@@ -126,6 +248,92 @@ namespace SampleFlow
                 const unsigned int max_delays,
                 const types::sample_index n_samples);
 
+        /**
+         * Like the previous function, but for a `propose_sample` function
+         * object with the signature
+         * @code
+         *   double propose_sample (const OutputType &x,
+         *                          const std::vector<OutputType> &rejected_samples,
+         *                          OutputType &trial_sample);
+         * @endcode
+         * that writes the trial sample $\tilde x$ into its third argument
+         * rather than returning it, and returns the ratio of proposal
+         * probabilities (which, as for the previous function, is currently
+         * ignored). The objects passed as third argument are taken from a
+         * pool of objects that the current object keeps: Trial samples
+         * that are rejected, and current samples that are replaced by an
+         * accepted trial sample, are returned to this pool once the step
+         * is finished and are passed to `propose_sample` again in later
+         * steps. If `OutputType` is a type that stores its elements on the
+         * heap, such as `Eigen::VectorXd`, then the sampler therefore does
+         * not need to allocate memory in every step -- as long as
+         * `propose_sample` overwrites the elements of its third argument
+         * instead of assigning a new object to it.
+         *
+         * For the same sequence of random numbers drawn by
+         * `propose_sample`, this function produces the same samples as the
+         * previous one.
+         */
+        template <typename ProposeSample>
+        requires (std::is_invocable_r_v<double, const ProposeSample &,
+                  const OutputType &, const std::vector<OutputType> &, OutputType &>)
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const ProposeSample &propose_sample,
+                const unsigned int max_delays,
+                const types::sample_index n_samples);
+
+        /**
+         * Continue the chain whose state is stored in the given checkpoint,
+         * written by a previous call to sample() or resume(), until it has
+         * taken a total of `n_samples` steps. The chain continues in the
+         * same way as if it had not been interrupted, provided the
+         * `propose_sample` function does not draw from a random number
+         * generator whose state is not restored along with the chain.
+         *
+         * @param[in] checkpoint A checkpoint written because
+         *   Parameters::checkpointer was set, for example as read from a
+         *   file via Checkpointer::read().
+         * @param[in] log_likelihood See sample().
+         * @param[in] propose_sample See sample().
+         * @param[in] max_delays See sample().
+         * @param[in] n_samples The total number of steps the chain should
+         *   have taken once this function returns, including the ones taken
+         *   before the checkpoint was written.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, const std::vector<OutputType> &)> &propose_sample,
+                const unsigned int max_delays,
+                const types::sample_index n_samples);
+
+        /**
+         * Like the previous function, but for a `propose_sample` function
+         * object that writes the trial sample into its third argument. See
+         * the second sample() function for a description.
+         */
+        template <typename ProposeSample>
+        requires (std::is_invocable_r_v<double, const ProposeSample &,
+                  const OutputType &, const std::vector<OutputType> &, OutputType &>)
+        void
+        resume (const std::vector<char> &checkpoint,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const ProposeSample &propose_sample,
+                const unsigned int max_delays,
+                const types::sample_index n_samples);
+
+        /**
+         * Return how often the likelihood function and the function that
+         * proposes trial samples have been called so far, and how long
+         * these calls took. The statistics are only collected if
+         * Parameters::record_timings is set, and otherwise all counters
+         * of the returned object are zero.
+         */
+        Instrumentation::SamplerStatistics
+        get_sampler_statistics () const;
+
       private:
         /**
          * A variable that stores parameters controlling specific aspects of
@@ -136,142 +344,554 @@ namespace SampleFlow
         /**
          * The random number generator used by the sampler.
          */
-        std::mt19937 rng;
+        RandomNumberGenerator rng;
+
+        /**
+         * The timings collected if Parameters::record_timings is set.
+         */
+        ShardedAccumulator<Instrumentation::SamplerStatistics> sampler_statistics;
 
         /**
-         * Recursively compute the acceptance ratio given the previous sample and
-         * a vector of proposed samples (all but one that have already been rejected).
+         * Evaluate the log likelihood of the starting point of the chain,
+         * timing the call if Parameters::record_timings is set.
+         */
+        double
+        starting_point_log_likelihood (const OutputType &starting_point,
+                                       const std::function<double (const OutputType &)> &log_likelihood);
+
+        /**
+         * The objects that are passed as trial samples to a
+         * `propose_sample` function that writes its result into its
+         * third argument. See the second of the sample() functions.
+         */
+        SamplePool<OutputType> sample_pool;
+
+        /**
+         * Advance the chain with the given state until it has taken
+         * `n_samples` steps. This is the implementation of the sample() and
+         * resume() functions. `ProposeSample` is the type of a function
+         * object with either of the two signatures the sample() functions
+         * accept.
+         */
+        template <typename ProposeSample>
+        void
+        run_chain (ChainState &state,
+                   const std::function<double (const OutputType &)> &log_likelihood,
+                   const ProposeSample &propose_sample,
+                   const unsigned int max_delays,
+                   const types::sample_index n_samples);
+
+        /**
+         * Convert the given state of the chain into a checkpoint and hand it
+         * to Parameters::checkpointer.
+         */
+        void
+        write_checkpoint (const ChainState &state) const;
+
+        /**
+         * Compute the probability with which the delayed rejection algorithm
+         * accepts a move along a path of samples. The samples in question
+         * are the last accepted sample $z_0=x$ followed by the trial samples
+         * $z_1=y_1,\ldots,z_n=y_n$ of the delayed rejection stages so far,
+         * and the path is the one that starts at $z_a$ and proposes, in
+         * turn, the samples $z_{a\pm 1}, z_{a\pm 2}, \ldots, z_b$ that lie
+         * between $z_a$ and $z_b$ in this list (in either direction). The
+         * acceptance probability of the current stage is the one for the
+         * path from $z_0$ to $z_n$, but the formula for it (see
+         * @cite trias2009delayed) also contains the acceptance
+         * probabilities of all earlier stages as well as those of the
+         * reversed paths that start at $z_n$ and go back towards $z_0$, and
+         * these again contain the probabilities for shorter paths.
          *
-         * @param[in] x The previous accepted sample and its associated log likelihood.
-         * @param[in] y Vector of proposed samples and their corresponding log
-         *   likelihoods; all but the last element have already been rejected.
+         * All of these are paths between two elements of the list, and so
+         * this function stores the probabilities it has computed in the
+         * given table, indexed by the start and end point of the path, and
+         * takes them from there if they are needed again. Computing the
+         * acceptance probability of a delayed rejection stage is then
+         * only quadratic in the number of stages, rather than exponential,
+         * and re-uses everything that was computed for the earlier stages
+         * of the same step. Under the assumption of symmetric proposal
+         * distributions made by this class, the acceptance probabilities
+         * only depend on the likelihoods of the samples, and so the
+         * function does not need the samples themselves.
+         *
+         * @param[in] a The index of the start $z_a$ of the path.
+         * @param[in] b The index of the end $z_b$ of the path.
+         * @param[in] log_likelihoods The log likelihoods of the samples
+         *   $z_0,\ldots,z_n$.
+         * @param[in,out] acceptance_probabilities A table in which element
+         *   `[a][b]` is the acceptance probability of the path from $z_a$
+         *   to $z_b$ if it has already been computed, or a negative number
+         *   otherwise.
          */
+        static
         double
-        alpha_fn (const std::pair<OutputType,double> &x,
-                  const std::vector<std::pair<OutputType,double>> &y);
+        acceptance_probability (const std::size_t a,
+                                const std::size_t b,
+                                const std::vector<double> &log_likelihoods,
+                                std::vector<std::vector<double>> &acceptance_probabilities);
+
     };
 
 
 
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     double
-    DelayedRejectionMetropolisHastings<OutputType>::
-    alpha_fn (const std::pair<OutputType,double> &x,
-              const std::vector<std::pair<OutputType,double>> &y)
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    acceptance_probability (const std::size_t a,
+                            const std::size_t b,
+                            const std::vector<double> &log_likelihoods,
+                            std::vector<std::vector<double>> &acceptance_probabilities)
     {
-      // Define the current delay stage as the number of rejected samples
-      // (number of proposed samples minus 1)
-      const unsigned int num_rejected_samples = y.size() - 1;
-      // Get the current proposed sample from the list of all proposed samples
-      const auto yi = y[num_rejected_samples];
-
-      // Get the likelihood ratio of the previous sample to the current proposed sample
-      const double likelihood_ratio = std::exp(yi.second - x.second);
-
-      // In the case where no samples have been rejected yet, the acceptance ratio is calculated
-      // the same as regular MH; we assume that the proposal is symmetric, so the acceptance
-      // ratio is simply the likelihood ratio
-      if (num_rejected_samples == 0)
-        return likelihood_ratio;
-
-      // Otherwise, recursively compute acceptance ratio
-      double alpha = likelihood_ratio;
-      for (int j = 1; j <= num_rejected_samples; ++j)
+      assert (a != b);
+      assert (a < log_likelihoods.size());
+      assert (b < log_likelihoods.size());
+
+      if (acceptance_probabilities[a][b] >= 0)
+        return acceptance_probabilities[a][b];
+
+      // The path goes from z_a to z_b via the points z_{a+d}, z_{a+2d},
+      // ..., where d is either +1 or -1. If the path has k steps, then the
+      // acceptance probability is
+      //   min(1, pi(z_b)/pi(z_a)
+      //          * prod_{j=1}^{k-1} (1-alpha(z_b -> ... -> z_{b-jd}))
+      //                             / (1-alpha(z_a -> ... -> z_{a+jd})))
+      // where the terms in the denominator are the acceptance
+      // probabilities of the earlier stages along the path (all of which
+      // have rejected), and the terms in the numerator those of the
+      // earlier stages along the reversed path.
+      const std::size_t n_steps = (a < b ? b - a : a - b);
+      const auto point_on_path = [a, b](const std::size_t start, const std::size_t j)
+      {
+        return ((a < b) == (start == a) ? start + j : start - j);
+      };
+
+      double numerator   = 1;
+      double denominator = 1;
+      for (std::size_t j=1; j<n_steps; ++j)
         {
-          const std::vector<std::pair<OutputType,double>> num_yvec_rev(y.begin() + (num_rejected_samples - j),
-                                                                       y.begin() + num_rejected_samples);
-          const std::vector<std::pair<OutputType,double>> num_yvec(num_yvec_rev.rbegin(), num_yvec_rev.rend() + 1);
-          const std::vector<std::pair<OutputType,double>> den_yvec(y.begin(), y.begin() + j);
-          alpha *= (1 - alpha_fn(yi, num_yvec_rev)) /
-                   (1 - alpha_fn(x, den_yvec));
+          numerator   *= 1 - acceptance_probability (b, point_on_path (b, j),
+                                                     log_likelihoods, acceptance_probabilities);
+          denominator *= 1 - acceptance_probability (a, point_on_path (a, j),
+                                                     log_likelihoods, acceptance_probabilities);
         }
+
+      // If one of the earlier stages along the path would have accepted
+      // with certainty, then the path cannot be taken; only be careful not
+      // to divide zero by zero in that case.
+      double alpha;
+      if (numerator == 0)
+        alpha = 0;
+      else if (denominator == 0)
+        alpha = 1;
+      else
+        alpha = std::min (1.,
+                          std::exp(log_likelihoods[b] - log_likelihoods[a])
+                          * numerator / denominator);
+
+      acceptance_probabilities[a][b] = alpha;
       return alpha;
     }
 
 
 
-    template <typename OutputType>
-    DelayedRejectionMetropolisHastings<OutputType>::
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
     DelayedRejectionMetropolisHastings (const Parameters &parameters)
       : parameters (parameters)
     {
-      if (parameters.random_seed != std::mt19937::result_type {})
+      assert (parameters.n_concurrent_stages >= 1);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
         rng.seed (parameters.random_seed);
     }
 
 
 
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     void
-    DelayedRejectionMetropolisHastings<OutputType>::
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    ChainState::save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, current_sample);
+      Serialization::write (buffer, current_log_likelihood);
+      Serialization::write (buffer, rng);
+      Serialization::write (buffer, n_steps);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    ChainState::load (std::span<const char> &buffer)
+    {
+      Serialization::read (buffer, current_sample);
+      Serialization::read (buffer, current_log_likelihood);
+      Serialization::read (buffer, rng);
+      Serialization::read (buffer, n_steps);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
     sample (const OutputType &starting_point,
             const std::function<double (const OutputType &)> &log_likelihood,
             const std::function<std::pair<OutputType,double> (const OutputType &, const std::vector<OutputType> &)> &propose_sample,
             const unsigned int max_delays,
             const types::sample_index n_samples)
+    {
+      ChainState state {starting_point,
+                        starting_point_log_likelihood (starting_point, log_likelihood),
+                        rng, 0};
+      run_chain (state, log_likelihood, propose_sample, max_delays, n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename ProposeSample>
+    requires (std::is_invocable_r_v<double, const ProposeSample &,
+              const OutputType &, const std::vector<OutputType> &, OutputType &>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const ProposeSample &propose_sample,
+            const unsigned int max_delays,
+            const types::sample_index n_samples)
+    {
+      ChainState state {starting_point,
+                        starting_point_log_likelihood (starting_point, log_likelihood),
+                        rng, 0};
+      run_chain (state, log_likelihood, propose_sample, max_delays, n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, const std::vector<OutputType> &)> &propose_sample,
+            const unsigned int max_delays,
+            const types::sample_index n_samples)
+    {
+      std::span<const char> buffer (checkpoint);
+
+      ChainState state;
+      Serialization::read (buffer, state);
+      assert (buffer.empty());
+
+      run_chain (state, log_likelihood, propose_sample, max_delays, n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename ProposeSample>
+    requires (std::is_invocable_r_v<double, const ProposeSample &,
+              const OutputType &, const std::vector<OutputType> &, OutputType &>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const ProposeSample &propose_sample,
+            const unsigned int max_delays,
+            const types::sample_index n_samples)
+    {
+      std::span<const char> buffer (checkpoint);
+
+      ChainState state;
+      Serialization::read (buffer, state);
+      assert (buffer.empty());
+
+      run_chain (state, log_likelihood, propose_sample, max_delays, n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Instrumentation::SamplerStatistics
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    get_sampler_statistics () const
+    {
+      return sampler_statistics.merged();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    starting_point_log_likelihood (const OutputType &starting_point,
+                                   const std::function<double (const OutputType &)> &log_likelihood)
+    {
+      std::chrono::nanoseconds likelihood_evaluation_time {0};
+      const double value
+        = Instrumentation::timed_call (parameters.record_timings, likelihood_evaluation_time, [&]()
+      {
+        Tracing::Span span ("log_likelihood", "sampler", this);
+        return log_likelihood (starting_point);
+      });
+
+      if (parameters.record_timings)
+        sampler_statistics.update ([&](Instrumentation::SamplerStatistics &s)
+      {
+        s.likelihood_evaluations.add (likelihood_evaluation_time);
+      });
+
+      return value;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    write_checkpoint (const ChainState &state) const
+    {
+      assert (parameters.checkpointer != nullptr);
+
+      // Only instantiate the serialization functions for sample types
+      // they support. Everyone else cannot write checkpoints.
+      if constexpr (Serialization::is_serializable<OutputType>())
+        {
+          std::vector<char> checkpoint;
+          Serialization::write (checkpoint, state);
+          parameters.checkpointer->write (std::move(checkpoint));
+        }
+      else
+        {
+          (void)state;
+          assert (false);
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename ProposeSample>
+    void
+    DelayedRejectionMetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_chain (ChainState &state,
+               const std::function<double (const OutputType &)> &log_likelihood,
+               const ProposeSample &propose_sample,
+               const unsigned int max_delays,
+               const types::sample_index n_samples)
     {
       // Make sure the flush_consumers() function is called at any point
-      // where we exit the current function.
-      Utilities::ScopeExit scope_exit ([this]()
+      // where we exit the current function. This is also where we write
+      // the last checkpoint, and where we let the random number generator
+      // of the current object continue where the chain left off.
+      Utilities::ScopeExit scope_exit ([this, &state]()
       {
+        if (parameters.checkpointer != nullptr)
+          write_checkpoint (state);
+        rng = state.rng;
+
         this->flush_consumers();
+        this->clear_stop_request();
       });
 
       std::uniform_real_distribution<> uniform_distribution(0,1);
 
-      OutputType current_sample         = starting_point;
-      double     current_log_likelihood = log_likelihood (current_sample);
+      constexpr bool propose_in_place
+        = std::is_invocable_r_v<double, const ProposeSample &,
+          const OutputType &, const std::vector<OutputType> &, OutputType &>;
+
+      OutputType &current_sample         = state.current_sample;
+      double     &current_log_likelihood = state.current_log_likelihood;
+
+      // If we evaluate several stages concurrently, do so on the thread
+      // pool selected:
+      const std::shared_ptr<ThreadPool> thread_pool
+        = (parameters.n_concurrent_stages == 1
+           ?
+           nullptr
+           :
+           (parameters.thread_pool != nullptr
+            ?
+            parameters.thread_pool
+            :
+            ThreadPool::default_pool()));
 
-      // Loop over the desired number of samples
-      for (types::sample_index i=0; i<n_samples; ++i)
+      // Arrays that store, for the current step, the trial samples of the
+      // stages so far, which are all rejected (or, while we evaluate
+      // several stages concurrently, assumed to be rejected), and the log
+      // likelihoods of the current sample (as the first element) and of
+      // the trial samples, along with the table of acceptance
+      // probabilities of the paths between these samples that the
+      // acceptance_probability() function fills. We allocate them once
+      // and re-use them for all steps. If the trial samples are written
+      // into existing objects, then these objects come from (and go back
+      // to) the sample pool.
+      std::vector<OutputType>          rejected_samples;
+      std::vector<double>              log_likelihoods;
+      std::vector<std::vector<double>> acceptance_probabilities (max_delays+2,
+                                                                 std::vector<double>(max_delays+2));
+      rejected_samples.reserve (max_delays+1);
+      log_likelihoods.reserve (max_delays+2);
+
+      // If we record timings, we collect the ones of each step in a
+      // separate object (with one time per concurrently evaluated stage)
+      // and only add them to the statistics of the sampler at the end of
+      // the step:
+      const bool measure = parameters.record_timings;
+      Instrumentation::SamplerStatistics    step_statistics;
+      std::vector<std::chrono::nanoseconds> likelihood_evaluation_times (max_delays+1);
+
+      // Loop until we have the desired number of samples
+      while ((state.n_steps < n_samples) && (this->stop_requested() == false))
         {
-          // Initialize a vector to store rejected samples, along with their
-          // log likelihoods
-          std::vector<std::pair<OutputType,double>> proposed_samples;
+          rejected_samples.clear ();
+          log_likelihoods.clear ();
+          log_likelihoods.push_back (current_log_likelihood);
+          for (auto &row : acceptance_probabilities)
+            std::fill (row.begin(), row.end(), -1.);
+          if (measure)
+            step_statistics = Instrumentation::SamplerStatistics();
+
           // Initialize a bool to store whether a sample is accepted
           bool accepted_sample = false;
-          // Delayed rejection loop
-          for (unsigned int delay_stage = 0; delay_stage <= max_delays; ++delay_stage)
+          // Delayed rejection loop, processing Parameters::n_concurrent_stages
+          // stages at a time
+          for (unsigned int first_stage = 0;
+               (first_stage <= max_delays) && (accepted_sample == false);
+               first_stage += parameters.n_concurrent_stages)
             {
-              // Obtain a new proposed sample
-              // (the previously last accepted one, along with the rejected ones)
-              // and then evaluate its log likelihood.
+              const unsigned int n_stages
+                = std::min (parameters.n_concurrent_stages, max_delays + 1 - first_stage);
+
+              // Obtain new proposed samples for these stages (based on the
+              // previously last accepted one, along with the rejected ones).
               //
               // TODO: The current implementation discards the second part of the
               // information returned by the 'propose_sample' function. This is based on
               // the assumption that the proposal distributions used by 'propose_sample'
               // are symmetric, and that the second number equals 1.0. We should
               // generalize this.
-              std::vector<OutputType> proposed_samples_only (proposed_samples.size());
-              for (unsigned int i=0; i<proposed_samples.size(); ++i)
-                proposed_samples_only[i] = proposed_samples[i].first;
-              std::pair<OutputType,double> trial_sample_and_ratio = propose_sample(current_sample,
-                                                                                   proposed_samples_only);
-              const OutputType trial_sample = std::move(trial_sample_and_ratio.first);
-              const double trial_log_likelihood = log_likelihood(trial_sample);
-              proposed_samples.push_back({trial_sample, trial_log_likelihood});
-
-              const double acceptance_ratio = alpha_fn({current_sample, current_log_likelihood},
-                                                       proposed_samples);
-              if (acceptance_ratio > 1 || acceptance_ratio >= uniform_distribution(rng))
-                accepted_sample = true;
-              if (accepted_sample)
+              for (unsigned int stage = first_stage; stage < first_stage + n_stages; ++stage)
                 {
-                  current_sample         = trial_sample;
-                  current_log_likelihood = trial_log_likelihood;
-                  break;
+                  std::chrono::nanoseconds proposal_time {0};
+                  if constexpr (propose_in_place)
+                    {
+                      OutputType trial_sample = sample_pool.acquire (current_sample);
+                      Instrumentation::timed_call (measure, proposal_time, [&]()
+                      {
+                        return propose_sample (current_sample, rejected_samples, trial_sample);
+                      });
+                      rejected_samples.push_back (std::move(trial_sample));
+                    }
+                  else
+                    rejected_samples.push_back (Instrumentation::timed_call (measure, proposal_time, [&]()
+                    {
+                      return propose_sample(current_sample, rejected_samples);
+                    }).first);
+
+                  if (measure)
+                    step_statistics.proposals.add (proposal_time);
+                }
+
+              // Then evaluate their log likelihoods, either right here or
+              // concurrently on the thread pool:
+              log_likelihoods.resize (first_stage + n_stages + 1);
+              const auto evaluate_stage = [this, &log_likelihood, &rejected_samples, &log_likelihoods,
+                                                 &likelihood_evaluation_times, measure](const unsigned int stage)
+              {
+                log_likelihoods[stage+1]
+                  = Instrumentation::timed_call (measure, likelihood_evaluation_times[stage], [&]()
+                {
+                  Tracing::Span span ("log_likelihood", "sampler", this);
+                  return log_likelihood (rejected_samples[stage]);
+                });
+              };
+              if (n_stages == 1)
+                evaluate_stage (first_stage);
+              else
+                {
+                  ThreadPool::TaskGroup evaluations;
+                  for (unsigned int stage = first_stage; stage < first_stage + n_stages; ++stage)
+                    evaluations.run (*thread_pool, [&evaluate_stage, stage]()
+                  {
+                    evaluate_stage (stage);
+                  });
+                  evaluations.wait();
+                }
+              if (measure)
+                for (unsigned int stage = first_stage; stage < first_stage + n_stages; ++stage)
+                  step_statistics.likelihood_evaluations.add (likelihood_evaluation_times[stage]);
+
+              // Now go through the stages in order. For each, compute the
+              // acceptance probability for the path from the current
+              // sample via all rejected samples to the trial sample. If it
+              // is one, we need not draw a random number to know that we
+              // accept the trial sample.
+              for (unsigned int stage = first_stage; stage < first_stage + n_stages; ++stage)
+                {
+                  const double acceptance_ratio
+                    = acceptance_probability (0, stage+1,
+                                              log_likelihoods, acceptance_probabilities);
+                  if (acceptance_ratio == 1 || acceptance_ratio >= uniform_distribution(state.rng))
+                    {
+                      // Swap rather than move the trial sample into
+                      // place, so that the memory of the previous
+                      // current sample goes back to the pool with the
+                      // other trial samples:
+                      accepted_sample        = true;
+                      std::swap (current_sample, rejected_samples[stage]);
+                      current_log_likelihood = log_likelihoods[stage+1];
+                      break;
+                    }
                 }
             }
 
           // Output the new sample (which may be equal to the old sample).
-          this->issue_sample (current_sample,
+          AuxiliaryData aux_data
           {
-            {"relative log likelihood", std::any(current_log_likelihood)},
-            {"sample is repeated", std::any(!accepted_sample)}
-          });
-        }
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)}
+          };
+          if (measure)
+            {
+              sampler_statistics.update ([&](Instrumentation::SamplerStatistics &s)
+              {
+                s.merge (step_statistics);
+              });
+              aux_data[AuxiliaryData::proposal_time]
+                = std::chrono::duration<double>(step_statistics.proposals.total_time).count();
+              aux_data[AuxiliaryData::likelihood_evaluation_time]
+                = std::chrono::duration<double>(step_statistics.likelihood_evaluations.total_time).count();
+            }
+          this->issue_sample (current_sample, std::move(aux_data));
 
-      this->flush_consumers();
+          if constexpr (propose_in_place)
+            for (OutputType &sample : rejected_samples)
+              sample_pool.release (std::move(sample));
+
+          ++state.n_steps;
+          if ((parameters.checkpointer != nullptr)
+              &&
+              (parameters.checkpoint_interval > 0)
+              &&
+              (state.n_steps % parameters.checkpoint_interval == 0))
+            write_checkpoint (state);
+        }
     }
 
   }
@@ -17,13 +17,30 @@
 #ifndef SAMPLEFLOW_PRODUCERS_DIFFERENTIAL_EVALUATION_MH_H
 #define SAMPLEFLOW_PRODUCERS_DIFFERENTIAL_EVALUATION_MH_H
 
+#include <sampleflow/checkpointer.h>
+#include <sampleflow/instrumentation.h>
 #include <sampleflow/producer.h>
+#include <sampleflow/random.h>
+#include <sampleflow/ring_buffer.h>
+#include <sampleflow/sample_pool.h>
 #include <sampleflow/scope_exit.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/tracing.h>
 #include <sampleflow/types.h>
 
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <deque>
 #include <future>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <span>
+#include <vector>
 #include <cmath>
 
 // Import the implementation of the things for this header file:
@@ -27,11 +27,230 @@ namespace SampleFlow
      * This class provides the same functionality as Metropolis Hastings but does
      * so over $N$ chains simultaneously, which can improve the rate of convergence. The
      * number of chains $N$ is given as an argument to the sample() function.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used to select the chains that are crossed over and to decide whether
+     *   trial samples are accepted. See the documentation of the
+     *   MetropolisHastings class for more information.
      */
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     class DifferentialEvaluationMetropolisHastings : public Producer<OutputType>
     {
       public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * The maximal number of past states that are kept in an archive
+           * from which the samples entering a crossover are drawn. If this
+           * number is zero (the default), then no archive is kept and the
+           * crossover uses the current samples of two other chains, as in
+           * the original algorithm.
+           *
+           * If it is nonzero, the algorithm instead draws the two samples
+           * `sample_a` and `sample_b` passed to the crossover function from
+           * an archive of past states of all chains, in the style of the
+           * "DE-MCz" algorithm of ter Braak and Vrugt (2008) and the DREAM
+           * family of samplers. The archive is initialized with the
+           * starting points and then, every `archive_thinning` generations
+           * (or, for sample_asynchronously(), every `archive_thinning`
+           * steps of a chain), the current samples of the chains are
+           * added to it. The archive is a RingBuffer of the given size:
+           * Once it is full, newly added samples replace the oldest ones,
+           * so that the memory used is bounded and allocated only once.
+           *
+           * Because the archive represents the distribution sampled much
+           * better than the current states of a few chains, this allows
+           * running with far fewer chains (the DE-MCz paper uses three)
+           * than the original algorithm, which needs a number of chains
+           * that grows with the dimension of the problem. With an archive,
+           * the algorithm only needs two chains, rather than three.
+           *
+           * The archive should be large enough to represent the target
+           * distribution well, i.e., contain many more samples than the
+           * dimension of the problem. If it is too small compared to how
+           * often samples are added to it, it only holds recent, strongly
+           * correlated states; the original DE-MCz algorithm in fact never
+           * discards past states.
+           */
+          std::size_t archive_size = 0;
+
+          /**
+           * How often the current samples of the chains are added to the
+           * archive. See `archive_size`. This value is ignored if
+           * `archive_size` is zero.
+           */
+          unsigned int archive_thinning = 10;
+
+          /**
+           * An object that writes checkpoints of the state of the sampler to
+           * a file. If this is set, then the sample() and resume() functions
+           * write the state of all chains, in the form of a State object
+           * converted to bytes using Serialization::write(), to a
+           * checkpoint every `checkpoint_interval` generations (unless
+           * `checkpoint_interval` is zero) and once more when sampling
+           * ends. Sampling can then later be continued from the checkpoint
+           * using the resume() functions. See the Checkpointer class, and
+           * the documentation of MetropolisHastings for a discussion.
+           * sample_asynchronously() does not write checkpoints since the
+           * sequence of samples it produces is not reproducible anyway.
+           */
+          std::shared_ptr<Checkpointer> checkpointer;
+
+          /**
+           * The number of generations between two checkpoints. See
+           * `checkpointer`.
+           */
+          types::sample_index checkpoint_interval = 0;
+
+          /**
+           * Whether to measure how long each evaluation of the likelihood
+           * and each proposal of a trial sample (including the crossover,
+           * if there is one) takes. If this is set, the timings are
+           * accumulated in the statistics returned by
+           * get_sampler_statistics(), and each sample sent downstream
+           * carries entries with keys
+           * AuxiliaryData::likelihood_evaluation_time and
+           * AuxiliaryData::proposal_time that store the times for the
+           * step that produced it. Since the sample() and resume()
+           * functions evaluate the likelihoods of a whole generation as
+           * one batch, each chain is attributed the time of the batch
+           * divided by the number of chains in it.
+           */
+          bool record_timings = false;
+
+          /**
+           * The pool on which the sample() and resume() functions whose
+           * `propose_sample` and `crossover` arguments take a random number
+           * generator create the trial samples of each generation, one
+           * task per chain. If this is `nullptr` (the default), then the
+           * pool returned by ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> proposal_thread_pool;
+
+          /**
+           * A function that the sample() and resume() functions call every
+           * `migration_interval` generations, once the samples of the
+           * generation have been sent downstream, with the current samples
+           * of all chains, their log likelihoods, and the random number
+           * generator `State::rng`. The function may replace the current
+           * samples of some of the chains (along with their log
+           * likelihoods) by other samples, which the chains then continue
+           * from.
+           *
+           * This is the "migration" step of population or "island model"
+           * algorithms, in which several populations of chains sample the
+           * same distribution independently and every so often exchange a
+           * few of their members -- see
+           * MPI::Producers::DifferentialEvaluationMetropolisHastings, which
+           * runs one population on each process of an MPI communicator and
+           * implements this function by exchanging samples with other
+           * processes. Once the populations have converged, the samples
+           * that migrate are draws from the target distribution
+           * themselves, and replacing the state of a chain by one of them
+           * does not change the distribution the chain samples; before
+           * that, migration helps populations that are stuck in a part of
+           * the parameter space find the others.
+           *
+           * If this object is empty (the default), or if
+           * `migration_interval` is zero, no migration takes place.
+           * sample_asynchronously() does not support migration.
+           */
+          std::function<void (std::vector<OutputType> &current_samples,
+                              std::vector<double> &current_log_likelihoods,
+                              RandomNumberGenerator &rng)> migrate;
+
+          /**
+           * The number of generations between two calls to `migrate`.
+           */
+          types::sample_index migration_interval = 0;
+
+          /**
+           * The number of consecutive steps of a chain that one task of
+           * sample_asynchronously() takes before it hands the chain back
+           * and enqueues the next task. The default, one, lets the next
+           * task pick up whichever chain has been idle the longest after
+           * every step, which balances the progress of the chains best if
+           * the cost of evaluating the likelihood varies a lot. Larger
+           * values save the overhead of one task and of handing the chain
+           * around per step, which matters if evaluating the likelihood
+           * is cheap. Each chain uses its own random number generator and
+           * takes its steps one after the other either way; which
+           * samples of other chains enter its crossovers depends on the
+           * timing of the steps of these chains, however. This parameter
+           * needs to be at least one, and is not used by the sample()
+           * and resume() functions.
+           */
+          types::sample_index grain_size = 1;
+        };
+
+        /**
+         * A structure that describes the state of the sampler between two
+         * generations, i.e., everything that is needed to continue the
+         * chains in exactly the same way as if they had not been
+         * interrupted. This is what is stored in the checkpoints described
+         * in the documentation of Parameters::checkpointer.
+         */
+        struct State
+        {
+          /**
+           * The samples the chains are currently at, and their log
+           * likelihoods.
+           */
+          std::vector<OutputType> current_samples;
+          std::vector<double>     current_log_likelihoods;
+
+          /**
+           * The random number generator used to select the samples that
+           * enter crossovers and to decide whether trial samples are
+           * accepted.
+           */
+          RandomNumberGenerator rng;
+
+          /**
+           * If the sampler was started by one of the sample() functions that
+           * create trial samples concurrently, the random number generators
+           * of the individual chains, which are then used instead of `rng`.
+           * Otherwise, this array is empty.
+           */
+          std::vector<RandomNumberGenerator> chain_rngs;
+
+          /**
+           * The number of generations completed so far.
+           */
+          types::sample_index generation;
+
+          /**
+           * If Parameters::archive_size is nonzero, the samples in the
+           * archive, from oldest to most recent.
+           */
+          std::vector<OutputType> archive;
+
+          /**
+           * Append the binary representation of this object to the given
+           * buffer. See namespace Serialization.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          /**
+           * Read the object from the binary representation at the beginning
+           * of the given buffer. See namespace Serialization.
+           */
+          void
+          load (std::span<const char> &buffer);
+        };
+
+        /**
+         * Constructor.
+         */
+        DifferentialEvaluationMetropolisHastings (const Parameters &parameters = {});
+
         /**
          * The principal function of this class. Starting from the given
          * initial samples $x_{i, 0}$, it produces a multiple chains of
@@ -43,7 +262,8 @@ namespace SampleFlow
          *   how many chains this algorithm will run.
          *   The algorithm needs to have at least three chains to make
          *   sense, and so the list of starting points must have at least
-         *   3 elements.
+         *   3 elements -- or 2 if crossovers draw from an archive of past
+         *   states, see Parameters::archive_size.
          * @param[in] log_likelihood A function object that, when called
          *   with a sample $x$, returns $\log(\pi(x))$, i.e., the natural
          *   logarithm of the likelihood function evaluated at the sample.
@@ -123,13 +343,16 @@ namespace SampleFlow
          *   as argument.
          *
          * @note When `asynchronous_likelihood_execution` is set to `true`, the
-         *   function evaluates the likelihoods for the current sample on all
-         *   chains in parallel by calling `std::async` with `std::launch::async`
-         *   as first argument. This may mean that the function evaluations are
-         *   run on separate threads, though the C++ standard does not actually
-         *   require this; in any case, you may therefore want to limit the number
-         *   of chains to at most a small multiple of the number of processor
-         *   cores available on the machine.
+         *   function evaluates the likelihoods of the trial samples of all
+         *   chains of a generation as tasks on the pool returned by
+         *   ThreadPool::default_pool(), and waits for all of them before
+         *   starting the next generation. The worker threads of the pool are
+         *   long-lived, so this does not create any threads; but it does mean
+         *   that if the likelihood takes much longer to evaluate for some
+         *   samples than for others, then the threads that have finished
+         *   their evaluations sit idle until the slowest evaluation of the
+         *   generation is done. See sample_asynchronously() for a variant of
+         *   the algorithm that does not have this problem.
          */
         void
         sample (const std::vector<OutputType> &starting_points,
@@ -139,13 +362,516 @@ namespace SampleFlow
                 const unsigned int crossover_gap,
                 const types::sample_index n_samples,
                 const bool asynchronous_likelihood_execution = true,
-                const std::mt19937::result_type random_seed = {});
+                const typename RandomNumberGenerator::result_type random_seed = {});
+
+        /**
+         * Like the previous function, but using a function object that only
+         * starts the evaluation of the log likelihood for a sample, and
+         * returns a `std::future` object from which the result can be
+         * obtained later. This function starts the evaluations for the trial
+         * samples of all chains of a generation before it waits for any of
+         * the results, so that as many evaluations can be in flight at
+         * the same time as there are chains -- for example, on a remote
+         * machine -- without using more than the current thread for it.
+         *
+         * The previous function with `asynchronous_likelihood_execution` set
+         * to `true` is equivalent to calling this function with a function
+         * object that evaluates the likelihood via `std::async`. For the same
+         * arguments and random seed, this function produces the same
+         * sequence of samples as the previous function.
+         *
+         * @param[in] starting_points See the previous function.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sample $x$, returns a future for $\log(\pi(x))$. See
+         *   types::AsynchronousLogLikelihood.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] crossover See the previous function.
+         * @param[in] crossover_gap See the previous function.
+         * @param[in] n_samples See the previous function.
+         * @param[in] random_seed See the previous function.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const typename RandomNumberGenerator::result_type random_seed = {});
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once.
+         * This function passes the trial samples of all chains of a
+         * generation to this function object in one call (and, at the
+         * beginning, all starting points), and is therefore the appropriate
+         * choice if the likelihood can be evaluated much more efficiently
+         * for many samples at once than for one sample at a time. Whether
+         * and how the evaluation of the batch is parallelized is up to the
+         * function object.
+         *
+         * For the same arguments and random seed, this function produces
+         * the same sequence of samples as the previous function.
+         *
+         * @param[in] starting_points The initial samples of $x_{i, 0}$
+         *   for each chain $i$. See the previous function.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sequence of samples $x_j$, writes $\log(\pi(x_j))$ into the
+         *   corresponding elements of its second argument. See
+         *   types::BatchLogLikelihood.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] crossover See the previous function.
+         * @param[in] crossover_gap See the previous function.
+         * @param[in] n_samples See the previous function.
+         * @param[in] random_seed See the previous function.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const typename RandomNumberGenerator::result_type random_seed = {});
+
+        /**
+         * Like the first sample() function, but with functions
+         * `propose_sample` and `crossover` that take the random number
+         * generator they should use as an additional last argument. Because
+         * these functions then do not need a generator of their own, the
+         * trial samples of the chains of a generation can be created
+         * concurrently: This function creates them as tasks on
+         * Parameters::proposal_thread_pool, one per chain, before it
+         * evaluates their likelihoods. This is useful if proposals or
+         * crossovers are expensive, for example because samples are large,
+         * since creating the trial samples is otherwise a sequential phase
+         * of every generation.
+         *
+         * Each chain uses its own random number generator, namely the
+         * stream with the number of the chain that Random::create_stream()
+         * creates from `random_seed`, for the calls to `propose_sample` and
+         * `crossover`, for selecting the samples that enter its crossovers,
+         * and for deciding whether it accepts its trial samples. The
+         * sequence of samples is therefore reproducible for a given seed
+         * and does not depend on the number of threads -- but it differs
+         * from the one the previous functions produce for the same seed.
+         *
+         * @param[in] starting_points See the first sample() function.
+         * @param[in] log_likelihood See the first sample() function.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial sample
+         *   and the ratio of proposal probabilities as described for the
+         *   first sample() function. This function is called concurrently
+         *   for different chains, and must only draw random numbers from the
+         *   generator it is given.
+         * @param[in] crossover A function object that combines three samples
+         *   as described for the first sample() function, using the given
+         *   random number generator if it needs one. This function is also
+         *   called concurrently.
+         * @param[in] crossover_gap See the first sample() function.
+         * @param[in] n_samples See the first sample() function.
+         * @param[in] asynchronous_likelihood_execution See the first sample()
+         *   function.
+         * @param[in] random_seed See the first sample() function.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const bool asynchronous_likelihood_execution = true,
+                const typename RandomNumberGenerator::result_type random_seed = {});
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once.
+         * See the corresponding sample() function above.
+         */
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const typename RandomNumberGenerator::result_type random_seed = {});
+
+        /**
+         * Continue the chains whose state is stored in the given checkpoint,
+         * written by a previous call to one of the sample() or resume()
+         * functions, until a total of `n_samples` samples has been produced.
+         * The chains continue in exactly the same way as if they had not
+         * been interrupted, provided `propose_sample` and `crossover` do
+         * not draw from a random number generator whose state is not
+         * restored along with the chains.
+         *
+         * @param[in] checkpoint A checkpoint written because
+         *   Parameters::checkpointer was set, for example as read from a
+         *   file via Checkpointer::read().
+         * @param[in] log_likelihood See the first sample() function.
+         * @param[in] propose_sample See the first sample() function.
+         * @param[in] crossover See the first sample() function.
+         * @param[in] crossover_gap See the first sample() function.
+         * @param[in] n_samples The total number of samples the chains
+         *   should have produced together once this function returns,
+         *   including the ones produced before the checkpoint was written.
+         * @param[in] asynchronous_likelihood_execution See the first
+         *   sample() function.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const bool asynchronous_likelihood_execution = true);
+
+        /**
+         * Like the previous function, but for a function object that
+         * returns a `std::future` for the log likelihood. See the
+         * corresponding sample() function.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples);
+
+        /**
+         * Like the previous function, but for a function object that
+         * evaluates the log likelihoods of a whole batch of samples at once.
+         * See the corresponding sample() function.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples);
+
+        /**
+         * Continue the chains whose state is stored in the given checkpoint,
+         * written by a previous call to one of the sample() or resume()
+         * functions whose `propose_sample` and `crossover` arguments take a
+         * random number generator. See the corresponding sample() and
+         * resume() functions above.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples,
+                const bool asynchronous_likelihood_execution = true);
+
+        /**
+         * Like the previous function, but for a function object that
+         * evaluates the log likelihoods of a whole batch of samples at once.
+         */
+        void
+        resume (const std::vector<char> &checkpoint,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                const unsigned int crossover_gap,
+                const types::sample_index n_samples);
+
+        /**
+         * A variant of the algorithm that does not advance the chains in
+         * lockstep, in generations, but lets each chain take its next step
+         * as soon as it is done with its previous one ("asynchronous"
+         * differential evaluation). The steps of each chain are run as tasks
+         * on the given thread pool: A task creates a trial sample for its
+         * chain, evaluates the likelihood of the trial sample, decides
+         * whether to accept it, sends the new sample downstream, and then
+         * enqueues the next step of the chain with the pool. (If
+         * Parameters::grain_size is larger than one, a task takes that many
+         * steps of its chain before it enqueues the next task.) When a step
+         * needs a crossover, it uses the current samples of the other chains
+         * at that time, whatever step these chains are at.
+         *
+         * This is useful if evaluating the likelihood takes very different
+         * amounts of time for different samples, for example because it
+         * involves an adaptive solver: In the generational algorithm of the
+         * sample() functions, all chains have to wait for the slowest
+         * evaluation of each generation, whereas here, a thread that has
+         * finished an evaluation immediately moves on to the next step of
+         * some chain. The price to pay is that the sequence of samples is no
+         * longer reproducible, since it depends on the order in which
+         * evaluations finish. Samples are sent to consumers concurrently
+         * from the worker threads of the pool, and the AuxiliaryData object
+         * of each sample carries an entry with key AuxiliaryData::chain_number
+         * that indicates which chain the sample belongs to.
+         *
+         * Each chain uses its own random number generator, namely the stream
+         * with the number of the chain that Random::create_stream() creates
+         * from `random_seed`. The `crossover_gap` counts steps of each
+         * individual chain.
+         *
+         * @param[in] starting_points See the previous functions.
+         * @param[in] log_likelihood A function object that returns
+         *   $\log(\pi(x))$. It is called concurrently from the worker
+         *   threads of the pool, and so needs to be reentrant.
+         * @param[in] propose_sample See the previous functions. This function
+         *   is also called concurrently, and so should not use a random
+         *   number generator shared between calls without synchronization.
+         * @param[in] crossover See the previous functions. This function is
+         *   also called concurrently.
+         * @param[in] crossover_gap See the previous functions.
+         * @param[in] n_samples The total number of (new) samples to be
+         *   produced by all chains together. Because chains take steps at
+         *   different rates, individual chains may produce different numbers
+         *   of samples.
+         * @param[in] random_seed See the previous functions.
+         * @param[in] thread_pool The pool on which the steps of the chains
+         *   are run.
+         */
+        void
+        sample_asynchronously (const std::vector<OutputType> &starting_points,
+                               const std::function<double (const OutputType &)> &log_likelihood,
+                               const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                               const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                               const unsigned int crossover_gap,
+                               const types::sample_index n_samples,
+                               const typename RandomNumberGenerator::result_type random_seed = {},
+                               const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * Return how often the likelihood function and the function that
+         * proposes trial samples have been called so far, and how long
+         * these calls took. The statistics are only collected if
+         * Parameters::record_timings is set, and otherwise all counters
+         * of the returned object are zero.
+         */
+        Instrumentation::SamplerStatistics
+        get_sampler_statistics () const;
+
+        /**
+         * Return a producer through which only the samples of the chain
+         * with the given number are sent downstream, in the order in which
+         * the chain produces them. All samples are still also sent through
+         * the current object itself, interleaved between chains.
+         *
+         * Consumers that only need the samples of one chain -- say, to
+         * write the trace of each chain to its own file, or an
+         * AutoCovarianceTrace object per chain -- could also be connected
+         * to the current object via a Filters::Condition object that only
+         * lets through samples whose AuxiliaryData::chain_number matches.
+         * But then each of these filters receives, and has to look at,
+         * every sample of every chain. Consumers connected to the outputs
+         * returned by this function instead only ever receive the samples
+         * of their chain:
+         * @code
+         *   SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> sampler;
+         *
+         *   std::vector<std::unique_ptr<SampleFlow::Consumers::AutoCovarianceTrace<SampleType>>> traces;
+         *   for (unsigned int chain=0; chain<n_chains; ++chain)
+         *     {
+         *       traces.emplace_back (std::make_unique<SampleFlow::Consumers::AutoCovarianceTrace<SampleType>>(100));
+         *       traces.back()->connect_to_producer (sampler.chain_output(chain));
+         *     }
+         * @endcode
+         * Samples sent through these outputs carry the same auxiliary data
+         * as the ones sent through the current object, including the chain
+         * number. When sampling ends, the consumers connected to these
+         * outputs are flushed along with those connected to the current
+         * object.
+         *
+         * The outputs are created when this function is first called for a
+         * chain, and only chains for which this has happened send their
+         * samples through an output of their own; for all others, this
+         * costs nothing. This function may be called at any time, including
+         * while samples are being produced; consumers connected to an output
+         * created during sampling receive the samples of the chain from then
+         * on.
+         */
+        Producer<OutputType> &
+        chain_output (const std::size_t chain);
+
+      private:
+        /**
+         * A class whose only purpose is to give access to the
+         * Producer::issue_sample() function and the other protected members
+         * of a Producer for the per-chain outputs of this object.
+         */
+        class ChainOutput : public Producer<OutputType>
+        {
+            friend class DifferentialEvaluationMetropolisHastings;
+        };
+
+        /**
+         * The per-chain outputs created by chain_output(), indexed by the
+         * number of the chain. Entries for chains whose output has not
+         * been asked for are `nullptr`. Since Producer objects cannot be
+         * copied and are referenced by the consumers connected to them,
+         * they are stored by pointer.
+         */
+        std::vector<std::unique_ptr<ChainOutput>> chain_outputs;
+
+        /**
+         * A mutex that guards `chain_outputs`, which chain_output() may
+         * change while the sampling functions read it. The ChainOutput
+         * objects themselves do not move when the vector is resized, and so
+         * can be used without holding the lock.
+         */
+        mutable std::mutex chain_outputs_mutex;
+
+        /**
+         * Send a copy of the given sample of the given chain, and of its
+         * auxiliary data, through the output of this chain, if there is
+         * one.
+         */
+        void
+        issue_to_chain_output (const std::size_t    chain,
+                               const OutputType    &sample,
+                               const AuxiliaryData &aux_data);
+
+        /**
+         * Flush the consumers connected to the current object, and then
+         * the ones connected to the per-chain outputs.
+         */
+        void
+        flush_all_consumers ();
+
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The timings collected if Parameters::record_timings is set,
+         * kept per thread since sample_asynchronously() runs steps on
+         * several threads.
+         */
+        ShardedAccumulator<Instrumentation::SamplerStatistics> sampler_statistics;
+
+        /**
+         * Add the given times for one proposal and one evaluation of the
+         * likelihood to the statistics returned by
+         * get_sampler_statistics() and to the given auxiliary data of a
+         * sample. If `aux_data` is a `nullptr`, only add `n` evaluations
+         * of the likelihood (of starting points) that each took
+         * `likelihood_evaluation_time`.
+         */
+        void
+        record_timings (const std::chrono::nanoseconds proposal_time,
+                        const std::chrono::nanoseconds likelihood_evaluation_time,
+                        AuxiliaryData *aux_data,
+                        const std::size_t n = 1);
+
+        /**
+         * The objects into which sample_asynchronously() copies the samples
+         * of other chains (or of the archive) that enter a crossover. Each
+         * step needs two such copies, since another chain may replace its
+         * current sample while the crossover is being computed; taking
+         * them from a pool means that the copies are assignments into
+         * existing objects rather than newly allocated objects.
+         */
+        SamplePool<OutputType> crossover_sample_pool;
+
+        /**
+         * Advance the chains with the given state, one generation at a
+         * time, until a total of `n_samples` samples has been produced.
+         * This is the implementation of the sample() and resume()
+         * functions. If `State::chain_rngs` is empty, the trial samples are
+         * created one after the other with the generator `State::rng`;
+         * otherwise, they are created concurrently, each chain with its own
+         * generator.
+         */
+        void
+        run_generations (State &state,
+                         const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                         const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                         const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                         const unsigned int crossover_gap,
+                         const types::sample_index n_samples);
+
+        /**
+         * Start the chains at the given points, with the random number
+         * generators set up as described for the sample() functions, and
+         * run them via run_generations(). This is the implementation of
+         * the sample() functions that take a batch log likelihood.
+         */
+        void
+        start_generations (const std::vector<OutputType> &starting_points,
+                           const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                           const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                           const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                           const unsigned int crossover_gap,
+                           const types::sample_index n_samples,
+                           const typename RandomNumberGenerator::result_type random_seed,
+                           const bool per_chain_generators);
+
+        /**
+         * Wrap a function object that evaluates the likelihood of one
+         * sample into one that evaluates a whole batch of samples, either
+         * one after the other or, if `asynchronous_execution` is set,
+         * concurrently as tasks on the default thread pool.
+         */
+        static
+        types::BatchLogLikelihood<OutputType>
+        as_batch_log_likelihood (const std::function<double (const OutputType &)> &log_likelihood,
+                                 const bool asynchronous_execution);
+
+        /**
+         * Wrap a function object that starts the evaluation of the
+         * likelihood of one sample into one that evaluates a whole batch
+         * of samples, by first starting the evaluations for all samples of
+         * the batch and only then waiting for the results.
+         */
+        static
+        types::BatchLogLikelihood<OutputType>
+        as_batch_log_likelihood (const types::AsynchronousLogLikelihood<OutputType> &log_likelihood);
+
+        /**
+         * Select two different elements of an archive with the given number
+         * of elements, using the given random number generator. This is
+         * used to select the samples that enter the crossover if
+         * Parameters::archive_size is nonzero.
+         */
+        static
+        std::pair<std::size_t,std::size_t>
+        select_archive_entries (const std::size_t n_entries,
+                                RandomNumberGenerator &rng);
+
+        /**
+         * Select two chains different from the given one and from each
+         * other, using the given random number generator. This is used to
+         * select the chains whose samples enter the crossover.
+         */
+        static
+        std::pair<std::size_t,std::size_t>
+        select_crossover_chains (const std::size_t chain,
+                                 const std::size_t n_chains,
+                                 RandomNumberGenerator &rng);
     };
 
 
-    template <typename OutputType>
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    DifferentialEvaluationMetropolisHastings (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert ((parameters.archive_size == 0) || (parameters.archive_size >= 2));
+      assert (parameters.archive_thinning >= 1);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     void
-    DifferentialEvaluationMetropolisHastings<OutputType>::
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
     sample (const std::vector<OutputType> &starting_points,
             const std::function<double (const OutputType &)> &log_likelihood,
             const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
@@ -153,186 +879,1051 @@ namespace SampleFlow
             const unsigned int crossover_gap,
             const types::sample_index n_samples,
             const bool asynchronous_likelihood_execution,
-            const std::mt19937::result_type random_seed)
+            const typename RandomNumberGenerator::result_type random_seed)
+    {
+      sample (starting_points,
+              as_batch_log_likelihood (log_likelihood, asynchronous_likelihood_execution),
+              propose_sample,
+              crossover,
+              crossover_gap,
+              n_samples,
+              random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const typename RandomNumberGenerator::result_type random_seed)
+    {
+      sample (starting_points,
+              as_batch_log_likelihood (log_likelihood),
+              propose_sample,
+              crossover,
+              crossover_gap,
+              n_samples,
+              random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const typename RandomNumberGenerator::result_type random_seed)
+    {
+      start_generations (starting_points,
+                         log_likelihood,
+                         [&propose_sample](const OutputType &x, RandomNumberGenerator &)
+      {
+        return propose_sample (x);
+      },
+      [&crossover](const OutputType &x, const OutputType &a, const OutputType &b,
+                   RandomNumberGenerator &)
+      {
+        return crossover (x, a, b);
+      },
+      crossover_gap,
+      n_samples,
+      random_seed,
+      false);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const bool asynchronous_likelihood_execution,
+            const typename RandomNumberGenerator::result_type random_seed)
+    {
+      start_generations (starting_points,
+                         as_batch_log_likelihood (log_likelihood, asynchronous_likelihood_execution),
+                         propose_sample,
+                         crossover,
+                         crossover_gap,
+                         n_samples,
+                         random_seed,
+                         true);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const typename RandomNumberGenerator::result_type random_seed)
+    {
+      start_generations (starting_points,
+                         log_likelihood,
+                         propose_sample,
+                         crossover,
+                         crossover_gap,
+                         n_samples,
+                         random_seed,
+                         true);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    start_generations (const std::vector<OutputType> &starting_points,
+                       const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                       const unsigned int crossover_gap,
+                       const types::sample_index n_samples,
+                       const typename RandomNumberGenerator::result_type random_seed,
+                       const bool per_chain_generators)
     {
-      const typename std::vector<OutputType>::size_type n_chains = starting_points.size();
-      assert (n_chains >= 3);
+      State state;
+      state.current_samples = starting_points;
+      state.current_log_likelihoods.resize (starting_points.size());
+
+      std::chrono::nanoseconds batch_time {0};
+      Instrumentation::timed_call (parameters.record_timings, batch_time, [&]()
+      {
+        Tracing::Span span ("log_likelihood_batch", "sampler", this);
+        log_likelihood (state.current_samples, state.current_log_likelihoods);
+        return 0;
+      });
+      if (parameters.record_timings && (starting_points.size() > 0))
+        record_timings ({}, batch_time / starting_points.size(), nullptr,
+                        starting_points.size());
+      if (random_seed != typename RandomNumberGenerator::result_type {})
+        state.rng.seed (random_seed);
+      if (per_chain_generators)
+        for (std::size_t chain=0; chain<starting_points.size(); ++chain)
+          state.chain_rngs.push_back (Random::create_stream<RandomNumberGenerator> (random_seed, chain));
+      state.generation = 0;
+
+      // If requested, the starting points are the first entries of the
+      // archive of past states:
+      if (parameters.archive_size > 0)
+        state.archive = starting_points;
+
+      run_generations (state,
+                       log_likelihood,
+                       propose_sample,
+                       crossover,
+                       crossover_gap,
+                       n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const bool asynchronous_likelihood_execution)
+    {
+      resume (checkpoint,
+              as_batch_log_likelihood (log_likelihood, asynchronous_likelihood_execution),
+              propose_sample,
+              crossover,
+              crossover_gap,
+              n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples)
+    {
+      resume (checkpoint,
+              as_batch_log_likelihood (log_likelihood),
+              propose_sample,
+              crossover,
+              crossover_gap,
+              n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples)
+    {
+      std::span<const char> buffer (checkpoint);
+
+      State state;
+      Serialization::read (buffer, state);
+      assert (buffer.empty());
+      assert (state.chain_rngs.empty());
+
+      run_generations (state,
+                       log_likelihood,
+                       [&propose_sample](const OutputType &x, RandomNumberGenerator &)
+      {
+        return propose_sample (x);
+      },
+      [&crossover](const OutputType &x, const OutputType &a, const OutputType &b,
+                   RandomNumberGenerator &)
+      {
+        return crossover (x, a, b);
+      },
+      crossover_gap,
+      n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples,
+            const bool asynchronous_likelihood_execution)
+    {
+      resume (checkpoint,
+              as_batch_log_likelihood (log_likelihood, asynchronous_likelihood_execution),
+              propose_sample,
+              crossover,
+              crossover_gap,
+              n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+            const unsigned int crossover_gap,
+            const types::sample_index n_samples)
+    {
+      std::span<const char> buffer (checkpoint);
+
+      State state;
+      Serialization::read (buffer, state);
+      assert (buffer.empty());
+      assert (state.chain_rngs.size() == state.current_samples.size());
+
+      run_generations (state,
+                       log_likelihood,
+                       propose_sample,
+                       crossover,
+                       crossover_gap,
+                       n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    State::save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, current_samples);
+      Serialization::write (buffer, current_log_likelihoods);
+      Serialization::write (buffer, rng);
+      Serialization::write (buffer, chain_rngs);
+      Serialization::write (buffer, generation);
+      Serialization::write (buffer, archive);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    State::load (std::span<const char> &buffer)
+    {
+      Serialization::read (buffer, current_samples);
+      Serialization::read (buffer, current_log_likelihoods);
+      Serialization::read (buffer, rng);
+      Serialization::read (buffer, chain_rngs);
+      Serialization::read (buffer, generation);
+      Serialization::read (buffer, archive);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    types::BatchLogLikelihood<OutputType>
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    as_batch_log_likelihood (const std::function<double (const OutputType &)> &log_likelihood,
+                             const bool asynchronous_execution)
+    {
+      // If requested, evaluate the likelihoods of a batch of samples as
+      // tasks on the default thread pool:
+      if (asynchronous_execution)
+        {
+          const std::shared_ptr<ThreadPool> thread_pool = ThreadPool::default_pool();
+          return [&log_likelihood, thread_pool](std::span<const OutputType> samples,
+                                                std::span<double> log_likelihoods)
+          {
+            assert (samples.size() == log_likelihoods.size());
+
+            ThreadPool::TaskGroup evaluations;
+            for (std::size_t i=0; i<samples.size(); ++i)
+              evaluations.run (*thread_pool,
+                               [&log_likelihood, &samples, &log_likelihoods, i]()
+            {
+              log_likelihoods[i] = log_likelihood (samples[i]);
+            });
+            evaluations.wait();
+          };
+        }
+      else
+        {
+          // Otherwise wrap it into one that evaluates a whole batch by
+          // evaluating one sample after the other:
+          return [&log_likelihood](std::span<const OutputType> samples,
+                                   std::span<double> log_likelihoods)
+          {
+            assert (samples.size() == log_likelihoods.size());
+
+            for (std::size_t i=0; i<samples.size(); ++i)
+              log_likelihoods[i] = log_likelihood (samples[i]);
+          };
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    types::BatchLogLikelihood<OutputType>
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    as_batch_log_likelihood (const types::AsynchronousLogLikelihood<OutputType> &log_likelihood)
+    {
+      return [&log_likelihood](std::span<const OutputType> samples,
+                               std::span<double> log_likelihoods)
+      {
+        assert (samples.size() == log_likelihoods.size());
+
+        std::vector<std::future<double>> evaluation_results;
+        evaluation_results.reserve (samples.size());
+        for (const OutputType &sample : samples)
+          evaluation_results.emplace_back (log_likelihood (sample));
+
+        for (std::size_t i=0; i<samples.size(); ++i)
+          log_likelihoods[i] = evaluation_results[i].get();
+      };
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_generations (State &state,
+                     const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                     const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                     const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &, RandomNumberGenerator &)> &crossover,
+                     const unsigned int crossover_gap,
+                     const types::sample_index n_samples)
+    {
+      const typename std::vector<OutputType>::size_type n_chains = state.current_samples.size();
+      assert (n_chains >= (parameters.archive_size > 0 ? 2 : 3));
       // Make sure the flush_consumers() function is called at any point
       // where we exit the current function.
       Utilities::ScopeExit scope_exit ([this]()
       {
-        this->flush_consumers();
+        flush_all_consumers();
+        this->clear_stop_request();
       });
 
-      std::mt19937 rng;
-      if (random_seed != std::mt19937::result_type {})
-        rng.seed (random_seed);
+      // If every chain has its own random number generator, we can create
+      // the trial samples of all chains concurrently:
+      const bool per_chain_generators = (state.chain_rngs.size() > 0);
+      assert (!per_chain_generators || (state.chain_rngs.size() == n_chains));
+      const std::shared_ptr<ThreadPool> proposal_thread_pool
+        = (parameters.proposal_thread_pool != nullptr ?
+           parameters.proposal_thread_pool :
+           ThreadPool::default_pool());
+
+      std::vector<OutputType> &current_samples         = state.current_samples;
+      std::vector<double>     &current_log_likelihoods = state.current_log_likelihoods;
+      assert (current_log_likelihoods.size() == n_chains);
+
+      // Arrays that store, for each chain, the trial sample, the ratio of
+      // proposal probabilities, the random number against which we compare
+      // the acceptance ratio, and the log likelihood of the trial sample,
+      // for the current generation. Because we first create the trial
+      // samples for all chains and only then update any of the chains,
+      // all crossovers are performed with the previous set of samples.
+      //
+      // 'trial_samples' and 'current_samples' form a double buffer: If a
+      // trial sample is accepted, we swap it with the current sample of
+      // its chain, and the object that then holds the old current sample
+      // is overwritten by the trial sample of the next generation. This
+      // way, we never copy samples from one array to the other -- which
+      // matters if samples are large vectors and there are many chains.
+      std::vector<OutputType> trial_samples = current_samples;
+      std::vector<double>     proposal_distribution_ratios (n_chains);
+      std::vector<double>     uniform_random_numbers (n_chains);
+      std::vector<double>     trial_log_likelihoods (n_chains);
+
+      // If we record timings, the times of the proposals of the chains
+      // and of the evaluation of the likelihoods of the current
+      // generation:
+      const bool measure = parameters.record_timings;
+      std::vector<std::chrono::nanoseconds> proposal_times (n_chains);
+      std::chrono::nanoseconds              batch_time {0};
+
+      std::vector<AuxiliaryData> generation_aux_data;
+      generation_aux_data.reserve (n_chains);
+
+      // If requested, set up the archive of past states from which to
+      // draw the samples for crossovers, and put the samples the state
+      // holds for it into it:
+      const bool use_archive = (parameters.archive_size > 0);
+      RingBuffer<OutputType> archive (use_archive ? parameters.archive_size : 1);
+      if (use_archive)
+        for (const OutputType &sample : state.archive)
+          archive.push_back (sample);
+      state.archive.clear ();
+
+      // If we write checkpoints, the state needs to contain the archive
+      // as well:
+      const auto write_checkpoint = [&]()
+      {
+        if (parameters.checkpointer == nullptr)
+          return;
 
-      // Initialize distribution for comparing to acceptance ratio
-      std::uniform_real_distribution<> uniform_distribution(0,1);
+        if constexpr (Serialization::is_serializable<OutputType>())
+          {
+            if (use_archive)
+              for (std::size_t i=0; i<archive.size(); ++i)
+                state.archive.push_back (archive[i]);
 
-      std::vector<OutputType> current_samples = starting_points;
-      std::vector<double> current_log_likelihoods(n_chains);
-      for (unsigned int i=0; i<n_chains; ++i)
-        current_log_likelihoods[i] = log_likelihood (starting_points[i]);
+            std::vector<char> checkpoint;
+            Serialization::write (checkpoint, state);
+            parameters.checkpointer->write (std::move(checkpoint));
 
-      // Include another array to store new values so that all crossovers
-      // can be performed with the previous set of samples
-      std::vector<OutputType> next_samples = starting_points;
+            state.archive.clear ();
+          }
+        else
+          assert (false);
+      };
 
       // Loop over the desired number of samples, using an outer loop over
-      // "generations" and an inner loop over the individual chains. We
-      // exit from the inner loop when we have reached the desired number of
-      // samples.
-      for (types::sample_index generation=0; generation * n_chains < n_samples; ++generation)
+      // "generations" and an inner loop over the individual chains. In the
+      // last generation, we may need fewer samples than there are chains;
+      // in that case, only the first few chains take another step.
+      types::sample_index &generation = state.generation;
+      while ((generation * n_chains < n_samples) && (this->stop_requested() == false))
         {
-          // A vector that will contain the std::future objects used to
-          // hold results of either synchronous or asynchronous
-          // evaluation.
-          std::vector<std::future<bool>> chain_evaluation_results;
-          chain_evaluation_results.reserve(n_chains);
-
-          // Loop over the desired number of chains and set up the computation
-          // of log likelihoods for new samples:
-          for (typename std::vector<OutputType>::size_type chain = 0; chain < n_chains; ++chain)
-            {
-              // Skip if we have enough samples already:
-              if (generation * n_chains + chain >= n_samples)
-                break;
-
-              // Determine trial sample and likelihood ratio; either from
-              // crossover operation or regular perturbation
-              std::pair<OutputType, double> trial_sample_and_ratio;
-
-              // Perform crossover every crossover_gap iterations
-              if (((crossover_gap == 0)
-                   ||
-                   ((generation % crossover_gap) == 0))
-                  &&
-                  (generation > 0))
-                {
-                  // Pick one of the other chains from which we want to draw:
-                  std::uniform_int_distribution<typename std::vector<OutputType>::size_type>
-                  a_dist(0, n_chains - 2);
-
-                  // Pick one chain with index 'a', just not the current one. We do this by
-                  // drawing from [0...n_chains-2] and mapping that onto the union of the
-                  // intervals [0...chain) + (chain...n_chains-1].
-                  typename std::vector<OutputType>::size_type a = a_dist(rng);
-                  if (a >= chain)
-                    a += 1;
-                  const OutputType trial_a = current_samples[a];
-
-                  // Then the other chain to draw from, but make sure it's not the same as
-                  // 'chain' or 'a'. We do this by drawing from [0...n_chains-3] and mapping
-                  // that onto the union of the intervals
-                  //   [0...x) + (x...y) + (y...n_chains-1]
-                  // where x=min(chain,a), y=max(chain,c) are the two points we want
-                  // to avoid.
-                  std::uniform_int_distribution<typename std::vector<OutputType>::size_type>
-                  b_dist(0, n_chains - 3);
-
-                  typename std::vector<OutputType>::size_type b = b_dist(rng);
-                  if (b >= std::min<typename std::vector<OutputType>::size_type>(a, chain))
-                    ++b;
-                  if (b >= std::max(a, chain))
-                    ++b;
-                  const OutputType trial_b = current_samples[b];
-
-                  assert (a!=b);
-
-                  // Combine trial a and trial b
-                  const OutputType crossover_result = crossover(current_samples[chain], trial_a, trial_b);
-                  trial_sample_and_ratio = propose_sample(crossover_result);
-                }
-              else
-                trial_sample_and_ratio = propose_sample(current_samples[chain]);
-
-              // Now that we have a trial sample, we need to evaluate the likelihood
-              // on it. We can do this sequentially or in parallel, and for this, we
-              // enclose everything into a lambda function that we can then execute
-              // either right away, or via a std::async. The only thing we need to pay
-              // attention to is that we create random numbers in a fixed order.
-              // We do this by evaluating the random number generator upon creating
-              // the lambda function.
-              const auto task
-              = [trial_sample = std::move(trial_sample_and_ratio.first),
-                 proposal_distribution_ratio = trial_sample_and_ratio.second,
-                 log_likelihood,
-                 uniform_random_number = uniform_distribution(rng),
-                 chain,
-                 &current_samples,
-                 &next_samples,
-                 &current_log_likelihoods]()
-              -> bool
+          Tracing::Span generation_span ("generation", "sampler", this);
+
+          const std::size_t n_active_chains
+            = std::min<types::sample_index> (n_chains, n_samples - generation * n_chains);
+
+          // The function that creates the trial sample for one chain,
+          // using the given random number generator:
+          const auto create_trial_sample = [&](const std::size_t chain,
+                                               RandomNumberGenerator &rng)
+          {
+            // Determine trial sample and likelihood ratio; either from
+            // crossover operation or regular perturbation
+            std::pair<OutputType, double> trial_sample_and_ratio;
+            const Instrumentation::Clock::time_point proposal_start
+              = (measure ? Instrumentation::Clock::now() : Instrumentation::Clock::time_point());
+
+            // Perform crossover every crossover_gap iterations
+            if (((crossover_gap == 0)
+                 ||
+                 ((generation % crossover_gap) == 0))
+                &&
+                (generation > 0))
               {
-                const double trial_log_likelihood = log_likelihood (trial_sample);
-                // Accept trial sample with probability equal to ratio of likelihoods;
-                // (always accept if > 1)
-                double acceptance_ratio = (std::exp(trial_log_likelihood - current_log_likelihoods[chain]) /
-                proposal_distribution_ratio);
-                bool accepted_sample = false;
-                if (acceptance_ratio >= uniform_random_number)
-                  accepted_sample = true;
-                if (accepted_sample)
+                // Pick two of the other chains from which we want to draw,
+                // or two entries of the archive, and combine their samples
+                // with the current one:
+                if (use_archive)
                   {
-                    next_samples[chain] = trial_sample;
-                    current_log_likelihoods[chain] = trial_log_likelihood;
+                    const auto [a, b] = select_archive_entries (archive.size(), rng);
+                    trial_sample_and_ratio = propose_sample(crossover(current_samples[chain],
+                                                                      archive[a],
+                                                                      archive[b],
+                                                                      rng),
+                                                            rng);
                   }
                 else
-                  next_samples[chain] = current_samples[chain];
+                  {
+                    const auto [a, b] = select_crossover_chains (chain, n_chains, rng);
+                    trial_sample_and_ratio = propose_sample(crossover(current_samples[chain],
+                                                                      current_samples[a],
+                                                                      current_samples[b],
+                                                                      rng),
+                                                            rng);
+                  }
+              }
+            else
+              trial_sample_and_ratio = propose_sample(current_samples[chain], rng);
 
-                return accepted_sample;
-              };
+            if (measure)
+              proposal_times[chain] = Instrumentation::Clock::now() - proposal_start;
 
+            // Store the trial sample. We also need a random number to
+            // decide whether to accept it; we draw it right away so
+            // that random numbers are created in a fixed order.
+            trial_samples[chain]                = std::move(trial_sample_and_ratio.first);
+            proposal_distribution_ratios[chain] = trial_sample_and_ratio.second;
+            uniform_random_numbers[chain]       = std::uniform_real_distribution<>(0,1)(rng);
+          };
 
-              // Now either execute the evaluator asynchronously or synchronously.
-              // In the former case, get a future from the async call that we can
-              // later use to wait for the evaluator. In the latter case,
-              // create a packaged task that we can ask for a future, then
-              // just execute the task synchronously.
-              if (asynchronous_likelihood_execution)
-                chain_evaluation_results.emplace_back (std::async(task));
-              else
-                {
-                  std::packaged_task<bool()> t(task);
-                  chain_evaluation_results.emplace_back (t.get_future());
-                  t();
-                }
+          // Then create the trial samples for all chains, either one
+          // after the other with the common generator, or as one task per
+          // chain with the generator of each chain. The tasks write into
+          // different elements of the arrays above and only read the
+          // current samples and the archive, which do not change until all
+          // tasks are done.
+          if (per_chain_generators == false)
+            for (std::size_t chain=0; chain<n_active_chains; ++chain)
+              create_trial_sample (chain, state.rng);
+          else
+            {
+              ThreadPool::TaskGroup proposals;
+              for (std::size_t chain=0; chain<n_active_chains; ++chain)
+                proposals.run (*proposal_thread_pool,
+                               [&create_trial_sample, &state, chain]()
+              {
+                create_trial_sample (chain, state.chain_rngs[chain]);
+              });
+              proposals.wait();
             }
 
-          // We have either executed the log likelihood function for
-          // all chains right away, or at least set up the asynchronous
-          // execution. Now it is time to let the cows come in for
-          // milking.
-          //
-          // In the following, we are in essence only issuing the new
-          // samples. We could have done that in the lambda function
-          // above, but that would have issued samples in unpredictable
-          // orders. Doing this relatively cheap step here sequentially
-          // guarantees a stable order.
-          for (typename std::vector<OutputType>::size_type chain = 0; chain < n_chains; ++chain)
+          // Now evaluate the likelihoods of all trial samples at once:
+          Instrumentation::timed_call (measure, batch_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood_batch", "sampler", this);
+            log_likelihood (std::span<const OutputType> (trial_samples.data(), n_active_chains),
+                            std::span<double> (trial_log_likelihoods.data(), n_active_chains));
+            return 0;
+          });
+
+          // Then decide for each chain whether we accept the trial
+          // sample. Doing this step here sequentially guarantees a stable
+          // order.
+          generation_aux_data.clear ();
+          for (std::size_t chain=0; chain<n_active_chains; ++chain)
             {
-              // Break the loop if we have already generated the desired number of
-              // samples:
-              if (generation * n_chains + chain >= n_samples)
-                break;
-
-              // Wait for the futures to be ready. Then output the new sample
-              // (which may of course be equal to the old sample).
-              assert (chain < chain_evaluation_results.size());
-              const bool accepted_sample = chain_evaluation_results[chain].get();
-              this->issue_sample (next_samples[chain],
+              // Accept trial sample with probability equal to ratio of likelihoods;
+              // (always accept if > 1)
+              const double acceptance_ratio
+                = (std::exp(trial_log_likelihoods[chain] - current_log_likelihoods[chain]) /
+                   proposal_distribution_ratios[chain]);
+              const bool accepted_sample = (acceptance_ratio >= uniform_random_numbers[chain]);
+
+              if (accepted_sample)
+                {
+                  std::swap (current_samples[chain], trial_samples[chain]);
+                  current_log_likelihoods[chain] = trial_log_likelihoods[chain];
+                }
+
+              generation_aux_data.emplace_back (AuxiliaryData
               {
-                {"relative log likelihood", std::any(current_log_likelihoods[chain])},
-                {"sample is repeated", std::any(!accepted_sample)},
-                {"chain number", std::any(std::size_t(chain))}
+                {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihoods[chain])},
+                {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)},
+                {AuxiliaryData::chain_number, std::any(std::size_t(chain))}
               });
+              if (measure)
+                record_timings (proposal_times[chain], batch_time / n_active_chains,
+                                &generation_aux_data.back());
             }
 
-          current_samples = next_samples;
+          // Every so many generations, add the new samples to the archive:
+          if (use_archive && ((generation + 1) % parameters.archive_thinning == 0))
+            for (std::size_t chain=0; chain<n_active_chains; ++chain)
+              archive.push_back (current_samples[chain]);
+
+          // Output the new samples (which may of course be equal to the
+          // old samples). Since we have a whole generation of samples at
+          // once, we send them downstream as one batch -- directly from
+          // the array of current samples, unless this is a last, partial
+          // generation.
+          if (n_active_chains == n_chains)
+            this->issue_batch (current_samples, generation_aux_data);
+          else
+            this->issue_batch (std::vector<OutputType> (current_samples.begin(),
+                                                        current_samples.begin() + n_active_chains),
+                               generation_aux_data);
+          for (std::size_t chain=0; chain<n_active_chains; ++chain)
+            issue_to_chain_output (chain, current_samples[chain], generation_aux_data[chain]);
+
+          ++generation;
+          if (parameters.migrate
+              &&
+              (parameters.migration_interval > 0)
+              &&
+              (generation % parameters.migration_interval == 0))
+            parameters.migrate (current_samples, current_log_likelihoods, state.rng);
+
+          if ((parameters.checkpoint_interval > 0)
+              &&
+              (generation % parameters.checkpoint_interval == 0))
+            write_checkpoint ();
+        }
+
+      write_checkpoint ();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample_asynchronously (const std::vector<OutputType> &starting_points,
+                           const std::function<double (const OutputType &)> &log_likelihood,
+                           const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                           const std::function<OutputType (const OutputType &, const OutputType &, const OutputType &)> &crossover,
+                           const unsigned int crossover_gap,
+                           const types::sample_index n_samples,
+                           const typename RandomNumberGenerator::result_type random_seed,
+                           const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      const std::size_t n_chains = starting_points.size();
+      assert (n_chains >= (parameters.archive_size > 0 ? 2 : 3));
+      assert (parameters.grain_size >= 1);
+      assert (thread_pool != nullptr);
+
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        flush_all_consumers();
+        this->clear_stop_request();
+      });
+
+      // The state of each chain. Each chain is worked on by at most one
+      // task at any given time, and so only that task accesses the state of
+      // the chain, except for the current sample: That is also read by the
+      // other chains for their crossovers, and is therefore stored
+      // separately in 'population', protected by a mutex.
+      struct ChainState
+      {
+        OutputType            current_sample;
+        double                current_log_likelihood;
+        RandomNumberGenerator rng;
+        types::sample_index   n_steps = 0;
+      };
+      std::vector<ChainState> chains;
+      chains.reserve (n_chains);
+      for (std::size_t chain=0; chain<n_chains; ++chain)
+        chains.push_back ({starting_points[chain], 0.,
+                           Random::create_stream<RandomNumberGenerator> (random_seed, chain)
+                          });
+
+      std::vector<OutputType> population = starting_points;
+
+      // The archive of past states, if requested. Protected by the same
+      // mutex as 'population'.
+      const bool use_archive = (parameters.archive_size > 0);
+      RingBuffer<OutputType> archive (use_archive ? parameters.archive_size : 1);
+      if (use_archive)
+        for (const OutputType &sample : starting_points)
+          archive.push_back (sample);
+
+      // The chains that are currently not being worked on, in the order in
+      // which they finished their previous step. Protected by the same
+      // mutex as 'population'.
+      std::deque<std::size_t> idle_chains;
+      std::mutex              mutex;
+
+      // The total number of steps that have been started so far. A task
+      // that wants to take a step first claims it by incrementing this
+      // counter, and stops if all steps have been claimed.
+      std::atomic<types::sample_index> n_steps_started (0);
+
+      // First evaluate the likelihoods of the starting points, in parallel:
+      {
+        ThreadPool::TaskGroup evaluations;
+        for (std::size_t chain=0; chain<n_chains; ++chain)
+          evaluations.run (*thread_pool, [&, chain]()
+        {
+          std::chrono::nanoseconds likelihood_evaluation_time {0};
+          chains[chain].current_log_likelihood
+            = Instrumentation::timed_call (parameters.record_timings, likelihood_evaluation_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood", "sampler", this);
+            return log_likelihood (chains[chain].current_sample);
+          });
+          if (parameters.record_timings)
+            record_timings ({}, likelihood_evaluation_time, nullptr);
+        });
+        evaluations.wait();
+      }
+      for (std::size_t chain=0; chain<n_chains; ++chain)
+        idle_chains.push_back (chain);
+
+      ThreadPool::TaskGroup steps;
+
+      // The function that takes one step (or Parameters::grain_size
+      // steps) for the chain that has been idle the longest, and then
+      // schedules the next step. Scheduling steps this way, rather than
+      // having each chain schedule its own next step, makes sure that all
+      // chains make progress at similar rates even if there are fewer
+      // threads than chains (and the thread pool prefers to run the task
+      // most recently enqueued by a worker).
+      //
+      // We always have n_chains of these tasks in flight, so there is
+      // always an idle chain when a task starts. The function calls itself
+      // indirectly, and so needs to be a std::function object.
+      std::function<void ()> take_step
+        = [&]()
+      {
+        if ((n_steps_started.fetch_add (1) >= n_samples)
+            ||
+            this->stop_requested())
+          return;
+
+        std::unique_lock<std::mutex> lock (mutex);
+        assert (idle_chains.size() > 0);
+        const std::size_t chain = idle_chains.front();
+        idle_chains.pop_front();
+        lock.unlock ();
+
+        ChainState &state = chains[chain];
+
+        // Take up to 'grain_size' steps of this chain before handing it
+        // back. Each step after the first one needs to be claimed like
+        // the first one.
+        for (types::sample_index step_in_task=1; ; ++step_in_task)
+          {
+            // Determine the trial sample, either from a crossover with the
+            // current samples of two other chains, or by perturbation.
+            const bool measure = parameters.record_timings;
+            std::pair<OutputType, double> trial_sample_and_ratio;
+            const Instrumentation::Clock::time_point proposal_start
+              = (measure ? Instrumentation::Clock::now() : Instrumentation::Clock::time_point());
+            if (((crossover_gap == 0)
+                 ||
+                 ((state.n_steps % crossover_gap) == 0))
+                &&
+                (state.n_steps > 0))
+              {
+                OutputType sample_a = crossover_sample_pool.acquire (state.current_sample);
+                OutputType sample_b = crossover_sample_pool.acquire (state.current_sample);
+                if (use_archive)
+                  {
+                    lock.lock ();
+                    const auto [a, b] = select_archive_entries (archive.size(), state.rng);
+                    sample_a = archive[a];
+                    sample_b = archive[b];
+                    lock.unlock ();
+                  }
+                else
+                  {
+                    const auto [a, b] = select_crossover_chains (chain, n_chains, state.rng);
+
+                    lock.lock ();
+                    sample_a = population[a];
+                    sample_b = population[b];
+                    lock.unlock ();
+                  }
+
+                trial_sample_and_ratio = propose_sample (crossover (state.current_sample,
+                                                                    sample_a,
+                                                                    sample_b));
+
+                crossover_sample_pool.release (std::move(sample_a));
+                crossover_sample_pool.release (std::move(sample_b));
+              }
+            else
+              trial_sample_and_ratio = propose_sample (state.current_sample);
+
+            const std::chrono::nanoseconds proposal_time
+              = (measure ? Instrumentation::Clock::now() - proposal_start : std::chrono::nanoseconds(0));
+
+            std::uniform_real_distribution<> uniform_distribution(0,1);
+            const double uniform_random_number = uniform_distribution (state.rng);
+
+            // Evaluate the likelihood of the trial sample, and decide whether
+            // to accept it in the same way as the sample() functions do:
+            std::chrono::nanoseconds likelihood_evaluation_time {0};
+            const double trial_log_likelihood
+              = Instrumentation::timed_call (measure, likelihood_evaluation_time, [&]()
+            {
+              Tracing::Span span ("log_likelihood", "sampler", this);
+              return log_likelihood (trial_sample_and_ratio.first);
+            });
+            const double acceptance_ratio
+              = (std::exp(trial_log_likelihood - state.current_log_likelihood) /
+                 trial_sample_and_ratio.second);
+            const bool accepted_sample = (acceptance_ratio >= uniform_random_number);
+
+            if (accepted_sample)
+              {
+                state.current_sample         = std::move(trial_sample_and_ratio.first);
+                state.current_log_likelihood = trial_log_likelihood;
+              }
+            ++state.n_steps;
+
+            AuxiliaryData aux_data
+            {
+              {AuxiliaryData::relative_log_likelihood, std::any(state.current_log_likelihood)},
+              {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)},
+              {AuxiliaryData::chain_number, std::any(chain)}
+            };
+            if (measure)
+              record_timings (proposal_time, likelihood_evaluation_time, &aux_data);
+            issue_to_chain_output (chain, state.current_sample, aux_data);
+            this->issue_sample (state.current_sample, std::move(aux_data));
+
+            // Then publish the new sample so that other chains see it in
+            // their crossovers:
+            lock.lock ();
+            if (accepted_sample)
+              population[chain] = state.current_sample;
+            if (use_archive && (state.n_steps % parameters.archive_thinning == 0))
+              archive.push_back (state.current_sample);
+            lock.unlock ();
+
+            if ((step_in_task >= parameters.grain_size)
+                ||
+                (n_steps_started.fetch_add (1) >= n_samples)
+                ||
+                this->stop_requested())
+              break;
+          }
+
+        // Finally put the chain back into the list of idle chains, and
+        // schedule the next step. Doing the latter before the current
+        // task finishes ensures that 'steps' never runs empty while there
+        // is still work to do.
+        lock.lock ();
+        idle_chains.push_back (chain);
+        lock.unlock ();
+
+        steps.run (*thread_pool, [&take_step]()
+        {
+          take_step ();
+        });
+      };
+
+      for (std::size_t chain=0; chain<n_chains; ++chain)
+        steps.run (*thread_pool, [&take_step]()
+      {
+        take_step ();
+      });
+
+      steps.wait();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Instrumentation::SamplerStatistics
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    get_sampler_statistics () const
+    {
+      return sampler_statistics.merged();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Producer<OutputType> &
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    chain_output (const std::size_t chain)
+    {
+      std::lock_guard<std::mutex> lock (chain_outputs_mutex);
+
+      if (chain >= chain_outputs.size())
+        chain_outputs.resize (chain+1);
+      if (chain_outputs[chain] == nullptr)
+        chain_outputs[chain] = std::make_unique<ChainOutput>();
+
+      return *chain_outputs[chain];
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    issue_to_chain_output (const std::size_t    chain,
+                           const OutputType    &sample,
+                           const AuxiliaryData &aux_data)
+    {
+      ChainOutput *output = nullptr;
+      {
+        std::lock_guard<std::mutex> lock (chain_outputs_mutex);
+        if (chain < chain_outputs.size())
+          output = chain_outputs[chain].get();
+      }
+
+      if (output != nullptr)
+        output->issue_sample (sample, aux_data);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    flush_all_consumers ()
+    {
+      this->flush_consumers();
+
+      std::vector<ChainOutput *> outputs;
+      {
+        std::lock_guard<std::mutex> lock (chain_outputs_mutex);
+        for (const auto &output : chain_outputs)
+          if (output != nullptr)
+            outputs.push_back (output.get());
+      }
+      for (ChainOutput *output : outputs)
+        output->flush_consumers();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    record_timings (const std::chrono::nanoseconds proposal_time,
+                    const std::chrono::nanoseconds likelihood_evaluation_time,
+                    AuxiliaryData *aux_data,
+                    const std::size_t n)
+    {
+      sampler_statistics.update ([&](Instrumentation::SamplerStatistics &s)
+      {
+        if (aux_data != nullptr)
+          s.proposals.add (proposal_time);
+        s.likelihood_evaluations.add (likelihood_evaluation_time, n);
+      });
+
+      if (aux_data != nullptr)
+        {
+          (*aux_data)[AuxiliaryData::proposal_time]
+            = std::chrono::duration<double>(proposal_time).count();
+          (*aux_data)[AuxiliaryData::likelihood_evaluation_time]
+            = std::chrono::duration<double>(likelihood_evaluation_time).count();
         }
     }
 
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::pair<std::size_t,std::size_t>
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    select_archive_entries (const std::size_t n_entries,
+                            RandomNumberGenerator &rng)
+    {
+      assert (n_entries >= 2);
+
+      // Pick one entry, and then another one from the remaining entries
+      // by drawing from [0...n_entries-2] and skipping over the first:
+      std::uniform_int_distribution<std::size_t> a_dist(0, n_entries - 1);
+      const std::size_t a = a_dist(rng);
+
+      std::uniform_int_distribution<std::size_t> b_dist(0, n_entries - 2);
+      std::size_t b = b_dist(rng);
+      if (b >= a)
+        ++b;
+
+      return {a, b};
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::pair<std::size_t,std::size_t>
+    DifferentialEvaluationMetropolisHastings<OutputType,RandomNumberGenerator>::
+    select_crossover_chains (const std::size_t chain,
+                             const std::size_t n_chains,
+                             RandomNumberGenerator &rng)
+    {
+      // Pick one chain with index 'a', just not the current one. We do this by
+      // drawing from [0...n_chains-2] and mapping that onto the union of the
+      // intervals [0...chain) + (chain...n_chains-1].
+      std::uniform_int_distribution<std::size_t> a_dist(0, n_chains - 2);
+      std::size_t a = a_dist(rng);
+      if (a >= chain)
+        a += 1;
+
+      // Then the other chain to draw from, but make sure it's not the same as
+      // 'chain' or 'a'. We do this by drawing from [0...n_chains-3] and mapping
+      // that onto the union of the intervals
+      //   [0...x) + (x...y) + (y...n_chains-1]
+      // where x=min(chain,a), y=max(chain,a) are the two points we want
+      // to avoid.
+      std::uniform_int_distribution<std::size_t> b_dist(0, n_chains - 3);
+      std::size_t b = b_dist(rng);
+      if (b >= std::min(a, chain))
+        ++b;
+      if (b >= std::max(a, chain))
+        ++b;
+
+      assert (a!=b);
+      return {a, b};
+    }
   }
 }
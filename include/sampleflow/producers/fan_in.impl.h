@@ -0,0 +1,526 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A class that collects the samples of many producers and presents
+     * them to consumers as if they came from one producer. This is useful
+     * for populations of many lightweight chains, each of which is a
+     * separate Producer object, whose samples are all to be fed into the
+     * same consumers:
+     * @code
+     *   std::vector<SampleFlow::Producers::MetropolisHastings<SampleType>> chains (1000);
+     *
+     *   SampleFlow::Producers::FanIn<SampleType> all_chains;
+     *   for (auto &chain : chains)
+     *     all_chains.connect_to_producer (chain);
+     *
+     *   SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+     *   mean_value.connect_to_producer (all_chains);
+     * @endcode
+     *
+     * Connecting every chain directly to every consumer works as well, but
+     * has costs that grow with the number of producers: Every consumer
+     * stores each connection, checks the number of its connections for
+     * every sample it receives, and has to take its locks exclusively
+     * whenever one of the producers disconnects. With this class in
+     * between, each consumer only has one connection, and the work done
+     * for a sample does not depend on how many producers there are.
+     *
+     *
+     * ### Implementation ###
+     *
+     * For each producer connected to it, the object keeps a "port" with
+     * its own lock and its own buffer of samples. Samples that arrive from
+     * a producer are appended to the buffer of its port, and whenever the
+     * buffer holds `batch_size` samples, the thread that added the last
+     * of them sends the buffer's contents downstream as one batch. The lock
+     * of a port is therefore only ever contended if one producer sends
+     * samples from several threads at once, and consumers receive samples
+     * in batches, which is cheaper for them than receiving samples one at
+     * a time. Batches that arrive from a producer and are at least
+     * `batch_size` long are passed on right away, without being copied.
+     *
+     * The samples of each producer are sent downstream in the order in
+     * which they arrived (as long as the producer sends them from one
+     * thread at a time), and with the auxiliary data they came with, so
+     * that for example AuxiliaryData::chain_number can be used downstream
+     * to tell chains apart. The samples of different producers are
+     * interleaved in batches, however, and batches from different ports
+     * may be sent downstream concurrently.
+     *
+     * When a producer flushes its consumers, the buffer of its port is
+     * sent downstream and then the consumers of the current object are
+     * flushed; the same happens when a producer is destroyed or
+     * disconnected. flush() sends the contents of all buffers downstream.
+     *
+     * @tparam OutputType The C++ type used to describe samples.
+     */
+    template <typename OutputType>
+    class FanIn : public Producer<OutputType>, public PipelineGraph::DownstreamNode
+    {
+      public:
+        /**
+         * Constructor.
+         *
+         * @param[in] batch_size The number of samples of one producer that
+         *   are collected before they are sent downstream as one batch. A
+         *   value of one sends samples on as they arrive.
+         */
+        explicit
+        FanIn (const std::size_t batch_size = 64);
+
+        /**
+         * Destructor. Disconnects from all producers and sends the samples
+         * still buffered downstream.
+         */
+        virtual ~FanIn ();
+
+        /**
+         * Connect to the given producer so that its samples are forwarded
+         * to the consumers of the current object.
+         */
+        void
+        connect_to_producer (Producer<OutputType> &producer);
+
+        /**
+         * Disconnect from the given producer, after sending the samples of
+         * this producer that are still buffered downstream.
+         */
+        void
+        disconnect_from_producer (const Producer<OutputType> &producer);
+
+        /**
+         * Return the number of producers the current object is connected
+         * to.
+         */
+        std::size_t
+        n_producers () const;
+
+        /**
+         * Send the samples still buffered for any of the producers
+         * downstream, and then flush the consumers connected to the current
+         * object.
+         */
+        void
+        flush ();
+
+        /**
+         * Add a node for the current object to the given graph, along with
+         * everything downstream of it. See PipelineGraph::DownstreamNode.
+         */
+        virtual
+        void
+        add_to_graph (PipelineGraph::Graph &graph) const override;
+
+        /**
+         * Return the address of the current object as the identifier of
+         * its node in a pipeline graph.
+         */
+        virtual
+        const void *
+        graph_node_id () const override;
+
+        /**
+         * Return whether any of the objects connected to the current one
+         * requests the entry with the given key in the auxiliary data of
+         * samples. See Producer::aux_data_requested().
+         */
+        virtual
+        bool
+        requests_aux_data (const AuxiliaryData::Key &key) const override;
+
+        /**
+         * Pass the announcement of one of the producers connected to the
+         * current object on to the objects connected to it. Since each of
+         * the producers only knows about its own samples, only the number
+         * of components of samples is passed on. See
+         * Producer::announce_samples().
+         */
+        virtual
+        void
+        receive_announcement (const SampleShape &shape) override;
+
+      private:
+        /**
+         * The buffer and connections kept for each producer.
+         */
+        struct Port
+        {
+          std::mutex                 mutex;
+          std::vector<OutputType>    samples;
+          std::vector<AuxiliaryData> aux_data;
+
+          /**
+           * Whether the port is still in use, and the number of threads
+           * currently adding samples to it. A port that is being closed
+           * waits for the latter to drop to zero so that no sample is
+           * added after the buffer has been sent downstream for the last
+           * time.
+           */
+          std::atomic<bool>         is_connected {true};
+          std::atomic<unsigned int> n_active_senders {0};
+
+          std::tuple<Connection,Connection,Connection,Connection> connections;
+          const Producer<OutputType>                             *producer = nullptr;
+          std::shared_ptr<PipelineGraph::EdgeCounter>             edge_counter;
+        };
+
+        /**
+         * The number of samples collected per port before they are sent
+         * downstream.
+         */
+        const std::size_t batch_size;
+
+        /**
+         * The ports, keyed by the producer they belong to, and a mutex
+         * that guards this map. The map is only accessed when connecting
+         * to or disconnecting from producers, not for individual samples.
+         */
+        mutable std::mutex ports_mutex;
+        std::unordered_map<const Producer<OutputType> *, std::unique_ptr<Port>> ports;
+
+        /**
+         * Add a sample, or a batch of samples, that arrived from the
+         * producer of the given port to the port's buffer, and send the
+         * buffer downstream if it is full.
+         */
+        void
+        receive (Port &port,
+                 OutputType &&sample,
+                 AuxiliaryData &&aux_data);
+
+        void
+        receive_batch (Port &port,
+                       const std::vector<OutputType> &samples,
+                       const std::vector<AuxiliaryData> &aux_data);
+
+        /**
+         * Send the samples buffered in the given port downstream.
+         */
+        void
+        send_buffer (Port &port);
+
+        /**
+         * Disconnect the given port from its producer, wait for all
+         * threads still adding samples to it, and send what is left in
+         * its buffer downstream.
+         */
+        void
+        close (Port &port);
+    };
+
+
+
+    template <typename OutputType>
+    FanIn<OutputType>::FanIn (const std::size_t batch_size)
+      :
+      batch_size (batch_size)
+    {
+      assert (batch_size >= 1);
+    }
+
+
+
+    template <typename OutputType>
+    FanIn<OutputType>::~FanIn ()
+    {
+      std::unordered_map<const Producer<OutputType> *, std::unique_ptr<Port>> remaining_ports;
+      {
+        std::lock_guard<std::mutex> lock (ports_mutex);
+        remaining_ports.swap (ports);
+      }
+
+      for (auto &p : remaining_ports)
+        close (*p.second);
+
+      if (remaining_ports.size() > 0)
+        this->flush_consumers();
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::connect_to_producer (Producer<OutputType> &producer)
+    {
+      std::unique_ptr<Port> port = std::make_unique<Port>();
+      Port *const port_pointer = port.get();
+
+      port->samples.reserve (batch_size);
+      port->aux_data.reserve (batch_size);
+      port->edge_counter = std::make_shared<PipelineGraph::EdgeCounter>();
+
+      auto sample_slot = [this, port_pointer](OutputType sample, AuxiliaryData aux_data)
+      {
+        ++port_pointer->n_active_senders;
+        if (port_pointer->is_connected.load() == true)
+          {
+            port_pointer->edge_counter->n_samples.fetch_add (1, std::memory_order_relaxed);
+            receive (*port_pointer, std::move(sample), std::move(aux_data));
+          }
+        --port_pointer->n_active_senders;
+      };
+
+      auto batch_slot = [this, port_pointer](const std::vector<OutputType> &samples,
+                                             const std::vector<AuxiliaryData> &aux_data)
+      {
+        ++port_pointer->n_active_senders;
+        if (port_pointer->is_connected.load() == true)
+          {
+            port_pointer->edge_counter->n_samples.fetch_add (samples.size(), std::memory_order_relaxed);
+            receive_batch (*port_pointer, samples, aux_data);
+          }
+        --port_pointer->n_active_senders;
+      };
+
+      auto flush_slot = [this, port_pointer]()
+      {
+        ++port_pointer->n_active_senders;
+        if (port_pointer->is_connected.load() == true)
+          {
+            send_buffer (*port_pointer);
+            this->flush_consumers();
+          }
+        --port_pointer->n_active_senders;
+      };
+
+      auto disconnect_slot = [this](const Producer<OutputType> &p)
+      {
+        disconnect_from_producer (p);
+      };
+
+      const auto connection = producer.connect_to_signals (sample_slot,
+                                                           batch_slot,
+                                                           flush_slot,
+                                                           disconnect_slot);
+      port->producer    = connection.first;
+      port->connections = connection.second;
+
+      {
+        std::lock_guard<std::mutex> lock (ports_mutex);
+        assert (ports.contains (connection.first) == false);
+        ports.emplace (connection.first, std::move(port));
+      }
+
+      connection.first->register_downstream_node (this, port_pointer->edge_counter);
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::disconnect_from_producer (const Producer<OutputType> &producer)
+    {
+      std::unique_ptr<Port> port;
+      {
+        std::lock_guard<std::mutex> lock (ports_mutex);
+        const auto p = ports.find (&producer);
+        if (p == ports.end())
+          return;
+        port = std::move (p->second);
+        ports.erase (p);
+      }
+
+      close (*port);
+      this->flush_consumers();
+    }
+
+
+
+    template <typename OutputType>
+    std::size_t
+    FanIn<OutputType>::n_producers () const
+    {
+      std::lock_guard<std::mutex> lock (ports_mutex);
+      return ports.size();
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::flush ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (ports_mutex);
+        for (auto &p : ports)
+          send_buffer (*p.second);
+      }
+      this->flush_consumers();
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::add_to_graph (PipelineGraph::Graph &graph) const
+    {
+      if (graph.contains (graph_node_id()))
+        return;
+
+      PipelineGraph::Node node;
+      node.object    = graph_node_id();
+      node.type_name = PipelineGraph::demangled_type_name (typeid(*this));
+      node.kind      = PipelineGraph::NodeKind::filter;
+      graph.nodes.push_back (node);
+
+      this->add_downstream_nodes_to_graph (graph);
+    }
+
+
+
+    template <typename OutputType>
+    const void *
+    FanIn<OutputType>::graph_node_id () const
+    {
+      return dynamic_cast<const void *>(this);
+    }
+
+
+
+    template <typename OutputType>
+    bool
+    FanIn<OutputType>::requests_aux_data (const AuxiliaryData::Key &key) const
+    {
+      return this->aux_data_requested (key);
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::receive_announcement (const SampleShape &shape)
+    {
+      this->announce_samples (SampleShape {shape.n_components, {}});
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::receive (Port &port,
+                                OutputType &&sample,
+                                AuxiliaryData &&aux_data)
+    {
+      std::vector<OutputType>    full_samples;
+      std::vector<AuxiliaryData> full_aux_data;
+      {
+        std::lock_guard<std::mutex> lock (port.mutex);
+        port.samples.emplace_back (std::move(sample));
+        port.aux_data.emplace_back (std::move(aux_data));
+
+        if (port.samples.size() < batch_size)
+          return;
+
+        // Take the full buffer out of the port and leave an empty one
+        // with the same capacity behind:
+        full_samples.reserve (batch_size);
+        full_aux_data.reserve (batch_size);
+        full_samples.swap (port.samples);
+        full_aux_data.swap (port.aux_data);
+      }
+
+      this->issue_batch (full_samples, full_aux_data);
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::receive_batch (Port &port,
+                                      const std::vector<OutputType> &samples,
+                                      const std::vector<AuxiliaryData> &aux_data)
+    {
+      assert (samples.size() == aux_data.size());
+
+      bool                       pass_on = false;
+      std::vector<OutputType>    full_samples;
+      std::vector<AuxiliaryData> full_aux_data;
+      {
+        std::lock_guard<std::mutex> lock (port.mutex);
+
+        // Large batches can be passed on as they are, as long as no
+        // earlier samples of the same producer are still waiting in the
+        // buffer:
+        if ((port.samples.size() == 0) && (samples.size() >= batch_size))
+          pass_on = true;
+        else
+          {
+            port.samples.insert (port.samples.end(), samples.begin(), samples.end());
+            port.aux_data.insert (port.aux_data.end(), aux_data.begin(), aux_data.end());
+
+            if (port.samples.size() < batch_size)
+              return;
+
+            full_samples.reserve (batch_size);
+            full_aux_data.reserve (batch_size);
+            full_samples.swap (port.samples);
+            full_aux_data.swap (port.aux_data);
+          }
+      }
+
+      if (pass_on)
+        this->issue_batch (samples, aux_data);
+      else
+        this->issue_batch (full_samples, full_aux_data);
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::send_buffer (Port &port)
+    {
+      std::vector<OutputType>    buffered_samples;
+      std::vector<AuxiliaryData> buffered_aux_data;
+      {
+        std::lock_guard<std::mutex> lock (port.mutex);
+        if (port.samples.size() == 0)
+          return;
+
+        buffered_samples.reserve (batch_size);
+        buffered_aux_data.reserve (batch_size);
+        buffered_samples.swap (port.samples);
+        buffered_aux_data.swap (port.aux_data);
+      }
+
+      this->issue_batch (buffered_samples, buffered_aux_data);
+    }
+
+
+
+    template <typename OutputType>
+    void
+    FanIn<OutputType>::close (Port &port)
+    {
+      port.is_connected = false;
+
+      std::get<0>(port.connections).disconnect ();
+      std::get<1>(port.connections).disconnect ();
+      std::get<2>(port.connections).disconnect ();
+      std::get<3>(port.connections).disconnect ();
+      port.producer->unregister_downstream_node (this);
+
+      while (port.n_active_senders.load() > 0)
+        std::this_thread::yield();
+
+      send_buffer (port);
+    }
+  }
+}
@@ -0,0 +1,322 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the Hamiltonian Monte Carlo algorithm (HMC, also
+     * known as "hybrid Monte Carlo"; see @cite Neal2011 for an
+     * introduction). The algorithm interprets $U(x)=-\log(\pi(x))$ as the
+     * potential energy of a particle at position $x$, and in each step
+     * draws a random momentum $p$ from a standard normal distribution
+     * and follows the trajectory of the particle under the Hamiltonian
+     * dynamics defined by the total energy
+     * @f{align*}{
+     *   H(x,p) = U(x) + \frac 12 \|p\|^2
+     * @f}
+     * for some time. The end point of the trajectory is the trial sample.
+     * Since the exact dynamics conserve $H$, and since the trajectory is
+     * computed with the symplectic and time-reversible "leapfrog" scheme
+     * that nearly conserves it, trial samples can be very far from the
+     * current sample and are nevertheless accepted with high probability:
+     * The trial sample $\tilde x$ with momentum $\tilde p$ at the end of
+     * the trajectory is accepted with probability
+     * $\min\{1,\exp(H(x,p)-H(\tilde x,\tilde p))\}$.
+     *
+     * A leapfrog step of size $\varepsilon$ updates position and momentum
+     * as
+     * @f{align*}{
+     *   p &\leftarrow p + \frac{\varepsilon}{2}\nabla\log(\pi(x)), \\
+     *   x &\leftarrow x + \varepsilon p, \\
+     *   p &\leftarrow p + \frac{\varepsilon}{2}\nabla\log(\pi(x)),
+     * @f}
+     * and the trajectory consists of $L$ such steps, with the two
+     * half-steps for the momentum between consecutive steps merged. Each
+     * step of the algorithm therefore requires $L$ evaluations of the
+     * likelihood and its gradient, provided by one function of type
+     * types::LogLikelihoodAndGradient; the gradient at the current sample
+     * is retained from the previous step. All vectors the algorithm works
+     * on (the current position and its gradient, the position along the
+     * trajectory and its gradient, and the momentum) are allocated once at
+     * the beginning of sample(), and the leapfrog steps do not allocate
+     * memory.
+     *
+     * If the trajectory enters a region of zero probability, it is
+     * abandoned and the trial sample is rejected.
+     *
+     * The length $\varepsilon L$ of the trajectories should not be close
+     * to a multiple of half the period with which the Hamiltonian dynamics
+     * oscillate in some direction: For a Gaussian with standard deviation
+     * $\sigma$ in that direction, such trajectories end close to where
+     * they started (or its mirror image), and the samples then explore the
+     * distribution only slowly in that direction.
+     *
+     * The AuxiliaryData object sent along with each sample stores the same
+     * entries as are described for the MetropolisHastings class.
+     *
+     * @tparam OutputType The type of the samples. This type must represent
+     *   elements of a vector space with real-valued elements that can be
+     *   accessed via the functions in namespace Utilities, as for the
+     *   Consumers::CovarianceMatrix class.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used for the momenta and for deciding whether trial samples are
+     *   accepted. See the documentation of the MetropolisHastings class
+     *   for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class HamiltonianMonteCarlo : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generator used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The step size $\varepsilon$ of the leapfrog scheme. Its optimal
+           * value depends on the scale of the distribution being sampled,
+           * and decreases like $d^{-1/4}$ with the dimension $d$ of the
+           * sample space. Good step sizes are ones for which about 65% of
+           * the trial samples are accepted.
+           */
+          double step_size = 0.1;
+
+          /**
+           * The number $L$ of leapfrog steps that make up a trajectory.
+           */
+          unsigned int n_leapfrog_steps = 10;
+        };
+
+        /**
+         * Constructor.
+         */
+        HamiltonianMonteCarlo (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial sample $x_0$, it produces a sequence of samples $x_k$
+         * that are passed through the signal of the base class to
+         * Consumer objects.
+         *
+         * @param[in] starting_point The initial sample $x_0$. The likelihood
+         *   of this sample must be nonzero.
+         * @param[in] log_likelihood_and_gradient A function object that,
+         *   when called with a sample $x$, returns $\log(\pi(x))$ and
+         *   writes $\nabla\log(\pi(x))$ into its second argument. As for the
+         *   MetropolisHastings class, a returned value of
+         *   `-std::numeric_limits<double>::max()` or minus infinity
+         *   indicates that the sample has zero probability.
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function. This is also the number of times the
+         *   signal is called that notifies Consumer objects that a new
+         *   sample is available.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const types::LogLikelihoodAndGradient<OutputType> &log_likelihood_and_gradient,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+
+        /**
+         * Perform the operation $a \leftarrow a + s b$ element by element,
+         * without creating temporary objects.
+         */
+        static
+        void
+        add_scaled (OutputType       &a,
+                    const double      s,
+                    const OutputType &b);
+
+        /**
+         * Return the kinetic energy $\frac 12 \|p\|^2$ that corresponds to
+         * the momentum $p$.
+         */
+        static
+        double
+        kinetic_energy (const OutputType &p);
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    HamiltonianMonteCarlo<OutputType,RandomNumberGenerator>::
+    HamiltonianMonteCarlo (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert (parameters.step_size > 0);
+      assert (parameters.n_leapfrog_steps >= 1);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    HamiltonianMonteCarlo<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const types::LogLikelihoodAndGradient<OutputType> &log_likelihood_and_gradient,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const double       step_size        = parameters.step_size;
+      const unsigned int n_leapfrog_steps = parameters.n_leapfrog_steps;
+      const std::size_t  dimension        = Utilities::size(starting_point);
+
+      const auto has_zero_probability = [](const double log_likelihood)
+      {
+        return ((log_likelihood == -std::numeric_limits<double>::max())
+                ||
+                (log_likelihood == -std::numeric_limits<double>::infinity()));
+      };
+
+      // Allocate the vectors for the current sample, the position along
+      // the trajectory, their gradients, and the momentum once; all of the
+      // following steps only work on their elements, or swap them.
+      OutputType current_sample   = starting_point;
+      OutputType current_gradient = starting_point;
+      double     current_log_likelihood
+        = log_likelihood_and_gradient (current_sample, current_gradient);
+      assert (has_zero_probability (current_log_likelihood) == false);
+
+      OutputType trial_sample   = starting_point;
+      OutputType trial_gradient = starting_point;
+      OutputType momentum       = starting_point;
+
+      std::normal_distribution<>       normal_distribution(0,1);
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      for (types::sample_index i=0; (i<n_samples) && (this->stop_requested() == false); ++i)
+        {
+          // Draw a momentum and compute the energy at the start of the
+          // trajectory:
+          for (std::size_t n=0; n<dimension; ++n)
+            Utilities::get_nth_element (momentum, n) = normal_distribution(rng);
+          const double initial_energy = -current_log_likelihood + kinetic_energy (momentum);
+
+          // Follow the trajectory. We start with the first half-step for
+          // the momentum, and then merge the second half-step of each
+          // leapfrog step with the first half-step of the next one.
+          trial_sample   = current_sample;
+          trial_gradient = current_gradient;
+          double trial_log_likelihood = current_log_likelihood;
+
+          add_scaled (momentum, step_size/2, trial_gradient);
+          for (unsigned int l=0; l<n_leapfrog_steps; ++l)
+            {
+              add_scaled (trial_sample, step_size, momentum);
+              trial_log_likelihood = log_likelihood_and_gradient (trial_sample, trial_gradient);
+              if (has_zero_probability (trial_log_likelihood))
+                break;
+
+              add_scaled (momentum,
+                          (l < n_leapfrog_steps-1 ? step_size : step_size/2),
+                          trial_gradient);
+            }
+
+          // Then accept or reject the end point of the trajectory:
+          bool accepted_sample = false;
+          if (has_zero_probability (trial_log_likelihood) == false)
+            {
+              const double final_energy = -trial_log_likelihood + kinetic_energy (momentum);
+              const double log_acceptance_ratio = initial_energy - final_energy;
+              accepted_sample = ((log_acceptance_ratio >= 0)
+                                 ||
+                                 (std::exp(log_acceptance_ratio) >= uniform_distribution(rng)));
+            }
+
+          if (accepted_sample)
+            {
+              std::swap (current_sample, trial_sample);
+              std::swap (current_gradient, trial_gradient);
+              current_log_likelihood = trial_log_likelihood;
+            }
+
+          // Output the new sample (which may be equal to the old sample).
+          this->issue_sample (current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)}
+          });
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    HamiltonianMonteCarlo<OutputType,RandomNumberGenerator>::
+    add_scaled (OutputType       &a,
+                const double      s,
+                const OutputType &b)
+    {
+      const std::size_t dimension = static_cast<std::size_t>(Utilities::size(a));
+      for (std::size_t n=0; n<dimension; ++n)
+        Utilities::get_nth_element (a, n) += s * Utilities::get_nth_element (b, n);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    HamiltonianMonteCarlo<OutputType,RandomNumberGenerator>::
+    kinetic_energy (const OutputType &p)
+    {
+      const std::size_t dimension = static_cast<std::size_t>(Utilities::size(p));
+      double norm_squared = 0;
+      for (std::size_t n=0; n<dimension; ++n)
+        norm_squared += Utilities::get_nth_element (p, n) * Utilities::get_nth_element (p, n);
+      return norm_squared / 2;
+    }
+  }
+}
@@ -16,14 +16,34 @@
 #ifndef SAMPLEFLOW_PRODUCERS_METROPOLIS_HASTINGS_H
 #define SAMPLEFLOW_PRODUCERS_METROPOLIS_HASTINGS_H
 
+#include <sampleflow/checkpointer.h>
+#include <sampleflow/coroutines.h>
+#include <sampleflow/instrumentation.h>
 #include <sampleflow/producer.h>
+#include <sampleflow/pull_range.h>
+#include <sampleflow/random.h>
 #include <sampleflow/scope_exit.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/tracing.h>
 #include <sampleflow/types.h>
+#include <sampleflow/thread_pool.h>
 
+#include <algorithm>
 #include <random>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <future>
+#include <span>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/producers/metropolis_hastings.impl.h>
@@ -42,14 +42,21 @@ namespace SampleFlow
      * Producer::connect_to_signal() or using Consumer::connect_to_producer())
      * one at a time. The AuxiliaryData object associated with each sample
      * $x_k$ stores two entries:
-     * - An entry with name "relative log likelihood" of type
+     * - An entry with name "relative log likelihood" (i.e., with key
+     *   AuxiliaryData::relative_log_likelihood) of type
      *   `double` that stores $\log(\pi(x_k))$;
-     * - An entry with name "sample is repeated" that stores a `bool`
+     * - An entry with name "sample is repeated" (i.e., with key
+     *   AuxiliaryData::sample_is_repeated) that stores a `bool`
      *   indicating whether the algorithm has chosen the current
      *   sample as an accepted trial sample (if `false`) or whether
      *   it is a repeated sample because the trial sample has been
      *   rejected (if `true`).
      *
+     * These entries (as well as the chain numbers and timings discussed
+     * below) are only created if at least one of the objects connected to
+     * the sampler may look at them, see Producer::aux_data_requested() and
+     * Consumer::used_aux_data_keys().
+     *
      *
      * <h3>Example 1: A discrete sample space</h3>
      *
@@ -340,6 +347,18 @@ namespace SampleFlow
      * That said, the recommendation to choose these `delta` values in such
      * a way to achieve an overall acceptance ratio of 0.234 remains in place.
      *
+     * Proposal functions of this kind, with the same standard deviation for
+     * all components, a separate one for each component, or a general
+     * covariance matrix, are implemented by the
+     * Proposals::GaussianRandomWalk class; for problems with a Gaussian
+     * prior, the Proposals::PreconditionedCrankNicolson class implements
+     * a proposal whose acceptance ratio does not degrade with the number
+     * of components. Objects of these classes can be passed directly as
+     * the `propose_sample` argument of sample() and sample_chains(), and
+     * generate the random numbers they need in blocks and without
+     * allocating memory, which makes them considerably faster than the
+     * functions above for samples with many components.
+     *
      *
      * <h3>Adaptive Metropolis for continuous variables</h3>
      *
@@ -476,8 +495,84 @@ namespace SampleFlow
      * draw samples from `std::complex` numbers, quaternions, graphs, or,
      * in essence, any other data type for which one can define the necessary
      * operations mentioned above.
+     *
+     *
+     * <h3>Random number generators</h3>
+     *
+     * By default, the class uses a `std::mt19937` object to decide whether
+     * trial samples are accepted, and passes one such object per chain to
+     * the `propose_sample` function of sample_chains(). The second template
+     * argument allows using a different generator. This is useful in
+     * particular when running many chains: The generators in namespace
+     * Random, for example Random::Philox4x32 or Random::Xoshiro256PlusPlus,
+     * take up only a few dozen bytes rather than the 2.5 kB of a
+     * `std::mt19937` object, and can create the independent streams of
+     * random numbers used by the different chains much more cheaply and
+     * with a guarantee that they do not overlap:
+     * @code
+     *   using Sampler = SampleFlow::Producers::MetropolisHastings<double,SampleFlow::Random::Philox4x32>;
+     *   Sampler mh_sampler;
+     *   mh_sampler.sample_chains (starting_points,
+     *                             &log_likelihood,
+     *                             [](const double x, SampleFlow::Random::Philox4x32 &rng)
+     *                             {
+     *                               return std::make_pair (x + std::normal_distribution<double>(0,1)(rng),
+     *                                                      1.0);
+     *                             },
+     *                             n_samples_per_chain);
+     * @endcode
+     *
+     *
+     * <h3>Checkpointing</h3>
+     *
+     * Long-running sampling jobs, for example ones that run on a cluster
+     * with a limit on the run time of jobs, may need to be interrupted and
+     * continued later. To make this possible, the class can write the
+     * state of its chains (see the ChainState structure) to a checkpoint
+     * every so many steps, if Parameters::checkpointer is set:
+     * @code
+     *   SampleFlow::Producers::MetropolisHastings<double>::Parameters parameters;
+     *   parameters.checkpointer        = std::make_shared<SampleFlow::Checkpointer>("chain.checkpoint");
+     *   parameters.checkpoint_interval = 100000;
+     *
+     *   SampleFlow::Producers::MetropolisHastings<double> mh_sampler (parameters);
+     *   mh_sampler.sample (1., &log_likelihood, &propose_sample, n_samples);
+     * @endcode
+     * If the program is interrupted, then a new program can continue the
+     * chain from the last checkpoint:
+     * @code
+     *   mh_sampler.resume (SampleFlow::Checkpointer::read ("chain.checkpoint"),
+     *                      &log_likelihood, &propose_sample, n_samples);
+     * @endcode
+     * Here, `n_samples` is the total number of steps the chain should take,
+     * including the ones it has taken before the checkpoint was written.
+     * The resumed chain then continues with exactly the same samples as
+     * if it had never been interrupted. (If the program was terminated
+     * between two checkpoints, then the samples produced after the last
+     * checkpoint are of course produced a second time by the resumed
+     * chain; consumers that were connected to the first program do not
+     * know about them.) The same works for several chains using the
+     * resume_chains() functions.
+     *
+     * The checkpoint contains the random number generators of the chains,
+     * but the class does not know about any other source of randomness.
+     * For the resumed chain to be identical to the uninterrupted one,
+     * `propose_sample` therefore has to draw its random numbers from
+     * the generator it is given by sample_chains() and resume_chains(),
+     * rather than from a generator of its own. (For the single chain run
+     * by sample() and resume(), the proposal function does not get to
+     * see a generator, and so resumed chains only continue in exactly
+     * the same way if the proposal function is deterministic or if the
+     * state of its generator is saved and restored separately.)
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator.
+     *   It needs to satisfy the `std::uniform_random_bit_generator` concept,
+     *   and to have a `seed()` function that takes an argument of type
+     *   `RandomNumberGenerator::result_type`.
      */
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     class MetropolisHastings : public Producer<OutputType>
     {
       public:
@@ -491,7 +586,169 @@ namespace SampleFlow
            * A random seed to be used to initialize the random number
            * generators used by the sampling algorithm.
            */
-          std::mt19937::result_type random_seed = {};
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * Whether to send each sample downstream only once, rather than
+           * once for every step, even if the chain stays at the same sample
+           * for several steps because trial samples are rejected. If this
+           * is set, then a sample is only sent once the chain has moved on
+           * from it (or when sampling ends), and its AuxiliaryData object
+           * carries an additional entry with key
+           * AuxiliaryData::repetition_count that stores the number of steps
+           * $m$ for which the chain stayed at the sample. The "sample is
+           * repeated" entry then indicates whether the first of these steps
+           * was a rejected one, which is only ever the case for the
+           * starting point.
+           *
+           * Consumers that compute statistics, such as
+           * Consumers::MeanValue, Consumers::CovarianceMatrix,
+           * Consumers::Histogram, Consumers::PairHistogram, and
+           * Consumers::CountSamples, treat such a sample as $m$ copies of
+           * the sample, but process it at the cost of one, and filters such
+           * as Filters::TakeEveryNth and Filters::DiscardFirstN count
+           * samples accordingly. In other words, the sample stream is
+           * "run-length encoded". If only a small fraction of trial samples
+           * is accepted, this saves most of the work of sending samples
+           * downstream and processing them. On the other hand, consumers
+           * that do not know about repetition counts see a sequence of
+           * distinct samples.
+           */
+          bool compress_repeated_samples = false;
+
+          /**
+           * The number given to the first chain run by the sample_chains()
+           * functions. The chains started by these functions are numbered
+           * consecutively starting at this number, and this number is what
+           * is stored in the AuxiliaryData::chain_number entry of their
+           * samples and used to select the random number stream of each
+           * chain. Setting this to a value other than zero allows several
+           * objects of this class, for example on different machines (see
+           * MPI::Producers::MetropolisHastings), to each run a part of a
+           * larger set of chains, in such a way that each chain produces
+           * the same samples as if all chains were run by the same object.
+           */
+          std::size_t first_chain_number = 0;
+
+          /**
+           * An object that writes checkpoints of the state of the chains to
+           * a file. If this is set, then the functions of this class that
+           * run chains write the states of all of their chains to a
+           * checkpoint every `checkpoint_interval` steps of a chain (unless
+           * `checkpoint_interval` is zero) and once more when sampling
+           * ends. A checkpoint is the result of converting a
+           * `std::vector<ChainState>` with one element per chain into
+           * bytes using Serialization::write(). Sampling can later be
+           * continued from such a checkpoint using the resume() and
+           * resume_chains() functions. The file is written on a separate
+           * thread, so that the chains are not held up by it; see the
+           * Checkpointer class. Checkpoints can only be written if
+           * `OutputType` is one of the types Serialization::write() knows
+           * how to deal with (see Serialization::is_serializable()).
+           */
+          std::shared_ptr<Checkpointer> checkpointer;
+
+          /**
+           * The number of steps of a chain between two checkpoints. See
+           * `checkpointer`.
+           */
+          types::sample_index checkpoint_interval = 0;
+
+          /**
+           * Whether to measure how long each call of the likelihood
+           * function and of the function that proposes trial samples
+           * takes. If this is set, the timings are accumulated in the
+           * statistics returned by get_sampler_statistics(), and each
+           * sample sent downstream carries entries with keys
+           * AuxiliaryData::likelihood_evaluation_time and
+           * AuxiliaryData::proposal_time that store the times for the
+           * step that produced it. There are two exceptions to the
+           * latter: If `compress_repeated_samples` is set, samples stand
+           * for several steps and do not carry these entries; and if the
+           * likelihoods of several chains are evaluated as one batch
+           * (see sample_chains()), each chain is attributed the time of
+           * the whole batch divided by the number of chains, both in the
+           * entries of its samples and in the statistics. For the
+           * sample_chains() function that runs chains as coroutines, the
+           * time of an evaluation is the time from starting it until the
+           * chain resumes with its result.
+           */
+          bool record_timings = false;
+
+          /**
+           * The number of steps a chain takes in one task when the
+           * sample_chains() and resume_chains() functions run chains on a
+           * thread pool. If this is zero (the default), then each chain is
+           * run to completion by a single task, and so stays with the
+           * worker thread that started it. Otherwise, a task advances its
+           * chain by `grain_size` steps and then enqueues another task
+           * for the next steps of the chain. If the cost of evaluating the
+           * likelihood varies between regions of parameter space, some
+           * chains take much longer than others; the pool's work stealing
+           * then lets idle threads pick up the pending steps of whichever
+           * chains are ready next, rather than waiting for the threads
+           * that happen to run the slow chains. Small values balance the
+           * load better but cost one task per `grain_size` steps. Since
+           * each chain keeps its own random number generator and its
+           * steps are still taken one after the other, the samples of each
+           * chain do not depend on this parameter.
+           */
+          types::sample_index grain_size = 0;
+        };
+
+        /**
+         * A structure that describes the state of a chain between two
+         * steps, i.e., everything that is needed to continue the chain in
+         * exactly the same way as if it had not been interrupted. Objects
+         * of this type are what is stored in the checkpoints described in
+         * the documentation of Parameters::checkpointer.
+         */
+        struct ChainState
+        {
+          /**
+           * The sample the chain is currently at.
+           */
+          OutputType current_sample;
+
+          /**
+           * The log likelihood of the current sample. This is NaN if the
+           * chain has not started yet, and so the likelihood of its
+           * starting point has not been evaluated yet.
+           */
+          double current_log_likelihood;
+
+          /**
+           * The random number generator of the chain.
+           */
+          RandomNumberGenerator rng;
+
+          /**
+           * The number of steps the chain has taken so far.
+           */
+          types::sample_index n_steps;
+
+          /**
+           * If Parameters::compress_repeated_samples is set, the number of
+           * steps for which the chain has stayed at the current sample
+           * without the sample having been sent downstream yet, and
+           * whether the first of these steps was a rejection.
+           */
+          types::sample_index n_repetitions;
+          bool                first_repetition_is_repeated;
+
+          /**
+           * Append the binary representation of this object to the given
+           * buffer. See namespace Serialization.
+           */
+          void
+          save (std::vector<char> &buffer) const;
+
+          /**
+           * Read the object from the binary representation at the beginning
+           * of the given buffer. See namespace Serialization.
+           */
+          void
+          load (std::span<const char> &buffer);
         };
 
 
@@ -575,117 +832,1855 @@ namespace SampleFlow
                 const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
                 const types::sample_index n_samples);
 
-      private:
+        /**
+         * Like the previous function, but taking arbitrary function objects
+         * for the log likelihood and the proposal, rather than
+         * `std::function` objects. Because the types of these objects are
+         * known to the compiler, calls to them can be inlined into the loop
+         * that produces the samples. This makes a real difference if both
+         * functions are cheap to evaluate, as is the case for many analytic
+         * test distributions.
+         *
+         * In addition to a function object with the same signature as for
+         * the previous function, `propose_sample` can be a function object
+         * with the signature
+         * @code
+         *   double propose_sample (const OutputType &x, OutputType &trial_sample);
+         * @endcode
+         * This function has to write the trial sample $\tilde x$ into its
+         * second argument, and return the ratio of proposal probabilities
+         * as described for the previous function. The object passed as
+         * second argument is one that the sampler keeps around from one
+         * step to the next and that holds a previous (trial or current)
+         * sample. As a consequence, if `OutputType` is, for example, a
+         * vector whose elements are allocated on the heap, then the
+         * sampler does not need to allocate memory for the trial sample
+         * in every step, as long as the function overwrites the elements
+         * of its second argument rather than assigning a new vector to it.
+         *
+         * For the same sequence of random numbers drawn by
+         * `propose_sample`, this function produces the same samples as the
+         * previous one.
+         */
+        template <typename LogLikelihood, typename ProposeSample>
+        requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
+                  &&
+                  (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
+                   ||
+                   std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+        void
+        sample (const OutputType &starting_point,
+                const LogLikelihood &log_likelihood,
+                const ProposeSample &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Return a lazily evaluated range of the samples of a Markov chain
+         * that starts at the given point. Rather than producing a given
+         * number of samples before returning, as sample() does, this
+         * function returns right away, and the chain only takes a step
+         * whenever the iterator of the returned range is advanced (see the
+         * PullRange class). The samples are also sent to the consumers
+         * connected to the current object, as they are produced. One can
+         * therefore drive a chain from one's own loop, interleave several
+         * chains on the same thread, or combine the chain with the range
+         * adaptors of the C++ standard library:
+         * @code
+         *   for (const auto &[sample, aux_data]
+         *        : mh_sampler.pull (starting_point, log_likelihood, perturb)
+         *          | std::views::take (1000))
+         *     ...
+         * @endcode
+         * The range is infinite; it ends only if request_stop() is called.
+         *
+         * @param[in] starting_point The starting point of the chain.
+         * @param[in] log_likelihood The function that evaluates the log
+         *   likelihood of a sample, as for sample().
+         * @param[in] propose_sample The function that proposes trial
+         *   samples, with either of the two signatures allowed for
+         *   sample().
+         * @param[in] chain If given, the chain uses the random number
+         *   stream of the chain with this number (as the chains run by
+         *   sample_chains() do), and this number is added to the auxiliary
+         *   data of each sample under the key AuxiliaryData::chain_number.
+         *   This allows pulling several independent chains out of the
+         *   same object. Otherwise, the chain starts with (a copy of) the
+         *   random number generator of the current object, and so
+         *   produces the same samples as a call to sample() would.
+         * @return The range of samples, along with their auxiliary data.
+         *   The functions passed as arguments are copied into the range,
+         *   and the current object must remain alive for as long as the
+         *   range is used.
+         *
+         * @note Since every step of the chain is taken separately, the
+         *   samples a chain sends downstream are never compressed, even if
+         *   Parameters::compress_repeated_samples is set.
+         */
+        template <typename LogLikelihood, typename ProposeSample>
+        requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
+                  &&
+                  (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
+                   ||
+                   std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+        PullRange<OutputType>
+        pull (const OutputType                 &starting_point,
+              const LogLikelihood              &log_likelihood,
+              const ProposeSample              &propose_sample,
+              const std::optional<std::size_t>  chain = {});
+
+        /**
+         * Run several independent Markov chains in parallel on the worker
+         * threads of a ThreadPool, one chain per starting point given.
+         * Each chain works in exactly the same way as the one run by the
+         * sample() function, and each sends its samples to the consumers
+         * connected to the current object as they are produced. Samples
+         * from different chains are therefore interleaved in a
+         * non-deterministic order, and consumers connected to this
+         * object must be able to deal with samples that arrive
+         * concurrently from different threads. The AuxiliaryData object
+         * sent along with each sample carries, in addition to the entries
+         * listed in the documentation of this class, an entry with key
+         * AuxiliaryData::chain_number of type `std::size_t` that indicates
+         * which chain the sample belongs to; consumers that care about the
+         * order of samples can use it to separate the chains again.
+         *
+         * Each chain uses its own random number generator. The generator of
+         * chain $c$ (counting from Parameters::first_chain_number) is the
+         * stream with number $c$ for the seed Parameters::random_seed, as created by Random::create_stream(), so
+         * that the samples of each chain are reproducible and independent of how
+         * the chains are scheduled on the threads of the pool.
+         *
+         * @param[in] starting_points The initial samples $x_{c,0}$ of the
+         *   chains. The number of elements of this vector determines the
+         *   number of chains.
+         * @param[in] log_likelihood A function object that returns
+         *   $\log(\pi(x))$ as for the sample() function. It is called
+         *   concurrently from the threads that run the chains, and so needs
+         *   to be reentrant.
+         * @param[in] propose_sample A function object with the same meaning as
+         *   for the sample() function, but that receives the random number
+         *   generator of the chain it is called for as second argument. It
+         *   should use this generator, rather than a global or `static` one,
+         *   for all of its random draws: The function is called concurrently
+         *   from different threads, and using the chain's generator also
+         *   makes the sequence of samples of each chain reproducible.
+         * @param[in] n_samples_per_chain The number of samples each chain
+         *   produces.
+         * @param[in] thread_pool The pool on which the chains are run. By
+         *   default, this is the pool returned by ThreadPool::default_pool().
+         *   If the pool has fewer threads than there are chains, then some
+         *   chains only start once others have finished, unless
+         *   Parameters::grain_size is set, in which case the threads
+         *   share the steps of all chains among themselves as they become
+         *   available.
+         */
+        void
+        sample_chains (const std::vector<OutputType> &starting_points,
+                       const std::function<double (const OutputType &)> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain,
+                       const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once.
+         * Rather than running the chains independently on a thread pool,
+         * this function advances all chains in lockstep on the current
+         * thread: In each step, it creates a trial sample for every chain,
+         * evaluates the likelihoods of all of these trial samples with one
+         * call to `log_likelihood`, and then sends the new samples of all
+         * chains downstream as one batch (see Producer::issue_batch). This
+         * is the appropriate choice if the likelihood can be evaluated much
+         * more efficiently for many samples at once than for one sample at a
+         * time, for example on a GPU. Any parallelism is then up to the
+         * function object that evaluates the likelihood.
+         *
+         * The random number generator of each chain and the auxiliary data
+         * of each sample are the same as for the previous function. As a
+         * consequence, for the same arguments, each chain produces exactly
+         * the same sequence of samples as with the previous function.
+         *
+         * @param[in] starting_points The initial samples $x_{c,0}$ of the
+         *   chains. The number of elements of this vector determines the
+         *   number of chains.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sequence of samples $x_j$, writes $\log(\pi(x_j))$ into the
+         *   corresponding elements of its second argument. See
+         *   types::BatchLogLikelihood.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] n_samples_per_chain The number of samples each chain
+         *   produces.
+         */
+        void
+        sample_chains (const std::vector<OutputType> &starting_points,
+                       const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain);
+
+        /**
+         * Like the previous function, but using a function object that only
+         * starts the evaluation of the log likelihood for a sample, and
+         * returns a `std::future` object from which the result can be
+         * obtained later. In each step, this function starts the
+         * evaluations for the trial samples of all chains before it waits
+         * for any of the results. This allows having as many evaluations
+         * in flight at the same time as there are chains -- for example, if
+         * the likelihood is evaluated on a remote machine -- while running
+         * all chains on the current thread.
+         *
+         * For the same arguments, this function produces the same chains
+         * as the previous two functions.
+         *
+         * @param[in] starting_points See the previous function.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sample $x$, returns a future for $\log(\pi(x))$. See
+         *   types::AsynchronousLogLikelihood.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] n_samples_per_chain See the previous function.
+         */
+        void
+        sample_chains (const std::vector<OutputType> &starting_points,
+                       const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain);
+
+        /**
+         * Like the previous function, but rather than advancing all chains
+         * in lockstep, run each chain as a coroutine on the given scheduler
+         * (see namespace Coroutines). A chain that waits for the result of
+         * the evaluation of the likelihood of its trial sample is suspended
+         * until the result is available, and the worker thread it ran on
+         * can advance other chains in the meantime. Each chain therefore
+         * moves on as soon as its own result is available, rather than
+         * waiting for the slowest of the evaluations of all chains in each
+         * step, and many more chains than there are worker threads can
+         * have evaluations in flight at the same time.
+         *
+         * As for the function that runs chains on a thread pool, the
+         * samples of the different chains are sent downstream from the
+         * worker threads of the pool, in an order that depends on when the
+         * evaluations finish. The function returns once all chains have
+         * finished (in fact, once all coroutines running on the scheduler
+         * have finished; see Coroutines::Scheduler::wait()) and the
+         * consumers have been flushed. For the same arguments, each chain
+         * produces the same sequence of samples as with the previous
+         * functions.
+         *
+         * @param[in] starting_points See the previous function.
+         * @param[in] log_likelihood See the previous function. Since the
+         *   function object is called from the worker threads of the pool,
+         *   it needs to be reentrant.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] n_samples_per_chain See the previous function.
+         * @param[in] scheduler The scheduler on which the chains are run.
+         */
+        void
+        sample_chains (const std::vector<OutputType> &starting_points,
+                       const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain,
+                       Coroutines::Scheduler &scheduler);
+
+        /**
+         * Continue the chain whose state is stored in the given checkpoint,
+         * written by a previous call to sample() or resume(), until it has
+         * taken a total of `n_samples` steps. The chain continues in exactly
+         * the same way as if it had not been interrupted; see the
+         * discussion of checkpointing in the documentation of this class.
+         *
+         * @param[in] checkpoint A checkpoint written by sample() or resume()
+         *   because Parameters::checkpointer was set, for example as read
+         *   from a file via Checkpointer::read().
+         * @param[in] log_likelihood See sample().
+         * @param[in] propose_sample See sample().
+         * @param[in] n_samples The total number of steps the chain should
+         *   have taken once this function returns, including the ones
+         *   taken before the checkpoint was written. If the chain had
+         *   already taken this many steps, then no new samples are
+         *   produced.
+         */
+        template <typename LogLikelihood, typename ProposeSample>
+        requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
+                  &&
+                  (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
+                   ||
+                   std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+        void
+        resume (const std::vector<char> &checkpoint,
+                const LogLikelihood &log_likelihood,
+                const ProposeSample &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Continue the chains whose states are stored in the given
+         * checkpoint, written by a previous call to one of the
+         * sample_chains() or resume_chains() functions, until each of them
+         * has taken a total of `n_samples_per_chain` steps. The number of
+         * chains is the one stored in the checkpoint. This function runs
+         * the chains on a thread pool like the corresponding
+         * sample_chains() function, but can be used to continue chains
+         * started with any of the sample_chains() functions since all of
+         * them produce the same chains.
+         *
+         * @param[in] checkpoint A checkpoint written because
+         *   Parameters::checkpointer was set.
+         * @param[in] log_likelihood See sample_chains().
+         * @param[in] propose_sample See sample_chains().
+         * @param[in] n_samples_per_chain The total number of steps each
+         *   chain should have taken once this function returns, including
+         *   the ones taken before the checkpoint was written.
+         * @param[in] thread_pool See sample_chains().
+         */
+        void
+        resume_chains (const std::vector<char> &checkpoint,
+                       const std::function<double (const OutputType &)> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain,
+                       const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * Like the previous function, but advancing all chains in lockstep
+         * and evaluating the likelihoods of the trial samples of all chains
+         * as one batch, as the corresponding sample_chains() function does.
+         */
+        void
+        resume_chains (const std::vector<char> &checkpoint,
+                       const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain);
+
+        /**
+         * Like the previous function, but starting the evaluations of the
+         * likelihoods of the trial samples of all chains before waiting for
+         * any of them, as the corresponding sample_chains() function does.
+         */
+        void
+        resume_chains (const std::vector<char> &checkpoint,
+                       const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                       const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                       const types::sample_index n_samples_per_chain);
+
+        /**
+         * Decide whether a trial sample is accepted, given its log likelihood,
+         * the log likelihood of the current sample, and the ratio of proposal
+         * probabilities for the transition to the trial sample and back. If
+         * necessary, this function draws a random number from the given
+         * generator. This function implements the acceptance criterion
+         * described in the documentation of the sample() function, including
+         * the treatment of samples with zero probability. It is public so
+         * that other samplers that need the same criterion, such as
+         * AdaptiveMetropolisHastings, can use it.
+         */
+        static
+        bool
+        accept_trial_sample (const double trial_log_likelihood,
+                             const double current_log_likelihood,
+                             const double proposal_distribution_ratio,
+                             RandomNumberGenerator &chain_rng);
+
+        /**
+         * Return how often the likelihood function and the function that
+         * proposes trial samples have been called so far, and how long
+         * these calls took. The statistics are only collected if
+         * Parameters::record_timings is set, and otherwise all counters
+         * of the returned object are zero. They accumulate over all calls
+         * to the functions of this class that run chains.
+         */
+        Instrumentation::SamplerStatistics
+        get_sampler_statistics () const;
+
+      protected:
         /**
          * A variable that stores parameters controlling specific aspects of
          * sampling algorithm.
          */
         Parameters parameters;
 
+      private:
         /**
          * The random number generator used by the sampler.
          */
-        std::mt19937 rng;
+        RandomNumberGenerator rng;
+
+        /**
+         * The timings collected if Parameters::record_timings is set,
+         * kept per thread since chains may run on several threads.
+         */
+        ShardedAccumulator<Instrumentation::SamplerStatistics> sampler_statistics;
+
+        /**
+         * Add the given times for one proposal and one evaluation of the
+         * likelihood to the statistics returned by
+         * get_sampler_statistics() and, unless `aux_data` is a `nullptr`,
+         * to the given auxiliary data of a sample.
+         */
+        void
+        record_timings (const std::chrono::nanoseconds proposal_time,
+                        const std::chrono::nanoseconds likelihood_evaluation_time,
+                        AuxiliaryData *aux_data);
+
+        /**
+         * Add the given time for the evaluation of the likelihood of the
+         * starting point of a chain to the statistics returned by
+         * get_sampler_statistics().
+         */
+        void
+        record_starting_point_timing (const std::chrono::nanoseconds likelihood_evaluation_time);
+
+        /**
+         * A structure that records which of the entries of the auxiliary
+         * data of samples this class may provide are requested by the
+         * objects connected to it (see Producer::aux_data_requested()).
+         * The entry AuxiliaryData::repetition_count is always provided
+         * when repeated samples are compressed, since it is part of what
+         * a sample means.
+         */
+        struct RequestedAuxData
+        {
+          bool relative_log_likelihood = true;
+          bool sample_is_repeated      = true;
+          bool chain_number            = true;
+          bool timings                 = true;
+        };
+
+        /**
+         * The entries of the auxiliary data requested downstream. This is
+         * determined by update_requested_aux_data() whenever samples are
+         * about to be generated, so that sending a sample does not require
+         * asking the consumers again.
+         */
+        RequestedAuxData requested_aux_data;
+
+        /**
+         * Set the `requested_aux_data` member variable from the requests of
+         * the objects currently connected to this object.
+         */
+        void
+        update_requested_aux_data ();
+
+        /**
+         * Announce to the objects connected to this object how many samples
+         * the given chains will produce until each of them has taken the
+         * given number of steps, and how many components these samples
+         * have. See Producer::announce_samples().
+         */
+        void
+        announce_chain_samples (const std::span<const ChainState> chain_states,
+                                const types::sample_index         n_steps_per_chain);
+
+        /**
+         * Create the auxiliary data for a sample with the given log
+         * likelihood that is or is not a repetition of the previous sample
+         * of its chain, containing only the entries that are requested.
+         * If `chain` has a value, it is stored as the chain number.
+         */
+        AuxiliaryData
+        create_aux_data (const double log_likelihood,
+                         const bool sample_is_repeated,
+                         const std::optional<std::size_t> chain) const;
+
+        /**
+         * Advance the Markov chain with the given state until it has taken
+         * `n_samples` steps, using the random number generator stored in
+         * the state. This is the implementation of the sample(),
+         * sample_chains(), resume(), and resume_chains() functions. If
+         * `chain` is given, then its value is added to the auxiliary data
+         * of each sample under the key AuxiliaryData::chain_number. If
+         * `write_checkpoint` is not empty, it is called with the state of
+         * the chain every Parameters::checkpoint_interval steps and when
+         * the chain ends. If `finish` is `false`, then the chain is only
+         * advanced and is not considered ended after `n_samples` steps, so
+         * that a later call can continue it; the caller then needs to call
+         * finish_chain() once the chain has taken all of its steps.
+         *
+         * `propose_sample` is called with the current sample and the random
+         * number generator, and either returns the trial sample along with
+         * the ratio of proposal probabilities, or takes the object into
+         * which to write the trial sample as additional second argument and
+         * only returns the ratio.
+         */
+        template <typename LogLikelihood, typename ProposeSample>
+        void
+        run_chain (ChainState &state,
+                   const LogLikelihood &log_likelihood,
+                   const ProposeSample &propose_sample,
+                   const types::sample_index n_samples,
+                   const std::optional<std::size_t> chain,
+                   const std::function<void (const ChainState &)> &write_checkpoint,
+                   const bool finish = true);
+
+        /**
+         * Like run_chain(), but as a coroutine run by the given scheduler
+         * that waits for the results of the asynchronous evaluations of
+         * the likelihood via `co_await`. All arguments need to remain valid
+         * until the coroutine has finished.
+         */
+        Coroutines::Task
+        run_chain_as_coroutine (ChainState &state,
+                                const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                                const types::sample_index n_samples,
+                                const std::size_t chain,
+                                const std::function<void (const ChainState &)> &write_checkpoint,
+                                Coroutines::Scheduler &scheduler);
+
+        /**
+         * The pieces of one step of a chain, as used by run_chain() and
+         * run_chain_as_coroutine(): propose_trial_sample() creates a trial
+         * sample from the current sample of the chain with the given state,
+         * writes it into `trial_sample`, and returns the ratio of proposal
+         * probabilities. Once the likelihood of the trial sample is known,
+         * complete_step() decides whether the chain moves to the trial
+         * sample, sends the resulting sample downstream along with the
+         * times the proposal and the evaluation of the likelihood took (if
+         * Parameters::record_timings is set), and writes a checkpoint if
+         * one is due. Finally, finish_chain() sends the
+         * sample the chain ends at downstream if that has not happened yet
+         * because repeated samples are compressed, and records the state
+         * the chain ends in.
+         */
+        template <typename ProposeSample>
+        double
+        propose_trial_sample (ChainState &state,
+                              const ProposeSample &propose_sample,
+                              OutputType &trial_sample);
+
+        void
+        complete_step (ChainState &state,
+                       OutputType &trial_sample,
+                       const double trial_log_likelihood,
+                       const double proposal_distribution_ratio,
+                       const std::chrono::nanoseconds proposal_time,
+                       const std::chrono::nanoseconds likelihood_evaluation_time,
+                       const std::optional<std::size_t> chain,
+                       const std::function<void (const ChainState &)> &write_checkpoint);
+
+        void
+        finish_chain (ChainState &state,
+                      const std::optional<std::size_t> chain,
+                      const std::function<void (const ChainState &)> &write_checkpoint);
+
+        /**
+         * If Parameters::compress_repeated_samples is set, send the sample
+         * the chain with the given state is at downstream, along with the
+         * number of steps the chain has stayed there.
+         */
+        void
+        issue_compressed_sample (ChainState &state,
+                                 const std::optional<std::size_t> chain);
+
+        /**
+         * Advance the single chain with the given state, using the
+         * generator of the current object, until it has taken `n_samples`
+         * steps. This is the implementation of the sample() and resume()
+         * functions, for the different kinds of `propose_sample` arguments
+         * they accept.
+         */
+        template <typename LogLikelihood, typename ProposeSample>
+        void
+        run_single_chain (ChainState &state,
+                          const LogLikelihood &log_likelihood,
+                          const ProposeSample &propose_sample,
+                          const types::sample_index n_samples);
+
+        /**
+         * Advance the chains with the given states on the given thread pool
+         * until each has taken `n_samples_per_chain` steps. This is the
+         * implementation of the sample_chains() and resume_chains() functions
+         * that run chains on a thread pool.
+         */
+        void
+        run_chains (std::vector<ChainState> &chain_states,
+                    const std::function<double (const OutputType &)> &log_likelihood,
+                    const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                    const types::sample_index n_samples_per_chain,
+                    const std::shared_ptr<ThreadPool> &thread_pool);
+
+        /**
+         * Advance the chains with the given states in lockstep until each
+         * has taken `n_samples_per_chain` steps. This is the implementation
+         * of the sample_chains() and resume_chains() functions that evaluate
+         * the likelihoods of all chains as one batch.
+         */
+        void
+        run_chains_in_lockstep (std::vector<ChainState> &chain_states,
+                                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                                const types::sample_index n_samples_per_chain);
+
+        /**
+         * Wrap a function object that starts the evaluation of the
+         * likelihood of one sample into one that evaluates a whole batch
+         * of samples, by first starting the evaluations for all samples of
+         * the batch and only then waiting for the results.
+         */
+        static
+        types::BatchLogLikelihood<OutputType>
+        as_batch_log_likelihood (const types::AsynchronousLogLikelihood<OutputType> &log_likelihood);
+
+        /**
+         * Return the random number generator to be used by the chain with
+         * the given number when running several chains.
+         */
+        RandomNumberGenerator
+        create_chain_rng (const std::size_t chain) const;
+
+        /**
+         * Return the states of chains that start at the given points and
+         * have not taken any steps yet, using the generators returned by
+         * create_chain_rng().
+         */
+        std::vector<ChainState>
+        create_chain_states (const std::vector<OutputType> &starting_points) const;
+
+        /**
+         * Convert the given states of chains into a checkpoint and hand it
+         * to Parameters::checkpointer. See the documentation of
+         * Parameters::checkpointer for the format of the checkpoint.
+         */
+        void
+        write_checkpoint (const std::span<const ChainState> chain_states) const;
+
+        /**
+         * Return the states of chains stored in the given checkpoint.
+         */
+        static
+        std::vector<ChainState>
+        read_checkpoint (const std::vector<char> &checkpoint);
     };
 
 
 
-    template <typename OutputType>
-    MetropolisHastings<OutputType>::
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
     MetropolisHastings (const Parameters &parameters)
       : parameters (parameters)
     {
-      if (parameters.random_seed != std::mt19937::result_type {})
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
         rng.seed (parameters.random_seed);
     }
 
 
-    template <typename OutputType>
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    ChainState::save (std::vector<char> &buffer) const
+    {
+      Serialization::write (buffer, current_sample);
+      Serialization::write (buffer, current_log_likelihood);
+      Serialization::write (buffer, rng);
+      Serialization::write (buffer, n_steps);
+      Serialization::write (buffer, n_repetitions);
+      Serialization::write (buffer, first_repetition_is_repeated);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    ChainState::load (std::span<const char> &buffer)
+    {
+      Serialization::read (buffer, current_sample);
+      Serialization::read (buffer, current_log_likelihood);
+      Serialization::read (buffer, rng);
+      Serialization::read (buffer, n_steps);
+      Serialization::read (buffer, n_repetitions);
+      Serialization::read (buffer, first_repetition_is_repeated);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
     void
-    MetropolisHastings<OutputType>::
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
     sample (const OutputType &starting_point,
             const std::function<double (const OutputType &)> &log_likelihood,
             const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
             const types::sample_index n_samples)
     {
-      // Make sure the flush_consumers() function is called at any point
-      // where we exit the current function.
-      Utilities::ScopeExit scope_exit ([this]()
-      {
-        this->flush_consumers();
-      });
+      ChainState state {starting_point, std::numeric_limits<double>::quiet_NaN(), rng, 0, 0, false};
+      run_single_chain (state, log_likelihood, propose_sample, n_samples);
+    }
 
-      std::uniform_real_distribution<> uniform_distribution(0,1);
 
-      OutputType current_sample         = starting_point;
-      double     current_log_likelihood = log_likelihood (current_sample);
 
-      // Loop over the desired number of samples
-      for (types::sample_index i=0; i<n_samples; ++i)
-        {
-          // Obtain a new proposed sample and evaluate the
-          // log likelihood for it
-          std::pair<OutputType,double> trial_sample_and_ratio = propose_sample (current_sample);
-          OutputType trial_sample = std::move(trial_sample_and_ratio.first);
-          const double proposal_distribution_ratio = trial_sample_and_ratio.second;
-
-          const double trial_log_likelihood = log_likelihood (trial_sample);
-
-          // Then see if we want to accept the sample. This happens if either
-          // the new sample has a higher likelihood (which happens if and
-          // only if the log likelihood of the new sample is larger than the
-          // log likelihood of the old sample), or if the ratio of likelihoods
-          // is larger than a randomly drawn number between zero and one. The
-          // ratio of likelihoods equals the exp of the difference of
-          // log likelihoods.
-          //
-          // If the sample is not accepted, then we simply stick with (i.e.,
-          // repeat) the previous sample.
-          //
-          // There are two special cases to consider. If the probability of the
-          // new sample is zero (i.e., the log likelihood is either -infinity or
-          // -numeric_limits<double>::max()), then we never want to accept the
-          // sample and there is no need to do any arithmetic on it. If, on
-          // the other hand, the sample has a zero probability *and* the
-          // previous probability was *also* zero, then we always want to accept
-          // it so that we can do a random walk that hopefully at some point leads
-          // to an area of nonzero probabilities.
-          const bool trial_sample_has_zero_probability
-            = ((trial_log_likelihood == -std::numeric_limits<double>::max())
-               ||
-               (trial_log_likelihood == -std::numeric_limits<double>::infinity()));
-          const bool current_sample_has_zero_probability
-            = ((current_log_likelihood == -std::numeric_limits<double>::max())
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood, typename ProposeSample>
+    requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
+              &&
+              (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
                ||
-               (current_log_likelihood == -std::numeric_limits<double>::infinity()));
+               std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const LogLikelihood &log_likelihood,
+            const ProposeSample &propose_sample,
+            const types::sample_index n_samples)
+    {
+      ChainState state {starting_point, std::numeric_limits<double>::quiet_NaN(), rng, 0, 0, false};
+      run_single_chain (state, log_likelihood, propose_sample, n_samples);
+    }
 
-          bool repeated_sample;
-          if (!(trial_sample_has_zero_probability && !current_sample_has_zero_probability)
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood, typename ProposeSample>
+    requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
               &&
-              ((trial_sample_has_zero_probability && current_sample_has_zero_probability
-                && (1. / proposal_distribution_ratio >= uniform_distribution(rng)))
-               ||
-               (trial_log_likelihood - std::log(proposal_distribution_ratio) > current_log_likelihood)
+              (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
                ||
-               (std::exp(trial_log_likelihood - current_log_likelihood) / proposal_distribution_ratio >= uniform_distribution(rng))))
-            {
-              current_sample         = trial_sample;
-              current_log_likelihood = trial_log_likelihood;
+               std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+    PullRange<OutputType>
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    pull (const OutputType                 &starting_point,
+          const LogLikelihood              &log_likelihood,
+          const ProposeSample              &propose_sample,
+          const std::optional<std::size_t>  chain)
+    {
+      // The state of the chain has to live as long as the range does, and
+      // is therefore owned by the function that advances the chain (and
+      // that the range stores):
+      const auto state = std::make_shared<ChainState>
+                         (ChainState
+      {
+        starting_point,
+        std::numeric_limits<double>::quiet_NaN(),
+        (chain ? create_chain_rng (*chain) : rng),
+        0, 0, false
+      });
 
-              repeated_sample = false;
-            }
-          else
-            repeated_sample = true;
+      const auto advance = [this, state, log_likelihood, propose_sample, chain]()
+      {
+        if (this->stop_requested())
+          {
+            this->clear_stop_request();
+            return false;
+          }
 
-          // Output the new sample (which may be equal to the old sample).
-          this->issue_sample (current_sample,
+        // The range connects its own consumer to us only after this
+        // function has returned, and other samplings may intervene between
+        // steps, so find out which auxiliary data is wanted before each
+        // step. Then take exactly one step, with a function that proposes
+        // samples in the way run_chain() expects:
+        update_requested_aux_data ();
+        if constexpr (std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>)
+          run_chain (*state,
+                     log_likelihood,
+                     [&](const OutputType &x, OutputType &trial_sample, RandomNumberGenerator &)
           {
-            {"relative log likelihood", std::any(current_log_likelihood)},
-            {"sample is repeated", std::any(repeated_sample)}
-          });
-        }
+            return propose_sample (x, trial_sample);
+          },
+          state->n_steps + 1,
+          chain,
+          {});
+        else
+          run_chain (*state,
+                     log_likelihood,
+                     [&](const OutputType &x, RandomNumberGenerator &)
+          {
+            return propose_sample (x);
+          },
+          state->n_steps + 1,
+          chain,
+          {});
+
+        return true;
+      };
+
+      return PullRange<OutputType> (*this,
+                                    advance,
+                                    [this]()
+      {
+        this->flush_consumers();
+      });
+    }
+
+
 
-      this->flush_consumers();
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood, typename ProposeSample>
+    requires (std::is_invocable_r_v<double, const LogLikelihood &, const OutputType &>
+              &&
+              (std::is_invocable_r_v<std::pair<OutputType,double>, const ProposeSample &, const OutputType &>
+               ||
+               std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>))
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume (const std::vector<char> &checkpoint,
+            const LogLikelihood &log_likelihood,
+            const ProposeSample &propose_sample,
+            const types::sample_index n_samples)
+    {
+      std::vector<ChainState> chain_states = read_checkpoint (checkpoint);
+      assert (chain_states.size() == 1);
+
+      run_single_chain (chain_states[0], log_likelihood, propose_sample, n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample_chains (const std::vector<OutputType> &starting_points,
+                   const std::function<double (const OutputType &)> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain,
+                   const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      std::vector<ChainState> chain_states = create_chain_states (starting_points);
+      run_chains (chain_states,
+                  log_likelihood,
+                  propose_sample,
+                  n_samples_per_chain,
+                  thread_pool);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample_chains (const std::vector<OutputType> &starting_points,
+                   const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain)
+    {
+      std::vector<ChainState> chain_states = create_chain_states (starting_points);
+      run_chains_in_lockstep (chain_states,
+                              log_likelihood,
+                              propose_sample,
+                              n_samples_per_chain);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample_chains (const std::vector<OutputType> &starting_points,
+                   const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain)
+    {
+      sample_chains (starting_points,
+                     as_batch_log_likelihood (log_likelihood),
+                     propose_sample,
+                     n_samples_per_chain);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample_chains (const std::vector<OutputType> &starting_points,
+                   const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain,
+                   Coroutines::Scheduler &scheduler)
+    {
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+      update_requested_aux_data ();
+
+      std::vector<ChainState> chain_states = create_chain_states (starting_points);
+      announce_chain_samples (chain_states, n_samples_per_chain);
+
+      // As in run_chains(), each chain works on its own copy of its state
+      // and reports it to the array of states when a checkpoint is to
+      // be written. Unlike there, the copies need to outlive the loop
+      // below since the coroutines only refer to them.
+      std::vector<ChainState> running_chain_states = chain_states;
+      std::mutex chain_states_mutex;
+      std::vector<std::function<void (const ChainState &)>> write_checkpoint (chain_states.size());
+      if (parameters.checkpointer != nullptr)
+        for (std::size_t chain=0; chain<chain_states.size(); ++chain)
+          write_checkpoint[chain] = [&, chain](const ChainState &state)
+        {
+          std::lock_guard<std::mutex> lock (chain_states_mutex);
+          chain_states[chain] = state;
+          this->write_checkpoint (chain_states);
+        };
+
+      for (std::size_t chain=0; chain<chain_states.size(); ++chain)
+        scheduler.spawn (run_chain_as_coroutine (running_chain_states[chain],
+                                                 log_likelihood,
+                                                 propose_sample,
+                                                 n_samples_per_chain,
+                                                 parameters.first_chain_number + chain,
+                                                 write_checkpoint[chain],
+                                                 scheduler));
+
+      // Wait for all chains to finish before we flush the consumers
+      // and return:
+      scheduler.wait();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume_chains (const std::vector<char> &checkpoint,
+                   const std::function<double (const OutputType &)> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain,
+                   const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      std::vector<ChainState> chain_states = read_checkpoint (checkpoint);
+      run_chains (chain_states,
+                  log_likelihood,
+                  propose_sample,
+                  n_samples_per_chain,
+                  thread_pool);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume_chains (const std::vector<char> &checkpoint,
+                   const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain)
+    {
+      std::vector<ChainState> chain_states = read_checkpoint (checkpoint);
+      run_chains_in_lockstep (chain_states,
+                              log_likelihood,
+                              propose_sample,
+                              n_samples_per_chain);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    resume_chains (const std::vector<char> &checkpoint,
+                   const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples_per_chain)
+    {
+      resume_chains (checkpoint,
+                     as_batch_log_likelihood (log_likelihood),
+                     propose_sample,
+                     n_samples_per_chain);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood, typename ProposeSample>
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_single_chain (ChainState &state,
+                      const LogLikelihood &log_likelihood,
+                      const ProposeSample &propose_sample,
+                      const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+      update_requested_aux_data ();
+      announce_chain_samples (std::span<const ChainState> (&state, 1), n_samples);
+
+      std::function<void (const ChainState &)> write_checkpoint;
+      if (parameters.checkpointer != nullptr)
+        write_checkpoint = [this](const ChainState &state)
+      {
+        this->write_checkpoint (std::span<const ChainState> (&state, 1));
+      };
+
+      // The function that proposes samples does not get to see our random
+      // number generator. Which of the two possible signatures the
+      // function has is then sorted out by run_chain().
+      if constexpr (std::is_invocable_r_v<double, const ProposeSample &, const OutputType &, OutputType &>)
+        run_chain (state,
+                   log_likelihood,
+                   [&propose_sample](const OutputType &x, OutputType &trial_sample, RandomNumberGenerator &)
+        {
+          return propose_sample (x, trial_sample);
+        },
+        n_samples,
+        {},
+        write_checkpoint);
+      else
+        run_chain (state,
+                   log_likelihood,
+                   [&propose_sample](const OutputType &x, RandomNumberGenerator &)
+        {
+          return propose_sample (x);
+        },
+        n_samples,
+        {},
+        write_checkpoint);
+
+      // The chain has used the random number generator of this object, and
+      // the next call to sample() should continue where it left off:
+      rng = state.rng;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_chains (std::vector<ChainState> &chain_states,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples_per_chain,
+                const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      assert (thread_pool != nullptr);
+
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+      update_requested_aux_data ();
+      announce_chain_samples (chain_states, n_samples_per_chain);
+
+      // If we write checkpoints, each chain reports its state to the
+      // array of chain states at the times it wants a checkpoint written,
+      // and the whole array is then written. The mutex protects the array
+      // against concurrent access from different chains.
+      std::mutex chain_states_mutex;
+
+      const auto make_checkpoint_writer = [&](const std::size_t chain)
+      {
+        std::function<void (const ChainState &)> write_checkpoint;
+        if (parameters.checkpointer != nullptr)
+          write_checkpoint = [&, chain](const ChainState &state)
+        {
+          std::lock_guard<std::mutex> lock (chain_states_mutex);
+          chain_states[chain] = state;
+          this->write_checkpoint (chain_states);
+        };
+        return write_checkpoint;
+      };
+
+      ThreadPool::TaskGroup chains;
+
+      // If Parameters::grain_size is set, split each chain into pieces of
+      // that many steps, each of which is a task that enqueues the task
+      // for the next piece when it is done. The steps of a chain are then
+      // still taken one after the other and with the chain's own random
+      // number generator, but workers that have run out of work can steal
+      // the next pieces of chains that are waiting while other workers are
+      // busy with expensive steps. Since a worker enqueues the next piece
+      // into its own queue and runs the most recently enqueued task of
+      // its queue first, a chain mostly stays with the same worker unless
+      // another worker is idle.
+      const types::sample_index grain_size = parameters.grain_size;
+      std::vector<std::unique_ptr<ChainState>> states (chain_states.size());
+      std::function<void (const std::size_t)> advance_chain
+        = [&](const std::size_t chain)
+      {
+        if (states[chain] == nullptr)
+          states[chain] = std::make_unique<ChainState> (chain_states[chain]);
+        ChainState &state = *states[chain];
+
+        const std::function<void (const ChainState &)> write_checkpoint
+          = make_checkpoint_writer (chain);
+
+        run_chain (state,
+                   log_likelihood,
+                   propose_sample,
+                   std::min (state.n_steps + grain_size, n_samples_per_chain),
+                   parameters.first_chain_number + chain,
+                   write_checkpoint,
+                   false);
+
+        if ((state.n_steps < n_samples_per_chain) && (this->stop_requested() == false))
+          chains.run (*thread_pool,
+                      [&advance_chain, chain]()
+        {
+          advance_chain (chain);
+        });
+        else
+          finish_chain (state, parameters.first_chain_number + chain, write_checkpoint);
+      };
+
+      // Start one task per chain. Each task works on a copy of the state of
+      // its chain, including the random number generator of the chain, and
+      // runs the chain to completion, or its first piece as described
+      // above. The copy is made by the task itself, so that its memory is
+      // allocated on the NUMA node of the worker thread that runs the
+      // chain; since tasks are distributed among the workers
+      // round-robin, a pool whose workers are bound to cores (see
+      // ThreadPool::Placement) spreads the chains across all nodes.
+      for (std::size_t chain=0; chain<chain_states.size(); ++chain)
+        if (grain_size > 0)
+          chains.run (*thread_pool,
+                      [&advance_chain, chain]()
+        {
+          advance_chain (chain);
+        });
+        else
+          chains.run (*thread_pool,
+                      [&, chain]()
+        {
+          ChainState state = chain_states[chain];
+
+          run_chain (state,
+                     log_likelihood,
+                     propose_sample,
+                     n_samples_per_chain,
+                     parameters.first_chain_number + chain,
+                     make_checkpoint_writer (chain));
+        });
+
+      // Wait for all chains to finish before we flush the consumers
+      // and return:
+      chains.wait();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_chains_in_lockstep (std::vector<ChainState> &chain_states,
+                            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                            const types::sample_index n_samples_per_chain)
+    {
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+      update_requested_aux_data ();
+      announce_chain_samples (chain_states, n_samples_per_chain);
+
+      const std::size_t n_chains = chain_states.size();
+
+      // Unpack the states of the chains into separate arrays, since we
+      // need to pass the current samples of all chains to the likelihood
+      // function and downstream as contiguous arrays. Since all chains
+      // advance in lockstep, they have all taken the same number of steps.
+      std::vector<OutputType>            current_samples;
+      std::vector<double>                current_log_likelihoods;
+      std::vector<RandomNumberGenerator> chain_rngs;
+      current_samples.reserve (n_chains);
+      current_log_likelihoods.reserve (n_chains);
+      chain_rngs.reserve (n_chains);
+      for (ChainState &state : chain_states)
+        {
+          assert (state.n_steps == chain_states[0].n_steps);
+
+          current_samples.emplace_back (std::move(state.current_sample));
+          current_log_likelihoods.emplace_back (state.current_log_likelihood);
+          chain_rngs.emplace_back (state.rng);
+        }
+      types::sample_index n_steps = (n_chains > 0 ? chain_states[0].n_steps : 0);
+
+      // If the chains have not started yet, we need the likelihoods of
+      // their starting points:
+      // We time the evaluation of this batch, and of all of the
+      // following ones, as a whole if we record timings, and attribute
+      // an equal share of the time to each chain.
+      const bool measure = parameters.record_timings;
+      std::chrono::nanoseconds batch_time {0};
+      if ((n_chains > 0) && std::isnan (current_log_likelihoods[0]))
+        {
+          Instrumentation::timed_call (measure, batch_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood_batch", "sampler", this);
+            log_likelihood (current_samples, current_log_likelihoods);
+            return 0;
+          });
+          if (measure)
+            for (std::size_t chain=0; chain<n_chains; ++chain)
+              record_starting_point_timing (batch_time / n_chains);
+        }
+
+      std::vector<OutputType> trial_samples = current_samples;
+      std::vector<double>     proposal_distribution_ratios (n_chains);
+      std::vector<double>     trial_log_likelihoods (n_chains);
+      std::vector<std::chrono::nanoseconds> proposal_times (n_chains);
+
+      std::vector<AuxiliaryData> aux_data (n_chains);
+
+      // If we compress repeated samples, we need to keep track for each
+      // chain of how many steps it has stayed at its current sample, and
+      // whether the first of these steps was a rejection. The samples a
+      // chain moves away from in each step are collected in separate
+      // arrays and then sent downstream as one batch.
+      const bool compress_repeated_samples = parameters.compress_repeated_samples;
+      std::vector<types::sample_index> n_repetitions;
+      std::vector<bool>                first_repetition_is_repeated;
+      for (const ChainState &state : chain_states)
+        {
+          n_repetitions.push_back (state.n_repetitions);
+          first_repetition_is_repeated.push_back (state.first_repetition_is_repeated);
+        }
+      std::vector<OutputType>          compressed_samples;
+      std::vector<AuxiliaryData>       compressed_aux_data;
+      const auto compressed_sample_aux_data = [&](const std::size_t chain)
+      {
+        AuxiliaryData compressed_aux_data
+          = create_aux_data (current_log_likelihoods[chain],
+                             first_repetition_is_repeated[chain],
+                             parameters.first_chain_number + chain);
+        compressed_aux_data[AuxiliaryData::repetition_count] = std::size_t(n_repetitions[chain]);
+        return compressed_aux_data;
+      };
+
+      // If we write checkpoints, we need to pack the arrays above back
+      // into the states of the chains:
+      const auto write_checkpoint = [&]()
+      {
+        if (parameters.checkpointer == nullptr)
+          return;
+
+        for (std::size_t chain=0; chain<n_chains; ++chain)
+          chain_states[chain] = ChainState
+        {
+          current_samples[chain],
+          current_log_likelihoods[chain],
+          chain_rngs[chain],
+          n_steps,
+          n_repetitions[chain],
+          first_repetition_is_repeated[chain]
+        };
+        this->write_checkpoint (chain_states);
+      };
+
+      while ((n_steps < n_samples_per_chain) && (this->stop_requested() == false))
+        {
+          // Obtain a proposed sample for each chain, then evaluate
+          // the log likelihoods of all of them at once:
+          for (std::size_t chain=0; chain<n_chains; ++chain)
+            {
+              std::pair<OutputType,double> trial_sample_and_ratio
+                = Instrumentation::timed_call (measure, proposal_times[chain], [&]()
+              {
+                return propose_sample (current_samples[chain], chain_rngs[chain]);
+              });
+              trial_samples[chain]                = std::move(trial_sample_and_ratio.first);
+              proposal_distribution_ratios[chain] = trial_sample_and_ratio.second;
+            }
+
+          Instrumentation::timed_call (measure, batch_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood_batch", "sampler", this);
+            log_likelihood (trial_samples, trial_log_likelihoods);
+            return 0;
+          });
+
+          // Then decide for each chain whether it moves to the trial
+          // sample, and send the new samples of all chains downstream:
+          for (std::size_t chain=0; chain<n_chains; ++chain)
+            {
+              const bool repeated_sample = (accept_trial_sample (trial_log_likelihoods[chain],
+                                                                 current_log_likelihoods[chain],
+                                                                 proposal_distribution_ratios[chain],
+                                                                 chain_rngs[chain])
+                                            == false);
+              if (repeated_sample == false)
+                {
+                  if (compress_repeated_samples && (n_repetitions[chain] > 0))
+                    {
+                      compressed_aux_data.emplace_back (compressed_sample_aux_data (chain));
+                      compressed_samples.emplace_back (std::move(current_samples[chain]));
+                      n_repetitions[chain] = 0;
+                    }
+
+                  current_samples[chain]         = std::move(trial_samples[chain]);
+                  current_log_likelihoods[chain] = trial_log_likelihoods[chain];
+                }
+
+              if (compress_repeated_samples)
+                {
+                  if (n_repetitions[chain] == 0)
+                    first_repetition_is_repeated[chain] = repeated_sample;
+                  ++n_repetitions[chain];
+
+                  if (measure)
+                    record_timings (proposal_times[chain], batch_time / n_chains, nullptr);
+                }
+              else
+                {
+                  aux_data[chain] = create_aux_data (current_log_likelihoods[chain],
+                                                     repeated_sample,
+                                                     parameters.first_chain_number + chain);
+                  if (measure)
+                    record_timings (proposal_times[chain], batch_time / n_chains, &aux_data[chain]);
+                }
+            }
+
+          if (compress_repeated_samples == false)
+            this->issue_batch (current_samples, aux_data);
+          else if (compressed_samples.size() > 0)
+            {
+              this->issue_batch (compressed_samples, compressed_aux_data);
+              compressed_samples.clear ();
+              compressed_aux_data.clear ();
+            }
+
+          ++n_steps;
+          if ((parameters.checkpoint_interval > 0)
+              &&
+              (n_steps % parameters.checkpoint_interval == 0))
+            write_checkpoint ();
+        }
+
+      // If we compress repeated samples, then the samples the chains
+      // are currently at have not been sent yet -- unless no chain has
+      // taken a step yet, in which case there is nothing to send. (All
+      // chains are in the same situation in this regard since each step
+      // leaves every chain with at least one pending repetition.)
+      if (compress_repeated_samples && (n_chains > 0) && (n_repetitions[0] > 0))
+        {
+          for (std::size_t chain=0; chain<n_chains; ++chain)
+            compressed_aux_data.emplace_back (compressed_sample_aux_data (chain));
+          this->issue_batch (current_samples, compressed_aux_data);
+          std::fill (n_repetitions.begin(), n_repetitions.end(), 0);
+        }
+
+      write_checkpoint ();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    types::BatchLogLikelihood<OutputType>
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    as_batch_log_likelihood (const types::AsynchronousLogLikelihood<OutputType> &log_likelihood)
+    {
+      return [&log_likelihood](std::span<const OutputType> samples,
+                               std::span<double> log_likelihoods)
+      {
+        assert (samples.size() == log_likelihoods.size());
+
+        std::vector<std::future<double>> evaluation_results;
+        evaluation_results.reserve (samples.size());
+        for (const OutputType &sample : samples)
+          evaluation_results.emplace_back (log_likelihood (sample));
+
+        for (std::size_t i=0; i<samples.size(); ++i)
+          log_likelihoods[i] = evaluation_results[i].get();
+      };
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood, typename ProposeSample>
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_chain (ChainState &state,
+               const LogLikelihood &log_likelihood,
+               const ProposeSample &propose_sample,
+               const types::sample_index n_samples,
+               const std::optional<std::size_t> chain,
+               const std::function<void (const ChainState &)> &write_checkpoint,
+               const bool finish)
+    {
+      const bool measure = parameters.record_timings;
+      std::chrono::nanoseconds proposal_time {0};
+      std::chrono::nanoseconds likelihood_evaluation_time {0};
+
+      // If the chain has not started yet, we need the likelihood of its
+      // starting point:
+      if (std::isnan (state.current_log_likelihood))
+        {
+          state.current_log_likelihood
+            = Instrumentation::timed_call (measure, likelihood_evaluation_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood", "sampler", this);
+            return log_likelihood (state.current_sample);
+          });
+          if (measure)
+            record_starting_point_timing (likelihood_evaluation_time);
+        }
+
+      // The object that holds the trial sample. It is reused from one
+      // step to the next: If the trial sample is accepted, it is swapped
+      // with the current sample, and otherwise it is simply overwritten
+      // in the next step.
+      OutputType trial_sample = state.current_sample;
+
+      // Loop until we have the desired number of samples
+      while ((state.n_steps < n_samples) && (this->stop_requested() == false))
+        {
+          // Obtain a new proposed sample and evaluate the
+          // log likelihood for it, then see whether we move there
+          const double proposal_distribution_ratio
+            = Instrumentation::timed_call (measure, proposal_time, [&]()
+          {
+            return propose_trial_sample (state, propose_sample, trial_sample);
+          });
+          const double trial_log_likelihood
+            = Instrumentation::timed_call (measure, likelihood_evaluation_time, [&]()
+          {
+            Tracing::Span span ("log_likelihood", "sampler", this);
+            return log_likelihood (trial_sample);
+          });
+
+          complete_step (state, trial_sample,
+                         trial_log_likelihood, proposal_distribution_ratio,
+                         proposal_time, likelihood_evaluation_time,
+                         chain, write_checkpoint);
+        }
+
+      if (finish)
+        finish_chain (state, chain, write_checkpoint);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Coroutines::Task
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_chain_as_coroutine (ChainState &state,
+                            const types::AsynchronousLogLikelihood<OutputType> &log_likelihood,
+                            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                            const types::sample_index n_samples,
+                            const std::size_t chain,
+                            const std::function<void (const ChainState &)> &write_checkpoint,
+                            Coroutines::Scheduler &scheduler)
+    {
+      // Since we cannot time the 'co_await' expressions with
+      // Instrumentation::timed_call(), read the clock by hand if we
+      // record timings:
+      const bool measure = parameters.record_timings;
+      const auto now = [measure]()
+      {
+        return (measure ? Instrumentation::Clock::now() : Instrumentation::Clock::time_point());
+      };
+      std::chrono::nanoseconds proposal_time {0};
+
+      if (std::isnan (state.current_log_likelihood))
+        {
+          const Instrumentation::Clock::time_point start = now();
+          state.current_log_likelihood
+            = co_await scheduler.wait_for (log_likelihood (state.current_sample));
+          if (measure)
+            record_starting_point_timing (now() - start);
+        }
+
+      OutputType trial_sample = state.current_sample;
+
+      while ((state.n_steps < n_samples) && (this->stop_requested() == false))
+        {
+          const double proposal_distribution_ratio
+            = Instrumentation::timed_call (measure, proposal_time, [&]()
+          {
+            return propose_trial_sample (state, propose_sample, trial_sample);
+          });
+
+          const Instrumentation::Clock::time_point start = now();
+          const double trial_log_likelihood
+            = co_await scheduler.wait_for (log_likelihood (trial_sample));
+          const std::chrono::nanoseconds likelihood_evaluation_time = now() - start;
+
+          complete_step (state, trial_sample,
+                         trial_log_likelihood, proposal_distribution_ratio,
+                         proposal_time, likelihood_evaluation_time,
+                         chain, write_checkpoint);
+        }
+
+      finish_chain (state, chain, write_checkpoint);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename ProposeSample>
+    double
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    propose_trial_sample (ChainState &state,
+                          const ProposeSample &propose_sample,
+                          OutputType &trial_sample)
+    {
+      if constexpr (std::is_invocable_r_v<double, const ProposeSample &,
+                    const OutputType &, OutputType &, RandomNumberGenerator &>)
+        return propose_sample (state.current_sample, trial_sample, state.rng);
+      else
+        {
+          std::pair<OutputType,double> trial_sample_and_ratio = propose_sample (state.current_sample, state.rng);
+          trial_sample = std::move(trial_sample_and_ratio.first);
+          return trial_sample_and_ratio.second;
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    complete_step (ChainState &state,
+                   OutputType &trial_sample,
+                   const double trial_log_likelihood,
+                   const double proposal_distribution_ratio,
+                   const std::chrono::nanoseconds proposal_time,
+                   const std::chrono::nanoseconds likelihood_evaluation_time,
+                   const std::optional<std::size_t> chain,
+                   const std::function<void (const ChainState &)> &write_checkpoint)
+    {
+      // See if we want to accept the sample. If the sample is not
+      // accepted, then we simply stick with (i.e., repeat) the previous
+      // sample.
+      const bool repeated_sample = (accept_trial_sample (trial_log_likelihood,
+                                                         state.current_log_likelihood,
+                                                         proposal_distribution_ratio,
+                                                         state.rng)
+                                    == false);
+      if (repeated_sample == false)
+        {
+          // If we compress repeated samples, this is the time to send
+          // the sample we are moving away from:
+          if (parameters.compress_repeated_samples && (state.n_repetitions > 0))
+            issue_compressed_sample (state, chain);
+
+          std::swap (state.current_sample, trial_sample);
+          state.current_log_likelihood = trial_log_likelihood;
+        }
+
+      if (parameters.compress_repeated_samples)
+        {
+          if (state.n_repetitions == 0)
+            state.first_repetition_is_repeated = repeated_sample;
+          ++state.n_repetitions;
+
+          if (parameters.record_timings)
+            record_timings (proposal_time, likelihood_evaluation_time, nullptr);
+        }
+      else
+        {
+          // Output the new sample (which may be equal to the old sample).
+          AuxiliaryData aux_data = create_aux_data (state.current_log_likelihood,
+                                                    repeated_sample,
+                                                    chain);
+          if (parameters.record_timings)
+            record_timings (proposal_time, likelihood_evaluation_time, &aux_data);
+
+          this->issue_sample (state.current_sample, std::move(aux_data));
+        }
+
+      ++state.n_steps;
+      if (write_checkpoint
+          &&
+          (parameters.checkpoint_interval > 0)
+          &&
+          (state.n_steps % parameters.checkpoint_interval == 0))
+        write_checkpoint (state);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    finish_chain (ChainState &state,
+                  const std::optional<std::size_t> chain,
+                  const std::function<void (const ChainState &)> &write_checkpoint)
+    {
+      // If we compress repeated samples, the sample the chain is
+      // currently at has not been sent yet:
+      if (state.n_repetitions > 0)
+        issue_compressed_sample (state, chain);
+
+      // Finally record the state in which the chain ends:
+      if (write_checkpoint)
+        write_checkpoint (state);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    issue_compressed_sample (ChainState &state,
+                             const std::optional<std::size_t> chain)
+    {
+      AuxiliaryData aux_data = create_aux_data (state.current_log_likelihood,
+                                                state.first_repetition_is_repeated,
+                                                chain);
+      aux_data[AuxiliaryData::repetition_count] = std::size_t(state.n_repetitions);
+
+      this->issue_sample (state.current_sample, std::move(aux_data));
+      state.n_repetitions = 0;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Instrumentation::SamplerStatistics
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    get_sampler_statistics () const
+    {
+      return sampler_statistics.merged();
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    record_timings (const std::chrono::nanoseconds proposal_time,
+                    const std::chrono::nanoseconds likelihood_evaluation_time,
+                    AuxiliaryData *aux_data)
+    {
+      sampler_statistics.update ([&](Instrumentation::SamplerStatistics &s)
+      {
+        s.proposals.add (proposal_time);
+        s.likelihood_evaluations.add (likelihood_evaluation_time);
+      });
+
+      if ((aux_data != nullptr) && requested_aux_data.timings)
+        {
+          (*aux_data)[AuxiliaryData::proposal_time]
+            = std::chrono::duration<double>(proposal_time).count();
+          (*aux_data)[AuxiliaryData::likelihood_evaluation_time]
+            = std::chrono::duration<double>(likelihood_evaluation_time).count();
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    record_starting_point_timing (const std::chrono::nanoseconds likelihood_evaluation_time)
+    {
+      sampler_statistics.update ([&](Instrumentation::SamplerStatistics &s)
+      {
+        s.likelihood_evaluations.add (likelihood_evaluation_time);
+      });
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    update_requested_aux_data ()
+    {
+      requested_aux_data.relative_log_likelihood
+        = this->aux_data_requested (AuxiliaryData::relative_log_likelihood);
+      requested_aux_data.sample_is_repeated
+        = this->aux_data_requested (AuxiliaryData::sample_is_repeated);
+      requested_aux_data.chain_number
+        = this->aux_data_requested (AuxiliaryData::chain_number);
+      requested_aux_data.timings
+        = (this->aux_data_requested (AuxiliaryData::proposal_time)
+           ||
+           this->aux_data_requested (AuxiliaryData::likelihood_evaluation_time));
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    announce_chain_samples (const std::span<const ChainState> chain_states,
+                            const types::sample_index         n_steps_per_chain)
+    {
+      if (chain_states.empty())
+        return;
+
+      // Chains that are resumed have already taken some of their steps:
+      types::sample_index n_samples = 0;
+      for (const ChainState &state : chain_states)
+        if (n_steps_per_chain > state.n_steps)
+          n_samples += n_steps_per_chain - state.n_steps;
+
+      this->announce_samples (SampleShape::of (chain_states.front().current_sample,
+                                               n_samples));
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    AuxiliaryData
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    create_aux_data (const double log_likelihood,
+                     const bool sample_is_repeated,
+                     const std::optional<std::size_t> chain) const
+    {
+      AuxiliaryData aux_data;
+      if (requested_aux_data.relative_log_likelihood)
+        aux_data[AuxiliaryData::relative_log_likelihood] = log_likelihood;
+      if (requested_aux_data.sample_is_repeated)
+        aux_data[AuxiliaryData::sample_is_repeated] = sample_is_repeated;
+      if (chain && requested_aux_data.chain_number)
+        aux_data[AuxiliaryData::chain_number] = *chain;
+      return aux_data;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    RandomNumberGenerator
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    create_chain_rng (const std::size_t chain) const
+    {
+      return Random::create_stream<RandomNumberGenerator> (parameters.random_seed,
+                                                           parameters.first_chain_number + chain);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::vector<typename MetropolisHastings<OutputType,RandomNumberGenerator>::ChainState>
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    create_chain_states (const std::vector<OutputType> &starting_points) const
+    {
+      std::vector<ChainState> chain_states;
+      chain_states.reserve (starting_points.size());
+      for (std::size_t chain=0; chain<starting_points.size(); ++chain)
+        chain_states.emplace_back (ChainState
+      {
+        starting_points[chain],
+        std::numeric_limits<double>::quiet_NaN(),
+        create_chain_rng (chain),
+        0,
+        0,
+        false
+      });
+
+      return chain_states;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    write_checkpoint (const std::span<const ChainState> chain_states) const
+    {
+      assert (parameters.checkpointer != nullptr);
+
+      // Store the states the same way as Serialization::write() stores
+      // a std::vector<ChainState>, i.e., as the number of elements followed
+      // by the elements. This is only possible for sample types the
+      // serialization functions support.
+      if constexpr (Serialization::is_serializable<OutputType>())
+        {
+          std::vector<char> checkpoint;
+          Serialization::write (checkpoint, std::uint64_t(chain_states.size()));
+          for (const ChainState &state : chain_states)
+            Serialization::write (checkpoint, state);
+
+          parameters.checkpointer->write (std::move(checkpoint));
+        }
+      else
+        {
+          (void)chain_states;
+          assert (false);
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::vector<typename MetropolisHastings<OutputType,RandomNumberGenerator>::ChainState>
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    read_checkpoint (const std::vector<char> &checkpoint)
+    {
+      std::span<const char> buffer (checkpoint);
+
+      std::vector<ChainState> chain_states;
+      Serialization::read (buffer, chain_states);
+      assert (buffer.empty());
+
+      return chain_states;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    bool
+    MetropolisHastings<OutputType,RandomNumberGenerator>::
+    accept_trial_sample (const double trial_log_likelihood,
+                         const double current_log_likelihood,
+                         const double proposal_distribution_ratio,
+                         RandomNumberGenerator &chain_rng)
+    {
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      // We accept the trial sample if either the new sample has a higher
+      // likelihood (which happens if and only if the log likelihood of the
+      // new sample is larger than the log likelihood of the old sample), or
+      // if the ratio of likelihoods is larger than a randomly drawn number
+      // between zero and one. The ratio of likelihoods equals the exp of
+      // the difference of log likelihoods.
+      //
+      // There are two special cases to consider. If the probability of the
+      // new sample is zero (i.e., the log likelihood is either -infinity or
+      // -numeric_limits<double>::max()), then we never want to accept the
+      // sample and there is no need to do any arithmetic on it. If, on
+      // the other hand, the sample has a zero probability *and* the
+      // previous probability was *also* zero, then we always want to accept
+      // it so that we can do a random walk that hopefully at some point leads
+      // to an area of nonzero probabilities.
+      const bool trial_sample_has_zero_probability
+        = ((trial_log_likelihood == -std::numeric_limits<double>::max())
+           ||
+           (trial_log_likelihood == -std::numeric_limits<double>::infinity()));
+      const bool current_sample_has_zero_probability
+        = ((current_log_likelihood == -std::numeric_limits<double>::max())
+           ||
+           (current_log_likelihood == -std::numeric_limits<double>::infinity()));
+
+      return (!(trial_sample_has_zero_probability && !current_sample_has_zero_probability)
+              &&
+              ((trial_sample_has_zero_probability && current_sample_has_zero_probability
+                && (1. / proposal_distribution_ratio >= uniform_distribution(chain_rng)))
+               ||
+               (trial_log_likelihood - std::log(proposal_distribution_ratio) > current_log_likelihood)
+               ||
+               (std::exp(trial_log_likelihood - current_log_likelihood) / proposal_distribution_ratio >= uniform_distribution(chain_rng))));
     }
 
   }
@@ -0,0 +1,45 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_PRODUCERS_MULTILEVEL_METROPOLIS_HASTINGS_H
+#define SAMPLEFLOW_PRODUCERS_MULTILEVEL_METROPOLIS_HASTINGS_H
+
+#include <sampleflow/bounded_queue.h>
+#include <sampleflow/concepts.h>
+#include <sampleflow/producer.h>
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/random.h>
+#include <sampleflow/scope_exit.h>
+#include <sampleflow/types.h>
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/producers/multilevel_metropolis_hastings.impl.h>
+
+#endif
@@ -0,0 +1,627 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the multilevel Markov chain Monte Carlo method
+     * of Dodwell et al. (see @cite DodwellKetelsenScheichlTeckentrup2015).
+     * In many applications, the likelihood $\pi(x)$ involves the solution
+     * of a forward model, for example a partial differential equation,
+     * that can be computed at different levels of accuracy -- say, on a
+     * hierarchy of meshes. The cheap approximations $\pi_0,\pi_1,\ldots$
+     * of the likelihood $\pi=\pi_{L-1}$ on the coarse levels are then often
+     * good enough to do most of the work of exploring the distribution,
+     * and only a few evaluations of the expensive likelihood on the finest
+     * level are necessary to correct for their error.
+     *
+     * This class runs one Markov chain per level:
+     * - The chain on level zero is a Metropolis-Hastings chain for
+     *   $\pi_0$ with the given proposal function.
+     * - The chain on level $\ell>0$ uses samples of the chain on level
+     *   $\ell-1$ as its proposals: It takes every $t_{\ell-1}$th sample of
+     *   that chain, where $t_{\ell-1}$ is given by
+     *   Parameters::subsampling_rates, as trial sample $y$ for a step from
+     *   its current sample $x$, and accepts it with probability
+     *   @f{align*}{
+     *     \min\left\{1,
+     *       \frac{\pi_\ell(y)\,\pi_{\ell-1}(x)}{\pi_\ell(x)\,\pi_{\ell-1}(y)}
+     *     \right\},
+     *   @f}
+     *   using MetropolisHastings::accept_trial_sample() with
+     *   $\frac{\pi_{\ell-1}(y)}{\pi_{\ell-1}(x)}$ as the ratio of proposal
+     *   probabilities. If the subsampling rate is large enough for the
+     *   samples of level $\ell-1$ to be nearly independent, then trial
+     *   samples on level $\ell$ are nearly independent as well, and are
+     *   accepted with high probability if $\pi_{\ell-1}$ is a good
+     *   approximation of $\pi_\ell$. (The chain on level $\ell$ only
+     *   samples $\pi_\ell$ exactly if its proposals are independent;
+     *   subsampling rates that are too small compared to the
+     *   autocorrelation time of the coarser chain therefore lead to a
+     *   bias.)
+     *
+     * Each level runs on its own thread: The finest level on the thread
+     * that calls sample(), and each of the coarser levels on a thread of
+     * its own that this class starts. The threads communicate through
+     * BoundedQueue objects with Parameters::queue_capacity elements that
+     * hold the samples a level has produced for the next finer one. While
+     * the finer level evaluates its (expensive) likelihood, the coarser
+     * levels therefore already produce the next proposals; if the queue to
+     * the next finer level is full, a level waits for space to become
+     * available, and if its own queue is empty, it waits for the coarser
+     * level to produce the next proposal.
+     *
+     * The samples of the finest level are sent downstream through the
+     * signal of the base class, with the same AuxiliaryData entries as
+     * for the MetropolisHastings class. In addition, the class provides
+     * two kinds of outputs that allow computing multilevel estimators of
+     * the form
+     * @f{align*}{
+     *   E_{\pi_{L-1}}[Q] = E_{\pi_0}[Q]
+     *     + \sum_{\ell=1}^{L-1} \left( E_{\pi_\ell}[Q] - E_{\pi_{\ell-1}}[Q] \right),
+     * @f}
+     * where the differences on the right are estimated from pairs of
+     * samples of neighboring levels:
+     * - level_samples() returns, for each level, a producer that issues
+     *   the samples of the chain on that level, with an
+     *   AuxiliaryData::chain_number entry that stores the level.
+     * - For sample types that represent elements of a vector space,
+     *   corrections() returns, for each level $\ell>0$, a producer that
+     *   issues the difference $x_\ell^{(n)}-y^{(n)}$ between the $n$th
+     *   sample of the chain on level $\ell$ and the trial sample $y^{(n)}$
+     *   from level $\ell-1$ that was proposed in that step. The mean value
+     *   of these differences estimates $E_{\pi_\ell}[x]-E_{\pi_{\ell-1}}[x]$,
+     *   and so the mean value of the samples of level zero plus the mean
+     *   values of the corrections of all levels estimates the mean
+     *   value of $\pi_{L-1}$ (see @cite DodwellKetelsenScheichlTeckentrup2015
+     *   for why this can be much cheaper than computing it from samples
+     *   of the finest level alone).
+     *
+     * Consumers connected to the outputs of a level receive their samples
+     * on the thread that runs the level. The coarse levels continue to
+     * run until the finest level has produced the requested number of
+     * samples; since the coarse levels run ahead of the finer ones, they
+     * typically produce a few more samples than are eventually used as
+     * proposals.
+     *
+     * Each level has its own random number generator, namely the stream
+     * with the number of the level that Random::create_stream() creates
+     * from Parameters::random_seed. Since the queues between levels hand
+     * on samples in the order in which they were produced, the sequence
+     * of samples on every level is reproducible, even though the levels
+     * run concurrently.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number
+     *   generators. See the documentation of the MetropolisHastings class
+     *   for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class MultilevelMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed from which the random number generators of the
+           * levels are created.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The subsampling rates $t_0,t_1,\ldots,t_{L-2}$: Element $\ell$
+           * of this array is the number of steps the chain on level $\ell$
+           * takes between two samples it hands on to level $\ell+1$ as
+           * proposals. The number of levels is one more than the number of
+           * elements of this array.
+           */
+          std::vector<unsigned int> subsampling_rates;
+
+          /**
+           * The number of proposals that can be waiting in the queue
+           * between two levels.
+           */
+          std::size_t queue_capacity = 16;
+        };
+
+        /**
+         * Constructor.
+         */
+        MultilevelMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting the chains on
+         * all levels from the given initial sample, it produces a
+         * sequence of samples of the finest level that are passed through
+         * the signal of the base class to Consumer objects.
+         *
+         * @param[in] starting_point The initial sample of the chains on
+         *   all levels.
+         * @param[in] log_likelihoods Function objects that, when called
+         *   with a sample $x$, return $\log(\pi_\ell(x))$ for the levels
+         *   $\ell=0,\ldots,L-1$, ordered from coarsest to finest. The
+         *   functions are called on the threads that run the levels, but
+         *   each function is only called from one thread. See
+         *   MetropolisHastings::sample() for how samples with zero
+         *   probability are treated.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample along with the ratio of proposal probabilities, as for
+         *   the MetropolisHastings::sample_chains() function. It is only
+         *   used by the chain on level zero.
+         * @param[in] n_samples The number of (new) samples of the finest
+         *   level to be produced by this function.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::vector<std::function<double (const OutputType &)>> &log_likelihoods,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Return a producer that issues the samples of the chain on the
+         * given level, as described in the documentation of this class.
+         */
+        Producer<OutputType> &
+        level_samples (const std::size_t level);
+
+        /**
+         * Return a producer that issues the differences between the
+         * samples of the chain on the given level $\ell>0$ and the trial
+         * samples from level $\ell-1$, as described in the documentation of
+         * this class.
+         */
+        Producer<OutputType> &
+        corrections (const std::size_t level)
+        requires (Concepts::is_vector_space_type<OutputType>);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * A class whose only purpose is to give access to the
+         * Producer::issue_sample() function for the outputs returned by
+         * level_samples() and corrections().
+         */
+        class LevelOutput : public Producer<OutputType>
+        {
+            friend class MultilevelMetropolisHastings;
+        };
+
+        /**
+         * The outputs for the samples of each level, and for the
+         * corrections of each level but the coarsest. (The latter array is
+         * indexed by the level minus one.)
+         */
+        std::vector<std::unique_ptr<LevelOutput>> level_outputs;
+        std::vector<std::unique_ptr<LevelOutput>> correction_outputs;
+
+        /**
+         * A sample handed on from one level to the next finer one as a
+         * proposal, along with the log likelihood the coarser level has
+         * computed for it.
+         */
+        struct Proposal
+        {
+          OutputType sample;
+          double     log_likelihood;
+        };
+
+        /**
+         * A queue of proposals between two levels, along with the mutex and
+         * condition variables that let the threads of the two levels wait
+         * for the queue to have an element or space for one.
+         */
+        struct ProposalQueue
+        {
+          ProposalQueue (const std::size_t capacity);
+
+          BoundedQueue<Proposal>  queue;
+          std::mutex              mutex;
+          std::condition_variable not_empty;
+          std::condition_variable not_full;
+        };
+
+        /**
+         * Add the given proposal to the given queue, waiting for space if
+         * necessary. Return `false` without adding the proposal if `stop`
+         * is set while waiting.
+         */
+        static
+        bool
+        push (ProposalQueue &queue,
+              Proposal &proposal,
+              const std::atomic<bool> &stop);
+
+        /**
+         * Remove a proposal from the given queue, waiting for one to
+         * arrive if necessary. Return an empty object if `stop` is set
+         * while waiting.
+         */
+        static
+        std::optional<Proposal>
+        pop (ProposalQueue &queue,
+             const std::atomic<bool> &stop);
+
+        /**
+         * Run the chain on the given level until it has taken `n_samples`
+         * steps or `stop` is set. `queues[l-1]` is the queue of proposals
+         * from level $l-1$ to level $l$.
+         */
+        void
+        run_level (const std::size_t level,
+                   const OutputType &starting_point,
+                   const std::vector<std::function<double (const OutputType &)>> &log_likelihoods,
+                   const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                   const types::sample_index n_samples,
+                   std::vector<std::unique_ptr<ProposalQueue>> &queues,
+                   const std::atomic<bool> &stop);
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    ProposalQueue::ProposalQueue (const std::size_t capacity)
+      :
+      queue (capacity)
+    {}
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    MultilevelMetropolisHastings (const Parameters &parameters)
+      :
+      parameters (parameters)
+    {
+      for (const unsigned int rate : parameters.subsampling_rates)
+        {
+          (void)rate;
+          assert (rate >= 1);
+        }
+      assert (parameters.queue_capacity >= 1);
+
+      const std::size_t n_levels = parameters.subsampling_rates.size() + 1;
+      for (std::size_t level=0; level<n_levels; ++level)
+        level_outputs.emplace_back (std::make_unique<LevelOutput>());
+      for (std::size_t level=1; level<n_levels; ++level)
+        correction_outputs.emplace_back (std::make_unique<LevelOutput>());
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::vector<std::function<double (const OutputType &)>> &log_likelihoods,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      const std::size_t n_levels = level_outputs.size();
+      assert (log_likelihoods.size() == n_levels);
+
+      // Make sure the flush_consumers() function of all outputs is called
+      // at any point where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        for (const auto &output : level_outputs)
+          output->flush_consumers();
+        for (const auto &output : correction_outputs)
+          output->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      std::vector<std::unique_ptr<ProposalQueue>> queues;
+      for (std::size_t level=1; level<n_levels; ++level)
+        queues.emplace_back (std::make_unique<ProposalQueue> (parameters.queue_capacity));
+
+      // Start the threads for the coarse levels. If one of them fails
+      // with an exception, tell all other levels to stop and re-throw the
+      // exception on the current thread once all threads have finished.
+      std::atomic<bool>  stop (false);
+      std::exception_ptr exception;
+      std::mutex         exception_mutex;
+
+      const auto stop_all_levels = [&]()
+      {
+        stop = true;
+        for (const auto &queue : queues)
+          {
+            {
+              std::lock_guard<std::mutex> lock (queue->mutex);
+            }
+            queue->not_empty.notify_all();
+            queue->not_full.notify_all();
+          }
+      };
+
+      std::vector<std::thread> threads;
+      for (std::size_t level=0; level<n_levels-1; ++level)
+        threads.emplace_back ([&, level]()
+      {
+        try
+          {
+            run_level (level, starting_point, log_likelihoods, propose_sample,
+                       std::numeric_limits<types::sample_index>::max(),
+                       queues, stop);
+          }
+        catch (...)
+          {
+            {
+              std::lock_guard<std::mutex> lock (exception_mutex);
+              exception = std::current_exception();
+            }
+            stop_all_levels ();
+          }
+      });
+
+      // Then run the finest level on the current thread, and stop the
+      // other levels once it is done:
+      try
+        {
+          run_level (n_levels-1, starting_point, log_likelihoods, propose_sample,
+                     n_samples, queues, stop);
+        }
+      catch (...)
+        {
+          std::lock_guard<std::mutex> lock (exception_mutex);
+          exception = std::current_exception();
+        }
+
+      stop_all_levels ();
+      for (std::thread &thread : threads)
+        thread.join();
+
+      if (exception)
+        std::rethrow_exception (exception);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Producer<OutputType> &
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    level_samples (const std::size_t level)
+    {
+      assert (level < level_outputs.size());
+      return *level_outputs[level];
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Producer<OutputType> &
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    corrections (const std::size_t level)
+    requires (Concepts::is_vector_space_type<OutputType>)
+    {
+      assert ((level >= 1) && (level < level_outputs.size()));
+      return *correction_outputs[level-1];
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    bool
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    push (ProposalQueue &queue,
+          Proposal &proposal,
+          const std::atomic<bool> &stop)
+    {
+      // Try without the mutex first. If the queue is full, wait until the
+      // thread that removes elements tells us that there is space. That
+      // thread acquires the mutex before notifying us, so we cannot miss
+      // the notification between checking and going to sleep.
+      bool pushed = queue.queue.try_push (proposal);
+      if (pushed == false)
+        {
+          std::unique_lock<std::mutex> lock (queue.mutex);
+          queue.not_full.wait (lock, [&]()
+          {
+            pushed = queue.queue.try_push (proposal);
+            return (pushed || stop.load());
+          });
+        }
+
+      if (pushed)
+        {
+          {
+            std::lock_guard<std::mutex> lock (queue.mutex);
+          }
+          queue.not_empty.notify_one();
+        }
+      return pushed;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::optional<typename MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::Proposal>
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    pop (ProposalQueue &queue,
+         const std::atomic<bool> &stop)
+    {
+      // The same as in push(), with the roles reversed:
+      std::optional<Proposal> proposal = queue.queue.try_pop ();
+      if (!proposal)
+        {
+          std::unique_lock<std::mutex> lock (queue.mutex);
+          queue.not_empty.wait (lock, [&]()
+          {
+            proposal = queue.queue.try_pop ();
+            return (proposal.has_value() || stop.load());
+          });
+        }
+
+      if (proposal)
+        {
+          {
+            std::lock_guard<std::mutex> lock (queue.mutex);
+          }
+          queue.not_full.notify_one();
+        }
+      return proposal;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MultilevelMetropolisHastings<OutputType,RandomNumberGenerator>::
+    run_level (const std::size_t level,
+               const OutputType &starting_point,
+               const std::vector<std::function<double (const OutputType &)>> &log_likelihoods,
+               const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+               const types::sample_index n_samples,
+               std::vector<std::unique_ptr<ProposalQueue>> &queues,
+               const std::atomic<bool> &stop)
+    {
+      const std::size_t n_levels = level_outputs.size();
+      const bool        is_finest_level = (level == n_levels-1);
+
+      const auto has_zero_probability = [](const double log_likelihood)
+      {
+        return ((log_likelihood == -std::numeric_limits<double>::max())
+                ||
+                (log_likelihood == -std::numeric_limits<double>::infinity()));
+      };
+
+      RandomNumberGenerator rng
+        = Random::create_stream<RandomNumberGenerator> (parameters.random_seed, level);
+
+      // For levels other than the coarsest, we also need the log
+      // likelihood of the current sample on the next coarser level to
+      // compute the ratio of proposal probabilities:
+      OutputType current_sample = starting_point;
+      double     current_log_likelihood = log_likelihoods[level] (current_sample);
+      double     current_coarse_log_likelihood
+        = (level > 0 ?
+           log_likelihoods[level-1] (current_sample) :
+           std::numeric_limits<double>::quiet_NaN());
+
+      unsigned int n_steps_since_last_proposal = 0;
+      for (types::sample_index step=0; step<n_samples; ++step)
+        {
+          if (stop.load() || (is_finest_level && this->stop_requested()))
+            break;
+
+          // Get a trial sample, either from the proposal function or from
+          // the next coarser level:
+          OutputType trial_sample;
+          double     proposal_distribution_ratio;
+          double     trial_coarse_log_likelihood = std::numeric_limits<double>::quiet_NaN();
+          if (level == 0)
+            std::tie (trial_sample, proposal_distribution_ratio)
+              = propose_sample (current_sample, rng);
+          else
+            {
+              std::optional<Proposal> proposal = pop (*queues[level-1], stop);
+              if (!proposal)
+                break;
+
+              trial_sample                = std::move (proposal->sample);
+              trial_coarse_log_likelihood = proposal->log_likelihood;
+
+              // The proposal distribution is the coarse distribution. If
+              // the current sample has zero probability there (which can
+              // only be the case for the starting point), ignore it so
+              // that the chain can move to a sample of nonzero probability.
+              proposal_distribution_ratio
+                = ((has_zero_probability (current_coarse_log_likelihood) ||
+                    has_zero_probability (trial_coarse_log_likelihood)) ?
+                   1. :
+                   std::exp (trial_coarse_log_likelihood - current_coarse_log_likelihood));
+            }
+
+          const double trial_log_likelihood = log_likelihoods[level] (trial_sample);
+          const bool   accepted
+            = MetropolisHastings<OutputType,RandomNumberGenerator>::
+              accept_trial_sample (trial_log_likelihood,
+                                   current_log_likelihood,
+                                   proposal_distribution_ratio,
+                                   rng);
+
+          // Compute the correction before we overwrite anything: The
+          // difference between the sample the chain ends up at and the
+          // trial sample, which is zero if the trial sample is accepted.
+          if constexpr (Concepts::is_vector_space_type<OutputType>)
+            if (level > 0)
+              {
+                OutputType correction = (accepted ? trial_sample : current_sample);
+                correction -= trial_sample;
+                correction_outputs[level-1]->issue_sample (std::move(correction),
+                {
+                  {AuxiliaryData::chain_number, std::any(level)}
+                });
+              }
+
+          if (accepted)
+            {
+              std::swap (current_sample, trial_sample);
+              current_log_likelihood        = trial_log_likelihood;
+              current_coarse_log_likelihood = trial_coarse_log_likelihood;
+            }
+
+          level_outputs[level]->issue_sample (current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted)},
+            {AuxiliaryData::chain_number, std::any(level)}
+          });
+
+          if (is_finest_level)
+            this->issue_sample (current_sample,
+            {
+              {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+              {AuxiliaryData::sample_is_repeated, std::any(!accepted)}
+            });
+          else
+            {
+              // Hand on every so many samples to the next finer level:
+              ++n_steps_since_last_proposal;
+              if (n_steps_since_last_proposal == parameters.subsampling_rates[level])
+                {
+                  Proposal proposal {current_sample, current_log_likelihood};
+                  if (push (*queues[level], proposal, stop) == false)
+                    break;
+                  n_steps_since_last_proposal = 0;
+                }
+            }
+        }
+    }
+  }
+}
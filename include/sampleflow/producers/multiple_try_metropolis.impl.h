@@ -0,0 +1,429 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the Multiple-Try Metropolis algorithm of Liu,
+     * Liang, and Wong (2000). In each step, the standard Metropolis-Hastings
+     * algorithm (see the MetropolisHastings class) proposes one trial
+     * sample and accepts or rejects it. Multiple-Try Metropolis instead
+     * proposes $k$ trial samples $y_1,\ldots,y_k$ from the current sample
+     * $x$, selects one of them, $y=y_J$, with probability proportional to
+     * weights $w(y_j,x)$ that favor trial samples with high likelihood,
+     * then draws $k-1$ "reference" samples $x^*_1,\ldots,x^*_{k-1}$ from
+     * $y$ (and sets $x^*_k=x$), and accepts $y$ with probability
+     * @f{align*}{
+     *   \min\left\{1, \frac{\sum_{j=1}^k w(y_j,x)}{\sum_{i=1}^k w(x^*_i,y)}\right\}.
+     * @f}
+     * This way, a step can make a larger move than a single Metropolis
+     * Hastings step -- the proposal distribution can be wider since the
+     * selection among several trial samples makes it likely that a good one
+     * is found -- at the cost of $2k-1$ likelihood evaluations per step.
+     * These evaluations are independent of each other within each of the
+     * two sets, and this class evaluates the $k$ likelihoods of the trial
+     * samples concurrently, and then those of the $k-1$ reference samples.
+     * If likelihood evaluations are expensive and there are idle cores,
+     * a step then takes about the time of two likelihood evaluations, and
+     * the algorithm converts these cores into better mixing of a single
+     * chain.
+     *
+     * The class uses the same proposal functions as the MetropolisHastings
+     * class, which return both a trial sample $\tilde x$ and the ratio
+     * $r(\tilde x,x)=\frac{\pi_\text{proposal}(\tilde x|x)}
+     *                     {\pi_\text{proposal}(x|\tilde x)}$. The weights
+     * are chosen as
+     * @f{align*}{
+     *   w(y,x) = \frac{\pi(y)}{\sqrt{r(y,x)}},
+     * @f}
+     * which corresponds to the choice
+     * $\lambda(x,y)=(\pi_\text{proposal}(y|x)\pi_\text{proposal}(x|y))^{-1/2}$
+     * of the symmetric function in the paper, and which only requires the
+     * ratio of proposal probabilities, not the probabilities themselves.
+     * For symmetric proposal distributions, the weights are simply the
+     * likelihoods of the samples. With $k=1$, the algorithm is the
+     * Metropolis-Hastings algorithm.
+     *
+     * The AuxiliaryData object sent along with each sample stores the same
+     * entries as are described for the MetropolisHastings class.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used to select among the trial samples and to decide whether they
+     *   are accepted. See the documentation of the MetropolisHastings class
+     *   for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class MultipleTryMetropolis : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generators used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The number $k$ of trial samples proposed in each step.
+           */
+          unsigned int n_trials = 4;
+
+          /**
+           * The pool on which the likelihood evaluations are run by the
+           * sample() function that takes a function evaluating the
+           * likelihood of one sample at a time. If this is `nullptr` (the
+           * default), then the pool returned by ThreadPool::default_pool()
+           * is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        MultipleTryMetropolis (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial sample $x_0$, it produces a sequence of samples $x_k$
+         * that are passed through the signal of the base class to
+         * Consumer objects.
+         *
+         * @param[in] starting_point The initial sample $x_0$.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$. The function is
+         *   called concurrently for the trial samples (and then the
+         *   reference samples) of each step on the threads of
+         *   Parameters::thread_pool, and so needs to be reentrant. As
+         *   for the MetropolisHastings class, a value of
+         *   `-std::numeric_limits<double>::max()` or minus infinity
+         *   indicates that the sample has zero probability.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$, returns a trial sample $\tilde x$ and the ratio of
+         *   proposal probabilities, exactly as for
+         *   MetropolisHastings::sample(). This function is only called on
+         *   the thread that calls this function.
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function. This is also the number of times the
+         *   signal is called that notifies Consumer objects that a new
+         *   sample is available.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once:
+         * In each step, first for the trial samples, and then for the
+         * reference samples. Whether and how the evaluation of a batch is
+         * parallelized is up to the function object.
+         *
+         * For the same arguments and random seed, this function produces
+         * the same sequence of samples as the previous function.
+         *
+         * @param[in] starting_point See the previous function.
+         * @param[in] log_likelihood A function object that, when called with
+         *   a sequence of samples $x_j$, writes $\log(\pi(x_j))$ into the
+         *   corresponding elements of its second argument. See
+         *   types::BatchLogLikelihood.
+         * @param[in] propose_sample See the previous function.
+         * @param[in] n_samples See the previous function.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+
+        /**
+         * Return the logarithm of the weight $w(y,x)$ of a sample $y$
+         * proposed from $x$, given $\log(\pi(y))$ and the ratio of proposal
+         * probabilities $r(y,x)$. For samples with zero probability, this
+         * function returns minus infinity.
+         */
+        static
+        double
+        log_weight (const double log_likelihood,
+                    const double proposal_distribution_ratio);
+
+        /**
+         * Return $\log(\sum_i \exp(a_i))$ for the given numbers $a_i$,
+         * computed in a way that avoids overflow and underflow.
+         */
+        static
+        double
+        log_sum_exp (const std::vector<double> &a);
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    MultipleTryMetropolis<OutputType,RandomNumberGenerator>::
+    MultipleTryMetropolis (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert (parameters.n_trials >= 1);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MultipleTryMetropolis<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      // Wrap the function into one that evaluates a whole batch of
+      // samples as tasks on the thread pool:
+      const std::shared_ptr<ThreadPool> thread_pool
+        = (parameters.thread_pool != nullptr ?
+           parameters.thread_pool :
+           ThreadPool::default_pool());
+      const auto batch_log_likelihood
+        = [&log_likelihood, &thread_pool](std::span<const OutputType> samples,
+                                          std::span<double> log_likelihoods)
+      {
+        assert (samples.size() == log_likelihoods.size());
+
+        if (samples.size() == 1)
+          log_likelihoods[0] = log_likelihood (samples[0]);
+        else
+          {
+            ThreadPool::TaskGroup evaluations;
+            for (std::size_t i=0; i<samples.size(); ++i)
+              evaluations.run (*thread_pool,
+                               [&log_likelihood, &samples, &log_likelihoods, i]()
+            {
+              log_likelihoods[i] = log_likelihood (samples[i]);
+            });
+            evaluations.wait();
+          }
+      };
+
+      sample (starting_point,
+              batch_log_likelihood,
+              propose_sample,
+              n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    MultipleTryMetropolis<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      const unsigned int n_trials = parameters.n_trials;
+
+      OutputType current_sample = starting_point;
+      double     current_log_likelihood;
+      log_likelihood (std::span<const OutputType> (&current_sample, 1),
+                      std::span<double> (&current_log_likelihood, 1));
+
+      // Arrays for the trial samples, the reference samples, and their
+      // log likelihoods and log weights. We allocate them once and re-use
+      // them (and, if possible, the memory of the samples they store) in
+      // all steps. The last of the log weights of the reference samples
+      // is the one of the current sample.
+      std::vector<OutputType> trial_samples (n_trials, starting_point);
+      std::vector<double>     trial_log_likelihoods (n_trials);
+      std::vector<double>     trial_proposal_distribution_ratios (n_trials);
+      std::vector<double>     trial_log_weights (n_trials);
+
+      std::vector<OutputType> reference_samples (n_trials-1, starting_point);
+      std::vector<double>     reference_log_likelihoods (n_trials-1);
+      std::vector<double>     reference_log_weights (n_trials);
+
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      for (types::sample_index i=0; (i<n_samples) && (this->stop_requested() == false); ++i)
+        {
+          // Propose the trial samples and evaluate their likelihoods:
+          for (unsigned int j=0; j<n_trials; ++j)
+            {
+              std::pair<OutputType,double> trial_sample_and_ratio
+                = propose_sample (current_sample);
+              trial_samples[j]                      = std::move(trial_sample_and_ratio.first);
+              trial_proposal_distribution_ratios[j] = trial_sample_and_ratio.second;
+            }
+          log_likelihood (trial_samples, trial_log_likelihoods);
+
+          // Select one of them with probability proportional to its
+          // weight. If all trial samples have zero probability, we reject
+          // them all -- unless the current sample also has zero
+          // probability, in which case we treat the first trial sample as
+          // the MetropolisHastings class does, so that the chain can do a
+          // random walk that hopefully leads to an area of nonzero
+          // probability.
+          for (unsigned int j=0; j<n_trials; ++j)
+            trial_log_weights[j] = log_weight (trial_log_likelihoods[j],
+                                               trial_proposal_distribution_ratios[j]);
+          const double log_sum_of_trial_weights = log_sum_exp (trial_log_weights);
+
+          bool accepted_sample = false;
+          if (log_sum_of_trial_weights == -std::numeric_limits<double>::infinity())
+            {
+              if ((log_weight (current_log_likelihood, 1.) == -std::numeric_limits<double>::infinity())
+                  &&
+                  (1. / trial_proposal_distribution_ratios[0] >= uniform_distribution(rng)))
+                {
+                  accepted_sample = true;
+                  std::swap (current_sample, trial_samples[0]);
+                  current_log_likelihood = trial_log_likelihoods[0];
+                }
+            }
+          else
+            {
+              unsigned int selected = n_trials-1;
+              {
+                const double threshold = uniform_distribution(rng);
+                double cumulative_probability = 0;
+                for (unsigned int j=0; j<n_trials-1; ++j)
+                  {
+                    cumulative_probability += std::exp(trial_log_weights[j] - log_sum_of_trial_weights);
+                    if (threshold < cumulative_probability)
+                      {
+                        selected = j;
+                        break;
+                      }
+                  }
+              }
+
+              // Draw the reference samples from the selected trial sample,
+              // evaluate their likelihoods, and compute their weights as
+              // well as the weight of the current sample as seen from the
+              // selected trial sample. The proposal probability ratio for
+              // going back from the selected sample to the current one is
+              // the inverse of the one for going forward.
+              for (unsigned int j=0; j<n_trials-1; ++j)
+                {
+                  std::pair<OutputType,double> reference_sample_and_ratio
+                    = propose_sample (trial_samples[selected]);
+                  reference_samples[j]     = std::move(reference_sample_and_ratio.first);
+                  reference_log_weights[j] = reference_sample_and_ratio.second;
+                }
+              if (n_trials > 1)
+                log_likelihood (reference_samples, reference_log_likelihoods);
+
+              for (unsigned int j=0; j<n_trials-1; ++j)
+                reference_log_weights[j] = log_weight (reference_log_likelihoods[j],
+                                                       reference_log_weights[j]);
+              reference_log_weights[n_trials-1]
+                = log_weight (current_log_likelihood,
+                              1. / trial_proposal_distribution_ratios[selected]);
+              const double log_sum_of_reference_weights = log_sum_exp (reference_log_weights);
+
+              // Then accept the selected trial sample with the
+              // probability given by the ratio of the two sums of weights:
+              const double log_acceptance_ratio = log_sum_of_trial_weights - log_sum_of_reference_weights;
+              accepted_sample = ((log_acceptance_ratio >= 0)
+                                 ||
+                                 (std::exp(log_acceptance_ratio) >= uniform_distribution(rng)));
+
+              if (accepted_sample)
+                {
+                  std::swap (current_sample, trial_samples[selected]);
+                  current_log_likelihood = trial_log_likelihoods[selected];
+                }
+            }
+
+          // Output the new sample (which may be equal to the old sample).
+          this->issue_sample (current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihood)},
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)}
+          });
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    MultipleTryMetropolis<OutputType,RandomNumberGenerator>::
+    log_weight (const double log_likelihood,
+                const double proposal_distribution_ratio)
+    {
+      if ((log_likelihood == -std::numeric_limits<double>::max())
+          ||
+          (log_likelihood == -std::numeric_limits<double>::infinity()))
+        return -std::numeric_limits<double>::infinity();
+      else
+        return log_likelihood - 0.5 * std::log(proposal_distribution_ratio);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    MultipleTryMetropolis<OutputType,RandomNumberGenerator>::
+    log_sum_exp (const std::vector<double> &a)
+    {
+      const double max = *std::max_element (a.begin(), a.end());
+      if (max == -std::numeric_limits<double>::infinity())
+        return max;
+
+      double sum = 0;
+      for (const double a_i : a)
+        sum += std::exp(a_i - max);
+      return max + std::log(sum);
+    }
+  }
+}
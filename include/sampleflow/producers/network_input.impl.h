@@ -0,0 +1,236 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A producer that receives samples that Consumers::NetworkOutput
+     * objects send over TCP connections, and sends them downstream. See the
+     * documentation of Consumers::NetworkOutput for an example.
+     *
+     * The constructor of this class starts listening for connections, so
+     * that the sending sides can connect as soon as the object exists.
+     * sample() then accepts the given number of connections, and sends the
+     * samples of each frame that arrives on any of them downstream as one
+     * batch (see Producer::issue_batch()). Frames are decompressed on the
+     * thread that calls sample().
+     *
+     * @tparam OutputType The type of the samples this producer creates. It
+     *   needs to have the same scalar type as the samples sent by the
+     *   other side, but need not be the same type: For example, the
+     *   sending process may use `std::vector<double>` and the receiving
+     *   one `Eigen::VectorXd`.
+     */
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    class NetworkInput : public Producer<OutputType>
+    {
+      public:
+        /**
+         * Constructor. Start listening for connections.
+         *
+         * @param[in] port The port on which to listen for connections. If
+         *   zero, the operating system chooses a free port, which can then
+         *   be queried with port().
+         * @param[in] n_senders The number of Consumers::NetworkOutput
+         *   objects that will connect.
+         */
+        NetworkInput (const std::uint16_t port = 0,
+                      const unsigned int  n_senders = 1);
+
+        /**
+         * Destructor. Stop listening for connections.
+         */
+        ~NetworkInput ();
+
+        /**
+         * Return the port on which the current object listens.
+         */
+        std::uint16_t
+        port () const;
+
+        /**
+         * Accept connections from the number of senders given to the
+         * constructor, then receive samples from them and send them
+         * downstream until all senders have closed their connections, or
+         * until a downstream object requests that sampling stop. In the
+         * latter case, the connections are closed, and the senders discard
+         * all samples they would still have sent.
+         */
+        void
+        sample ();
+
+      private:
+        /**
+         * The socket that listens for connections.
+         */
+        const int listening_socket;
+
+        /**
+         * The number of senders to accept.
+         */
+        const unsigned int n_senders;
+    };
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    NetworkInput<OutputType>::
+    NetworkInput (const std::uint16_t port,
+                  const unsigned int  n_senders)
+      :
+      listening_socket (NetworkStream::listen_on (port, n_senders)),
+      n_senders (n_senders)
+    {
+      assert (n_senders > 0);
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    NetworkInput<OutputType>::
+    ~NetworkInput ()
+    {
+      close (listening_socket);
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    std::uint16_t
+    NetworkInput<OutputType>::
+    port () const
+    {
+      return NetworkStream::local_port (listening_socket);
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    void
+    NetworkInput<OutputType>::
+    sample ()
+    {
+      // Accept all connections, and read what each sender is going to
+      // send:
+      std::vector<pollfd>                  connections;
+      std::vector<ChainFileFormat::Header> headers;
+      while (connections.size() < n_senders)
+        {
+          const int connection = accept (listening_socket, nullptr, nullptr);
+          if (connection < 0)
+            {
+              assert (errno == EINTR);
+              continue;
+            }
+
+          if (const std::optional<ChainFileFormat::Header> header
+              = NetworkStream::receive_preamble (connection))
+            {
+              assert (header->scalar_kind == ChainFileFormat::scalar_kind<types::ScalarType<OutputType>>());
+              assert (header->scalar_size == sizeof(types::ScalarType<OutputType>));
+
+              connections.push_back ({connection, POLLIN, 0});
+              headers.push_back (*header);
+            }
+          else
+            {
+              // The sender went away before it told us anything. Count it
+              // as one that is done:
+              close (connection);
+              connections.push_back ({-1, 0, 0});
+              headers.emplace_back ();
+            }
+        }
+
+      Utilities::ScopeExit scope_exit ([this, &connections]()
+      {
+        for (const pollfd &connection : connections)
+          if (connection.fd >= 0)
+            close (connection.fd);
+
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      std::vector<char>          payload;
+      std::vector<char>          records;
+      std::vector<OutputType>    samples;
+      std::vector<AuxiliaryData> aux_data;
+      std::size_t n_open_connections = std::count_if (connections.begin(), connections.end(),
+                                                      [](const pollfd &connection)
+      {
+        return connection.fd >= 0;
+      });
+      while (n_open_connections > 0)
+        {
+          // Wait for frames to arrive on any connection. poll() ignores
+          // entries with negative file descriptors, which is what we use
+          // for connections that have been closed:
+          if (poll (connections.data(), connections.size(), -1) < 0)
+            {
+              assert (errno == EINTR);
+              continue;
+            }
+
+          for (unsigned int c=0; c<connections.size(); ++c)
+            {
+              if ((connections[c].fd < 0) || (connections[c].revents == 0))
+                continue;
+
+              // Read a whole frame. If that fails, the sender has closed the
+              // connection:
+              NetworkStream::FrameHeader frame_header;
+              bool success = NetworkStream::receive_all (connections[c].fd,
+              {reinterpret_cast<char *>(&frame_header), sizeof(frame_header)});
+              if (success)
+                {
+                  payload.resize (frame_header.payload_size);
+                  success = NetworkStream::receive_all (connections[c].fd, payload);
+                }
+              if (success == false)
+                {
+                  close (connections[c].fd);
+                  connections[c].fd = -1;
+                  --n_open_connections;
+                  continue;
+                }
+
+              const std::size_t record_size = headers[c].record_size();
+              NetworkStream::decode_payload (frame_header, payload, record_size, records);
+
+              samples.resize (frame_header.n_records);
+              aux_data.resize (frame_header.n_records);
+              for (unsigned int i=0; i<frame_header.n_records; ++i)
+                {
+                  aux_data[i] = AuxiliaryData();
+                  ChainFileFormat::read_record (records.data() + i*record_size, headers[c],
+                                                samples[i], aux_data[i]);
+                }
+
+              this->issue_batch (samples, aux_data);
+              if (this->stop_requested())
+                return;
+            }
+        }
+    }
+  }
+}
@@ -0,0 +1,458 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the parallel tempering (or "replica exchange")
+     * algorithm. Probability distributions with several well-separated
+     * modes are notoriously difficult to sample with a Metropolis-Hastings
+     * chain: Proposals have to be small enough to be accepted with a
+     * reasonable probability within a mode, but then the chain hardly ever
+     * crosses the region of low probability that separates the modes.
+     * Parallel tempering addresses this by running a number of chains
+     * ("replicas") at the same time, each sampling from a "tempered"
+     * version of the distribution,
+     * @f{align*}{
+     *   \pi_r(x) \propto \pi(x)^{1/T_r},
+     * @f}
+     * where $1=T_0<T_1<\ldots<T_{R-1}$ are the temperatures of the
+     * replicas. For large temperatures, the distribution becomes flatter,
+     * and the chain moves easily between modes. Every so often, the
+     * algorithm then proposes to exchange the current samples of two
+     * replicas $r, r+1$ with adjacent temperatures, and accepts this swap
+     * with probability
+     * @f{align*}{
+     *   \min\left\{1,
+     *     \left(\frac{\pi(x_{r+1})}{\pi(x_r)}\right)^{1/T_r-1/T_{r+1}}
+     *   \right\}.
+     * @f}
+     * This way, samples found by the hot replicas in other modes
+     * eventually make their way down to the "cold" replica $r=0$ that
+     * samples the distribution $\pi(x)$ one is actually interested in.
+     *
+     * This class runs each replica as a Metropolis-Hastings chain with the
+     * given proposal function. The replicas take `Parameters::swap_interval`
+     * steps independently of each other, as tasks on a ThreadPool, before
+     * the calling thread performs the swap moves and the replicas continue.
+     * The swaps are proposed alternatingly between all pairs $(r,r+1)$ with
+     * even $r$ and all pairs with odd $r$ (the "deterministic even-odd"
+     * scheme), which is known to move samples through the temperature
+     * ladder faster than proposing swaps between randomly chosen pairs.
+     * Since swaps only exchange the samples of two replicas, they require
+     * neither copies of the samples nor evaluations of the likelihood.
+     *
+     * Only the samples of the cold replica are sent downstream through the
+     * signal of the base class, and so the class can be used like any other
+     * producer; the AuxiliaryData object that accompanies each sample
+     * stores the same information as for the MetropolisHastings class. (If
+     * a swap has moved a different sample into the cold replica, then the
+     * next sample is not marked as repeated, even if the trial sample of
+     * that step is rejected.) If one is interested in the samples of all
+     * replicas, for example to tune the temperature ladder, then one can
+     * connect consumers to the separate producer returned by
+     * replica_samples(), which issues the samples of all replicas with an
+     * AuxiliaryData::chain_number entry that indicates which replica a
+     * sample belongs to.
+     *
+     * Each replica uses its own random number generator, namely the stream
+     * with the number of the replica that Random::create_stream() creates
+     * from Parameters::random_seed; the swap moves use the stream whose
+     * number equals the number of replicas. The sequence of samples
+     * is therefore reproducible, and does not depend on the number of
+     * threads of the pool.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator.
+     *   See the documentation of the MetropolisHastings class for more
+     *   information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class ParallelTempering : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generators used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The temperatures $T_r$ of the replicas. The number of elements
+           * of this array determines the number of replicas. The first
+           * temperature must be one, and the temperatures must be
+           * increasing. A geometric progression of temperatures is often a
+           * good choice; the ratio between successive temperatures should
+           * be small enough that a reasonable fraction of swaps is accepted
+           * (see get_swap_acceptance_ratios()).
+           */
+          std::vector<double> temperatures = {1., 2., 4., 8.};
+
+          /**
+           * The number of steps each replica takes between two rounds of
+           * swap moves. Larger values mean less synchronization between
+           * the replicas; smaller ones let samples move through the
+           * temperature ladder faster.
+           */
+          unsigned int swap_interval = 10;
+
+          /**
+           * The pool on which the replicas are run. If this is `nullptr`
+           * (the default), then the pool returned by
+           * ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        ParallelTempering (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting all replicas from
+         * the given initial sample, it produces a sequence of samples of
+         * the cold replica that are passed through the signal of the base
+         * class to Consumer objects.
+         *
+         * @param[in] starting_point The initial sample of all replicas.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$, i.e., the natural
+         *   logarithm of the *untempered* likelihood function evaluated at
+         *   the sample. This function is called concurrently from the
+         *   threads of the pool, and so needs to be reentrant. See
+         *   MetropolisHastings::sample() for how samples with zero
+         *   probability are treated.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample $\tilde x$ and the ratio of proposal probabilities
+         *   $\frac{\pi_\text{proposal}(\tilde x|x)}
+         *         {\pi_\text{proposal}(x|\tilde x)}$, as described for
+         *   MetropolisHastings::sample(). This function is also called
+         *   concurrently, and so should only use the random number
+         *   generator it is given. Because the tempered distributions are
+         *   wider than the original one, it is often useful to make larger
+         *   proposals for hotter replicas; use the two-argument form of
+         *   `propose_sample` below for this.
+         * @param[in] n_samples The number of (new) samples of the cold
+         *   replica to be produced by this function; every other replica
+         *   takes the same number of steps.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Like the previous function, but with a proposal function that
+         * also receives the number of the replica for which it is called,
+         * so that it can scale its proposals with the temperature
+         * `Parameters::temperatures[replica]`.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, const std::size_t replica, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples);
+
+        /**
+         * Return a producer that issues the samples of all replicas,
+         * including the cold one. Consumers connected to it receive the
+         * samples concurrently from the threads of the pool, in an order
+         * that is only well-defined for the samples of each individual
+         * replica, and can tell the replicas apart by the
+         * AuxiliaryData::chain_number entry of the AuxiliaryData object
+         * that accompanies each sample. The AuxiliaryData::relative_log_likelihood
+         * entry contains the untempered log likelihood of the sample.
+         */
+        Producer<OutputType> &
+        replica_samples ();
+
+        /**
+         * For each pair of replicas with adjacent temperatures, return the
+         * fraction of proposed swaps between these replicas that was
+         * accepted in all calls to sample() so far. Element $r$ of the
+         * returned array corresponds to the pair $(r,r+1)$, and so the
+         * array has one element less than there are replicas.
+         */
+        std::vector<double>
+        get_swap_acceptance_ratios () const;
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * A class whose only purpose is to give access to the
+         * Producer::issue_sample() function for the output returned by
+         * replica_samples().
+         */
+        class ReplicaSamples : public Producer<OutputType>
+        {
+            friend class ParallelTempering;
+        };
+
+        /**
+         * The output for the samples of all replicas.
+         */
+        ReplicaSamples all_replica_samples;
+
+        /**
+         * The number of swaps proposed and accepted between each pair of
+         * adjacent replicas.
+         */
+        std::vector<types::sample_index> n_swaps_proposed;
+        std::vector<types::sample_index> n_swaps_accepted;
+
+        /**
+         * Return the tempered version of the given log likelihood for the
+         * given replica. Log likelihoods that indicate that a sample has
+         * zero probability are returned unchanged, so that
+         * MetropolisHastings::accept_trial_sample() recognizes them as
+         * such.
+         */
+        double
+        tempered_log_likelihood (const double log_likelihood,
+                                 const std::size_t replica) const;
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    ParallelTempering (const Parameters &parameters)
+      :
+      parameters (parameters),
+      n_swaps_proposed (parameters.temperatures.size() > 0 ? parameters.temperatures.size()-1 : 0, 0),
+      n_swaps_accepted (parameters.temperatures.size() > 0 ? parameters.temperatures.size()-1 : 0, 0)
+    {
+      assert (parameters.temperatures.size() >= 1);
+      assert (parameters.temperatures[0] == 1.);
+      for (std::size_t r=1; r<parameters.temperatures.size(); ++r)
+        assert (parameters.temperatures[r] > parameters.temperatures[r-1]);
+      assert (parameters.swap_interval >= 1);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      sample (starting_point,
+              log_likelihood,
+              [&propose_sample](const OutputType &x, const std::size_t, RandomNumberGenerator &rng)
+      {
+        return propose_sample (x, rng);
+      },
+      n_samples);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, const std::size_t replica, RandomNumberGenerator &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function of both outputs is called
+      // at any point where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        all_replica_samples.flush_consumers();
+        this->clear_stop_request();
+        all_replica_samples.clear_stop_request();
+      });
+
+      const std::size_t n_replicas = parameters.temperatures.size();
+      ThreadPool &thread_pool = (parameters.thread_pool != nullptr ?
+                                 *parameters.thread_pool :
+                                 *ThreadPool::default_pool());
+
+      // The state of each replica. Between two rounds of swaps, each
+      // replica is worked on by exactly one task.
+      struct Replica
+      {
+        OutputType            current_sample;
+        double                current_log_likelihood;
+        RandomNumberGenerator rng;
+        bool                  swapped;
+      };
+      std::vector<Replica> replicas;
+      replicas.reserve (n_replicas);
+      const double starting_log_likelihood = log_likelihood (starting_point);
+      for (std::size_t r=0; r<n_replicas; ++r)
+        replicas.push_back ({starting_point, starting_log_likelihood,
+                             Random::create_stream<RandomNumberGenerator> (parameters.random_seed, r),
+                             false
+                            });
+
+      RandomNumberGenerator swap_rng
+        = Random::create_stream<RandomNumberGenerator> (parameters.random_seed, n_replicas);
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      for (types::sample_index first_step=0, round=0;
+           first_step < n_samples;
+           first_step += parameters.swap_interval, ++round)
+        {
+          // Stop if someone has asked us to, via either of the two outputs:
+          if (this->stop_requested() || all_replica_samples.stop_requested())
+            break;
+
+          const types::sample_index n_steps
+            = std::min<types::sample_index> (parameters.swap_interval, n_samples - first_step);
+
+          // Let all replicas take their steps. The cold replica sends
+          // its samples downstream from the task it runs on; since there
+          // is only one such task at a time, the order of the samples is
+          // preserved.
+          {
+            ThreadPool::TaskGroup steps;
+            for (std::size_t r=0; r<n_replicas; ++r)
+              steps.run (thread_pool, [&, r]()
+            {
+              Replica &replica = replicas[r];
+              for (types::sample_index step=0; step<n_steps; ++step)
+                {
+                  if (this->stop_requested() || all_replica_samples.stop_requested())
+                    break;
+
+                  std::pair<OutputType,double> trial_sample_and_ratio
+                    = propose_sample (replica.current_sample, r, replica.rng);
+                  const double trial_log_likelihood = log_likelihood (trial_sample_and_ratio.first);
+
+                  const bool accepted_sample
+                    = MetropolisHastings<OutputType,RandomNumberGenerator>::
+                      accept_trial_sample (tempered_log_likelihood (trial_log_likelihood, r),
+                                           tempered_log_likelihood (replica.current_log_likelihood, r),
+                                           trial_sample_and_ratio.second,
+                                           replica.rng);
+                  if (accepted_sample)
+                    {
+                      replica.current_sample         = std::move(trial_sample_and_ratio.first);
+                      replica.current_log_likelihood = trial_log_likelihood;
+                    }
+                  const bool sample_is_repeated = !accepted_sample && !replica.swapped;
+                  replica.swapped = false;
+
+                  if (r == 0)
+                    this->issue_sample (replica.current_sample,
+                    {
+                      {AuxiliaryData::relative_log_likelihood, std::any(replica.current_log_likelihood)},
+                      {AuxiliaryData::sample_is_repeated, std::any(sample_is_repeated)}
+                    });
+
+                  all_replica_samples.issue_sample (replica.current_sample,
+                  {
+                    {AuxiliaryData::relative_log_likelihood, std::any(replica.current_log_likelihood)},
+                    {AuxiliaryData::sample_is_repeated, std::any(sample_is_repeated)},
+                    {AuxiliaryData::chain_number, std::any(r)}
+                  });
+                }
+            });
+            steps.wait();
+          }
+
+          // Then propose swaps between adjacent replicas, alternating
+          // between the pairs (0,1), (2,3), ... and (1,2), (3,4), ...
+          for (std::size_t r=round%2; r+1<n_replicas; r+=2)
+            {
+              const double log_acceptance_ratio
+                = (1./parameters.temperatures[r] - 1./parameters.temperatures[r+1])
+                  * (replicas[r+1].current_log_likelihood - replicas[r].current_log_likelihood);
+
+              ++n_swaps_proposed[r];
+              if ((log_acceptance_ratio >= 0)
+                  ||
+                  (std::exp(log_acceptance_ratio) >= uniform_distribution(swap_rng)))
+                {
+                  ++n_swaps_accepted[r];
+                  std::swap (replicas[r].current_sample, replicas[r+1].current_sample);
+                  std::swap (replicas[r].current_log_likelihood, replicas[r+1].current_log_likelihood);
+                  replicas[r].swapped   = true;
+                  replicas[r+1].swapped = true;
+                }
+            }
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    Producer<OutputType> &
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    replica_samples ()
+    {
+      return all_replica_samples;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::vector<double>
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    get_swap_acceptance_ratios () const
+    {
+      std::vector<double> ratios (n_swaps_proposed.size(), 0.);
+      for (std::size_t r=0; r<ratios.size(); ++r)
+        if (n_swaps_proposed[r] > 0)
+          ratios[r] = 1. * n_swaps_accepted[r] / n_swaps_proposed[r];
+      return ratios;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    ParallelTempering<OutputType,RandomNumberGenerator>::
+    tempered_log_likelihood (const double log_likelihood,
+                             const std::size_t replica) const
+    {
+      if ((log_likelihood == -std::numeric_limits<double>::max())
+          ||
+          (log_likelihood == -std::numeric_limits<double>::infinity()))
+        return log_likelihood;
+      else
+        return log_likelihood / parameters.temperatures[replica];
+    }
+  }
+}
@@ -16,10 +16,19 @@
 #ifndef SAMPLEFLOW_PRODUCERS_RANGE_H
 #define SAMPLEFLOW_PRODUCERS_RANGE_H
 
+#include <sampleflow/element_access.h>
 #include <sampleflow/producer.h>
 #include <sampleflow/scope_exit.h>
+#include <sampleflow/thread_pool.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
 #include <ranges>
+#include <utility>
+#include <vector>
 
 // Import the implementation of the things for this header file:
 #include <sampleflow/producers/range.impl.h>
@@ -69,6 +69,26 @@ namespace SampleFlow
      *   range_producer.sample (std::views::iota(1,7));
      * @endcode
      *
+     *
+     * ### Processing large ranges in parallel ###
+     *
+     * The sample() function walks through the range on the calling thread
+     * and sends its elements downstream one batch after the other. For
+     * large, random-access ranges -- for example a long chain that has been
+     * read into memory and is to be re-analyzed -- the sample_in_parallel()
+     * function instead splits the range into chunks of `max_batch_size`
+     * elements that are created and sent downstream by the worker threads of
+     * a ThreadPool. If the consumers connected to this object do not care
+     * about the order of samples (say, Consumers::MeanValue or
+     * Consumers::CovarianceMatrix), then the chunks are sent downstream
+     * concurrently from the worker threads, and the work done by the
+     * consumers is distributed across all threads. Otherwise, the chunks
+     * can be sent in the order in which they appear in the range; in that
+     * case, only the creation of the samples from the elements of the range
+     * happens in parallel, which pays off if that involves a non-trivial
+     * conversion, for example if the range is a `std::views::transform`
+     * view.
+     *
      * @tparam OutputType The type the samples sent downstream should have.
      *   This need not necessarily be the same type as the one of the objects
      *   provided to the sample() member function, but these objects must be
@@ -92,12 +112,66 @@ namespace SampleFlow
          * a range-based for loop. Furthermore, the values produced in
          * the loop (i.e., the `sample` objects above) need to be convertible
          * to `OutputType`.
+         *
+         * Rather than sending samples downstream one at a time, this function
+         * collects up to `max_batch_size` samples and sends them as one
+         * batch (see Producer::issue_batch).
          */
         template <typename RangeType>
         requires (std::ranges::input_range<RangeType> &&
                   std::convertible_to<std::ranges::range_value_t<RangeType>,OutputType>)
         void
         sample (const RangeType &range);
+
+        /**
+         * Like sample(), but split the range into chunks of `max_batch_size`
+         * elements each and create the samples of these chunks on the
+         * threads of the given thread pool, as discussed in the
+         * documentation of this class. Each chunk is sent downstream as one
+         * batch.
+         *
+         * @param[in] range The range of elements to be sent downstream. Since
+         *   chunks are accessed independently, it needs to be a sized,
+         *   random-access range.
+         * @param[in] preserve_order If `false` (the default), then batches
+         *   are sent downstream from the threads of the pool as soon as
+         *   they have been created, i.e., in no particular order and
+         *   concurrently. Consumers connected to this object then need to be
+         *   ones that do not depend on the order of samples. If `true`, then
+         *   batches are sent downstream one after the other, from the calling
+         *   thread, and in the order in which they appear in the range; the
+         *   samples of the next chunks are created while the current ones
+         *   are processed downstream. (See
+         *   Producer::issue_batches_in_parallel().)
+         * @param[in] thread_pool The pool on which the chunks are processed.
+         *   By default, this is the pool returned by
+         *   ThreadPool::default_pool().
+         */
+        template <typename RangeType>
+        requires (std::ranges::random_access_range<const RangeType> &&
+                  std::ranges::sized_range<const RangeType> &&
+                  std::convertible_to<std::ranges::range_value_t<RangeType>,OutputType>)
+        void
+        sample_in_parallel (const RangeType &range,
+                            const bool preserve_order = false,
+                            const std::shared_ptr<ThreadPool> &thread_pool = ThreadPool::default_pool());
+
+        /**
+         * The maximal number of samples sent downstream as one batch.
+         */
+        static constexpr std::size_t max_batch_size = 1024;
+
+      private:
+        /**
+         * Announce the samples of the given range to the objects connected
+         * to the current one (see Producer::announce_samples()): their
+         * number if the range is sized, and the number of components of
+         * the first element if the range can be iterated over more than
+         * once.
+         */
+        template <typename RangeType>
+        void
+        announce_range (const RangeType &range);
     };
 
 
@@ -114,12 +188,104 @@ namespace SampleFlow
       Utilities::ScopeExit scope_exit ([this]()
       {
         this->flush_consumers();
+        this->clear_stop_request();
       });
 
-      // Loop over all elements of the given range and issue a sample for
-      // each of them.
+      announce_range (range);
+
+      // Loop over all elements of the given range and collect them into
+      // batches that we send off whenever they are full. The samples
+      // produced by this class have no auxiliary data, so we can just
+      // reuse the same vector of (empty) AuxiliaryData objects for all
+      // batches.
+      std::vector<OutputType> batch;
+      batch.reserve (max_batch_size);
+      const std::vector<AuxiliaryData> aux_data (max_batch_size);
+
       for (auto sample : range)
-        this->issue_sample (sample, {});
+        {
+          batch.emplace_back (sample);
+          if (batch.size() == max_batch_size)
+            {
+              this->issue_batch (batch, aux_data);
+              batch.clear ();
+
+              if (this->stop_requested())
+                return;
+            }
+        }
+
+      // Send whatever is left over:
+      if (batch.size() > 0)
+        {
+          const std::vector<AuxiliaryData> remaining_aux_data (batch.size());
+          this->issue_batch (batch, remaining_aux_data);
+        }
+    }
+
+
+
+    template <typename OutputType>
+    template <typename RangeType>
+    requires (std::ranges::random_access_range<const RangeType> &&
+              std::ranges::sized_range<const RangeType> &&
+              std::convertible_to<std::ranges::range_value_t<RangeType>,OutputType>)
+    void
+    Range<OutputType>::
+    sample_in_parallel (const RangeType &range,
+                        const bool preserve_order,
+                        const std::shared_ptr<ThreadPool> &thread_pool)
+    {
+      assert (thread_pool != nullptr);
+
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      announce_range (range);
+
+      // Split the range into chunks of max_batch_size elements, and
+      // let the base class create and send these off on the thread pool:
+      const std::size_t n_elements = std::ranges::size(range);
+      const std::size_t n_chunks   = (n_elements + max_batch_size - 1) / max_batch_size;
+
+      const auto first = std::ranges::begin(range);
+      this->issue_batches_in_parallel (n_chunks,
+                                       [&](const std::size_t chunk)
+      {
+        const std::size_t begin = chunk * max_batch_size;
+        const std::size_t end   = std::min (begin + max_batch_size, n_elements);
+
+        std::vector<OutputType> samples;
+        samples.reserve (end - begin);
+        for (std::size_t i=begin; i<end; ++i)
+          samples.emplace_back (first[static_cast<std::ranges::range_difference_t<const RangeType>>(i)]);
+
+        return std::make_pair (std::move(samples),
+                               std::vector<AuxiliaryData>(end - begin));
+      },
+      preserve_order,
+      *thread_pool);
+    }
+
+
+
+    template <typename OutputType>
+    template <typename RangeType>
+    void
+    Range<OutputType>::
+    announce_range (const RangeType &range)
+    {
+      SampleShape shape;
+      if constexpr (std::ranges::sized_range<const RangeType>)
+        shape.n_samples = std::ranges::size(range);
+      if constexpr (std::ranges::forward_range<const RangeType>)
+        if (std::ranges::begin(range) != std::ranges::end(range))
+          shape.n_components = Utilities::size (OutputType(*std::ranges::begin(range)));
+
+      this->announce_samples (shape);
     }
 
   }
@@ -0,0 +1,660 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of a sequential Monte Carlo ("SMC") sampler with
+     * likelihood tempering, see @cite DelMoralDoucetJasra2006. Rather than
+     * running a Markov chain, the algorithm moves a population of
+     * "particles" $x_1,\ldots,x_N$ drawn from the prior distribution
+     * $\pi_0(x)$ through a sequence of distributions
+     * @f{align*}{
+     *   \pi_\beta(x) \propto \pi_0(x) L(x)^\beta,
+     *   \qquad 0=\beta_0<\beta_1<\ldots<\beta_K=1,
+     * @f}
+     * that ends at the posterior distribution $\pi_1(x)\propto\pi_0(x)L(x)$.
+     * Each stage consists of three steps:
+     * - Reweighting: Each particle's weight is multiplied by
+     *   $L(x_i)^{\beta_{k+1}-\beta_k}$. This requires no new evaluations of
+     *   the likelihood, since the likelihoods of all particles are known.
+     * - Resampling: If the effective sample size
+     *   $N_\text{eff}=\frac{(\sum_i w_i)^2}{\sum_i w_i^2}$ of the weighted
+     *   population has dropped below a fraction
+     *   Parameters::resampling_threshold of $N$, then $N$ new particles
+     *   are drawn from the weighted population using systematic
+     *   resampling, and all weights are reset to one.
+     * - Rejuvenation: Each particle takes Parameters::n_rejuvenation_steps
+     *   Metropolis-Hastings steps that leave $\pi_{\beta_{k+1}}$
+     *   invariant, using the given proposal function and the acceptance
+     *   criterion of MetropolisHastings::accept_trial_sample(). This moves
+     *   apart the copies of particles that resampling has created.
+     *
+     * A by-product of the algorithm is an estimate of the "model evidence"
+     * $Z=\int \pi_0(x) L(x) \; dx$ (assuming that both the prior and the
+     * likelihood are normalized), which is the product of the average
+     * incremental weights of all stages; it is returned by
+     * get_log_evidence(). The sequence of $\beta_k$ is either given as
+     * Parameters::temperatures, or chosen adaptively so that each
+     * reweighting step reduces the "conditional effective sample size" of
+     * @cite ZhouJohansenAston2016 to the fraction
+     * Parameters::target_relative_ess of $N$; in the latter case, the
+     * sequence chosen is returned by get_temperatures().
+     *
+     * Except for resampling, the particles are processed independently of
+     * each other, and this is where the parallelism of the class comes
+     * from: The particles, their log priors and log likelihoods, and their
+     * trial samples are stored in contiguous arrays. Proposing trial
+     * samples, evaluating their prior, and deciding whether to accept them
+     * is done for contiguous chunks of particles as tasks on a
+     * ThreadPool, and the likelihoods of the trial samples of all particles
+     * are evaluated at once -- either as tasks on the same pool, or by a
+     * function object that evaluates a whole batch of samples (see
+     * types::BatchLogLikelihood). Systematic resampling computes the
+     * cumulative sums of the weights, and then determines the parent of
+     * each new particle (and copies it) independently of all other new
+     * particles, again in chunks on the thread pool.
+     *
+     * Each particle has its own random number generator, namely the
+     * stream with the number of the particle that Random::create_stream()
+     * creates from Parameters::random_seed; resampling uses the stream
+     * whose number equals the number of particles. (Generators belong to
+     * the positions in the array of particles, not to the particles
+     * themselves, and so do not move with them when resampling.) The
+     * result is therefore reproducible, and does not depend on the number
+     * of threads of the pool.
+     *
+     * Once the population has reached $\beta=1$, the particles are sent
+     * downstream via the Producer::issue_batch signal as one batch,
+     * ordered by particle. The AuxiliaryData object of each particle
+     * carries its weight (normalized so that the weights average to one)
+     * under the key AuxiliaryData::sample_weight, which consumers such as
+     * Consumers::MeanValue, Consumers::CovarianceMatrix, and
+     * Consumers::Histogram take into account; its value of
+     * $\log(\pi_0(x)L(x))$ under the key
+     * AuxiliaryData::relative_log_likelihood; and the number of the
+     * particle under the key AuxiliaryData::chain_number. If
+     * Producer::request_stop() is called before the population reaches
+     * $\beta=1$, then no samples are sent downstream at all, since the
+     * population does not yet represent the posterior distribution.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number
+     *   generators used by the particles and for resampling. See the
+     *   documentation of the MetropolisHastings class for more
+     *   information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class SequentialMonteCarlo : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed from which the random number generators of the
+           * particles and of the resampling step are created.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The sequence of exponents $\beta_1<\beta_2<\ldots<\beta_K=1$
+           * through which the particles are moved. All values must be in
+           * $(0,1]$, and the last one must equal one. If this is empty (the
+           * default), then the exponents are chosen adaptively as
+           * described in the documentation of this class.
+           */
+          std::vector<double> temperatures;
+
+          /**
+           * If the exponents $\beta_k$ are chosen adaptively, the fraction
+           * of the number of particles to which each reweighting step
+           * reduces the conditional effective sample size. Smaller values
+           * lead to fewer, larger steps.
+           */
+          double target_relative_ess = 0.5;
+
+          /**
+           * The fraction of the number of particles below which the
+           * effective sample size needs to drop for the population to be
+           * resampled. A value of one resamples after every reweighting
+           * step, a value of zero never.
+           */
+          double resampling_threshold = 0.5;
+
+          /**
+           * The number of Metropolis-Hastings steps each particle takes
+           * after each reweighting step.
+           */
+          unsigned int n_rejuvenation_steps = 5;
+
+          /**
+           * The pool on which the work on the particles is done. If this is
+           * `nullptr` (the default), then the pool returned by
+           * ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        SequentialMonteCarlo (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * particles, move them through the sequence of tempered
+         * distributions described in the documentation of this class and
+         * send the final, weighted population downstream.
+         *
+         * @param[in] initial_particles The particles at $\beta=0$, which
+         *   need to be independent samples of the prior distribution. The
+         *   number of particles $N$ equals the number of samples that are
+         *   sent downstream.
+         * @param[in] log_prior A function object that, when called with a
+         *   sample $x$, returns $\log(\pi_0(x))$. The function is called
+         *   concurrently on the threads of Parameters::thread_pool, and so
+         *   needs to be reentrant.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(L(x))$. Like `log_prior`, it
+         *   is called concurrently on the threads of the pool. As for the
+         *   MetropolisHastings class, values of
+         *   `-std::numeric_limits<double>::max()` or minus infinity returned
+         *   by either function indicate that the sample has zero
+         *   probability.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample along with the ratio of proposal probabilities, as for
+         *   the MetropolisHastings::sample_chains() function. It is called
+         *   concurrently for different particles, each with the generator
+         *   of the particle, from which it should draw all of its random
+         *   numbers.
+         */
+        void
+        sample (const std::vector<OutputType> &initial_particles,
+                const std::function<double (const OutputType &)> &log_prior,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample);
+
+        /**
+         * Like the previous function, but using a function object that
+         * evaluates the log likelihood for a whole batch of samples at once,
+         * namely all initial particles and then the trial samples of all
+         * particles in each rejuvenation step. Whether and how the
+         * evaluation of a batch is parallelized is up to the function
+         * object.
+         *
+         * For the same arguments and random seed, this function produces
+         * the same samples as the previous function.
+         */
+        void
+        sample (const std::vector<OutputType> &initial_particles,
+                const std::function<double (const OutputType &)> &log_prior,
+                const types::BatchLogLikelihood<OutputType> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample);
+
+        /**
+         * Return the estimate of the logarithm of the model evidence
+         * $Z=\int \pi_0(x) L(x) \; dx$ computed by the last call to
+         * sample().
+         */
+        double
+        get_log_evidence () const;
+
+        /**
+         * Return the sequence of exponents $0=\beta_0<\beta_1<\ldots$
+         * through which the last call to sample() has moved the particles.
+         */
+        const std::vector<double> &
+        get_temperatures () const;
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The estimate of the log evidence and the exponents used by the
+         * last call to sample().
+         */
+        double              log_evidence;
+        std::vector<double> temperatures;
+
+        /**
+         * Return the thread pool to be used, i.e., either
+         * Parameters::thread_pool or the default pool.
+         */
+        std::shared_ptr<ThreadPool>
+        get_thread_pool () const;
+
+        /**
+         * Given the (unnormalized) log weights and the log likelihoods of
+         * the particles, return the next exponent after `beta` as
+         * described in the documentation of Parameters::target_relative_ess.
+         */
+        double
+        next_temperature (const double beta,
+                          const std::vector<double> &log_weights,
+                          const std::vector<double> &log_likelihoods) const;
+
+        /**
+         * Return $\log\sum_i \exp(a_i)$ for the given numbers $a_i$,
+         * computed in a way that avoids overflow and underflow.
+         */
+        static
+        double
+        log_sum_exp (const std::vector<double> &a);
+
+        /**
+         * Return $\log(\pi_0(x)L(x)^\beta)$ given $\log(\pi_0(x))$ and
+         * $\log(L(x))$, or minus infinity if either the prior or (for
+         * $\beta>0$) the likelihood indicates that $x$ has zero probability.
+         */
+        static
+        double
+        tempered_log_density (const double log_prior,
+                              const double log_likelihood,
+                              const double beta);
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    SequentialMonteCarlo (const Parameters &parameters)
+      : parameters (parameters),
+        log_evidence (std::numeric_limits<double>::quiet_NaN())
+    {
+      assert ((parameters.target_relative_ess > 0) && (parameters.target_relative_ess < 1));
+      assert ((parameters.resampling_threshold >= 0) && (parameters.resampling_threshold <= 1));
+      assert (parameters.temperatures.empty() || (parameters.temperatures.back() == 1.));
+      assert (std::is_sorted (parameters.temperatures.begin(), parameters.temperatures.end()));
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &initial_particles,
+            const std::function<double (const OutputType &)> &log_prior,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample)
+    {
+      // Wrap the function into one that evaluates a whole batch of
+      // samples in chunks on the thread pool:
+      const auto batch_log_likelihood
+        = [this, &log_likelihood](std::span<const OutputType> samples,
+                                  std::span<double> log_likelihoods)
+      {
+        assert (samples.size() == log_likelihoods.size());
+
+        get_thread_pool()->for_each_chunk (samples.size(),
+                                           [&](const std::size_t begin, const std::size_t end)
+        {
+          for (std::size_t i=begin; i<end; ++i)
+            log_likelihoods[i] = log_likelihood (samples[i]);
+        });
+      };
+
+      sample (initial_particles,
+              log_prior,
+              batch_log_likelihood,
+              propose_sample);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &initial_particles,
+            const std::function<double (const OutputType &)> &log_prior,
+            const types::BatchLogLikelihood<OutputType> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample)
+    {
+      const std::size_t n_particles = initial_particles.size();
+      assert (n_particles > 0);
+
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      // Store the particles and everything we know about them in
+      // contiguous arrays. The same is true for the trial samples of the
+      // rejuvenation steps and the arrays used for resampling. All of
+      // these arrays are allocated once and re-used in all stages.
+      std::vector<OutputType> particles = initial_particles;
+      std::vector<double>     log_priors (n_particles);
+      std::vector<double>     log_likelihoods (n_particles);
+      std::vector<double>     log_weights (n_particles, 0.);
+
+      get_thread_pool()->for_each_chunk (n_particles,
+                                         [&](const std::size_t begin, const std::size_t end)
+      {
+        for (std::size_t i=begin; i<end; ++i)
+          log_priors[i] = log_prior (particles[i]);
+      });
+      log_likelihood (particles, log_likelihoods);
+
+      std::vector<OutputType> trial_samples (n_particles, initial_particles[0]);
+      std::vector<double>     trial_log_priors (n_particles);
+      std::vector<double>     trial_log_likelihoods (n_particles);
+      std::vector<double>     proposal_distribution_ratios (n_particles);
+
+      std::vector<double>     new_log_weights (n_particles);
+      std::vector<double>     cumulative_weights (n_particles);
+
+      std::vector<RandomNumberGenerator> particle_rngs;
+      particle_rngs.reserve (n_particles);
+      for (std::size_t i=0; i<n_particles; ++i)
+        particle_rngs.emplace_back (Random::create_stream<RandomNumberGenerator> (parameters.random_seed, i));
+      RandomNumberGenerator resampling_rng
+        = Random::create_stream<RandomNumberGenerator> (parameters.random_seed, n_particles);
+
+      temperatures.assign (1, 0.);
+      log_evidence = 0;
+
+      double beta = 0;
+      while ((beta < 1) && (this->stop_requested() == false))
+        {
+          const double next_beta
+            = (parameters.temperatures.empty() ?
+               next_temperature (beta, log_weights, log_likelihoods) :
+               parameters.temperatures[temperatures.size()-1]);
+          assert (next_beta > beta);
+
+          // Reweight the particles. The ratio of the sums of the new and
+          // the old weights is the factor by which the evidence changes.
+          for (std::size_t i=0; i<n_particles; ++i)
+            new_log_weights[i]
+              = log_weights[i]
+                + (internal::has_zero_probability (log_likelihoods[i]) ?
+                   -std::numeric_limits<double>::infinity() :
+                   (next_beta - beta) * log_likelihoods[i]);
+
+          const double log_sum_of_new_weights = log_sum_exp (new_log_weights);
+          assert (log_sum_of_new_weights > -std::numeric_limits<double>::infinity());
+          log_evidence += log_sum_of_new_weights - log_sum_exp (log_weights);
+
+          std::swap (log_weights, new_log_weights);
+          beta = next_beta;
+          temperatures.push_back (beta);
+
+          // Compute the normalized weights, stored in their cumulative
+          // form, and from them the effective sample size. If it is too
+          // small, resample the population using systematic resampling:
+          // Draw one uniform number u in [0,1/N), and choose as parent of
+          // the ith new particle the particle into whose interval of the
+          // cumulative weights the point u+i/N falls. Since the parents of
+          // all new particles can be found independently of each other by
+          // bisection, this can be done in parallel.
+          double sum_of_squares = 0;
+          double cumulative_weight = 0;
+          for (std::size_t i=0; i<n_particles; ++i)
+            {
+              const double w = std::exp (log_weights[i] - log_sum_of_new_weights);
+              cumulative_weight += w;
+              sum_of_squares += w*w;
+              cumulative_weights[i] = cumulative_weight;
+            }
+
+          if (1. / sum_of_squares < parameters.resampling_threshold * n_particles)
+            {
+              const double u = std::uniform_real_distribution<>(0,1)(resampling_rng) / n_particles;
+
+              get_thread_pool()->for_each_chunk (n_particles,
+                                                 [&](const std::size_t begin, const std::size_t end)
+              {
+                for (std::size_t i=begin; i<end; ++i)
+                  {
+                    const std::size_t parent
+                      = std::min<std::size_t> (std::upper_bound (cumulative_weights.begin(),
+                                                                 cumulative_weights.end(),
+                                                                 u + 1. * i / n_particles)
+                                               - cumulative_weights.begin(),
+                                               n_particles-1);
+                    trial_samples[i]         = particles[parent];
+                    trial_log_priors[i]      = log_priors[parent];
+                    trial_log_likelihoods[i] = log_likelihoods[parent];
+                  }
+              });
+
+              std::swap (particles, trial_samples);
+              std::swap (log_priors, trial_log_priors);
+              std::swap (log_likelihoods, trial_log_likelihoods);
+              std::fill (log_weights.begin(), log_weights.end(), 0.);
+            }
+
+          // Finally rejuvenate the particles by letting each take a few
+          // Metropolis-Hastings steps for the distribution with the
+          // current exponent. The likelihoods of all trial samples are
+          // evaluated as one batch.
+          for (unsigned int step=0; step<parameters.n_rejuvenation_steps; ++step)
+            {
+              get_thread_pool()->for_each_chunk (n_particles,
+                                                 [&](const std::size_t begin, const std::size_t end)
+              {
+                for (std::size_t i=begin; i<end; ++i)
+                  {
+                    std::tie (trial_samples[i], proposal_distribution_ratios[i])
+                      = propose_sample (particles[i], particle_rngs[i]);
+                    trial_log_priors[i] = log_prior (trial_samples[i]);
+                  }
+              });
+
+              log_likelihood (trial_samples, trial_log_likelihoods);
+
+              get_thread_pool()->for_each_chunk (n_particles,
+                                                 [&](const std::size_t begin, const std::size_t end)
+              {
+                for (std::size_t i=begin; i<end; ++i)
+                  if (MetropolisHastings<OutputType,RandomNumberGenerator>::
+                      accept_trial_sample (tempered_log_density (trial_log_priors[i],
+                                                                 trial_log_likelihoods[i],
+                                                                 beta),
+                                           tempered_log_density (log_priors[i],
+                                                                 log_likelihoods[i],
+                                                                 beta),
+                                           proposal_distribution_ratios[i],
+                                           particle_rngs[i]))
+                    {
+                      std::swap (particles[i], trial_samples[i]);
+                      log_priors[i]      = trial_log_priors[i];
+                      log_likelihoods[i] = trial_log_likelihoods[i];
+                    }
+              });
+            }
+        }
+
+      // If we have arrived at the posterior distribution, send the
+      // weighted population downstream:
+      if (beta == 1)
+        {
+          const double log_sum_of_weights = log_sum_exp (log_weights);
+
+          std::vector<AuxiliaryData> aux_data;
+          aux_data.reserve (n_particles);
+          for (std::size_t i=0; i<n_particles; ++i)
+            aux_data.emplace_back (AuxiliaryData
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(tempered_log_density (log_priors[i], log_likelihoods[i], 1.))},
+            {AuxiliaryData::sample_weight, std::any(n_particles * std::exp (log_weights[i] - log_sum_of_weights))},
+            {AuxiliaryData::chain_number, std::any(i)}
+          });
+
+          this->issue_batch (particles, aux_data);
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    get_log_evidence () const
+    {
+      return log_evidence;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    const std::vector<double> &
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    get_temperatures () const
+    {
+      return temperatures;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::shared_ptr<ThreadPool>
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    get_thread_pool () const
+    {
+      return (parameters.thread_pool != nullptr ?
+              parameters.thread_pool :
+              ThreadPool::default_pool());
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    next_temperature (const double beta,
+                      const std::vector<double> &log_weights,
+                      const std::vector<double> &log_likelihoods) const
+    {
+      const std::size_t n_particles = log_weights.size();
+
+      // Compute the normalized weights W_i:
+      const double log_sum_of_weights = log_sum_exp (log_weights);
+      std::vector<double> normalized_weights (n_particles);
+      for (std::size_t i=0; i<n_particles; ++i)
+        normalized_weights[i] = std::exp (log_weights[i] - log_sum_of_weights);
+
+      // The relative conditional effective sample size for an increment
+      // delta of the exponent, with incremental weights u_i = L(x_i)^delta,
+      // is (sum_i W_i u_i)^2 / (sum_i W_i u_i^2). Particles with zero
+      // likelihood lose their weight for any positive delta; we leave them
+      // out of the sums (and re-normalize the weights of the others) so
+      // that the ratio equals one for delta=0 and decreases monotonically
+      // with delta. We also scale the u_i by their maximum to avoid
+      // overflow; this does not change the ratio.
+      double sum_of_nonzero_weights = 0;
+      for (std::size_t i=0; i<n_particles; ++i)
+        if (internal::has_zero_probability (log_likelihoods[i]))
+          normalized_weights[i] = 0;
+        else
+          sum_of_nonzero_weights += normalized_weights[i];
+      assert (sum_of_nonzero_weights > 0);
+      for (double &w : normalized_weights)
+        w /= sum_of_nonzero_weights;
+
+      const auto relative_ess = [&](const double delta)
+      {
+        double max_log_u = -std::numeric_limits<double>::infinity();
+        for (std::size_t i=0; i<n_particles; ++i)
+          if (normalized_weights[i] > 0)
+            max_log_u = std::max (max_log_u, delta * log_likelihoods[i]);
+
+        double sum = 0, sum_of_squares = 0;
+        for (std::size_t i=0; i<n_particles; ++i)
+          if (normalized_weights[i] > 0)
+            {
+              const double u = std::exp (delta * log_likelihoods[i] - max_log_u);
+              sum += normalized_weights[i] * u;
+              sum_of_squares += normalized_weights[i] * u * u;
+            }
+        return sum * sum / sum_of_squares;
+      };
+
+      // If we can go all the way to one, do so. Otherwise find the
+      // increment for which the conditional ESS equals the target by
+      // bisection:
+      if (relative_ess (1-beta) >= parameters.target_relative_ess)
+        return 1;
+
+      double lower = 0, upper = 1-beta;
+      for (unsigned int iteration=0; iteration<60; ++iteration)
+        {
+          const double middle = (lower + upper) / 2;
+          if (relative_ess (middle) >= parameters.target_relative_ess)
+            lower = middle;
+          else
+            upper = middle;
+        }
+
+      return beta + (lower > 0 ? lower : upper);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    log_sum_exp (const std::vector<double> &a)
+    {
+      const double max_a = *std::max_element (a.begin(), a.end());
+      if (max_a == -std::numeric_limits<double>::infinity())
+        return max_a;
+
+      double sum = 0;
+      for (const double x : a)
+        sum += std::exp (x - max_a);
+      return max_a + std::log (sum);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    SequentialMonteCarlo<OutputType,RandomNumberGenerator>::
+    tempered_log_density (const double log_prior,
+                          const double log_likelihood,
+                          const double beta)
+    {
+      if (internal::has_zero_probability (log_prior) ||
+          ((beta > 0) && internal::has_zero_probability (log_likelihood)))
+        return -std::numeric_limits<double>::infinity();
+      else
+        return log_prior + beta * log_likelihood;
+    }
+  }
+}
@@ -0,0 +1,142 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A producer that receives samples from a Consumers::SharedMemoryOutput
+     * object in another process (or in the same process), and sends them
+     * downstream. See the documentation of Consumers::SharedMemoryOutput
+     * for an example.
+     *
+     * @tparam OutputType The type of the samples this producer creates. It
+     *   needs to have the same scalar type as the samples sent by the
+     *   other side, but need not be the same type: For example, the
+     *   sending process may use `std::vector<double>` and the receiving
+     *   one `Eigen::VectorXd`.
+     */
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    class SharedMemoryInput : public Producer<OutputType>
+    {
+      public:
+        /**
+         * Constructor. Connect to the shared memory object with the given
+         * name, which needs to have been created by a
+         * Consumers::SharedMemoryOutput object that still exists.
+         */
+        SharedMemoryInput (const std::string &name);
+
+        /**
+         * Return the header that describes the samples received, and the
+         * auxiliary data that comes with them.
+         */
+        const ChainFileFormat::Header &
+        header () const;
+
+        /**
+         * Receive samples and send them downstream until the sending side
+         * has been destroyed and all samples it sent have been received, or
+         * until a downstream object requests that sampling stop. Samples
+         * that are available right away are sent downstream together, in
+         * batches of up to `max_batch_size` samples.
+         */
+        void
+        sample ();
+
+        /**
+         * The maximal number of samples sent downstream as one batch.
+         */
+        static constexpr std::size_t max_batch_size = 1024;
+
+      private:
+        /**
+         * The queue from which samples are received.
+         */
+        SharedMemoryQueue queue;
+    };
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    SharedMemoryInput<OutputType>::
+    SharedMemoryInput (const std::string &name)
+      :
+      queue (name)
+    {}
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    const ChainFileFormat::Header &
+    SharedMemoryInput<OutputType>::
+    header () const
+    {
+      return queue.header();
+    }
+
+
+
+    template <typename OutputType>
+    requires (std::is_arithmetic_v<types::ScalarType<OutputType>>)
+    void
+    SharedMemoryInput<OutputType>::
+    sample ()
+    {
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      std::vector<char>          record (queue.header().record_size());
+      std::vector<OutputType>    samples;
+      std::vector<AuxiliaryData> aux_data;
+      while (true)
+        {
+          // Check whether the sending side has finished *before* looking
+          // for samples: If it has, then everything it sent is in the queue
+          // already, and we are done once we find the queue empty.
+          const bool sender_is_done = queue.is_closed();
+
+          samples.clear();
+          aux_data.clear();
+          while ((samples.size() < max_batch_size) && queue.try_read (record.data()))
+            {
+              samples.emplace_back ();
+              aux_data.emplace_back ();
+              ChainFileFormat::read_record (record.data(), queue.header(),
+                                            samples.back(), aux_data.back());
+            }
+
+          if (samples.size() > 0)
+            {
+              this->issue_batch (samples, aux_data);
+              if (this->stop_requested())
+                return;
+            }
+          else if (sender_is_done)
+            return;
+          else
+            std::this_thread::sleep_for (std::chrono::microseconds(50));
+        }
+    }
+  }
+}
@@ -0,0 +1,437 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A variant of the Metropolis-Hastings sampler (see the
+     * MetropolisHastings class) that runs a single chain, but uses idle
+     * processor cores by evaluating the likelihood of future trial samples
+     * speculatively, before it is known whether the chain will get there.
+     *
+     * A Metropolis-Hastings chain is inherently sequential: Which trial
+     * sample is proposed in step $k+1$ depends on whether the trial sample
+     * of step $k$ was accepted, and that is only known once its likelihood
+     * has been evaluated. If evaluating the likelihood is expensive, one
+     * can nonetheless make progress on the following steps before this
+     * decision is made: Starting from the current sample, this class
+     * proposes the trial sample for the next step and starts evaluating
+     * its likelihood; it then proposes trial samples for the step after
+     * that for *both* possible outcomes -- the case where the first
+     * trial sample is accepted, and the case where it is rejected -- and
+     * starts evaluating their likelihoods as well; and so on for a given
+     * number of steps (the "speculation depth"). This creates a binary
+     * tree of trial samples whose likelihoods are evaluated in parallel on
+     * the threads of a ThreadPool. Once the likelihood of the first trial
+     * sample is known, the acceptance decision for it is made, the
+     * resulting sample is sent to the consumers, and the half of the tree
+     * that corresponds to the outcome that did not happen is discarded.
+     * The tree is then extended by one more level, and the process repeats.
+     *
+     * With a speculation depth $D$, the tree has $2^{D+1}-1$ nodes, of which
+     * only $D+1$ lie on the path the chain will actually take. The
+     * remaining evaluations are wasted work, but they use processor cores
+     * that would otherwise be idle. If the likelihood evaluation
+     * dominates the cost of each step, a depth $D$ can use up to
+     * $2^{D+1}-1$ cores, and reduce the time per step by up to a factor of
+     * $D+1$ (more if the acceptance ratio is very high or very low, since
+     * then one of the two halves of the tree is much more likely than the
+     * other, though this class does not exploit this).
+     *
+     *
+     * <h3>Reproducibility</h3>
+     *
+     * The sequence of samples produced by this class does not depend on
+     * the speculation depth, on the number of threads of the pool, or on
+     * the order in which the likelihood evaluations finish: It is the same
+     * sequence that is produced with a speculation depth of zero, i.e.,
+     * if the class runs the plain, serial Metropolis-Hastings algorithm.
+     *
+     * To make this possible, this class needs to control the random
+     * numbers that go into each step. The MetropolisHastings class leaves
+     * drawing the trial sample to a user-provided function that typically
+     * uses its own random number generator, and the number of random numbers
+     * it draws for the acceptance decision depends on the outcome of
+     * previous steps; neither is compatible with proposing trial samples
+     * for several possible futures of the chain. Instead, this class uses
+     * a separate random number generator for each step $k$, namely the
+     * stream with number $k$ that Random::create_stream() creates from
+     * Parameters::random_seed, and passes it to the function that
+     * proposes trial samples; each node of the tree for step $k$ uses its
+     * own copy of that generator. The acceptance decisions use exactly one
+     * uniformly distributed random number per step, drawn from yet another
+     * generator. As a consequence, the samples produced by this class are
+     * generally different from the ones the MetropolisHastings class
+     * produces with the same seed, though of course both follow the
+     * same probability distribution.
+     *
+     * The AuxiliaryData object sent along with each sample stores the same
+     * entries as are described for the MetropolisHastings class.
+     *
+     * Since a generator has to be created for every step, this class
+     * benefits in particular from using one of the generators in namespace
+     * Random, such as Random::Philox4x32, as second template argument:
+     * These are much cheaper to create than the default `std::mt19937`.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number generator.
+     *   See the documentation of the MetropolisHastings class for more
+     *   information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class SpeculativeMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generators used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The number of steps beyond the current one for which trial
+           * samples are proposed and evaluated speculatively. A value of
+           * zero means that no speculation happens: the likelihood of each
+           * trial sample is then evaluated on the thread that calls
+           * sample(), once it is known that the chain needs it.
+           */
+          unsigned int speculation_depth = 2;
+
+          /**
+           * The pool on which the likelihood evaluations are run. If this is
+           * `nullptr` (the default), then the pool returned by
+           * ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        SpeculativeMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * initial sample $x_0$, it produces a sequence of samples $x_k$
+         * that are passed through the signal of the base class to
+         * Consumer objects.
+         *
+         * @param[in] starting_point The initial sample $x_0$.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a sample $x$, returns $\log(\pi(x))$. Because this function
+         *   is called concurrently on the threads of the pool, it needs to
+         *   be reentrant. See MetropolisHastings::sample() for how samples
+         *   with zero probability are treated.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample $\tilde x$ and the ratio of proposal probabilities
+         *   $\frac{\pi_\text{proposal}(\tilde x|x)}
+         *         {\pi_\text{proposal}(x|\tilde x)}$, as described for
+         *   MetropolisHastings::sample(). For the sequence of samples to
+         *   be reproducible, this function must use only the random number
+         *   generator it is given (and not, for example, a `static` one),
+         *   and must not otherwise have any state that changes between
+         *   calls. The function is only ever called on the thread that
+         *   calls sample().
+         * @param[in] n_samples The number of (new) samples to be produced
+         *   by this function. This is also the number of times the
+         *   signal is called that notifies Consumer objects that a new
+         *   sample is available.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The number of steps the sampler has taken in previous calls to
+         * sample(), so that calling sample() several times continues with
+         * the random numbers where the previous call ended.
+         */
+        types::sample_index n_previous_steps;
+
+        /**
+         * The random number generator used for the acceptance decisions.
+         */
+        RandomNumberGenerator acceptance_rng;
+
+        /**
+         * A structure that describes one node of the tree of speculatively
+         * evaluated steps: The sample the chain is at if it reaches this
+         * node (along with its log likelihood), the trial sample proposed
+         * from there (along with the ratio of proposal probabilities and
+         * its log likelihood), and the two nodes that follow depending
+         * on whether the trial sample is accepted or rejected.
+         *
+         * Because the log likelihoods may not have been computed yet, they
+         * are stored as futures. They are `std::shared_future` objects
+         * since the log likelihood of a trial sample is also the log
+         * likelihood of the current sample of the child node that
+         * corresponds to accepting it.
+         */
+        struct Node
+        {
+          types::sample_index         step;
+          OutputType                  current_sample;
+          std::shared_future<double>  current_log_likelihood;
+
+          OutputType                  trial_sample;
+          double                      proposal_distribution_ratio;
+          std::shared_future<double>  trial_log_likelihood;
+
+          std::unique_ptr<Node>       accepted;
+          std::unique_ptr<Node>       rejected;
+        };
+
+        /**
+         * Make sure that the trial sample of the given node has been
+         * proposed and its evaluation started, and that the two nodes that
+         * follow it exist. Then recursively do the same for these nodes,
+         * down to the given depth below the current node.
+         */
+        void
+        expand (Node &node,
+                const unsigned int depth,
+                const std::function<double (const OutputType &)> &log_likelihood,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                ThreadPool &thread_pool,
+                ThreadPool::TaskGroup &evaluations);
+
+        /**
+         * Return the random number generator proposals for the given step
+         * should use.
+         */
+        RandomNumberGenerator
+        create_step_rng (const types::sample_index step) const;
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    SpeculativeMetropolisHastings<OutputType,RandomNumberGenerator>::
+    SpeculativeMetropolisHastings (const Parameters &parameters)
+      :
+      parameters (parameters),
+      n_previous_steps (0)
+    {
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        acceptance_rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    SpeculativeMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      ThreadPool &thread_pool = (parameters.thread_pool != nullptr ?
+                                 *parameters.thread_pool :
+                                 *ThreadPool::default_pool());
+
+      // The speculative evaluations reference the log_likelihood
+      // function object. Before we leave this function, we therefore
+      // have to wait for all of them to finish, including those whose
+      // results we no longer need. This is what the destructor of the
+      // following object does, also if we leave the function via an
+      // exception.
+      ThreadPool::TaskGroup evaluations;
+
+      std::uniform_real_distribution<> uniform_distribution(0,1);
+
+      std::unique_ptr<Node> root = std::make_unique<Node>();
+      root->step           = n_previous_steps;
+      root->current_sample = starting_point;
+      {
+        std::promise<double> current_log_likelihood;
+        current_log_likelihood.set_value (log_likelihood (starting_point));
+        root->current_log_likelihood = current_log_likelihood.get_future().share();
+      }
+
+      types::sample_index n_steps = 0;
+      for (; (n_steps<n_samples) && (this->stop_requested() == false); ++n_steps)
+        {
+          // Make sure the tree below the current node is populated to
+          // the desired depth, and that all evaluations have been
+          // started:
+          expand (*root, parameters.speculation_depth,
+                  log_likelihood, propose_sample,
+                  thread_pool, evaluations);
+
+          // Then wait for the trial sample of the current step to be
+          // evaluated. Rather than just sitting idle, help with the
+          // pending evaluations in the meantime.
+          while (root->trial_log_likelihood.wait_for(std::chrono::seconds(0))
+                 != std::future_status::ready)
+            if (thread_pool.run_pending_task() == false)
+              root->trial_log_likelihood.wait();
+
+          const double current_log_likelihood = root->current_log_likelihood.get();
+          const double trial_log_likelihood   = root->trial_log_likelihood.get();
+          const double proposal_distribution_ratio = root->proposal_distribution_ratio;
+
+          // Decide whether we accept the trial sample. This is the same
+          // test as in the MetropolisHastings class, except that we always
+          // draw exactly one random number.
+          const double uniform_random_number = uniform_distribution(acceptance_rng);
+
+          const bool trial_sample_has_zero_probability
+            = ((trial_log_likelihood == -std::numeric_limits<double>::max())
+               ||
+               (trial_log_likelihood == -std::numeric_limits<double>::infinity()));
+          const bool current_sample_has_zero_probability
+            = ((current_log_likelihood == -std::numeric_limits<double>::max())
+               ||
+               (current_log_likelihood == -std::numeric_limits<double>::infinity()));
+
+          bool accepted_sample;
+          if (trial_sample_has_zero_probability && !current_sample_has_zero_probability)
+            accepted_sample = false;
+          else if (trial_sample_has_zero_probability && current_sample_has_zero_probability)
+            accepted_sample = (1. / proposal_distribution_ratio >= uniform_random_number);
+          else
+            accepted_sample = (std::exp(trial_log_likelihood - current_log_likelihood)
+                               / proposal_distribution_ratio
+                               >= uniform_random_number);
+
+          // Move to the node that corresponds to the decision just made,
+          // which discards the other half of the tree:
+          root = std::move(accepted_sample ? root->accepted : root->rejected);
+
+          // Output the new sample (which may be equal to the old sample).
+          this->issue_sample (root->current_sample,
+          {
+            {AuxiliaryData::relative_log_likelihood, std::any(root->current_log_likelihood.get())},
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted_sample)}
+          });
+        }
+
+      n_previous_steps += n_steps;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    SpeculativeMetropolisHastings<OutputType,RandomNumberGenerator>::
+    expand (Node &node,
+            const unsigned int depth,
+            const std::function<double (const OutputType &)> &log_likelihood,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            ThreadPool &thread_pool,
+            ThreadPool::TaskGroup &evaluations)
+    {
+      // If we have not done so yet, propose a trial sample for this node
+      // and start evaluating its likelihood. If we do not speculate at all,
+      // there is no point in moving the evaluation to another thread.
+      if (node.trial_log_likelihood.valid() == false)
+        {
+          RandomNumberGenerator step_rng = create_step_rng (node.step);
+          std::pair<OutputType,double> trial_sample_and_ratio
+            = propose_sample (node.current_sample, step_rng);
+          node.trial_sample                = std::move(trial_sample_and_ratio.first);
+          node.proposal_distribution_ratio = trial_sample_and_ratio.second;
+
+          if (parameters.speculation_depth == 0)
+            {
+              std::promise<double> trial_log_likelihood;
+              trial_log_likelihood.set_value (log_likelihood (node.trial_sample));
+              node.trial_log_likelihood = trial_log_likelihood.get_future().share();
+            }
+          else
+            {
+              // The evaluation works on its own copy of the trial sample
+              // so that it does not matter if the node is discarded
+              // before the evaluation finishes.
+              const auto evaluation
+                = std::make_shared<std::packaged_task<double ()>>
+                  ([&log_likelihood, trial_sample = node.trial_sample]()
+              {
+                return log_likelihood (trial_sample);
+              });
+              node.trial_log_likelihood = evaluation->get_future().share();
+              evaluations.run (thread_pool,
+                               [evaluation]()
+              {
+                (*evaluation)();
+              });
+            }
+        }
+
+      // Then create the nodes for the two possible next steps, and
+      // if we are not yet at the desired depth, expand these as well:
+      if (node.accepted == nullptr)
+        {
+          node.accepted = std::make_unique<Node>();
+          node.accepted->step                   = node.step + 1;
+          node.accepted->current_sample         = node.trial_sample;
+          node.accepted->current_log_likelihood = node.trial_log_likelihood;
+
+          node.rejected = std::make_unique<Node>();
+          node.rejected->step                   = node.step + 1;
+          node.rejected->current_sample         = node.current_sample;
+          node.rejected->current_log_likelihood = node.current_log_likelihood;
+        }
+
+      if (depth == 0)
+        return;
+
+      expand (*node.accepted, depth-1, log_likelihood, propose_sample, thread_pool, evaluations);
+      expand (*node.rejected, depth-1, log_likelihood, propose_sample, thread_pool, evaluations);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    RandomNumberGenerator
+    SpeculativeMetropolisHastings<OutputType,RandomNumberGenerator>::
+    create_step_rng (const types::sample_index step) const
+    {
+      return Random::create_stream<RandomNumberGenerator> (parameters.random_seed, step);
+    }
+  }
+}
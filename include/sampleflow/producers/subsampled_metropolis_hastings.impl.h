@@ -0,0 +1,394 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * An implementation of the Metropolis-Hastings algorithm for posterior
+     * distributions whose likelihood is a product over many independent
+     * pieces of data, i.e., where
+     * @f{align*}{
+     *   \log\pi(x) = \log\pi_0(x) + \sum_{b=0}^{N-1} \ell_b(x)
+     * @f}
+     * with a prior $\pi_0$ and one term $\ell_b$ for each of $N$ "blocks"
+     * of the data (which may consist of a single datum each, or of
+     * groups of data). If $N$ is large, evaluating all terms of the sum
+     * for every trial sample is expensive, and this class implements the
+     * approximate test of @cite KorattikaraChenWelling2014 that decides
+     * whether to accept a trial sample $\tilde x$ by looking at only a
+     * random subset of the blocks.
+     *
+     * The test is based on the observation that the Metropolis-Hastings
+     * criterion $u < \frac{\pi(\tilde x)}{\pi(x)} /
+     * \frac{\pi_\text{proposal}(\tilde x|x)}{\pi_\text{proposal}(x|\tilde x)}$
+     * for a uniform random number $u$ is equivalent to
+     * @f{align*}{
+     *   \bar d = \frac 1N \sum_{b=0}^{N-1} \left(\ell_b(\tilde x)-\ell_b(x)\right)
+     *   > \mu_0
+     *   = \frac 1N \left(\log u
+     *                    + \log\frac{\pi_\text{proposal}(\tilde x|x)}{\pi_\text{proposal}(x|\tilde x)}
+     *                    - \log\pi_0(\tilde x) + \log\pi_0(x)\right).
+     * @f}
+     * The left hand side is the mean of the $N$ differences
+     * $d_b=\ell_b(\tilde x)-\ell_b(x)$, which the algorithm estimates
+     * from a growing random subset of the blocks drawn without
+     * replacement: It first evaluates Parameters::blocks_per_batch
+     * randomly chosen blocks, computes the mean and the standard error of
+     * the differences seen so far, and decides on the outcome as soon as
+     * the probability that the sign of $\bar d-\mu_0$ differs from the
+     * one of its estimate (computed from a normal approximation of the
+     * distribution of the estimate) is less than
+     * Parameters::error_tolerance. Otherwise, it adds another batch of
+     * blocks and tries again, until it either reaches a decision or has
+     * seen all blocks, in which case the decision is exact. Trial samples
+     * whose prior or whose likelihood for one of the blocks seen is zero
+     * are rejected immediately.
+     *
+     * The result is a chain whose stationary distribution is only
+     * approximately the posterior distribution; the error tolerance
+     * trades the accuracy of this approximation against the number of
+     * blocks evaluated. If the error tolerance is zero, all blocks are
+     * evaluated in every step and the algorithm is the same as the
+     * MetropolisHastings class, though with the likelihood split into
+     * pieces.
+     *
+     * The blocks of each batch are evaluated as tasks on a ThreadPool.
+     * The values $\ell_b(x)$ for the current sample are remembered, so
+     * that for every block only $\ell_b(\tilde x)$ needs to be evaluated
+     * unless the block has not been seen since the chain moved to $x$.
+     * All random numbers, including the ones that choose the blocks, are
+     * drawn on the calling thread from the stream with number zero that
+     * Random::create_stream() creates from Parameters::random_seed, and
+     * the differences are summed in the order in which the blocks were
+     * chosen. The result is therefore reproducible, and does not depend on
+     * the number of threads of the pool.
+     *
+     * Each sample of the chain is sent downstream via the
+     * Producer::issue_sample signal. Since the algorithm does not know
+     * the full likelihood of the samples, their AuxiliaryData objects do
+     * not store an entry under the key
+     * AuxiliaryData::relative_log_likelihood. Instead, they store whether
+     * the sample is a repetition of the previous one under the key
+     * AuxiliaryData::sample_is_repeated, and how many blocks were
+     * evaluated to decide whether to accept the trial sample under the
+     * key AuxiliaryData::n_likelihood_blocks.
+     *
+     * @tparam OutputType The type of the samples.
+     * @tparam RandomNumberGenerator The type of the random number
+     *   generator used by the sampler. See the documentation of the
+     *   MetropolisHastings class for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class SubsampledMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed from which the random number generator of the
+           * sampler is created.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The number of blocks that are added to the subset in each
+           * round of the sequential test, and that are evaluated
+           * concurrently. The normal approximation used by the test is
+           * only reasonable if this number is not too small.
+           */
+          std::size_t blocks_per_batch = 32;
+
+          /**
+           * The probability of a wrong decision below which the sequential
+           * test stops adding blocks, denoted by $\epsilon$ in
+           * @cite KorattikaraChenWelling2014. Zero means that all blocks
+           * are evaluated in every step.
+           */
+          double error_tolerance = 0.05;
+
+          /**
+           * The pool on which the blocks are evaluated. If this is
+           * `nullptr` (the default), then the pool returned by
+           * ThreadPool::default_pool() is used.
+           */
+          std::shared_ptr<ThreadPool> thread_pool;
+        };
+
+        /**
+         * Constructor.
+         */
+        SubsampledMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting with the given
+         * sample, run a chain of `n_samples` steps and send each sample
+         * downstream.
+         *
+         * @param[in] starting_point The first sample of the chain. Its
+         *   prior must not be zero.
+         * @param[in] log_prior A function object that, when called with a
+         *   sample $x$, returns $\log(\pi_0(x))$.
+         * @param[in] block_log_likelihood A function object that, when
+         *   called with a sample $x$ and the number $b$ of a block, returns
+         *   $\ell_b(x)$. The function is called concurrently on the threads
+         *   of Parameters::thread_pool, and so needs to be reentrant. As for
+         *   the MetropolisHastings class, values of
+         *   `-std::numeric_limits<double>::max()` or minus infinity returned
+         *   by either function indicate that the sample has zero
+         *   probability.
+         * @param[in] n_blocks The number $N$ of blocks.
+         * @param[in] propose_sample A function object that, when given a
+         *   sample $x$ and a random number generator, returns a trial
+         *   sample along with the ratio of proposal probabilities, as for
+         *   the MetropolisHastings::sample_chains() function.
+         * @param[in] n_samples The number of samples to produce.
+         */
+        void
+        sample (const OutputType &starting_point,
+                const std::function<double (const OutputType &)> &log_prior,
+                const std::function<double (const OutputType &, const std::size_t)> &block_log_likelihood,
+                const std::size_t n_blocks,
+                const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+                const types::sample_index n_samples);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * Return the thread pool to be used, i.e., either
+         * Parameters::thread_pool or the default pool.
+         */
+        std::shared_ptr<ThreadPool>
+        get_thread_pool () const;
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    SubsampledMetropolisHastings<OutputType,RandomNumberGenerator>::
+    SubsampledMetropolisHastings (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert (parameters.blocks_per_batch > 0);
+      assert ((parameters.error_tolerance >= 0) && (parameters.error_tolerance < 0.5));
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    SubsampledMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const OutputType &starting_point,
+            const std::function<double (const OutputType &)> &log_prior,
+            const std::function<double (const OutputType &, const std::size_t)> &block_log_likelihood,
+            const std::size_t n_blocks,
+            const std::function<std::pair<OutputType,double> (const OutputType &, RandomNumberGenerator &)> &propose_sample,
+            const types::sample_index n_samples)
+    {
+      assert (n_blocks > 0);
+
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      RandomNumberGenerator rng
+        = Random::create_stream<RandomNumberGenerator> (parameters.random_seed, 0);
+
+      OutputType current_sample = starting_point;
+      double     current_log_prior = log_prior (current_sample);
+      assert (internal::has_zero_probability (current_log_prior) == false);
+
+      // The blocks are chosen by an incremental Fisher-Yates shuffle of
+      // the following array: In each step, the first n entries are the
+      // blocks seen so far. Since any permutation is as good a starting
+      // point as any other, we do not need to reset the array between
+      // steps.
+      std::vector<std::size_t> blocks (n_blocks);
+      for (std::size_t b=0; b<n_blocks; ++b)
+        blocks[b] = b;
+
+      // The values l_b(x) for the current sample x are cached. An entry
+      // is valid if its stamp equals the number of the current sample,
+      // which saves us from having to clear the cache whenever the chain
+      // moves.
+      std::vector<double>              current_block_log_likelihoods (n_blocks);
+      std::vector<types::sample_index> current_block_stamps (n_blocks, 0);
+      types::sample_index              current_stamp = 1;
+
+      // The values l_b(x_trial), indexed by position in the 'blocks'
+      // array, and the differences l_b(x_trial)-l_b(x):
+      std::vector<double> trial_block_log_likelihoods (n_blocks);
+      std::vector<double> differences (n_blocks);
+
+      for (types::sample_index step=0; step<n_samples; ++step)
+        {
+          if (this->stop_requested())
+            break;
+
+          auto [trial_sample, proposal_distribution_ratio] = propose_sample (current_sample, rng);
+          const double trial_log_prior = log_prior (trial_sample);
+          const double log_u = std::log (std::uniform_real_distribution<>(0,1)(rng));
+
+          // Run the sequential test. The trial sample is accepted if the
+          // mean of the differences is larger than mu_0:
+          std::size_t n_evaluated = 0;
+          bool        accepted = false;
+          if (internal::has_zero_probability (trial_log_prior) == false)
+            {
+              const double mu_0 = (log_u
+                                   + std::log (proposal_distribution_ratio)
+                                   - (trial_log_prior - current_log_prior))
+                                  / n_blocks;
+
+              double mean = 0;
+              double sum_of_squares = 0;
+              while (true)
+                {
+                  // Choose the next batch of blocks on this thread, then
+                  // evaluate them on the thread pool:
+                  const std::size_t batch_end = std::min (n_evaluated + parameters.blocks_per_batch,
+                                                          n_blocks);
+                  for (std::size_t i=n_evaluated; i<batch_end; ++i)
+                    std::swap (blocks[i],
+                               blocks[std::uniform_int_distribution<std::size_t>(i, n_blocks-1)(rng)]);
+
+                  get_thread_pool()->for_each_chunk (batch_end - n_evaluated,
+                                                     [&, first = n_evaluated](const std::size_t begin, const std::size_t end)
+                  {
+                    for (std::size_t i=first+begin; i<first+end; ++i)
+                      {
+                        const std::size_t b = blocks[i];
+                        trial_block_log_likelihoods[i] = block_log_likelihood (trial_sample, b);
+                        if (current_block_stamps[b] != current_stamp)
+                          {
+                            current_block_log_likelihoods[b] = block_log_likelihood (current_sample, b);
+                            current_block_stamps[b]          = current_stamp;
+                          }
+                        differences[i] = trial_block_log_likelihoods[i] - current_block_log_likelihoods[b];
+                      }
+                  });
+
+                  // Update the mean and variance of the differences in
+                  // the order in which the blocks were chosen, and look
+                  // out for blocks in which either sample has zero
+                  // probability. If the trial sample has, we reject it;
+                  // if only the current sample has (which can only
+                  // happen for the starting point), we move away from it.
+                  bool trial_has_zero_probability   = false;
+                  bool current_has_zero_probability = false;
+                  for (std::size_t i=n_evaluated; i<batch_end; ++i)
+                    {
+                      if (internal::has_zero_probability (trial_block_log_likelihoods[i]))
+                        trial_has_zero_probability = true;
+                      else if (internal::has_zero_probability (current_block_log_likelihoods[blocks[i]]))
+                        current_has_zero_probability = true;
+                      else
+                        {
+                          const double delta = differences[i] - mean;
+                          mean           += delta / (i+1);
+                          sum_of_squares += delta * (differences[i] - mean);
+                        }
+                    }
+                  n_evaluated = batch_end;
+
+                  if (trial_has_zero_probability || current_has_zero_probability)
+                    {
+                      accepted = !trial_has_zero_probability;
+                      break;
+                    }
+
+                  // If we have seen all blocks, the decision is exact.
+                  // Otherwise compute the standard error of the mean,
+                  // including the correction for sampling without
+                  // replacement from a finite population, and stop if the
+                  // probability of a wrong decision is small enough:
+                  if (n_evaluated == n_blocks)
+                    {
+                      accepted = (mean > mu_0);
+                      break;
+                    }
+
+                  if (n_evaluated >= 2)
+                    {
+                      const double n = n_evaluated;
+                      const double standard_error
+                        = std::sqrt (sum_of_squares / (n-1) / n
+                                     * (1 - (n-1) / (n_blocks-1)));
+                      if ((standard_error == 0)
+                          ||
+                          (0.5 * std::erfc (std::fabs(mean - mu_0) / standard_error / std::sqrt(2.))
+                           < parameters.error_tolerance))
+                        {
+                          accepted = (mean > mu_0);
+                          break;
+                        }
+                    }
+                }
+            }
+
+          if (accepted)
+            {
+              // Move to the trial sample, and keep the values of the
+              // blocks we have evaluated for it:
+              std::swap (current_sample, trial_sample);
+              current_log_prior = trial_log_prior;
+
+              ++current_stamp;
+              for (std::size_t i=0; i<n_evaluated; ++i)
+                {
+                  current_block_log_likelihoods[blocks[i]] = trial_block_log_likelihoods[i];
+                  current_block_stamps[blocks[i]]          = current_stamp;
+                }
+            }
+
+          this->issue_sample (current_sample,
+          {
+            {AuxiliaryData::sample_is_repeated, std::any(!accepted)},
+            {AuxiliaryData::n_likelihood_blocks, std::any(n_evaluated)}
+          });
+        }
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::shared_ptr<ThreadPool>
+    SubsampledMetropolisHastings<OutputType,RandomNumberGenerator>::
+    get_thread_pool () const
+    {
+      return (parameters.thread_pool != nullptr ?
+              parameters.thread_pool :
+              ThreadPool::default_pool());
+    }
+  }
+}
@@ -0,0 +1,476 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  namespace Producers
+  {
+    /**
+     * A class that runs many independent random-walk Metropolis-Hastings
+     * chains in lockstep, organized so that the compiler can process the
+     * chains in the lanes of SIMD registers. This is useful for target
+     * distributions that are so cheap to evaluate -- analytic test
+     * problems, or surrogate models of expensive ones -- that the cost of
+     * running a chain with the MetropolisHastings class is dominated not
+     * by evaluating the likelihood, but by the machinery around it: calls
+     * through `std::function` objects, drawing one random number at a
+     * time, the branches of the acceptance test, and creating a new
+     * sample object in every step.
+     *
+     * This class instead stores the current states of all $W$ chains in
+     * one array in "structure of arrays" layout: The values of component
+     * $i$ of all chains are stored next to each other. Each step of all
+     * chains then consists of a few loops over the chains, none of which
+     * contains a branch:
+     * - All $dW$ normally distributed numbers needed for the Gaussian
+     *   random-walk proposals of all chains are drawn with one call to
+     *   Random::fill_normal(), and added to the current states with the
+     *   standard deviations given in Parameters.
+     * - The log likelihoods of all $W$ trial points are computed by one
+     *   call to a user-provided function that receives the trial points
+     *   as a LanePoints object, i.e., in the same layout. Written as a
+     *   loop over the lanes, such a function is typically vectorized by
+     *   the compiler. It is passed to sample() as a template argument, so
+     *   that it can be inlined.
+     * - Each chain accepts or rejects its trial point by comparing the
+     *   difference of log likelihoods with the logarithm of a uniformly
+     *   distributed number, and the new states of all chains are selected
+     *   component by component from the current and the trial states.
+     *
+     * The samples of all chains are sent downstream as one batch via the
+     * Producer::issue_batch signal, every Parameters::steps_per_sample
+     * steps. The AuxiliaryData object that accompanies each sample carries
+     * the entries described for the MetropolisHastings class, along with
+     * an entry with key AuxiliaryData::chain_number that identifies the
+     * chain. Consecutive samples of the output stream therefore come from
+     * different chains; see the AffineInvariantEnsemble class for what
+     * this means for consumers. For cheap likelihoods, the cost of
+     * creating the sample objects and their auxiliary data then often
+     * exceeds the cost of the steps themselves, and sending only every
+     * $k$th sample of each chain downstream -- i.e., thinning the chains
+     * at the source -- is considerably cheaper than thinning them later.
+     *
+     * The number of chains is arbitrary, but is best chosen as a multiple
+     * of the number of lanes of the SIMD registers of the machine for the
+     * type of the elements of the samples (for example, 8 for `double`
+     * with AVX-512), and large enough that the arrays used in each step
+     * are long compared to the length of the registers.
+     *
+     * The class is not a replacement for the MetropolisHastings class for
+     * general problems: The proposal distribution is restricted to a
+     * Gaussian random walk with a diagonal covariance matrix, and all
+     * chains run on the thread that calls sample().
+     *
+     * Here is an example that samples a two-dimensional Gaussian with 64
+     * chains:
+     * @code
+     *   using SampleType = std::valarray<double>;
+     *   using Sampler    = SampleFlow::Producers::VectorizedMetropolisHastings<SampleType>;
+     *
+     *   Sampler sampler ({.proposal_standard_deviations = {0.5, 2.0}});
+     *   sampler.sample (std::vector<SampleType> (64, SampleType {0., 0.}),
+     *                   [](const Sampler::LanePoints &points, std::span<double> log_likelihoods)
+     *                   {
+     *                     const std::span<const double> x = points.component(0);
+     *                     const std::span<const double> y = points.component(1);
+     *                     for (std::size_t lane=0; lane<points.n_lanes(); ++lane)
+     *                       log_likelihoods[lane] = -0.5 * (x[lane]*x[lane] + y[lane]*y[lane]/16);
+     *                   },
+     *                   10000);
+     * @endcode
+     *
+     * @tparam OutputType The type of the samples. It needs to represent
+     *   elements of a vector space with real-valued elements.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   that is used for all chains. See the documentation of the
+     *   MetropolisHastings class for more information.
+     */
+    template <typename OutputType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class VectorizedMetropolisHastings : public Producer<OutputType>
+    {
+      public:
+        /**
+         * The type of the elements of the samples.
+         */
+        using scalar_type = types::ScalarType<OutputType>;
+
+        /**
+         * A read-only view of one point per chain, stored in "structure of
+         * arrays" layout. This is the type of the object passed to the
+         * function that evaluates the log likelihoods of the trial points.
+         */
+        class LanePoints
+        {
+          public:
+            /**
+             * Return the number of chains, i.e., the number of points.
+             */
+            std::size_t
+            n_lanes () const;
+
+            /**
+             * Return the number of components of each point.
+             */
+            std::size_t
+            dimension () const;
+
+            /**
+             * Return the values of component `i` of the points of all
+             * chains, stored contiguously.
+             */
+            std::span<const scalar_type>
+            component (const std::size_t i) const;
+
+            /**
+             * Return component `i` of the point of chain `lane`.
+             */
+            scalar_type
+            operator() (const std::size_t i,
+                        const std::size_t lane) const;
+
+          private:
+            /**
+             * Constructor, only accessible by the sampler.
+             */
+            LanePoints (const scalar_type *values,
+                        const std::size_t  dimension,
+                        const std::size_t  n_lanes);
+
+            const scalar_type *values;
+            std::size_t        dim;
+            std::size_t        n_chains;
+
+            friend class VectorizedMetropolisHastings;
+        };
+
+        /**
+         * A structure that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        struct Parameters
+        {
+          /**
+           * A random seed to be used to initialize the random number
+           * generator used by the sampling algorithm.
+           */
+          typename RandomNumberGenerator::result_type random_seed = {};
+
+          /**
+           * The standard deviation of the Gaussian proposal distribution
+           * in each component. If this vector is empty, the standard
+           * deviation `proposal_step_size` is used for all components.
+           */
+          std::vector<double> proposal_standard_deviations;
+
+          /**
+           * The standard deviation of the Gaussian proposal distribution
+           * in all components, if `proposal_standard_deviations` is empty.
+           */
+          double proposal_step_size = 1;
+
+          /**
+           * The number of steps each chain takes between two samples that
+           * are sent downstream.
+           */
+          unsigned int steps_per_sample = 1;
+        };
+
+        /**
+         * Constructor.
+         */
+        VectorizedMetropolisHastings (const Parameters &parameters = {});
+
+        /**
+         * The principal function of this class. Starting from the given
+         * points, one per chain, it advances all chains until each has
+         * produced `n_samples_per_chain` samples, which are passed through
+         * the signals of the base class to Consumer objects.
+         *
+         * @param[in] starting_points The starting points of the chains.
+         *   All need to have the same number of components. The samples
+         *   sent downstream are copies of these objects whose elements
+         *   have been overwritten.
+         * @param[in] log_likelihood A function object that, when called
+         *   with a LanePoints object that describes the points $x_w$ of all
+         *   chains and a `std::span<double>` with one element per chain,
+         *   writes $\log(\pi(x_w))$ into element $w$ of the latter. As for
+         *   the MetropolisHastings class, a value of
+         *   `-std::numeric_limits<double>::max()` or minus infinity
+         *   indicates that a point has zero probability.
+         * @param[in] n_samples_per_chain The number of samples each chain
+         *   sends downstream.
+         */
+        template <typename LogLikelihood>
+        requires (std::invocable<const LogLikelihood &, const LanePoints &, std::span<double>>)
+        void
+        sample (const std::vector<OutputType> &starting_points,
+                const LogLikelihood           &log_likelihood,
+                const types::sample_index      n_samples_per_chain);
+
+      private:
+        /**
+         * A variable that stores parameters controlling specific aspects of
+         * sampling algorithm.
+         */
+        Parameters parameters;
+
+        /**
+         * The random number generator used by the sampler.
+         */
+        RandomNumberGenerator rng;
+    };
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints::
+    LanePoints (const scalar_type *values,
+                const std::size_t  dimension,
+                const std::size_t  n_lanes)
+      :
+      values (values),
+      dim (dimension),
+      n_chains (n_lanes)
+    {}
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::size_t
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints::
+    n_lanes () const
+    {
+      return n_chains;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::size_t
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints::
+    dimension () const
+    {
+      return dim;
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::span<const typename VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::scalar_type>
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints::
+    component (const std::size_t i) const
+    {
+      assert (i < dim);
+      return {values + i*n_chains, n_chains};
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    typename VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::scalar_type
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints::
+    operator() (const std::size_t i,
+                const std::size_t lane) const
+    {
+      assert (i < dim);
+      assert (lane < n_chains);
+      return values[i*n_chains + lane];
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::
+    VectorizedMetropolisHastings (const Parameters &parameters)
+      : parameters (parameters)
+    {
+      assert (parameters.steps_per_sample >= 1);
+      assert (parameters.proposal_step_size > 0);
+
+      if (parameters.random_seed != typename RandomNumberGenerator::result_type {})
+        rng.seed (parameters.random_seed);
+    }
+
+
+
+    template <typename OutputType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<OutputType> &&
+              std::floating_point<types::ScalarType<OutputType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    template <typename LogLikelihood>
+    requires (std::invocable<const LogLikelihood &,
+              const typename VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::LanePoints &,
+              std::span<double>>)
+    void
+    VectorizedMetropolisHastings<OutputType,RandomNumberGenerator>::
+    sample (const std::vector<OutputType> &starting_points,
+            const LogLikelihood           &log_likelihood,
+            const types::sample_index      n_samples_per_chain)
+    {
+      const std::size_t n_chains = starting_points.size();
+      assert (n_chains > 0);
+      const std::size_t dimension = Utilities::size (starting_points[0]);
+      assert ((parameters.proposal_standard_deviations.size() == 0)
+              ||
+              (parameters.proposal_standard_deviations.size() == dimension));
+
+      // Make sure the flush_consumers() function is called at any point
+      // where we exit the current function.
+      Utilities::ScopeExit scope_exit ([this]()
+      {
+        this->flush_consumers();
+        this->clear_stop_request();
+      });
+
+      // Set up the state of all chains in structure-of-arrays layout:
+      // Element i*n_chains+w of 'current' is component i of chain w. The
+      // same layout is used for the trial points. All arrays are allocated
+      // once and reused in all steps.
+      std::vector<scalar_type> current (dimension * n_chains);
+      for (std::size_t w=0; w<n_chains; ++w)
+        {
+          assert (Utilities::size (starting_points[w]) == dimension);
+          for (std::size_t i=0; i<dimension; ++i)
+            current[i*n_chains + w] = Utilities::get_nth_element (starting_points[w], i);
+        }
+      std::vector<scalar_type> trial (dimension * n_chains);
+
+      std::vector<scalar_type> standard_deviations (dimension, parameters.proposal_step_size);
+      if (parameters.proposal_standard_deviations.size() > 0)
+        std::copy (parameters.proposal_standard_deviations.begin(),
+                   parameters.proposal_standard_deviations.end(),
+                   standard_deviations.begin());
+
+      std::vector<double> current_log_likelihoods (n_chains);
+      std::vector<double> trial_log_likelihoods (n_chains);
+      std::vector<double> log_uniforms (n_chains);
+
+      // Whether each chain has accepted its trial point in the current
+      // step, and whether it has moved since the last sample sent
+      // downstream. We use 'unsigned char' rather than 'bool' so that the
+      // loops below operate on plain arrays:
+      std::vector<unsigned char> accepted (n_chains);
+      std::vector<unsigned char> moved (n_chains, 0);
+
+      log_likelihood (LanePoints (current.data(), dimension, n_chains),
+                      std::span<double> (current_log_likelihoods));
+
+      std::vector<OutputType>    samples = starting_points;
+      std::vector<AuxiliaryData> aux_data (n_chains);
+
+      const auto has_zero_probability = [](const double log_likelihood)
+      {
+        return ((log_likelihood == -std::numeric_limits<double>::max())
+                ||
+                (log_likelihood == -std::numeric_limits<double>::infinity()));
+      };
+
+      for (types::sample_index n_issued = 0;
+           (n_issued < n_samples_per_chain) && (this->stop_requested() == false);
+           ++n_issued)
+        {
+          for (unsigned int step=0; step<parameters.steps_per_sample; ++step)
+            {
+              // Propose trial points for all chains:
+              Random::fill_normal (std::span<scalar_type> (trial), rng);
+              for (std::size_t i=0; i<dimension; ++i)
+                {
+                  scalar_type *const trial_i = trial.data() + i*n_chains;
+                  const scalar_type *const current_i = current.data() + i*n_chains;
+                  const scalar_type standard_deviation = standard_deviations[i];
+                  for (std::size_t w=0; w<n_chains; ++w)
+                    trial_i[w] = current_i[w] + standard_deviation * trial_i[w];
+                }
+
+              log_likelihood (LanePoints (trial.data(), dimension, n_chains),
+                              std::span<double> (trial_log_likelihoods));
+
+              // Decide which chains accept their trial points. Drawing the
+              // random numbers is sequential, but taking their logarithms
+              // and comparing is not. As in MetropolisHastings, a chain
+              // whose current point has zero probability accepts any
+              // trial point, and trial points with zero probability are
+              // otherwise rejected.
+              for (std::size_t w=0; w<n_chains; ++w)
+                log_uniforms[w] = Random::internal::uniform_open_closed (rng);
+              for (std::size_t w=0; w<n_chains; ++w)
+                log_uniforms[w] = std::log (log_uniforms[w]);
+              for (std::size_t w=0; w<n_chains; ++w)
+                {
+                  const bool current_is_zero = has_zero_probability (current_log_likelihoods[w]);
+                  const bool trial_is_zero   = has_zero_probability (trial_log_likelihoods[w]);
+                  accepted[w] = (current_is_zero
+                                 |
+                                 ((!trial_is_zero)
+                                  &
+                                  (trial_log_likelihoods[w] - current_log_likelihoods[w] >= log_uniforms[w])));
+                }
+
+              // Then select the new states component by component:
+              for (std::size_t i=0; i<dimension; ++i)
+                {
+                  scalar_type *const current_i = current.data() + i*n_chains;
+                  const scalar_type *const trial_i = trial.data() + i*n_chains;
+                  for (std::size_t w=0; w<n_chains; ++w)
+                    current_i[w] = (accepted[w] ? trial_i[w] : current_i[w]);
+                }
+              for (std::size_t w=0; w<n_chains; ++w)
+                {
+                  current_log_likelihoods[w] = (accepted[w] ? trial_log_likelihoods[w] : current_log_likelihoods[w]);
+                  moved[w] |= accepted[w];
+                }
+            }
+
+          // Send the current states of all chains downstream as one batch,
+          // writing them into the sample objects we keep around:
+          for (std::size_t w=0; w<n_chains; ++w)
+            {
+              for (std::size_t i=0; i<dimension; ++i)
+                Utilities::get_nth_element (samples[w], i) = current[i*n_chains + w];
+
+              aux_data[w] =
+              {
+                {AuxiliaryData::relative_log_likelihood, std::any(current_log_likelihoods[w])},
+                {AuxiliaryData::sample_is_repeated, std::any(moved[w] == 0)},
+                {AuxiliaryData::chain_number, std::any(w)}
+              };
+              moved[w] = 0;
+            }
+          this->issue_batch (samples, aux_data);
+        }
+    }
+  }
+}
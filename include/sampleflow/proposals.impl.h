@@ -0,0 +1,862 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for commonly used proposal distributions ("kernels") for
+   * Markov chain Monte Carlo methods, in a form that can be passed
+   * directly as the `propose_sample` argument of
+   * Producers::MetropolisHastings::sample() and
+   * Producers::MetropolisHastings::sample_chains().
+   *
+   * Most users of SampleFlow write a function that perturbs the current
+   * sample by a Gaussian random vector, as shown in the documentation of
+   * the Producers::MetropolisHastings class. Done in the obvious way --
+   * drawing one number at a time from a `std::normal_distribution`
+   * object and returning a newly allocated sample -- this is quite slow
+   * for samples with many components. The classes in this namespace
+   * instead draw the random numbers in blocks via Random::fill_normal(),
+   * apply the covariance matrix of the proposal distribution with
+   * vectorized loops, and write the trial sample into the object the
+   * sampler provides for it, so that no memory is allocated once the
+   * first sample has been proposed:
+   * @code
+   *   using SampleType = Eigen::VectorXd;
+   *   SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+   *   mh_sampler.sample (starting_point,
+   *                      log_likelihood,
+   *                      SampleFlow::Proposals::GaussianRandomWalk<SampleType> (proposal_covariance),
+   *                      n_samples);
+   * @endcode
+   *
+   * Each class has three function call operators. The one that takes the
+   * current sample and the trial sample to be written is the one
+   * MetropolisHastings::sample() calls; it uses a random number generator
+   * stored in the proposal object. The one that takes the current sample
+   * and a random number generator and returns the trial sample is the one
+   * MetropolisHastings::sample_chains() calls with the generator of the
+   * chain, so that the same proposal object can be used by all chains at
+   * the same time and that the chains are reproducible and can be
+   * checkpointed. Both are implemented via the third one, which takes the
+   * current sample, the trial sample, and the generator.
+   */
+  namespace Proposals
+  {
+    namespace internal
+    {
+      /**
+       * A class that describes the covariance matrix $\Sigma$ of a
+       * Gaussian distribution with mean zero, which is either a multiple
+       * $s^2 I$ of the identity matrix, a diagonal matrix, or a general
+       * symmetric positive definite matrix $\Sigma=LL^T$ given by its
+       * Cholesky factor $L$.
+       */
+      template <typename Number>
+      class GaussianShape
+      {
+        public:
+          using vector_type = Eigen::Matrix<Number,Eigen::Dynamic,1>;
+          using matrix_type = Eigen::Matrix<Number,Eigen::Dynamic,Eigen::Dynamic>;
+
+          /**
+           * Constructor for the covariance matrix $s^2 I$.
+           */
+          explicit
+          GaussianShape (const Number standard_deviation);
+
+          /**
+           * Constructor for a diagonal covariance matrix with the squares of
+           * the given numbers on the diagonal.
+           */
+          explicit
+          GaussianShape (const vector_type &standard_deviations);
+
+          /**
+           * Constructor for a general covariance matrix, which must be
+           * symmetric and positive definite.
+           */
+          explicit
+          GaussianShape (const matrix_type &covariance);
+
+          /**
+           * Replace the vector $z$ by $Lz$. If $z$ has independent, standard
+           * normally distributed entries, then $Lz$ has covariance
+           * $\Sigma$.
+           */
+          void
+          transform (std::span<Number> z) const;
+
+          /**
+           * Replace the vector $y$ by $L^{-1}y$, so that the squared norm of
+           * the result is $y^T\Sigma^{-1}y$.
+           */
+          void
+          whiten (std::span<Number> y) const;
+
+          /**
+           * Return the number of components of vectors this object can be
+           * applied to, or zero if it is a multiple of the identity.
+           */
+          unsigned int
+          size () const;
+
+        private:
+          enum class Kind
+          {
+            isotropic,
+            diagonal,
+            cholesky
+          };
+
+          Kind        kind;
+          Number      standard_deviation;
+          vector_type standard_deviations;
+
+          /**
+           * The transpose $L^T$ of the Cholesky factor. Since Eigen stores
+           * matrices by column, the rows of $L$ that transform() and
+           * whiten() need are then stored contiguously.
+           */
+          matrix_type cholesky_factor_transpose;
+      };
+
+
+
+      /**
+       * Return a vector owned by the current thread with (at least) the
+       * given number of elements, to be used as scratch space by the
+       * proposal classes. Using one vector per thread, rather than one per
+       * proposal object, allows using the same proposal object on several
+       * threads at once, for example by MetropolisHastings::sample_chains(),
+       * without allocating memory for every proposed sample.
+       */
+      template <typename Number>
+      std::span<Number>
+      scratch_space (const std::size_t size)
+      {
+        thread_local std::vector<Number> scratch;
+        if (scratch.size() < size)
+          scratch.resize (size);
+        return std::span<Number> (scratch.data(), size);
+      }
+
+
+
+      /**
+       * Set `trial_sample` to `shift + factor * (x - shift) + perturbation`
+       * (where `shift` may be empty, in which case it is treated as zero),
+       * reusing the memory of `trial_sample` if it already has the right
+       * size.
+       */
+      template <typename SampleType, typename Number>
+      void
+      write_trial_sample (const SampleType                              &x,
+                          const Number                                   factor,
+                          const Eigen::Matrix<Number,Eigen::Dynamic,1>   &shift,
+                          const std::span<const Number>                  perturbation,
+                          SampleType                                    &trial_sample)
+      {
+        const std::size_t size = perturbation.size();
+        if (static_cast<std::size_t>(Utilities::size(trial_sample)) != size)
+          trial_sample = x;
+
+        using vector_type = Eigen::Matrix<Number,Eigen::Dynamic,1>;
+        if constexpr (Concepts::has_contiguous_storage<SampleType,Number>)
+          {
+            Eigen::Map<vector_type> trial (std::ranges::data(trial_sample), size);
+            const Eigen::Map<const vector_type> current (std::ranges::data(x), size);
+            const Eigen::Map<const vector_type> p (perturbation.data(), size);
+            if (shift.size() == 0)
+              trial = factor * current + p;
+            else
+              trial = shift + factor * (current - shift) + p;
+          }
+        else
+          for (std::size_t i=0; i<size; ++i)
+            {
+              const Number s = (shift.size() == 0 ? Number(0) : shift[i]);
+              Utilities::get_nth_element (trial_sample, i)
+                = s + factor * (Utilities::get_nth_element (x, i) - s) + perturbation[i];
+            }
+      }
+    }
+
+
+
+    /**
+     * A Gaussian random walk proposal: Given the current sample $x$, the
+     * trial sample is $\tilde x = x + \xi$ where $\xi$ is drawn from a
+     * normal distribution with mean zero and covariance matrix $\Sigma$.
+     * $\Sigma$ can be a multiple $s^2I$ of the identity matrix (an
+     * "isotropic" random walk), a diagonal matrix, or a general symmetric
+     * positive definite matrix, for example an approximation of the
+     * covariance of the target distribution ("preconditioned" random
+     * walk). In the last case, the constructor computes the Cholesky
+     * factorization $\Sigma=LL^T$, and every proposal costs ${\cal O}(d^2)$
+     * operations for samples with $d$ components; in the first two
+     * cases, it costs ${\cal O}(d)$ operations.
+     *
+     * The proposal distribution is symmetric, so the ratio of proposal
+     * probabilities returned by the function call operators is always one.
+     *
+     * See the documentation of namespace Proposals for how to use this
+     * class.
+     *
+     * @tparam SampleType The type of the samples. It needs to be a vector
+     *   type (see Concepts::is_vector_space_type) with real-valued
+     *   elements.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used, which should be the same as the one used by the sampler.
+     */
+    template <typename SampleType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class GaussianRandomWalk
+    {
+      public:
+        /**
+         * The type of the elements of samples.
+         */
+        using scalar_type = types::ScalarType<SampleType>;
+
+        /**
+         * The types used for vectors and matrices that describe the
+         * covariance of the proposal distribution.
+         */
+        using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * Constructor for an isotropic random walk whose steps have the
+         * given standard deviation in each component.
+         *
+         * @param[in] step_size The standard deviation $s$ of each component
+         *   of the perturbation.
+         * @param[in] random_seed The seed of the random number generator
+         *   used by the function call operator that does not take a
+         *   generator.
+         */
+        explicit
+        GaussianRandomWalk (const scalar_type   step_size,
+                            const std::uint64_t random_seed = 0);
+
+        /**
+         * Constructor for a random walk whose steps have independent
+         * components with the given standard deviations.
+         */
+        explicit
+        GaussianRandomWalk (const vector_type   &standard_deviations,
+                            const std::uint64_t  random_seed = 0);
+
+        /**
+         * Constructor for a random walk whose steps have the given
+         * covariance matrix, which must be symmetric and positive definite.
+         */
+        explicit
+        GaussianRandomWalk (const matrix_type   &covariance,
+                            const std::uint64_t  random_seed = 0);
+
+        /**
+         * Write a trial sample into the second argument, using the random
+         * number generator stored in this object, and return the ratio of
+         * proposal probabilities, which is one. This function must not be
+         * called on the same object from several threads at once.
+         */
+        double
+        operator() (const SampleType &current_sample,
+                    SampleType       &trial_sample) const;
+
+        /**
+         * Return a trial sample, using the given random number generator,
+         * along with the ratio of proposal probabilities, which is one.
+         * This function can be called on the same object from several
+         * threads at once.
+         */
+        std::pair<SampleType,double>
+        operator() (const SampleType      &current_sample,
+                    RandomNumberGenerator &rng) const;
+
+        /**
+         * Write a trial sample into the second argument, using the given
+         * random number generator, and return the ratio of proposal
+         * probabilities, which is one. This function can be called on the
+         * same object from several threads at once.
+         */
+        double
+        operator() (const SampleType      &current_sample,
+                    SampleType            &trial_sample,
+                    RandomNumberGenerator &rng) const;
+
+        /**
+         * Return the logarithm of the probability density with which a
+         * trial sample $\tilde x$ is proposed from the current sample $x$,
+         * up to a constant that is the same for all arguments, i.e.,
+         * $-\frac 12 (\tilde x-x)^T\Sigma^{-1}(\tilde x-x)$. This is what
+         * samplers need that couple the proposals of two chains, such as
+         * Producers::CoupledMetropolisHastings. This function can be called
+         * on the same object from several threads at once.
+         */
+        double
+        log_density (const SampleType &current_sample,
+                     const SampleType &trial_sample) const;
+
+      private:
+        /**
+         * The covariance of the perturbations.
+         */
+        internal::GaussianShape<scalar_type> shape;
+
+        /**
+         * The random number generator used if none is given.
+         */
+        mutable RandomNumberGenerator rng;
+    };
+
+
+
+    /**
+     * The preconditioned Crank-Nicolson (pCN) proposal for problems in which
+     * the target distribution has the form
+     * $\pi(x) \propto L(x)\,\mu_0(x)$ with a Gaussian prior distribution
+     * $\mu_0={\cal N}(m,C)$ and a likelihood $L(x)$, see
+     * S. L. Cotter, G. O. Roberts, A. M. Stuart, D. White: "MCMC methods
+     * for functions: Modifying old algorithms to make them faster",
+     * Statistical Science, vol. 28, pp. 424-446, 2013.
+     * Given the current sample $x$, the trial sample is
+     * @f{align*}{
+     *   \tilde x = m + \sqrt{1-\beta^2}\,(x-m) + \beta\xi,
+     *   \qquad \xi\sim {\cal N}(0,C),
+     * @f}
+     * with a step size $0<\beta\le 1$. Unlike for a random walk, the
+     * acceptance rate of this proposal does not degrade as the
+     * discretization of a function-valued unknown $x$ is refined (i.e., as
+     * the number of components of $x$ grows), which makes it the method of
+     * choice for inverse problems with Gaussian priors on fields.
+     *
+     * The proposal leaves the prior $\mu_0$ invariant, and so the ratio of
+     * proposal probabilities is
+     * $\frac{\pi_\text{proposal}(\tilde x|x)}{\pi_\text{proposal}(x|\tilde x)}
+     *  = \frac{\mu_0(\tilde x)}{\mu_0(x)}$. This is what the function call
+     * operators return, so that MetropolisHastings, which is given the
+     * logarithm of the full target density $L(x)\mu_0(x)$ (up to a
+     * constant), accepts trial samples with the pCN acceptance probability
+     * $\min\{1,L(\tilde x)/L(x)\}$. Computing this ratio requires one
+     * triangular solve with the Cholesky factor of $C$ in addition to the
+     * one multiplication needed to draw $\xi$, i.e., ${\cal O}(d^2)$
+     * operations for a general $C$ and ${\cal O}(d)$ operations for a
+     * diagonal or isotropic one, as is common for priors expressed in a
+     * Karhunen-Loeve basis.
+     *
+     * @tparam SampleType The type of the samples. The same requirements
+     *   hold as for the GaussianRandomWalk class.
+     * @tparam RandomNumberGenerator The type of the random number generator
+     *   used, which should be the same as the one used by the sampler.
+     */
+    template <typename SampleType, typename RandomNumberGenerator = std::mt19937>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    class PreconditionedCrankNicolson
+    {
+      public:
+        /**
+         * The type of the elements of samples.
+         */
+        using scalar_type = types::ScalarType<SampleType>;
+
+        /**
+         * The types used for vectors and matrices that describe the prior
+         * distribution.
+         */
+        using vector_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,1>;
+        using matrix_type = Eigen::Matrix<scalar_type,Eigen::Dynamic,Eigen::Dynamic>;
+
+        /**
+         * Constructor for a prior whose components are independent with
+         * standard deviation `prior_standard_deviation` each.
+         *
+         * @param[in] beta The step size $\beta$.
+         * @param[in] prior_standard_deviation The standard deviation of
+         *   each component of the prior.
+         * @param[in] prior_mean The mean $m$ of the prior. If empty, the
+         *   mean is zero.
+         * @param[in] random_seed The seed of the random number generator
+         *   used by the function call operator that does not take a
+         *   generator.
+         */
+        PreconditionedCrankNicolson (const scalar_type    beta,
+                                     const scalar_type    prior_standard_deviation,
+                                     const vector_type   &prior_mean = {},
+                                     const std::uint64_t  random_seed = 0);
+
+        /**
+         * Constructor for a prior whose components are independent with
+         * the given standard deviations.
+         */
+        PreconditionedCrankNicolson (const scalar_type    beta,
+                                     const vector_type   &prior_standard_deviations,
+                                     const vector_type   &prior_mean = {},
+                                     const std::uint64_t  random_seed = 0);
+
+        /**
+         * Constructor for a prior with the given covariance matrix $C$,
+         * which must be symmetric and positive definite.
+         */
+        PreconditionedCrankNicolson (const scalar_type    beta,
+                                     const matrix_type   &prior_covariance,
+                                     const vector_type   &prior_mean = {},
+                                     const std::uint64_t  random_seed = 0);
+
+        /**
+         * Write a trial sample into the second argument, using the random
+         * number generator stored in this object, and return the ratio of
+         * proposal probabilities. This function must not be called on the
+         * same object from several threads at once.
+         */
+        double
+        operator() (const SampleType &current_sample,
+                    SampleType       &trial_sample) const;
+
+        /**
+         * Return a trial sample, using the given random number generator,
+         * along with the ratio of proposal probabilities. This function can
+         * be called on the same object from several threads at once.
+         */
+        std::pair<SampleType,double>
+        operator() (const SampleType      &current_sample,
+                    RandomNumberGenerator &rng) const;
+
+        /**
+         * Write a trial sample into the second argument, using the given
+         * random number generator, and return the ratio of proposal
+         * probabilities. This function can be called on the same object
+         * from several threads at once.
+         */
+        double
+        operator() (const SampleType      &current_sample,
+                    SampleType            &trial_sample,
+                    RandomNumberGenerator &rng) const;
+
+      private:
+        /**
+         * The step size $\beta$ and the factor $\sqrt{1-\beta^2}$.
+         */
+        const scalar_type beta;
+        const scalar_type contraction;
+
+        /**
+         * The covariance and the mean of the prior.
+         */
+        internal::GaussianShape<scalar_type> shape;
+        vector_type                          prior_mean;
+
+        /**
+         * The random number generator used if none is given.
+         */
+        mutable RandomNumberGenerator rng;
+    };
+
+
+
+    namespace internal
+    {
+      template <typename Number>
+      GaussianShape<Number>::GaussianShape (const Number standard_deviation)
+        :
+        kind (Kind::isotropic),
+        standard_deviation (standard_deviation)
+      {
+        assert (standard_deviation > 0);
+      }
+
+
+
+      template <typename Number>
+      GaussianShape<Number>::GaussianShape (const vector_type &standard_deviations)
+        :
+        kind (Kind::diagonal),
+        standard_deviation (1),
+        standard_deviations (standard_deviations)
+      {
+        assert ((standard_deviations.array() > 0).all());
+      }
+
+
+
+      template <typename Number>
+      GaussianShape<Number>::GaussianShape (const matrix_type &covariance)
+        :
+        kind (Kind::cholesky),
+        standard_deviation (1)
+      {
+        assert (covariance.rows() == covariance.cols());
+
+        const Eigen::LLT<matrix_type> factorization (covariance);
+        assert (factorization.info() == Eigen::Success);
+        cholesky_factor_transpose = factorization.matrixU();
+      }
+
+
+
+      template <typename Number>
+      void
+      GaussianShape<Number>::transform (std::span<Number> z) const
+      {
+        using vector_type = Eigen::Matrix<Number,Eigen::Dynamic,1>;
+        Eigen::Map<vector_type> v (z.data(), z.size());
+
+        switch (kind)
+          {
+            case Kind::isotropic:
+              v *= standard_deviation;
+              break;
+
+            case Kind::diagonal:
+              assert (standard_deviations.size() == v.size());
+              v.array() *= standard_deviations.array();
+              break;
+
+            case Kind::cholesky:
+            {
+              assert (cholesky_factor_transpose.rows() == v.size());
+
+              // Compute v <- L v in place: Row i of L only involves the
+              // elements 0..i of v, so going from the last row to the
+              // first only uses elements that have not been overwritten
+              // yet. Row i of L is column i of L^T, stored contiguously:
+              for (Eigen::Index i=v.size()-1; i>=0; --i)
+                v(i) = cholesky_factor_transpose.col(i).head(i+1).dot (v.head(i+1));
+              break;
+            }
+          }
+      }
+
+
+
+      template <typename Number>
+      void
+      GaussianShape<Number>::whiten (std::span<Number> y) const
+      {
+        using vector_type = Eigen::Matrix<Number,Eigen::Dynamic,1>;
+        Eigen::Map<vector_type> v (y.data(), y.size());
+
+        switch (kind)
+          {
+            case Kind::isotropic:
+              v /= standard_deviation;
+              break;
+
+            case Kind::diagonal:
+              assert (standard_deviations.size() == v.size());
+              v.array() /= standard_deviations.array();
+              break;
+
+            case Kind::cholesky:
+            {
+              assert (cholesky_factor_transpose.rows() == v.size());
+
+              // Forward substitution with L, in place:
+              for (Eigen::Index i=0; i<v.size(); ++i)
+                v(i) = (v(i) - cholesky_factor_transpose.col(i).head(i).dot (v.head(i)))
+                       / cholesky_factor_transpose(i,i);
+              break;
+            }
+          }
+      }
+
+
+
+      template <typename Number>
+      unsigned int
+      GaussianShape<Number>::size () const
+      {
+        switch (kind)
+          {
+            case Kind::diagonal:
+              return standard_deviations.size();
+            case Kind::cholesky:
+              return cholesky_factor_transpose.rows();
+            default:
+              return 0;
+          }
+      }
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    GaussianRandomWalk (const scalar_type   step_size,
+                        const std::uint64_t random_seed)
+      :
+      shape (step_size),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {}
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    GaussianRandomWalk (const vector_type   &standard_deviations,
+                        const std::uint64_t  random_seed)
+      :
+      shape (standard_deviations),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {}
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    GaussianRandomWalk (const matrix_type   &covariance,
+                        const std::uint64_t  random_seed)
+      :
+      shape (covariance),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {}
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType &current_sample,
+                SampleType       &trial_sample) const
+    {
+      return (*this)(current_sample, trial_sample, rng);
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::pair<SampleType,double>
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType      &current_sample,
+                RandomNumberGenerator &rng) const
+    {
+      SampleType trial_sample = current_sample;
+      const double ratio = (*this)(current_sample, trial_sample, rng);
+      return {std::move(trial_sample), ratio};
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType      &current_sample,
+                SampleType            &trial_sample,
+                RandomNumberGenerator &rng) const
+    {
+      const std::size_t size = Utilities::size (current_sample);
+      assert ((shape.size() == 0) || (shape.size() == size));
+
+      const std::span<scalar_type> perturbation = internal::scratch_space<scalar_type> (size);
+      Random::fill_normal (perturbation, rng);
+      shape.transform (perturbation);
+
+      internal::write_trial_sample (current_sample, scalar_type(1), vector_type(),
+                                    std::span<const scalar_type> (perturbation),
+                                    trial_sample);
+      return 1.;
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    GaussianRandomWalk<SampleType,RandomNumberGenerator>::
+    log_density (const SampleType &current_sample,
+                 const SampleType &trial_sample) const
+    {
+      const std::size_t size = Utilities::size (current_sample);
+      assert ((shape.size() == 0) || (shape.size() == size));
+      assert (static_cast<std::size_t>(Utilities::size (trial_sample)) == size);
+
+      const std::span<scalar_type> step = internal::scratch_space<scalar_type> (size);
+      for (std::size_t i=0; i<size; ++i)
+        step[i] = Utilities::get_nth_element (trial_sample, i)
+                  - Utilities::get_nth_element (current_sample, i);
+      shape.whiten (step);
+
+      return -0.5 * Eigen::Map<const vector_type> (step.data(), size).squaredNorm();
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    PreconditionedCrankNicolson (const scalar_type    beta,
+                                 const scalar_type    prior_standard_deviation,
+                                 const vector_type   &prior_mean,
+                                 const std::uint64_t  random_seed)
+      :
+      beta (beta),
+      contraction (std::sqrt (1 - beta*beta)),
+      shape (prior_standard_deviation),
+      prior_mean (prior_mean),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {
+      assert ((beta > 0) && (beta <= 1));
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    PreconditionedCrankNicolson (const scalar_type    beta,
+                                 const vector_type   &prior_standard_deviations,
+                                 const vector_type   &prior_mean,
+                                 const std::uint64_t  random_seed)
+      :
+      beta (beta),
+      contraction (std::sqrt (1 - beta*beta)),
+      shape (prior_standard_deviations),
+      prior_mean (prior_mean),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {
+      assert ((beta > 0) && (beta <= 1));
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    PreconditionedCrankNicolson (const scalar_type    beta,
+                                 const matrix_type   &prior_covariance,
+                                 const vector_type   &prior_mean,
+                                 const std::uint64_t  random_seed)
+      :
+      beta (beta),
+      contraction (std::sqrt (1 - beta*beta)),
+      shape (prior_covariance),
+      prior_mean (prior_mean),
+      rng (Random::create_stream<RandomNumberGenerator> (random_seed, 0))
+    {
+      assert ((beta > 0) && (beta <= 1));
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType &current_sample,
+                SampleType       &trial_sample) const
+    {
+      return (*this)(current_sample, trial_sample, rng);
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    std::pair<SampleType,double>
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType      &current_sample,
+                RandomNumberGenerator &rng) const
+    {
+      SampleType trial_sample = current_sample;
+      const double ratio = (*this)(current_sample, trial_sample, rng);
+      return {std::move(trial_sample), ratio};
+    }
+
+
+
+    template <typename SampleType, typename RandomNumberGenerator>
+    requires (Concepts::is_vector_space_type<SampleType> &&
+              std::floating_point<types::ScalarType<SampleType>> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    double
+    PreconditionedCrankNicolson<SampleType,RandomNumberGenerator>::
+    operator() (const SampleType      &current_sample,
+                SampleType            &trial_sample,
+                RandomNumberGenerator &rng) const
+    {
+      const std::size_t size = Utilities::size (current_sample);
+      assert ((shape.size() == 0) || (shape.size() == size));
+      assert ((prior_mean.size() == 0) || (std::size_t(prior_mean.size()) == size));
+
+      // Use the first half of the scratch space for w = L^{-1}(x-m) and
+      // the second half for the standard normal vector z:
+      const std::span<scalar_type> scratch = internal::scratch_space<scalar_type> (2*size);
+      const std::span<scalar_type> whitened = scratch.first (size);
+      const std::span<scalar_type> perturbation = scratch.last (size);
+
+      for (std::size_t i=0; i<size; ++i)
+        whitened[i] = Utilities::get_nth_element (current_sample, i)
+                      - (prior_mean.size() == 0 ? scalar_type(0) : prior_mean[i]);
+      shape.whiten (whitened);
+
+      Random::fill_normal (perturbation, rng);
+
+      // With rho=sqrt(1-beta^2), the whitened trial sample is
+      // w' = rho w + beta z, and so the logarithm of
+      // mu_0(x')/mu_0(x) = exp(-|w'|^2/2) / exp(-|w|^2/2) is
+      //   -1/2 (|w'|^2 - |w|^2)
+      //   = -1/2 (beta^2 (|z|^2 - |w|^2) + 2 rho beta w.z).
+      const Eigen::Map<const vector_type> w (whitened.data(), size);
+      const Eigen::Map<const vector_type> z (perturbation.data(), size);
+      const double log_ratio = -0.5 * (beta*beta * (z.squaredNorm() - w.squaredNorm())
+                                       + 2 * contraction * beta * w.dot(z));
+
+      // Then compute beta*L*z and from it the trial sample:
+      shape.transform (perturbation);
+      Eigen::Map<vector_type> (perturbation.data(), size) *= beta;
+      internal::write_trial_sample (current_sample, contraction, prior_mean,
+                                    std::span<const scalar_type> (perturbation),
+                                    trial_sample);
+
+      return std::exp (log_ratio);
+    }
+  }
+}
@@ -0,0 +1,40 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_PULL_RANGE_H
+#define SAMPLEFLOW_PULL_RANGE_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/auxiliary_data.h>
+#include <sampleflow/consumer.h>
+#include <sampleflow/producer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <utility>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/pull_range.impl.h>
+
+#endif
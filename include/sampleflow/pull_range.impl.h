@@ -0,0 +1,384 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A class that turns a Producer into a lazily evaluated range of the
+   * samples it produces. Producers generally "push" samples to the
+   * consumers connected to them: One calls a function such as
+   * Producers::MetropolisHastings::sample(), which only returns once all
+   * samples have been generated and sent downstream. In contrast, iterating
+   * over an object of the current class "pulls" samples out of a producer
+   * one at a time: Whenever the iterator is advanced, the producer is
+   * asked to take one more step, and the samples it issues in the process
+   * are what the iterator then points to. This makes it possible, for
+   * example, to interleave several chains on one thread:
+   * @code
+   *   auto chain_1 = sampler_1.pull (starting_point_1, log_likelihood, perturb);
+   *   auto chain_2 = sampler_2.pull (starting_point_2, log_likelihood, perturb);
+   *   for (auto it_1 = chain_1.begin(), it_2 = chain_2.begin();
+   *        n_steps < max_n_steps;
+   *        ++it_1, ++it_2, ++n_steps)
+   *     {
+   *       const auto &[sample_1, aux_data_1] = *it_1;
+   *       const auto &[sample_2, aux_data_2] = *it_2;
+   *       ...
+   *     }
+   * @endcode
+   * Because the class satisfies the requirements of a `std::ranges::view`,
+   * it can also be combined with the range adaptors of the C++ standard
+   * library, for example as in `sampler.pull(...) | std::views::take(1000)`
+   * -- which in turn can be fed to Producers::Range to send the samples to
+   * consumers.
+   *
+   * Samples are issued by the producer in the usual way, and consumers
+   * connected to the producer therefore still receive them. The current
+   * class simply connects an additional consumer to the producer that
+   * stores the samples until the iterator gets to them. This consumer only
+   * stores samples that are issued while the current range lets the
+   * producer take a step, on the thread that does so; several ranges can
+   * therefore pull samples from the same producer (for example, several
+   * chains of one Producers::MetropolisHastings object), even on
+   * different threads.
+   *
+   * Objects of this type are typically not created directly, but by
+   * member functions of producers such as
+   * Producers::MetropolisHastings::pull(). These provide the function that
+   * advances the producer by one step.
+   *
+   * The range is an input range: It can only be traversed once, and
+   * begin() must only be called once. Producing samples happens on the
+   * thread that advances the iterator.
+   *
+   * @tparam OutputType The type of the samples of the producer.
+   */
+  template <typename OutputType>
+  class PullRange : public std::ranges::view_interface<PullRange<OutputType>>
+  {
+    public:
+      /**
+       * The type of the elements of the range: A sample along with its
+       * auxiliary data.
+       */
+      using value_type = std::pair<OutputType,AuxiliaryData>;
+
+    private:
+      /**
+       * The state of the range, declared with the private members below.
+       */
+      struct State;
+
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] producer The producer whose samples are to be pulled.
+       *   The producer must remain alive while the current object is
+       *   being iterated over.
+       * @param[in] advance A function that lets the producer take one step.
+       *   A step may issue any number of samples, including none (for
+       *   example if the producer compresses repeated samples); the
+       *   function is called as often as necessary to obtain the next
+       *   sample. The function returns `false` once the producer cannot
+       *   produce any more samples, at which point the range ends.
+       * @param[in] finish A function that is called when the current
+       *   object is destroyed. Producers use this to flush the consumers
+       *   connected to them.
+       */
+      PullRange (Producer<OutputType>        &producer,
+                 const std::function<bool ()> &advance,
+                 const std::function<void ()> &finish = {});
+
+      /**
+       * Move constructor and move assignment operator. Ranges can be moved
+       * but not copied.
+       */
+      PullRange (PullRange &&) = default;
+      PullRange &operator= (PullRange &&) = default;
+
+      /**
+       * Destructor.
+       */
+      ~PullRange ();
+
+      /**
+       * The iterator through which one accesses the elements of the range.
+       */
+      class iterator
+      {
+        public:
+          using value_type      = PullRange::value_type;
+          using difference_type = std::ptrdiff_t;
+
+          /**
+           * Access the sample (and its auxiliary data) the iterator
+           * currently points to. The functions return references into the
+           * state of the range that remain valid until the iterator is
+           * incremented. Since the range is traversed only once, it is
+           * fine to move the sample out of the object so referenced.
+           */
+          value_type &operator* () const;
+          value_type *operator-> () const;
+
+          /**
+           * Move the iterator to the next sample, letting the producer
+           * take as many steps as necessary to produce it.
+           */
+          iterator &operator++ ();
+          void operator++ (int);
+
+          /**
+           * Return whether the iterator points past the end of the range.
+           */
+          bool operator== (std::default_sentinel_t) const;
+
+        private:
+          /**
+           * Constructor.
+           */
+          iterator (PullRange::State &range_state);
+
+          /**
+           * The state of the range the iterator belongs to. (This is not
+           * a pointer to the range itself since ranges can be moved.)
+           */
+          PullRange::State *range_state;
+
+          friend class PullRange;
+      };
+
+      /**
+       * Return an iterator that points to the first sample of the range,
+       * letting the producer take as many steps as necessary to produce
+       * it.
+       */
+      iterator
+      begin ();
+
+      /**
+       * Return an object that indicates the end of the range.
+       */
+      std::default_sentinel_t
+      end () const;
+
+    private:
+      /**
+       * A consumer that receives the samples of the producer and stores
+       * them until the iterator gets to them.
+       */
+      class Receiver : public Consumer<OutputType>
+      {
+        public:
+          Receiver ();
+          virtual ~Receiver ();
+
+          virtual
+          void
+          consume (OutputType sample, AuxiliaryData aux_data) override;
+
+          /**
+           * The samples received but not yet handed out.
+           */
+          std::deque<value_type> samples;
+
+          /**
+           * The thread that is currently letting the producer take a step
+           * on behalf of the current range, if any. Samples issued on other
+           * threads (or at other times) belong to someone else.
+           */
+          std::atomic<std::thread::id> receiving_thread;
+      };
+
+      /**
+       * The state of the range. It is kept in a separate object so that
+       * the receiver, which is connected to the producer, does not have
+       * to move when the range is moved.
+       */
+      struct State
+      {
+        Receiver                  receiver;
+        std::function<bool ()>    advance;
+        std::function<void ()>    finish;
+        std::optional<value_type> current_sample;
+        bool                      producer_exhausted = false;
+
+        /**
+         * Let the producer take steps until there is a sample available,
+         * or until it cannot produce any further samples, and then make
+         * the next sample the current one.
+         */
+        void
+        fetch_next_sample ();
+      };
+
+      std::unique_ptr<State> state;
+  };
+
+
+
+  template <typename OutputType>
+  PullRange<OutputType>::Receiver::Receiver ()
+    :
+    receiving_thread (std::thread::id())
+  {}
+
+
+
+  template <typename OutputType>
+  PullRange<OutputType>::Receiver::~Receiver ()
+  {
+    this->disconnect_and_flush();
+  }
+
+
+
+  template <typename OutputType>
+  void
+  PullRange<OutputType>::Receiver::consume (OutputType sample, AuxiliaryData aux_data)
+  {
+    // Only the thread that iterates over the range gets past this check,
+    // and it is also the one that takes samples out of the 'samples'
+    // array. Accessing the array therefore needs no lock.
+    if (receiving_thread.load (std::memory_order_relaxed) == std::this_thread::get_id())
+      samples.emplace_back (std::move(sample), std::move(aux_data));
+  }
+
+
+
+  template <typename OutputType>
+  PullRange<OutputType>::PullRange (Producer<OutputType>        &producer,
+                                    const std::function<bool ()> &advance,
+                                    const std::function<void ()> &finish)
+    :
+    state (std::make_unique<State>())
+  {
+    assert (advance);
+
+    state->advance = advance;
+    state->finish  = finish;
+    state->receiver.connect_to_producer (producer);
+  }
+
+
+
+  template <typename OutputType>
+  PullRange<OutputType>::~PullRange ()
+  {
+    // Nothing to do for moved-from objects:
+    if (state == nullptr)
+      return;
+
+    state->receiver.disconnect_and_flush();
+    if (state->finish)
+      state->finish();
+  }
+
+
+
+  template <typename OutputType>
+  typename PullRange<OutputType>::iterator
+  PullRange<OutputType>::begin ()
+  {
+    state->fetch_next_sample ();
+    return iterator (*state);
+  }
+
+
+
+  template <typename OutputType>
+  std::default_sentinel_t
+  PullRange<OutputType>::end () const
+  {
+    return std::default_sentinel;
+  }
+
+
+
+  template <typename OutputType>
+  void
+  PullRange<OutputType>::State::fetch_next_sample ()
+  {
+    std::deque<value_type> &samples = receiver.samples;
+    receiver.receiving_thread = std::this_thread::get_id();
+    while (samples.empty() && (producer_exhausted == false))
+      producer_exhausted = (advance() == false);
+    receiver.receiving_thread = std::thread::id();
+
+    if (samples.empty() == false)
+      {
+        current_sample = std::move(samples.front());
+        samples.pop_front();
+      }
+    else
+      current_sample.reset();
+  }
+
+
+
+  template <typename OutputType>
+  PullRange<OutputType>::iterator::iterator (PullRange::State &range_state)
+    :
+    range_state (&range_state)
+  {}
+
+
+
+  template <typename OutputType>
+  typename PullRange<OutputType>::value_type &
+  PullRange<OutputType>::iterator::operator* () const
+  {
+    assert (range_state->current_sample.has_value());
+    return *range_state->current_sample;
+  }
+
+
+
+  template <typename OutputType>
+  typename PullRange<OutputType>::value_type *
+  PullRange<OutputType>::iterator::operator-> () const
+  {
+    return &**this;
+  }
+
+
+
+  template <typename OutputType>
+  typename PullRange<OutputType>::iterator &
+  PullRange<OutputType>::iterator::operator++ ()
+  {
+    range_state->fetch_next_sample ();
+    return *this;
+  }
+
+
+
+  template <typename OutputType>
+  void
+  PullRange<OutputType>::iterator::operator++ (int)
+  {
+    ++*this;
+  }
+
+
+
+  template <typename OutputType>
+  bool
+  PullRange<OutputType>::iterator::operator== (std::default_sentinel_t) const
+  {
+    return (range_state->current_sample.has_value() == false);
+  }
+}
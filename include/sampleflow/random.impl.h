@@ -0,0 +1,683 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for random number generators ("engines") that can be used
+   * in place of the ones provided by the C++ standard library, along with
+   * functions that help create independent streams of random numbers.
+   *
+   * The sampling algorithms in namespace Producers take the type of the
+   * random number generator they use as a template argument that defaults
+   * to `std::mt19937`. The Mersenne twister has a very long period and good
+   * statistical properties, but its state is 2.5 kB large and seeding it
+   * is comparatively expensive. This matters if one runs many chains at
+   * the same time, each with its own generator (see, for example,
+   * Producers::MetropolisHastings::sample_chains()). The generators in this
+   * namespace have a state of only a few dozen bytes, and, more
+   * importantly, offer a cheap and well-defined way to create many
+   * non-overlapping streams of random numbers from one seed: Their
+   * constructors take, in addition to the seed, the number of the stream.
+   * The function create_stream() uses this constructor if it is available,
+   * and falls back to `std::seed_seq` for other generators.
+   */
+  namespace Random
+  {
+    /**
+     * An implementation of the "xoshiro256++" random number generator of
+     * David Blackman and Sebastiano Vigna, see
+     * https://prng.di.unimi.it/ . It produces 64-bit random numbers, has a
+     * state of 256 bits, and a period of $2^{256}-1$. The seed is expanded
+     * into the state using the "SplitMix64" generator, as recommended by
+     * the authors.
+     *
+     * The generator has a jump() function that advances the state by
+     * $2^{128}$ steps at the cost of generating a few hundred numbers. The
+     * constructor uses it to create non-overlapping streams of random
+     * numbers: The stream with number $s$ starts $s\cdot 2^{128}$ steps
+     * after the first number generated for the given seed.
+     *
+     * The class satisfies the requirements of the
+     * `std::uniform_random_bit_generator` concept, and can consequently be
+     * used with the random number distributions of the C++ standard library.
+     */
+    class Xoshiro256PlusPlus
+    {
+      public:
+        /**
+         * The type of the random numbers produced by this generator.
+         */
+        using result_type = std::uint64_t;
+
+        /**
+         * The seed used by the default constructor.
+         */
+        static constexpr std::uint64_t default_seed = 0;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] seed The seed from which the state of the generator
+         *   is computed.
+         * @param[in] stream The number of the stream of random numbers
+         *   this object should produce. Different streams for the same
+         *   seed do not overlap unless one draws more than $2^{128}$
+         *   numbers from one of them. Creating stream $s$ requires $s$
+         *   calls to jump().
+         */
+        explicit
+        Xoshiro256PlusPlus (const std::uint64_t seed = default_seed,
+                            const std::uint64_t stream = 0);
+
+        /**
+         * Re-initialize the state of the generator from the given seed, in
+         * the same way as the constructor when called with stream zero.
+         */
+        void
+        seed (const std::uint64_t seed = default_seed);
+
+        /**
+         * Return the next random number.
+         */
+        result_type
+        operator() ();
+
+        /**
+         * Advance the generator by the given number of steps.
+         */
+        void
+        discard (unsigned long long z);
+
+        /**
+         * Advance the generator by $2^{128}$ steps.
+         */
+        void
+        jump ();
+
+        /**
+         * Return the smallest number this generator can return.
+         */
+        static constexpr result_type
+        min ()
+        {
+          return 0;
+        }
+
+        /**
+         * Return the largest number this generator can return.
+         */
+        static constexpr result_type
+        max ()
+        {
+          return std::numeric_limits<result_type>::max();
+        }
+
+        /**
+         * Compare two generators. They are equal if they will produce the
+         * same sequence of numbers.
+         */
+        bool
+        operator== (const Xoshiro256PlusPlus &other) const = default;
+
+      private:
+        /**
+         * The state of the generator.
+         */
+        std::array<std::uint64_t,4> state;
+    };
+
+
+
+    /**
+     * An implementation of the "Philox4x32-10" counter-based random number
+     * generator of John Salmon, Mark Moraes, Ron Dror, and David Shaw
+     * ("Parallel random numbers: As easy as 1, 2, 3", Proceedings of SC'11).
+     * Rather than updating a state every time a number is drawn, a
+     * counter-based generator computes its numbers by applying a bijection
+     * ("encryption") that depends on a key to a counter that is simply
+     * incremented. Each value of the 128-bit counter yields four 32-bit
+     * random numbers.
+     *
+     * The key of this class is given by the seed. The counter is split
+     * into two 64-bit halves: The upper half is the stream number passed
+     * to the constructor, and the lower half the index of the block of four
+     * numbers within that stream. Each of the $2^{64}$ streams for a given
+     * seed therefore has a length of $2^{66}$ numbers, and streams never
+     * overlap. Creating a stream, and jumping ahead within it using
+     * discard(), only costs a few operations.
+     *
+     * The class satisfies the requirements of the
+     * `std::uniform_random_bit_generator` concept, and can consequently be
+     * used with the random number distributions of the C++ standard library.
+     */
+    class Philox4x32
+    {
+      public:
+        /**
+         * The type of the random numbers produced by this generator.
+         */
+        using result_type = std::uint32_t;
+
+        /**
+         * The seed used by the default constructor.
+         */
+        static constexpr std::uint64_t default_seed = 0;
+
+        /**
+         * Constructor.
+         *
+         * @param[in] seed The seed of the generator, which is used as the
+         *   key of the Philox bijection.
+         * @param[in] stream The number of the stream of random numbers
+         *   this object should produce.
+         */
+        explicit
+        Philox4x32 (const std::uint64_t seed = default_seed,
+                    const std::uint64_t stream = 0);
+
+        /**
+         * Re-initialize the generator with the given seed, in the same way
+         * as the constructor when called with stream zero.
+         */
+        void
+        seed (const std::uint64_t seed = default_seed);
+
+        /**
+         * Return the next random number.
+         */
+        result_type
+        operator() ();
+
+        /**
+         * Advance the generator by the given number of steps. This
+         * function only needs a constant number of operations, regardless
+         * of the number of steps.
+         */
+        void
+        discard (unsigned long long z);
+
+        /**
+         * Return the smallest number this generator can return.
+         */
+        static constexpr result_type
+        min ()
+        {
+          return 0;
+        }
+
+        /**
+         * Return the largest number this generator can return.
+         */
+        static constexpr result_type
+        max ()
+        {
+          return std::numeric_limits<result_type>::max();
+        }
+
+        /**
+         * Compare two generators. They are equal if they will produce the
+         * same sequence of numbers.
+         */
+        bool
+        operator== (const Philox4x32 &other) const;
+
+        /**
+         * Apply the Philox4x32-10 bijection with the given key to the given
+         * counter, and return the four resulting random numbers.
+         */
+        static
+        std::array<std::uint32_t,4>
+        encrypt (std::array<std::uint32_t,4> counter,
+                 std::array<std::uint32_t,2> key);
+
+      private:
+        /**
+         * The key, i.e., the seed split into two 32-bit words.
+         */
+        std::array<std::uint32_t,2> key;
+
+        /**
+         * The stream number that forms the upper half of the counter.
+         */
+        std::uint64_t stream;
+
+        /**
+         * The index of the next block of four numbers to be computed,
+         * which forms the lower half of the counter.
+         */
+        std::uint64_t next_block;
+
+        /**
+         * The four numbers of the block that was computed last, and the
+         * index of the next one of these to be returned. If this index
+         * equals four, then all numbers of the block have been used.
+         */
+        std::array<std::uint32_t,4> block;
+        unsigned int                position_in_block;
+
+        /**
+         * Compute the block of four numbers with index `next_block`, and
+         * increment that index.
+         */
+        void
+        compute_next_block ();
+    };
+
+
+
+    /**
+     * Create a random number generator of type `RandomNumberGenerator` that
+     * produces the stream of random numbers with number `stream` for the
+     * given seed. This function is used by the sampling algorithms in
+     * namespace Producers that need several independent generators, for
+     * example one per chain.
+     *
+     * If the generator can be constructed from a seed and a stream number,
+     * as the ones in this namespace, then this constructor is used.
+     * Otherwise, the generator is initialized with a `std::seed_seq` object
+     * built from the lower 32 bits of the seed and of the stream number,
+     * followed by the upper 32 bits of each if they are nonzero.
+     */
+    template <typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    RandomNumberGenerator
+    create_stream (const std::uint64_t seed,
+                   const std::uint64_t stream);
+
+
+
+    /**
+     * Fill the given array with independent, standard normally distributed
+     * random numbers drawn using the given generator.
+     *
+     * Unlike `std::normal_distribution`, which produces one number per
+     * call and, in common implementations, uses a rejection method whose
+     * branches do not vectorize, this function produces numbers in blocks:
+     * It first fills an array of uniformly distributed numbers from the
+     * bits of the generator, and then transforms pairs of them into pairs
+     * of normally distributed numbers with the Box-Muller transform, in
+     * loops without branches that compilers can vectorize (including the
+     * calls to `std::log`, `std::cos`, and `std::sin`, if a vector math
+     * library such as glibc's libmvec is available and math functions are
+     * allowed not to set `errno`, e.g., with `-fno-math-errno`). This makes
+     * filling a vector with many normally distributed numbers, as
+     * Gaussian proposal distributions in high dimensions need to do, several
+     * times faster than calling `std::normal_distribution` for each element.
+     *
+     * The numbers produced only depend on the state of the generator, and
+     * calling the function with the same generator state always yields the
+     * same numbers, on every platform on which the math functions return
+     * the same results. They are of course different from the ones
+     * `std::normal_distribution` would produce.
+     */
+    template <typename Number, typename RandomNumberGenerator>
+    requires (std::floating_point<Number> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    fill_normal (std::span<Number>      values,
+                 RandomNumberGenerator &rng);
+
+
+
+    namespace internal
+    {
+      /**
+       * Rotate the bits of a 64-bit number to the left.
+       */
+      inline
+      std::uint64_t
+      rotate_left (const std::uint64_t x, const int k)
+      {
+        return (x << k) | (x >> (64 - k));
+      }
+
+
+
+      /**
+       * Return the next number of the SplitMix64 generator, and update its
+       * state.
+       */
+      inline
+      std::uint64_t
+      splitmix64 (std::uint64_t &state)
+      {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+      }
+    }
+
+
+
+    inline
+    Xoshiro256PlusPlus::Xoshiro256PlusPlus (const std::uint64_t seed,
+                                            const std::uint64_t stream)
+    {
+      this->seed (seed);
+      for (std::uint64_t s=0; s<stream; ++s)
+        jump();
+    }
+
+
+
+    inline
+    void
+    Xoshiro256PlusPlus::seed (const std::uint64_t seed)
+    {
+      std::uint64_t splitmix_state = seed;
+      for (std::uint64_t &s : state)
+        s = internal::splitmix64 (splitmix_state);
+    }
+
+
+
+    inline
+    Xoshiro256PlusPlus::result_type
+    Xoshiro256PlusPlus::operator() ()
+    {
+      const std::uint64_t result
+        = internal::rotate_left (state[0] + state[3], 23) + state[0];
+      const std::uint64_t t = state[1] << 17;
+
+      state[2] ^= state[0];
+      state[3] ^= state[1];
+      state[1] ^= state[2];
+      state[0] ^= state[3];
+      state[2] ^= t;
+      state[3] = internal::rotate_left (state[3], 45);
+
+      return result;
+    }
+
+
+
+    inline
+    void
+    Xoshiro256PlusPlus::discard (unsigned long long z)
+    {
+      for (; z>0; --z)
+        (*this)();
+    }
+
+
+
+    inline
+    void
+    Xoshiro256PlusPlus::jump ()
+    {
+      constexpr std::uint64_t jump_polynomial[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                                    0xa9582618e03fc9aa, 0x39abdc4529b1661c
+                                                  };
+
+      std::array<std::uint64_t,4> new_state = {{0, 0, 0, 0}};
+      for (const std::uint64_t word : jump_polynomial)
+        for (int bit=0; bit<64; ++bit)
+          {
+            if (word & (std::uint64_t(1) << bit))
+              for (unsigned int i=0; i<4; ++i)
+                new_state[i] ^= state[i];
+            (*this)();
+          }
+      state = new_state;
+    }
+
+
+
+    inline
+    Philox4x32::Philox4x32 (const std::uint64_t seed,
+                            const std::uint64_t stream)
+      :
+      stream (stream)
+    {
+      this->seed (seed);
+    }
+
+
+
+    inline
+    void
+    Philox4x32::seed (const std::uint64_t seed)
+    {
+      key = {{ static_cast<std::uint32_t>(seed),
+               static_cast<std::uint32_t>(seed >> 32)
+             }
+            };
+      next_block = 0;
+      position_in_block = 4;
+    }
+
+
+
+    inline
+    Philox4x32::result_type
+    Philox4x32::operator() ()
+    {
+      if (position_in_block == 4)
+        compute_next_block ();
+      return block[position_in_block++];
+    }
+
+
+
+    inline
+    void
+    Philox4x32::discard (unsigned long long z)
+    {
+      // First use up what is left of the current block. If that is not
+      // enough, skip over as many whole blocks as necessary, and compute
+      // the block in which the generator ends up if it is partially used.
+      if (z <= 4-position_in_block)
+        position_in_block += z;
+      else
+        {
+          z -= 4-position_in_block;
+          next_block += z / 4;
+          if (z % 4 != 0)
+            {
+              compute_next_block ();
+              position_in_block = z % 4;
+            }
+          else
+            position_in_block = 4;
+        }
+    }
+
+
+
+    inline
+    bool
+    Philox4x32::operator== (const Philox4x32 &other) const
+    {
+      // The numbers stored in 'block' are unused if the block has been
+      // used up, and otherwise follow from the remaining members.
+      return ((key == other.key) &&
+              (stream == other.stream) &&
+              (next_block == other.next_block) &&
+              (position_in_block == other.position_in_block));
+    }
+
+
+
+    inline
+    std::array<std::uint32_t,4>
+    Philox4x32::encrypt (std::array<std::uint32_t,4> counter,
+                         std::array<std::uint32_t,2> key)
+    {
+      constexpr std::uint64_t multiplier_0 = 0xD2511F53;
+      constexpr std::uint64_t multiplier_1 = 0xCD9E8D57;
+      constexpr std::uint32_t key_increment_0 = 0x9E3779B9;
+      constexpr std::uint32_t key_increment_1 = 0xBB67AE85;
+
+      for (unsigned int round=0; round<10; ++round)
+        {
+          if (round > 0)
+            {
+              key[0] += key_increment_0;
+              key[1] += key_increment_1;
+            }
+
+          const std::uint64_t product_0 = multiplier_0 * counter[0];
+          const std::uint64_t product_1 = multiplier_1 * counter[2];
+
+          counter = {{ static_cast<std::uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<std::uint32_t>(product_1),
+                       static_cast<std::uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<std::uint32_t>(product_0)
+                     }
+                    };
+        }
+
+      return counter;
+    }
+
+
+
+    inline
+    void
+    Philox4x32::compute_next_block ()
+    {
+      block = encrypt ({{ static_cast<std::uint32_t>(next_block),
+                          static_cast<std::uint32_t>(next_block >> 32),
+                          static_cast<std::uint32_t>(stream),
+                          static_cast<std::uint32_t>(stream >> 32)
+                        }
+                       },
+                       key);
+      ++next_block;
+      position_in_block = 0;
+    }
+
+
+
+    template <typename RandomNumberGenerator>
+    requires (std::uniform_random_bit_generator<RandomNumberGenerator>)
+    RandomNumberGenerator
+    create_stream (const std::uint64_t seed,
+                   const std::uint64_t stream)
+    {
+      if constexpr (std::constructible_from<RandomNumberGenerator, std::uint64_t, std::uint64_t>)
+        return RandomNumberGenerator (seed, stream);
+      else
+        {
+          std::vector<std::uint32_t> seed_words = { static_cast<std::uint32_t>(seed),
+                                                    static_cast<std::uint32_t>(stream)
+                                                  };
+          if ((seed >> 32) != 0)
+            seed_words.push_back (static_cast<std::uint32_t>(seed >> 32));
+          if ((stream >> 32) != 0)
+            seed_words.push_back (static_cast<std::uint32_t>(stream >> 32));
+
+          std::seed_seq seeds (seed_words.begin(), seed_words.end());
+          return RandomNumberGenerator (seeds);
+        }
+    }
+
+
+
+    namespace internal
+    {
+      /**
+       * Return a random number that is uniformly distributed in the
+       * interval $(0,1]$, computed from 53 random bits drawn from the
+       * given generator.
+       */
+      template <typename RandomNumberGenerator>
+      double
+      uniform_open_closed (RandomNumberGenerator &rng)
+      {
+        using result_type = typename RandomNumberGenerator::result_type;
+        constexpr result_type range = RandomNumberGenerator::max() - RandomNumberGenerator::min();
+
+        std::uint64_t bits;
+        if constexpr (range == std::numeric_limits<std::uint64_t>::max())
+          bits = static_cast<std::uint64_t>(rng() - RandomNumberGenerator::min()) >> 11;
+        else if constexpr (range == std::numeric_limits<std::uint32_t>::max())
+          {
+            const std::uint64_t high = rng() - RandomNumberGenerator::min();
+            const std::uint64_t low  = rng() - RandomNumberGenerator::min();
+            bits = ((high << 32) | low) >> 11;
+          }
+        else
+          return 1. - std::generate_canonical<double,53> (rng);
+
+        return (bits + 1) * 0x1.0p-53;
+      }
+    }
+
+
+
+    template <typename Number, typename RandomNumberGenerator>
+    requires (std::floating_point<Number> &&
+              std::uniform_random_bit_generator<RandomNumberGenerator>)
+    void
+    fill_normal (std::span<Number>      values,
+                 RandomNumberGenerator &rng)
+    {
+      // Work on blocks of pairs of numbers that are small enough to stay
+      // in registers or the L1 cache:
+      constexpr std::size_t block_size = 32;
+      constexpr double two_pi = 6.283185307179586476925286766559;
+
+      double radius[block_size];
+      double angle[block_size];
+
+      std::size_t position = 0;
+      while (position < values.size())
+        {
+          const std::size_t n_pairs
+            = std::min (block_size, (values.size() - position + 1) / 2);
+
+          // Drawing the random bits is inherently sequential:
+          for (std::size_t i=0; i<n_pairs; ++i)
+            {
+              radius[i] = internal::uniform_open_closed (rng);
+              angle[i]  = internal::uniform_open_closed (rng);
+            }
+
+          // The transformations are not:
+          for (std::size_t i=0; i<n_pairs; ++i)
+            {
+              radius[i] = std::sqrt (-2. * std::log (radius[i]));
+              angle[i] *= two_pi;
+            }
+
+          if (position + 2*n_pairs <= values.size())
+            {
+              Number *const block = values.data() + position;
+              for (std::size_t i=0; i<n_pairs; ++i)
+                {
+                  block[2*i]   = radius[i] * std::cos (angle[i]);
+                  block[2*i+1] = radius[i] * std::sin (angle[i]);
+                }
+            }
+          else
+            {
+              // The last block, with an odd number of values left. Drop
+              // the last number of the last pair:
+              for (std::size_t i=0; i<n_pairs-1; ++i)
+                {
+                  values[position + 2*i]   = radius[i] * std::cos (angle[i]);
+                  values[position + 2*i+1] = radius[i] * std::sin (angle[i]);
+                }
+              values[position + 2*(n_pairs-1)] = radius[n_pairs-1] * std::cos (angle[n_pairs-1]);
+            }
+
+          position += 2*n_pairs;
+        }
+    }
+  }
+}
@@ -0,0 +1,226 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the functions that control whether parallel
+   * computations produce bitwise identical results from run to run.
+   *
+   * Sampling algorithms that run several chains in parallel (for example,
+   * Producers::MetropolisHastings::sample_chains()) already produce the
+   * same samples for each chain in every run, since each chain draws from
+   * its own stream of random numbers (see Random::create_stream()), and
+   * number each chain in the same way (see AuxiliaryData::chain_number).
+   * What differs from run to run is the order in which the samples of
+   * different chains reach the consumers. Consumers such as
+   * Consumers::MeanValue or Consumers::CovarianceMatrix do not depend on
+   * this order mathematically, but floating point arithmetic is not
+   * associative, and so their results differ in the last few bits: They
+   * accumulate their state in a ShardedAccumulator, and which samples end
+   * up in which shard depends on which thread happened to process them.
+   *
+   * In deterministic mode, enabled via set_deterministic(), a
+   * ShardedAccumulator instead keeps one shard per "stream" of samples,
+   * and merges these shards in the order of the stream numbers. The
+   * stream a sample belongs to is its chain number, if it has one, and
+   * zero otherwise; the Consumer base class sets it (via StreamScope)
+   * while a sample is being processed. Since the samples of each chain
+   * are sent, and processed, in the order in which the chain produces them
+   * -- also in ParallelMode::asynchronous and
+   * ParallelMode::dedicated_thread, which process the samples of a
+   * consumer one at a time in the order in which they arrive -- each shard
+   * then sees the same samples in the same order in every run, and the
+   * merged result is bitwise reproducible regardless of the number of
+   * threads and of how the chains were scheduled.
+   *
+   * The cost of this mode is that updating a ShardedAccumulator requires
+   * looking up the shard of the current stream in a map protected by a
+   * reader-writer lock, and that merging touches one shard per chain
+   * rather than one per thread.
+   *
+   * This mode does not help consumers whose results depend on the order
+   * of all samples they receive, rather than just the order within each
+   * chain (for example, Consumers::AutoCovarianceMatrix when fed by several
+   * chains), nor producers whose chains interact through shared random
+   * number generators that are not created via Random::create_stream().
+   */
+  namespace Reproducibility
+  {
+    /**
+     * Enable or disable deterministic mode. This should be done before any
+     * samples are sent through a pipeline, and not changed while sampling
+     * is under way.
+     */
+    void
+    set_deterministic (const bool deterministic);
+
+    /**
+     * Return whether deterministic mode is enabled. It is disabled by
+     * default.
+     */
+    bool
+    is_deterministic ();
+
+    /**
+     * Return the number of the stream the sample currently being processed
+     * on this thread belongs to, as set by the innermost StreamScope object
+     * that is alive on this thread, or zero if there is none.
+     */
+    std::size_t
+    current_stream ();
+
+
+    /**
+     * A class whose objects set the number returned by current_stream()
+     * for as long as they live, and restore the previous one when they are
+     * destroyed. Objects of this class only do something if deterministic
+     * mode is enabled.
+     */
+    class StreamScope
+    {
+      public:
+        /**
+         * Constructor. Set the current stream to the chain number stored in
+         * the given auxiliary data, or to zero if there is none.
+         */
+        explicit
+        StreamScope (const AuxiliaryData &aux_data);
+
+        /**
+         * Constructor. Set the current stream to the chain number of the
+         * first of the given samples, i.e., treat all samples of a batch as
+         * belonging to the same stream.
+         */
+        explicit
+        StreamScope (const std::vector<AuxiliaryData> &aux_data);
+
+        /**
+         * Destructor. Restores the stream that was current before.
+         */
+        ~StreamScope ();
+
+        StreamScope (const StreamScope &) = delete;
+        StreamScope &operator= (const StreamScope &) = delete;
+
+      private:
+        /**
+         * Whether this object changed the current stream, and what the
+         * stream was before.
+         */
+        bool        active;
+        std::size_t previous_stream;
+    };
+
+
+
+    namespace internal
+    {
+      inline
+      std::atomic<bool> &
+      deterministic ()
+      {
+        static std::atomic<bool> flag (false);
+        return flag;
+      }
+
+
+      inline
+      std::size_t &
+      stream ()
+      {
+        thread_local std::size_t s = 0;
+        return s;
+      }
+
+
+      inline
+      std::size_t
+      stream_of (const AuxiliaryData &aux_data)
+      {
+        const std::size_t *chain = aux_data.get_if<std::size_t> (AuxiliaryData::chain_number);
+        return (chain != nullptr ? *chain : 0);
+      }
+    }
+
+
+
+    inline
+    void
+    set_deterministic (const bool deterministic)
+    {
+      internal::deterministic().store (deterministic);
+    }
+
+
+
+    inline
+    bool
+    is_deterministic ()
+    {
+      return internal::deterministic().load (std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    std::size_t
+    current_stream ()
+    {
+      return internal::stream();
+    }
+
+
+
+    inline
+    StreamScope::StreamScope (const AuxiliaryData &aux_data)
+      :
+      active (is_deterministic()),
+      previous_stream (0)
+    {
+      if (active)
+        {
+          previous_stream = internal::stream();
+          internal::stream() = internal::stream_of (aux_data);
+        }
+    }
+
+
+
+    inline
+    StreamScope::StreamScope (const std::vector<AuxiliaryData> &aux_data)
+      :
+      active (is_deterministic()),
+      previous_stream (0)
+    {
+      if (active)
+        {
+          previous_stream = internal::stream();
+          internal::stream() = (aux_data.size() > 0 ?
+                                internal::stream_of (aux_data[0]) :
+                                0);
+        }
+    }
+
+
+
+    inline
+    StreamScope::~StreamScope ()
+    {
+      if (active)
+        internal::stream() = previous_stream;
+    }
+  }
+}
@@ -0,0 +1,304 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores the most recent elements of a sequence of objects
+   * of type `T`, up to a fixed maximal number of them. Adding an element
+   * to a buffer that is already full overwrites the oldest element. The
+   * memory for the elements is allocated once, when the buffer is
+   * created, and elements that are overwritten are assigned to rather
+   * than destroyed and re-created; if `T` is a type such as
+   * `std::vector<double>` or `Eigen::VectorXd` whose copy assignment
+   * operator reuses the memory of the object assigned to, then a full
+   * buffer does not allocate any memory at all when new elements are
+   * added.
+   *
+   * Elements are accessed via operator[], with index zero corresponding
+   * to the oldest element still stored and index size()-1 to the most
+   * recently added one.
+   *
+   * In contrast to the BoundedQueue class, this class is not thread-safe:
+   * If several threads access the same object, the caller needs to
+   * provide the necessary synchronization.
+   *
+   * Objects of this class can be copied and assigned, and can be written
+   * to and read from a buffer using the functions in namespace
+   * Serialization, so that they can be part of the state of a consumer.
+   *
+   * @tparam T The type of the objects stored in the buffer. This type
+   *   needs to be copy-constructible and copy-assignable.
+   */
+  template <typename T>
+  class RingBuffer
+  {
+    public:
+      /**
+       * Default constructor. The resulting object has capacity zero,
+       * and elements can not be added to it. It is only useful as a
+       * placeholder to which another object is later assigned.
+       */
+      RingBuffer ();
+
+      /**
+       * Constructor.
+       *
+       * @param[in] capacity The maximal number of elements the buffer
+       *   stores. Must be at least one.
+       */
+      RingBuffer (const std::size_t capacity);
+
+      /**
+       * Return the maximal number of elements the buffer can hold.
+       */
+      std::size_t
+      capacity () const;
+
+      /**
+       * Return the number of elements currently stored in the buffer.
+       * This number grows with every call to push_back() until it reaches
+       * capacity(), and then stays there.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Return whether the buffer is empty.
+       */
+      bool
+      empty () const;
+
+      /**
+       * Return whether the buffer is full, i.e., whether the next call to
+       * push_back() will overwrite the oldest element.
+       */
+      bool
+      full () const;
+
+      /**
+       * Add an element to the buffer. If the buffer is full, this replaces
+       * the oldest element.
+       */
+      void
+      push_back (const T &element);
+
+      /**
+       * Return a reference to the `index`th oldest element stored in the
+       * buffer. `index` needs to be less than size().
+       */
+      const T &
+      operator[] (const std::size_t index) const;
+
+      /**
+       * Return a reference to the most recently added element. The buffer
+       * must not be empty.
+       */
+      const T &
+      back () const;
+
+      /**
+       * Remove all elements from the buffer. The memory of the elements is
+       * retained, but only reused once the buffer has been filled again
+       * with capacity() elements.
+       */
+      void
+      clear ();
+
+      /**
+       * Append the capacity of the buffer and the elements currently
+       * stored, from oldest to newest, to the given buffer.
+       */
+      void
+      save (std::vector<char> &buffer) const;
+
+      /**
+       * Replace the current object by the one previously written by
+       * save(), read from the front of the given buffer. The buffer is
+       * advanced past the data read.
+       */
+      void
+      load (std::span<const char> &buffer);
+
+    private:
+      /**
+       * The maximal number of elements.
+       */
+      std::size_t max_n_elements;
+
+      /**
+       * The storage for the elements. Until the buffer is full for the
+       * first time, elements are simply appended; after that, this array
+       * always has max_n_elements elements, and new elements overwrite
+       * existing ones.
+       */
+      std::vector<T> elements;
+
+      /**
+       * The number of elements currently stored in the buffer, and the
+       * position in the `elements` array of the oldest one.
+       */
+      std::size_t n_elements;
+      std::size_t first;
+  };
+
+
+
+  template <typename T>
+  RingBuffer<T>::RingBuffer ()
+    :
+    max_n_elements (0),
+    n_elements (0),
+    first (0)
+  {}
+
+
+
+  template <typename T>
+  RingBuffer<T>::RingBuffer (const std::size_t capacity)
+    :
+    max_n_elements (capacity),
+    n_elements (0),
+    first (0)
+  {
+    assert (capacity >= 1);
+    elements.reserve (capacity);
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  RingBuffer<T>::capacity () const
+  {
+    return max_n_elements;
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  RingBuffer<T>::size () const
+  {
+    return n_elements;
+  }
+
+
+
+  template <typename T>
+  bool
+  RingBuffer<T>::empty () const
+  {
+    return (n_elements == 0);
+  }
+
+
+
+  template <typename T>
+  bool
+  RingBuffer<T>::full () const
+  {
+    return (n_elements == max_n_elements);
+  }
+
+
+
+  template <typename T>
+  void
+  RingBuffer<T>::push_back (const T &element)
+  {
+    assert (max_n_elements > 0);
+
+    if (n_elements < max_n_elements)
+      {
+        // There is still space. If we have used the slot before (because
+        // the buffer was cleared), reuse it; otherwise create it.
+        const std::size_t position = (first + n_elements) % max_n_elements;
+        if (position < elements.size())
+          elements[position] = element;
+        else
+          elements.push_back (element);
+        ++n_elements;
+      }
+    else
+      {
+        // Overwrite the oldest element, which then becomes the newest:
+        elements[first] = element;
+        first = (first + 1) % max_n_elements;
+      }
+  }
+
+
+
+  template <typename T>
+  const T &
+  RingBuffer<T>::operator[] (const std::size_t index) const
+  {
+    assert (index < n_elements);
+    return elements[(first + index) % max_n_elements];
+  }
+
+
+
+  template <typename T>
+  const T &
+  RingBuffer<T>::back () const
+  {
+    assert (n_elements > 0);
+    return (*this)[n_elements-1];
+  }
+
+
+
+  template <typename T>
+  void
+  RingBuffer<T>::clear ()
+  {
+    n_elements = 0;
+    first      = 0;
+  }
+
+
+
+  template <typename T>
+  void
+  RingBuffer<T>::save (std::vector<char> &buffer) const
+  {
+    Serialization::write (buffer, std::uint64_t(max_n_elements));
+    Serialization::write (buffer, std::uint64_t(n_elements));
+    for (std::size_t i=0; i<n_elements; ++i)
+      Serialization::write (buffer, (*this)[i]);
+  }
+
+
+
+  template <typename T>
+  void
+  RingBuffer<T>::load (std::span<const char> &buffer)
+  {
+    std::uint64_t capacity, size;
+    Serialization::read (buffer, capacity);
+    Serialization::read (buffer, size);
+    assert (size <= capacity);
+
+    *this = RingBuffer (capacity);
+    for (std::uint64_t i=0; i<size; ++i)
+      {
+        T element;
+        Serialization::read (buffer, element);
+        push_back (element);
+      }
+  }
+}
@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A function object that computes a hash value for a sample, as needed
+   * by classes such as LikelihoodCache, Consumers::CategoricalHistogram,
+   * and Consumers::StateCounts that store samples in hash tables. If
+   * `std::hash<SampleType>` exists, it is used. Otherwise, the sample is
+   * treated as a collection of elements -- for example a `std::vector<int>`
+   * or an `Eigen::VectorXd` -- and the hash values of the elements are
+   * combined. If the elements are stored contiguously (see
+   * Concepts::has_contiguous_scalar_storage), they are read directly from
+   * memory; otherwise, they are accessed via Utilities::size() and
+   * Utilities::get_nth_element().
+   */
+  template <typename SampleType>
+  struct SampleHash
+  {
+    std::size_t
+    operator() (const SampleType &sample) const;
+  };
+
+
+
+  /**
+   * A function object that determines whether two samples are equal, for
+   * use together with SampleHash in hash tables. If the elements of the
+   * samples are stored contiguously (see
+   * Concepts::has_contiguous_scalar_storage), the samples are equal if they
+   * have the same number of elements and these compare equal; this also
+   * works for types such as `std::valarray<int>` whose `operator==`
+   * compares elementwise and does not return a `bool`, and for samples of
+   * different sizes, which Eigen's `operator==` does not allow.
+   * Otherwise, `operator==` is used.
+   */
+  template <typename SampleType>
+  struct SampleEqual
+  {
+    bool
+    operator() (const SampleType &a,
+                const SampleType &b) const;
+  };
+
+
+
+  template <typename SampleType>
+  std::size_t
+  SampleHash<SampleType>::operator() (const SampleType &sample) const
+  {
+    // Combine the hash values of the elements in the same way as
+    // boost::hash_combine does:
+    const auto combine = [](std::size_t &hash, const std::size_t element_hash)
+    {
+      hash ^= element_hash + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+
+    if constexpr (requires { std::hash<SampleType>()(sample); })
+      return std::hash<SampleType>()(sample);
+    else if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+      {
+        const auto elements = Utilities::as_span (sample);
+        using ElementType = typename decltype(elements)::value_type;
+
+        std::size_t hash = elements.size();
+        for (const ElementType &element : elements)
+          combine (hash, std::hash<ElementType>()(element));
+        return hash;
+      }
+    else
+      {
+        using ElementType = decltype(Utilities::get_nth_element(sample, 0));
+
+        std::size_t hash = Utilities::size(sample);
+        for (std::size_t i=0; i<static_cast<std::size_t>(Utilities::size(sample)); ++i)
+          combine (hash, std::hash<ElementType>()(Utilities::get_nth_element(sample, i)));
+        return hash;
+      }
+  }
+
+
+
+  template <typename SampleType>
+  bool
+  SampleEqual<SampleType>::operator() (const SampleType &a,
+                                       const SampleType &b) const
+  {
+    if constexpr (Concepts::has_contiguous_scalar_storage<SampleType>)
+      {
+        const auto a_elements = Utilities::as_span (a);
+        const auto b_elements = Utilities::as_span (b);
+        return std::equal (a_elements.begin(), a_elements.end(),
+                           b_elements.begin(), b_elements.end());
+      }
+    else
+      return (a == b);
+  }
+}
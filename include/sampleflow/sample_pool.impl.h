@@ -0,0 +1,192 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A class that keeps objects of type `T` that are no longer needed so
+   * that they can be re-used later, rather than destroying them and
+   * creating new ones. This is useful for sample types such as
+   * `Eigen::VectorXd` or `std::valarray<double>` that store their data on
+   * the heap: Creating and destroying such objects requires allocating
+   * and freeing memory, whereas re-using an object of the right size and
+   * overwriting its elements does not.
+   *
+   * Producers use this class for the samples they only need temporarily
+   * while computing a step of the chain, such as the trial samples of the
+   * delayed rejection stages in Producers::DelayedRejectionMetropolisHastings.
+   * A producer obtains an object via acquire(), lets a proposal function
+   * overwrite its elements, and then returns it via release() once it no
+   * longer needs it -- either the trial sample itself, if it was rejected,
+   * or the previous current sample, if the trial sample was accepted and
+   * took its place. Over the course of a chain, the producer then only
+   * ever allocates as many objects as it needs at the same time.
+   *
+   * The objects are kept as they are returned, i.e., acquire() returns an
+   * object whose value is whatever it had when it was released. The
+   * class does not know how to give an object a particular size, and so
+   * acquire() takes a prototype object that it copies if there is no
+   * object available to re-use.
+   *
+   * All member functions can be called concurrently from different
+   * threads.
+   *
+   * @tparam T The type of the objects stored. It needs to be copy-constructible
+   *   and move-constructible.
+   */
+  template <typename T>
+  class SamplePool
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] max_size The maximal number of objects the pool keeps.
+       *   Objects that are released while the pool is full are destroyed.
+       */
+      SamplePool (const std::size_t max_size = std::numeric_limits<std::size_t>::max());
+
+      /**
+       * Obtain an object. If the pool has an object available, it is
+       * removed from the pool and returned with whatever value it had when
+       * it was released. Otherwise, the function returns a copy of
+       * `prototype`.
+       */
+      T
+      acquire (const T &prototype);
+
+      /**
+       * Return an object to the pool so that a later call to acquire() can
+       * re-use it.
+       */
+      void
+      release (T &&object);
+
+      /**
+       * Return the number of objects currently available for re-use.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Return the number of times acquire() had to make a copy of its
+       * argument because no object was available for re-use. This can be
+       * used to verify that a pipeline's steady state does not create
+       * new objects.
+       */
+      std::size_t
+      n_created () const;
+
+      /**
+       * Destroy all objects currently held by the pool.
+       */
+      void
+      clear ();
+
+    private:
+      /**
+       * The maximal number of objects the pool keeps.
+       */
+      const std::size_t max_size;
+
+      /**
+       * The objects available for re-use.
+       */
+      std::vector<T> objects;
+
+      /**
+       * The number of objects created by acquire().
+       */
+      std::size_t n_objects_created;
+
+      /**
+       * A mutex that guards access to the member variables above.
+       */
+      mutable std::mutex mutex;
+  };
+
+
+
+  template <typename T>
+  SamplePool<T>::SamplePool (const std::size_t max_size)
+    :
+    max_size (max_size),
+    n_objects_created (0)
+  {}
+
+
+
+  template <typename T>
+  T
+  SamplePool<T>::acquire (const T &prototype)
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      if (objects.size() > 0)
+        {
+          T object (std::move(objects.back()));
+          objects.pop_back ();
+          return object;
+        }
+
+      ++n_objects_created;
+    }
+
+    // Copy the prototype outside the lock; this may be expensive.
+    return prototype;
+  }
+
+
+
+  template <typename T>
+  void
+  SamplePool<T>::release (T &&object)
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    if (objects.size() < max_size)
+      objects.emplace_back (std::move(object));
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  SamplePool<T>::size () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    return objects.size();
+  }
+
+
+
+  template <typename T>
+  std::size_t
+  SamplePool<T>::n_created () const
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    return n_objects_created;
+  }
+
+
+
+  template <typename T>
+  void
+  SamplePool<T>::clear ()
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+    objects.clear ();
+  }
+}
@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A structure that describes what a producer knows about the samples it
+   * is about to send downstream, before it sends the first of them: How
+   * many components each sample has, and how many samples to expect.
+   * Producers announce this information via Producer::announce_samples()
+   * at the start of their `sample()` functions, filters pass it on (see
+   * Filter::output_shape()), and consumers receive it through
+   * Consumer::prepare_for_samples(). Consumers that would otherwise
+   * size their data structures when the first sample arrives, or grow
+   * them as samples arrive, can then allocate the memory they need up
+   * front.
+   *
+   * All of the information is a hint: Either part may be unknown, the
+   * number of samples may turn out to be different (for example, if the
+   * producer is asked to stop early, see Producer::request_stop()), and a
+   * consumer may receive several announcements -- for example, one for
+   * each call to a producer's `sample()` function, or one from each of
+   * the producers connected to it. Consumers must therefore continue to
+   * work correctly if they receive samples they have not been told
+   * about.
+   */
+  struct SampleShape
+  {
+    /**
+     * The number of components of each sample, as returned by
+     * Utilities::size(), if known.
+     */
+    std::optional<std::size_t> n_components;
+
+    /**
+     * The number of samples the producer expects to send from now on, if
+     * known. Samples with a repetition count (see
+     * AuxiliaryData::repetition_count) stand for several samples, but are
+     * only counted once here, since this is the number relevant for the
+     * memory needed to store them. Filters that thin out the stream of
+     * samples report the number of samples they will pass on if they know
+     * it, and leave it unknown otherwise, so that consumers do not
+     * allocate memory for samples that never arrive.
+     */
+    std::optional<types::sample_index> n_samples;
+
+    /**
+     * Return a SampleShape object that describes samples with as many
+     * components as the given one, of which there are the given number.
+     */
+    template <typename SampleType>
+    static
+    SampleShape
+    of (const SampleType                         &sample,
+        const std::optional<types::sample_index>  n_samples = {});
+  };
+
+
+
+  template <typename SampleType>
+  SampleShape
+  SampleShape::of (const SampleType                         &sample,
+                   const std::optional<types::sample_index>  n_samples)
+  {
+    return SampleShape
+    {
+      static_cast<std::size_t>(Utilities::size (sample)),
+      n_samples
+    };
+  }
+}
@@ -0,0 +1,170 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace Concepts
+  {
+    /**
+     * A concept that describes sample types that do not own the elements
+     * of a sample, but refer to memory owned by someone else -- typically
+     * a buffer inside the producer that creates the samples. Examples are
+     * `std::span<const double>` and `Eigen::Map<const Eigen::VectorXd>`.
+     * More precisely, the concept is satisfied by
+     * - contiguous, sized ranges that are views whose validity does not
+     *   depend on the view object itself (i.e., "borrowed ranges" in the
+     *   terminology of the C++ standard) and that can be created from a
+     *   pointer and a number of elements, such as `std::span`; and
+     * - Eigen's `Map` classes, i.e., Eigen types that have a `data()`
+     *   function and can be created from a pointer and a number of rows
+     *   and columns, but are not the same as the type Eigen uses to store
+     *   the result of evaluating them (their `PlainObject` type).
+     *
+     * Using such types as the type of samples avoids copying large
+     * samples from one stage of a pipeline to the next, but is only safe
+     * as long as the memory they refer to remains valid while a sample is
+     * being processed. In ParallelMode::synchronous, this is the case as
+     * long as the producer does not overwrite its buffer until the call
+     * that sends the sample downstream has returned. Consumers that
+     * process samples at a later time (in ParallelMode::asynchronous,
+     * ParallelMode::dedicated_thread, or ParallelMode::adaptive) therefore
+     * convert samples of these types into owning objects (see
+     * Utilities::materialize()) before they put them into their queue,
+     * and create a view of these copies when they process them. Consumers
+     * that keep samples beyond the call of their consume() function --
+     * such as Consumers::LastSample or Consumers::ReservoirSample -- can
+     * not be used with view types at all, and need to be connected via a
+     * Filters::Materialize object instead. (Consumers that only copy the
+     * elements of samples into their own storage, such as
+     * Consumers::SampleStore, can be used with view types directly.)
+     */
+    template <typename SampleType>
+    concept is_sample_view
+      = ((std::ranges::view<SampleType>
+          &&
+          std::ranges::borrowed_range<SampleType>
+          &&
+          std::ranges::contiguous_range<SampleType>
+          &&
+          std::ranges::sized_range<SampleType>
+          &&
+          std::constructible_from<SampleType,
+          decltype(std::ranges::data(std::declval<SampleType &>())),
+          std::size_t>)
+         ||
+         requires (const SampleType &sample)
+    {
+      typename SampleType::PlainObject;
+      requires (!std::same_as<SampleType, typename SampleType::PlainObject>);
+      sample.data();
+      sample.rows();
+      sample.cols();
+      requires std::constructible_from<SampleType,
+      decltype(sample.data()),
+      decltype(sample.rows()),
+      decltype(sample.cols())>;
+    });
+
+
+    /**
+     * A concept that describes sample types whose objects own the elements
+     * of a sample, i.e., all types that do not satisfy the
+     * Concepts::is_sample_view concept. Classes that keep samples beyond
+     * the call of their consume() function -- such as
+     * Consumers::LastSample or Consumers::ReservoirSample -- require their
+     * sample type to satisfy this concept. If the samples a producer
+     * creates are of a view type, connect such classes via a
+     * Filters::Materialize object that converts samples into owning
+     * objects first.
+     */
+    template <typename SampleType>
+    concept is_owning_sampletype = !is_sample_view<SampleType>;
+  }
+
+
+
+  namespace Utilities
+  {
+    /**
+     * Return an object that owns a copy of the elements of the given
+     * sample. For view types (see Concepts::is_sample_view), this is a
+     * `std::vector` of the elements of a range such as `std::span`, or the
+     * `PlainObject` type of an Eigen `Map` (e.g., `Eigen::VectorXd` for an
+     * `Eigen::Map<const Eigen::VectorXd>`). For all other types, the
+     * sample is simply forwarded (i.e., copied or moved).
+     */
+    template <typename SampleType>
+    auto
+    materialize (SampleType &&sample)
+    {
+      using Type = std::remove_cvref_t<SampleType>;
+      if constexpr (Concepts::is_sample_view<Type>)
+        {
+          if constexpr (requires { typename Type::PlainObject; })
+            return typename Type::PlainObject (sample);
+          else
+            return std::vector<std::ranges::range_value_t<Type>> (std::ranges::begin(sample),
+                                                                   std::ranges::end(sample));
+        }
+      else
+        return Type (std::forward<SampleType>(sample));
+    }
+  }
+
+
+
+  namespace types
+  {
+    /**
+     * The type of the object Utilities::materialize() returns for a sample
+     * of type `SampleType`: An owning type if `SampleType` is a view type
+     * (see Concepts::is_sample_view), and `SampleType` itself otherwise.
+     */
+    template <typename SampleType>
+    using MaterializedType
+      = decltype(Utilities::materialize (std::declval<SampleType>()));
+  }
+
+
+
+  namespace Utilities
+  {
+    /**
+     * The inverse of materialize(): Return a sample of type `SampleType`
+     * that refers to the elements stored in the given object, if
+     * `SampleType` is a view type, or the object itself (moved) otherwise.
+     * In the former case, the returned view is only valid as long as the
+     * argument lives.
+     */
+    template <typename SampleType>
+    SampleType
+    view_of (types::MaterializedType<SampleType> &materialized_sample)
+    {
+      if constexpr (Concepts::is_sample_view<SampleType>)
+        {
+          if constexpr (requires { typename SampleType::PlainObject; })
+            return SampleType (materialized_sample.data(),
+                               materialized_sample.rows(),
+                               materialized_sample.cols());
+          else
+            return SampleType (std::ranges::data(materialized_sample),
+                               std::ranges::size(materialized_sample));
+        }
+      else
+        return std::move(materialized_sample);
+    }
+  }
+}
@@ -0,0 +1,371 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for functions that convert objects into a compact binary
+   * representation, i.e., a sequence of bytes, and back. This is used,
+   * for example, to write the state of a sampler to a checkpoint from
+   * which sampling can later be resumed (see Checkpointer).
+   *
+   * The functions in this namespace know how to deal with the following
+   * kinds of types, and any combination of them:
+   * - Types that are trivially copyable, such as `double`, `int`,
+   *   `std::complex<double>`, or arrays of such types. They are stored
+   *   as the bytes that make up the object in memory. This includes
+   *   the random number generators of namespace Random and, in common
+   *   implementations of the C++ standard library, the random number
+   *   generators of the standard library, whose state is then saved in
+   *   its entirety.
+   * - Classes that have member functions `void save (std::vector<char> &buffer) const`
+   *   and `void load (std::span<const char> &buffer)`, which are expected
+   *   to call the functions of this namespace for their member variables.
+   * - `std::optional` objects, pairs and tuples, and `std::array` objects
+   *   of non-trivially copyable types.
+   * - Matrix and vector classes such as those of the Eigen library that
+   *   have member functions `rows()`, `cols()`, `data()`, and
+   *   `resize(rows,cols)`.
+   * - Containers such as `std::vector`, `std::valarray`, or `std::string`
+   *   that have a `size()` and a `resize()` function and can be iterated
+   *   over. They are stored as the number of elements followed by the
+   *   elements.
+   *
+   * Because the bytes that make up objects in memory differ between
+   * platforms (and, for some types, between compilers), the binary
+   * representation is not portable: It can only be read on the same kind
+   * of machine and by a program compiled with the same compiler as the
+   * one that wrote it.
+   */
+  namespace Serialization
+  {
+    /**
+     * Append the binary representation of the given object to the end of
+     * the given buffer.
+     */
+    template <typename T>
+    void
+    write (std::vector<char> &buffer,
+           const T &object);
+
+    /**
+     * Read an object from the binary representation at the beginning of
+     * the given buffer, and remove the bytes read from the buffer -- that
+     * is, upon return, `buffer` only refers to the bytes that follow the
+     * representation of the object, from which the next object can then
+     * be read.
+     */
+    template <typename T>
+    void
+    read (std::span<const char> &buffer,
+          T &object);
+
+    /**
+     * Return whether objects of type `T` can be converted by the write()
+     * and read() functions, i.e., whether `T` is one of the kinds of types
+     * listed in the documentation of this namespace. Classes that use the
+     * functions of this namespace for objects of types provided by the
+     * user (such as the samplers, for the samples) can use this function
+     * to only instantiate these calls if the type is supported.
+     */
+    template <typename T>
+    constexpr
+    bool
+    is_serializable ();
+
+
+
+    namespace internal
+    {
+      /**
+       * A concept that describes classes that know how to save themselves
+       * into a buffer and to load themselves from it.
+       */
+      template <typename T>
+      concept has_save_and_load = requires (const T &object,
+                                            T &object_to_load,
+                                            std::vector<char> &buffer,
+                                            std::span<const char> &input)
+      {
+        object.save (buffer);
+        object_to_load.load (input);
+      };
+
+
+      /**
+       * A concept that describes types that are stored as the bytes that
+       * make up the object in memory, i.e., trivially copyable types that
+       * do not provide their own save() and load() functions.
+       */
+      template <typename T>
+      concept is_stored_as_bytes = (std::is_trivially_copyable_v<T>
+                                    &&
+                                    (has_save_and_load<T> == false));
+
+
+      /**
+       * A concept that describes Eigen-like matrices and vectors.
+       */
+      template <typename T>
+      concept is_matrix = requires (const T &object,
+                                    T &object_to_load)
+      {
+        typename T::Scalar;
+        object.rows ();
+        object.cols ();
+        object.data ();
+        object_to_load.resize (object.rows(), object.cols());
+      };
+
+
+      /**
+       * A concept that describes types such as `std::pair`, `std::tuple`,
+       * and `std::array`, whose elements can be accessed via `std::get`.
+       */
+      template <typename T>
+      concept is_tuple_like = requires
+      {
+        std::tuple_size<T>::value;
+      };
+
+
+      /**
+       * A concept that describes containers that can be iterated over.
+       */
+      template <typename T>
+      concept is_container = requires (const T &object)
+      {
+        typename T::value_type;
+        std::size (object);
+        std::begin (object);
+        std::end (object);
+      };
+
+
+      /**
+       * A type trait that tells whether a type is a `std::optional`.
+       */
+      template <typename T>
+      struct is_optional : std::false_type
+      {};
+
+      template <typename T>
+      struct is_optional<std::optional<T>> : std::true_type
+      {};
+
+
+
+      /**
+       * Append the given number of bytes, starting at the given address, to
+       * the buffer.
+       */
+      inline
+      void
+      write_bytes (std::vector<char> &buffer,
+                   const void *data,
+                   const std::size_t n_bytes)
+      {
+        const char *bytes = static_cast<const char *>(data);
+        buffer.insert (buffer.end(), bytes, bytes + n_bytes);
+      }
+
+
+
+      /**
+       * Copy the given number of bytes from the beginning of the buffer to
+       * the given address, and remove them from the buffer.
+       */
+      inline
+      void
+      read_bytes (std::span<const char> &buffer,
+                  void *data,
+                  const std::size_t n_bytes)
+      {
+        assert (buffer.size() >= n_bytes);
+
+        if (n_bytes > 0)
+          std::memcpy (data, buffer.data(), n_bytes);
+        buffer = buffer.subspan (n_bytes);
+      }
+
+
+
+      /**
+       * Return whether all element types of the tuple-like type `T` can be
+       * serialized.
+       */
+      template <typename T, std::size_t... indices>
+      constexpr
+      bool
+      all_elements_are_serializable (std::index_sequence<indices...>)
+      {
+        return (is_serializable<std::tuple_element_t<indices,T>>() && ...);
+      }
+    }
+
+
+
+    template <typename T>
+    constexpr
+    bool
+    is_serializable ()
+    {
+      if constexpr (internal::has_save_and_load<T> || std::is_trivially_copyable_v<T>)
+        return true;
+      else if constexpr (internal::is_optional<T>::value)
+        return is_serializable<typename T::value_type>();
+      else if constexpr (internal::is_matrix<T>)
+        return std::is_trivially_copyable_v<typename T::Scalar>;
+      else if constexpr (internal::is_tuple_like<T>)
+        return internal::all_elements_are_serializable<T>
+               (std::make_index_sequence<std::tuple_size_v<T>>());
+      else if constexpr (internal::is_container<T>)
+        return is_serializable<typename T::value_type>();
+      else
+        return false;
+    }
+
+
+
+    template <typename T>
+    void
+    write (std::vector<char> &buffer,
+           const T &object)
+    {
+      if constexpr (internal::has_save_and_load<T>)
+        object.save (buffer);
+      else if constexpr (std::is_trivially_copyable_v<T>)
+        internal::write_bytes (buffer, &object, sizeof(T));
+      else if constexpr (internal::is_optional<T>::value)
+        {
+          write (buffer, object.has_value());
+          if (object.has_value())
+            write (buffer, *object);
+        }
+      else if constexpr (internal::is_matrix<T>)
+        {
+          static_assert (std::is_trivially_copyable_v<typename T::Scalar>,
+                         "Only matrices of trivially copyable types can be serialized.");
+          write (buffer, std::int64_t(object.rows()));
+          write (buffer, std::int64_t(object.cols()));
+          internal::write_bytes (buffer, object.data(),
+                                 object.rows() * object.cols() * sizeof(typename T::Scalar));
+        }
+      else if constexpr (internal::is_tuple_like<T>)
+        std::apply ([&buffer](const auto &... elements)
+      {
+        (write (buffer, elements), ...);
+      },
+      object);
+      else if constexpr (internal::is_container<T>)
+        {
+          using value_type = typename T::value_type;
+
+          // Store the number of elements, followed by the elements. If the
+          // elements are stored contiguously in memory and are themselves
+          // stored as bytes, copy them all at once:
+          const std::uint64_t n_elements = std::size (object);
+          write (buffer, n_elements);
+          if constexpr (internal::is_stored_as_bytes<value_type>
+                        &&
+                        std::contiguous_iterator<decltype(std::begin(object))>)
+            {
+              if (n_elements > 0)
+                internal::write_bytes (buffer, &*std::begin(object),
+                                       n_elements * sizeof(value_type));
+            }
+          else
+            for (const auto &element : object)
+              write (buffer, element);
+        }
+      else
+        static_assert (std::is_trivially_copyable_v<T>,
+                       "This type is not supported by the serialization functions.");
+    }
+
+
+
+    template <typename T>
+    void
+    read (std::span<const char> &buffer,
+          T &object)
+    {
+      if constexpr (internal::has_save_and_load<T>)
+        object.load (buffer);
+      else if constexpr (std::is_trivially_copyable_v<T>)
+        internal::read_bytes (buffer, &object, sizeof(T));
+      else if constexpr (internal::is_optional<T>::value)
+        {
+          bool has_value;
+          read (buffer, has_value);
+          if (has_value)
+            {
+              typename T::value_type value;
+              read (buffer, value);
+              object = std::move(value);
+            }
+          else
+            object.reset ();
+        }
+      else if constexpr (internal::is_matrix<T>)
+        {
+          std::int64_t n_rows, n_cols;
+          read (buffer, n_rows);
+          read (buffer, n_cols);
+          object.resize (n_rows, n_cols);
+          internal::read_bytes (buffer, object.data(),
+                                n_rows * n_cols * sizeof(typename T::Scalar));
+        }
+      else if constexpr (internal::is_tuple_like<T>)
+        std::apply ([&buffer](auto &... elements)
+      {
+        (read (buffer, elements), ...);
+      },
+      object);
+      else if constexpr (internal::is_container<T>)
+        {
+          using value_type = typename T::value_type;
+
+          std::uint64_t n_elements;
+          read (buffer, n_elements);
+          object.resize (n_elements);
+          if constexpr (internal::is_stored_as_bytes<value_type>
+                        &&
+                        std::contiguous_iterator<decltype(std::begin(object))>)
+            {
+              if (n_elements > 0)
+                internal::read_bytes (buffer, &*std::begin(object),
+                                      n_elements * sizeof(value_type));
+            }
+          else if constexpr (std::contiguous_iterator<decltype(std::begin(object))>)
+            for (auto &element : object)
+              read (buffer, element);
+          else
+            // Containers such as std::vector<bool> do not give out
+            // references to their elements, so we have to assign to
+            // them instead:
+            for (auto it = std::begin(object); it != std::end(object); ++it)
+              {
+                value_type element;
+                read (buffer, element);
+                *it = std::move(element);
+              }
+        }
+      else
+        static_assert (std::is_trivially_copyable_v<T>,
+                       "This type is not supported by the serialization functions.");
+    }
+  }
+}
@@ -0,0 +1,41 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_SHARDED_ACCUMULATOR_H
+#define SAMPLEFLOW_SHARDED_ACCUMULATOR_H
+
+#include <sampleflow/config.h>
+
+#include <sampleflow/concepts.h>
+#include <sampleflow/copy_on_write.h>
+#include <sampleflow/reproducibility.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/topology.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/sharded_accumulator.impl.h>
+
+#endif
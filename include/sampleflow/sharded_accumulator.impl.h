@@ -0,0 +1,606 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that stores the state of a computation that many threads
+   * contribute to concurrently, in a way that allows these threads to
+   * do so without competing for the same lock. Examples of such computations
+   * are those done in consumers such as Consumers::MeanValue,
+   * Consumers::CovarianceMatrix, or Consumers::Histogram, whose consume()
+   * functions may be called from many threads at the same time -- for
+   * example, if many sampling algorithms run in parallel on separate threads
+   * and all send their samples to the same consumer. If all of these threads
+   * updated a single state variable, they would all have to wait for each
+   * other to acquire the lock that protects it.
+   *
+   * Instead, this class stores a number of copies ("shards") of the state,
+   * and each thread only ever updates the shard that corresponds to it.
+   * Only if the number of threads is larger than the number of shards do
+   * several threads share the same shard, but even then they only compete
+   * with a few others for its lock. When the result of the computation is
+   * requested, the states of all shards are combined (see merged()).
+   *
+   * The state of each shard is stored in a CopyOnWrite object. As a
+   * consequence, merged() does not hold up threads that update the shards
+   * while it copies and merges the states: It only needs to briefly lock
+   * each shard to obtain a snapshot of its state, and then merges these
+   * snapshots without holding any lock. This makes it possible to call
+   * merged() (and consequently, the `get()` functions of consumers that use
+   * this class) frequently from a separate thread that monitors the
+   * progress of a computation, without slowing down the computation.
+   *
+   * On machines with several NUMA nodes (see the Topology namespace), the
+   * shards are split into one group per node, and threads only use the
+   * shards of the group of the node they run on. Furthermore, the first
+   * thread that updates a shard makes a copy of its state on which it then
+   * works, so that the memory of the state is allocated on that thread's
+   * node. Both of these work best if the threads in question are bound to
+   * cores (see ThreadPool::Placement), since the operating system can
+   * otherwise move them to another node at any time. merged() then first
+   * merges the shards within each group, and then the results of the
+   * groups, so that most of the data it reads is read by one thread per
+   * node in turn rather than alternating between nodes.
+   *
+   * The results of merging the shards differ in the last few bits from
+   * run to run if the shards have received different data, or the same
+   * data in a different order -- which is what happens when threads are
+   * scheduled differently. If Reproducibility::set_deterministic() has
+   * been called, update() instead uses one shard for each stream number
+   * returned by Reproducibility::current_stream() (i.e., typically for
+   * each chain), creating these shards as needed, and merged() merges them
+   * in the order of the stream numbers. This makes the result bitwise
+   * reproducible; see the Reproducibility namespace.
+   *
+   * This only works for computations whose result does not depend on the
+   * order in which data is processed, and for which one can compute the
+   * result for the union of two sets of data from the results for each set
+   * of data. This is what the Concepts::is_mergeable concept requires:
+   * The `StateType` class has to have a member function `merge()` that
+   * takes a second object of the same type and updates the current object
+   * so that it represents the union of the data represented by the two
+   * objects. Merging with an object that represents no data at all must
+   * leave the current object unchanged; as a consequence, the result of
+   * a computation for which all data was processed on a single thread is
+   * exactly the same as if no sharding had been used.
+   *
+   * @tparam StateType The type that describes the state of the
+   *   computation.
+   */
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  class ShardedAccumulator
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] initial_state The state each of the shards starts out
+       *   with. This state must represent the computation before any data
+       *   has been processed.
+       * @param[in] n_shards The number of shards to use. By default, this is
+       *   the number returned by default_n_shards().
+       */
+      ShardedAccumulator (const StateType &initial_state = StateType(),
+                          const unsigned int n_shards = default_n_shards());
+
+      /**
+       * Copy constructor. This creates a copy of all of the shards of the
+       * argument.
+       */
+      ShardedAccumulator (const ShardedAccumulator &o);
+
+      /**
+       * Update the shard that corresponds to the current thread by calling
+       * the function object given as argument with a reference to the
+       * state of that shard. The function object is called while holding a
+       * lock that protects the shard, but this lock is only shared with
+       * other threads if there are more threads than shards, and with
+       * calls to merged() for the short time it takes them to obtain a
+       * snapshot of the shard.
+       *
+       * @param[in] update_function The function object that updates the
+       *   state of a shard.
+       * @param[in] synchronize Whether to acquire the lock that protects the
+       *   shard. If a caller passes `false`, it guarantees that no other
+       *   thread calls update() or merged() at the same time; in that case,
+       *   this function also does not need to determine the shard that
+       *   corresponds to the current thread, and simply updates the first one.
+       *   Since all updates then come from one thread in a well-defined
+       *   order, this is also what happens in deterministic mode.
+       */
+      template <typename UpdateFunction>
+      void
+      update (const UpdateFunction &update_function,
+              const bool synchronize = true);
+
+      /**
+       * Return the state that results from merging the states of all
+       * shards. The function first takes snapshots of all shards, and then
+       * merges them, in order, as a binary tree by calling
+       * `StateType::merge()`: the first shard with the second, the third
+       * with the fourth, and so on, then the results of these merges in
+       * the same way, until only one state is left. Since the shape of the
+       * tree only depends on the number of shards, the result is
+       * reproducible. If merging two states takes long enough, the merges
+       * of each level of the tree are done in parallel on
+       * ThreadPool::default_pool(), so that the time this function takes
+       * grows only logarithmically with the number of shards. If the shards
+       * are grouped by NUMA node, the shards of each group are merged
+       * this way, and then the results of the groups. The state of each shard
+       * that is used is the state as of the time this function looks at the
+       * shard; if other threads are updating the shards at the same time,
+       * the result therefore contains some but not necessarily all of their
+       * updates, but it never contains partial updates.
+       *
+       * If shards have been created for streams in deterministic mode, then
+       * the tree is built from the shards of the streams in the order of
+       * their numbers, followed by the shards described above (which have
+       * not received any updates if deterministic mode was enabled
+       * throughout).
+       */
+      StateType
+      merged () const;
+
+      /**
+       * Replace the state of the computation by the given one: The first
+       * shard is set to `state`, all other shards to the initial state
+       * given to the constructor, and the shards created for streams in
+       * deterministic mode are removed, so that merged() then returns
+       * `state`.
+       * Updates by other threads that happen while this function runs may
+       * or may not be lost.
+       */
+      void
+      reset (const StateType &state);
+
+      /**
+       * Return the number of shards this object uses, not counting the
+       * ones created for streams in deterministic mode.
+       */
+      unsigned int
+      n_shards () const;
+
+      /**
+       * Return the number of groups into which the shards are split, one
+       * per NUMA node (but not more than there are shards).
+       */
+      unsigned int
+      n_shard_groups () const;
+
+      /**
+       * Return the number of shards used by default. This is the number
+       * of hardware threads the system provides, but at least eight.
+       */
+      static
+      unsigned int
+      default_n_shards ();
+
+    private:
+      /**
+       * A structure that holds the state of one shard. Each shard is placed
+       * on its own cache line(s) so that threads working on different
+       * shards do not interfere. `placed` records whether a thread has
+       * already made a copy of the state on its own NUMA node.
+       */
+      struct alignas(64) Shard
+      {
+        CopyOnWrite<StateType> state;
+        std::atomic<bool>      placed = false;
+      };
+
+      /**
+       * The number of shards, the number of groups they are split into,
+       * and the shards themselves.
+       */
+      const unsigned int       n_shards_;
+      const unsigned int       n_groups;
+      std::unique_ptr<Shard[]> shards;
+
+      /**
+       * The shards created for each stream in deterministic mode, along
+       * with a mutex that protects the map (but not the shards, which are
+       * protected by their own locks).
+       */
+      std::map<std::size_t,std::unique_ptr<Shard>> stream_shards;
+      mutable std::shared_mutex                     stream_shards_mutex;
+
+      /**
+       * A copy of the initial state given to the constructor.
+       */
+      const StateType initial_state;
+
+      /**
+       * Return the shard for the given stream, creating it if necessary.
+       */
+      Shard &
+      stream_shard (const std::size_t stream);
+
+      /**
+       * Return a number that identifies the current thread. The numbers
+       * are assigned consecutively to threads in the order in which they
+       * first call this function, so that small numbers of threads map to
+       * different shards.
+       */
+      static
+      unsigned int
+      thread_index ();
+
+      /**
+       * Return the NUMA node of the current thread, as determined the first
+       * time the thread calls this function.
+       */
+      static
+      unsigned int
+      thread_numa_node ();
+
+      /**
+       * Return the index of the first shard of the given group. The shards
+       * of group `g` are those with indices from `first_shard_of_group(g)`
+       * up to (but excluding) `first_shard_of_group(g+1)`.
+       */
+      unsigned int
+      first_shard_of_group (const unsigned int group) const;
+
+      /**
+       * The (estimated) time the merges of one level of merge_tree() need
+       * to take before they are done in parallel. Below this, the overhead
+       * of handing the merges to a ThreadPool is larger than the gain.
+       */
+      static constexpr std::chrono::microseconds parallel_merge_threshold {50};
+
+      /**
+       * Merge the given states as a binary tree: First each pair of
+       * neighboring states, then pairs of the results, and so on. The
+       * order of the states is preserved, i.e., the result is as if the
+       * states had been merged one after the other, up to round-off.
+       * If the merges are expensive, the merges of each level of the tree
+       * are done in parallel on ThreadPool::default_pool().
+       */
+      static
+      StateType
+      merge_tree (std::vector<std::shared_ptr<const StateType>> states);
+  };
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  ShardedAccumulator<StateType>::
+  ShardedAccumulator (const StateType &initial_state,
+                      const unsigned int n_shards)
+    :
+    n_shards_ (n_shards),
+    n_groups (std::max (1U, std::min (n_shards, Topology::n_numa_nodes()))),
+    shards (std::make_unique<Shard[]>(n_shards)),
+    initial_state (initial_state)
+  {
+    assert (n_shards >= 1);
+
+    for (unsigned int i=0; i<n_shards_; ++i)
+      shards[i].state.modify ([&initial_state](StateType &state)
+    {
+      state = initial_state;
+    });
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  ShardedAccumulator<StateType>::
+  ShardedAccumulator (const ShardedAccumulator &o)
+    :
+    n_shards_ (o.n_shards_),
+    n_groups (o.n_groups),
+    shards (std::make_unique<Shard[]>(o.n_shards_)),
+    initial_state (o.initial_state)
+  {
+    for (unsigned int i=0; i<n_shards_; ++i)
+      {
+        const std::shared_ptr<const StateType> state = o.shards[i].state.snapshot();
+        shards[i].state.modify ([&state](StateType &s)
+        {
+          s = *state;
+        });
+      }
+
+    std::shared_lock<std::shared_mutex> lock (o.stream_shards_mutex);
+    for (const auto &[stream, shard] : o.stream_shards)
+      {
+        const std::shared_ptr<const StateType> state = shard->state.snapshot();
+        stream_shards.emplace (stream, std::make_unique<Shard>());
+        stream_shards[stream]->state.modify ([&state](StateType &s)
+        {
+          s = *state;
+        });
+      }
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  template <typename UpdateFunction>
+  void
+  ShardedAccumulator<StateType>::
+  update (const UpdateFunction &update_function,
+          const bool synchronize)
+  {
+    if (synchronize && Reproducibility::is_deterministic())
+      stream_shard (Reproducibility::current_stream()).state.modify (update_function);
+    else if (synchronize)
+      {
+        const unsigned int group = thread_numa_node() % n_groups;
+        const unsigned int first = first_shard_of_group (group);
+        Shard &shard = shards[first + thread_index() % (first_shard_of_group (group+1) - first)];
+
+        // The first thread to use a shard lets the state be copied on its
+        // own node: Holding a snapshot of the state forces modify() to make
+        // a copy before it calls the update function.
+        if ((shard.placed.load(std::memory_order_relaxed) == false)
+            &&
+            (shard.placed.exchange(true) == false))
+          {
+            const std::shared_ptr<const StateType> previous_state = shard.state.snapshot();
+            shard.state.modify (update_function);
+          }
+        else
+          shard.state.modify (update_function);
+      }
+    else
+      shards[0].state.modify (update_function, false);
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  StateType
+  ShardedAccumulator<StateType>::
+  merged () const
+  {
+    // First collect snapshots of the shards in the order in which they
+    // are to be merged. This only takes each shard's lock for a moment:
+    std::vector<std::shared_ptr<const StateType>> states;
+    {
+      std::shared_lock<std::shared_mutex> lock (stream_shards_mutex);
+      if (stream_shards.size() > 0)
+        {
+          for (const auto &p : stream_shards)
+            states.emplace_back (p.second->state.snapshot());
+          for (unsigned int i=0; i<n_shards_; ++i)
+            states.emplace_back (shards[i].state.snapshot());
+
+          lock.unlock();
+          return merge_tree (std::move(states));
+        }
+    }
+
+    for (unsigned int i=0; i<n_shards_; ++i)
+      states.emplace_back (shards[i].state.snapshot());
+
+    if (n_groups == 1)
+      return merge_tree (std::move(states));
+    else
+      {
+        // Merge the shards of each group, and then the results of the
+        // groups:
+        std::vector<std::shared_ptr<const StateType>> group_results;
+        for (unsigned int group=0; group<n_groups; ++group)
+          group_results.emplace_back
+          (std::make_shared<const StateType>
+           (merge_tree (std::vector<std::shared_ptr<const StateType>>
+                        (states.begin() + first_shard_of_group(group),
+                         states.begin() + first_shard_of_group(group+1)))));
+
+        return merge_tree (std::move(group_results));
+      }
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  StateType
+  ShardedAccumulator<StateType>::
+  merge_tree (std::vector<std::shared_ptr<const StateType>> states)
+  {
+    assert (states.size() > 0);
+
+    // Merge neighboring pairs of states until only two are left. Whether
+    // the merges of one level are worth spreading across the threads of
+    // a pool depends on how expensive they are, which we determine by
+    // timing the first merge of each level until one is found to be
+    // expensive enough:
+    bool use_thread_pool = false;
+    while (states.size() > 2)
+      {
+        const std::size_t n_pairs = states.size() / 2;
+        std::vector<std::shared_ptr<const StateType>> next_level ((states.size()+1) / 2);
+
+        const auto merge_pairs = [&states, &next_level](const std::size_t begin,
+                                                        const std::size_t end)
+        {
+          for (std::size_t p=begin; p<end; ++p)
+            {
+              auto result = std::make_shared<StateType> (*states[2*p]);
+              result->merge (*states[2*p+1]);
+              next_level[p] = std::move(result);
+            }
+        };
+
+        std::size_t first_pair = 0;
+        if (use_thread_pool == false)
+          {
+            const auto start = std::chrono::steady_clock::now();
+            merge_pairs (0, 1);
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            first_pair = 1;
+            use_thread_pool = (elapsed * (n_pairs-1) > parallel_merge_threshold);
+          }
+
+        if (use_thread_pool)
+          ThreadPool::default_pool()->for_each_chunk (n_pairs - first_pair,
+                                                      [&merge_pairs, first_pair](const std::size_t begin,
+                                                          const std::size_t end)
+        {
+          merge_pairs (first_pair + begin, first_pair + end);
+        });
+        else
+          merge_pairs (first_pair, n_pairs);
+
+        // An odd state at the end moves up to the next level unchanged:
+        if (states.size() % 2 == 1)
+          next_level.back() = std::move(states.back());
+
+        states = std::move(next_level);
+      }
+
+    StateType result = *states[0];
+    if (states.size() == 2)
+      result.merge (*states[1]);
+    return result;
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  void
+  ShardedAccumulator<StateType>::
+  reset (const StateType &state)
+  {
+    {
+      std::unique_lock<std::shared_mutex> lock (stream_shards_mutex);
+      stream_shards.clear();
+    }
+
+    shards[0].state.modify ([&state](StateType &s)
+    {
+      s = state;
+    });
+
+    for (unsigned int i=1; i<n_shards_; ++i)
+      shards[i].state.modify ([this](StateType &s)
+    {
+      s = initial_state;
+    });
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  n_shards () const
+  {
+    return n_shards_;
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  n_shard_groups () const
+  {
+    return n_groups;
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  default_n_shards ()
+  {
+    return std::max (8U, std::thread::hardware_concurrency());
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  thread_index ()
+  {
+    static std::atomic<unsigned int> n_threads_seen (0);
+    thread_local const unsigned int index = n_threads_seen++;
+
+    return index;
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  thread_numa_node ()
+  {
+    thread_local const unsigned int node = Topology::current_numa_node();
+
+    return node;
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  unsigned int
+  ShardedAccumulator<StateType>::
+  first_shard_of_group (const unsigned int group) const
+  {
+    assert (group <= n_groups);
+    return static_cast<unsigned int>(1UL * group * n_shards_ / n_groups);
+  }
+
+
+
+  template <typename StateType>
+  requires (Concepts::is_mergeable<StateType>)
+  typename ShardedAccumulator<StateType>::Shard &
+  ShardedAccumulator<StateType>::
+  stream_shard (const std::size_t stream)
+  {
+    {
+      std::shared_lock<std::shared_mutex> lock (stream_shards_mutex);
+      const auto p = stream_shards.find (stream);
+      if (p != stream_shards.end())
+        return *p->second;
+    }
+
+    // The shard does not exist yet. Another thread may create it at the
+    // same time, so check again once we have exclusive access:
+    std::unique_lock<std::shared_mutex> lock (stream_shards_mutex);
+    std::unique_ptr<Shard> &shard = stream_shards[stream];
+    if (shard == nullptr)
+      {
+        shard = std::make_unique<Shard>();
+        shard->state.modify ([this](StateType &s)
+        {
+          s = initial_state;
+        });
+      }
+    return *shard;
+  }
+}
@@ -0,0 +1,444 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A class that implements a first-in first-out queue of records in a
+   * POSIX shared memory object, through which one process can send
+   * samples to another process running on the same machine. The records
+   * are laid out as described in the documentation of namespace
+   * ChainFileFormat (the components of a sample, followed by selected
+   * entries of its auxiliary data), and the queue also stores the
+   * ChainFileFormat::Header that describes them, so that the receiving
+   * process knows what it receives. This class is the basis of the
+   * Consumers::SharedMemoryOutput and Producers::SharedMemoryInput classes,
+   * which connect sampling pipelines in different processes.
+   *
+   * The shared memory object consists of a small control block, the
+   * header, and a fixed number of "slots" that each hold one record. The
+   * sending process writes its records directly into the slots, and the
+   * receiving process reads them directly from there, so that no data
+   * is copied except into and out of the shared memory. Which slots are
+   * full is described by two counters in the control block (the position
+   * at which the next record will be written, and the position from which
+   * the next record will be read), both of which only ever increase. As
+   * for the BoundedQueue class, these counters are atomic variables, so
+   * that neither side ever needs to lock a mutex. The queue is meant to
+   * be used by one sending and one receiving process (or thread) at a
+   * time.
+   *
+   * If the queue is full when a new record is to be written, then the
+   * sending process either waits for the receiving process to read a
+   * record, or -- for QueueFullPolicy::drop_oldest -- overwrites the
+   * oldest record that has not been read yet. In the latter case, the
+   * receiving process may be in the middle of reading the record being
+   * overwritten; it notices this when it tries to advance the read
+   * position afterward, and then discards what it has read.
+   *
+   * Waiting (for a record to be read, or to become available) happens by
+   * polling the counters at short intervals, since there is no portable
+   * way to wait for a condition variable in another process.
+   */
+  class SharedMemoryQueue
+  {
+    public:
+      /**
+       * Constructor for the sending side. Create a shared memory object
+       * with the given name (which, as required for POSIX shared memory
+       * objects, should start with a slash and contain no other
+       * slashes), and with room for the given number of records described
+       * by the given header. If an object with the same name exists
+       * already, for example because a previous program was terminated
+       * before it could remove the object, it is overwritten.
+       */
+      SharedMemoryQueue (const std::string             &name,
+                         const ChainFileFormat::Header &header,
+                         const std::size_t              n_slots);
+
+      /**
+       * Constructor for the receiving side. Open the shared memory object
+       * with the given name, which must have been created by another
+       * object of this class that still exists.
+       */
+      SharedMemoryQueue (const std::string &name);
+
+      /**
+       * Copy constructor. Queues cannot be copied, and so this
+       * constructor is deleted.
+       */
+      SharedMemoryQueue (const SharedMemoryQueue &) = delete;
+
+      /**
+       * Destructor. Unmap the shared memory object and, on the sending
+       * side, remove its name so that it disappears once the receiving
+       * side has also unmapped it.
+       */
+      ~SharedMemoryQueue ();
+
+      /**
+       * Return the header that describes the records in the queue.
+       */
+      const ChainFileFormat::Header &
+      header () const;
+
+      /**
+       * Return the number of records the queue can hold.
+       */
+      std::size_t
+      n_slots () const;
+
+      /**
+       * Return a pointer to the slot into which the next record is to be
+       * written, waiting for space in the queue (or overwriting the oldest
+       * record) as described by the given policy. The caller needs to
+       * write `header().record_size()` bytes there and then call
+       * end_write().
+       */
+      char *
+      begin_write (const QueueFullPolicy policy);
+
+      /**
+       * Make the record written into the slot returned by the last call to
+       * begin_write() available to the receiving side.
+       */
+      void
+      end_write ();
+
+      /**
+       * Indicate that the sending side will not write any more records.
+       */
+      void
+      close ();
+
+      /**
+       * Return whether the sending side has called close(). Records written
+       * before that may of course still be waiting to be read.
+       */
+      bool
+      is_closed () const;
+
+      /**
+       * If the queue holds a record, copy it to the `header().record_size()`
+       * bytes starting at `record`, remove it from the queue, and return
+       * true. Otherwise, return false.
+       */
+      bool
+      try_read (char *record);
+
+      /**
+       * Return the number of records that were overwritten before the
+       * receiving side could read them.
+       */
+      std::uint64_t
+      n_dropped_records () const;
+
+    private:
+      /**
+       * The layout of the control block at the beginning of the shared
+       * memory object.
+       */
+      struct ControlBlock
+      {
+        char                       magic[8];
+        std::atomic<std::uint32_t> state;
+        std::uint32_t              header_size;
+        std::uint64_t              n_slots;
+        std::uint64_t              record_size;
+        std::atomic<std::uint64_t> n_dropped_records;
+
+        alignas(64) std::atomic<std::uint64_t> write_position;
+        alignas(64) std::atomic<std::uint64_t> read_position;
+      };
+
+      static_assert (std::atomic<std::uint64_t>::is_always_lock_free,
+                     "Shared memory queues require lock-free 64-bit atomics.");
+
+      /**
+       * The values of ControlBlock::state.
+       */
+      static constexpr std::uint32_t being_set_up = 0;
+      static constexpr std::uint32_t open         = 1;
+      static constexpr std::uint32_t closed       = 2;
+
+      /**
+       * The bytes with which the shared memory object starts.
+       */
+      static constexpr char magic[8] = {'S', 'F', 'S', 'H', 'M', 'Q', '1', '\0'};
+
+      /**
+       * Return the offset of the header, and of the first slot, from the
+       * beginning of the shared memory object, for a header of the given
+       * size.
+       */
+      static
+      std::size_t
+      header_offset ();
+
+      static
+      std::size_t
+      slots_offset (const std::size_t header_size);
+
+      /**
+       * The name of the shared memory object, and whether the current
+       * object created it.
+       */
+      const std::string name;
+      const bool        is_sender;
+
+      /**
+       * The memory the shared memory object has been mapped to, and its
+       * size.
+       */
+      char        *mapped_data;
+      std::size_t  mapped_size;
+
+      /**
+       * Pointers to the control block and the first slot within the
+       * mapped memory.
+       */
+      ControlBlock *control;
+      char         *slots;
+
+      /**
+       * A copy of the header stored in the shared memory object.
+       */
+      ChainFileFormat::Header queue_header;
+  };
+
+
+
+  inline
+  SharedMemoryQueue::SharedMemoryQueue (const std::string             &name,
+                                        const ChainFileFormat::Header &header,
+                                        const std::size_t              n_slots)
+    :
+    name (name),
+    is_sender (true),
+    queue_header (header)
+  {
+    assert (n_slots >= 1);
+
+    const std::vector<char> header_bytes = ChainFileFormat::write_header (header);
+    mapped_size = slots_offset (header_bytes.size()) + n_slots * header.record_size();
+
+    const int fd = shm_open (name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    assert (fd >= 0);
+    [[maybe_unused]] const int ierr = ftruncate (fd, mapped_size);
+    assert (ierr == 0);
+
+    void *const address = mmap (nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert (address != MAP_FAILED);
+    mapped_data = static_cast<char *>(address);
+    ::close (fd);
+
+    // Set up the control block and the header. The receiving side waits
+    // for the state to change before it looks at anything else:
+    control = new (mapped_data) ControlBlock;
+    control->state.store (being_set_up, std::memory_order_relaxed);
+    control->header_size = header_bytes.size();
+    control->n_slots     = n_slots;
+    control->record_size = header.record_size();
+    control->n_dropped_records.store (0, std::memory_order_relaxed);
+    control->write_position.store (0, std::memory_order_relaxed);
+    control->read_position.store (0, std::memory_order_relaxed);
+    std::memcpy (control->magic, magic, sizeof(magic));
+
+    std::memcpy (mapped_data + header_offset(), header_bytes.data(), header_bytes.size());
+    slots = mapped_data + slots_offset (header_bytes.size());
+
+    control->state.store (open, std::memory_order_release);
+  }
+
+
+
+  inline
+  SharedMemoryQueue::SharedMemoryQueue (const std::string &name)
+    :
+    name (name),
+    is_sender (false)
+  {
+    const int fd = shm_open (name.c_str(), O_RDWR, 0600);
+    assert (fd >= 0);
+
+    struct stat file_status;
+    [[maybe_unused]] const int ierr = fstat (fd, &file_status);
+    assert (ierr == 0);
+    mapped_size = file_status.st_size;
+    assert (mapped_size >= sizeof(ControlBlock));
+
+    void *const address = mmap (nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert (address != MAP_FAILED);
+    mapped_data = static_cast<char *>(address);
+    ::close (fd);
+
+    control = reinterpret_cast<ControlBlock *>(mapped_data);
+    while (control->state.load (std::memory_order_acquire) == being_set_up)
+      std::this_thread::yield();
+    assert (std::memcmp (control->magic, magic, sizeof(magic)) == 0);
+
+    std::span<const char> buffer (mapped_data + header_offset(), control->header_size);
+    queue_header = ChainFileFormat::read_header (buffer);
+    assert (queue_header.record_size() == control->record_size);
+
+    slots = mapped_data + slots_offset (control->header_size);
+  }
+
+
+
+  inline
+  SharedMemoryQueue::~SharedMemoryQueue ()
+  {
+    munmap (mapped_data, mapped_size);
+    if (is_sender)
+      shm_unlink (name.c_str());
+  }
+
+
+
+  inline
+  const ChainFileFormat::Header &
+  SharedMemoryQueue::header () const
+  {
+    return queue_header;
+  }
+
+
+
+  inline
+  std::size_t
+  SharedMemoryQueue::n_slots () const
+  {
+    return control->n_slots;
+  }
+
+
+
+  inline
+  char *
+  SharedMemoryQueue::begin_write (const QueueFullPolicy policy)
+  {
+    assert (is_sender);
+
+    // Only the sending side changes the write position, so we can read it
+    // without synchronization. If the queue is full, either wait or drop
+    // the oldest record by advancing the read position ourselves. The
+    // latter may fail if the receiving side has just read that record, in
+    // which case there is now space in the queue anyway.
+    const std::uint64_t write_position = control->write_position.load (std::memory_order_relaxed);
+    for (unsigned int attempt=0; ; ++attempt)
+      {
+        std::uint64_t read_position = control->read_position.load (std::memory_order_acquire);
+        if (write_position - read_position < control->n_slots)
+          break;
+
+        if (policy == QueueFullPolicy::drop_oldest)
+          {
+            if (control->read_position.compare_exchange_strong (read_position, read_position+1,
+                                                                std::memory_order_acq_rel))
+              {
+                control->n_dropped_records.fetch_add (1, std::memory_order_relaxed);
+                break;
+              }
+          }
+        else if ((policy == QueueFullPolicy::spin_then_block) && (attempt < 1000))
+          continue;
+        else
+          std::this_thread::sleep_for (std::chrono::microseconds(50));
+      }
+
+    return slots + (write_position % control->n_slots) * control->record_size;
+  }
+
+
+
+  inline
+  void
+  SharedMemoryQueue::end_write ()
+  {
+    control->write_position.fetch_add (1, std::memory_order_release);
+  }
+
+
+
+  inline
+  void
+  SharedMemoryQueue::close ()
+  {
+    control->state.store (closed, std::memory_order_release);
+  }
+
+
+
+  inline
+  bool
+  SharedMemoryQueue::is_closed () const
+  {
+    return (control->state.load (std::memory_order_acquire) == closed);
+  }
+
+
+
+  inline
+  bool
+  SharedMemoryQueue::try_read (char *record)
+  {
+    while (true)
+      {
+        std::uint64_t read_position = control->read_position.load (std::memory_order_acquire);
+        if (read_position == control->write_position.load (std::memory_order_acquire))
+          return false;
+
+        std::memcpy (record,
+                     slots + (read_position % control->n_slots) * control->record_size,
+                     control->record_size);
+
+        // Claim the record. If the sending side has dropped it in the
+        // meantime, it may have overwritten the slot while we were
+        // copying it, and we need to try again with the next record.
+        if (control->read_position.compare_exchange_strong (read_position, read_position+1,
+                                                            std::memory_order_acq_rel))
+          return true;
+      }
+  }
+
+
+
+  inline
+  std::uint64_t
+  SharedMemoryQueue::n_dropped_records () const
+  {
+    return control->n_dropped_records.load (std::memory_order_relaxed);
+  }
+
+
+
+  inline
+  std::size_t
+  SharedMemoryQueue::header_offset ()
+  {
+    return (sizeof(ControlBlock) + 63) / 64 * 64;
+  }
+
+
+
+  inline
+  std::size_t
+  SharedMemoryQueue::slots_offset (const std::size_t header_size)
+  {
+    return (header_offset() + header_size + 63) / 64 * 64;
+  }
+}
@@ -0,0 +1,33 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_SHARED_SAMPLE_H
+#define SAMPLEFLOW_SHARED_SAMPLE_H
+
+#include <sampleflow/config.h>
+
+#include <sampleflow/auxiliary_data.h>
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/shared_sample.impl.h>
+
+#endif
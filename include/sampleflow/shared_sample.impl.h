@@ -0,0 +1,205 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that holds a sample along with its auxiliary data while the
+   * sample is being sent from a Producer to all of the Consumer objects
+   * connected to it. The Producer::issue_sample() function creates one
+   * object of this type for each sample it sends, and then hands a
+   * reference to this one object to each connected consumer. As a
+   * consequence, sending a sample to $N$ consumers does not require
+   * making $N+1$ copies of the sample (one to pass to the signal, and one
+   * for each slot connected to it), as would be the case if the sample
+   * were passed along by value.
+   *
+   * Each receiver of the sample has to call take() exactly once. The
+   * object keeps track of how many receivers still have to do so: All but
+   * the last of these receive a copy of the sample and its auxiliary data,
+   * whereas the last one receives the stored objects themselves, moved out
+   * of the current object. In the common case of a producer with a single
+   * consumer, the sample is therefore never copied at all. This is also
+   * what makes it possible to use sample types that can be moved but not
+   * copied: Producers of such samples can only have one consumer (see
+   * Concepts::is_valid_sampletype).
+   *
+   * @tparam SampleType The type of the sample stored.
+   */
+  namespace Utilities
+  {
+    /**
+     * Return a copy of the given sample. This function is used in the
+     * places where a sample that belongs to someone else has to be passed
+     * on by value -- for example, when a producer sends a sample to more
+     * than one consumer, or when the samples of a batch (which are passed
+     * by reference) are processed one at a time.
+     *
+     * Sample types that can be moved but not copied (see
+     * Concepts::is_valid_sampletype) can not be used in these places. Since
+     * this can, in general, only be determined at run time, the function
+     * can be called for such types as well, but then aborts the program.
+     */
+    template <typename SampleType>
+    SampleType
+    copy_sample (const SampleType &sample)
+    {
+      if constexpr (std::copyable<SampleType>)
+        return sample;
+      else
+        {
+          assert (false &&
+                  "Samples of this type can not be copied. They can only be "
+                  "sent to a single consumer, and not in batches to consumers "
+                  "that do not override the functions that receive batches.");
+          std::abort();
+        }
+    }
+  }
+
+
+
+  template <typename SampleType>
+  class SharedSample
+  {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param[in] sample The sample to be stored.
+       * @param[in] aux_data The auxiliary data to be stored.
+       * @param[in] n_receivers The number of receivers that will call
+       *   take(). If this number is larger than the actual number of
+       *   receivers, then everyone gets a copy of the stored objects;
+       *   it must not be smaller.
+       */
+      SharedSample (SampleType         &&sample,
+                    AuxiliaryData      &&aux_data,
+                    const std::size_t    n_receivers);
+
+      /**
+       * Copy constructor. Objects of this type cannot be copied, and so
+       * this constructor is deleted.
+       */
+      SharedSample (const SharedSample &) = delete;
+
+      /**
+       * Return a reference to the stored sample.
+       */
+      const SampleType &
+      sample () const;
+
+      /**
+       * Return a reference to the stored auxiliary data.
+       */
+      const AuxiliaryData &
+      aux_data () const;
+
+      /**
+       * Obtain the sample and its auxiliary data. If the caller is the last
+       * of the receivers announced to the constructor, then the stored
+       * objects are moved into the returned pair; otherwise, the returned
+       * pair contains copies.
+       */
+      std::pair<SampleType,AuxiliaryData>
+      take ();
+
+      /**
+       * Indicate that the caller, one of the receivers announced to the
+       * constructor, does not need its own copy of the sample and its
+       * auxiliary data: It has looked at them via sample() and aux_data()
+       * and will not do so again. Receivers that do this instead of calling
+       * take() do not cause the sample to be copied, and if they do so
+       * before the other receivers call take(), then the last of those
+       * still receives the stored objects without a copy.
+       */
+      void
+      release ();
+
+    private:
+      /**
+       * The sample and auxiliary data.
+       */
+      SampleType    stored_sample;
+      AuxiliaryData stored_aux_data;
+
+      /**
+       * The number of receivers that have not yet called take().
+       */
+      std::atomic<std::size_t> n_remaining_receivers;
+  };
+
+
+
+  template <typename SampleType>
+  SharedSample<SampleType>::
+  SharedSample (SampleType         &&sample,
+                AuxiliaryData      &&aux_data,
+                const std::size_t    n_receivers)
+    :
+    stored_sample (std::move(sample)),
+    stored_aux_data (std::move(aux_data)),
+    n_remaining_receivers (n_receivers)
+  {}
+
+
+
+  template <typename SampleType>
+  const SampleType &
+  SharedSample<SampleType>::
+  sample () const
+  {
+    return stored_sample;
+  }
+
+
+
+  template <typename SampleType>
+  const AuxiliaryData &
+  SharedSample<SampleType>::
+  aux_data () const
+  {
+    return stored_aux_data;
+  }
+
+
+
+  template <typename SampleType>
+  std::pair<SampleType,AuxiliaryData>
+  SharedSample<SampleType>::
+  take ()
+  {
+    const std::size_t previously_remaining = n_remaining_receivers.fetch_sub (1);
+    // Make sure that no more receivers have called this function
+    // than were announced to the constructor:
+    assert (previously_remaining >= 1);
+
+    if (previously_remaining == 1)
+      return {std::move(stored_sample), std::move(stored_aux_data)};
+    else
+      return {Utilities::copy_sample (stored_sample), stored_aux_data};
+  }
+
+
+
+  template <typename SampleType>
+  void
+  SharedSample<SampleType>::
+  release ()
+  {
+    [[maybe_unused]] const std::size_t previously_remaining = n_remaining_receivers.fetch_sub (1);
+    assert (previously_remaining >= 1);
+  }
+}
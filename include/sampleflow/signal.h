@@ -0,0 +1,53 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+#ifndef SAMPLEFLOW_SIGNAL_H
+#define SAMPLEFLOW_SIGNAL_H
+
+#include <sampleflow/config.h>
+
+// By default, producers use the lightweight Signal class below to send
+// samples to the consumers connected to them. Defining
+// SAMPLEFLOW_WITH_BOOST_SIGNALS2 before including any SampleFlow header
+// file selects the implementation of BOOST's signals2 library instead.
+#ifdef SAMPLEFLOW_WITH_BOOST_SIGNALS2
+
+#include <boost/signals2.hpp>
+
+namespace SampleFlow
+{
+  template <typename Signature>
+  using Signal = boost::signals2::signal<Signature>;
+
+  using Connection = boost::signals2::connection;
+}
+
+#else
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/signal.impl.h>
+
+#endif
+
+#endif
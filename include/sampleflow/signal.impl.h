@@ -0,0 +1,524 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    namespace Signals
+    {
+      class SignalStateBase;
+
+
+      /**
+       * The part of a slot connected to a Signal object that does not
+       * depend on the signature of the signal, namely whether the slot is
+       * still connected and which signal it is connected to. This is what
+       * Connection objects refer to.
+       */
+      class SlotBase
+      {
+        public:
+          /**
+           * Constructor.
+           */
+          SlotBase (const std::weak_ptr<SignalStateBase> &signal_state)
+            :
+            is_connected (true),
+            signal_state (signal_state)
+          {}
+
+          /**
+           * Destructor.
+           */
+          virtual ~SlotBase () = default;
+
+          /**
+           * Whether the slot is still connected. Signals do not call slots
+           * for which this flag is `false`, even if they are still part
+           * of the list of slots a signal is currently working through.
+           */
+          std::atomic<bool> is_connected;
+
+          /**
+           * The state of the signal the slot is connected to. This is a
+           * weak pointer so that connections can be terminated even after
+           * the signal has been destroyed.
+           */
+          const std::weak_ptr<SignalStateBase> signal_state;
+      };
+
+
+      /**
+       * The part of the state of a Signal object that does not depend on
+       * the signature of the signal: A function that removes a slot from
+       * the list of slots.
+       */
+      class SignalStateBase
+      {
+        public:
+          /**
+           * Destructor.
+           */
+          virtual ~SignalStateBase () = default;
+
+          /**
+           * Remove the given slot from the list of slots of the signal.
+           */
+          virtual
+          void
+          remove (const SlotBase *slot) = 0;
+      };
+    }
+  }
+
+
+  /**
+   * An object that represents the connection of a slot to a Signal
+   * object, returned by Signal::connect(). Its only purpose is to allow
+   * terminating the connection again via disconnect(). Connection objects
+   * can be copied; all copies then refer to the same connection.
+   * Destroying a Connection object does not terminate the connection.
+   */
+  class Connection
+  {
+    public:
+      /**
+       * Default constructor. The object created does not refer to any
+       * connection.
+       */
+      Connection () = default;
+
+      /**
+       * Constructor used by Signal::connect().
+       */
+      Connection (const std::shared_ptr<internal::Signals::SlotBase> &slot);
+
+      /**
+       * Terminate the connection. Once this function has returned, the
+       * signal will no longer call the slot, except for calls that had
+       * already started (possibly on other threads) before this function
+       * was called. It is not an error to call this function more than
+       * once, or for an object that does not refer to a connection.
+       */
+      void
+      disconnect () const;
+
+      /**
+       * Return whether the connection still exists.
+       */
+      bool
+      connected () const;
+
+    private:
+      /**
+       * The slot this object refers to. The slot is owned by the signal
+       * to which it is connected, and is destroyed once it has been
+       * disconnected and the signal is no longer calling it.
+       */
+      std::weak_ptr<internal::Signals::SlotBase> slot;
+  };
+
+
+
+  inline
+  Connection::Connection (const std::shared_ptr<internal::Signals::SlotBase> &slot)
+    :
+    slot (slot)
+  {}
+
+
+
+  inline
+  void
+  Connection::disconnect () const
+  {
+    // Only the first thread to clear the flag removes the slot from the
+    // list of slots of the signal (if the signal still exists):
+    if (const std::shared_ptr<internal::Signals::SlotBase> s = slot.lock())
+      if (s->is_connected.exchange (false) == true)
+        if (const std::shared_ptr<internal::Signals::SignalStateBase> signal_state
+            = s->signal_state.lock())
+          signal_state->remove (s.get());
+  }
+
+
+
+  inline
+  bool
+  Connection::connected () const
+  {
+    if (const std::shared_ptr<internal::Signals::SlotBase> s = slot.lock())
+      return s->is_connected.load();
+    else
+      return false;
+  }
+
+
+
+  template <typename Signature>
+  class Signal;
+
+
+  /**
+   * A class that implements a "signal" to which one can connect any number
+   * of "slots" (functions with the given signature), and that calls all of
+   * these slots when invoked as a function. This is the mechanism with
+   * which the Producer class sends samples to the consumers connected to
+   * it. The class provides the subset of the interface of
+   * `boost::signals2::signal` that SampleFlow uses, and SampleFlow can be
+   * configured to use the latter instead of the current class (see the
+   * `SAMPLEFLOW_WITH_BOOST_SIGNALS2` macro in signal.h).
+   *
+   * The list of slots is modified much less frequently (namely when
+   * consumers are connected to or disconnected from a producer) than the
+   * signal is invoked (namely for every sample), and the class is
+   * optimized for this case: The list of slots is stored in a vector that
+   * is never modified once created; rather, connecting or disconnecting a
+   * slot creates a new vector and atomically replaces the pointer to the
+   * old one ("copy on write"). Invoking the signal then only requires
+   * atomically loading this pointer and calling the slots in the vector
+   * one after the other; in particular, it does not require acquiring a
+   * mutex. Threads that invoke the signal while a slot is connected or
+   * disconnected keep working on the vector they loaded, which is only
+   * destroyed once the last of them is done with it.
+   *
+   * Slots are called in the order in which they were connected.
+   *
+   * @tparam Args The types of the arguments of the slots. The arguments
+   *   passed to operator() are passed on to every slot as lvalues; for
+   *   arguments that are passed by value, every slot therefore receives
+   *   its own copy. Producer only uses signals whose arguments are
+   *   references.
+   */
+  template <typename... Args>
+  class Signal<void (Args...)>
+  {
+    public:
+      /**
+       * The type of functions that can be connected to the signal.
+       */
+      using slot_type = std::function<void (Args...)>;
+
+      /**
+       * Constructor. The signal initially has no slots.
+       */
+      Signal ();
+
+      /**
+       * Copy constructor. Signals can not be copied, and so this
+       * constructor is deleted.
+       */
+      Signal (const Signal &) = delete;
+
+      /**
+       * Destructor. All connections to the current signal are terminated.
+       */
+      ~Signal ();
+
+      /**
+       * Connect a function to the current signal, i.e., ensure that it is
+       * called whenever the signal is invoked.
+       *
+       * @param[in] slot The function to be called.
+       * @return An object with which the connection can be terminated.
+       */
+      Connection
+      connect (const slot_type &slot);
+
+      /**
+       * Invoke the signal, i.e., call all slots connected to it with the
+       * given arguments.
+       */
+      void
+      operator() (Args... args) const;
+
+      /**
+       * A class that represents the list of slots connected to the signal
+       * at one point in time. See below.
+       */
+      class SlotSnapshot;
+
+      /**
+       * Return the list of slots currently connected to the signal.
+       */
+      SlotSnapshot
+      current_slots () const;
+
+      /**
+       * Return whether no slots are connected to the current signal.
+       */
+      bool
+      empty () const;
+
+      /**
+       * Return the number of slots connected to the current signal.
+       */
+      std::size_t
+      num_slots () const;
+
+      /**
+       * Terminate all connections to the current signal.
+       */
+      void
+      disconnect_all_slots ();
+
+    private:
+      /**
+       * A slot, i.e., the function to be called along with the
+       * information whether it is still connected.
+       */
+      class Slot : public internal::Signals::SlotBase
+      {
+        public:
+          Slot (const std::weak_ptr<internal::Signals::SignalStateBase> &signal_state,
+                const slot_type &function)
+            :
+            internal::Signals::SlotBase (signal_state),
+            function (function)
+          {}
+
+          const slot_type function;
+      };
+
+      /**
+       * The type used for the list of slots.
+       */
+      using SlotList = std::vector<std::shared_ptr<Slot>>;
+
+    public:
+      /**
+       * A class that represents the list of slots connected to a signal at
+       * one point in time, as returned by current_slots(). Invoking it calls
+       * these slots, even if slots have been connected to or disconnected
+       * from the signal since the object was created -- except that, as
+       * for operator() of the signal, slots that have been disconnected
+       * in the meantime are not called.
+       *
+       * This is useful for callers that need to know how many slots they
+       * are going to call before calling them: Using num_slots() followed
+       * by operator() of the signal would give a wrong answer if a slot is
+       * connected on another thread in between.
+       */
+      class SlotSnapshot
+      {
+        public:
+          /**
+           * Return the number of slots in the list.
+           */
+          std::size_t
+          size () const;
+
+          /**
+           * Call all slots in the list that are still connected with the
+           * given arguments.
+           */
+          void
+          operator() (Args... args) const;
+
+        private:
+          /**
+           * Constructor, used by current_slots().
+           */
+          SlotSnapshot (std::shared_ptr<const SlotList> &&slots);
+
+          /**
+           * The list of slots.
+           */
+          const std::shared_ptr<const SlotList> slots;
+
+          friend class Signal;
+      };
+
+    private:
+
+      /**
+       * The state of the signal, namely the list of slots along with a
+       * mutex that serializes modifications of it. This is kept
+       * separately from the current object (and referenced via a
+       * `std::shared_ptr`) so that Connection objects can call remove()
+       * without having to check whether the signal still exists.
+       */
+      class State : public internal::Signals::SignalStateBase
+      {
+        public:
+          State ();
+
+          /**
+           * Replace the list of slots by a copy that does not contain the
+           * given slot.
+           */
+          virtual
+          void
+          remove (const internal::Signals::SlotBase *slot) override;
+
+          /**
+           * A mutex that is held while the list of slots is modified.
+           * Invoking the signal does not require this mutex.
+           */
+          std::mutex mutex;
+
+          /**
+           * The current list of slots.
+           */
+          std::atomic<std::shared_ptr<const SlotList>> slots;
+      };
+
+      /**
+       * The state of the current signal.
+       */
+      const std::shared_ptr<State> state;
+  };
+
+
+
+  template <typename... Args>
+  Signal<void (Args...)>::Signal ()
+    :
+    state (std::make_shared<State>())
+  {}
+
+
+
+  template <typename... Args>
+  Signal<void (Args...)>::State::State ()
+    :
+    slots (std::make_shared<const SlotList>())
+  {}
+
+
+
+  template <typename... Args>
+  void
+  Signal<void (Args...)>::State::remove (const internal::Signals::SlotBase *slot)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const std::shared_ptr<const SlotList> old_slots = slots.load();
+    auto new_slots = std::make_shared<SlotList>();
+    new_slots->reserve (old_slots->size());
+    for (const std::shared_ptr<Slot> &s : *old_slots)
+      if (s.get() != slot)
+        new_slots->push_back (s);
+    slots.store (std::move(new_slots));
+  }
+
+
+
+  template <typename... Args>
+  Signal<void (Args...)>::~Signal ()
+  {
+    disconnect_all_slots ();
+  }
+
+
+
+  template <typename... Args>
+  Connection
+  Signal<void (Args...)>::connect (const slot_type &slot)
+  {
+    auto new_slot = std::make_shared<Slot>(state, slot);
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+
+      const std::shared_ptr<const SlotList> old_slots = state->slots.load();
+      auto new_slots = std::make_shared<SlotList>(*old_slots);
+      new_slots->push_back (new_slot);
+      state->slots.store (std::move(new_slots));
+    }
+
+    return Connection (new_slot);
+  }
+
+
+
+  template <typename... Args>
+  void
+  Signal<void (Args...)>::operator() (Args... args) const
+  {
+    current_slots() (args...);
+  }
+
+
+
+  template <typename... Args>
+  Signal<void (Args...)>::SlotSnapshot::SlotSnapshot (std::shared_ptr<const SlotList> &&slots)
+    :
+    slots (std::move(slots))
+  {}
+
+
+
+  template <typename... Args>
+  std::size_t
+  Signal<void (Args...)>::SlotSnapshot::size () const
+  {
+    return slots->size();
+  }
+
+
+
+  template <typename... Args>
+  void
+  Signal<void (Args...)>::SlotSnapshot::operator() (Args... args) const
+  {
+    for (const std::shared_ptr<Slot> &slot : *slots)
+      if (slot->is_connected.load (std::memory_order_acquire))
+        slot->function (args...);
+  }
+
+
+
+  template <typename... Args>
+  typename Signal<void (Args...)>::SlotSnapshot
+  Signal<void (Args...)>::current_slots () const
+  {
+    return SlotSnapshot (state->slots.load (std::memory_order_acquire));
+  }
+
+
+
+  template <typename... Args>
+  bool
+  Signal<void (Args...)>::empty () const
+  {
+    return state->slots.load()->empty();
+  }
+
+
+
+  template <typename... Args>
+  std::size_t
+  Signal<void (Args...)>::num_slots () const
+  {
+    return state->slots.load()->size();
+  }
+
+
+
+  template <typename... Args>
+  void
+  Signal<void (Args...)>::disconnect_all_slots ()
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+
+    const std::shared_ptr<const SlotList> old_slots
+      = state->slots.exchange (std::make_shared<const SlotList>());
+    for (const std::shared_ptr<Slot> &slot : *old_slots)
+      slot->is_connected = false;
+  }
+}
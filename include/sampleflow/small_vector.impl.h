@@ -0,0 +1,623 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A class that represents a vector of elements of type `T` whose size is
+   * determined at run time, but that stores up to `N` elements inline in
+   * the object itself rather than in memory allocated on the heap. This
+   * is the "small buffer optimization" used by many implementations of
+   * `std::string`. Only if the vector is resized to more than `N` elements
+   * does the class allocate memory; in that case, it behaves like
+   * `std::vector<T>`.
+   *
+   * The class is meant for cases where the dimension of the problem is
+   * not known at compile time, so that FixedVector can not be used, but is
+   * known to be small in the typical use case. Like FixedVector, the class
+   * satisfies Concepts::is_vector_space_type, and copying objects with
+   * at most `N` elements does not allocate memory. The inline elements
+   * are aligned in the same way as those of FixedVector, and the
+   * arithmetic operators are written as simple loops over contiguous
+   * memory that compilers can vectorize.
+   *
+   * In contrast to `std::vector`, the class requires `T` to be
+   * default-constructible, since the inline buffer always holds `N`
+   * objects of type `T`. This is of no concern for the arithmetic types
+   * this class is meant for.
+   *
+   * @tparam T The type of the individual elements, typically `double` or
+   *   `float`.
+   * @tparam N The number of elements that can be stored without allocating
+   *   memory.
+   */
+  template <typename T, std::size_t N>
+  class SmallVector
+  {
+    public:
+      /**
+       * The type of the elements of this vector.
+       */
+      using value_type = T;
+
+      /**
+       * Default constructor. Creates an empty vector.
+       */
+      SmallVector ();
+
+      /**
+       * Constructor that creates a vector with `n` elements, all of
+       * which are set to the given value.
+       *
+       * @param[in] n The number of elements.
+       * @param[in] value The value to which all elements are set.
+       */
+      explicit SmallVector (const std::size_t n,
+                            const T &value = T());
+
+      /**
+       * Constructor that creates a vector with the given list of values.
+       */
+      SmallVector (const std::initializer_list<T> values);
+
+      /**
+       * Copy constructor. This only allocates memory if `v` has more than
+       * `N` elements.
+       */
+      SmallVector (const SmallVector &v);
+
+      /**
+       * Move constructor. If `v` stores its elements on the heap, then
+       * the current object takes over this memory; otherwise, the elements
+       * are copied. In either case, `v` is empty afterward.
+       */
+      SmallVector (SmallVector &&v) noexcept;
+
+      /**
+       * Copy assignment operator. This only allocates memory if `v` has
+       * more elements than fit into the memory the current object already
+       * has.
+       */
+      SmallVector &
+      operator= (const SmallVector &v);
+
+      /**
+       * Move assignment operator. See the move constructor for the
+       * semantics.
+       */
+      SmallVector &
+      operator= (SmallVector &&v) noexcept;
+
+      /**
+       * Return the number of elements of this vector.
+       */
+      std::size_t
+      size () const;
+
+      /**
+       * Return the number of elements this vector can hold without
+       * allocating (more) memory. This is `N` for vectors that store their
+       * elements inline.
+       */
+      std::size_t
+      capacity () const;
+
+      /**
+       * Return whether the elements of this vector are stored inline in
+       * the object, i.e., whether the object has not allocated memory on
+       * the heap.
+       */
+      bool
+      uses_inline_storage () const;
+
+      /**
+       * Change the number of elements of this vector. Elements that
+       * existed before are retained; new elements are set to `T()`.
+       * Memory is only allocated if the new size is larger than the
+       * current capacity().
+       */
+      void
+      resize (const std::size_t new_size);
+
+      /**
+       * Return a reference to the `i`th element of the vector.
+       */
+      T &
+      operator[] (const std::size_t i);
+
+      /**
+       * Return a reference to the `i`th element of the vector.
+       */
+      const T &
+      operator[] (const std::size_t i) const;
+
+      /**
+       * Return a pointer to the first element of the vector. The elements
+       * are stored contiguously.
+       */
+      T *
+      data ();
+
+      /**
+       * Return a pointer to the first element of the vector. The elements
+       * are stored contiguously.
+       */
+      const T *
+      data () const;
+
+      /**
+       * Return an iterator to the first element of the vector.
+       */
+      T *
+      begin ();
+
+      /**
+       * Return an iterator to the first element of the vector.
+       */
+      const T *
+      begin () const;
+
+      /**
+       * Return an iterator to one past the last element of the vector.
+       */
+      T *
+      end ();
+
+      /**
+       * Return an iterator to one past the last element of the vector.
+       */
+      const T *
+      end () const;
+
+      /**
+       * Add the elements of the given vector to the current one. The two
+       * vectors need to have the same size.
+       */
+      SmallVector &
+      operator+= (const SmallVector &v);
+
+      /**
+       * Subtract the elements of the given vector from the current one.
+       * The two vectors need to have the same size.
+       */
+      SmallVector &
+      operator-= (const SmallVector &v);
+
+      /**
+       * Multiply all elements of the current vector by the given factor.
+       */
+      SmallVector &
+      operator*= (const double factor);
+
+      /**
+       * Divide all elements of the current vector by the given factor.
+       */
+      SmallVector &
+      operator/= (const double factor);
+
+      /**
+       * Compare two vectors. Vectors are equal if they have the same size
+       * and the same elements.
+       */
+      bool
+      operator== (const SmallVector &v) const;
+
+    private:
+      /**
+       * The number of elements of this vector.
+       */
+      std::size_t n_elements;
+
+      /**
+       * The number of elements for which memory has been allocated in
+       * `heap_elements`, or zero if the vector uses the inline storage.
+       */
+      std::size_t heap_capacity;
+
+      /**
+       * The elements of the vector if they do not fit into the inline
+       * storage; a null pointer otherwise.
+       */
+      std::unique_ptr<T[]> heap_elements;
+
+      /**
+       * The elements of the vector if there are at most `N` of them.
+       */
+      alignas(internal::VectorStorage::alignment<T>(N)) T inline_elements[N];
+  };
+
+
+  /**
+   * Return the sum of two vectors.
+   */
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator+ (SmallVector<T,N> v1,
+             const SmallVector<T,N> &v2);
+
+  /**
+   * Return the difference of two vectors.
+   */
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator- (SmallVector<T,N> v1,
+             const SmallVector<T,N> &v2);
+
+  /**
+   * Return the vector multiplied by a scalar.
+   */
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator* (SmallVector<T,N> v,
+             const double factor);
+
+  /**
+   * Return the vector multiplied by a scalar.
+   */
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator* (const double factor,
+             SmallVector<T,N> v);
+
+  /**
+   * Return the vector divided by a scalar.
+   */
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator/ (SmallVector<T,N> v,
+             const double factor);
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>::SmallVector ()
+    :
+    n_elements (0),
+    heap_capacity (0),
+    inline_elements {}
+  {}
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>::SmallVector (const std::size_t n,
+                                 const T &value)
+    :
+    SmallVector ()
+  {
+    resize (n);
+    std::fill_n (data(), n, value);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>::SmallVector (const std::initializer_list<T> values)
+    :
+    SmallVector ()
+  {
+    resize (values.size());
+    std::copy (values.begin(), values.end(), data());
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>::SmallVector (const SmallVector &v)
+    :
+    SmallVector ()
+  {
+    *this = v;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>::SmallVector (SmallVector &&v) noexcept
+    :
+    SmallVector ()
+  {
+    *this = std::move(v);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator= (const SmallVector &v)
+  {
+    if (this != &v)
+      {
+        // Shrink first so that resize() does not copy elements that are
+        // going to be overwritten anyway:
+        if (v.n_elements > capacity())
+          n_elements = 0;
+        resize (v.n_elements);
+        std::copy (v.begin(), v.end(), data());
+      }
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator= (SmallVector &&v) noexcept
+  {
+    if (this != &v)
+      {
+        if (v.heap_elements)
+          {
+            heap_elements = std::move(v.heap_elements);
+            heap_capacity = v.heap_capacity;
+            n_elements    = v.n_elements;
+          }
+        else
+          {
+            heap_elements.reset ();
+            heap_capacity = 0;
+            n_elements    = v.n_elements;
+            std::copy (v.inline_elements, v.inline_elements + v.n_elements,
+                       inline_elements);
+          }
+
+        v.n_elements    = 0;
+        v.heap_capacity = 0;
+      }
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  std::size_t
+  SmallVector<T,N>::size () const
+  {
+    return n_elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  std::size_t
+  SmallVector<T,N>::capacity () const
+  {
+    return (heap_elements ? heap_capacity : N);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  bool
+  SmallVector<T,N>::uses_inline_storage () const
+  {
+    return !heap_elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  void
+  SmallVector<T,N>::resize (const std::size_t new_size)
+  {
+    if (new_size > capacity())
+      {
+        std::unique_ptr<T[]> new_elements (new T[new_size]);
+        std::copy (begin(), end(), new_elements.get());
+
+        heap_elements = std::move(new_elements);
+        heap_capacity = new_size;
+      }
+
+    // Value-initialize the elements that are added:
+    if (new_size > n_elements)
+      std::fill (data() + n_elements, data() + new_size, T());
+
+    n_elements = new_size;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T &
+  SmallVector<T,N>::operator[] (const std::size_t i)
+  {
+    assert (i < n_elements);
+    return data()[i];
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T &
+  SmallVector<T,N>::operator[] (const std::size_t i) const
+  {
+    assert (i < n_elements);
+    return data()[i];
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  SmallVector<T,N>::data ()
+  {
+    return (heap_elements ? heap_elements.get() : inline_elements);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  SmallVector<T,N>::data () const
+  {
+    return (heap_elements ? heap_elements.get() : inline_elements);
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  SmallVector<T,N>::begin ()
+  {
+    return data();
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  SmallVector<T,N>::begin () const
+  {
+    return data();
+  }
+
+
+
+  template <typename T, std::size_t N>
+  T *
+  SmallVector<T,N>::end ()
+  {
+    return data() + n_elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  const T *
+  SmallVector<T,N>::end () const
+  {
+    return data() + n_elements;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator+= (const SmallVector &v)
+  {
+    assert (v.n_elements == n_elements);
+
+    T *const       dst = data();
+    const T *const src = v.data();
+    for (std::size_t i=0; i<n_elements; ++i)
+      dst[i] += src[i];
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator-= (const SmallVector &v)
+  {
+    assert (v.n_elements == n_elements);
+
+    T *const       dst = data();
+    const T *const src = v.data();
+    for (std::size_t i=0; i<n_elements; ++i)
+      dst[i] -= src[i];
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator*= (const double factor)
+  {
+    T *const dst = data();
+    for (std::size_t i=0; i<n_elements; ++i)
+      dst[i] *= factor;
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N> &
+  SmallVector<T,N>::operator/= (const double factor)
+  {
+    T *const dst = data();
+    for (std::size_t i=0; i<n_elements; ++i)
+      dst[i] /= factor;
+    return *this;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  bool
+  SmallVector<T,N>::operator== (const SmallVector &v) const
+  {
+    return std::equal (begin(), end(), v.begin(), v.end());
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator+ (SmallVector<T,N> v1,
+             const SmallVector<T,N> &v2)
+  {
+    v1 += v2;
+    return v1;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator- (SmallVector<T,N> v1,
+             const SmallVector<T,N> &v2)
+  {
+    v1 -= v2;
+    return v1;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator* (SmallVector<T,N> v,
+             const double factor)
+  {
+    v *= factor;
+    return v;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator* (const double factor,
+             SmallVector<T,N> v)
+  {
+    v *= factor;
+    return v;
+  }
+
+
+
+  template <typename T, std::size_t N>
+  SmallVector<T,N>
+  operator/ (SmallVector<T,N> v,
+             const double factor)
+  {
+    v /= factor;
+    return v;
+  }
+}
@@ -0,0 +1,270 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+namespace SampleFlow
+{
+  namespace internal
+  {
+    /**
+     * A hash table that maps the integer coordinates of a cell of a grid
+     * in a space of given dimension to the number and weight of the
+     * samples counted in it. This is the data structure behind the
+     * Consumers::SparsePairHistogram and Consumers::MultivariateHistogram
+     * classes, which only store the cells of their grids that actually
+     * contain samples.
+     *
+     * The table uses open addressing with linear probing: All cells are
+     * stored in one array of slots whose size is a power of two, and a
+     * cell is placed in the first free slot at or after the position its
+     * hash value points to. Empty slots are marked by a sample count of
+     * zero. The array is doubled in size whenever it would otherwise
+     * become more than half full, which keeps the sequences of slots that
+     * need to be searched short. Because cells are never removed from the
+     * table (other than by replacing the table as a whole), there is no
+     * need for the "tombstones" usually necessary in open-addressing
+     * schemes.
+     *
+     * Since the dimension is only known at run time, keys are tuples of a
+     * run-time length. To avoid allocating memory for each key, the keys
+     * of all slots are stored in one array in which slot $s$ occupies the
+     * entries $sD,\ldots,sD+D-1$ for dimension $D$, and the counts and
+     * weights of the slots are stored in separate arrays.
+     */
+    class SparseGridTable
+    {
+      public:
+        /**
+         * A structure that describes one cell of the grid: Its integer
+         * coordinates, along with the number of samples that fell into it
+         * and the sum of their weights.
+         */
+        struct Cell
+        {
+          std::vector<std::int64_t> index;
+          types::sample_index       n_samples;
+          double                    weight;
+        };
+
+        /**
+         * Constructor. Create an empty table for cells in a space of the
+         * given dimension. (The default argument only exists so that the
+         * states of ShardedAccumulator objects that contain a table can be
+         * default-constructed; such states need to be initialized with a
+         * table of the correct dimension.)
+         */
+        SparseGridTable (const unsigned int dimension = 1);
+
+        /**
+         * Add the given number of samples with the given sum of weights to
+         * the cell with the given coordinates, creating the cell if it does
+         * not exist yet. `index` must point to `dimension` coordinates,
+         * and `n_samples` must be positive.
+         */
+        void
+        add (const std::int64_t        *index,
+             const types::sample_index  n_samples,
+             const double               weight);
+
+        /**
+         * Return the number of cells that contain samples.
+         */
+        std::size_t
+        size () const;
+
+        /**
+         * Call the given function as `function(index, n_samples, weight)`
+         * for each cell that contains samples, where `index` points to the
+         * `dimension` coordinates of the cell. The order in which cells are
+         * visited is unspecified. This avoids the memory allocations of
+         * sorted_cells() for callers that store cells in their own format.
+         */
+        template <typename Function>
+        void
+        for_each_cell (const Function &function) const;
+
+        /**
+         * Return all cells that contain samples, sorted lexicographically
+         * by their coordinates.
+         */
+        std::vector<Cell>
+        sorted_cells () const;
+
+      private:
+        /**
+         * The dimension of the space.
+         */
+        unsigned int dimension;
+
+        /**
+         * The keys, counts, and weights of the slots. Slots whose count is
+         * zero are empty.
+         */
+        std::vector<std::int64_t>        keys;
+        std::vector<types::sample_index> counts;
+        std::vector<double>              weights;
+
+        /**
+         * The number of slots that are not empty.
+         */
+        std::size_t n_occupied_slots;
+
+        /**
+         * Return the position of the slot that stores the cell with the
+         * given coordinates or, if the table does not contain this cell,
+         * of the empty slot in which it would have to be stored.
+         */
+        std::size_t
+        find_slot (const std::int64_t *index) const;
+    };
+
+
+
+    inline
+    SparseGridTable::SparseGridTable (const unsigned int dimension)
+      :
+      dimension (dimension),
+      keys (16*dimension, 0),
+      counts (16, 0),
+      weights (16, 0.),
+      n_occupied_slots (0)
+    {
+      assert (dimension >= 1);
+    }
+
+
+
+    inline
+    void
+    SparseGridTable::add (const std::int64_t        *index,
+                          const types::sample_index  n_samples,
+                          const double               weight)
+    {
+      assert (n_samples > 0);
+
+      std::size_t slot = find_slot (index);
+      if (counts[slot] == 0)
+        {
+          // This is a new cell. If adding it would make the table more
+          // than half full, then first double its size and re-insert the
+          // existing cells:
+          if (2*(n_occupied_slots+1) > counts.size())
+            {
+              const std::size_t n_slots = 2*counts.size();
+
+              std::vector<std::int64_t>        old_keys (n_slots*dimension, 0);
+              std::vector<types::sample_index> old_counts (n_slots, 0);
+              std::vector<double>              old_weights (n_slots, 0.);
+              old_keys.swap (keys);
+              old_counts.swap (counts);
+              old_weights.swap (weights);
+
+              for (std::size_t s=0; s<old_counts.size(); ++s)
+                if (old_counts[s] != 0)
+                  {
+                    const std::size_t new_slot = find_slot (&old_keys[s*dimension]);
+                    std::copy_n (&old_keys[s*dimension], dimension, &keys[new_slot*dimension]);
+                    counts[new_slot]  = old_counts[s];
+                    weights[new_slot] = old_weights[s];
+                  }
+
+              slot = find_slot (index);
+            }
+
+          std::copy_n (index, dimension, &keys[slot*dimension]);
+          ++n_occupied_slots;
+        }
+
+      counts[slot]  += n_samples;
+      weights[slot] += weight;
+    }
+
+
+
+    inline
+    std::size_t
+    SparseGridTable::size () const
+    {
+      return n_occupied_slots;
+    }
+
+
+
+    template <typename Function>
+    void
+    SparseGridTable::for_each_cell (const Function &function) const
+    {
+      for (std::size_t s=0; s<counts.size(); ++s)
+        if (counts[s] != 0)
+          function (&keys[s*dimension], counts[s], weights[s]);
+    }
+
+
+
+    inline
+    std::vector<SparseGridTable::Cell>
+    SparseGridTable::sorted_cells () const
+    {
+      std::vector<Cell> cells;
+      cells.reserve (n_occupied_slots);
+      for_each_cell ([this, &cells](const std::int64_t        *index,
+                                    const types::sample_index  n_samples,
+                                    const double               weight)
+      {
+        cells.push_back ({std::vector<std::int64_t>(index, index+dimension),
+                          n_samples, weight
+                         });
+      });
+
+      std::sort (cells.begin(), cells.end(),
+                 [](const Cell &a, const Cell &b)
+      {
+        return a.index < b.index;
+      });
+
+      return cells;
+    }
+
+
+
+    inline
+    std::size_t
+    SparseGridTable::find_slot (const std::int64_t *index) const
+    {
+      // Combine the coordinates one after the other, and then scramble
+      // the bits of the result using the finalization step of the
+      // MurmurHash3 function. The scrambling is necessary because
+      // neighboring cells have coordinates that differ only in their
+      // lowest bits, and linear probing degrades badly if these cells end
+      // up in neighboring slots.
+      std::uint64_t hash = 0;
+      for (unsigned int d=0; d<dimension; ++d)
+        hash = (hash * 0x9e3779b97f4a7c15ULL) ^ static_cast<std::uint64_t>(index[d]);
+      hash ^= (hash >> 33);
+      hash *= 0xff51afd7ed558ccdULL;
+      hash ^= (hash >> 33);
+      hash *= 0xc4ceb9fe1a85ec53ULL;
+      hash ^= (hash >> 33);
+
+      const std::size_t mask = counts.size() - 1;
+      for (std::size_t slot = hash & mask; ; slot = (slot+1) & mask)
+        if ((counts[slot] == 0)
+            ||
+            std::equal (index, index+dimension, &keys[slot*dimension]))
+          return slot;
+    }
+  }
+}
@@ -0,0 +1,99 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for the classes that connect SampleFlow to the Threading
+   * Building Blocks (TBB) library. Like the classes in namespaces MPI and
+   * HDF5, these classes are not included in the SampleFlow module
+   * and require linking with the external library.
+   */
+  namespace TBB
+  {
+    /**
+     * An implementation of the Executor interface that runs tasks in a TBB
+     * task arena, i.e., on the threads that TBB manages for that arena.
+     * This is the appropriate choice for applications that already use TBB
+     * and that want SampleFlow to share TBB's threads rather than to
+     * create threads of its own:
+     * @code
+     *   tbb::task_arena arena;
+     *   SampleFlow::ThreadPool::set_default_pool
+     *     (std::make_shared<SampleFlow::ThreadPool>
+     *      (std::make_shared<SampleFlow::TBB::Executor>(arena)));
+     * @endcode
+     */
+    class Executor : public SampleFlow::Executor
+    {
+      public:
+        /**
+         * Constructor. Tasks are enqueued in the given arena, which is
+         * initialized if that has not happened yet. The arena must live at
+         * least as long as the current object.
+         */
+        Executor (tbb::task_arena &arena);
+
+        /**
+         * Enqueue the given task in the arena.
+         */
+        virtual
+        void
+        execute (std::function<void ()> &&task) override;
+
+        /**
+         * Return the maximal concurrency of the arena.
+         */
+        virtual
+        unsigned int
+        concurrency () const override;
+
+      private:
+        /**
+         * The arena in which tasks are run.
+         */
+        tbb::task_arena &arena;
+    };
+
+
+
+    inline
+    Executor::Executor (tbb::task_arena &arena)
+      :
+      arena (arena)
+    {
+      arena.initialize ();
+    }
+
+
+
+    inline
+    void
+    Executor::execute (std::function<void ()> &&task)
+    {
+      arena.enqueue (std::move(task));
+    }
+
+
+
+    inline
+    unsigned int
+    Executor::concurrency () const
+    {
+      return arena.max_concurrency();
+    }
+  }
+}
@@ -0,0 +1,40 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_THREAD_POOL_H
+#define SAMPLEFLOW_THREAD_POOL_H
+
+#include <sampleflow/config.h>
+#include <sampleflow/executor.h>
+#include <sampleflow/parallel_mode.h>
+#include <sampleflow/topology.h>
+#include <sampleflow/tracing.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/thread_pool.impl.h>
+
+#endif
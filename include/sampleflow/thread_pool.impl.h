@@ -0,0 +1,987 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A class that represents a fixed set of long-lived worker threads to
+   * which one can hand tasks (function objects) for execution at a later
+   * time. This is what backs ParallelMode::asynchronous: Rather than
+   * creating a new task via `std::async` for every incoming sample (which
+   * with common C++ standard library implementations means creating a new
+   * operating system thread for every sample), consumers and filters that
+   * process samples asynchronously package up the work that needs to be done
+   * for each sample and enqueue it with an object of the current type.
+   *
+   * Each worker thread has its own queue of tasks. If a task is enqueued from
+   * one of the worker threads (for example, because an asynchronous filter
+   * sends a sample to an asynchronous consumer downstream), then it is placed
+   * into that worker's own queue; otherwise, tasks are distributed among the
+   * queues in a round-robin fashion. Workers first work on tasks in their own
+   * queue, and if that is empty "steal" tasks from the queues of other
+   * workers. This "work stealing" strategy keeps all workers busy without
+   * having them all contend for a single, central queue.
+   *
+   * By default, all consumers and filters share one pool, returned by
+   * default_pool(), that has as many worker threads as the machine has
+   * processor cores. Different pipelines can be made to use separate pools,
+   * or to share a pool of a specific size, by creating a ThreadPool object
+   * (wrapped in a `std::shared_ptr`) and passing it to
+   * Consumer::set_thread_pool().
+   *
+   * Keeping track of whether the tasks that have been enqueued on behalf of
+   * a specific consumer have finished is done using objects of type
+   * ThreadPool::TaskGroup.
+   *
+   * Rather than creating its own worker threads, a pool can also hand all
+   * of its tasks to another object derived from the Executor interface --
+   * for example, one that runs them in a TBB task arena (see
+   * TBB::Executor) or as OpenMP tasks (see OpenMP::Executor). This is
+   * how applications that already manage their own threads make
+   * SampleFlow use them, either for all pipelines (via
+   * set_default_pool()) or for specific objects only.
+   *
+   * On machines with several NUMA nodes (typically, several sockets), a
+   * pool can be asked to bind its worker threads to processor cores so
+   * that consecutive workers sit on different nodes (see Placement). Since
+   * tasks enqueued from outside the pool are distributed round-robin among
+   * the workers, consecutive tasks -- for example, the chains started by
+   * Producers::MetropolisHastings::sample_chains() -- then run on
+   * alternating nodes, and because workers are not moved between cores,
+   * the memory a task allocates and first writes to stays on the node
+   * the task runs on.
+   *
+   * Tasks can be enqueued with one of the priorities listed in the
+   * Priority `enum`. Workers then take tasks of priority Priority::critical
+   * (from their own queue or from that of other workers) before any task
+   * of priority Priority::normal, and these before any task of priority
+   * Priority::low. Consumers enqueue the tasks that process their samples
+   * with the priority set via Consumer::set_priority(). Tasks that have
+   * already started are not interrupted, however.
+   *
+   * @note Tasks executed by the pool must not throw exceptions. An exception
+   *   that escapes from a task terminates the program, just like an exception
+   *   escaping from the function run by a `std::thread`.
+   */
+  class ThreadPool : public Executor
+  {
+    public:
+      /**
+       * A class that keeps track of a set of tasks that have been enqueued
+       * with a ThreadPool, and that allows waiting for all of them to
+       * finish. This replaces the pattern of storing a `std::future` for
+       * every task and then waiting on all of them in turn.
+       *
+       * Consumer objects use one object of this type to keep track of all
+       * of the samples they have been sent but not yet processed; the
+       * Consumer::flush() function then just calls wait().
+       */
+      class TaskGroup
+      {
+        public:
+          /**
+           * Constructor.
+           */
+          TaskGroup ();
+
+          /**
+           * Destructor. Waits for all tasks still pending to finish.
+           */
+          ~TaskGroup ();
+
+          /**
+           * Enqueue the given task with the given thread pool and priority,
+           * and record that it is part of the current group.
+           */
+          void
+          run (ThreadPool &thread_pool,
+               std::function<void ()> &&task,
+               const Priority priority = Priority::normal);
+
+          /**
+           * Wait for all tasks that have been started via run() to finish.
+           * If this function is called on one of the worker threads of a
+           * thread pool, then it does not just wait, but executes other
+           * pending tasks of that pool in the meantime; this avoids a
+           * dead-lock in situations where all worker threads would
+           * otherwise be waiting for tasks that none of them can get to.
+           */
+          void
+          wait ();
+
+          /**
+           * Return the number of tasks that have been started via run() but
+           * that have not finished yet.
+           */
+          std::size_t
+          n_pending_tasks () const;
+
+        private:
+          /**
+           * The number of tasks that have been enqueued but have not finished
+           * yet.
+           */
+          std::atomic<std::size_t> n_pending;
+
+          /**
+           * A mutex and condition variable used to wait for n_pending to
+           * reach zero. The last decrement to zero always happens while
+           * holding the mutex, so that a thread that has waited for the
+           * group to become empty can safely destroy the object.
+           */
+          mutable std::mutex      mutex;
+          std::condition_variable all_done;
+
+          /**
+           * Record that one of the tasks of this group has finished.
+           */
+          void
+          task_finished ();
+      };
+
+
+      /**
+       * An enumeration describing where the worker threads of a pool are
+       * allowed to run.
+       */
+      enum class Placement
+      {
+        /**
+         * Let the operating system decide on which cores the worker threads
+         * run, and move them between cores as it sees fit.
+         */
+        unbound,
+
+        /**
+         * Bind each worker thread to one core, choosing the cores so that
+         * consecutive workers are placed on different NUMA nodes (see
+         * Topology::round_robin_cpus()). On systems where threads cannot be
+         * bound to cores, this is the same as `unbound`.
+         */
+        numa_round_robin
+      };
+
+
+      /**
+       * Constructor.
+       *
+       * @param[in] n_threads The number of worker threads this pool should
+       *   create. If zero (the default), the number is chosen as the number
+       *   of processor cores reported by `std::thread::hardware_concurrency()`
+       *   (or one, if that function cannot determine the number of cores).
+       * @param[in] placement Where the worker threads are allowed to run.
+       */
+      ThreadPool (const unsigned int n_threads = 0,
+                  const Placement    placement = Placement::unbound);
+
+      /**
+       * Constructor for a pool that does not have worker threads of its
+       * own, but has the given executor run its tasks. n_threads() then
+       * returns what the executor reports as its concurrency.
+       *
+       * Enqueued tasks are still placed into a queue owned by the pool,
+       * and for each task, the executor is asked to run a function that
+       * takes a task from that queue and executes it. This way,
+       * run_pending_task() works as for a pool with its own worker
+       * threads, and threads that wait for tasks -- for example, in
+       * TaskGroup::wait() -- can execute pending tasks in the meantime,
+       * rather than blocking one of the threads of the executor.
+       * Furthermore, while a task runs, current_pool() returns the pool on
+       * whose behalf it runs, even though the thread is not a worker of
+       * the pool.
+       */
+      explicit
+      ThreadPool (const std::shared_ptr<Executor> &executor);
+
+      /**
+       * Copy constructor. Thread pools cannot be copied, and so this
+       * constructor is deleted.
+       */
+      ThreadPool (const ThreadPool &) = delete;
+
+      /**
+       * Destructor. Executes all tasks that have already been enqueued
+       * and then shuts down the worker threads. If the pool hands its
+       * tasks to an executor, then wait for all tasks handed to the
+       * executor to finish.
+       */
+      ~ThreadPool ();
+
+      /**
+       * Return the number of worker threads of this pool.
+       */
+      unsigned int
+      n_threads () const;
+
+      /**
+       * Return the NUMA node the worker thread with the given index is
+       * bound to. If the workers are not bound to cores (see Placement),
+       * return the node the worker was running on when it started.
+       */
+      unsigned int
+      numa_node_of_worker (const unsigned int worker_index) const;
+
+      /**
+       * Enqueue a task for execution on one of the worker threads. Tasks
+       * with higher priority are executed before tasks with lower priority
+       * that have been enqueued before.
+       */
+      void
+      enqueue (std::function<void ()> &&task,
+               const Priority priority = Priority::normal);
+
+      /**
+       * Implementation of the Executor interface: This function is the
+       * same as enqueue() with Priority::normal.
+       */
+      virtual
+      void
+      execute (std::function<void ()> &&task) override;
+
+      /**
+       * Implementation of the Executor interface: This function is the
+       * same as n_threads().
+       */
+      virtual
+      unsigned int
+      concurrency () const override;
+
+      /**
+       * If there is a task that has been enqueued but not started yet,
+       * remove it from its queue and execute it on the current thread.
+       *
+       * @return Whether a task was found and executed.
+       */
+      bool
+      run_pending_task ();
+
+      /**
+       * Set how worker threads of this pool wait for new tasks once there
+       * are none left, i.e., how long they look for new tasks before they
+       * go to sleep. See the WaitPolicy structure for more information.
+       * enqueue() only wakes up a worker if one is actually sleeping, and
+       * so workers that look for new tasks a bit longer save it this work
+       * if tasks are enqueued at a high rate -- for example, by consumers
+       * in ParallelMode::asynchronous that receive samples at a high rate.
+       * The default is a default-constructed WaitPolicy object.
+       *
+       * This function can be called at any time. The new policy applies
+       * the next time a worker runs out of tasks.
+       */
+      void
+      set_wait_policy (const WaitPolicy &wait_policy);
+
+      /**
+       * Split the range of indices $[0,n)$ into chunks, call `f(begin,end)`
+       * for each chunk on a task executed by this pool, and return once all
+       * of them have finished. There are a few chunks per worker thread, so
+       * that threads that finish early can pick up some of the remaining
+       * work. If there is only one chunk, `f` is called on the current
+       * thread.
+       */
+      void
+      for_each_chunk (const std::size_t n,
+                      const std::function<void (const std::size_t, const std::size_t)> &f);
+
+      /**
+       * Return the pool used by all consumers and filters for which no
+       * other pool has been set via Consumer::set_thread_pool(). Unless
+       * set_default_pool() has been called before, this pool is created
+       * upon the first call to this function with as many worker threads
+       * as there are processor cores.
+       */
+      static
+      std::shared_ptr<ThreadPool>
+      default_pool ();
+
+      /**
+       * Replace the pool returned by default_pool(). This affects only
+       * those consumers and filters that are set up for asynchronous
+       * processing after this function has been called; objects that
+       * already use the previous default pool keep a reference to it
+       * and continue to use it.
+       */
+      static
+      void
+      set_default_pool (const std::shared_ptr<ThreadPool> &thread_pool);
+
+      /**
+       * If the current thread is a worker thread of a ThreadPool object,
+       * return a pointer to that pool. Otherwise, return `nullptr`.
+       */
+      static
+      ThreadPool *
+      current_pool ();
+
+    private:
+      /**
+       * The executor that runs the tasks, if the pool was created from
+       * one. In that case, the pool has no worker threads and only one
+       * queue, and `n_executor_tasks` counts the functions that have been
+       * handed to the executor but have not finished yet.
+       */
+      const std::shared_ptr<Executor> executor;
+      std::atomic<std::size_t>        n_executor_tasks;
+
+      /**
+       * The number of different values of the Priority `enum`.
+       */
+      static constexpr unsigned int n_priorities = 3;
+
+      /**
+       * A structure that represents the queues of tasks associated with
+       * one worker thread, one queue for each priority.
+       */
+      struct WorkQueue
+      {
+        std::mutex                                                   mutex;
+        std::array<std::deque<std::function<void ()>>,n_priorities> tasks;
+      };
+
+      /**
+       * The queues of tasks, one per worker thread.
+       */
+      std::vector<std::unique_ptr<WorkQueue>> work_queues;
+
+      /**
+       * The worker threads, and the NUMA nodes they run on.
+       */
+      std::vector<std::thread>               workers;
+      std::vector<std::atomic<unsigned int>> worker_numa_nodes;
+
+      /**
+       * The queue into which the next task enqueued from a thread that is
+       * not a worker of this pool will be placed.
+       */
+      std::atomic<unsigned int> next_queue;
+
+      /**
+       * The total number of tasks currently sitting in any of the queues,
+       * and the number of those with each of the priorities.
+       */
+      std::atomic<std::size_t>                          n_queued_tasks;
+      std::array<std::atomic<std::size_t>,n_priorities> n_queued_tasks_by_priority;
+
+      /**
+       * The number of worker threads currently waiting for work.
+       */
+      std::atomic<unsigned int> n_sleeping_workers;
+
+      /**
+       * The two members of the WaitPolicy set via set_wait_policy(),
+       * stored as atomic variables so that the workers can read them while
+       * the policy is changed.
+       */
+      std::atomic<unsigned int> n_wait_spins;
+      std::atomic<unsigned int> n_wait_yields;
+
+      /**
+       * A mutex and condition variable used to let worker threads sleep
+       * while there is no work, and to wake them up again when there is.
+       */
+      std::mutex              sleep_mutex;
+      std::condition_variable wake_up;
+
+      /**
+       * Whether the destructor has been called. Access is protected by
+       * `sleep_mutex`.
+       */
+      bool shutting_down;
+
+      /**
+       * The pool the current thread is a worker of (if any), along with
+       * the index of the worker.
+       */
+      static inline thread_local ThreadPool   *this_thread_pool         = nullptr;
+      static inline thread_local unsigned int  this_thread_worker_index = 0;
+
+      /**
+       * Try to obtain a task of the highest priority for which tasks are
+       * waiting, first from the queue with the given index (taking the
+       * most recently added task), and then from all other queues (taking
+       * the oldest task).
+       */
+      bool
+      try_get_task (const unsigned int own_queue,
+                    std::function<void ()> &task);
+
+      /**
+       * The function run by each of the worker threads.
+       */
+      void
+      worker_loop (const unsigned int worker_index,
+                   const int          cpu);
+
+      /**
+       * Return a reference to the object that stores the default pool.
+       */
+      static
+      std::shared_ptr<ThreadPool> &
+      default_pool_storage ();
+
+      /**
+       * A mutex that protects accessing the default pool.
+       */
+      static
+      std::mutex &
+      default_pool_mutex ();
+  };
+
+
+
+  inline
+  ThreadPool::TaskGroup::TaskGroup ()
+    :
+    n_pending (0)
+  {}
+
+
+
+  inline
+  ThreadPool::TaskGroup::~TaskGroup ()
+  {
+    wait ();
+  }
+
+
+
+  inline
+  void
+  ThreadPool::TaskGroup::
+  run (ThreadPool &thread_pool,
+       std::function<void ()> &&task,
+       const Priority priority)
+  {
+    ++n_pending;
+    thread_pool.enqueue ([this, task = std::move(task)]() mutable
+    {
+      // Run the task and destroy it (along with everything it may
+      // have captured) before we report back that it has finished.
+      {
+        std::function<void ()> t = std::move(task);
+        t();
+      }
+      task_finished();
+    },
+    priority);
+  }
+
+
+
+  inline
+  void
+  ThreadPool::TaskGroup::
+  task_finished ()
+  {
+    // Decrement the counter without a lock as long as we are not the
+    // last task. The last task needs to do its decrement under the lock
+    // so that a thread in wait() cannot observe the counter at zero,
+    // return, and destroy the current object while we still need to
+    // notify it.
+    std::size_t remaining = n_pending.load();
+    while (true)
+      {
+        assert (remaining > 0);
+        if (remaining > 1)
+          {
+            if (n_pending.compare_exchange_weak (remaining, remaining-1))
+              return;
+          }
+        else
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            if (n_pending.compare_exchange_strong (remaining, 0))
+              {
+                all_done.notify_all();
+                return;
+              }
+          }
+      }
+  }
+
+
+
+  inline
+  void
+  ThreadPool::TaskGroup::
+  wait ()
+  {
+    if (ThreadPool *const pool = ThreadPool::current_pool())
+      {
+        // We are on a worker thread. Help with pending work until
+        // our own tasks are done.
+        while (n_pending.load() > 0)
+          if (pool->run_pending_task() == false)
+            std::this_thread::yield();
+
+        // Acquire the lock once to make sure that whoever decremented
+        // the counter to zero is done touching the current object.
+        std::lock_guard<std::mutex> lock (mutex);
+      }
+    else
+      {
+        std::unique_lock<std::mutex> lock (mutex);
+        all_done.wait (lock, [this]()
+        {
+          return (n_pending.load() == 0);
+        });
+      }
+  }
+
+
+
+  inline
+  std::size_t
+  ThreadPool::TaskGroup::
+  n_pending_tasks () const
+  {
+    return n_pending.load();
+  }
+
+
+
+  inline
+  ThreadPool::ThreadPool (const unsigned int n_threads,
+                          const Placement    placement)
+    :
+    next_queue (0),
+    n_queued_tasks (0),
+    n_queued_tasks_by_priority {},
+    n_sleeping_workers (0),
+    n_wait_spins (WaitPolicy().n_spins),
+    n_wait_yields (WaitPolicy().n_yields),
+    shutting_down (false)
+  {
+    const unsigned int n_workers
+      = (n_threads != 0 ?
+         n_threads :
+         std::max (1U, std::thread::hardware_concurrency()));
+
+    // First create all queues, then the threads. The threads may
+    // start looking into the queues of other threads right away.
+    for (unsigned int i=0; i<n_workers; ++i)
+      work_queues.emplace_back (std::make_unique<WorkQueue>());
+    worker_numa_nodes = std::vector<std::atomic<unsigned int>> (n_workers);
+
+    std::vector<int> cpus (n_workers, -1);
+    if (placement == Placement::numa_round_robin)
+      {
+        const std::vector<unsigned int> round_robin_cpus = Topology::round_robin_cpus (n_workers);
+        std::copy (round_robin_cpus.begin(), round_robin_cpus.end(), cpus.begin());
+      }
+
+    for (unsigned int i=0; i<n_workers; ++i)
+      {
+        worker_numa_nodes[i] = (cpus[i] >= 0 ? Topology::numa_node_of_cpu (cpus[i]) : 0);
+        workers.emplace_back ([this, i, cpu = cpus[i]]()
+        {
+          worker_loop (i, cpu);
+        });
+      }
+  }
+
+
+
+  inline
+  ThreadPool::ThreadPool (const std::shared_ptr<Executor> &executor)
+    :
+    executor (executor),
+    n_executor_tasks (0),
+    next_queue (0),
+    n_queued_tasks (0),
+    n_queued_tasks_by_priority {},
+    n_sleeping_workers (0),
+    n_wait_spins (WaitPolicy().n_spins),
+    n_wait_yields (WaitPolicy().n_yields),
+    shutting_down (false)
+  {
+    assert (executor != nullptr);
+
+    work_queues.emplace_back (std::make_unique<WorkQueue>());
+  }
+
+
+
+  inline
+  ThreadPool::~ThreadPool ()
+  {
+    if (executor != nullptr)
+      {
+        std::unique_lock<std::mutex> lock (sleep_mutex);
+        wake_up.wait (lock, [this]()
+        {
+          return (n_executor_tasks.load() == 0);
+        });
+        return;
+      }
+
+    {
+      std::lock_guard<std::mutex> lock (sleep_mutex);
+      shutting_down = true;
+    }
+    wake_up.notify_all();
+
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+
+
+  inline
+  unsigned int
+  ThreadPool::n_threads () const
+  {
+    if (executor != nullptr)
+      return executor->concurrency();
+    else
+      return workers.size();
+  }
+
+
+
+  inline
+  unsigned int
+  ThreadPool::numa_node_of_worker (const unsigned int worker_index) const
+  {
+    if (executor != nullptr)
+      return 0;
+
+    assert (worker_index < worker_numa_nodes.size());
+    return worker_numa_nodes[worker_index].load();
+  }
+
+
+
+  inline
+  void
+  ThreadPool::enqueue (std::function<void ()> &&task,
+                       const Priority priority)
+  {
+    const unsigned int priority_index = static_cast<unsigned int>(priority);
+    assert (priority_index < n_priorities);
+
+    if (executor != nullptr)
+      {
+        ++n_queued_tasks;
+        ++n_queued_tasks_by_priority[priority_index];
+        {
+          std::lock_guard<std::mutex> lock (work_queues[0]->mutex);
+          work_queues[0]->tasks[priority_index].emplace_back (std::move(task));
+        }
+
+        // Ask the executor to run one task from our queue -- not
+        // necessarily the one just added (but the one with the highest
+        // priority), and possibly none at all if
+        // another thread has already taken them all via
+        // run_pending_task(). The counter lets the destructor wait for
+        // these functions; its last decrement happens under the lock so
+        // that the destructor cannot return (and the current object go
+        // away) while we are still notifying it.
+        ++n_executor_tasks;
+        executor->execute ([this]()
+        {
+          std::function<void ()> task;
+          if (try_get_task (0, task))
+            {
+              ThreadPool *const   previous_pool         = this_thread_pool;
+              const unsigned int  previous_worker_index = this_thread_worker_index;
+              this_thread_pool         = this;
+              this_thread_worker_index = 0;
+
+              {
+                Tracing::Span span ("task", "thread pool", this);
+                task();
+              }
+              task = nullptr;
+
+              this_thread_pool         = previous_pool;
+              this_thread_worker_index = previous_worker_index;
+            }
+
+          std::lock_guard<std::mutex> lock (sleep_mutex);
+          if (--n_executor_tasks == 0)
+            wake_up.notify_all();
+        });
+        return;
+      }
+
+    // If we are on one of our own worker threads, put the task into
+    // that worker's queue. Otherwise distribute tasks round-robin.
+    const unsigned int queue
+      = (this_thread_pool == this ?
+         this_thread_worker_index :
+         next_queue.fetch_add(1) % work_queues.size());
+
+    // Count the task before it becomes visible in the queue, so that a
+    // worker that takes it right away cannot decrement the counter below
+    // zero.
+    ++n_queued_tasks;
+    ++n_queued_tasks_by_priority[priority_index];
+    {
+      std::lock_guard<std::mutex> lock (work_queues[queue]->mutex);
+      work_queues[queue]->tasks[priority_index].emplace_back (std::move(task));
+    }
+
+    // Wake up a sleeping worker, if there is one. A worker that is about
+    // to go to sleep first increments n_sleeping_workers and then checks
+    // n_queued_tasks, which we have already incremented above; so either
+    // it sees the new task, or we see it as sleeping.
+    if (n_sleeping_workers.load() > 0)
+      {
+        {
+          std::lock_guard<std::mutex> lock (sleep_mutex);
+        }
+        wake_up.notify_one();
+      }
+  }
+
+
+
+  inline
+  bool
+  ThreadPool::try_get_task (const unsigned int own_queue,
+                            std::function<void ()> &task)
+  {
+    if (n_queued_tasks.load() == 0)
+      return false;
+
+    // Go through the priorities, starting with the highest one, and skip
+    // those for which no tasks are waiting:
+    for (unsigned int p=0; p<n_priorities; ++p)
+      {
+        if (n_queued_tasks_by_priority[p].load() == 0)
+          continue;
+
+        // Look into our own queue first, and take the most recently added
+        // task since its data is most likely still in the cache:
+        {
+          WorkQueue &queue = *work_queues[own_queue];
+          std::lock_guard<std::mutex> lock (queue.mutex);
+          if (queue.tasks[p].size() > 0)
+            {
+              task = std::move (queue.tasks[p].back());
+              queue.tasks[p].pop_back();
+              --n_queued_tasks_by_priority[p];
+              --n_queued_tasks;
+              return true;
+            }
+        }
+
+        // Then try to steal the oldest task from one of the other queues:
+        for (unsigned int i=1; i<work_queues.size(); ++i)
+          {
+            WorkQueue &queue = *work_queues[(own_queue + i) % work_queues.size()];
+            std::lock_guard<std::mutex> lock (queue.mutex);
+            if (queue.tasks[p].size() > 0)
+              {
+                task = std::move (queue.tasks[p].front());
+                queue.tasks[p].pop_front();
+                --n_queued_tasks_by_priority[p];
+                --n_queued_tasks;
+                return true;
+              }
+          }
+      }
+
+    return false;
+  }
+
+
+
+  inline
+  void
+  ThreadPool::set_wait_policy (const WaitPolicy &wait_policy)
+  {
+    n_wait_spins  = wait_policy.n_spins;
+    n_wait_yields = wait_policy.n_yields;
+  }
+
+
+
+  inline
+  void
+  ThreadPool::execute (std::function<void ()> &&task)
+  {
+    enqueue (std::move(task));
+  }
+
+
+
+  inline
+  unsigned int
+  ThreadPool::concurrency () const
+  {
+    return n_threads();
+  }
+
+
+
+  inline
+  void
+  ThreadPool::for_each_chunk (const std::size_t n,
+                              const std::function<void (const std::size_t, const std::size_t)> &f)
+  {
+    const std::size_t n_chunks
+      = std::min<std::size_t> (n, 4 * std::max (n_threads(), 1U));
+    if (n_chunks <= 1)
+      {
+        f (0, n);
+        return;
+      }
+
+    TaskGroup chunks;
+    for (std::size_t c=0; c<n_chunks; ++c)
+      chunks.run (*this,
+                  [&f, c, n, n_chunks]()
+    {
+      f (c * n / n_chunks, (c+1) * n / n_chunks);
+    });
+    chunks.wait();
+  }
+
+
+
+  inline
+  bool
+  ThreadPool::run_pending_task ()
+  {
+    const unsigned int own_queue
+      = (this_thread_pool == this ?
+         this_thread_worker_index :
+         0);
+
+    std::function<void ()> task;
+    if (try_get_task (own_queue, task))
+      {
+        {
+          Tracing::Span span ("task", "thread pool", this);
+          task();
+        }
+        return true;
+      }
+    else
+      return false;
+  }
+
+
+
+  inline
+  void
+  ThreadPool::worker_loop (const unsigned int worker_index,
+                           const int          cpu)
+  {
+    this_thread_pool         = this;
+    this_thread_worker_index = worker_index;
+
+    // Bind the thread to its core before it touches any memory, or
+    // otherwise record where the operating system happened to start it:
+    if ((cpu >= 0) && Topology::bind_current_thread_to_cpu (cpu))
+      worker_numa_nodes[worker_index] = Topology::numa_node_of_cpu (cpu);
+    else
+      worker_numa_nodes[worker_index] = Topology::current_numa_node();
+
+    std::function<void ()> task;
+    while (true)
+      {
+        if (try_get_task (worker_index, task))
+          {
+            {
+              Tracing::Span span ("task", "thread pool", this);
+              task();
+            }
+            task = nullptr;
+            continue;
+          }
+
+        // There is nothing to do. Look for new tasks for a little while,
+        // without counting as sleeping (see WaitPolicy), and then go to
+        // sleep until there is something to do, or until we are asked to
+        // shut down and there is no more work left.
+        const WaitPolicy wait_policy {n_wait_spins.load(), n_wait_yields.load()};
+        const auto task_arrived = [this]()
+        {
+          return (n_queued_tasks.load() > 0);
+        };
+        if (internal::spin_then_yield (wait_policy, task_arrived))
+          continue;
+
+        std::unique_lock<std::mutex> lock (sleep_mutex);
+        if (shutting_down && (n_queued_tasks.load() == 0))
+          return;
+
+        ++n_sleeping_workers;
+        wake_up.wait (lock, [this]()
+        {
+          return (shutting_down || (n_queued_tasks.load() > 0));
+        });
+        --n_sleeping_workers;
+      }
+  }
+
+
+
+  inline
+  std::shared_ptr<ThreadPool> &
+  ThreadPool::default_pool_storage ()
+  {
+    static std::shared_ptr<ThreadPool> pool;
+    return pool;
+  }
+
+
+
+  inline
+  std::mutex &
+  ThreadPool::default_pool_mutex ()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+
+
+  inline
+  std::shared_ptr<ThreadPool>
+  ThreadPool::default_pool ()
+  {
+    std::lock_guard<std::mutex> lock (default_pool_mutex());
+
+    std::shared_ptr<ThreadPool> &pool = default_pool_storage();
+    if (pool == nullptr)
+      pool = std::make_shared<ThreadPool>();
+    return pool;
+  }
+
+
+
+  inline
+  void
+  ThreadPool::set_default_pool (const std::shared_ptr<ThreadPool> &thread_pool)
+  {
+    assert (thread_pool != nullptr);
+
+    std::lock_guard<std::mutex> lock (default_pool_mutex());
+    default_pool_storage() = thread_pool;
+  }
+
+
+
+  inline
+  ThreadPool *
+  ThreadPool::current_pool ()
+  {
+    return this_thread_pool;
+  }
+}
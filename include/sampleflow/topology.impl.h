@@ -0,0 +1,281 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for functions that describe how the processor cores of
+   * the machine are grouped into NUMA ("non-uniform memory access") nodes
+   * -- typically, one node per socket -- and that allow binding threads
+   * to specific cores.
+   *
+   * On machines with more than one NUMA node, accessing memory that is
+   * attached to another node is considerably slower than accessing local
+   * memory. Operating systems place a page of memory on the node of the
+   * thread that first writes to it ("first touch"). Consequently, data
+   * that a thread creates and then works on is local to that thread as
+   * long as the thread is not moved to a core of another node -- which is
+   * what binding threads to cores prevents. ThreadPool uses the functions
+   * in this namespace to bind its workers to cores if asked to (see
+   * ThreadPool::Placement), and ShardedAccumulator uses them to group its
+   * shards by node.
+   *
+   * The information is read from `/sys/devices/system/node` on Linux. On
+   * other systems, or if that information is not available, the functions
+   * in this namespace describe the machine as a single node that contains
+   * all cores, and binding threads to cores does nothing.
+   */
+  namespace Topology
+  {
+    /**
+     * Return the number of NUMA nodes of the machine. This is at least
+     * one.
+     */
+    unsigned int
+    n_numa_nodes ();
+
+    /**
+     * Return the (operating system) numbers of the cores that belong to
+     * the given NUMA node, in ascending order.
+     */
+    const std::vector<unsigned int> &
+    cpus_of_numa_node (const unsigned int node);
+
+    /**
+     * Return the NUMA node the given core belongs to.
+     */
+    unsigned int
+    numa_node_of_cpu (const unsigned int cpu);
+
+    /**
+     * Return the NUMA node of the core the current thread is running on.
+     * Unless the thread is bound to a core, the operating system may move
+     * it to a core of another node at any time, and the result is then
+     * only a hint.
+     */
+    unsigned int
+    current_numa_node ();
+
+    /**
+     * Return a list of `n` cores to which `n` threads can be bound so that
+     * consecutive threads are placed on different NUMA nodes: The list
+     * starts with the first core of each node, followed by the second core
+     * of each node, and so on. (Nodes with fewer cores than others drop out
+     * of the rotation once their cores are used up.) If `n` is larger than
+     * the number of cores, the list repeats.
+     */
+    std::vector<unsigned int>
+    round_robin_cpus (const unsigned int n);
+
+    /**
+     * Bind the current thread to the given core.
+     *
+     * @return Whether the operating system accepted the request.
+     */
+    bool
+    bind_current_thread_to_cpu (const unsigned int cpu);
+
+
+    namespace internal
+    {
+      /**
+       * Parse a list of cores as found in the `cpulist` files in
+       * `/sys/devices/system/node`, such as "0-3,8-11".
+       */
+      inline
+      std::vector<unsigned int>
+      parse_cpu_list (const std::string &list)
+      {
+        std::vector<unsigned int> cpus;
+        std::istringstream in (list);
+        std::string range;
+        while (std::getline (in, range, ','))
+          {
+            const std::size_t dash = range.find ('-');
+            try
+              {
+                const unsigned int first = std::stoul (range.substr (0, dash));
+                const unsigned int last  = (dash != std::string::npos ?
+                                            std::stoul (range.substr (dash+1)) :
+                                            first);
+                for (unsigned int cpu=first; cpu<=last; ++cpu)
+                  cpus.push_back (cpu);
+              }
+            catch (const std::exception &)
+              {
+                // Ignore empty or malformed entries
+              }
+          }
+        return cpus;
+      }
+
+
+      /**
+       * A description of the machine, determined once upon first use: For
+       * each NUMA node, the cores that belong to it.
+       */
+      struct Description
+      {
+        std::vector<std::vector<unsigned int>> node_cpus;
+      };
+
+
+      inline
+      Description
+      describe_machine ()
+      {
+        Description description;
+
+#ifdef __linux__
+        // Nodes are numbered consecutively, but there may be gaps (for
+        // example, for nodes without cores). Only keep nodes with cores.
+        for (unsigned int node=0; ; ++node)
+          {
+            std::ifstream in ("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!in)
+              {
+                // Allow for a few missing node numbers before giving up:
+                if (node > description.node_cpus.size() + 64)
+                  break;
+                continue;
+              }
+
+            std::string list;
+            std::getline (in, list);
+            std::vector<unsigned int> cpus = parse_cpu_list (list);
+            if (cpus.size() > 0)
+              description.node_cpus.emplace_back (std::move(cpus));
+          }
+#endif
+
+        if (description.node_cpus.size() == 0)
+          {
+            std::vector<unsigned int> cpus (std::max (1U, std::thread::hardware_concurrency()));
+            for (unsigned int i=0; i<cpus.size(); ++i)
+              cpus[i] = i;
+            description.node_cpus.emplace_back (std::move(cpus));
+          }
+
+        return description;
+      }
+
+
+      inline
+      const Description &
+      machine ()
+      {
+        static const Description description = describe_machine();
+        return description;
+      }
+    }
+
+
+
+    inline
+    unsigned int
+    n_numa_nodes ()
+    {
+      return internal::machine().node_cpus.size();
+    }
+
+
+
+    inline
+    const std::vector<unsigned int> &
+    cpus_of_numa_node (const unsigned int node)
+    {
+      assert (node < n_numa_nodes());
+      return internal::machine().node_cpus[node];
+    }
+
+
+
+    inline
+    unsigned int
+    numa_node_of_cpu (const unsigned int cpu)
+    {
+      const std::vector<std::vector<unsigned int>> &node_cpus = internal::machine().node_cpus;
+      for (unsigned int node=0; node<node_cpus.size(); ++node)
+        if (std::binary_search (node_cpus[node].begin(), node_cpus[node].end(), cpu))
+          return node;
+      return 0;
+    }
+
+
+
+    inline
+    unsigned int
+    current_numa_node ()
+    {
+      if (n_numa_nodes() == 1)
+        return 0;
+
+#ifdef __linux__
+      const int cpu = sched_getcpu();
+      if (cpu >= 0)
+        return numa_node_of_cpu (cpu);
+#endif
+      return 0;
+    }
+
+
+
+    inline
+    std::vector<unsigned int>
+    round_robin_cpus (const unsigned int n)
+    {
+      const std::vector<std::vector<unsigned int>> &node_cpus = internal::machine().node_cpus;
+
+      std::vector<unsigned int> all_cpus;
+      for (std::size_t i=0; ; ++i)
+        {
+          bool found_any = false;
+          for (const std::vector<unsigned int> &cpus : node_cpus)
+            if (i < cpus.size())
+              {
+                all_cpus.push_back (cpus[i]);
+                found_any = true;
+              }
+          if (found_any == false)
+            break;
+        }
+
+      std::vector<unsigned int> cpus (n);
+      for (unsigned int i=0; i<n; ++i)
+        cpus[i] = all_cpus[i % all_cpus.size()];
+      return cpus;
+    }
+
+
+
+    inline
+    bool
+    bind_current_thread_to_cpu (const unsigned int cpu)
+    {
+#ifdef __linux__
+      if (cpu >= CPU_SETSIZE)
+        return false;
+
+      cpu_set_t cpu_set;
+      CPU_ZERO (&cpu_set);
+      CPU_SET (cpu, &cpu_set);
+      return (pthread_setaffinity_np (pthread_self(), sizeof(cpu_set), &cpu_set) == 0);
+#else
+      (void)cpu;
+      return false;
+#endif
+    }
+  }
+}
@@ -0,0 +1,438 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for functions that record a trace of what a program using
+   * SampleFlow does, and when: Every time a producer sends a sample
+   * downstream, a consumer processes a sample or a batch or is flushed, a
+   * sampler evaluates a likelihood, or a thread pool runs a task, a
+   * "span" is recorded that says on which thread this happened, when it
+   * started, and how long it took. The trace can then be written in the
+   * JSON format of the Chrome trace viewer (see write_chrome_trace()),
+   * which can be displayed by `chrome://tracing` or by the Perfetto UI. This
+   * shows, for example, whether the samples of asynchronous consumers are
+   * really processed concurrently, or where the threads of a pool are idle
+   * while the chains of a sampler wait for each other.
+   *
+   * Tracing is switched on by start() and off by stop(). While it is off,
+   * recording a span costs a single load of an atomic variable. While it
+   * is on, it costs two reads of a clock and writing an Event into a
+   * buffer that belongs to the current thread, without any locks or
+   * contended atomic operations (except for the first span a thread
+   * records after start(), which registers the buffer). Since the
+   * buffers have a fixed size, each thread records at most as many spans
+   * as given to start(); further spans are dropped and counted (see
+   * n_dropped_events()). This makes it feasible to leave tracing switched
+   * on for short production runs.
+   */
+  namespace Tracing
+  {
+    /**
+     * The clock used for the time stamps of events.
+     */
+    using Clock = std::chrono::steady_clock;
+
+
+    /**
+     * A structure that describes one span recorded in a trace.
+     */
+    struct Event
+    {
+      /**
+       * What happened, for example "consume", and the kind of object that
+       * did it, for example "consumer". Both need to be string literals
+       * (or otherwise outlive the trace), since only the pointers are
+       * stored.
+       */
+      const char *name;
+      const char *category;
+
+      /**
+       * The object that did it, for example the consumer that processed
+       * a sample. This serves to distinguish events that belong to
+       * different objects of the same kind and may be a `nullptr`.
+       */
+      const void *object;
+
+      /**
+       * The start and end of the span.
+       */
+      Clock::time_point start;
+      Clock::time_point end;
+    };
+
+
+    /**
+     * Start recording a trace, discarding the events of any previous one.
+     * Each thread can record up to `max_events_per_thread` events. This
+     * function should not be called while other threads are recording
+     * spans, since some of their spans may then still end up in the old
+     * trace.
+     */
+    void
+    start (const std::size_t max_events_per_thread = (1 << 16));
+
+    /**
+     * Stop recording. The events recorded so far remain available to
+     * write_chrome_trace() until the next call to start().
+     */
+    void
+    stop ();
+
+    /**
+     * Return whether a trace is currently being recorded.
+     */
+    bool
+    is_enabled ();
+
+    /**
+     * Record a span with the given name, category, and object that
+     * started and ended at the given times, if a trace is being recorded.
+     * This is the function Span uses; it is useful by itself for spans
+     * that do not correspond to a scope, for example because they end on
+     * a different thread than the one they started on.
+     */
+    void
+    record (const char              *name,
+            const char              *category,
+            const void              *object,
+            const Clock::time_point  start,
+            const Clock::time_point  end);
+
+    /**
+     * Return the number of events recorded in the current (or last)
+     * trace, and the number of events that were dropped because the
+     * buffer of the thread that tried to record them was full.
+     */
+    std::size_t
+    n_events ();
+
+    std::size_t
+    n_dropped_events ();
+
+    /**
+     * Write the events of the current (or last) trace to the given stream,
+     * in the JSON format of the Chrome trace viewer: Each span becomes a
+     * "complete" event (phase "X") with time stamps in microseconds since
+     * the call to start(), and with the address of the object that
+     * recorded it stored under "object" in its arguments. Threads are
+     * numbered in the order in which they first recorded a span in any
+     * trace, and are named accordingly via metadata events. This function
+     * can be called while other threads are still recording spans; it
+     * then writes the ones that have been completed so far.
+     *
+     * The Perfetto UI (https://ui.perfetto.dev) reads this format as
+     * well, and so there is no separate function that writes Perfetto's
+     * own protobuf-based format.
+     */
+    void
+    write_chrome_trace (std::ostream &out);
+
+
+    /**
+     * A class that records a span from its construction to its destruction,
+     * if a trace is being recorded at the time the object is created. This
+     * is how the span of a function call is typically recorded:
+     * @code
+     *   {
+     *     Tracing::Span span ("consume", "consumer", this);
+     *     consume (std::move(sample), std::move(aux_data));
+     *   }
+     * @endcode
+     * The arguments have the meaning described for the members of Event.
+     */
+    class Span
+    {
+      public:
+        /**
+         * Constructor. Record the start of the span.
+         */
+        Span (const char *name,
+              const char *category,
+              const void *object = nullptr);
+
+        /**
+         * Copy constructor. Spans cannot be copied, and so this
+         * constructor is deleted.
+         */
+        Span (const Span &) = delete;
+
+        /**
+         * Destructor. Record the span if a trace was being recorded when
+         * the object was created (and still is).
+         */
+        ~Span ();
+
+      private:
+        /**
+         * The name, category, and object passed to the constructor.
+         */
+        const char *name;
+        const char *category;
+        const void *object;
+
+        /**
+         * The start of the span, or a default-constructed time point if no
+         * trace was being recorded when the object was created.
+         */
+        Clock::time_point start;
+    };
+
+
+    namespace internal
+    {
+      /**
+       * The buffer into which one thread records its events during one
+       * trace. Only the thread that owns the buffer writes into it;
+       * `n_events` is incremented (with release semantics) only after an
+       * event has been written, so that other threads can read all
+       * events below it.
+       */
+      struct ThreadBuffer
+      {
+        ThreadBuffer (const std::uint64_t  trace_number,
+                      const unsigned int   thread_number,
+                      const std::size_t    capacity)
+          :
+          trace_number (trace_number),
+          thread_number (thread_number),
+          events (std::make_unique<Event[]> (capacity)),
+          capacity (capacity)
+        {}
+
+        const std::uint64_t      trace_number;
+        const unsigned int       thread_number;
+        std::unique_ptr<Event[]> events;
+        const std::size_t        capacity;
+        std::atomic<std::size_t> n_events {0};
+        std::atomic<std::size_t> n_dropped {0};
+      };
+
+
+      /**
+       * The state of the current (or last) trace. The buffers of the
+       * threads are registered in `buffers` under `mutex`; `enabled`
+       * and `trace_number` are read without it.
+       */
+      struct TraceState
+      {
+        std::atomic<bool>                          enabled {false};
+        std::atomic<std::uint64_t>                 trace_number {0};
+        std::atomic<std::size_t>                   max_events_per_thread {0};
+        std::atomic<unsigned int>                  n_threads {0};
+        Clock::time_point                          start_time;
+        std::mutex                                 mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+      };
+
+
+      inline
+      TraceState &
+      trace_state ()
+      {
+        static TraceState state;
+        return state;
+      }
+
+
+      /**
+       * Return the buffer of the current thread for the current trace,
+       * creating and registering it if necessary.
+       */
+      inline
+      ThreadBuffer &
+      thread_buffer ()
+      {
+        TraceState &state = trace_state();
+
+        thread_local const unsigned int thread_number = state.n_threads.fetch_add (1);
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+        const std::uint64_t trace_number = state.trace_number.load (std::memory_order_acquire);
+        if ((buffer == nullptr) || (buffer->trace_number != trace_number))
+          {
+            buffer = std::make_shared<ThreadBuffer> (trace_number, thread_number,
+                                                     state.max_events_per_thread.load());
+
+            std::lock_guard<std::mutex> lock (state.mutex);
+            state.buffers.push_back (buffer);
+          }
+
+        return *buffer;
+      }
+    }
+
+
+
+    inline
+    void
+    start (const std::size_t max_events_per_thread)
+    {
+      internal::TraceState &state = internal::trace_state();
+
+      std::lock_guard<std::mutex> lock (state.mutex);
+      state.buffers.clear ();
+      state.max_events_per_thread = max_events_per_thread;
+      state.start_time = Clock::now();
+      state.trace_number.fetch_add (1, std::memory_order_release);
+      state.enabled.store (true, std::memory_order_release);
+    }
+
+
+
+    inline
+    void
+    stop ()
+    {
+      internal::trace_state().enabled.store (false, std::memory_order_release);
+    }
+
+
+
+    inline
+    bool
+    is_enabled ()
+    {
+      return internal::trace_state().enabled.load (std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    void
+    record (const char              *name,
+            const char              *category,
+            const void              *object,
+            const Clock::time_point  start,
+            const Clock::time_point  end)
+    {
+      if (is_enabled() == false)
+        return;
+
+      internal::ThreadBuffer &buffer = internal::thread_buffer();
+      const std::size_t n = buffer.n_events.load (std::memory_order_relaxed);
+      if (n < buffer.capacity)
+        {
+          buffer.events[n] = Event {name, category, object, start, end};
+          buffer.n_events.store (n+1, std::memory_order_release);
+        }
+      else
+        buffer.n_dropped.fetch_add (1, std::memory_order_relaxed);
+    }
+
+
+
+    inline
+    std::size_t
+    n_events ()
+    {
+      internal::TraceState &state = internal::trace_state();
+      std::lock_guard<std::mutex> lock (state.mutex);
+
+      std::size_t n = 0;
+      for (const auto &buffer : state.buffers)
+        n += buffer->n_events.load (std::memory_order_acquire);
+      return n;
+    }
+
+
+
+    inline
+    std::size_t
+    n_dropped_events ()
+    {
+      internal::TraceState &state = internal::trace_state();
+      std::lock_guard<std::mutex> lock (state.mutex);
+
+      std::size_t n = 0;
+      for (const auto &buffer : state.buffers)
+        n += buffer->n_dropped.load (std::memory_order_relaxed);
+      return n;
+    }
+
+
+
+    inline
+    void
+    write_chrome_trace (std::ostream &out)
+    {
+      internal::TraceState &state = internal::trace_state();
+
+      // Take a copy of the list of buffers, so that threads that record
+      // their first span while we write are not held up:
+      std::vector<std::shared_ptr<internal::ThreadBuffer>> buffers;
+      Clock::time_point                                    start_time;
+      {
+        std::lock_guard<std::mutex> lock (state.mutex);
+        buffers    = state.buffers;
+        start_time = state.start_time;
+      }
+
+      const auto microseconds = [](const Clock::duration t)
+      {
+        return std::to_string (std::chrono::duration<double,std::micro>(t).count());
+      };
+
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+      bool first = true;
+      for (const auto &buffer : buffers)
+        {
+          out << (first ? "" : ",") << '\n'
+              << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread_number
+              << ",\"args\":{\"name\":\"thread " << buffer->thread_number << "\"}}";
+          first = false;
+
+          const std::size_t n = buffer->n_events.load (std::memory_order_acquire);
+          for (std::size_t i=0; i<n; ++i)
+            {
+              const Event &event = buffer->events[i];
+              out << ",\n"
+                  << "{\"name\":\"" << event.name << "\""
+                  << ",\"cat\":\"" << event.category << "\""
+                  << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_number
+                  << ",\"ts\":" << microseconds (event.start - start_time)
+                  << ",\"dur\":" << microseconds (event.end - event.start)
+                  << ",\"args\":{\"object\":\"" << event.object << "\"}}";
+            }
+        }
+      out << "\n]}" << std::endl;
+    }
+
+
+
+    inline
+    Span::Span (const char *name,
+                const char *category,
+                const void *object)
+      :
+      name (name),
+      category (category),
+      object (object),
+      start (is_enabled() ? Clock::now() : Clock::time_point())
+    {}
+
+
+
+    inline
+    Span::~Span ()
+    {
+      if (start != Clock::time_point())
+        record (name, category, object, start, Clock::now());
+    }
+  }
+}
@@ -18,8 +18,13 @@
 
 #include <sampleflow/config.h>
 
+#include <cassert>
 #include <cstddef>
 #include <complex>
+#include <functional>
+#include <future>
+#include <span>
+#include <type_traits>
 
 #include <sampleflow/element_access.h>
 
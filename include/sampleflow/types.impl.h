@@ -52,6 +52,214 @@ namespace SampleFlow
      */
     template <typename SampleType>
     using ScalarType = decltype(Utilities::get_nth_element(std::declval<SampleType>(), 0));
+
+
+    namespace internal
+    {
+      /**
+       * The machinery behind DenseType.
+       */
+      template <typename SampleType>
+      struct Dense
+      {
+        using type = SampleType;
+      };
+
+      template <typename SampleType>
+      requires (Concepts::has_sparse_storage<SampleType>)
+      struct Dense<SampleType>
+      {
+        using type = typename SampleType::DenseMatrixType;
+      };
+    }
+
+
+    /**
+     * The type consumers use by default to store quantities such as the
+     * mean value of samples of type `SampleType`. This is `SampleType`
+     * itself, except for types that only store their nonzero elements (see
+     * Concepts::has_sparse_storage): The mean value of sparse vectors is
+     * in general not sparse, and is better stored in a dense vector. For
+     * these types, DenseType is the type `SampleType::DenseMatrixType`
+     * that Eigen's sparse vectors provide, i.e., a dense Eigen vector with
+     * the same scalar type.
+     */
+    template <typename SampleType>
+    using DenseType = typename internal::Dense<SampleType>::type;
+
+
+    namespace internal
+    {
+      /**
+       * The machinery behind HandledType.
+       */
+      template <typename SampleType>
+      struct Handled
+      {
+        using type = SampleType;
+      };
+
+      template <typename SampleType>
+      requires (Concepts::is_sample_handle<SampleType>)
+      struct Handled<SampleType>
+      {
+        using type = typename SampleType::element_type;
+      };
+    }
+
+
+    /**
+     * The type of the sample an object of type `SampleType` refers to if
+     * `SampleType` is a handle to a sample (see Concepts::is_sample_handle),
+     * i.e., `T` if `SampleType` is `std::shared_ptr<const T>`; the element
+     * type of the `std::shared_ptr` is `const T`, and the `const` is
+     * removed. For all other types, this is `SampleType` itself.
+     */
+    template <typename SampleType>
+    using HandledType = std::remove_const_t<typename internal::Handled<SampleType>::type>;
+
+
+    /**
+     * Whether the given scalar type is complex-valued, i.e., a
+     * `std::complex<T>`. Consumers use this to select kernels that avoid
+     * the multiplication operator of `std::complex`; see
+     * Utilities::multiply().
+     */
+    template <typename T>
+    inline constexpr bool is_complex = false;
+
+    template <typename T>
+    inline constexpr bool is_complex<std::complex<T>> = true;
+
+
+    /**
+     * The type of function objects that evaluate the logarithm of the
+     * likelihood $\log(\pi(x))$ for a whole batch of samples at once.
+     * Such a function receives a sequence of samples as first argument,
+     * and needs to write the log likelihood of the $i$th sample into the
+     * $i$th element of the second argument, which has the same length as
+     * the first.
+     *
+     * Sampling algorithms that work on several samples at the same time --
+     * such as Producers::DifferentialEvaluationMetropolisHastings for all
+     * chains of one generation, Producers::MultipleTryMetropolis for the
+     * trial samples of one step, or Producers::MetropolisHastings when
+     * running several chains -- can accept likelihood functions of this
+     * form in place of ones that evaluate one sample at a time. This is
+     * useful if the likelihood can be evaluated much more efficiently for
+     * many samples at once than for each sample individually, for example
+     * because it is evaluated on a GPU, or by a solver that can treat
+     * several right hand sides at the same time.
+     */
+    template <typename SampleType>
+    using BatchLogLikelihood = std::function<void (std::span<const SampleType> samples,
+                                                   std::span<double> log_likelihoods)>;
+
+
+    /**
+     * The type of function objects that start the evaluation of the
+     * logarithm of the likelihood $\log(\pi(x))$ for a sample, and return a
+     * `std::future` object through which the result can later be obtained.
+     * This is useful if evaluating the likelihood takes a long time but
+     * does not actually require any work on the current thread -- for
+     * example, if the likelihood is evaluated on a remote machine. A
+     * sampling algorithm that works on several samples at the same time
+     * can then have the evaluations for all of these samples in flight
+     * at once, from a single thread.
+     *
+     * The sample passed to such a function object remains valid until
+     * the result has been obtained from the returned future.
+     */
+    template <typename SampleType>
+    using AsynchronousLogLikelihood = std::function<std::future<double> (const SampleType &sample)>;
+
+
+    /**
+     * The type of function objects that evaluate both the logarithm of the
+     * likelihood $\log(\pi(x))$ for a sample $x$ and its gradient
+     * $\nabla_x \log(\pi(x))$. Such a function receives the sample as
+     * first argument, writes the gradient into its second argument (which
+     * has the same size as the sample), and returns the log likelihood.
+     *
+     * Sampling algorithms that use the gradient of the likelihood -- such
+     * as Producers::MetropolisAdjustedLangevin and
+     * Producers::HamiltonianMonteCarlo -- always need both the value and
+     * the gradient for each sample. Computing them in one function allows
+     * sharing the work between the two: If the likelihood involves the
+     * solution of a partial differential equation, for example, the
+     * gradient can be computed with one additional adjoint solve that
+     * re-uses the solution already computed for the value.
+     */
+    template <typename SampleType>
+    using LogLikelihoodAndGradient = std::function<double (const SampleType &sample,
+                                                           SampleType &gradient)>;
+
+
+    namespace internal
+    {
+      /**
+       * The machinery behind FirstArgumentType: Look at the call operator
+       * of function objects, and at the signature of (pointers to)
+       * functions and member functions.
+       */
+      template <typename Function>
+      struct FirstArgument
+        : FirstArgument<decltype(&Function::operator())>
+      {};
+
+      template <typename Result, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (*)(Argument, Arguments...)>
+      {
+        using type = Argument;
+      };
+
+      template <typename Result, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (*)(Argument, Arguments...) noexcept>
+      {
+        using type = Argument;
+      };
+
+      template <typename Result, typename Class, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (Class::*)(Argument, Arguments...)>
+      {
+        using type = Argument;
+      };
+
+      template <typename Result, typename Class, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (Class::*)(Argument, Arguments...) const>
+      {
+        using type = Argument;
+      };
+
+      template <typename Result, typename Class, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (Class::*)(Argument, Arguments...) noexcept>
+      {
+        using type = Argument;
+      };
+
+      template <typename Result, typename Class, typename Argument, typename... Arguments>
+      struct FirstArgument<Result (Class::*)(Argument, Arguments...) const noexcept>
+      {
+        using type = Argument;
+      };
+    }
+
+
+    /**
+     * The type of the first argument of a function, or of the call
+     * operator of a function object such as a (non-generic) lambda
+     * function, with references and `const` removed. This is used in
+     * the deduction guides of classes that store a function object
+     * whose type is a template argument, such as Filters::Condition and
+     * Consumers::Action, so that the type of samples can be deduced from
+     * the function object alone:
+     * @code
+     *   SampleFlow::Filters::Condition positive ([](const double x) { return x > 0; });
+     * @endcode
+     */
+    template <typename Function>
+    using FirstArgumentType
+      = std::remove_cvref_t<typename internal::FirstArgument<std::decay_t<Function>>::type>;
   }
 
 
@@ -81,5 +289,105 @@ namespace SampleFlow
     {
       return std::conj(value);
     }
+
+
+
+    /**
+     * Return the product $ab$ of two scalars. This function template is
+     * chosen when the arguments are not complex-valued, and simply returns
+     * `a*b`.
+     */
+    template <typename T>
+    T multiply (const T &a, const T &b)
+    {
+      return a*b;
+    }
+
+
+
+    /**
+     * Return the product $ab$ of two complex numbers, computed from their
+     * real and imaginary parts by the textbook formula.
+     *
+     * The multiplication operator of `std::complex` in addition treats
+     * infinite and NaN arguments the way Annex G of the C standard
+     * prescribes, and compilers implement this by checking the result
+     * for NaNs and, if necessary, calling a library function such as
+     * `__muldc3`. This call prevents compilers from vectorizing loops
+     * that contain the product, and makes loops over the elements of
+     * complex-valued samples several times slower than the same loops
+     * for real-valued samples. The function here computes the same
+     * product for all finite arguments, and loops that use it are
+     * vectorized just like their real-valued counterparts.
+     */
+    template <typename T>
+    requires (std::is_arithmetic_v<T>)
+    std::complex<T> multiply (const std::complex<T> &a, const std::complex<T> &b)
+    {
+      return {a.real()*b.real() - a.imag()*b.imag(),
+              a.real()*b.imag() + a.imag()*b.real()};
+    }
+
+
+
+    /**
+     * Return the product $a\bar b$ of the first argument with the complex
+     * conjugate of the second, using multiply(). For arguments that are
+     * not complex-valued, this is simply `a*b`.
+     */
+    template <typename T>
+    T multiply_conjugate (const T &a, const T &b)
+    {
+      return Utilities::multiply (a, Utilities::conj (b));
+    }
+
+
+
+
+    /**
+     * Compute $y \leftarrow y + ax$ for the elements of two arrays of the
+     * same length, using multiply() for the products so that the loop is
+     * vectorized also for complex-valued elements. See
+     * add_hermitian_rank_one() for where this is used.
+     */
+    template <typename T>
+    void axpy (const std::span<T>       y,
+               const T                  a,
+               const std::span<const T> x)
+    {
+      assert (x.size() == y.size());
+      for (std::size_t i=0; i<x.size(); ++i)
+        y[i] += Utilities::multiply (a, x[i]);
+    }
+
+
+
+
+    /**
+     * Add $f x x^H$ to the lower triangle (including the diagonal) of the
+     * square matrix whose elements are stored column by column, with
+     * `leading_dimension` elements between the starts of consecutive
+     * columns, starting at `matrix`. This is what Eigen's
+     * `selfadjointView<Eigen::Lower>().rankUpdate(x,f)` computes, and
+     * consumers use the current function instead for complex-valued
+     * elements: Eigen's implementation is not vectorized for these, and
+     * is then more than an order of magnitude slower than for real-valued
+     * elements. The current function updates one column at a time with
+     * axpy(), and takes about four times as long as Eigen takes for real
+     * elements -- the cost of the four real products that make up one
+     * complex product.
+     */
+    template <typename T>
+    void add_hermitian_rank_one (T                       *matrix,
+                                 const std::size_t        leading_dimension,
+                                 const std::span<const T> x,
+                                 const double             factor)
+    {
+      const std::size_t size = x.size();
+      for (std::size_t j=0; j<size; ++j)
+        Utilities::axpy (std::span<T>(matrix + j*leading_dimension + j, size-j),
+                         T(Utilities::conj(x[j]) * factor),
+                         x.subspan(j));
+    }
   }
 }
@@ -0,0 +1,37 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+#ifndef SAMPLEFLOW_WARM_START_H
+#define SAMPLEFLOW_WARM_START_H
+
+#include <sampleflow/auxiliary_data.h>
+#include <sampleflow/producers/chain_file.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/last_sample.h>
+#include <sampleflow/consumers/reservoir_sample.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+// Import the implementation of the things for this header file:
+#include <sampleflow/warm_start.impl.h>
+
+#endif
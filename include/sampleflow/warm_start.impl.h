@@ -0,0 +1,233 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+namespace SampleFlow
+{
+  /**
+   * A namespace for functions that help start sampling algorithms where a
+   * previous run left off -- for example to continue a run that was
+   * interrupted, or to start the sampling of a refined model from the
+   * posterior distribution of a coarser one. Starting there, rather than
+   * at an arbitrary point, avoids a second burn-in phase.
+   *
+   * The functions in this namespace obtain starting points for one chain
+   * (as needed by Producers::MetropolisHastings::sample()) or for several
+   * chains or a population (as needed by
+   * Producers::MetropolisHastings::sample_chains() or
+   * Producers::DifferentialEvaluationMetropolisHastings::sample()) from the
+   * places where the results of a previous run are typically found: A file
+   * written by Consumers::StreamOutput and read via Producers::ChainFile,
+   * which only accesses the samples actually needed rather than reading
+   * the whole file; or a Consumers::LastSample or Consumers::ReservoirSample
+   * object that was connected to the previous run. Finally,
+   * proposal_covariance() turns the state of a Consumers::CovarianceMatrix
+   * object into the covariance matrix of a Gaussian proposal distribution,
+   * for example for
+   * Producers::AdaptiveMetropolisHastings::Parameters::initial_proposal_covariance.
+   *
+   * Here is an example that continues a run of 16 chains whose samples
+   * were written to a file, using the covariance of the samples of the
+   * previous run to scale the proposal distribution:
+   * @code
+   *   SampleFlow::Producers::ChainFile<Eigen::VectorXd> previous_run ("samples.bin");
+   *   const std::vector<Eigen::VectorXd> starting_points
+   *     = SampleFlow::WarmStart::starting_points (previous_run, 16);
+   *
+   *   SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXd> covariance;
+   *   covariance.connect_to_producer (previous_run);
+   *   previous_run.sample (previous_run.n_samples() / 2);
+   *   const Eigen::LLT<Eigen::MatrixXd> proposal_factorization
+   *     (SampleFlow::WarmStart::proposal_covariance (covariance));
+   *   ...
+   * @endcode
+   */
+  namespace WarmStart
+  {
+    /**
+     * Return the last sample stored in the given file.
+     */
+    template <typename SampleType>
+    SampleType
+    starting_point (const Producers::ChainFile<SampleType> &chain_file);
+
+    /**
+     * Return `n_points` samples stored in the given file to be used as
+     * the starting points of as many chains.
+     *
+     * If the file has a column that stores the chain number of each sample
+     * (see AuxiliaryData::chain_number), as is the case for files written
+     * by runs of several chains, then the function returns the last sample
+     * of each of the chains with numbers $0,\ldots,$ `n_points`$-1$, so
+     * that each chain continues where it left off. The function reads the
+     * file backward from the end, and stops as soon as it has found the
+     * samples of all of these chains. All of these chains need to be
+     * present in the file.
+     *
+     * Otherwise, the function treats the first half of the samples in the
+     * file as burn-in and returns `n_points` samples that are evenly spaced
+     * over the second half, ending with the last sample.
+     */
+    template <typename SampleType>
+    std::vector<SampleType>
+    starting_points (const Producers::ChainFile<SampleType> &chain_file,
+                     const std::size_t                       n_points);
+
+    /**
+     * Return the sample stored by the given object. The object needs to
+     * have received at least one sample.
+     */
+    template <typename SampleType>
+    SampleType
+    starting_point (const Consumers::LastSample<SampleType> &last_sample);
+
+    /**
+     * Return `n_points` of the samples stored by the given object. Since
+     * these samples are a uniformly random subset of the samples the
+     * object has received, the function returns the first `n_points` of
+     * them. If the object stores fewer than `n_points` samples, they are
+     * repeated as often as necessary. The object needs to have received at
+     * least one sample.
+     */
+    template <typename SampleType>
+    std::vector<SampleType>
+    starting_points (const Consumers::ReservoirSample<SampleType> &reservoir_sample,
+                     const std::size_t                             n_points);
+
+    /**
+     * Return the covariance matrix $s_d C$ of a Gaussian proposal
+     * distribution, where $C$ is the covariance matrix computed by the
+     * given object and $s_d$ a scaling factor. If the scaling factor is
+     * zero (the default), then $s_d=\frac{2.4^2}{d}$ is used, where $d$ is
+     * the dimension of the samples; this is the same choice as in
+     * Producers::AdaptiveMetropolisHastings (see @cite GRG95).
+     */
+    template <typename SampleType>
+    typename Consumers::CovarianceMatrix<SampleType>::value_type
+    proposal_covariance (const Consumers::CovarianceMatrix<SampleType> &covariance_matrix,
+                         const double                                   scaling_factor = 0);
+
+
+
+    template <typename SampleType>
+    SampleType
+    starting_point (const Producers::ChainFile<SampleType> &chain_file)
+    {
+      assert (chain_file.n_samples() > 0);
+      return chain_file.get_sample (chain_file.n_samples() - 1);
+    }
+
+
+
+    template <typename SampleType>
+    std::vector<SampleType>
+    starting_points (const Producers::ChainFile<SampleType> &chain_file,
+                     const std::size_t                       n_points)
+    {
+      const std::size_t n_samples = chain_file.n_samples();
+      assert (n_samples > 0);
+      assert (n_points > 0);
+
+      const bool has_chain_numbers
+        = std::any_of (chain_file.header().columns.begin(),
+                       chain_file.header().columns.end(),
+                       [](const ChainFileFormat::Column &column)
+      {
+        return (column.key == AuxiliaryData::chain_number);
+      });
+
+      if (has_chain_numbers)
+        {
+          // Walk backward through the file and remember the position of
+          // the last sample of each chain we are interested in:
+          std::vector<std::size_t> last_positions (n_points, n_samples);
+          std::size_t n_found = 0;
+          for (std::size_t i=n_samples; (i>0) && (n_found<n_points); --i)
+            {
+              const std::size_t *chain
+                = chain_file.get_aux_data(i-1).template get_if<std::size_t> (AuxiliaryData::chain_number);
+              if ((chain != nullptr) && (*chain < n_points) && (last_positions[*chain] == n_samples))
+                {
+                  last_positions[*chain] = i-1;
+                  ++n_found;
+                }
+            }
+          assert (n_found == n_points);
+
+          std::vector<SampleType> points;
+          points.reserve (n_points);
+          for (const std::size_t position : last_positions)
+            points.emplace_back (chain_file.get_sample (position));
+          return points;
+        }
+      else
+        {
+          // Pick evenly spaced samples from the second half of the file,
+          // ending with the last sample:
+          const std::size_t first = n_samples / 2;
+          std::vector<SampleType> points;
+          points.reserve (n_points);
+          for (std::size_t p=0; p<n_points; ++p)
+            points.emplace_back (chain_file.get_sample (n_samples - 1
+                                                        - (n_points-1-p) * (n_samples-1-first) / std::max<std::size_t>(n_points-1, 1)));
+          return points;
+        }
+    }
+
+
+
+    template <typename SampleType>
+    SampleType
+    starting_point (const Consumers::LastSample<SampleType> &last_sample)
+    {
+      const std::shared_ptr<const SampleType> sample = last_sample.get_shared();
+      assert (sample != nullptr);
+      return *sample;
+    }
+
+
+
+    template <typename SampleType>
+    std::vector<SampleType>
+    starting_points (const Consumers::ReservoirSample<SampleType> &reservoir_sample,
+                     const std::size_t                             n_points)
+    {
+      const std::vector<SampleType> samples = reservoir_sample.get();
+      assert (samples.size() > 0);
+
+      std::vector<SampleType> points;
+      points.reserve (n_points);
+      for (std::size_t p=0; p<n_points; ++p)
+        points.push_back (samples[p % samples.size()]);
+      return points;
+    }
+
+
+
+    template <typename SampleType>
+    typename Consumers::CovarianceMatrix<SampleType>::value_type
+    proposal_covariance (const Consumers::CovarianceMatrix<SampleType> &covariance_matrix,
+                         const double                                   scaling_factor)
+    {
+      const typename Consumers::CovarianceMatrix<SampleType>::value_type
+      covariance = covariance_matrix.get();
+      assert (covariance.rows() > 0);
+
+      const double s_d = (scaling_factor != 0 ?
+                          scaling_factor :
+                          2.4 * 2.4 / covariance.rows());
+      return s_d * covariance;
+    }
+  }
+}
@@ -0,0 +1,32 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// This file contains the explicit instantiations that make up the
+// SampleFlow.instantiations library. See the documentation in
+// <sampleflow/explicit_instantiations.impl.h> for what this is good for.
+//
+// The header file also declares all of these instantiations as
+// 'extern template', but an explicit instantiation definition following
+// such a declaration is allowed and then produces the actual code.
+
+#include <sampleflow/explicit_instantiations.h>
+
+
+namespace SampleFlow
+{
+  SAMPLEFLOW_INSTANTIATE(template)
+}
@@ -19,29 +19,74 @@
 module;
 
 
+#include <algorithm>
 #include <any>
+#include <array>
 #include <atomic>
+#include <bit>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <compare>
 #include <complex>
 #include <concepts>
+#include <condition_variable>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <future>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <numbers>
+#include <numeric>
 #include <optional>
+#include <ostream>
 #include <random>
+#include <ranges>
 #include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <streambuf>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/syscall.h>
+#endif
 
 #include <boost/signals2.hpp>
 #include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
 
 #include <sampleflow/config.h>
 
@@ -56,28 +101,98 @@ export {
 #include <sampleflow/auxiliary_data.h>
 #include <sampleflow/types.h>
 #include <sampleflow/element_access.h>
+#include <sampleflow/sample_view.h>
 #include <sampleflow/parallel_mode.h>
+#include <sampleflow/random.h>
+#include <sampleflow/proposals.h>
+#include <sampleflow/instrumentation.h>
+#include <sampleflow/memory.h>
+#include <sampleflow/executor.h>
+#include <sampleflow/tracing.h>
+#include <sampleflow/topology.h>
+#include <sampleflow/sample_shape.h>
+#include <sampleflow/pipeline_graph.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/coroutines.h>
+#include <sampleflow/bounded_queue.h>
+#include <sampleflow/ring_buffer.h>
+#include <sampleflow/lag_window.h>
+#include <sampleflow/blocked_sample_buffer.h>
+#include <sampleflow/sample_pool.h>
+#include <sampleflow/sample_hash.h>
+#include <sampleflow/likelihood_cache.h>
+#include <sampleflow/device_log_likelihood.h>
+#include <sampleflow/shared_sample.h>
+#include <sampleflow/signal.h>
+#include <sampleflow/copy_on_write.h>
+#include <sampleflow/reproducibility.h>
+#include <sampleflow/sharded_accumulator.h>
+#include <sampleflow/compact_counts.h>
+#include <sampleflow/sparse_grid_table.h>
+#include <sampleflow/fixed_vector.h>
+#include <sampleflow/small_vector.h>
 
 #include <sampleflow/producer.h>
 #include <sampleflow/filter.h>
 #include <sampleflow/consumer.h>
+#include <sampleflow/pull_range.h>
 
 #include <sampleflow/connections.h>
+#include <sampleflow/fused_pipeline.h>
 #include <sampleflow/scope_exit.h>
+#include <sampleflow/serialization.h>
+#include <sampleflow/checkpointer.h>
+#include <sampleflow/periodic_snapshot.h>
+#include <sampleflow/chain_file_format.h>
+#include <sampleflow/direct_file_writer.h>
+#include <sampleflow/network_stream.h>
+#include <sampleflow/shared_memory_queue.h>
+#include <sampleflow/persistent_state.h>
 
 // Then the various producer classes:
 #include <sampleflow/producers/delayed_rejection_mh.impl.h>
 #include <sampleflow/producers/differential_evaluation_mh.impl.h>
+#include <sampleflow/producers/hamiltonian_monte_carlo.impl.h>
+#include <sampleflow/producers/metropolis_adjusted_langevin.impl.h>
 #include <sampleflow/producers/metropolis_hastings.impl.h>
+#include <sampleflow/producers/adaptive_metropolis_hastings.impl.h>
+#include <sampleflow/producers/affine_invariant_ensemble.impl.h>
+#include <sampleflow/producers/chain_file.impl.h>
+#include <sampleflow/producers/coupled_metropolis_hastings.impl.h>
+#include <sampleflow/producers/delayed_acceptance_mh.impl.h>
+#include <sampleflow/producers/fan_in.impl.h>
+#include <sampleflow/producers/multilevel_metropolis_hastings.impl.h>
+#include <sampleflow/producers/multiple_try_metropolis.impl.h>
+#include <sampleflow/producers/network_input.impl.h>
+#include <sampleflow/producers/parallel_tempering.impl.h>
 #include <sampleflow/producers/range.impl.h>
+#include <sampleflow/producers/sequential_monte_carlo.impl.h>
+#include <sampleflow/producers/shared_memory_input.impl.h>
+#include <sampleflow/producers/speculative_metropolis_hastings.impl.h>
+#include <sampleflow/producers/subsampled_metropolis_hastings.impl.h>
+#include <sampleflow/producers/vectorized_metropolis_hastings.impl.h>
 
 // Then the various filter classes:
+#include <sampleflow/filters/auxiliary_data_projection.impl.h>
+#include <sampleflow/filters/batcher.impl.h>
 #include <sampleflow/filters/component_splitter.impl.h>
 #include <sampleflow/filters/condition.impl.h>
 #include <sampleflow/filters/conversion.impl.h>
+#include <sampleflow/filters/dequantization.impl.h>
 #include <sampleflow/filters/discard_first_n.impl.h>
+#include <sampleflow/filters/linear_projection.impl.h>
+#include <sampleflow/filters/make_shared.impl.h>
+#include <sampleflow/filters/materialize.impl.h>
+#include <sampleflow/filters/multi_component_splitter.impl.h>
+#include <sampleflow/filters/parallel_stage.impl.h>
 #include <sampleflow/filters/pass_through.impl.h>
+#include <sampleflow/filters/per_chain_discard_first_n.impl.h>
+#include <sampleflow/filters/per_chain_take_every_nth.impl.h>
+#include <sampleflow/filters/pipeline_stage.impl.h>
+#include <sampleflow/filters/quantization.impl.h>
 #include <sampleflow/filters/take_every_nth.impl.h>
+#include <sampleflow/filters/take_every_interval.impl.h>
+#include <sampleflow/filters/unbatcher.impl.h>
 
 // And finally the various consumer classes:
 #include <sampleflow/consumers/acceptance_ratio.impl.h>
@@ -85,13 +200,65 @@ export {
 #include <sampleflow/consumers/auto_covariance_matrix.impl.h>
 #include <sampleflow/consumers/auto_covariance_trace.impl.h>
 #include <sampleflow/consumers/average_cosinus.impl.h>
+#include <sampleflow/consumers/banded_covariance_matrix.impl.h>
+#include <sampleflow/consumers/categorical_histogram.impl.h>
+#include <sampleflow/consumers/cholesky_factor.impl.h>
 #include <sampleflow/consumers/count_samples.impl.h>
 #include <sampleflow/consumers/covariance_matrix.impl.h>
+#include <sampleflow/consumers/consensus_combination.impl.h>
+#include <sampleflow/consumers/early_stopping.impl.h>
+#include <sampleflow/consumers/effective_sample_size.impl.h>
+#include <sampleflow/consumers/exponentially_weighted_covariance_matrix.impl.h>
+#include <sampleflow/consumers/fft_auto_covariance_trace.impl.h>
+#include <sampleflow/consumers/group.impl.h>
+#include <sampleflow/consumers/heavy_hitters.impl.h>
+#include <sampleflow/consumers/hierarchical_pair_histogram.impl.h>
 #include <sampleflow/consumers/histogram.impl.h>
 #include <sampleflow/consumers/last_sample.impl.h>
+#include <sampleflow/consumers/low_rank_covariance_matrix.impl.h>
+#include <sampleflow/consumers/marginal_histograms.impl.h>
 #include <sampleflow/consumers/maximum_probability_sample.impl.h>
 #include <sampleflow/consumers/mean_value.impl.h>
+#include <sampleflow/consumers/monte_carlo_standard_error.impl.h>
+#include <sampleflow/consumers/most_probable_samples.impl.h>
+#include <sampleflow/consumers/multivariate_histogram.impl.h>
+#include <sampleflow/consumers/network_output.impl.h>
 #include <sampleflow/consumers/pair_histogram.impl.h>
+#include <sampleflow/consumers/potential_scale_reduction.impl.h>
+#include <sampleflow/consumers/quantiles.impl.h>
+#include <sampleflow/consumers/posterior_predictive.impl.h>
+#include <sampleflow/consumers/reservoir_sample.impl.h>
+#include <sampleflow/consumers/sample_store.impl.h>
+#include <sampleflow/consumers/sharded_chain_output.impl.h>
+#include <sampleflow/consumers/shared_memory_output.impl.h>
+#include <sampleflow/consumers/sparse_covariance_matrix.impl.h>
+#include <sampleflow/consumers/sparse_pair_histogram.impl.h>
+#include <sampleflow/consumers/state_counts.impl.h>
 #include <sampleflow/consumers/stream_output.impl.h>
+#include <sampleflow/consumers/summary_statistics.impl.h>
+#include <sampleflow/consumers/tumbling_window_statistics.impl.h>
+#include <sampleflow/consumers/windowed_covariance_matrix.impl.h>
+
+// Filters that use consumer classes internally need to come after them:
+#include <sampleflow/filters/adaptive_thinning.impl.h>
+
+// As do tools that report what consumers compute, and tools that start
+// producers from the state of producers and consumers of previous runs:
+#include <sampleflow/metrics.h>
+#include <sampleflow/warm_start.h>
+
+}
+
+
+// Finally, explicitly instantiate the most widely used classes for the
+// most widely used sample types, just as the SampleFlow.instantiations
+// library does. Explicit instantiations do not declare names and so can
+// not be part of the export block above, but they are nonetheless
+// attached to this module, and importers of the module do not need to
+// instantiate these classes again.
+#include <sampleflow/explicit_instantiations.h>
 
+namespace SampleFlow
+{
+  SAMPLEFLOW_INSTANTIATE(template)
 }
@@ -66,8 +66,11 @@ int main ()
                      &perturb,
                      10);
 
-  // At this point, we have sampled 1,2,3,4,5,6,7,8,8,8. Three samples are the samples, so ratio should be
-  //equal to 0.8.
+  // At this point, we have sampled 1,2,3,4,5,6,7,8,8,8. The last
+  // two samples equal their predecessors, but they are the result of
+  // accepted proposals (the proposal returns the same point and has
+  // the same likelihood). The sampler therefore does not mark them as
+  // repeated, and the acceptance ratio should be equal to 1.
   //Output whatever we got:
   std::cout << acceptance_ratio.get() << std::endl;
 }
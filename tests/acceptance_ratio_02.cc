@@ -67,8 +67,9 @@ int main ()
                      &perturb,
                      1000);
 
-  // At this point, we have sampled 1,1,1,1,1,1,1,1,1,1,1. All samples 1000 are equal, so ratio should be
-  //equal to 0.001.
+  // At this point, we have sampled 1,1,1,1,1,1,1,1,1,1,1. All 1000
+  // samples are equal, but every one of them is the result of an
+  // accepted proposal, so the ratio should be equal to 1.
   //Output whatever we got:
   std::cout << acceptance_ratio.get() << std::endl;
 }
@@ -0,0 +1,94 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the AcceptanceRatio consumer with samples that know whether
+// they are repeated: Equal samples that are marked as accepted count as
+// accepted, and the moving average returned by get_recent() follows
+// changes of the acceptance rate. Then check that a Metropolis-Hastings
+// sampler that compresses repeated samples leads to the same acceptance
+// ratio as one that does not.
+
+
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#else
+import SampleFlow;
+#endif
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+void
+run_mh (const bool compress_repeated_samples)
+{
+  SampleFlow::Producers::MetropolisHastings<double>::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.compress_repeated_samples = compress_repeated_samples;
+  SampleFlow::Producers::MetropolisHastings<double> mh_sampler (parameters);
+
+  SampleFlow::Consumers::AcceptanceRatio<double> acceptance_ratio (50);
+  acceptance_ratio.connect_to_producer (mh_sampler);
+
+  std::mt19937 rng;
+  mh_sampler.sample (0.,
+                     &log_likelihood,
+                     [&](const double &x)
+  {
+    return std::make_pair (x + std::normal_distribution<double>(0, 5)(rng), 1.0);
+  },
+  10000);
+
+  std::cout << "Compressed: " << compress_repeated_samples
+            << ", acceptance ratio: " << acceptance_ratio.get()
+            << ", recent: " << acceptance_ratio.get_recent() << std::endl;
+}
+
+
+int main ()
+{
+  {
+    SampleFlow::Consumers::AcceptanceRatio<double> acceptance_ratio (10);
+
+    // First send 100 samples that are all equal, but every other one of
+    // which is marked as accepted:
+    for (unsigned int i=0; i<100; ++i)
+      {
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::sample_is_repeated] = (i%2 == 1);
+        acceptance_ratio.consume (1., aux_data);
+      }
+    std::cout << acceptance_ratio.get() << ' ' << acceptance_ratio.get_recent() << std::endl;
+
+    // Then send 50 rejected samples:
+    for (unsigned int i=0; i<50; ++i)
+      {
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::sample_is_repeated] = true;
+        acceptance_ratio.consume (1., aux_data);
+      }
+    std::cout << acceptance_ratio.get() << ' ' << acceptance_ratio.get_recent() << std::endl;
+  }
+
+  run_mh (false);
+  run_mh (true);
+}
@@ -0,0 +1,129 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the batching mode of the Action consumer: Batches have the
+// requested size except for the last one, which is handed over by
+// flush(); a time limit leads to partial batches being processed
+// without a call to flush(); and samples sent from several threads all
+// arrive.
+
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  // Batches of ten samples, for a total of 25 samples:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Consumers::Action<SampleType> action
+    ([](const std::vector<SampleType> &samples,
+        const std::vector<SampleFlow::AuxiliaryData> &aux_data)
+    {
+      std::cout << "Batch of " << samples.size() << " samples ("
+                << aux_data.size() << " aux data objects):";
+      for (const auto s : samples)
+        std::cout << ' ' << s;
+      std::cout << std::endl;
+    },
+    10);
+    action.connect_to_producer(range_producer);
+
+    std::vector<SampleType> samples;
+    for (unsigned int i=0; i<25; ++i)
+      samples.push_back (i);
+    range_producer.sample (samples);
+
+    action.flush();
+    std::cout << "After flush()" << std::endl;
+  }
+
+  // A batch that is not full, but whose time limit passes:
+  {
+    std::mutex mutex;
+    std::vector<SampleType> received;
+    SampleFlow::Consumers::Action<SampleType> action
+    ([&](const std::vector<SampleType> &samples,
+         const std::vector<SampleFlow::AuxiliaryData> &)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      received.insert (received.end(), samples.begin(), samples.end());
+    },
+    1000,
+    std::chrono::milliseconds(10));
+
+    action.consume (1, {});
+    action.consume (2, {});
+    action.consume (3, {});
+
+    bool all_received = false;
+    for (unsigned int i=0; (i<500) && !all_received; ++i)
+      {
+        std::this_thread::sleep_for (std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock (mutex);
+        all_received = (received.size() == 3);
+      }
+    std::cout << "Samples received without flush(): "
+              << (all_received ? "yes" : "no") << std::endl;
+  }
+
+  // Samples sent from several threads:
+  {
+    std::atomic<unsigned int> n_received = 0;
+    std::atomic<unsigned int> n_calls = 0;
+    double sum = 0;
+    {
+      SampleFlow::Consumers::Action<SampleType> action
+      ([&](const std::vector<SampleType> &samples,
+           const std::vector<SampleFlow::AuxiliaryData> &)
+      {
+        // Calls never overlap, so there is no need to lock
+        for (const auto s : samples)
+          sum += s;
+        n_received += samples.size();
+        ++n_calls;
+      },
+      64);
+
+      std::vector<std::thread> threads;
+      for (unsigned int t=0; t<4; ++t)
+        threads.emplace_back ([&]()
+      {
+        for (unsigned int i=1; i<=10000; ++i)
+          action.consume (i, {});
+      });
+      for (auto &thread : threads)
+        thread.join();
+    }
+    std::cout << "Samples received from four threads: " << n_received
+              << ", sum: " << sum
+              << ", batches: " << n_calls << std::endl;
+  }
+}
@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the AdaptiveMetropolisHastings producer: Sample a correlated
+// Gaussian in two dimensions and check the mean value and covariance
+// matrix of the samples, as well as the learned proposal covariance
+// matrix. Then do the same for an anisotropic Gaussian in 20 dimensions,
+// where the proposal distribution has to learn very different scales in
+// the different directions.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/adaptive_metropolis_hastings.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void check (const SampleType &starting_point,
+            const SampleType &mu,
+            const Eigen::MatrixXd &C,
+            const SampleFlow::types::sample_index n_samples,
+            const double tolerance)
+{
+  const Eigen::MatrixXd C_inverse = C.inverse();
+  const auto log_likelihood = [&](const SampleType &x)
+  {
+    const SampleType y = x-mu;
+    return -0.5 * y.dot(C_inverse*y);
+  };
+
+  typename SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.n_non_adaptive_samples = 1000;
+  parameters.initial_proposal_covariance = 0.01 * Eigen::MatrixXd::Identity(mu.size(), mu.size());
+  SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType> am_sampler (parameters);
+
+  // Discard the samples from the initial phase of the chain:
+  SampleFlow::Filters::DiscardFirstN<SampleType> discard (n_samples/10);
+  discard.connect_to_producer (am_sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (discard);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (discard);
+
+  SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (am_sampler);
+
+  am_sampler.sample (starting_point, log_likelihood, n_samples);
+
+  const double d = mu.size();
+  const Eigen::MatrixXd expected_proposal_covariance = 2.4*2.4/d * C;
+
+  std::cout << "Dimension " << mu.size() << ':' << std::endl;
+  std::cout << "  mean value correct: "
+            << ((mean_value.get() - mu).norm() < tolerance * std::sqrt(C.trace())) << std::endl;
+  std::cout << "  covariance matrix correct: "
+            << ((covariance_matrix.get() - C).norm() < tolerance * C.norm()) << std::endl;
+  std::cout << "  proposal covariance correct: "
+            << ((am_sampler.get_proposal_covariance() - expected_proposal_covariance).norm()
+                < tolerance * expected_proposal_covariance.norm()) << std::endl;
+  std::cout << "  acceptance ratio reasonable: "
+            << (acceptance_ratio.get() > 0.15 && acceptance_ratio.get() < 0.5) << std::endl;
+}
+
+
+int main ()
+{
+  {
+    Eigen::MatrixXd C (2,2);
+    C << 1, 0.5,
+    0.5, 1;
+    check (Eigen::Vector2d (0,0), Eigen::Vector2d (1,2), C, 100000, 0.05);
+  }
+
+  {
+    const unsigned int d = 20;
+    Eigen::MatrixXd C = Eigen::MatrixXd::Zero (d,d);
+    for (unsigned int i=0; i<d; ++i)
+      C(i,i) = (i+1)*(i+1) / 100.;
+    Eigen::VectorXd mu (d);
+    for (unsigned int i=0; i<d; ++i)
+      mu(i) = i;
+    // The proposal covariance is computed from all samples of the chain.
+    // To avoid having it be dominated by the initial transient, start
+    // the chain at the mean value.
+    check (mu, mu, C, 400000, 0.1);
+  }
+}
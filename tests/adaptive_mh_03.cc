@@ -0,0 +1,77 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that continuing the chain of an AdaptiveMetropolisHastings
+// producer from the last sample of a previous call yields the same samples
+// and the same learned proposal covariance matrix as a single call with
+// as many steps, i.e., that the sample at which the chain is continued is
+// not counted twice.
+
+
+#include <iostream>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/adaptive_metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::Vector2d;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x(0)*x(0) + 4*x(1)*x(1) - x(0)*x(1));
+}
+
+
+int main ()
+{
+  typename SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.n_non_adaptive_samples = 100;
+
+  std::vector<SampleType> one_call;
+  SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType> sampler_1 (parameters);
+  SampleFlow::Consumers::Action<SampleType>
+  action_1 ([&](SampleType x, SampleFlow::AuxiliaryData)
+  {
+    one_call.push_back (x);
+  });
+  action_1.connect_to_producer (sampler_1);
+  sampler_1.sample (SampleType (1, 1), &log_likelihood, 2000);
+
+  std::vector<SampleType> two_calls;
+  SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType> sampler_2 (parameters);
+  SampleFlow::Consumers::Action<SampleType>
+  action_2 ([&](SampleType x, SampleFlow::AuxiliaryData)
+  {
+    two_calls.push_back (x);
+  });
+  action_2.connect_to_producer (sampler_2);
+  sampler_2.sample (SampleType (1, 1), &log_likelihood, 1000);
+  sampler_2.sample (two_calls.back(), &log_likelihood, 1000);
+
+  std::cout << "Same samples: " << (one_call == two_calls) << std::endl;
+  std::cout << "Same proposal covariance: "
+            << (sampler_1.get_proposal_covariance() == sampler_2.get_proposal_covariance())
+            << std::endl;
+}
@@ -0,0 +1,147 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check ParallelMode::adaptive: A cheap consumer has to stay synchronous,
+// an expensive one has to switch to asynchronous or dedicated-thread mode
+// depending on which of these modes it supports, and one that only
+// supports synchronous mode has to stay synchronous. In all cases, every
+// sample has to be processed, and order-dependent consumers have to see
+// the samples in order.
+
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/pipeline_graph.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = double;
+
+
+// A consumer that takes a while for each sample, and that records the
+// samples it receives and the threads on which it receives them.
+class SlowRecorder : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    SlowRecorder (const SampleFlow::ParallelMode supported_parallel_modes)
+      :
+      SampleFlow::Consumer<SampleType>(supported_parallel_modes)
+    {}
+
+    ~SlowRecorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      const auto start = std::chrono::steady_clock::now();
+      while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(20))
+        ;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      samples.push_back (sample);
+      threads.push_back (std::this_thread::get_id());
+    }
+
+    bool
+    processed_in_order (const std::vector<SampleType> &reference) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return (samples == reference);
+    }
+
+    bool
+    processed_on_other_thread () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return (threads.back() != std::this_thread::get_id());
+    }
+
+    mutable std::mutex           mutex;
+    std::vector<double>          samples;
+    std::vector<std::thread::id> threads;
+};
+
+
+int main ()
+{
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<3000; ++i)
+    samples.push_back (i);
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.set_parallel_mode (SampleFlow::ParallelMode::adaptive, 16);
+  mean_value.connect_to_producer (range_producer);
+
+  SlowRecorder asynchronous_recorder (SampleFlow::ParallelMode(static_cast<int>(SampleFlow::ParallelMode::synchronous)
+                                                               |
+                                                               static_cast<int>(SampleFlow::ParallelMode::asynchronous)));
+  asynchronous_recorder.set_parallel_mode (SampleFlow::ParallelMode::adaptive, 16);
+  asynchronous_recorder.connect_to_producer (range_producer);
+
+  SlowRecorder ordered_recorder (SampleFlow::ParallelMode(static_cast<int>(SampleFlow::ParallelMode::synchronous)
+                                                          |
+                                                          static_cast<int>(SampleFlow::ParallelMode::dedicated_thread)));
+  ordered_recorder.set_parallel_mode (SampleFlow::ParallelMode::adaptive, 16);
+  ordered_recorder.connect_to_producer (range_producer);
+
+  SlowRecorder synchronous_recorder (SampleFlow::ParallelMode::synchronous);
+  synchronous_recorder.set_parallel_mode (SampleFlow::ParallelMode::adaptive, 16);
+  synchronous_recorder.connect_to_producer (range_producer);
+
+  std::cout << "Before sampling: "
+            << SampleFlow::PipelineGraph::to_string (mean_value.get_parallel_mode()) << std::endl;
+
+  range_producer.sample (samples);
+
+  // Range::sample() flushes its consumers, so everything has been
+  // processed by now.
+  std::cout << "Cheap consumer: "
+            << SampleFlow::PipelineGraph::to_string (mean_value.get_parallel_mode())
+            << ", mean=" << mean_value.get() << std::endl;
+
+  std::cout << "Expensive consumer: "
+            << SampleFlow::PipelineGraph::to_string (asynchronous_recorder.get_parallel_mode())
+            << ", " << asynchronous_recorder.samples.size() << " samples"
+            << ", last on other thread: " << asynchronous_recorder.processed_on_other_thread()
+            << std::endl;
+
+  std::cout << "Expensive, order-dependent consumer: "
+            << SampleFlow::PipelineGraph::to_string (ordered_recorder.get_parallel_mode())
+            << ", in order: " << ordered_recorder.processed_in_order (samples)
+            << ", last on other thread: " << ordered_recorder.processed_on_other_thread()
+            << std::endl;
+
+  std::cout << "Expensive, synchronous-only consumer: "
+            << SampleFlow::PipelineGraph::to_string (synchronous_recorder.get_parallel_mode())
+            << ", in order: " << synchronous_recorder.processed_in_order (samples)
+            << ", last on other thread: " << synchronous_recorder.processed_on_other_thread()
+            << std::endl;
+}
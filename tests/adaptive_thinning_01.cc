@@ -0,0 +1,72 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the AdaptiveThinning filter: Feed it a chain from an AR(1)
+// process with autoregression coefficient 0.9, whose integrated
+// autocorrelation time is (1+0.9)/(1-0.9)=19, and check that the stride
+// it settles on is in the right range and that it passes on the right
+// fraction of samples.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/adaptive_thinning.h>
+#  include <sampleflow/consumers/count_samples.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::vector<SampleType> chain;
+  {
+    std::mt19937 rng;
+    std::normal_distribution<double> normal;
+    double x = 0, y = 0;
+    for (unsigned int i=0; i<100000; ++i)
+      {
+        x = 0.9*x + std::sqrt(1-0.9*0.9)*normal(rng);
+        y = normal(rng);
+        chain.push_back ({x, y});
+      }
+  }
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Filters::AdaptiveThinning<SampleType> thinning (1000);
+  thinning.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (thinning);
+
+  range_producer.sample (chain);
+
+  const auto stride = thinning.get_stride();
+  std::cout << "Stride between 12 and 28: "
+            << ((stride >= 12) && (stride <= 28) ? "yes" : "no")
+            << std::endl;
+  std::cout << "Samples passed on roughly 1/stride of all: "
+            << ((count_samples.get() > 100000/stride) && (count_samples.get() < 3*100000/stride)
+                ? "yes" : "no")
+            << std::endl;
+}
@@ -0,0 +1,158 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the AffineInvariantEnsemble producer: Sample a two-dimensional
+// Gaussian that is strongly stretched along a diagonal direction (standard
+// deviations 10 and 0.1), for which a random walk Metropolis-Hastings
+// sampler with an isotropic proposal distribution would need a very small
+// step size. The affine-invariant stretch move does not care about the
+// shape of the distribution. Check the mean value and covariance matrix
+// of the samples, that the number of samples is correct if it is not a
+// multiple of the number of walkers, that samples are labeled with their
+// walker, and that the function that takes a batch log likelihood
+// produces the same samples as the one that evaluates likelihoods on the
+// thread pool.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/affine_invariant_ensemble.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/action.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+#include <eigen3/Eigen/Dense>
+
+using SampleType = Eigen::VectorXd;
+
+
+// The covariance matrix C = Q diag(100, 0.01) Q^T with Q a rotation by 45
+// degrees, i.e., C = [[50.005, 49.995], [49.995, 50.005]]. The log
+// likelihood is then -1/2 x^T C^{-1} x, plus a constant.
+double log_likelihood (const SampleType &x)
+{
+  const double along  = (x(0) + x(1)) / std::sqrt(2.);
+  const double across = (x(0) - x(1)) / std::sqrt(2.);
+  return -0.5 * (along*along/100 + across*across/0.01);
+}
+
+
+std::vector<SampleType>
+check (const SampleFlow::types::sample_index n_samples,
+       const bool batch)
+{
+  SampleFlow::Producers::AffineInvariantEnsemble<SampleType>::Parameters parameters;
+  parameters.random_seed = 1;
+  parameters.thread_pool = std::make_shared<SampleFlow::ThreadPool> (4);
+  SampleFlow::Producers::AffineInvariantEnsemble<SampleType> ensemble (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (ensemble);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (ensemble);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (ensemble);
+
+  // Store the samples, check that the samples of each generation are
+  // labeled with the consecutive walker numbers, and count how many
+  // trial samples were accepted. (The AcceptanceRatio consumer cannot
+  // be used for the latter since consecutive samples come from
+  // different walkers.)
+  const std::size_t n_walkers = 16;
+  std::vector<SampleType> samples;
+  bool chain_numbers_correct = true;
+  std::size_t n_accepted = 0;
+  SampleFlow::Consumers::Action<SampleType> store_samples
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    const std::size_t *chain_number
+      = aux_data.get_if<std::size_t> (SampleFlow::AuxiliaryData::chain_number);
+    if ((chain_number == nullptr) || (*chain_number != samples.size() % n_walkers))
+      chain_numbers_correct = false;
+    if (*aux_data.get_if<bool> (SampleFlow::AuxiliaryData::sample_is_repeated) == false)
+      ++n_accepted;
+    samples.push_back (x);
+  });
+  store_samples.connect_to_producer (ensemble);
+
+  // Start the walkers in a small ball around a point away from the
+  // mean:
+  std::mt19937 rng;
+  std::normal_distribution<double> distribution(0, 0.1);
+  std::vector<SampleType> starting_points (n_walkers, SampleType(2));
+  for (SampleType &x : starting_points)
+    {
+      x(0) = 5 + distribution(rng);
+      x(1) = 5 + distribution(rng);
+    }
+
+  if (batch)
+    ensemble.sample (starting_points,
+                     [](std::span<const SampleType> samples,
+                        std::span<double> log_likelihoods)
+    {
+      for (std::size_t i=0; i<samples.size(); ++i)
+        log_likelihoods[i] = log_likelihood (samples[i]);
+    },
+    n_samples);
+  else
+    ensemble.sample (starting_points, &log_likelihood, n_samples);
+
+  SampleType exact_mean (2);
+  exact_mean << 0, 0;
+  Eigen::MatrixXd exact_covariance (2,2);
+  exact_covariance << 50.005, 49.995,
+                   49.995, 50.005;
+
+  std::cout << (batch ? "Batch:" : "Thread pool:") << std::endl
+            << "  number of samples correct: "
+            << (count_samples.get() == n_samples) << std::endl
+            << "  walker numbers correct: "
+            << chain_numbers_correct << std::endl
+            << "  mean value correct: "
+            << ((mean_value.get() - exact_mean).norm() < 0.5) << std::endl
+            << "  covariance matrix correct: "
+            << ((covariance_matrix.get() - exact_covariance).norm() < 0.05 * exact_covariance.norm())
+            << std::endl
+            << "  acceptance ratio reasonable: "
+            << ((1. * n_accepted / n_samples > 0.2) && (1. * n_accepted / n_samples < 0.9))
+            << std::endl;
+
+  return samples;
+}
+
+
+int main ()
+{
+  // Use a number of samples that is not divisible by the number of
+  // walkers, nor by the number of walkers in each half:
+  const std::vector<SampleType> samples = check (16*50000 + 11, false);
+  const std::vector<SampleType> batch_samples = check (16*50000 + 11, true);
+  std::cout << "Same samples with batch likelihood: "
+            << (samples == batch_samples) << std::endl;
+}
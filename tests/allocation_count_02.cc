@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that a Metropolis-Hastings sampler with samples of type
+// SampleFlow::FixedVector<double,2> does not allocate memory on the heap for each sample once the
+// chain has started, neither in the sampler itself nor in the MeanValue,
+// CovarianceMatrix, Histogram (via a ComponentSplitter), and CountSamples
+// consumers it feeds. Allocations are counted between two steps well
+// into the chain, so that the memory allocated when setting up the chain
+// and the consumers does not count.
+
+
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "allocation_counter.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/fixed_vector.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/filters/component_splitter.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/count_samples.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = SampleFlow::FixedVector<double,2>;
+
+
+// The pipelines checked: Each is a class whose constructor connects the
+// consumers it stores to the given producer.
+struct NoConsumer
+{
+  NoConsumer (SampleFlow::Producer<SampleType> &)
+  {}
+};
+
+struct MeanValue
+{
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+
+  MeanValue (SampleFlow::Producer<SampleType> &producer)
+  {
+    mean_value.connect_to_producer (producer);
+  }
+};
+
+struct CovarianceMatrix
+{
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+
+  CovarianceMatrix (SampleFlow::Producer<SampleType> &producer)
+  {
+    covariance_matrix.connect_to_producer (producer);
+  }
+};
+
+struct Histogram
+{
+  SampleFlow::Filters::ComponentSplitter<SampleType> component_splitter;
+  SampleFlow::Consumers::Histogram<double> histogram;
+
+  Histogram (SampleFlow::Producer<SampleType> &producer)
+    : component_splitter (0),
+      histogram (-3, 3, 20)
+  {
+    component_splitter.connect_to_producer (producer);
+    histogram.connect_to_producer (component_splitter);
+  }
+};
+
+struct CountSamples
+{
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+
+  CountSamples (SampleFlow::Producer<SampleType> &producer)
+  {
+    count_samples.connect_to_producer (producer);
+  }
+};
+
+
+// Run a chain of 3000 steps through the given pipeline and output the
+// number of heap allocations per step between steps 1000 and 2000, once
+// for a proposal that perturbs the current sample and returns a new
+// object, and once for a proposal that writes the trial sample into an
+// existing object.
+template <typename Pipeline>
+void
+check (const char *name)
+{
+  std::cout << name << ':';
+  for (const bool in_place : {false, true})
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+      Pipeline pipeline (mh_sampler);
+
+      unsigned int step = 0;
+      std::uint64_t n_allocations_start = 0;
+      std::uint64_t n_allocations_end = 0;
+      const auto log_likelihood = [&](const SampleType &x) -> double
+      {
+        ++step;
+        if (step == 1000)
+          n_allocations_start = SampleFlow::Testing::n_allocations();
+        else if (step == 2000)
+          n_allocations_end = SampleFlow::Testing::n_allocations();
+        return -x[0]*x[0] - x[1]*x[1];
+      };
+
+      if (in_place == false)
+        mh_sampler.sample (SampleType {},
+                           log_likelihood,
+                           [](const SampleType &x)
+        {
+          SampleType y = x;
+          y[0] += 0.1;
+          y[1] -= 0.1;
+          return std::pair<SampleType,double> (std::move(y), 1.);
+        },
+        3000);
+      else
+        mh_sampler.sample (SampleType {},
+                           log_likelihood,
+                           [](const SampleType &x, SampleType &y) -> double
+        {
+          y = x;
+          y[0] += 0.1;
+          y[1] -= 0.1;
+          return 1.;
+        },
+        3000);
+
+      std::cout << ' ' << (n_allocations_end - n_allocations_start) / 1000.;
+    }
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  check<NoConsumer> ("No consumer");
+  check<MeanValue> ("MeanValue");
+  check<CovarianceMatrix> ("CovarianceMatrix");
+  check<Histogram> ("Histogram");
+  check<CountSamples> ("CountSamples");
+}
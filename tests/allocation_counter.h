@@ -0,0 +1,154 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+#ifndef SAMPLEFLOW_TESTS_ALLOCATION_COUNTER_H
+#define SAMPLEFLOW_TESTS_ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Including this file into a test replaces the global allocation
+ * functions by ones that count how often they are called, so that the
+ * test can check how many heap allocations some piece of code makes. With
+ * the GNU C library, the replaced functions are `malloc()`, `calloc()`,
+ * and `realloc()`, so that allocations that do not go through
+ * `operator new` (such as the ones Eigen makes) are counted as well; on
+ * other systems, the replaced functions are the global `operator new`
+ * variants.
+ *
+ * The benchmarks in the benchmarks/ directory use this file as well,
+ * see `Benchmarks::n_allocations()`.
+ *
+ * Since the replacements are definitions of functions with external
+ * linkage, this file can only be included into tests that consist of a
+ * single translation unit.
+ */
+namespace SampleFlow
+{
+  namespace Testing
+  {
+    namespace internal
+    {
+      inline std::atomic<std::uint64_t> allocation_count (0);
+    }
+
+
+    /**
+     * Return the number of heap allocations the program has made so far,
+     * in all threads.
+     */
+    inline
+    std::uint64_t
+    n_allocations ()
+    {
+      return internal::allocation_count.load (std::memory_order_relaxed);
+    }
+  }
+}
+
+
+#ifdef __GLIBC__
+
+// The GNU C library exports its allocation functions under a second name
+// so that programs can replace malloc() and friends and forward to the
+// original implementation. operator new calls malloc(), so this also
+// counts allocations via operator new.
+extern "C"
+{
+  void *__libc_malloc (std::size_t size);
+  void *__libc_calloc (std::size_t n, std::size_t size);
+  void *__libc_realloc (void *pointer, std::size_t size);
+  void  __libc_free (void *pointer);
+
+  void *
+  malloc (std::size_t size) noexcept
+  {
+    SampleFlow::Testing::internal::allocation_count.fetch_add (1, std::memory_order_relaxed);
+    return __libc_malloc (size);
+  }
+
+  void *
+  calloc (std::size_t n, std::size_t size) noexcept
+  {
+    SampleFlow::Testing::internal::allocation_count.fetch_add (1, std::memory_order_relaxed);
+    return __libc_calloc (n, size);
+  }
+
+  void *
+  realloc (void *pointer, std::size_t size) noexcept
+  {
+    SampleFlow::Testing::internal::allocation_count.fetch_add (1, std::memory_order_relaxed);
+    return __libc_realloc (pointer, size);
+  }
+
+  void
+  free (void *pointer) noexcept
+  {
+    __libc_free (pointer);
+  }
+}
+
+#else
+
+void *
+operator new (std::size_t size)
+{
+  SampleFlow::Testing::internal::allocation_count.fetch_add (1, std::memory_order_relaxed);
+  if (void *pointer = std::malloc (size != 0 ? size : 1))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void *
+operator new (std::size_t size, std::align_val_t alignment)
+{
+  SampleFlow::Testing::internal::allocation_count.fetch_add (1, std::memory_order_relaxed);
+  const std::size_t a = static_cast<std::size_t>(alignment);
+  if (void *pointer = std::aligned_alloc (a, (size + a - 1) / a * a))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void
+operator delete (void *pointer) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete (void *pointer, std::size_t) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete (void *pointer, std::align_val_t) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete (void *pointer, std::size_t, std::align_val_t) noexcept
+{
+  std::free (pointer);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the Concepts::has_contiguous_scalar_storage concept and the
+// Utilities::as_span() function: Output which sample types are
+// recognized as storing their elements contiguously, and for those,
+// modify the elements through the span returned by as_span() and
+// output the sum of the elements.
+
+
+#include <array>
+#include <complex>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/concepts.h>
+#  include <sampleflow/element_access.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const char *name, SampleType &sample)
+{
+  std::cout << name << ": ";
+  if constexpr (SampleFlow::Concepts::has_contiguous_scalar_storage<SampleType>)
+    {
+      for (auto &x : SampleFlow::Utilities::as_span (sample))
+        x *= 2;
+
+      const SampleType &const_sample = sample;
+      const auto elements = SampleFlow::Utilities::as_span (const_sample);
+      std::cout << "contiguous, elements=" << elements.size()
+                << ", doubled sum=";
+      auto sum = elements[0];
+      for (std::size_t i=1; i<elements.size(); ++i)
+        sum += elements[i];
+      std::cout << sum << std::endl;
+    }
+  else
+    std::cout << "not contiguous" << std::endl;
+}
+
+
+int main ()
+{
+  std::vector<double> v = {1, 2, 3};
+  test ("std::vector<double>", v);
+
+  std::array<float,4> a = {{1, 2, 3, 4}};
+  test ("std::array<float,4>", a);
+
+  std::valarray<int> va = {1, 2, 3, 4, 5};
+  test ("std::valarray<int>", va);
+
+  double c[2] = {1.5, 2.5};
+  test ("double[2]", c);
+
+  Eigen::VectorXd e (3);
+  e << 1, 1, 1;
+  test ("Eigen::VectorXd", e);
+
+  Eigen::Matrix<double,2,1> f (2, 3);
+  test ("Eigen::Matrix<double,2,1>", f);
+
+  std::vector<std::complex<double>> z = {{1,1}, {2,-1}};
+  test ("std::vector<std::complex<double>>", z);
+
+  std::vector<bool> b = {true, false};
+  test ("std::vector<bool>", b);
+
+  std::deque<double> d = {1, 2};
+  test ("std::deque<double>", d);
+
+  std::list<double> l = {1, 2};
+  test ("std::list<double>", l);
+
+  double s = 1;
+  test ("double", s);
+}
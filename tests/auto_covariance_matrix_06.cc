@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that AutoCovarianceMatrix objects restricted to selected
+// components, selected lags, and to the symmetric parts or diagonals of
+// the matrices compute the same entries as an unrestricted object.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+using ACM = SampleFlow::Consumers::AutoCovarianceMatrix<SampleType>;
+
+
+int main ()
+{
+  const unsigned int dimension = 6;
+  const unsigned int max_lag = 40;
+
+  const std::vector<unsigned int> lags = ACM::geometric_lags (max_lag);
+  std::cout << "Geometric lags:";
+  for (const unsigned int l : lags)
+    std::cout << ' ' << l;
+  std::cout << std::endl;
+
+  const std::vector<unsigned int> components = {4, 1, 2};
+
+  ACM full (max_lag);
+  ACM selected ({components, lags, ACM::Output::full});
+  ACM symmetric ({components, lags, ACM::Output::symmetric});
+  ACM diagonal ({{}, lags, ACM::Output::diagonal});
+
+  // An autoregressive process whose components are correlated, with
+  // weighted and repeated samples:
+  std::mt19937 rng;
+  SampleType x (0., dimension);
+  for (unsigned int n=0; n<3000; ++n)
+    {
+      SampleType y = 0.6 * x;
+      for (unsigned int i=0; i<dimension; ++i)
+        y[i] += SampleFlow::Testing::NormalDistribution<double>(0,1)(rng) + 0.3*x[(i+1)%dimension];
+      x = y;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(1 + n%3);
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + (n%5==0 ? 50 : 0));
+
+      full.consume (x, aux_data);
+      selected.consume (x, aux_data);
+      symmetric.consume (x, aux_data);
+      diagonal.consume (x, aux_data);
+    }
+
+  const ACM::value_type full_result = full.get();
+  const ACM::value_type selected_result = selected.get();
+  const ACM::value_type symmetric_result = symmetric.get();
+  const ACM::value_type diagonal_result = diagonal.get();
+
+  std::cout << "Number of matrices: " << full_result.size() << ' '
+            << selected_result.size() << ' ' << symmetric_result.size() << ' '
+            << diagonal_result.size() << std::endl;
+
+  double selected_error = 0, symmetric_error = 0, diagonal_error = 0, norm = 0;
+  for (unsigned int k=0; k<lags.size(); ++k)
+    {
+      const Eigen::MatrixXd &gamma = full_result[lags[k]];
+      for (unsigned int i=0; i<components.size(); ++i)
+        for (unsigned int j=0; j<components.size(); ++j)
+          {
+            const double entry = gamma(components[i], components[j]);
+            const double symmetric_entry = (entry + gamma(components[j], components[i])) / 2;
+            selected_error = std::max (selected_error, std::fabs(selected_result[k](i,j) - entry));
+            symmetric_error = std::max (symmetric_error, std::fabs(symmetric_result[k](i,j) - symmetric_entry));
+          }
+      for (unsigned int i=0; i<dimension; ++i)
+        diagonal_error = std::max (diagonal_error, std::fabs(diagonal_result[k](i,0) - gamma(i,i)));
+      norm = std::max (norm, gamma.norm());
+    }
+
+  std::cout << "Selected components match: " << (selected_error < 1e-12 * norm) << std::endl;
+  std::cout << "Symmetric parts match: " << (symmetric_error < 1e-12 * norm) << std::endl;
+  std::cout << "Diagonals match: " << (diagonal_error < 1e-12 * norm) << std::endl;
+  std::cout << "Diagonal result is a column: " << (diagonal_result[0].cols() == 1) << std::endl;
+  std::cout << "Memory used by diagonal object is smaller: "
+            << (diagonal.memory_consumption() < full.memory_consumption()) << std::endl;
+}
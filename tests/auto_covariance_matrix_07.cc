@@ -0,0 +1,127 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the AutoCovarianceMatrix consumer computes the same results
+// in Evaluation::lazy mode as in the default eager mode, for full,
+// symmetric, and diagonal outputs, with weighted and repeated samples,
+// when get() is called while samples are still arriving, when the state
+// is saved and loaded, and when a lazy object continues from a loaded
+// state.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+using ACM = SampleFlow::Consumers::AutoCovarianceMatrix<SampleType>;
+
+
+bool same (const ACM::value_type &a,
+           const ACM::value_type &b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (unsigned int k=0; k<a.size(); ++k)
+    if ((a[k] - b[k]).norm() > 1e-10 * (1 + b[k].norm()))
+      return false;
+  return true;
+}
+
+
+
+void test (const ACM::Selection &selection)
+{
+  ACM eager (selection);
+  ACM lazy (selection, SampleFlow::Evaluation::lazy);
+  ACM resumed (selection, SampleFlow::Evaluation::lazy);
+
+  // An autoregressive process whose components are correlated, with
+  // weighted and repeated samples:
+  const unsigned int dimension = 6;
+  std::mt19937 rng;
+  SampleType x (0., dimension);
+  for (unsigned int n=0; n<5000; ++n)
+    {
+      SampleType y = 0.6 * x;
+      for (unsigned int i=0; i<dimension; ++i)
+        y[i] += SampleFlow::Testing::NormalDistribution<double>(0,1)(rng) + 0.3*x[(i+1)%dimension];
+      x = y;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(n%3);
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + (n%5==0 ? 50 : 0));
+
+      eager.consume (x, aux_data);
+      lazy.consume (x, aux_data);
+      if (n > 2000)
+        resumed.consume (x, aux_data);
+
+      if (n == 2000)
+        {
+          std::cout << "  Intermediate results same: " << same (lazy.get(), eager.get()) << std::endl;
+
+          std::vector<char> buffer;
+          eager.save (buffer);
+          std::span<const char> data (buffer);
+          resumed.load (data);
+        }
+    }
+
+  const ACM::value_type gamma = eager.get();
+  std::cout << "  Final results same: " << same (lazy.get(), gamma) << std::endl;
+  std::cout << "  Resumed same: " << same (resumed.get(), gamma) << std::endl;
+
+  // Saving a lazy object saves the evaluated state, which can be loaded
+  // into an eager object:
+  std::vector<char> buffer;
+  lazy.save (buffer);
+  ACM loaded (selection);
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  std::cout << "  Loaded same: " << same (loaded.get(), gamma) << std::endl;
+}
+
+
+
+int main ()
+{
+  const std::vector<unsigned int> lags = ACM::geometric_lags (40);
+
+  std::cout << "Full:" << std::endl;
+  test ({{}, lags, ACM::Output::full});
+
+  std::cout << "Symmetric, selected components:" << std::endl;
+  test ({{4, 1, 2}, lags, ACM::Output::symmetric});
+
+  std::cout << "Diagonal:" << std::endl;
+  test ({{}, lags, ACM::Output::diagonal});
+
+  std::cout << "Single lag:" << std::endl;
+  test ({{}, {3}, ACM::Output::full});
+}
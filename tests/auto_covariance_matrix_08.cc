@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that the AutoCovarianceMatrix and AutoCovarianceTrace consumers
+// compute the same results when samples are large enough and there are
+// enough lags that processing a single sample updates the running
+// averages for different lags in parallel. As a reference, use
+// AutoCovarianceMatrix in Evaluation::lazy mode, which processes each lag
+// separately, and the sum of the diagonals it computes for the trace.
+
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+using ACM = SampleFlow::Consumers::AutoCovarianceMatrix<SampleType>;
+using ACT = SampleFlow::Consumers::AutoCovarianceTrace<SampleType>;
+
+
+// Generate samples of an autoregressive process with the given number of
+// components, some of which carry weights and repetition counts larger
+// than the largest lag, and send them to the given consumers.
+template <typename... Consumers>
+void generate_samples (const unsigned int dimension,
+                       const unsigned int n_samples,
+                       Consumers &... consumers)
+{
+  std::mt19937 rng;
+  SampleType x (0., dimension);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      SampleType y = 0.6 * x;
+      for (unsigned int i=0; i<dimension; ++i)
+        y[i] += SampleFlow::Testing::NormalDistribution<double>(0,1)(rng) + 0.3*x[(i+1)%dimension];
+      x = y;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(1 + n%3);
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + (n%100==0 ? 700 : 0));
+
+      (consumers.consume (x, aux_data), ...);
+    }
+}
+
+
+
+int main ()
+{
+  // Make sure that the work is split up even on machines with only one
+  // processor core:
+  SampleFlow::ThreadPool::set_default_pool (std::make_shared<SampleFlow::ThreadPool>(4));
+
+  // Full matrices with 80x80 entries for 51 lags:
+  {
+    ACM eager (50);
+    ACM lazy (50, SampleFlow::Evaluation::lazy);
+    generate_samples (80, 500, eager, lazy);
+
+    const ACM::value_type a = eager.get();
+    const ACM::value_type b = lazy.get();
+    bool same = (a.size() == b.size());
+    for (unsigned int k=0; same && (k<a.size()); ++k)
+      same = ((a[k] - b[k]).norm() <= 1e-10 * (1 + b[k].norm()));
+    std::cout << "Matrices same: " << same << std::endl;
+  }
+
+  // Traces for samples with 600 components and 501 lags:
+  {
+    std::vector<unsigned int> lags;
+    for (unsigned int l=0; l<=500; ++l)
+      lags.push_back (l);
+
+    ACT trace (500);
+    ACM diagonal ({{}, lags, ACM::Output::diagonal}, SampleFlow::Evaluation::lazy);
+    generate_samples (600, 1000, trace, diagonal);
+
+    const std::vector<double> a = trace.get();
+    const ACM::value_type     b = diagonal.get();
+    bool same = (a.size() == b.size());
+    for (unsigned int l=0; same && (l<a.size()); ++l)
+      same = (std::abs (a[l] - b[l].sum()) <= 1e-10 * (1 + std::abs (a[l])));
+    std::cout << "Traces same: " << same << std::endl;
+  }
+}
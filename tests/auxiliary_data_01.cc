@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the AuxiliaryData class: Predefined and user-defined keys,
+// lookup by key and by string, and what happens if we store more
+// entries than fit into the object itself.
+
+
+#include <iostream>
+#include <string>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/auxiliary_data.h>
+#else
+import SampleFlow;
+#endif
+
+
+void print (const SampleFlow::AuxiliaryData &aux_data)
+{
+  std::cout << "Size: " << aux_data.size() << std::endl;
+  for (const auto &data : aux_data)
+    {
+      std::cout << "   " << data.first;
+      if (const bool *p = std::any_cast<bool>(&data.second))
+        std::cout << " -> " << (*p ? "true" : "false") << std::endl;
+      else if (const double *p = std::any_cast<double>(&data.second))
+        std::cout << " -> " << *p << std::endl;
+      else if (const int *p = std::any_cast<int>(&data.second))
+        std::cout << " -> " << *p << std::endl;
+      else
+        std::cout << std::endl;
+    }
+}
+
+
+int main ()
+{
+  SampleFlow::AuxiliaryData aux_data
+  {
+    {SampleFlow::AuxiliaryData::relative_log_likelihood, std::any(-1.5)},
+    {"sample is repeated", std::any(true)}
+  };
+  print (aux_data);
+
+  // Keys created from strings compare equal to the predefined ones:
+  std::cout << "Same key: "
+            << (SampleFlow::AuxiliaryData::Key("relative log likelihood")
+                == SampleFlow::AuxiliaryData::relative_log_likelihood)
+            << std::endl;
+  std::cout << "Log likelihood: "
+            << *aux_data.get_if<double>("relative log likelihood")
+            << std::endl;
+  std::cout << "Wrong type: "
+            << (aux_data.get_if<int>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+                == nullptr)
+            << std::endl;
+  std::cout << "Contains chain number: "
+            << aux_data.contains(SampleFlow::AuxiliaryData::chain_number)
+            << std::endl;
+
+  // Add more entries than fit into the object itself, then copy the
+  // object and remove entries again:
+  for (int i=0; i<5; ++i)
+    aux_data["entry " + std::to_string(i)] = std::any(i);
+  aux_data["entry 2"] = std::any(42);
+  print (aux_data);
+
+  SampleFlow::AuxiliaryData copy = aux_data;
+  copy.erase ("sample is repeated");
+  copy.erase ("entry 0");
+  copy.erase ("entry 4");
+  copy.erase ("no such entry");
+  print (copy);
+  print (aux_data);
+
+  copy.clear ();
+  print (copy);
+}
@@ -0,0 +1,197 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the AuxiliaryDataProjection filter: Send samples whose
+// auxiliary data holds a log likelihood to a projection onto this entry
+// and to another consumer, one at a time and in a batch, and check that
+// the mean value of the log likelihoods is correct, that samples
+// without the entry are dropped, and that no sample is ever copied.
+
+
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumer.h>
+#  include <sampleflow/filters/auxiliary_data_projection.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A sample type that counts how often objects of its type are copied.
+struct CountedSample
+{
+    CountedSample (const double value = 0)
+      :
+      value (value)
+    {}
+
+    CountedSample (const CountedSample &other)
+      :
+      value (other.value)
+    {
+      ++n_copies;
+    }
+
+    CountedSample (CountedSample &&other) = default;
+
+    CountedSample &
+    operator= (const CountedSample &other)
+    {
+      value = other.value;
+      ++n_copies;
+      return *this;
+    }
+
+    CountedSample &
+    operator= (CountedSample &&other) = default;
+
+    double value;
+
+    static unsigned int n_copies;
+};
+
+unsigned int CountedSample::n_copies = 0;
+
+
+
+// A producer that sends samples with index i and log likelihood -i,
+// except that every fourth sample has no log likelihood.
+class Issuer : public SampleFlow::Producer<CountedSample>
+{
+  public:
+    void
+    sample (const unsigned int n_samples)
+    {
+      for (unsigned int i=0; i<n_samples; ++i)
+        this->issue_sample (CountedSample(i), aux_data (i));
+      this->flush_consumers ();
+    }
+
+    void
+    sample_batch (const unsigned int n_samples)
+    {
+      std::vector<CountedSample>             samples (n_samples);
+      std::vector<SampleFlow::AuxiliaryData> aux_data_of_samples;
+      for (unsigned int i=0; i<n_samples; ++i)
+        aux_data_of_samples.push_back (aux_data (i));
+      this->issue_batch (samples, aux_data_of_samples);
+      this->flush_consumers ();
+    }
+
+  private:
+    static
+    SampleFlow::AuxiliaryData
+    aux_data (const unsigned int i)
+    {
+      if (i % 4 == 3)
+        return {};
+      else
+        return {{SampleFlow::AuxiliaryData::relative_log_likelihood, std::any(-1.*i)}};
+    }
+};
+
+
+
+// A consumer that adds up the values of the samples it receives.
+class Sink : public SampleFlow::Consumer<CountedSample>
+{
+  public:
+    ~Sink ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (CountedSample sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      sum += sample.value;
+    }
+
+    double
+    get () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return sum;
+    }
+
+  private:
+    mutable std::mutex mutex;
+    double             sum = 0;
+};
+
+
+
+int main ()
+{
+  // Send samples one at a time to the projection and to a consumer that
+  // needs its own sample, which then receives the one the producer
+  // created:
+  {
+    Issuer issuer;
+
+    SampleFlow::Filters::AuxiliaryDataProjection<CountedSample,double>
+    log_likelihoods (SampleFlow::AuxiliaryData::relative_log_likelihood);
+    log_likelihoods.connect_to_producer (issuer);
+
+    Sink sink;
+    sink.connect_to_producer (issuer);
+
+    SampleFlow::Consumers::MeanValue<double> mean_value;
+    mean_value.connect_to_producer (log_likelihoods);
+    SampleFlow::Consumers::CountSamples<double> count_samples;
+    count_samples.connect_to_producer (log_likelihoods);
+
+    issuer.sample (100);
+
+    // The samples with log likelihoods are those with indices
+    // 0,1,2,4,5,6,...,98, whose mean is 49:
+    std::cout << "Single samples:" << std::endl
+              << "  Sum of samples: " << sink.get() << std::endl
+              << "  Number of log likelihoods: " << count_samples.get() << std::endl
+              << "  Mean log likelihood: " << mean_value.get() << std::endl
+              << "  Copies: " << CountedSample::n_copies << std::endl;
+  }
+
+  // Then send them as a batch to the projection alone:
+  {
+    Issuer issuer;
+
+    SampleFlow::Filters::AuxiliaryDataProjection<CountedSample,double>
+    log_likelihoods (SampleFlow::AuxiliaryData::relative_log_likelihood);
+    log_likelihoods.connect_to_producer (issuer);
+
+    SampleFlow::Consumers::MeanValue<double> mean_value;
+    mean_value.connect_to_producer (log_likelihoods);
+    SampleFlow::Consumers::CountSamples<double> count_samples;
+    count_samples.connect_to_producer (log_likelihoods);
+
+    issuer.sample_batch (100);
+
+    std::cout << "Batch:" << std::endl
+              << "  Number of log likelihoods: " << count_samples.get() << std::endl
+              << "  Mean log likelihood: " << mean_value.get() << std::endl
+              << "  Copies: " << CountedSample::n_copies << std::endl;
+  }
+}
@@ -0,0 +1,98 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the AverageCosineBetweenSuccessiveSamples consumer against a
+// direct evaluation of the average cosines over all pairs of samples,
+// for lags that are long compared to the number of samples and for
+// sample types with and without contiguous storage.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+#include <cmath>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/average_cosinus.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::vector<std::vector<double>> &samples,
+           const unsigned int max_lag)
+{
+  SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<SampleType> average_cosinus(max_lag);
+
+  std::vector<SampleType> converted_samples;
+  for (const auto &s : samples)
+    {
+      SampleType x (s.size());
+      for (unsigned int j=0; j<s.size(); ++j)
+        x[j] = s[j];
+      converted_samples.push_back (x);
+      average_cosinus.consume (x, {});
+    }
+
+  const std::vector<double> cosines = average_cosinus.get();
+
+  double max_difference = 0;
+  for (unsigned int l=1; l<=max_lag; ++l)
+    {
+      double sum = 0;
+      unsigned int n_pairs = 0;
+      for (unsigned int t=0; t+l<samples.size(); ++t, ++n_pairs)
+        {
+          double dot = 0, norm1 = 0, norm2 = 0;
+          for (unsigned int j=0; j<samples[t].size(); ++j)
+            {
+              dot += samples[t+l][j] * samples[t][j];
+              norm1 += samples[t+l][j] * samples[t+l][j];
+              norm2 += samples[t][j] * samples[t][j];
+            }
+          sum += dot / std::sqrt(norm1*norm2);
+        }
+      const double expected = (n_pairs > 0 ? sum / n_pairs : 0.);
+      max_difference = std::max (max_difference, std::fabs(cosines[l-1] - expected));
+    }
+
+  std::cout << "Lags: " << max_lag
+            << ", samples: " << samples.size()
+            << ", deviation from direct computation is small: "
+            << (max_difference < 1e-12 ? "yes" : "no")
+            << std::endl;
+}
+
+
+int main ()
+{
+  std::mt19937 rng;
+  std::normal_distribution<double> distribution (1, 1);
+
+  std::vector<std::vector<double>> samples (200, std::vector<double>(7));
+  for (auto &s : samples)
+    for (auto &x : s)
+      x = distribution (rng);
+
+  for (const unsigned int max_lag : {1u, 17u, 199u, 250u})
+    {
+      test<Eigen::VectorXd> (samples, max_lag);
+      test<std::valarray<double>> (samples, max_lag);
+    }
+}
@@ -0,0 +1,105 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the BandedCovarianceMatrix consumer computes the same
+// entries within the band as the CovarianceMatrix consumer computes
+// for the full matrix, both for the diagonal alone and for a wider
+// band, and that merging two objects gives the same result as sending
+// all samples to one of them.
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/banded_covariance_matrix.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+int main ()
+{
+  const unsigned int dimension = 10;
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  SampleFlow::Consumers::BandedCovarianceMatrix<SampleType> diagonal (0);
+  SampleFlow::Consumers::BandedCovarianceMatrix<SampleType> band (2);
+  SampleFlow::Consumers::BandedCovarianceMatrix<SampleType> first_half (2);
+  SampleFlow::Consumers::BandedCovarianceMatrix<SampleType> second_half (2);
+
+  // Create samples in which each component is correlated with the
+  // previous one:
+  std::mt19937 rng;
+  for (unsigned int n=0; n<1000; ++n)
+    {
+      SampleType sample (dimension);
+      sample(0) = SampleFlow::Testing::NormalDistribution<double>(0,1)(rng);
+      for (unsigned int i=1; i<dimension; ++i)
+        sample(i) = 0.5*sample(i-1) + SampleFlow::Testing::NormalDistribution<double>(0,1)(rng);
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+
+      covariance.consume (sample, aux_data);
+      diagonal.consume (sample, aux_data);
+      band.consume (sample, aux_data);
+      if (n < 500)
+        first_half.consume (sample, aux_data);
+      else
+        second_half.consume (sample, aux_data);
+    }
+  first_half.merge (second_half);
+
+  const auto C = covariance.get();
+  const auto B = band.get();
+  std::cout << "Band: " << B.rows() << 'x' << B.cols() << std::endl;
+
+  double max_difference = 0;
+  for (unsigned int j=0; j<dimension; ++j)
+    for (unsigned int k=0; k<3; ++k)
+      if (j+k < dimension)
+        max_difference = std::max (max_difference, std::fabs(B(k,j) - C(j+k,j)));
+      else
+        max_difference = std::max (max_difference, std::fabs(B(k,j)));
+  std::cout << "Band agrees with full matrix: " << (max_difference < 1e-12) << std::endl;
+
+  std::cout << "Diagonal agrees with full matrix: "
+            << ((diagonal.get_diagonal() - C.diagonal()).norm() < 1e-12) << ' '
+            << ((band.get_diagonal() - C.diagonal()).norm() < 1e-12) << std::endl;
+
+  std::cout << "Merged objects agree: "
+            << ((first_half.get() - B).norm() < 1e-12) << std::endl;
+
+  std::cout << "Variances:";
+  for (unsigned int i=0; i<dimension; ++i)
+    std::cout << ' ' << diagonal.get()(0,i);
+  std::cout << std::endl;
+  std::cout << "First subdiagonal:";
+  for (unsigned int i=0; i<dimension-1; ++i)
+    std::cout << ' ' << B(1,i);
+  std::cout << std::endl;
+}
@@ -0,0 +1,97 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the Range producer sends its samples in batches, that
+// filters pass batches on as batches, and that consumers that do not
+// override Consumer::consume_batch() still see every sample.
+
+
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename InputType>
+class BatchSizes : public SampleFlow::Consumer<InputType>
+{
+  public:
+    ~BatchSizes ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (InputType /*sample*/, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::cout << "Single sample" << std::endl;
+    }
+
+    virtual
+    void
+    consume_batch (const std::vector<InputType> &samples,
+                   const std::vector<SampleFlow::AuxiliaryData> &aux_data) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::cout << "Batch of " << samples.size() << " samples with "
+                << aux_data.size() << " aux data objects, starting at "
+                << samples.front() << std::endl;
+    }
+
+  private:
+    mutable std::mutex mutex;
+};
+
+
+int main ()
+{
+  using SampleType = double;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  BatchSizes<SampleType> batch_sizes;
+  batch_sizes.connect_to_producer (range_producer);
+
+  SampleFlow::Filters::TakeEveryNth<SampleType> every_second (2);
+  every_second.connect_to_producer (range_producer);
+
+  BatchSizes<SampleType> filtered_batch_sizes;
+  filtered_batch_sizes.connect_to_producer (every_second);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (every_second);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (range_producer);
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<2500; ++i)
+    samples.push_back (i);
+  range_producer.sample (samples);
+
+  std::cout << "Number of filtered samples: " << count_samples.get() << std::endl;
+  std::cout << "Mean value: " << mean_value.get() << std::endl;
+}
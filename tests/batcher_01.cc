@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the Batcher and Unbatcher filters: Collect samples into batches
+// of four, output the size of each batch including the last, incomplete
+// one that is sent off upon flushing, and then split the batches up into
+// samples again. Then do the same with a time limit for each batch.
+
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/batcher.h>
+#  include <sampleflow/filters/unbatcher.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/stream_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer that sends off individual samples without flushing its
+// consumers after each one, so that the Batcher has to rely on the time
+// limit to complete a batch.
+class Issuer : public SampleFlow::Producer<int>
+{
+  public:
+    void
+    sample (const int sample)
+    {
+      this->issue_sample (sample, SampleFlow::AuxiliaryData());
+    }
+};
+
+
+
+int main ()
+{
+  using SampleType = int;
+
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Filters::Batcher<SampleType> batcher (4);
+    batcher.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::Action<SampleFlow::Filters::SampleBatch<SampleType>>
+    batch_sizes ([](const SampleFlow::Filters::SampleBatch<SampleType> &batch,
+                    const SampleFlow::AuxiliaryData &)
+    {
+      std::cout << "Batch of size " << batch.samples.size() << std::endl;
+    });
+    batch_sizes.connect_to_producer (batcher);
+
+    SampleFlow::Filters::Unbatcher<SampleType> unbatcher;
+    unbatcher.connect_to_producer (batcher);
+
+    SampleFlow::Consumers::StreamOutput<SampleType> stream_output (std::cout);
+    stream_output.connect_to_producer (unbatcher);
+
+    const std::vector<SampleType> samples = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    range_producer.sample (samples);
+  }
+
+  // Now with a time limit: Samples that arrive more than 50ms after the
+  // first sample of a batch complete the batch, even if it has fewer than
+  // 100 samples.
+  {
+    Issuer issuer;
+
+    SampleFlow::Filters::Batcher<SampleType> batcher (100, std::chrono::milliseconds(50));
+    batcher.connect_to_producer (issuer);
+
+    SampleFlow::Consumers::Action<SampleFlow::Filters::SampleBatch<SampleType>>
+    batch_sizes ([](const SampleFlow::Filters::SampleBatch<SampleType> &batch,
+                    const SampleFlow::AuxiliaryData &)
+    {
+      std::cout << "Batch of size " << batch.samples.size() << std::endl;
+    });
+    batch_sizes.connect_to_producer (batcher);
+
+    for (const SampleType s : {1, 2, 0, 3, 4, 5, 0, 6})
+      {
+        if (s == 0)
+          std::this_thread::sleep_for (std::chrono::milliseconds(100));
+        issuer.sample (s);
+      }
+    batcher.flush ();
+  }
+}
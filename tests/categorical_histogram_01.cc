@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test the CategoricalHistogram consumer: Count integers with and without
+// a range of values stored in an array (including values outside the
+// range), vector-valued samples sent as batches, an enumeration, and
+// weighted samples. Also check saving, loading, and merging.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/categorical_histogram.h>
+#else
+import SampleFlow;
+#endif
+
+
+enum class Color { red, green, blue };
+
+std::ostream &operator<< (std::ostream &out, const Color c)
+{
+  return out << (c == Color::red ? "red" : (c == Color::green ? "green" : "blue"));
+}
+
+
+template <typename T>
+void print (const T &histogram)
+{
+  for (const auto &[value, count] : histogram)
+    std::cout << "  " << value << ": " << count << std::endl;
+}
+
+
+int main ()
+{
+  std::vector<int> samples;
+  for (int i=0; i<1000; ++i)
+    samples.push_back ((i*i) % 7);
+
+  // Integers, in a hash table and with values 1...5 in an array:
+  {
+    SampleFlow::Producers::Range<int> range_producer;
+    SampleFlow::Consumers::CategoricalHistogram<int> hashed;
+    hashed.connect_to_producer (range_producer);
+    SampleFlow::Consumers::CategoricalHistogram<int> dense (1, 5);
+    dense.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    std::cout << "Integers:" << std::endl;
+    print (hashed.get());
+    std::cout << "Same with array: " << (hashed.get() == dense.get()) << std::endl;
+
+    std::vector<char> buffer;
+    dense.save (buffer);
+    SampleFlow::Consumers::CategoricalHistogram<int> loaded (1, 5);
+    std::span<const char> data (buffer);
+    loaded.load (data);
+    loaded.merge (dense);
+    std::cout << "Saved, loaded, and merged:" << std::endl;
+    print (loaded.get());
+  }
+
+  // Vectors of integers, sent as one batch:
+  {
+    std::vector<std::vector<int>> vector_samples;
+    for (const int s : samples)
+      vector_samples.push_back ({s % 2, s % 3});
+
+    SampleFlow::Consumers::CategoricalHistogram<std::vector<int>> histogram;
+    histogram.consume_batch (vector_samples,
+                             std::vector<SampleFlow::AuxiliaryData> (vector_samples.size()));
+
+    std::cout << "Vectors:" << std::endl;
+    for (const auto &[value, count] : histogram.get())
+      std::cout << "  (" << value[0] << ',' << value[1] << "): " << count << std::endl;
+  }
+
+  // An enumeration with weighted samples:
+  {
+    SampleFlow::Consumers::CategoricalHistogram<Color> histogram (Color::red, Color::green);
+    histogram.consume (Color::red,   {{SampleFlow::AuxiliaryData::sample_weight, std::any(0.5)}});
+    histogram.consume (Color::blue,  {{SampleFlow::AuxiliaryData::sample_weight, std::any(2.)}});
+    histogram.consume (Color::red,   {{SampleFlow::AuxiliaryData::repetition_count, std::any(std::size_t(3))}});
+    histogram.consume (Color::blue,  {});
+
+    std::cout << "Colors:" << std::endl;
+    print (histogram.get());
+    std::cout << "Weighted:" << std::endl;
+    print (histogram.get_weighted());
+  }
+}
@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Producers::ChainFile: Write a file in the binary format described
+// in namespace ChainFileFormat with a few samples and two auxiliary data
+// columns, then read it back and send first all, then every third sample
+// starting at the second one downstream, and finally the whole file in
+// parallel while preserving the order of samples.
+
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/chain_file_format.h>
+#  include <sampleflow/producers/chain_file.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const std::string filename = "chain_file_01.bin";
+  const unsigned int n_samples = 3000;
+
+  // Write the file by hand:
+  {
+    SampleFlow::ChainFileFormat::Header header;
+    header.scalar_kind = SampleFlow::ChainFileFormat::scalar_kind<double>();
+    header.scalar_size = sizeof(double);
+    header.dimension   = 2;
+    header.columns     = {{SampleFlow::AuxiliaryData::relative_log_likelihood,
+                           SampleFlow::ChainFileFormat::ColumnType::floating_point},
+      {SampleFlow::AuxiliaryData::repetition_count,
+       SampleFlow::ChainFileFormat::ColumnType::unsigned_integer}
+    };
+
+    std::ofstream out (filename, std::ios::binary);
+    const std::vector<char> header_bytes = SampleFlow::ChainFileFormat::write_header (header);
+    out.write (header_bytes.data(), header_bytes.size());
+
+    std::vector<char> record (header.record_size());
+    for (unsigned int i=0; i<n_samples; ++i)
+      {
+        const double x[2] = {1.*i, -2.*i};
+        std::memcpy (record.data(), x, sizeof(x));
+
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -0.5*i;
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + i%2);
+        SampleFlow::ChainFileFormat::write_column (aux_data, header.columns[0],
+                                                   record.data() + sizeof(x));
+        SampleFlow::ChainFileFormat::write_column (aux_data, header.columns[1],
+                                                   record.data() + sizeof(x) + 8);
+
+        out.write (record.data(), record.size());
+      }
+  }
+
+  {
+    using SampleType = Eigen::VectorXd;
+    SampleFlow::Producers::ChainFile<SampleType> chain_file (filename);
+
+    std::cout << "Samples: " << chain_file.n_samples()
+              << ", dimension: " << chain_file.header().dimension << std::endl;
+    std::cout << "Sample 17: " << chain_file.sample_vector(17).transpose()
+              << ", log likelihood: "
+              << *chain_file.get_aux_data(17).get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+              << std::endl;
+
+    // The mean value takes into account the repetition counts stored in
+    // the file:
+    {
+      SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+      mean_value.connect_to_producer (chain_file);
+      chain_file.sample ();
+      std::cout << "Mean of all samples: " << mean_value.get().transpose() << std::endl;
+    }
+
+    {
+      std::vector<double> first_components;
+      SampleFlow::Consumers::Action<SampleType> action
+      ([&first_components](SampleType sample, SampleFlow::AuxiliaryData)
+      {
+        first_components.push_back (sample[0]);
+      });
+      action.connect_to_producer (chain_file);
+      chain_file.sample (1, 20, 3);
+
+      std::cout << "Every third sample:";
+      for (const double x : first_components)
+        std::cout << ' ' << x;
+      std::cout << std::endl;
+
+      first_components.clear();
+      chain_file.sample_in_parallel (0, n_samples, 1, true);
+      bool in_order = (first_components.size() == n_samples);
+      for (unsigned int i=0; in_order && (i<first_components.size()); ++i)
+        in_order = (first_components[i] == i);
+      std::cout << "In parallel: " << first_components.size() << ' ' << in_order << std::endl;
+    }
+  }
+
+  std::remove (filename.c_str());
+}
@@ -0,0 +1,328 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check checkpointing and restarting of samplers: For MetropolisHastings
+// (a single chain with compressed repeated samples, and several chains
+// on a thread pool), DelayedRejectionMetropolisHastings, and
+// DifferentialEvaluationMetropolisHastings, run a chain that is stopped
+// part of the way, then let a new sampler object resume from the
+// checkpoint the first one wrote. The samples of the interrupted and
+// the resumed run together need to be the same as the ones of a run that
+// was not interrupted.
+//
+// The proposal functions of the single-chain samplers do not get to see
+// a random number generator, and so use a deterministic (but irregular)
+// perturbation for this test to be reproducible.
+
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/checkpointer.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/producers/delayed_rejection_mh.h>
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -x*x/2;
+}
+
+
+SampleType perturb (const SampleType &x,
+                    const std::size_t stage = 0)
+{
+  return x + std::sin (12345.678 * x + stage);
+}
+
+
+
+// Run a single MH chain with compressed repeated samples; record the
+// expanded sequence of samples.
+void test_single_chain ()
+{
+  const auto propose = [](const SampleType &x)
+  {
+    return std::make_pair (perturb (x), 1.);
+  };
+
+  std::vector<SampleType> uninterrupted, interrupted;
+  const auto recorder = [](std::vector<SampleType> &samples)
+  {
+    return [&samples](SampleType x, SampleFlow::AuxiliaryData aux_data)
+    {
+      for (std::size_t i=0; i<aux_data.n_repetitions(); ++i)
+        samples.push_back (x);
+    };
+  };
+
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.compress_repeated_samples = true;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (uninterrupted));
+    action.connect_to_producer (mh_sampler);
+    mh_sampler.sample (0., &log_likelihood, propose, 1000);
+  }
+
+  parameters.checkpointer = std::make_shared<SampleFlow::Checkpointer> ("checkpoint_01.mh");
+  parameters.checkpoint_interval = 100;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (interrupted));
+    action.connect_to_producer (mh_sampler);
+
+    // Stop the chain after 437 steps:
+    SampleFlow::Consumers::Action<SampleType>
+    stopper ([&](SampleType, SampleFlow::AuxiliaryData)
+    {
+      if (interrupted.size() >= 437)
+        mh_sampler.request_stop ();
+    });
+    stopper.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample (0., &log_likelihood, propose, 1000);
+  }
+  std::cout << "MH single chain, interrupted after: " << interrupted.size() << std::endl;
+
+  parameters.checkpointer->wait ();
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (interrupted));
+    action.connect_to_producer (mh_sampler);
+    mh_sampler.resume (SampleFlow::Checkpointer::read ("checkpoint_01.mh"),
+                       &log_likelihood, propose, 1000);
+  }
+  parameters.checkpointer->wait ();
+  std::remove ("checkpoint_01.mh");
+
+  std::cout << "MH single chain: " << interrupted.size() << ' '
+            << (interrupted == uninterrupted) << std::endl;
+}
+
+
+
+// Run several MH chains on a thread pool, and record the samples of each
+// chain separately.
+void test_chains ()
+{
+  const auto propose = [](const SampleType &x, std::mt19937 &rng)
+  {
+    return std::make_pair (x + std::uniform_real_distribution<double>(-1,1)(rng), 1.);
+  };
+  const std::vector<SampleType> starting_points = {0., 1., 2., 3.};
+
+  using Samples = std::map<std::size_t,std::vector<SampleType>>;
+  Samples uninterrupted, interrupted;
+  const auto recorder = [](Samples &samples)
+  {
+    return [&samples](SampleType x, SampleFlow::AuxiliaryData aux_data)
+    {
+      samples[std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number])].push_back (x);
+    };
+  };
+
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 1;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (uninterrupted));
+    action.connect_to_producer (mh_sampler);
+    mh_sampler.sample_chains (starting_points, &log_likelihood, propose, 500);
+  }
+
+  parameters.checkpointer = std::make_shared<SampleFlow::Checkpointer> ("checkpoint_01.chains");
+  parameters.checkpoint_interval = 50;
+  std::size_t n_interrupted = 0;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+
+    // Record samples and stop the chains once they have produced 1000
+    // samples together. Where each chain stops depends on timing.
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&, record = recorder (interrupted)](SampleType x, SampleFlow::AuxiliaryData aux_data)
+    {
+      record (x, aux_data);
+      if (++n_interrupted >= 1000)
+        mh_sampler.request_stop ();
+    });
+    action.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample_chains (starting_points, &log_likelihood, propose, 500);
+  }
+  std::cout << "MH chains, interrupted: " << (n_interrupted < 2000) << std::endl;
+
+  parameters.checkpointer->wait ();
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (interrupted));
+    action.connect_to_producer (mh_sampler);
+    mh_sampler.resume_chains (SampleFlow::Checkpointer::read ("checkpoint_01.chains"),
+                              &log_likelihood, propose, 500);
+  }
+  parameters.checkpointer->wait ();
+  std::remove ("checkpoint_01.chains");
+
+  for (const auto &[chain, samples] : interrupted)
+    std::cout << "MH chain " << chain << ": " << samples.size() << ' '
+              << (samples == uninterrupted[chain]) << std::endl;
+}
+
+
+
+void test_delayed_rejection ()
+{
+  const auto propose = [](const SampleType &x, const std::vector<SampleType> &rejected_samples)
+  {
+    return std::make_pair (perturb (x, rejected_samples.size()), 1.);
+  };
+
+  std::vector<SampleType> uninterrupted, interrupted;
+  const auto recorder = [](std::vector<SampleType> &samples)
+  {
+    return [&samples](SampleType x, SampleFlow::AuxiliaryData)
+    {
+      samples.push_back (x);
+    };
+  };
+
+  using Sampler = SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType>;
+  Sampler::Parameters parameters;
+  parameters.random_seed = 3;
+  {
+    Sampler dr_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (uninterrupted));
+    action.connect_to_producer (dr_sampler);
+    dr_sampler.sample (0., &log_likelihood, propose, 2, 600);
+  }
+
+  parameters.checkpointer = std::make_shared<SampleFlow::Checkpointer> ("checkpoint_01.dr");
+  parameters.checkpoint_interval = 100;
+  {
+    Sampler dr_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&, record = recorder (interrupted)](SampleType x, SampleFlow::AuxiliaryData aux_data)
+    {
+      record (x, aux_data);
+      if (interrupted.size() == 250)
+        dr_sampler.request_stop ();
+    });
+    action.connect_to_producer (dr_sampler);
+    dr_sampler.sample (0., &log_likelihood, propose, 2, 600);
+  }
+
+  parameters.checkpointer->wait ();
+  {
+    Sampler dr_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (interrupted));
+    action.connect_to_producer (dr_sampler);
+    dr_sampler.resume (SampleFlow::Checkpointer::read ("checkpoint_01.dr"),
+                       &log_likelihood, propose, 2, 600);
+  }
+  parameters.checkpointer->wait ();
+  std::remove ("checkpoint_01.dr");
+
+  std::cout << "DR: " << interrupted.size() << ' '
+            << (interrupted == uninterrupted) << std::endl;
+}
+
+
+
+void test_differential_evaluation ()
+{
+  const auto propose = [](const SampleType &x)
+  {
+    return std::make_pair (perturb (x), 1.);
+  };
+  const auto crossover = [](const SampleType &x, const SampleType &a, const SampleType &b)
+  {
+    return x + 0.5*(a-b);
+  };
+  const std::vector<SampleType> starting_points = {-1., 0., 1., 2.};
+
+  std::vector<SampleType> uninterrupted, interrupted;
+  const auto recorder = [](std::vector<SampleType> &samples)
+  {
+    return [&samples](SampleType x, SampleFlow::AuxiliaryData)
+    {
+      samples.push_back (x);
+    };
+  };
+
+  using Sampler = SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType>;
+  Sampler::Parameters parameters;
+  parameters.archive_size = 20;
+  parameters.archive_thinning = 3;
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (uninterrupted));
+    action.connect_to_producer (de_sampler);
+    de_sampler.sample (starting_points, &log_likelihood, propose, crossover, 5, 800, false, 7);
+  }
+
+  parameters.checkpointer = std::make_shared<SampleFlow::Checkpointer> ("checkpoint_01.de");
+  parameters.checkpoint_interval = 10;
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&, record = recorder (interrupted)](SampleType x, SampleFlow::AuxiliaryData aux_data)
+    {
+      record (x, aux_data);
+      if (interrupted.size() == 300)
+        de_sampler.request_stop ();
+    });
+    action.connect_to_producer (de_sampler);
+    de_sampler.sample (starting_points, &log_likelihood, propose, crossover, 5, 800, false, 7);
+  }
+
+  parameters.checkpointer->wait ();
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType> action (recorder (interrupted));
+    action.connect_to_producer (de_sampler);
+    de_sampler.resume (SampleFlow::Checkpointer::read ("checkpoint_01.de"),
+                       &log_likelihood, propose, crossover, 5, 800, false);
+  }
+  parameters.checkpointer->wait ();
+  std::remove ("checkpoint_01.de");
+
+  std::cout << "DE: " << interrupted.size() << ' '
+            << (interrupted == uninterrupted) << std::endl;
+}
+
+
+
+int main ()
+{
+  test_single_chain ();
+  test_chains ();
+  test_delayed_rejection ();
+  test_differential_evaluation ();
+}
@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the CholeskyFactor consumer, which updates the factor with
+// every sample, yields the factor of the covariance matrix computed by
+// CovarianceMatrix (plus the regularization term), both with and without
+// regularization, and with samples that have weights and repetition
+// counts. Also check that no factor is provided before the covariance
+// matrix is positive definite.
+
+
+#include <iostream>
+#include <span>
+#include <valarray>
+#include <vector>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/cholesky_factor.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::vector<Eigen::VectorXd> &values,
+           const std::vector<SampleFlow::AuxiliaryData> &aux_data,
+           const double regularization)
+{
+  SampleFlow::Consumers::CholeskyFactor<SampleType> cholesky (regularization, 50);
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+
+  const unsigned int dimension = values[0].size();
+  double W1 = 0, W2 = 0;
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero (dimension);
+  double max_error = 0;
+  unsigned int first_factor = values.size();
+  for (unsigned int n=0; n<values.size(); ++n)
+    {
+      SampleType sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = values[n][i];
+      cholesky.consume (sample, aux_data[n]);
+      covariance.consume (sample, aux_data[n]);
+
+      W1 += aux_data[n].n_repetitions() * aux_data[n].weight();
+      W2 += aux_data[n].n_repetitions() * aux_data[n].weight() * aux_data[n].weight();
+      mean += aux_data[n].n_repetitions() * aux_data[n].weight() * values[n];
+
+      const Eigen::MatrixXd L = cholesky.get();
+      if (L.size() == 0)
+        continue;
+      first_factor = std::min (first_factor, n);
+
+      Eigen::MatrixXd C = covariance.get();
+      C.diagonal().array() += regularization / (W1 - W2/W1);
+      max_error = std::max (max_error,
+                            (L * L.transpose() - C).norm() / C.norm());
+      if (!L.isLowerTriangular())
+        std::cout << "Factor is not lower triangular!" << std::endl;
+    }
+
+  std::cout << "First sample with a factor: " << first_factor << std::endl;
+  std::cout << "Factor matches: " << (max_error < 1e-10) << std::endl;
+  std::cout << "Mean value matches: "
+            << ((cholesky.snapshot()->mean - mean/W1).norm() < 1e-10) << std::endl;
+  std::cout << "Total weight: " << cholesky.snapshot()->total_weight << std::endl;
+
+  std::vector<char> buffer;
+  cholesky.save (buffer);
+  SampleFlow::Consumers::CholeskyFactor<SampleType> copy (regularization, 50);
+  std::span<const char> data (buffer);
+  copy.load (data);
+  std::cout << "Restored factor matches: "
+            << ((copy.get() - cholesky.get()).norm() < 1e-10 * cholesky.get().norm()) << std::endl;
+}
+
+
+
+int main ()
+{
+  const unsigned int dimension = 5;
+  const unsigned int n_samples = 500;
+
+  std::mt19937 rng;
+  std::vector<Eigen::VectorXd> values (n_samples, Eigen::VectorXd(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i,1+i)(rng)
+                       + (i == 3 ? 0.5*values[n][1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double(1 + (n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  for (const double regularization : {0., 0.5})
+    {
+      std::cout << "Regularization " << regularization << ':' << std::endl;
+      test<std::valarray<double>> (values, aux_data, regularization);
+      test<Eigen::VectorXd> (values, aux_data, regularization);
+    }
+}
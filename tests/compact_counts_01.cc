@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test the CompactCounts class with 16-bit counters, so that counters
+// overflow quickly: Check that the values are correct when counters
+// exceed the range of the small counters, when two objects are merged,
+// and when an object is saved and loaded again. Also check that a
+// Histogram whose bins exceed 2^32 samples reports the correct counts.
+
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/compact_counts.h>
+#  include <sampleflow/consumers/histogram.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const unsigned int n_counters = 5;
+  SampleFlow::CompactCounts<std::uint16_t> counts (n_counters);
+  std::vector<SampleFlow::types::sample_index> reference (n_counters, 0);
+
+  for (unsigned int i=0; i<100000; ++i)
+    {
+      const unsigned int index = i % n_counters;
+      const SampleFlow::types::sample_index n = (index == 0 ? 1 : index*index*10);
+      counts.add (index, n);
+      reference[index] += n;
+    }
+  counts.add (4, 1000000000000);
+  reference[4] += 1000000000000;
+
+  std::cout << "Counters:";
+  for (unsigned int i=0; i<n_counters; ++i)
+    std::cout << ' ' << counts[i];
+  std::cout << std::endl;
+  bool correct = true;
+  for (unsigned int i=0; i<n_counters; ++i)
+    correct = correct && (counts[i] == reference[i]);
+  std::cout << "Correct: " << correct << std::endl;
+  std::cout << "Overflowed counters: " << counts.n_overflowed_counters() << std::endl;
+
+  // Merge with itself, which should double all counters:
+  SampleFlow::CompactCounts<std::uint16_t> merged = counts;
+  merged.merge (counts);
+  correct = true;
+  for (unsigned int i=0; i<n_counters; ++i)
+    correct = correct && (merged[i] == 2*reference[i]);
+  std::cout << "Merged correct: " << correct << std::endl;
+
+  // Save and load, both as an object with 16-bit counters and as one
+  // with the default 32-bit counters, and as a vector:
+  std::vector<char> buffer;
+  SampleFlow::Serialization::write (buffer, merged);
+  {
+    SampleFlow::CompactCounts<std::uint16_t> loaded;
+    std::span<const char> data (buffer);
+    SampleFlow::Serialization::read (data, loaded);
+    correct = (loaded.size() == n_counters);
+    for (unsigned int i=0; i<n_counters; ++i)
+      correct = correct && (loaded[i] == merged[i]);
+    std::cout << "Loaded (16 bit) correct: " << correct << std::endl;
+  }
+  {
+    SampleFlow::CompactCounts<> loaded;
+    std::span<const char> data (buffer);
+    SampleFlow::Serialization::read (data, loaded);
+    correct = (loaded.size() == n_counters);
+    for (unsigned int i=0; i<n_counters; ++i)
+      correct = correct && (loaded[i] == merged[i]);
+    std::cout << "Loaded (32 bit) correct: " << correct << std::endl;
+    std::cout << "Overflowed counters: " << loaded.n_overflowed_counters() << std::endl;
+  }
+  {
+    std::vector<SampleFlow::types::sample_index> loaded;
+    std::span<const char> data (buffer);
+    SampleFlow::Serialization::read (data, loaded);
+    correct = (loaded.size() == n_counters);
+    for (unsigned int i=0; i<n_counters; ++i)
+      correct = correct && (loaded[i] == merged[i]);
+    std::cout << "Loaded (vector) correct: " << correct << std::endl;
+  }
+
+  // Now a histogram, one of whose bins receives more samples than fit
+  // into 32 bits, via repetition counts:
+  SampleFlow::Consumers::Histogram<double> histogram (0, 3, 3);
+  for (unsigned int i=0; i<10; ++i)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = SampleFlow::types::sample_index(1000000000);
+      histogram.consume (1.5, aux_data);
+      histogram.consume (i%3 + 0.5, SampleFlow::AuxiliaryData());
+    }
+  for (const auto &bin : histogram.get())
+    std::cout << '[' << std::get<0>(bin) << ',' << std::get<1>(bin) << "): "
+              << std::get<2>(bin) << std::endl;
+}
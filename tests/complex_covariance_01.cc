@@ -0,0 +1,160 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the consumers that compute second moments for complex-valued
+// samples, which use the kernels in Utilities::multiply() and
+// Utilities::add_hermitian_rank_one() rather than the operations of
+// std::complex and Eigen:
+// - The covariance matrices computed by CovarianceMatrix,
+//   BandedCovarianceMatrix, WindowedCovarianceMatrix, and
+//   SummaryStatistics agree with the Hermitian matrix computed directly
+//   from the definition.
+// - For purely imaginary samples i*y, AutoCovarianceTrace and (the full
+//   and diagonal parts of) AutoCovarianceMatrix, which do not conjugate,
+//   return the negatives of what they return for the real samples y.
+
+
+#include <complex>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/banded_covariance_matrix.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/summary_statistics.h>
+#  include <sampleflow/consumers/windowed_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const unsigned int dimension = 40;
+  const unsigned int n_samples = 200;
+
+  std::mt19937 random_number_generator;
+  std::normal_distribution<double> distribution;
+  std::vector<Eigen::VectorXcd> samples (n_samples, Eigen::VectorXcd(dimension));
+  for (auto &sample : samples)
+    for (unsigned int i=0; i<dimension; ++i)
+      {
+        const double real_part = distribution (random_number_generator);
+        sample[i] = {real_part, distribution (random_number_generator)};
+      }
+
+  // Compute the covariance matrix from its definition:
+  Eigen::VectorXcd mean = Eigen::VectorXcd::Zero(dimension);
+  for (const auto &sample : samples)
+    mean += sample;
+  mean /= n_samples;
+  Eigen::MatrixXcd reference = Eigen::MatrixXcd::Zero(dimension, dimension);
+  for (const auto &sample : samples)
+    reference += (sample - mean) * (sample - mean).adjoint();
+  reference /= (n_samples - 1);
+
+  {
+    SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXcd>         covariance;
+    SampleFlow::Consumers::BandedCovarianceMatrix<Eigen::VectorXcd>   banded_covariance (3);
+    SampleFlow::Consumers::WindowedCovarianceMatrix<Eigen::VectorXcd> windowed_covariance (2*n_samples);
+    SampleFlow::Consumers::SummaryStatistics<Eigen::VectorXcd>        summary_statistics;
+    for (const auto &sample : samples)
+      {
+        covariance.consume (sample, {});
+        banded_covariance.consume (sample, {});
+        windowed_covariance.consume (sample, {});
+        summary_statistics.consume (sample, {});
+      }
+
+    const double tolerance = 1e-12 * reference.norm();
+    std::cout << "CovarianceMatrix: "
+              << ((covariance.get() - reference).norm() < tolerance) << std::endl;
+
+    const Eigen::MatrixXcd band = banded_covariance.get();
+    double band_error = 0;
+    for (unsigned int j=0; j<dimension; ++j)
+      for (unsigned int k=0; (k<=3) && (j+k<dimension); ++k)
+        band_error = std::max (band_error, std::abs (band(k,j) - reference(j+k,j)));
+    std::cout << "BandedCovarianceMatrix: " << (band_error < tolerance) << std::endl;
+
+    std::cout << "WindowedCovarianceMatrix: "
+              << ((windowed_covariance.get() - reference).norm() < tolerance) << std::endl;
+    std::cout << "SummaryStatistics: "
+              << ((summary_statistics.get_covariance() - reference).norm() < tolerance) << std::endl;
+  }
+
+  // Now compare autocovariances for real and purely imaginary samples:
+  {
+    using namespace SampleFlow::Consumers;
+
+    AutoCovarianceTrace<Eigen::VectorXd>  real_trace (5);
+    AutoCovarianceTrace<Eigen::VectorXcd> imaginary_trace (5);
+
+    using RealMatrix    = AutoCovarianceMatrix<Eigen::VectorXd>;
+    using ComplexMatrix = AutoCovarianceMatrix<Eigen::VectorXcd>;
+    RealMatrix    real_full (5);
+    ComplexMatrix imaginary_full (5);
+    RealMatrix    real_diagonal (RealMatrix::Selection {{}, {0, 1, 2, 3, 4, 5}, RealMatrix::Output::diagonal});
+    ComplexMatrix imaginary_diagonal (ComplexMatrix::Selection {{}, {0, 1, 2, 3, 4, 5}, ComplexMatrix::Output::diagonal});
+    RealMatrix    real_symmetric (RealMatrix::Selection {{}, {0, 1, 2, 3, 4, 5}, RealMatrix::Output::symmetric});
+    ComplexMatrix complex_symmetric (ComplexMatrix::Selection {{}, {0, 1, 2, 3, 4, 5}, ComplexMatrix::Output::symmetric});
+
+    for (const auto &sample : samples)
+      {
+        const Eigen::VectorXd y = sample.real();
+        const Eigen::VectorXcd iy = std::complex<double>(0,1) * y.cast<std::complex<double>>();
+
+        real_trace.consume (y, {});
+        imaginary_trace.consume (iy, {});
+        real_full.consume (y, {});
+        imaginary_full.consume (iy, {});
+        real_diagonal.consume (y, {});
+        imaginary_diagonal.consume (iy, {});
+        real_symmetric.consume (y, {});
+        complex_symmetric.consume (y.cast<std::complex<double>>(), {});
+      }
+
+    double trace_error = 0;
+    const auto real_traces      = real_trace.get();
+    const auto imaginary_traces = imaginary_trace.get();
+    for (unsigned int l=0; l<real_traces.size(); ++l)
+      trace_error = std::max (trace_error,
+                              std::abs (imaginary_traces[l] + real_traces[l]) / std::abs (real_traces[0]));
+    std::cout << "AutoCovarianceTrace: " << (trace_error < 1e-12) << std::endl;
+
+    const auto matrix_error = [](const auto &real_matrices, const auto &complex_matrices,
+                                 const double sign)
+    {
+      double error = 0;
+      for (unsigned int l=0; l<real_matrices.size(); ++l)
+        error = std::max (error,
+                          (complex_matrices[l] - sign * real_matrices[l].template cast<std::complex<double>>()).norm()
+                          / real_matrices[0].norm());
+      return error;
+    };
+    std::cout << "AutoCovarianceMatrix, full: "
+              << (matrix_error (real_full.get(), imaginary_full.get(), -1) < 1e-12) << std::endl;
+    std::cout << "AutoCovarianceMatrix, diagonal: "
+              << (matrix_error (real_diagonal.get(), imaginary_diagonal.get(), -1) < 1e-12) << std::endl;
+    std::cout << "AutoCovarianceMatrix, symmetric: "
+              << (matrix_error (real_symmetric.get(), complex_symmetric.get(), 1) < 1e-12) << std::endl;
+  }
+}
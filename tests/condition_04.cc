@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test that the Filters::Condition, Filters::Conversion, and
+// Consumers::Action classes can store their function objects by type if
+// the template arguments are deduced from the function objects, and that
+// the results are the same as with the std::function-based variants. Also
+// check that Consumers::Histogram accepts a lambda function to transform
+// its bins.
+
+
+#include <iostream>
+#include <functional>
+#include <ranges>
+#include <type_traits>
+#include <cmath>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/filters/conversion.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/connections.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = int;
+
+  const auto is_odd = [](const SampleType &s)
+  {
+    return (s % 2 == 1);
+  };
+  const auto is_small = [](const SampleType &s, const SampleFlow::AuxiliaryData &)
+  {
+    return (s < 20);
+  };
+  const auto halve = [](const SampleType &s)
+  {
+    return s / 2.;
+  };
+  double sum_deduced = 0;
+  const auto add_to_sum = [&sum_deduced](const double x, SampleFlow::AuxiliaryData)
+  {
+    sum_deduced += x;
+  };
+
+  // First a chain of objects whose template arguments are deduced:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Filters::Condition odd (is_odd);
+    SampleFlow::Filters::Condition small (is_small);
+    SampleFlow::Filters::Conversion conversion (halve);
+    SampleFlow::Consumers::Action action (add_to_sum);
+
+    static_assert (std::is_same_v<decltype(odd),
+                   SampleFlow::Filters::Condition<SampleType,std::remove_const_t<decltype(is_odd)>>>);
+    static_assert (std::is_same_v<decltype(small),
+                   SampleFlow::Filters::Condition<SampleType,std::remove_const_t<decltype(is_small)>>>);
+    static_assert (std::is_same_v<decltype(conversion),
+                   SampleFlow::Filters::Conversion<SampleType,double,std::remove_const_t<decltype(halve)>>>);
+    static_assert (std::is_same_v<decltype(action),
+                   SampleFlow::Consumers::Action<double,std::remove_const_t<decltype(add_to_sum)>>>);
+
+    range_producer >> odd >> small >> conversion >> action;
+    range_producer.sample (std::views::iota(1,100));
+  }
+
+  // Then the same with the std::function-based variants:
+  double sum_type_erased = 0;
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Filters::Condition<SampleType> odd (is_odd);
+    SampleFlow::Filters::Condition<SampleType> small (is_small);
+    SampleFlow::Filters::Conversion<SampleType,double> conversion (halve);
+    SampleFlow::Consumers::Action<double> action ([&sum_type_erased](const double x,
+                                                                      SampleFlow::AuxiliaryData)
+    {
+      sum_type_erased += x;
+    });
+
+    range_producer >> odd >> small >> conversion >> action;
+    range_producer.sample (std::views::iota(1,100));
+  }
+
+  std::cout << "Sum (deduced types):     " << sum_deduced << std::endl;
+  std::cout << "Sum (std::function):     " << sum_type_erased << std::endl;
+
+  // Finally a histogram with logarithmically spaced bins, with the
+  // transformation given as a lambda function:
+  {
+    SampleFlow::Producers::Range<double> range_producer;
+    SampleFlow::Consumers::Histogram<double> histogram (0, 2, 4,
+                                                        [](const double x)
+    {
+      return std::pow (10., x);
+    });
+    histogram.connect_to_producer (range_producer);
+
+    range_producer.sample (std::views::iota(1,100)
+                           | std::views::transform ([](const int i)
+    {
+      return 1. * i;
+    }));
+
+    for (const auto &bin : histogram.get())
+      std::cout << std::get<0>(bin) << ' ' << std::get<1>(bin) << ' '
+                << std::get<2>(bin) << std::endl;
+  }
+}
@@ -0,0 +1,98 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test that Filters::Condition selects the same samples from batches as
+// from individual samples, with a predicate stored as std::function, a
+// predicate stored by type, and a batch predicate. Also check batches of
+// which all or none of the samples are selected, and that the batch
+// predicate is called once per batch.
+
+
+#include <iostream>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename ConditionType>
+void test (const std::string &name,
+           ConditionType &condition)
+{
+  std::vector<int> received;
+  SampleFlow::Consumers::Action<int> action ([&received](const int x,
+                                                         const SampleFlow::AuxiliaryData &)
+  {
+    received.push_back (x);
+  });
+  action.connect_to_producer (condition);
+
+  // A batch of which some samples are selected, one of which all are
+  // selected, and one of which none are:
+  for (const std::vector<int> &batch : std::vector<std::vector<int>> {{1, 2, 3, 4, 5, 6, 7},
+         {2, 4, 6},
+         {1, 3}
+       })
+    condition.consume_batch (batch, std::vector<SampleFlow::AuxiliaryData> (batch.size()));
+
+  // And individual samples:
+  for (int i=10; i<15; ++i)
+    condition.consume (i, {});
+
+  std::cout << name << ":";
+  for (const int x : received)
+    std::cout << ' ' << x;
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  const auto is_even = [](const int &x)
+  {
+    return (x % 2 == 0);
+  };
+
+  {
+    SampleFlow::Filters::Condition<int> condition (is_even);
+    test ("std::function", condition);
+  }
+
+  {
+    SampleFlow::Filters::Condition condition (is_even);
+    test ("Stored by type", condition);
+  }
+
+  {
+    unsigned int n_calls = 0;
+    SampleFlow::Filters::Condition<int>
+    condition ([&n_calls](const std::span<const int> samples,
+                          const std::span<const SampleFlow::AuxiliaryData> aux_data,
+                          const std::span<bool> selected)
+    {
+      ++n_calls;
+      for (std::size_t i=0; i<samples.size(); ++i)
+        selected[i] = (samples[i] % 2 == 0) && aux_data[i].empty();
+    });
+    test ("Batch predicate", condition);
+    std::cout << "Calls of the batch predicate: " << n_calls << std::endl;
+  }
+}
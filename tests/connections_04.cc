@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that chains of temporary filters built via operator>> are fused
+// into a single filter, that named filters are not fused, and that the
+// fused chains produce the same samples as unfused ones.
+
+
+#include <iostream>
+#include <sstream>
+#include <ranges>
+#include <type_traits>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/filters/conversion.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <sampleflow/connections.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const auto half = [](const int &i)
+  {
+    return i/2.;
+  };
+  const auto is_not_integer = [](const double &x)
+  {
+    return (x != static_cast<int>(x));
+  };
+
+  std::ostringstream reference;
+  {
+    SampleFlow::Producers::Range<int> range_producer;
+    SampleFlow::Filters::Conversion<int,double> conversion (half);
+    SampleFlow::Filters::Condition<double> condition (is_not_integer);
+    SampleFlow::Filters::TakeEveryNth<double> every_3rd (3);
+    SampleFlow::Consumers::StreamOutput<double> stream_output (reference);
+
+    auto chain = range_producer >> conversion >> condition >> every_3rd >> stream_output;
+    range_producer.sample (std::views::iota(1,30));
+  }
+  std::cout << reference.str();
+
+  // The same with temporary filters. All three are fused into one:
+  {
+    std::ostringstream o;
+    SampleFlow::Producers::Range<int> range_producer;
+    SampleFlow::Consumers::StreamOutput<double> stream_output (o);
+
+    auto head = range_producer
+                >> SampleFlow::Filters::Conversion<int,double> (half)
+                >> SampleFlow::Filters::Condition<double> (is_not_integer)
+                >> SampleFlow::Filters::TakeEveryNth<double> (3);
+    std::cout << "Fused: "
+              << std::is_same_v<decltype(head), SampleFlow::FusedChain<int,double>>
+              << std::endl;
+
+    auto chain = std::move(head) >> stream_output;
+    range_producer.sample (std::views::iota(1,30));
+    std::cout << "Same output: " << (o.str() == reference.str()) << std::endl;
+  }
+
+  // Two temporary filters fused without a producer, with a named filter
+  // between the producer and them that is not fused:
+  {
+    std::ostringstream o;
+    SampleFlow::Producers::Range<int> range_producer;
+    SampleFlow::Filters::Conversion<int,double> conversion (half);
+    SampleFlow::Consumers::StreamOutput<double> stream_output (o);
+
+    auto filters = SampleFlow::Filters::Condition<double> (is_not_integer)
+                   >> SampleFlow::Filters::TakeEveryNth<double> (3);
+    std::cout << "Fused: "
+              << std::is_same_v<decltype(filters), SampleFlow::FusedFilter<double,double,double>>
+              << std::endl;
+
+    auto head = range_producer >> conversion;
+    std::cout << "Not fused: "
+              << std::is_same_v<decltype(head), SampleFlow::Chain<void,int,double>>
+              << std::endl;
+
+    auto chain = std::move(head) >> std::move(filters) >> stream_output;
+    range_producer.sample (std::views::iota(1,30));
+    std::cout << "Same output: " << (o.str() == reference.str()) << std::endl;
+  }
+}
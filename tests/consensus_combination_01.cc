@@ -0,0 +1,168 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the ConsensusCombination class: Sample three Gaussian
+// sub-posteriors with different means and covariance matrices with one
+// Metropolis-Hastings sampler each, run concurrently, and combine their
+// samples. For Gaussians, consensus Monte Carlo with inverse covariance
+// weights yields samples of the exact posterior, i.e., of the product of
+// the sub-posteriors, whose mean and covariance we know. Then check the
+// inverse variance and equal weightings for a case in which they are
+// exact as well.
+
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/consensus_combination.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+using Combination = SampleFlow::Consumers::ConsensusCombination<SampleType>;
+
+
+// Sample the Gaussians with the given means and covariance matrices, one
+// per shard, combine the samples with the given weighting, and compare
+// the mean and covariance of the combined samples with the ones of the
+// product of the Gaussians.
+void check (const std::vector<Eigen::VectorXd> &means,
+            const std::vector<Eigen::MatrixXd> &covariances,
+            const Combination::Weighting        weighting)
+{
+  const unsigned int n_shards = means.size();
+  const SampleFlow::types::sample_index n_samples = 100000;
+
+  Combination consensus (n_shards, weighting);
+
+  std::vector<SampleFlow::Producers::MetropolisHastings<SampleType>> samplers;
+  for (unsigned int s=0; s<n_shards; ++s)
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+      parameters.random_seed = s+1;
+      samplers.emplace_back (parameters);
+    }
+  for (unsigned int s=0; s<n_shards; ++s)
+    consensus.shard(s).connect_to_producer (samplers[s]);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (consensus);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (consensus);
+
+  std::vector<std::function<void ()>> shard_samplers;
+  for (unsigned int s=0; s<n_shards; ++s)
+    shard_samplers.emplace_back ([&, s]()
+  {
+    const Eigen::MatrixXd inverse = covariances[s].inverse();
+    const Eigen::LLT<Eigen::MatrixXd> proposal_factorization (covariances[s]);
+    const Eigen::MatrixXd proposal_factor = proposal_factorization.matrixL();
+
+    std::mt19937 rng (s);
+    std::normal_distribution<double> distribution (0, 1);
+
+    samplers[s].sample (means[s],
+                        [&](const SampleType &x)
+    {
+      return -0.5 * (x-means[s]).dot(inverse * (x-means[s]));
+    },
+    [&](const SampleType &x)
+    {
+      Eigen::VectorXd z (x.size());
+      for (auto &z_i : z)
+        z_i = distribution(rng);
+      return std::make_pair (SampleType (x + 1.5 * proposal_factor * z), 1.);
+    },
+    n_samples);
+  });
+  consensus.run_shards (shard_samplers,
+                        std::make_shared<SampleFlow::ThreadPool> (n_shards));
+
+  // Compute the mean and covariance of the product of the Gaussians:
+  Eigen::MatrixXd precision = Eigen::MatrixXd::Zero (means[0].size(), means[0].size());
+  Eigen::VectorXd weighted_means = Eigen::VectorXd::Zero (means[0].size());
+  for (unsigned int s=0; s<n_shards; ++s)
+    {
+      precision += covariances[s].inverse();
+      weighted_means += covariances[s].inverse() * means[s];
+    }
+  const Eigen::MatrixXd exact_covariance = precision.inverse();
+  const Eigen::VectorXd exact_mean = exact_covariance * weighted_means;
+
+  std::cout << "Number of combined samples: " << consensus.n_combined_samples() << std::endl
+            << "  mean value correct: "
+            << ((mean_value.get() - exact_mean).norm() < 0.03) << std::endl
+            << "  covariance correct: "
+            << ((covariance_matrix.get() - exact_covariance).norm() < 0.1 * exact_covariance.norm())
+            << std::endl;
+}
+
+
+
+int main ()
+{
+  // Three shards with different means and correlated covariances:
+  {
+    std::vector<Eigen::VectorXd> means (3, Eigen::VectorXd (2));
+    means[0] << 1, 0;
+    means[1] << 0, 2;
+    means[2] << -1, 1;
+
+    std::vector<Eigen::MatrixXd> covariances (3, Eigen::MatrixXd (2,2));
+    covariances[0] << 1, 0.5,
+                   0.5, 1;
+    covariances[1] << 2, -0.3,
+                   -0.3, 0.5;
+    covariances[2] << 0.5, 0,
+                   0, 3;
+
+    check (means, covariances, Combination::Weighting::inverse_covariance);
+  }
+
+  // Two shards with diagonal covariances, for which inverse variance
+  // weights are exact:
+  {
+    std::vector<Eigen::VectorXd> means (2, Eigen::VectorXd (2));
+    means[0] << 1, 0;
+    means[1] << 0, 2;
+
+    std::vector<Eigen::MatrixXd> covariances (2, Eigen::MatrixXd::Zero (2,2));
+    covariances[0].diagonal() << 1, 2;
+    covariances[1].diagonal() << 3, 0.5;
+
+    check (means, covariances, Combination::Weighting::inverse_variance);
+  }
+
+  // Two identical shards, for which equal weights are exact:
+  {
+    std::vector<Eigen::VectorXd> means (2, Eigen::VectorXd::Ones (2));
+    std::vector<Eigen::MatrixXd> covariances (2, Eigen::MatrixXd::Identity (2,2));
+
+    check (means, covariances, Combination::Weighting::equal);
+  }
+}
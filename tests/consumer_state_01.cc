@@ -0,0 +1,215 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the save(), load(), and merge() functions of the consumers that
+// compute statistics: Split a sequence of samples in two halves, let one
+// set of consumers see the first half, save their state, and load it into
+// a second set of consumers that then see the second half; then also merge
+// the state of a third set of consumers that only saw the second half into
+// a copy of the first. Compare the results against consumers that saw all
+// samples.
+//
+// For the autocovariance consumers, merging two objects that have seen
+// different sequences does not yield the same as seeing the concatenated
+// sequence (the pairs straddling the boundary are missing), except for
+// lag zero, where the result must be the (trace of the) covariance
+// matrix of all samples.
+
+
+#include <cmath>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/pair_histogram.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::Vector2d;
+
+
+// A set of consumers of vector-valued samples, along with consumers of
+// the first component of these samples.
+struct Consumers
+{
+  SampleFlow::Consumers::CountSamples<SampleType>         count;
+  SampleFlow::Consumers::MeanValue<SampleType>            mean;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType>     covariance;
+  SampleFlow::Consumers::PairHistogram<SampleType>        pair_histogram {-2, 2, 4, -2, 2, 5};
+  SampleFlow::Consumers::AcceptanceRatio<SampleType>      acceptance_ratio;
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType>  autocovariance_trace {5};
+  SampleFlow::Consumers::AutoCovarianceMatrix<SampleType> autocovariance_matrix {5};
+  SampleFlow::Consumers::Histogram<double>                histogram {-2, 2, 8};
+
+  SampleFlow::Producers::Range<SampleType> vector_producer;
+  SampleFlow::Producers::Range<double>     scalar_producer;
+
+  Consumers ()
+  {
+    count.connect_to_producer (vector_producer);
+    mean.connect_to_producer (vector_producer);
+    covariance.connect_to_producer (vector_producer);
+    pair_histogram.connect_to_producer (vector_producer);
+    acceptance_ratio.connect_to_producer (vector_producer);
+    autocovariance_trace.connect_to_producer (vector_producer);
+    autocovariance_matrix.connect_to_producer (vector_producer);
+    histogram.connect_to_producer (scalar_producer);
+  }
+
+  void sample (const std::vector<SampleType> &samples)
+  {
+    vector_producer.sample (samples);
+
+    std::vector<double> first_components;
+    for (const auto &s : samples)
+      first_components.push_back (s[0]);
+    scalar_producer.sample (first_components);
+  }
+
+  std::vector<char> save () const
+  {
+    std::vector<char> buffer;
+    count.save (buffer);
+    mean.save (buffer);
+    covariance.save (buffer);
+    pair_histogram.save (buffer);
+    acceptance_ratio.save (buffer);
+    autocovariance_trace.save (buffer);
+    autocovariance_matrix.save (buffer);
+    histogram.save (buffer);
+    return buffer;
+  }
+
+  void load (const std::vector<char> &data)
+  {
+    std::span<const char> buffer (data);
+    count.load (buffer);
+    mean.load (buffer);
+    covariance.load (buffer);
+    pair_histogram.load (buffer);
+    acceptance_ratio.load (buffer);
+    autocovariance_trace.load (buffer);
+    autocovariance_matrix.load (buffer);
+    histogram.load (buffer);
+    if (buffer.size() != 0)
+      std::cout << "Not all data was read!" << std::endl;
+  }
+
+  void merge (const Consumers &other)
+  {
+    count.merge (other.count);
+    mean.merge (other.mean);
+    covariance.merge (other.covariance);
+    pair_histogram.merge (other.pair_histogram);
+    acceptance_ratio.merge (other.acceptance_ratio);
+    autocovariance_trace.merge (other.autocovariance_trace);
+    autocovariance_matrix.merge (other.autocovariance_matrix);
+    histogram.merge (other.histogram);
+  }
+};
+
+
+
+// Compare the results of all consumers but the autocovariance ones
+bool same_statistics (const Consumers &a, const Consumers &b)
+{
+  bool same = (a.count.get() == b.count.get());
+  same &= ((a.mean.get() - b.mean.get()).norm() < 1e-12);
+  same &= ((a.covariance.get() - b.covariance.get()).norm() < 1e-12);
+  same &= (a.pair_histogram.get() == b.pair_histogram.get());
+  same &= (std::fabs(a.acceptance_ratio.get() - b.acceptance_ratio.get()) < 1e-12);
+  same &= (a.histogram.get() == b.histogram.get());
+  return same;
+}
+
+
+
+bool same_autocovariances (const Consumers &a, const Consumers &b)
+{
+  bool same = true;
+  const auto trace_a = a.autocovariance_trace.get();
+  const auto trace_b = b.autocovariance_trace.get();
+  const auto matrix_a = a.autocovariance_matrix.get();
+  const auto matrix_b = b.autocovariance_matrix.get();
+  for (unsigned int l=0; l<trace_a.size(); ++l)
+    {
+      same &= (std::fabs(trace_a[l] - trace_b[l]) < 1e-12);
+      same &= ((matrix_a[l] - matrix_b[l]).norm() < 1e-12);
+    }
+  return same;
+}
+
+
+
+int main ()
+{
+  // Create a deterministic but irregular sequence of samples in which
+  // some samples are repeated, as in a Markov chain:
+  std::vector<SampleType> first_half, second_half;
+  for (unsigned int i=0; i<1000; ++i)
+    {
+      SampleType s;
+      s << 1.5*std::sin(i*i*0.37), 1.5*std::cos(i*1.93 + std::sin(i*0.1));
+      (i<500 ? first_half : second_half).push_back (s);
+      if (i % 3 == 0)
+        (i<500 ? first_half : second_half).push_back (s);
+    }
+
+  Consumers all;
+  all.sample (first_half);
+  all.sample (second_half);
+
+  Consumers first;
+  first.sample (first_half);
+
+  // Continue from saved state:
+  Consumers continued;
+  continued.load (first.save());
+  continued.sample (second_half);
+  std::cout << "Continued, statistics: " << same_statistics(continued, all) << std::endl;
+  std::cout << "Continued, autocovariances: " << same_autocovariances(continued, all) << std::endl;
+
+  // Merge with consumers that only saw the second half:
+  Consumers second;
+  second.sample (second_half);
+  Consumers merged;
+  merged.load (first.save());
+  merged.merge (second);
+  std::cout << "Merged, statistics: " << same_statistics(merged, all) << std::endl;
+
+  std::cout << "Merged, autocovariances for lag zero: "
+            << (std::fabs(merged.autocovariance_trace.get()[0]
+                          - all.covariance.get().trace()) < 1e-12)
+            << ' '
+            << ((merged.autocovariance_matrix.get()[0]
+                 - all.covariance.get()).norm() < 1e-12)
+            << std::endl;
+
+  std::cout << "Number of samples: " << merged.count.get() << ' ' << all.count.get() << std::endl;
+  std::cout << "Acceptance ratio: " << merged.acceptance_ratio.get() << std::endl;
+}
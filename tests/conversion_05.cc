@@ -0,0 +1,155 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that a Conversion filter whose conversion function takes its
+// argument by rvalue reference can reuse the sample it receives, and
+// that one whose conversion function modifies the sample in place sends
+// on the sample it received. In both cases, no copies should be made.
+
+
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumer.h>
+#  include <sampleflow/filters/conversion.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A sample type that counts how often objects of its type are copied.
+struct CountedSample
+{
+    CountedSample (const double value = 0)
+      :
+      value (value)
+    {}
+
+    CountedSample (const CountedSample &other)
+      :
+      value (other.value)
+    {
+      ++n_copies;
+    }
+
+    CountedSample (CountedSample &&other) = default;
+
+    CountedSample &
+    operator= (const CountedSample &other)
+    {
+      value = other.value;
+      ++n_copies;
+      return *this;
+    }
+
+    CountedSample &
+    operator= (CountedSample &&other) = default;
+
+    double value;
+
+    static unsigned int n_copies;
+};
+
+unsigned int CountedSample::n_copies = 0;
+
+
+// A type that wraps a CountedSample, and that we convert to.
+struct Wrapper
+{
+    CountedSample sample;
+};
+
+
+
+// A producer that simply sends its argument downstream.
+class Issuer : public SampleFlow::Producer<CountedSample>
+{
+  public:
+    void
+    sample (CountedSample &&sample)
+    {
+      this->issue_sample (std::move(sample), {});
+      this->flush_consumers ();
+    }
+};
+
+
+
+// A consumer that stores the value of the last sample it received.
+template <typename SampleType>
+class Sink : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    ~Sink ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if constexpr (std::is_same_v<SampleType,Wrapper>)
+        value = sample.sample.value;
+      else
+        value = sample.value;
+    }
+
+    double
+    get () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return value;
+    }
+
+  private:
+    mutable std::mutex mutex;
+    double             value = 0;
+};
+
+
+int main ()
+{
+  Issuer issuer;
+
+  const auto wrap = [](CountedSample &&sample)
+  {
+    return Wrapper {std::move(sample)};
+  };
+  SampleFlow::Filters::Conversion<CountedSample, Wrapper, decltype(wrap)> wrapping (wrap);
+  wrapping.connect_to_producer (issuer);
+  Sink<Wrapper> wrapper_sink;
+  wrapper_sink.connect_to_producer (wrapping);
+
+  const auto scale = [](CountedSample &sample)
+  {
+    sample.value *= 2;
+  };
+  SampleFlow::Filters::Conversion<CountedSample, CountedSample, decltype(scale)> scaling (scale);
+  scaling.connect_to_producer (issuer);
+  Sink<CountedSample> scaled_sink;
+  scaled_sink.connect_to_producer (scaling);
+
+  // The issuer has two consumers, and so has to make one copy of the
+  // sample. The filters should not make any more:
+  issuer.sample (CountedSample(3));
+  std::cout << "Wrapped: " << wrapper_sink.get() << std::endl
+            << "Scaled: " << scaled_sink.get() << std::endl
+            << "Copies: " << CountedSample::n_copies << std::endl;
+}
@@ -0,0 +1,63 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that snapshots taken from a CopyOnWrite object are not affected
+// by later modifications, and that modifications made while nobody
+// holds a snapshot do not need to copy the object.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/copy_on_write.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  SampleFlow::CopyOnWrite<std::vector<int>> values (std::vector<int>(1, 1));
+
+  // Modify the object while nobody holds a snapshot. This should
+  // happen in place.
+  const std::vector<int> *address = values.snapshot().get();
+  values.modify ([](std::vector<int> &v)
+  {
+    v.push_back (2);
+  });
+  std::cout << "Modified in place: " << (values.snapshot().get() == address)
+            << std::endl;
+
+  // Now take a snapshot and modify the object again. The snapshot has
+  // to keep showing the old state.
+  const auto snapshot = values.snapshot();
+  values.modify ([](std::vector<int> &v)
+  {
+    v.push_back (3);
+  });
+
+  std::cout << "Snapshot:";
+  for (const int i : *snapshot)
+    std::cout << ' ' << i;
+  std::cout << std::endl;
+
+  std::cout << "Current value:";
+  for (const int i : *values.snapshot())
+    std::cout << ' ' << i;
+  std::cout << std::endl;
+}
@@ -0,0 +1,182 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the CoupledMetropolisHastings producer: Estimate the mean value
+// and the second moment of a normal distribution with mean 3 and
+// variance 1 from chains that all start far away from it, at -5. Then
+// check that the estimate of each run only depends on its number, not on
+// the number of threads, and that runs whose chains do not meet within
+// the maximal number of steps are abandoned.
+
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/coupled_metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+SampleType draw_starting_point (std::mt19937 &)
+{
+  return -5;
+}
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-3)*(x-3)/2;
+}
+
+
+SampleType perturb (const SampleType &x, std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 1.);
+  return x + distribution(rng);
+}
+
+
+double log_proposal_density (const SampleType &x, const SampleType &y)
+{
+  return -(y-x)*(y-x)/2;
+}
+
+
+int main ()
+{
+  SampleFlow::Producers::CoupledMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.first_averaged_step = 10;
+  parameters.last_averaged_step = 50;
+
+  // First estimate the mean value, and store the estimate of each run
+  // along with the largest meeting time:
+  const std::size_t n_runs = 4000;
+  std::vector<double> estimates (n_runs);
+  SampleFlow::types::sample_index max_meeting_time = 0;
+  std::size_t n_estimates = 0;
+  {
+    SampleFlow::Producers::CoupledMetropolisHastings<SampleType> coupled_sampler (parameters);
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (coupled_sampler);
+
+    SampleFlow::Consumers::Action<SampleType> store_estimates
+    ([&](const SampleType &estimate, const SampleFlow::AuxiliaryData &aux_data)
+    {
+      const std::size_t run = *aux_data.get_if<std::size_t>(SampleFlow::AuxiliaryData::chain_number);
+      const SampleFlow::types::sample_index meeting_time
+        = *aux_data.get_if<SampleFlow::types::sample_index>(SampleFlow::AuxiliaryData::meeting_time);
+      estimates[run] = estimate;
+      max_meeting_time = std::max (max_meeting_time, meeting_time);
+      ++n_estimates;
+    });
+    store_estimates.connect_to_producer (coupled_sampler);
+
+    coupled_sampler.sample (&draw_starting_point,
+                            &log_likelihood,
+                            &perturb,
+                            &log_proposal_density,
+                            n_runs,
+                            std::make_shared<SampleFlow::ThreadPool> (4));
+
+    std::cout << "Number of estimates: " << n_estimates << std::endl
+              << "Mean value correct: " << (std::fabs(mean_value.get() - 3) < 0.05) << std::endl
+              << "Chains met after burn-in in some runs: " << (max_meeting_time > parameters.first_averaged_step)
+              << std::endl;
+  }
+
+  // Then estimate the second moment E[x^2] = 1 + 3^2 = 10:
+  {
+    SampleFlow::Producers::CoupledMetropolisHastings<SampleType> coupled_sampler (parameters);
+
+    SampleFlow::Consumers::MeanValue<double> mean_value;
+    mean_value.connect_to_producer (coupled_sampler);
+
+    coupled_sampler.sample (&draw_starting_point,
+                            &log_likelihood,
+                            &perturb,
+                            &log_proposal_density,
+                            [](const SampleType &x)
+    {
+      return x*x;
+    },
+    n_runs,
+    std::make_shared<SampleFlow::ThreadPool> (4));
+
+    std::cout << "Second moment correct: " << (std::fabs(mean_value.get() - 10) < 0.2) << std::endl;
+  }
+
+  // Recompute the first 100 estimates on a single thread:
+  {
+    SampleFlow::Producers::CoupledMetropolisHastings<SampleType> coupled_sampler (parameters);
+
+    bool same_estimates = true;
+    SampleFlow::Consumers::Action<SampleType> compare_estimates
+    ([&](const SampleType &estimate, const SampleFlow::AuxiliaryData &aux_data)
+    {
+      const std::size_t run = *aux_data.get_if<std::size_t>(SampleFlow::AuxiliaryData::chain_number);
+      if (estimate != estimates[run])
+        same_estimates = false;
+    });
+    compare_estimates.connect_to_producer (coupled_sampler);
+
+    coupled_sampler.sample (&draw_starting_point,
+                            &log_likelihood,
+                            &perturb,
+                            &log_proposal_density,
+                            100,
+                            std::make_shared<SampleFlow::ThreadPool> (1));
+
+    std::cout << "Same estimates on one thread: " << same_estimates << std::endl;
+  }
+
+  // Finally, limit the number of steps so that the chains of some runs
+  // do not meet in time, and verify that these runs are abandoned:
+  {
+    parameters.max_steps = parameters.last_averaged_step + 1;
+    SampleFlow::Producers::CoupledMetropolisHastings<SampleType> coupled_sampler (parameters);
+
+    n_estimates = 0;
+    SampleFlow::Consumers::Action<SampleType> count_estimates
+    ([&](const SampleType &, const SampleFlow::AuxiliaryData &)
+    {
+      ++n_estimates;
+    });
+    count_estimates.connect_to_producer (coupled_sampler);
+
+    coupled_sampler.sample (&draw_starting_point,
+                            &log_likelihood,
+                            &perturb,
+                            &log_proposal_density,
+                            n_runs);
+
+    std::cout << "Some runs abandoned: " << (coupled_sampler.n_abandoned_runs() > 0) << std::endl
+              << "All runs accounted for: "
+              << (n_estimates + coupled_sampler.n_abandoned_runs() == n_runs) << std::endl;
+  }
+}
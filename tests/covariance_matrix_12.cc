@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the CovarianceMatrix consumer computes the same matrix
+// for a sample type whose elements are stored contiguously (and for
+// which the class uses Eigen's symmetric rank-one update) and for a
+// sample type for which it has to go through the elements one at a
+// time, and that the matrix returned is exactly symmetric.
+
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+#include <random>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A vector class that only offers element access via operator[], so
+// that CovarianceMatrix cannot use its fast path.
+class Point
+{
+  public:
+    Point () = default;
+
+    Point (const std::vector<double> &values)
+      : values (values)
+    {}
+
+    double operator[] (const std::size_t i) const
+    {
+      return values[i];
+    }
+
+    std::size_t size () const
+    {
+      return values.size();
+    }
+
+    Point &operator+= (const Point &p)
+    {
+      for (std::size_t i=0; i<values.size(); ++i)
+        values[i] += p.values[i];
+      return *this;
+    }
+
+    Point &operator-= (const Point &p)
+    {
+      for (std::size_t i=0; i<values.size(); ++i)
+        values[i] -= p.values[i];
+      return *this;
+    }
+
+    Point &operator/= (const std::size_t n)
+    {
+      for (double &v : values)
+        v /= n;
+      return *this;
+    }
+
+    Point operator* (const double d) const
+    {
+      Point p = *this;
+      for (double &v : p.values)
+        v *= d;
+      return p;
+    }
+
+  private:
+    std::vector<double> values;
+};
+
+
+Point operator* (const double d, const Point &p)
+{
+  return p * d;
+}
+
+
+
+int main ()
+{
+  static_assert (SampleFlow::Concepts::has_contiguous_storage<std::valarray<double>,double>);
+  static_assert (SampleFlow::Concepts::has_contiguous_storage<Point,double> == false);
+
+  const unsigned int dimension = 20;
+
+  SampleFlow::Consumers::CovarianceMatrix<std::valarray<double>> contiguous_covariance;
+  SampleFlow::Consumers::CovarianceMatrix<Point> generic_covariance;
+
+  std::mt19937 rng;
+  for (unsigned int n=0; n<1000; ++n)
+    {
+      std::vector<double> sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = SampleFlow::Testing::NormalDistribution<double>(0,1+i)(rng);
+
+      SampleFlow::AuxiliaryData aux_data;
+      contiguous_covariance.consume (std::valarray<double>(sample.data(), dimension), aux_data);
+      generic_covariance.consume (Point(sample), aux_data);
+    }
+
+  const auto C1 = contiguous_covariance.get();
+  const auto C2 = generic_covariance.get();
+
+  std::cout << "Size: " << C1.rows() << 'x' << C1.cols() << std::endl;
+  std::cout << "Symmetric: " << (C1 == C1.transpose()) << ' '
+            << (C2 == C2.transpose()) << std::endl;
+  std::cout << "Relative difference below 1e-12: "
+            << ((C1-C2).norm() < 1e-12 * C1.norm()) << std::endl;
+  std::cout << "Diagonal entries: " << C1(0,0) << ' ' << C1(dimension-1,dimension-1)
+            << std::endl;
+}
@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the CovarianceMatrix and MeanValue consumers compute the
+// same results if they receive weighted samples in batches (for which
+// they use a blocked update for sample types with contiguous storage)
+// as when they receive the same samples one at a time. Some of the
+// samples have weight zero and must not contribute anything.
+
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::vector<std::vector<double>> &values,
+           const std::vector<SampleFlow::AuxiliaryData> &aux_data)
+{
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> batched_covariance;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  SampleFlow::Consumers::MeanValue<SampleType> batched_mean;
+  SampleFlow::Consumers::MeanValue<SampleType> mean;
+
+  const unsigned int dimension = values[0].size();
+  const unsigned int batch_size = 37;
+  for (unsigned int start=0; start<values.size(); start+=batch_size)
+    {
+      std::vector<SampleType> samples;
+      std::vector<SampleFlow::AuxiliaryData> batch_aux_data;
+      for (unsigned int n=start; n<std::min<std::size_t>(start+batch_size, values.size()); ++n)
+        {
+          SampleType sample (dimension);
+          for (unsigned int i=0; i<dimension; ++i)
+            sample[i] = values[n][i];
+
+          covariance.consume (sample, aux_data[n]);
+          mean.consume (sample, aux_data[n]);
+
+          samples.push_back (sample);
+          batch_aux_data.push_back (aux_data[n]);
+        }
+
+      batched_covariance.consume_batch (samples, batch_aux_data);
+      batched_mean.consume_batch (samples, batch_aux_data);
+    }
+
+  const auto C1 = batched_covariance.get();
+  const auto C2 = covariance.get();
+  std::cout << "Covariance: symmetric=" << (C1 == C1.transpose())
+            << ", same as for single samples="
+            << ((C1-C2).norm() < 1e-12 * C2.norm()) << std::endl;
+
+  const SampleType m1 = batched_mean.get();
+  const SampleType m2 = mean.get();
+  double difference = 0, norm = 0;
+  for (unsigned int i=0; i<dimension; ++i)
+    {
+      difference += (m1[i]-m2[i]) * (m1[i]-m2[i]);
+      norm += m2[i] * m2[i];
+    }
+  std::cout << "Mean value: same as for single samples="
+            << (difference < 1e-24 * norm) << std::endl;
+
+  std::cout << "C(0,0)=" << C1(0,0) << ", C(3,1)=" << C1(3,1)
+            << ", mean[2]=" << m1[2] << std::endl;
+}
+
+
+
+int main ()
+{
+  const unsigned int dimension = 5;
+  const unsigned int n_samples = 1000;
+
+  std::mt19937 rng;
+  std::vector<std::vector<double>> values (n_samples, std::vector<double>(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i,1)(rng)
+                       + (i == 3 ? 0.5*values[n][1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double((n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  test<std::valarray<double>> (values, aux_data);
+  test<Eigen::VectorXd> (values, aux_data);
+}
@@ -0,0 +1,126 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the CovarianceMatrix consumer computes the same results for
+// sample types whose size is known at compile time (for which it stores
+// its state in fixed-size matrices) as for Eigen::VectorXd, whether
+// samples arrive one at a time or in batches, and when the state is
+// saved and loaded again. Also check Utilities::static_size for a number
+// of types.
+
+
+#include <array>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/fixed_vector.h>
+#else
+import SampleFlow;
+#endif
+
+
+static_assert (SampleFlow::Utilities::static_size<double> == 1);
+static_assert (SampleFlow::Utilities::static_size<double[4]> == 4);
+static_assert (SampleFlow::Utilities::static_size<std::array<double,3>> == 3);
+static_assert (SampleFlow::Utilities::static_size<Eigen::Vector3d> == 3);
+static_assert (SampleFlow::Utilities::static_size<Eigen::Matrix2d> == 4);
+static_assert (SampleFlow::Utilities::static_size<SampleFlow::FixedVector<double,3>> == 3);
+static_assert (SampleFlow::Utilities::static_size<Eigen::VectorXd> == std::dynamic_extent);
+static_assert (SampleFlow::Utilities::static_size<std::vector<double>> == std::dynamic_extent);
+static_assert (SampleFlow::Utilities::static_size<std::valarray<double>> == std::dynamic_extent);
+
+
+const unsigned int dimension = 3;
+
+
+template <typename SampleType>
+Eigen::MatrixXd test (const std::vector<std::vector<double>>       &values,
+                      const std::vector<SampleFlow::AuxiliaryData> &aux_data)
+{
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> batched_covariance;
+
+  // Before any samples are received, the matrix is empty:
+  std::cout << "Initial size: " << covariance.get().rows() << 'x'
+            << covariance.get().cols() << std::endl;
+
+  std::vector<SampleType> samples;
+  for (unsigned int n=0; n<values.size(); ++n)
+    {
+      SampleType sample;
+      if constexpr (requires { sample.resize (dimension); })
+        sample.resize (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = values[n][i];
+
+      covariance.consume (sample, aux_data[n]);
+      samples.push_back (sample);
+    }
+  batched_covariance.consume_batch (samples, aux_data);
+
+  // Save and load the state:
+  std::vector<char> buffer;
+  covariance.save (buffer);
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> loaded_covariance;
+  std::span<const char> data (buffer);
+  loaded_covariance.load (data);
+
+  const Eigen::MatrixXd C = covariance.get();
+  std::cout << "Batched same as single samples: "
+            << ((batched_covariance.get() - C).norm() < 1e-12 * C.norm()) << std::endl;
+  std::cout << "Loaded same as saved: " << (loaded_covariance.get() == C) << std::endl;
+
+  return C;
+}
+
+
+
+int main ()
+{
+  const unsigned int n_samples = 1000;
+
+  std::mt19937 rng;
+  std::vector<std::vector<double>> values (n_samples, std::vector<double>(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i,1)(rng)
+                       + (i == 2 ? 0.5*values[n][1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double((n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  const Eigen::MatrixXd C_dynamic = test<Eigen::VectorXd> (values, aux_data);
+  const Eigen::MatrixXd C_eigen   = test<Eigen::Vector3d> (values, aux_data);
+  const Eigen::MatrixXd C_fixed   = test<SampleFlow::FixedVector<double,dimension>> (values, aux_data);
+
+  std::cout << "Same for Eigen::Vector3d: "
+            << ((C_eigen - C_dynamic).norm() < 1e-12 * C_dynamic.norm()) << std::endl;
+  std::cout << "Same for FixedVector: "
+            << ((C_fixed - C_dynamic).norm() < 1e-12 * C_dynamic.norm()) << std::endl;
+
+  std::cout << "C(1,1)=" << C_dynamic(1,1) << ", C(2,1)=" << C_dynamic(2,1) << std::endl;
+}
@@ -0,0 +1,135 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the CovarianceMatrix consumer computes the same results in
+// Evaluation::lazy mode as in the default eager mode, for samples that
+// arrive one at a time and in batches, from several threads, with weights
+// and repetition counts, and when the state is saved, loaded, and merged.
+
+
+#include <iostream>
+#include <random>
+#include <thread>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType, typename AccumulatorType = SampleType>
+void test (const std::vector<Eigen::VectorXd>            &values,
+           const std::vector<SampleFlow::AuxiliaryData> &aux_data)
+{
+  using CM = SampleFlow::Consumers::CovarianceMatrix<SampleType,AccumulatorType>;
+  CM eager;
+  CM lazy (SampleFlow::Evaluation::lazy);
+  CM lazy_batched (SampleFlow::Evaluation::lazy);
+
+  std::vector<SampleType> samples;
+  for (const auto &v : values)
+    {
+      SampleType sample (v.size());
+      for (unsigned int i=0; i<v.size(); ++i)
+        sample[i] = v[i];
+      samples.push_back (sample);
+    }
+
+  for (unsigned int n=0; n<samples.size(); ++n)
+    eager.consume (samples[n], aux_data[n]);
+
+  // Send the samples to the lazy objects from several threads, so that
+  // they end up in different shards:
+  const unsigned int n_threads = 4;
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<n_threads; ++t)
+    threads.emplace_back ([&, t]()
+  {
+    const std::size_t begin = t * samples.size() / n_threads;
+    const std::size_t end   = (t+1) * samples.size() / n_threads;
+    for (std::size_t n=begin; n<end; ++n)
+      lazy.consume (samples[n], aux_data[n]);
+
+    lazy_batched.consume_batch (std::vector<SampleType> (samples.begin()+begin, samples.begin()+end),
+                                std::vector<SampleFlow::AuxiliaryData> (aux_data.begin()+begin,
+                                                                        aux_data.begin()+end));
+  });
+  for (auto &thread : threads)
+    thread.join();
+
+  const Eigen::MatrixXd C = eager.get();
+  const auto same = [&C](const Eigen::MatrixXd &D)
+  {
+    return ((D - C).norm() < 1e-10 * C.norm());
+  };
+
+  std::cout << "Lazy same as eager: " << same (lazy.get()) << std::endl;
+  std::cout << "Lazy batched same as eager: " << same (lazy_batched.get()) << std::endl;
+
+  // Saving a lazy object saves the evaluated state, which can be loaded
+  // into an eager object:
+  std::vector<char> buffer;
+  lazy.save (buffer);
+  CM loaded;
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  std::cout << "Loaded same as eager: " << same (loaded.get()) << std::endl;
+
+  // Merging two lazy objects that each have seen half of the samples:
+  CM first_half (SampleFlow::Evaluation::lazy);
+  CM second_half (SampleFlow::Evaluation::lazy);
+  for (unsigned int n=0; n<samples.size(); ++n)
+    (n < samples.size()/2 ? first_half : second_half).consume (samples[n], aux_data[n]);
+  first_half.merge (second_half);
+  std::cout << "Merged same as eager: " << same (first_half.get()) << std::endl;
+}
+
+
+
+int main ()
+{
+  const unsigned int dimension = 5;
+  const unsigned int n_samples = 10000;
+
+  std::mt19937 rng;
+  std::vector<Eigen::VectorXd> values (n_samples, Eigen::VectorXd(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i,1)(rng)
+                       + (i > 0 ? 0.5*values[n][i-1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double((n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  std::cout << "Eigen::VectorXd:" << std::endl;
+  test<Eigen::VectorXd> (values, aux_data);
+
+  std::cout << "std::valarray<double>:" << std::endl;
+  test<std::valarray<double>> (values, aux_data);
+
+  std::cout << "Eigen::VectorXf with Eigen::VectorXd accumulator:" << std::endl;
+  test<Eigen::VectorXf,Eigen::VectorXd> (values, aux_data);
+}
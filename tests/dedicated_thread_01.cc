@@ -0,0 +1,109 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check ParallelMode::dedicated_thread: Samples have to be processed on a
+// thread other than the one that generates them, but in the order in
+// which they were generated, and order-dependent consumers such as
+// AutoCovarianceTrace have to compute the same result as in synchronous
+// mode even with a small queue.
+
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+
+
+// A consumer that records the samples it receives and the threads on
+// which it receives them.
+class Recorder : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    Recorder ()
+      :
+      SampleFlow::Consumer<SampleType>(SampleFlow::ParallelMode::dedicated_thread)
+    {}
+
+    ~Recorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      samples.push_back (sample[0]);
+      threads.push_back (std::this_thread::get_id());
+    }
+
+    mutable std::mutex           mutex;
+    std::vector<double>          samples;
+    std::vector<std::thread::id> threads;
+};
+
+
+int main ()
+{
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<10000; ++i)
+    samples.push_back ({1.*(i%17), 1.*(i%5)});
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> synchronous_autocovariance (5);
+  synchronous_autocovariance.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> dedicated_autocovariance (5);
+  dedicated_autocovariance.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 4);
+  dedicated_autocovariance.connect_to_producer (range_producer);
+
+  Recorder recorder;
+  recorder.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 4);
+  recorder.connect_to_producer (range_producer);
+
+  range_producer.sample (samples);
+
+  // Range::sample() flushes its consumers, so everything has been
+  // processed by now.
+  bool in_order = (recorder.samples.size() == samples.size());
+  for (unsigned int i=0; in_order && i<samples.size(); ++i)
+    if (recorder.samples[i] != samples[i][0])
+      in_order = false;
+  std::cout << "Samples processed in order: " << in_order << std::endl;
+
+  bool on_one_other_thread = true;
+  for (const auto &thread : recorder.threads)
+    if ((thread == std::this_thread::get_id()) || (thread != recorder.threads[0]))
+      on_one_other_thread = false;
+  std::cout << "Samples processed on one other thread: " << on_one_other_thread << std::endl;
+
+  const auto synchronous_result = synchronous_autocovariance.get();
+  const auto dedicated_result = dedicated_autocovariance.get();
+  std::cout << "Same autocovariances: " << (synchronous_result == dedicated_result) << std::endl;
+}
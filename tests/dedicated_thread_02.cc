@@ -0,0 +1,152 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the WaitPolicy of consumers in ParallelMode::dedicated_thread and
+// of ThreadPool workers: Send samples from several threads at once, in
+// bursts separated by pauses so that the worker thread runs out of
+// samples and, depending on the policy, goes to sleep in between. No
+// matter whether the worker goes to sleep right away, only after a
+// while, or (practically) never, it has to process every sample, and
+// flush() has to wait for all of them.
+
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumer.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer whose samples are sent from whatever thread calls sample().
+class Issuer : public SampleFlow::Producer<int>
+{
+  public:
+    void
+    sample (const int sample)
+    {
+      this->issue_sample (sample, SampleFlow::AuxiliaryData());
+    }
+};
+
+
+// A consumer that adds up the samples it receives. In the modes used
+// here, it is only ever called from one thread at a time, namely the
+// worker thread or one task of the thread pool at a time.
+class Sum : public SampleFlow::Consumer<int>
+{
+  public:
+    Sum ()
+      :
+      SampleFlow::Consumer<int>(SampleFlow::ParallelMode(static_cast<int>(SampleFlow::ParallelMode::asynchronous)
+                                                         |
+                                                         static_cast<int>(SampleFlow::ParallelMode::dedicated_thread))),
+      sum (0),
+      n_samples (0)
+    {}
+
+    ~Sum ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (int sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      sum += sample;
+      ++n_samples;
+    }
+
+    long int     sum;
+    unsigned int n_samples;
+};
+
+
+
+void send_in_bursts (Issuer &issuer)
+{
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<4; ++t)
+    threads.emplace_back ([&issuer, t]()
+  {
+    for (unsigned int burst=0; burst<50; ++burst)
+      {
+        for (unsigned int i=0; i<200; ++i)
+          issuer.sample (t*10000 + burst*200 + i);
+        std::this_thread::sleep_for (std::chrono::microseconds(100 * (burst%3)));
+      }
+  });
+  for (auto &thread : threads)
+    thread.join();
+}
+
+
+
+int main ()
+{
+  // The sum of all samples sent by send_in_bursts():
+  long int expected_sum = 0;
+  for (unsigned int t=0; t<4; ++t)
+    for (unsigned int i=0; i<10000; ++i)
+      expected_sum += t*10000 + i;
+
+  const std::vector<SampleFlow::WaitPolicy> wait_policies
+  = { {0, 0}, {}, {1U<<20, 1000} };
+
+  for (const SampleFlow::WaitPolicy &wait_policy : wait_policies)
+    {
+      Issuer issuer;
+      Sum sum;
+      sum.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 16);
+      sum.set_wait_policy (wait_policy);
+      sum.connect_to_producer (issuer);
+
+      send_in_bursts (issuer);
+      sum.flush ();
+
+      std::cout << "Dedicated thread, " << wait_policy.n_spins << " spins, "
+                << wait_policy.n_yields << " yields: "
+                << sum.n_samples << " samples, sum correct: "
+                << (sum.sum == expected_sum) << std::endl;
+    }
+
+  for (const SampleFlow::WaitPolicy &wait_policy : wait_policies)
+    {
+      const auto thread_pool = std::make_shared<SampleFlow::ThreadPool> (2);
+      thread_pool->set_wait_policy (wait_policy);
+
+      Issuer issuer;
+      Sum sum;
+      sum.set_thread_pool (thread_pool);
+      sum.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 16);
+      sum.connect_to_producer (issuer);
+
+      send_in_bursts (issuer);
+      sum.flush ();
+
+      std::cout << "Thread pool, " << wait_policy.n_spins << " spins, "
+                << wait_policy.n_yields << " yields: "
+                << sum.n_samples << " samples, sum correct: "
+                << (sum.sum == expected_sum) << std::endl;
+    }
+}
@@ -0,0 +1,101 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the DelayedAcceptanceMetropolisHastings producer: Sample a
+// standard normal distribution using a surrogate that is a normal
+// distribution with a different mean and variance. Despite the error in
+// the surrogate, the samples have to have mean zero and variance one.
+// Also check that the AuxiliaryData::rejection_stage entry is consistent
+// with the number of times the exact likelihood is evaluated.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/delayed_acceptance_mh.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+unsigned int n_evaluations = 0;
+
+double log_likelihood (const SampleType &x)
+{
+  ++n_evaluations;
+  return -0.5 * x * x;
+}
+
+
+double surrogate_log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x-0.3) * (x-0.3) / (1.2*1.2);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::normal_distribution<double> distribution(0, 2);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  SampleFlow::Producers::DelayedAcceptanceMetropolisHastings<SampleType> da_sampler;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (da_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (da_sampler);
+
+  unsigned int n_per_stage[3] = {0, 0, 0};
+  bool         repeated_consistent = true;
+  SampleFlow::Consumers::Action<SampleType> count_stages
+  ([&](const SampleType &, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    const unsigned int stage = *aux_data.get_if<unsigned int>(SampleFlow::AuxiliaryData::rejection_stage);
+    ++n_per_stage[stage];
+    if (*aux_data.get_if<bool>(SampleFlow::AuxiliaryData::sample_is_repeated) != (stage != 0))
+      repeated_consistent = false;
+  });
+  count_stages.connect_to_producer (da_sampler);
+
+  const SampleFlow::types::sample_index n_samples = 400000;
+  da_sampler.sample (0., &log_likelihood, &surrogate_log_likelihood, &perturb, n_samples);
+
+  std::cout << "Mean value correct: "
+            << (std::fabs(mean_value.get()) < 0.02) << std::endl
+            << "Variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 1) < 0.03) << std::endl
+            << "Stage counts add up: "
+            << (n_per_stage[0] + n_per_stage[1] + n_per_stage[2] == n_samples) << std::endl
+            << "Exact evaluations only after first stage: "
+            << (n_evaluations == 1 + n_per_stage[0] + n_per_stage[2]) << std::endl
+            << "Some trial samples rejected in each stage: "
+            << (n_per_stage[1] > 0 && n_per_stage[2] > 0) << std::endl
+            << "Repeated samples consistent: "
+            << repeated_consistent << std::endl;
+}
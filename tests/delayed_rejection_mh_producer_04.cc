@@ -0,0 +1,79 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the DelayedRejectionMetropolisHastings producer samples the
+// correct distribution also with many delayed rejection stages. We use an
+// independence proposal that draws trial samples uniformly from an
+// interval, regardless of the current and the rejected samples; the
+// proposal distribution is then symmetric in the sense the algorithm
+// assumes, and the samples have to have the mean and variance of the
+// (standard normal) target distribution. This is a test of the way the
+// acceptance probability of later delayed rejection stages is computed
+// from those of the earlier stages and the reversed paths. With eight
+// stages, the test also makes sure that this computation does not take
+// time exponential in the number of stages.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/delayed_rejection_mh.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * x * x;
+}
+
+
+std::pair<SampleType,double> propose (const SampleType &, const std::vector<SampleType> &)
+{
+  static std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution(-8, 8);
+  return {distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  for (const unsigned int max_delays : {2, 4, 8})
+    {
+      SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType> drmh_sampler;
+
+      SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+      mean_value.connect_to_producer (drmh_sampler);
+
+      SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+      covariance_matrix.connect_to_producer (drmh_sampler);
+
+      drmh_sampler.sample (0, &log_likelihood, &propose, max_delays, 200000);
+
+      std::cout << "max_delays=" << max_delays << ':' << std::endl
+                << "  mean value correct: "
+                << (std::fabs(mean_value.get()) < 0.02) << std::endl
+                << "  variance correct: "
+                << (std::fabs(covariance_matrix.get()(0,0) - 1) < 0.03) << std::endl;
+    }
+}
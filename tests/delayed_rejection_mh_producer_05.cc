@@ -0,0 +1,101 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Like the _04 test, but evaluate the likelihoods of three delayed
+// rejection stages at a time concurrently on a thread pool
+// (Parameters::n_concurrent_stages). The samples have to follow the same
+// distribution as before. Also check that the number of likelihood
+// evaluations is what we expect: In each step, the stages are evaluated
+// in groups of three, and so the number of evaluations per step is a
+// multiple of three unless the last (partial) group of stages is
+// reached.
+
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/delayed_rejection_mh.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+std::atomic<unsigned int> n_evaluations (0);
+
+double log_likelihood (const SampleType &x)
+{
+  ++n_evaluations;
+  return -0.5 * x * x;
+}
+
+
+std::pair<SampleType,double> propose (const SampleType &, const std::vector<SampleType> &)
+{
+  static std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution(-8, 8);
+  return {distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int max_delays = 7;
+  const SampleFlow::types::sample_index n_samples = 200000;
+
+  SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.n_concurrent_stages = 3;
+  parameters.thread_pool = std::make_shared<SampleFlow::ThreadPool> (4);
+  SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType> drmh_sampler (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (drmh_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (drmh_sampler);
+
+  // Count the steps by checking how the number of evaluations grows from
+  // one sample to the next:
+  unsigned int previous_n_evaluations = 1;
+  bool         n_evaluations_correct  = true;
+  SampleFlow::Consumers::Action<SampleType> check_evaluations
+  ([&](const SampleType &, const SampleFlow::AuxiliaryData &)
+  {
+    const unsigned int n = n_evaluations - previous_n_evaluations;
+    if ((n % 3 != 0) && (n != max_delays+1))
+      n_evaluations_correct = false;
+    previous_n_evaluations = n_evaluations;
+  });
+  check_evaluations.connect_to_producer (drmh_sampler);
+
+  drmh_sampler.sample (0, &log_likelihood, &propose, max_delays, n_samples);
+
+  std::cout << "mean value correct: "
+            << (std::fabs(mean_value.get()) < 0.02) << std::endl
+            << "variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 1) < 0.03) << std::endl
+            << "number of evaluations correct: "
+            << n_evaluations_correct << std::endl
+            << "at least three evaluations per step: "
+            << (n_evaluations > 3*n_samples) << std::endl;
+}
@@ -0,0 +1,110 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the DelayedRejectionMetropolisHastings::sample() function that
+// takes a proposal function writing its trial sample into an existing
+// object. It has to produce the same samples as the variant that returns
+// the trial sample, but since the objects the trial samples are written
+// into are re-used from one step to the next, it has to allocate (at
+// least) one object less per proposal.
+
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include "allocation_counter.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/delayed_rejection_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x*x).sum();
+}
+
+
+int main ()
+{
+  const unsigned int max_delays = 3;
+  const SampleFlow::types::sample_index n_samples = 1000;
+
+  std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution(-4, 4);
+  unsigned int n_proposals = 0;
+
+  // Run the sampler with each of the two kinds of proposal functions,
+  // starting the proposal's random number generator from the same state,
+  // and record the samples and the number of allocations:
+  const auto run = [&](const auto &propose)
+  {
+    rng.seed (1);
+
+    SampleFlow::Producers::DelayedRejectionMetropolisHastings<SampleType> drmh_sampler;
+
+    std::vector<SampleType> samples;
+    samples.reserve (n_samples);
+    SampleFlow::Consumers::Action<SampleType> record_samples
+    ([&](const SampleType &sample, const SampleFlow::AuxiliaryData &)
+    {
+      samples.push_back (sample);
+    });
+    record_samples.connect_to_producer (drmh_sampler);
+
+    const std::uint64_t n_allocations_before = SampleFlow::Testing::n_allocations();
+    drmh_sampler.sample (SampleType {0., 0., 0.}, &log_likelihood, propose, max_delays, n_samples);
+
+    return std::make_pair (samples, SampleFlow::Testing::n_allocations() - n_allocations_before);
+  };
+
+  const auto [samples_1, n_allocations_1]
+    = run ([&](const SampleType &x, const std::vector<SampleType> &)
+  {
+    ++n_proposals;
+
+    SampleType y = x;
+    for (auto &el : y)
+      el = distribution(rng);
+    return std::make_pair (y, 1.0);
+  });
+
+  const auto [samples_2, n_allocations_2]
+    = run ([&](const SampleType &, const std::vector<SampleType> &, SampleType &y)
+  {
+    for (auto &el : y)
+      el = distribution(rng);
+    return 1.0;
+  });
+
+  bool same_samples = (samples_1.size() == samples_2.size());
+  for (std::size_t i=0; same_samples && (i<samples_1.size()); ++i)
+    same_samples = (samples_1[i] == samples_2[i]).min();
+
+  std::cout << "number of samples: " << samples_1.size() << std::endl
+            << "same samples: " << same_samples << std::endl
+            << "more than one proposal per step: " << (n_proposals > n_samples) << std::endl
+            << "allocations saved: "
+            << (n_allocations_1 >= n_allocations_2 + n_proposals - (max_delays+1)) << std::endl;
+}
@@ -0,0 +1,331 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check DeviceLogLikelihood with a device that is emulated on the host:
+// Its "streams" are threads that execute the operations enqueued in
+// them in order, and its "device memory" is ordinary memory. Running
+// several MetropolisHastings chains, and DifferentialEvaluation-
+// MetropolisHastings, with a batch log likelihood that goes through
+// the emulated device needs to give the same samples as evaluating
+// the log likelihood on the host, with one synchronization per buffer
+// and batch.
+
+
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/device_log_likelihood.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+
+// See the comment in differential_evaluation_mh_producer_01.cc.
+#  include <future>
+
+import SampleFlow;
+
+#endif
+
+
+// A queue of operations that a thread executes in order.
+class Stream
+{
+  public:
+    Stream ()
+      : worker ([this]()
+    {
+      run();
+    })
+    {}
+
+    ~Stream ()
+    {
+      enqueue (nullptr);
+      worker.join();
+    }
+
+    void enqueue (std::function<void ()> &&operation)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      operations.emplace_back (std::move(operation));
+      ++n_enqueued;
+      condition.notify_all();
+    }
+
+    void synchronize ()
+    {
+      std::unique_lock<std::mutex> lock (mutex);
+      condition.wait (lock, [this]()
+      {
+        return (n_done == n_enqueued);
+      });
+    }
+
+  private:
+    void run ()
+    {
+      while (true)
+        {
+          std::function<void ()> operation;
+          {
+            std::unique_lock<std::mutex> lock (mutex);
+            condition.wait (lock, [this]()
+            {
+              return (operations.size() > 0);
+            });
+            operation = std::move (operations.front());
+            operations.pop_front();
+          }
+          if (!operation)
+            return;
+          operation();
+
+          std::lock_guard<std::mutex> lock (mutex);
+          ++n_done;
+          condition.notify_all();
+        }
+    }
+
+    std::mutex                         mutex;
+    std::condition_variable            condition;
+    std::deque<std::function<void ()>> operations;
+    std::size_t                        n_enqueued = 0;
+    std::size_t                        n_done     = 0;
+    std::thread                        worker;
+};
+
+
+struct EmulatedDevice
+{
+  using stream_type = Stream *;
+
+  stream_type create_stream ()
+  {
+    return new Stream();
+  }
+
+  void destroy_stream (stream_type stream)
+  {
+    delete stream;
+  }
+
+  void *allocate_host_memory (const std::size_t n_bytes)
+  {
+    return std::malloc (n_bytes);
+  }
+
+  void free_host_memory (void *pointer)
+  {
+    std::free (pointer);
+  }
+
+  void *allocate_device_memory (const std::size_t n_bytes)
+  {
+    return std::malloc (n_bytes);
+  }
+
+  void free_device_memory (void *pointer)
+  {
+    std::free (pointer);
+  }
+
+  void copy_to_device (void *device_pointer, const void *host_pointer,
+                       const std::size_t n_bytes, stream_type stream)
+  {
+    stream->enqueue ([=]()
+    {
+      std::memcpy (device_pointer, host_pointer, n_bytes);
+    });
+  }
+
+  void copy_to_host (void *host_pointer, const void *device_pointer,
+                     const std::size_t n_bytes, stream_type stream)
+  {
+    copy_to_device (host_pointer, device_pointer, n_bytes, stream);
+  }
+
+  void synchronize (stream_type stream)
+  {
+    stream->synchronize();
+  }
+};
+
+
+
+// The "kernel": Enqueue the evaluation of a Gaussian log likelihood
+// centered at (1,...,1) in the stream.
+void kernel (const double *samples,
+             const std::size_t n_samples,
+             const std::size_t sample_size,
+             double *log_likelihoods,
+             Stream *stream)
+{
+  stream->enqueue ([=]()
+  {
+    for (std::size_t i=0; i<n_samples; ++i)
+      {
+        log_likelihoods[i] = 0;
+        for (std::size_t d=0; d<sample_size; ++d)
+          log_likelihoods[i] -= (samples[i*sample_size+d]-1) * (samples[i*sample_size+d]-1);
+      }
+  });
+}
+
+
+
+template <typename SampleType>
+void host_log_likelihood (std::span<const SampleType> samples,
+                          std::span<double> log_likelihoods)
+{
+  for (std::size_t i=0; i<samples.size(); ++i)
+    {
+      log_likelihoods[i] = 0;
+      for (std::size_t d=0; d<SampleFlow::Utilities::size(samples[i]); ++d)
+        {
+          const double x = SampleFlow::Utilities::get_nth_element (samples[i], d);
+          log_likelihoods[i] -= (x-1) * (x-1);
+        }
+    }
+}
+
+
+
+void test_metropolis_hastings ()
+{
+  using SampleType = std::vector<double>;
+
+  SampleFlow::DeviceLogLikelihood<SampleType,EmulatedDevice>
+  device_log_likelihood (EmulatedDevice(), &kernel);
+
+  const auto propose = [](const SampleType &x, std::mt19937 &rng)
+  {
+    std::normal_distribution<double> distribution(0, 0.5);
+    SampleType y = x;
+    for (double &y_d : y)
+      y_d += distribution(rng);
+    return std::make_pair (y, 1.0);
+  };
+
+  std::vector<SampleType> samples[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+      {
+        samples[run].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      const std::vector<SampleType> starting_points
+      = {{-1., 0., 2.}, {0., 0., 0.}, {2., 3., 1.}, {3., -1., 0.}, {1., 1., 1.}};
+      if (run == 0)
+        mh_sampler.sample_chains (starting_points, &host_log_likelihood<SampleType>, propose, 100);
+      else
+        mh_sampler.sample_chains (starting_points, device_log_likelihood, propose, 100);
+    }
+
+  std::cout << "MH: number of samples: " << samples[1].size() << std::endl;
+  std::cout << "MH: same samples: " << (samples[0] == samples[1]) << std::endl;
+  std::cout << "MH: number of batches: " << device_log_likelihood.n_batches() << std::endl;
+  std::cout << "MH: number of synchronizations: " << device_log_likelihood.n_synchronizations() << std::endl;
+}
+
+
+
+std::mt19937 rng;
+
+void test_differential_evaluation ()
+{
+  using SampleType = double;
+
+  // Use three buffers, and evaluate on the device in single precision:
+  SampleFlow::DeviceLogLikelihood<SampleType,EmulatedDevice,float>
+  device_log_likelihood (EmulatedDevice(),
+                         [](const float *samples, const std::size_t n_samples, const std::size_t,
+                            double *log_likelihoods, Stream *stream)
+  {
+    stream->enqueue ([=]()
+    {
+      for (std::size_t i=0; i<n_samples; ++i)
+        log_likelihoods[i] = -(samples[i]-1.f) * (samples[i]-1.f);
+    });
+  },
+  3);
+
+  const auto propose = [](const SampleType &x)
+  {
+    std::normal_distribution<double> distribution(0, 0.5);
+    return std::make_pair (x + distribution(rng), 1.0);
+  };
+  const auto crossover = [](const SampleType &x, const SampleType &a, const SampleType &b)
+  {
+    return x + 0.5 * (a - b);
+  };
+
+  std::vector<SampleType> samples[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      rng.seed (1);
+
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+      {
+        samples[run].push_back (static_cast<float>(sample));
+      });
+      action.connect_to_producer (de_sampler);
+
+      // Round the starting points to single precision so that both runs
+      // see the same log likelihoods at least there:
+      if (run == 0)
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           [](std::span<const SampleType> x, std::span<double> log_likelihoods)
+      {
+        for (std::size_t i=0; i<x.size(); ++i)
+          log_likelihoods[i] = -(static_cast<float>(x[i])-1.f) * (static_cast<float>(x[i])-1.f);
+      },
+      propose, crossover, 2, 400);
+      else
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           device_log_likelihood,
+                           propose, crossover, 2, 400);
+    }
+
+  std::cout << "DE: number of samples: " << samples[1].size() << std::endl;
+  std::cout << "DE: same samples: " << (samples[0] == samples[1]) << std::endl;
+  std::cout << "DE: number of batches: " << device_log_likelihood.n_batches() << std::endl;
+  std::cout << "DE: number of synchronizations: " << device_log_likelihood.n_synchronizations() << std::endl;
+}
+
+
+
+int main ()
+{
+  test_metropolis_hastings ();
+  test_differential_evaluation ();
+}
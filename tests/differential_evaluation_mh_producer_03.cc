@@ -0,0 +1,117 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the variant of the DEMH producer that takes a function
+// evaluating the log likelihood for a batch of samples at once: It
+// should call this function once for the starting points and once
+// per generation, and produce the same samples as the variant that
+// evaluates one sample at a time.
+
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+#include <cmath>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+
+// See the comment in differential_evaluation_mh_producer_01.cc.
+#  include <future>
+
+import SampleFlow;
+
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+unsigned int n_batch_evaluations = 0;
+
+void batch_log_likelihood (std::span<const SampleType> samples,
+                           std::span<double> log_likelihoods)
+{
+  ++n_batch_evaluations;
+  std::cout << "Evaluating a batch of " << samples.size() << " samples" << std::endl;
+  for (std::size_t i=0; i<samples.size(); ++i)
+    log_likelihoods[i] = log_likelihood (samples[i]);
+}
+
+
+std::mt19937 rng;
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+SampleType crossover(const SampleType &current_sample,
+                     const SampleType &sample_a,
+                     const SampleType &sample_b)
+{
+  return current_sample + 0.5 * (sample_a - sample_b);
+}
+
+
+
+int main ()
+{
+  std::vector<SampleType> samples[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      rng.seed (1);
+
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler;
+
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+      {
+        samples[run].push_back (sample);
+      });
+      action.connect_to_producer (de_sampler);
+
+      // Get 18 samples on four chains, i.e., four complete
+      // generations and a partial one:
+      if (run == 0)
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           &log_likelihood,
+                           &perturb,
+                           &crossover,
+                           2,
+                           18);
+      else
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           &batch_log_likelihood,
+                           &perturb,
+                           &crossover,
+                           2,
+                           18);
+    }
+
+  std::cout << "Number of batch evaluations: " << n_batch_evaluations << std::endl;
+  std::cout << "Number of samples: " << samples[1].size() << std::endl;
+  std::cout << "Same samples: " << (samples[0] == samples[1]) << std::endl;
+}
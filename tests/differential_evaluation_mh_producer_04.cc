@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the variant of the DEMH producer that takes a function
+// returning a std::future for the log likelihood: The evaluations for
+// all chains of a generation should be in flight at the same time, and
+// the samples should be the same as for the variant that evaluates one
+// sample at a time.
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cmath>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+
+// See the comment in differential_evaluation_mh_producer_01.cc.
+#  include <future>
+
+import SampleFlow;
+
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+// Simulate a remote evaluation by returning a deferred future, and
+// keep track of how many evaluations have been started but not
+// finished.
+unsigned int n_in_flight     = 0;
+unsigned int max_n_in_flight = 0;
+
+std::future<double> asynchronous_log_likelihood (const SampleType &x)
+{
+  ++n_in_flight;
+  max_n_in_flight = std::max (max_n_in_flight, n_in_flight);
+
+  return std::async (std::launch::deferred,
+                     [x]()
+  {
+    --n_in_flight;
+    return log_likelihood (x);
+  });
+}
+
+
+std::mt19937 rng;
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+SampleType crossover(const SampleType &current_sample,
+                     const SampleType &sample_a,
+                     const SampleType &sample_b)
+{
+  return current_sample + 0.5 * (sample_a - sample_b);
+}
+
+
+
+int main ()
+{
+  std::vector<SampleType> samples[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      rng.seed (1);
+
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler;
+
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+      {
+        samples[run].push_back (sample);
+      });
+      action.connect_to_producer (de_sampler);
+
+      // Get 18 samples on four chains, i.e., four complete
+      // generations and a partial one:
+      if (run == 0)
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           &log_likelihood,
+                           &perturb,
+                           &crossover,
+                           2,
+                           18,
+                           false);
+      else
+        de_sampler.sample ({-1., 0., 2., 3.},
+                           &asynchronous_log_likelihood,
+                           &perturb,
+                           &crossover,
+                           2,
+                           18);
+    }
+
+  std::cout << "Maximal number of evaluations in flight: " << max_n_in_flight << std::endl;
+  std::cout << "Evaluations left in flight: " << n_in_flight << std::endl;
+  std::cout << "Number of samples: " << samples[1].size() << std::endl;
+  std::cout << "Same samples: " << (samples[0] == samples[1]) << std::endl;
+}
@@ -0,0 +1,126 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that DifferentialEvaluationMetropolisHastings does not copy
+// samples in every step: Use a sample type that counts how often it is
+// copied, and proposal and crossover functions that create new objects
+// rather than copying their arguments. Then the only copies are the ones
+// made when setting up the population, regardless of how many samples
+// are produced.
+
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#else
+#  include <future>
+import SampleFlow;
+#endif
+
+
+// A vector that counts how often objects of this type are copied.
+struct CountedVector
+{
+  static unsigned int n_copies;
+
+  std::vector<double> values;
+
+  CountedVector (const std::size_t n = 0)
+    : values (n)
+  {}
+
+  CountedVector (const CountedVector &other)
+    : values (other.values)
+  {
+    ++n_copies;
+  }
+
+  CountedVector (CountedVector &&other) = default;
+
+  CountedVector &operator= (const CountedVector &other)
+  {
+    values = other.values;
+    ++n_copies;
+    return *this;
+  }
+
+  CountedVector &operator= (CountedVector &&other) = default;
+};
+
+unsigned int CountedVector::n_copies = 0;
+
+using SampleType = CountedVector;
+
+
+void log_likelihood (std::span<const SampleType> samples,
+                     std::span<double> log_likelihoods)
+{
+  for (std::size_t i=0; i<samples.size(); ++i)
+    {
+      log_likelihoods[i] = 0;
+      for (const double x : samples[i].values)
+        log_likelihoods[i] -= 0.5 * (x-1)*(x-1);
+    }
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::normal_distribution<double> distribution(0, 0.1);
+
+  SampleType y (x.values.size());
+  for (std::size_t i=0; i<y.values.size(); ++i)
+    y.values[i] = x.values[i] + distribution(rng);
+  return {std::move(y), 1.0};
+}
+
+
+SampleType crossover (const SampleType &current_sample,
+                      const SampleType &sample_a,
+                      const SampleType &sample_b)
+{
+  SampleType y (current_sample.values.size());
+  for (std::size_t i=0; i<y.values.size(); ++i)
+    y.values[i] = current_sample.values[i] + 0.5 * (sample_a.values[i] - sample_b.values[i]);
+  return y;
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 8;
+  const std::vector<SampleType> starting_points (n_chains, SampleType (100));
+
+  for (const unsigned int n_generations : {10, 1000})
+    {
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler;
+
+      CountedVector::n_copies = 0;
+      de_sampler.sample (starting_points,
+                         &log_likelihood,
+                         &perturb,
+                         &crossover,
+                         2,
+                         n_generations * n_chains);
+
+      std::cout << n_generations << " generations: "
+                << CountedVector::n_copies << " copies" << std::endl;
+    }
+}
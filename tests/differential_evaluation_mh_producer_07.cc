@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the DifferentialEvaluationMetropolisHastings producer with an
+// archive of past states from which the samples for the crossover are
+// drawn ("DE-MCz"): Sample a correlated Gaussian in two dimensions with
+// only three, and then only two chains, and check the mean value and
+// covariance matrix of the samples. Without the archive, the algorithm
+// would need many more chains to explore the distribution well.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::Vector2d;
+
+
+void check (const std::vector<SampleType> &starting_points)
+{
+  const SampleType mu (1,2);
+  Eigen::Matrix2d C;
+  C << 1, 0.8,
+  0.8, 1;
+  const Eigen::Matrix2d C_inverse = C.inverse();
+
+  const auto log_likelihood = [&](const SampleType &x)
+  {
+    const SampleType y = x-mu;
+    return -0.5 * y.dot(C_inverse*y);
+  };
+
+  // Add a small random perturbation to every sample, so that the chains
+  // can also move in directions not spanned by the differences of
+  // archived samples:
+  std::mt19937 rng;
+  std::normal_distribution<double> distribution (0, 0.01);
+  const auto perturb = [&](const SampleType &x) -> std::pair<SampleType,double>
+  {
+    return {x + SampleType (distribution(rng), distribution(rng)), 1.0};
+  };
+
+  const double gamma = 2.38 / std::sqrt(2.*2);
+  const auto crossover = [&](const SampleType &current_sample,
+                             const SampleType &sample_a,
+                             const SampleType &sample_b) -> SampleType
+  {
+    return current_sample + gamma * (sample_a - sample_b);
+  };
+
+  typename SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.archive_size     = 10000;
+  parameters.archive_thinning = 10;
+  SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler (parameters);
+
+  const SampleFlow::types::sample_index n_samples = 300000;
+  SampleFlow::Filters::DiscardFirstN<SampleType> discard (n_samples/10);
+  discard.connect_to_producer (de_sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (discard);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (discard);
+
+  de_sampler.sample (starting_points,
+                     log_likelihood,
+                     perturb,
+                     crossover,
+                     1,
+                     n_samples,
+                     false);
+
+  std::cout << starting_points.size() << " chains:" << std::endl;
+  std::cout << "  mean value correct: "
+            << ((mean_value.get() - mu).norm() < 0.05) << std::endl;
+  std::cout << "  covariance matrix correct: "
+            << ((covariance_matrix.get() - C).norm() < 0.05 * C.norm()) << std::endl;
+}
+
+
+int main ()
+{
+  check ({SampleType (0,0), SampleType (2,1), SampleType (1,3)});
+  check ({SampleType (0,0), SampleType (2,3)});
+}
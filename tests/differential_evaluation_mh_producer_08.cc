@@ -0,0 +1,188 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the DifferentialEvaluationMetropolisHastings producer with
+// proposal and crossover functions that take a random number generator,
+// for which the trial samples of each generation are created concurrently
+// with one random number stream per chain: Sample a correlated Gaussian in
+// two dimensions and check that the samples are the same regardless of
+// how many threads create the trial samples, that their mean value and
+// covariance matrix are correct, and that a run interrupted and resumed
+// from a checkpoint produces the same samples as one that is not.
+
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/checkpointer.h>
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::Vector2d;
+using Sampler    = SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType>;
+
+
+const SampleType mu (1,2);
+
+
+double log_likelihood (const SampleType &x)
+{
+  Eigen::Matrix2d C;
+  C << 1, 0.8,
+  0.8, 1;
+  const SampleType y = x-mu;
+  return -0.5 * y.dot(C.inverse()*y);
+}
+
+
+std::pair<SampleType,double>
+perturb (const SampleType &x, std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution (0, 0.1);
+  return {x + SampleType (distribution(rng), distribution(rng)), 1.0};
+}
+
+
+SampleType
+crossover (const SampleType &current_sample,
+           const SampleType &sample_a,
+           const SampleType &sample_b,
+           std::mt19937 &rng)
+{
+  // Randomize the scaling factor a bit, as is common:
+  const double gamma = 2.38 / std::sqrt(2.*2) * std::uniform_real_distribution<double>(0.9, 1.1)(rng);
+  return current_sample + gamma * (sample_a - sample_b);
+}
+
+
+std::vector<SampleType> run (const unsigned int n_threads)
+{
+  Sampler::Parameters parameters;
+  parameters.proposal_thread_pool = std::make_shared<SampleFlow::ThreadPool> (n_threads);
+  Sampler de_sampler (parameters);
+
+  std::vector<SampleType> samples;
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&samples](SampleType x, SampleFlow::AuxiliaryData)
+  {
+    samples.push_back (x);
+  });
+  action.connect_to_producer (de_sampler);
+
+  const std::vector<SampleType> starting_points (8, mu);
+  de_sampler.sample (starting_points, &log_likelihood, &perturb, &crossover, 1, 80000, false, 42);
+
+  return samples;
+}
+
+
+void check_threads ()
+{
+  const std::vector<SampleType> samples_1 = run (1);
+  const std::vector<SampleType> samples_4 = run (4);
+
+  SampleType mean = SampleType::Zero();
+  Eigen::Matrix2d covariance = Eigen::Matrix2d::Zero();
+  const std::size_t first = samples_1.size() / 10;
+  for (std::size_t i=first; i<samples_1.size(); ++i)
+    mean += samples_1[i];
+  mean /= (samples_1.size() - first);
+  for (std::size_t i=first; i<samples_1.size(); ++i)
+    covariance += (samples_1[i] - mean) * (samples_1[i] - mean).transpose();
+  covariance /= (samples_1.size() - first - 1);
+
+  std::cout << "n_samples: " << samples_1.size() << std::endl
+            << "same samples with 1 and 4 threads: " << (samples_1 == samples_4) << std::endl
+            << "mean correct: " << ((mean - mu).norm() < 0.05) << std::endl
+            << "covariance correct: " << (std::abs(covariance(0,0) - 1) < 0.05) << ' '
+            << (std::abs(covariance(0,1) - 0.8) < 0.05) << ' '
+            << (std::abs(covariance(1,1) - 1) < 0.05) << std::endl;
+}
+
+
+void check_resume ()
+{
+  const std::vector<SampleType> starting_points = {SampleType(0,0), SampleType(1,0),
+                                                   SampleType(0,1), SampleType(1,1)
+                                                  };
+
+  std::vector<SampleType> uninterrupted, interrupted;
+  Sampler::Parameters parameters;
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&](SampleType x, SampleFlow::AuxiliaryData)
+    {
+      uninterrupted.push_back (x);
+    });
+    action.connect_to_producer (de_sampler);
+    de_sampler.sample (starting_points, &log_likelihood, &perturb, &crossover, 3, 800, false, 7);
+  }
+
+  parameters.checkpointer = std::make_shared<SampleFlow::Checkpointer> ("differential_evaluation_mh_producer_08.checkpoint");
+  parameters.checkpoint_interval = 10;
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&](SampleType x, SampleFlow::AuxiliaryData)
+    {
+      interrupted.push_back (x);
+      if (interrupted.size() == 300)
+        de_sampler.request_stop ();
+    });
+    action.connect_to_producer (de_sampler);
+    de_sampler.sample (starting_points, &log_likelihood, &perturb, &crossover, 3, 800, false, 7);
+  }
+
+  parameters.checkpointer->wait ();
+  {
+    Sampler de_sampler (parameters);
+    SampleFlow::Consumers::Action<SampleType>
+    action ([&](SampleType x, SampleFlow::AuxiliaryData)
+    {
+      interrupted.push_back (x);
+    });
+    action.connect_to_producer (de_sampler);
+    de_sampler.resume (SampleFlow::Checkpointer::read ("differential_evaluation_mh_producer_08.checkpoint"),
+                       &log_likelihood, &perturb, &crossover, 3, 800, false);
+  }
+  parameters.checkpointer->wait ();
+  std::remove ("differential_evaluation_mh_producer_08.checkpoint");
+
+  std::cout << "resumed: " << interrupted.size() << ' '
+            << (interrupted == uninterrupted) << std::endl;
+}
+
+
+int main ()
+{
+  check_threads ();
+  check_resume ();
+}
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Like the _05 test, but with tasks that take several steps of a chain
+// at a time (see DifferentialEvaluationMetropolisHastings::Parameters::
+// grain_size), and a number of samples that is not a multiple of the
+// grain size.
+
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/thread_pool.h>
+#else
+#  include <future>
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+// A Gaussian with mean one and unit variance. Samples in the right tail
+// take much longer to evaluate than others.
+double log_likelihood (const SampleType &x)
+{
+  if (x > 1.5)
+    std::this_thread::sleep_for (std::chrono::microseconds(100));
+  return -0.5 * (x-1)*(x-1);
+}
+
+
+// The proposal function is called concurrently from several threads, so
+// uses a random number generator per thread.
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  thread_local std::mt19937 rng (std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+SampleType crossover (const SampleType &current_sample,
+                      const SampleType &sample_a,
+                      const SampleType &sample_b)
+{
+  return current_sample + (2.38/std::sqrt(2.)) * (sample_a - sample_b);
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 8;
+
+  SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.grain_size = 16;
+  SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler (parameters);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (de_sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (de_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (de_sampler);
+
+  std::mutex mutex;
+  std::vector<unsigned int> counts (n_chains, 0);
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType, SampleFlow::AuxiliaryData aux_data)
+  {
+    const std::size_t chain
+      = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+    std::lock_guard<std::mutex> lock (mutex);
+    ++counts[chain];
+  });
+  action.connect_to_producer (de_sampler);
+
+  de_sampler.sample_asynchronously (std::vector<SampleType> (n_chains, 0.),
+                                    &log_likelihood,
+                                    &perturb,
+                                    &crossover,
+                                    10,
+                                    40003,
+                                    {},
+                                    std::make_shared<SampleFlow::ThreadPool>(4));
+
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+
+  bool all_chains_progressed = true;
+  unsigned int sum_of_counts = 0;
+  for (const unsigned int count : counts)
+    {
+      all_chains_progressed = all_chains_progressed && (count > 1000);
+      sum_of_counts += count;
+    }
+  std::cout << "All chains made progress: " << all_chains_progressed << std::endl;
+  std::cout << "Chain counts add up: " << (sum_of_counts == count_samples.get()) << std::endl;
+
+  std::cout << "Mean value close to one: "
+            << (std::fabs(mean_value.get() - 1) < 0.1) << std::endl;
+  std::cout << "Variance close to one: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 1) < 0.1) << std::endl;
+}
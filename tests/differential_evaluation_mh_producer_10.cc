@@ -0,0 +1,210 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that the per-chain outputs of the DifferentialEvaluationMetropolisHastings
+// class (see DifferentialEvaluationMetropolisHastings::chain_output()) send
+// each of their consumers exactly the samples of their chain, in the same
+// order in which they are sent through the combined output. Do this both
+// for generation-by-generation sampling and for asynchronous sampling, and
+// only connect consumers to some of the chains. In the asynchronous case,
+// how many samples each chain produces depends on scheduling, so we only
+// output the total number. Finally, check that a consumer can be connected to
+// the output of a chain while sampling is running, and then receives the
+// remaining samples of that chain.
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/thread_pool.h>
+#else
+#  include <future>
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  thread_local std::mt19937 rng (std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+SampleType crossover (const SampleType &current_sample,
+                      const SampleType &sample_a,
+                      const SampleType &sample_b)
+{
+  return current_sample + (2.38/std::sqrt(2.)) * (sample_a - sample_b);
+}
+
+
+template <typename Sample>
+void test (Sample &&sample)
+{
+  const unsigned int n_chains = 6;
+  const std::vector<unsigned int> observed_chains = {1, 4};
+
+  SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType> de_sampler;
+
+  // Record the samples of each chain as they come through the combined
+  // output...
+  std::mutex mutex;
+  std::vector<std::vector<SampleType>> combined (n_chains);
+  SampleFlow::Consumers::Action<SampleType>
+  combined_action ([&](SampleType s, SampleFlow::AuxiliaryData aux_data)
+  {
+    const std::size_t chain
+      = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+    std::lock_guard<std::mutex> lock (mutex);
+    combined[chain].push_back (s);
+  });
+  combined_action.connect_to_producer (de_sampler);
+
+  // ...and as they come through the per-chain outputs, along with the
+  // chain numbers that come with them.
+  std::map<unsigned int,std::vector<SampleType>> per_chain;
+  std::map<unsigned int,bool> chain_numbers_match;
+  std::vector<std::unique_ptr<SampleFlow::Consumers::Action<SampleType>>> per_chain_actions;
+  for (const unsigned int c : observed_chains)
+    {
+      chain_numbers_match[c] = true;
+      per_chain_actions.emplace_back (
+        std::make_unique<SampleFlow::Consumers::Action<SampleType>>(
+          [&, c](SampleType s, SampleFlow::AuxiliaryData aux_data)
+      {
+        per_chain[c].push_back (s);
+        if (std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]) != c)
+          chain_numbers_match[c] = false;
+      }));
+      per_chain_actions.back()->connect_to_producer (de_sampler.chain_output(c));
+    }
+
+  sample (de_sampler, std::vector<SampleType> (n_chains, 0.));
+
+  std::size_t n_samples = 0;
+  for (const auto &samples : combined)
+    n_samples += samples.size();
+  std::cout << "Number of samples: " << n_samples << std::endl;
+
+  for (const unsigned int c : observed_chains)
+    std::cout << "Chain " << c << ": "
+              << "same as combined output: " << (per_chain[c] == combined[c])
+              << ", chain numbers match: " << chain_numbers_match[c]
+              << std::endl;
+}
+
+
+int main ()
+{
+  using Sampler = SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<SampleType>;
+
+  std::cout << "Generations:" << std::endl;
+  test ([](Sampler &de_sampler, const std::vector<SampleType> &starting_points)
+  {
+    de_sampler.sample (starting_points,
+                       &log_likelihood,
+                       &perturb,
+                       &crossover,
+                       10,
+                       6*1000,
+                       42);
+  });
+
+  std::cout << "Asynchronous:" << std::endl;
+  test ([](Sampler &de_sampler, const std::vector<SampleType> &starting_points)
+  {
+    de_sampler.sample_asynchronously (starting_points,
+                                      &log_likelihood,
+                                      &perturb,
+                                      &crossover,
+                                      10,
+                                      6*1000,
+                                      {},
+                                      std::make_shared<SampleFlow::ThreadPool>(3));
+  });
+
+  // Connect a consumer to the output of chain 5 from a consumer of the
+  // combined output once some samples have been produced. The new consumer
+  // needs to receive all samples of the chain from then on, except possibly
+  // for one that was sent through the output of the chain but not yet
+  // through the combined output at the time.
+  {
+    Sampler de_sampler;
+
+    std::mutex mutex;
+    std::vector<SampleType> chain_5;
+    std::vector<SampleType> late;
+    SampleFlow::Consumers::Action<SampleType>
+    late_action ([&](SampleType s, SampleFlow::AuxiliaryData)
+    {
+      late.push_back (s);
+    });
+
+    unsigned int n_samples = 0;
+    std::size_t n_chain_5_before_connecting = 0;
+    SampleFlow::Consumers::Action<SampleType>
+    combined_action ([&](SampleType s, SampleFlow::AuxiliaryData aux_data)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      if (std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]) == 5)
+        chain_5.push_back (s);
+      if (++n_samples == 1000)
+        {
+          n_chain_5_before_connecting = chain_5.size();
+          late_action.connect_to_producer (de_sampler.chain_output(5));
+        }
+    });
+    combined_action.connect_to_producer (de_sampler);
+
+    de_sampler.sample_asynchronously (std::vector<SampleType> (6, 0.),
+                                      &log_likelihood,
+                                      &perturb,
+                                      &crossover,
+                                      10,
+                                      6*1000,
+                                      {},
+                                      std::make_shared<SampleFlow::ThreadPool>(3));
+
+    std::cout << "Connected during sampling: "
+              << "received remaining samples: "
+              << (late.size() + 1 >= chain_5.size() - n_chain_5_before_connecting)
+              << ", last samples of the chain: "
+              << ((late.size() <= chain_5.size())
+                  &&
+                  std::equal (late.begin(), late.end(), chain_5.end() - late.size()))
+              << std::endl;
+  }
+}
@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check DirectFileWriter: Write data in pieces of odd sizes, with
+// flushes in between that leave partial blocks behind, through a writer
+// with small buffers so that the buffers are reused many times, and check
+// that the file contains exactly what was written. Then use it underneath
+// a StreamOutput object in binary mode, and as the backend of a
+// ShardedChainOutput object, and read the samples back.
+
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/direct_file_writer.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/producers/chain_file.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <sampleflow/consumers/sharded_chain_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::vector<double>;
+
+
+int main ()
+{
+  const std::string filename = "direct_file_writer_01.bin";
+
+  // Write raw bytes:
+  {
+    std::vector<char> expected;
+    {
+      SampleFlow::DirectFileWriter file (filename, 8192, 3);
+      std::ostream out (&file);
+
+      for (unsigned int i=0; i<2000; ++i)
+        {
+          std::vector<char> piece (1 + (i*37) % 301);
+          for (std::size_t j=0; j<piece.size(); ++j)
+            piece[j] = static_cast<char>(i + 7*j);
+          out.write (piece.data(), piece.size());
+          expected.insert (expected.end(), piece.begin(), piece.end());
+
+          // Also write single characters, which go through overflow():
+          out.put ('x');
+          expected.push_back ('x');
+
+          if (i % 313 == 0)
+            out.flush ();
+        }
+    }
+
+    std::ifstream in (filename, std::ios::binary);
+    const std::vector<char> actual ((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+    std::cout << "Bytes written: " << expected.size()
+              << ", file matches: " << (actual == expected) << std::endl;
+  }
+
+  // Write samples through StreamOutput:
+  {
+    {
+      SampleFlow::DirectFileWriter file (filename, 64*1024);
+      std::ostream out (&file);
+
+      SampleFlow::Producers::Range<SampleType> range_producer;
+      SampleFlow::Consumers::StreamOutput<SampleType>
+      stream_output (out,
+                     SampleFlow::Consumers::StreamOutput<SampleType>::Format::binary,
+                     {}, 10000);
+      stream_output.connect_to_producer (range_producer);
+
+      std::vector<SampleType> samples;
+      for (unsigned int i=0; i<10000; ++i)
+        samples.push_back ({1.*i, -1.*i, 0.5*i});
+      range_producer.sample (samples);
+    }
+
+    SampleFlow::Producers::ChainFile<SampleType> chain_file (filename);
+    bool correct = (chain_file.n_samples() == 10000);
+    for (unsigned int i=0; correct && (i<chain_file.n_samples()); ++i)
+      correct = (chain_file.get_sample(i) == SampleType({1.*i, -1.*i, 0.5*i}));
+    std::cout << "StreamOutput samples: " << chain_file.n_samples()
+              << ", correct: " << correct << std::endl;
+  }
+  std::remove (filename.c_str());
+
+  // Write samples through ShardedChainOutput:
+  {
+    using Output = SampleFlow::Consumers::ShardedChainOutput<SampleType>;
+    {
+      SampleFlow::Producers::Range<SampleType> range_producer;
+      Output output ("direct_file_writer_01", Output::ShardBy::chain, {}, 5000,
+                     SampleFlow::FileWriterBackend::direct);
+      output.connect_to_producer (range_producer);
+
+      std::vector<SampleType> samples;
+      for (unsigned int i=0; i<3333; ++i)
+        samples.push_back ({1.*i});
+      range_producer.sample (samples);
+    }
+
+    for (const Output::ShardDescription &shard
+         : Output::read_index ("direct_file_writer_01.index"))
+      {
+        SampleFlow::Producers::ChainFile<SampleType> chain_file (shard.filename);
+        bool correct = (chain_file.n_samples() == shard.n_samples);
+        for (unsigned int i=0; correct && (i<chain_file.n_samples()); ++i)
+          correct = (chain_file.get_sample(i)[0] == i);
+        std::cout << "Shard " << shard.shard_key << ": " << chain_file.n_samples()
+                  << " samples, correct: " << correct << std::endl;
+        std::remove (shard.filename.c_str());
+      }
+    std::remove ("direct_file_writer_01.index");
+  }
+}
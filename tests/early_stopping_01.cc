@@ -0,0 +1,119 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the EarlyStopping consumer: A Metropolis-Hastings sampler is
+// asked for far more samples than necessary, and an EarlyStopping
+// object stops it once a CountSamples consumer has seen enough
+// samples. Also check that a stop requested before sampling starts
+// makes the sampler return immediately, and that the sampler can be
+// used normally again afterwards.
+
+
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/early_stopping.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -x*x/2;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution(-1,1);
+  return {x+distribution(rng), 1.};
+}
+
+
+int main ()
+{
+  // Stop after 1000 samples, checking every 100 samples:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::EarlyStopping<SampleType>
+    early_stopping (mh_sampler,
+                    [&]()
+    {
+      return (count_samples.get() >= 1000);
+    },
+    100);
+    early_stopping.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample ({0}, &log_likelihood, &perturb, 1000000);
+
+    std::cout << count_samples.get() << ' '
+              << early_stopping.get() << std::endl;
+  }
+
+  // Do the same, but with the EarlyStopping object connected to a
+  // filter rather than the sampler itself. The criterion is only
+  // evaluated every 10th (filtered) sample:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (mh_sampler);
+
+    SampleFlow::Filters::TakeEveryNth<SampleType> take_every_nth (7);
+    take_every_nth.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::EarlyStopping<SampleType>
+    early_stopping (mh_sampler,
+                    [&]()
+    {
+      return (count_samples.get() >= 1000);
+    },
+    10);
+    early_stopping.connect_to_producer (take_every_nth);
+
+    mh_sampler.sample ({0}, &log_likelihood, &perturb, 1000000);
+
+    std::cout << count_samples.get() << std::endl;
+  }
+
+  // Request a stop before sampling, then sample again:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (mh_sampler);
+
+    mh_sampler.request_stop ();
+    mh_sampler.sample ({0}, &log_likelihood, &perturb, 100);
+    std::cout << count_samples.get() << ' '
+              << mh_sampler.stop_requested() << std::endl;
+
+    mh_sampler.sample ({0}, &log_likelihood, &perturb, 100);
+    std::cout << count_samples.get() << std::endl;
+  }
+}
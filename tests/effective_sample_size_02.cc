@@ -0,0 +1,103 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Like the _01 test, but with the spectral estimator of the
+// EffectiveSampleSize class: Estimate the integrated autocorrelation
+// times of two independent AR(1) processes with known integrated
+// autocorrelation times (1+phi)/(1-phi), namely 3 and 19, and check the
+// lag-one autocovariances phi/(1-phi^2) (for innovations with unit
+// variance) as well as that the autocovariances decay with the lag.
+// Then check that feeding the same chain as samples with repetition
+// counts yields the same result as feeding each sample separately.
+
+
+#include <iostream>
+#include <iomanip>
+#include <valarray>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/effective_sample_size.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+int main ()
+{
+  const unsigned int n_samples = 1U << 18;
+  const double phi[2] = {0.5, 0.9};
+
+  std::mt19937 rng;
+  SampleFlow::Testing::NormalDistribution<double> distribution(0., 1.);
+
+  using ESS = SampleFlow::Consumers::EffectiveSampleSize<SampleType>;
+  ESS ess (ESS::Estimator::spectral);
+  SampleType x = {0, 0};
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int j=0; j<2; ++j)
+        x[j] = phi[j]*x[j] + distribution(rng);
+      ess.consume (x, SampleFlow::AuxiliaryData());
+    }
+
+  const std::vector<double> tau = ess.get_integrated_autocorrelation_times();
+  const std::vector<double> n_eff = ess.get();
+  std::cout << std::setprecision(2)
+            << "Integrated autocorrelation times: " << tau[0] << ' ' << tau[1] << std::endl
+            << "Effective sample sizes: " << n_eff[0] << ' ' << n_eff[1] << std::endl;
+
+  const auto autocovariances = ess.get_autocovariances();
+  std::cout << "Lag-one autocovariances: "
+            << autocovariances[0].second[0] << ' ' << autocovariances[0].second[1]
+            << std::endl;
+  for (unsigned int k=0; k<6; ++k)
+    std::cout << "  lag " << autocovariances[k].first << ": "
+              << (autocovariances[k].second[1] > autocovariances[k+1].second[1])
+              << std::endl;
+
+  // Now a chain in which samples are repeated a varying number of times,
+  // once fed one copy at a time and once with repetition counts:
+  ESS individual (ESS::Estimator::spectral), repeated (ESS::Estimator::spectral);
+  for (unsigned int n=0; n<5000; ++n)
+    {
+      for (unsigned int j=0; j<2; ++j)
+        x[j] = phi[j]*x[j] + distribution(rng);
+
+      const std::size_t n_repetitions = 1 + (n*n)%37;
+      for (unsigned int r=0; r<n_repetitions; ++r)
+        individual.consume (x, SampleFlow::AuxiliaryData());
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      repeated.consume (x, aux_data);
+    }
+
+  const std::vector<double> tau_individual = individual.get_integrated_autocorrelation_times();
+  const std::vector<double> tau_repeated = repeated.get_integrated_autocorrelation_times();
+  std::cout << "Repetitions: "
+            << ((std::abs(tau_individual[0]-tau_repeated[0]) < 1e-8*tau_individual[0])
+                &&
+                (std::abs(tau_individual[1]-tau_repeated[1]) < 1e-8*tau_individual[1]))
+            << std::endl;
+}
@@ -0,0 +1,98 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that TakeEveryNth asks its producer to skip the samples it would
+// discard anyway, and that it still passes on the right samples if the
+// producer does not honor the request: when samples come in batches,
+// with repetition counts, or when a second consumer is connected.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <sampleflow/consumers/count_samples.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer that sends its argument downstream, either one by one,
+// with a given repetition count, or as a batch.
+class Issuer : public SampleFlow::Producer<int>
+{
+  public:
+    void
+    sample (const int sample, const std::size_t n_repetitions = 1)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      if (n_repetitions != 1)
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      this->issue_sample (sample, aux_data);
+    }
+
+    void
+    sample_batch (const std::vector<int> &samples)
+    {
+      this->issue_batch (samples,
+                         std::vector<SampleFlow::AuxiliaryData>(samples.size()));
+    }
+};
+
+
+int main ()
+{
+  Issuer issuer;
+
+  SampleFlow::Filters::TakeEveryNth<int> every_3rd (3);
+  every_3rd.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::StreamOutput<int> stream_output (std::cout);
+  stream_output.connect_to_producer (every_3rd);
+
+  // Samples one at a time. After the first one, the filter should have
+  // asked the producer to skip the next two. Check this, and then put
+  // the request back in place:
+  issuer.sample (0);
+  const std::size_t n_to_skip = issuer.cancel_skip_request();
+  std::cout << "Copies to be skipped: " << n_to_skip << std::endl;
+  std::cout << "Request accepted: " << issuer.skip_next_samples (n_to_skip) << std::endl;
+  for (int i=1; i<10; ++i)
+    issuer.sample (i);
+
+  // Samples with repetition counts: The five copies of 10 are copies
+  // 10...14 of the expanded sequence. The producer skips the first two
+  // and sends the sample on with a repetition count of three, of which
+  // the filter passes on one (copy 12). Copies 15 and 18 are both
+  // copies of 11:
+  issuer.sample (10, 5);
+  issuer.sample (11, 4);
+
+  // A batch, whose first element is copy number 19. Since the producer
+  // does not skip elements of batches, the filter has to take back its
+  // request to skip copies 19 and 20:
+  issuer.sample_batch ({12, 13, 14, 15, 16, 17, 18});
+
+  // And then some samples with a second consumer, which should see all
+  // of them, while the filter still only forwards every third:
+  SampleFlow::Consumers::CountSamples<int> count_samples;
+  count_samples.connect_to_producer (issuer);
+  for (int i=19; i<25; ++i)
+    issuer.sample (i);
+  std::cout << "Samples seen by second consumer: " << count_samples.get() << std::endl;
+}
@@ -0,0 +1,109 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that the classes and sample types declared in
+// <sampleflow/explicit_instantiations.h> can be used with the
+// instantiations provided by the SampleFlow.instantiations library: This
+// test does not instantiate any of the member functions of the classes
+// below itself, and so only links if the library provides them.
+
+
+#include <iostream>
+
+#include <sampleflow/explicit_instantiations.h>
+#include <sampleflow/producers/range.h>
+
+
+int main ()
+{
+  // Run a Metropolis-Hastings sampler for scalar samples and feed the
+  // samples to a few consumers:
+  {
+    using SampleType = double;
+
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Filters::DiscardFirstN<SampleType> discard_first_n (10);
+    discard_first_n.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (discard_first_n);
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (discard_first_n);
+
+    SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::Histogram<SampleType> histogram (-10, 10, 4);
+    histogram.connect_to_producer (discard_first_n);
+
+    // Sample from a distribution that only has mass on the integers 0...9,
+    // so that the output does not depend on floating point round-off:
+    std::mt19937 rng;
+    mh_sampler.sample (5.,
+                       [](const SampleType &x)
+    {
+      return ((x >= 0) && (x <= 9) ? 0. : -std::numeric_limits<double>::infinity());
+    },
+    [&](const SampleType &x)
+    {
+      return std::make_pair (x + (std::uniform_int_distribution<int>(0,1)(rng) == 0 ? -1. : 1.),
+                             1.);
+    },
+    10010);
+
+    std::cout << "Number of samples: " << count_samples.get() << std::endl;
+    std::cout << "Mean value: " << mean_value.get() << std::endl;
+    std::cout << "Acceptance ratio: " << acceptance_ratio.get() << std::endl;
+    for (const auto &[bin_min, bin_max, count] : histogram.get())
+      std::cout << "Histogram bin [" << bin_min << ',' << bin_max << "]: "
+                << count << std::endl;
+  }
+
+  // Do the same with vector-valued samples sent through a Range producer,
+  // which is not among the explicitly instantiated classes but uses the
+  // instantiated Producer base class:
+  {
+    using SampleType = Eigen::VectorXd;
+
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Filters::TakeEveryNth<SampleType> take_every_nth (2);
+    take_every_nth.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+    covariance_matrix.connect_to_producer (take_every_nth);
+
+    SampleFlow::Consumers::LastSample<SampleType> last_sample;
+    last_sample.connect_to_producer (take_every_nth);
+
+    SampleFlow::Filters::ComponentSplitter<SampleType> component_splitter (1);
+    component_splitter.connect_to_producer (range_producer);
+    SampleFlow::Consumers::MaximumProbabilitySample<double> maximum;
+    maximum.connect_to_producer (component_splitter);
+    SampleFlow::Consumers::CountSamples<double> count_components;
+    count_components.connect_to_producer (component_splitter);
+
+    std::vector<SampleType> samples (10, SampleType(2));
+    for (unsigned int i=0; i<samples.size(); ++i)
+      samples[i] << i, 2.*i;
+    range_producer.sample (samples);
+
+    std::cout << "Covariance matrix:\n" << covariance_matrix.get() << std::endl;
+    std::cout << "Last sample: " << last_sample.get().transpose() << std::endl;
+    std::cout << "Number of second components: " << count_components.get() << std::endl;
+  }
+}
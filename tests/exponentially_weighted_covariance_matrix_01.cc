@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the ExponentiallyWeightedCovarianceMatrix consumer against a
+// direct implementation of its update formula. Samples with repetition
+// counts and integer weights must yield the same result as the same
+// sample sent as often as the product of the two indicates.
+
+
+#include <iostream>
+#include <span>
+#include <valarray>
+#include <vector>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/exponentially_weighted_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::vector<Eigen::VectorXd> &values,
+           const std::vector<SampleFlow::AuxiliaryData> &aux_data,
+           const double alpha)
+{
+  SampleFlow::Consumers::ExponentiallyWeightedCovarianceMatrix<SampleType> covariance (alpha);
+
+  const unsigned int dimension = values[0].size();
+  Eigen::VectorXd mean;
+  Eigen::MatrixXd C;
+  for (unsigned int n=0; n<values.size(); ++n)
+    {
+      SampleType sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = values[n][i];
+      covariance.consume (sample, aux_data[n]);
+
+      const unsigned int multiplicity
+        = aux_data[n].n_repetitions() * static_cast<unsigned int>(aux_data[n].weight());
+      for (unsigned int r=0; r<multiplicity; ++r)
+        if (mean.size() == 0)
+          {
+            mean = values[n];
+            C = Eigen::MatrixXd::Zero (dimension, dimension);
+          }
+        else
+          {
+            const Eigen::VectorXd delta = values[n] - mean;
+            mean += alpha * delta;
+            C = (1-alpha) * (C + alpha * delta * delta.transpose());
+          }
+    }
+
+  std::cout << "Half life: " << covariance.half_life() << std::endl;
+  std::cout << "Mean value matches: "
+            << ((covariance.get_mean() - mean).norm() < 1e-10 * mean.norm()) << std::endl;
+  std::cout << "Covariance matches: "
+            << ((covariance.get() - C).norm() < 1e-10 * C.norm()) << std::endl;
+  std::cout << "C(0,0)=" << covariance.get()(0,0)
+            << ", C(3,1)=" << covariance.get()(3,1) << std::endl;
+
+  std::vector<char> buffer;
+  covariance.save (buffer);
+  SampleFlow::Consumers::ExponentiallyWeightedCovarianceMatrix<SampleType> copy (alpha);
+  std::span<const char> data (buffer);
+  copy.load (data);
+  std::cout << "Restored state matches: "
+            << (copy.get() == covariance.get()) << std::endl;
+}
+
+
+
+int main ()
+{
+  const unsigned int dimension = 5;
+  const unsigned int n_samples = 2000;
+
+  std::mt19937 rng;
+  std::vector<Eigen::VectorXd> values (n_samples, Eigen::VectorXd(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i + 0.01*n,1)(rng)
+                       + (i == 3 ? 0.5*values[n][1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double((n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  for (const double alpha : {0.5, 0.01})
+    {
+      std::cout << "Smoothing factor " << alpha << ':' << std::endl;
+      test<std::valarray<double>> (values, aux_data, alpha);
+      test<Eigen::VectorXd> (values, aux_data, alpha);
+    }
+}
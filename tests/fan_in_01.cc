@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Producers::FanIn: Many producers, running on several threads at
+// once, feed into one FanIn object. The consumers downstream need to see
+// all samples, those of each producer in order, and the FanIn object
+// needs to notice when producers go away.
+
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/fan_in.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A consumer that records, for each producer (identified by the
+// thousands digit of the sample), the samples it receives.
+class Recorder : public SampleFlow::Consumer<double>
+{
+  public:
+    Recorder ()
+      :
+      SampleFlow::Consumer<double>(SampleFlow::ParallelMode::synchronous)
+    {}
+
+    ~Recorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (double sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      samples[static_cast<int>(sample) / 1000].push_back (sample);
+    }
+
+    std::mutex                         mutex;
+    std::map<int,std::vector<double>>  samples;
+};
+
+
+int main ()
+{
+  const unsigned int n_producers = 200;
+  const unsigned int n_samples   = 100;
+
+  SampleFlow::Producers::FanIn<double> fan_in (16);
+
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.connect_to_producer (fan_in);
+
+  SampleFlow::Consumers::MeanValue<double> mean_value;
+  mean_value.connect_to_producer (fan_in);
+
+  Recorder recorder;
+  recorder.connect_to_producer (fan_in);
+
+  {
+    std::list<SampleFlow::Producers::Range<double>> producers (n_producers);
+    for (auto &producer : producers)
+      fan_in.connect_to_producer (producer);
+    std::cout << "Connected producers: " << fan_in.n_producers() << std::endl;
+
+    // Let four threads each run a quarter of the producers. Every other
+    // producer sends its samples as one batch, the others one at a time.
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<4; ++t)
+      threads.emplace_back ([&, t]()
+      {
+        unsigned int p = 0;
+        for (auto &producer : producers)
+          {
+            if (p % 4 == t)
+              {
+                std::vector<double> samples;
+                for (unsigned int i=0; i<n_samples; ++i)
+                  samples.push_back (1000.*p + i);
+
+                if (p % 2 == 0)
+                  producer.sample (samples);
+                else
+                  for (const double sample : samples)
+                    producer.sample (std::vector<double> {sample});
+              }
+            ++p;
+          }
+      });
+    for (auto &thread : threads)
+      thread.join();
+  }
+
+  // The producers are gone now, and so are the FanIn object's ports:
+  std::cout << "Remaining producers: " << fan_in.n_producers() << std::endl;
+
+  std::cout << "Samples counted: " << count_samples.get() << std::endl;
+  std::cout << "Mean value: " << mean_value.get() << std::endl;
+
+  bool in_order = (recorder.samples.size() == n_producers);
+  for (const auto &p : recorder.samples)
+    {
+      if (p.second.size() != n_samples)
+        in_order = false;
+      for (unsigned int i=0; in_order && i<p.second.size(); ++i)
+        if (p.second[i] != 1000.*p.first + i)
+          in_order = false;
+    }
+  std::cout << "Samples of each producer in order: " << in_order << std::endl;
+
+  // The FanIn object also shows up in pipeline descriptions:
+  std::cout << "Nodes downstream: " << fan_in.describe_pipeline().nodes.size() << std::endl;
+}
@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that FFTAutoCovarianceTrace computes the same autocovariances as
+// AutoCovarianceTrace, for a chain with repeated samples, for block sizes
+// smaller and larger than the maximal lag, after saving and loading the
+// state, and when merging the results of two chains.
+
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/fft_auto_covariance_trace.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+double log_likelihood (const SampleType &x)
+{
+  double sum = 0;
+  for (unsigned int i=0; i<x.size(); ++i)
+    sum += (x[i]-10) * (x[i]-10);
+
+  return -sum;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  SampleFlow::Testing::NormalDistribution<double> distribution(0., 0.5);
+
+  SampleType y = x;
+  for (auto &el : y)
+    el += distribution(rng);
+
+  return {y,1};
+}
+
+
+double relative_difference (const std::vector<double> &a,
+                            const std::vector<double> &b)
+{
+  double difference = 0;
+  for (unsigned int l=0; l<a.size(); ++l)
+    difference = std::max (difference, std::abs(a[l]-b[l]));
+  return difference / std::abs(b[0]);
+}
+
+
+int main ()
+{
+  const unsigned int max_lag = 50;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.compress_repeated_samples = true;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler_1 (parameters);
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler_2 (parameters);
+
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> reference_1 (max_lag);
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> reference_2 (max_lag);
+  reference_1.connect_to_producer (mh_sampler_1);
+  reference_2.connect_to_producer (mh_sampler_2);
+
+  SampleFlow::Consumers::FFTAutoCovarianceTrace<SampleType> small_blocks (max_lag, 17);
+  SampleFlow::Consumers::FFTAutoCovarianceTrace<SampleType> large_blocks (max_lag);
+  SampleFlow::Consumers::FFTAutoCovarianceTrace<SampleType> fft_2 (max_lag, 100);
+  small_blocks.connect_to_producer (mh_sampler_1);
+  large_blocks.connect_to_producer (mh_sampler_1);
+  fft_2.connect_to_producer (mh_sampler_2);
+
+  mh_sampler_1.sample ({0,1,2}, &log_likelihood, &perturb, 10000);
+  mh_sampler_2.sample ({20,19,18}, &log_likelihood, &perturb, 3001);
+
+  const std::vector<double> reference = reference_1.get();
+  std::cout << "Autocovariances:";
+  for (unsigned int l=0; l<=max_lag; l+=10)
+    std::cout << ' ' << reference[l];
+  std::cout << std::endl;
+
+  std::cout << "Small blocks: "
+            << (relative_difference (small_blocks.get(), reference) < 1e-10)
+            << std::endl;
+  std::cout << "Large blocks: "
+            << (relative_difference (large_blocks.get(), reference) < 1e-10)
+            << std::endl;
+
+  // Save and load the state into an object with a different block size:
+  std::vector<char> buffer;
+  small_blocks.save (buffer);
+  SampleFlow::Consumers::FFTAutoCovarianceTrace<SampleType> loaded (max_lag, 5);
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  std::cout << "Loaded: "
+            << (data.empty() && (relative_difference (loaded.get(), reference) < 1e-10))
+            << std::endl;
+
+  // Then merge the second chain:
+  reference_1.merge (reference_2);
+  small_blocks.merge (fft_2);
+  std::cout << "Merged: "
+            << (relative_difference (small_blocks.get(), reference_1.get()) < 1e-10)
+            << std::endl;
+}
@@ -0,0 +1,85 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that FixedVector can be used as the sample type of a producer and
+// of the MeanValue and CovarianceMatrix consumers, and that it stores its
+// elements inline with the expected alignment.
+
+
+#include <iostream>
+#include <type_traits>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/fixed_vector.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = SampleFlow::FixedVector<double,2>;
+
+double log_likelihood (const SampleType &)
+{
+  return 1;
+}
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  // Move the sample to the right and lie about the ratio of proposal
+  // probabilities as in the covariance_matrix_01 test:
+  return {x + SampleType(1.), 1.0};
+}
+
+int main ()
+{
+  static_assert (SampleFlow::Concepts::is_vector_space_type<SampleType>);
+  static_assert (std::is_trivially_copyable_v<SampleType>);
+
+  std::cout << "size=" << SampleType::size()
+            << " sizeof=" << sizeof(SampleType)
+            << " alignof=" << alignof(SampleType) << std::endl;
+  std::cout << "sizeof(FixedVector<float,3>)=" << sizeof(SampleFlow::FixedVector<float,3>)
+            << " alignof=" << alignof(SampleFlow::FixedVector<float,3>) << std::endl;
+  std::cout << "alignof(FixedVector<double,16>)=" << alignof(SampleFlow::FixedVector<double,16>)
+            << std::endl;
+
+  // Check the arithmetic operators:
+  const SampleType a = {1., 2.};
+  const SampleType b = {3., 5.};
+  const SampleType c = (a + 2.*b - a*3.) / 2.;
+  std::cout << c[0] << ' ' << c[1] << std::endl;
+  std::cout << (a - a == SampleType()) << std::endl;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer(mh_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer(mh_sampler);
+
+  mh_sampler.sample ({0,1},
+                     &log_likelihood,
+                     &perturb,
+                     8);
+
+  // The two components run from 1 to 8 and 2 to 9, respectively:
+  const SampleType mean = mean_value.get();
+  std::cout << mean[0] << ' ' << mean[1] << std::endl;
+  std::cout << covariance_matrix.get() << std::endl;
+}
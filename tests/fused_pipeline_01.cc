@@ -0,0 +1,97 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that a fused pipeline built via SampleFlow::fuse() produces the
+// same results as the corresponding dynamically connected chain, both
+// with stages that are stored by reference and with stages that are
+// moved into the pipeline.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#  include <sampleflow/filters/pass_through.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/connections.h>
+#  include <sampleflow/fused_pipeline.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<1000; ++i)
+    samples.push_back (i);
+
+  // First the dynamically connected chain:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Filters::DiscardFirstN<SampleType> discard (100);
+    SampleFlow::Filters::TakeEveryNth<SampleType> every_third (3);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+
+    auto chain = range_producer >> discard >> every_third >> mean_value;
+    range_producer.sample (samples);
+
+    std::cout << "Chain: " << mean_value.get() << std::endl;
+  }
+
+  // Then the same with a fused pipeline whose stages are referenced:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Filters::DiscardFirstN<SampleType> discard (100);
+    SampleFlow::Filters::TakeEveryNth<SampleType> every_third (3);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+
+    auto pipeline = SampleFlow::fuse(range_producer) >> discard >> every_third >> mean_value;
+    range_producer.sample (samples);
+
+    std::cout << "Fused pipeline: " << mean_value.get() << std::endl;
+  }
+
+  // And with filters that are moved into the pipeline, and a consumer
+  // that is accessed through the pipeline object.
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+
+    auto pipeline = SampleFlow::fuse(range_producer)
+                    >> SampleFlow::Filters::Condition<SampleType> ([](const SampleType &s)
+    {
+      return (s >= 100);
+    })
+    >> SampleFlow::Filters::PassThrough<SampleType> ()
+    >> SampleFlow::Filters::Condition<SampleType> ([](const SampleType &s)
+    {
+      return (static_cast<int>(s) % 3 == 0);
+    })
+    >> count_samples;
+    range_producer.sample (samples);
+
+    std::cout << "Fused pipeline, number of samples: "
+              << pipeline.get_stage<3>().get() << std::endl;
+  }
+}
@@ -0,0 +1,136 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the Group consumer: Consumers that are members of a group
+// connected to a producer need to compute the same results as when they
+// are connected to the producer directly. Also check which members get to
+// see references to the samples, and which one is handed the sample itself.
+
+
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/group.h>
+#  include <sampleflow/consumers/maximum_probability_sample.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::Vector2d;
+
+
+// A consumer that counts how it was called.
+class CallCounter : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    ~CallCounter ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType /*sample*/,
+             SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      ++n_calls;
+    }
+
+    virtual
+    void
+    consume_by_reference (const SampleType &/*sample*/,
+                          const SampleFlow::AuxiliaryData &/*aux_data*/) override
+    {
+      ++n_calls_by_reference;
+    }
+
+    unsigned int n_calls = 0;
+    unsigned int n_calls_by_reference = 0;
+};
+
+
+int main ()
+{
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+
+  // Consumers connected directly:
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::MaximumProbabilitySample<SampleType> maximum_probability_sample;
+  maximum_probability_sample.connect_to_producer (mh_sampler);
+
+  // The same consumers as members of a group:
+  SampleFlow::Consumers::CountSamples<SampleType> group_count_samples;
+  SampleFlow::Consumers::MeanValue<SampleType> group_mean_value;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> group_covariance_matrix;
+  SampleFlow::Consumers::MaximumProbabilitySample<SampleType> group_maximum_probability_sample;
+  CallCounter first_call_counter;
+  CallCounter last_call_counter;
+
+  SampleFlow::Consumers::Group<SampleType> group;
+  group.add (first_call_counter);
+  group.add (group_count_samples);
+  group.add (group_mean_value);
+  group.add (group_covariance_matrix);
+  group.add (group_maximum_probability_sample);
+  group.add (last_call_counter);
+  group.connect_to_producer (mh_sampler);
+
+  std::mt19937 rng;
+  mh_sampler.sample ({1,1},
+                     [](const SampleType &x)
+  {
+    return -0.5 * (x[0]*x[0] + x[1]*x[1]/4);
+  },
+  [&](const SampleType &x)
+  {
+    SampleType y = x;
+    for (auto &el : y)
+      el += std::normal_distribution<double>(0, 1)(rng);
+    return std::make_pair (y, 1.0);
+  },
+  1000);
+
+  std::cout << "Number of members: " << group.n_members() << std::endl;
+
+  std::cout << "Count: " << group_count_samples.get()
+            << " (" << count_samples.get() << ")" << std::endl;
+  std::cout << "Mean: " << group_mean_value.get().transpose()
+            << " (" << mean_value.get().transpose() << ")" << std::endl;
+  std::cout << "Covariance: " << group_covariance_matrix.get().reshaped().transpose()
+            << " (" << covariance_matrix.get().reshaped().transpose() << ")" << std::endl;
+  std::cout << "Most likely sample: " << group_maximum_probability_sample.get().first.transpose()
+            << " (" << maximum_probability_sample.get().first.transpose() << ")" << std::endl;
+
+  std::cout << "First member: " << first_call_counter.n_calls << " calls with a sample, "
+            << first_call_counter.n_calls_by_reference << " calls with a reference" << std::endl;
+  std::cout << "Last member: " << last_call_counter.n_calls << " calls with a sample, "
+            << last_call_counter.n_calls_by_reference << " calls with a reference" << std::endl;
+}
@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the HamiltonianMonteCarlo producer: Sample a 20-dimensional
+// Gaussian with independent components of different means and standard
+// deviations, and check the mean value and the variances of the
+// components as well as the number of evaluations of the likelihood and
+// its gradient. Also check that trajectories that leave the region of
+// nonzero probability are rejected by sampling the same distribution
+// restricted to the positive first component.
+
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/hamiltonian_monte_carlo.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/action.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+#include <eigen3/Eigen/Dense>
+
+using SampleType = Eigen::VectorXd;
+
+const unsigned int dimension = 20;
+
+double mu (const unsigned int i)
+{
+  return 0.1 * i;
+}
+
+double sigma (const unsigned int i)
+{
+  return 1 + 0.05 * i;
+}
+
+
+unsigned int n_evaluations = 0;
+bool restrict_to_positive = false;
+
+double log_likelihood_and_gradient (const SampleType &x, SampleType &gradient)
+{
+  ++n_evaluations;
+  if (restrict_to_positive && (x(0) < 0))
+    return -std::numeric_limits<double>::infinity();
+
+  double log_likelihood = 0;
+  for (unsigned int i=0; i<dimension; ++i)
+    {
+      log_likelihood -= (x(i)-mu(i))*(x(i)-mu(i)) / (2*sigma(i)*sigma(i));
+      gradient(i) = -(x(i)-mu(i)) / (sigma(i)*sigma(i));
+    }
+  return log_likelihood;
+}
+
+
+void check ()
+{
+  SampleFlow::Producers::HamiltonianMonteCarlo<SampleType>::Parameters parameters;
+  parameters.random_seed = 1;
+  parameters.step_size = 0.5;
+  parameters.n_leapfrog_steps = 5;
+  SampleFlow::Producers::HamiltonianMonteCarlo<SampleType> hmc_sampler (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (hmc_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (hmc_sampler);
+
+  unsigned int n_accepted = 0;
+  bool all_samples_positive = true;
+  SampleFlow::Consumers::Action<SampleType> count_accepted
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    if (*aux_data.get_if<bool> (SampleFlow::AuxiliaryData::sample_is_repeated) == false)
+      ++n_accepted;
+    if (x(0) < 0)
+      all_samples_positive = false;
+  });
+  count_accepted.connect_to_producer (hmc_sampler);
+
+  SampleType starting_point (dimension);
+  for (unsigned int i=0; i<dimension; ++i)
+    starting_point(i) = mu(i) + 1;
+
+  const unsigned int n_samples = 50000;
+  n_evaluations = 0;
+  hmc_sampler.sample (starting_point, &log_likelihood_and_gradient, n_samples);
+
+  if (restrict_to_positive == false)
+    {
+      double max_mean_error = 0;
+      double max_variance_error = 0;
+      for (unsigned int i=0; i<dimension; ++i)
+        {
+          max_mean_error = std::max (max_mean_error,
+                                     std::fabs(mean_value.get()(i) - mu(i)) / sigma(i));
+          max_variance_error = std::max (max_variance_error,
+                                         std::fabs(covariance_matrix.get()(i,i) / sigma(i) / sigma(i) - 1));
+        }
+      std::cout << "Mean value correct: " << (max_mean_error < 0.05) << std::endl
+                << "Variances correct: " << (max_variance_error < 0.05) << std::endl
+                << "Number of evaluations per step: "
+                << (n_evaluations - 1.) / n_samples << std::endl
+                << "Acceptance ratio reasonable: "
+                << ((1. * n_accepted / n_samples > 0.5) && (1. * n_accepted / n_samples < 0.99))
+                << std::endl;
+    }
+  else
+    std::cout << "All samples have positive first component: "
+              << all_samples_positive << std::endl
+              << "Number of evaluations per step at most L: "
+              << ((n_evaluations - 1.) / n_samples <= parameters.n_leapfrog_steps) << std::endl;
+}
+
+
+int main ()
+{
+  check ();
+
+  restrict_to_positive = true;
+  check ();
+}
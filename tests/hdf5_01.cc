@@ -0,0 +1,153 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check HDF5::Consumers::ChainOutput and HDF5::Producers::ChainFile: Run a
+// Metropolis-Hastings sampler for a two-dimensional Gaussian and write its
+// samples, along with their log likelihoods and whether they are
+// repetitions of the previous sample, to an HDF5 file using a chunk size
+// that does not divide the number of samples. Then read the file back and
+// check that we get the same samples, the same mean value, and the same
+// auxiliary data.
+
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/hdf5/consumers/chain_output.h>
+#include <sampleflow/hdf5/producers/chain_file.h>
+
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x*x).sum();
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::normal_distribution<double> distribution(0, 1);
+
+  SampleType y = x;
+  for (auto &v : y)
+    v += distribution(rng);
+  return {y, 1.};
+}
+
+
+int main ()
+{
+  const std::string filename = "hdf5_01.h5";
+  const SampleFlow::ChainFileFormat::Column columns[2]
+    = {{SampleFlow::AuxiliaryData::relative_log_likelihood,
+        SampleFlow::ChainFileFormat::ColumnType::floating_point},
+    {SampleFlow::AuxiliaryData::sample_is_repeated,
+     SampleFlow::ChainFileFormat::ColumnType::boolean}
+  };
+
+  std::vector<SampleType> original_samples;
+  std::vector<double>     original_log_likelihoods;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::Action<SampleType> action
+    ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+    {
+      original_samples.push_back (sample);
+      original_log_likelihoods.push_back
+      (*aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood));
+    });
+    action.connect_to_producer (mh_sampler);
+
+    SampleFlow::HDF5::Consumers::ChainOutput<SampleType> chain_output
+    (filename, {columns[0], columns[1]}, 1000);
+    chain_output.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample ({0, 0}, &log_likelihood, &perturb, 10000);
+
+    std::cout << "Mean value during sampling: "
+              << mean_value.get()[0] << ' ' << mean_value.get()[1] << std::endl;
+  }
+
+  {
+    SampleFlow::HDF5::Producers::ChainFile<SampleType> chain_file (filename);
+    std::cout << "Samples: " << chain_file.n_samples()
+              << ", dimension: " << chain_file.dimension()
+              << ", columns: " << chain_file.columns().size() << std::endl;
+    for (const auto &column : chain_file.columns())
+      std::cout << "  " << column.key.name() << ' '
+                << static_cast<int>(column.type) << std::endl;
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (chain_file);
+
+    std::size_t n_correct = 0;
+    std::size_t n_repeated = 0;
+    std::size_t index = 0;
+    SampleFlow::Consumers::Action<SampleType> action
+    ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+    {
+      if (((sample != original_samples[index]).max() == false)
+          &&
+          (*aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+           == original_log_likelihoods[index]))
+        ++n_correct;
+      if (*aux_data.get_if<bool>(SampleFlow::AuxiliaryData::sample_is_repeated))
+        ++n_repeated;
+      ++index;
+    });
+    action.connect_to_producer (chain_file);
+
+    chain_file.sample ();
+
+    std::cout << "Mean value from file: "
+              << mean_value.get()[0] << ' ' << mean_value.get()[1] << std::endl;
+    std::cout << "Correct samples: " << n_correct << std::endl;
+    std::cout << "Some samples repeated: " << (n_repeated > 0) << std::endl;
+
+    // Read only every seventh sample, starting with the third:
+    std::vector<double> first_components;
+    SampleFlow::Consumers::Action<SampleType> strided_action
+    ([&](SampleType sample, SampleFlow::AuxiliaryData)
+    {
+      first_components.push_back (sample[0]);
+    });
+    action.disconnect_and_flush ();
+    mean_value.disconnect_and_flush ();
+    strided_action.connect_to_producer (chain_file);
+    chain_file.sample (2, 10000, 7);
+
+    bool strided_correct = (first_components.size() == (10000-2+6)/7);
+    for (std::size_t i=0; strided_correct && (i<first_components.size()); ++i)
+      strided_correct = (first_components[i] == original_samples[2+7*i][0]);
+    std::cout << "Strided read: " << first_components.size()
+              << ' ' << strided_correct << std::endl;
+  }
+
+  std::remove (filename.c_str());
+}
@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Encoding::xor_with_previous for HDF5::Consumers::ChainOutput:
+// Write the samples of a Metropolis-Hastings sampler twice, with and
+// without encoding, and check that the encoded file is smaller and that
+// reading it back (all samples, and every fifth sample) yields the
+// original samples and auxiliary data. Samples are produced in two runs
+// of the sampler, so that the chunk written at the end of the first run
+// is incomplete and the encoding has to continue across it.
+
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/hdf5/consumers/chain_output.h>
+#include <sampleflow/hdf5/producers/chain_file.h>
+
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * (x*x).sum();
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::normal_distribution<double> distribution(0, 0.5);
+
+  SampleType y = x;
+  for (auto &v : y)
+    v += distribution(rng);
+  return {y, 1.};
+}
+
+
+int main ()
+{
+  const std::vector<SampleFlow::ChainFileFormat::Column> columns
+    = {{SampleFlow::AuxiliaryData::relative_log_likelihood,
+        SampleFlow::ChainFileFormat::ColumnType::floating_point}
+  };
+
+  std::vector<SampleType> original_samples;
+  std::vector<double>     original_log_likelihoods;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::Action<SampleType> action
+    ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+    {
+      original_samples.push_back (sample);
+      original_log_likelihoods.push_back
+      (*aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood));
+    });
+    action.connect_to_producer (mh_sampler);
+
+    SampleFlow::HDF5::Consumers::ChainOutput<SampleType> plain_output
+    ("hdf5_02_plain.h5", columns, 1000);
+    plain_output.connect_to_producer (mh_sampler);
+
+    SampleFlow::HDF5::Consumers::ChainOutput<SampleType> encoded_output
+    ("hdf5_02_encoded.h5", columns, 1000, 4,
+     SampleFlow::HDF5::Encoding::xor_with_previous);
+    encoded_output.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample ({0, 0, 0}, &log_likelihood, &perturb, 2500);
+    mh_sampler.sample (original_samples.back(), &log_likelihood, &perturb, 7500);
+  }
+
+  std::cout << "Encoded file is smaller: "
+            << (std::filesystem::file_size("hdf5_02_encoded.h5")
+                <
+                std::filesystem::file_size("hdf5_02_plain.h5"))
+            << std::endl;
+
+  {
+    SampleFlow::HDF5::Producers::ChainFile<SampleType> chain_file ("hdf5_02_encoded.h5");
+    std::cout << "Samples: " << chain_file.n_samples()
+              << ", dimension: " << chain_file.dimension() << std::endl;
+
+    for (const std::size_t stride : {1, 5})
+      {
+        std::size_t n_received = 0;
+        std::size_t n_correct = 0;
+        SampleFlow::Consumers::Action<SampleType> action
+        ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+        {
+          const std::size_t index = 1 + n_received*stride;
+          if (((sample != original_samples[index]).max() == false)
+              &&
+              (*aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+               == original_log_likelihoods[index]))
+            ++n_correct;
+          ++n_received;
+        });
+        action.connect_to_producer (chain_file);
+
+        chain_file.sample (1, chain_file.n_samples(), stride);
+        std::cout << "Stride " << stride << ": " << n_received
+                  << " samples, " << n_correct << " correct" << std::endl;
+      }
+  }
+
+  std::remove ("hdf5_02_plain.h5");
+  std::remove ("hdf5_02_encoded.h5");
+}
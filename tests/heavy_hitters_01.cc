@@ -0,0 +1,136 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Test the HeavyHitters consumer: Send it a stream of samples from a
+// distribution over many more states than the consumer has counters, in
+// which a few states carry most of the probability, from several
+// threads at once. Check that it identifies the most frequent states,
+// that the true counts lie between the guaranteed and the estimated
+// counts, and that the results survive saving, loading, and merging.
+
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/heavy_hitters.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::vector<int>;
+
+
+int main ()
+{
+  // Create the samples: One in two is one of five frequent states, with
+  // probabilities proportional to 5,4,3,2,1; all others are drawn
+  // uniformly from a million states.
+  std::mt19937 rng;
+  std::vector<SampleType> samples;
+  std::map<SampleType,SampleFlow::types::sample_index> exact_counts;
+  for (unsigned int i=0; i<100000; ++i)
+    {
+      SampleType sample;
+      if (std::bernoulli_distribution(0.5)(rng))
+        {
+          const int state = std::discrete_distribution<int>({5, 4, 3, 2, 1})(rng);
+          sample = {state, state, state};
+        }
+      else
+        sample = {std::uniform_int_distribution<int>(0,99)(rng),
+                  std::uniform_int_distribution<int>(0,99)(rng),
+                  std::uniform_int_distribution<int>(100,199)(rng)
+                 };
+      ++exact_counts[sample];
+      samples.push_back (sample);
+    }
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::HeavyHitters<SampleType> heavy_hitters (20, 16384, 4);
+  heavy_hitters.connect_to_producer (range_producer);
+
+  range_producer.sample_in_parallel (samples);
+
+  std::cout << "Number of samples: " << heavy_hitters.n_samples() << std::endl;
+
+  // Output the five most frequent states, which are guaranteed to be
+  // found since each of them makes up more than 1/20 of the samples:
+  const auto result = heavy_hitters.get();
+  bool within_bounds = true;
+  for (const auto &heavy_hitter : result)
+    {
+      const auto exact_count = exact_counts[heavy_hitter.sample];
+      within_bounds = within_bounds
+                      && (heavy_hitter.guaranteed_count <= exact_count)
+                      && (exact_count <= heavy_hitter.estimated_count)
+                      && (exact_count <= heavy_hitters.estimated_count (heavy_hitter.sample));
+    }
+  for (unsigned int i=0; i<5; ++i)
+    {
+      const auto exact_count = exact_counts[result[i].sample];
+      std::cout << "State " << result[i].sample[0] << ": " << exact_count
+                << " samples, estimate within 1%: "
+                << (result[i].estimated_count - exact_count < exact_count / 100)
+                << std::endl;
+    }
+  std::cout << "True counts within bounds: " << within_bounds << std::endl;
+
+  // Save and load the state of the consumer:
+  std::vector<char> buffer;
+  heavy_hitters.save (buffer);
+  SampleFlow::Consumers::HeavyHitters<SampleType> loaded (20, 16384, 4);
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  const auto loaded_result = loaded.get();
+  bool same = (loaded.n_samples() == heavy_hitters.n_samples())
+              && (loaded_result.size() == result.size());
+  for (std::size_t i=0; same && (i<result.size()); ++i)
+    same = (loaded_result[i].sample == result[i].sample)
+           && (loaded_result[i].estimated_count == result[i].estimated_count)
+           && (loaded_result[i].guaranteed_count == result[i].guaranteed_count);
+  std::cout << "Saved and loaded: " << same << std::endl;
+
+  // Merging the loaded object with the original one has to double all
+  // counts of the most frequent states:
+  loaded.merge (heavy_hitters);
+  const auto merged_result = loaded.get();
+  std::cout << "Number of samples after merging: " << loaded.n_samples() << std::endl;
+  for (unsigned int i=0; i<5; ++i)
+    std::cout << "State " << merged_result[i].sample[0] << ": "
+              << (merged_result[i].estimated_count == 2*result[i].estimated_count)
+              << (merged_result[i].guaranteed_count == 2*result[i].guaranteed_count)
+              << std::endl;
+
+  // Repetition counts:
+  SampleFlow::Consumers::HeavyHitters<SampleType> repeated (2);
+  repeated.consume ({1}, {{SampleFlow::AuxiliaryData::repetition_count, std::any(std::size_t(3))}});
+  repeated.consume ({2}, {});
+  repeated.consume ({3}, {});
+  std::cout << "Repeated samples:" << std::endl;
+  for (const auto &heavy_hitter : repeated.get())
+    std::cout << "  State " << heavy_hitter.sample[0] << ": estimated "
+              << heavy_hitter.estimated_count << ", guaranteed "
+              << heavy_hitter.guaranteed_count << std::endl;
+  std::cout << "Number of samples: " << repeated.n_samples() << std::endl;
+}
@@ -0,0 +1,172 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the HierarchicalPairHistogram consumer: Count samples of a
+// narrow peak on top of a uniform background. The tree needs to be
+// refined much further near the peak than elsewhere, while staying
+// within the given budget of nodes, and the numbers of samples reported
+// for the bins of the whole histogram, of a coarse view of it, and of a
+// window that zooms in on the peak need to match the numbers of samples
+// one counts directly. Then check save(), load(), and merge().
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/hierarchical_pair_histogram.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+using Histogram  = SampleFlow::Consumers::HierarchicalPairHistogram<SampleType>;
+
+
+// Return the largest difference between the number of samples reported
+// for a bin and the number of samples counted in it directly, relative
+// to the square root of the latter (i.e., to the expected statistical
+// fluctuation), along with the sum of the numbers reported.
+std::pair<double,double>
+check_bins (const Histogram::value_type   &bins,
+            const std::vector<SampleType> &samples)
+{
+  double max_error = 0;
+  double n_samples = 0;
+  for (const auto &bin : bins)
+    {
+      n_samples += std::get<2>(bin);
+
+      double n = 0;
+      for (const auto &sample : samples)
+        if ((sample[0] >= std::get<0>(bin)[0]) && (sample[0] < std::get<1>(bin)[0])
+            &&
+            (sample[1] >= std::get<0>(bin)[1]) && (sample[1] < std::get<1>(bin)[1]))
+          ++n;
+      max_error = std::max (max_error,
+                            std::fabs(std::get<2>(bin) - n) / std::sqrt(std::max(n, 1.)));
+    }
+  return {max_error, n_samples};
+}
+
+
+
+int main ()
+{
+  std::mt19937 rng;
+  std::normal_distribution<double>       peak (0.3, 0.01);
+  std::uniform_real_distribution<double> background (0, 1);
+
+  // 50,000 samples, half of them in the peak and half of them uniformly
+  // distributed over [0,1]^2. Add a few that lie outside the range:
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<25000; ++i)
+    {
+      samples.push_back ({ peak(rng), peak(rng) });
+      samples.push_back ({ background(rng), background(rng) });
+    }
+  std::vector<SampleType> all_samples = samples;
+  all_samples.push_back ({ 1.5, 0.5 });
+  all_samples.push_back ({ 0.5, -0.1 });
+  all_samples.push_back ({ NAN, 0.5 });
+
+  const std::size_t max_n_nodes = 2000;
+  Histogram histogram (0, 1, 0, 1, max_n_nodes, 100, 12);
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    histogram.connect_to_producer (range_producer);
+    range_producer.sample (all_samples);
+  }
+
+  const Histogram::value_type bins = histogram.get();
+  std::cout << "Number of nodes within budget: " << (histogram.n_nodes() <= max_n_nodes) << std::endl;
+
+  // The smallest bins need to be near the peak, and the bins far away
+  // from it need to be much larger:
+  double smallest_width = 1;
+  std::array<double,2> smallest_bin_center = {{0, 0}};
+  double largest_width_near_corner = 0;
+  for (const auto &bin : bins)
+    {
+      const double width = std::get<1>(bin)[0] - std::get<0>(bin)[0];
+      if (width < smallest_width)
+        {
+          smallest_width = width;
+          smallest_bin_center = {{(std::get<0>(bin)[0] + std::get<1>(bin)[0]) / 2,
+                                  (std::get<0>(bin)[1] + std::get<1>(bin)[1]) / 2
+                                 }
+                                };
+        }
+      if (std::get<0>(bin)[0] >= 0.75 && std::get<0>(bin)[1] >= 0.75)
+        largest_width_near_corner = std::max (largest_width_near_corner, width);
+    }
+  std::cout << "Smallest bins near the peak: "
+            << ((smallest_width <= 1./256)
+                &&
+                (std::fabs(smallest_bin_center[0] - 0.3) < 0.05)
+                &&
+                (std::fabs(smallest_bin_center[1] - 0.3) < 0.05))
+            << std::endl;
+  std::cout << "Large bins far from the peak: " << (largest_width_near_corner >= 1./16) << std::endl;
+
+  // The numbers of samples in all bins, in a coarse view, and in a
+  // window around the peak need to match direct counts up to a few
+  // times the statistical fluctuation:
+  {
+    const auto [error, n_samples] = check_bins (bins, samples);
+    std::cout << "All bins: " << n_samples << " samples, counts accurate: " << (error < 4) << std::endl;
+  }
+  {
+    const Histogram::value_type coarse_bins = histogram.get (2);
+    const auto [error, n_samples] = check_bins (coarse_bins, samples);
+    std::cout << "Depth 2: " << coarse_bins.size() << " bins, "
+              << n_samples << " samples, counts accurate: " << (error < 4) << std::endl;
+  }
+  {
+    const Histogram::value_type window_bins = histogram.get ({{0.28, 0.28}}, {{0.32, 0.32}});
+    bool all_intersect = true;
+    for (const auto &bin : window_bins)
+      if ((std::get<1>(bin)[0] <= 0.28) || (std::get<0>(bin)[0] >= 0.32)
+          ||
+          (std::get<1>(bin)[1] <= 0.28) || (std::get<0>(bin)[1] >= 0.32))
+        all_intersect = false;
+    const auto [error, n_samples] = check_bins (window_bins, samples);
+    std::cout << "Window around the peak: bins intersect window: " << all_intersect
+              << ", counts accurate: " << (error < 4) << std::endl;
+  }
+
+  // Save the state, load it into a new object, and compare:
+  std::vector<char> buffer;
+  histogram.save (buffer);
+  Histogram copy (0, 1, 0, 1, max_n_nodes, 100, 12);
+  std::span<const char> input (buffer);
+  copy.load (input);
+  std::cout << "Loaded: " << (copy.get() == bins) << ' ' << input.size() << std::endl;
+
+  // Merging the histogram into the copy doubles all counts:
+  copy.merge (histogram);
+  const auto merged = copy.get();
+  bool doubled = (merged.size() == bins.size());
+  for (unsigned int i=0; doubled && i<bins.size(); ++i)
+    doubled = (std::get<2>(merged[i]) == 2*std::get<2>(bins[i]));
+  std::cout << "Merged: " << doubled << std::endl;
+}
@@ -0,0 +1,73 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that the Histogram consumer computes the same bins for equally
+// spaced bins (for which it computes bins arithmetically) as for the
+// same bins set up via a transformation (for which it uses a binary
+// search), both for samples sent one at a time and for batches of
+// samples. The samples include values outside the range of the histogram
+// and values that lie exactly on break points between bins.
+
+
+#include <iostream>
+#include <vector>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/histogram.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = double;
+
+  SampleFlow::Consumers::Histogram<SampleType> equally_spaced (-1.3, 2.1, 17);
+  SampleFlow::Consumers::Histogram<SampleType> batched (-1.3, 2.1, 17);
+  SampleFlow::Consumers::Histogram<SampleType> transformed (-1.3, 2.1, 17,
+                                                           [](const double x)
+  {
+    return x;
+  });
+
+  std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution (-2., 3.);
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<10000; ++i)
+    samples.push_back (distribution(rng));
+  for (const auto &bin : equally_spaced.get())
+    {
+      samples.push_back (std::get<0>(bin));
+      samples.push_back (std::get<1>(bin));
+    }
+
+  std::vector<SampleFlow::AuxiliaryData> aux_data (samples.size());
+  for (std::size_t i=0; i<samples.size(); ++i)
+    {
+      aux_data[i][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + i%3);
+      equally_spaced.consume (samples[i], aux_data[i]);
+      transformed.consume (samples[i], aux_data[i]);
+    }
+  batched.consume_batch (samples, aux_data);
+
+  SampleFlow::types::sample_index n_counted = 0;
+  for (const auto &bin : equally_spaced.get())
+    n_counted += std::get<2>(bin);
+  std::cout << "Samples counted: " << n_counted << std::endl;
+  std::cout << "Single samples: " << (equally_spaced.get() == transformed.get()) << std::endl;
+  std::cout << "Batches: " << (batched.get() == transformed.get()) << std::endl;
+}
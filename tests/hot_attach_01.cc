@@ -0,0 +1,188 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that consumers can be attached to and detached from a producer
+// that is sending samples on another thread: A consumer attached while
+// samples are being sent has to see a contiguous sequence of samples up to
+// the last one; a consumer detached while samples are being sent has to
+// have seen a contiguous sequence starting at the first one; and a
+// consumer whose parallel mode is changed while it is connected has to
+// continue receiving samples. At the same time, other consumers are
+// repeatedly attached and detached, which must not confuse the producer
+// about how many consumers receive each sample.
+
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::vector<int>;
+
+
+// A producer that sends the numbers 0...n-1 (wrapped in a vector, so that
+// copying and moving samples make a difference), and that lets others
+// know how far it has come. So that the test does not depend on how
+// quickly threads run, the producer waits before sending sample number
+// `hold_at` until someone changes that variable.
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const int n)
+    {
+      for (int i=0; i<n; ++i)
+        {
+          while (i == hold_at.load())
+            std::this_thread::yield();
+          this->issue_sample (SampleType(1,i), {});
+          n_issued = i+1;
+        }
+      this->flush_consumers();
+    }
+
+    std::atomic<int> n_issued {0};
+    std::atomic<int> hold_at {-1};
+};
+
+
+// A consumer that records the samples it receives.
+class Recorder : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    Recorder ()
+      :
+      SampleFlow::Consumer<SampleType>(SampleFlow::ParallelMode(static_cast<int>(SampleFlow::ParallelMode::synchronous)
+                                                                |
+                                                                static_cast<int>(SampleFlow::ParallelMode::asynchronous)))
+    {}
+
+    ~Recorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      samples.push_back (sample[0]);
+    }
+
+    std::size_t
+    n_samples () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return samples.size();
+    }
+
+    // Return whether the recorded samples are a contiguous sequence.
+    bool
+    is_contiguous () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (std::size_t i=1; i<samples.size(); ++i)
+        if (samples[i] != samples[i-1]+1)
+          return false;
+      return (samples.size() > 0);
+    }
+
+    mutable std::mutex mutex;
+    std::vector<int>   samples;
+};
+
+
+void wait_for (const Issuer &issuer, const int n)
+{
+  while (issuer.n_issued.load() < n)
+    std::this_thread::yield();
+}
+
+
+int main ()
+{
+  const int n_samples = 100000;
+
+  Issuer issuer;
+  issuer.hold_at = n_samples/4;
+
+  Recorder detached_recorder;
+  detached_recorder.connect_to_producer (issuer);
+
+  Recorder reconfigured_recorder;
+  reconfigured_recorder.connect_to_producer (issuer);
+
+  Recorder attached_recorder;
+
+  std::thread sampler ([&]()
+  {
+    issuer.sample (n_samples);
+  });
+
+  // Attach and detach other consumers while samples are being sent:
+  for (unsigned int i=0; i<20; ++i)
+    {
+      SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+      count_samples.connect_to_producer (issuer);
+      std::this_thread::yield();
+    }
+
+  wait_for (issuer, n_samples/4);
+  detached_recorder.disconnect_and_flush();
+  issuer.hold_at = n_samples/2;
+
+  wait_for (issuer, n_samples/2);
+  attached_recorder.connect_to_producer (issuer);
+  issuer.hold_at = 3*n_samples/4;
+
+  wait_for (issuer, 3*n_samples/4);
+  reconfigured_recorder.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 16);
+  const std::size_t n_before_reconfiguration = reconfigured_recorder.n_samples();
+  issuer.hold_at = -1;
+
+  sampler.join();
+
+  std::cout << "Detached consumer saw a contiguous sequence from the start: "
+            << (detached_recorder.is_contiguous()
+                && (detached_recorder.samples.front() == 0)
+                && (detached_recorder.samples.back() == n_samples/4-1))
+            << std::endl;
+  std::cout << "Attached consumer saw a contiguous sequence to the end: "
+            << (attached_recorder.is_contiguous()
+                && (attached_recorder.samples.front() == n_samples/2)
+                && (attached_recorder.samples.back() == n_samples-1))
+            << std::endl;
+  std::cout << "Reconfigured consumer is asynchronous: "
+            << (reconfigured_recorder.get_parallel_mode() == SampleFlow::ParallelMode::asynchronous)
+            << std::endl;
+  std::cout << "Reconfigured consumer saw all samples: "
+            << (reconfigured_recorder.is_contiguous()
+                && (n_before_reconfiguration == 3*n_samples/4)
+                && (reconfigured_recorder.n_samples() == n_samples))
+            << std::endl;
+}
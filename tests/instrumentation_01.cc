@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the performance counters kept if SAMPLEFLOW_WITH_INSTRUMENTATION
+// is defined: Consumers in synchronous and asynchronous mode need to
+// count the samples and batches they process and the calls to flush(),
+// asynchronous consumers need to report their queue depth, and producers
+// need to count the samples they send downstream.
+//
+// The macro only takes effect if the header files are included, and
+// so this test does not use the SampleFlow module.
+
+
+#define SAMPLEFLOW_WITH_INSTRUMENTATION
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/producers/range.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/mean_value.h>
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+std::pair<double,double> perturb (const double &x)
+{
+  static std::mt19937 rng;
+  return {x + std::normal_distribution<double>(0, 1)(rng), 1.0};
+}
+
+
+void print (const std::string &name,
+            const SampleFlow::Instrumentation::ConsumerStatistics &s,
+            const unsigned int queue_size)
+{
+  std::cout << name << ": "
+            << s.n_samples << " samples, "
+            << s.n_batches << " batches, "
+            << s.consume_time_histogram.count() << " timings, "
+            << s.n_flushes << " flushes" << std::endl;
+  std::cout << "  consume time consistent with histogram: "
+            << ((s.consume_time.count() >= 0)
+                &&
+                (s.consume_time_histogram.quantile(0.5) <= s.consume_time_histogram.quantile(0.99)))
+            << std::endl;
+  std::cout << "  lock wait time consistent with contention: "
+            << ((s.n_contended_locks == 0) == (s.lock_wait_time.count() == 0))
+            << std::endl;
+  std::cout << "  queue depth now: " << s.queue_depth
+            << ", maximal queue depth within queue size: "
+            << ((queue_size == 0) ?
+                (s.max_queue_depth == 0) :
+                ((s.max_queue_depth >= 1) && (s.max_queue_depth <= queue_size)))
+            << std::endl;
+}
+
+
+int main ()
+{
+  std::cout << "Instrumentation enabled: " << SampleFlow::Instrumentation::enabled << std::endl;
+
+  // Samples sent one at a time:
+  {
+    SampleFlow::Producers::MetropolisHastings<double> mh_sampler;
+
+    SampleFlow::Consumers::MeanValue<double> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::CountSamples<double> count_samples;
+    count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 4);
+    count_samples.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample (0., &log_likelihood, &perturb, 1000);
+
+    const SampleFlow::Instrumentation::ProducerStatistics p
+      = mh_sampler.get_producer_statistics();
+    std::cout << "MetropolisHastings: " << p.n_samples << " samples, "
+              << p.issue_time_histogram.count() << " timings" << std::endl;
+
+    print ("MeanValue", mean_value.get_consumer_statistics(), 0);
+    print ("CountSamples (asynchronous)", count_samples.get_consumer_statistics(), 4);
+  }
+
+  // Samples sent in batches:
+  {
+    SampleFlow::Producers::Range<double> range_producer;
+
+    SampleFlow::Consumers::CountSamples<double> count_samples;
+    count_samples.connect_to_producer (range_producer);
+
+    range_producer.sample (std::vector<double> (10, 1.));
+
+    std::cout << "Range: " << range_producer.get_producer_statistics().n_samples
+              << " samples sent individually" << std::endl;
+    print ("CountSamples (batches)", count_samples.get_consumer_statistics(), 0);
+  }
+
+  // Consumers that are disconnected count the flush that happens then:
+  SampleFlow::Producers::Range<double> range_producer;
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.connect_to_producer (range_producer);
+  count_samples.disconnect_and_flush ();
+  std::cout << "Flushes after disconnecting: "
+            << count_samples.get_consumer_statistics().n_flushes << std::endl;
+}
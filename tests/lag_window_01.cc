@@ -0,0 +1,118 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that AutoCovarianceTrace, AutoCovarianceMatrix, and
+// AverageCosineBetweenSuccessiveSamples compute the same results when
+// they share a LagWindow as when each stores its own previous samples,
+// and that the shared window copies every sample only once. Some of the
+// samples carry repetition counts and weights, including ones with zero
+// weight, which the autocovariance classes skip but which still need to
+// be inserted into the window.
+
+
+#include <iostream>
+#include <memory>
+#include <valarray>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/lag_window.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <sampleflow/consumers/average_cosinus.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+// A producer that sends its argument downstream along with a repetition
+// count and a weight.
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const SampleType &sample, const std::size_t n_repetitions, const double weight)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      if (n_repetitions != 1)
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      if (weight != 1)
+        aux_data[SampleFlow::AuxiliaryData::sample_weight] = weight;
+      this->issue_sample (sample, aux_data);
+    }
+};
+
+
+int main ()
+{
+  const unsigned int max_lag = 5;
+
+  Issuer issuer;
+
+  // Consumers that each store their own previous samples:
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> trace (max_lag);
+  trace.connect_to_producer (issuer);
+  SampleFlow::Consumers::AutoCovarianceMatrix<SampleType> matrix (max_lag);
+  matrix.connect_to_producer (issuer);
+  SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<SampleType> cosine (max_lag);
+  cosine.connect_to_producer (issuer);
+
+  // And the same with a shared window:
+  auto window = std::make_shared<SampleFlow::LagWindow<double>>();
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> shared_trace (max_lag, window);
+  shared_trace.connect_to_producer (issuer);
+  SampleFlow::Consumers::AutoCovarianceMatrix<SampleType>
+  shared_matrix ({{}, {0, 1, 2, 3, 4, 5}, SampleFlow::Consumers::AutoCovarianceMatrix<SampleType>::Output::full},
+                 window);
+  shared_matrix.connect_to_producer (issuer);
+  SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<SampleType> shared_cosine (max_lag, window);
+  shared_cosine.connect_to_producer (issuer);
+
+  const unsigned int n_samples = 200;
+  for (unsigned int i=0; i<n_samples; ++i)
+    issuer.sample ({std::sin(1.*i), std::cos(2.*i), 1.+0.1*i*std::sin(0.3*i)},
+                   1 + (i%7==0 ? 3 : 0),
+                   (i%11==0 ? 0. : (i%5==0 ? 2. : 1.)));
+
+  // Compare the results:
+  double trace_difference = 0;
+  for (unsigned int l=0; l<=max_lag; ++l)
+    trace_difference = std::max (trace_difference,
+                                 std::abs (trace.get()[l] - shared_trace.get()[l]));
+  double matrix_difference = 0;
+  for (unsigned int l=0; l<=max_lag; ++l)
+    matrix_difference = std::max (matrix_difference,
+                                  (matrix.get()[l] - shared_matrix.get()[l]).norm());
+  double cosine_difference = 0;
+  for (unsigned int l=0; l<max_lag; ++l)
+    cosine_difference = std::max (cosine_difference,
+                                  std::abs (cosine.get()[l] - shared_cosine.get()[l]));
+
+  std::cout << "Trace difference:  " << trace_difference << std::endl;
+  std::cout << "Matrix difference: " << matrix_difference << std::endl;
+  std::cout << "Cosine difference: " << cosine_difference << std::endl;
+
+  std::cout << "Trace at lag 0 and 1: " << shared_trace.get()[0] << ' ' << shared_trace.get()[1] << std::endl;
+  std::cout << "Cosine at lag 1: " << shared_cosine.get()[0] << std::endl;
+
+  // Two of the three readers of the shared window should have found every
+  // sample already inserted:
+  std::cout << "Shared insertions: " << window->n_shared_insertions()
+            << " of " << 3*n_samples << std::endl;
+}
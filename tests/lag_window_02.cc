@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that AutoCovarianceTrace and AverageCosineBetweenSuccessiveSamples
+// can work on handles to samples (as created by Filters::MakeShared), that
+// they compute the same results as when they receive the samples
+// themselves, and that their (shared) LagWindow keeps the handles rather
+// than copies of the samples: Only the most recent max_lag+1 samples may
+// still be alive while the consumers exist, and none once they are gone.
+// Also check that ReservoirSample keeps the handles it receives.
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/lag_window.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/average_cosinus.h>
+#  include <sampleflow/consumers/reservoir_sample.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+using HandleType = std::shared_ptr<const SampleType>;
+
+
+// A producer that sends its argument downstream.
+template <typename OutputType>
+class Issuer : public SampleFlow::Producer<OutputType>
+{
+  public:
+    void
+    sample (const OutputType &sample)
+    {
+      this->issue_sample (sample, SampleFlow::AuxiliaryData());
+    }
+};
+
+
+
+int main ()
+{
+  const unsigned int max_lag   = 5;
+  const unsigned int n_samples = 200;
+
+  Issuer<SampleType> issuer;
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> trace (max_lag);
+  trace.connect_to_producer (issuer);
+  SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<SampleType> cosine (max_lag);
+  cosine.connect_to_producer (issuer);
+
+  std::vector<std::weak_ptr<const SampleType>> issued_samples;
+  {
+    Issuer<HandleType> handle_issuer;
+    auto window = std::make_shared<SampleFlow::LagWindow<double>>();
+    SampleFlow::Consumers::AutoCovarianceTrace<HandleType> handle_trace (max_lag, window);
+    handle_trace.connect_to_producer (handle_issuer);
+    SampleFlow::Consumers::AverageCosineBetweenSuccessiveSamples<HandleType> handle_cosine (max_lag, window);
+    handle_cosine.connect_to_producer (handle_issuer);
+
+    for (unsigned int i=0; i<n_samples; ++i)
+      {
+        const SampleType sample = {std::sin(1.*i), std::cos(2.*i), 1.+0.1*i*std::sin(0.3*i)};
+        issuer.sample (sample);
+
+        const HandleType handle = std::make_shared<const SampleType>(sample);
+        issued_samples.push_back (handle);
+        handle_issuer.sample (handle);
+      }
+
+    double trace_difference = 0;
+    for (unsigned int l=0; l<=max_lag; ++l)
+      trace_difference = std::max (trace_difference,
+                                   std::abs (trace.get()[l] - handle_trace.get()[l]));
+    double cosine_difference = 0;
+    for (unsigned int l=0; l<max_lag; ++l)
+      cosine_difference = std::max (cosine_difference,
+                                    std::abs (cosine.get()[l] - handle_cosine.get()[l]));
+    std::cout << "Trace difference:  " << trace_difference << std::endl;
+    std::cout << "Cosine difference: " << cosine_difference << std::endl;
+
+    std::cout << "Samples alive while consumers exist: "
+              << std::count_if (issued_samples.begin(), issued_samples.end(),
+                                [](const auto &s)
+    {
+      return !s.expired();
+    })
+        << std::endl;
+  }
+  std::cout << "Samples alive afterwards: "
+            << std::count_if (issued_samples.begin(), issued_samples.end(),
+                              [](const auto &s)
+  {
+    return !s.expired();
+  })
+      << std::endl;
+
+  // A reservoir of handles keeps the objects it was sent:
+  {
+    std::vector<HandleType> samples;
+    SampleFlow::Consumers::ReservoirSample<HandleType> reservoir (10);
+    for (unsigned int i=0; i<100; ++i)
+      {
+        samples.push_back (std::make_shared<const SampleType>(SampleType(1.*i, 3)));
+        reservoir.consume (samples.back(), SampleFlow::AuxiliaryData());
+      }
+
+    unsigned int n_kept_handles = 0;
+    for (const HandleType &kept : reservoir.get())
+      if (std::find (samples.begin(), samples.end(), kept) != samples.end())
+        ++n_kept_handles;
+    std::cout << "Reservoir handles kept: " << n_kept_handles
+              << " of " << reservoir.get().size() << std::endl;
+  }
+}
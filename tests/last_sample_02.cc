@@ -0,0 +1,73 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that the LastSample consumer can be read from while samples are
+// being processed on another thread, and that the samples obtained via
+// get_shared() remain valid and unchanged after newer samples arrive.
+
+
+#include <iostream>
+#include <thread>
+#include <valarray>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/last_sample.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  SampleFlow::Consumers::LastSample<SampleType> last;
+  std::cout << "Before the first sample: "
+            << (last.get_shared() ? "sample" : "no sample") << ", size of get(): "
+            << last.get().size() << std::endl;
+
+  const unsigned int n_samples = 100000;
+  std::thread writer ([&]()
+  {
+    for (unsigned int i=1; i<=n_samples; ++i)
+      last.consume (SampleType(static_cast<double>(i), 100), {});
+  });
+
+  // Read the last sample repeatedly while the writer is running. Every
+  // sample must be internally consistent, and the samples must come in
+  // order.
+  bool consistent = true;
+  double previous = 0;
+  std::shared_ptr<const SampleType> first_seen;
+  while (previous < n_samples)
+    {
+      const std::shared_ptr<const SampleType> sample = last.get_shared();
+      if (!sample)
+        continue;
+
+      if (!first_seen)
+        first_seen = sample;
+
+      if (((*sample) != (*sample)[0]).max() || ((*sample)[0] < previous))
+        consistent = false;
+      previous = (*sample)[0];
+    }
+  writer.join();
+
+  std::cout << "Samples read were consistent: " << (consistent ? "yes" : "no") << std::endl;
+  std::cout << "First sample read is still valid: "
+            << (((*first_seen) == (*first_seen)[0]).min() ? "yes" : "no") << std::endl;
+  std::cout << "Last sample: " << last.get()[0] << ' ' << last.get().size() << std::endl;
+}
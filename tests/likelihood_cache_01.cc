@@ -0,0 +1,145 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the LikelihoodCache class: Sample the throws of a weighted dice
+// with the Metropolis-Hastings sampler, once with the plain likelihood and
+// once with a cached one, and check that the samples are the same and
+// that the likelihood is only evaluated once per state. Then run several
+// chains in parallel with a cache for vector-valued samples that is too
+// small to hold all states, and check the values returned, the
+// statistics, and that the cache does not grow beyond its capacity.
+
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/likelihood_cache.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+std::atomic<unsigned int> n_evaluations (0);
+
+
+double log_likelihood (const int &x)
+{
+  ++n_evaluations;
+  return std::log (x == 3 ? 0.5 : 0.1);
+}
+
+
+std::mt19937 rng;
+
+std::pair<int,double> propose_sample (const int &x)
+{
+  const int x_tilde = x + (std::bernoulli_distribution(0.5)(rng) ? 1 : -1);
+  return {(x_tilde < 1 ? 6 : (x_tilde > 6 ? 1 : x_tilde)), 1.};
+}
+
+
+std::vector<int>
+run_dice (const std::function<double (const int &)> &log_likelihood)
+{
+  rng.seed (1);
+  SampleFlow::Producers::MetropolisHastings<int> mh_sampler;
+  SampleFlow::Consumers::SampleStore<int> sample_store;
+  sample_store.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample (3, log_likelihood, &propose_sample, 10000);
+
+  return std::vector<int> (sample_store.begin(), sample_store.end());
+}
+
+
+void check_dice ()
+{
+  const std::vector<int> samples = run_dice (&log_likelihood);
+
+  n_evaluations = 0;
+  SampleFlow::LikelihoodCache<int> cached_log_likelihood (&log_likelihood, 100);
+  const std::vector<int> cached_samples = run_dice (cached_log_likelihood);
+
+  std::cout << "Dice:" << std::endl
+            << "  same samples: " << (samples == cached_samples) << std::endl
+            << "  one evaluation per state: " << (n_evaluations == 6) << std::endl
+            << "  misses: " << cached_log_likelihood.n_misses() << std::endl
+            << "  calls: " << cached_log_likelihood.n_hits() + cached_log_likelihood.n_misses() << std::endl
+            << "  size: " << cached_log_likelihood.size() << std::endl;
+}
+
+
+void check_chains ()
+{
+  using SampleType = std::vector<int>;
+  const auto log_likelihood = [](const SampleType &x)
+  {
+    ++n_evaluations;
+    return -0.1 * (x[0]*x[0] + x[1]*x[1]);
+  };
+
+  n_evaluations = 0;
+  SampleFlow::LikelihoodCache<SampleType> cached_log_likelihood (log_likelihood, 64, 4);
+
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+  bool values_correct = true;
+  mh_sampler.sample_chains (std::vector<SampleType> (8, SampleType {0,0}),
+                            [&](const SampleType &x)
+  {
+    const double value = cached_log_likelihood (x);
+    if (value != -0.1 * (x[0]*x[0] + x[1]*x[1]))
+      values_correct = false;
+    return value;
+  },
+  [](const SampleType &x, std::mt19937 &rng)
+  {
+    SampleType x_tilde = x;
+    x_tilde[std::uniform_int_distribution<int>(0,1)(rng)] += (std::bernoulli_distribution(0.5)(rng) ? 1 : -1);
+    return std::make_pair (x_tilde, 1.);
+  },
+  10000,
+  std::make_shared<SampleFlow::ThreadPool> (4));
+
+  std::cout << "Chains:" << std::endl
+            << "  values correct: " << values_correct << std::endl
+            << "  misses counted correctly: "
+            << (cached_log_likelihood.n_misses() == n_evaluations) << std::endl
+            << "  calls counted correctly: "
+            << (cached_log_likelihood.n_hits() + cached_log_likelihood.n_misses() == 8 * 10001) << std::endl
+            << "  hit rate above one half: "
+            << (cached_log_likelihood.hit_rate() > 0.5) << std::endl
+            << "  entries evicted: "
+            << (cached_log_likelihood.n_misses() > 64) << std::endl
+            << "  size within capacity: "
+            << (cached_log_likelihood.size() <= 64) << std::endl;
+
+  cached_log_likelihood.clear ();
+  std::cout << "  cleared: "
+            << (cached_log_likelihood.size() == 0 && cached_log_likelihood.n_hits() == 0) << std::endl;
+}
+
+
+int main ()
+{
+  check_dice ();
+  check_chains ();
+}
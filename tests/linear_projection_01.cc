@@ -0,0 +1,121 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the LinearProjection filter: Project four-dimensional samples
+// onto two directions, once with a dense operator and samples sent in a
+// batch (by a Range producer) and compact, fixed-size output vectors,
+// and once with a sparse operator and samples sent one at a time and
+// without contiguous storage. Each consumer downstream prints the
+// projected samples and records whether it received them as a batch.
+
+
+#include <iostream>
+#include <deque>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumer.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/linear_projection.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer that sends its samples individually rather than as a batch.
+template <typename SampleType>
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const SampleType &sample)
+    {
+      this->issue_sample (sample, SampleFlow::AuxiliaryData());
+    }
+};
+
+
+// A consumer that prints the samples it gets and how it got them.
+template <typename SampleType>
+class Printer : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    ~Printer ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample,
+             SampleFlow::AuxiliaryData) override
+    {
+      std::cout << "Sample: " << sample.transpose() << std::endl;
+    }
+
+    virtual
+    void
+    consume_batch (const std::vector<SampleType> &samples,
+                   const std::vector<SampleFlow::AuxiliaryData> &) override
+    {
+      std::cout << "Batch of " << samples.size() << " samples:" << std::endl;
+      for (const auto &sample : samples)
+        std::cout << "  " << sample.transpose() << std::endl;
+    }
+};
+
+
+
+int main ()
+{
+  const std::vector<std::vector<double>> samples
+    = {{1, 2, 3, 4}, {0, 1, 0, 1}, {-1, 0, 2, 1}};
+
+  {
+    Eigen::MatrixXd P (2,4);
+    P << 1, 1, 1, 1,
+         1, -1, 0, 0.5;
+
+    SampleFlow::Producers::Range<std::vector<double>> range_producer;
+
+    SampleFlow::Filters::LinearProjection<std::vector<double>,Eigen::Matrix<double,2,1>>
+    projection (P);
+    projection.connect_to_producer (range_producer);
+
+    Printer<Eigen::Matrix<double,2,1>> printer;
+    printer.connect_to_producer (projection);
+
+    range_producer.sample (samples);
+  }
+
+  {
+    Eigen::SparseMatrix<double> P (2,4);
+    P.insert (0,0) = 2;
+    P.insert (1,3) = -1;
+
+    Issuer<std::deque<double>> issuer;
+
+    SampleFlow::Filters::LinearProjection<std::deque<double>,Eigen::VectorXd,Eigen::SparseMatrix<double>>
+    projection (P);
+    projection.connect_to_producer (issuer);
+
+    Printer<Eigen::VectorXd> printer;
+    printer.connect_to_producer (projection);
+
+    for (const auto &sample : samples)
+      issuer.sample (std::deque<double>(sample.begin(), sample.end()));
+  }
+}
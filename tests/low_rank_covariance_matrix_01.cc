@@ -0,0 +1,112 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the LowRankCovarianceMatrix consumer. If the samples lie in a
+// subspace whose dimension is at most the rank of the approximation,
+// then the eigenvalues and eigenvectors must agree with the ones of
+// the full covariance matrix computed by CovarianceMatrix. If the
+// samples have small components outside this subspace, they must
+// still agree approximately.
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/low_rank_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+void test (const double noise)
+{
+  const unsigned int dimension = 100;
+  const unsigned int rank = 3;
+
+  // Three fixed directions in which the samples vary with standard
+  // deviations 3, 2, and 1:
+  std::mt19937 rng;
+  Eigen::MatrixXd directions (dimension, rank);
+  for (unsigned int i=0; i<dimension; ++i)
+    for (unsigned int k=0; k<rank; ++k)
+      directions(i,k) = SampleFlow::Testing::NormalDistribution<double>(0,1)(rng);
+  directions = directions.householderQr().householderQ() * Eigen::MatrixXd::Identity(dimension, rank);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> low_rank (rank);
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> first_half (rank);
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> second_half (rank);
+
+  for (unsigned int n=0; n<2000; ++n)
+    {
+      SampleType sample = SampleType::Constant (dimension, 1.);
+      for (unsigned int k=0; k<rank; ++k)
+        sample += directions.col(k) * SampleFlow::Testing::NormalDistribution<double>(0,3-k)(rng);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample(i) += SampleFlow::Testing::NormalDistribution<double>(0,noise)(rng);
+
+      SampleFlow::AuxiliaryData aux_data;
+      covariance.consume (sample, aux_data);
+      low_rank.consume (sample, aux_data);
+      if (n < 1234)
+        first_half.consume (sample, aux_data);
+      else
+        second_half.consume (sample, aux_data);
+    }
+  first_half.merge (second_half);
+
+  // Compute the exact eigenvalues from the full matrix, in descending
+  // order:
+  const Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen_solver (covariance.get());
+
+  for (const auto &result : {low_rank.get(), first_half.get()})
+    {
+      std::cout << "Noise " << noise << ": " << result.eigenvalues.size() << " eigenvalues" << std::endl;
+      for (unsigned int k=0; k<result.eigenvalues.size(); ++k)
+        {
+          const double exact_eigenvalue = eigen_solver.eigenvalues()(dimension-1-k);
+          const double alignment
+            = std::fabs(result.eigenvectors.col(k).dot(eigen_solver.eigenvectors().col(dimension-1-k)));
+          std::cout << "  eigenvalue " << result.eigenvalues(k)
+                    << ", relative error below 1e-2: "
+                    << (std::fabs(result.eigenvalues(k) - exact_eigenvalue) < 1e-2 * exact_eigenvalue)
+                    << ", relative error below 1e-10: "
+                    << (std::fabs(result.eigenvalues(k) - exact_eigenvalue) < 1e-10 * exact_eigenvalue)
+                    << ", eigenvector aligned: " << (alignment > 0.999)
+                    << ", unit length: " << (std::fabs(result.eigenvectors.col(k).norm()-1) < 1e-10)
+                    << std::endl;
+        }
+    }
+}
+
+
+
+int main ()
+{
+  test (0.);
+  test (0.01);
+}
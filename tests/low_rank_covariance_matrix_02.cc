@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that LowRankCovarianceMatrix computes the trace of the
+// covariance matrix exactly, also for weighted and repeated samples,
+// after merging two objects, and after saving and loading, and that it
+// can be used to determine the fraction of the variance captured by the
+// principal components.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/low_rank_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+int main ()
+{
+  const unsigned int dimension = 50;
+  const unsigned int rank = 2;
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> low_rank (rank);
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> first_half (rank);
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> second_half (rank);
+
+  // Samples that vary mostly in the first two components, with standard
+  // deviations 10 and 5, and only a little in all others:
+  std::mt19937 rng;
+  for (unsigned int n=0; n<1000; ++n)
+    {
+      SampleType sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample(i) = SampleFlow::Testing::NormalDistribution<double>(i, (i == 0 ? 10 : i == 1 ? 5 : 0.1))(rng);
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(1 + n%3);
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%2);
+
+      covariance.consume (sample, aux_data);
+      low_rank.consume (sample, aux_data);
+      if (n < 400)
+        first_half.consume (sample, aux_data);
+      else
+        second_half.consume (sample, aux_data);
+    }
+  first_half.merge (second_half);
+
+  std::vector<char> buffer;
+  low_rank.save (buffer);
+  SampleFlow::Consumers::LowRankCovarianceMatrix<SampleType> restored (rank);
+  std::span<const char> data (buffer);
+  restored.load (data);
+
+  const double exact_trace = covariance.get().trace();
+  for (const auto &result : {low_rank.get(), first_half.get(), restored.get()})
+    {
+      const double explained = result.eigenvalues.sum() / result.total_variance;
+      std::cout << "Total variance matches: "
+                << (std::fabs(result.total_variance - exact_trace) < 1e-12 * exact_trace)
+                << ", explained fraction between 0.99 and 1: "
+                << ((explained > 0.99) && (explained <= 1)) << std::endl;
+    }
+}
@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the MarginalHistograms consumer: Generate four-dimensional
+// samples, compute the histograms of three of their components (in an
+// order different from the one of the components in the samples) and
+// of all pairs of these components, and compare against Histogram and
+// PairHistogram objects fed with the corresponding components. The
+// samples are sent to the MarginalHistograms object from several
+// threads.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/marginal_histograms.h>
+#  include <sampleflow/consumers/pair_histogram.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::mt19937 rng;
+  std::normal_distribution<double> normal;
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<20000; ++i)
+    {
+      const double z = normal(rng);
+      samples.push_back ({ z + normal(rng), normal(rng), 2*z, z - 0.5*normal(rng) });
+    }
+
+  const std::vector<unsigned int> components = {3, 0, 2};
+  const std::vector<double>       min_values = {-2, -3, -4};
+  const std::vector<double>       max_values = {2, 3, 4};
+  const unsigned int              n_bins = 10;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  SampleFlow::Consumers::MarginalHistograms<SampleType>
+  histograms (min_values, max_values, n_bins, components);
+  histograms.connect_to_producer (range_producer);
+  range_producer.sample_in_parallel (samples);
+
+  bool histograms_correct = true;
+  for (unsigned int a=0; a<3; ++a)
+    {
+      SampleFlow::Producers::Range<double> producer;
+      SampleFlow::Consumers::Histogram<double> histogram (min_values[a], max_values[a], n_bins);
+      histogram.connect_to_producer (producer);
+
+      std::vector<double> values;
+      for (const auto &sample : samples)
+        values.push_back (sample[components[a]]);
+      producer.sample (values);
+
+      if (histograms.get(components[a]) != histogram.get())
+        histograms_correct = false;
+    }
+  std::cout << "Histograms: " << histograms_correct << std::endl;
+
+  // Compare the joint histograms, for both orders of the components:
+  bool pair_histograms_correct = true;
+  for (unsigned int a=0; a<3; ++a)
+    for (unsigned int b=0; b<3; ++b)
+      if (a != b)
+        {
+          SampleFlow::Producers::Range<SampleType> producer;
+          SampleFlow::Consumers::PairHistogram<SampleType>
+          pair_histogram (min_values[a], max_values[a], n_bins,
+                          min_values[b], max_values[b], n_bins);
+          pair_histogram.connect_to_producer (producer);
+
+          std::vector<SampleType> pairs;
+          for (const auto &sample : samples)
+            pairs.push_back ({ sample[components[a]], sample[components[b]] });
+          producer.sample (pairs);
+
+          if (histograms.get_pair(components[a], components[b]) != pair_histogram.get())
+            pair_histograms_correct = false;
+        }
+  std::cout << "Pair histograms: " << pair_histograms_correct << std::endl;
+
+  // Then check a repeated and weighted sample sent directly:
+  SampleFlow::AuxiliaryData aux_data;
+  aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(3);
+  aux_data[SampleFlow::AuxiliaryData::sample_weight] = 0.5;
+  SampleFlow::Consumers::MarginalHistograms<SampleType>
+  single_sample (min_values, max_values, n_bins, components);
+  single_sample.consume ({ 0.1, 10, -3.9, 1.9 }, aux_data);
+
+  for (const unsigned int component : components)
+    {
+      std::cout << "Component " << component << ':';
+      for (const auto &bin : single_sample.get_weighted(component))
+        std::cout << ' ' << std::get<2>(bin);
+      std::cout << std::endl;
+    }
+  for (const auto &bin : single_sample.get_pair(2, 0))
+    if (std::get<2>(bin) > 0)
+      std::cout << "Bin [" << std::get<0>(bin)[0] << ',' << std::get<1>(bin)[0]
+                << "]x[" << std::get<0>(bin)[1] << ',' << std::get<1>(bin)[1]
+                << "]: " << std::get<2>(bin) << std::endl;
+
+  // Finally check save() and load():
+  std::vector<char> buffer;
+  histograms.save (buffer);
+  SampleFlow::Consumers::MarginalHistograms<SampleType>
+  copy (min_values, max_values, n_bins, components);
+  std::span<const char> input (buffer);
+  copy.load (input);
+  std::cout << "Loaded: " << (copy.get_pair(0,3) == histograms.get_pair(0,3))
+            << ' ' << input.size() << std::endl;
+}
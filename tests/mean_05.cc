@@ -0,0 +1,106 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that MeanValue and CovarianceMatrix can accumulate samples with
+// single precision elements in double precision, both one sample at a
+// time and in batches, and that this yields results as accurate as
+// if the samples had been converted to double precision first.
+
+
+#include <iostream>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const unsigned int n_samples = 1000000;
+  const unsigned int batch_size = 1000;
+
+  // Samples whose elements are exactly representable in single
+  // precision, but whose mean is not well approximated by a running
+  // mean in single precision:
+  std::vector<Eigen::VectorXf> samples (n_samples, Eigen::VectorXf(2));
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      samples[n][0] = 1 + (n%1024)/1024.f;
+      samples[n][1] = 1000 - (n%4096)/4096.f;
+    }
+  Eigen::VectorXd exact_mean = Eigen::VectorXd::Zero(2);
+  for (const auto &sample : samples)
+    exact_mean += sample.cast<double>();
+  exact_mean /= n_samples;
+
+  SampleFlow::Consumers::MeanValue<float>                           mean_float;
+  SampleFlow::Consumers::MeanValue<float,double>                    mean_float_double;
+  SampleFlow::Consumers::MeanValue<Eigen::VectorXf>                 mean_vector_float;
+  SampleFlow::Consumers::MeanValue<Eigen::VectorXf,Eigen::VectorXd> mean_vector_double;
+  SampleFlow::Consumers::MeanValue<Eigen::VectorXf,Eigen::VectorXd> batched_mean;
+
+  SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXd>                 covariance_reference;
+  SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXf,Eigen::VectorXd> covariance;
+  SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXf,Eigen::VectorXd> batched_covariance;
+
+  const SampleFlow::AuxiliaryData aux_data;
+  for (unsigned int start=0; start<n_samples; start+=batch_size)
+    {
+      const std::vector<Eigen::VectorXf> batch (samples.begin()+start,
+                                                samples.begin()+start+batch_size);
+      for (const auto &sample : batch)
+        {
+          mean_float.consume (sample[0], aux_data);
+          mean_float_double.consume (sample[0], aux_data);
+          mean_vector_float.consume (sample, aux_data);
+          mean_vector_double.consume (sample, aux_data);
+
+          covariance_reference.consume (sample.cast<double>(), aux_data);
+          covariance.consume (sample, aux_data);
+        }
+      batched_mean.consume_batch (batch, std::vector<SampleFlow::AuxiliaryData>(batch_size));
+      batched_covariance.consume_batch (batch, std::vector<SampleFlow::AuxiliaryData>(batch_size));
+    }
+
+  // Compare errors relative to the exact mean. The single precision
+  // results are off by far more than the double precision ones:
+  const auto error = [&](const auto &mean)
+  {
+    return (mean.template cast<double>() - exact_mean).norm() / exact_mean.norm();
+  };
+  std::cout << "Scalar, float accumulator accurate:  "
+            << (std::abs(mean_float.get() - exact_mean[0]) < 1e-12 * exact_mean[0]) << std::endl;
+  std::cout << "Scalar, double accumulator accurate: "
+            << (std::abs(mean_float_double.get() - exact_mean[0]) < 1e-12 * exact_mean[0]) << std::endl;
+  std::cout << "Vector, float accumulator accurate:  "
+            << (error(mean_vector_float.get()) < 1e-12) << std::endl;
+  std::cout << "Vector, double accumulator accurate: "
+            << (error(mean_vector_double.get()) < 1e-12) << std::endl;
+  std::cout << "Vector, batched, accurate:           "
+            << (error(batched_mean.get()) < 1e-12) << std::endl;
+
+  const Eigen::MatrixXd C = covariance_reference.get();
+  std::cout << "Covariance same as for double samples: "
+            << ((covariance.get() - C).norm() < 1e-12 * C.norm()) << std::endl;
+  std::cout << "Batched covariance same as for double samples: "
+            << ((batched_covariance.get() - C).norm() < 1e-12 * C.norm()) << std::endl;
+}
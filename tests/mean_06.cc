@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that MeanValue can compute the mean of sparse samples (of type
+// Eigen::SparseVector), and that the result is the same as for the
+// corresponding dense samples. Samples have different weights, and
+// some are processed one at a time while others are processed in
+// batches or merged in from another object.
+
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const unsigned int dimension = 1000;
+  const unsigned int n_samples = 10000;
+
+  SampleFlow::Consumers::MeanValue<Eigen::SparseVector<double>> sparse_mean;
+  SampleFlow::Consumers::MeanValue<Eigen::SparseVector<double>> other_sparse_mean;
+  SampleFlow::Consumers::MeanValue<Eigen::VectorXd>             dense_mean;
+
+  // The default accumulator is a dense vector:
+  static_assert (std::is_same_v<decltype(sparse_mean.get()), Eigen::VectorXd>);
+
+  std::mt19937 random_number_generator;
+  std::vector<Eigen::SparseVector<double>> batch;
+  std::vector<SampleFlow::AuxiliaryData>   batch_aux_data;
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      // Samples with five nonzero elements at random places:
+      Eigen::SparseVector<double> sample (dimension);
+      for (unsigned int i=0; i<5; ++i)
+        sample.coeffRef(random_number_generator() % dimension)
+          = 1. * (random_number_generator() % 1000) / 100;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = 1. + (n%3);
+
+      dense_mean.consume (Eigen::VectorXd(sample), aux_data);
+      if (n % 4 == 0)
+        other_sparse_mean.consume (sample, aux_data);
+      else if (n % 4 == 1)
+        {
+          batch.push_back (sample);
+          batch_aux_data.push_back (aux_data);
+        }
+      else
+        sparse_mean.consume (sample, aux_data);
+    }
+  sparse_mean.consume_batch (batch, batch_aux_data);
+  sparse_mean.merge (other_sparse_mean);
+
+  const Eigen::VectorXd reference = dense_mean.get();
+  std::cout << "Mean norm: " << reference.norm() << std::endl;
+  std::cout << "Sparse mean agrees with dense mean: "
+            << ((sparse_mean.get() - reference).norm() < 1e-12 * reference.norm())
+            << std::endl;
+}
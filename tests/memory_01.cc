@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the memory accounting of namespace Memory: The estimates of the
+// memory used by samples of different types, the memory reported by
+// consumers with large states, and that a memory budget keeps the
+// samples queued by a slow consumer below the limit while without
+// a budget, they exceed it.
+
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <sampleflow/consumers/sample_store.h>
+#  include <sampleflow/memory.h>
+#  include <Eigen/Dense>
+#else
+import SampleFlow;
+#  include <Eigen/Dense>
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+// Send samples to a consumer that processes them slowly on its own
+// thread, and return the high-water mark of the memory taken up by the
+// samples waiting for it.
+std::size_t run_slow_consumer (const std::vector<SampleType> &samples)
+{
+  SampleFlow::Memory::reset_high_water_mark ();
+
+  unsigned int n_processed = 0;
+  SampleFlow::Consumers::Action<SampleType> action ([&](SampleType, SampleFlow::AuxiliaryData)
+  {
+    std::this_thread::sleep_for (std::chrono::microseconds (100));
+    ++n_processed;
+  },
+  false,
+  SampleFlow::ParallelMode::dedicated_thread);
+  action.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 1000);
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  action.connect_to_producer (range_producer);
+  range_producer.sample (samples);
+
+  std::cout << "  Samples processed: " << n_processed
+            << ", still queued: " << action.queued_memory_consumption()
+            << ", in total: " << SampleFlow::Memory::queued_bytes() << std::endl;
+
+  return SampleFlow::Memory::high_water_mark();
+}
+
+
+int main ()
+{
+  std::cout << "std::vector<double>(10): "
+            << (SampleFlow::Memory::memory_consumption (std::vector<double>(10))
+                == sizeof(std::vector<double>) + 10*sizeof(double)) << std::endl;
+  std::cout << "std::array<double,3>: "
+            << (SampleFlow::Memory::memory_consumption (std::array<double,3>())
+                == sizeof(std::array<double,3>)) << std::endl;
+  std::cout << "Eigen::VectorXd(5): "
+            << (SampleFlow::Memory::memory_consumption (Eigen::VectorXd(5))
+                == sizeof(Eigen::VectorXd) + 5*sizeof(double)) << std::endl;
+  std::cout << "Eigen::Vector3d: "
+            << (SampleFlow::Memory::memory_consumption (Eigen::Vector3d())
+                == sizeof(Eigen::Vector3d)) << std::endl;
+  std::cout << "std::vector<std::vector<double>>(2, std::vector<double>(10)): "
+            << (SampleFlow::Memory::memory_consumption (std::vector<std::vector<double>>(2, std::vector<double>(10)))
+                == sizeof(std::vector<std::vector<double>>)
+                + 2*(sizeof(std::vector<double>) + 10*sizeof(double))) << std::endl;
+  std::cout << "double: " << SampleFlow::Memory::memory_consumption (1.) << std::endl;
+
+  std::vector<SampleType> samples (200, SampleType::Ones(100));
+  const std::size_t bytes_per_sample
+    = (SampleFlow::Memory::memory_consumption (samples[0])
+       + SampleFlow::Memory::memory_consumption (SampleFlow::AuxiliaryData()));
+
+  // Consumers with large states:
+  {
+    SampleFlow::Consumers::AutoCovarianceMatrix<SampleType> auto_covariance (10);
+    SampleFlow::Consumers::SampleStore<SampleType> sample_store;
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    auto_covariance.connect_to_producer (range_producer);
+    sample_store.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    // The autocovariance stores 11 matrices of size 100x100, and the
+    // sample store all 200 samples:
+    std::cout << "AutoCovarianceMatrix: "
+              << (auto_covariance.memory_consumption() > 11*100*100*sizeof(double)) << std::endl;
+    std::cout << "SampleStore: "
+              << (sample_store.memory_consumption() >= 200*100*sizeof(double)) << std::endl;
+  }
+
+  // Without a budget, the producer sends samples much faster than they
+  // can be processed, and they pile up:
+  const std::size_t budget = 20 * bytes_per_sample;
+  std::cout << "Without a budget:" << std::endl;
+  const std::size_t unlimited_mark = run_slow_consumer (samples);
+  std::cout << "  High-water mark above the memory of 20 samples: "
+            << (unlimited_mark > budget) << std::endl;
+
+  SampleFlow::Memory::set_budget (budget);
+  std::cout << "With a budget of the memory of "
+            << SampleFlow::Memory::get_budget() / bytes_per_sample << " samples:" << std::endl;
+  const std::size_t limited_mark = run_slow_consumer (samples);
+  std::cout << "  High-water mark within budget: " << (limited_mark <= budget)
+            << ", at least one sample: " << (limited_mark >= bytes_per_sample) << std::endl;
+}
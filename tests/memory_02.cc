@@ -0,0 +1,106 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Memory::CacheLineAllocator: Allocations have to start on a cache
+// line and take up whole cache lines (or huge pages, for large ones), and
+// the objects stored by CopyOnWrite -- and therefore the shards of a
+// ShardedAccumulator -- have to be allocated this way, so that no two of
+// them share a cache line.
+
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/copy_on_write.h>
+#  include <sampleflow/memory.h>
+#else
+import SampleFlow;
+#endif
+
+
+bool
+is_aligned (const void *p, const std::size_t alignment)
+{
+  return (reinterpret_cast<std::uintptr_t>(p) % alignment == 0);
+}
+
+
+int main ()
+{
+  using namespace SampleFlow;
+
+  // The layout of blocks of different sizes:
+  for (const std::size_t n_bytes : {1UL, 8UL, 64UL, 65UL, 1000UL, Memory::huge_page_size, Memory::huge_page_size+1})
+    {
+      const auto [alignment, size] = Memory::CacheLineAllocator<char>::block_layout (n_bytes);
+      std::cout << n_bytes << " bytes: alignment " << alignment << ", size " << size << std::endl;
+    }
+
+  // Actual allocations, with and without huge pages:
+  for (const bool huge_pages : {false, true})
+    {
+      Memory::set_huge_pages (huge_pages);
+      std::cout << "Huge pages: " << Memory::get_huge_pages() << std::endl;
+
+      std::vector<double,Memory::CacheLineAllocator<double>> small (3, 1.);
+      std::vector<double,Memory::CacheLineAllocator<double>> large (Memory::huge_page_size / sizeof(double), 1.);
+      std::cout << "  Small vector aligned to a cache line: "
+                << is_aligned (small.data(), Memory::cache_line_size) << std::endl;
+      std::cout << "  Large vector aligned to a huge page: "
+                << is_aligned (large.data(), Memory::huge_page_size) << std::endl;
+    }
+  Memory::set_huge_pages (false);
+
+  // Many small CopyOnWrite objects, as used for the shards of a
+  // ShardedAccumulator, must all live on cache lines of their own, also
+  // after modify() has had to make a copy:
+  std::vector<std::unique_ptr<CopyOnWrite<int>>> objects;
+  for (unsigned int i=0; i<100; ++i)
+    objects.emplace_back (std::make_unique<CopyOnWrite<int>>(i));
+
+  bool all_aligned = true;
+  for (auto &object : objects)
+    {
+      const std::shared_ptr<const int> before = object->snapshot();
+      object->modify ([](int &value)
+      {
+        ++value;
+      });
+      const std::shared_ptr<const int> after = object->snapshot();
+
+      // The objects themselves and their reference counts (which are
+      // stored in front of them) need to be on a separate cache line from
+      // every other object:
+      for (const auto &other : objects)
+        if (other.get() != object.get())
+          {
+            const auto line = [](const void *p)
+            {
+              return reinterpret_cast<std::uintptr_t>(p) / Memory::cache_line_size;
+            };
+            if ((line (after.get()) == line (other->snapshot().get()))
+                ||
+                (line (before.get()) == line (other->snapshot().get())))
+              all_aligned = false;
+          }
+      if ((*after != *before + 1) || (after.get() == before.get()))
+        all_aligned = false;
+    }
+  std::cout << "CopyOnWrite objects on separate cache lines: " << all_aligned << std::endl;
+}
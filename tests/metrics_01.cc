@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Metrics::Exporter: The output needs to be in the Prometheus text
+// format, with one description per metric followed by the values for
+// all registered objects. The sampler's timings, its acceptance ratio,
+// and the counters of producers and consumers need to be reported, and
+// objects that are removed need to disappear from the output.
+//
+// The counters of producers and consumers are only kept if
+// SAMPLEFLOW_WITH_INSTRUMENTATION is defined, which only takes effect if
+// the header files are included, and so this test does not use the
+// SampleFlow module.
+
+
+#define SAMPLEFLOW_WITH_INSTRUMENTATION
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/acceptance_ratio.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/metrics.h>
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+std::pair<double,double> perturb (const double &x)
+{
+  static std::mt19937 rng;
+  return {x + std::normal_distribution<double>(0, 1)(rng), 1.0};
+}
+
+
+// Print the scraped metrics, except for the values of those that measure
+// time and consequently differ from run to run.
+void print (const std::string &metrics)
+{
+  std::istringstream in (metrics);
+  std::string line;
+  while (std::getline (in, line))
+    if ((line[0] != '#') && (line.find ("second") != std::string::npos))
+      {
+        const std::size_t space = line.rfind (' ');
+        std::cout << line.substr (0, space) << " (time is non-negative: "
+                  << (std::stod (line.substr (space+1)) >= 0) << ")" << std::endl;
+      }
+    else
+      std::cout << line << std::endl;
+}
+
+
+int main ()
+{
+  SampleFlow::Producers::MetropolisHastings<double>::Parameters parameters;
+  parameters.record_timings = true;
+  SampleFlow::Producers::MetropolisHastings<double> mh_sampler (parameters);
+
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::AcceptanceRatio<double> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (mh_sampler);
+
+  SampleFlow::Metrics::Exporter exporter;
+  exporter.add_producer ("mh", mh_sampler);
+  exporter.add_consumer ("count", count_samples);
+  exporter.add_consumer ("acceptance", acceptance_ratio);
+  exporter.add_acceptance_ratio ("mh", acceptance_ratio);
+  exporter.add_gauge ("sampleflow_test_value", "A \"quoted\" name.", "a\"b",
+                      []()
+  {
+    return 0.25;
+  });
+
+  mh_sampler.sample (0., &log_likelihood, &perturb, 1000);
+  print (exporter.scrape());
+
+  std::cout << "After removing objects:" << std::endl;
+  exporter.remove ("mh");
+  exporter.remove ("acceptance");
+  exporter.remove ("a\"b");
+  print (exporter.scrape());
+}
@@ -0,0 +1,101 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check MetropolisHastings::sample_chains(): Run four chains on a pool
+// with two threads and verify that each chain produces the requested
+// number of samples, tagged with its chain number, and that each chain
+// is reproducible regardless of how it was scheduled.
+
+
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+// Run the chains and return the sum of the samples of each chain,
+// in the order in which the chain produced them.
+std::vector<double> run (const unsigned int n_threads)
+{
+  const unsigned int n_chains = 4;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (mh_sampler);
+
+  std::mutex mutex;
+  std::vector<double> sums (n_chains, 0.);
+  std::vector<unsigned int> counts (n_chains, 0);
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+  {
+    const std::size_t chain
+      = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+    std::lock_guard<std::mutex> lock (mutex);
+    sums[chain] += sample;
+    ++counts[chain];
+  });
+  action.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample_chains ({-1., 0., 2., 3.},
+                            &log_likelihood,
+                            &perturb,
+                            10000,
+                            std::make_shared<SampleFlow::ThreadPool>(n_threads));
+
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+  for (unsigned int c=0; c<n_chains; ++c)
+    std::cout << "Chain " << c << ": " << counts[c] << " samples, mean value "
+              << sums[c]/counts[c] << std::endl;
+
+  return sums;
+}
+
+
+int main ()
+{
+  const std::vector<double> sums_1 = run (2);
+  const std::vector<double> sums_2 = run (1);
+
+  std::cout << "Chains are reproducible: " << (sums_1 == sums_2) << std::endl;
+}
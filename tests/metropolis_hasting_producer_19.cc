@@ -0,0 +1,109 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the variant of MetropolisHastings::sample_chains() that takes
+// a function evaluating the log likelihood for a batch of samples at
+// once: It needs to call this function once per step for all chains,
+// and produce the same chains as the variant that runs the chains
+// independently on a thread pool.
+
+
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+unsigned int n_batch_evaluations = 0;
+
+void batch_log_likelihood (std::span<const SampleType> samples,
+                           std::span<double> log_likelihoods)
+{
+  ++n_batch_evaluations;
+  for (std::size_t i=0; i<samples.size(); ++i)
+    log_likelihoods[i] = log_likelihood (samples[i]);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 3;
+  const std::vector<SampleType> starting_points = {-1., 0., 2.};
+
+  // For each of the two ways of running the chains, record the
+  // samples of each chain in the order in which they arrive:
+  std::vector<std::vector<SampleType>> chains[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      chains[run].resize (n_chains);
+
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const std::size_t chain
+          = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+        std::lock_guard<std::mutex> lock (mutex);
+        chains[run][chain].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      if (run == 0)
+        mh_sampler.sample_chains (starting_points,
+                                  &log_likelihood,
+                                  &perturb,
+                                  1000,
+                                  std::make_shared<SampleFlow::ThreadPool>(2));
+      else
+        mh_sampler.sample_chains (starting_points,
+                                  &batch_log_likelihood,
+                                  &perturb,
+                                  1000);
+    }
+
+  // One evaluation for the starting points, and one per step:
+  std::cout << "Number of batch evaluations: " << n_batch_evaluations << std::endl;
+  for (unsigned int c=0; c<n_chains; ++c)
+    std::cout << "Chain " << c << ": " << chains[1][c].size() << " samples, same as with thread pool: "
+              << (chains[0][c] == chains[1][c]) << std::endl;
+}
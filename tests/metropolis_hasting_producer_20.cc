@@ -0,0 +1,117 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the variant of MetropolisHastings::sample_chains() that takes a
+// function returning a std::future for the log likelihood: All chains
+// need to have their evaluations in flight at the same time, and the
+// chains need to be the same as with a likelihood that returns its
+// result right away.
+
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+// Simulate a remote evaluation by returning a deferred future, and
+// keep track of how many evaluations have been started but not
+// finished.
+unsigned int n_in_flight     = 0;
+unsigned int max_n_in_flight = 0;
+
+std::future<double> asynchronous_log_likelihood (const SampleType &x)
+{
+  ++n_in_flight;
+  max_n_in_flight = std::max (max_n_in_flight, n_in_flight);
+
+  return std::async (std::launch::deferred,
+                     [x]()
+  {
+    --n_in_flight;
+    return log_likelihood (x);
+  });
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 5;
+  const std::vector<SampleType> starting_points = {-1., 0., 1., 2., 3.};
+
+  std::vector<std::vector<SampleType>> chains[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      chains[run].resize (n_chains);
+
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const std::size_t chain
+          = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+        std::lock_guard<std::mutex> lock (mutex);
+        chains[run][chain].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      if (run == 0)
+        mh_sampler.sample_chains (starting_points,
+                                  &log_likelihood,
+                                  &perturb,
+                                  1000,
+                                  std::make_shared<SampleFlow::ThreadPool>(2));
+      else
+        mh_sampler.sample_chains (starting_points,
+                                  &asynchronous_log_likelihood,
+                                  &perturb,
+                                  1000);
+    }
+
+  std::cout << "Maximal number of evaluations in flight: " << max_n_in_flight << std::endl;
+  std::cout << "Evaluations left in flight: " << n_in_flight << std::endl;
+  for (unsigned int c=0; c<n_chains; ++c)
+    std::cout << "Chain " << c << ": " << chains[1][c].size() << " samples, same as with thread pool: "
+              << (chains[0][c] == chains[1][c]) << std::endl;
+}
@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check MetropolisHastings with random number generators other than the
+// default std::mt19937: Run four chains with each of the generators in
+// namespace SampleFlow::Random and verify that the chains are
+// reproducible regardless of how they were scheduled, and that they
+// sample the right distribution.
+
+
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/random.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+// Run the chains and return the sum of the samples of each chain.
+template <typename RNG>
+std::vector<double> run (const unsigned int n_threads)
+{
+  const unsigned int n_chains = 4;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType,RNG> mh_sampler ({123});
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  std::mutex mutex;
+  std::vector<double> sums (n_chains, 0.);
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+  {
+    const std::size_t chain
+      = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+    std::lock_guard<std::mutex> lock (mutex);
+    sums[chain] += sample;
+  });
+  action.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample_chains ({-1., 0., 2., 3.},
+                            &log_likelihood,
+                            [](const SampleType &x, RNG &rng)
+  {
+    std::normal_distribution<double> distribution(0, 0.5);
+    return std::make_pair (x + distribution(rng), 1.0);
+  },
+  10000,
+  std::make_shared<SampleFlow::ThreadPool>(n_threads));
+
+  std::cout << "  mean value close to one: "
+            << (std::fabs(mean_value.get() - 1) < 0.05) << std::endl;
+
+  return sums;
+}
+
+
+template <typename RNG>
+void check (const std::string &name)
+{
+  std::cout << name << ':' << std::endl;
+
+  const std::vector<double> sums_1 = run<RNG> (2);
+  const std::vector<double> sums_2 = run<RNG> (1);
+
+  std::cout << "  chains are reproducible: " << (sums_1 == sums_2) << std::endl;
+  std::cout << "  chains differ: " << (sums_1[0] != sums_1[1]) << std::endl;
+}
+
+
+int main ()
+{
+  check<SampleFlow::Random::Philox4x32> ("Philox4x32");
+  check<SampleFlow::Random::Xoshiro256PlusPlus> ("Xoshiro256PlusPlus");
+}
@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the templated MetropolisHastings::sample() function that accepts
+// arbitrary function objects, including a proposal function that writes
+// the trial sample into an object provided by the sampler. Verify that
+// the latter produces the same samples as a proposal function that
+// returns the trial sample, and that the sampler does not allocate new
+// memory for the trial samples it hands to the in-place proposal
+// function: it only ever uses the memory of two vectors.
+
+
+#include <iostream>
+#include <random>
+#include <set>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+int main ()
+{
+  const auto log_likelihood = [](const SampleType &x)
+  {
+    return -0.5 * (x.array()-1).square().sum();
+  };
+
+  SampleType starting_point = SampleType::Zero(10);
+
+  // First run the sampler with a proposal function that returns its
+  // trial samples:
+  SampleType mean_1;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    std::mt19937 rng;
+    mh_sampler.sample (starting_point,
+                       log_likelihood,
+                       [&rng](const SampleType &x)
+    {
+      std::normal_distribution<double> distribution (0, 0.3);
+      SampleType trial_sample = x;
+      for (auto &y : trial_sample)
+        y += distribution (rng);
+      return std::make_pair (trial_sample, 1.0);
+    },
+    20000);
+
+    mean_1 = mean_value.get();
+  }
+
+  // Then do the same with a proposal function that writes its trial
+  // samples into the object provided:
+  SampleType mean_2;
+  std::set<const double *> trial_sample_buffers;
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+
+    std::mt19937 rng;
+    mh_sampler.sample (starting_point,
+                       log_likelihood,
+                       [&](const SampleType &x, SampleType &trial_sample)
+    {
+      std::normal_distribution<double> distribution (0, 0.3);
+      trial_sample_buffers.insert (trial_sample.data());
+      for (Eigen::Index i=0; i<x.size(); ++i)
+        trial_sample[i] = x[i] + distribution (rng);
+      return 1.0;
+    },
+    20000);
+
+    mean_2 = mean_value.get();
+    std::cout << "Acceptance ratio is reasonable: "
+              << (acceptance_ratio.get() > 0.2 && acceptance_ratio.get() < 0.8)
+              << std::endl;
+  }
+
+  std::cout << "Mean value: " << mean_2.transpose() << std::endl;
+  std::cout << "Same samples: " << (mean_1 == mean_2) << std::endl;
+  std::cout << "Number of trial sample buffers: " << trial_sample_buffers.size() << std::endl;
+}
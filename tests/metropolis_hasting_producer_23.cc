@@ -0,0 +1,211 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check MetropolisHastings::Parameters::compress_repeated_samples: Run the
+// same chain (a random walk with large steps and consequently a low
+// acceptance rate) once with and once without compressing repeated
+// samples, and verify that the consumers and filters that know about
+// repetition counts compute the same results from the run-length encoded
+// stream of samples as from the full stream, while receiving many fewer
+// samples. Do this both for a single chain and for several chains run
+// with a batch log likelihood.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/filters/component_splitter.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/pair_histogram.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * x.squaredNorm();
+}
+
+
+struct Results
+{
+  SampleType                      mean;
+  Eigen::MatrixXd                 covariance;
+  SampleFlow::types::sample_index n_samples;
+  std::vector<SampleFlow::types::sample_index> histogram;
+  std::vector<SampleFlow::types::sample_index> pair_histogram;
+  SampleFlow::types::sample_index n_every_nth_samples;
+  SampleType                      every_nth_mean;
+  SampleFlow::types::sample_index n_late_samples;
+  SampleType                      late_mean;
+  SampleFlow::types::sample_index n_received_samples;
+};
+
+
+Results
+run (const bool compress_repeated_samples,
+     const bool several_chains)
+{
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.compress_repeated_samples = compress_repeated_samples;
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (mh_sampler);
+
+  SampleFlow::Filters::ComponentSplitter<SampleType> first_component (0);
+  first_component.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::Histogram<double> histogram (-3, 3, 12);
+  histogram.connect_to_producer (first_component);
+
+  SampleFlow::Consumers::PairHistogram<SampleType> pair_histogram (-3, 3, 6, -3, 3, 6);
+  pair_histogram.connect_to_producer (mh_sampler);
+
+  SampleFlow::Filters::TakeEveryNth<SampleType> every_nth (7);
+  every_nth.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::CountSamples<SampleType> count_every_nth_samples;
+  count_every_nth_samples.connect_to_producer (every_nth);
+  SampleFlow::Consumers::MeanValue<SampleType> every_nth_mean_value;
+  every_nth_mean_value.connect_to_producer (every_nth);
+
+  SampleFlow::Filters::DiscardFirstN<SampleType> discard_first_n (1001);
+  discard_first_n.connect_to_producer (mh_sampler);
+  SampleFlow::Consumers::CountSamples<SampleType> count_late_samples;
+  count_late_samples.connect_to_producer (discard_first_n);
+  SampleFlow::Consumers::MeanValue<SampleType> late_mean_value;
+  late_mean_value.connect_to_producer (discard_first_n);
+
+  SampleFlow::types::sample_index n_received_samples = 0;
+  SampleFlow::Consumers::Action<SampleType> count_received_samples
+  ([&n_received_samples](const SampleType &, const SampleFlow::AuxiliaryData &)
+  {
+    ++n_received_samples;
+  });
+  count_received_samples.connect_to_producer (mh_sampler);
+
+  // A random walk with a step size much larger than the width of the
+  // distribution, so that most trial samples are rejected:
+  const auto perturb = [](const SampleType &x, std::mt19937 &rng)
+  {
+    std::normal_distribution<double> distribution (0, 8);
+    SampleType y = x;
+    for (auto &y_i : y)
+      y_i += distribution (rng);
+    return std::make_pair (y, 1.0);
+  };
+
+  SampleType starting_point = SampleType::Zero(2);
+  if (several_chains == false)
+    {
+      std::mt19937 rng;
+      mh_sampler.sample (starting_point,
+                         &log_likelihood,
+                         [&](const SampleType &x)
+      {
+        return perturb (x, rng);
+      },
+      100000);
+    }
+  else
+    mh_sampler.sample_chains (std::vector<SampleType>(4, starting_point),
+                              [](std::span<const SampleType> samples,
+                                 std::span<double> log_likelihoods)
+    {
+      for (std::size_t i=0; i<samples.size(); ++i)
+        log_likelihoods[i] = log_likelihood (samples[i]);
+    },
+    perturb,
+    25000);
+
+  Results results;
+  results.mean = mean_value.get();
+  results.covariance = covariance_matrix.get();
+  results.n_samples = count_samples.get();
+  for (const auto &bin : histogram.get())
+    results.histogram.push_back (std::get<2>(bin));
+  for (const auto &bin : pair_histogram.get())
+    results.pair_histogram.push_back (std::get<2>(bin));
+  results.n_every_nth_samples = count_every_nth_samples.get();
+  results.every_nth_mean = every_nth_mean_value.get();
+  results.n_late_samples = count_late_samples.get();
+  results.late_mean = late_mean_value.get();
+  results.n_received_samples = n_received_samples;
+  return results;
+}
+
+
+int main ()
+{
+  for (const bool several_chains : {false, true})
+    {
+      const Results full       = run (false, several_chains);
+      const Results compressed = run (true, several_chains);
+
+      std::cout << (several_chains ? "Several chains:" : "One chain:") << std::endl
+                << "  number of samples: " << full.n_samples
+                << ' ' << compressed.n_samples << std::endl
+                << "  mean values agree: "
+                << ((full.mean - compressed.mean).norm() < 1e-12) << std::endl
+                << "  covariance matrices agree: "
+                << ((full.covariance - compressed.covariance).norm() < 1e-12) << std::endl
+                << "  histograms agree: "
+                << (full.histogram == compressed.histogram) << std::endl
+                << "  pair histograms agree: "
+                << (full.pair_histogram == compressed.pair_histogram) << std::endl
+                << "  number of every 7th samples: " << full.n_every_nth_samples
+                << ' ' << compressed.n_every_nth_samples << std::endl
+                << "  number of samples after the first 1001: " << full.n_late_samples
+                << ' ' << compressed.n_late_samples << std::endl
+                << "  fewer than 5% of samples sent when compressing: "
+                << (compressed.n_received_samples < 0.05 * full.n_received_samples) << std::endl;
+
+      // For a single chain, the filters also have to select the same
+      // samples. For several chains, this is not the case since the
+      // samples of different chains are interleaved differently if
+      // repeated samples are compressed.
+      if (several_chains == false)
+        std::cout << "  mean values of every 7th samples agree: "
+                  << ((full.every_nth_mean - compressed.every_nth_mean).norm() < 1e-12) << std::endl
+                  << "  mean values of samples after the first 1001 agree: "
+                  << ((full.late_mean - compressed.late_mean).norm() < 1e-12) << std::endl;
+    }
+}
@@ -0,0 +1,191 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the variant of MetropolisHastings::sample_chains() that runs each
+// chain as a coroutine: The log likelihoods are evaluated by a separate
+// "remote" thread that answers requests in an order different from the
+// one in which they arrive, and many more chains than there are worker
+// threads need to have their evaluations in flight at the same time. The
+// chains need to be the same as with a likelihood that returns its result
+// right away.
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/coroutines.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+// A class that simulates a remote machine that evaluates the likelihood:
+// Requests are collected in a queue, and a separate thread takes all
+// requests that have accumulated and answers them in reverse order.
+class RemoteEvaluator
+{
+  public:
+    RemoteEvaluator ()
+      : shutting_down (false),
+        n_in_flight (0),
+        max_n_in_flight (0),
+        evaluation_thread ([this]()
+    {
+      evaluate();
+    })
+    {}
+
+    ~RemoteEvaluator ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        shutting_down = true;
+      }
+      request_added.notify_one();
+      evaluation_thread.join();
+    }
+
+    std::future<double> operator() (const SampleType &x)
+    {
+      std::promise<double> promise;
+      std::future<double> future = promise.get_future();
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        requests.emplace_back (x, std::move(promise));
+        max_n_in_flight = std::max (max_n_in_flight, ++n_in_flight);
+      }
+      request_added.notify_one();
+      return future;
+    }
+
+    std::mutex                                          mutex;
+    std::condition_variable                             request_added;
+    std::deque<std::pair<SampleType,std::promise<double>>> requests;
+    bool                                                shutting_down;
+    unsigned int                                        n_in_flight;
+    unsigned int                                        max_n_in_flight;
+    std::thread                                         evaluation_thread;
+
+  private:
+    void evaluate ()
+    {
+      std::unique_lock<std::mutex> lock (mutex);
+      while (true)
+        {
+          request_added.wait (lock, [this]()
+          {
+            return shutting_down || (requests.empty() == false);
+          });
+          if (requests.empty())
+            return;
+
+          std::deque<std::pair<SampleType,std::promise<double>>> batch;
+          std::swap (batch, requests);
+          n_in_flight -= batch.size();
+          lock.unlock();
+
+          // Give the other chains a chance to send their requests, then
+          // answer the ones we have in reverse order:
+          std::this_thread::sleep_for (std::chrono::microseconds(200));
+          for (auto p=batch.rbegin(); p!=batch.rend(); ++p)
+            p->second.set_value (log_likelihood (p->first));
+
+          lock.lock();
+        }
+    }
+};
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 40;
+  std::vector<SampleType> starting_points;
+  for (unsigned int c=0; c<n_chains; ++c)
+    starting_points.push_back (0.1*c);
+
+  const auto thread_pool = std::make_shared<SampleFlow::ThreadPool>(2);
+  RemoteEvaluator remote_evaluator;
+
+  std::vector<std::vector<SampleType>> chains[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      chains[run].resize (n_chains);
+
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const std::size_t chain
+          = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+        std::lock_guard<std::mutex> lock (mutex);
+        chains[run][chain].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      if (run == 0)
+        mh_sampler.sample_chains (starting_points,
+                                  &log_likelihood,
+                                  &perturb,
+                                  200,
+                                  thread_pool);
+      else
+        {
+          SampleFlow::Coroutines::Scheduler scheduler (thread_pool);
+          mh_sampler.sample_chains (starting_points,
+                                    std::ref(remote_evaluator),
+                                    &perturb,
+                                    200,
+                                    scheduler);
+          std::cout << "Coroutines still running: " << scheduler.n_active_tasks() << std::endl;
+        }
+    }
+
+  std::cout << "More evaluations in flight than threads: "
+            << (remote_evaluator.max_n_in_flight > thread_pool->n_threads()) << std::endl;
+  for (unsigned int c=0; c<n_chains; ++c)
+    std::cout << "Chain " << c << ": " << chains[1][c].size() << " samples, same as with thread pool: "
+              << (chains[0][c] == chains[1][c]) << std::endl;
+}
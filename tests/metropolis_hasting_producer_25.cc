@@ -0,0 +1,225 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that MetropolisHastings only attaches those entries of the
+// auxiliary data to its samples that the consumers connected to it
+// (directly or through filters) declare that they use, and that doing so
+// does not change the samples or what the consumers compute from them.
+
+
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/filters/pass_through.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+// A consumer that records the keys of the auxiliary data of the samples
+// it receives, and declares that it uses the keys given to its
+// constructor (or all keys if none are given).
+class KeyRecorder : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    KeyRecorder (const std::optional<std::vector<SampleFlow::AuxiliaryData::Key>> &keys)
+      : keys (keys)
+    {}
+
+    ~KeyRecorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType, SampleFlow::AuxiliaryData aux_data) override
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      for (const auto &entry : aux_data)
+        seen_keys.insert (entry.first.name());
+    }
+
+    virtual
+    std::optional<std::vector<SampleFlow::AuxiliaryData::Key>>
+    used_aux_data_keys () const override
+    {
+      return keys;
+    }
+
+    void
+    print () const
+    {
+      std::cout << "  Keys seen:";
+      for (const std::string &key : seen_keys)
+        std::cout << " '" << key << "'";
+      std::cout << std::endl;
+    }
+
+  private:
+    const std::optional<std::vector<SampleFlow::AuxiliaryData::Key>> keys;
+    std::mutex            mutex;
+    std::set<std::string> seen_keys;
+};
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -x*x/2;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  static std::mt19937 rng;
+  std::uniform_real_distribution<double> distribution(-1,1);
+  return {x + distribution(rng), 1.0};
+}
+
+
+std::pair<SampleType,double> perturb_chain (const SampleType &x,
+                                            std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> distribution(-1,1);
+  return {x + distribution(rng), 1.0};
+}
+
+
+void
+print_requests (const SampleFlow::Producer<SampleType> &producer)
+{
+  std::cout << "  Requested:";
+  for (const SampleFlow::AuxiliaryData::Key &key :
+       {
+         SampleFlow::AuxiliaryData::relative_log_likelihood,
+         SampleFlow::AuxiliaryData::sample_is_repeated,
+         SampleFlow::AuxiliaryData::chain_number,
+         SampleFlow::AuxiliaryData::repetition_count
+       })
+    if (producer.aux_data_requested (key))
+      std::cout << " '" << key << "'";
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  // Nobody connected, nothing requested:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    std::cout << "No consumers:" << std::endl;
+    print_requests (mh_sampler);
+  }
+
+  // Consumers that only use repetition counts and weights, directly and
+  // through a filter:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    SampleFlow::Filters::PassThrough<SampleType> pass_through;
+    pass_through.connect_to_producer (mh_sampler);
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (mh_sampler);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (pass_through);
+
+    std::cout << "Statistics only:" << std::endl;
+    print_requests (mh_sampler);
+
+    // Then add a consumer behind the filter that looks at the log
+    // likelihood, and one that wants to know about repeated samples:
+    KeyRecorder recorder ({{SampleFlow::AuxiliaryData::relative_log_likelihood}});
+    recorder.connect_to_producer (pass_through);
+    mh_sampler.sample (0., &log_likelihood, &perturb, 1000);
+    std::cout << "With log likelihood consumer:" << std::endl;
+    print_requests (mh_sampler);
+    recorder.print ();
+
+    SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+    mh_sampler.sample (0., &log_likelihood, &perturb, 1000);
+    std::cout << "With acceptance ratio:" << std::endl;
+    print_requests (mh_sampler);
+    recorder.print ();
+    std::cout << "  Number of samples: " << count_samples.get() << std::endl;
+  }
+
+  // A consumer that does not declare what it uses gets everything:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    KeyRecorder recorder (std::nullopt);
+    recorder.connect_to_producer (mh_sampler);
+    mh_sampler.sample_chains ({0., 1.}, &log_likelihood, &perturb_chain, 100);
+    std::cout << "Undeclared keys:" << std::endl;
+    print_requests (mh_sampler);
+    recorder.print ();
+  }
+
+  // The chain number is only provided if someone wants it:
+  for (const bool want_chain_number : {false, true})
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+      KeyRecorder recorder (want_chain_number ?
+                            std::vector<SampleFlow::AuxiliaryData::Key> {SampleFlow::AuxiliaryData::chain_number} :
+                            std::vector<SampleFlow::AuxiliaryData::Key> {});
+      recorder.connect_to_producer (mh_sampler);
+      mh_sampler.sample_chains ({0., 1.}, &log_likelihood, &perturb_chain, 100);
+      std::cout << "Chains, chain number " << (want_chain_number ? "requested:" : "not requested:")
+                << std::endl;
+      recorder.print ();
+    }
+
+  // The samples and the statistics computed from them do not depend on
+  // which entries are attached:
+  {
+    std::vector<SampleType> means;
+    std::vector<double>     acceptance_ratios;
+    for (const bool declare_keys : {false, true})
+      {
+        SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+        SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+        mean_value.connect_to_producer (mh_sampler);
+        SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+        acceptance_ratio.connect_to_producer (mh_sampler);
+
+        std::optional<KeyRecorder> recorder;
+        if (declare_keys == false)
+          {
+            recorder.emplace (std::nullopt);
+            recorder->connect_to_producer (mh_sampler);
+          }
+
+        mh_sampler.sample_chains ({0., 1.}, &log_likelihood, &perturb_chain, 1000);
+        means.push_back (mean_value.get());
+        acceptance_ratios.push_back (acceptance_ratio.get());
+      }
+    std::cout << "Same mean value: " << (means[0] == means[1]) << std::endl;
+    std::cout << "Same acceptance ratio: " << (acceptance_ratios[0] == acceptance_ratios[1])
+              << std::endl;
+  }
+}
@@ -0,0 +1,117 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check MetropolisHastings::Parameters::grain_size: Run many more chains
+// than there are threads, with a likelihood whose cost differs
+// substantially between samples, once with each chain run to completion
+// by one task and once with chains split into pieces of a few steps that
+// idle threads can steal. Each chain needs to produce the same samples
+// either way, also if repeated samples are compressed.
+
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/thread_pool.h>
+#else
+#  include <future>
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+// A Gaussian with mean one. Samples in the right tail take much longer
+// to evaluate than others.
+double log_likelihood (const SampleType &x)
+{
+  if (x > 1.5)
+    std::this_thread::sleep_for (std::chrono::microseconds(50));
+  return -0.5 * (x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 12;
+  std::vector<SampleType> starting_points;
+  for (unsigned int c=0; c<n_chains; ++c)
+    starting_points.push_back (0.25*c);
+
+  const auto thread_pool = std::make_shared<SampleFlow::ThreadPool>(3);
+
+  for (const bool compress : {false, true})
+    {
+      // For each grain size, the samples of each chain along with the
+      // number of steps each of them stands for:
+      std::vector<std::vector<std::pair<SampleType,std::size_t>>> chains[2];
+      for (unsigned int run=0; run<2; ++run)
+        {
+          chains[run].resize (n_chains);
+
+          SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+          parameters.random_seed = 42;
+          parameters.compress_repeated_samples = compress;
+          parameters.grain_size = (run == 0 ? 0 : 7);
+          SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+
+          std::mutex mutex;
+          SampleFlow::Consumers::Action<SampleType>
+          action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+          {
+            const std::size_t chain
+              = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+            const std::size_t *repetitions
+              = aux_data.get_if<std::size_t>(SampleFlow::AuxiliaryData::repetition_count);
+            std::lock_guard<std::mutex> lock (mutex);
+            chains[run][chain].emplace_back (sample, (repetitions != nullptr ? *repetitions : 1));
+          });
+          action.connect_to_producer (mh_sampler);
+
+          mh_sampler.sample_chains (starting_points,
+                                    &log_likelihood,
+                                    &perturb,
+                                    300,
+                                    thread_pool);
+        }
+
+      std::cout << "Compressed samples: " << compress << std::endl;
+      for (unsigned int c=0; c<n_chains; ++c)
+        {
+          std::size_t n_steps = 0;
+          for (const auto &sample : chains[1][c])
+            n_steps += sample.second;
+          std::cout << "  Chain " << c << ": " << n_steps
+                    << " steps, same as without grain size: "
+                    << (chains[0][c] == chains[1][c]) << std::endl;
+        }
+    }
+}
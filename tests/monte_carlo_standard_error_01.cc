@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Estimate the Monte Carlo standard error of the mean of two AR(1)
+// processes x_{n+1} = phi x_n + e_n with standard normal e_n, for which
+// the standard error of the mean of n samples is asymptotically
+// 1/((1-phi) sqrt(n)). Then check that the estimate of two chains merged
+// into one object is that of a chain of twice the length, that samples
+// with repetition counts are treated like repeated samples, and that
+// saving and loading the state works.
+
+
+#include <iostream>
+#include <iomanip>
+#include <valarray>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <random>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/monte_carlo_standard_error.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+int main ()
+{
+  const unsigned int n_samples = 1U << 18;
+  const double phi[2] = {0.5, 0.9};
+
+  std::mt19937 rng;
+  SampleFlow::Testing::NormalDistribution<double> distribution(0., 1.);
+
+  SampleFlow::Consumers::MonteCarloStandardError<SampleType> mcse_1, mcse_2;
+  std::cout << "Before any samples: " << mcse_1.get().size() << std::endl;
+
+  for (SampleFlow::Consumers::MonteCarloStandardError<SampleType> *mcse : {&mcse_1, &mcse_2})
+    {
+      SampleType x = {0, 0};
+      for (unsigned int n=0; n<n_samples; ++n)
+        {
+          for (unsigned int j=0; j<2; ++j)
+            x[j] = phi[j]*x[j] + distribution(rng);
+          mcse->consume (x, SampleFlow::AuxiliaryData());
+        }
+    }
+
+  // Output the ratio of the estimated and the exact standard error for
+  // one chain and for both chains together. The estimate for one chain
+  // is based on 32 batches, and its relative standard deviation is
+  // therefore around 1/sqrt(2*31), i.e., a bit more than ten percent:
+  const std::vector<double> single = mcse_1.get();
+  std::cout << std::setprecision(1) << std::fixed
+            << "One chain: "
+            << single[0] * (1-phi[0]) * std::sqrt(n_samples) << ' '
+            << single[1] * (1-phi[1]) * std::sqrt(n_samples) << std::endl;
+
+  mcse_1.merge (mcse_2);
+  const std::vector<double> both = mcse_1.get();
+  std::cout << "Two chains: "
+            << both[0] * (1-phi[0]) * std::sqrt(2*n_samples) << ' '
+            << both[1] * (1-phi[1]) * std::sqrt(2*n_samples) << std::endl;
+
+  // Now a chain in which samples are repeated a varying number of times,
+  // once fed one copy at a time and once with repetition counts:
+  SampleFlow::Consumers::MonteCarloStandardError<SampleType> individual, repeated;
+  SampleType x = {0, 0};
+  for (unsigned int n=0; n<5000; ++n)
+    {
+      for (unsigned int j=0; j<2; ++j)
+        x[j] = phi[j]*x[j] + distribution(rng);
+
+      const std::size_t n_repetitions = 1 + (n*n)%37;
+      for (unsigned int r=0; r<n_repetitions; ++r)
+        individual.consume (x, SampleFlow::AuxiliaryData());
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      repeated.consume (x, aux_data);
+    }
+
+  const std::vector<double> mcse_individual = individual.get();
+  const std::vector<double> mcse_repeated = repeated.get();
+  std::cout << "Repetitions: "
+            << ((std::abs(mcse_individual[0]-mcse_repeated[0]) < 1e-8*mcse_individual[0])
+                &&
+                (std::abs(mcse_individual[1]-mcse_repeated[1]) < 1e-8*mcse_individual[1]))
+            << std::endl;
+
+  std::vector<char> buffer;
+  mcse_1.save (buffer);
+  SampleFlow::Consumers::MonteCarloStandardError<SampleType> loaded;
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  std::cout << "Loaded: "
+            << (data.empty() && (loaded.get() == both))
+            << std::endl;
+}
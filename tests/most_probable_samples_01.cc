@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the MostProbableSamples consumer: Send samples with a log
+// likelihood attached from several threads, some of them marked as
+// repetitions of the previous sample, and compare the samples kept with
+// the most likely samples computed directly.
+
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/most_probable_samples.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  SampleFlow::Consumers::MostProbableSamples<double> most_probable_samples (5);
+
+  // Create the samples of each thread up front. Every other sample is a
+  // repetition of the previous one:
+  const unsigned int n_threads = 4;
+  std::vector<std::vector<double>> samples (n_threads);
+  std::mt19937 rng;
+  std::normal_distribution<double> normal;
+  for (auto &thread_samples : samples)
+    for (unsigned int i=0; i<20000; ++i)
+      thread_samples.push_back (i%2 == 0 ? normal(rng) : thread_samples.back());
+
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<n_threads; ++t)
+    threads.emplace_back ([&, t]()
+  {
+    for (unsigned int i=0; i<samples[t].size(); ++i)
+      {
+        const double x = samples[t][i];
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -x*x;
+        aux_data[SampleFlow::AuxiliaryData::sample_is_repeated] = (i%2 == 1);
+        most_probable_samples.consume (x, std::move(aux_data));
+      }
+  });
+  for (auto &thread : threads)
+    thread.join ();
+
+  // Compute the five samples with the smallest absolute values directly:
+  std::vector<double> all_samples;
+  for (const auto &thread_samples : samples)
+    for (unsigned int i=0; i<thread_samples.size(); i+=2)
+      all_samples.push_back (thread_samples[i]);
+  std::sort (all_samples.begin(), all_samples.end(),
+             [](const double a, const double b)
+  {
+    return std::abs(a) < std::abs(b);
+  });
+
+  const auto kept = most_probable_samples.get();
+  std::cout << "Number of samples kept: " << kept.size() << std::endl;
+  for (unsigned int i=0; i<kept.size(); ++i)
+    std::cout << (kept[i].first == all_samples[i]) << ' '
+              << (*kept[i].second.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+                  == -all_samples[i]*all_samples[i])
+              << std::endl;
+}
@@ -0,0 +1,149 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that samples of a type that can be moved but not copied can be
+// sent from a producer through filters to a consumer, including one that
+// processes samples on a dedicated thread, and through a fused pipeline;
+// and that a MakeShared filter can be used to distribute such samples to
+// several consumers.
+
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#  include <sampleflow/filters/make_shared.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/last_sample.h>
+#  include <sampleflow/fused_pipeline.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A sample type that holds its data through a handle that can only be
+// moved, the way one would for a large mesh or a buffer on an
+// accelerator.
+struct Mesh
+{
+  std::unique_ptr<std::vector<double>> vertices;
+};
+
+
+class MeshProducer : public SampleFlow::Producer<Mesh>
+{
+  public:
+    void
+    sample (const unsigned int n_samples)
+    {
+      for (unsigned int i=0; i<n_samples; ++i)
+        this->issue_sample (Mesh {std::make_unique<std::vector<double>>(3, i)}, {});
+      this->flush_consumers ();
+    }
+};
+
+
+int main ()
+{
+  // A chain of filters, ending in a consumer that works on a
+  // dedicated thread:
+  {
+    MeshProducer producer;
+
+    SampleFlow::Filters::DiscardFirstN<Mesh> discard (2);
+    discard.connect_to_producer (producer);
+
+    SampleFlow::Filters::TakeEveryNth<Mesh> every_second (2);
+    every_second.connect_to_producer (discard);
+
+    SampleFlow::Filters::Condition<Mesh> condition ([](const Mesh &mesh)
+    {
+      return (*mesh.vertices)[0] < 15;
+    });
+    condition.connect_to_producer (every_second);
+
+    SampleFlow::Consumers::Action<Mesh>
+    action ([&](Mesh mesh, SampleFlow::AuxiliaryData)
+    {
+      std::cout << "Received mesh " << (*mesh.vertices)[0] << std::endl;
+    },
+    false,
+    SampleFlow::ParallelMode::dedicated_thread);
+    action.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 2);
+    action.connect_to_producer (condition);
+
+    producer.sample (20);
+  }
+
+  // The same as a fused pipeline:
+  {
+    MeshProducer producer;
+
+    double sum = 0;
+    SampleFlow::Consumers::Action<Mesh>
+    action ([&](Mesh mesh, SampleFlow::AuxiliaryData)
+    {
+      sum += (*mesh.vertices)[0];
+    });
+
+    auto pipeline = SampleFlow::fuse(producer)
+                    >> SampleFlow::Filters::DiscardFirstN<Mesh> (2)
+                    >> SampleFlow::Filters::TakeEveryNth<Mesh> (2)
+                    >> action;
+
+    producer.sample (20);
+    std::cout << "Sum in fused pipeline: " << sum << std::endl;
+  }
+
+  // Distribute the samples to several consumers via shared handles, and
+  // check that all of them see the same object:
+  {
+    using SharedMesh = std::shared_ptr<const Mesh>;
+
+    MeshProducer producer;
+
+    SampleFlow::Filters::MakeShared<Mesh> make_shared;
+    make_shared.connect_to_producer (producer);
+
+    SampleFlow::Consumers::CountSamples<SharedMesh> count_samples;
+    count_samples.connect_to_producer (make_shared);
+
+    SampleFlow::Consumers::LastSample<SharedMesh> last_sample;
+    last_sample.connect_to_producer (make_shared);
+
+    unsigned int n_same_object = 0;
+    SampleFlow::Consumers::Action<SharedMesh>
+    action ([&](SharedMesh mesh, SampleFlow::AuxiliaryData)
+    {
+      if (mesh == last_sample.get())
+        ++n_same_object;
+    });
+    action.connect_to_producer (make_shared);
+
+    producer.sample (10);
+
+    std::cout << "Number of samples: " << count_samples.get() << std::endl;
+    std::cout << "Samples shared with LastSample: " << n_same_object << std::endl;
+    std::cout << "Last sample: " << (*last_sample.get()->vertices)[0] << std::endl;
+  }
+}
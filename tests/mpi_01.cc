@@ -0,0 +1,192 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the MPI versions of the MetropolisHastings producer and of the
+// CountSamples, MeanValue, CovarianceMatrix, and Histogram consumers:
+// Run a number of chains distributed over all processes, and compare
+// the statistics the distributed consumers compute with the ones
+// computed by the regular consumers when all chains are run on one
+// process. The results must be the same regardless of the number of
+// processes this test is run on, including the case where some
+// processes do not run any chains at all.
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <valarray>
+
+#include <mpi.h>
+
+#include <sampleflow/mpi/producers/metropolis_hastings.h>
+#include <sampleflow/mpi/consumers/count_samples.h>
+#include <sampleflow/mpi/consumers/mean_value.h>
+#include <sampleflow/mpi/consumers/covariance_matrix.h>
+#include <sampleflow/mpi/consumers/histogram.h>
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/filters/component_splitter.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/consumers/covariance_matrix.h>
+#include <sampleflow/consumers/histogram.h>
+
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x[0]*x[0] + 4*x[1]*x[1] + x[0]*x[1])/2;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> distribution(-1,1);
+  SampleType y = x;
+  for (auto &el : y)
+    el += distribution(rng);
+  return {y, 1.};
+}
+
+
+void test (const unsigned int n_chains)
+{
+  std::vector<SampleType> starting_points;
+  for (unsigned int c=0; c<n_chains; ++c)
+    starting_points.push_back (SampleType ({1.*c, -1.*c}));
+
+  SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+
+  // First run all chains distributed across processes:
+  SampleFlow::MPI::Producers::MetropolisHastings<SampleType>
+  mpi_sampler (MPI_COMM_WORLD, parameters);
+
+  SampleFlow::MPI::Consumers::CountSamples<SampleType> mpi_count (MPI_COMM_WORLD);
+  mpi_count.connect_to_producer (mpi_sampler);
+
+  SampleFlow::MPI::Consumers::MeanValue<SampleType> mpi_mean (MPI_COMM_WORLD);
+  mpi_mean.connect_to_producer (mpi_sampler);
+
+  SampleFlow::MPI::Consumers::CovarianceMatrix<SampleType> mpi_covariance (MPI_COMM_WORLD);
+  mpi_covariance.connect_to_producer (mpi_sampler);
+
+  SampleFlow::Filters::ComponentSplitter<SampleType> mpi_component (0);
+  mpi_component.connect_to_producer (mpi_sampler);
+  SampleFlow::MPI::Consumers::Histogram<double> mpi_histogram (MPI_COMM_WORLD, -3, 3, 6);
+  mpi_histogram.connect_to_producer (mpi_component);
+
+  mpi_sampler.sample_chains (starting_points, &log_likelihood, &perturb, 1000);
+
+  // Then run them all on the current process:
+  SampleFlow::Producers::MetropolisHastings<SampleType> sampler (parameters);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count;
+  count.connect_to_producer (sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean;
+  mean.connect_to_producer (sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance;
+  covariance.connect_to_producer (sampler);
+
+  SampleFlow::Filters::ComponentSplitter<SampleType> component (0);
+  component.connect_to_producer (sampler);
+  SampleFlow::Consumers::Histogram<double> histogram (-3, 3, 6);
+  histogram.connect_to_producer (component);
+
+  sampler.sample_chains (starting_points, &log_likelihood, &perturb, 1000);
+
+  // Compute the distributed statistics on all processes, and compare
+  // them with the local ones:
+  const auto mpi_n_samples        = mpi_count.get();
+  const double mpi_ess            = mpi_count.effective_sample_size();
+  const SampleType mpi_mean_value = mpi_mean.get();
+  const auto mpi_covariance_value = mpi_covariance.get();
+  const auto mpi_histogram_value  = mpi_histogram.get();
+
+  const SampleType mean_value     = mean.get();
+  const auto covariance_value     = covariance.get();
+
+  bool same = (mpi_n_samples == count.get())
+              &&
+              (std::fabs(mpi_ess - count.effective_sample_size()) < 1e-10)
+              &&
+              (mpi_mean_value.size() == 2)
+              &&
+              (std::abs(SampleType(mpi_mean_value - mean_value)).max() < 1e-12)
+              &&
+              ((mpi_covariance_value - covariance_value).norm() < 1e-12)
+              &&
+              (mpi_histogram_value == histogram.get());
+
+  // The local statistics on each process must add up to the
+  // distributed ones as well:
+  std::vector<SampleFlow::types::sample_index> n_local_samples = { mpi_count.local().get() };
+  SampleFlow::MPI::sum (n_local_samples, MPI_COMM_WORLD);
+  same = same && (n_local_samples[0] == mpi_n_samples);
+
+  // The distributed sample_chains() function must not change the
+  // parameters of the sampler: Chains run afterwards by the base class's
+  // function are again numbered starting from zero.
+  std::size_t first_chain_number = std::numeric_limits<std::size_t>::max();
+  SampleFlow::Consumers::Action<SampleType>
+  chain_numbers ([&](SampleType, SampleFlow::AuxiliaryData aux_data)
+  {
+    first_chain_number
+      = std::min (first_chain_number,
+                  std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]));
+  });
+  chain_numbers.connect_to_producer (mpi_sampler);
+  mpi_sampler.SampleFlow::Producers::MetropolisHastings<SampleType>::
+  sample_chains (starting_points, &log_likelihood, &perturb, 10);
+  same = same && (first_chain_number == 0);
+
+  // Make sure that the checks succeeded on all processes:
+  std::vector<unsigned int> n_failed = { (same ? 0u : 1u) };
+  SampleFlow::MPI::sum (n_failed, MPI_COMM_WORLD);
+
+  if (SampleFlow::MPI::this_rank (MPI_COMM_WORLD) == 0)
+    {
+      std::cout << "Number of chains: " << n_chains << std::endl;
+      std::cout << "  Number of samples: " << mpi_n_samples << std::endl;
+      std::cout << "  Mean value: " << mpi_mean_value[0] << ' '
+                << mpi_mean_value[1] << std::endl;
+      std::cout << "  Covariance matrix:" << std::endl
+                << mpi_covariance_value << std::endl;
+      std::cout << "  Histogram:" << std::endl;
+      for (const auto &bin : mpi_histogram_value)
+        std::cout << "    [" << std::get<0>(bin) << ',' << std::get<1>(bin)
+                  << "]: " << std::get<2>(bin) << std::endl;
+      std::cout << "  Failed checks: " << n_failed[0] << std::endl;
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+  MPI_Init (&argc, &argv);
+
+  test (7);
+  test (2);
+
+  MPI_Finalize ();
+}
@@ -0,0 +1,119 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the MPI version of the DifferentialEvaluationMetropolisHastings
+// producer: Run one population of chains on each process, with
+// migration between the processes, and check that the islands together
+// sample the right distribution and that migrants are sent. Which
+// migrants arrive where, and when, depends on the relative speed of
+// the processes, and so the samples are not reproducible; we only
+// output quantities that do not depend on this.
+//
+// The chains of each island start far away from each other and from
+// the mode of the distribution, and each island produces a different
+// number of samples, so that the islands finish at different times.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <valarray>
+
+#include <mpi.h>
+
+#include <sampleflow/mpi/producers/differential_evaluation_mh.h>
+#include <sampleflow/mpi/consumers/count_samples.h>
+#include <sampleflow/mpi/consumers/mean_value.h>
+
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x[0]*x[0] + 4*x[1]*x[1] + x[0]*x[1])/2;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> distribution(-0.5,0.5);
+  SampleType y = x;
+  for (auto &el : y)
+    el += distribution(rng);
+  return {y, 1.};
+}
+
+
+SampleType crossover (const SampleType &current_sample,
+                      const SampleType &sample_a,
+                      const SampleType &sample_b,
+                      std::mt19937 &)
+{
+  return SampleType(current_sample + 1.19 * (sample_a - sample_b));
+}
+
+
+int main (int argc, char **argv)
+{
+  MPI_Init (&argc, &argv);
+
+  {
+    const unsigned int rank = SampleFlow::MPI::this_rank (MPI_COMM_WORLD);
+
+    std::vector<SampleType> starting_points;
+    for (unsigned int c=0; c<6; ++c)
+      starting_points.push_back (SampleType ({3.+rank+c, -2.-rank}));
+
+    SampleFlow::MPI::Producers::DifferentialEvaluationMetropolisHastings<SampleType>
+    sampler (MPI_COMM_WORLD, 10, 2);
+
+    SampleFlow::MPI::Consumers::CountSamples<SampleType> count (MPI_COMM_WORLD);
+    count.connect_to_producer (sampler);
+
+    SampleFlow::MPI::Consumers::MeanValue<SampleType> mean (MPI_COMM_WORLD);
+    mean.connect_to_producer (sampler);
+
+    const SampleFlow::types::sample_index n_samples = 60000 + 6000*rank;
+    sampler.sample (starting_points,
+                    &log_likelihood,
+                    &perturb,
+                    &crossover,
+                    1,
+                    n_samples,
+                    false,
+                    42 + rank);
+
+    const auto n_total_samples = count.get();
+    const SampleType mean_value = mean.get();
+
+    std::vector<SampleFlow::types::sample_index> n_sent
+      = { sampler.n_migrants_exchanged().first };
+    SampleFlow::MPI::sum (n_sent, MPI_COMM_WORLD);
+
+    if (rank == 0)
+      {
+        std::cout << "Number of samples: " << n_total_samples << std::endl;
+        std::cout << "Mean value close to zero: "
+                  << (std::abs(mean_value).max() < 0.1 ? "yes" : "no") << std::endl;
+        std::cout << "Migrants sent: "
+                  << (n_sent[0] > 0 ? "yes" : "no") << std::endl;
+      }
+  }
+
+  MPI_Finalize ();
+}
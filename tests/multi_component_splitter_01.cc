@@ -0,0 +1,63 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test the multi-output component splitter: Send the third and the
+// first component of each sample through separate outputs, both one
+// sample at a time and as a batch.
+
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/filters/multi_component_splitter.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+  using ResultType = double;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Filters::MultiComponentSplitter<SampleType> splitter({2,0});
+  splitter.connect_to_producer(range_producer);
+  std::cout << "Outputs: " << splitter.n_outputs() << std::endl;
+
+  SampleFlow::Consumers::StreamOutput<ResultType> stream_output(std::cout);
+  stream_output.connect_to_producer(splitter.output(0));
+
+  SampleFlow::Consumers::MeanValue<ResultType> mean_value;
+  mean_value.connect_to_producer(splitter.output(1));
+
+  const std::vector<SampleType> samples = {{1,10,100}, {2,12,200}, {3,13,300},
+    {4,14,400}, {5,15,500}, {6,16,600}
+  };
+  range_producer.sample (samples);
+  std::cout << "Mean of first component: " << mean_value.get() << std::endl;
+
+  // Now send the samples once more as a batch:
+  splitter.consume_batch (samples,
+                          std::vector<SampleFlow::AuxiliaryData>(samples.size()));
+  std::cout << "Mean of first component: " << mean_value.get() << std::endl;
+}
@@ -0,0 +1,123 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the MultilevelMetropolisHastings producer with three levels whose
+// likelihoods are Gaussians N(mu_l,1) with means 0.5, 0.2, and 0, i.e.,
+// the coarse levels are shifted approximations of the finest level.
+// Check that the samples of the finest level have the right mean and
+// variance, that the mean of the samples of the coarsest level plus the
+// mean values of the corrections of the two finer levels telescopes to
+// the mean of the finest level, and that the result is reproducible.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/multilevel_metropolis_hastings.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = double;
+
+
+std::vector<SampleType>
+check ()
+{
+  SampleFlow::Producers::MultilevelMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed       = 1;
+  parameters.subsampling_rates = {20, 10};
+  parameters.queue_capacity    = 4;
+  SampleFlow::Producers::MultilevelMetropolisHastings<SampleType> mlmcmc (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mlmcmc);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (mlmcmc);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (mlmcmc);
+
+  SampleFlow::Consumers::SampleStore<SampleType> sample_store;
+  sample_store.connect_to_producer (mlmcmc);
+
+  SampleFlow::Consumers::MeanValue<SampleType> coarse_mean_value;
+  coarse_mean_value.connect_to_producer (mlmcmc.level_samples(0));
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_finest_level_samples;
+  count_finest_level_samples.connect_to_producer (mlmcmc.level_samples(2));
+
+  SampleFlow::Consumers::MeanValue<SampleType> correction_1;
+  correction_1.connect_to_producer (mlmcmc.corrections(1));
+
+  SampleFlow::Consumers::MeanValue<SampleType> correction_2;
+  correction_2.connect_to_producer (mlmcmc.corrections(2));
+
+  const std::vector<double> means = {0.5, 0.2, 0};
+  std::vector<std::function<double (const SampleType &)>> log_likelihoods;
+  for (const double mu : means)
+    log_likelihoods.emplace_back ([mu](const SampleType &x)
+  {
+    return -(x-mu)*(x-mu)/2;
+  });
+
+  const SampleFlow::types::sample_index n_samples = 100000;
+  mlmcmc.sample (0.,
+                 log_likelihoods,
+                 [](const SampleType &x, std::mt19937 &rng)
+  {
+    return std::make_pair (x + std::uniform_real_distribution<double>(-1.5, 1.5)(rng),
+                           1.);
+  },
+  n_samples);
+
+  std::cout << "Number of samples correct: "
+            << (count_samples.get() == n_samples) << std::endl
+            << "Number of samples on finest level correct: "
+            << (count_finest_level_samples.get() == n_samples) << std::endl
+            << "Mean value correct: "
+            << (std::fabs(mean_value.get()) < 0.05) << std::endl
+            << "Variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 1) < 0.05) << std::endl
+            << "Coarse mean value correct: "
+            << (std::fabs(coarse_mean_value.get() - 0.5) < 0.05) << std::endl
+            << "Level 1 correction correct: "
+            << (std::fabs(correction_1.get() + 0.3) < 0.05) << std::endl
+            << "Level 2 correction correct: "
+            << (std::fabs(correction_2.get() + 0.2) < 0.05) << std::endl
+            << "Telescoping sum correct: "
+            << (std::fabs(coarse_mean_value.get() + correction_1.get() + correction_2.get()) < 0.05)
+            << std::endl;
+
+  return std::vector<SampleType> (sample_store.begin(), sample_store.end());
+}
+
+
+int main ()
+{
+  const std::vector<SampleType> samples = check ();
+  const std::vector<SampleType> samples_again = check ();
+  std::cout << "Reproducible: " << (samples == samples_again) << std::endl;
+}
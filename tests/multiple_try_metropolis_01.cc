@@ -0,0 +1,133 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the MultipleTryMetropolis producer: Sample a Gamma distribution
+// with shape parameter 3 and scale 1 (mean and variance both equal to 3)
+// using a multiplicative random walk proposal, which is not symmetric and
+// so tests that the ratio of proposal probabilities is correctly taken
+// into account in the weights. Do this with one trial sample per step
+// (i.e., plain Metropolis-Hastings) and with five. Also check the number
+// of likelihood evaluations, and that the function that takes a batch
+// log likelihood produces the same samples as the one that evaluates
+// likelihoods on the thread pool.
+
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/multiple_try_metropolis.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/action.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+std::atomic<unsigned int> n_evaluations (0);
+
+double log_likelihood (const SampleType &x)
+{
+  ++n_evaluations;
+  if (x <= 0)
+    return -std::numeric_limits<double>::infinity();
+  return 2*std::log(x) - x;
+}
+
+
+// Propose y = x*exp(s*z) with z a standard normal random number. Then the
+// ratio of proposal probabilities is x/y.
+std::mt19937 proposal_rng;
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  std::normal_distribution<double> distribution(0, 1.5);
+  const SampleType y = x * std::exp(distribution(proposal_rng));
+  return {y, x/y};
+}
+
+
+std::vector<SampleType>
+check (const unsigned int n_trials, const bool batch)
+{
+  SampleFlow::Producers::MultipleTryMetropolis<SampleType>::Parameters parameters;
+  parameters.n_trials = n_trials;
+  parameters.thread_pool = std::make_shared<SampleFlow::ThreadPool> (4);
+  SampleFlow::Producers::MultipleTryMetropolis<SampleType> mtm_sampler (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mtm_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (mtm_sampler);
+
+  SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (mtm_sampler);
+
+  std::vector<SampleType> samples;
+  SampleFlow::Consumers::Action<SampleType> store_samples
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &)
+  {
+    samples.push_back (x);
+  });
+  store_samples.connect_to_producer (mtm_sampler);
+
+  const SampleFlow::types::sample_index n_samples = 200000;
+  proposal_rng.seed (1);
+  n_evaluations = 0;
+  if (batch)
+    mtm_sampler.sample (1.,
+                        [](std::span<const SampleType> samples,
+                           std::span<double> log_likelihoods)
+    {
+      for (std::size_t i=0; i<samples.size(); ++i)
+        log_likelihoods[i] = log_likelihood (samples[i]);
+    },
+    &perturb,
+    n_samples);
+  else
+    mtm_sampler.sample (1., &log_likelihood, &perturb, n_samples);
+
+  std::cout << "n_trials=" << n_trials << (batch ? " (batch)" : "") << ':' << std::endl
+            << "  mean value correct: "
+            << (std::fabs(mean_value.get() - 3) < 0.05) << std::endl
+            << "  variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 3) < 0.15) << std::endl
+            << "  number of evaluations per step: "
+            << (n_evaluations - 1.) / n_samples << std::endl;
+
+  return samples;
+}
+
+
+int main ()
+{
+  check (1, false);
+  const std::vector<SampleType> samples = check (5, false);
+  const std::vector<SampleType> batch_samples = check (5, true);
+  std::cout << "Same samples with batch likelihood: "
+            << (samples == batch_samples) << std::endl;
+}
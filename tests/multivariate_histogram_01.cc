@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the MultivariateHistogram consumer: Compute the joint histogram
+// of three of the four components of normally distributed samples, check
+// the counts in the cells against direct counts, and compare the binned
+// kernel density estimate with the exact density of the smoothed
+// distribution. Then check save(), load(), and merge().
+
+
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/multivariate_histogram.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::mt19937 rng;
+  std::normal_distribution<double> normal;
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<50000; ++i)
+    samples.push_back ({ normal(rng), 100+normal(rng), normal(rng), normal(rng) });
+
+  const std::vector<unsigned int> components = {0, 2, 3};
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  SampleFlow::Consumers::MultivariateHistogram<SampleType>
+  histogram (components, {0.5, 0.5, 0.5});
+  histogram.connect_to_producer (range_producer);
+  range_producer.sample_in_parallel (samples);
+
+  // Check the counts in all cells:
+  const auto cells = histogram.get();
+  SampleFlow::types::sample_index n_samples = 0;
+  bool cells_correct = true;
+  for (const auto &cell : cells)
+    {
+      n_samples += std::get<2>(cell);
+
+      SampleFlow::types::sample_index n = 0;
+      for (const auto &sample : samples)
+        {
+          bool inside = true;
+          for (unsigned int d=0; d<3; ++d)
+            if ((sample[components[d]] < std::get<0>(cell)[d])
+                ||
+                (sample[components[d]] >= std::get<1>(cell)[d]))
+              inside = false;
+          if (inside)
+            ++n;
+        }
+      if (n != std::get<2>(cell))
+        cells_correct = false;
+    }
+  std::cout << "Samples counted: " << n_samples << ' ' << cells_correct << std::endl;
+
+  // The kernel density estimate with bandwidth b of samples drawn from a
+  // standard normal distribution, binned into cells of width h,
+  // approximates a normal distribution with variance 1+b^2+h^2/12 in each
+  // direction:
+  const double b = 0.5;
+  const double variance = 1 + b*b + 0.5*0.5/12;
+  const std::vector<std::vector<double>> points = {{0, 0, 0}, {1, 0, -1}, {0, 2, 0}};
+  const auto densities = histogram.get_density (points, {b, b, b});
+  for (unsigned int p=0; p<points.size(); ++p)
+    {
+      double r2 = 0;
+      for (const double x : points[p])
+        r2 += x*x;
+      const double exact = std::pow (2*std::numbers::pi*variance, -1.5)
+                           * std::exp (-r2/(2*variance));
+      std::cout << "Density ratio at point " << p << ": "
+                << std::round(100*densities[p]/exact)/100 << std::endl;
+    }
+
+  // Save, load, and merge:
+  std::vector<char> buffer;
+  histogram.save (buffer);
+  SampleFlow::Consumers::MultivariateHistogram<SampleType>
+  copy (components, {0.5, 0.5, 0.5});
+  std::span<const char> input (buffer);
+  copy.load (input);
+  std::cout << "Loaded: " << (copy.get() == cells) << ' ' << input.size() << std::endl;
+
+  copy.merge (histogram);
+  const auto merged = copy.get();
+  bool doubled = (merged.size() == cells.size());
+  for (unsigned int i=0; doubled && i<cells.size(); ++i)
+    doubled = (std::get<2>(merged[i]) == 2*std::get<2>(cells[i]));
+  std::cout << "Merged: " << doubled << std::endl;
+}
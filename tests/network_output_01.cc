@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Consumers::NetworkOutput and Producers::NetworkInput: Two senders,
+// each on their own thread, stream a chain in which every sample is
+// repeated a few times (as if proposals had been rejected) to a receiver
+// in the same process. Check that all samples arrive in order, along with
+// their auxiliary data, and that compression made the data smaller. Also
+// check that frames of data that do not compress are sent as they are.
+
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/network_stream.h>
+#  include <sampleflow/producers/network_input.h>
+#  include <sampleflow/consumers/network_output.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::vector<double>;
+
+
+// A producer that sends the samples of one chain.
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const unsigned int chain,
+            const unsigned int n_samples)
+    {
+      for (unsigned int i=0; i<n_samples; ++i)
+        {
+          SampleFlow::AuxiliaryData aux_data;
+          aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -0.5*(i/3);
+          this->issue_sample ({1.*chain, 1. + 0.001*(i/3)}, aux_data);
+        }
+      this->flush_consumers ();
+    }
+};
+
+
+int main ()
+{
+  const unsigned int n_samples = 5000;
+
+  SampleFlow::Producers::NetworkInput<SampleType> network_input (0, 2);
+
+  std::map<unsigned int, std::vector<double>> received;
+  SampleFlow::Consumers::Action<SampleType> action
+  ([&received](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+  {
+    received[static_cast<unsigned int>(sample[0])].push_back (sample[1]);
+    received[static_cast<unsigned int>(sample[0]) + 10]
+    .push_back (*aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood));
+  });
+  action.connect_to_producer (network_input);
+
+  std::vector<std::uint64_t> bytes_sent (2);
+  std::vector<std::thread>   senders;
+  for (unsigned int c=0; c<2; ++c)
+    senders.emplace_back ([&, c]()
+  {
+    Issuer issuer;
+    SampleFlow::Consumers::NetworkOutput<SampleType>
+    network_output ("localhost", network_input.port(), 2,
+    {
+      {
+        SampleFlow::AuxiliaryData::relative_log_likelihood,
+        SampleFlow::ChainFileFormat::ColumnType::floating_point
+      }
+    },
+    128, SampleFlow::NetworkStream::Compression::delta_zero_run, 2);
+    network_output.connect_to_producer (issuer);
+    issuer.sample (c, n_samples);
+    bytes_sent[c] = network_output.n_bytes_sent();
+  });
+
+  network_input.sample ();
+  for (std::thread &sender : senders)
+    sender.join();
+
+  for (unsigned int c=0; c<2; ++c)
+    {
+      bool correct = (received[c].size() == n_samples) && (received[c+10].size() == n_samples);
+      for (unsigned int i=0; correct && (i<n_samples); ++i)
+        correct = (received[c][i] == 1. + 0.001*(i/3)) && (received[c+10][i] == -0.5*(i/3));
+      std::cout << "Chain " << c << ": " << received[c].size()
+                << " samples, correct: " << correct
+                << ", compressed: " << (bytes_sent[c] < n_samples * 3 * sizeof(double))
+                << std::endl;
+    }
+
+  // Then check a frame with random bytes:
+  {
+    std::mt19937 random_number_generator;
+    std::vector<char> records (24*100);
+    for (char &c : records)
+      c = static_cast<char>(random_number_generator());
+
+    const std::vector<char> frame
+      = SampleFlow::NetworkStream::encode_frame (records, 24,
+                                                 SampleFlow::NetworkStream::Compression::delta_zero_run);
+    SampleFlow::NetworkStream::FrameHeader frame_header;
+    std::memcpy (&frame_header, frame.data(), sizeof(frame_header));
+
+    std::vector<char> decoded;
+    SampleFlow::NetworkStream::decode_payload (frame_header,
+                                               std::span<const char>(frame).subspan(sizeof(frame_header)),
+                                               24, decoded);
+    std::cout << "Random data: compression " << frame_header.compression
+              << ", records " << frame_header.n_records
+              << ", round trip: " << (decoded == records) << std::endl;
+  }
+}
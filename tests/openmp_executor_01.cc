@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check OpenMP::Executor: When made the default pool, the chains of
+// MetropolisHastings::sample_chains() need to run as OpenMP tasks if the
+// function is called from within a parallel region, and on the calling
+// thread otherwise. In both cases, the chains need to be the same as with
+// the built-in pool.
+
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/openmp/executor.h>
+
+#include <omp.h>
+
+using SampleType = double;
+
+
+std::atomic<bool> everything_in_parallel (true);
+
+double log_likelihood (const SampleType &x)
+{
+  if (omp_in_parallel() == false)
+    everything_in_parallel = false;
+  return -(x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 4;
+  const std::vector<SampleType> starting_points = {-1., 0., 1., 2.};
+
+  SampleFlow::ThreadPool::set_default_pool
+  (std::make_shared<SampleFlow::ThreadPool>(std::make_shared<SampleFlow::OpenMP::Executor>()));
+
+  std::vector<std::vector<SampleType>> chains[3];
+  for (unsigned int run=0; run<3; ++run)
+    {
+      chains[run].resize (n_chains);
+      everything_in_parallel = true;
+
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const std::size_t chain
+          = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+        std::lock_guard<std::mutex> lock (mutex);
+        chains[run][chain].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      if (run == 0)
+        mh_sampler.sample_chains (starting_points,
+                                  &log_likelihood,
+                                  &perturb,
+                                  1000,
+                                  std::make_shared<SampleFlow::ThreadPool>(2));
+      else if (run == 1)
+        {
+          mh_sampler.sample_chains (starting_points,
+                                    &log_likelihood,
+                                    &perturb,
+                                    1000);
+          std::cout << "Run outside of a parallel region: all evaluations in parallel region: "
+                    << everything_in_parallel.load() << std::endl;
+        }
+      else
+        {
+#pragma omp parallel num_threads(3)
+#pragma omp single
+          {
+            std::cout << "Threads: " << SampleFlow::ThreadPool::default_pool()->n_threads() << std::endl;
+            mh_sampler.sample_chains (starting_points,
+                                      &log_likelihood,
+                                      &perturb,
+                                      1000);
+          }
+          std::cout << "Run inside of a parallel region: all evaluations in parallel region: "
+                    << everything_in_parallel.load() << std::endl;
+        }
+    }
+
+  for (unsigned int run=1; run<3; ++run)
+    for (unsigned int c=0; c<n_chains; ++c)
+      std::cout << "Run " << run << ", chain " << c << ": " << chains[run][c].size()
+                << " samples, same as with built-in pool: "
+                << (chains[0][c] == chains[run][c]) << std::endl;
+}
@@ -0,0 +1,97 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the ParallelStage filter: Run a (slow) conversion on the worker
+// threads of a thread pool and verify that the samples arrive downstream
+// in the order in which they were generated even though later samples
+// are processed faster than earlier ones. Also check that a Condition
+// filter that drops some samples works, and that the number of samples in
+// flight does not exceed the given queue size.
+
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/filters/conversion.h>
+#  include <sampleflow/filters/parallel_stage.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const auto thread_pool = std::make_shared<SampleFlow::ThreadPool>(4);
+
+  {
+    std::atomic<int> n_in_flight (0);
+    std::atomic<int> max_n_in_flight (0);
+
+    SampleFlow::Producers::Range<int> range_producer;
+
+    SampleFlow::Filters::ParallelStage<int,double>
+    stage (SampleFlow::Filters::Conversion<int,double>([&](const int &i)
+    {
+      const int n = ++n_in_flight;
+      int max_n = max_n_in_flight.load();
+      while ((n > max_n) && !max_n_in_flight.compare_exchange_weak (max_n, n))
+        ;
+
+      std::this_thread::sleep_for (std::chrono::milliseconds(20-i));
+
+      --n_in_flight;
+      return 1.5*i;
+    }),
+    6, thread_pool);
+    stage.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::StreamOutput<double> stream_output (std::cout);
+    stream_output.connect_to_producer (stage);
+
+    range_producer.sample (std::views::iota(0,20));
+
+    std::cout << "At most 6 samples in flight: "
+              << (max_n_in_flight.load() <= 6 ? "yes" : "no")
+              << std::endl;
+  }
+
+  {
+    SampleFlow::Producers::Range<int> range_producer;
+
+    SampleFlow::Filters::ParallelStage<int,int>
+    stage (SampleFlow::Filters::Condition<int>([](const int &i,
+                                                  const SampleFlow::AuxiliaryData &)
+    {
+      std::this_thread::sleep_for (std::chrono::milliseconds(i % 3));
+      return (i % 3 == 0);
+    }),
+    3, thread_pool);
+    stage.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::StreamOutput<int> stream_output (std::cout);
+    stream_output.connect_to_producer (stage);
+
+    range_producer.sample (std::views::iota(0,20));
+  }
+}
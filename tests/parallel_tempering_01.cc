@@ -0,0 +1,96 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the ParallelTempering producer with a distribution that has two
+// well-separated modes at -5 and +5. A Metropolis-Hastings chain with
+// proposals the size of the modes never leaves the mode it starts in,
+// but with parallel tempering, the cold replica has to visit both modes
+// about equally often. Also check that the producer for the samples of
+// all replicas issues the samples of every replica, and that swaps are
+// accepted between all pairs of adjacent replicas.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/parallel_tempering.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return std::log (std::exp(-(x-5)*(x-5)/(2*0.25)) + std::exp(-(x+5)*(x+5)/(2*0.25)));
+}
+
+
+int main ()
+{
+  SampleFlow::Producers::ParallelTempering<SampleType>::Parameters parameters;
+  parameters.temperatures = {1, 3, 9, 27, 81};
+  parameters.thread_pool  = std::make_shared<SampleFlow::ThreadPool> (3);
+  SampleFlow::Producers::ParallelTempering<SampleType> pt_sampler (parameters);
+
+  // Scale the proposals with the width of the tempered distributions:
+  const auto propose = [&](const SampleType &x, const std::size_t replica, std::mt19937 &rng)
+  {
+    std::normal_distribution<double> distribution (0, 0.5 * std::sqrt(parameters.temperatures[replica]));
+    return std::pair<SampleType,double> (x + distribution(rng), 1.0);
+  };
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (pt_sampler);
+
+  unsigned int n_positive = 0;
+  SampleFlow::Consumers::Action<SampleType> count_positive
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &)
+  {
+    if (x > 0)
+      ++n_positive;
+  });
+  count_positive.connect_to_producer (pt_sampler);
+
+  SampleFlow::Consumers::CountSamples<SampleType> n_replica_samples;
+  n_replica_samples.connect_to_producer (pt_sampler.replica_samples());
+
+  const SampleFlow::types::sample_index n_samples = 100000;
+  pt_sampler.sample (-5, &log_likelihood, propose, n_samples);
+
+  std::cout << "Fraction of samples in the positive mode reasonable: "
+            << (std::fabs (1. * n_positive / n_samples - 0.5) < 0.1) << std::endl;
+  std::cout << "Mean value close to zero: "
+            << (std::fabs (mean_value.get()) < 1) << std::endl;
+  std::cout << "Number of replica samples: "
+            << n_replica_samples.get() << std::endl;
+
+  const std::vector<double> swap_ratios = pt_sampler.get_swap_acceptance_ratios();
+  std::cout << "Number of swap acceptance ratios: " << swap_ratios.size() << std::endl;
+  bool swaps_accepted = true;
+  for (const double ratio : swap_ratios)
+    if ((ratio <= 0.05) || (ratio >= 1))
+      swaps_accepted = false;
+  std::cout << "Swaps accepted between all pairs: " << swaps_accepted << std::endl;
+}
@@ -0,0 +1,89 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the PerChainDiscardFirstN and PerChainTakeEveryNth filters with
+// samples from three interleaved chains, some of which carry repetition
+// counts.
+
+
+#include <iostream>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/per_chain_discard_first_n.h>
+#  include <sampleflow/filters/per_chain_take_every_nth.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer that sends its argument downstream, tagged with a chain
+// number and possibly a repetition count.
+class Issuer : public SampleFlow::Producer<int>
+{
+  public:
+    void
+    sample (const int sample, const std::size_t chain, const std::size_t n_repetitions = 1)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::chain_number] = chain;
+      if (n_repetitions != 1)
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      this->issue_sample (sample, aux_data);
+    }
+};
+
+
+int main ()
+{
+  Issuer issuer;
+
+  // Discard the first four samples of each chain, then take every third
+  // of the remaining ones:
+  SampleFlow::Filters::PerChainDiscardFirstN<int> burn_in (4, 3);
+  burn_in.connect_to_producer (issuer);
+
+  SampleFlow::Filters::PerChainTakeEveryNth<int> every_3rd (3, 3);
+  every_3rd.connect_to_producer (burn_in);
+
+  SampleFlow::Consumers::Action<int> output ([](const int sample,
+                                                const SampleFlow::AuxiliaryData &aux_data)
+  {
+    std::cout << sample
+              << " chain=" << *aux_data.get_if<std::size_t>(SampleFlow::AuxiliaryData::chain_number)
+              << " repetitions=" << aux_data.n_repetitions()
+              << std::endl;
+  });
+  output.connect_to_producer (every_3rd);
+
+  // Interleave the chains. Sample 100*c+i is the ith sample of chain c.
+  // Chains 0 and 1 send samples one at a time. Chain 2 sends samples
+  // with a repetition count of three, the second of which straddles the
+  // end of its burn-in period:
+  for (int i=0; i<12; ++i)
+    {
+      issuer.sample (i, 0);
+      issuer.sample (100+i, 1);
+      if (i < 4)
+        issuer.sample (200+i, 2, 3);
+    }
+
+  for (std::size_t c=0; c<3; ++c)
+    std::cout << "Chain " << c
+              << ": burn-in samples seen=" << burn_in.n_samples_seen (c)
+              << ", samples seen after burn-in=" << every_3rd.n_samples_seen (c)
+              << std::endl;
+}
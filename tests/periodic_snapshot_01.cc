@@ -0,0 +1,85 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check PeriodicSnapshot: While a producer sends samples to a few
+// consumers, a PeriodicSnapshot object writes their state to a file in
+// the background. Loading the last snapshot into new consumer objects
+// has to reproduce the results of the original consumers.
+
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/periodic_snapshot.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  SampleFlow::Producers::Range<double> range_producer;
+
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::MeanValue<double> mean_value;
+  mean_value.connect_to_producer (range_producer);
+
+  {
+    SampleFlow::PeriodicSnapshot snapshot ("periodic_snapshot_01.snapshot",
+                                           std::chrono::milliseconds(10));
+    snapshot.add (count_samples);
+    snapshot.add (mean_value);
+
+    // Send samples for a while, so that the timer thread gets to take
+    // snapshots while samples are processed:
+    for (unsigned int round=0; round<10; ++round)
+      {
+        std::vector<double> samples;
+        for (unsigned int i=0; i<100; ++i)
+          samples.push_back (100*round + i);
+        range_producer.sample (samples);
+        std::this_thread::sleep_for (std::chrono::milliseconds(5));
+      }
+
+    // Make sure that the file contains the final state:
+    snapshot.snapshot_now ();
+    snapshot.wait ();
+    std::cout << "Snapshots were written: "
+              << (snapshot.n_snapshots_written() > 0) << std::endl;
+  }
+
+  SampleFlow::Consumers::CountSamples<double> restored_count_samples;
+  SampleFlow::Consumers::MeanValue<double>    restored_mean_value;
+  SampleFlow::PeriodicSnapshot::load ("periodic_snapshot_01.snapshot",
+                                      restored_count_samples,
+                                      restored_mean_value);
+
+  std::cout << "Number of samples: " << count_samples.get()
+            << ' ' << restored_count_samples.get() << std::endl;
+  std::cout << "Mean value: " << mean_value.get()
+            << ' ' << restored_mean_value.get() << std::endl;
+
+  std::remove ("periodic_snapshot_01.snapshot");
+}
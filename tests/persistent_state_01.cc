@@ -0,0 +1,200 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that MeanValue, CovarianceMatrix, CountSamples, and Histogram
+// objects can keep their state in memory-mapped files: Fork a process
+// that processes some samples and then terminates without running any
+// destructors, as if it had crashed, and check that new objects in the
+// original process pick up the state from the files. Let them process
+// more samples, and check that the state is again restored after they
+// have been destroyed regularly. Finally, check that the PersistentState
+// class falls back to the previous state if the current one is broken.
+
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/persistent_state.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+const std::string filename_base = "persistent_state_01-" + std::to_string(getpid());
+
+
+// A set of consumers fed by two producers, one of vectors and one of
+// their first components.
+struct Consumers
+{
+  SampleFlow::Producers::Range<SampleType> vector_producer;
+  SampleFlow::Producers::Range<double>     scalar_producer;
+
+  SampleFlow::Consumers::MeanValue<SampleType>        mean_value;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  SampleFlow::Consumers::CountSamples<SampleType>     count_samples;
+  SampleFlow::Consumers::Histogram<double>            histogram {-1, 1, 10};
+
+  Consumers ()
+  {
+    mean_value.connect_to_producer (vector_producer);
+    covariance_matrix.connect_to_producer (vector_producer);
+    count_samples.connect_to_producer (vector_producer);
+    histogram.connect_to_producer (scalar_producer);
+  }
+
+  // Let all consumers keep their state in files, and return how many of
+  // them restored a state from there:
+  unsigned int keep_state_in_files ()
+  {
+    return (mean_value.keep_state_in_file (filename_base + ".mean", 100)
+            + covariance_matrix.keep_state_in_file (filename_base + ".covariance", 100)
+            + count_samples.keep_state_in_file (filename_base + ".count", 100)
+            + histogram.keep_state_in_file (filename_base + ".histogram", 100));
+  }
+
+  // Send the samples with indices [begin,end) in chunks of 100:
+  void sample (const unsigned int begin, const unsigned int end)
+  {
+    for (unsigned int chunk=begin; chunk<end; chunk+=100)
+      {
+        std::vector<SampleType> samples;
+        std::vector<double>     scalars;
+        for (unsigned int i=chunk; i<chunk+100; ++i)
+          {
+            samples.emplace_back (SampleType {{std::sin(i), std::cos(3.*i)}});
+            scalars.push_back (samples.back()[0]);
+          }
+        vector_producer.sample (samples);
+        scalar_producer.sample (scalars);
+      }
+  }
+};
+
+
+// Output whether the states of two sets of consumers are the same:
+void compare (const Consumers &restored, const Consumers &reference)
+{
+  std::cout << "  mean value same: "
+            << ((restored.mean_value.get() - reference.mean_value.get()).norm() < 1e-12)
+            << std::endl
+            << "  covariance matrix same: "
+            << ((restored.covariance_matrix.get() - reference.covariance_matrix.get()).norm() < 1e-12)
+            << std::endl
+            << "  number of samples same: "
+            << (restored.count_samples.get() == reference.count_samples.get())
+            << " (" << restored.count_samples.get() << ')' << std::endl
+            << "  histogram same: "
+            << (restored.histogram.get() == reference.histogram.get())
+            << std::endl;
+}
+
+
+
+int main ()
+{
+  // Process 1000 samples in another process that then dies:
+  const pid_t child = fork();
+  if (child == 0)
+    {
+      Consumers consumers;
+      consumers.keep_state_in_files ();
+      consumers.sample (0, 1000);
+      _exit (0);
+    }
+  waitpid (child, nullptr, 0);
+
+  Consumers reference;
+  reference.sample (0, 1000);
+
+  // Restore the state and continue with 1000 more samples:
+  {
+    Consumers consumers;
+    std::cout << "States restored after crash: " << consumers.keep_state_in_files () << std::endl;
+    compare (consumers, reference);
+
+    consumers.sample (1000, 2000);
+  }
+  reference.sample (1000, 2000);
+
+  {
+    Consumers consumers;
+    std::cout << "States restored after regular end: " << consumers.keep_state_in_files () << std::endl;
+    compare (consumers, reference);
+  }
+
+  for (const std::string suffix : {".mean", ".covariance", ".count", ".histogram"})
+    std::remove ((filename_base + suffix).c_str());
+
+  // Now check PersistentState directly with states of growing size:
+  const std::string filename = filename_base + ".state";
+  {
+    std::vector<char> state;
+    SampleFlow::PersistentState persistent_state (filename,
+                                                  [&state](std::vector<char> &buffer)
+    {
+      buffer.insert (buffer.end(), state.begin(), state.end());
+    });
+    std::cout << "New file has no state: " << persistent_state.stored_state().empty() << std::endl;
+
+    for (unsigned int i=1; i<=5; ++i)
+      {
+        state.assign (1000*i*i, 'a' + i);
+        persistent_state.write ();
+      }
+    std::cout << "Epoch: " << persistent_state.epoch() << std::endl;
+  }
+
+  // Overwrite part of the last state, which consists of the letter 'f':
+  {
+    std::fstream file (filename, std::ios::in | std::ios::out | std::ios::binary);
+    const std::string contents ((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+    file.seekp (contents.find (std::string(100, 'f')) + 100);
+    file.write ("broken", 6);
+  }
+
+  {
+    SampleFlow::PersistentState persistent_state (filename,
+                                                  [](std::vector<char> &)
+    {});
+    const std::vector<char> state = persistent_state.stored_state();
+    std::cout << "Epoch after restart: " << persistent_state.epoch() << std::endl
+              << "Fell back to previous state: "
+              << ((state.size() == 16000) && (state.front() == 'e') && (state.back() == 'e'))
+              << std::endl;
+  }
+  std::remove (filename.c_str());
+}
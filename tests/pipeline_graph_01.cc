@@ -0,0 +1,94 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Producer::describe_pipeline(): The graph needs to list the
+// producer, the filters, and the consumers downstream of it with their
+// parallel modes and queue sizes, and an edge for each connection with
+// the number of samples sent through it. Consumers that are destroyed
+// need to disappear from the graph.
+//
+// The edges only count samples if SAMPLEFLOW_WITH_INSTRUMENTATION is
+// defined, which only takes effect if the header files are included, and
+// so this test does not use the SampleFlow module.
+
+
+#define SAMPLEFLOW_WITH_INSTRUMENTATION
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <sampleflow/producers/range.h>
+#include <sampleflow/filters/discard_first_n.h>
+#include <sampleflow/filters/take_every_nth.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/consumers/mean_value.h>
+#include <sampleflow/pipeline_graph.h>
+
+
+// Print the graph without the throughputs, which depend on timing.
+void print (const SampleFlow::PipelineGraph::Graph &graph)
+{
+  SampleFlow::PipelineGraph::Graph dot_graph = graph;
+  for (auto &edge : dot_graph.edges)
+    {
+      std::cout << "Edge with " << edge.n_samples << " samples, throughput known: "
+                << (edge.samples_per_second > 0) << std::endl;
+      edge.n_samples = 0;
+    }
+  dot_graph.write_dot (std::cout);
+}
+
+
+int main ()
+{
+  std::vector<double> samples;
+  for (unsigned int i=0; i<100; ++i)
+    samples.push_back (i);
+
+  SampleFlow::Producers::Range<double> range_producer;
+
+  SampleFlow::Filters::DiscardFirstN<double> discard_first_n (10);
+  discard_first_n.connect_to_producer (range_producer);
+
+  SampleFlow::Filters::TakeEveryNth<double> take_every_nth (3);
+  take_every_nth.connect_to_producer (discard_first_n);
+
+  SampleFlow::Consumers::MeanValue<double> mean_value;
+  mean_value.connect_to_producer (take_every_nth);
+
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 16);
+  count_samples.connect_to_producer (range_producer);
+
+  {
+    SampleFlow::Consumers::CountSamples<double> temporary_count;
+    temporary_count.connect_to_producer (discard_first_n);
+    std::cout << "With a temporary consumer: "
+              << range_producer.describe_pipeline().nodes.size() << " nodes" << std::endl;
+  }
+
+  range_producer.sample (samples);
+  std::cout << "Mean value: " << mean_value.get() << std::endl;
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+
+  print (range_producer.describe_pipeline());
+
+  // Describing the pipeline starting at a filter only covers what is
+  // downstream of it:
+  std::cout << "From a filter:" << std::endl;
+  print (discard_first_n.describe_pipeline());
+}
@@ -0,0 +1,77 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the PipelineStage filter: Run a (slow) conversion on the thread
+// of a pipeline stage and verify that the samples arrive downstream
+// in the order in which they were generated, and that the conversion
+// did not run on the thread that generated the samples. Then do the same
+// with a stage that uses a thread pool.
+
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/conversion.h>
+#  include <sampleflow/filters/pipeline_stage.h>
+#  include <sampleflow/consumers/stream_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+void test (const SampleFlow::ParallelMode parallel_mode)
+{
+  const std::thread::id sampling_thread = std::this_thread::get_id();
+  std::atomic<bool> converted_on_sampling_thread (false);
+
+  SampleFlow::Producers::Range<int> range_producer;
+
+  SampleFlow::Filters::PipelineStage<int,double>
+  stage (SampleFlow::Filters::Conversion<int,double>([&](const int &i)
+  {
+    if (std::this_thread::get_id() == sampling_thread)
+      converted_on_sampling_thread = true;
+
+    // Make later samples faster to process than early ones, to provoke
+    // a different order if the stage did not preserve it:
+    std::this_thread::sleep_for (std::chrono::milliseconds(10-i));
+    return 1.5*i;
+  }),
+  4);
+  if (parallel_mode != SampleFlow::ParallelMode::dedicated_thread)
+    stage.set_parallel_mode (parallel_mode, 4);
+  stage.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::StreamOutput<double> stream_output (std::cout);
+  stream_output.connect_to_producer (stage);
+
+  range_producer.sample (std::views::iota(0,10));
+
+  std::cout << "Converted on sampling thread: "
+            << (converted_on_sampling_thread ? "yes" : "no")
+            << std::endl;
+}
+
+
+int main ()
+{
+  test (SampleFlow::ParallelMode::dedicated_thread);
+  test (SampleFlow::ParallelMode::asynchronous);
+}
@@ -0,0 +1,181 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the PosteriorPredictive consumer: Compute the predictions of a
+// forward model for every third of a set of samples, once with a model
+// for one sample at a time and once with a model for batches, on a pool
+// with a small queue so that the sending thread has to wait for the pool,
+// and compare the statistics with those computed directly from the
+// predictions. Also check that the forward model is not evaluated on the
+// thread that sends the samples.
+//
+// The quantile estimates of a t-digest depend on the order in which it
+// sees the predictions, which on a pool differs from run to run. They
+// are therefore checked in a third run in which all predictions are
+// computed in one batch, and so reach the digest in the order of the
+// samples, against a Quantiles object fed the same predictions serially.
+
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <thread>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/posterior_predictive.h>
+#  include <sampleflow/consumers/quantiles.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+
+SampleType forward_model (const SampleType &x)
+{
+  return { x[0] + x[1], x[0] * x[1], std::exp(x[0]) };
+}
+
+
+template <typename PosteriorPredictiveType>
+void check (const PosteriorPredictiveType &posterior_predictive,
+            const std::vector<SampleType> &samples)
+{
+  // Compute the statistics of the predictions of every third sample:
+  std::vector<SampleType> predictions;
+  for (std::size_t i=0; i<samples.size(); i+=3)
+    predictions.push_back (forward_model (samples[i]));
+  const std::size_t n = predictions.size();
+
+  SampleType mean (0., 3);
+  for (const auto &y : predictions)
+    mean += y;
+  mean /= n;
+
+  SampleType variance (0., 3);
+  for (const auto &y : predictions)
+    variance += (y-mean)*(y-mean);
+  variance /= (n-1);
+
+  std::cout << "Number of predictions: " << posterior_predictive.n_predictions()
+            << " (expected " << n << ')' << std::endl;
+
+  const SampleType estimated_mean = posterior_predictive.get_mean();
+  const std::vector<double> estimated_variance = posterior_predictive.get_variance();
+  std::cout << "Mean and variance correct:";
+  for (unsigned int c=0; c<3; ++c)
+    std::cout << ' ' << (std::abs(estimated_mean[c] - mean[c]) < 1e-10 * (1+std::abs(mean[c])))
+              << (std::abs(estimated_variance[c] - variance[c]) < 1e-10 * variance[c]);
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  std::mt19937 rng;
+  std::normal_distribution<double> normal;
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<30000; ++i)
+    samples.push_back ({ normal(rng), 1+0.5*normal(rng) });
+
+  const auto thread_pool = std::make_shared<SampleFlow::ThreadPool> (3);
+  const std::thread::id main_thread = std::this_thread::get_id();
+
+  // First a forward model for one sample at a time:
+  {
+    std::atomic<unsigned int> n_on_main_thread (0);
+
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::PosteriorPredictive<SampleType,SampleType>
+    posterior_predictive ([&](const SampleType &x)
+    {
+      if (std::this_thread::get_id() == main_thread)
+        ++n_on_main_thread;
+      return forward_model (x);
+    },
+    /* every_nth = */ 3, /* batch_size = */ 4, /* queue_size = */ 8,
+    thread_pool);
+    posterior_predictive.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    std::cout << "Per-sample forward model:" << std::endl;
+    check (posterior_predictive, samples);
+    std::cout << "Evaluations on the sending thread: " << n_on_main_thread << std::endl;
+  }
+
+  // Then a forward model for batches. The last batch is incomplete:
+  {
+    std::atomic<unsigned int> n_batches (0);
+
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::PosteriorPredictive<SampleType,SampleType>
+    posterior_predictive ([&](std::span<const SampleType> x,
+                              std::span<SampleType> y)
+    {
+      ++n_batches;
+      for (std::size_t i=0; i<x.size(); ++i)
+        y[i] = forward_model (x[i]);
+    },
+    /* every_nth = */ 3, /* batch_size = */ 64, /* queue_size = */ 256,
+    thread_pool);
+    posterior_predictive.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    std::cout << "Batch forward model:" << std::endl;
+    check (posterior_predictive, samples);
+    std::cout << "Number of batches: " << n_batches << std::endl;
+  }
+
+  // Finally, a batch large enough for all predictions, compared with the
+  // quantiles of the same predictions computed serially:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::PosteriorPredictive<SampleType,SampleType>
+    posterior_predictive (&forward_model,
+                          /* every_nth = */ 3, /* batch_size = */ 10000,
+                          /* queue_size = */ 10000, thread_pool);
+    posterior_predictive.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    std::vector<SampleType> predictions;
+    for (std::size_t i=0; i<samples.size(); i+=3)
+      predictions.push_back (forward_model (samples[i]));
+
+    SampleFlow::Producers::Range<SampleType> prediction_producer;
+    SampleFlow::Consumers::Quantiles<SampleType> quantiles;
+    quantiles.connect_to_producer (prediction_producer);
+    prediction_producer.sample (predictions);
+
+    const std::vector<double> qs = {0.05, 0.5, 0.95};
+    const auto estimates = posterior_predictive.get_quantiles (qs);
+    const auto reference = quantiles.get (qs);
+
+    std::cout << "Single batch:" << std::endl;
+    std::cout << "Number of predictions: " << posterior_predictive.n_predictions()
+              << std::endl;
+    std::cout << "Quantiles match serial computation:";
+    for (unsigned int i=0; i<qs.size(); ++i)
+      std::cout << ' ' << (estimates[i] == reference[i]);
+    std::cout << std::endl;
+  }
+}
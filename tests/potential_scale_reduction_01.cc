@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the split-R-hat computed by PotentialScaleReduction: for several
+// chains run by the same producer and identified by their chain numbers,
+// for chains run by separate producers, and for a single chain that is
+// still drifting. Also check that saving and loading the state works.
+
+
+#include <iostream>
+#include <iomanip>
+#include <valarray>
+#include <vector>
+#include <span>
+#include <random>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/potential_scale_reduction.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x[0]-1)*(x[0]-1) - 4*x[1]*x[1];
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  SampleType y = x;
+  for (auto &el : y)
+    el += distribution(rng);
+  return {y, 1.0};
+}
+
+
+int main ()
+{
+  std::cout << std::setprecision(6);
+
+  // Four chains run by one producer:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    SampleFlow::Consumers::PotentialScaleReduction<SampleType> r_hat;
+    r_hat.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample_chains ({{-1.,1.}, {0.,0.}, {2.,-1.}, {3.,2.}},
+                              &log_likelihood,
+                              &perturb,
+                              20000,
+                              std::make_shared<SampleFlow::ThreadPool>(2));
+
+    const std::vector<double> result = r_hat.get();
+    std::cout << "Chains of one producer: " << r_hat.n_chains() << std::endl
+              << "  R-hat: " << result[0] << ' ' << result[1] << std::endl;
+
+    std::vector<char> buffer;
+    r_hat.save (buffer);
+    SampleFlow::Consumers::PotentialScaleReduction<SampleType> loaded;
+    std::span<const char> data (buffer);
+    loaded.load (data);
+    std::cout << "  Loaded: "
+              << (data.empty() && (loaded.get() == result) && (loaded.n_chains() == 4))
+              << std::endl;
+  }
+
+  // Two producers that each run one chain, far apart and with too few
+  // samples to have converged:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler_1, mh_sampler_2;
+    SampleFlow::Consumers::PotentialScaleReduction<SampleType> r_hat;
+    r_hat.connect_to_producer (mh_sampler_1);
+    r_hat.connect_to_producer (mh_sampler_2);
+
+    std::mt19937 rng;
+    const auto propose = [&rng](const SampleType &x)
+    {
+      return perturb (x, rng);
+    };
+    mh_sampler_1.sample ({-10.,0.}, &log_likelihood, propose, 50);
+    mh_sampler_2.sample ({10.,0.}, &log_likelihood, propose, 50);
+
+    const std::vector<double> result = r_hat.get();
+    std::cout << "Chains of two producers: " << r_hat.n_chains() << std::endl
+              << "  Not converged: " << (result[0] > 1.1) << std::endl;
+  }
+
+  // One chain whose first component is drifting, fed directly:
+  {
+    SampleFlow::Consumers::PotentialScaleReduction<SampleType> r_hat;
+    std::mt19937 rng;
+    SampleFlow::Testing::NormalDistribution<double> distribution(0., 1.);
+    for (unsigned int n=0; n<10000; ++n)
+      r_hat.consume ({n/1000. + distribution(rng), distribution(rng)},
+                     SampleFlow::AuxiliaryData());
+
+    const std::vector<double> result = r_hat.get();
+    std::cout << "Drifting chain: " << r_hat.n_chains() << std::endl
+              << "  Not converged: " << (result[0] > 1.1) << ' ' << (result[1] > 1.1)
+              << std::endl;
+  }
+}
@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check priorities: A ThreadPool has to execute waiting tasks in the
+// order of their priorities, and a consumer with Priority::low has to
+// skip samples rather than block the producer if its queue is full,
+// whereas a critical consumer connected to the same producer has to see
+// every sample.
+
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumer.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A consumer that takes a while for each sample, and that records the
+// samples it receives.
+class SlowRecorder : public SampleFlow::Consumer<int>
+{
+  public:
+    SlowRecorder ()
+      :
+      SampleFlow::Consumer<int>(SampleFlow::ParallelMode(static_cast<int>(SampleFlow::ParallelMode::synchronous)
+                                                         |
+                                                         static_cast<int>(SampleFlow::ParallelMode::asynchronous)))
+    {}
+
+    ~SlowRecorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (int sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::this_thread::sleep_for (std::chrono::milliseconds(1));
+
+      std::lock_guard<std::mutex> lock(mutex);
+      samples.push_back (sample);
+    }
+
+    std::mutex       mutex;
+    std::vector<int> samples;
+};
+
+
+
+int main ()
+{
+  // First check the order in which a pool with a single worker executes
+  // tasks: Keep the worker busy until all tasks have been enqueued.
+  {
+    SampleFlow::ThreadPool thread_pool (1);
+    SampleFlow::ThreadPool::TaskGroup tasks;
+
+    std::atomic<bool> started (false);
+    std::atomic<bool> gate (false);
+    tasks.run (thread_pool, [&]()
+    {
+      started = true;
+      while (gate.load() == false)
+        std::this_thread::yield();
+    });
+    while (started.load() == false)
+      std::this_thread::yield();
+
+    std::mutex        mutex;
+    std::vector<char> order;
+    const SampleFlow::Priority priorities[] = {SampleFlow::Priority::low,
+                                               SampleFlow::Priority::normal,
+                                               SampleFlow::Priority::critical
+                                              };
+    const char names[] = {'l', 'n', 'c'};
+    for (unsigned int i=0; i<9; ++i)
+      tasks.run (thread_pool,
+                 [&, name = names[i%3]]()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back (name);
+      },
+      priorities[i%3]);
+
+    gate = true;
+    tasks.wait();
+
+    std::cout << "Order of execution: ";
+    for (const char c : order)
+      std::cout << c;
+    std::cout << std::endl;
+  }
+
+  // Then check load shedding: The low-priority consumer has a queue of
+  // two samples, but would block the producer by default if it is full.
+  {
+    SampleFlow::Producers::Range<int> range_producer;
+
+    SlowRecorder low_priority_recorder;
+    low_priority_recorder.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 2);
+    low_priority_recorder.set_priority (SampleFlow::Priority::low);
+    low_priority_recorder.connect_to_producer (range_producer);
+
+    SlowRecorder critical_recorder;
+    critical_recorder.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 100);
+    critical_recorder.set_priority (SampleFlow::Priority::critical);
+    critical_recorder.connect_to_producer (range_producer);
+
+    std::vector<int> samples;
+    for (int i=0; i<100; ++i)
+      samples.push_back (i);
+    range_producer.sample (samples);
+
+    std::cout << "Critical consumer processed all samples: "
+              << (critical_recorder.samples.size() == samples.size()) << std::endl;
+    std::cout << "Low-priority consumer skipped samples: "
+              << (low_priority_recorder.samples.size() < samples.size()) << std::endl;
+    std::cout << "Low-priority consumer processed the last sample: "
+              << (low_priority_recorder.samples.back() == samples.back()) << std::endl;
+  }
+}
@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Producer::flush_consumers_async() and
+// Producer::set_deferred_flush(): With deferred flushing, sample() has to
+// return before a slow consumer on a dedicated thread has processed all
+// samples, and the future has to become ready only once the consumer --
+// including one connected behind a filter -- has done so.
+
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/pass_through.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A consumer that takes a while for each sample and counts them.
+class SlowCounter : public SampleFlow::Consumer<double>
+{
+  public:
+    SlowCounter ()
+      :
+      SampleFlow::Consumer<double>(SampleFlow::ParallelMode::dedicated_thread)
+    {}
+
+    ~SlowCounter ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (double /*sample*/, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::this_thread::sleep_for (std::chrono::milliseconds(2));
+      ++n_samples;
+    }
+
+    std::atomic<unsigned int> n_samples {0};
+};
+
+
+int main ()
+{
+  const unsigned int n_samples = 100;
+  std::vector<double> samples;
+  for (unsigned int i=0; i<n_samples; ++i)
+    samples.push_back (i);
+
+  SampleFlow::Producers::Range<double> range_producer;
+
+  SlowCounter direct_counter;
+  direct_counter.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 2*n_samples);
+  direct_counter.connect_to_producer (range_producer);
+
+  SampleFlow::Filters::PassThrough<double> pass_through;
+  pass_through.connect_to_producer (range_producer);
+
+  SlowCounter filtered_counter;
+  filtered_counter.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 2*n_samples);
+  filtered_counter.connect_to_producer (pass_through);
+
+  // Without any flush having been started, the last flush counts as
+  // finished:
+  std::cout << "Initially ready: "
+            << (range_producer.last_flush().wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            << std::endl;
+
+  // Defer flushing: sample() now returns while the consumers are still
+  // working.
+  range_producer.set_deferred_flush (true);
+  range_producer.sample (samples);
+  std::cout << "Returned before consumers finished: "
+            << ((direct_counter.n_samples < n_samples) && (filtered_counter.n_samples < n_samples))
+            << std::endl;
+
+  range_producer.last_flush().get();
+  std::cout << "Samples after deferred flush: "
+            << direct_counter.n_samples << ' ' << filtered_counter.n_samples << std::endl;
+
+  // Now the synchronous default again, followed by an explicit
+  // asynchronous flush:
+  range_producer.set_deferred_flush (false);
+  range_producer.sample (samples);
+  std::cout << "Samples after synchronous flush: "
+            << direct_counter.n_samples << ' ' << filtered_counter.n_samples << std::endl;
+
+  std::shared_future<void> flush = range_producer.flush_consumers_async();
+  flush.wait();
+  range_producer.wait_for_flush();
+  std::cout << "Samples after explicit flush: "
+            << direct_counter.n_samples << ' ' << filtered_counter.n_samples << std::endl;
+}
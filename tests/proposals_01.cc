@@ -0,0 +1,202 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the proposal kernels in namespace SampleFlow::Proposals: The
+// differences between trial and current samples of GaussianRandomWalk
+// have to have the covariance given to the constructor, for all three
+// ways of specifying it. Running PreconditionedCrankNicolson with the
+// prior as target distribution has to accept all proposals, and with a
+// Gaussian likelihood has to yield the mean of the posterior. Finally,
+// check that the kernels also work with sample_chains() and with sample
+// types other than Eigen vectors.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/proposals.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+// Return the largest relative difference between the covariance of the
+// steps the given kernel takes from a fixed point, and the given matrix.
+template <typename Proposal>
+double step_covariance_error (const Proposal        &proposal,
+                              const Eigen::MatrixXd &covariance)
+{
+  const unsigned int n = 200000;
+  const SampleType x = SampleType::Constant (covariance.rows(), 1.);
+  SampleType trial;
+  Eigen::MatrixXd empirical = Eigen::MatrixXd::Zero (covariance.rows(), covariance.cols());
+  for (unsigned int i=0; i<n; ++i)
+    {
+      const double ratio = proposal (x, trial);
+      if (ratio != 1)
+        return 1e10;
+      empirical += (trial - x) * (trial - x).transpose();
+    }
+  empirical /= n;
+  return (empirical - covariance).norm() / covariance.norm();
+}
+
+
+
+void check_random_walk ()
+{
+  Eigen::MatrixXd covariance (3,3);
+  covariance << 4, 1, 0.5,
+             1, 2, -0.3,
+             0.5, -0.3, 1;
+  Eigen::VectorXd standard_deviations (3);
+  standard_deviations << 0.5, 2, 1;
+
+  std::cout << "Random walk:" << std::endl;
+  std::cout << "  isotropic: "
+            << (step_covariance_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (0.3, 1),
+                                       0.09 * Eigen::MatrixXd::Identity (3,3)) < 0.02)
+            << std::endl;
+  std::cout << "  diagonal: "
+            << (step_covariance_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (standard_deviations, 2),
+                                       Eigen::MatrixXd (standard_deviations.array().square().matrix().asDiagonal())) < 0.02)
+            << std::endl;
+  std::cout << "  full: "
+            << (step_covariance_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (covariance, 3),
+                                       covariance) < 0.02)
+            << std::endl;
+}
+
+
+
+void check_pcn ()
+{
+  Eigen::MatrixXd prior_covariance (2,2);
+  prior_covariance << 2, 0.5,
+                   0.5, 1;
+  Eigen::VectorXd prior_mean (2);
+  prior_mean << 1, -1;
+  const Eigen::MatrixXd prior_precision = prior_covariance.inverse();
+
+  const auto log_prior = [&](const SampleType &x)
+  {
+    return -0.5 * (x-prior_mean).dot (prior_precision * (x-prior_mean));
+  };
+
+  std::cout << "pCN:" << std::endl;
+
+  // With the prior as target, every proposal is accepted, and the samples
+  // are distributed according to the prior:
+  {
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample (prior_mean,
+                       log_prior,
+                       SampleFlow::Proposals::PreconditionedCrankNicolson<SampleType> (0.5, prior_covariance, prior_mean, 1),
+                       100000);
+    std::cout << "  prior only, acceptance ratio: " << acceptance_ratio.get() << std::endl
+              << "  prior only, mean correct: " << ((mean_value.get() - prior_mean).norm() < 0.05)
+              << std::endl;
+  }
+
+  // With a Gaussian likelihood centered at (2,2) with covariance I, the
+  // posterior mean is (C^{-1}+I)^{-1} (C^{-1}m + (2,2)):
+  {
+    SampleType data (2);
+    data << 2, 2;
+    const SampleType posterior_mean
+      = (prior_precision + Eigen::MatrixXd::Identity(2,2)).inverse()
+        * (prior_precision * prior_mean + data);
+
+    SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+    SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+
+    mh_sampler.sample (prior_mean,
+                       [&](const SampleType &x)
+    {
+      return log_prior(x) - 0.5 * (x-data).squaredNorm();
+    },
+    SampleFlow::Proposals::PreconditionedCrankNicolson<SampleType> (0.5, prior_covariance, prior_mean, 2),
+    200000);
+    std::cout << "  posterior, some rejections: " << (acceptance_ratio.get() < 0.95) << std::endl
+              << "  posterior, mean correct: " << ((mean_value.get() - posterior_mean).norm() < 0.05)
+              << std::endl;
+  }
+}
+
+
+
+void check_chains ()
+{
+  // Run several chains with an isotropic pCN kernel and an isotropic
+  // random walk for a standard normal target in 50 dimensions, using a
+  // sample type without an Eigen interface:
+  using VectorType = std::valarray<double>;
+  const auto log_likelihood = [](const VectorType &x)
+  {
+    return -0.5 * (x*x).sum();
+  };
+
+  std::cout << "Chains:" << std::endl;
+  {
+    SampleFlow::Producers::MetropolisHastings<VectorType> mh_sampler;
+    SampleFlow::Consumers::AcceptanceRatio<VectorType> acceptance_ratio;
+    acceptance_ratio.connect_to_producer (mh_sampler);
+    mh_sampler.sample_chains (std::vector<VectorType> (4, VectorType (0., 50)),
+                              log_likelihood,
+                              SampleFlow::Proposals::PreconditionedCrankNicolson<VectorType> (0.2, 1.),
+                              1000);
+    std::cout << "  pCN, all accepted: " << (acceptance_ratio.get() == 1) << std::endl;
+  }
+  {
+    SampleFlow::Producers::MetropolisHastings<VectorType> mh_sampler;
+    SampleFlow::Consumers::MeanValue<VectorType> mean_value;
+    mean_value.connect_to_producer (mh_sampler);
+    mh_sampler.sample_chains (std::vector<VectorType> (4, VectorType (3., 50)),
+                              log_likelihood,
+                              SampleFlow::Proposals::GaussianRandomWalk<VectorType> (0.3),
+                              20000);
+    std::cout << "  random walk, mean correct: "
+              << (std::abs(mean_value.get()).max() < 0.3) << std::endl;
+  }
+}
+
+
+int main ()
+{
+  check_random_walk ();
+  check_pcn ();
+  check_chains ();
+}
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check GaussianRandomWalk::log_density(): Differences of its values
+// between two trial samples have to equal the differences of the
+// logarithm of the Gaussian density with the covariance given to the
+// constructor, for all three ways of specifying it. Then use the kernel
+// with CoupledMetropolisHastings to estimate the mean of a
+// two-dimensional Gaussian.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/proposals.h>
+#  include <sampleflow/producers/coupled_metropolis_hastings.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+// Return the largest error in the differences of log densities
+// computed by the given kernel, compared to the ones computed from the
+// given covariance matrix.
+template <typename Proposal>
+double log_density_error (const Proposal        &proposal,
+                          const Eigen::MatrixXd &covariance)
+{
+  const Eigen::MatrixXd inverse = covariance.inverse();
+  const SampleType x = SampleType::Constant (covariance.rows(), 1.);
+
+  std::mt19937 rng;
+  double error = 0;
+  SampleType previous_trial = x;
+  for (unsigned int i=0; i<100; ++i)
+    {
+      const SampleType trial = proposal (x, rng).first;
+      const double expected = -0.5 * (trial-x).dot(inverse * (trial-x))
+                              + 0.5 * (previous_trial-x).dot(inverse * (previous_trial-x));
+      const double computed = proposal.log_density (x, trial)
+                              - proposal.log_density (x, previous_trial);
+      error = std::max (error, std::fabs(computed - expected));
+      previous_trial = trial;
+    }
+  return error;
+}
+
+
+
+int main ()
+{
+  Eigen::MatrixXd covariance (3,3);
+  covariance << 4, 1, 0.5,
+             1, 2, -0.3,
+             0.5, -0.3, 1;
+  Eigen::VectorXd standard_deviations (3);
+  standard_deviations << 0.5, 2, 1;
+
+  std::cout << "Isotropic log density correct: "
+            << (log_density_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (0.7),
+                                   0.49 * Eigen::MatrixXd::Identity(3,3)) < 1e-10)
+            << std::endl;
+  std::cout << "Diagonal log density correct: "
+            << (log_density_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (standard_deviations),
+                                   Eigen::MatrixXd(standard_deviations.array().square().matrix().asDiagonal())) < 1e-10)
+            << std::endl;
+  std::cout << "General log density correct: "
+            << (log_density_error (SampleFlow::Proposals::GaussianRandomWalk<SampleType> (covariance),
+                                   covariance) < 1e-10)
+            << std::endl;
+
+  // Estimate the mean of a Gaussian with mean (1,-2) and covariance
+  // diag(1,4), starting all chains at the origin:
+  SampleFlow::Producers::CoupledMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 1;
+  parameters.first_averaged_step = 100;
+  parameters.last_averaged_step = 500;
+  SampleFlow::Producers::CoupledMetropolisHastings<SampleType> coupled_sampler (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (coupled_sampler);
+
+  const SampleFlow::Proposals::GaussianRandomWalk<SampleType> random_walk (1.);
+  coupled_sampler.sample ([](std::mt19937 &)
+  {
+    return SampleType (SampleType::Zero(2));
+  },
+  [](const SampleType &x)
+  {
+    return -0.5 * ((x(0)-1)*(x(0)-1) + (x(1)+2)*(x(1)+2)/4);
+  },
+  [&random_walk](const SampleType &x, std::mt19937 &rng)
+  {
+    return random_walk (x, rng).first;
+  },
+  [&random_walk](const SampleType &x, const SampleType &y)
+  {
+    return random_walk.log_density (x, y);
+  },
+  2000);
+
+  SampleType exact_mean (2);
+  exact_mean << 1, -2;
+  std::cout << "Mean value correct: "
+            << ((mean_value.get() - exact_mean).norm() < 0.05)
+            << std::endl;
+}
@@ -0,0 +1,118 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check MetropolisHastings::pull(): Pulling samples out of a sampler needs
+// to produce the same samples as sample(), and consumers connected to the
+// sampler need to see them as well. Also check that one can interleave
+// several chains on one thread, and that the range can be combined with
+// the range adaptors of the standard library.
+
+
+#include <iostream>
+#include <random>
+#include <ranges>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+std::mt19937 perturb_rng;
+
+double perturb (const double &x, double &y)
+{
+  y = x + std::normal_distribution<double>(0, 1)(perturb_rng);
+  return 1.0;
+}
+
+
+int main ()
+{
+  // First compute the samples of a chain in the usual way:
+  std::vector<double> pushed_samples;
+  {
+    SampleFlow::Producers::MetropolisHastings<double> mh_sampler;
+    SampleFlow::Consumers::SampleStore<double> sample_store;
+    sample_store.connect_to_producer (mh_sampler);
+    mh_sampler.sample (1., &log_likelihood, &perturb, 10);
+    for (std::size_t i=0; i<sample_store.size(); ++i)
+      pushed_samples.push_back (sample_store[i]);
+  }
+
+  // Then pull the chain out of an identical sampler, starting with the
+  // same random number generators:
+  perturb_rng = std::mt19937();
+  {
+    SampleFlow::Producers::MetropolisHastings<double> mh_sampler;
+    SampleFlow::Consumers::CountSamples<double> count_samples;
+    count_samples.connect_to_producer (mh_sampler);
+
+    auto chain = mh_sampler.pull (1., &log_likelihood, &perturb);
+    auto it = chain.begin();
+    for (unsigned int i=0; i<10; ++i, ++it)
+      std::cout << "pulled " << it->first
+                << ", pushed " << pushed_samples[i]
+                << ", repeated=" << std::any_cast<bool>(it->second[SampleFlow::AuxiliaryData::sample_is_repeated])
+                << std::endl;
+
+    // The last increment of the iterator in the loop above has already
+    // pulled an eleventh sample:
+    std::cout << "Samples seen by the connected consumer: " << count_samples.get() << std::endl;
+  }
+
+  // Now interleave two chains that use different random number streams,
+  // and use the range adaptors of the standard library:
+  {
+    SampleFlow::Producers::MetropolisHastings<double> mh_sampler;
+    std::mt19937 rng;
+    const auto propose = [&rng](const double &x)
+    {
+      return std::make_pair (x + std::normal_distribution<double>(0, 1)(rng), 1.0);
+    };
+
+    auto chain_0 = mh_sampler.pull (-10., &log_likelihood, propose, 0);
+    auto chain_1 = mh_sampler.pull (10., &log_likelihood, propose, 1);
+    auto it_0 = chain_0.begin();
+    auto it_1 = chain_1.begin();
+    for (unsigned int i=0; i<5; ++i, ++it_0, ++it_1)
+      std::cout << "chain "
+                << std::any_cast<std::size_t>(it_0->second[SampleFlow::AuxiliaryData::chain_number])
+                << ": " << it_0->first
+                << ", chain "
+                << std::any_cast<std::size_t>(it_1->second[SampleFlow::AuxiliaryData::chain_number])
+                << ": " << it_1->first
+                << std::endl;
+
+    for (const double x : mh_sampler.pull (0., &log_likelihood, propose)
+         | std::views::transform ([](const auto &sample_and_aux_data)
+    {
+      return sample_and_aux_data.first;
+    })
+    | std::views::take (3))
+      std::cout << "transformed: " << x << std::endl;
+  }
+}
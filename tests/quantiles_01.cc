@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the Quantiles consumer: Compare the estimated quantiles of the
+// components of samples drawn from a normal and an exponential
+// distribution against the exact quantiles of the samples, then check
+// weighted samples, and that save(), load(), and merge() work.
+
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/quantiles.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::mt19937 rng;
+  std::normal_distribution<double>      normal;
+  std::exponential_distribution<double> exponential;
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<100000; ++i)
+    samples.push_back ({ normal(rng), exponential(rng) });
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  SampleFlow::Consumers::Quantiles<SampleType> quantiles;
+  quantiles.connect_to_producer (range_producer);
+  range_producer.sample_in_parallel (samples);
+
+  // For each estimate, compute which fraction of the samples lies below
+  // it, and compare that with the requested quantile:
+  const std::vector<double> qs = {0.001, 0.025, 0.5, 0.975, 0.999};
+  const auto estimates = quantiles.get(qs);
+  for (unsigned int c=0; c<2; ++c)
+    {
+      std::vector<double> values;
+      for (const auto &sample : samples)
+        values.push_back (sample[c]);
+      std::sort (values.begin(), values.end());
+
+      std::cout << "Component " << c << ':';
+      for (unsigned int i=0; i<qs.size(); ++i)
+        {
+          const double fraction
+            = 1. * (std::lower_bound (values.begin(), values.end(), estimates[i][c])
+                    - values.begin()) / values.size();
+          const double tolerance = std::min (0.3*std::min(qs[i], 1-qs[i]), 0.002);
+          std::cout << ' ' << (std::abs(fraction - qs[i]) < tolerance);
+        }
+      std::cout << std::endl;
+    }
+
+  // Then check weighted samples: Values 1...1000 in which value i has
+  // weight i. The total weight is 500500, half of which is reached at
+  // i=707.
+  {
+    SampleFlow::Consumers::Quantiles<double> weighted_quantiles;
+    for (unsigned int i=1; i<=1000; ++i)
+      {
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(i);
+        weighted_quantiles.consume (i, aux_data);
+      }
+    std::cout << "Weighted median: " << std::round(weighted_quantiles.get(0.5)[0])
+              << std::endl;
+  }
+
+  // Finally check save(), load(), and merge():
+  std::vector<char> buffer;
+  quantiles.save (buffer);
+  SampleFlow::Consumers::Quantiles<SampleType> copy;
+  std::span<const char> input (buffer);
+  copy.load (input);
+  std::cout << "Loaded: " << (copy.get(qs) == quantiles.get(qs))
+            << ' ' << input.size() << std::endl;
+
+  // Merging an object with itself does not change the distribution, and
+  // so should not change the quantiles by much either:
+  copy.merge (quantiles);
+  const auto merged_estimates = copy.get(qs);
+  bool merged_close = true;
+  for (unsigned int i=0; i<qs.size(); ++i)
+    for (unsigned int c=0; c<2; ++c)
+      if (std::abs(merged_estimates[i][c] - estimates[i][c]) > 0.05)
+        merged_close = false;
+  std::cout << "Merged: " << merged_close << std::endl;
+}
@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the Quantization and Dequantization filters: Convert samples to
+// single precision, and to a 16-bit fixed-point representation with a
+// different scale and offset for each component. Write the latter in
+// binary format to a file, read it back, and convert the samples back
+// to double precision. Also check that values outside the range of the
+// integer type are clamped.
+
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/producers/chain_file.h>
+#  include <sampleflow/filters/quantization.h>
+#  include <sampleflow/filters/dequantization.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const std::string filename = "quantization_01.bin";
+  const std::vector<std::vector<double>> samples
+    = {{0.1, 100.25}, {-0.123456789, 101}, {1, 99.5}, {400, 0}};
+
+  // Single precision:
+  {
+    SampleFlow::Producers::Range<std::vector<double>> range_producer;
+
+    SampleFlow::Filters::Quantization<std::vector<double>,Eigen::VectorXf> quantization;
+    quantization.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::Action<Eigen::VectorXf>
+    action ([](const Eigen::VectorXf &sample, const SampleFlow::AuxiliaryData &)
+    {
+      std::cout << "float: " << sample[0] << ' ' << sample[1]
+                << " (" << sizeof(sample[0]) << " bytes)" << std::endl;
+    });
+    action.connect_to_producer (quantization);
+
+    range_producer.sample (samples);
+  }
+
+  // Fixed point, written to a file:
+  const std::vector<double> scales  = {0.01, 0.25};
+  const std::vector<double> offsets = {0, 100};
+  {
+    std::ofstream file (filename, std::ios::binary);
+
+    SampleFlow::Producers::Range<std::vector<double>> range_producer;
+
+    SampleFlow::Filters::Quantization<std::vector<double>,std::vector<std::int16_t>>
+    quantization (scales, offsets);
+    quantization.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::StreamOutput<std::vector<std::int16_t>>
+    writer (file, SampleFlow::Consumers::StreamOutput<std::vector<std::int16_t>>::Format::binary);
+    writer.connect_to_producer (quantization);
+
+    range_producer.sample (samples);
+  }
+
+  // Read the file back and undo the quantization:
+  {
+    SampleFlow::Producers::ChainFile<std::vector<std::int16_t>> chain_file (filename);
+    std::cout << "Bytes per scalar in the file: " << chain_file.header().scalar_size
+              << std::endl;
+
+    SampleFlow::Filters::Dequantization<std::vector<std::int16_t>,std::vector<double>>
+    dequantization (scales, offsets);
+    dequantization.connect_to_producer (chain_file);
+
+    SampleFlow::Consumers::Action<std::vector<double>>
+    action ([](const std::vector<double> &sample, const SampleFlow::AuxiliaryData &)
+    {
+      std::cout << "fixed point: " << sample[0] << ' ' << sample[1] << std::endl;
+    });
+    action.connect_to_producer (dequantization);
+
+    chain_file.sample ();
+  }
+
+  std::remove (filename.c_str());
+}
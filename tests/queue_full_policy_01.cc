@@ -0,0 +1,66 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that a consumer in asynchronous mode with a small queue
+// processes all samples, and in the order in which they were sent,
+// if the queue is full and we wait for space in it. With
+// QueueFullPolicy::drop_oldest, samples may be lost, but never
+// duplicated.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/stream_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::StreamOutput<SampleType> stream_output(std::cout);
+  stream_output.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 2,
+                                   SampleFlow::QueueFullPolicy::block);
+  stream_output.connect_to_producer(range_producer);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 1,
+                                   SampleFlow::QueueFullPolicy::spin_then_block);
+  count_samples.connect_to_producer(range_producer);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_dropped_samples;
+  count_dropped_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 1,
+                                           SampleFlow::QueueFullPolicy::drop_oldest);
+  count_dropped_samples.connect_to_producer(range_producer);
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<100; ++i)
+    samples.push_back (i);
+  range_producer.sample (samples);
+
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+  std::cout << "At most 100 samples with drop_oldest: "
+            << (count_dropped_samples.get() <= 100 ? "yes" : "no")
+            << std::endl;
+}
@@ -0,0 +1,99 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the random number generators in namespace SampleFlow::Random:
+// Compare the Philox4x32-10 bijection with the known-answer test vectors
+// published along with the algorithm, output the first numbers of the
+// xoshiro256++ generator, and check that discard() skips ahead by the
+// right number of steps and that different streams differ.
+
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/random.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename RNG>
+void check_discard (RNG rng)
+{
+  static_assert (std::uniform_random_bit_generator<RNG>);
+
+  // Compare skipping ahead with drawing the same number of values, for
+  // a few step counts that do and do not align with internal blocks:
+  for (const unsigned int n : {0, 1, 3, 4, 5, 13, 100})
+    {
+      RNG rng_1 = rng;
+      RNG rng_2 = rng;
+      for (unsigned int i=0; i<n; ++i)
+        rng_1();
+      rng_2.discard (n);
+      std::cout << "  discard(" << std::dec << n << std::hex << "): " << (rng_1 == rng_2)
+                << ' ' << (rng_1() == rng_2()) << std::endl;
+    }
+
+  // Different streams should not start with the same numbers:
+  RNG stream_0 = SampleFlow::Random::create_stream<RNG> (42, 0);
+  RNG stream_1 = SampleFlow::Random::create_stream<RNG> (42, 1);
+  std::cout << "  streams equal: " << (stream_0 == stream_1)
+            << ' ' << (stream_0() == stream_1()) << std::endl;
+}
+
+
+int main ()
+{
+  std::cout << std::hex;
+
+  std::cout << "Philox4x32-10:" << std::endl;
+  for (const auto &[counter, key]
+       : {std::make_pair (std::array<std::uint32_t,4> {{0, 0, 0, 0}},
+                          std::array<std::uint32_t,2> {{0, 0}}),
+          std::make_pair (std::array<std::uint32_t,4> {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+                          std::array<std::uint32_t,2> {{0xffffffff, 0xffffffff}}),
+          std::make_pair (std::array<std::uint32_t,4> {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+                          std::array<std::uint32_t,2> {{0xa4093822, 0x299f31d0}})
+         })
+    {
+      for (const std::uint32_t x : SampleFlow::Random::Philox4x32::encrypt (counter, key))
+        std::cout << "  " << x;
+      std::cout << std::endl;
+    }
+
+  // The first numbers of the default-seeded generator are the ones for
+  // counter and key zero:
+  SampleFlow::Random::Philox4x32 philox;
+  for (unsigned int i=0; i<4; ++i)
+    std::cout << "  " << philox();
+  std::cout << std::endl;
+  check_discard (SampleFlow::Random::Philox4x32 (42, 3));
+
+  std::cout << "Xoshiro256++:" << std::endl;
+  SampleFlow::Random::Xoshiro256PlusPlus xoshiro (42);
+  for (unsigned int i=0; i<3; ++i)
+    std::cout << "  " << xoshiro();
+  std::cout << std::endl;
+
+  SampleFlow::Random::Xoshiro256PlusPlus xoshiro_stream_1 (42, 1);
+  for (unsigned int i=0; i<2; ++i)
+    std::cout << "  " << xoshiro_stream_1();
+  std::cout << std::endl;
+  check_discard (SampleFlow::Random::Xoshiro256PlusPlus (42, 3));
+}
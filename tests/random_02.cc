@@ -0,0 +1,82 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Random::fill_normal(): Fill arrays of various lengths (including
+// odd ones and ones that are not multiples of the internal block size)
+// with normally distributed numbers, and check their mean, variance and
+// fourth moment. Also check that 32-bit and 64-bit generators work, and
+// that the numbers are the same for the same seed.
+
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/random.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename Number, typename RNG>
+void check (const std::size_t length, RNG rng)
+{
+  const std::size_t n_repetitions = 400000 / length + 1;
+
+  double sum = 0, sum_2 = 0, sum_4 = 0;
+  std::size_t n = 0;
+  std::vector<Number> values (length);
+  for (std::size_t r=0; r<n_repetitions; ++r)
+    {
+      SampleFlow::Random::fill_normal (std::span<Number>(values), rng);
+      for (const Number v : values)
+        {
+          sum += v;
+          sum_2 += v*v;
+          sum_4 += v*v*v*v;
+          ++n;
+        }
+    }
+  const double mean = sum / n;
+  const double variance = sum_2 / n - mean*mean;
+  const double kurtosis = sum_4 / n;
+
+  std::cout << "length " << length << ": "
+            << (std::abs(mean) < 0.01) << ' '
+            << (std::abs(variance - 1) < 0.02) << ' '
+            << (std::abs(kurtosis - 3) < 0.1) << std::endl;
+}
+
+
+int main ()
+{
+  for (const std::size_t length : {1, 2, 7, 63, 64, 65, 1001})
+    check<double> (length, std::mt19937 (length));
+  for (const std::size_t length : {3, 64})
+    check<float> (length, SampleFlow::Random::Xoshiro256PlusPlus (length));
+
+  // The same seed has to result in the same numbers, and consecutive
+  // calls in different ones:
+  std::vector<double> a (17), b (17), c (17);
+  SampleFlow::Random::Philox4x32 rng_1 (1), rng_2 (1);
+  SampleFlow::Random::fill_normal (std::span<double>(a), rng_1);
+  SampleFlow::Random::fill_normal (std::span<double>(b), rng_2);
+  SampleFlow::Random::fill_normal (std::span<double>(c), rng_1);
+  std::cout << "reproducible: " << (a == b) << ' ' << (a != c) << std::endl;
+}
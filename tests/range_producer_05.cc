@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Producers::Range::sample_in_parallel(): Send a range of 100,000
+// elements, created from a std::views::transform view, downstream both
+// without and with preserving the order of samples. In the first case,
+// check that the consumers see all samples; in the second, also that
+// they see them in the right order.
+
+
+#include <iostream>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  const unsigned int n_elements = 100000;
+  const auto range = std::views::iota(0u, n_elements)
+                     | std::views::transform([](const unsigned int i)
+  {
+    return 2.*i;
+  });
+
+  const auto thread_pool = std::make_shared<SampleFlow::ThreadPool>(4);
+
+  // First without preserving the order:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+    count_samples.connect_to_producer (range_producer);
+
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (range_producer);
+
+    range_producer.sample_in_parallel (range, false, thread_pool);
+
+    std::cout << "Unordered: " << count_samples.get() << ' ' << mean_value.get() << std::endl;
+  }
+
+  // Then with preserving the order:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+
+    std::vector<SampleType> samples;
+    SampleFlow::Consumers::Action<SampleType> action
+    ([&samples](SampleType sample, SampleFlow::AuxiliaryData)
+    {
+      samples.push_back (sample);
+    });
+    action.connect_to_producer (range_producer);
+
+    range_producer.sample_in_parallel (range, true, thread_pool);
+
+    bool in_order = (samples.size() == n_elements);
+    for (unsigned int i=0; in_order && (i<samples.size()); ++i)
+      in_order = (samples[i] == 2.*i);
+    std::cout << "Ordered: " << samples.size() << ' ' << in_order << std::endl;
+  }
+}
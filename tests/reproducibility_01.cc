@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Reproducibility::set_deterministic(): Run many MetropolisHastings
+// chains on thread pools of different sizes, with a MeanValue consumer
+// that processes samples synchronously and a CovarianceMatrix consumer
+// that processes them asynchronously. In deterministic mode, the
+// results need to be bitwise identical in every run.
+
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/reproducibility.h>
+#  include <sampleflow/thread_pool.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -((x[0]-1)*(x[0]-1) + (x[1]+2)*(x[1]+2)/4 + 0.1*x[0]*x[1]);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.7);
+  return {SampleType {x[0] + distribution(rng), x[1] + distribution(rng)}, 1.0};
+}
+
+
+
+// Run the chains and return the mean value and the entries of the
+// covariance matrix.
+std::vector<double> run (const unsigned int n_threads)
+{
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 64);
+  covariance_matrix.connect_to_producer (mh_sampler);
+
+  std::vector<SampleType> starting_points;
+  for (unsigned int c=0; c<16; ++c)
+    starting_points.push_back (SampleType {0.1*c, -0.2*c});
+
+  mh_sampler.sample_chains (starting_points,
+                            &log_likelihood,
+                            &perturb,
+                            5000,
+                            std::make_shared<SampleFlow::ThreadPool>(n_threads));
+
+  const SampleType mean = mean_value.get();
+  const auto covariance = covariance_matrix.get();
+  return {mean[0], mean[1],
+          covariance(0,0), covariance(0,1), covariance(1,0), covariance(1,1)};
+}
+
+
+
+bool bitwise_equal (const std::vector<double> &a,
+                    const std::vector<double> &b)
+{
+  return (a.size() == b.size())
+         &&
+         (std::memcmp (a.data(), b.data(), a.size()*sizeof(double)) == 0);
+}
+
+
+
+int main ()
+{
+  SampleFlow::Reproducibility::set_deterministic (true);
+  std::cout << "Deterministic: " << SampleFlow::Reproducibility::is_deterministic() << std::endl;
+
+  const std::vector<double> reference = run (4);
+  std::cout << "Mean value: " << reference[0] << ' ' << reference[1] << std::endl;
+
+  bool all_equal = true;
+  for (const unsigned int n_threads : {4, 4, 4, 1, 3, 8})
+    if (bitwise_equal (run (n_threads), reference) == false)
+      all_equal = false;
+  std::cout << "Bitwise identical results: " << all_equal << std::endl;
+}
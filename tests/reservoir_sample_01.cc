@@ -0,0 +1,173 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the ReservoirSample consumer: If fewer than k samples are seen,
+// all of them are kept; samples are kept with equal probability; repeated
+// samples are treated as if the copies had been sent separately; samples
+// sent from several threads are all represented; and saving and loading
+// the state of the consumer preserves the samples kept.
+
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/reservoir_sample.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  // Fewer samples than fit into the reservoir:
+  {
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::ReservoirSample<SampleType> reservoir (100);
+    reservoir.connect_to_producer (range_producer);
+
+    std::vector<SampleType> samples;
+    for (unsigned int i=0; i<50; ++i)
+      samples.push_back (i);
+    range_producer.sample (samples);
+
+    std::vector<SampleType> kept = reservoir.get();
+    std::sort (kept.begin(), kept.end());
+    std::cout << "Kept " << kept.size() << " of " << reservoir.n_samples_seen()
+              << " samples, all of them: " << (kept == samples ? "yes" : "no")
+              << std::endl;
+  }
+
+  // Count how often each of 1000 samples is kept in a reservoir of size
+  // 10, over many runs with different seeds. Each sample should be kept
+  // in 1% of all runs, so every group of 100 consecutive samples should
+  // have about as many samples kept as there are runs.
+  {
+    const unsigned int n_runs = 2000;
+    std::vector<unsigned int> n_kept (10, 0);
+    for (unsigned int run=0; run<n_runs; ++run)
+      {
+        SampleFlow::Consumers::ReservoirSample<SampleType> reservoir (10, run);
+        for (unsigned int i=0; i<1000; ++i)
+          reservoir.consume (i, {});
+
+        for (const SampleType s : reservoir.get())
+          ++n_kept[static_cast<unsigned int>(s) / 100];
+      }
+
+    bool uniform = true;
+    for (const unsigned int n : n_kept)
+      if ((n < 0.9*n_runs) || (n > 1.1*n_runs))
+        uniform = false;
+    std::cout << "Samples are kept uniformly: " << (uniform ? "yes" : "no") << std::endl;
+  }
+
+  // Sending a sample with a repetition count has to produce the same
+  // result as sending it that many times:
+  {
+    SampleFlow::Consumers::ReservoirSample<SampleType> reservoir_1 (20, 1);
+    SampleFlow::Consumers::ReservoirSample<SampleType> reservoir_2 (20, 1);
+    for (unsigned int i=0; i<1000; ++i)
+      {
+        const unsigned int n_repetitions = 1 + (i % 7);
+
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(n_repetitions);
+        reservoir_1.consume (i, aux_data);
+
+        for (unsigned int r=0; r<n_repetitions; ++r)
+          reservoir_2.consume (i, {});
+      }
+    std::cout << "Number of samples seen: " << reservoir_1.n_samples_seen()
+              << ' ' << reservoir_2.n_samples_seen() << std::endl;
+    std::cout << "Repeated samples are treated correctly: "
+              << (reservoir_1.get() == reservoir_2.get() ? "yes" : "no") << std::endl;
+  }
+
+  // Merge a reservoir that has seen 1000 samples with one that has seen
+  // 3000. Over many runs, a quarter of the samples kept should come
+  // from the first one:
+  {
+    const unsigned int n_runs = 200;
+    unsigned int n_kept_from_first = 0;
+    for (unsigned int run=0; run<n_runs; ++run)
+      {
+        SampleFlow::Consumers::ReservoirSample<SampleType> reservoir_1 (100, 2*run);
+        SampleFlow::Consumers::ReservoirSample<SampleType> reservoir_2 (100, 2*run+1);
+        for (unsigned int i=0; i<1000; ++i)
+          reservoir_1.consume (i, {});
+        for (unsigned int i=0; i<3000; ++i)
+          reservoir_2.consume (10000+i, {});
+
+        reservoir_1.merge (reservoir_2);
+        for (const SampleType s : reservoir_1.get())
+          if (s < 10000)
+            ++n_kept_from_first;
+      }
+    const double fraction = 1. * n_kept_from_first / (100 * n_runs);
+    std::cout << "Fraction of samples from the first reservoir is about 1/4: "
+              << ((fraction > 0.23) && (fraction < 0.27) ? "yes" : "no") << std::endl;
+  }
+
+  // Four threads sending 25,000 samples each. Each should contribute
+  // about a quarter of the samples kept:
+  {
+    SampleFlow::Consumers::ReservoirSample<SampleType> reservoir (1000);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<4; ++t)
+      threads.emplace_back ([&reservoir,t]()
+    {
+      for (unsigned int i=0; i<25000; ++i)
+        reservoir.consume (100000*t + i, {});
+    });
+    for (auto &thread : threads)
+      thread.join();
+
+    const std::vector<SampleType> kept = reservoir.get();
+    std::vector<unsigned int> n_kept (4, 0);
+    for (const SampleType s : kept)
+      ++n_kept[static_cast<unsigned int>(s) / 100000];
+
+    std::cout << "Kept " << kept.size() << " of " << reservoir.n_samples_seen()
+              << " samples, all different: "
+              << (std::set<SampleType>(kept.begin(), kept.end()).size() == kept.size() ? "yes" : "no")
+              << std::endl;
+    std::cout << "Each thread contributes about a quarter: "
+              << (std::all_of (n_kept.begin(), n_kept.end(),
+                               [](const unsigned int n)
+    {
+      return (n > 200) && (n < 300);
+    }) ? "yes" : "no")
+        << std::endl;
+
+    // Save the state and load it into another object:
+    std::vector<char> buffer;
+    reservoir.save (buffer);
+
+    SampleFlow::Consumers::ReservoirSample<SampleType> loaded_reservoir (1000);
+    std::span<const char> data (buffer);
+    loaded_reservoir.load (data);
+    std::cout << "Loaded state is the same: "
+              << ((loaded_reservoir.get() == kept) && (data.size() == 0) ? "yes" : "no")
+              << std::endl;
+  }
+}
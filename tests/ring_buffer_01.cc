@@ -0,0 +1,88 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the RingBuffer class: Fill a buffer, overwrite its oldest
+// elements, clear it, and fill it again. Also check that once the buffer
+// is full, adding elements reuses the memory of the elements overwritten.
+
+
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/ring_buffer.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename T>
+void print (const SampleFlow::RingBuffer<T> &buffer)
+{
+  std::cout << "size=" << buffer.size()
+            << " full=" << buffer.full()
+            << " elements:";
+  for (std::size_t i=0; i<buffer.size(); ++i)
+    std::cout << ' ' << buffer[i];
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  {
+    SampleFlow::RingBuffer<int> buffer (4);
+    std::cout << "capacity=" << buffer.capacity()
+              << " empty=" << buffer.empty() << std::endl;
+
+    for (int i=0; i<7; ++i)
+      {
+        buffer.push_back (i);
+        print (buffer);
+      }
+    std::cout << "back=" << buffer.back() << std::endl;
+
+    buffer.clear ();
+    print (buffer);
+    for (int i=10; i<13; ++i)
+      buffer.push_back (i);
+    print (buffer);
+  }
+
+  {
+    SampleFlow::RingBuffer<std::vector<double>> buffer (3);
+    for (unsigned int i=0; i<3; ++i)
+      buffer.push_back (std::vector<double> (100, i));
+
+    std::vector<const double *> memory_locations;
+    for (unsigned int i=0; i<3; ++i)
+      memory_locations.push_back (buffer[i].data());
+
+    // Overwrite all elements twice. Because that is a multiple of the
+    // capacity, the oldest element is then again stored in the first
+    // slot, and all elements live in the same memory locations as
+    // before:
+    for (unsigned int i=3; i<9; ++i)
+      buffer.push_back (std::vector<double> (100, i));
+
+    bool same_memory = true;
+    for (unsigned int i=0; i<3; ++i)
+      if (buffer[i].data() != memory_locations[i])
+        same_memory = false;
+    std::cout << "elements " << buffer[0][0] << ' ' << buffer[1][0] << ' ' << buffer[2][0]
+              << ", memory reused: " << same_memory << std::endl;
+  }
+}
@@ -0,0 +1,70 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that a RingBuffer can be saved to and loaded from a buffer,
+// and that copies and objects loaded from such a buffer continue to
+// overwrite the oldest element when new elements are added.
+
+
+#include <iostream>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/ring_buffer.h>
+#  include <sampleflow/serialization.h>
+#else
+import SampleFlow;
+#endif
+
+
+void print (const SampleFlow::RingBuffer<std::vector<int>> &buffer)
+{
+  std::cout << "capacity=" << buffer.capacity() << " size=" << buffer.size()
+            << " elements:";
+  for (unsigned int i=0; i<buffer.size(); ++i)
+    std::cout << " (" << buffer[i][0] << ',' << buffer[i][1] << ')';
+  std::cout << std::endl;
+}
+
+
+int main ()
+{
+  SampleFlow::RingBuffer<std::vector<int>> ring_buffer (3);
+  for (int i=0; i<5; ++i)
+    ring_buffer.push_back ({i, 10*i});
+  print (ring_buffer);
+
+  std::vector<char> buffer;
+  SampleFlow::Serialization::write (buffer, ring_buffer);
+
+  SampleFlow::RingBuffer<std::vector<int>> loaded_buffer;
+  std::cout << "default-constructed: capacity=" << loaded_buffer.capacity() << std::endl;
+
+  std::span<const char> input (buffer);
+  SampleFlow::Serialization::read (input, loaded_buffer);
+  std::cout << "bytes left: " << input.size() << std::endl;
+  print (loaded_buffer);
+
+  loaded_buffer.push_back ({5, 50});
+  print (loaded_buffer);
+
+  SampleFlow::RingBuffer<std::vector<int>> copy;
+  copy = loaded_buffer;
+  copy.push_back ({6, 60});
+  print (copy);
+  print (loaded_buffer);
+}
@@ -0,0 +1,139 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check that producers announce the shape and number of the samples they
+// are about to send via Producer::announce_samples(), that filters and
+// groups pass these announcements on (with the number of samples adjusted
+// by TakeEveryNth and DiscardFirstN), and that a SampleStore uses them to
+// allocate all of its chunks up front.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/filters/discard_first_n.h>
+#  include <sampleflow/consumers/group.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A consumer that prints the announcements it receives.
+template <typename InputType>
+class AnnouncementPrinter : public SampleFlow::Consumer<InputType>
+{
+  public:
+    AnnouncementPrinter (const std::string &name)
+      : name (name)
+    {}
+
+    ~AnnouncementPrinter ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (InputType, SampleFlow::AuxiliaryData) override
+    {}
+
+    virtual
+    void
+    prepare_for_samples (const SampleFlow::SampleShape &shape) override
+    {
+      std::cout << name << ": ";
+      if (shape.n_components.has_value())
+        std::cout << *shape.n_components << " components, ";
+      else
+        std::cout << "unknown number of components, ";
+      if (shape.n_samples.has_value())
+        std::cout << *shape.n_samples << " samples" << std::endl;
+      else
+        std::cout << "unknown number of samples" << std::endl;
+    }
+
+  private:
+    const std::string name;
+};
+
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<100; ++i)
+    samples.push_back (SampleType({1.*i, 2.*i, 3.*i}));
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  AnnouncementPrinter<SampleType> direct ("direct");
+  direct.connect_to_producer (range_producer);
+
+  SampleFlow::Filters::TakeEveryNth<SampleType> take_every_nth (7);
+  take_every_nth.connect_to_producer (range_producer);
+  AnnouncementPrinter<SampleType> thinned ("every 7th");
+  thinned.connect_to_producer (take_every_nth);
+
+  SampleFlow::Filters::DiscardFirstN<SampleType> discard_first_n (30);
+  discard_first_n.connect_to_producer (range_producer);
+  AnnouncementPrinter<SampleType> in_group ("after burn-in, in a group");
+  SampleFlow::Consumers::SampleStore<SampleType> store ({}, 16);
+  SampleFlow::Consumers::Group<SampleType> group;
+  group.add (in_group);
+  group.add (store);
+  group.connect_to_producer (discard_first_n);
+
+  range_producer.sample (samples);
+  std::cout << "Stored samples: " << store.size()
+            << ", chunks: " << store.n_chunks()
+            << ", sample 50: " << store[50][2] << std::endl;
+
+  // A second round of samples. The burn-in phase is over, so the
+  // DiscardFirstN filter announces all of them:
+  range_producer.sample (samples);
+  std::cout << "Stored samples: " << store.size()
+            << ", chunks: " << store.n_chunks() << std::endl;
+
+
+  // A Metropolis-Hastings sampler announces the number of steps it will
+  // take:
+  std::mt19937 rng;
+  SampleFlow::Producers::MetropolisHastings<Eigen::VectorXd> mh_sampler;
+  AnnouncementPrinter<Eigen::VectorXd> mh_output ("MH");
+  mh_output.connect_to_producer (mh_sampler);
+  mh_sampler.sample (Eigen::VectorXd::Zero(4),
+                     [](const Eigen::VectorXd &x)
+  {
+    return -x.squaredNorm();
+  },
+  [&rng](const Eigen::VectorXd &x)
+  {
+    Eigen::VectorXd y = x;
+    y[0] += std::uniform_real_distribution<double>(-1,1)(rng);
+    return std::make_pair (y, 1.0);
+  },
+  250);
+}
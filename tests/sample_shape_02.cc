@@ -0,0 +1,109 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that filters that may drop samples do not pass on the number of
+// samples announced upstream (which would make a SampleStore downstream
+// allocate memory for samples that never arrive), but that a Batcher
+// announces the number of batches it will send.
+
+
+#include <iostream>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/batcher.h>
+#  include <sampleflow/filters/condition.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A consumer that prints the announcements it receives.
+template <typename InputType>
+class AnnouncementPrinter : public SampleFlow::Consumer<InputType>
+{
+  public:
+    AnnouncementPrinter (const std::string &name)
+      : name (name)
+    {}
+
+    ~AnnouncementPrinter ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (InputType, SampleFlow::AuxiliaryData) override
+    {}
+
+    virtual
+    void
+    prepare_for_samples (const SampleFlow::SampleShape &shape) override
+    {
+      std::cout << name << ": ";
+      if (shape.n_components.has_value())
+        std::cout << *shape.n_components << " components, ";
+      else
+        std::cout << "unknown number of components, ";
+      if (shape.n_samples.has_value())
+        std::cout << *shape.n_samples << " samples" << std::endl;
+      else
+        std::cout << "unknown number of samples" << std::endl;
+    }
+
+  private:
+    const std::string name;
+};
+
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<1000; ++i)
+    samples.push_back (SampleType({1.*i, 2.*i, 3.*i}));
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  // Only keep every 50th sample. The store then needs only one chunk:
+  SampleFlow::Filters::Condition<SampleType>
+  condition ([](const SampleType &x)
+  {
+    return (static_cast<unsigned int>(x[0]) % 50 == 0);
+  });
+  condition.connect_to_producer (range_producer);
+  AnnouncementPrinter<SampleType> selected ("condition");
+  selected.connect_to_producer (condition);
+  SampleFlow::Consumers::SampleStore<SampleType> store ({}, 64);
+  store.connect_to_producer (condition);
+
+  SampleFlow::Filters::Batcher<SampleType> batcher (64);
+  batcher.connect_to_producer (range_producer);
+  AnnouncementPrinter<SampleFlow::Filters::SampleBatch<SampleType>> batches ("batcher");
+  batches.connect_to_producer (batcher);
+
+  range_producer.sample (samples);
+  std::cout << "Stored samples: " << store.size()
+            << ", chunks: " << store.n_chunks() << std::endl;
+}
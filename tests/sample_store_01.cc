@@ -0,0 +1,100 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the SampleStore consumer: samples and selected auxiliary data
+// are stored, can be viewed chunk by chunk as Eigen matrices and
+// vectors, and the store can be used as input for a Range producer.
+
+
+#include <iostream>
+#include <valarray>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  SampleFlow::Consumers::SampleStore<SampleType>
+  store ({SampleFlow::AuxiliaryData::relative_log_likelihood,
+          SampleFlow::AuxiliaryData::sample_is_repeated},
+         4);
+
+  for (unsigned int i=0; i<10; ++i)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -0.5*i;
+      if (i % 3 != 0)
+        aux_data[SampleFlow::AuxiliaryData::sample_is_repeated] = (i % 2 == 0);
+      store.consume (SampleType({1.*i, 10.*i, 100.*i}), aux_data);
+    }
+
+  std::cout << "Samples: " << store.size()
+            << ", components: " << store.n_components()
+            << ", chunks: " << store.n_chunks() << std::endl;
+
+  for (std::size_t c=0; c<store.n_chunks(); ++c)
+    {
+      std::cout << "Chunk " << c << ":" << std::endl
+                << store.chunk(c) << std::endl;
+      std::cout << "  component 1: " << store.component(c,1).transpose() << std::endl;
+      std::cout << "  log likelihood: " << store.aux_data_column(c,0).transpose() << std::endl;
+      std::cout << "  repeated: " << store.aux_data_column(c,1).transpose() << std::endl;
+    }
+
+  std::cout << "Sample 6: ";
+  for (const double x : store[6])
+    std::cout << x << ' ';
+  std::cout << "with log likelihood " << store.aux_data(6,0) << std::endl;
+
+  // Compute the mean value from the chunks, and by sending the stored
+  // samples through a Range producer to a MeanValue consumer:
+  Eigen::VectorXd sum = Eigen::VectorXd::Zero (store.n_components());
+  for (std::size_t c=0; c<store.n_chunks(); ++c)
+    sum += store.chunk(c).colwise().sum().transpose();
+  std::cout << "Mean from chunks: " << (sum / store.size()).transpose() << std::endl;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (range_producer);
+  range_producer.sample (store);
+
+  std::cout << "Mean from Range producer: ";
+  for (const double x : mean_value.get())
+    std::cout << x << ' ';
+  std::cout << std::endl;
+
+  // Also copy the store into another one using sample_in_parallel(),
+  // which requires a random-access range:
+  SampleFlow::Producers::Range<SampleType> parallel_range_producer;
+  SampleFlow::Consumers::SampleStore<SampleType> copy ({}, 3);
+  copy.connect_to_producer (parallel_range_producer);
+  parallel_range_producer.sample_in_parallel (store, true);
+
+  bool equal = (copy.size() == store.size());
+  for (std::size_t i=0; i<copy.size(); ++i)
+    if ((copy[i] != store[i]).max())
+      equal = false;
+  std::cout << "Copy is equal: " << (equal ? "yes" : "no") << std::endl;
+}
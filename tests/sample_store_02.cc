@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the SampleStore consumer when it writes full chunks to a file:
+// Store many samples while keeping only two chunks in memory, then
+// check that the samples, the auxiliary data, and the chunk views are
+// the same as for a store that keeps everything in memory, that the
+// memory used stays bounded, and that the stored samples can be sent
+// through a Range producer. Then do the same for samples with an odd
+// number of float components, for which the auxiliary data has to be
+// placed behind padding.
+
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::size_t dimension,
+          const std::size_t chunk_size,
+          const std::size_t n_samples)
+{
+  using scalar_type = typename SampleType::value_type;
+
+  SampleFlow::Consumers::SampleStore<SampleType>
+  in_memory ({SampleFlow::AuxiliaryData::relative_log_likelihood}, chunk_size);
+  SampleFlow::Consumers::SampleStore<SampleType>
+  on_disk ({SampleFlow::AuxiliaryData::relative_log_likelihood}, chunk_size);
+
+  const std::string filename = "sample_store_02.spill";
+  on_disk.spill_to_file (filename, 2);
+
+  std::size_t max_memory = 0;
+  for (std::size_t i=0; i<n_samples; ++i)
+    {
+      SampleType sample (dimension);
+      for (std::size_t c=0; c<dimension; ++c)
+        sample[c] = static_cast<scalar_type>(i % 1000) + c;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -0.5*i;
+
+      in_memory.consume (sample, aux_data);
+      on_disk.consume (sample, aux_data);
+
+      max_memory = std::max (max_memory, on_disk.memory_consumption());
+    }
+
+  // The file has been removed from its directory right away:
+  std::FILE *file = std::fopen (filename.c_str(), "r");
+  std::cout << "File exists: " << (file != nullptr ? "yes" : "no") << std::endl;
+  if (file != nullptr)
+    std::fclose (file);
+
+  std::cout << "Samples: " << on_disk.size()
+            << ", chunks: " << on_disk.n_chunks() << std::endl;
+
+  // The memory used by the samples is that of at most two chunks, plus
+  // the array of descriptions of all chunks:
+  const std::size_t chunk_memory
+    = chunk_size * (dimension*sizeof(scalar_type) + sizeof(double));
+  std::cout << "Memory bounded: "
+            << (max_memory <= 2*chunk_memory + on_disk.n_chunks()*64 ? "yes" : "no")
+            << std::endl;
+
+  bool equal = true;
+  for (std::size_t c=0; c<on_disk.n_chunks(); ++c)
+    {
+      if (on_disk.chunk(c) != in_memory.chunk(c))
+        equal = false;
+      if (on_disk.component(c,dimension-1) != in_memory.component(c,dimension-1))
+        equal = false;
+      if (on_disk.aux_data_column(c,0) != in_memory.aux_data_column(c,0))
+        equal = false;
+    }
+  for (std::size_t i=0; i<n_samples; i+=997)
+    if (((on_disk[i] != in_memory[i]).max())
+        ||
+        (on_disk.aux_data(i,0) != in_memory.aux_data(i,0)))
+      equal = false;
+  std::cout << "Same as in memory: " << (equal ? "yes" : "no") << std::endl;
+
+  // Send the stored samples through a Range producer, on several threads:
+  SampleFlow::Producers::Range<SampleType> range_producer;
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (range_producer);
+  range_producer.sample_in_parallel (on_disk, true);
+
+  Eigen::VectorXd sum = Eigen::VectorXd::Zero (dimension);
+  for (std::size_t c=0; c<in_memory.n_chunks(); ++c)
+    sum += in_memory.chunk(c).template cast<double>().colwise().sum().transpose();
+  const Eigen::VectorXd mean = sum / n_samples;
+
+  bool mean_equal = true;
+  for (std::size_t c=0; c<dimension; ++c)
+    if (std::abs (mean_value.get()[c] - mean[c]) > 1e-4 * std::abs(mean[c]))
+      mean_equal = false;
+  std::cout << "Mean from Range producer correct: " << (mean_equal ? "yes" : "no") << std::endl;
+}
+
+
+int main ()
+{
+  test<std::valarray<double>> (3, 1000, 200003);
+  test<std::valarray<float>> (5, 7, 10000);
+}
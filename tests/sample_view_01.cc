@@ -0,0 +1,155 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check that samples of a type that only refers to the memory of the
+// producer (here, std::span<const double>) can be passed through a
+// pipeline: Synchronous consumers see the samples directly, consumers
+// that process samples on a dedicated thread see copies of them even
+// though the producer overwrites its buffer right away, and a
+// Materialize filter turns the views into std::vector<double> objects
+// that can be stored.
+
+
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/materialize.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/last_sample.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::span<const double>;
+
+
+// A producer that creates all of its samples in the same buffer and sends
+// views of this buffer downstream.
+class BufferProducer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const unsigned int n_samples)
+    {
+      std::vector<double> buffer (3);
+      for (unsigned int i=0; i<n_samples; ++i)
+        {
+          buffer[0] = i;
+          buffer[1] = 2*i;
+          buffer[2] = i%7;
+          this->issue_sample (SampleType (buffer), {});
+        }
+
+      // Make sure nobody sees the last sample before it has been
+      // processed:
+      buffer.assign (3, -1.);
+      this->flush_consumers ();
+    }
+};
+
+
+// A consumer that records the samples it receives on a thread of its
+// own, at which point the producer has long overwritten its buffer.
+class Recorder : public SampleFlow::Consumer<SampleType>
+{
+  public:
+    Recorder ()
+      :
+      SampleFlow::Consumer<SampleType>(SampleFlow::ParallelMode::dedicated_thread)
+    {}
+
+    ~Recorder ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (SampleType sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      samples.emplace_back (sample.begin(), sample.end());
+    }
+
+    std::mutex                       mutex;
+    std::vector<std::vector<double>> samples;
+};
+
+
+int main ()
+{
+  const unsigned int n_samples = 1000;
+
+  BufferProducer producer;
+
+  unsigned int n_correct_synchronous = 0;
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+  {
+    if ((sample[1] == 2*sample[0])
+        &&
+        (sample[2] == static_cast<unsigned int>(sample[0]) % 7))
+      ++n_correct_synchronous;
+  });
+  action.connect_to_producer (producer);
+
+  Recorder recorder;
+  recorder.set_parallel_mode (SampleFlow::ParallelMode::dedicated_thread, 4);
+  recorder.connect_to_producer (producer);
+
+  SampleFlow::Filters::Materialize<SampleType> materialize;
+  materialize.connect_to_producer (producer);
+
+  double sum_of_first_components = 0;
+  SampleFlow::Consumers::Action<std::vector<double>>
+  sum ([&](const std::vector<double> &sample, SampleFlow::AuxiliaryData)
+  {
+    sum_of_first_components += sample[0];
+  });
+  sum.connect_to_producer (materialize);
+
+  SampleFlow::Consumers::LastSample<std::vector<double>> last_sample;
+  last_sample.connect_to_producer (materialize);
+
+  producer.sample (n_samples);
+
+  std::cout << "Correct synchronous samples: " << n_correct_synchronous << std::endl;
+
+  bool recorded_correctly = (recorder.samples.size() == n_samples);
+  for (unsigned int i=0; recorded_correctly && i<n_samples; ++i)
+    if (recorder.samples[i] != std::vector<double> {1.*i, 2.*i, 1.*(i%7)})
+      recorded_correctly = false;
+  std::cout << "Correct samples on dedicated thread: " << recorded_correctly << std::endl;
+
+  std::cout << "Sum of first components: " << sum_of_first_components << std::endl;
+
+  std::cout << "Last sample:";
+  for (const double x : last_sample.get())
+    std::cout << ' ' << x;
+  std::cout << std::endl;
+
+  std::cout << "Materialized type is std::vector<double>: "
+            << std::is_same_v<SampleFlow::types::MaterializedType<SampleType>, std::vector<double>>
+            << std::endl;
+  std::cout << "View of std::vector<double> is a sample view: "
+            << SampleFlow::Concepts::is_sample_view<std::vector<double>> << std::endl;
+}
@@ -0,0 +1,221 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the timings of likelihood evaluations and proposals that the
+// MetropolisHastings, DelayedRejectionMetropolisHastings, and
+// DifferentialEvaluationMetropolisHastings samplers collect if
+// Parameters::record_timings is set: The number of calls needs to match
+// the number of steps (plus the evaluations for the starting points),
+// every sample needs to carry its timings as aux data entries of type
+// double (unless repeated samples are compressed), and the sum of these
+// must not exceed the total time in the statistics. Since the times
+// themselves are not reproducible, we only output whether they are
+// consistent.
+
+
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/producers/delayed_rejection_mh.h>
+#  include <sampleflow/producers/differential_evaluation_mh.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+// A consumer that checks that each sample carries timings, and adds
+// them up.
+struct TimingCollector
+{
+  std::mutex    mutex;
+  std::size_t   n_samples            = 0;
+  std::size_t   n_samples_with_times = 0;
+  double        proposal_time        = 0;
+  double        likelihood_time      = 0;
+
+  SampleFlow::Consumers::Action<double> action
+  {
+    [this](const double, const SampleFlow::AuxiliaryData &aux_data)
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      ++n_samples;
+
+      const double *p = aux_data.get_if<double> (SampleFlow::AuxiliaryData::proposal_time);
+      const double *l = aux_data.get_if<double> (SampleFlow::AuxiliaryData::likelihood_evaluation_time);
+      if ((p != nullptr) && (l != nullptr) && (*p >= 0) && (*l >= 0))
+        {
+          ++n_samples_with_times;
+          proposal_time   += *p;
+          likelihood_time += *l;
+        }
+    }
+  };
+};
+
+
+void print (const std::string &name,
+            const SampleFlow::Instrumentation::SamplerStatistics &s,
+            const TimingCollector &collector)
+{
+  const auto consistent = [](const SampleFlow::Instrumentation::TimingStatistics &t,
+                             const double sum_over_samples)
+  {
+    return ((t.histogram.count() == t.n_calls)
+            &&
+            (t.quantile(0.5) <= t.quantile(0.99))
+            &&
+            (t.mean() * t.n_calls <= t.total_time)
+            &&
+            (sum_over_samples <= std::chrono::duration<double>(t.total_time).count() * (1+1e-9)));
+  };
+
+  std::cout << name << ": "
+            << s.likelihood_evaluations.n_calls << " likelihood evaluations, "
+            << s.proposals.n_calls << " proposals, "
+            << collector.n_samples << " samples, "
+            << collector.n_samples_with_times << " with timings" << std::endl;
+  std::cout << "  consistent: "
+            << consistent (s.likelihood_evaluations, collector.likelihood_time) << ' '
+            << consistent (s.proposals, collector.proposal_time) << std::endl;
+}
+
+
+int main ()
+{
+  // Metropolis-Hastings with a single chain, without and with timings,
+  // and with compressed samples:
+  for (const bool compress : {false, true})
+    for (const bool record_timings : {false, true})
+      {
+        SampleFlow::Producers::MetropolisHastings<double>::Parameters parameters;
+        parameters.compress_repeated_samples = compress;
+        parameters.record_timings            = record_timings;
+        SampleFlow::Producers::MetropolisHastings<double> mh_sampler (parameters);
+
+        TimingCollector collector;
+        collector.action.connect_to_producer (mh_sampler);
+
+        mh_sampler.sample (0.,
+                           &log_likelihood,
+                           [](const double &x)
+        {
+          static std::mt19937 rng;
+          return std::pair<double,double> (x + std::normal_distribution<double>(0, 1)(rng), 1.);
+        },
+        100);
+
+        print (std::string("MH") + (compress ? ", compressed" : "") + (record_timings ? ", timed" : ""),
+               mh_sampler.get_sampler_statistics(), collector);
+      }
+
+  // Several chains on a thread pool, and in lockstep:
+  for (const bool lockstep : {false, true})
+    {
+      SampleFlow::Producers::MetropolisHastings<double>::Parameters parameters;
+      parameters.record_timings = true;
+      SampleFlow::Producers::MetropolisHastings<double> mh_sampler (parameters);
+
+      TimingCollector collector;
+      collector.action.connect_to_producer (mh_sampler);
+
+      const auto propose = [](const double &x, std::mt19937 &rng)
+      {
+        return std::pair<double,double> (x + std::normal_distribution<double>(0, 1)(rng), 1.);
+      };
+      if (lockstep)
+        mh_sampler.sample_chains ({-1., 0., 1., 2.},
+                                  SampleFlow::types::BatchLogLikelihood<double>
+                                  ([](std::span<const double> samples, std::span<double> log_likelihoods)
+        {
+          for (std::size_t i=0; i<samples.size(); ++i)
+            log_likelihoods[i] = log_likelihood (samples[i]);
+        }),
+        propose, 50);
+      else
+        mh_sampler.sample_chains ({-1., 0., 1., 2.}, &log_likelihood, propose, 50);
+
+      print (lockstep ? "MH chains in lockstep" : "MH chains on pool",
+             mh_sampler.get_sampler_statistics(), collector);
+    }
+
+  // Delayed rejection, with sequential and concurrent stages. Since the
+  // proposal is deterministic, so is the number of likelihood
+  // evaluations.
+  for (const unsigned int n_concurrent_stages : {1, 3})
+    {
+      SampleFlow::Producers::DelayedRejectionMetropolisHastings<double>::Parameters parameters;
+      parameters.n_concurrent_stages = n_concurrent_stages;
+      parameters.record_timings      = true;
+      SampleFlow::Producers::DelayedRejectionMetropolisHastings<double> dr_sampler (parameters);
+
+      TimingCollector collector;
+      collector.action.connect_to_producer (dr_sampler);
+
+      dr_sampler.sample (0.,
+                         &log_likelihood,
+                         [](const double &x, const std::vector<double> &rejected)
+      {
+        return std::pair<double,double> (x + 2. / (1 + rejected.size()), 1.);
+      },
+      2, 100);
+
+      print ("DR-MH with " + std::to_string(n_concurrent_stages) + " concurrent stages",
+             dr_sampler.get_sampler_statistics(), collector);
+    }
+
+  // Differential evaluation, by generations and asynchronously:
+  for (const bool asynchronous : {false, true})
+    {
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<double>::Parameters parameters;
+      parameters.record_timings = true;
+      SampleFlow::Producers::DifferentialEvaluationMetropolisHastings<double> de_sampler (parameters);
+
+      TimingCollector collector;
+      collector.action.connect_to_producer (de_sampler);
+
+      const auto propose = [](const double &x)
+      {
+        static std::mt19937 rng;
+        static std::mutex   mutex;
+        std::lock_guard<std::mutex> lock (mutex);
+        return std::pair<double,double> (x + std::normal_distribution<double>(0, 0.1)(rng), 1.);
+      };
+      const auto crossover = [](const double &x, const double &a, const double &b)
+      {
+        return x + 0.5 * (a - b);
+      };
+      if (asynchronous)
+        de_sampler.sample_asynchronously ({-1., 0., 1., 2.}, &log_likelihood, propose, crossover,
+                                          5, 102);
+      else
+        de_sampler.sample ({-1., 0., 1., 2.}, &log_likelihood, propose, crossover,
+                           5, 102);
+
+      print (asynchronous ? "DE-MH asynchronously" : "DE-MH",
+             de_sampler.get_sampler_statistics(), collector);
+    }
+}
@@ -0,0 +1,157 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the SequentialMonteCarlo producer: Use a Gaussian prior N(0,10^2)
+// and a Gaussian likelihood for one observation y=3 with noise N(0,1).
+// The posterior is then the Gaussian N(300/101, 100/101), and the evidence
+// is the density of N(0,101) at y=3. Check the weighted mean and variance
+// of the samples, the estimate of the evidence, that the weights average
+// to one, and that the function that takes a batch log likelihood
+// produces the same samples as the one that evaluates likelihoods on the
+// thread pool. Also check a fixed sequence of temperatures.
+
+
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/sequential_monte_carlo.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = double;
+
+
+double log_prior (const SampleType &x)
+{
+  return -0.5 * std::log(2 * std::numbers::pi * 100) - x*x/200;
+}
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -0.5 * std::log(2 * std::numbers::pi) - (x-3)*(x-3)/2;
+}
+
+
+std::vector<SampleType>
+check (const bool batch,
+       const std::vector<double> &temperatures)
+{
+  SampleFlow::Producers::SequentialMonteCarlo<SampleType>::Parameters parameters;
+  parameters.random_seed  = 1;
+  parameters.temperatures = temperatures;
+  parameters.thread_pool  = std::make_shared<SampleFlow::ThreadPool> (4);
+  SampleFlow::Producers::SequentialMonteCarlo<SampleType> smc (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (smc);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (smc);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (smc);
+
+  // Store the samples and add up their weights:
+  std::vector<SampleType> samples;
+  double sum_of_weights = 0;
+  bool chain_numbers_correct = true;
+  SampleFlow::Consumers::Action<SampleType> store_samples
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    const std::size_t *chain_number
+      = aux_data.get_if<std::size_t> (SampleFlow::AuxiliaryData::chain_number);
+    if ((chain_number == nullptr) || (*chain_number != samples.size()))
+      chain_numbers_correct = false;
+    sum_of_weights += aux_data.weight();
+    samples.push_back (x);
+  });
+  store_samples.connect_to_producer (smc);
+
+  // Draw the initial particles from the prior:
+  const std::size_t n_particles = 4000;
+  std::mt19937 rng;
+  std::normal_distribution<double> prior_distribution(0, 10);
+  std::vector<SampleType> initial_particles (n_particles);
+  for (SampleType &x : initial_particles)
+    x = prior_distribution(rng);
+
+  const auto propose_sample = [](const SampleType &x, std::mt19937 &rng)
+  {
+    return std::make_pair (x + std::normal_distribution<double>(0, 0.5)(rng),
+                           1.);
+  };
+
+  if (batch)
+    smc.sample (initial_particles,
+                &log_prior,
+                [](std::span<const SampleType> samples,
+                   std::span<double> log_likelihoods)
+    {
+      for (std::size_t i=0; i<samples.size(); ++i)
+        log_likelihoods[i] = log_likelihood (samples[i]);
+    },
+    propose_sample);
+  else
+    smc.sample (initial_particles, &log_prior, &log_likelihood, propose_sample);
+
+  const double exact_log_evidence = -0.5 * std::log(2 * std::numbers::pi * 101) - 9./(2*101);
+
+  std::cout << (batch ? "Batch:" : "Thread pool:") << std::endl
+            << "  number of samples correct: "
+            << (count_samples.get() == n_particles) << std::endl
+            << "  particle numbers correct: "
+            << chain_numbers_correct << std::endl
+            << "  average weight is one: "
+            << (std::fabs(sum_of_weights / n_particles - 1) < 1e-12) << std::endl
+            << "  mean value correct: "
+            << (std::fabs(mean_value.get() - 300./101) < 0.1) << std::endl
+            << "  variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) - 100./101) < 0.1) << std::endl
+            << "  log evidence correct: "
+            << (std::fabs(smc.get_log_evidence() - exact_log_evidence) < 0.1) << std::endl
+            << "  temperatures end at one: "
+            << (smc.get_temperatures().back() == 1.) << std::endl;
+
+  if (temperatures.size() > 0)
+    std::cout << "  temperatures as given: "
+              << (std::vector<double>(smc.get_temperatures().begin()+1,
+                                      smc.get_temperatures().end()) == temperatures)
+              << std::endl;
+
+  return samples;
+}
+
+
+int main ()
+{
+  const std::vector<SampleType> samples = check (false, {});
+  const std::vector<SampleType> batch_samples = check (true, {});
+  std::cout << "Same samples with batch likelihood: "
+            << (samples == batch_samples) << std::endl;
+
+  check (false, {0.01, 0.1, 0.3, 1});
+}
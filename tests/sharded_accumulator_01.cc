@@ -0,0 +1,101 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that consumers whose state is split into per-thread shards
+// (MeanValue, CovarianceMatrix, CountSamples, Histogram) compute the
+// same results when samples come in from many threads at once as when
+// the same samples are sent from a single thread.
+
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/component_splitter.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/histogram.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+
+
+int main ()
+{
+  const unsigned int n_threads = 8;
+  const unsigned int n_samples_per_thread = 10000;
+
+  // Create deterministic samples for each thread:
+  std::vector<std::vector<SampleType>> samples (n_threads);
+  for (unsigned int t=0; t<n_threads; ++t)
+    for (unsigned int i=0; i<n_samples_per_thread; ++i)
+      samples[t].push_back ({1.*((t*n_samples_per_thread+i)%13),
+                             1.*((t*n_samples_per_thread+i)%7) + 0.5*t});
+
+  // Set up a producer for each thread, and connect all of them to the
+  // same consumers:
+  std::vector<SampleFlow::Producers::Range<SampleType>> producers (n_threads);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  SampleFlow::Filters::ComponentSplitter<SampleType> first_component (0);
+  SampleFlow::Consumers::Histogram<double> histogram (-0.5, 12.5, 13);
+  histogram.connect_to_producer (first_component);
+
+  for (auto &producer : producers)
+    {
+      mean_value.connect_to_producer (producer);
+      covariance_matrix.connect_to_producer (producer);
+      count_samples.connect_to_producer (producer);
+      first_component.connect_to_producer (producer);
+    }
+
+  // Then sample on all threads concurrently:
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<n_threads; ++t)
+    threads.emplace_back ([&, t]()
+  {
+    producers[t].sample (samples[t]);
+  });
+  for (auto &thread : threads)
+    thread.join();
+
+  std::cout << std::setprecision(8);
+
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+
+  const SampleType mean = mean_value.get();
+  std::cout << "Mean value: " << mean[0] << ' ' << mean[1] << std::endl;
+
+  const auto covariance = covariance_matrix.get();
+  std::cout << "Covariance matrix: "
+            << covariance(0,0) << ' ' << covariance(0,1) << ' '
+            << covariance(1,0) << ' ' << covariance(1,1) << std::endl;
+
+  std::cout << "Histogram:";
+  for (const auto &bin : histogram.get())
+    std::cout << ' ' << std::get<2>(bin);
+  std::cout << std::endl;
+}
@@ -0,0 +1,112 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that ShardedAccumulator::merged() merges many shards correctly,
+// both when merging is cheap and when it is expensive enough that the
+// levels of the merge tree are spread across the threads of the default
+// thread pool.
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/sharded_accumulator.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+
+std::atomic<unsigned int> n_concurrent_merges = 0;
+std::atomic<unsigned int> max_concurrent_merges = 0;
+
+
+// A state that collects the numbers it has been given, and whose merge()
+// function can be made artificially slow:
+struct State
+{
+  std::vector<unsigned int> values;
+  bool                      slow = false;
+
+  void merge (const State &other)
+  {
+    if (other.slow)
+      {
+        const unsigned int n = ++n_concurrent_merges;
+        unsigned int max = max_concurrent_merges.load();
+        while ((n > max) && !max_concurrent_merges.compare_exchange_weak (max, n))
+          ;
+        std::this_thread::sleep_for (std::chrono::milliseconds(2));
+        --n_concurrent_merges;
+        slow = true;
+      }
+    values.insert (values.end(), other.values.begin(), other.values.end());
+  }
+};
+
+
+
+void test (const bool slow)
+{
+  const unsigned int n_shards = 64;
+  SampleFlow::ShardedAccumulator<State> accumulator (State {{}, slow}, n_shards);
+
+  // Update the shards from as many threads as there are shards:
+  std::vector<std::thread> threads;
+  for (unsigned int t=0; t<n_shards; ++t)
+    threads.emplace_back ([&accumulator, t]()
+  {
+    accumulator.update ([t](State &state)
+    {
+      state.values.push_back (t);
+    });
+  });
+  for (auto &thread : threads)
+    thread.join();
+
+  State result = accumulator.merged();
+  std::sort (result.values.begin(), result.values.end());
+
+  bool all_there = (result.values.size() == n_shards);
+  for (unsigned int t=0; t<result.values.size(); ++t)
+    all_there = all_there && (result.values[t] == t);
+  std::cout << "All values merged: " << all_there << std::endl;
+
+  // Calling merged() a second time gives the same result:
+  State second_result = accumulator.merged();
+  std::sort (second_result.values.begin(), second_result.values.end());
+  std::cout << "Same result again: " << (second_result.values == result.values) << std::endl;
+}
+
+
+
+int main ()
+{
+  std::cout << "Cheap merges:" << std::endl;
+  test (false);
+  std::cout << "Merges done in parallel: " << (max_concurrent_merges > 1) << std::endl;
+
+  std::cout << "Expensive merges:" << std::endl;
+  test (true);
+  std::cout << "Merges done in parallel: "
+            << ((max_concurrent_merges > 1) || (SampleFlow::ThreadPool::default_pool()->n_threads() == 1))
+            << std::endl;
+}
@@ -0,0 +1,163 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Consumers::ShardedChainOutput: Let several threads send chains
+// with different chain numbers, interleaved, to one object, then read the
+// index and the shards back and check that each shard contains exactly
+// the samples of its chain, in order. Also check that the index allows
+// seeking to a sample directly, and sharding by thread.
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumers/sharded_chain_output.h>
+#  include <sampleflow/producers/chain_file.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::vector<double>;
+
+
+// A producer that sends the samples of one chain.
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const std::size_t chain_number,
+            const unsigned int n_samples)
+    {
+      for (unsigned int i=0; i<n_samples; ++i)
+        {
+          SampleFlow::AuxiliaryData aux_data;
+          aux_data[SampleFlow::AuxiliaryData::chain_number] = chain_number;
+          aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -1.*i;
+          this->issue_sample ({1.*chain_number, 1.*i}, aux_data);
+        }
+      this->flush_consumers ();
+    }
+};
+
+
+int main ()
+{
+  const unsigned int n_chains  = 8;
+  const unsigned int n_samples = 5000;
+
+  using Output = SampleFlow::Consumers::ShardedChainOutput<SampleType>;
+
+  // Write with a small buffer so that every shard is written in many
+  // pieces:
+  {
+    std::vector<Issuer> issuers (n_chains);
+    Output output ("sharded_chain_output_01",
+                   Output::ShardBy::chain,
+    {
+      {
+        SampleFlow::AuxiliaryData::relative_log_likelihood,
+        SampleFlow::ChainFileFormat::ColumnType::floating_point
+      }
+    },
+    1000);
+    for (Issuer &issuer : issuers)
+      output.connect_to_producer (issuer);
+
+    std::vector<std::thread> threads;
+    for (unsigned int c=0; c<n_chains; ++c)
+      threads.emplace_back ([&issuers, c, n_samples]()
+    {
+      issuers[c].sample (c, n_samples);
+    });
+    for (std::thread &thread : threads)
+      thread.join();
+  }
+
+  // Now read the index and check each shard:
+  const std::vector<Output::ShardDescription> shards
+    = Output::read_index ("sharded_chain_output_01.index");
+  std::cout << "Shards: " << shards.size() << std::endl;
+  for (const Output::ShardDescription &shard : shards)
+    {
+      SampleFlow::Producers::ChainFile<SampleType> chain_file (shard.filename);
+
+      bool correct = (chain_file.n_samples() == shard.n_samples)
+                     && (chain_file.header().record_size() == shard.record_size);
+      for (unsigned int i=0; correct && (i<chain_file.n_samples()); ++i)
+        {
+          const SampleType sample = chain_file.get_sample(i);
+          correct = (sample[0] == shard.shard_key) && (sample[1] == i)
+                    && (*chain_file.get_aux_data(i).get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood)
+                        == -1.*i);
+        }
+
+      // Seek to one sample directly:
+      std::ifstream in (shard.filename, std::ios::binary);
+      in.seekg (shard.byte_offset(1234));
+      double x[2];
+      in.read (reinterpret_cast<char *>(x), sizeof(x));
+
+      std::cout << "Shard " << shard.shard_key << ": "
+                << shard.n_samples << " samples, correct: " << correct
+                << ", sample 1234: " << x[0] << ' ' << x[1] << std::endl;
+
+      std::remove (shard.filename.c_str());
+    }
+  std::remove ("sharded_chain_output_01.index");
+
+  // Then shard by thread. Each thread sends samples of several chains, so
+  // the shards correspond to threads, not chains:
+  {
+    std::vector<Issuer> issuers (2);
+    Output output ("sharded_chain_output_01", Output::ShardBy::thread);
+    for (Issuer &issuer : issuers)
+      output.connect_to_producer (issuer);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<2; ++t)
+      threads.emplace_back ([&issuers, t]()
+    {
+      for (unsigned int c=0; c<3; ++c)
+        issuers[t].sample (c, 100*(t+1));
+    });
+    for (std::thread &thread : threads)
+      thread.join();
+
+    std::size_t total = 0;
+    std::vector<std::size_t> shard_sizes;
+    for (const Output::ShardDescription &shard : output.get())
+      {
+        shard_sizes.push_back (shard.n_samples);
+        total += shard.n_samples;
+      }
+    std::sort (shard_sizes.begin(), shard_sizes.end());
+    std::cout << "Thread shards: " << shard_sizes.size()
+              << ", sizes: " << shard_sizes[0] << ' ' << shard_sizes[1]
+              << ", total: " << total << std::endl;
+  }
+  for (const Output::ShardDescription &shard
+       : Output::read_index ("sharded_chain_output_01.index"))
+    std::remove (shard.filename.c_str());
+  std::remove ("sharded_chain_output_01.index");
+}
@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Consumers::SharedMemoryOutput and Producers::SharedMemoryInput:
+// Create the sending side, then fork a process that receives the
+// samples and computes their mean value and the sum of an auxiliary data
+// entry, while the original process sends a few thousand samples through
+// a queue that is much smaller than the number of samples, so that the
+// sending side has to wait for the receiving one.
+
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/shared_memory_input.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/shared_memory_output.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const std::string name = "/sampleflow-shared_memory_01-" + std::to_string(getpid());
+  const unsigned int n_samples = 5000;
+
+  // Send each sample with its index as the log likelihood:
+  const SampleFlow::ChainFileFormat::Column column
+    = {SampleFlow::AuxiliaryData::relative_log_likelihood,
+       SampleFlow::ChainFileFormat::ColumnType::floating_point
+      };
+
+  std::optional<SampleFlow::Consumers::SharedMemoryOutput<std::vector<double>>>
+  shared_memory_output;
+  shared_memory_output.emplace (name, 2, std::vector {column}, 64);
+
+  const pid_t child = fork();
+  if (child == 0)
+    {
+      // The receiving side, which uses a different sample type:
+      using SampleType = Eigen::VectorXd;
+      SampleFlow::Producers::SharedMemoryInput<SampleType> shared_memory_input (name);
+
+      SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+      mean_value.connect_to_producer (shared_memory_input);
+
+      double sum_of_indices = 0;
+      unsigned int n_received = 0;
+      bool in_order = true;
+      SampleFlow::Consumers::Action<SampleType> action
+      ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const double index
+          = *aux_data.get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood);
+        in_order = in_order && (sample[0] == n_received) && (index == n_received);
+        sum_of_indices += index;
+        ++n_received;
+      });
+      action.connect_to_producer (shared_memory_input);
+
+      shared_memory_input.sample ();
+
+      std::cout << "Received: " << n_received << ", in order: " << in_order << std::endl;
+      std::cout << "Mean value: " << mean_value.get().transpose() << std::endl;
+      std::cout << "Sum of indices: " << sum_of_indices << std::endl;
+
+      // Leave without running the destructor of this process's copy of
+      // the sending side:
+      _exit (0);
+    }
+
+  // Send the samples along with auxiliary data, without a producer:
+  for (unsigned int i=0; i<n_samples; ++i)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = 1.*i;
+      shared_memory_output->consume ({1.*i, -1.*i}, std::move(aux_data));
+    }
+
+  // Tell the receiving side that we are done, and wait for it:
+  shared_memory_output.reset();
+  int status;
+  waitpid (child, &status, 0);
+  std::cout << "Receiving process succeeded: " << (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
+            << std::endl;
+}
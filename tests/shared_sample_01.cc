@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that sending a sample to several consumers copies the sample
+// only as often as necessary: not at all for a single consumer, and
+// N-1 times for N consumers.
+
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/consumer.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A sample type that counts how often objects of its type are copied.
+struct CountedSample
+{
+    CountedSample (const double value = 0)
+      :
+      value (value)
+    {}
+
+    CountedSample (const CountedSample &other)
+      :
+      value (other.value)
+    {
+      ++n_copies;
+    }
+
+    CountedSample (CountedSample &&other) = default;
+
+    CountedSample &
+    operator= (const CountedSample &other)
+    {
+      value = other.value;
+      ++n_copies;
+      return *this;
+    }
+
+    CountedSample &
+    operator= (CountedSample &&other) = default;
+
+    double value;
+
+    static unsigned int n_copies;
+};
+
+unsigned int CountedSample::n_copies = 0;
+
+
+
+// A producer that simply sends its argument downstream.
+class Issuer : public SampleFlow::Producer<CountedSample>
+{
+  public:
+    void
+    sample (CountedSample &&sample)
+    {
+      this->issue_sample (std::move(sample), {});
+      this->flush_consumers ();
+    }
+};
+
+
+
+// A consumer that stores the last sample it received.
+class Sink : public SampleFlow::Consumer<CountedSample>
+{
+  public:
+    ~Sink ()
+    {
+      this->disconnect_and_flush();
+    }
+
+    virtual
+    void
+    consume (CountedSample sample, SampleFlow::AuxiliaryData /*aux_data*/) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      last_sample = std::move(sample);
+    }
+
+    double
+    get () const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return last_sample.value;
+    }
+
+  private:
+    mutable std::mutex mutex;
+    CountedSample      last_sample;
+};
+
+
+int main ()
+{
+  Issuer issuer;
+
+  // Without any consumer, nothing happens at all:
+  issuer.sample (CountedSample(1));
+  std::cout << "No consumers: " << CountedSample::n_copies << " copies" << std::endl;
+
+  // Then successively add more consumers and send one sample each time.
+  std::vector<std::unique_ptr<Sink>> sinks;
+  for (unsigned int n=1; n<=4; ++n)
+    {
+      sinks.emplace_back (std::make_unique<Sink>());
+      sinks.back()->connect_to_producer (issuer);
+
+      CountedSample::n_copies = 0;
+      issuer.sample (CountedSample(n));
+      std::cout << n << " consumers: " << CountedSample::n_copies << " copies" << std::endl;
+
+      for (const auto &sink : sinks)
+        std::cout << "  received " << sink->get() << std::endl;
+    }
+
+  // Disconnecting a consumer must reduce the number of copies again:
+  sinks.erase (sinks.begin());
+  CountedSample::n_copies = 0;
+  issuer.sample (CountedSample(5));
+  std::cout << sinks.size() << " consumers: " << CountedSample::n_copies << " copies" << std::endl;
+}
@@ -0,0 +1,131 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the Signal class: Slots are called in the order in which they
+// were connected, disconnected slots are no longer called (also if they
+// are disconnected while the signal is being invoked), and connections can
+// be terminated even after the signal has been destroyed. Finally, invoke
+// a signal on one thread while another thread connects and disconnects
+// slots.
+
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/signal.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  {
+    SampleFlow::Signal<void (const int &)> signal;
+    std::cout << "empty: " << signal.empty() << std::endl;
+
+    SampleFlow::Connection c1 = signal.connect ([](const int &i)
+    {
+      std::cout << "slot 1: " << i << std::endl;
+    });
+    SampleFlow::Connection c2;
+    c2 = signal.connect ([&c2](const int &i)
+    {
+      std::cout << "slot 2: " << i << std::endl;
+
+      // Disconnect ourselves after the first call:
+      c2.disconnect();
+    });
+    SampleFlow::Connection c3 = signal.connect ([&c1](const int &i)
+    {
+      std::cout << "slot 3: " << i << std::endl;
+
+      // Disconnect slot 1 during the second call:
+      if (i == 2)
+        c1.disconnect();
+    });
+
+    std::cout << "number of slots: " << signal.num_slots() << std::endl;
+    signal (1);
+    std::cout << "number of slots: " << signal.num_slots() << std::endl;
+    signal (2);
+    signal (3);
+    std::cout << "connected: " << c1.connected() << ' ' << c2.connected() << ' '
+              << c3.connected() << std::endl;
+
+    // Disconnecting twice is not an error:
+    c1.disconnect();
+    std::cout << "number of slots: " << signal.num_slots() << std::endl;
+  }
+
+  // Slots are destroyed when they are disconnected, and connections can
+  // outlive the signal:
+  {
+    auto counter = std::make_shared<int>(0);
+    SampleFlow::Connection connection;
+    {
+      SampleFlow::Signal<void ()> signal;
+      connection = signal.connect ([counter]()
+      {
+        ++*counter;
+      });
+      signal ();
+      signal ();
+      std::cout << "counter: " << *counter << ", use count: " << counter.use_count() << std::endl;
+    }
+    std::cout << "connected after destruction of the signal: " << connection.connected()
+              << ", use count: " << counter.use_count() << std::endl;
+    connection.disconnect();
+  }
+
+  // Invoke a signal on one thread while connecting and disconnecting
+  // slots on another. The permanently connected slot has to see every
+  // invocation.
+  {
+    SampleFlow::Signal<void ()> signal;
+    std::atomic<unsigned int> n_permanent_calls = 0;
+    std::atomic<unsigned int> n_temporary_calls = 0;
+    signal.connect ([&]()
+    {
+      ++n_permanent_calls;
+    });
+
+    std::atomic<bool> done = false;
+    std::thread connector ([&]()
+    {
+      while (done == false)
+        {
+          SampleFlow::Connection c = signal.connect ([&]()
+          {
+            ++n_temporary_calls;
+          });
+          std::this_thread::yield();
+          c.disconnect();
+        }
+    });
+
+    for (unsigned int i=0; i<100000; ++i)
+      signal ();
+    done = true;
+    connector.join();
+
+    std::cout << "permanent slot calls: " << n_permanent_calls
+              << ", number of slots: " << signal.num_slots() << std::endl;
+  }
+}
@@ -0,0 +1,81 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that consumers and filters produce the same results in
+// ParallelMode::single_threaded, in which they do not acquire any
+// locks, as they do in the default synchronous mode.
+
+
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/filters/take_every_nth.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/last_sample.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = double;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  count_samples.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  mean_value.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::Histogram<SampleType> histogram (0.5, 100.5, 4);
+  histogram.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  histogram.connect_to_producer (range_producer);
+
+  SampleFlow::Filters::TakeEveryNth<SampleType> take_every_nth (7);
+  take_every_nth.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  take_every_nth.connect_to_producer (range_producer);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_every_nth;
+  count_every_nth.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  count_every_nth.connect_to_producer (take_every_nth);
+
+  SampleFlow::Consumers::LastSample<SampleType> last_every_nth;
+  last_every_nth.set_parallel_mode (SampleFlow::ParallelMode::single_threaded);
+  last_every_nth.connect_to_producer (take_every_nth);
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=1; i<=100; ++i)
+    samples.push_back (i);
+  range_producer.sample (samples);
+
+  std::cout << "Number of samples: " << count_samples.get() << std::endl;
+  std::cout << "Mean value: " << mean_value.get() << std::endl;
+  std::cout << "Histogram:";
+  for (const auto &bin : histogram.get())
+    std::cout << ' ' << std::get<2>(bin);
+  std::cout << std::endl;
+  std::cout << "Number of samples after filter: " << count_every_nth.get() << std::endl;
+  std::cout << "Last sample after filter: " << last_every_nth.get() << std::endl;
+}
@@ -0,0 +1,120 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check SmallVector: that it only allocates memory if it has more elements
+// than fit into its inline storage, and that it can be used as the sample
+// type of a producer and of the MeanValue consumer.
+
+
+#include <cstdint>
+#include <iostream>
+
+#include "allocation_counter.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/small_vector.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = SampleFlow::SmallVector<double,4>;
+
+double log_likelihood (const SampleType &)
+{
+  return 1;
+}
+
+std::pair<SampleType,double> perturb (const SampleType &x)
+{
+  SampleType y = x;
+  for (auto &el : y)
+    el += 1;
+  return {y, 1.0};
+}
+
+int main ()
+{
+  static_assert (SampleFlow::Concepts::is_vector_space_type<SampleType>);
+
+  // Copy, move, and do arithmetic with a vector that fits into the
+  // inline storage. None of this should allocate memory.
+  {
+    const std::uint64_t n_allocations_before = SampleFlow::Testing::n_allocations();
+
+    SampleType a = {1., 2., 3.};
+    SampleType b = a;
+    SampleType c = std::move(b);
+    c = 2.*a + c;
+    c /= 3;
+
+    // Count before printing, since the first output may allocate a buffer:
+    const std::uint64_t n_small_allocations
+      = SampleFlow::Testing::n_allocations() - n_allocations_before;
+    std::cout << "small: size=" << c.size()
+              << " capacity=" << c.capacity()
+              << " inline=" << c.uses_inline_storage()
+              << " allocations=" << n_small_allocations
+              << std::endl;
+    std::cout << c[0] << ' ' << c[1] << ' ' << c[2] << std::endl;
+    std::cout << "moved-from size=" << b.size() << std::endl;
+  }
+
+  // Now do the same with a vector that does not fit. Every copy
+  // allocates, moves do not:
+  {
+    const std::uint64_t n_allocations_before = SampleFlow::Testing::n_allocations();
+
+    SampleType a (6, 1.);
+    SampleType b = a;
+    SampleType c = std::move(b);
+    c += a;
+
+    std::cout << "large: size=" << c.size()
+              << " capacity=" << c.capacity()
+              << " inline=" << c.uses_inline_storage()
+              << " allocations=" << SampleFlow::Testing::n_allocations() - n_allocations_before
+              << std::endl;
+    std::cout << c[0] << ' ' << c[5] << std::endl;
+
+    // Shrinking keeps the memory, growing beyond it allocates again:
+    c.resize (2);
+    c.resize (6);
+    std::cout << "after resize: " << c[0] << ' ' << c[5]
+              << " allocations=" << SampleFlow::Testing::n_allocations() - n_allocations_before
+              << std::endl;
+    c.resize (7);
+    std::cout << "after growing: capacity=" << c.capacity()
+              << " allocations=" << SampleFlow::Testing::n_allocations() - n_allocations_before
+              << std::endl;
+  }
+
+  // Finally use the type in a sampler:
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer(mh_sampler);
+
+  mh_sampler.sample ({0,1},
+                     &log_likelihood,
+                     &perturb,
+                     8);
+
+  const SampleType mean = mean_value.get();
+  std::cout << mean.size() << ": " << mean[0] << ' ' << mean[1] << std::endl;
+}
@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that SparseCovarianceMatrix computes the same covariance matrix
+// as CovarianceMatrix does for the corresponding dense samples, both as
+// a dense matrix and when used through entries and matrix-vector
+// products, and that the same holds after merging two objects. Also
+// check the mean value against MeanValue.
+
+
+#include <iostream>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sparse_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  const unsigned int dimension = 50;
+  const unsigned int n_samples = 2000;
+
+  SampleFlow::Consumers::SparseCovarianceMatrix<Eigen::SparseVector<double>> sparse_covariance;
+  SampleFlow::Consumers::SparseCovarianceMatrix<Eigen::SparseVector<double>> other_sparse_covariance;
+  SampleFlow::Consumers::CovarianceMatrix<Eigen::VectorXd>                   dense_covariance;
+  SampleFlow::Consumers::MeanValue<Eigen::VectorXd>                          dense_mean;
+
+  std::mt19937 random_number_generator;
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      // Samples with three nonzero elements at random places:
+      Eigen::SparseVector<double> sample (dimension);
+      for (unsigned int i=0; i<3; ++i)
+        sample.coeffRef(random_number_generator() % dimension)
+          = 1. * (random_number_generator() % 1000) / 100;
+
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = 1. + (n%3);
+
+      dense_covariance.consume (Eigen::VectorXd(sample), aux_data);
+      dense_mean.consume (Eigen::VectorXd(sample), aux_data);
+      if (n % 2 == 0)
+        sparse_covariance.consume (sample, aux_data);
+      else
+        other_sparse_covariance.consume (sample, aux_data);
+    }
+  sparse_covariance.merge (other_sparse_covariance);
+
+  const Eigen::MatrixXd C = dense_covariance.get();
+  const auto sparse_C = sparse_covariance.get();
+
+  std::cout << "Size: " << sparse_C.size() << std::endl;
+  std::cout << "Nonzero entries in sparse part: "
+            << (sparse_C.sparse_part.nonZeros() < dimension*dimension) << std::endl;
+  std::cout << "Dense matrix agrees: "
+            << ((sparse_C.to_dense() - C).norm() < 1e-10 * C.norm()) << std::endl;
+  std::cout << "Entry agrees: "
+            << (std::abs(sparse_C.entry(3,7) - C(3,7)) < 1e-10 * C.norm()) << std::endl;
+
+  const Eigen::VectorXd v = Eigen::VectorXd::LinSpaced(dimension, -1, 1);
+  std::cout << "Product agrees: "
+            << ((sparse_C.multiply(v) - C*v).norm() < 1e-10 * (C*v).norm()) << std::endl;
+  std::cout << "Mean agrees: "
+            << ((sparse_covariance.get_mean() - dense_mean.get()).norm() < 1e-12 * dense_mean.get().norm())
+            << std::endl;
+}
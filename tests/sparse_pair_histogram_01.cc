@@ -0,0 +1,133 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+// Check the SparsePairHistogram consumer: Compare it against a
+// PairHistogram that uses the same bins for samples that all lie within
+// the range of the latter, then check that limiting the number of bins
+// merges bins as expected for samples with a heavy tail, and that
+// save() and load() reproduce the histogram.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/pair_histogram.h>
+#  include <sampleflow/consumers/sparse_pair_histogram.h>
+#else
+import SampleFlow;
+#endif
+
+int main ()
+{
+  using SampleType = std::valarray<double>;
+
+  std::mt19937 rng;
+  std::normal_distribution<double> normal (0., 0.5);
+  std::cauchy_distribution<double> cauchy (0., 1.);
+
+  // First compare against a dense histogram on [-2,2]x[-2,2]:
+  {
+    std::vector<SampleType> samples;
+    while (samples.size() < 10000)
+      {
+        const SampleType sample = { normal(rng), normal(rng) };
+        if (std::abs(sample).max() < 2)
+          samples.push_back (sample);
+      }
+
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::PairHistogram<SampleType> dense_histogram (-2, 2, 16,
+        -2, 2, 8);
+    SampleFlow::Consumers::SparsePairHistogram<SampleType> sparse_histogram (0.25, 0.5,
+        0, -2, -2);
+    dense_histogram.connect_to_producer (range_producer);
+    sparse_histogram.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    const auto dense  = dense_histogram.get();
+    const auto sparse = sparse_histogram.get();
+    std::size_t n_matching_bins = 0;
+    std::size_t n_nonempty_bins = 0;
+    for (const auto &bin : dense)
+      if (std::get<2>(bin) > 0)
+        {
+          ++n_nonempty_bins;
+          for (const auto &sparse_bin : sparse)
+            if ((std::get<0>(sparse_bin) == std::get<0>(bin))
+                &&
+                (std::get<1>(sparse_bin) == std::get<1>(bin))
+                &&
+                (std::get<2>(sparse_bin) == std::get<2>(bin)))
+              ++n_matching_bins;
+        }
+    std::cout << "Occupied bins: " << sparse.size() << ' ' << n_nonempty_bins
+              << ' ' << n_matching_bins << std::endl;
+  }
+
+  // Then use samples with heavy tails and limit the number of bins:
+  {
+    std::vector<SampleType> samples;
+    for (unsigned int i=0; i<10000; ++i)
+      samples.push_back ({ cauchy(rng), cauchy(rng) });
+
+    SampleFlow::Producers::Range<SampleType> range_producer;
+    SampleFlow::Consumers::SparsePairHistogram<SampleType> histogram (0.1, 0.1, 100);
+    histogram.connect_to_producer (range_producer);
+    range_producer.sample (samples);
+
+    const auto bins = histogram.get();
+    const auto widths = histogram.get_bin_widths();
+    std::cout << "Bin widths: " << widths[0] << ' ' << widths[1] << std::endl;
+
+    // Count the samples in the bins, and check each bin by counting
+    // the samples inside it directly:
+    SampleFlow::types::sample_index n_samples = 0;
+    bool bins_correct = (bins.size() <= 100);
+    for (const auto &bin : bins)
+      {
+        n_samples += std::get<2>(bin);
+
+        SampleFlow::types::sample_index n = 0;
+        for (const auto &sample : samples)
+          if ((sample[0] >= std::get<0>(bin)[0]) && (sample[0] < std::get<1>(bin)[0])
+              &&
+              (sample[1] >= std::get<0>(bin)[1]) && (sample[1] < std::get<1>(bin)[1]))
+            ++n;
+        if (n != std::get<2>(bin))
+          bins_correct = false;
+      }
+    std::cout << "Samples counted: " << n_samples << ' ' << bins_correct << std::endl;
+
+    // Save the state, load it into a new object, and compare:
+    std::vector<char> buffer;
+    histogram.save (buffer);
+    SampleFlow::Consumers::SparsePairHistogram<SampleType> copy (0.1, 0.1, 100);
+    std::span<const char> input (buffer);
+    copy.load (input);
+    std::cout << "Loaded: " << (copy.get() == bins) << ' ' << input.size() << std::endl;
+
+    // Merging the histogram into the copy doubles all counts:
+    copy.merge (histogram);
+    const auto merged = copy.get();
+    bool doubled = (merged.size() == bins.size());
+    for (unsigned int i=0; doubled && i<bins.size(); ++i)
+      doubled = (std::get<2>(merged[i]) == 2*std::get<2>(bins[i]));
+    std::cout << "Merged: " << doubled << std::endl;
+  }
+}
@@ -0,0 +1,96 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the SpeculativeMetropolisHastings producer: The sequence of
+// samples must not depend on the speculation depth or the number of
+// threads the likelihood evaluations run on.
+
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/speculative_metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/thread_pool.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 1);
+  return {x + distribution(rng), 1.0};
+}
+
+
+std::vector<SampleType> run (const unsigned int speculation_depth,
+                             const unsigned int n_threads)
+{
+  SampleFlow::Producers::SpeculativeMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed       = 42;
+  parameters.speculation_depth = speculation_depth;
+  parameters.thread_pool       = std::make_shared<SampleFlow::ThreadPool>(n_threads);
+
+  SampleFlow::Producers::SpeculativeMetropolisHastings<SampleType> mh_sampler (parameters);
+
+  std::vector<SampleType> samples;
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType sample, SampleFlow::AuxiliaryData)
+  {
+    samples.push_back (sample);
+  });
+  action.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample ({3}, &log_likelihood, &perturb, 10000);
+
+  std::cout << "Depth " << speculation_depth << ", " << n_threads << " threads: "
+            << samples.size() << " samples, mean value " << mean_value.get()
+            << ", acceptance ratio " << acceptance_ratio.get() << std::endl;
+
+  return samples;
+}
+
+
+int main ()
+{
+  const std::vector<SampleType> serial = run (0, 1);
+
+  for (const auto &[speculation_depth, n_threads] : {std::pair(1,1), std::pair(3,4)})
+    {
+      const std::vector<SampleType> speculative = run (speculation_depth, n_threads);
+      std::cout << "Same samples: " << (speculative == serial) << std::endl;
+    }
+}
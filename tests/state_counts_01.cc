@@ -0,0 +1,127 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Test the StateCounts consumer: Run a Metropolis-Hastings sampler on a
+// discrete distribution over pairs of integers stored in a
+// std::valarray<int> (for which operator== does not return a bool), and
+// check that the counts of the distinct states add up to the number of
+// samples, that the states' first occurrences and log likelihoods are
+// what the chain produced, and that the summary survives saving and
+// loading. Also check repetition counts and samples without a log
+// likelihood.
+
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <valarray>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/state_counts.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<int>;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -1. * (x[0] + x[1]);
+}
+
+
+std::pair<SampleType,double> propose_sample (const SampleType &x)
+{
+  static std::mt19937 rng;
+  SampleType y = x;
+  const unsigned int component = std::uniform_int_distribution<unsigned int>(0,1)(rng);
+  y[component] = (y[component] + (std::bernoulli_distribution(0.5)(rng) ? 1 : 3)) % 4;
+  return {y, 1.};
+}
+
+
+int main ()
+{
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::StateCounts<SampleType> state_counts;
+  state_counts.connect_to_producer (mh_sampler);
+
+  // Record the first occurrence of every state separately:
+  std::map<std::pair<int,int>,SampleFlow::types::sample_index> first_occurrences;
+  SampleFlow::types::sample_index index = 0;
+  SampleFlow::Consumers::Action<SampleType>
+  record ([&](const SampleType &x, const SampleFlow::AuxiliaryData &)
+  {
+    first_occurrences.emplace (std::make_pair (x[0], x[1]), index);
+    ++index;
+  });
+  record.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample ({0, 0}, &log_likelihood, &propose_sample, 10000);
+
+  const auto states = state_counts.get();
+  std::cout << "Number of samples: " << state_counts.n_samples() << std::endl;
+  std::cout << "Number of distinct states: " << state_counts.n_distinct_states() << std::endl;
+
+  SampleFlow::types::sample_index n_total = 0;
+  bool consistent = true;
+  for (const auto &state : states)
+    {
+      std::cout << "  (" << state.sample[0] << ',' << state.sample[1] << "): "
+                << state.n_occurrences << " samples, first at " << state.first_index
+                << ", log likelihood " << state.log_likelihood << std::endl;
+      n_total += state.n_occurrences;
+      consistent = consistent
+                   && (first_occurrences[ {state.sample[0], state.sample[1]}] == state.first_index)
+                   && (state.log_likelihood == log_likelihood (state.sample));
+    }
+  std::cout << "Counts add up: " << (n_total == state_counts.n_samples()) << std::endl;
+  std::cout << "Consistent with chain: " << consistent << std::endl;
+
+  // Save and load the summary:
+  std::vector<char> buffer;
+  state_counts.save (buffer);
+  SampleFlow::Consumers::StateCounts<SampleType> loaded (3);
+  std::span<const char> data (buffer);
+  loaded.load (data);
+  const auto loaded_states = loaded.get();
+  bool same = (loaded.n_samples() == state_counts.n_samples())
+              && (loaded_states.size() == states.size());
+  for (std::size_t i=0; same && (i<states.size()); ++i)
+    same = (std::abs(loaded_states[i].sample - states[i].sample).max() == 0)
+           && (loaded_states[i].n_occurrences == states[i].n_occurrences)
+           && (loaded_states[i].first_index == states[i].first_index);
+  std::cout << "Saved and loaded: " << same << std::endl;
+
+  // Repetition counts, and samples without a log likelihood:
+  SampleFlow::Consumers::StateCounts<std::vector<double>> repeated;
+  repeated.consume ({1., 2.}, {{SampleFlow::AuxiliaryData::repetition_count, std::any(std::size_t(3))}});
+  repeated.consume ({2., 1.}, {{SampleFlow::AuxiliaryData::relative_log_likelihood, std::any(-1.5)}});
+  repeated.consume ({1., 2.}, {});
+  repeated.consume ({1., 2., 3.}, {});
+  std::cout << "Repeated samples:" << std::endl;
+  for (const auto &state : repeated.get())
+    std::cout << "  " << state.sample.size() << " elements, starting with " << state.sample[0]
+              << ": " << state.n_occurrences << " samples, first at " << state.first_index
+              << ", log likelihood " << state.log_likelihood << std::endl;
+  std::cout << "Number of samples: " << repeated.n_samples() << std::endl;
+}
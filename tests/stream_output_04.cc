@@ -0,0 +1,89 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the binary output mode of the StreamOutput class: Write a few
+// thousand samples along with one auxiliary data column into a file,
+// using a small buffer so that many buffers have to be handed to the
+// writer thread, and then read the file back with Producers::ChainFile.
+// The samples are sent to the consumer directly so that we can attach
+// auxiliary data to them.
+
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/chain_file.h>
+#  include <sampleflow/consumers/stream_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  using SampleType = std::vector<double>;
+
+  const std::string filename = "stream_output_04.bin";
+  const unsigned int n_samples = 5000;
+
+  {
+    std::ofstream out (filename, std::ios::binary);
+
+    SampleFlow::Consumers::StreamOutput<SampleType>
+    stream_output (out,
+                   SampleFlow::Consumers::StreamOutput<SampleType>::Format::binary,
+    {
+      {
+        SampleFlow::AuxiliaryData::relative_log_likelihood,
+        SampleFlow::ChainFileFormat::ColumnType::floating_point
+      }
+    },
+    1000);
+
+    for (unsigned int i=0; i<n_samples; ++i)
+      {
+        SampleFlow::AuxiliaryData aux_data;
+        aux_data[SampleFlow::AuxiliaryData::relative_log_likelihood] = -1.*i;
+        stream_output.consume ({1.*i, 0.5*i, -1.*i}, std::move(aux_data));
+      }
+    stream_output.flush ();
+  }
+
+  SampleFlow::Producers::ChainFile<SampleType> chain_file (filename);
+  std::cout << "Samples: " << chain_file.n_samples()
+            << ", dimension: " << chain_file.header().dimension << std::endl;
+
+  bool all_correct = true;
+  for (unsigned int i=0; i<chain_file.n_samples(); ++i)
+    {
+      const SampleType sample = chain_file.get_sample(i);
+      const double *log_likelihood
+        = chain_file.get_aux_data(i).get_if<double>(SampleFlow::AuxiliaryData::relative_log_likelihood);
+      if ((sample != SampleType{1.*i, 0.5*i, -1.*i})
+          || (log_likelihood == nullptr) || (*log_likelihood != -1.*i))
+        all_correct = false;
+    }
+  std::cout << "All samples correct: " << all_correct << std::endl;
+  std::cout << "Sample 4321: "
+            << chain_file.get_sample(4321)[0] << ' '
+            << chain_file.get_sample(4321)[1] << ' '
+            << chain_file.get_sample(4321)[2] << std::endl;
+
+  std::remove (filename.c_str());
+}
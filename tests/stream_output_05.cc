@@ -0,0 +1,70 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Format::fast_text of the StreamOutput class, where numbers are
+// converted to text with std::to_chars: first with the default shortest
+// round-trip representation, then with a different separator and a
+// fixed precision, and finally for integer samples.
+
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/stream_output.h>
+#else
+import SampleFlow;
+#endif
+
+
+int main ()
+{
+  {
+    using SampleType = std::vector<double>;
+    const std::vector<SampleType> samples = {{1, 0.1}, {-2.5, 1e-20}, {1./3, 123456789.}};
+
+    using StreamOutput = SampleFlow::Consumers::StreamOutput<SampleType>;
+
+    for (const StreamOutput::TextFormat &text_format
+         : {StreamOutput::TextFormat(), StreamOutput::TextFormat {", ", 3}})
+      {
+        SampleFlow::Producers::Range<SampleType> range_producer;
+        StreamOutput stream_output (std::cout, text_format);
+        stream_output.connect_to_producer (range_producer);
+
+        range_producer.sample (samples);
+      }
+  }
+
+  // Write a few integer samples into a string instead, to check that
+  // there is no separator at the end of each line:
+  {
+    using SampleType = int;
+
+    std::ostringstream output;
+    {
+      SampleFlow::Producers::Range<SampleType> range_producer;
+      using StreamOutput = SampleFlow::Consumers::StreamOutput<SampleType>;
+      StreamOutput stream_output (output, StreamOutput::TextFormat {"\t", -1});
+      stream_output.connect_to_producer (range_producer);
+
+      range_producer.sample (std::vector<int> {1, -20, 300});
+    }
+    std::cout << '[' << output.str() << ']' << std::endl;
+  }
+}
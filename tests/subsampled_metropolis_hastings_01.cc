@@ -0,0 +1,131 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the SubsampledMetropolisHastings producer: Infer the mean of
+// 2,000 data points drawn from N(1,1), with one block per datum and a
+// wide Gaussian prior. The posterior is then approximately N(ybar,1/N).
+// Check the mean and variance of the samples, that the sequential test
+// evaluates fewer than half of the blocks on average, that an error
+// tolerance of zero evaluates all blocks in every step, and that the
+// result does not depend on the number of threads.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/subsampled_metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = double;
+
+
+std::vector<SampleType>
+check (const std::vector<double> &data,
+       const double error_tolerance,
+       const unsigned int n_threads)
+{
+  SampleFlow::Producers::SubsampledMetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed     = 1;
+  parameters.error_tolerance = error_tolerance;
+  parameters.thread_pool     = std::make_shared<SampleFlow::ThreadPool> (n_threads);
+  SampleFlow::Producers::SubsampledMetropolisHastings<SampleType> smh (parameters);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (smh);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (smh);
+
+  std::vector<SampleType> samples;
+  std::size_t n_blocks_evaluated = 0;
+  std::size_t min_blocks_evaluated = data.size();
+  SampleFlow::Consumers::Action<SampleType> store_samples
+  ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    const std::size_t n
+      = *aux_data.get_if<std::size_t> (SampleFlow::AuxiliaryData::n_likelihood_blocks);
+    n_blocks_evaluated  += n;
+    min_blocks_evaluated = std::min (min_blocks_evaluated, n);
+    samples.push_back (x);
+  });
+  store_samples.connect_to_producer (smh);
+
+  const SampleFlow::types::sample_index n_samples = 10000;
+  smh.sample (1.,
+              [](const SampleType &x)
+  {
+    return -x*x/200;
+  },
+  [&data](const SampleType &x, const std::size_t b)
+  {
+    return -(data[b]-x)*(data[b]-x)/2;
+  },
+  data.size(),
+  [](const SampleType &x, std::mt19937 &rng)
+  {
+    return std::make_pair (x + std::uniform_real_distribution<double>(-0.02, 0.02)(rng),
+                           1.);
+  },
+  n_samples);
+
+  double data_mean = 0;
+  for (const double y : data)
+    data_mean += y / data.size();
+  const double posterior_variance = 1. / data.size();
+
+  std::cout << "Error tolerance " << error_tolerance
+            << ", " << n_threads << " thread(s):" << std::endl
+            << "  number of samples correct: "
+            << (samples.size() == n_samples) << std::endl
+            << "  mean value correct: "
+            << (std::fabs(mean_value.get() - data_mean) < 0.005) << std::endl
+            << "  variance correct: "
+            << (std::fabs(covariance_matrix.get()(0,0) / posterior_variance - 1) < 0.3) << std::endl;
+  if (error_tolerance > 0)
+    std::cout << "  fewer than half of the blocks evaluated: "
+              << (n_blocks_evaluated < n_samples * data.size() / 2) << std::endl;
+  else
+    std::cout << "  all blocks evaluated: "
+              << (min_blocks_evaluated == data.size()) << std::endl;
+
+  return samples;
+}
+
+
+int main ()
+{
+  std::mt19937 rng;
+  std::normal_distribution<double> distribution (1, 1);
+  std::vector<double> data (2000);
+  for (double &y : data)
+    y = distribution (rng);
+
+  const std::vector<SampleType> samples = check (data, 0.01, 1);
+  const std::vector<SampleType> samples_again = check (data, 0.01, 4);
+  std::cout << "Independent of number of threads: "
+            << (samples == samples_again) << std::endl;
+
+  check (data, 0, 4);
+}
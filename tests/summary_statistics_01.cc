@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the SummaryStatistics consumer by comparing the statistics it
+// computes with the ones computed by the individual consumers, for
+// chains with and without compressed repeated samples.
+
+
+#include <iostream>
+#include <random>
+#include <valarray>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/maximum_probability_sample.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/summary_statistics.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void
+run_mh (const SampleType &starting_point,
+        const bool        compress_repeated_samples)
+{
+  typename SampleFlow::Producers::MetropolisHastings<SampleType>::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.compress_repeated_samples = compress_repeated_samples;
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler (parameters);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::MaximumProbabilitySample<SampleType> maximum_probability_sample;
+  maximum_probability_sample.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::SummaryStatistics<SampleType> summary_statistics;
+  summary_statistics.connect_to_producer (mh_sampler);
+
+  // A summary that only computes the mean value:
+  SampleFlow::Consumers::SummaryStatistics<SampleType>
+  mean_only (SampleFlow::Consumers::SummaryStatistics<SampleType>::mean);
+  mean_only.connect_to_producer (mh_sampler);
+
+  // Sample from a Gaussian with covariance diag(1,4), using a random walk
+  // proposal:
+  std::mt19937 rng;
+  mh_sampler.sample (starting_point,
+                     [](const SampleType &x)
+  {
+    return -0.5 * (x[0]*x[0] + x[1]*x[1]/4);
+  },
+  [&](const SampleType &x)
+  {
+    SampleType y = x;
+    for (auto &el : y)
+      el += std::normal_distribution<double>(0, 1)(rng);
+    return std::make_pair (y, 1.0);
+  },
+  10000);
+
+  std::cout << "count: " << summary_statistics.get_count()
+            << " (" << count_samples.get() << ")" << std::endl;
+
+  const SampleType mean = summary_statistics.get_mean();
+  const SampleType reference_mean = mean_value.get();
+  std::cout << "mean: " << mean[0] << ' ' << mean[1]
+            << " (" << reference_mean[0] << ' ' << reference_mean[1] << ")" << std::endl;
+  std::cout << "mean only: " << mean_only.get_mean()[0] << ' ' << mean_only.get_mean()[1]
+            << std::endl;
+
+  const auto covariance = summary_statistics.get_covariance();
+  const auto reference_covariance = covariance_matrix.get();
+  std::cout << "covariance: " << covariance(0,0) << ' ' << covariance(0,1) << ' '
+            << covariance(1,0) << ' ' << covariance(1,1)
+            << " (" << reference_covariance(0,0) << ' ' << reference_covariance(0,1) << ' '
+            << reference_covariance(1,0) << ' ' << reference_covariance(1,1) << ")" << std::endl;
+
+  const SampleType most_likely = summary_statistics.get_maximum_probability_sample().first;
+  const SampleType reference_most_likely = maximum_probability_sample.get().first;
+  std::cout << "most likely sample: " << most_likely[0] << ' ' << most_likely[1]
+            << " (" << reference_most_likely[0] << ' ' << reference_most_likely[1] << ")"
+            << std::endl;
+
+  std::cout << "acceptance ratio: " << summary_statistics.get_acceptance_ratio()
+            << " (" << acceptance_ratio.get() << ")" << std::endl;
+}
+
+
+int main ()
+{
+  for (const bool compress : {false, true})
+    {
+      std::cout << "Eigen::Vector2d, compress=" << compress << std::endl;
+      run_mh<Eigen::Vector2d> (Eigen::Vector2d(1,1), compress);
+    }
+
+  for (const bool compress : {false, true})
+    {
+      std::cout << "std::valarray<double>, compress=" << compress << std::endl;
+      run_mh<std::valarray<double>> ({1,1}, compress);
+    }
+}
@@ -0,0 +1,76 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Filters::TakeEveryInterval: The first sample has to be passed on,
+// samples that arrive in quick succession have to be discarded, and a
+// sample that arrives after the interval has passed has to be passed on
+// again, with its repetition count reset to one.
+
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/take_every_interval.h>
+#  include <sampleflow/consumers/action.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A producer that sends its argument downstream with a given repetition
+// count.
+class Issuer : public SampleFlow::Producer<int>
+{
+  public:
+    void
+    sample (const int sample, const std::size_t n_repetitions = 1)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      if (n_repetitions != 1)
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      this->issue_sample (sample, aux_data);
+    }
+};
+
+
+int main ()
+{
+  Issuer issuer;
+
+  SampleFlow::Filters::TakeEveryInterval<int> take_every_interval (std::chrono::milliseconds(200));
+  take_every_interval.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::Action<int>
+  action ([](int sample, SampleFlow::AuxiliaryData aux_data)
+  {
+    std::cout << "Sample " << sample
+              << ", repetitions " << aux_data.n_repetitions() << std::endl;
+  });
+  action.connect_to_producer (take_every_interval);
+
+  // A burst of samples: Only the first one can pass.
+  for (int i=0; i<1000; ++i)
+    issuer.sample (i);
+
+  // Wait for longer than the interval, then send another burst, with a
+  // repetition count on each sample:
+  std::this_thread::sleep_for (std::chrono::milliseconds(250));
+  for (int i=1000; i<1010; ++i)
+    issuer.sample (i, 3);
+}
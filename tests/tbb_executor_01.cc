@@ -0,0 +1,121 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check TBB::Executor: A ThreadPool that hands its tasks to a TBB task
+// arena needs to run both the chains of MetropolisHastings::sample_chains()
+// and the work of an asynchronous consumer on the threads of that arena,
+// and the chains need to be the same as with the built-in pool.
+
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <sampleflow/producers/metropolis_hastings.h>
+#include <sampleflow/consumers/action.h>
+#include <sampleflow/consumers/count_samples.h>
+#include <sampleflow/thread_pool.h>
+#include <sampleflow/tbb/executor.h>
+
+#include <oneapi/tbb/global_control.h>
+#include <oneapi/tbb/task_arena.h>
+
+using SampleType = double;
+
+
+bool in_arena ()
+{
+  return (tbb::this_task_arena::current_thread_index() != tbb::task_arena::not_initialized);
+}
+
+
+std::atomic<bool> everything_in_arena (true);
+
+double log_likelihood (const SampleType &x)
+{
+  if (in_arena() == false)
+    everything_in_arena = false;
+  return -(x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+int main ()
+{
+  const unsigned int n_chains = 4;
+  const std::vector<SampleType> starting_points = {-1., 0., 1., 2.};
+
+  // Make sure that TBB creates worker threads even on machines with only
+  // one processor core; the enqueued tasks would otherwise never run.
+  tbb::global_control control (tbb::global_control::max_allowed_parallelism, 3);
+  tbb::task_arena arena (2);
+  const auto tbb_pool
+    = std::make_shared<SampleFlow::ThreadPool>(std::make_shared<SampleFlow::TBB::Executor>(arena));
+  std::cout << "Threads: " << tbb_pool->n_threads() << std::endl;
+
+  std::vector<std::vector<SampleType>> chains[2];
+  for (unsigned int run=0; run<2; ++run)
+    {
+      const std::shared_ptr<SampleFlow::ThreadPool> thread_pool
+        = (run == 0 ?
+           std::make_shared<SampleFlow::ThreadPool>(2) :
+           tbb_pool);
+
+      chains[run].resize (n_chains);
+      everything_in_arena = true;
+
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType>
+      action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+      {
+        const std::size_t chain
+          = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+        std::lock_guard<std::mutex> lock (mutex);
+        chains[run][chain].push_back (sample);
+      });
+      action.connect_to_producer (mh_sampler);
+
+      SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+      count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 8);
+      count_samples.set_thread_pool (thread_pool);
+      count_samples.connect_to_producer (mh_sampler);
+
+      mh_sampler.sample_chains (starting_points,
+                                &log_likelihood,
+                                &perturb,
+                                1000,
+                                thread_pool);
+
+      std::cout << "Samples counted asynchronously: " << count_samples.get() << std::endl;
+    }
+
+  std::cout << "All likelihood evaluations in arena: " << everything_in_arena.load() << std::endl;
+  for (unsigned int c=0; c<n_chains; ++c)
+    std::cout << "Chain " << c << ": " << chains[1][c].size() << " samples, same as with built-in pool: "
+              << (chains[0][c] == chains[1][c]) << std::endl;
+}
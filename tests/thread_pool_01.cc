@@ -0,0 +1,78 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that several consumers can share a ThreadPool object of a
+// specific size set via Consumer::set_thread_pool(), and that flushing
+// one consumer waits for exactly the samples that consumer was sent.
+
+
+#include <iostream>
+#include <memory>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/thread_pool.h>
+#  include <sampleflow/producers/range.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = std::valarray<double>;
+
+
+
+int main ()
+{
+  const std::shared_ptr<SampleFlow::ThreadPool>
+  thread_pool = std::make_shared<SampleFlow::ThreadPool> (2);
+  std::cout << "Number of threads: " << thread_pool->n_threads() << std::endl;
+
+  SampleFlow::Producers::Range<SampleType> range_producer;
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 8);
+  count_samples.set_thread_pool (thread_pool);
+  count_samples.connect_to_producer(range_producer);
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 8);
+  mean_value.set_thread_pool (thread_pool);
+  mean_value.connect_to_producer(range_producer);
+
+  std::vector<SampleType> samples;
+  for (unsigned int i=0; i<1000; ++i)
+    {
+      samples.push_back (SampleType {0,0});
+      samples.push_back (SampleType {1,0});
+      samples.push_back (SampleType {1,1});
+      samples.push_back (SampleType {0,1});
+    }
+
+  // Run the samples twice to make sure that the pool can be reused
+  // after the consumers have been flushed:
+  for (unsigned int run=0; run<2; ++run)
+    {
+      range_producer.sample (samples);
+
+      std::cout << "Number of samples: " << count_samples.get() << std::endl;
+      std::cout << "Mean value: "
+                << mean_value.get()[0] << ' '
+                << mean_value.get()[1] << std::endl;
+    }
+}
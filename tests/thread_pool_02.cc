@@ -0,0 +1,188 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check ThreadPool::Placement::numa_round_robin: The description of
+// the machine in the Topology namespace needs to be consistent, the
+// workers of the pool need to be placed on alternating NUMA nodes, and
+// running several MetropolisHastings chains on such a pool, with all
+// samples going into a consumer whose state is sharded by node, needs
+// to produce the same results as on a pool whose workers are not bound
+// to cores. The output does not depend on the number of nodes of the
+// machine the test runs on.
+
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/topology.h>
+#  include <sampleflow/thread_pool.h>
+#  include <sampleflow/sharded_accumulator.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#else
+import SampleFlow;
+#endif
+
+using SampleType = double;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -(x-1)*(x-1);
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x,
+                                      std::mt19937 &rng)
+{
+  std::normal_distribution<double> distribution(0, 0.5);
+  return {x + distribution(rng), 1.0};
+}
+
+
+struct Sum
+{
+  unsigned long value = 0;
+
+  void merge (const Sum &other)
+  {
+    value += other.value;
+  }
+};
+
+
+
+void check_topology ()
+{
+  namespace Topology = SampleFlow::Topology;
+
+  // Every core belongs to exactly one node:
+  std::set<unsigned int> all_cpus;
+  std::size_t n_cpus = 0;
+  bool nodes_consistent = true;
+  for (unsigned int node=0; node<Topology::n_numa_nodes(); ++node)
+    for (const unsigned int cpu : Topology::cpus_of_numa_node(node))
+      {
+        all_cpus.insert (cpu);
+        ++n_cpus;
+        if (Topology::numa_node_of_cpu (cpu) != node)
+          nodes_consistent = false;
+      }
+  std::cout << "Cores belong to exactly one node: "
+            << ((all_cpus.size() == n_cpus) && nodes_consistent) << std::endl;
+
+  // Consecutive cores of the round-robin list are on different nodes,
+  // as long as there are cores left on more than one node:
+  const std::vector<unsigned int> cpus = Topology::round_robin_cpus (n_cpus);
+  bool alternating = true;
+  for (std::size_t i=1; i<std::min<std::size_t> (n_cpus, Topology::n_numa_nodes()); ++i)
+    if (Topology::numa_node_of_cpu (cpus[i]) == Topology::numa_node_of_cpu (cpus[i-1]))
+      alternating = false;
+  std::cout << "Round-robin list uses each core once: "
+            << (std::set<unsigned int>(cpus.begin(), cpus.end()).size() == n_cpus)
+            << std::endl;
+  std::cout << "Round-robin list alternates between nodes: " << alternating << std::endl;
+}
+
+
+
+// Run the chains on the given pool and return the sum of the samples of
+// each chain. Also output the mean value computed by a consumer that is
+// updated from all of the workers.
+std::vector<double> run (const std::shared_ptr<SampleFlow::ThreadPool> &thread_pool)
+{
+  const unsigned int n_chains = 8;
+
+  SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  std::mutex mutex;
+  std::vector<double> sums (n_chains, 0.);
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](SampleType sample, SampleFlow::AuxiliaryData aux_data)
+  {
+    const std::size_t chain
+      = std::any_cast<std::size_t>(aux_data[SampleFlow::AuxiliaryData::chain_number]);
+    std::lock_guard<std::mutex> lock (mutex);
+    sums[chain] += sample;
+  });
+  action.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample_chains ({-1., 0., 2., 3., -1., 0., 2., 3.},
+                            &log_likelihood,
+                            &perturb,
+                            10000,
+                            thread_pool);
+
+  double sum = 0;
+  for (const double s : sums)
+    sum += s;
+  std::cout << "Mean value matches sum of chains: "
+            << (std::abs (mean_value.get() - sum/(n_chains*10000)) < 1e-10)
+            << std::endl;
+
+  return sums;
+}
+
+
+
+int main ()
+{
+  check_topology ();
+
+  const auto pinned_pool
+    = std::make_shared<SampleFlow::ThreadPool> (4, SampleFlow::ThreadPool::Placement::numa_round_robin);
+  bool workers_alternate = true;
+  for (unsigned int w=1; w<std::min (pinned_pool->n_threads(), SampleFlow::Topology::n_numa_nodes()); ++w)
+    if (pinned_pool->numa_node_of_worker (w) == pinned_pool->numa_node_of_worker (w-1))
+      workers_alternate = false;
+  std::cout << "Workers alternate between nodes: " << workers_alternate << std::endl;
+
+  // Shards are split into groups, one per node, and merging them gives
+  // the sum of all updates made from the workers of the pool:
+  SampleFlow::ShardedAccumulator<Sum> accumulator;
+  std::cout << "One shard group per node: "
+            << (accumulator.n_shard_groups() == std::min (accumulator.n_shards(),
+                                                          SampleFlow::Topology::n_numa_nodes()))
+            << std::endl;
+  {
+    SampleFlow::ThreadPool::TaskGroup tasks;
+    for (unsigned int i=1; i<=1000; ++i)
+      tasks.run (*pinned_pool, [&accumulator, i]()
+    {
+      accumulator.update ([i](Sum &sum)
+      {
+        sum.value += i;
+      });
+    });
+    tasks.wait();
+  }
+  std::cout << "Sum of updates: " << accumulator.merged().value << std::endl;
+
+  const std::vector<double> sums_1 = run (pinned_pool);
+  const std::vector<double> sums_2 = run (std::make_shared<SampleFlow::ThreadPool> (3));
+
+  std::cout << "Chains are reproducible: " << (sums_1 == sums_2) << std::endl;
+}
@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Tracing: While a trace is recorded, producers, consumers,
+// samplers, and thread pools need to record spans for each sample sent
+// downstream, each sample consumed, each likelihood evaluation, and each
+// task, and write them in the Chrome trace format. Spans beyond the
+// capacity of the per-thread buffers need to be counted as dropped, and
+// nothing is recorded while tracing is switched off.
+
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/tracing.h>
+#else
+import SampleFlow;
+#endif
+
+
+double log_likelihood (const double &x)
+{
+  return -0.5 * x * x;
+}
+
+
+std::pair<double,double> perturb (const double &x)
+{
+  static std::mt19937 rng;
+  return {x + std::normal_distribution<double>(0, 1)(rng), 1.0};
+}
+
+
+// Count the occurrences of a pattern in a trace, or the events with the
+// given name.
+unsigned int occurrences (const std::string &trace,
+                          const std::string &pattern)
+{
+  unsigned int n = 0;
+  for (std::size_t p = trace.find (pattern); p != std::string::npos; p = trace.find (pattern, p+1))
+    ++n;
+  return n;
+}
+
+
+unsigned int count (const std::string &trace,
+                    const std::string &name)
+{
+  return occurrences (trace, "{\"name\":\"" + name + "\"");
+}
+
+
+void sample (const unsigned int n_samples)
+{
+  SampleFlow::Producers::MetropolisHastings<double> mh_sampler;
+
+  SampleFlow::Consumers::MeanValue<double> mean_value;
+  mean_value.connect_to_producer (mh_sampler);
+
+  SampleFlow::Consumers::CountSamples<double> count_samples;
+  count_samples.set_parallel_mode (SampleFlow::ParallelMode::asynchronous, 4);
+  count_samples.connect_to_producer (mh_sampler);
+
+  mh_sampler.sample (0., &log_likelihood, &perturb, n_samples);
+}
+
+
+int main ()
+{
+  // Nothing is recorded before a trace is started:
+  sample (10);
+  std::cout << "Before start: enabled=" << SampleFlow::Tracing::is_enabled() << std::endl;
+
+  // Record a trace of a run with one synchronous and one asynchronous
+  // consumer. The asynchronous one processes its samples as tasks on
+  // the default thread pool.
+  SampleFlow::Tracing::start ();
+  sample (100);
+  SampleFlow::Tracing::stop ();
+  sample (10);
+
+  std::ostringstream out;
+  SampleFlow::Tracing::write_chrome_trace (out);
+  const std::string trace = out.str();
+
+  std::cout << "Dropped events: " << SampleFlow::Tracing::n_dropped_events() << std::endl;
+  std::cout << "issue_sample: " << count (trace, "issue_sample") << std::endl;
+  std::cout << "consume: " << count (trace, "consume") << std::endl;
+  std::cout << "log_likelihood: " << count (trace, "log_likelihood") << std::endl;
+  std::cout << "Has flushes: " << (count (trace, "flush") > 0) << std::endl;
+  std::cout << "Has tasks: " << (count (trace, "task") > 0) << std::endl;
+  std::cout << "Has thread names: " << (count (trace, "thread_name") > 0) << std::endl;
+  std::cout << "All events counted: "
+            << (SampleFlow::Tracing::n_events() == occurrences (trace, "\"ph\":\"X\""))
+            << std::endl;
+  std::cout << "Well-formed: "
+            << ((trace.substr (0, 2) == "{\"") && (trace.substr (trace.size()-4) == "\n]}\n"))
+            << std::endl;
+
+  // Then record a trace with buffers that are too small:
+  SampleFlow::Tracing::start (50);
+  sample (100);
+  SampleFlow::Tracing::stop ();
+  std::cout << "With small buffers, events dropped: "
+            << (SampleFlow::Tracing::n_dropped_events() > 0) << std::endl;
+}
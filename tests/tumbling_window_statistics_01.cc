@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the TumblingWindowStatistics consumer with a short sequence of
+// samples, some of which are repetitions of the previous one, some of
+// which carry repetition counts that make them span more than one
+// window, and some of which carry weights. Then check that the drift
+// z-scores of a sequence of samples with a trend are large, and those of
+// one without are small.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <valarray>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/tumbling_window_statistics.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+
+
+template <typename Statistics>
+void
+print (const Statistics &statistics)
+{
+  std::cout << "Completed windows: " << statistics.n_completed_windows() << std::endl;
+  for (const auto &window : statistics.get())
+    std::cout << "  first step=" << window.first_step
+              << ", weight=" << window.total_weight
+              << ", mean=" << window.mean.transpose()
+              << ", variance=" << window.variance.transpose()
+              << ", acceptance ratio=" << window.acceptance_ratio
+              << std::endl;
+}
+
+
+int main ()
+{
+  // Send samples by hand, with windows of 4 steps, keeping 3 windows:
+  {
+    SampleFlow::Consumers::TumblingWindowStatistics<SampleType> statistics (4, 3);
+
+    const auto send = [&](const double x, const std::size_t n_repetitions,
+                          const double weight)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      if (n_repetitions != 1)
+        aux_data[SampleFlow::AuxiliaryData::repetition_count] = n_repetitions;
+      if (weight != 1)
+        aux_data[SampleFlow::AuxiliaryData::sample_weight] = weight;
+      statistics.consume (SampleType {x, -2*x}, aux_data);
+    };
+
+    // First window: four different samples, all accepted.
+    send (1, 1, 1);
+    send (2, 1, 1);
+    send (3, 1, 1);
+    send (4, 1, 1);
+    print (statistics);
+
+    // Second window: a repetition of the previous sample, then a new
+    // sample that stands for six steps, the last three of which belong
+    // to the third window.
+    send (4, 1, 1);
+    send (8, 6, 1);
+    print (statistics);
+
+    // Finish the third window with a weighted sample, then add two
+    // more windows so that the first is no longer kept:
+    send (10, 1, 3);
+    for (unsigned int i=0; i<8; ++i)
+      send (i, 1, 1);
+    print (statistics);
+  }
+
+  // Then compare the drift z-scores of a sequence of random samples with
+  // those of the same sequence with a slow trend added to the first
+  // component:
+  for (const double trend : {0., 1e-4})
+    {
+      SampleFlow::Consumers::TumblingWindowStatistics<SampleType> statistics (1000, 20);
+
+      std::mt19937 rng;
+      SampleFlow::Testing::NormalDistribution<double> distribution (0, 1);
+      for (unsigned int i=0; i<20000; ++i)
+        statistics.consume (SampleType {trend*i + distribution(rng), distribution(rng)},
+                            SampleFlow::AuxiliaryData());
+
+      const auto z = statistics.drift_z_scores (5, 10);
+      std::cout << "Trend " << trend << ": |z| > 4 = "
+                << (std::fabs(z[0]) > 4) << ' ' << (std::fabs(z[1]) > 4)
+                << std::endl;
+    }
+}
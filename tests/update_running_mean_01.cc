@@ -0,0 +1,126 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check Utilities::update_running_mean() and Utilities::add_scaled() for
+// sample types that take the different code paths: types with contiguous
+// storage, scalar types, and a vector space type that does not allow
+// access to its elements.
+
+
+#include <complex>
+#include <iostream>
+#include <valarray>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/element_access.h>
+#  include <sampleflow/fixed_vector.h>
+#else
+import SampleFlow;
+#endif
+
+
+// A two-dimensional vector space type whose elements can only be
+// accessed by name:
+struct Point
+{
+  double x, y;
+
+  Point &operator+= (const Point &p)
+  {
+    x += p.x;
+    y += p.y;
+    return *this;
+  }
+
+  Point &operator-= (const Point &p)
+  {
+    x -= p.x;
+    y -= p.y;
+    return *this;
+  }
+
+  Point &operator/= (const double d)
+  {
+    x /= d;
+    y /= d;
+    return *this;
+  }
+};
+
+Point operator* (const Point &p, const double d)
+{
+  return {p.x*d, p.y*d};
+}
+
+Point operator* (const double d, const Point &p)
+{
+  return p*d;
+}
+
+
+// Compute the mean of three samples via update_running_mean(), then
+// add a multiple of the first sample to the mean:
+template <typename SampleType>
+SampleType test (const SampleType &a, const SampleType &b, const SampleType &c)
+{
+  SampleType mean = a;
+  SampleFlow::Utilities::update_running_mean (mean, b, 1./2);
+  SampleFlow::Utilities::update_running_mean (mean, SampleType(c), 1./3);
+  SampleFlow::Utilities::add_scaled (mean, a, 2.);
+  return mean;
+}
+
+
+int main ()
+{
+  {
+    const std::valarray<double> v = test (std::valarray<double> {1., 2.},
+                                          std::valarray<double> {2., 4.},
+                                          std::valarray<double> {6., 3.});
+    std::cout << "valarray: " << v[0] << ' ' << v[1] << std::endl;
+  }
+
+  {
+    const Eigen::VectorXd v = test (Eigen::VectorXd(Eigen::Vector2d(1., 2.)),
+                                    Eigen::VectorXd(Eigen::Vector2d(2., 4.)),
+                                    Eigen::VectorXd(Eigen::Vector2d(6., 3.)));
+    std::cout << "Eigen::VectorXd: " << v.transpose() << std::endl;
+  }
+
+  {
+    const SampleFlow::FixedVector<float,2> v
+      = test (SampleFlow::FixedVector<float,2> {1.f, 2.f},
+              SampleFlow::FixedVector<float,2> {2.f, 4.f},
+              SampleFlow::FixedVector<float,2> {6.f, 3.f});
+    std::cout << "FixedVector<float,2>: " << v[0] << ' ' << v[1] << std::endl;
+  }
+
+  std::cout << "double: " << test (1., 2., 6.) << std::endl;
+  std::cout << "complex: " << test (std::complex<double>(1,2),
+                                    std::complex<double>(2,4),
+                                    std::complex<double>(6,3)) << std::endl;
+
+  // For integers, the updates are rounded toward zero: the mean of 1 and
+  // 2 is 1, and the mean of 1, 2, 6 is then 1+(6-1)/3=2, plus 2*1.
+  std::cout << "int: " << test (1, 2, 6) << std::endl;
+
+  {
+    const Point p = test (Point {1., 2.}, Point {2., 4.}, Point {6., 3.});
+    std::cout << "Point: " << p.x << ' ' << p.y << std::endl;
+  }
+}
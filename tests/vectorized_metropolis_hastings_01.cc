@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the VectorizedMetropolisHastings producer: Sample a
+// two-dimensional Gaussian with different standard deviations in the two
+// components with 32 chains, using a sample type without an Eigen
+// interface, and check the mean value and variances of the samples, the
+// number of samples, that each chain is labeled correctly, and that thinning
+// at the source yields fewer repeated samples. Then sample a Gaussian
+// restricted to a half plane from starting points outside of it, to check
+// that chains find their way out of regions of zero probability, and
+// that two runs with the same seed produce the same samples.
+
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <valarray>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producers/vectorized_metropolis_hastings.h>
+#  include <sampleflow/consumers/acceptance_ratio.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sample_store.h>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = std::valarray<double>;
+using Sampler    = SampleFlow::Producers::VectorizedMetropolisHastings<SampleType>;
+
+
+double check_gaussian (const unsigned int steps_per_sample)
+{
+  Sampler::Parameters parameters;
+  parameters.random_seed = 1;
+  parameters.proposal_standard_deviations = {1.5, 0.3};
+  parameters.steps_per_sample = steps_per_sample;
+  Sampler sampler (parameters);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (sampler);
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (sampler);
+  SampleFlow::Consumers::AcceptanceRatio<SampleType> acceptance_ratio;
+  acceptance_ratio.connect_to_producer (sampler);
+
+  // Check that samples are labeled with their chain in the order in
+  // which the chains are numbered, and compute the second moments:
+  std::size_t next_chain = 0;
+  bool chains_correct = true;
+  SampleType second_moments = {0., 0.};
+  SampleFlow::Consumers::Action<SampleType>
+  action ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+  {
+    const std::size_t *chain = aux_data.get_if<std::size_t> (SampleFlow::AuxiliaryData::chain_number);
+    if ((chain == nullptr) || (*chain != next_chain))
+      chains_correct = false;
+    next_chain = (next_chain + 1) % 32;
+    second_moments += x*x;
+  });
+  action.connect_to_producer (sampler);
+
+  // The standard deviations are 2 and 0.5:
+  sampler.sample (std::vector<SampleType> (32, SampleType {1., 1.}),
+                  [](const Sampler::LanePoints &points, std::span<double> log_likelihoods)
+  {
+    const std::span<const double> x = points.component(0);
+    const std::span<const double> y = points.component(1);
+    for (std::size_t lane=0; lane<points.n_lanes(); ++lane)
+      log_likelihoods[lane] = -0.5 * (x[lane]*x[lane]/4 + y[lane]*y[lane]/0.25);
+  },
+  20000);
+  second_moments /= count_samples.get();
+
+  std::cout << "Gaussian, " << steps_per_sample << " step(s) per sample:" << std::endl
+            << "  n_samples: " << count_samples.get() << std::endl
+            << "  chains correct: " << chains_correct << std::endl
+            << "  mean correct: " << (std::abs(mean_value.get()).max() < 0.05) << std::endl
+            << "  variances correct: "
+            << (std::abs(second_moments[0] - 4) < 0.1) << ' '
+            << (std::abs(second_moments[1] - 0.25) < 0.01) << std::endl
+            << "  acceptance ratio above 0.2: "
+            << (acceptance_ratio.get() > 0.2) << std::endl;
+
+  return acceptance_ratio.get();
+}
+
+
+
+std::vector<SampleType> sample_half_gaussian ()
+{
+  Sampler::Parameters parameters;
+  parameters.random_seed = 42;
+  parameters.proposal_step_size = 0.5;
+  Sampler sampler (parameters);
+
+  SampleFlow::Consumers::SampleStore<SampleType> sample_store;
+  sample_store.connect_to_producer (sampler);
+
+  sampler.sample (std::vector<SampleType> (8, SampleType {-0.3, 0.}),
+                  [](const Sampler::LanePoints &points, std::span<double> log_likelihoods)
+  {
+    for (std::size_t lane=0; lane<points.n_lanes(); ++lane)
+      log_likelihoods[lane] = (points(0,lane) >= 0 ?
+                               -0.5 * (points(0,lane)*points(0,lane) + points(1,lane)*points(1,lane)) :
+                               -std::numeric_limits<double>::infinity());
+  },
+  2000);
+
+  return std::vector<SampleType> (sample_store.begin(), sample_store.end());
+}
+
+
+
+void check_half_gaussian ()
+{
+  const std::vector<SampleType> samples = sample_half_gaussian ();
+
+  // All samples of the second half must have a nonnegative first
+  // component (the samples are ordered by step, and within each step by
+  // chain):
+  bool inside = true;
+  for (std::size_t i=samples.size()/2; i<samples.size(); ++i)
+    if (samples[i][0] < 0)
+      inside = false;
+
+  const std::vector<SampleType> samples_2 = sample_half_gaussian ();
+  bool same = (samples.size() == samples_2.size());
+  for (std::size_t i=0; same && (i<samples.size()); ++i)
+    same = ((samples[i] == samples_2[i]).min() == true);
+
+  std::cout << "Half Gaussian:" << std::endl
+            << "  n_samples: " << samples.size() << std::endl
+            << "  inside: " << inside << std::endl
+            << "  reproducible: " << same << std::endl;
+}
+
+
+int main ()
+{
+  const double acceptance_ratio_1 = check_gaussian (1);
+  const double acceptance_ratio_5 = check_gaussian (5);
+  std::cout << "Fewer repeated samples with thinning: "
+            << (acceptance_ratio_5 > acceptance_ratio_1) << std::endl;
+  check_half_gaussian ();
+}
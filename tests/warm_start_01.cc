@@ -0,0 +1,181 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the functions in namespace WarmStart: Run four chains sampling a
+// two-dimensional Gaussian and write their samples, including the chain
+// numbers, to a file. Check that the starting points obtained from the
+// file are the last samples of the four chains. Then do the same for a
+// single chain written without chain numbers, and check the starting
+// points obtained from the file and from LastSample, ReservoirSample,
+// and CovarianceMatrix consumers. Finally, use the latter to continue
+// sampling with an AdaptiveMetropolisHastings sampler.
+
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/warm_start.h>
+#  include <sampleflow/producers/adaptive_metropolis_hastings.h>
+#  include <sampleflow/producers/metropolis_hastings.h>
+#  include <sampleflow/consumers/action.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/sample_store.h>
+#  include <sampleflow/consumers/stream_output.h>
+#  include <eigen3/Eigen/Dense>
+#else
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+double log_likelihood (const SampleType &x)
+{
+  return -x.squaredNorm() / 2;
+}
+
+
+std::pair<SampleType,double> perturb (const SampleType &x, std::mt19937 &rng)
+{
+  SampleType y = x;
+  for (auto &y_i : y)
+    y_i += std::uniform_real_distribution<double>(-1.5, 1.5)(rng);
+  return {y, 1.};
+}
+
+
+int main ()
+{
+  // Several chains, with chain numbers:
+  {
+    const std::string filename = "warm_start_01.chains.bin";
+    std::map<std::size_t,SampleType> last_samples;
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+
+      std::ofstream out (filename, std::ios::binary);
+      SampleFlow::Consumers::StreamOutput<SampleType>
+      stream_output (out, SampleFlow::Consumers::StreamOutput<SampleType>::Format::binary,
+      {{SampleFlow::AuxiliaryData::chain_number, SampleFlow::ChainFileFormat::ColumnType::unsigned_integer}});
+      stream_output.connect_to_producer (mh_sampler);
+
+      std::mutex mutex;
+      SampleFlow::Consumers::Action<SampleType> record_last_samples
+      ([&](const SampleType &x, const SampleFlow::AuxiliaryData &aux_data)
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        last_samples[*aux_data.get_if<std::size_t>(SampleFlow::AuxiliaryData::chain_number)] = x;
+      });
+      record_last_samples.connect_to_producer (mh_sampler);
+
+      mh_sampler.sample_chains (std::vector<SampleType> (4, SampleType::Zero(2)),
+                                &log_likelihood, &perturb, 1000);
+    }
+
+    SampleFlow::Producers::ChainFile<SampleType> chain_file (filename);
+    const std::vector<SampleType> starting_points
+      = SampleFlow::WarmStart::starting_points (chain_file, 4);
+
+    bool correct = (starting_points.size() == 4);
+    for (std::size_t c=0; c<starting_points.size(); ++c)
+      correct = correct && (starting_points[c] == last_samples[c]);
+    std::cout << "Last samples of all chains: " << correct << std::endl;
+
+    std::remove (filename.c_str());
+  }
+
+  // A single chain, without chain numbers:
+  {
+    const std::string filename = "warm_start_01.chain.bin";
+    SampleFlow::Consumers::LastSample<SampleType>       last_sample;
+    SampleFlow::Consumers::ReservoirSample<SampleType>  reservoir_sample (8, 1);
+    SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+    SampleFlow::Consumers::SampleStore<SampleType>      sample_store;
+    {
+      SampleFlow::Producers::MetropolisHastings<SampleType> mh_sampler;
+      last_sample.connect_to_producer (mh_sampler);
+      reservoir_sample.connect_to_producer (mh_sampler);
+      covariance_matrix.connect_to_producer (mh_sampler);
+      sample_store.connect_to_producer (mh_sampler);
+
+      std::ofstream out (filename, std::ios::binary);
+      SampleFlow::Consumers::StreamOutput<SampleType>
+      stream_output (out, SampleFlow::Consumers::StreamOutput<SampleType>::Format::binary);
+      stream_output.connect_to_producer (mh_sampler);
+
+      std::mt19937 rng;
+      mh_sampler.sample (SampleType::Zero(2),
+                         &log_likelihood,
+                         [&rng](const SampleType &x)
+      {
+        return perturb (x, rng);
+      },
+      20000);
+    }
+    const std::vector<SampleType> samples (sample_store.begin(), sample_store.end());
+
+    SampleFlow::Producers::ChainFile<SampleType> chain_file (filename);
+    const std::vector<SampleType> starting_points
+      = SampleFlow::WarmStart::starting_points (chain_file, 5);
+    std::cout << "Last sample from file: "
+              << (SampleFlow::WarmStart::starting_point (chain_file) == samples.back()) << std::endl
+              << "Last sample from consumer: "
+              << (SampleFlow::WarmStart::starting_point (last_sample) == samples.back()) << std::endl
+              << "Evenly spaced samples from file: "
+              << ((starting_points.size() == 5) &&
+                  (starting_points[0] == samples[samples.size()/2]) &&
+                  (starting_points[2] == samples[samples.size()-1 - (samples.size()-1 - samples.size()/2)/2]) &&
+                  (starting_points[4] == samples.back()))
+              << std::endl;
+
+    const std::vector<SampleType> reservoir_points
+      = SampleFlow::WarmStart::starting_points (reservoir_sample, 12);
+    bool reservoir_correct = (reservoir_points.size() == 12);
+    for (std::size_t p=0; p<reservoir_points.size(); ++p)
+      reservoir_correct = reservoir_correct
+                          && (reservoir_points[p] == reservoir_points[p % 8])
+                          && (std::find (samples.begin(), samples.end(), reservoir_points[p]) != samples.end());
+    std::cout << "Samples from reservoir: " << reservoir_correct << std::endl;
+
+    const Eigen::MatrixXd proposal_covariance
+      = SampleFlow::WarmStart::proposal_covariance (covariance_matrix);
+    std::cout << "Proposal covariance correct: "
+              << ((proposal_covariance - 2.4*2.4/2 * Eigen::MatrixXd::Identity(2,2)).norm() < 0.3)
+              << std::endl;
+
+    // Continue sampling from where the previous chain left off, with the
+    // proposal distribution learned from it:
+    SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType>::Parameters parameters;
+    parameters.initial_proposal_covariance = proposal_covariance;
+    SampleFlow::Producers::AdaptiveMetropolisHastings<SampleType> am_sampler (parameters);
+    SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+    mean_value.connect_to_producer (am_sampler);
+    am_sampler.sample (SampleFlow::WarmStart::starting_point (chain_file),
+                       &log_likelihood, 20000);
+    std::cout << "Continued chain has correct mean: "
+              << (mean_value.get().norm() < 0.1) << std::endl;
+
+    std::remove (filename.c_str());
+  }
+}
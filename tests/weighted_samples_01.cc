@@ -0,0 +1,282 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2026 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check that statistics consumers treat samples with weights (see
+// AuxiliaryData::sample_weight) and repetition counts consistently: A
+// sample with repetition count m must have the same effect as m copies
+// of the sample, multiplying all weights by the same factor must not
+// change mean values and covariances, and the results must agree with
+// the weighted mean and covariance computed directly.
+
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/producer.h>
+#  include <sampleflow/filters/component_splitter.h>
+#  include <sampleflow/consumers/auto_covariance_matrix.h>
+#  include <sampleflow/consumers/auto_covariance_trace.h>
+#  include <sampleflow/consumers/count_samples.h>
+#  include <sampleflow/consumers/covariance_matrix.h>
+#  include <sampleflow/consumers/histogram.h>
+#  include <sampleflow/consumers/mean_value.h>
+#  include <sampleflow/consumers/pair_histogram.h>
+#else
+#  include <future>
+
+import SampleFlow;
+#endif
+
+
+using SampleType = Eigen::VectorXd;
+
+
+// A producer that simply sends its arguments downstream.
+class Issuer : public SampleFlow::Producer<SampleType>
+{
+  public:
+    void
+    sample (const SampleType &sample,
+            const SampleFlow::AuxiliaryData &aux_data)
+    {
+      this->issue_sample (sample, aux_data);
+    }
+
+    void
+    finish ()
+    {
+      this->flush_consumers ();
+    }
+};
+
+
+
+// The results of all of the consumers we check.
+using HistogramType     = SampleFlow::Consumers::Histogram<double>;
+using PairHistogramType = SampleFlow::Consumers::PairHistogram<SampleType>;
+
+struct Results
+{
+    SampleType                               mean;
+    Eigen::MatrixXd                          covariance;
+    SampleFlow::types::sample_index          n_samples;
+    double                                   total_weight;
+    double                                   effective_sample_size;
+    HistogramType::value_type                histogram;
+    HistogramType::weighted_value_type       weighted_histogram;
+    PairHistogramType::value_type            pair_histogram;
+    PairHistogramType::weighted_value_type   weighted_pair_histogram;
+    std::vector<double>                      autocovariance_trace;
+    std::vector<Eigen::MatrixXd>             autocovariance_matrix;
+};
+
+
+
+// Send the given samples downstream. If 'expand' is true, then send each
+// sample as many times as its repetition count says, each with the given
+// weight; otherwise send each sample once, along with its repetition
+// count and weight. Weights are multiplied by 'weight_scale'.
+Results
+run (const std::vector<SampleType>                      &samples,
+     const std::vector<double>                          &weights,
+     const std::vector<SampleFlow::types::sample_index> &repetitions,
+     const bool                                          expand,
+     const double                                        weight_scale)
+{
+  Issuer issuer;
+
+  SampleFlow::Consumers::MeanValue<SampleType> mean_value;
+  mean_value.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::CovarianceMatrix<SampleType> covariance_matrix;
+  covariance_matrix.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::CountSamples<SampleType> count_samples;
+  count_samples.connect_to_producer (issuer);
+
+  SampleFlow::Filters::ComponentSplitter<SampleType> first_component (0);
+  first_component.connect_to_producer (issuer);
+  HistogramType histogram (-3, 3, 12);
+  histogram.connect_to_producer (first_component);
+
+  PairHistogramType pair_histogram (-3, 3, 6, -3, 3, 6);
+  pair_histogram.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::AutoCovarianceTrace<SampleType> autocovariance_trace (5);
+  autocovariance_trace.connect_to_producer (issuer);
+
+  SampleFlow::Consumers::AutoCovarianceMatrix<SampleType> autocovariance_matrix (5);
+  autocovariance_matrix.connect_to_producer (issuer);
+
+  for (unsigned int i=0; i<samples.size(); ++i)
+    {
+      SampleFlow::AuxiliaryData aux_data;
+      aux_data[SampleFlow::AuxiliaryData::sample_weight] = double(weight_scale * weights[i]);
+
+      if (expand)
+        for (unsigned int r=0; r<repetitions[i]; ++r)
+          issuer.sample (samples[i], aux_data);
+      else
+        {
+          aux_data[SampleFlow::AuxiliaryData::repetition_count] = std::size_t(repetitions[i]);
+          issuer.sample (samples[i], aux_data);
+        }
+    }
+  issuer.finish ();
+
+  return {mean_value.get(), covariance_matrix.get(),
+          count_samples.get(), count_samples.total_weight(), count_samples.effective_sample_size(),
+          histogram.get(), histogram.get_weighted(),
+          pair_histogram.get(), pair_histogram.get_weighted(),
+          autocovariance_trace.get(), autocovariance_matrix.get()};
+}
+
+
+
+// Compare the results of two runs. If 'same_weights' is false, then the
+// two runs used weights that differ by a constant factor, and we only
+// compare quantities that are independent of such a factor.
+bool
+same (const Results &a,
+      const Results &b,
+      const bool     same_weights)
+{
+  const double tolerance = 1e-10;
+
+  bool ok = ((a.mean - b.mean).norm() < tolerance)
+            &&
+            ((a.covariance - b.covariance).norm() < tolerance)
+            &&
+            (a.n_samples == b.n_samples)
+            &&
+            (std::fabs(a.effective_sample_size - b.effective_sample_size) < tolerance);
+
+  for (unsigned int l=0; l<a.autocovariance_trace.size(); ++l)
+    ok = ok
+         &&
+         (std::fabs(a.autocovariance_trace[l] - b.autocovariance_trace[l]) < tolerance)
+         &&
+         ((a.autocovariance_matrix[l] - b.autocovariance_matrix[l]).norm() < tolerance);
+
+  ok = ok && (a.histogram == b.histogram) && (a.pair_histogram == b.pair_histogram);
+
+  if (same_weights)
+    {
+      ok = ok && (std::fabs(a.total_weight - b.total_weight) < tolerance);
+      for (unsigned int bin=0; bin<a.weighted_histogram.size(); ++bin)
+        ok = ok && (std::fabs(std::get<2>(a.weighted_histogram[bin])
+                              - std::get<2>(b.weighted_histogram[bin])) < tolerance);
+      for (unsigned int bin=0; bin<a.weighted_pair_histogram.size(); ++bin)
+        ok = ok && (std::fabs(std::get<2>(a.weighted_pair_histogram[bin])
+                              - std::get<2>(b.weighted_pair_histogram[bin])) < tolerance);
+    }
+
+  return ok;
+}
+
+
+
+int main ()
+{
+  // Create a set of samples with random weights and repetition counts.
+  // Repetition counts go beyond the maximal lag of the autocovariance
+  // consumers.
+  std::mt19937 rng;
+  std::normal_distribution<double> normal;
+  std::uniform_real_distribution<double> uniform (0.1, 2);
+  std::uniform_int_distribution<unsigned int> n_repetitions (1, 10);
+
+  const unsigned int n_samples = 1000;
+  std::vector<SampleType> samples (n_samples, SampleType(2));
+  std::vector<double> weights (n_samples);
+  std::vector<SampleFlow::types::sample_index> repetitions (n_samples);
+  for (unsigned int i=0; i<n_samples; ++i)
+    {
+      samples[i](0) = normal(rng);
+      samples[i](1) = 0.5*samples[i](0) + normal(rng);
+      weights[i] = uniform(rng);
+      repetitions[i] = n_repetitions(rng);
+    }
+
+  const Results compressed = run (samples, weights, repetitions, false, 1);
+  const Results expanded   = run (samples, weights, repetitions, true,  1);
+  const Results scaled     = run (samples, weights, repetitions, false, 7.5);
+
+  std::cout << "Compressed vs. expanded: " << same(compressed, expanded, true) << std::endl;
+  std::cout << "Scaled weights: " << same(compressed, scaled, false) << std::endl;
+
+  // Compute the weighted mean, covariance, and effective sample size
+  // directly:
+  double W = 0, W2 = 0;
+  SampleFlow::types::sample_index n = 0;
+  SampleType mean = SampleType::Zero(2);
+  for (unsigned int i=0; i<n_samples; ++i)
+    {
+      W  += repetitions[i] * weights[i];
+      W2 += repetitions[i] * weights[i] * weights[i];
+      n  += repetitions[i];
+      mean += repetitions[i] * weights[i] * samples[i];
+    }
+  mean /= W;
+
+  Eigen::MatrixXd covariance = Eigen::MatrixXd::Zero(2,2);
+  for (unsigned int i=0; i<n_samples; ++i)
+    covariance += repetitions[i] * weights[i]
+                  * (samples[i] - mean) * (samples[i] - mean).transpose();
+  covariance /= (W - W2/W);
+
+  std::cout << "Mean: " << ((compressed.mean - mean).norm() < 1e-10) << std::endl;
+  std::cout << "Covariance: " << ((compressed.covariance - covariance).norm() < 1e-10) << std::endl;
+  std::cout << "Number of samples: " << (compressed.n_samples == n) << std::endl;
+  std::cout << "Total weight: " << (std::fabs(compressed.total_weight - W) < 1e-10) << std::endl;
+  std::cout << "Effective sample size: "
+            << (std::fabs(compressed.effective_sample_size - W*W/W2) < 1e-10) << std::endl;
+
+  // The autocovariance for lag zero must be the covariance matrix:
+  std::cout << "Autocovariance for lag zero: "
+            << ((compressed.autocovariance_matrix[0] - covariance).norm() < 1e-10)
+            << ' '
+            << (std::fabs(compressed.autocovariance_trace[0] - covariance.trace()) < 1e-10)
+            << std::endl;
+
+  // The weighted histograms must add up to the total weight of the
+  // samples that fall into their range:
+  double weight_in_range = 0, weight_in_pair_range = 0;
+  for (unsigned int i=0; i<n_samples; ++i)
+    {
+      if ((samples[i](0) >= -3) && (samples[i](0) < 3))
+        {
+          weight_in_range += repetitions[i] * weights[i];
+          if ((samples[i](1) >= -3) && (samples[i](1) < 3))
+            weight_in_pair_range += repetitions[i] * weights[i];
+        }
+    }
+  double histogram_weight = 0, pair_histogram_weight = 0;
+  for (const auto &bin : compressed.weighted_histogram)
+    histogram_weight += std::get<2>(bin);
+  for (const auto &bin : compressed.weighted_pair_histogram)
+    pair_histogram_weight += std::get<2>(bin);
+  std::cout << "Weighted histograms: "
+            << (std::fabs(histogram_weight - weight_in_range) < 1e-10)
+            << ' '
+            << (std::fabs(pair_histogram_weight - weight_in_pair_range) < 1e-10)
+            << std::endl;
+}
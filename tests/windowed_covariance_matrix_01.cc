@@ -0,0 +1,152 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2019 by the SampleFlow authors.
+//
+// This file is part of the SampleFlow library.
+//
+// The SampleFlow library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of SampleFlow.
+//
+// ---------------------------------------------------------------------
+
+
+// Check the WindowedCovarianceMatrix consumer: After each of many
+// samples, the mean and covariance it computes must match those computed
+// directly from the most recent samples. Samples have different weights
+// (some of them zero) and repetition counts; a sample with several
+// repetitions occupies that many places in the window. Finally, check
+// that saving and loading the state yields an object that continues
+// with the same results.
+
+
+#include <iostream>
+#include <span>
+#include <valarray>
+#include <vector>
+#include <random>
+
+#include <eigen3/Eigen/Dense>
+
+#include "tests.h"
+
+#ifndef SAMPLEFLOW_TEST_WITH_MODULE
+#  include <sampleflow/consumers/windowed_covariance_matrix.h>
+#else
+import SampleFlow;
+#endif
+
+
+template <typename SampleType>
+void test (const std::vector<Eigen::VectorXd> &values,
+           const std::vector<SampleFlow::AuxiliaryData> &aux_data,
+           const std::size_t window_size)
+{
+  SampleFlow::Consumers::WindowedCovarianceMatrix<SampleType> covariance (window_size);
+
+  // The samples that are in the window, with their weights:
+  std::vector<std::pair<Eigen::VectorXd,double>> history;
+
+  const unsigned int dimension = values[0].size();
+  double max_mean_error = 0, max_covariance_error = 0;
+  for (unsigned int n=0; n<values.size(); ++n)
+    {
+      SampleType sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = values[n][i];
+      covariance.consume (sample, aux_data[n]);
+
+      if (aux_data[n].weight() > 0)
+        for (unsigned int r=0; r<aux_data[n].n_repetitions(); ++r)
+          history.emplace_back (values[n], aux_data[n].weight());
+      const std::size_t first = (history.size() > window_size ?
+                                 history.size() - window_size :
+                                 0);
+      if (first == history.size())
+        continue;
+
+      double W = 0, W2 = 0;
+      Eigen::VectorXd mean = Eigen::VectorXd::Zero (dimension);
+      for (std::size_t j=first; j<history.size(); ++j)
+        {
+          mean += history[j].second * history[j].first;
+          W += history[j].second;
+          W2 += history[j].second * history[j].second;
+        }
+      mean /= W;
+
+      Eigen::MatrixXd C = Eigen::MatrixXd::Zero (dimension, dimension);
+      for (std::size_t j=first; j<history.size(); ++j)
+        C += history[j].second
+             * (history[j].first - mean) * (history[j].first - mean).transpose();
+      if (W - W2/W > 0)
+        C /= (W - W2/W);
+
+      max_mean_error = std::max (max_mean_error,
+                                 (covariance.get_mean() - mean).norm() / mean.norm());
+      max_covariance_error = std::max (max_covariance_error,
+                                       (covariance.get() - C).norm() / std::max(C.norm(), 1.));
+    }
+
+  std::cout << "Samples in window: " << covariance.n_samples_in_window() << std::endl;
+  std::cout << "Mean value matches: " << (max_mean_error < 1e-10) << std::endl;
+  std::cout << "Covariance matches: " << (max_covariance_error < 1e-10) << std::endl;
+  std::cout << "C(0,0)=" << covariance.get()(0,0)
+            << ", C(3,1)=" << covariance.get()(3,1) << std::endl;
+
+  // Save the state and load it into another object, then feed both the
+  // same samples again:
+  std::vector<char> buffer;
+  covariance.save (buffer);
+  SampleFlow::Consumers::WindowedCovarianceMatrix<SampleType> copy (window_size);
+  std::span<const char> data (buffer);
+  copy.load (data);
+  std::cout << "Restored state matches: "
+            << ((copy.get() - covariance.get()).norm() <= 1e-12 * covariance.get().norm())
+            << std::endl;
+
+  for (unsigned int n=0; n<values.size()/10; ++n)
+    {
+      SampleType sample (dimension);
+      for (unsigned int i=0; i<dimension; ++i)
+        sample[i] = values[n][i];
+      covariance.consume (sample, aux_data[n]);
+      copy.consume (sample, aux_data[n]);
+    }
+  std::cout << "Continued state matches: "
+            << ((copy.get() - covariance.get()).norm() <= 1e-12 * covariance.get().norm())
+            << std::endl;
+}
+
+
+
+int main ()
+{
+  const unsigned int dimension = 5;
+  const unsigned int n_samples = 2000;
+
+  std::mt19937 rng;
+  std::vector<Eigen::VectorXd> values (n_samples, Eigen::VectorXd(dimension));
+  std::vector<SampleFlow::AuxiliaryData> aux_data (n_samples);
+  for (unsigned int n=0; n<n_samples; ++n)
+    {
+      // Let the samples drift so that the statistics of the window
+      // actually differ from those of all samples:
+      for (unsigned int i=0; i<dimension; ++i)
+        values[n][i] = SampleFlow::Testing::NormalDistribution<double>(i + 0.01*n,1)(rng)
+                       + (i == 3 ? 0.5*values[n][1] : 0.);
+
+      aux_data[n][SampleFlow::AuxiliaryData::sample_weight] = double((n%7)/2);
+      aux_data[n][SampleFlow::AuxiliaryData::repetition_count] = std::size_t(1 + n%3);
+    }
+
+  for (const std::size_t window_size : {1, 2, 50})
+    {
+      std::cout << "Window size " << window_size << ':' << std::endl;
+      test<std::valarray<double>> (values, aux_data, window_size);
+      test<Eigen::VectorXd> (values, aux_data, window_size);
+    }
+}